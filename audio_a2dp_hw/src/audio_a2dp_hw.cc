@@ -47,6 +47,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
+#include "udrv/include/uipc_shm.h"
 
 #include "audio_a2dp_hw.h"
 
@@ -121,6 +122,7 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  tUIPC_SHM shm;  // PCM ring handed over on audio_fd, if any
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -341,6 +343,12 @@ static int skt_disconnect(int fd) {
   return 0;
 }
 
+static void audio_skt_disconnect(struct a2dp_stream_common* common) {
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  uipc_shm_close(&common->shm);
+}
+
 /*****************************************************************************
  *
  *  AUDIO CONTROL PATH
@@ -816,6 +824,7 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  uipc_shm_reset(&common->shm);
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -851,6 +860,12 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
       ERROR("Audiopath start failed - error opening data socket");
       goto error;
     }
+
+    /* the stack hands over a shared memory ring right after accept */
+    if (uipc_shm_recv_handshake(common->audio_fd, &common->shm,
+                                UIPC_SHM_HANDSHAKE_TMO_MS) == 0) {
+      INFO("using shared memory ring (%u bytes)", common->shm.size);
+    }
   }
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STARTED;
 
@@ -882,8 +897,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  audio_skt_disconnect(common);
 
   return 0;
 }
@@ -902,9 +916,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  audio_skt_disconnect(common);
 
   return 0;
 }
@@ -955,12 +967,16 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   }
 
   lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (uipc_shm_is_mapped(&out->common.shm)) {
+    sent = uipc_shm_write(&out->common.shm, out->common.audio_fd, buffer,
+                          write_bytes, SOCK_SEND_TIMEOUT_MS);
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   lock.lock();
 
   if (sent == -1) {
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    audio_skt_disconnect(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
         (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -1521,8 +1537,7 @@ static ssize_t in_read(struct audio_stream_in* stream, void* buffer,
   read = skt_read(in->common.audio_fd, buffer, bytes);
   lock.lock();
   if (read == -1) {
-    skt_disconnect(in->common.audio_fd);
-    in->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    audio_skt_disconnect(&in->common);
     if ((in->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
         (in->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       in->common.state = AUDIO_A2DP_STATE_STOPPED;
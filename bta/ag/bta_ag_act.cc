@@ -480,6 +480,7 @@ void bta_ag_rfc_open(tBTA_AG_SCB* p_scb, const tBTA_AG_DATA& data) {
 
   /* set up AT command interpreter */
   p_scb->at_cb.p_at_tbl = bta_ag_at_tbl[p_scb->conn_service];
+  p_scb->at_cb.p_at_trie = bta_ag_at_trie[p_scb->conn_service];
   p_scb->at_cb.p_cmd_cback = bta_ag_at_cback_tbl[p_scb->conn_service];
   p_scb->at_cb.p_err_cback = bta_ag_at_err_cback;
   p_scb->at_cb.p_user = p_scb;
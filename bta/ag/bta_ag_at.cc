@@ -24,12 +24,12 @@
 #define LOG_TAG "bta_ag_at"
 
 #include <cstdint>
+#include <string_view>
 
 #include "bt_target.h"  // Must be first to define build configuration:
 
 #include "bta/ag/bta_ag_at.h"
 #include "bta/ag/bta_ag_int.h"
-#include "bta/include/utl.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 
@@ -82,39 +82,34 @@ void bta_ag_at_reinit(tBTA_AG_AT_CB* p_cb) {
  *
  *****************************************************************************/
 void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
-  uint16_t idx;
   uint8_t arg_type;
   char* p_arg;
   int16_t int_arg = 0;
-  /* loop through at command table looking for match */
-  for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++) {
-    if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf)) {
-      break;
-    }
-  }
+  /* match the command against the trie of the at command table */
+  std::string_view cmd(p_cb->p_cmd_buf, p_end - p_cb->p_cmd_buf);
+  AtMatch match = p_cb->p_at_trie->Match(cmd, true /* ignore_case */);
 
   /* if there is a match; verify argument type */
-  if (p_cb->p_at_tbl[idx].p_cmd[0] != 0) {
+  if (match.found()) {
+    size_t idx = match.index;
     /* start of argument is p + strlen matching command */
-    p_arg = p_cb->p_cmd_buf + strlen(p_cb->p_at_tbl[idx].p_cmd);
-    if (p_arg > p_end) {
-      (*p_cb->p_err_cback)((tBTA_AG_SCB*)p_cb->p_user, false, nullptr);
-      android_errorWriteLog(0x534e4554, "112860487");
-      return;
-    }
+    p_arg = p_cb->p_cmd_buf + match.length;
+    /* arguments end at the first null character */
+    std::string_view args = cmd.substr(match.length);
+    args = args.substr(0, args.find('\0'));
 
     /* if no argument */
-    if (p_arg[0] == 0) {
+    if (args.empty()) {
       arg_type = BTA_AG_AT_NONE;
     }
     /* else if arg is '?' and it is last character */
-    else if (p_arg[0] == '?' && p_arg[1] == 0) {
+    else if (args == "?") {
       /* we have a read */
       arg_type = BTA_AG_AT_READ;
     }
     /* else if arg is '=' */
-    else if (p_arg[0] == '=' && p_arg[1] != 0) {
-      if (p_arg[1] == '?' && p_arg[2] == 0) {
+    else if (args[0] == '=' && args.size() > 1) {
+      if (args == "=?") {
         /* we have a test */
         arg_type = BTA_AG_AT_TEST;
       } else {
@@ -123,6 +118,7 @@ void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
 
         /* skip past '=' */
         p_arg++;
+        args.remove_prefix(1);
       }
     } else
     /* else it is freeform argument */
@@ -135,7 +131,7 @@ void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
       /* if it's a set integer check max, min range */
       if (arg_type == BTA_AG_AT_SET &&
           p_cb->p_at_tbl[idx].fmt == BTA_AG_AT_INT) {
-        int_arg = utl_str2int(p_arg);
+        int_arg = AtParseInt(args);
         if (int_arg < (int16_t)p_cb->p_at_tbl[idx].min ||
             int_arg > (int16_t)p_cb->p_at_tbl[idx].max) {
           /* arg out of range; error */
@@ -159,7 +155,7 @@ void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
     }
   } else {
     /* else no match call error callback */
-    LOG_WARN("Unmatched command index %d", idx);
+    LOG_WARN("Unmatched command");
     (*p_cb->p_err_cback)((tBTA_AG_SCB*)p_cb->p_user, true, p_cb->p_cmd_buf);
   }
 }
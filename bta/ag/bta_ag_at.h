@@ -28,6 +28,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "bta/sys/at_lexer.h"
+
 /*****************************************************************************
  *  Constants
  ****************************************************************************/
@@ -70,6 +72,7 @@ typedef void(tBTA_AG_AT_ERR_CBACK)(tBTA_AG_SCB* p_user, bool unknown,
 /* AT command parsing control block */
 typedef struct {
   const tBTA_AG_AT_CMD* p_at_tbl;    /* AT command table */
+  const AtCommandTrie* p_at_trie;    /* trie of the AT command table */
   tBTA_AG_AT_CMD_CBACK* p_cmd_cback; /* command callback */
   tBTA_AG_AT_ERR_CBACK* p_err_cback; /* error callback */
   void* p_user;                      /* user-defined data */
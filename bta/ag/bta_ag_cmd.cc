@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <string_view>
 
 #include "bta/ag/bta_ag_at.h"
 #include "bta/ag/bta_ag_int.h"
@@ -57,7 +58,7 @@ enum {
 };
 
 /* AT command interpreter table for HSP */
-static const tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
+static constexpr tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
     {"+CKPD", BTA_AG_AT_CKPD_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 200, 200},
     {"+VGS", BTA_AG_SPK_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
     {"+VGM", BTA_AG_MIC_EVT, BTA_AG_AT_SET, BTA_AG_AT_INT, 0, 15},
@@ -65,7 +66,7 @@ static const tBTA_AG_AT_CMD bta_ag_hsp_cmd[] = {
     {"", 0, 0, 0, 0, 0}};
 
 /* AT command interpreter table for HFP */
-static const tBTA_AG_AT_CMD bta_ag_hfp_cmd[] = {
+static constexpr tBTA_AG_AT_CMD bta_ag_hfp_cmd[] = {
     {"A", BTA_AG_AT_A_EVT, BTA_AG_AT_NONE, BTA_AG_AT_STR, 0, 0},
     {"D", BTA_AG_AT_D_EVT, BTA_AG_AT_NONE | BTA_AG_AT_FREE, BTA_AG_AT_STR, 0,
      0},
@@ -168,6 +169,16 @@ static const tBTA_AG_RESULT* bta_ag_result_by_code(size_t code) {
 const tBTA_AG_AT_CMD* bta_ag_at_tbl[BTA_AG_NUM_IDX] = {bta_ag_hsp_cmd,
                                                        bta_ag_hfp_cmd};
 
+static constexpr AtCommandTrie bta_ag_hsp_trie(bta_ag_hsp_cmd,
+                                               &tBTA_AG_AT_CMD::p_cmd);
+static constexpr AtCommandTrie bta_ag_hfp_trie(bta_ag_hfp_cmd,
+                                               &tBTA_AG_AT_CMD::p_cmd);
+static_assert(!bta_ag_hsp_trie.IsFull() && !bta_ag_hfp_trie.IsFull(),
+              "AtCommandTrie::kMaxNodes is too small");
+
+const AtCommandTrie* bta_ag_at_trie[BTA_AG_NUM_IDX] = {&bta_ag_hsp_trie,
+                                                       &bta_ag_hfp_trie};
+
 typedef struct {
   size_t result_code;
   size_t indicator;
@@ -365,23 +376,17 @@ static void bta_ag_send_ind(tBTA_AG_SCB* p_scb, uint16_t id, uint16_t value,
  * Returns          true if parsed ok, false otherwise.
  *
  ******************************************************************************/
-static bool bta_ag_parse_cmer(char* p_s, char* p_end, bool* p_enabled) {
+static bool bta_ag_parse_cmer(std::string_view args, bool* p_enabled) {
   int16_t n[4] = {-1, -1, -1, -1};
-  int i;
-  char* p;
-
-  for (i = 0; i < 4; i++, p_s = p + 1) {
-    /* skip to comma delimiter */
-    for (p = p_s; p < p_end && *p != ',' && *p != 0; p++)
-      ;
+  AtArgumentLexer lexer(args);
+  std::string_view arg;
 
-    /* get integer value */
-    if (p > p_end) {
+  for (int i = 0; i < 4; i++) {
+    if (!lexer.Next(&arg)) {
       android_errorWriteLog(0x534e4554, "112860487");
       return false;
     }
-    *p = 0;
-    n[i] = utl_str2int(p_s);
+    n[i] = AtParseInt(arg);
   }
 
   /* process values */
@@ -438,28 +443,14 @@ static uint8_t bta_ag_parse_chld(UNUSED_ATTR tBTA_AG_SCB* p_scb, char* p_s) {
  * Returns          Returns bitmap of supported codecs.
  *
  ******************************************************************************/
-static tBTA_AG_PEER_CODEC bta_ag_parse_bac(tBTA_AG_SCB* p_scb, char* p_s,
-                                           char* p_end) {
+static tBTA_AG_PEER_CODEC bta_ag_parse_bac(tBTA_AG_SCB* p_scb,
+                                           std::string_view args) {
   tBTA_AG_PEER_CODEC retval = BTA_AG_CODEC_NONE;
-  uint16_t uuid_codec;
-  char* p;
+  AtArgumentLexer lexer(args);
+  std::string_view arg;
 
-  while (p_s) {
-    /* skip to comma delimiter */
-    for (p = p_s; p < p_end && *p != ',' && *p != 0; p++)
-      ;
-
-    /* get integer value */
-    if (p > p_end) {
-      android_errorWriteLog(0x534e4554, "112860487");
-      break;
-    }
-    bool cont = false;  // Continue processing
-    if (*p != 0) {
-      *p = 0;
-      cont = true;
-    }
-    uuid_codec = utl_str2int(p_s);
+  while (lexer.Next(&arg)) {
+    uint16_t uuid_codec = AtParseInt(arg);
     switch (uuid_codec) {
       case UUID_CODEC_CVSD:
         retval |= BTA_AG_CODEC_CVSD;
@@ -471,11 +462,6 @@ static tBTA_AG_PEER_CODEC bta_ag_parse_bac(tBTA_AG_SCB* p_scb, char* p_s,
         APPL_TRACE_ERROR("Unknown Codec UUID(%d) received", uuid_codec);
         break;
     }
-
-    if (cont)
-      p_s = p + 1;
-    else
-      break;
   }
 
   return (retval);
@@ -1077,7 +1063,8 @@ void bta_ag_at_hfp_cback(tBTA_AG_SCB* p_scb, uint16_t cmd, uint8_t arg_type,
 
     case BTA_AG_LOCAL_EVT_CMER:
       /* if parsed ok store setting, send OK */
-      if (bta_ag_parse_cmer(p_arg, p_end, &p_scb->cmer_enabled)) {
+      if (bta_ag_parse_cmer(std::string_view(p_arg, p_end - p_arg),
+                            &p_scb->cmer_enabled)) {
         bta_ag_send_ok(p_scb);
 
         /* if service level conn. not already open and our features and
@@ -1246,7 +1233,8 @@ void bta_ag_at_hfp_cback(tBTA_AG_SCB* p_scb, uint16_t cmd, uint8_t arg_type,
       /* store available codecs from the peer */
       if ((p_scb->peer_features & BTA_AG_PEER_FEAT_CODEC) &&
           (p_scb->features & BTA_AG_FEAT_CODEC)) {
-        p_scb->peer_codecs = bta_ag_parse_bac(p_scb, p_arg, p_end);
+        p_scb->peer_codecs =
+            bta_ag_parse_bac(p_scb, std::string_view(p_arg, p_end - p_arg));
         p_scb->codec_updated = true;
 
         if (p_scb->peer_codecs & BTA_AG_CODEC_MSBC) {
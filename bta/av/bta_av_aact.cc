@@ -79,6 +79,17 @@ constexpr char kBtmLogTag[] = "A2DP";
 #define BTA_AV_RECONFIG_RETRY 6
 #endif
 
+/* Persisted stream discovery results: a version, the initiator UUID and the
+ * number of SEPs, then per SEP its information, a flag telling whether its
+ * capabilities are known and the capabilities, then a check value */
+#define BTA_AV_SEP_CACHE_CONFIG_KEY "AvdtpSepCache"
+#define BTA_AV_SEP_CACHE_VERSION 1
+#define BTA_AV_SEP_CACHE_HDR_LEN 4
+#define BTA_AV_SEP_CACHE_SEP_LEN (12 + AVDT_CODEC_SIZE + AVDT_PROTECT_SIZE)
+#define BTA_AV_SEP_CACHE_MAX_LEN                                           \
+  (BTA_AV_SEP_CACHE_HDR_LEN + BTA_AV_NUM_SEPS * BTA_AV_SEP_CACHE_SEP_LEN + \
+   sizeof(uint32_t))
+
 /* ACL quota we are letting FW use for A2DP Offload Tx. */
 #define BTA_AV_A2DP_OFFLOAD_XMIT_QUOTA 4
 
@@ -109,6 +120,26 @@ const tBTA_AV_CO_FUNCTS bta_av_a2dp_cos = {bta_av_co_audio_init,
                                            bta_av_co_audio_update_mtu,
                                            bta_av_co_get_scmst_info};
 
+/* Static stream endpoint information of a peer: its SEP list without the
+ * in-use flags, and the capabilities received for each SEP. The AVDTP
+ * Discover still goes to the peer for the current in-use flags, and when the
+ * SEP list is unchanged the capabilities are replayed instead of the Get (All)
+ * Capabilities round trips. Dropped on disconnect, and together with the
+ * persisted copy when a connection using them fails. */
+typedef struct {
+  bool in_use;
+  RawAddress peer_addr;
+  uint16_t uuid_int;
+  uint8_t num_seps;
+  tAVDT_SEP_INFO sep_info[BTA_AV_NUM_SEPS];
+  AvdtpSepConfig peer_cap[BTA_AV_NUM_SEPS];
+  bool cap_valid[BTA_AV_NUM_SEPS];
+  bool from_storage; /* loaded from the config, nothing new to save */
+} tBTA_AV_CAP_CACHE;
+
+static tBTA_AV_CAP_CACHE bta_av_cap_cache[BTA_AV_CAP_CACHE_SIZE];
+static uint8_t bta_av_cap_cache_next; /* entry replaced by the next store */
+
 /* these tables translate AVDT events to SSM events */
 static const uint16_t bta_av_stream_evt_ok[] = {
     BTA_AV_STR_DISC_OK_EVT,      /* AVDT_DISCOVER_CFM_EVT */
@@ -281,6 +312,292 @@ void bta_av_st_rc_timer(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_find
+ *
+ * Description      Find the cached discovery results of a peer for the given
+ *                  initiator role.
+ *
+ * Returns          The cache entry, or nullptr if there is none.
+ *
+ ******************************************************************************/
+static tBTA_AV_CAP_CACHE* bta_av_cap_cache_find(const RawAddress& peer_addr,
+                                                uint16_t uuid_int) {
+  for (tBTA_AV_CAP_CACHE& entry : bta_av_cap_cache) {
+    if (entry.in_use && entry.peer_addr == peer_addr &&
+        entry.uuid_int == uuid_int) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_store
+ *
+ * Description      Record fresh discovery results of a peer, replacing any
+ *                  previous ones. Capabilities are added as they arrive.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_store(tBTA_AV_SCB* p_scb) {
+  tBTA_AV_CAP_CACHE* p_entry =
+      bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int);
+  if (p_entry == nullptr) {
+    p_entry = &bta_av_cap_cache[bta_av_cap_cache_next];
+    bta_av_cap_cache_next =
+        (bta_av_cap_cache_next + 1) % BTA_AV_CAP_CACHE_SIZE;
+  }
+
+  p_entry->in_use = true;
+  p_entry->peer_addr = p_scb->PeerAddress();
+  p_entry->uuid_int = p_scb->uuid_int;
+  p_entry->num_seps = p_scb->num_seps;
+  memcpy(p_entry->sep_info, p_scb->sep_info,
+         p_entry->num_seps * sizeof(tAVDT_SEP_INFO));
+  for (uint8_t i = 0; i < p_entry->num_seps; i++) {
+    p_entry->sep_info[i].in_use = false;
+  }
+  memset(p_entry->cap_valid, 0, sizeof(p_entry->cap_valid));
+  p_entry->from_storage = false;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_update
+ *
+ * Description      Check the fresh discovery results of a peer against its
+ *                  cached stream endpoints. The cached capabilities are kept
+ *                  for replay if the endpoints are unchanged, otherwise the
+ *                  entry is replaced by the fresh results.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_update(tBTA_AV_SCB* p_scb) {
+  tBTA_AV_CAP_CACHE* p_entry =
+      p_scb->disc_cached
+          ? bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int)
+          : nullptr;
+  bool match = (p_entry != nullptr && p_entry->num_seps == p_scb->num_seps);
+  for (uint8_t i = 0; match && i < p_scb->num_seps; i++) {
+    const tAVDT_SEP_INFO& fresh = p_scb->sep_info[i];
+    const tAVDT_SEP_INFO& cached = p_entry->sep_info[i];
+    match = fresh.seid == cached.seid && fresh.tsep == cached.tsep &&
+            fresh.media_type == cached.media_type;
+  }
+  if (match) return;
+
+  if (p_scb->disc_cached) {
+    LOG_WARN("%s: peer %s stream endpoints changed, dropping cached results",
+             __func__, p_scb->PeerAddress().ToString().c_str());
+  }
+  p_scb->disc_cached = false;
+  bta_av_cap_cache_store(p_scb);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_check_value
+ *
+ * Description      FNV-1a hash guarding the persisted discovery results
+ *                  against truncation and corruption.
+ *
+ * Returns          The hash of the buffer.
+ *
+ ******************************************************************************/
+static uint32_t bta_av_cap_cache_check_value(const uint8_t* p, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_save
+ *
+ * Description      Persist the discovery results of a peer in its config
+ *                  section so that they survive a restart of the stack.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_save(tBTA_AV_SCB* p_scb) {
+  tBTA_AV_CAP_CACHE* p_entry =
+      bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int);
+  if (p_entry == nullptr || p_entry->from_storage) return;
+
+  uint8_t buf[BTA_AV_SEP_CACHE_MAX_LEN];
+  uint8_t* p = buf;
+  UINT8_TO_STREAM(p, BTA_AV_SEP_CACHE_VERSION);
+  UINT16_TO_STREAM(p, p_entry->uuid_int);
+  UINT8_TO_STREAM(p, p_entry->num_seps);
+  for (uint8_t i = 0; i < p_entry->num_seps; i++) {
+    const tAVDT_SEP_INFO& info = p_entry->sep_info[i];
+    const AvdtpSepConfig& cap = p_entry->peer_cap[i];
+    UINT8_TO_STREAM(p, info.seid);
+    UINT8_TO_STREAM(p, info.media_type);
+    UINT8_TO_STREAM(p, info.tsep);
+    UINT8_TO_STREAM(p, p_entry->cap_valid[i]);
+    ARRAY_TO_STREAM(p, cap.codec_info, AVDT_CODEC_SIZE);
+    ARRAY_TO_STREAM(p, cap.protect_info, AVDT_PROTECT_SIZE);
+    UINT8_TO_STREAM(p, cap.num_codec);
+    UINT8_TO_STREAM(p, cap.num_protect);
+    UINT16_TO_STREAM(p, cap.psc_mask);
+    UINT8_TO_STREAM(p, cap.recov_type);
+    UINT8_TO_STREAM(p, cap.recov_mrws);
+    UINT8_TO_STREAM(p, cap.recov_mnmp);
+    UINT8_TO_STREAM(p, cap.hdrcmp_mask);
+  }
+  uint32_t check_value = bta_av_cap_cache_check_value(buf, p - buf);
+  UINT32_TO_STREAM(p, check_value);
+
+  if (btif_config_set_bin(p_scb->PeerAddress().ToString(),
+                          BTA_AV_SEP_CACHE_CONFIG_KEY, buf, p - buf)) {
+    btif_config_save();
+  } else {
+    APPL_TRACE_WARNING("%s: Failed to store stream discovery results for %s",
+                       __func__, p_scb->PeerAddress().ToString().c_str());
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_load
+ *
+ * Description      Restore the persisted discovery results of a peer into
+ *                  the cache if they were recorded for the same initiator
+ *                  role and are intact.
+ *
+ * Returns          The cache entry, or nullptr if nothing usable was stored.
+ *
+ ******************************************************************************/
+static tBTA_AV_CAP_CACHE* bta_av_cap_cache_load(tBTA_AV_SCB* p_scb) {
+  uint8_t buf[BTA_AV_SEP_CACHE_MAX_LEN];
+  size_t len = sizeof(buf);
+  if (!btif_config_get_bin(p_scb->PeerAddress().ToString(),
+                           BTA_AV_SEP_CACHE_CONFIG_KEY, buf, &len) ||
+      len < BTA_AV_SEP_CACHE_HDR_LEN + sizeof(uint32_t)) {
+    return nullptr;
+  }
+
+  uint8_t* p = buf;
+  uint8_t version, num_seps;
+  uint16_t uuid_int;
+  uint32_t check_value;
+  STREAM_TO_UINT8(version, p);
+  STREAM_TO_UINT16(uuid_int, p);
+  STREAM_TO_UINT8(num_seps, p);
+  if (version != BTA_AV_SEP_CACHE_VERSION || uuid_int != p_scb->uuid_int ||
+      num_seps == 0 || num_seps > BTA_AV_NUM_SEPS ||
+      len != BTA_AV_SEP_CACHE_HDR_LEN + num_seps * BTA_AV_SEP_CACHE_SEP_LEN +
+                 sizeof(uint32_t)) {
+    return nullptr;
+  }
+  size_t check_len = len - sizeof(uint32_t);
+  uint8_t* p_check = buf + check_len;
+  STREAM_TO_UINT32(check_value, p_check);
+  if (check_value != bta_av_cap_cache_check_value(buf, check_len)) {
+    APPL_TRACE_WARNING("%s: Corrupt stream discovery results for %s", __func__,
+                       p_scb->PeerAddress().ToString().c_str());
+    return nullptr;
+  }
+
+  AvdtpSepConfig peer_cap[BTA_AV_NUM_SEPS];
+  bool cap_valid[BTA_AV_NUM_SEPS];
+  p_scb->num_seps = num_seps;
+  for (uint8_t i = 0; i < num_seps; i++) {
+    tAVDT_SEP_INFO* p_info = &p_scb->sep_info[i];
+    AvdtpSepConfig* p_cap = &peer_cap[i];
+    uint8_t valid;
+    p_info->in_use = false;
+    STREAM_TO_UINT8(p_info->seid, p);
+    STREAM_TO_UINT8(p_info->media_type, p);
+    STREAM_TO_UINT8(p_info->tsep, p);
+    STREAM_TO_UINT8(valid, p);
+    STREAM_TO_ARRAY(p_cap->codec_info, p, AVDT_CODEC_SIZE);
+    STREAM_TO_ARRAY(p_cap->protect_info, p, AVDT_PROTECT_SIZE);
+    STREAM_TO_UINT8(p_cap->num_codec, p);
+    STREAM_TO_UINT8(p_cap->num_protect, p);
+    STREAM_TO_UINT16(p_cap->psc_mask, p);
+    STREAM_TO_UINT8(p_cap->recov_type, p);
+    STREAM_TO_UINT8(p_cap->recov_mrws, p);
+    STREAM_TO_UINT8(p_cap->recov_mnmp, p);
+    STREAM_TO_UINT8(p_cap->hdrcmp_mask, p);
+    cap_valid[i] = (valid != 0);
+  }
+
+  bta_av_cap_cache_store(p_scb);
+  tBTA_AV_CAP_CACHE* p_entry =
+      bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int);
+  for (uint8_t i = 0; i < num_seps; i++) {
+    p_entry->peer_cap[i] = peer_cap[i];
+    p_entry->cap_valid[i] = cap_valid[i];
+  }
+  p_entry->from_storage = true;
+  return p_entry;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_store_cap
+ *
+ * Description      Record the capabilities just received from the peer for
+ *                  the current stream endpoint.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_store_cap(tBTA_AV_SCB* p_scb) {
+  if (p_scb->disc_cached || p_scb->sep_info_idx >= BTA_AV_NUM_SEPS) return;
+
+  tBTA_AV_CAP_CACHE* p_entry =
+      bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int);
+  if (p_entry == nullptr) return;
+  p_entry->peer_cap[p_scb->sep_info_idx] = p_scb->peer_cap;
+  p_entry->cap_valid[p_scb->sep_info_idx] = true;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_forget
+ *
+ * Description      Drop the cached discovery results of a peer from memory.
+ *                  The persisted copy is kept, it is checked against a fresh
+ *                  discovery when the peer connects again.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_forget(const RawAddress& peer_addr) {
+  for (tBTA_AV_CAP_CACHE& entry : bta_av_cap_cache) {
+    if (entry.in_use && entry.peer_addr == peer_addr) entry.in_use = false;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_cap_cache_remove
+ *
+ * Description      Forget the cached discovery results of a peer, in memory
+ *                  and in its config section.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_cap_cache_remove(const RawAddress& peer_addr) {
+  bta_av_cap_cache_forget(peer_addr);
+  if (btif_config_remove(peer_addr.ToString(), BTA_AV_SEP_CACHE_CONFIG_KEY)) {
+    btif_config_save();
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_next_getcap
@@ -309,6 +626,22 @@ static bool bta_av_next_getcap(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
         (p_scb->sep_info[i].media_type == p_scb->media_type)) {
       p_scb->sep_info_idx = i;
 
+      /* replay the capabilities learnt on a previous connection */
+      tBTA_AV_CAP_CACHE* p_entry =
+          p_scb->disc_cached
+              ? bta_av_cap_cache_find(p_scb->PeerAddress(), uuid_int)
+              : nullptr;
+      if (p_entry != nullptr && p_entry->cap_valid[i]) {
+        tAVDT_CTRL ctrl;
+        memset(&ctrl, 0, sizeof(ctrl));
+        p_scb->peer_cap = p_entry->peer_cap[i];
+        ctrl.getcap_cfm.p_cfg = &p_scb->peer_cap;
+        bta_av_proc_stream_evt(0, p_scb->PeerAddress(), AVDT_GETCAP_CFM_EVT,
+                               &ctrl, p_scb->hdi);
+        sent_cmd = true;
+        break;
+      }
+
       /* we got a stream; get its capabilities */
       bool get_all_cap = (p_scb->AvdtpVersion() >= AVDT_VERSION_1_3) &&
                          (A2DP_GetAvdtpVersion() >= AVDT_VERSION_1_3);
@@ -856,6 +1189,8 @@ void bta_av_cleanup(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
   p_scb->wait = 0;
   p_scb->num_disc_snks = 0;
   p_scb->coll_mask = 0;
+  p_scb->disc_cached = false;
+  bta_av_cap_cache_forget(p_scb->PeerAddress());
   alarm_cancel(p_scb->avrc_ct_timer);
   alarm_cancel(p_scb->link_signalling_timer);
   alarm_cancel(p_scb->accept_signalling_timer);
@@ -1424,6 +1759,8 @@ void bta_av_disc_results(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
   /* if we got any */
   if (p_scb->num_seps > 0) {
+    bta_av_cap_cache_update(p_scb);
+
     /* initialize index into discovery results */
     p_scb->sep_info_idx = 0;
 
@@ -1473,6 +1810,8 @@ void bta_av_disc_res_as_acp(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
   /* if we got any */
   if (p_scb->num_seps > 0) {
+    bta_av_cap_cache_update(p_scb);
+
     /* initialize index into discovery results */
     p_scb->sep_info_idx = 0;
 
@@ -1509,6 +1848,8 @@ void bta_av_save_caps(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   APPL_TRACE_DEBUG("%s: codec: %s", __func__,
                    A2DP_CodecInfoString(p_scb->peer_cap.codec_info).c_str());
 
+  bta_av_cap_cache_store_cap(p_scb);
+
   cfg = p_scb->peer_cap;
   /* let application know the capability of the SNK */
   if (p_scb->p_cos->getcfg(p_scb->hndl, p_scb->PeerAddress(), cfg.codec_info,
@@ -1541,6 +1882,7 @@ void bta_av_save_caps(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
                      __func__, p_scb->num_seps, p_scb->sep_info_idx,
                      p_scb->wait);
     p_scb->wait &= ~(BTA_AV_WAIT_ACP_CAPS_ON | BTA_AV_WAIT_ACP_CAPS_STARTED);
+    if (!p_scb->disc_cached) bta_av_cap_cache_save(p_scb);
     if (old_wait & BTA_AV_WAIT_ACP_CAPS_STARTED) {
       bta_av_start_ok(p_scb, NULL);
     }
@@ -1592,6 +1934,7 @@ void bta_av_open_failed(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   APPL_TRACE_ERROR("%s: peer_addr=%s", __func__,
                    p_scb->PeerAddress().ToString().c_str());
   p_scb->open_status = BTA_AV_FAIL_STREAM;
+  bta_av_cap_cache_remove(p_scb->PeerAddress());
   bta_av_cco_close(p_scb, p_data);
 
   /* check whether there is already an opened audio or video connection with the
@@ -1653,6 +1996,8 @@ void bta_av_getcap_results(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   uint8_t media_type = A2DP_GetMediaType(p_scb->peer_cap.codec_info);
   tAVDT_SEP_INFO* p_info = &p_scb->sep_info[p_scb->sep_info_idx];
 
+  bta_av_cap_cache_store_cap(p_scb);
+
   cfg.num_codec = 1;
   cfg.num_protect = p_scb->peer_cap.num_protect;
   memcpy(cfg.codec_info, p_scb->peer_cap.codec_info, AVDT_CODEC_SIZE);
@@ -1677,6 +2022,7 @@ void bta_av_getcap_results(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
     /* save copy of codec configuration */
     p_scb->cfg = cfg;
+    if (!p_scb->disc_cached) bta_av_cap_cache_save(p_scb);
 
     APPL_TRACE_DEBUG("%s: result: sep_info_idx=%d", __func__,
                      p_scb->sep_info_idx);
@@ -1762,7 +2108,17 @@ void bta_av_setconfig_rej(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
  *
  ******************************************************************************/
 void bta_av_discover_req(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
-  /* send avdtp discover request */
+  tBTA_AV_CAP_CACHE* p_entry =
+      bta_av_cap_cache_find(p_scb->PeerAddress(), p_scb->uuid_int);
+  if (p_entry == nullptr) p_entry = bta_av_cap_cache_load(p_scb);
+  p_scb->disc_cached = (p_entry != nullptr);
+  if (p_scb->disc_cached) {
+    LOG_INFO("%s: peer %s has cached stream capabilities", __func__,
+             p_scb->PeerAddress().ToString().c_str());
+  }
+
+  /* send avdtp discover request, also with cached results: the in-use state
+   * of the peer's stream endpoints is only known from a fresh discovery */
 
   AVDT_DiscoverReq(p_scb->PeerAddress(), p_scb->hdi, p_scb->sep_info,
                    BTA_AV_NUM_SEPS, &bta_av_proc_stream_evt);
@@ -1877,7 +2233,6 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   tBTA_AV_SUSPEND suspend_rsp;
   uint8_t start = p_scb->started;
   bool sus_evt = true;
-  BT_HDR* p_buf;
 
   APPL_TRACE_ERROR(
       "%s: peer %s bta_handle:0x%x audio_open_cnt:%d, p_data %p start:%d",
@@ -1905,11 +2260,7 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
   /* if q_info.a2dp_list is not empty, drop it now */
   if (BTA_AV_CHNL_AUDIO == p_scb->chnl) {
-    while (!list_is_empty(p_scb->a2dp_list)) {
-      p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-      list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
-    }
+    bta_av_flush_audio_list(p_scb);
 
     /* drop the audio buffers queued in L2CAP */
     if (p_data && p_data->api_stop.flush)
@@ -2058,8 +2409,7 @@ void bta_av_reconfig(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
  *
  ******************************************************************************/
 void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
-  BT_HDR* p_buf = NULL;
-  uint32_t timestamp;
+  tBTA_AV_MEDIA_PKT* p_pkt = NULL;
   bool new_buf = false;
   uint8_t m_pt = 0x60;
   tAVDT_DATA_OPT_MASK opt;
@@ -2077,30 +2427,30 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
       (uint8_t)L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_GET);
 
   if (!list_is_empty(p_scb->a2dp_list)) {
-    p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-    list_remove(p_scb->a2dp_list, p_buf);
-    /* use q_info.a2dp data, read the timestamp */
-    timestamp = *(uint32_t*)(p_buf + 1);
+    p_pkt = (tBTA_AV_MEDIA_PKT*)list_front(p_scb->a2dp_list);
+    list_remove(p_scb->a2dp_list, p_pkt);
   } else {
     new_buf = true;
-    /* A2DP_list empty, call co_data, dup data to other channels */
-    p_buf = p_scb->p_cos->data(p_scb->cfg.codec_info, &timestamp);
+    /* A2DP_list empty, call co_data, share the data with other channels */
+    uint32_t timestamp;
+    BT_HDR* p_buf = p_scb->p_cos->data(p_scb->cfg.codec_info, &timestamp);
 
     if (p_buf) {
-      /* use the offset area for the time stamp */
-      *(uint32_t*)(p_buf + 1) = timestamp;
+      p_pkt = bta_av_media_pkt_new(p_buf, timestamp);
 
-      /* dup the data to other channels */
-      bta_av_dup_audio_buf(p_scb, p_buf);
+      /* fan the data out to other channels */
+      bta_av_dup_audio_buf(p_scb, p_pkt);
     }
   }
 
-  if (p_buf) {
+  if (p_pkt) {
     if (p_scb->l2c_bufs < (BTA_AV_QUEUE_DATA_CHK_NUM)) {
       /* There's a buffer, just queue it to L2CAP.
        * There's no need to increment it here, it is always read from
        * L2CAP (see above).
        */
+      uint32_t timestamp = p_pkt->timestamp;
+      BT_HDR* p_buf = bta_av_media_pkt_take(p_pkt);
 
       /* opt is a bit mask, it could have several options set */
       opt = AVDT_DATA_OPT_NONE;
@@ -2158,16 +2508,16 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
       if (new_buf) {
         /* just got this buffer from co_data,
          * put it in queue */
-        list_append(p_scb->a2dp_list, p_buf);
+        list_append(p_scb->a2dp_list, p_pkt);
       } else {
         /* just dequeue it from the a2dp_list */
         if (list_length(p_scb->a2dp_list) < 3) {
           /* put it back to the queue */
-          list_prepend(p_scb->a2dp_list, p_buf);
+          list_prepend(p_scb->a2dp_list, p_pkt);
         } else {
           /* too many buffers in a2dp_list, drop it. */
           bta_av_co_audio_drop(p_scb->hndl, p_scb->PeerAddress());
-          osi_free(p_buf);
+          bta_av_media_pkt_release(p_pkt);
         }
       }
     }
@@ -2805,6 +3155,7 @@ void bta_av_rcfg_open(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
     p_scb->p_cos->stop(p_scb->hndl, p_scb->PeerAddress());
 
     /* send avdtp discover request */
+    p_scb->disc_cached = false;
     AVDT_DiscoverReq(p_scb->PeerAddress(), p_scb->hdi, p_scb->sep_info,
                      BTA_AV_NUM_SEPS, &bta_av_proc_stream_evt);
   } else {
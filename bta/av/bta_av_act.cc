@@ -2248,7 +2248,6 @@ void bta_av_dereg_comp(tBTA_AV_DATA* p_data) {
   tBTA_AV_SCB* p_scb;
   tBTA_UTL_COD cod;
   uint8_t mask;
-  BT_HDR* p_buf;
 
   /* find the stream control block */
   p_scb = bta_av_hndl_to_scb(p_data->hdr.layer_specific);
@@ -2266,11 +2265,7 @@ void bta_av_dereg_comp(tBTA_AV_DATA* p_data) {
 
     if (p_scb->q_tag == BTA_AV_Q_TAG_STREAM && p_scb->a2dp_list) {
       /* make sure no buffers are in a2dp_list */
-      while (!list_is_empty(p_scb->a2dp_list)) {
-        p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
-        list_remove(p_scb->a2dp_list, p_buf);
-        osi_free(p_buf);
-      }
+      bta_av_flush_audio_list(p_scb);
     }
 
     /* remove the A2DP SDP record, if no more audio stream is left */
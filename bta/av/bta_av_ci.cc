@@ -41,12 +41,13 @@
  *
  ******************************************************************************/
 void bta_av_ci_src_data_ready(tBTA_AV_CHNL chnl) {
-  BT_HDR_RIGID* p_buf = (BT_HDR_RIGID*)osi_malloc(sizeof(BT_HDR_RIGID));
+  BT_HDR_RIGID event = {};
 
-  p_buf->layer_specific = chnl;
-  p_buf->event = BTA_AV_CI_SRC_DATA_READY_EVT;
+  event.layer_specific = chnl;
+  event.event = BTA_AV_CI_SRC_DATA_READY_EVT;
 
-  bta_sys_sendmsg(p_buf);
+  /* Sent for every encoded frame, without allocating it */
+  bta_sys_send_event<bta_av_hdl_event>(event);
 }
 
 /*******************************************************************************
@@ -135,6 +135,12 @@ enum {
 /* maximum number of SEPS in stream discovery results */
 #define BTA_AV_NUM_SEPS 32
 
+/* number of peers whose stream discovery results are kept across
+ * connections */
+#ifndef BTA_AV_CAP_CACHE_SIZE
+#define BTA_AV_CAP_CACHE_SIZE 4
+#endif
+
 /* initialization value for AVRC handle */
 #define BTA_AV_RC_HANDLE_NONE 0xFF
 
@@ -450,6 +456,16 @@ typedef union {
                             is needed on another AV channel */
 } tBTA_AV_Q_INFO;
 
+/* An encoded audio packet shared by the audio channels it is fanned out to.
+ * Each channel queues a reference in its a2dp_list. The channel that sends
+ * the last reference gets the original buffer, the others get a copy, since
+ * AVDTP and L2CAP write their headers into the headroom of the buffer. */
+typedef struct {
+  BT_HDR* p_buf;
+  uint32_t timestamp;
+  uint8_t ref_cnt;
+} tBTA_AV_MEDIA_PKT;
+
 #define BTA_AV_Q_TAG_OPEN 0x01   /* after API_OPEN, before STR_OPENED */
 #define BTA_AV_Q_TAG_START 0x02  /* before start sending media packets */
 #define BTA_AV_Q_TAG_STREAM 0x03 /* during streaming */
@@ -486,7 +502,7 @@ struct tBTA_AV_SCB final {
   bool sdp_discovery_started; /* variable to determine whether SDP is started */
   tBTA_AV_SEP seps[BTAV_A2DP_CODEC_INDEX_MAX];
   AvdtpSepConfig peer_cap; /* buffer used for get capabilities */
-  list_t* a2dp_list; /* used for audio channels only */
+  list_t* a2dp_list; /* tBTA_AV_MEDIA_PKT, used for audio channels only */
   tBTA_AV_Q_INFO q_info;
   tAVDT_SEP_INFO sep_info[BTA_AV_NUM_SEPS]; /* stream discovery results */
   AvdtpSepConfig cfg;                       /* local SEP configuration */
@@ -508,6 +524,7 @@ struct tBTA_AV_SCB final {
   uint8_t num_seps;           /* number of seps returned by stream discovery */
   uint8_t num_disc_snks;      /* number of discovered snks */
   uint8_t num_disc_srcs;      /* number of discovered srcs */
+  bool disc_cached;           /* true if cached capabilities are replayed */
   uint8_t sep_info_idx;       /* current index into sep_info */
   uint8_t sep_idx;            /* current index into local seps[] */
   uint8_t rcfg_idx;           /* reconfig requested index into sep_info */
@@ -710,7 +727,12 @@ extern void bta_av_free_scb(tBTA_AV_SCB* p_scb);
 
 /* main functions */
 extern void bta_av_api_deregister(tBTA_AV_DATA* p_data);
-extern void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf);
+extern tBTA_AV_MEDIA_PKT* bta_av_media_pkt_new(BT_HDR* p_buf,
+                                               uint32_t timestamp);
+extern BT_HDR* bta_av_media_pkt_take(tBTA_AV_MEDIA_PKT* p_pkt);
+extern void bta_av_media_pkt_release(tBTA_AV_MEDIA_PKT* p_pkt);
+extern void bta_av_flush_audio_list(tBTA_AV_SCB* p_scb);
+extern void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt);
 extern void bta_av_sm_execute(tBTA_AV_CB* p_cb, uint16_t event,
                               tBTA_AV_DATA* p_data);
 extern void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
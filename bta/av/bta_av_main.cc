@@ -1043,21 +1043,103 @@ bool bta_av_link_role_ok(tBTA_AV_SCB* p_scb, uint8_t bits) {
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_new
+ *
+ * Description      Wrap an encoded audio packet so it can be shared by
+ *                  several audio channels.  The caller holds the only
+ *                  reference.
+ *
+ * Returns          The shared packet
+ *
+ ******************************************************************************/
+tBTA_AV_MEDIA_PKT* bta_av_media_pkt_new(BT_HDR* p_buf, uint32_t timestamp) {
+  tBTA_AV_MEDIA_PKT* p_pkt =
+      (tBTA_AV_MEDIA_PKT*)osi_malloc(sizeof(tBTA_AV_MEDIA_PKT));
+  p_pkt->p_buf = p_buf;
+  p_pkt->timestamp = timestamp;
+  p_pkt->ref_cnt = 1;
+  return p_pkt;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_take
+ *
+ * Description      Drop a reference to a shared audio packet, and get a
+ *                  buffer that the caller owns and may hand to AVDTP.  The
+ *                  data is copied only if other channels still hold a
+ *                  reference.
+ *
+ * Returns          The buffer to send
+ *
+ ******************************************************************************/
+BT_HDR* bta_av_media_pkt_take(tBTA_AV_MEDIA_PKT* p_pkt) {
+  BT_HDR* p_buf = p_pkt->p_buf;
+
+  if (--p_pkt->ref_cnt == 0) {
+    osi_free(p_pkt);
+    return p_buf;
+  }
+
+  uint16_t copy_size = BT_HDR_SIZE + p_buf->offset + p_buf->len;
+  BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
+  memcpy(p_new, p_buf, copy_size);
+  return p_new;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_media_pkt_release
+ *
+ * Description      Drop a reference to a shared audio packet without sending
+ *                  it, and free it if it was the last reference.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_media_pkt_release(tBTA_AV_MEDIA_PKT* p_pkt) {
+  if (--p_pkt->ref_cnt > 0) return;
+
+  osi_free(p_pkt->p_buf);
+  osi_free(p_pkt);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_flush_audio_list
+ *
+ * Description      Drop the audio packets queued for an audio channel.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_flush_audio_list(tBTA_AV_SCB* p_scb) {
+  while (!list_is_empty(p_scb->a2dp_list)) {
+    tBTA_AV_MEDIA_PKT* p_pkt =
+        static_cast<tBTA_AV_MEDIA_PKT*>(list_front(p_scb->a2dp_list));
+    list_remove(p_scb->a2dp_list, p_pkt);
+    bta_av_media_pkt_release(p_pkt);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_dup_audio_buf
  *
- * Description      dup the audio data to the q_info.a2dp of other audio
- *                  channels
+ * Description      Queue a reference to the audio packet in the a2dp_list of
+ *                  the other started audio channels with the same codec
+ *                  configuration.  Each channel drains its list at its own
+ *                  pace, and drops its oldest packets when it falls behind.
  *
  * Returns          void
  *
  ******************************************************************************/
-void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
+void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt) {
   /* Test whether there is more than one audio channel connected */
-  if ((p_buf == NULL) || (bta_av_cb.audio_open_cnt < 2)) return;
+  if ((p_pkt == NULL) || (bta_av_cb.audio_open_cnt < 2)) return;
 
-  uint16_t copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
   for (int i = 0; i < BTA_AV_NUM_STRS; i++) {
     tBTA_AV_SCB* p_scbi = bta_av_cb.p_scb[i];
 
@@ -1066,18 +1148,20 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
       continue; /* Ignore if SCB is not used or started */
     if (!(bta_av_cb.conn_audio & BTA_AV_HNDL_TO_MSK(i)))
       continue; /* Audio is not connected */
+    if (!A2DP_CodecEquals(p_scb->cfg.codec_info, p_scbi->cfg.codec_info))
+      continue; /* The packet was not encoded for this channel */
 
     /* Enqueue the data */
-    BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
-    memcpy(p_new, p_buf, copy_size);
-    list_append(p_scbi->a2dp_list, p_new);
+    p_pkt->ref_cnt++;
+    list_append(p_scbi->a2dp_list, p_pkt);
 
     if (list_length(p_scbi->a2dp_list) > p_bta_av_cfg->audio_mqs) {
       // Drop the oldest packet
       bta_av_co_audio_drop(p_scbi->hndl, p_scbi->PeerAddress());
-      BT_HDR* p_buf_drop = static_cast<BT_HDR*>(list_front(p_scbi->a2dp_list));
-      list_remove(p_scbi->a2dp_list, p_buf_drop);
-      osi_free(p_buf_drop);
+      tBTA_AV_MEDIA_PKT* p_pkt_drop =
+          static_cast<tBTA_AV_MEDIA_PKT*>(list_front(p_scbi->a2dp_list));
+      list_remove(p_scbi->a2dp_list, p_pkt_drop);
+      bta_av_media_pkt_release(p_pkt_drop);
     }
   }
 }
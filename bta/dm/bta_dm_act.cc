@@ -27,6 +27,7 @@
 
 #include <base/logging.h>
 
+#include <algorithm>
 #include <cstdint>
 
 #include "bta/dm/bta_dm_int.h"
@@ -838,6 +839,7 @@ void bta_dm_search_start(tBTA_DM_MSG* p_data) {
                    p_bta_dm_cfg->avoid_scatter);
 
   BTM_ClearInqDb(nullptr);
+  bta_dm_search_cb.disc_order_count = 0;
   /* save search params */
   bta_dm_search_cb.p_search_cback = p_data->search.p_cback;
   bta_dm_search_cb.services = p_data->search.services;
@@ -905,6 +907,7 @@ void bta_dm_discover(tBTA_DM_MSG* p_data) {
   bta_dm_search_cb.services_found = 0;
   bta_dm_search_cb.peer_name[0] = 0;
   bta_dm_search_cb.p_btm_inq_info = BTM_InqDbRead(p_data->discover.bd_addr);
+  bta_dm_search_cb.disc_order_count = 0;
   bta_dm_search_cb.transport = p_data->discover.transport;
 
   bta_dm_search_cb.name_discover_done = false;
@@ -1005,7 +1008,19 @@ void bta_dm_inq_cmpl(uint8_t num) {
   data.inq_cmpl.num_resps = num;
   bta_dm_search_cb.p_search_cback(BTA_DM_INQ_CMPL_EVT, &data);
 
-  bta_dm_search_cb.p_btm_inq_info = BTM_InqDbFirst();
+  bta_dm_search_cb.disc_order_count = 0;
+  for (tBTM_INQ_INFO* p_info = BTM_InqDbFirst();
+       p_info != NULL && bta_dm_search_cb.disc_order_count < BTM_INQ_DB_SIZE;
+       p_info = BTM_InqDbNext(p_info)) {
+    bta_dm_search_cb.disc_order[bta_dm_search_cb.disc_order_count++] = p_info;
+  }
+  bta_dm_order_inq_results(bta_dm_search_cb.disc_order,
+                           bta_dm_search_cb.disc_order_count);
+  bta_dm_search_cb.disc_order_index = 0;
+
+  bta_dm_search_cb.p_btm_inq_info = (bta_dm_search_cb.disc_order_count != 0)
+                                        ? bta_dm_search_cb.disc_order[0]
+                                        : NULL;
   if (bta_dm_search_cb.p_btm_inq_info != NULL) {
     /* start name and service discovery from the first device on inquiry result
      */
@@ -1019,6 +1034,40 @@ void bta_dm_inq_cmpl(uint8_t num) {
   }
 }
 
+/* Inquiry results with a name need no remote name request */
+static bool bta_dm_inq_name_known(const tBTM_INQ_INFO* p_info) {
+  return p_info->appl_knows_rem_name ||
+         p_info->results.device_type == BT_DEVICE_TYPE_BLE;
+}
+
+static int bta_dm_inq_rssi(const tBTM_INQ_INFO* p_info) {
+  if (p_info->results.rssi == BTM_INQ_RES_IGNORE_RSSI) return INT8_MIN - 1;
+  return p_info->results.rssi;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_order_inq_results
+ *
+ * Description      Orders the inquiry results for name and service discovery.
+ *                  The devices with a known name come first, as they are
+ *                  reported without a remote name request, then the others
+ *                  from the strongest signal: they answer the page sooner, and
+ *                  are the closest to the user. Devices without a signal
+ *                  strength come last, the order is kept otherwise.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_dm_order_inq_results(tBTM_INQ_INFO** p_infos, uint16_t count) {
+  std::stable_sort(p_infos, p_infos + count,
+                   [](const tBTM_INQ_INFO* a, const tBTM_INQ_INFO* b) {
+                     bool a_known = bta_dm_inq_name_known(a);
+                     if (a_known != bta_dm_inq_name_known(b)) return a_known;
+                     return bta_dm_inq_rssi(a) > bta_dm_inq_rssi(b);
+                   });
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_rmt_name
@@ -1249,8 +1298,7 @@ void bta_dm_sdp_result(tBTA_DM_MSG* p_data) {
       bta_dm_search_cb.wait_disc = false;
 
     /* not able to connect go to next device */
-    if (bta_dm_search_cb.p_sdp_db)
-      osi_free_and_reset((void**)&bta_dm_search_cb.p_sdp_db);
+    bta_dm_free_sdp_db();
 
     if (bluetooth::shim::is_gd_security_enabled()) {
       bluetooth::shim::BTM_SecDeleteRmtNameNotifyCallback(
@@ -1416,7 +1464,8 @@ static void bta_dm_search_timer_cback(UNUSED_ATTR void* data) {
  *
  ******************************************************************************/
 void bta_dm_free_sdp_db() {
-  osi_free_and_reset((void**)&bta_dm_search_cb.p_sdp_db);
+  SDP_FreeDiscoveryDb(bta_dm_search_cb.p_sdp_db);
+  bta_dm_search_cb.p_sdp_db = NULL;
 }
 
 /*******************************************************************************
@@ -1549,8 +1598,6 @@ static void bta_dm_find_services(const RawAddress& bd_addr) {
     if (bta_dm_search_cb.services_to_search &
         (tBTA_SERVICE_MASK)(
             BTA_SERVICE_ID_TO_SERVICE_MASK(bta_dm_search_cb.service_index))) {
-      bta_dm_search_cb.p_sdp_db =
-          (tSDP_DISCOVERY_DB*)osi_malloc(BTA_DM_SDP_DB_SIZE);
       APPL_TRACE_DEBUG("bta_dm_search_cb.services = %04x***********",
                        bta_dm_search_cb.services);
       /* try to search all services by search based on L2CAP UUID */
@@ -1582,8 +1629,8 @@ static void bta_dm_find_services(const RawAddress& bd_addr) {
       }
 
       LOG_INFO("%s search UUID = %s", __func__, uuid.ToString().c_str());
-      SDP_InitDiscoveryDb(bta_dm_search_cb.p_sdp_db, BTA_DM_SDP_DB_SIZE, 1,
-                          &uuid, 0, NULL);
+      bta_dm_search_cb.p_sdp_db =
+          SDP_CreateDiscoveryDb(BTA_DM_SDP_DB_SIZE, 1, &uuid, 0, NULL);
 
       memset(g_disc_raw_data_buf, 0, sizeof(g_disc_raw_data_buf));
       bta_dm_search_cb.p_sdp_db->raw_data = g_disc_raw_data_buf;
@@ -1596,7 +1643,7 @@ static void bta_dm_find_services(const RawAddress& bd_addr) {
          * If discovery is not successful with this device, then
          * proceed with the next one.
          */
-        osi_free_and_reset((void**)&bta_dm_search_cb.p_sdp_db);
+        bta_dm_free_sdp_db();
         bta_dm_search_cb.service_index = BTA_MAX_SERVICE_ID;
 
       } else {
@@ -1637,8 +1684,16 @@ static void bta_dm_discover_next_device(void) {
   APPL_TRACE_DEBUG("bta_dm_discover_next_device");
 
   /* searching next device on inquiry result */
-  bta_dm_search_cb.p_btm_inq_info =
-      BTM_InqDbNext(bta_dm_search_cb.p_btm_inq_info);
+  if (bta_dm_search_cb.disc_order_count == 0) {
+    bta_dm_search_cb.p_btm_inq_info =
+        BTM_InqDbNext(bta_dm_search_cb.p_btm_inq_info);
+  } else if (++bta_dm_search_cb.disc_order_index <
+             bta_dm_search_cb.disc_order_count) {
+    bta_dm_search_cb.p_btm_inq_info =
+        bta_dm_search_cb.disc_order[bta_dm_search_cb.disc_order_index];
+  } else {
+    bta_dm_search_cb.p_btm_inq_info = NULL;
+  }
   if (bta_dm_search_cb.p_btm_inq_info != NULL) {
     bta_dm_search_cb.name_discover_done = false;
     bta_dm_search_cb.peer_name[0] = 0;
@@ -1759,6 +1814,8 @@ static void bta_dm_discover_device(const RawAddress& remote_bd_addr) {
         }
       } else {
         bta_dm_search_cb.sdp_results = false;
+        /* A service discovery asks for fresh records */
+        SDP_InvalidateCache(bta_dm_search_cb.peer_bdaddr);
         bta_dm_find_services(bta_dm_search_cb.peer_bdaddr);
         return;
       }
@@ -1833,6 +1890,13 @@ static void bta_dm_inq_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
   result.inq_res.p_eir = p_eir;
   result.inq_res.eir_len = eir_len;
 
+  /* The cached SDP records are stale once the advertised services change */
+  if (p_eir) {
+    SDP_UpdateCacheFingerprint(p_inq->remote_bd_addr,
+                               (const uint8_t*)p_inq->eir_uuid,
+                               sizeof(p_inq->eir_uuid));
+  }
+
   p_inq_info = BTM_InqDbRead(p_inq->remote_bd_addr);
   if (p_inq_info != NULL) {
     /* initialize remt_name_not_required to false so that we get the name by
@@ -2418,6 +2482,7 @@ void bta_dm_acl_up(const RawAddress& bd_addr, tBT_TRANSPORT transport) {
   device->pref_role = BTA_ANY_ROLE;
   device->info = BTA_DM_DI_NONE;
   device->transport = transport;
+  device->pm_policy.Reset();
 
   if (controller_get_interface()->supports_sniff_subrating() &&
       acl_peer_supports_sniff_subrating(bd_addr)) {
@@ -2578,7 +2643,7 @@ static void bta_dm_disable_conn_down_timer_cback(UNUSED_ATTR void* data) {
 
   bta_dm_cb.disabling = false;
   LOG_INFO("Stack device manager shutdown completed");
-  future_ready(stack_manager_get_hack_future(), FUTURE_SUCCESS);
+  stack_manager_signal_stage_done();
 }
 
 /*******************************************************************************
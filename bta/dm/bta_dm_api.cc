@@ -579,6 +579,20 @@ void BTA_DmBleGetEnergyInfo(tBTA_BLE_ENERGY_INFO_CBACK* p_cmpl_cback) {
                     base::Bind(bta_dm_ble_get_energy_info, p_cmpl_cback));
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_DmPmDumpStatistics
+ *
+ * Description      Dump the power mode decisions taken from the traffic of
+ *                  the connected links, and how often they were right
+ *
+ * Parameters       fd - file descriptor to dump to
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_DmPmDumpStatistics(int fd) { bta_dm_pm_dump_statistics(fd); }
+
 /** This function is to set maximum LE data packet size */
 void BTA_DmBleRequestMaxTxDataLength(const RawAddress& remote_device) {
   do_in_main_thread(FROM_HERE,
@@ -30,6 +30,7 @@
 
 #include "bt_target.h"  // Must be first to define build configuration
 
+#include "bta/dm/bta_dm_pm_policy.h"
 #include "bta/include/bta_api.h"
 #include "bta/include/bta_gatt_api.h"
 #include "bta/sys/bta_sys.h"
@@ -245,6 +246,7 @@ struct sBTA_DM_PEER_DEVICE {
   tBTA_DM_PM_ACTION pm_mode_failed;
   bool remove_dev_pending;
   tBT_TRANSPORT transport;
+  PmTrafficPolicy pm_policy; /* power mode decisions from the ACL traffic */
 };
 typedef struct sBTA_DM_PEER_DEVICE tBTA_DM_PEER_DEVICE;
 
@@ -377,6 +379,10 @@ typedef struct {
   uint16_t conn_id;
   alarm_t* gatt_close_timer; /* GATT channel close delay timer */
   RawAddress pending_close_bda; /* pending GATT channel remote device address */
+  /* inquiry results, in the order they are discovered in */
+  tBTM_INQ_INFO* disc_order[BTM_INQ_DB_SIZE];
+  uint16_t disc_order_count;
+  uint16_t disc_order_index;
 
 } tBTA_DM_SEARCH_CB;
 
@@ -523,12 +529,14 @@ extern void bta_dm_ci_rmt_oob_act(std::unique_ptr<tBTA_DM_CI_RMT_OOB> msg);
 
 extern void bta_dm_init_pm(void);
 extern void bta_dm_disable_pm(void);
+extern void bta_dm_pm_dump_statistics(int fd);
 
 extern uint8_t bta_dm_get_av_count(void);
 extern void bta_dm_search_start(tBTA_DM_MSG* p_data);
 extern void bta_dm_search_cancel();
 extern void bta_dm_discover(tBTA_DM_MSG* p_data);
 extern void bta_dm_inq_cmpl(uint8_t num);
+extern void bta_dm_order_inq_results(tBTM_INQ_INFO** p_infos, uint16_t count);
 extern void bta_dm_rmt_name(tBTA_DM_MSG* p_data);
 extern void bta_dm_sdp_result(tBTA_DM_MSG* p_data);
 extern void bta_dm_search_cmpl();
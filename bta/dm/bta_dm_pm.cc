@@ -31,9 +31,11 @@
 #include "bta/include/bta_api.h"
 #include "bta/include/bta_dm_api.h"
 #include "bta/sys/bta_sys.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "main/shim/dumpsys.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/btu.h"  // do_in_main_thread
 #include "types/raw_address.h"
@@ -67,6 +69,10 @@ tBTA_DM_CONNECTED_SRVCS bta_dm_conn_srvcs;
 static std::recursive_mutex pm_timer_schedule_mutex;
 static std::recursive_mutex pm_timer_state_mutex;
 
+/* Whether the power mode tables are adapted to the traffic of the links */
+#define BTA_DM_PM_TRAFFIC_POLICY_PROPERTY "bluetooth.pm.traffic_policy.enabled"
+static bool bta_dm_pm_traffic_policy;
+
 /*******************************************************************************
  *
  * Function         bta_dm_init_pm
@@ -79,6 +85,8 @@ static std::recursive_mutex pm_timer_state_mutex;
  ******************************************************************************/
 void bta_dm_init_pm(void) {
   memset(&bta_dm_conn_srvcs, 0x00, sizeof(bta_dm_conn_srvcs));
+  bta_dm_pm_traffic_policy =
+      osi_property_get_bool(BTA_DM_PM_TRAFFIC_POLICY_PROPERTY, true);
 
   /* if there are no power manger entries, so not register */
   if (p_bta_dm_pm_cfg[0].app_id != 0) {
@@ -140,6 +148,33 @@ uint8_t bta_dm_get_av_count(void) {
   return count;
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_traffic_class
+ *
+ * Description      Get the traffic expected on a link from the state of the
+ *                  services connected on it
+ *
+ *
+ * Returns          PmTrafficClass
+ *
+ ******************************************************************************/
+static PmTrafficClass bta_dm_pm_traffic_class(const RawAddress& peer_addr) {
+  PmTrafficClass cls = PmTrafficClass::kData;
+  for (int i = 0; i < bta_dm_conn_srvcs.count; i++) {
+    const tBTA_DM_SRVCS& service = bta_dm_conn_srvcs.conn_srvc[i];
+    if (service.peer_bdaddr != peer_addr) continue;
+    if (service.state == BTA_SYS_SCO_OPEN ||
+        (service.id == BTA_ID_AV && service.state == BTA_SYS_CONN_BUSY)) {
+      return PmTrafficClass::kAudio;
+    }
+    if (service.id == BTA_ID_HH || service.id == BTA_ID_HD) {
+      cls = PmTrafficClass::kHid;
+    }
+  }
+  return cls;
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_pm_stop_timer
@@ -600,6 +635,26 @@ static void bta_dm_pm_set_mode(const RawAddress& peer_addr,
       }
     }
   }
+  /* adapt the time to enter sniff mode to the traffic of the link */
+  tBTM_ACL_TRAFFIC traffic;
+  if (bta_dm_pm_traffic_policy && (pm_action & BTA_DM_PM_SNIFF) &&
+      (timeout_ms > 0) && BTM_ReadAclTraffic(peer_addr, &traffic)) {
+    PmTrafficPolicy& policy = p_peer_device->pm_policy;
+    PmTrafficClass cls = bta_dm_pm_traffic_class(peer_addr);
+    if (pm_req != BTA_DM_PM_EXECUTE) {
+      timeout_ms = policy.SniffDelayMs(traffic, cls, timeout_ms);
+    } else {
+      uint64_t defer_ms = policy.SniffDeferMs(
+          traffic, cls, bluetooth::common::time_get_os_boottime_ms());
+      if (defer_ms > 0) {
+        LOG_DEBUG("Deferring sniff mode by %llu ms for peer:%s",
+                  (unsigned long long)defer_ms, PRIVATE_ADDRESS(peer_addr));
+        pm_req = BTA_DM_PM_RESTART;
+        timeout_ms = defer_ms;
+      }
+    }
+  }
+
   /* if need to start a timer */
   if ((pm_req != BTA_DM_PM_EXECUTE) && (timeout_ms > 0)) {
     for (i = 0; i < BTA_DM_NUM_PM_TIMER; i++) {
@@ -750,6 +805,12 @@ void bta_dm_pm_sniff(tBTA_DM_PEER_DEVICE* p_peer_dev, uint8_t index) {
   /* if the current mode is not sniff, issue the sniff command.
    * If sniff, but SSR is not used in this link, still issue the command */
   memcpy(&pwr_md, &p_bta_dm_pm_md[index], sizeof(tBTM_PM_PWR_MD));
+  tBTM_ACL_TRAFFIC traffic;
+  if (bta_dm_pm_traffic_policy &&
+      BTM_ReadAclTraffic(p_peer_dev->peer_bdaddr, &traffic)) {
+    p_peer_dev->pm_policy.AdjustSniff(
+        traffic, bta_dm_pm_traffic_class(p_peer_dev->peer_bdaddr), &pwr_md);
+  }
   if (p_peer_dev->Info() & BTA_DM_DI_INT_SNIFF) {
     LOG_DEBUG("Trying to force power mode");
     pwr_md.mode |= BTM_PM_MD_FORCE;
@@ -842,14 +903,24 @@ static void bta_dm_pm_ssr(const RawAddress& peer_addr, int ssr) {
       }
     }
 
+    /* links idle for long can tolerate a longer latency */
+    uint16_t max_lat = p_spec->max_lat;
+    tBTA_DM_PEER_DEVICE* p_dev = bta_dm_find_peer_device(peer_addr);
+    tBTM_ACL_TRAFFIC traffic;
+    if (bta_dm_pm_traffic_policy && p_dev != nullptr &&
+        BTM_ReadAclTraffic(peer_addr, &traffic)) {
+      max_lat = p_dev->pm_policy.SsrMaxLatency(
+          traffic, bta_dm_pm_traffic_class(peer_addr), max_lat);
+    }
+
     LOG_DEBUG(
         "Setting sniff subrating for device:%s spec_name:%s max_latency(s):%.2f"
         " min_local_timeout(s):%.2f min_remote_timeout(s):%.2f",
-        PRIVATE_ADDRESS(peer_addr), p_spec->name,
-        ticks_to_seconds(p_spec->max_lat), ticks_to_seconds(p_spec->min_loc_to),
+        PRIVATE_ADDRESS(peer_addr), p_spec->name, ticks_to_seconds(max_lat),
+        ticks_to_seconds(p_spec->min_loc_to),
         ticks_to_seconds(p_spec->min_rmt_to));
     /* set the SSR parameters. */
-    BTM_SetSsrParams(peer_addr, p_spec->max_lat, p_spec->min_rmt_to,
+    BTM_SetSsrParams(peer_addr, max_lat, p_spec->min_rmt_to,
                      p_spec->min_loc_to);
   }
 }
@@ -974,6 +1045,7 @@ void bta_dm_pm_btm_status(const RawAddress& bd_addr, tBTM_PM_STATUS status,
           bta_dm_pm_set_mode(bd_addr, BTA_DM_PM_NO_ACTION, BTA_DM_PM_RESTART);
         }
       } else {
+        p_dev->pm_policy.OnActive(bluetooth::common::time_get_os_boottime_ms());
         if (p_dev->prev_low) {
           /* need to send the SSR paramaters to controller again */
           bta_dm_pm_ssr(p_dev->peer_bdaddr, BTA_DM_PM_SSR0);
@@ -1010,6 +1082,7 @@ void bta_dm_pm_btm_status(const RawAddress& bd_addr, tBTM_PM_STATUS status,
       break;
     case BTM_PM_STS_SNIFF:
       if (hci_status == 0) {
+        p_dev->pm_policy.OnSniff(bluetooth::common::time_get_os_boottime_ms());
         /* Stop PM timer now if already active for
          * particular device since link is already
          * put in sniff mode by remote device, and
@@ -1160,3 +1233,44 @@ tBTA_DM_CONTRL_STATE bta_dm_pm_obtain_controller_state(void) {
   APPL_TRACE_DEBUG("bta_dm_pm_obtain_controller_state: %d", cur_state);
   return cur_state;
 }
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_dump_statistics
+ *
+ * Description      Dump the traffic of the connected BR/EDR links, and the
+ *                  power mode decisions taken from it
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_dm_pm_dump_statistics(int fd) {
+  dprintf(fd, "\nBTA DM power mode policy: %s\n",
+          bta_dm_pm_traffic_policy ? "enabled" : "disabled");
+  for (int i = 0; i < bta_dm_cb.device_list.count; i++) {
+    const tBTA_DM_PEER_DEVICE& device = bta_dm_cb.device_list.peer_device[i];
+    tBTM_ACL_TRAFFIC traffic;
+    if (device.conn_state != BTA_DM_CONNECTED ||
+        device.transport != BT_TRANSPORT_BR_EDR ||
+        !BTM_ReadAclTraffic(device.peer_bdaddr, &traffic)) {
+      continue;
+    }
+
+    const PmTrafficPolicy& policy = device.pm_policy;
+    dprintf(fd, "  peer: %s\n", device.peer_bdaddr.ToString().c_str());
+    dprintf(fd, "    ACL packets tx/rx: %u / %u\n", traffic.tx_packets,
+            traffic.rx_packets);
+    dprintf(fd, "    Idle gaps (ms):");
+    for (size_t j = 0; j < BTM_ACL_GAP_BUCKETS; j++) {
+      dprintf(fd, " %u+:%u", BTM_ACL_BURST_GAP_MS << j, traffic.gaps[j]);
+    }
+    dprintf(fd, "\n");
+    dprintf(fd, "    Sniff mode advanced/deferred: %u / %u\n",
+            policy.advanced(), policy.deferred());
+    uint32_t scored = policy.hits() + policy.misses();
+    dprintf(fd, "    Sniff mode hits/misses: %u / %u (hit rate %u%%)\n",
+            policy.hits(), policy.misses(),
+            scored == 0 ? 0 : policy.hits() * 100 / scored);
+    dprintf(fd, "    Last sniff max interval: %hu\n", policy.last_interval());
+  }
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "bta/dm/bta_dm_pm_policy.h"
+
+#include <algorithm>
+
+namespace {
+
+/* Links idle for this long are given the longest sniff parameters */
+constexpr uint64_t kLongIdleMs = 6400;
+/* Links with bursts this close are given the shortest sniff interval */
+constexpr uint64_t kShortGapMs = 800;
+
+uint32_t total_gaps(const tBTM_ACL_TRAFFIC& traffic) {
+  uint32_t total = 0;
+  for (size_t i = 0; i < BTM_ACL_GAP_BUCKETS; i++) total += traffic.gaps[i];
+  return total;
+}
+
+/* Bucket of the |percent| percentile of the gaps, there must be some */
+size_t percentile_bucket(const tBTM_ACL_TRAFFIC& traffic, uint32_t percent) {
+  uint32_t rank = (total_gaps(traffic) * percent + 99) / 100;
+  uint32_t count = 0;
+  for (size_t i = 0; i < BTM_ACL_GAP_BUCKETS; i++) {
+    count += traffic.gaps[i];
+    if (count >= rank && count != 0) return i;
+  }
+  return BTM_ACL_GAP_BUCKETS - 1;
+}
+
+}  // namespace
+
+void PmTrafficPolicy::Reset() {
+  sniff_since_ms_ = 0;
+  advanced_ = 0;
+  deferred_ = 0;
+  hits_ = 0;
+  misses_ = 0;
+  last_interval_ = 0;
+  deferrals_ = 0;
+}
+
+uint64_t PmTrafficPolicy::GapLowerMs(const tBTM_ACL_TRAFFIC& traffic,
+                                     uint32_t percent) {
+  return uint64_t{BTM_ACL_BURST_GAP_MS} << percentile_bucket(traffic, percent);
+}
+
+uint64_t PmTrafficPolicy::GapUpperMs(const tBTM_ACL_TRAFFIC& traffic,
+                                     uint32_t percent) {
+  size_t bucket = percentile_bucket(traffic, percent);
+  if (bucket == BTM_ACL_GAP_BUCKETS - 1) return UINT64_MAX;
+  return uint64_t{BTM_ACL_BURST_GAP_MS} << (bucket + 1);
+}
+
+bool PmTrafficPolicy::IsLearned(const tBTM_ACL_TRAFFIC& traffic,
+                                PmTrafficClass cls) {
+  return cls != PmTrafficClass::kAudio && total_gaps(traffic) >= kMinGaps;
+}
+
+bool PmTrafficPolicy::IsIdle(const tBTM_ACL_TRAFFIC& traffic) {
+  return GapLowerMs(traffic, 25) >= kLongIdleMs;
+}
+
+uint64_t PmTrafficPolicy::SniffDelayMs(const tBTM_ACL_TRAFFIC& traffic,
+                                       PmTrafficClass cls, uint64_t table_ms) {
+  deferrals_ = 0;
+  if (!IsLearned(traffic, cls)) return table_ms;
+
+  /* Even the short gaps are much longer than the timeout, or long enough */
+  if (IsIdle(traffic) || GapLowerMs(traffic, 25) >= 4 * table_ms) {
+    uint64_t delay_ms = std::max(table_ms / 2, kMinSniffDelayMs);
+    if (delay_ms < table_ms) {
+      advanced_++;
+      return delay_ms;
+    }
+  }
+  return table_ms;
+}
+
+uint64_t PmTrafficPolicy::SniffDeferMs(const tBTM_ACL_TRAFFIC& traffic,
+                                       PmTrafficClass cls, uint64_t now_ms) {
+  if (!IsLearned(traffic, cls) || deferrals_ >= kMaxDeferrals) {
+    deferrals_ = 0;
+    return 0;
+  }
+
+  /* Most bursts come back within |idle_ms| */
+  uint64_t idle_ms = GapUpperMs(traffic, 90);
+  uint64_t since_ms = now_ms - traffic.last_packet_ms;
+  if (idle_ms > kMaxIdleBeforeSniffMs || traffic.last_packet_ms == 0 ||
+      since_ms >= idle_ms) {
+    deferrals_ = 0;
+    return 0;
+  }
+  deferrals_++;
+  deferred_++;
+  return idle_ms - since_ms;
+}
+
+void PmTrafficPolicy::AdjustSniff(const tBTM_ACL_TRAFFIC& traffic,
+                                  PmTrafficClass cls, tBTM_PM_PWR_MD* p_mode) {
+  if (cls == PmTrafficClass::kData && IsLearned(traffic, cls)) {
+    if (IsIdle(traffic)) {
+      p_mode->min = p_mode->max;
+    } else if (GapUpperMs(traffic, 75) <= kShortGapMs) {
+      p_mode->max = p_mode->min;
+    }
+  }
+  last_interval_ = p_mode->max;
+}
+
+uint16_t PmTrafficPolicy::SsrMaxLatency(const tBTM_ACL_TRAFFIC& traffic,
+                                        PmTrafficClass cls,
+                                        uint16_t table_lat) const {
+  if (table_lat == 0 || cls != PmTrafficClass::kData ||
+      !IsLearned(traffic, cls) || !IsIdle(traffic)) {
+    return table_lat;
+  }
+  /* 0xFFFF is not a valid latency */
+  return static_cast<uint16_t>(std::min(2 * uint32_t{table_lat}, 0xFFFEu));
+}
+
+void PmTrafficPolicy::OnSniff(uint64_t now_ms) {
+  if (sniff_since_ms_ == 0) sniff_since_ms_ = now_ms;
+}
+
+void PmTrafficPolicy::OnActive(uint64_t now_ms) {
+  if (sniff_since_ms_ == 0) return;
+  if (now_ms - sniff_since_ms_ < kEarlyWakeMs) {
+    misses_++;
+  } else {
+    hits_++;
+  }
+  sniff_since_ms_ = 0;
+}
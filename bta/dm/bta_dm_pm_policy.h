@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Power mode policy of a link, adapting the power mode tables to the ACL
+ *  traffic of the link.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+#include "stack/include/acl_api_types.h"
+#include "stack/include/btm_api_types.h"
+
+/* Traffic expected on a link, from the services connected on it */
+enum class PmTrafficClass : uint8_t {
+  kData,
+  /* Input devices, which need a short sniff interval */
+  kHid,
+  /* Streaming or calls, left to the tables */
+  kAudio,
+};
+
+/* Decides when a link enters sniff mode and with which parameters, from the
+ * idle gaps between the bursts of its ACL traffic:
+ *  - if the bursts usually come back shortly after the sniff timeout of the
+ *    tables, entering sniff is deferred until the link was idle for longer
+ *    than that, not to enter it right before a burst.
+ *  - if the link stays idle for long, sniff is entered sooner, with the
+ *    longest interval of the tables and a longer subrating latency.
+ *  - if the bursts are frequent, the shortest interval of the tables is used.
+ * Each sniff mode is scored when it is left: a hit if it lasted, a miss if it
+ * was left within kEarlyWakeMs.
+ *
+ * It is kept in tBTA_DM_PEER_DEVICE, and cleared with it: it has no
+ * constructor, call Reset() when the link comes up.
+ */
+class PmTrafficPolicy {
+ public:
+  /* Gaps counted before the traffic is trusted over the tables */
+  static constexpr uint32_t kMinGaps = 8;
+  /* Sniff mode left within this time was entered right before a burst */
+  static constexpr uint64_t kEarlyWakeMs = 1000;
+  /* Earliest sniff mode entered on idle links */
+  static constexpr uint64_t kMinSniffDelayMs = 500;
+  /* Gaps past this are not waited for before entering sniff */
+  static constexpr uint64_t kMaxIdleBeforeSniffMs = 3200;
+  /* Deferrals in a row before entering sniff as the tables say */
+  static constexpr uint8_t kMaxDeferrals = 4;
+
+  void Reset();
+
+  /* Returns the time to wait before entering sniff, in place of |table_ms|
+   * from the power mode tables */
+  uint64_t SniffDelayMs(const tBTM_ACL_TRAFFIC& traffic, PmTrafficClass cls,
+                        uint64_t table_ms);
+
+  /* Called once the time to enter sniff has come. Returns how much longer to
+   * wait, or 0 to enter sniff now */
+  uint64_t SniffDeferMs(const tBTM_ACL_TRAFFIC& traffic, PmTrafficClass cls,
+                        uint64_t now_ms);
+
+  /* Narrows the interval range of the sniff parameters |p_mode| */
+  void AdjustSniff(const tBTM_ACL_TRAFFIC& traffic, PmTrafficClass cls,
+                   tBTM_PM_PWR_MD* p_mode);
+
+  /* Returns the sniff subrating maximum latency in place of |table_lat| */
+  uint16_t SsrMaxLatency(const tBTM_ACL_TRAFFIC& traffic, PmTrafficClass cls,
+                         uint16_t table_lat) const;
+
+  /* The link entered sniff mode, or went back to active mode */
+  void OnSniff(uint64_t now_ms);
+  void OnActive(uint64_t now_ms);
+
+  uint32_t advanced() const { return advanced_; }
+  uint32_t deferred() const { return deferred_; }
+  uint32_t hits() const { return hits_; }
+  uint32_t misses() const { return misses_; }
+  uint16_t last_interval() const { return last_interval_; }
+
+  /* Lower and upper bound of the |percent| percentile of the idle gaps, in
+   * ms. The upper bound of the last bucket is UINT64_MAX */
+  static uint64_t GapLowerMs(const tBTM_ACL_TRAFFIC& traffic, uint32_t percent);
+  static uint64_t GapUpperMs(const tBTM_ACL_TRAFFIC& traffic, uint32_t percent);
+
+ private:
+  static bool IsLearned(const tBTM_ACL_TRAFFIC& traffic, PmTrafficClass cls);
+  static bool IsIdle(const tBTM_ACL_TRAFFIC& traffic);
+
+  /* Boot time the link entered sniff mode at, 0 if active */
+  uint64_t sniff_since_ms_;
+  uint32_t advanced_;
+  uint32_t deferred_;
+  uint32_t hits_;
+  uint32_t misses_;
+  uint16_t last_interval_;
+  uint8_t deferrals_;
+};
@@ -28,12 +28,13 @@
 #include <base/bind.h>
 #include <base/strings/stringprintf.h>
 
+#include <algorithm>
+
 #include "bt_target.h"  // Must be first to define build configuration
 
 #include "bta/gatt/bta_gattc_int.h"
 #include "bta/hh/bta_hh_int.h"
 #include "btif/include/btif_debug_conn.h"
-#include "device/include/controller.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"  // UNUSED_ATTR
 #include "stack/include/btm_ble_api_types.h"
@@ -61,6 +62,9 @@ static void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
                                    tGATT_CL_COMPLETE* p_data);
 
 static void bta_gattc_deregister_cmpl(tBTA_GATTC_RCB* p_clreg);
+static void bta_gattc_write_stream_yield(tBTA_GATTC_CLCB* p_clcb);
+static bool bta_gattc_write_stream_seg_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                            tGATT_STATUS status);
 static void bta_gattc_enc_cmpl_cback(tGATT_IF gattc_if, const RawAddress& bda);
 static void bta_gattc_cong_cback(uint16_t conn_id, bool congested);
 static void bta_gattc_phy_update_cback(tGATT_IF gatt_if, uint16_t conn_id,
@@ -208,13 +212,8 @@ void bta_gattc_deregister(tBTA_GATTC_RCB* p_clreg) {
     return;
   }
 
-  uint8_t accept_list_size = 0;
-  if (controller_get_interface()->supports_ble()) {
-    accept_list_size = controller_get_interface()->get_ble_acceptlist_size();
-  }
-
   /* remove bg connection associated with this rcb */
-  for (uint8_t i = 0; i < accept_list_size; i++) {
+  for (uint8_t i = 0; i < BTA_GATTC_KNOWN_SR_MAX; i++) {
     if (!bta_gattc_cb.bg_track[i].in_use) continue;
 
     if (bta_gattc_cb.bg_track[i].cif_mask & (1 << (p_clreg->client_if - 1))) {
@@ -490,6 +489,10 @@ void bta_gattc_conn(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
         bta_gattc_reset_discover_st(p_clcb->p_srcb, GATT_SUCCESS);
       } else {
         p_clcb->p_srcb->state = BTA_GATTC_SERV_DISC;
+        /* read db hash first, another device may have the same database */
+        if (bta_gattc_is_robust_caching_enabled()) {
+          p_clcb->p_srcb->srvc_hdl_db_hash = true;
+        }
         /* cache load failure, start discovery */
         bta_gattc_start_discover(p_clcb, NULL);
       }
@@ -660,9 +663,23 @@ void bta_gattc_start_discover_internal(tBTA_GATTC_CLCB* p_clcb) {
   if (p_clcb->transport == BT_TRANSPORT_LE)
     L2CA_EnableUpdateBleConnParams(p_clcb->p_srcb->server_bda, false);
 
-  bta_gattc_init_cache(p_clcb->p_srcb);
-  p_clcb->status = bta_gattc_discover_pri_service(
-      p_clcb->bta_conn_id, p_clcb->p_srcb, GATT_DISC_SRVC_ALL);
+  /* after a service change indication, rediscover only the changed services */
+  tBTA_GATTC_SERV* p_srcb = p_clcb->p_srcb;
+  uint16_t s_handle = p_srcb->srvc_chg_range.first;
+  uint16_t e_handle = p_srcb->srvc_chg_range.second;
+  p_srcb->srvc_chg_range = {0, 0};
+
+  if (p_clcb->transport == BT_TRANSPORT_LE && GATT_HANDLE_IS_VALID(s_handle) &&
+      bta_gattc_init_partial_cache(p_srcb, &s_handle, &e_handle)) {
+    LOG(INFO) << __func__ << ": rediscover services in range "
+              << loghex(s_handle) << "-" << loghex(e_handle);
+    p_clcb->status = GATTC_Discover(p_clcb->bta_conn_id, GATT_DISC_SRVC_ALL,
+                                    s_handle, e_handle);
+  } else {
+    bta_gattc_init_cache(p_srcb);
+    p_clcb->status = bta_gattc_discover_pri_service(
+        p_clcb->bta_conn_id, p_srcb, GATT_DISC_SRVC_ALL);
+  }
   if (p_clcb->status != GATT_SUCCESS) {
     LOG(ERROR) << "discovery on server failed";
     bta_gattc_reset_discover_st(p_clcb->p_srcb, p_clcb->status);
@@ -810,6 +827,7 @@ void bta_gattc_read_multi(tBTA_GATTC_CLCB* p_clcb,
 
   read_param.read_multiple.num_handles = p_data->api_read_multi.num_attr;
   read_param.read_multiple.auth_req = p_data->api_read_multi.auth_req;
+  read_param.read_multiple.variable_len = p_data->api_read_multi.variable_len;
   memcpy(&read_param.read_multiple.handles, p_data->api_read_multi.handles,
          sizeof(uint16_t) * p_data->api_read_multi.num_attr);
 
@@ -854,6 +872,183 @@ void bta_gattc_write(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
   }
 }
 
+/** Write a stream of data with Write Commands. The stream stays in p_q_cmd
+ * until all of it was handed to L2CAP; segments are sent from the main thread
+ * so that the queued buffer is never released by the BTA dispatcher. */
+void bta_gattc_write_stream(tBTA_GATTC_CLCB* p_clcb,
+                            const tBTA_GATTC_DATA* p_data) {
+  if (!bta_gattc_enqueue(p_clcb, p_data)) {
+    const tBTA_GATTC_API_WRITE_STREAM& stream = p_data->api_write_stream;
+    if (stream.stream_cb) {
+      stream.stream_cb(p_clcb->bta_conn_id, GATT_BUSY, stream.handle,
+                       stream.offset, stream.len, stream.stream_cb_data);
+    }
+    return;
+  }
+
+  bta_gattc_write_stream_yield(p_clcb);
+}
+
+/** report the progress of the stream in p_q_cmd, unless it is over */
+static void bta_gattc_write_stream_progress(tBTA_GATTC_CLCB* p_clcb) {
+  const tBTA_GATTC_API_WRITE_STREAM& stream =
+      p_clcb->p_q_cmd->api_write_stream;
+
+  if (stream.stream_cb && stream.offset < stream.len) {
+    stream.stream_cb(p_clcb->bta_conn_id, GATT_SUCCESS, stream.handle,
+                     stream.offset, stream.len, stream.stream_cb_data);
+  }
+}
+
+/** write stream complete */
+static void bta_gattc_write_stream_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                        tGATT_STATUS status) {
+  const tBTA_GATTC_API_WRITE_STREAM& stream =
+      p_clcb->p_q_cmd->api_write_stream;
+  GATT_WRITE_STREAM_OP_CB cb = stream.stream_cb;
+  void* my_cb_data = stream.stream_cb_data;
+  uint16_t handle = stream.handle;
+  uint32_t sent = stream.offset;
+  uint32_t total = stream.len;
+
+  osi_free_and_reset((void**)&p_clcb->p_q_cmd);
+  p_clcb->stream_state = BTA_GATTC_STREAM_IDLE;
+
+  if (cb) {
+    cb(p_clcb->bta_conn_id, status, handle, sent, total, my_cb_data);
+  }
+
+  if (p_clcb->auto_update == BTA_GATTC_DISC_WAITING) {
+    p_clcb->auto_update = BTA_GATTC_REQ_WAITING;
+
+    /* request read db hash first */
+    if (bta_gattc_is_robust_caching_enabled()) {
+      p_clcb->p_srcb->srvc_hdl_db_hash = true;
+    }
+
+    bta_gattc_sm_execute(p_clcb, BTA_GATTC_INT_DISCOVER_EVT, NULL);
+  }
+}
+
+/** account the segment of the stream that just completed, returns true if
+ * the next one can be sent right away */
+static bool bta_gattc_write_stream_seg_done(tBTA_GATTC_CLCB* p_clcb) {
+  tBTA_GATTC_API_WRITE_STREAM* p_stream =
+      (tBTA_GATTC_API_WRITE_STREAM*)p_clcb->p_q_cmd;
+  tGATT_STATUS status = p_clcb->stream_status;
+
+  if (status != GATT_SUCCESS && status != GATT_CONGESTED) {
+    bta_gattc_write_stream_cmpl(p_clcb, status);
+    return false;
+  }
+
+  /* a congested link still took the segment */
+  p_stream->offset += p_clcb->stream_seg_len;
+  if (p_stream->offset == p_stream->len) {
+    bta_gattc_write_stream_cmpl(p_clcb, GATT_SUCCESS);
+    return false;
+  }
+
+  if (status == GATT_CONGESTED) {
+    /* bta_gattc_cong_cback resumes once L2CAP drained its queue */
+    p_clcb->stream_state = BTA_GATTC_STREAM_W4_UNCONGEST;
+    bta_gattc_write_stream_progress(p_clcb);
+    return false;
+  }
+  return true;
+}
+
+/** send segments of the stream in p_q_cmd until the link is congested or a
+ * burst was sent, then yield to the main thread */
+static void bta_gattc_write_stream_pump(tBTA_GATTC_CLCB* p_clcb) {
+  /* discovery executes p_q_cmd again once it completes */
+  if (p_clcb->state == BTA_GATTC_DISCOVER_ST) {
+    p_clcb->stream_state = BTA_GATTC_STREAM_W4_RESUME;
+    return;
+  }
+
+  const tBTA_GATTC_API_WRITE_STREAM& stream =
+      p_clcb->p_q_cmd->api_write_stream;
+  uint16_t max_len = GATTC_GetWriteCmdMaxLen(p_clcb->bta_conn_id);
+  if (max_len == 0) {
+    bta_gattc_write_stream_cmpl(p_clcb, GATT_ERROR);
+    return;
+  }
+
+  for (int i = 0; i < BTA_GATTC_STREAM_BURST_MAX; i++) {
+    if (stream.offset == stream.len) {
+      bta_gattc_write_stream_cmpl(p_clcb, GATT_SUCCESS);
+      return;
+    }
+
+    tGATT_VALUE attr;
+    attr.conn_id = p_clcb->bta_conn_id;
+    attr.handle = stream.handle;
+    attr.offset = 0;
+    attr.len = std::min<uint32_t>(max_len, stream.len - stream.offset);
+    attr.auth_req = stream.auth_req;
+    memcpy(attr.value, stream.p_value + stream.offset, attr.len);
+
+    p_clcb->stream_seg_len = attr.len;
+    p_clcb->stream_state = BTA_GATTC_STREAM_SENDING;
+    tGATT_STATUS status =
+        GATTC_Write(p_clcb->bta_conn_id, GATT_WRITE_NO_RSP, &attr);
+    if (status != GATT_SUCCESS) {
+      bta_gattc_write_stream_cmpl(p_clcb, status);
+      return;
+    }
+
+    /* waits for the link security, bta_gattc_cmpl_cback goes on */
+    if (p_clcb->stream_state == BTA_GATTC_STREAM_SENDING) {
+      p_clcb->stream_state = BTA_GATTC_STREAM_W4_CMPL;
+      return;
+    }
+
+    if (!bta_gattc_write_stream_seg_done(p_clcb)) return;
+  }
+
+  bta_gattc_write_stream_progress(p_clcb);
+  bta_gattc_write_stream_yield(p_clcb);
+}
+
+static void bta_gattc_write_stream_resume(uint16_t conn_id) {
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (!p_clcb || p_clcb->stream_state != BTA_GATTC_STREAM_W4_RESUME) return;
+
+  /* the stream may be gone with the connection or a failed discovery */
+  if (!p_clcb->p_q_cmd ||
+      p_clcb->p_q_cmd->hdr.event != BTA_GATTC_API_WRITE_STREAM_EVT)
+    return;
+
+  bta_gattc_write_stream_pump(p_clcb);
+}
+
+static void bta_gattc_write_stream_yield(tBTA_GATTC_CLCB* p_clcb) {
+  p_clcb->stream_state = BTA_GATTC_STREAM_W4_RESUME;
+  do_in_main_thread(FROM_HERE, base::Bind(&bta_gattc_write_stream_resume,
+                                          p_clcb->bta_conn_id));
+}
+
+/** Write Command of a stream complete, returns true if it was one. Segments
+ * sent within GATTC_Write are accounted by bta_gattc_write_stream_pump, so
+ * that they do not cost a message each. */
+static bool bta_gattc_write_stream_seg_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                            tGATT_STATUS status) {
+  if (p_clcb->stream_state == BTA_GATTC_STREAM_SENDING) {
+    p_clcb->stream_status = status;
+    p_clcb->stream_state = BTA_GATTC_STREAM_SENT;
+    return true;
+  }
+
+  if (p_clcb->stream_state == BTA_GATTC_STREAM_W4_CMPL) {
+    p_clcb->stream_status = status;
+    if (bta_gattc_write_stream_seg_done(p_clcb))
+      bta_gattc_write_stream_yield(p_clcb);
+    return true;
+  }
+  return false;
+}
+
 /** send execute write */
 void bta_gattc_execute(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
   if (!bta_gattc_enqueue(p_clcb, p_data)) return;
@@ -885,9 +1080,34 @@ void bta_gattc_confirm(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
   }
 }
 
+/** read multiple complete */
+static void bta_gattc_read_multi_cmpl(tBTA_GATTC_CLCB* p_clcb,
+                                      const tBTA_GATTC_OP_CMPL* p_data) {
+  GATT_READ_MULTI_OP_CB cb = p_clcb->p_q_cmd->api_read_multi.read_cb;
+  void* my_cb_data = p_clcb->p_q_cmd->api_read_multi.read_cb_data;
+
+  tBTA_GATTC_MULTI handles;
+  handles.num_attr = p_clcb->p_q_cmd->api_read_multi.num_attr;
+  memcpy(handles.handles, p_clcb->p_q_cmd->api_read_multi.handles,
+         sizeof(uint16_t) * handles.num_attr);
+
+  osi_free_and_reset((void**)&p_clcb->p_q_cmd);
+
+  if (cb) {
+    uint16_t len = p_data->p_cmpl ? p_data->p_cmpl->att_value.len : 0;
+    uint8_t* value = p_data->p_cmpl ? p_data->p_cmpl->att_value.value : NULL;
+    cb(p_clcb->bta_conn_id, p_data->status, handles, len, value, my_cb_data);
+  }
+}
+
 /** read complete */
 static void bta_gattc_read_cmpl(tBTA_GATTC_CLCB* p_clcb,
                                 const tBTA_GATTC_OP_CMPL* p_data) {
+  if (p_clcb->p_q_cmd->hdr.event == BTA_GATTC_API_READ_MULTI_EVT) {
+    bta_gattc_read_multi_cmpl(p_clcb, p_data);
+    return;
+  }
+
   GATT_READ_OP_CB cb = p_clcb->p_q_cmd->api_read.read_cb;
   void* my_cb_data = p_clcb->p_q_cmd->api_read.read_cb_data;
 
@@ -923,6 +1143,8 @@ static void bta_gattc_write_cmpl(tBTA_GATTC_CLCB* p_clcb,
 /** execute write complete */
 static void bta_gattc_exec_cmpl(tBTA_GATTC_CLCB* p_clcb,
                                 const tBTA_GATTC_OP_CMPL* p_data) {
+  GATT_EXECUTE_WRITE_OP_CB cb = p_clcb->p_q_cmd->api_exec.exec_cb;
+  void* my_cb_data = p_clcb->p_q_cmd->api_exec.exec_cb_data;
   tBTA_GATTC cb_data;
 
   osi_free_and_reset((void**)&p_clcb->p_q_cmd);
@@ -932,6 +1154,10 @@ static void bta_gattc_exec_cmpl(tBTA_GATTC_CLCB* p_clcb,
   cb_data.exec_cmpl.conn_id = p_clcb->bta_conn_id;
   cb_data.exec_cmpl.status = p_data->status;
 
+  if (cb) {
+    cb(p_clcb->bta_conn_id, p_data->status, my_cb_data);
+  }
+
   (*p_clcb->p_rcb->p_cback)(BTA_GATTC_EXEC_EVT, &cb_data);
 }
 
@@ -1027,6 +1253,8 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, const tBTA_GATTC_DATA* p_data) {
       p_data->op_cmpl.status == GATT_DATABASE_OUT_OF_SYNC) {
     LOG(INFO) << __func__ << ": DATABASE_OUT_OF_SYNC, re-discover service";
     p_clcb->auto_update = BTA_GATTC_REQ_WAITING;
+    /* the changed handles are unknown, rediscover all services */
+    p_clcb->p_srcb->srvc_chg_range = {0, 0};
     /* request read db hash first */
     p_clcb->p_srcb->srvc_hdl_db_hash = true;
     bta_gattc_sm_execute(p_clcb, BTA_GATTC_INT_DISCOVER_EVT, NULL);
@@ -1156,6 +1384,8 @@ static void bta_gattc_enc_cmpl_cback(tGATT_IF gattc_if, const RawAddress& bda) {
 void bta_gattc_process_api_refresh(const RawAddress& remote_bda) {
   tBTA_GATTC_SERV* p_srvc_cb = bta_gattc_find_srvr_cache(remote_bda);
   if (p_srvc_cb) {
+    p_srvc_cb->srvc_chg_range = {0, 0};
+
     /* try to find a CLCB */
     if (p_srvc_cb->connected && p_srvc_cb->num_clcb != 0) {
       bool found = false;
@@ -1216,8 +1446,18 @@ bool bta_gattc_process_srvc_chg_ind(uint16_t conn_id, tBTA_GATTC_RCB* p_clrcb,
   LOG(ERROR) << __func__ << ": service changed s_handle=" << loghex(s_handle)
              << ", e_handle=" << loghex(e_handle);
 
-  /* mark service handle change pending */
+  /* mark service handle change pending, merging the handle range with the
+   * one of the indications not handled yet */
   p_srcb->srvc_hdl_chg = true;
+  std::pair<uint16_t, uint16_t> range = {s_handle, e_handle};
+  if (!GATT_HANDLE_IS_VALID(s_handle) || s_handle > e_handle) {
+    range = {0x0001, 0xFFFF};
+  }
+  if (GATT_HANDLE_IS_VALID(p_srcb->srvc_chg_range.first)) {
+    range.first = std::min(range.first, p_srcb->srvc_chg_range.first);
+    range.second = std::max(range.second, p_srcb->srvc_chg_range.second);
+  }
+  p_srcb->srvc_chg_range = range;
   /* clear up all notification/indication registration */
   bta_gattc_clear_notif_registration(p_srcb, conn_id, s_handle, e_handle);
   /* service change indication all received, do discovery update */
@@ -1268,17 +1508,20 @@ void bta_gattc_proc_other_indication(tBTA_GATTC_CLCB* p_clcb, uint8_t op,
                  p_data->att_value.handle, p_data->handle);
   VLOG(1) << "is_notify " << p_notify->is_notify;
 
-  p_notify->is_notify = (op == GATTC_OPTYPE_INDICATION) ? false : true;
-  p_notify->len = p_data->att_value.len;
-  p_notify->bda = p_clcb->bda;
-  memcpy(p_notify->value, p_data->att_value.value, p_data->att_value.len);
-  p_notify->conn_id = p_clcb->bta_conn_id;
+  if (!p_clcb->p_rcb->p_cback) return;
 
-  if (p_clcb->p_rcb->p_cback) {
-    tBTA_GATTC bta_gattc;
-    bta_gattc.notify = *p_notify;
-    (*p_clcb->p_rcb->p_cback)(BTA_GATTC_NOTIF_EVT, &bta_gattc);
-  }
+  // Build the event in place, and copy only the received octets of the value.
+  tBTA_GATTC bta_gattc;
+  tBTA_GATTC_NOTIFY& notify = bta_gattc.notify;
+  notify.conn_id = p_clcb->bta_conn_id;
+  notify.bda = p_clcb->bda;
+  notify.handle = p_notify->handle;
+  notify.len = p_data->att_value.len;
+  memcpy(notify.value, p_data->att_value.value, p_data->att_value.len);
+  notify.is_notify = (op == GATTC_OPTYPE_INDICATION) ? false : true;
+  notify.cid = p_notify->cid;
+
+  (*p_clcb->p_rcb->p_cback)(BTA_GATTC_NOTIF_EVT, &bta_gattc);
 }
 
 /** process indication/notification */
@@ -1376,6 +1619,10 @@ static void bta_gattc_cmpl_cback(uint16_t conn_id, tGATTC_OPTYPE op,
     bta_sys_idle(BTA_ID_GATTC, BTA_ALL_APP_ID, p_clcb->bda);
   }
 
+  if (op == GATTC_OPTYPE_WRITE &&
+      bta_gattc_write_stream_seg_cmpl(p_clcb, status))
+    return;
+
   bta_gattc_cmpl_sendmsg(conn_id, op, status, p_data);
 }
 
@@ -1402,7 +1649,12 @@ static void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
 /** congestion callback for BTA GATT client */
 static void bta_gattc_cong_cback(uint16_t conn_id, bool congested) {
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
-  if (!p_clcb || !p_clcb->p_rcb->p_cback) return;
+  if (!p_clcb) return;
+
+  if (!congested && p_clcb->stream_state == BTA_GATTC_STREAM_W4_UNCONGEST)
+    bta_gattc_write_stream_yield(p_clcb);
+
+  if (!p_clcb->p_rcb->p_cback) return;
 
   tBTA_GATTC cb_data;
   cb_data.congest.conn_id = conn_id;
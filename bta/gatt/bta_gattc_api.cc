@@ -24,7 +24,6 @@
 
 #include <base/bind.h>
 #include <ios>
-#include <list>
 #include <memory>
 #include <vector>
 
@@ -276,7 +275,7 @@ void BTA_GATTC_DiscoverServiceByUuid(uint16_t conn_id, const Uuid& srvc_uuid) {
  * Returns          returns list of gatt::Service or NULL.
  *
  ******************************************************************************/
-const std::list<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
+const std::vector<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
   return bta_gattc_get_services(conn_id);
 }
 
@@ -437,12 +436,20 @@ void BTA_GATTC_ReadCharDescr(uint16_t conn_id, uint16_t handle,
  *
  * Parameters       conn_id - connectino ID.
  *                    p_read_multi - pointer to the read multiple parameter.
+ *                    variable_len - use Read Multiple Variable Length.
+ *                    callback - called with the raw response.
  *
  * Returns          None
  *
  ******************************************************************************/
 void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
                             tGATT_AUTH_REQ auth_req) {
+  BTA_GATTC_ReadMultiple(conn_id, p_read_multi, false, auth_req, NULL, NULL);
+}
+
+void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
+                            bool variable_len, tGATT_AUTH_REQ auth_req,
+                            GATT_READ_MULTI_OP_CB callback, void* cb_data) {
   tBTA_GATTC_API_READ_MULTI* p_buf =
       (tBTA_GATTC_API_READ_MULTI*)osi_calloc(sizeof(tBTA_GATTC_API_READ_MULTI));
 
@@ -450,6 +457,9 @@ void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
   p_buf->hdr.layer_specific = conn_id;
   p_buf->auth_req = auth_req;
   p_buf->num_attr = p_read_multi->num_attr;
+  p_buf->variable_len = variable_len;
+  p_buf->read_cb = callback;
+  p_buf->read_cb_data = cb_data;
 
   if (p_buf->num_attr > 0)
     memcpy(p_buf->handles, p_read_multi->handles,
@@ -497,6 +507,45 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
   bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharStream
+ *
+ * Description      This function is called to write a stream of data to a
+ *                  characteristic with Write Commands. The whole stream is
+ *                  handed to BTA in one message and segmented there.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  handle - characteristic handle to write.
+ *                  value - the data to be written.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTC_WriteCharStream(uint16_t conn_id, uint16_t handle,
+                               std::vector<uint8_t> value,
+                               tGATT_AUTH_REQ auth_req,
+                               GATT_WRITE_STREAM_OP_CB callback,
+                               void* cb_data) {
+  tBTA_GATTC_API_WRITE_STREAM* p_buf = (tBTA_GATTC_API_WRITE_STREAM*)osi_calloc(
+      sizeof(tBTA_GATTC_API_WRITE_STREAM) + value.size());
+
+  p_buf->hdr.event = BTA_GATTC_API_WRITE_STREAM_EVT;
+  p_buf->hdr.layer_specific = conn_id;
+  p_buf->auth_req = auth_req;
+  p_buf->handle = handle;
+  p_buf->len = value.size();
+  p_buf->stream_cb = callback;
+  p_buf->stream_cb_data = cb_data;
+
+  if (value.size() > 0) {
+    p_buf->p_value = (uint8_t*)(p_buf + 1);
+    memcpy(p_buf->p_value, value.data(), value.size());
+  }
+
+  bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_WriteCharDescr
@@ -588,12 +637,19 @@ void BTA_GATTC_PrepareWrite(uint16_t conn_id, uint16_t handle, uint16_t offset,
  *
  ******************************************************************************/
 void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute) {
+  BTA_GATTC_ExecuteWrite(conn_id, is_execute, NULL, NULL);
+}
+
+void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute,
+                            GATT_EXECUTE_WRITE_OP_CB callback, void* cb_data) {
   tBTA_GATTC_API_EXEC* p_buf =
       (tBTA_GATTC_API_EXEC*)osi_calloc(sizeof(tBTA_GATTC_API_EXEC));
 
   p_buf->hdr.event = BTA_GATTC_API_EXEC_EVT;
   p_buf->hdr.layer_specific = conn_id;
   p_buf->is_execute = is_execute;
+  p_buf->exec_cb = callback;
+  p_buf->exec_cb_data = cb_data;
 
   bta_sys_sendmsg(p_buf);
 }
@@ -34,6 +34,7 @@
 
 #include "bta/gatt/bta_gattc_int.h"
 #include "bta/gatt/database.h"
+#include "bta/gatt/database_file.h"
 #include "osi/include/log.h"
 #include "stack/btm/btm_sec.h"
 #include "stack/include/gatt_api.h"
@@ -44,13 +45,17 @@ using bluetooth::Uuid;
 using gatt::Characteristic;
 using gatt::Database;
 using gatt::DatabaseBuilder;
+using gatt::DatabaseFile;
 using gatt::Descriptor;
 using gatt::IncludedService;
 using gatt::Service;
-using gatt::StoredAttribute;
 
 static void bta_gattc_cache_write(const RawAddress& server_bda,
-                                  const std::vector<StoredAttribute>& attr);
+                                  const Database& database);
+static void bta_gattc_hash_cache_write(const Database& database);
+static bool bta_gattc_hash_cache_load(tBTA_GATTC_SERV* p_srcb,
+                                      const Octet16& hash);
+static bool bta_gattc_cache_load_file(const char* fname, Database* database);
 static tGATT_STATUS bta_gattc_sdp_service_disc(uint16_t conn_id,
                                                tBTA_GATTC_SERV* p_server_cb);
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
@@ -72,7 +77,10 @@ static void bta_gattc_read_ext_prop_desc_cmpl(tBTA_GATTC_CLCB* p_clcb,
 #define BTA_GATT_SDP_DB_SIZE 4096
 
 #define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
-#define GATT_CACHE_VERSION 6
+
+/* Databases of servers exposing a Database Hash are also stored under the
+ * hash, so devices of the same model can share one discovery */
+#define GATT_HASH_CACHE_PREFIX "/data/misc/bluetooth/gatt_hash_"
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
                                                const RawAddress& bda) {
@@ -81,6 +89,15 @@ static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
            bda.address[4], bda.address[5]);
 }
 
+static void bta_gattc_generate_hash_file_name(char* buffer, size_t buffer_len,
+                                              const Octet16& hash) {
+  int len = snprintf(buffer, buffer_len, "%s", GATT_HASH_CACHE_PREFIX);
+  for (uint8_t octet : hash) {
+    if (len < 0 || (size_t)len >= buffer_len) return;
+    len += snprintf(buffer + len, buffer_len - len, "%02x", octet);
+  }
+}
+
 /*****************************************************************************
  *  Constants and data types
  ****************************************************************************/
@@ -118,16 +135,37 @@ static void bta_gattc_display_explore_record(const DatabaseBuilder& database) {
 void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->gatt_database = gatt::Database();
   p_srvc_cb->pending_discovery.Clear();
+  p_srvc_cb->dscp_disc_in_flight = 0;
+  p_srvc_cb->deferred_dscp_range = {0, 0};
 }
 
-const Service* bta_gattc_find_matching_service(
-    const std::list<Service>& services, uint16_t handle) {
-  for (const Service& service : services) {
-    if (handle >= service.handle && handle <= service.end_handle)
-      return &service;
+/** Initialize the discovery of the services in the |*p_s_handle|-|*p_e_handle|
+ * range only, keeping the rest of the database cache. The range is widened to
+ * the services it overlaps. Returns false if a full discovery is needed */
+bool bta_gattc_init_partial_cache(tBTA_GATTC_SERV* p_srvc_cb,
+                                  uint16_t* p_s_handle, uint16_t* p_e_handle) {
+  if (p_srvc_cb->gatt_database.IsEmpty()) return false;
+
+  if (!p_srvc_cb->pending_discovery.StartPartialDiscovery(
+          p_srvc_cb->gatt_database, p_s_handle, p_e_handle)) {
+    return false;
   }
 
-  return nullptr;
+  p_srvc_cb->gatt_database = gatt::Database();
+  p_srvc_cb->dscp_disc_in_flight = 0;
+  p_srvc_cb->deferred_dscp_range = {0, 0};
+  return true;
+}
+
+/** Return true if the database exposes the Database Hash characteristic */
+static bool bta_gattc_has_db_hash(const Database& database) {
+  Uuid db_hash_uuid = Uuid::From16Bit(GATT_UUID_DATABASE_HASH);
+  for (const Service& service : database.Services()) {
+    for (const Characteristic& characteristic : service.characteristics) {
+      if (characteristic.uuid == db_hash_uuid) return true;
+    }
+  }
+  return false;
 }
 
 /** Start primary service discovery */
@@ -226,9 +264,16 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
   /* save cache to NV */
   p_clcb->p_srcb->state = BTA_GATTC_SERV_SAVE;
 
+  /* the hash cache holds no per-device data, share it across devices whether
+   * bonded or not */
+  if (bta_gattc_is_robust_caching_enabled() &&
+      bta_gattc_has_db_hash(p_srvc_cb->gatt_database)) {
+    bta_gattc_hash_cache_write(p_srvc_cb->gatt_database);
+  }
+
   if (btm_sec_is_a_bonded_dev(p_srvc_cb->server_bda)) {
     bta_gattc_cache_write(p_clcb->p_srcb->server_bda,
-                          p_clcb->p_srcb->gatt_database.Serialize());
+                          p_clcb->p_srcb->gatt_database);
   }
 
   // After success, reset the count.
@@ -242,24 +287,35 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
   bta_gattc_reset_discover_st(p_clcb->p_srcb, GATT_SUCCESS);
 }
 
-/** Start discovery for characteristic descriptor */
+/** Start discovery for characteristic descriptor. Descriptor ranges of
+ * different characteristics don't depend on each other, so one request is
+ * kept outstanding per bearer the stack lets us use (ATT plus EATT). */
 void bta_gattc_start_disc_char_dscp(uint16_t conn_id,
                                     tBTA_GATTC_SERV* p_srvc_cb) {
   VLOG(1) << "starting discover characteristics descriptor";
 
-  std::pair<uint16_t, uint16_t> range =
-      p_srvc_cb->pending_discovery.NextDescriptorRangeToExplore();
-  if (range == DatabaseBuilder::EXPLORE_END) {
-    goto descriptor_discovery_done;
-  }
+  while (true) {
+    std::pair<uint16_t, uint16_t> range = p_srvc_cb->deferred_dscp_range;
+    p_srvc_cb->deferred_dscp_range = {0, 0};
+    if (range.first == 0) {
+      range = p_srvc_cb->pending_discovery.NextDescriptorRangeToExplore();
+    }
+    if (range == DatabaseBuilder::EXPLORE_END) break;
 
-  if (GATTC_Discover(conn_id, GATT_DISC_CHAR_DSCPT, range.first,
-                     range.second) != 0) {
-    goto descriptor_discovery_done;
+    tGATT_STATUS status = GATTC_Discover(conn_id, GATT_DISC_CHAR_DSCPT,
+                                         range.first, range.second);
+    if (status == GATT_BUSY && p_srvc_cb->dscp_disc_in_flight > 0) {
+      /* all bearers busy, retry once one of our requests completes */
+      p_srvc_cb->deferred_dscp_range = range;
+      return;
+    }
+    if (status != GATT_SUCCESS) break;
+    p_srvc_cb->dscp_disc_in_flight++;
   }
-  return;
 
-descriptor_discovery_done:
+  /* wait for the descriptors still being discovered */
+  if (p_srvc_cb->dscp_disc_in_flight > 0) return;
+
   /* all characteristic has been explored, start with next service if any */
   DVLOG(3) << "all characteristics explored";
 
@@ -435,9 +491,22 @@ void bta_gattc_disc_cmpl_cback(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
   tBTA_GATTC_SERV* p_srvc_cb = bta_gattc_find_scb_by_cid(conn_id);
 
+  if (p_srvc_cb && disc_type == GATT_DISC_CHAR_DSCPT &&
+      p_srvc_cb->dscp_disc_in_flight > 0) {
+    p_srvc_cb->dscp_disc_in_flight--;
+  }
+
   if (p_clcb && (status != GATT_SUCCESS || p_clcb->status != GATT_SUCCESS)) {
     if (status == GATT_SUCCESS) p_clcb->status = status;
 
+    /* finish discovery once the last outstanding descriptor request is done */
+    if (p_srvc_cb && disc_type == GATT_DISC_CHAR_DSCPT &&
+        p_srvc_cb->dscp_disc_in_flight > 0) {
+      if (p_clcb->status == GATT_SUCCESS) p_clcb->status = status;
+      p_srvc_cb->deferred_dscp_range = {0, 0};
+      return;
+    }
+
     // if db out of sync is received, try to start service discovery if possible
     if (bta_gattc_is_robust_caching_enabled() &&
         status == GATT_DATABASE_OUT_OF_SYNC) {
@@ -485,6 +554,7 @@ void bta_gattc_disc_cmpl_cback(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
     }
 
     case GATT_DISC_CHAR_DSCPT:
+      if (!p_clcb || p_clcb->state != BTA_GATTC_DISCOVER_ST) break;
       /* start discovering next characteristic for char descriptor */
       bta_gattc_start_disc_char_dscp(conn_id, p_srvc_cb);
       break;
@@ -517,13 +587,14 @@ void bta_gattc_search_service(tBTA_GATTC_CLCB* p_clcb, Uuid* p_uuid) {
   }
 }
 
-const std::list<Service>* bta_gattc_get_services_srcb(tBTA_GATTC_SERV* p_srcb) {
+const std::vector<Service>* bta_gattc_get_services_srcb(
+    tBTA_GATTC_SERV* p_srcb) {
   if (!p_srcb || p_srcb->gatt_database.IsEmpty()) return NULL;
 
   return &p_srcb->gatt_database.Services();
 }
 
-const std::list<Service>* bta_gattc_get_services(uint16_t conn_id) {
+const std::vector<Service>* bta_gattc_get_services(uint16_t conn_id) {
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
   if (p_clcb == NULL) return NULL;
@@ -535,31 +606,22 @@ const std::list<Service>* bta_gattc_get_services(uint16_t conn_id) {
 
 const Service* bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV* p_srcb,
                                                      uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services_srcb(p_srcb);
-  if (services == NULL) return NULL;
-  return bta_gattc_find_matching_service(*services, handle);
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindService(handle);
 }
 
 const Service* bta_gattc_get_service_for_handle(uint16_t conn_id,
                                                 uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services(conn_id);
-  if (services == NULL) return NULL;
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (p_clcb == NULL) return NULL;
 
-  return bta_gattc_find_matching_service(*services, handle);
+  return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV* p_srcb,
                                                         uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    if (handle == charac.value_handle) return &charac;
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
@@ -574,20 +636,8 @@ const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
 
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
                                                 uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) {
-    return NULL;
-  }
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &desc;
-    }
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindDescriptor(handle);
 }
 
 const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
@@ -601,18 +651,8 @@ const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
 
 const Characteristic* bta_gattc_get_owning_characteristic_srcb(
     tBTA_GATTC_SERV* p_srcb, uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &charac;
-    }
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindOwningCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_owning_characteristic(uint16_t conn_id,
@@ -653,16 +693,18 @@ static void bta_gattc_read_db_hash_cmpl(tBTA_GATTC_CLCB* p_clcb,
 
   // run match flow only if the status is success
   bool matched = false;
+  bool have_remote_hash = false;
+  Octet16 remote_hash;
   if (p_data->status == GATT_SUCCESS) {
     // start to compare local hash and remote hash
     uint16_t len = p_data->p_cmpl->att_value.len;
     uint8_t* data = p_data->p_cmpl->att_value.value;
 
-    Octet16 remote_hash;
     if (len == remote_hash.size()) {
       uint8_t idx = 0;
       auto it = remote_hash.begin();
       for (; idx < len; idx++, data++, it++) *it = *data;
+      have_remote_hash = true;
 
       Octet16 local_hash = p_clcb->p_srcb->gatt_database.Hash();
       matched = (local_hash == remote_hash);
@@ -673,6 +715,17 @@ static void bta_gattc_read_db_hash_cmpl(tBTA_GATTC_CLCB* p_clcb,
     LOG(INFO) << __func__ << ": hash is the same, skip service discovery";
     p_clcb->p_srcb->state = BTA_GATTC_SERV_IDLE;
     bta_gattc_reset_discover_st(p_clcb->p_srcb, GATT_SUCCESS);
+  } else if (have_remote_hash &&
+             bta_gattc_hash_cache_load(p_clcb->p_srcb, remote_hash)) {
+    LOG(INFO) << __func__
+              << ": database with this hash is cached, skip service discovery";
+    tBTA_GATTC_SERV* p_srcb = p_clcb->p_srcb;
+    if (btm_sec_is_a_bonded_dev(p_srcb->server_bda)) {
+      bta_gattc_cache_write(p_srcb->server_bda, p_srcb->gatt_database);
+    }
+    p_srcb->srvc_disc_count = 0;
+    p_srcb->state = BTA_GATTC_SERV_IDLE;
+    bta_gattc_reset_discover_st(p_srcb, GATT_SUCCESS);
   } else {
     LOG(INFO) << __func__ << ": hash is not the same, start service discovery";
     bta_gattc_start_discover_internal(p_clcb);
@@ -772,7 +825,7 @@ void bta_gattc_fill_gatt_db_el(btgatt_db_element_t* p_attr,
 /*******************************************************************************
  * Returns          number of elements inside db from start_handle to end_handle
  ******************************************************************************/
-static size_t bta_gattc_get_db_size(const std::list<Service>& services,
+static size_t bta_gattc_get_db_size(const std::vector<Service>& services,
                                     uint16_t start_handle,
                                     uint16_t end_handle) {
   if (services.empty()) return 0;
@@ -935,46 +988,52 @@ bool bta_gattc_cache_load(tBTA_GATTC_SERV* p_srcb) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), p_srcb->server_bda);
 
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
-    LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
-               << " for reading, error: " << strerror(errno);
-    return false;
-  }
+  return bta_gattc_cache_load_file(fname, &p_srcb->gatt_database);
+}
 
-  uint16_t cache_ver = 0;
-  bool success = false;
-  uint16_t num_attr = 0;
+/*******************************************************************************
+ *
+ * Function         bta_gattc_hash_cache_load
+ *
+ * Description      Load the database another server with the same Database
+ *                  Hash was discovered to have. The loaded database must hash
+ *                  to |hash|, otherwise it is dropped.
+ *
+ * Parameter        p_srcb: pointer to the server cache, that will
+ *                          be filled from storage
+ *                  hash: Database Hash read from the server
+ * Returns          true on success, false otherwise
+ *
+ ******************************************************************************/
+static bool bta_gattc_hash_cache_load(tBTA_GATTC_SERV* p_srcb,
+                                      const Octet16& hash) {
+  char fname[255] = {0};
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
 
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
-  }
+  if (access(fname, F_OK) != 0) return false;
 
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
-  }
+  Database database;
+  if (!bta_gattc_cache_load_file(fname, &database)) return false;
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+  if (database.Hash() != hash) {
+    LOG(WARNING) << __func__ << ": stale GATT hash cache " << fname;
+    unlink(fname);
+    return false;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
-
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
+  p_srcb->gatt_database = std::move(database);
+  return true;
+}
 
-    p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
+static bool bta_gattc_cache_load_file(const char* fname, Database* database) {
+  std::shared_ptr<const DatabaseFile> file = DatabaseFile::Open(fname);
+  if (!file) {
+    LOG(ERROR) << __func__ << ": can't load GATT cache file " << fname;
+    return false;
   }
 
-done:
-  fclose(fd);
+  bool success = false;
+  *database = file->ToDatabase(&success);
   return success;
 }
 
@@ -986,44 +1045,49 @@ done:
  *                  cache is available to save.
  *
  * Parameter        server_bda: server bd address of this cache belongs to
- *                  attr: attributes to save.
+ *                  database: database to save.
  * Returns
  *
  ******************************************************************************/
 static void bta_gattc_cache_write(const RawAddress& server_bda,
-                                  const std::vector<StoredAttribute>& attr) {
+                                  const Database& database) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
 
-  FILE* fd = fopen(fname, "wb");
-  if (!fd) {
-    LOG(ERROR) << __func__
-               << ": can't open GATT cache file for writing: " << fname;
-    return;
+  /* link to the copy stored under the hash, so that devices with the same
+   * database share one file and one mapping of it */
+  Octet16 hash = database.Hash();
+  if (bta_gattc_is_robust_caching_enabled() &&
+      bta_gattc_has_db_hash(database)) {
+    char hash_fname[255] = {0};
+    bta_gattc_generate_hash_file_name(hash_fname, sizeof(hash_fname), hash);
+    unlink(fname);
+    if (link(hash_fname, fname) == 0) return;
   }
 
-  uint16_t cache_ver = GATT_CACHE_VERSION;
-  if (fwrite(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache version: " << fname;
-    fclose(fd);
-    return;
-  }
+  DatabaseFile::Write(fname, database.Serialize(), hash);
+}
 
-  uint16_t num_attr = attr.size();
-  if (fwrite(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't write GATT cache attribute count: " << fname;
-    fclose(fd);
-    return;
-  }
+/*******************************************************************************
+ *
+ * Function         bta_gattc_hash_cache_write
+ *
+ * Description      Save a discovered database under its Database Hash, for
+ *                  other servers that report the same hash.
+ *
+ * Parameter        database: database to save.
+ * Returns
+ *
+ ******************************************************************************/
+static void bta_gattc_hash_cache_write(const Database& database) {
+  char fname[255] = {0};
+  Octet16 hash = database.Hash();
+  bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
 
-  if (fwrite(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-    LOG(ERROR) << __func__ << ": can't write GATT cache attributes: " << fname;
-    fclose(fd);
-    return;
-  }
+  /* same hash, same content: keep the file devices already link to */
+  if (access(fname, F_OK) == 0) return;
 
-  fclose(fd);
+  DatabaseFile::Write(fname, database.Serialize(), hash);
 }
 
 /*******************************************************************************
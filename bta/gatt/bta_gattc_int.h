@@ -54,6 +54,7 @@ enum {
   BTA_GATTC_API_SEARCH_EVT,
   BTA_GATTC_API_CONFIRM_EVT,
   BTA_GATTC_API_READ_MULTI_EVT,
+  BTA_GATTC_API_WRITE_STREAM_EVT,
 
   BTA_GATTC_INT_CONN_EVT,
   BTA_GATTC_INT_DISCOVER_EVT,
@@ -79,6 +80,12 @@ typedef uint16_t tBTA_GATTC_INT_EVT;
 #define BTA_GATTC_CLCB_MAX GATT_CL_MAX_LCB
 #endif
 
+/* Write Commands of a stream sent in a row before yielding to the main
+ * thread */
+#ifndef BTA_GATTC_STREAM_BURST_MAX
+#define BTA_GATTC_STREAM_BURST_MAX 16
+#endif
+
 #define BTA_GATTC_WRITE_PREPARE GATT_WRITE_PREPARE
 
 /* internal strucutre for GATTC register API  */
@@ -123,9 +130,22 @@ typedef struct {
   void* write_cb_data;
 } tBTA_GATTC_API_WRITE;
 
+typedef struct {
+  BT_HDR_RIGID hdr;
+  tGATT_AUTH_REQ auth_req;
+  uint16_t handle;
+  uint32_t len;
+  uint32_t offset; /* octets already handed to L2CAP */
+  uint8_t* p_value;
+  GATT_WRITE_STREAM_OP_CB stream_cb;
+  void* stream_cb_data;
+} tBTA_GATTC_API_WRITE_STREAM;
+
 typedef struct {
   BT_HDR_RIGID hdr;
   bool is_execute;
+  GATT_EXECUTE_WRITE_OP_CB exec_cb;
+  void* exec_cb_data;
 } tBTA_GATTC_API_EXEC;
 
 typedef struct {
@@ -150,6 +170,9 @@ typedef struct {
   tGATT_AUTH_REQ auth_req;
   uint8_t num_attr;
   uint16_t handles[GATT_MAX_READ_MULTI_HANDLES];
+  bool variable_len;
+  GATT_READ_MULTI_OP_CB read_cb;
+  void* read_cb_data;
 } tBTA_GATTC_API_READ_MULTI;
 
 typedef struct {
@@ -175,6 +198,7 @@ typedef union {
   tBTA_GATTC_API_READ api_read;
   tBTA_GATTC_API_SEARCH api_search;
   tBTA_GATTC_API_WRITE api_write;
+  tBTA_GATTC_API_WRITE_STREAM api_write_stream;
   tBTA_GATTC_API_CONFIRM api_confirm;
   tBTA_GATTC_API_EXEC api_exec;
   tBTA_GATTC_API_READ_MULTI api_read_multi;
@@ -215,8 +239,15 @@ typedef struct {
   bool read_multiple_not_supported;
 
   uint8_t srvc_hdl_chg; /* service handle change indication pending */
+  /* handle range of the pending service change indications, {0, 0} if none */
+  std::pair<uint16_t, uint16_t> srvc_chg_range;
   bool srvc_hdl_db_hash;   /* read db hash pending */
   uint8_t srvc_disc_count; /* current discovery retry count */
+
+  /* used only during service discovery: descriptor discovery requests
+   * outstanding, and a descriptor range that found every bearer busy */
+  uint8_t dscp_disc_in_flight;
+  std::pair<uint16_t, uint16_t> deferred_dscp_range;
   uint16_t attr_index;  /* cahce NV saving/loading attribute index */
 
   uint16_t mtu;
@@ -268,6 +299,18 @@ typedef struct {
   bool in_use;
   tBTA_GATTC_STATE state;
   tGATT_STATUS status;
+
+// progress of the Write Command stream in p_q_cmd, if any
+#define BTA_GATTC_STREAM_IDLE 0
+#define BTA_GATTC_STREAM_SENDING 1       /* segment handed to GATTC_Write */
+#define BTA_GATTC_STREAM_SENT 2          /* segment completed within the call */
+#define BTA_GATTC_STREAM_W4_CMPL 3       /* segment waits for security */
+#define BTA_GATTC_STREAM_W4_UNCONGEST 4  /* link congested */
+#define BTA_GATTC_STREAM_W4_RESUME 5     /* yielded to the main thread */
+
+  uint8_t stream_state;
+  tGATT_STATUS stream_status; /* status of the last segment */
+  uint16_t stream_seg_len;    /* length of the last segment */
 } tBTA_GATTC_CLCB;
 
 /* back ground connection tracking information */
@@ -366,6 +409,8 @@ extern void bta_gattc_read(tBTA_GATTC_CLCB* p_clcb,
                            const tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_write(tBTA_GATTC_CLCB* p_clcb,
                             const tBTA_GATTC_DATA* p_data);
+extern void bta_gattc_write_stream(tBTA_GATTC_CLCB* p_clcb,
+                                   const tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb,
                               const tBTA_GATTC_DATA* p_data);
 extern void bta_gattc_q_cmd(tBTA_GATTC_CLCB* p_clcb,
@@ -451,7 +496,8 @@ extern tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
                                                    tGATT_DISC_TYPE disc_type);
 extern void bta_gattc_search_service(tBTA_GATTC_CLCB* p_clcb,
                                      bluetooth::Uuid* p_uuid);
-extern const std::list<gatt::Service>* bta_gattc_get_services(uint16_t conn_id);
+extern const std::vector<gatt::Service>* bta_gattc_get_services(
+    uint16_t conn_id);
 extern const gatt::Service* bta_gattc_get_service_for_handle(uint16_t conn_id,
                                                              uint16_t handle);
 const gatt::Characteristic* bta_gattc_get_characteristic_srcb(
@@ -468,6 +514,9 @@ extern void bta_gattc_get_gatt_db(uint16_t conn_id, uint16_t start_handle,
                                   uint16_t end_handle, btgatt_db_element_t** db,
                                   int* count);
 extern void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb);
+extern bool bta_gattc_init_partial_cache(tBTA_GATTC_SERV* p_srvc_cb,
+                                         uint16_t* p_s_handle,
+                                         uint16_t* p_e_handle);
 extern void bta_gattc_reset_discover_st(tBTA_GATTC_SERV* p_srcb,
                                         tGATT_STATUS status);
 
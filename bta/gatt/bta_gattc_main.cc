@@ -60,6 +60,7 @@ enum {
   BTA_GATTC_DISC_CLOSE,
   BTA_GATTC_RESTART_DISCOVER,
   BTA_GATTC_CFG_MTU,
+  BTA_GATTC_WRITE_STREAM,
 
   BTA_GATTC_IGNORE
 };
@@ -92,7 +93,8 @@ const tBTA_GATTC_ACTION bta_gattc_action[] = {
     bta_gattc_op_cmpl_during_discovery, /* BTA_GATTC_OP_CMPL_DURING_DISCOVERY */
     bta_gattc_disc_close,               /* BTA_GATTC_DISC_CLOSE */
     bta_gattc_restart_discover,         /* BTA_GATTC_RESTART_DISCOVER */
-    bta_gattc_cfg_mtu                   /* BTA_GATTC_CFG_MTU */
+    bta_gattc_cfg_mtu,                  /* BTA_GATTC_CFG_MTU */
+    bta_gattc_write_stream              /* BTA_GATTC_WRITE_STREAM */
 };
 
 /* state table information */
@@ -124,6 +126,7 @@ static const uint8_t bta_gattc_st_idle[][BTA_GATTC_NUM_COLS] = {
     /* BTA_GATTC_API_SEARCH_EVT         */ {BTA_GATTC_FAIL, BTA_GATTC_IDLE_ST},
     /* BTA_GATTC_API_CONFIRM_EVT        */ {BTA_GATTC_FAIL, BTA_GATTC_IDLE_ST},
     /* BTA_GATTC_API_READ_MULTI_EVT     */ {BTA_GATTC_FAIL, BTA_GATTC_IDLE_ST},
+    /* BTA_GATTC_API_WRITE_STREAM_EVT   */ {BTA_GATTC_FAIL, BTA_GATTC_IDLE_ST},
 
     /* BTA_GATTC_INT_CONN_EVT           */ {BTA_GATTC_CONN, BTA_GATTC_CONN_ST},
     /* BTA_GATTC_INT_DISCOVER_EVT       */ {BTA_GATTC_IGNORE,
@@ -166,6 +169,8 @@ static const uint8_t bta_gattc_st_w4_conn[][BTA_GATTC_NUM_COLS] = {
                                             BTA_GATTC_W4_CONN_ST},
     /* BTA_GATTC_API_READ_MULTI_EVT     */ {BTA_GATTC_FAIL,
                                             BTA_GATTC_W4_CONN_ST},
+    /* BTA_GATTC_API_WRITE_STREAM_EVT   */ {BTA_GATTC_FAIL,
+                                            BTA_GATTC_W4_CONN_ST},
 
     /* BTA_GATTC_INT_CONN_EVT           */ {BTA_GATTC_CONN, BTA_GATTC_CONN_ST},
     /* BTA_GATTC_INT_DISCOVER_EVT       */ {BTA_GATTC_IGNORE,
@@ -204,6 +209,8 @@ static const uint8_t bta_gattc_st_connected[][BTA_GATTC_NUM_COLS] = {
                                             BTA_GATTC_CONN_ST},
     /* BTA_GATTC_API_READ_MULTI_EVT     */ {BTA_GATTC_READ_MULTI,
                                             BTA_GATTC_CONN_ST},
+    /* BTA_GATTC_API_WRITE_STREAM_EVT   */ {BTA_GATTC_WRITE_STREAM,
+                                            BTA_GATTC_CONN_ST},
 
     /* BTA_GATTC_INT_CONN_EVT           */ {BTA_GATTC_IGNORE,
                                             BTA_GATTC_CONN_ST},
@@ -248,6 +255,8 @@ static const uint8_t bta_gattc_st_discover[][BTA_GATTC_NUM_COLS] = {
                                             BTA_GATTC_DISCOVER_ST},
     /* BTA_GATTC_API_READ_MULTI_EVT     */ {BTA_GATTC_Q_CMD,
                                             BTA_GATTC_DISCOVER_ST},
+    /* BTA_GATTC_API_WRITE_STREAM_EVT   */ {BTA_GATTC_Q_CMD,
+                                            BTA_GATTC_DISCOVER_ST},
 
     /* BTA_GATTC_INT_CONN_EVT           */ {BTA_GATTC_CONN,
                                             BTA_GATTC_DISCOVER_ST},
@@ -436,6 +445,8 @@ static const char* gattc_evt_code(tBTA_GATTC_INT_EVT evt_code) {
       return "BTA_GATTC_API_CONFIRM_EVT";
     case BTA_GATTC_API_READ_MULTI_EVT:
       return "BTA_GATTC_API_READ_MULTI_EVT";
+    case BTA_GATTC_API_WRITE_STREAM_EVT:
+      return "BTA_GATTC_API_WRITE_STREAM_EVT";
     case BTA_GATTC_INT_CONN_EVT:
       return "BTA_GATTC_INT_CONN_EVT";
     case BTA_GATTC_INT_DISCOVER_EVT:
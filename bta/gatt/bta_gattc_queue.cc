@@ -16,10 +16,13 @@
 
 #include "bta_gatt_queue.h"
 
+#include <algorithm>
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "stack/include/bt_types.h"
+
 using gatt_operation = BtaGattQueue::gatt_operation;
 
 constexpr uint8_t GATT_READ_CHAR = 1;
@@ -28,6 +31,15 @@ constexpr uint8_t GATT_WRITE_CHAR = 3;
 constexpr uint8_t GATT_WRITE_DESC = 4;
 constexpr uint8_t GATT_CONFIG_MTU = 5;
 
+/* Operations of a batch. Their callbacks queue the next operation of the batch
+ * at the front before running the queue, so batches are not interleaved with
+ * other operations */
+constexpr uint8_t GATT_BATCH_READ = 6;
+constexpr uint8_t GATT_BATCH_READ_MULTI = 7;
+constexpr uint8_t GATT_BATCH_WRITE = 8;
+constexpr uint8_t GATT_BATCH_PREPARE_WRITE = 9;
+constexpr uint8_t GATT_BATCH_EXECUTE_WRITE = 10;
+
 struct gatt_read_op_data {
   GATT_READ_OP_CB cb;
   void* cb_data;
@@ -104,6 +116,221 @@ void BtaGattQueue::gatt_configure_mtu_op_finished(uint16_t conn_id,
   }
 }
 
+struct gatt_read_batch {
+  GATT_READ_BATCH_OP_CB cb;
+  void* cb_data;
+  std::vector<gatt_read_result> results;
+  /* first result not requested yet */
+  size_t next;
+  /* results to read again with single reads */
+  std::list<size_t> retry;
+  /* results requested by the operation in flight */
+  size_t first;
+  size_t count;
+  bool read_multi_supported;
+};
+
+bool BtaGattQueue::gatt_read_batch_op(void* data, gatt_operation* op) {
+  gatt_read_batch* batch = (gatt_read_batch*)data;
+
+  if (!batch->retry.empty()) {
+    batch->first = batch->retry.front();
+    batch->count = 1;
+    batch->retry.pop_front();
+  } else if (batch->next < batch->results.size()) {
+    batch->first = batch->next;
+    batch->count = 1;
+    if (batch->read_multi_supported) {
+      batch->count = std::min(batch->results.size() - batch->next,
+                              (size_t)GATT_MAX_READ_MULTI_HANDLES);
+    }
+    batch->next += batch->count;
+  } else {
+    return false;
+  }
+
+  *op = {};
+  op->read_cb_data = batch;
+  if (batch->count == 1) {
+    op->type = GATT_BATCH_READ;
+    op->handle = batch->results[batch->first].handle;
+    op->read_cb = gatt_read_batch_single_finished;
+  } else {
+    op->type = GATT_BATCH_READ_MULTI;
+    for (size_t i = batch->first; i < batch->first + batch->count; i++) {
+      op->handles.push_back(batch->results[i].handle);
+    }
+    op->read_multi_cb = gatt_read_batch_multi_finished;
+  }
+  return true;
+}
+
+void BtaGattQueue::gatt_read_batch_continue(uint16_t conn_id, void* data) {
+  gatt_read_batch* batch = (gatt_read_batch*)data;
+
+  gatt_operation op;
+  bool done = !gatt_read_batch_op(batch, &op);
+  if (!done) gatt_op_queue[conn_id].push_front(std::move(op));
+
+  mark_as_not_executing(conn_id);
+  gatt_execute_next_op(conn_id);
+
+  if (!done) return;
+
+  tGATT_STATUS status = GATT_SUCCESS;
+  for (const gatt_read_result& result : batch->results) {
+    if (result.status != GATT_SUCCESS) {
+      status = result.status;
+      break;
+    }
+  }
+  if (batch->cb) batch->cb(conn_id, status, batch->results, batch->cb_data);
+  delete batch;
+}
+
+void BtaGattQueue::gatt_read_batch_single_finished(uint16_t conn_id,
+                                                   tGATT_STATUS status,
+                                                   uint16_t handle,
+                                                   uint16_t len, uint8_t* value,
+                                                   void* data) {
+  gatt_read_batch* batch = (gatt_read_batch*)data;
+  gatt_read_result& result = batch->results[batch->first];
+
+  result.status = status;
+  if (status == GATT_SUCCESS && len > 0) result.value.assign(value, value + len);
+
+  gatt_read_batch_continue(conn_id, batch);
+}
+
+void BtaGattQueue::gatt_read_batch_multi_finished(uint16_t conn_id,
+                                                  tGATT_STATUS status,
+                                                  tBTA_GATTC_MULTI& handles,
+                                                  uint16_t len, uint8_t* value,
+                                                  void* data) {
+  gatt_read_batch* batch = (gatt_read_batch*)data;
+  size_t end = batch->first + batch->count;
+
+  if (status != GATT_SUCCESS) {
+    /* a failed handle fails the whole request, read them one by one to get
+     * the status of each */
+    if (status == GATT_REQ_NOT_SUPPORTED) batch->read_multi_supported = false;
+    for (size_t i = batch->first; i < end; i++) batch->retry.push_back(i);
+    gatt_read_batch_continue(conn_id, batch);
+    return;
+  }
+
+  /* The response is a list of length and value pairs, cut at the MTU. Values
+   * cut short are read again on their own, which reads long values in full */
+  uint8_t* p = value;
+  uint16_t remaining = len;
+  for (size_t i = batch->first; i < end; i++) {
+    if (remaining < 2) {
+      batch->retry.push_back(i);
+      remaining = 0;
+      continue;
+    }
+
+    uint16_t value_len;
+    STREAM_TO_UINT16(value_len, p);
+    remaining -= 2;
+    if (value_len > remaining) {
+      batch->retry.push_back(i);
+      remaining = 0;
+      continue;
+    }
+
+    gatt_read_result& result = batch->results[i];
+    result.status = GATT_SUCCESS;
+    result.value.assign(p, p + value_len);
+    p += value_len;
+    remaining -= value_len;
+  }
+
+  gatt_read_batch_continue(conn_id, batch);
+}
+
+struct gatt_write_batch {
+  GATT_WRITE_BATCH_OP_CB cb;
+  void* cb_data;
+  std::vector<std::pair<uint16_t, std::vector<uint8_t>>> values;
+  /* first value not written yet */
+  size_t next;
+  bool executed;
+  tGATT_STATUS status;
+  uint16_t failed_handle;
+};
+
+bool BtaGattQueue::gatt_write_batch_op(void* data, gatt_operation* op) {
+  gatt_write_batch* batch = (gatt_write_batch*)data;
+  if (batch->executed) return false;
+
+  *op = {};
+  op->write_cb_data = batch;
+
+  if (batch->values.size() == 1) {
+    op->type = GATT_BATCH_WRITE;
+    op->handle = batch->values[0].first;
+    op->value = std::move(batch->values[0].second);
+    op->write_cb = gatt_write_batch_write_finished;
+    batch->next = 1;
+    batch->executed = true;
+  } else if (batch->status == GATT_SUCCESS &&
+             batch->next < batch->values.size()) {
+    op->type = GATT_BATCH_PREPARE_WRITE;
+    op->handle = batch->values[batch->next].first;
+    op->value = std::move(batch->values[batch->next].second);
+    op->write_cb = gatt_write_batch_write_finished;
+    batch->next++;
+  } else {
+    /* cancel anything already prepared if a prepare write failed */
+    op->type = GATT_BATCH_EXECUTE_WRITE;
+    op->is_execute = batch->status == GATT_SUCCESS;
+    op->exec_cb = gatt_write_batch_exec_finished;
+    batch->executed = true;
+  }
+  return true;
+}
+
+void BtaGattQueue::gatt_write_batch_continue(uint16_t conn_id, void* data) {
+  gatt_write_batch* batch = (gatt_write_batch*)data;
+
+  gatt_operation op;
+  bool done = !gatt_write_batch_op(batch, &op);
+  if (!done) gatt_op_queue[conn_id].push_front(std::move(op));
+
+  mark_as_not_executing(conn_id);
+  gatt_execute_next_op(conn_id);
+
+  if (!done) return;
+
+  if (batch->cb) {
+    batch->cb(conn_id, batch->status, batch->failed_handle, batch->cb_data);
+  }
+  delete batch;
+}
+
+void BtaGattQueue::gatt_write_batch_write_finished(uint16_t conn_id,
+                                                   tGATT_STATUS status,
+                                                   uint16_t handle,
+                                                   void* data) {
+  gatt_write_batch* batch = (gatt_write_batch*)data;
+  if (status != GATT_SUCCESS && batch->status == GATT_SUCCESS) {
+    batch->status = status;
+    batch->failed_handle = batch->values[batch->next - 1].first;
+  }
+  gatt_write_batch_continue(conn_id, batch);
+}
+
+void BtaGattQueue::gatt_write_batch_exec_finished(uint16_t conn_id,
+                                                  tGATT_STATUS status,
+                                                  void* data) {
+  gatt_write_batch* batch = (gatt_write_batch*)data;
+  if (status != GATT_SUCCESS && batch->status == GATT_SUCCESS) {
+    batch->status = status;
+  }
+  gatt_write_batch_continue(conn_id, batch);
+}
+
 void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
   APPL_TRACE_DEBUG("%s: conn_id=0x%x", __func__, conn_id);
   if (gatt_op_queue.empty()) {
@@ -169,6 +396,25 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
     BTA_GATTC_ConfigureMTU(conn_id, static_cast<uint16_t>(op.value[0] |
                                                           (op.value[1] << 8)),
                            gatt_configure_mtu_op_finished, data);
+  } else if (op.type == GATT_BATCH_READ) {
+    BTA_GATTC_ReadCharacteristic(conn_id, op.handle, GATT_AUTH_REQ_NONE,
+                                 op.read_cb, op.read_cb_data);
+  } else if (op.type == GATT_BATCH_READ_MULTI) {
+    tBTA_GATTC_MULTI multi;
+    multi.num_attr = op.handles.size();
+    std::copy(op.handles.begin(), op.handles.end(), multi.handles);
+    BTA_GATTC_ReadMultiple(conn_id, &multi, true, GATT_AUTH_REQ_NONE,
+                           op.read_multi_cb, op.read_cb_data);
+  } else if (op.type == GATT_BATCH_WRITE) {
+    BTA_GATTC_WriteCharValue(conn_id, op.handle, GATT_WRITE,
+                             std::move(op.value), GATT_AUTH_REQ_NONE,
+                             op.write_cb, op.write_cb_data);
+  } else if (op.type == GATT_BATCH_PREPARE_WRITE) {
+    BTA_GATTC_PrepareWrite(conn_id, op.handle, 0, std::move(op.value),
+                           GATT_AUTH_REQ_NONE, op.write_cb, op.write_cb_data);
+  } else if (op.type == GATT_BATCH_EXECUTE_WRITE) {
+    BTA_GATTC_ExecuteWrite(conn_id, op.is_execute, op.exec_cb,
+                           op.write_cb_data);
   }
 
   gatt_ops.pop_front();
@@ -231,3 +477,45 @@ void BtaGattQueue::ConfigureMtu(uint16_t conn_id, uint16_t mtu) {
                                     .value = std::move(value)});
   gatt_execute_next_op(conn_id);
 }
+
+void BtaGattQueue::ReadMultiple(uint16_t conn_id,
+                                const std::vector<uint16_t>& handles,
+                                GATT_READ_BATCH_OP_CB cb, void* cb_data) {
+  if (handles.empty()) {
+    if (cb) cb(conn_id, GATT_SUCCESS, {}, cb_data);
+    return;
+  }
+
+  gatt_read_batch* batch = new gatt_read_batch{
+      .cb = cb, .cb_data = cb_data, .read_multi_supported = true};
+  for (uint16_t handle : handles) {
+    batch->results.push_back(
+        {.handle = handle, .status = GATT_ERROR, .value = {}});
+  }
+
+  gatt_operation op;
+  gatt_read_batch_op(batch, &op);
+  gatt_op_queue[conn_id].push_back(std::move(op));
+  gatt_execute_next_op(conn_id);
+}
+
+void BtaGattQueue::WriteMultiple(
+    uint16_t conn_id,
+    std::vector<std::pair<uint16_t, std::vector<uint8_t>>> values,
+    GATT_WRITE_BATCH_OP_CB cb, void* cb_data) {
+  if (values.empty()) {
+    if (cb) cb(conn_id, GATT_SUCCESS, 0, cb_data);
+    return;
+  }
+
+  gatt_write_batch* batch = new gatt_write_batch{
+      .cb = cb,
+      .cb_data = cb_data,
+      .values = std::move(values),
+      .status = GATT_SUCCESS};
+
+  gatt_operation op;
+  gatt_write_batch_op(batch, &op);
+  gatt_op_queue[conn_id].push_back(std::move(op));
+  gatt_execute_next_op(conn_id);
+}
@@ -255,6 +255,43 @@ void BTA_GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_id,
   bta_sys_sendmsg(p_buf);
 }
 
+static void bta_gatts_set_attr_cache_impl(uint16_t attr_id,
+                                          std::vector<uint8_t> value,
+                                          uint64_t ttl_ms) {
+  if (value.empty()) {
+    GATTS_ClearAttributeCache(attr_id);
+    return;
+  }
+
+  tGATT_STATUS status = GATTS_SetAttributeCache(attr_id, value, ttl_ms);
+  if (status != GATT_SUCCESS) {
+    LOG(ERROR) << __func__ << ": attr_id=" << loghex(attr_id)
+               << " not cached, status=" << loghex(status);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTS_SetAttributeCache
+ *
+ * Description      This function is called to let the stack answer reads of
+ *                  a characteristic or descriptor.
+ *
+ * Parameters       attr_id - attribute ID of the cached value.
+ *                  value - value of the attribute, empty to stop caching it.
+ *                  ttl_ms - how long the value stays valid, 0 if it never
+ *                           changes.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTS_SetAttributeCache(uint16_t attr_id, std::vector<uint8_t> value,
+                                 uint64_t ttl_ms) {
+  do_in_main_thread(FROM_HERE,
+                    base::Bind(&bta_gatts_set_attr_cache_impl, attr_id,
+                               std::move(value), ttl_ms));
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTS_SendRsp
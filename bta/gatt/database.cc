@@ -22,7 +22,7 @@
 #include "stack/include/gattdefs.h"
 
 #include <base/logging.h>
-#include <list>
+#include <algorithm>
 #include <memory>
 #include <sstream>
 
@@ -48,7 +48,7 @@ static size_t UuidSize(const Uuid& uuid) {
   return (len == Uuid::kNumBytes32) ? Uuid::kNumBytes128 : len;
 }
 
-Service* FindService(std::list<Service>& services, uint16_t handle) {
+Service* FindService(std::vector<Service>& services, uint16_t handle) {
   for (Service& service : services) {
     if (handle >= service.handle && handle <= service.end_handle)
       return &service;
@@ -57,6 +57,61 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+const Service* Database::FindService(uint16_t handle) const {
+  auto it = std::upper_bound(
+      services.begin(), services.end(), handle,
+      [](uint16_t handle, const Service& s) { return handle < s.handle; });
+  if (it == services.begin()) return nullptr;
+  --it;
+  return HandleInRange(*it, handle) ? &*it : nullptr;
+}
+
+const Characteristic* Database::FindCharacteristicBefore(
+    uint16_t handle) const {
+  const Service* service = FindService(handle);
+  if (!service) return nullptr;
+
+  const auto& characteristics = service->characteristics;
+  auto it = std::lower_bound(characteristics.begin(), characteristics.end(),
+                             handle, [](const Characteristic& c, uint16_t h) {
+                               return c.declaration_handle < h;
+                             });
+  if (it == characteristics.begin()) return nullptr;
+  return &*std::prev(it);
+}
+
+const Characteristic* Database::FindCharacteristic(
+    uint16_t value_handle) const {
+  const Characteristic* characteristic = FindCharacteristicBefore(value_handle);
+  if (!characteristic || characteristic->value_handle != value_handle)
+    return nullptr;
+  return characteristic;
+}
+
+static const Descriptor* FindDescriptorIn(const Characteristic& characteristic,
+                                          uint16_t handle) {
+  const auto& descriptors = characteristic.descriptors;
+  auto it = std::lower_bound(
+      descriptors.begin(), descriptors.end(), handle,
+      [](const Descriptor& d, uint16_t h) { return d.handle < h; });
+  if (it == descriptors.end() || it->handle != handle) return nullptr;
+  return &*it;
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  const Characteristic* characteristic = FindCharacteristicBefore(handle);
+  if (!characteristic) return nullptr;
+  return FindDescriptorIn(*characteristic, handle);
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  const Characteristic* characteristic = FindCharacteristicBefore(handle);
+  if (!characteristic || !FindDescriptorIn(*characteristic, handle))
+    return nullptr;
+  return characteristic;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -170,8 +225,8 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
     }
 
     if (attr.type == INCLUDE) {
-      Service* included_service =
-          FindService(result.services, attr.value.included_service.handle);
+      Service* included_service = gatt::FindService(
+          result.services, attr.value.included_service.handle);
       if (!included_service) {
         LOG(ERROR) << __func__ << ": Non-existing included service!";
         *success = false;
@@ -18,7 +18,6 @@
 
 #pragma once
 
-#include <list>
 #include <set>
 #include <string>
 #include <utility>
@@ -107,10 +106,25 @@ class Database {
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() { std::vector<Service>().swap(services); }
 
-  /* Return list of services available in this database */
-  const std::list<Service>& Services() const { return services; }
+  /* Return list of services available in this database, sorted by handle */
+  const std::vector<Service>& Services() const { return services; }
+
+  /* Handle lookups, in O(log n). Services are sorted by handle, their
+   * characteristics by declaration handle and descriptors by handle. */
+
+  /* Return the service whose handle range contains |handle| */
+  const Service* FindService(uint16_t handle) const;
+
+  /* Return the characteristic whose value is at |value_handle| */
+  const Characteristic* FindCharacteristic(uint16_t value_handle) const;
+
+  /* Return the descriptor at |handle| */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic owning the descriptor at |handle| */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
 
   std::string ToString() const;
 
@@ -125,11 +139,15 @@ class Database {
   friend class DatabaseBuilder;
 
  private:
-  std::list<Service> services;
+  /* Return the characteristic declared last before |handle|, the only one
+   * that can own an attribute at |handle| */
+  const Characteristic* FindCharacteristicBefore(uint16_t handle) const;
+
+  std::vector<Service> services;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
  * inside gatt namespace.*/
-Service* FindService(std::list<Service>& services, uint16_t handle);
+Service* FindService(std::vector<Service>& services, uint16_t handle);
 
 }  // namespace gatt
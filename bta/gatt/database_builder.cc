@@ -18,7 +18,6 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <list>
 #include <string>
 #include <utility>
 #include <vector>
@@ -49,9 +48,10 @@ void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
     auto& vec = database.services;
 
     // Find first service whose start handle is bigger than new service handle
-    auto it = std::lower_bound(
-        vec.begin(), vec.end(), handle,
-        [](Service s, uint16_t handle) { return s.end_handle < handle; });
+    auto it = std::lower_bound(vec.begin(), vec.end(), handle,
+                               [](const Service& s, uint16_t handle) {
+                                 return s.end_handle < handle;
+                               });
 
     // Insert new service just before it
     vec.emplace(it, Service{
@@ -68,8 +68,7 @@ void DatabaseBuilder::AddService(uint16_t handle, uint16_t end_handle,
 void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
                                          uint16_t start_handle,
                                          uint16_t end_handle) {
-  Service* service = FindService(database.services, handle);
-  if (!service) {
+  if (!FindService(database.services, handle)) {
     LOG(ERROR) << "Illegal action to add to non-existing service!";
     return;
   }
@@ -80,6 +79,8 @@ void DatabaseBuilder::AddIncludedService(uint16_t handle, const Uuid& uuid,
     AddService(start_handle, end_handle, uuid, false /* not primary */);
   }
 
+  // Adding a service may move the others, look the owner up again
+  Service* service = FindService(database.services, handle);
   service->included_services.push_back(IncludedService{
       .handle = handle,
       .uuid = uuid,
@@ -192,7 +193,7 @@ std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
   return {HANDLE_MAX, HANDLE_MAX};
 }
 
-Descriptor* FindDescriptorByHandle(std::list<Service>& services,
+Descriptor* FindDescriptorByHandle(std::vector<Service>& services,
                                    uint16_t handle) {
   Service* service = FindService(services, handle);
   if (!service) return nullptr;
@@ -239,6 +240,40 @@ bool DatabaseBuilder::SetValueOfDescriptors(
 
 bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 
+bool DatabaseBuilder::StartPartialDiscovery(const Database& old_database,
+                                            uint16_t* start, uint16_t* end) {
+  uint16_t s_handle = *start;
+  uint16_t e_handle = *end;
+  for (const Service& service : old_database.services) {
+    if (service.end_handle < s_handle || service.handle > e_handle) continue;
+    s_handle = std::min(s_handle, service.handle);
+    e_handle = std::max(e_handle, service.end_handle);
+  }
+
+  auto is_changed = [&](uint16_t handle, uint16_t end_handle) {
+    return end_handle >= s_handle && handle <= e_handle;
+  };
+
+  for (const Service& service : old_database.services) {
+    if (is_changed(service.handle, service.end_handle)) continue;
+    for (const IncludedService& included : service.included_services) {
+      if (is_changed(included.start_handle, included.end_handle)) return false;
+    }
+  }
+
+  Clear();
+  services_to_discover.clear();
+  descriptor_handles_to_read.clear();
+  for (const Service& service : old_database.services) {
+    if (!is_changed(service.handle, service.end_handle))
+      database.services.push_back(service);
+  }
+
+  *start = s_handle;
+  *end = e_handle;
+  return true;
+}
+
 Database DatabaseBuilder::Build() {
   Database tmp = database;
   database.Clear();
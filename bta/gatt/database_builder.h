@@ -69,6 +69,13 @@ class DatabaseBuilder {
   // existence will mean discovery is pending
   bool InProgress() const;
 
+  /* Start a discovery of the services in the |*start|-|*end| handle range
+   * only, keeping the services of |database| outside of it. The range is
+   * widened to the services it overlaps. Returns false if services kept would
+   * include services of the range, which then needs a full discovery. */
+  bool StartPartialDiscovery(const Database& database, uint16_t* start,
+                             uint16_t* end);
+
   /* Call this method at end of GATT discovery, to obtain object representing
    * the database of remote device */
   Database Build();
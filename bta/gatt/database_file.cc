@@ -0,0 +1,318 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "database_file.h"
+
+#include <base/logging.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "bt_trace.h"
+#include "stack/include/gattdefs.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+const Uuid PRIMARY_SERVICE = Uuid::From16Bit(GATT_UUID_PRI_SERVICE);
+const Uuid SECONDARY_SERVICE = Uuid::From16Bit(GATT_UUID_SEC_SERVICE);
+const Uuid INCLUDE = Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE);
+const Uuid CHARACTERISTIC = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+const Uuid CHARACTERISTIC_EXTENDED_PROPERTIES =
+    Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP);
+
+/* Record::uuid of attributes that have no value UUID */
+constexpr uint16_t kNoUuid = 0xffff;
+
+/* Open mappings, keyed by device and inode of the mapped file */
+std::mutex open_files_mutex;
+std::map<std::pair<dev_t, ino_t>, std::weak_ptr<const DatabaseFile>>
+    open_files;
+}  // namespace
+
+struct DatabaseFile::Header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t num_uuids;
+  uint32_t num_records;
+  uint8_t hash[16];
+};
+
+/* Meaning of the value fields depends on the attribute type:
+ *   service:        uuid, value_0 = end handle
+ *   included:       uuid, value_0 = start handle, value_1 = end handle
+ *   characteristic: uuid, value_0 = value handle, properties
+ *   ext properties: value_0 = extended properties */
+struct DatabaseFile::Record {
+  uint16_t handle;
+  uint16_t type;
+  uint16_t uuid;
+  uint16_t value_0;
+  uint16_t value_1;
+  uint8_t properties;
+  uint8_t reserved;
+};
+
+bool DatabaseFile::Write(const std::string& path,
+                         const std::vector<StoredAttribute>& attributes,
+                         const Octet16& hash) {
+  std::vector<const StoredAttribute*> sorted;
+  sorted.reserve(attributes.size());
+  for (const StoredAttribute& attr : attributes) sorted.push_back(&attr);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const StoredAttribute* a, const StoredAttribute* b) {
+              return a->handle < b->handle;
+            });
+
+  std::vector<Uuid> uuids;
+  std::unordered_map<Uuid, uint16_t> uuid_index;
+  auto intern = [&](const Uuid& uuid) {
+    auto it = uuid_index.find(uuid);
+    if (it != uuid_index.end()) return it->second;
+    uint16_t index = uuids.size();
+    uuids.push_back(uuid);
+    uuid_index.emplace(uuid, index);
+    return index;
+  };
+
+  std::vector<Record> records;
+  records.reserve(sorted.size());
+  for (const StoredAttribute* attr : sorted) {
+    if (!records.empty() && records.back().handle == attr->handle) {
+      LOG(ERROR) << __func__ << ": duplicate attribute handle "
+                 << loghex(attr->handle);
+      return false;
+    }
+
+    Record record{.handle = attr->handle,
+                  .type = intern(attr->type),
+                  .uuid = kNoUuid};
+    if (attr->type == PRIMARY_SERVICE || attr->type == SECONDARY_SERVICE) {
+      record.uuid = intern(attr->value.service.uuid);
+      record.value_0 = attr->value.service.end_handle;
+    } else if (attr->type == INCLUDE) {
+      record.uuid = intern(attr->value.included_service.uuid);
+      record.value_0 = attr->value.included_service.handle;
+      record.value_1 = attr->value.included_service.end_handle;
+    } else if (attr->type == CHARACTERISTIC) {
+      record.uuid = intern(attr->value.characteristic.uuid);
+      record.value_0 = attr->value.characteristic.value_handle;
+      record.properties = attr->value.characteristic.properties;
+    } else if (attr->type == CHARACTERISTIC_EXTENDED_PROPERTIES) {
+      record.value_0 = attr->value.characteristic_extended_properties;
+    }
+    records.push_back(record);
+  }
+
+  /* an attribute table has fewer than kNoUuid attributes, so fewer UUIDs */
+  Header header{.magic = kMagic,
+                .version = kVersion,
+                .num_uuids = static_cast<uint16_t>(uuids.size()),
+                .num_records = static_cast<uint32_t>(records.size())};
+  memcpy(header.hash, hash.data(), sizeof(header.hash));
+
+  std::string tmp_path = path + ".tmp";
+  FILE* fd = fopen(tmp_path.c_str(), "wb");
+  if (!fd) {
+    LOG(ERROR) << __func__ << ": can't open " << tmp_path << " for writing";
+    return false;
+  }
+
+  bool success = fwrite(&header, sizeof(header), 1, fd) == 1;
+  for (const Uuid& uuid : uuids) {
+    if (!success) break;
+    success = fwrite(uuid.To128BitLE().data(), Uuid::kNumBytes128, 1, fd) == 1;
+  }
+  if (success && !records.empty()) {
+    success =
+        fwrite(records.data(), sizeof(Record), records.size(), fd) ==
+        records.size();
+  }
+  if (fclose(fd) != 0) success = false;
+
+  if (!success || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << __func__ << ": can't write GATT cache file " << path;
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const DatabaseFile> DatabaseFile::Open(
+    const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(open_files_mutex);
+  for (auto it = open_files.begin(); it != open_files.end();) {
+    it = it->second.expired() ? open_files.erase(it) : std::next(it);
+  }
+
+  auto key = std::make_pair(st.st_dev, st.st_ino);
+  auto it = open_files.find(key);
+  if (it != open_files.end()) {
+    close(fd);
+    return it->second.lock();
+  }
+
+  size_t size = st.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT cache file " << path;
+    return nullptr;
+  }
+
+  if (!Validate(static_cast<const uint8_t*>(data), size)) {
+    LOG(ERROR) << __func__ << ": invalid GATT cache file " << path;
+    munmap(data, size);
+    return nullptr;
+  }
+
+  std::shared_ptr<const DatabaseFile> file(
+      new DatabaseFile(static_cast<const uint8_t*>(data), size));
+  open_files[key] = file;
+  return file;
+}
+
+bool DatabaseFile::Validate(const uint8_t* data, size_t size) {
+  static_assert(sizeof(Header) == 28 && sizeof(Header) % alignof(Record) == 0,
+                "uuids and records must stay aligned");
+  static_assert(sizeof(Record) == 12,
+                "cache file layout must not depend on the compiler");
+
+  if (size < sizeof(Header)) return false;
+
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->magic != kMagic || header->version != kVersion) return false;
+
+  size_t expected = sizeof(Header) + header->num_uuids * Uuid::kNumBytes128 +
+                    header->num_records * sizeof(Record);
+  if (size != expected) return false;
+
+  const Record* records = reinterpret_cast<const Record*>(
+      data + sizeof(Header) + header->num_uuids * Uuid::kNumBytes128);
+  for (size_t i = 0; i < header->num_records; i++) {
+    const Record& record = records[i];
+    if (i > 0 && records[i - 1].handle >= record.handle) return false;
+    if (record.type >= header->num_uuids) return false;
+    if (record.uuid != kNoUuid && record.uuid >= header->num_uuids)
+      return false;
+  }
+  return true;
+}
+
+DatabaseFile::DatabaseFile(const uint8_t* data, size_t size)
+    : data_(data), size_(size), num_records_(header()->num_records) {}
+
+DatabaseFile::~DatabaseFile() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+const DatabaseFile::Header* DatabaseFile::header() const {
+  return reinterpret_cast<const Header*>(data_);
+}
+
+const DatabaseFile::Record* DatabaseFile::records() const {
+  return reinterpret_cast<const Record*>(
+      data_ + sizeof(Header) + header()->num_uuids * Uuid::kNumBytes128);
+}
+
+Uuid DatabaseFile::UuidAt(uint16_t index) const {
+  if (index == kNoUuid) return Uuid::kEmpty;
+  return Uuid::From128BitLE(data_ + sizeof(Header) +
+                            index * Uuid::kNumBytes128);
+}
+
+Octet16 DatabaseFile::Hash() const {
+  Octet16 hash;
+  memcpy(hash.data(), header()->hash, hash.size());
+  return hash;
+}
+
+StoredAttribute DatabaseFile::GetAttribute(size_t index) const {
+  const Record& record = records()[index];
+  StoredAttribute attr{.handle = record.handle, .type = UuidAt(record.type)};
+
+  if (attr.type == PRIMARY_SERVICE || attr.type == SECONDARY_SERVICE) {
+    attr.value.service = {.uuid = UuidAt(record.uuid),
+                          .end_handle = record.value_0};
+  } else if (attr.type == INCLUDE) {
+    attr.value.included_service = {.handle = record.value_0,
+                                   .end_handle = record.value_1,
+                                   .uuid = UuidAt(record.uuid)};
+  } else if (attr.type == CHARACTERISTIC) {
+    attr.value.characteristic = {.properties = record.properties,
+                                 .value_handle = record.value_0,
+                                 .uuid = UuidAt(record.uuid)};
+  } else if (attr.type == CHARACTERISTIC_EXTENDED_PROPERTIES) {
+    attr.value.characteristic_extended_properties = record.value_0;
+  }
+  return attr;
+}
+
+bool DatabaseFile::FindAttribute(uint16_t handle,
+                                 StoredAttribute* attribute) const {
+  const Record* begin = records();
+  const Record* end = begin + num_records_;
+  const Record* it =
+      std::lower_bound(begin, end, handle, [](const Record& r, uint16_t h) {
+        return r.handle < h;
+      });
+  if (it == end || it->handle != handle) return false;
+
+  *attribute = GetAttribute(it - begin);
+  return true;
+}
+
+Database DatabaseFile::ToDatabase(bool* success) const {
+  /* Database::Deserialize expects all service declarations first */
+  std::vector<StoredAttribute> attributes;
+  attributes.reserve(num_records_);
+  for (size_t i = 0; i < num_records_; i++) {
+    StoredAttribute attr = GetAttribute(i);
+    if (attr.type == PRIMARY_SERVICE || attr.type == SECONDARY_SERVICE)
+      attributes.push_back(attr);
+  }
+  for (size_t i = 0; i < num_records_; i++) {
+    StoredAttribute attr = GetAttribute(i);
+    if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE)
+      attributes.push_back(attr);
+  }
+
+  return Database::Deserialize(attributes, success);
+}
+
+}  // namespace gatt
@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bta/gatt/database.h"
+
+namespace gatt {
+
+/* GATT client cache file, mapped read-only and queried in place.
+ *
+ * Layout, in host byte order like the earlier versions of the cache:
+ *   Header
+ *   uint8_t uuids[num_uuids][16]   interned UUIDs, little endian
+ *   Record records[num_records]    one per stored attribute, sorted by handle
+ *
+ * Opening a file only validates it, no heap copy is made. Devices whose cache
+ * files are links to the same file share one mapping. */
+class DatabaseFile {
+ public:
+  static constexpr uint32_t kMagic = 0x43544147; /* "GATC" */
+  static constexpr uint16_t kVersion = 7;
+
+  /* Write |attributes| into a cache file at |path|. The file is written aside
+   * and renamed over |path|, so a mapped file never changes under a reader.
+   * Returns false on I/O errors or if two attributes share a handle. */
+  static bool Write(const std::string& path,
+                    const std::vector<StoredAttribute>& attributes,
+                    const Octet16& hash);
+
+  /* Map the cache file at |path|. Returns nullptr if it is missing, of another
+   * version, or malformed. */
+  static std::shared_ptr<const DatabaseFile> Open(const std::string& path);
+
+  ~DatabaseFile();
+
+  /* Database Hash of the stored attributes */
+  Octet16 Hash() const;
+
+  size_t NumAttributes() const { return num_records_; }
+
+  /* Return the attribute at |index|, attributes are ordered by handle */
+  StoredAttribute GetAttribute(size_t index) const;
+
+  /* Find the attribute declared at |handle|. Returns false if there is none */
+  bool FindAttribute(uint16_t handle, StoredAttribute* attribute) const;
+
+  /* Build the database of a connected server from the file */
+  Database ToDatabase(bool* success) const;
+
+ private:
+  struct Header;
+  struct Record;
+
+  DatabaseFile(const uint8_t* data, size_t size);
+  DatabaseFile(const DatabaseFile&) = delete;
+  DatabaseFile& operator=(const DatabaseFile&) = delete;
+
+  static bool Validate(const uint8_t* data, size_t size);
+
+  const Header* header() const;
+  const Record* records() const;
+  bluetooth::Uuid UuidAt(uint16_t index) const;
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t num_records_;
+};
+
+}  // namespace gatt
@@ -620,7 +620,7 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    const std::list<gatt::Service>* services = BTA_GATTC_GetServices(conn_id);
+    const std::vector<gatt::Service>* services = BTA_GATTC_GetServices(conn_id);
 
     const gatt::Service* service = nullptr;
     for (const gatt::Service& tmp : *services) {
@@ -1152,54 +1152,78 @@ class HearingAidImpl : public HearingAid {
     hearingDevice->playback_started = true;
   }
 
-  /* Compare the two sides LE CoC credit and return true to drop two sides
-   * packet on these situations.
-   * 1) The credit is close
-   * 2) Other side is disconnected
-   * 3) Get one side current credit value failure.
-   *
-   * Otherwise, just flush audio packet one side.
+  /* Current LE CoC credits granted by |device|. A failure to read them is
+   * handled as if the peer granted none.
    */
-  bool NeedToDropPacket(HearingDevice* target_side, HearingDevice* other_side) {
-    // Just drop packet if the other side does not exist.
-    if (!other_side) {
-      VLOG(2) << __func__ << ": other side not connected to profile";
-      return true;
-    }
-
-    uint16_t diff_credit = 0;
-
-    uint16_t target_current_credit = L2CA_GetPeerLECocCredit(
-        target_side->address, GAP_ConnGetL2CAPCid(target_side->gap_handle));
-    if (target_current_credit == L2CAP_LE_CREDIT_MAX) {
-      LOG(ERROR) << __func__ << ": Get target side credit value fail.";
-      return true;
+  uint16_t GetPeerCredits(HearingDevice* device) {
+    uint16_t credits = L2CA_GetPeerLECocCredit(
+        device->address, GAP_ConnGetL2CAPCid(device->gap_handle));
+    if (credits == L2CAP_LE_CREDIT_MAX) {
+      LOG(ERROR) << __func__ << ": Get " << device->address
+                 << " credit value fail.";
+      return 0;
     }
+    VLOG(2) << __func__ << ": " << device->address << " Credit: " << credits
+            << ", Init Credit: " << init_credit;
+    return credits;
+  }
 
-    uint16_t other_current_credit = L2CA_GetPeerLECocCredit(
-        other_side->address, GAP_ConnGetL2CAPCid(other_side->gap_handle));
-    if (other_current_credit == L2CAP_LE_CREDIT_MAX) {
-      LOG(ERROR) << __func__ << ": Get other side credit value fail.";
-      return true;
+  /* Flush the oldest audio packets queued towards the two sides before a new
+   * frame of |packets_per_frame| packets is queued.
+   *
+   * Once the new frame is queued, packets that wait for credits beyond one
+   * frame only add latency: they are flushed, oldest first. The side left
+   * with the longest queue then plays behind the other one, so it is trimmed
+   * to at most one frame more than the other side, which keeps the two sides
+   * playing the same frame. The newest frame is never dropped.
+   */
+  void FlushStaleAudioPackets(HearingDevice* left, HearingDevice* right,
+                              uint16_t packets_per_frame) {
+    HearingDevice* sides[] = {left, right};
+    uint16_t queued[2] = {0, 0};
+    uint16_t keep[2] = {0, 0};
+    uint16_t min_keep = UINT16_MAX;
+
+    for (int i = 0; i < 2; i++) {
+      if (!sides[i]) continue;
+      uint16_t cid = GAP_ConnGetL2CAPCid(sides[i]->gap_handle);
+      queued[i] = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
+      keep[i] = queued[i];
+      if (queued[i]) {
+        // Packets left without credits once the new frame is queued
+        int waiting = queued[i] + packets_per_frame - GetPeerCredits(sides[i]);
+        if (waiting > packets_per_frame) {
+          keep[i] -= std::min<int>(waiting - packets_per_frame, queued[i]);
+          sides[i]->audio_stats.trigger_drop_count++;
+        }
+        hearingDevices.StartRssiLog();
+      }
+      min_keep = std::min(min_keep, keep[i]);
     }
 
-    if (target_current_credit > other_current_credit) {
-      diff_credit = target_current_credit - other_current_credit;
-    } else {
-      diff_credit = other_current_credit - target_current_credit;
+    for (int i = 0; i < 2; i++) {
+      if (!sides[i]) continue;
+      if (left && right) {
+        keep[i] = std::min<uint16_t>(keep[i], min_keep + packets_per_frame);
+      }
+      uint16_t to_flush = queued[i] - keep[i];
+      if (to_flush) {
+        LOG(INFO) << sides[i]->address << " flushing " << to_flush << " of "
+                  << queued[i] << " packets";
+        L2CA_FlushChannel(GAP_ConnGetL2CAPCid(sides[i]->gap_handle),
+                          to_flush);
+        sides[i]->audio_stats.packet_flush_count += to_flush;
+        sides[i]->audio_stats.frame_flush_count +=
+            (to_flush + packets_per_frame - 1) / packets_per_frame;
+      }
+      check_and_do_rssi_read(sides[i]);
     }
-    VLOG(2) << __func__ << ": Target(" << target_side->address
-            << ") Credit: " << target_current_credit << ", Other("
-            << other_side->address << ") Credit: " << other_current_credit
-            << ", Init Credit: " << init_credit;
-    return diff_credit < (init_credit / 2 - 1);
   }
 
   void OnAudioDataReady(const std::vector<uint8_t>& data) {
     /* For now we assume data comes in as 16bit per sample 16kHz PCM stereo */
     DVLOG(2) << __func__;
 
-    bool need_drop = false;
     int num_samples =
         data.size() / (2 /*bytes_per_sample*/ * 2 /*number of channels*/);
 
@@ -1227,8 +1251,10 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    std::vector<uint16_t> chan_left;
-    std::vector<uint16_t> chan_right;
+    // The buffers are kept across frames so that they are not reallocated
+    // 100 times a second.
+    chan_left.clear();
+    chan_right.clear();
     if (left == nullptr || right == nullptr) {
       for (int i = 0; i < num_samples; i++) {
         const uint8_t* sample = data.data() + i * 4;
@@ -1259,10 +1285,8 @@ class HearingAidImpl : public HearingAid {
 
     // divide encoded data into packets, add header, send.
 
-    // TODO: make those buffers static and global to prevent constant
-    // reallocations
     // TODO: this should basically fit the encoded data, tune the size later
-    std::vector<uint8_t> encoded_data_left;
+    encoded_data_left.clear();
     if (left) {
       // TODO: instead of a magic number, we need to figure out the correct
       // buffer size
@@ -1271,30 +1295,9 @@ class HearingAidImpl : public HearingAid {
           g722_encode(encoder_state_left, encoded_data_left.data(),
                       (const int16_t*)chan_left.data(), chan_left.size());
       encoded_data_left.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
-      uint16_t packets_in_chans = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_in_chans) {
-        // Compare the two sides LE CoC credit value to confirm need to drop or
-        // skip audio packet.
-        if (NeedToDropPacket(left, right)) {
-          LOG(INFO) << left->address << " triggers dropping, "
-                    << packets_in_chans << " packets in channel";
-          need_drop = true;
-          left->audio_stats.trigger_drop_count++;
-        } else {
-          LOG(INFO) << left->address << " skipping " << packets_in_chans
-                    << " packets";
-          left->audio_stats.packet_flush_count += packets_in_chans;
-          left->audio_stats.frame_flush_count++;
-          L2CA_FlushChannel(cid, 0xffff);
-        }
-        hearingDevices.StartRssiLog();
-      }
-      check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
+    encoded_data_right.clear();
     if (right) {
       // TODO: instead of a magic number, we need to figure out the correct
       // buffer size
@@ -1303,27 +1306,6 @@ class HearingAidImpl : public HearingAid {
           g722_encode(encoder_state_right, encoded_data_right.data(),
                       (const int16_t*)chan_right.data(), chan_right.size());
       encoded_data_right.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
-      uint16_t packets_in_chans = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_in_chans) {
-        // Compare the two sides LE CoC credit value to confirm need to drop or
-        // skip audio packet.
-        if (NeedToDropPacket(right, left)) {
-          LOG(INFO) << right->address << " triggers dropping, "
-                    << packets_in_chans << " packets in channel";
-          need_drop = true;
-          right->audio_stats.trigger_drop_count++;
-        } else {
-          LOG(INFO) << right->address << " skipping " << packets_in_chans
-                    << " packets";
-          right->audio_stats.packet_flush_count += packets_in_chans;
-          right->audio_stats.frame_flush_count++;
-          L2CA_FlushChannel(cid, 0xffff);
-        }
-        hearingDevices.StartRssiLog();
-      }
-      check_and_do_rssi_read(right);
     }
 
     size_t encoded_data_size =
@@ -1332,15 +1314,9 @@ class HearingAidImpl : public HearingAid {
     uint16_t packet_size =
         CalcCompressedAudioPacketSize(codec_in_use, default_data_interval_ms);
 
-    if (need_drop) {
-      if (left) {
-        left->audio_stats.packet_drop_count++;
-      }
-      if (right) {
-        right->audio_stats.packet_drop_count++;
-      }
-      return;
-    }
+    uint16_t packets_per_frame =
+        (encoded_data_size + packet_size - 1) / packet_size;
+    FlushStaleAudioPackets(left, right, packets_per_frame);
 
     for (size_t i = 0; i < encoded_data_size; i += packet_size) {
       if (left) {
@@ -1684,6 +1660,12 @@ class HearingAidImpl : public HearingAid {
 
   HearingDevices hearingDevices;
 
+  /* audio buffers, kept across frames */
+  std::vector<uint16_t> chan_left;
+  std::vector<uint16_t> chan_right;
+  std::vector<uint8_t> encoded_data_left;
+  std::vector<uint8_t> encoded_data_right;
+
   void find_server_changed_ccc_handle(uint16_t conn_id,
                                       const gatt::Service* service) {
     HearingDevice* hearingDevice = hearingDevices.FindByConnId(conn_id);
@@ -61,13 +61,20 @@ int sample_rate = -1;
 int data_interval_ms = -1;
 int num_channels = 2;
 bluetooth::common::RepeatingTimer audio_timer;
+// The wakelock is reference counted, hold it once while the ticks run
+bool wakelock_held = false;
 HearingAidAudioReceiver* localAudioReceiver = nullptr;
 std::unique_ptr<tUIPC_STATE> uipc_hearing_aid = nullptr;
 
+/* Frames queued by the audio HAL above which the producer is considered
+ * ahead of the tick, and one more frame is sent to catch up. */
+constexpr uint32_t kMaxBacklogFrames = 2;
+
 struct AudioHalStats {
   size_t media_read_total_underflow_bytes;
   size_t media_read_total_underflow_count;
   uint64_t media_read_last_underflow_us;
+  size_t media_read_catch_up_count;
 
   AudioHalStats() { Reset(); }
 
@@ -75,41 +82,76 @@ struct AudioHalStats {
     media_read_total_underflow_bytes = 0;
     media_read_total_underflow_count = 0;
     media_read_last_underflow_us = 0;
+    media_read_catch_up_count = 0;
   }
 };
 
 AudioHalStats stats;
 
+/* The frame being filled from the audio HAL. It is only sent once complete,
+ * so a tick finding too little data is stretched to the next one instead of
+ * sending a short frame, which follows a producer slower than the tick. */
+std::vector<uint8_t> audio_frame;
+uint32_t audio_frame_fill = 0;
+
 bool hearing_aid_on_resume_req(bool start_media_task);
 bool hearing_aid_on_suspend_req();
 
+uint32_t read_audio_data(uint8_t* p_buf, uint32_t len) {
+  if (bluetooth::audio::hearing_aid::is_hal_2_0_enabled()) {
+    return bluetooth::audio::hearing_aid::read(p_buf, len);
+  }
+  uint16_t event;
+  return UIPC_Read(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
+}
+
+/* Bytes the audio HAL has queued, or 0 when the transport can't tell */
+uint32_t audio_data_backlog() {
+  uint32_t readable = 0;
+  if (!bluetooth::audio::hearing_aid::is_hal_2_0_enabled()) {
+    UIPC_Ioctl(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_READABLE,
+               &readable);
+  }
+  return readable;
+}
+
+/* Tops up the current frame and sends it once complete */
+bool send_audio_frame(uint32_t bytes_per_tick) {
+  uint32_t bytes_read = read_audio_data(audio_frame.data() + audio_frame_fill,
+                                        bytes_per_tick - audio_frame_fill);
+  VLOG(2) << "bytes_read: " << bytes_read;
+  audio_frame_fill += bytes_read;
+  if (audio_frame_fill < bytes_per_tick) return false;
+
+  audio_frame_fill = 0;
+  if (localAudioReceiver != nullptr) {
+    localAudioReceiver->OnAudioDataReady(audio_frame);
+  }
+  return true;
+}
+
 void send_audio_data() {
   uint32_t bytes_per_tick =
       (num_channels * sample_rate * data_interval_ms * (bit_rate / 8)) / 1000;
 
-  uint16_t event;
-  uint8_t p_buf[bytes_per_tick];
-
-  uint32_t bytes_read;
-  if (bluetooth::audio::hearing_aid::is_hal_2_0_enabled()) {
-    bytes_read = bluetooth::audio::hearing_aid::read(p_buf, bytes_per_tick);
-  } else {
-    bytes_read = UIPC_Read(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, &event,
-                           p_buf, bytes_per_tick);
+  if (audio_frame.size() != bytes_per_tick) {
+    audio_frame.assign(bytes_per_tick, 0);
+    audio_frame_fill = 0;
   }
 
-  VLOG(2) << "bytes_read: " << bytes_read;
-  if (bytes_read < bytes_per_tick) {
-    stats.media_read_total_underflow_bytes += bytes_per_tick - bytes_read;
+  if (!send_audio_frame(bytes_per_tick)) {
+    stats.media_read_total_underflow_bytes += bytes_per_tick - audio_frame_fill;
     stats.media_read_total_underflow_count++;
     stats.media_read_last_underflow_us =
         bluetooth::common::time_get_os_boottime_us();
+    return;
   }
 
-  std::vector<uint8_t> data(p_buf, p_buf + bytes_read);
-
-  if (localAudioReceiver != nullptr) {
-    localAudioReceiver->OnAudioDataReady(data);
+  /* The producer runs faster than the tick: send the next frame right away
+   * rather than let the backlog, and the latency, grow. */
+  if (audio_data_backlog() >= kMaxBacklogFrames * bytes_per_tick) {
+    stats.media_read_catch_up_count++;
+    send_audio_frame(bytes_per_tick);
   }
 }
 
@@ -125,7 +167,11 @@ void start_audio_ticks() {
     LOG(FATAL) << " Unsupported data interval: " << data_interval_ms;
   }
 
-  wakelock_acquire();
+  audio_frame_fill = 0;
+  if (!wakelock_held) {
+    wakelock_acquire();
+    wakelock_held = true;
+  }
   audio_timer.SchedulePeriodic(
       get_main_thread()->GetWeakPtr(), FROM_HERE, base::Bind(&send_audio_data),
       base::TimeDelta::FromMilliseconds(data_interval_ms));
@@ -135,7 +181,10 @@ void start_audio_ticks() {
 void stop_audio_ticks() {
   LOG(INFO) << __func__ << ": stopped";
   audio_timer.CancelAndWait();
-  wakelock_release();
+  if (wakelock_held) {
+    wakelock_release();
+    wakelock_held = false;
+  }
 }
 
 void hearing_aid_data_cb(tUIPC_CH_ID, tUIPC_EVENT event) {
@@ -196,7 +245,7 @@ void hearing_aid_recv_ctrl_data() {
         ctrl_ack_status = HEARING_AID_CTRL_ACK_FAILURE;
       } else {
         UIPC_Open(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, hearing_aid_data_cb,
-                  HEARING_AID_DATA_PATH);
+                  HEARING_AID_DATA_PATH, UIPC_CH_TYPE_SHM);
       }
       hearing_aid_send_ack(ctrl_ack_status);
       break;
@@ -445,6 +494,7 @@ void HearingAidAudioSource::DebugDump(int fd) {
                                         stats.media_read_last_underflow_us) /
                        1000
                  : 0)
-         << std::endl;
+         << "\n    Counts (frames sent early to catch up)                  : "
+         << stats.media_read_catch_up_count << std::endl;
   dprintf(fd, "%s", stream.str().c_str());
 }
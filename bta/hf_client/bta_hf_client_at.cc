@@ -21,7 +21,11 @@
 
 #include "bt_trace.h"  // Legacy trace logging
 
+#include <string_view>
+
 #include "bta/hf_client/bta_hf_client_int.h"
+#include "bta/sys/at_lexer.h"
+#include "device/include/interop.h"
 #include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/log.h"
@@ -142,6 +146,15 @@ static void bta_hf_client_queue_at(tBTA_HF_CLIENT_CB* client_cb,
   }
 }
 
+/* Falls back to sending AT commands one at a time to the AG, and to AGs with
+ * addresses alike, after it failed with pipelined commands. */
+static void bta_hf_client_disable_at_pipelining(tBTA_HF_CLIENT_CB* client_cb) {
+  LOG_WARN("%s: AT command pipelining failed, disabling it for %s", __func__,
+           client_cb->peer_addr.ToString().c_str());
+  interop_database_add(INTEROP_HF_CLIENT_DISABLE_AT_PIPELINING,
+                       &client_cb->peer_addr, RawAddress::kLength - 1);
+}
+
 static void bta_hf_client_at_resp_timer_cback(void* data) {
   tBTA_HF_CLIENT_CB* client_cb = (tBTA_HF_CLIENT_CB*)data;
   if (client_cb->at_cb.current_cmd == BTA_HF_CLIENT_AT_CNUM) {
@@ -150,6 +163,9 @@ static void bta_hf_client_at_resp_timer_cback(void* data) {
     bta_hf_client_handle_ok(client_cb);
   } else {
     APPL_TRACE_ERROR("HFPClient: AT response timeout, disconnecting");
+    if (client_cb->at_cb.pipeline_in_use) {
+      bta_hf_client_disable_at_pipelining(client_cb);
+    }
 
     tBTA_HF_CLIENT_DATA msg = {};
     msg.hdr.layer_specific = client_cb->handle;
@@ -166,10 +182,36 @@ static void bta_hf_client_stop_at_resp_timer(tBTA_HF_CLIENT_CB* client_cb) {
   alarm_cancel(client_cb->at_cb.resp_timer);
 }
 
+/* Whether |cmd| can be sent before current_cmd is answered */
+static bool bta_hf_client_can_pipeline_at(tBTA_HF_CLIENT_CB* client_cb,
+                                          tBTA_HF_CLIENT_AT_CMD cmd) {
+  const tBTA_HF_CLIENT_AT_CB& at_cb = client_cb->at_cb;
+  if (!at_cb.pipelining || at_cb.current_cmd == BTA_HF_CLIENT_AT_NONE ||
+      at_cb.num_pipelined == BTA_HF_CLIENT_AT_MAX_PIPELINED ||
+      at_cb.queued_cmd != NULL || alarm_is_scheduled(at_cb.hold_timer)) {
+    return false;
+  }
+  /* Answered with a fake OK, which has to come in order */
+  return service_availability ||
+         (cmd != BTA_HF_CLIENT_AT_CNUM && cmd != BTA_HF_CLIENT_AT_COPS);
+}
+
 static void bta_hf_client_send_at(tBTA_HF_CLIENT_CB* client_cb,
                                   tBTA_HF_CLIENT_AT_CMD cmd, const char* buf,
                                   uint16_t buf_len) {
   APPL_TRACE_DEBUG("%s", __func__);
+  if (bta_hf_client_can_pipeline_at(client_cb, cmd)) {
+    uint16_t len;
+
+    APPL_TRACE_DEBUG("%s: pipelining command %d behind %d", __func__, cmd,
+                     client_cb->at_cb.current_cmd);
+    PORT_WriteData(client_cb->conn_handle, buf, buf_len, &len);
+
+    client_cb->at_cb.pipelined_cmd[client_cb->at_cb.num_pipelined++] = cmd;
+    client_cb->at_cb.pipeline_in_use = true;
+    return;
+  }
+
   if ((client_cb->at_cb.current_cmd == BTA_HF_CLIENT_AT_NONE ||
        !client_cb->svc_conn) &&
       !alarm_is_scheduled(client_cb->at_cb.hold_timer)) {
@@ -214,6 +256,52 @@ static void bta_hf_client_send_queued_at(tBTA_HF_CLIENT_CB* client_cb) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hf_client_at_pipeline
+ *
+ * Description      Starts or stops pipelining the AT commands sent next: they
+ *                  are written to the AG without waiting for the response to
+ *                  the previous ones, which it answers in order. Only used for
+ *                  the commands of the SLC setup and the ones following it,
+ *                  and not with AGs known to mishandle it.
+ *
+ * Returns          true if the commands sent next are pipelined.
+ *
+ ******************************************************************************/
+bool bta_hf_client_at_pipeline(tBTA_HF_CLIENT_CB* client_cb, bool enable) {
+  client_cb->at_cb.pipelining =
+      enable && !interop_match_addr(INTEROP_HF_CLIENT_DISABLE_AT_PIPELINING,
+                                    &client_cb->peer_addr);
+  return client_cb->at_cb.pipelining;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hf_client_at_cmd_done
+ *
+ * Description      Moves on to the next pipelined command once current_cmd
+ *                  is answered.
+ *
+ * Returns          true if a pipelined command now awaits its response.
+ *
+ ******************************************************************************/
+bool bta_hf_client_at_cmd_done(tBTA_HF_CLIENT_CB* client_cb) {
+  tBTA_HF_CLIENT_AT_CB* at_cb = &client_cb->at_cb;
+  if (at_cb->num_pipelined == 0) {
+    at_cb->current_cmd = BTA_HF_CLIENT_AT_NONE;
+    at_cb->pipeline_in_use = false;
+    return false;
+  }
+
+  at_cb->current_cmd = at_cb->pipelined_cmd[0];
+  at_cb->num_pipelined--;
+  memmove(&at_cb->pipelined_cmd[0], &at_cb->pipelined_cmd[1],
+          at_cb->num_pipelined * sizeof(at_cb->pipelined_cmd[0]));
+  bta_hf_client_start_at_resp_timer(client_cb);
+  return true;
+}
+
 static void bta_hf_client_at_hold_timer_cback(void* data) {
   tBTA_HF_CLIENT_CB* client_cb = (tBTA_HF_CLIENT_CB*)data;
   APPL_TRACE_DEBUG("%s", __func__);
@@ -272,9 +360,9 @@ static void bta_hf_client_handle_ok(tBTA_HF_CLIENT_CB* client_cb) {
       break;
   }
 
-  client_cb->at_cb.current_cmd = BTA_HF_CLIENT_AT_NONE;
-
-  bta_hf_client_send_queued_at(client_cb);
+  if (!bta_hf_client_at_cmd_done(client_cb)) {
+    bta_hf_client_send_queued_at(client_cb);
+  }
 }
 
 static void bta_hf_client_handle_error(tBTA_HF_CLIENT_CB* client_cb,
@@ -285,6 +373,9 @@ static void bta_hf_client_handle_error(tBTA_HF_CLIENT_CB* client_cb,
   bta_hf_client_stop_at_resp_timer(client_cb);
 
   if (!client_cb->svc_conn) {
+    if (client_cb->at_cb.pipeline_in_use) {
+      bta_hf_client_disable_at_pipelining(client_cb);
+    }
     bta_hf_client_slc_seq(client_cb, true);
     return;
   }
@@ -308,9 +399,9 @@ static void bta_hf_client_handle_error(tBTA_HF_CLIENT_CB* client_cb,
       break;
   }
 
-  client_cb->at_cb.current_cmd = BTA_HF_CLIENT_AT_NONE;
-
-  bta_hf_client_send_queued_at(client_cb);
+  if (!bta_hf_client_at_cmd_done(client_cb)) {
+    bta_hf_client_send_queued_at(client_cb);
+  }
 }
 
 static void bta_hf_client_handle_ring(tBTA_HF_CLIENT_CB* client_cb) {
@@ -1551,26 +1642,49 @@ static char* bta_hf_client_process_unknown(tBTA_HF_CLIENT_CB* client_cb,
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(tBTA_HF_CLIENT_CB*, char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] = {
-    bta_hf_client_parse_ok,        bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,      bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,      bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,      bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,      bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,       bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,       bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,      bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,      bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,      bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,      bta_hf_client_parse_btrh,
-    bta_hf_client_parse_bind,      bta_hf_client_parse_busy,
-    bta_hf_client_parse_delayed,   bta_hf_client_parse_no_carrier,
-    bta_hf_client_parse_no_answer, bta_hf_client_parse_rejectlisted,
-    bta_hf_client_process_unknown};
-
-/* calculate supported event list length */
-static const uint16_t bta_hf_client_parser_cb_count =
-    sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+/* AT event or reply, and the parser handling it */
+typedef struct {
+  const char* p_prefix;
+  tBTA_HF_CLIENT_PARSER_CALLBACK p_parser;
+} tBTA_HF_CLIENT_PARSER;
+
+static constexpr tBTA_HF_CLIENT_PARSER bta_hf_client_parsers[] = {
+    {"\r\nOK", bta_hf_client_parse_ok},
+    {"\r\nERROR", bta_hf_client_parse_error},
+    {"\r\nRING", bta_hf_client_parse_ring},
+    {"\r\n+BRSF:", bta_hf_client_parse_brsf},
+    {"\r\n+CIND:", bta_hf_client_parse_cind},
+    {"\r\n+CIEV:", bta_hf_client_parse_ciev},
+    {"\r\n+CHLD:", bta_hf_client_parse_chld},
+    {"\r\n+BCS:", bta_hf_client_parse_bcs},
+    {"\r\n+BSIR:", bta_hf_client_parse_bsir},
+    {"\r\n+CME ERROR:", bta_hf_client_parse_cmeerror},
+    {"\r\n+VGM:", bta_hf_client_parse_vgm},
+    {"\r\n+VGM=", bta_hf_client_parse_vgme},
+    {"\r\n+VGS:", bta_hf_client_parse_vgs},
+    {"\r\n+VGS=", bta_hf_client_parse_vgse},
+    {"\r\n+BVRA:", bta_hf_client_parse_bvra},
+    {"\r\n+CLIP:", bta_hf_client_parse_clip},
+    {"\r\n+CCWA:", bta_hf_client_parse_ccwa},
+    {"\r\n+COPS:", bta_hf_client_parse_cops},
+    {"\r\n+BINP:", bta_hf_client_parse_binp},
+    {"\r\n+CLCC:", bta_hf_client_parse_clcc},
+    {"\r\n+CNUM:", bta_hf_client_parse_cnum},
+    {"\r\n+BTRH:", bta_hf_client_parse_btrh},
+    {"\r\n+BIND:", bta_hf_client_parse_bind},
+    {"\r\nBUSY", bta_hf_client_parse_busy},
+    {"\r\nDELAYED", bta_hf_client_parse_delayed},
+    {"\r\nNO CARRIER", bta_hf_client_parse_no_carrier},
+    {"\r\nNO ANSWER", bta_hf_client_parse_no_answer},
+    {"\r\nREJECTLISTED", bta_hf_client_parse_rejectlisted},
+};
+
+/* No prefix is a prefix of another, so an event matches at most one parser */
+static constexpr AtCommandTrie bta_hf_client_parser_trie(
+    bta_hf_client_parsers, &tBTA_HF_CLIENT_PARSER::p_prefix);
+static_assert(!bta_hf_client_parser_trie.IsFull() &&
+                  !bta_hf_client_parser_trie.HasNestedCommands(),
+              "AT events must be matched by a single parser");
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(tBTA_HF_CLIENT_CB* client_cb) {
@@ -1609,24 +1723,22 @@ static void bta_hf_client_at_parse_start(tBTA_HF_CLIENT_CB* client_cb) {
   bta_hf_client_dump_at(client_cb);
 #endif
 
+  const char* end = buf + strlen(buf);
   while (*buf != '\0') {
-    int i;
-    char* tmp = NULL;
-
-    for (i = 0; i < bta_hf_client_parser_cb_count; i++) {
-      tmp = bta_hf_client_parser_cb[i](client_cb, buf);
-      if (tmp == NULL) {
-        APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
-        tmp = bta_hf_client_skip_unknown(client_cb, buf);
-        break;
-      }
+    char* tmp = buf;
 
-      /* matched or unknown skipped, if unknown failed tmp is NULL so
-         this is also handled */
-      if (tmp != buf) {
-        buf = tmp;
-        break;
-      }
+    AtMatch match = bta_hf_client_parser_trie.Match(
+        std::string_view(buf, end - buf), false /* ignore_case */);
+    if (match.found()) {
+      tmp = bta_hf_client_parsers[match.index].p_parser(client_cb, buf);
+    }
+    /* not matched, or matched but not in the expected format */
+    if (tmp == buf) {
+      tmp = bta_hf_client_process_unknown(client_cb, buf);
+    }
+    if (tmp == NULL) {
+      APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
+      tmp = bta_hf_client_skip_unknown(client_cb, buf);
     }
 
     /* could not skip unknown (received garbage?)... disconnect */
@@ -2192,6 +2304,9 @@ void bta_hf_client_at_reset(tBTA_HF_CLIENT_CB* client_cb) {
   }
 
   client_cb->at_cb.current_cmd = BTA_HF_CLIENT_AT_NONE;
+  client_cb->at_cb.num_pipelined = 0;
+  client_cb->at_cb.pipelining = false;
+  client_cb->at_cb.pipeline_in_use = false;
 }
 
 void bta_hf_client_send_at_cmd(tBTA_HF_CLIENT_DATA* p_data) {
@@ -41,6 +41,9 @@ struct queued_at_cmd {
 };
 typedef struct queued_at_cmd tBTA_HF_CLIENT_AT_QCMD;
 
+/* Maximum number of AT commands sent ahead of the response to current_cmd */
+#define BTA_HF_CLIENT_AT_MAX_PIPELINED 8
+
 /* Maximum number of indicators */
 #define BTA_HF_CLIENT_AT_INDICATOR_COUNT 20
 
@@ -50,6 +53,13 @@ typedef struct {
            1]; /* extra byte to always have \0 at the end */
   unsigned int offset;
   tBTA_HF_CLIENT_AT_CMD current_cmd;
+  /* Commands sent while current_cmd awaits its response, in sending order.
+     The AG answers them in that order once current_cmd is answered. */
+  tBTA_HF_CLIENT_AT_CMD pipelined_cmd[BTA_HF_CLIENT_AT_MAX_PIPELINED];
+  uint8_t num_pipelined;
+  bool pipelining;      /* set while sending commands that may be pipelined */
+  bool pipeline_in_use; /* set until all the pipelined commands are answered */
+  uint64_t slc_start_ms; /* time AT+BRSF was sent, for logging */
   tBTA_HF_CLIENT_AT_QCMD* queued_cmd;
   alarm_t* resp_timer; /* AT response timer */
   alarm_t* hold_timer; /* AT hold timer */
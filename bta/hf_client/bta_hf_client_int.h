@@ -314,6 +314,8 @@ extern void bta_hf_client_send_at_bia(tBTA_HF_CLIENT_CB* client_cb);
 /* AT API Functions */
 void bta_hf_client_at_init(tBTA_HF_CLIENT_CB* client_cb);
 void bta_hf_client_at_reset(tBTA_HF_CLIENT_CB* client_cb);
+bool bta_hf_client_at_pipeline(tBTA_HF_CLIENT_CB* client_cb, bool enable);
+bool bta_hf_client_at_cmd_done(tBTA_HF_CLIENT_CB* client_cb);
 extern void bta_hf_client_ind(tBTA_HF_CLIENT_CB* client_cb,
                               tBTA_HF_CLIENT_IND_TYPE type, uint16_t value);
 extern void bta_hf_client_evt_val(tBTA_HF_CLIENT_CB* client_cb,
@@ -22,7 +22,9 @@
 
 #include "bta/hf_client/bta_hf_client_int.h"
 #include "bta/include/utl.h"
+#include "common/time_util.h"
 #include "osi/include/allocator.h"
+#include "osi/include/log.h"
 #include "osi/include/osi.h"  // UNUSED_ATTR
 #include "stack/include/btm_api.h"
 
@@ -763,17 +765,55 @@ void bta_hf_client_sm_execute(uint16_t event, tBTA_HF_CLIENT_DATA* p_data) {
 }
 
 static void send_post_slc_cmd(tBTA_HF_CLIENT_CB* client_cb) {
+  LOG_INFO("%s: SLC established in %llu ms", __func__,
+           static_cast<unsigned long long>(
+               bluetooth::common::time_get_os_boottime_ms() -
+               client_cb->at_cb.slc_start_ms));
   client_cb->at_cb.current_cmd = BTA_HF_CLIENT_AT_NONE;
 
   tBTA_HF_CLIENT_DATA p_data;
   p_data.hdr.layer_specific = client_cb->handle;
   bta_hf_client_sco_listen(&p_data);
+  bta_hf_client_at_pipeline(client_cb, true);
   bta_hf_client_send_at_bia(client_cb);
   bta_hf_client_send_at_ccwa(client_cb, true);
   bta_hf_client_send_at_cmee(client_cb, true);
   bta_hf_client_send_at_cops(client_cb, false);
   bta_hf_client_send_at_btrh(client_cb, true, 0);
   bta_hf_client_send_at_clip(client_cb, true);
+  bta_hf_client_at_pipeline(client_cb, false);
+}
+
+static void open_slc(tBTA_HF_CLIENT_CB* client_cb) {
+  tBTA_HF_CLIENT_DATA msg;
+  msg.hdr.layer_specific = client_cb->handle;
+  bta_hf_client_svc_conn_open(&msg);
+  send_post_slc_cmd(client_cb);
+}
+
+/* Sends the SLC setup commands following AT+BRSF at once, instead of waiting
+ * for the response to each of them before sending the next one. The AG answers
+ * them in order. */
+static void send_pipelined_slc_cmd(tBTA_HF_CLIENT_CB* client_cb) {
+  client_cb->at_cb.current_cmd = BTA_HF_CLIENT_AT_NONE;
+
+  if ((bta_hf_client_cb_arr.features & BTA_HF_CLIENT_FEAT_CODEC) &&
+      (client_cb->peer_features & BTA_HF_CLIENT_PEER_CODEC)) {
+    bta_hf_client_send_at_bac(client_cb);
+  }
+  bta_hf_client_send_at_cind(client_cb, false);
+  bta_hf_client_send_at_cind(client_cb, true);
+  bta_hf_client_send_at_cmer(client_cb, true);
+  if (client_cb->peer_features & BTA_HF_CLIENT_PEER_FEAT_3WAY &&
+      bta_hf_client_cb_arr.features & BTA_HF_CLIENT_FEAT_3WAY) {
+    bta_hf_client_send_at_chld(client_cb, '?', 0);
+  }
+  if (bta_hf_client_cb_arr.features & BTA_HF_CLIENT_FEAT_HF_IND &&
+      client_cb->peer_features & BTA_HF_CLIENT_PEER_HF_IND) {
+    bta_hf_client_send_at_bind(client_cb, 0);
+    bta_hf_client_send_at_bind(client_cb, 1);
+    bta_hf_client_send_at_bind(client_cb, 2);
+  }
 }
 
 /*******************************************************************************
@@ -808,12 +848,28 @@ void bta_hf_client_slc_seq(tBTA_HF_CLIENT_CB* client_cb, bool error) {
     return;
   }
 
+  if (client_cb->at_cb.pipeline_in_use) {
+    /* Once the last pipelined command is answered */
+    if (!bta_hf_client_at_cmd_done(client_cb)) {
+      open_slc(client_cb);
+    }
+    return;
+  }
+
   switch (client_cb->at_cb.current_cmd) {
     case BTA_HF_CLIENT_AT_NONE:
+      client_cb->at_cb.slc_start_ms =
+          bluetooth::common::time_get_os_boottime_ms();
       bta_hf_client_send_at_brsf(client_cb, bta_hf_client_cb_arr.features);
       break;
 
     case BTA_HF_CLIENT_AT_BRSF:
+      if (bta_hf_client_at_pipeline(client_cb, true)) {
+        send_pipelined_slc_cmd(client_cb);
+        bta_hf_client_at_pipeline(client_cb, false);
+        break;
+      }
+
       if ((bta_hf_client_cb_arr.features & BTA_HF_CLIENT_FEAT_CODEC) &&
           (client_cb->peer_features & BTA_HF_CLIENT_PEER_CODEC)) {
         bta_hf_client_send_at_bac(client_cb);
@@ -843,10 +899,7 @@ void bta_hf_client_slc_seq(tBTA_HF_CLIENT_CB* client_cb, bool error) {
                  client_cb->peer_features & BTA_HF_CLIENT_PEER_HF_IND) {
         bta_hf_client_send_at_bind(client_cb, 0);
       } else {
-        tBTA_HF_CLIENT_DATA msg;
-        msg.hdr.layer_specific = client_cb->handle;
-        bta_hf_client_svc_conn_open(&msg);
-        send_post_slc_cmd(client_cb);
+        open_slc(client_cb);
       }
       break;
 
@@ -855,10 +908,7 @@ void bta_hf_client_slc_seq(tBTA_HF_CLIENT_CB* client_cb, bool error) {
           client_cb->peer_features & BTA_HF_CLIENT_PEER_HF_IND) {
         bta_hf_client_send_at_bind(client_cb, 0);
       } else {
-        tBTA_HF_CLIENT_DATA msg;
-        msg.hdr.layer_specific = client_cb->handle;
-        bta_hf_client_svc_conn_open(&msg);
-        send_post_slc_cmd(client_cb);
+        open_slc(client_cb);
       }
       break;
 
@@ -871,10 +921,7 @@ void bta_hf_client_slc_seq(tBTA_HF_CLIENT_CB* client_cb, bool error) {
       break;
 
     case BTA_HF_CLIENT_AT_BIND_READ_ENABLED_IND:
-      tBTA_HF_CLIENT_DATA msg;
-      msg.hdr.layer_specific = client_cb->handle;
-      bta_hf_client_svc_conn_open(&msg);
-      send_post_slc_cmd(client_cb);
+      open_slc(client_cb);
       break;
 
     default: {
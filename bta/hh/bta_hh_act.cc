@@ -1091,6 +1091,33 @@ void bta_hh_write_dev_act(tBTA_HH_DEV_CB* p_cb, const tBTA_HH_DATA* p_data) {
 /*****************************************************************************
  *  Static Function
  ****************************************************************************/
+/*******************************************************************************
+ *
+ * Function         bta_hh_intr_data_fast_path
+ *
+ * Description      Input reports of a connected device are written to uhid
+ *                  right away, from the L2CAP data callback, rather than
+ *                  being posted to BTA as a BTA_HH_INT_DATA_EVT first. The
+ *                  message path is kept while earlier reports of the device
+ *                  are still queued there.
+ *
+ * Returns          true if the report was consumed.
+ *
+ ******************************************************************************/
+static bool bta_hh_intr_data_fast_path(uint8_t dev_handle, BT_HDR* pdata) {
+  uint8_t index = bta_hh_dev_handle_to_cb_idx(dev_handle);
+  if (index >= BTA_HH_MAX_DEVICE) return false;
+  tBTA_HH_DEV_CB* p_cb = &bta_hh_cb.kdev[index];
+  if (p_cb->state != BTA_HH_CONN_ST) return false;
+  /* Reports queued before the connection completed go first */
+  if (p_cb->int_data_pending > 0) return false;
+
+  bta_hh_co_input(dev_handle, 0, (uint8_t*)(pdata + 1) + pdata->offset,
+                  pdata->len);
+  osi_free(pdata);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_cback
@@ -1116,9 +1143,12 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
     case HID_HDEV_EVT_CLOSE:
       sm_event = BTA_HH_INT_CLOSE_EVT;
       break;
-    case HID_HDEV_EVT_INTR_DATA:
+    case HID_HDEV_EVT_INTR_DATA: {
+      if (bta_hh_intr_data_fast_path(dev_handle, pdata)) return;
       sm_event = BTA_HH_INT_DATA_EVT;
-      break;
+      uint8_t index = bta_hh_dev_handle_to_cb_idx(dev_handle);
+      if (index < BTA_HH_MAX_DEVICE) bta_hh_cb.kdev[index].int_data_pending++;
+    } break;
     case HID_HDEV_EVT_HANDSHAKE:
       sm_event = BTA_HH_INT_HANDSK_EVT;
       break;
@@ -175,6 +175,12 @@ typedef struct {
 
 } tBTA_HH_LE_HID_SRVC;
 
+/* Input report notified by an LE HID device, looked up by value handle */
+typedef struct {
+  uint16_t handle; /* value handle of the report characteristic */
+  uint8_t rpt_idx; /* index of the report in hid_srvc.report */
+} tBTA_HH_LE_INPUT_NOTIF;
+
 /* convert a HID handle to the LE CB index */
 #define BTA_HH_GET_LE_CB_IDX(x) (((x) >> 4) - 1)
 /* convert a GATT connection ID to HID device handle, it is the hi 4 bits of a
@@ -224,6 +230,15 @@ typedef struct {
 #define BTA_HH_LE_SCPS_NOTIFY_ENB 0x02
   uint8_t scps_notify; /* scan refresh supported/notification enabled */
   bool security_pending;
+
+  /* Input reports, set when registering for their notifications, so that
+   * notifications skip the lookup of the GATT database */
+  tBTA_HH_LE_INPUT_NOTIF input_notif[BTA_HH_LE_RPT_MAX];
+  uint8_t num_input_notif;
+
+  /* BTA_HH_INT_DATA_EVT posted and not handled yet. Input reports only skip
+   * the BTA queue when it holds none, so that they stay in order */
+  uint16_t int_data_pending;
 } tBTA_HH_DEV_CB;
 
 /******************************************************************************
@@ -521,6 +521,53 @@ static void bta_hh_le_save_report_ref(tBTA_HH_DEV_CB* p_dev_cb,
     p_rpt = NULL;
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_set_input_notif
+ *
+ * Description      Record the value handles of the input reports, which the
+ *                  notifications are looked up by.
+ *
+ ******************************************************************************/
+static void bta_hh_le_set_input_notif(tBTA_HH_DEV_CB* p_dev_cb) {
+  const tBTA_HH_LE_RPT* p_rpt = &p_dev_cb->hid_srvc.report[0];
+
+  p_dev_cb->num_input_notif = 0;
+  for (uint8_t i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
+    if (!p_rpt->in_use || p_rpt->rpt_type != BTA_HH_RPTT_INPUT) continue;
+    tBTA_HH_LE_INPUT_NOTIF* p_notif =
+        &p_dev_cb->input_notif[p_dev_cb->num_input_notif++];
+    p_notif->handle = p_rpt->char_inst_id;
+    p_notif->rpt_idx = i;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_find_input_notif
+ *
+ * Description      Find the input report notified on value handle |handle|.
+ *
+ * Returns          the report, or NULL if not found or no longer valid.
+ *
+ ******************************************************************************/
+static const tBTA_HH_LE_RPT* bta_hh_le_find_input_notif(
+    const tBTA_HH_DEV_CB* p_dev_cb, uint16_t handle) {
+  for (uint8_t i = 0; i < p_dev_cb->num_input_notif; i++) {
+    const tBTA_HH_LE_INPUT_NOTIF* p_notif = &p_dev_cb->input_notif[i];
+    if (p_notif->handle != handle) continue;
+
+    /* The report table may have changed since, on rediscovery */
+    const tBTA_HH_LE_RPT* p_rpt = &p_dev_cb->hid_srvc.report[p_notif->rpt_idx];
+    if (p_rpt->in_use && p_rpt->rpt_type == BTA_HH_RPTT_INPUT &&
+        p_rpt->char_inst_id == handle) {
+      return p_rpt;
+    }
+    return NULL;
+  }
+  return NULL;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_le_register_input_notif
@@ -539,6 +586,8 @@ static void bta_hh_le_register_input_notif(tBTA_HH_DEV_CB* p_dev_cb,
   APPL_TRACE_DEBUG("%s: bta_hh_le_register_input_notif mode: %d", __func__,
                    proto_mode);
 
+  bta_hh_le_set_input_notif(p_dev_cb);
+
   for (int i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
     if (p_rpt->rpt_type == BTA_HH_RPTT_INPUT) {
       if (register_ba && p_rpt->uuid == GATT_UUID_BATTERY_LEVEL) {
@@ -594,6 +643,8 @@ static void bta_hh_le_register_input_notif(tBTA_HH_DEV_CB* p_dev_cb,
 static void bta_hh_le_deregister_input_notif(tBTA_HH_DEV_CB* p_dev_cb) {
   tBTA_HH_LE_RPT* p_rpt = &p_dev_cb->hid_srvc.report[0];
 
+  p_dev_cb->num_input_notif = 0;
+
   for (uint8_t i = 0; i < BTA_HH_LE_RPT_MAX; i++, p_rpt++) {
     if (p_rpt->rpt_type == BTA_HH_RPTT_INPUT) {
       if (p_rpt->uuid == GATT_UUID_HID_REPORT &&
@@ -1449,7 +1500,7 @@ static void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
     return;
   }
 
-  const std::list<gatt::Service>* services =
+  const std::vector<gatt::Service>* services =
       BTA_GATTC_GetServices(p_data->conn_id);
 
   bool have_hid = false;
@@ -1521,6 +1572,15 @@ static void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
     return;
   }
 
+  /* Fast path, the report is written out as is, prefixed by its ID */
+  const tBTA_HH_LE_RPT* p_input =
+      bta_hh_le_find_input_notif(p_dev_cb, p_data->handle);
+  if (p_input != NULL) {
+    bta_hh_co_input(p_dev_cb->hid_handle, p_input->rpt_id, p_data->value,
+                    p_data->len);
+    return;
+  }
+
   const gatt::Characteristic* p_char =
       BTA_GATTC_GetCharacteristic(p_dev_cb->conn_id, p_data->handle);
   if (p_char == NULL) {
@@ -349,6 +349,10 @@ bool bta_hh_hdl_event(BT_HDR_RIGID* p_msg) {
         index = bta_hh_dev_handle_to_cb_idx((uint8_t)p_msg->layer_specific);
 
       if (index != BTA_HH_IDX_INVALID) p_cb = &bta_hh_cb.kdev[index];
+      if (p_cb != NULL && p_msg->event == BTA_HH_INT_DATA_EVT &&
+          p_cb->int_data_pending > 0) {
+        p_cb->int_data_pending--;
+      }
 
       APPL_TRACE_DEBUG("bta_hh_hdl_event:: handle = %d dev_cb[%d] ",
                        p_msg->layer_specific, index);
@@ -1167,6 +1167,20 @@ extern void BTA_DmBleRequestMaxTxDataLength(const RawAddress& remote_device);
  ******************************************************************************/
 extern void BTA_DmBleGetEnergyInfo(tBTA_BLE_ENERGY_INFO_CBACK* p_cmpl_cback);
 
+/*******************************************************************************
+ *
+ * Function         BTA_DmPmDumpStatistics
+ *
+ * Description      Dump the power mode decisions taken from the traffic of
+ *                  the connected links, and how often they were right
+ *
+ * Parameters       fd - file descriptor to dump to
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTA_DmPmDumpStatistics(int fd);
+
 /*******************************************************************************
  *
  * Function         BTA_BrcmInit
@@ -26,7 +26,6 @@
 #define BTA_GATT_API_H
 
 #include <base/callback_forward.h>
-#include <list>
 #include <string>
 #include <vector>
 
@@ -520,7 +519,8 @@ extern void BTA_GATTC_DiscoverServiceByUuid(uint16_t conn_id,
  * Returns          returns list of gatt::Service or NULL.
  *
  ******************************************************************************/
-extern const std::list<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id);
+extern const std::vector<gatt::Service>* BTA_GATTC_GetServices(
+    uint16_t conn_id);
 
 /*******************************************************************************
  *
@@ -587,6 +587,19 @@ typedef void (*GATT_WRITE_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
                                  uint16_t handle, void* data);
 typedef void (*GATT_CONFIGURE_MTU_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
                                          void* data);
+/* |value| holds the values of |handles| as the server sent them, see
+ * BTA_GATTC_ReadMultiple */
+typedef void (*GATT_READ_MULTI_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
+                                      tBTA_GATTC_MULTI& handles, uint16_t len,
+                                      uint8_t* value, void* data);
+typedef void (*GATT_EXECUTE_WRITE_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
+                                         void* data);
+/* |sent| of the |total| octets of a stream were handed to L2CAP. The stream
+ * is over once |status| is not GATT_SUCCESS or |sent| equals |total|, see
+ * BTA_GATTC_WriteCharStream */
+typedef void (*GATT_WRITE_STREAM_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
+                                        uint16_t handle, uint32_t sent,
+                                        uint32_t total, void* data);
 
 /*******************************************************************************
  *
@@ -649,6 +662,31 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
                               tGATT_AUTH_REQ auth_req,
                               GATT_WRITE_OP_CB callback, void* cb_data);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_WriteCharStream
+ *
+ * Description      This function is called to write a stream of data to a
+ *                  characteristic with Write Commands. The stream is cut in
+ *                  segments as large as the ATT MTU allows, which are sent as
+ *                  fast as L2CAP takes them and paused while the link is
+ *                  congested.
+ *
+ * Parameters       conn_id - connection ID.
+ *                  handle - characteristic handle to write.
+ *                  value - the data to be written.
+ *                  callback - called with the progress of the stream, and
+ *                             once more when it is over.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTC_WriteCharStream(uint16_t conn_id, uint16_t handle,
+                               std::vector<uint8_t> value,
+                               tGATT_AUTH_REQ auth_req,
+                               GATT_WRITE_STREAM_OP_CB callback,
+                               void* cb_data);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_WriteCharDescr
@@ -749,6 +787,9 @@ extern void BTA_GATTC_PrepareWrite(uint16_t conn_id, uint16_t handle,
  *
  ******************************************************************************/
 extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
+extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute,
+                                   GATT_EXECUTE_WRITE_OP_CB callback,
+                                   void* cb_data);
 
 /*******************************************************************************
  *
@@ -759,6 +800,10 @@ extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
  *
  * Parameters       conn_id - connectino ID.
  *                    p_read_multi - read multiple parameters.
+ *                    variable_len - use Read Multiple Variable Length, whose
+ *                                   response is a list of 2 byte length and
+ *                                   value pairs instead of the bare values.
+ *                    callback - called with the raw response.
  *
  * Returns          None
  *
@@ -766,6 +811,11 @@ extern void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
 extern void BTA_GATTC_ReadMultiple(uint16_t conn_id,
                                    tBTA_GATTC_MULTI* p_read_multi,
                                    tGATT_AUTH_REQ auth_req);
+extern void BTA_GATTC_ReadMultiple(uint16_t conn_id,
+                                   tBTA_GATTC_MULTI* p_read_multi,
+                                   bool variable_len, tGATT_AUTH_REQ auth_req,
+                                   GATT_READ_MULTI_OP_CB callback,
+                                   void* cb_data);
 
 /*******************************************************************************
  *
@@ -929,6 +979,27 @@ extern void BTA_GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_id,
                                             std::vector<uint8_t> value,
                                             bool need_confirm);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTS_SetAttributeCache
+ *
+ * Description      This function is called to let the stack answer reads of
+ *                  a characteristic or descriptor, instead of sending
+ *                  BTA_GATTS_READ_CHARACTERISTIC_EVT or
+ *                  BTA_GATTS_READ_DESCRIPTOR_EVT.
+ *
+ * Parameters       attr_id - attribute ID of the cached value.
+ *                  value - value of the attribute, empty to stop caching it.
+ *                  ttl_ms - how long the value stays valid, 0 if it never
+ *                           changes.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+extern void BTA_GATTS_SetAttributeCache(uint16_t attr_id,
+                                        std::vector<uint8_t> value,
+                                        uint64_t ttl_ms);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTS_SendRsp
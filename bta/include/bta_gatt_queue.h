@@ -18,10 +18,27 @@
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "bta/include/bta_gatt_api.h"
 
+/* Value of one handle read by BtaGattQueue::ReadMultiple */
+struct gatt_read_result {
+  uint16_t handle;
+  tGATT_STATUS status;
+  std::vector<uint8_t> value;
+};
+
+/* |status| is GATT_SUCCESS if every handle was read, otherwise the status of
+ * the first handle that failed */
+typedef void (*GATT_READ_BATCH_OP_CB)(
+    uint16_t conn_id, tGATT_STATUS status,
+    const std::vector<gatt_read_result>& results, void* data);
+/* |handle| is the handle whose write failed, or 0 */
+typedef void (*GATT_WRITE_BATCH_OP_CB)(uint16_t conn_id, tGATT_STATUS status,
+                                       uint16_t handle, void* data);
+
 /* BTA GATTC implementation does not allow for multiple commands queuing. So one
  * client making calls to BTA_GATTC_ReadCharacteristic, BTA_GATTC_ReadCharDescr,
  * BTA_GATTC_WriteCharValue, BTA_GATTC_WriteCharDescr must wait for the callacks
@@ -50,6 +67,24 @@ class BtaGattQueue {
                               void* cb_data);
   static void ConfigureMtu(uint16_t conn_id, uint16_t mtu);
 
+  /* Read the values of |handles| in as few requests as possible: Read
+   * Multiple Variable Length requests of up to GATT_MAX_READ_MULTI_HANDLES
+   * handles each, and single reads for values that did not fit in the MTU or
+   * when the server rejects the request. |cb| gets all the results at once,
+   * in the order of |handles|. */
+  static void ReadMultiple(uint16_t conn_id,
+                           const std::vector<uint16_t>& handles,
+                           GATT_READ_BATCH_OP_CB cb, void* cb_data);
+
+  /* Write |values|, pairs of handle and value, as one reliable write: every
+   * value is queued with prepare writes and the server applies them with one
+   * execute write, or none at all if any prepare write fails. A single value
+   * is written with a plain write request. */
+  static void WriteMultiple(
+      uint16_t conn_id,
+      std::vector<std::pair<uint16_t, std::vector<uint8_t>>> values,
+      GATT_WRITE_BATCH_OP_CB cb, void* cb_data);
+
   /* Holds pending GATT operations */
   struct gatt_operation {
     uint8_t type;
@@ -64,6 +99,12 @@ class BtaGattQueue {
     /* write-specific fields */
     tGATT_WRITE_TYPE write_type;
     std::vector<uint8_t> value;
+
+    /* batch-specific fields */
+    std::vector<uint16_t> handles;
+    GATT_READ_MULTI_OP_CB read_multi_cb;
+    GATT_EXECUTE_WRITE_OP_CB exec_cb;
+    bool is_execute;
   };
 
  private:
@@ -76,6 +117,24 @@ class BtaGattQueue {
                                      uint16_t handle, void* data);
   static void gatt_configure_mtu_op_finished(uint16_t conn_id,
                                              tGATT_STATUS status, void* data);
+  static bool gatt_read_batch_op(void* batch, gatt_operation* op);
+  static void gatt_read_batch_continue(uint16_t conn_id, void* batch);
+  static void gatt_read_batch_single_finished(uint16_t conn_id,
+                                              tGATT_STATUS status,
+                                              uint16_t handle, uint16_t len,
+                                              uint8_t* value, void* data);
+  static void gatt_read_batch_multi_finished(uint16_t conn_id,
+                                             tGATT_STATUS status,
+                                             tBTA_GATTC_MULTI& handles,
+                                             uint16_t len, uint8_t* value,
+                                             void* data);
+  static bool gatt_write_batch_op(void* batch, gatt_operation* op);
+  static void gatt_write_batch_continue(uint16_t conn_id, void* batch);
+  static void gatt_write_batch_write_finished(uint16_t conn_id,
+                                              tGATT_STATUS status,
+                                              uint16_t handle, void* data);
+  static void gatt_write_batch_exec_finished(uint16_t conn_id,
+                                             tGATT_STATUS status, void* data);
 
   // maps connection id to operations waiting for execution
   static std::unordered_map<uint16_t, std::list<gatt_operation>> gatt_op_queue;
@@ -53,6 +53,21 @@ extern void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
                            uint8_t ctry_code, const RawAddress& peer_addr,
                            uint8_t app_id);
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_input
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report is notified by an LE device, or received on the
+ *                  interrupt channel of a connected classic device. The
+ *                  report is prefixed by |rpt_id| unless it is 0.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+extern void bta_hh_co_input(uint8_t dev_handle, uint8_t rpt_id,
+                            const uint8_t* p_rpt, uint16_t len);
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_open
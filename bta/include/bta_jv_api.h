@@ -26,6 +26,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "bt_target.h"  // Must be first to define build configuration
 
@@ -586,6 +587,25 @@ tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size);
 tBTA_JV_STATUS BTA_JvL2capWrite(uint32_t handle, uint32_t req_id, BT_HDR* msg,
                                 uint32_t user_id);
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capWriteBatch
+ *
+ * Description      This function writes several SDUs to an L2CAP connection
+ *                  in a single main thread task. When all of them have been
+ *                  handed to L2CAP, tBTA_JV_L2CAP_CBACK is called once with
+ *                  BTA_JV_L2CAP_WRITE_EVT, carrying the total length and the
+ *                  req_id. Takes ownership of the buffers. The total length
+ *                  must fit in tBTA_JV_L2CAP_WRITE.len.
+ *
+ * Returns          BTA_JV_SUCCESS, if the request is being processed.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capWriteBatch(uint32_t handle, uint32_t req_id,
+                                     std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id);
+
 /*******************************************************************************
  *
  * Function         BTA_JvRfcommConnect
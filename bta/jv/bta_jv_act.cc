@@ -1156,6 +1156,45 @@ void bta_jv_l2cap_write(uint32_t handle, uint32_t req_id, BT_HDR* msg,
   p_cb->p_cback(BTA_JV_L2CAP_WRITE_EVT, &bta_jv, user_id);
 }
 
+/* Write SDUs read back to back from a socket to an L2CAP connection. They are
+ * handed to GAP in order, and a single write event reports them all, so the
+ * socket is polled again once per batch instead of once per SDU. */
+void bta_jv_l2cap_write_batch(uint32_t handle, uint32_t req_id,
+                              std::vector<BT_HDR*> msgs, uint32_t user_id,
+                              tBTA_JV_L2C_CB* p_cb) {
+  /* See bta_jv_l2cap_write() for why the callback may be gone by now */
+  if (!p_cb->p_cback) {
+    LOG(ERROR) << __func__ << ": p_cb->p_cback == NULL";
+    for (BT_HDR* msg : msgs) osi_free(msg);
+    return;
+  }
+
+  tBTA_JV_L2CAP_WRITE evt_data;
+  evt_data.status = BTA_JV_SUCCESS;
+  evt_data.handle = handle;
+  evt_data.req_id = req_id;
+  evt_data.cong = p_cb->cong;
+  evt_data.len = 0;
+
+  bta_jv_pm_conn_busy(p_cb->p_pm_cb);
+
+  for (BT_HDR* msg : msgs) {
+    evt_data.len += msg->len;
+    msg->event = BT_EVT_TO_BTU_SP_DATA;
+
+    if (evt_data.status != BTA_JV_SUCCESS || evt_data.cong) {
+      evt_data.status = BTA_JV_FAILURE;
+      osi_free(msg);
+    } else if (GAP_ConnWriteData(handle, msg) != BT_PASS) {
+      evt_data.status = BTA_JV_FAILURE;
+    }
+  }
+
+  tBTA_JV bta_jv;
+  bta_jv.l2c_write = evt_data;
+  p_cb->p_cback(BTA_JV_L2CAP_WRITE_EVT, &bta_jv, user_id);
+}
+
 /*******************************************************************************
  *
  * Function     bta_jv_port_data_co_cback
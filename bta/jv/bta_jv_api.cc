@@ -396,6 +396,36 @@ tBTA_JV_STATUS BTA_JvL2capWrite(uint32_t handle, uint32_t req_id, BT_HDR* msg,
   return BTA_JV_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capWriteBatch
+ *
+ * Description      This function writes several SDUs to an L2CAP connection
+ *                  with one main thread task and one BTA_JV_L2CAP_WRITE_EVT.
+ *                  This function takes ownership of the buffers, and will
+ *                  osi_free them.
+ *
+ * Returns          BTA_JV_SUCCESS, if the request is being processed.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capWriteBatch(uint32_t handle, uint32_t req_id,
+                                     std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id) {
+  VLOG(2) << __func__ << ": count=" << msgs.size();
+
+  if (msgs.empty() || handle >= BTA_JV_MAX_L2C_CONN ||
+      !bta_jv_cb.l2c_cb[handle].p_cback) {
+    for (BT_HDR* msg : msgs) osi_free(msg);
+    return BTA_JV_FAILURE;
+  }
+
+  do_in_main_thread(
+      FROM_HERE, Bind(&bta_jv_l2cap_write_batch, handle, req_id,
+                      std::move(msgs), user_id, &bta_jv_cb.l2c_cb[handle]));
+  return BTA_JV_SUCCESS;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_JvRfcommConnect
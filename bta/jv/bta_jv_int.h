@@ -26,6 +26,7 @@
 
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "bta/include/bta_jv_api.h"
 #include "stack/include/rfcdefs.h"
@@ -170,6 +171,9 @@ extern void bta_jv_l2cap_stop_server(uint16_t local_psm,
                                      uint32_t l2cap_socket_id);
 extern void bta_jv_l2cap_write(uint32_t handle, uint32_t req_id, BT_HDR* msg,
                                uint32_t user_id, tBTA_JV_L2C_CB* p_cb);
+extern void bta_jv_l2cap_write_batch(uint32_t handle, uint32_t req_id,
+                                     std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id, tBTA_JV_L2C_CB* p_cb);
 extern void bta_jv_rfcomm_connect(tBTA_SEC sec_mask, uint8_t remote_scn,
                                   const RawAddress& peer_bd_addr,
                                   tBTA_JV_RFCOMM_CBACK* p_cback,
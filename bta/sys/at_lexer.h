@@ -0,0 +1,177 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  AT command lexer shared by the AG and HF client: command tables compiled
+ *  into tries, and arguments split over slices of the received buffer.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/* Command of an AT table matched by AtCommandTrie::Match() */
+struct AtMatch {
+  static constexpr size_t kNone = SIZE_MAX;
+
+  /* Index of the command in its table, or kNone */
+  size_t index;
+  /* Length of the command, its arguments start past it */
+  size_t length;
+
+  constexpr bool found() const { return index != kNone; }
+};
+
+/* Trie of the commands of an AT table, built at compile time. Matching walks
+ * the input once instead of comparing it with every command of the table. */
+class AtCommandTrie {
+ public:
+  static constexpr size_t kMaxNodes = 256;
+  static constexpr size_t kMaxCommands = 255;
+
+  /* Builds the trie of the |command| of the entries of |table|, skipping the
+   * empty ones such as end-of-table markers. Check IsFull() at compile time. */
+  template <typename T, size_t N>
+  constexpr AtCommandTrie(const T (&table)[N], const char* const T::*command)
+      : nodes_{}, num_nodes_(1), is_full_(N > kMaxCommands) {
+    for (size_t i = 0; i < N && !is_full_; i++) {
+      Insert(table[i].*command, i);
+    }
+  }
+
+  /* Returns the first command of the table that is a prefix of |input|. With
+   * |ignore_case|, the letters of |input| are upper cased before matching the
+   * commands, which have to be upper case. */
+  constexpr AtMatch Match(std::string_view input, bool ignore_case) const {
+    AtMatch match = {AtMatch::kNone, 0};
+    uint8_t node = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+      char c = input[i];
+      if (ignore_case && c >= 'a' && c <= 'z') c -= 'a' - 'A';
+      node = FindChild(node, c);
+      if (node == 0) break;
+      size_t command = nodes_[node].command;
+      if (command != 0 && command - 1 < match.index) {
+        match.index = command - 1;
+        match.length = i + 1;
+      }
+    }
+    return match;
+  }
+
+  /* Whether the trie could not hold all the commands of its table */
+  constexpr bool IsFull() const { return is_full_; }
+
+  /* Whether a command is a prefix of another one, in which case an input may
+   * match both */
+  constexpr bool HasNestedCommands() const {
+    for (size_t node = 1; node < num_nodes_; node++) {
+      if (nodes_[node].command != 0 && nodes_[node].child != 0) return true;
+    }
+    return false;
+  }
+
+ private:
+  struct Node {
+    char c;
+    /* First child and next sibling, 0 for none as the root is nobody's */
+    uint8_t child;
+    uint8_t sibling;
+    /* Index of the command ending here plus one, 0 for none */
+    uint8_t command;
+  };
+
+  constexpr uint8_t FindChild(uint8_t node, char c) const {
+    uint8_t child = nodes_[node].child;
+    while (child != 0 && nodes_[child].c != c) child = nodes_[child].sibling;
+    return child;
+  }
+
+  constexpr void Insert(const char* command, size_t index) {
+    uint8_t node = 0;
+    for (; *command != 0; command++) {
+      uint8_t child = FindChild(node, *command);
+      if (child == 0) {
+        if (num_nodes_ == kMaxNodes) {
+          is_full_ = true;
+          return;
+        }
+        child = static_cast<uint8_t>(num_nodes_++);
+        nodes_[child].c = *command;
+        nodes_[child].sibling = nodes_[node].child;
+        nodes_[node].child = child;
+      }
+      node = child;
+    }
+    /* The first of duplicate commands is the one matched */
+    if (node != 0 && nodes_[node].command == 0) {
+      nodes_[node].command = static_cast<uint8_t>(index + 1);
+    }
+  }
+
+  Node nodes_[kMaxNodes];
+  size_t num_nodes_;
+  bool is_full_;
+};
+
+/* Splits AT command arguments, separated by commas or null characters, into
+ * slices of the buffer holding them. */
+class AtArgumentLexer {
+ public:
+  explicit constexpr AtArgumentLexer(std::string_view args)
+      : args_(args), done_(false) {}
+
+  /* Sets |arg| to the next argument. Returns false once all of them were,
+   * there is always one, possibly empty. */
+  constexpr bool Next(std::string_view* arg) {
+    if (done_) return false;
+    size_t end = args_.find_first_of(std::string_view(",\0", 2));
+    if (end == std::string_view::npos) {
+      *arg = args_;
+      done_ = true;
+    } else {
+      *arg = args_.substr(0, end);
+      args_.remove_prefix(end + 1);
+    }
+    return true;
+  }
+
+ private:
+  std::string_view args_;
+  bool done_;
+};
+
+/* Parses a decimal integer argument like utl_str2int(): leading spaces are
+ * skipped, then only digits are allowed. Returns -1 if |arg| is invalid or
+ * above 32767. */
+constexpr int16_t AtParseInt(std::string_view arg) {
+  size_t i = 0;
+  while (i < arg.size() && arg[i] == ' ') i++;
+  if (i == arg.size()) return -1;
+
+  int32_t val = 0;
+  for (; i < arg.size(); i++) {
+    if (arg[i] < '0' || arg[i] > '9') return -1;
+    val = val * 10 + (arg[i] - '0');
+    if (val > 32767) return -1;
+  }
+  return static_cast<int16_t>(val);
+}
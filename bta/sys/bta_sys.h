@@ -25,7 +25,9 @@
 #define BTA_SYS_H
 
 #include <base/time/time.h>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 #include "bt_target.h"  // Must be first to define build configuration
 
@@ -208,6 +210,26 @@ extern void bta_sys_deregister(uint8_t id);
 extern bool bta_sys_is_register(uint8_t id);
 extern void bta_sys_sendmsg(void* p_msg);
 extern void bta_sys_sendmsg_delayed(void* p_msg, const base::TimeDelta& delay);
+
+/* Size of the largest event sent with bta_sys_send_event() */
+#define BTA_SYS_EVENT_MAX_SIZE 64
+
+extern void bta_sys_send_inline_event(tBTA_SYS_EVT_HDLR* p_handler,
+                                      const void* p_event, size_t len);
+
+/* Sends |event|, which starts with its BT_HDR_RIGID, to |handler| on the main
+ * thread. Unlike bta_sys_sendmsg(), the event is copied into a preallocated
+ * slot instead of being allocated, and goes to its handler without a lookup of
+ * its subsystem. For small events sent often, which their handler must not
+ * keep: it has to return true. When all the slots are in use, the event is
+ * allocated and sent with bta_sys_sendmsg(), and may then be handled out of
+ * order. */
+template <tBTA_SYS_EVT_HDLR* handler, typename T>
+void bta_sys_send_event(const T& event) {
+  static_assert(std::is_trivially_copyable<T>::value, "events are copied");
+  static_assert(sizeof(T) <= BTA_SYS_EVENT_MAX_SIZE, "event is too large");
+  bta_sys_send_inline_event(handler, &event, sizeof(T));
+}
 extern void bta_sys_start_timer(alarm_t* alarm, uint64_t interval_ms,
                                 uint16_t event, uint16_t layer_specific);
 extern void bta_sys_disable();
@@ -25,6 +25,7 @@
 #define LOG_TAG "bt_bta_sys_main"
 
 #include <base/bind.h>
+#include <atomic>
 #include <cstring>
 
 #include "bt_target.h"  // Must be first to define build configuration
@@ -33,6 +34,7 @@
 #include "bta/sys/bta_sys_int.h"
 #include "include/hardware/bluetooth.h"
 #include "osi/include/alarm.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "stack/include/bt_types.h"
@@ -43,6 +45,26 @@ void BTIF_dm_on_hw_error();
 /* system manager control block definition */
 tBTA_SYS_CB bta_sys_cb;
 
+/* Events sent by bta_sys_send_event(), in a bounded lock free queue of slots
+ * (Vyukov's MPMC queue) drained by the main thread. The main thread is woken up
+ * once per burst of events rather than once per event. */
+#define BTA_SYS_INLINE_EVENT_SLOTS 64 /* power of 2 */
+
+typedef struct {
+  /* Position in the queue for which the slot is free, or plus one for which
+   * it holds an event */
+  std::atomic<size_t> sequence;
+  tBTA_SYS_EVT_HDLR* p_handler;
+  alignas(std::max_align_t) uint8_t event[BTA_SYS_EVENT_MAX_SIZE];
+} tBTA_SYS_INLINE_EVENT_SLOT;
+
+static tBTA_SYS_INLINE_EVENT_SLOT
+    bta_sys_inline_events[BTA_SYS_INLINE_EVENT_SLOTS];
+static std::atomic<size_t> bta_sys_inline_events_enqueue_pos;
+/* Main thread only */
+static size_t bta_sys_inline_events_dequeue_pos;
+static std::atomic<bool> bta_sys_inline_events_drain_posted;
+
 /* trace level */
 /* TODO Hard-coded trace levels -  Needs to be configurable */
 uint8_t appl_trace_level = APPL_INITIAL_TRACE_LEVEL;
@@ -60,6 +82,14 @@ uint8_t btif_trace_level = BT_TRACE_LEVEL_WARNING;
  ******************************************************************************/
 void bta_sys_init(void) {
   memset(&bta_sys_cb, 0, sizeof(tBTA_SYS_CB));
+
+  /* Events left from before the stack was last shut down are dropped */
+  for (size_t i = 0; i < BTA_SYS_INLINE_EVENT_SLOTS; i++) {
+    bta_sys_inline_events[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  bta_sys_inline_events_enqueue_pos.store(0, std::memory_order_relaxed);
+  bta_sys_inline_events_dequeue_pos = 0;
+  bta_sys_inline_events_drain_posted.store(false, std::memory_order_release);
 }
 
 void bta_set_forward_hw_failures(bool value) {
@@ -72,6 +102,44 @@ void BTA_sys_signal_hw_error() {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_sys_allocation_tag
+ *
+ * Description      Returns the tag the allocations made handling the events
+ *                  of subsystem |id| are accounted to.
+ *
+ *
+ * Returns          allocation_tag_t
+ *
+ ******************************************************************************/
+static allocation_tag_t bta_sys_allocation_tag(uint8_t id) {
+  switch (id) {
+    case BTA_ID_DM_SEARCH:
+    case BTA_ID_DM_SEC:
+      return ALLOCATION_TAG_DM;
+    case BTA_ID_AG:
+    case BTA_ID_HS:
+      return ALLOCATION_TAG_HFP;
+    case BTA_ID_PAN:
+      return ALLOCATION_TAG_PAN;
+    case BTA_ID_AV:
+      return ALLOCATION_TAG_A2DP;
+    case BTA_ID_HD:
+    case BTA_ID_HH:
+      return ALLOCATION_TAG_HID;
+    case BTA_ID_JV:
+      return ALLOCATION_TAG_SOCKET;
+    case BTA_ID_GATTC:
+    case BTA_ID_GATTS:
+      return ALLOCATION_TAG_GATT;
+    case BTA_ID_SDP:
+      return ALLOCATION_TAG_SDP;
+    default:
+      return ALLOCATION_TAG_NONE;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_sys_event
@@ -93,6 +161,7 @@ static void bta_sys_event(BT_HDR_RIGID* p_msg) {
 
   /* verify id and call subsystem event handler */
   if ((id < BTA_ID_MAX) && (bta_sys_cb.reg[id] != NULL)) {
+    AllocationTagScope tag_scope(bta_sys_allocation_tag(id));
     freebuf = (*bta_sys_cb.reg[id]->evt_hdlr)(p_msg);
   } else {
     LOG_INFO("Ignoring receipt of unregistered event id:%s",
@@ -179,6 +248,93 @@ void bta_sys_sendmsg_delayed(void* p_msg, const base::TimeDelta& delay) {
   }
 }
 
+static bool bta_sys_enqueue_inline_event(tBTA_SYS_EVT_HDLR* p_handler,
+                                         const void* p_event, size_t len) {
+  tBTA_SYS_INLINE_EVENT_SLOT* p_slot;
+  size_t pos =
+      bta_sys_inline_events_enqueue_pos.load(std::memory_order_relaxed);
+  for (;;) {
+    p_slot = &bta_sys_inline_events[pos & (BTA_SYS_INLINE_EVENT_SLOTS - 1)];
+    size_t sequence = p_slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (bta_sys_inline_events_enqueue_pos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false; /* full */
+    } else {
+      pos = bta_sys_inline_events_enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  p_slot->p_handler = p_handler;
+  memcpy(p_slot->event, p_event, len);
+  p_slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+static void bta_sys_drain_inline_events() {
+  /* Cleared first, for events enqueued from now on to post another drain */
+  bta_sys_inline_events_drain_posted.exchange(false,
+                                              std::memory_order_acq_rel);
+
+  for (;;) {
+    size_t pos = bta_sys_inline_events_dequeue_pos;
+    tBTA_SYS_INLINE_EVENT_SLOT* p_slot =
+        &bta_sys_inline_events[pos & (BTA_SYS_INLINE_EVENT_SLOTS - 1)];
+    if (p_slot->sequence.load(std::memory_order_acquire) != pos + 1) {
+      return; /* empty */
+    }
+
+    /* Copied out for the slot to be reused by events the handler sends */
+    tBTA_SYS_EVT_HDLR* p_handler = p_slot->p_handler;
+    alignas(std::max_align_t) uint8_t event[BTA_SYS_EVENT_MAX_SIZE];
+    memcpy(event, p_slot->event, sizeof(event));
+    p_slot->sequence.store(pos + BTA_SYS_INLINE_EVENT_SLOTS,
+                           std::memory_order_release);
+    bta_sys_inline_events_dequeue_pos = pos + 1;
+
+    bool freebuf = (*p_handler)((BT_HDR_RIGID*)event);
+    CHECK(freebuf) << __func__ << ": event 0x" << std::hex
+                   << ((BT_HDR_RIGID*)event)->event << " kept by its handler";
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_sys_send_inline_event
+ *
+ * Description      Send a fixed size event to its handler on the main thread,
+ *                  without allocating it. Called by bta_sys_send_event().
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_sys_send_inline_event(tBTA_SYS_EVT_HDLR* p_handler,
+                               const void* p_event, size_t len) {
+  CHECK(len <= BTA_SYS_EVENT_MAX_SIZE);
+
+  if (!bta_sys_enqueue_inline_event(p_handler, p_event, len)) {
+    /* All the slots are in use, the event goes through its subsystem */
+    void* p_msg = osi_malloc(len);
+    memcpy(p_msg, p_event, len);
+    bta_sys_sendmsg(p_msg);
+    return;
+  }
+
+  if (bta_sys_inline_events_drain_posted.exchange(true,
+                                                  std::memory_order_acq_rel)) {
+    return;
+  }
+  if (do_in_main_thread(FROM_HERE, base::Bind(&bta_sys_drain_inline_events)) !=
+      BT_STATUS_SUCCESS) {
+    LOG(ERROR) << __func__ << ": do_in_main_thread failed";
+    bta_sys_inline_events_drain_posted.store(false, std::memory_order_release);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_sys_start_timer
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string_view>
+
+#include "bta/sys/at_lexer.h"
+
+namespace {
+
+struct TestCommand {
+  const char* p_cmd;
+};
+
+constexpr TestCommand kCommands[] = {
+    {"+CIND"}, {"+CIEV"}, {"+CHLD"}, {"+CIND"}, {"D"}, {"+BIND"}, {""}};
+constexpr AtCommandTrie kTrie(kCommands, &TestCommand::p_cmd);
+
+constexpr TestCommand kNestedCommands[] = {{"+BRSF"}, {"+BRS"}, {"A"}};
+constexpr AtCommandTrie kNestedTrie(kNestedCommands, &TestCommand::p_cmd);
+
+static_assert(!kTrie.IsFull(), "trie too small");
+static_assert(kTrie.Match("+CHLD=1", false).index == 2, "not constexpr");
+static_assert(AtParseInt(" 42") == 42, "not constexpr");
+
+}  // namespace
+
+TEST(AtLexerTest, match_command) {
+  AtMatch match = kTrie.Match("+CIEV: 1,0", false);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 1u);
+  EXPECT_EQ(match.length, 5u);
+
+  match = kTrie.Match("D5551234;", false);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 4u);
+  EXPECT_EQ(match.length, 1u);
+}
+
+TEST(AtLexerTest, match_first_duplicate) {
+  AtMatch match = kTrie.Match("+CIND?", false);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 0u);
+}
+
+TEST(AtLexerTest, no_match) {
+  EXPECT_FALSE(kTrie.Match("", false).found());
+  EXPECT_FALSE(kTrie.Match("+CI", false).found());
+  EXPECT_FALSE(kTrie.Match("+COPS?", false).found());
+  EXPECT_FALSE(kTrie.Match("X+CIND", false).found());
+}
+
+TEST(AtLexerTest, match_ignore_case) {
+  EXPECT_FALSE(kTrie.Match("+chld=1", false).found());
+
+  AtMatch match = kTrie.Match("+cHlD=1", true);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 2u);
+  EXPECT_EQ(match.length, 5u);
+}
+
+TEST(AtLexerTest, match_nested_commands) {
+  EXPECT_FALSE(kTrie.HasNestedCommands());
+  EXPECT_TRUE(kNestedTrie.HasNestedCommands());
+
+  // The command first in the table wins, as with a linear scan
+  AtMatch match = kNestedTrie.Match("+BRSF=1", false);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 0u);
+  EXPECT_EQ(match.length, 5u);
+
+  match = kNestedTrie.Match("+BRS=1", false);
+  ASSERT_TRUE(match.found());
+  EXPECT_EQ(match.index, 1u);
+  EXPECT_EQ(match.length, 4u);
+}
+
+TEST(AtLexerTest, full_trie) {
+  static TestCommand commands[AtCommandTrie::kMaxCommands + 1];
+  for (auto& command : commands) command.p_cmd = "A";
+  AtCommandTrie trie(commands, &TestCommand::p_cmd);
+  EXPECT_TRUE(trie.IsFull());
+}
+
+TEST(AtLexerTest, split_arguments) {
+  AtArgumentLexer lexer(std::string_view("1,,20\0" "3", 7));
+  std::string_view arg;
+  ASSERT_TRUE(lexer.Next(&arg));
+  EXPECT_EQ(arg, "1");
+  ASSERT_TRUE(lexer.Next(&arg));
+  EXPECT_EQ(arg, "");
+  ASSERT_TRUE(lexer.Next(&arg));
+  EXPECT_EQ(arg, "20");
+  ASSERT_TRUE(lexer.Next(&arg));
+  EXPECT_EQ(arg, "3");
+  EXPECT_FALSE(lexer.Next(&arg));
+}
+
+TEST(AtLexerTest, split_empty_arguments) {
+  AtArgumentLexer lexer("");
+  std::string_view arg = "x";
+  ASSERT_TRUE(lexer.Next(&arg));
+  EXPECT_EQ(arg, "");
+  EXPECT_FALSE(lexer.Next(&arg));
+}
+
+TEST(AtLexerTest, parse_int) {
+  EXPECT_EQ(AtParseInt("0"), 0);
+  EXPECT_EQ(AtParseInt("  17"), 17);
+  EXPECT_EQ(AtParseInt("32767"), 32767);
+  EXPECT_EQ(AtParseInt("32768"), -1);
+  EXPECT_EQ(AtParseInt("999999999999"), -1);
+  EXPECT_EQ(AtParseInt(""), -1);
+  EXPECT_EQ(AtParseInt("   "), -1);
+  EXPECT_EQ(AtParseInt("1a"), -1);
+  EXPECT_EQ(AtParseInt("-1"), -1);
+  EXPECT_EQ(AtParseInt("1 "), -1);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <strings.h>
+
+#include <iterator>
+#include <string_view>
+
+#include "bta/sys/at_lexer.h"
+
+namespace {
+
+struct BenchmarkCommand {
+  const char* p_cmd;
+};
+
+// The HFP commands of the AG
+constexpr BenchmarkCommand kCommands[] = {
+    {"A"},     {"D"},     {"+VGS"},  {"+VGM"},  {"+CCWA"}, {"+CHLD"},
+    {"+CHUP"}, {"+CIND"}, {"+CLIP"}, {"+CMER"}, {"+VTS"},  {"+BINP"},
+    {"+BLDN"}, {"+BVRA"}, {"+BRSF"}, {"+NREC"}, {"+CNUM"}, {"+BTRH"},
+    {"+CLCC"}, {"+COPS"}, {"+CMEE"}, {"+BIA"},  {"+CBC"},  {"+BCC"},
+    {"+BCS"},  {"+BIND"}, {"+BIEV"}, {"+BAC"},  {""}};
+constexpr AtCommandTrie kTrie(kCommands, &BenchmarkCommand::p_cmd);
+
+// Commands of a service level connection set up and an incoming call
+constexpr const char* kInputs[] = {
+    "+BRSF=959",      "+BAC=1,2",     "+CIND=?",   "+CIND?",
+    "+CMER=3,0,0,1",  "+CHLD=?",      "+BIND=1,2", "+BIND?",
+    "+CLIP=1",        "+CCWA=1",      "+CMEE=1",   "+BIA=0,0,0,1,1,1,0",
+    "+CLCC",          "+COPS=3,0",    "+COPS?",    "A",
+    "+VGS=9",         "+unknown=1",
+};
+
+size_t LinearMatch(const char* input) {
+  for (size_t i = 0; kCommands[i].p_cmd[0] != '\0'; i++) {
+    const char* command = kCommands[i].p_cmd;
+    if (strncasecmp(command, input, strlen(command)) == 0) return i;
+  }
+  return AtMatch::kNone;
+}
+
+void BM_LinearMatch(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* input : kInputs) {
+      benchmark::DoNotOptimize(LinearMatch(input));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * std::size(kInputs));
+}
+BENCHMARK(BM_LinearMatch);
+
+void BM_TrieMatch(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* input : kInputs) {
+      benchmark::DoNotOptimize(kTrie.Match(input, true));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * std::size(kInputs));
+}
+BENCHMARK(BM_TrieMatch);
+
+void BM_LexArguments(benchmark::State& state) {
+  constexpr std::string_view kArgs = "0,0,0,1,1,1,0";
+  for (auto _ : state) {
+    AtArgumentLexer lexer(kArgs);
+    std::string_view arg;
+    int sum = 0;
+    while (lexer.Next(&arg)) sum += AtParseInt(arg);
+    benchmark::DoNotOptimize(sum);
+  }
+}
+BENCHMARK(BM_LexArguments);
+
+}  // namespace
+
+BENCHMARK_MAIN();
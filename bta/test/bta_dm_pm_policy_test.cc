@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "bta/dm/bta_dm_pm_policy.h"
+
+namespace {
+
+constexpr uint64_t kTableMs = 7000;
+constexpr uint64_t kNowMs = 100000;
+
+class BtaDmPmPolicyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&traffic_, 0, sizeof(traffic_));
+    traffic_.last_packet_ms = kNowMs;
+    policy_.Reset();
+  }
+
+  /* Counts |count| gaps of |gap_ms| */
+  void AddGaps(uint64_t gap_ms, uint32_t count) {
+    size_t bucket = 0;
+    for (gap_ms /= 2 * BTM_ACL_BURST_GAP_MS;
+         gap_ms != 0 && bucket < BTM_ACL_GAP_BUCKETS - 1; gap_ms /= 2) {
+      bucket++;
+    }
+    traffic_.gaps[bucket] += count;
+  }
+
+  tBTM_ACL_TRAFFIC traffic_;
+  PmTrafficPolicy policy_;
+};
+
+TEST_F(BtaDmPmPolicyTest, follows_tables_until_learned) {
+  AddGaps(60000, PmTrafficPolicy::kMinGaps - 1);
+  EXPECT_EQ(policy_.SniffDelayMs(traffic_, PmTrafficClass::kData, kTableMs),
+            kTableMs);
+  EXPECT_EQ(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData, kNowMs), 0u);
+
+  tBTM_PM_PWR_MD mode = {.max = 800, .min = 400};
+  policy_.AdjustSniff(traffic_, PmTrafficClass::kData, &mode);
+  EXPECT_EQ(mode.max, 800);
+  EXPECT_EQ(mode.min, 400);
+  EXPECT_EQ(policy_.SsrMaxLatency(traffic_, PmTrafficClass::kData, 1200), 1200);
+}
+
+TEST_F(BtaDmPmPolicyTest, percentiles) {
+  AddGaps(150, 10);
+  AddGaps(1000, 80);
+  AddGaps(60000, 10);
+  EXPECT_EQ(PmTrafficPolicy::GapLowerMs(traffic_, 5), 100u);
+  EXPECT_EQ(PmTrafficPolicy::GapLowerMs(traffic_, 50), 800u);
+  EXPECT_EQ(PmTrafficPolicy::GapUpperMs(traffic_, 50), 1600u);
+  EXPECT_EQ(PmTrafficPolicy::GapUpperMs(traffic_, 95), UINT64_MAX);
+}
+
+TEST_F(BtaDmPmPolicyTest, idle_link_enters_sniff_sooner) {
+  AddGaps(60000, 20);
+  EXPECT_EQ(policy_.SniffDelayMs(traffic_, PmTrafficClass::kData, kTableMs),
+            kTableMs / 2);
+  EXPECT_EQ(policy_.advanced(), 1u);
+  EXPECT_EQ(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData, kNowMs), 0u);
+
+  tBTM_PM_PWR_MD mode = {.max = 800, .min = 400};
+  policy_.AdjustSniff(traffic_, PmTrafficClass::kData, &mode);
+  EXPECT_EQ(mode.min, 800);
+  EXPECT_EQ(policy_.SsrMaxLatency(traffic_, PmTrafficClass::kData, 1200), 2400);
+}
+
+TEST_F(BtaDmPmPolicyTest, defers_sniff_before_burst) {
+  /* Bursts come back within 1.6 s */
+  AddGaps(1000, 20);
+  EXPECT_EQ(policy_.SniffDelayMs(traffic_, PmTrafficClass::kData, kTableMs),
+            kTableMs);
+
+  /* The last packet was 500 ms ago, the next burst is likely to come */
+  EXPECT_EQ(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData,
+                                 kNowMs + 500),
+            1100u);
+  EXPECT_EQ(policy_.deferred(), 1u);
+
+  /* Idle for long enough */
+  EXPECT_EQ(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData,
+                                 kNowMs + 1600),
+            0u);
+}
+
+TEST_F(BtaDmPmPolicyTest, stops_deferring_busy_link) {
+  AddGaps(1000, 20);
+  for (int i = 0; i < PmTrafficPolicy::kMaxDeferrals; i++) {
+    EXPECT_GT(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData, kNowMs),
+              0u);
+  }
+  EXPECT_EQ(policy_.SniffDeferMs(traffic_, PmTrafficClass::kData, kNowMs), 0u);
+}
+
+TEST_F(BtaDmPmPolicyTest, chatty_link_uses_short_interval) {
+  AddGaps(300, 20);
+  tBTM_PM_PWR_MD mode = {.max = 800, .min = 400};
+  policy_.AdjustSniff(traffic_, PmTrafficClass::kData, &mode);
+  EXPECT_EQ(mode.max, 400);
+  EXPECT_EQ(policy_.last_interval(), 400);
+}
+
+TEST_F(BtaDmPmPolicyTest, leaves_hid_and_audio_links) {
+  AddGaps(60000, 20);
+  tBTM_PM_PWR_MD mode = {.max = 54, .min = 30};
+  policy_.AdjustSniff(traffic_, PmTrafficClass::kHid, &mode);
+  EXPECT_EQ(mode.max, 54);
+  EXPECT_EQ(mode.min, 30);
+  EXPECT_EQ(policy_.SsrMaxLatency(traffic_, PmTrafficClass::kHid, 360), 360);
+  EXPECT_EQ(policy_.SniffDelayMs(traffic_, PmTrafficClass::kAudio, kTableMs),
+            kTableMs);
+}
+
+TEST_F(BtaDmPmPolicyTest, scores_sniff_modes) {
+  policy_.OnActive(kNowMs);
+  policy_.OnSniff(kNowMs);
+  policy_.OnActive(kNowMs + PmTrafficPolicy::kEarlyWakeMs - 1);
+  policy_.OnSniff(kNowMs + 2000);
+  policy_.OnActive(kNowMs + 60000);
+  EXPECT_EQ(policy_.misses(), 1u);
+  EXPECT_EQ(policy_.hits(), 1u);
+}
+
+}  // namespace
@@ -70,7 +70,7 @@ TEST_F(BtaDmTest, disable_no_acl_links) {
   fake_osi_alarm_set_on_mloop_.cb(fake_osi_alarm_set_on_mloop_.data);
   ASSERT_EQ(1, mock_function_count_map["alarm_set_on_mloop"]);
   ASSERT_EQ(0, mock_function_count_map["BTIF_dm_disable"]);
-  ASSERT_EQ(1, mock_function_count_map["future_ready"]);
+  ASSERT_EQ(1, mock_function_count_map["stack_manager_signal_stage_done"]);
   ASSERT_TRUE(!bta_dm_cb.disabling);
 }
 
@@ -112,3 +112,24 @@ TEST_F(BtaDmTest, disable_second_pass_with_acl_links) {
   ASSERT_EQ(1, mock_function_count_map["BTIF_dm_disable"]);
   ASSERT_TRUE(!bta_dm_cb.disabling);
 }
+
+TEST_F(BtaDmTest, order_inq_results) {
+  tBTM_INQ_INFO infos[5] = {};
+  infos[0].results.rssi = -80;
+  infos[1].results.rssi = BTM_INQ_RES_IGNORE_RSSI;
+  infos[2].results.rssi = -40;
+  infos[3].results.rssi = -90;
+  infos[3].appl_knows_rem_name = true;
+  infos[4].results.rssi = -80;
+
+  tBTM_INQ_INFO* p_infos[5];
+  for (int i = 0; i < 5; i++) p_infos[i] = &infos[i];
+  bta_dm_order_inq_results(p_infos, 5);
+
+  // Known name first, then by signal strength, without signal strength last
+  ASSERT_EQ(&infos[3], p_infos[0]);
+  ASSERT_EQ(&infos[2], p_infos[1]);
+  ASSERT_EQ(&infos[0], p_infos[2]);
+  ASSERT_EQ(&infos[4], p_infos[3]);
+  ASSERT_EQ(&infos[1], p_infos[4]);
+}
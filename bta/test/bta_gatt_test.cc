@@ -67,6 +67,30 @@ void bta_gatt_write_complete_callback(uint16_t conn_id, tGATT_STATUS status,
   param::bta_gatt_write_complete_callback.data = data;
 }
 
+namespace param {
+struct {
+  int count;
+  uint16_t conn_id;
+  tGATT_STATUS status;
+  uint16_t handle;
+  uint32_t sent;
+  uint32_t total;
+  void* data;
+} bta_gatt_write_stream_callback;
+}  // namespace param
+
+void bta_gatt_write_stream_callback(uint16_t conn_id, tGATT_STATUS status,
+                                    uint16_t handle, uint32_t sent,
+                                    uint32_t total, void* data) {
+  param::bta_gatt_write_stream_callback.count++;
+  param::bta_gatt_write_stream_callback.conn_id = conn_id;
+  param::bta_gatt_write_stream_callback.status = status;
+  param::bta_gatt_write_stream_callback.handle = handle;
+  param::bta_gatt_write_stream_callback.sent = sent;
+  param::bta_gatt_write_stream_callback.total = total;
+  param::bta_gatt_write_stream_callback.data = data;
+}
+
 namespace param {
 struct {
   uint16_t conn_id;
@@ -101,6 +125,7 @@ class BtaGattTest : public ::testing::Test {
     mock_function_count_map.clear();
     param::bta_gatt_read_complete_callback = {};
     param::bta_gatt_write_complete_callback = {};
+    param::bta_gatt_write_stream_callback = {};
     param::bta_gatt_configure_mtu_complete_callback = {};
     param::bta_gattc_event_complete_callback = {};
   }
@@ -293,3 +318,57 @@ TEST_F(BtaGattTest, bta_gattc_op_cmpl_read_interrupted) {
   bta_gattc_op_cmpl(&client_channel_control_block, &data);
   ASSERT_EQ(GATT_ERROR, param::bta_gatt_read_complete_callback.status);
 }
+
+TEST_F(BtaGattTest, bta_gattc_write_stream_busy) {
+  tBTA_GATTC_DATA data = {
+      .api_write_stream =  // tBTA_GATTC_API_WRITE_STREAM
+      {
+          .hdr =
+              {
+                  .event = BTA_GATTC_API_WRITE_STREAM_EVT,
+              },
+          .handle = 123,
+          .len = 1000,
+          .stream_cb = bta_gatt_write_stream_callback,
+          .stream_cb_data = static_cast<void*>(this),
+      },
+  };
+
+  // Another command is pending
+  client_channel_control_block.p_q_cmd = &command_queue;
+
+  bta_gattc_write_stream(&client_channel_control_block, &data);
+  ASSERT_EQ(&command_queue, client_channel_control_block.p_q_cmd);
+  ASSERT_EQ(1, param::bta_gatt_write_stream_callback.count);
+  ASSERT_EQ(456, param::bta_gatt_write_stream_callback.conn_id);
+  ASSERT_EQ(GATT_BUSY, param::bta_gatt_write_stream_callback.status);
+  ASSERT_EQ(123, param::bta_gatt_write_stream_callback.handle);
+  ASSERT_EQ(0U, param::bta_gatt_write_stream_callback.sent);
+  ASSERT_EQ(1000U, param::bta_gatt_write_stream_callback.total);
+  ASSERT_EQ(this, param::bta_gatt_write_stream_callback.data);
+}
+
+TEST_F(BtaGattTest, bta_gattc_write_stream_queued) {
+  tBTA_GATTC_DATA data = {
+      .api_write_stream =  // tBTA_GATTC_API_WRITE_STREAM
+      {
+          .hdr =
+              {
+                  .event = BTA_GATTC_API_WRITE_STREAM_EVT,
+              },
+          .handle = 123,
+          .len = 1000,
+          .stream_cb = bta_gatt_write_stream_callback,
+      },
+  };
+
+  client_channel_control_block.p_q_cmd = nullptr;
+
+  // The stream keeps the command queue and is sent from the main thread
+  bta_gattc_write_stream(&client_channel_control_block, &data);
+  ASSERT_EQ(&data, client_channel_control_block.p_q_cmd);
+  ASSERT_EQ(BTA_GATTC_STREAM_W4_RESUME,
+            client_channel_control_block.stream_state);
+  ASSERT_EQ(1, mock_function_count_map["do_in_main_thread"]);
+  ASSERT_EQ(0, param::bta_gatt_write_stream_callback.count);
+}
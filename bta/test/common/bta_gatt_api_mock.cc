@@ -57,7 +57,7 @@ void BTA_GATTC_ServiceSearchRequest(uint16_t conn_id,
   gatt_interface->ServiceSearchRequest(conn_id, p_srvc_uuid);
 }
 
-const std::list<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
+const std::vector<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
   return gatt_interface->GetServices(conn_id);
 }
 
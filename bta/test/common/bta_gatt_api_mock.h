@@ -38,7 +38,7 @@ class BtaGattInterface {
   virtual void Close(uint16_t conn_id) = 0;
   virtual void ServiceSearchRequest(uint16_t conn_id,
                                     const bluetooth::Uuid* p_srvc_uuid) = 0;
-  virtual const std::list<Service>* GetServices(uint16_t conn_id) = 0;
+  virtual const std::vector<Service>* GetServices(uint16_t conn_id) = 0;
   virtual const Characteristic* GetCharacteristic(uint16_t conn_id,
                                                   uint16_t handle) = 0;
   virtual const Service* GetOwningService(uint16_t conn_id,
@@ -71,7 +71,7 @@ class MockBtaGattInterface : public BtaGattInterface {
   MOCK_METHOD((void), Close, (uint16_t conn_id));
   MOCK_METHOD((void), ServiceSearchRequest,
               (uint16_t conn_id, const bluetooth::Uuid* p_srvc_uuid));
-  MOCK_METHOD((std::list<Service>*), GetServices, (uint16_t conn_id));
+  MOCK_METHOD((std::vector<Service>*), GetServices, (uint16_t conn_id));
   MOCK_METHOD((const Characteristic*), GetCharacteristic,
               (uint16_t conn_id, uint16_t handle));
   MOCK_METHOD((const Service*), GetOwningService,
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks the AT lexer against the linear scans and utl_str2int() it replaced.
+
+#include <fuzzer/FuzzedDataProvider.h>
+#include <stdlib.h>
+
+#include <string>
+#include <string_view>
+
+#include "bta/sys/at_lexer.h"
+
+namespace {
+
+struct FuzzCommand {
+  const char* p_cmd;
+};
+
+// The HFP commands of the AG, plus nested ones
+constexpr FuzzCommand kCommands[] = {
+    {"A"},     {"D"},     {"+VGS"},  {"+VGM"},  {"+CCWA"}, {"+CHLD"},
+    {"+CHUP"}, {"+CIND"}, {"+CLIP"}, {"+CMER"}, {"+VTS"},  {"+BINP"},
+    {"+BLDN"}, {"+BVRA"}, {"+BRSF"}, {"+NREC"}, {"+CNUM"}, {"+BTRH"},
+    {"+CLCC"}, {"+COPS"}, {"+CMEE"}, {"+BIA"},  {"+CBC"},  {"+BCC"},
+    {"+BCS"},  {"+BIND"}, {"+BIEV"}, {"+BAC"},  {"+BI"},   {"+CIN"},
+    {""}};
+constexpr AtCommandTrie kTrie(kCommands, &FuzzCommand::p_cmd);
+
+char ToUpper(char c, bool ignore_case) {
+  return ignore_case && c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c;
+}
+
+AtMatch LinearMatch(std::string_view input, bool ignore_case) {
+  for (size_t i = 0; i < sizeof(kCommands) / sizeof(kCommands[0]); i++) {
+    std::string_view command = kCommands[i].p_cmd;
+    if (command.empty() || command.size() > input.size()) continue;
+    size_t j = 0;
+    while (j < command.size() && ToUpper(input[j], ignore_case) == command[j]) {
+      j++;
+    }
+    if (j == command.size()) return {i, j};
+  }
+  return {AtMatch::kNone, 0};
+}
+
+int16_t LinearParseInt(const std::string& arg) {
+  const char* p = arg.c_str();
+  while (*p == ' ') p++;
+  if (*p == '\0') return -1;
+  int32_t val = 0;
+  for (; *p != '\0'; p++) {
+    if (*p < '0' || *p > '9') return -1;
+    val = val * 10 + (*p - '0');
+    if (val > 32767) return -1;
+  }
+  return static_cast<int16_t>(val);
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  FuzzedDataProvider fdp(data, size);
+  bool ignore_case = fdp.ConsumeBool();
+  std::string input = fdp.ConsumeRemainingBytesAsString();
+
+  AtMatch match = kTrie.Match(input, ignore_case);
+  AtMatch expected = LinearMatch(input, ignore_case);
+  if (match.index != expected.index ||
+      (match.found() && match.length != expected.length)) {
+    abort();
+  }
+
+  // Arguments and their separators add up to the input
+  AtArgumentLexer lexer(input);
+  std::string_view arg;
+  size_t length = 0;
+  size_t count = 0;
+  while (lexer.Next(&arg)) {
+    if (arg.data() != input.data() + length) abort();
+    length += arg.size() + 1;
+    count++;
+    if (AtParseInt(arg) != LinearParseInt(std::string(arg))) abort();
+  }
+  if (count == 0 || length != input.size() + 1) abort();
+  return 0;
+}
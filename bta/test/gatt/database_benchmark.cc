@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "gatt/database.h"
+#include "gatt/database_builder.h"
+
+using bluetooth::Uuid;
+using gatt::Characteristic;
+using gatt::Database;
+using gatt::DatabaseBuilder;
+using gatt::Service;
+
+namespace {
+
+/* Database of the example in Bluetooth SPEC V5.2, Vol 3, Part G, APPENDIX B,
+ * also used by database_test, followed by |extra_services| HID like services
+ * of 8 notifying characteristics each */
+Database BuildDatabase(int extra_services, std::vector<uint16_t>* values) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, Uuid::From16Bit(0x1800), true);
+  builder.AddService(0x0006, 0x000D, Uuid::From16Bit(0x1801), true);
+  builder.AddService(0x000E, 0x0013, Uuid::From16Bit(0x1808), true);
+  builder.AddService(0x0014, 0x0016, Uuid::From16Bit(0x180F), false);
+
+  builder.AddCharacteristic(0x0002, 0x0003, Uuid::From16Bit(0x2A00), 0x0A);
+  builder.AddCharacteristic(0x0004, 0x0005, Uuid::From16Bit(0x2A01), 0x02);
+  builder.AddCharacteristic(0x0007, 0x0008, Uuid::From16Bit(0x2A05), 0x20);
+  builder.AddDescriptor(0x0009, Uuid::From16Bit(0x2902));
+  builder.AddCharacteristic(0x000A, 0x000B, Uuid::From16Bit(0x2B29), 0x0A);
+  builder.AddCharacteristic(0x000C, 0x000D, Uuid::From16Bit(0x2B2A), 0x02);
+  builder.AddIncludedService(0x000F, Uuid::From16Bit(0x180F), 0x0014, 0x0016);
+  builder.AddCharacteristic(0x0010, 0x0011, Uuid::From16Bit(0x2A18), 0xA2);
+  builder.AddDescriptor(0x0012, Uuid::From16Bit(0x2902));
+  builder.AddDescriptor(0x0013, Uuid::From16Bit(0x2900));
+  builder.AddCharacteristic(0x0015, 0x0016, Uuid::From16Bit(0x2A19), 0x02);
+
+  uint16_t handle = 0x0020;
+  for (int i = 0; i < extra_services; i++) {
+    uint16_t start = handle;
+    uint16_t end = start + 8 * 4;
+    builder.AddService(start, end, Uuid::From16Bit(0x1812), true);
+    for (int c = 0; c < 8; c++) {
+      uint16_t declaration = start + 1 + c * 4;
+      builder.AddCharacteristic(declaration, declaration + 1,
+                                Uuid::From16Bit(0x2A4D), 0x1A);
+      builder.AddDescriptor(declaration + 2, Uuid::From16Bit(0x2902));
+      builder.AddDescriptor(declaration + 3, Uuid::From16Bit(0x2908));
+    }
+    handle = end + 1;
+  }
+
+  Database database = builder.Build();
+  for (const Service& service : database.Services()) {
+    for (const Characteristic& characteristic : service.characteristics) {
+      values->push_back(characteristic.value_handle);
+    }
+  }
+  return database;
+}
+
+/* The lookup bta_gattc_get_characteristic_srcb() did before the database
+ * could be searched by handle */
+const Characteristic* LinearFindCharacteristic(const Database& database,
+                                               uint16_t handle) {
+  for (const Service& service : database.Services()) {
+    if (handle < service.handle || handle > service.end_handle) continue;
+    for (const Characteristic& characteristic : service.characteristics) {
+      if (characteristic.value_handle == handle) return &characteristic;
+    }
+    return nullptr;
+  }
+  return nullptr;
+}
+
+void BM_FindCharacteristic(benchmark::State& state) {
+  std::vector<uint16_t> values;
+  Database database = BuildDatabase(state.range(0), &values);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        database.FindCharacteristic(values[i++ % values.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LinearFindCharacteristic(benchmark::State& state) {
+  std::vector<uint16_t> values;
+  Database database = BuildDatabase(state.range(0), &values);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        LinearFindCharacteristic(database, values[i++ % values.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FindDescriptor(benchmark::State& state) {
+  std::vector<uint16_t> values;
+  Database database = BuildDatabase(state.range(0), &values);
+  size_t i = 0;
+  for (auto _ : state) {
+    /* the CCCD right after each value */
+    benchmark::DoNotOptimize(
+        database.FindDescriptor(values[i++ % values.size()] + 1));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_FindCharacteristic)->Arg(0)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_LinearFindCharacteristic)->Arg(0)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_FindDescriptor)->Arg(0)->Arg(4)->Arg(16)->Arg(64);
@@ -176,4 +176,81 @@ TEST(DatabaseBuilderTest, SecondaryServiceOutOfOrderTest) {
   ASSERT_EQ(service, result.Services().end());
 }
 
+namespace {
+Database BuildThreeServices() {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, true);
+  builder.AddService(0x0020, 0x002f, SERVICE_3_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0004, SERVICE_1_CHAR_1_DESC_1_UUID);
+  return builder.Build();
+}
+}  // namespace
+
+/* Verify that a partial discovery keeps the services outside of the changed
+ * range, and rediscovers the services the range overlaps */
+TEST(DatabaseBuilderTest, PartialDiscoveryKeepsUnchangedServices) {
+  Database database = BuildThreeServices();
+  DatabaseBuilder builder;
+
+  uint16_t start = 0x0014;
+  uint16_t end = 0x0016;
+  ASSERT_TRUE(builder.StartPartialDiscovery(database, &start, &end));
+  ASSERT_EQ(make_pair_u16(start, end), make_pair_u16(0x0010, 0x001f));
+
+  // Nothing to explore but the rediscovered service
+  builder.AddService(0x0010, 0x001a, SERVICE_4_UUID, true);
+  EXPECT_TRUE(builder.StartNextServiceExploration());
+  ASSERT_EQ(builder.CurrentlyExploredService(), make_pair_u16(0x0010, 0x001a));
+  EXPECT_FALSE(builder.StartNextServiceExploration());
+  EXPECT_TRUE(builder.DescriptorHandlesToRead().empty());
+
+  Database result = builder.Build();
+  ASSERT_EQ(result.Services().size(), (size_t)3);
+
+  auto service = result.Services().begin();
+  ASSERT_EQ(service->handle, 0x0001);
+  ASSERT_EQ(service->uuid, SERVICE_1_UUID);
+  ASSERT_EQ(service->characteristics[0].descriptors[0].handle, 0x0004);
+
+  service++;
+  ASSERT_EQ(service->handle, 0x0010);
+  ASSERT_EQ(service->end_handle, 0x001a);
+  ASSERT_EQ(service->uuid, SERVICE_4_UUID);
+
+  service++;
+  ASSERT_EQ(service->handle, 0x0020);
+  ASSERT_EQ(service->uuid, SERVICE_3_UUID);
+}
+
+/* Verify that a service removed from the changed range is dropped */
+TEST(DatabaseBuilderTest, PartialDiscoveryDropsRemovedService) {
+  Database database = BuildThreeServices();
+  DatabaseBuilder builder;
+
+  uint16_t start = 0x0020;
+  uint16_t end = 0xffff;
+  ASSERT_TRUE(builder.StartPartialDiscovery(database, &start, &end));
+  ASSERT_EQ(make_pair_u16(start, end), make_pair_u16(0x0020, 0xffff));
+  EXPECT_FALSE(builder.StartNextServiceExploration());
+
+  Database result = builder.Build();
+  ASSERT_EQ(result.Services().size(), (size_t)2);
+  ASSERT_EQ(result.Services().back().handle, 0x0010);
+}
+
+/* Verify that a change of a service included by a service outside of the
+ * changed range requires a full discovery */
+TEST(DatabaseBuilderTest, PartialDiscoveryIncludedServiceChanged) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddIncludedService(0x0002, SERVICE_2_UUID, 0x0020, 0x002f);
+  Database database = builder.Build();
+
+  uint16_t start = 0x0020;
+  uint16_t end = 0x0022;
+  EXPECT_FALSE(builder.StartPartialDiscovery(database, &start, &end));
+}
+
 }  // namespace gatt
\ No newline at end of file
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "gatt/database_builder.h"
+#include "gatt/database_file.h"
+#include "stack/include/gattdefs.h"
+
+using bluetooth::Uuid;
+
+namespace gatt {
+
+namespace {
+const Uuid CHARACTERISTIC_EXTENDED_PROPERTIES =
+    Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP);
+
+Uuid SERVICE_1_UUID = Uuid::FromString("1800");
+Uuid SERVICE_2_UUID = Uuid::FromString("1801");
+Uuid SERVICE_3_UUID = Uuid::FromString("1802");
+Uuid CHAR_1_UUID = Uuid::FromString("2a00");
+Uuid CHAR_2_UUID = Uuid::FromString("2a01");
+Uuid DESC_1_UUID = Uuid::FromString("2902");
+
+class DatabaseFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/gatt_database_file_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override { unlink(path_.c_str()); }
+
+  /* Database with every kind of stored attribute */
+  Database Build() {
+    DatabaseBuilder builder;
+    builder.AddService(0x0001, 0x0004, SERVICE_1_UUID, true);
+    builder.AddService(0x0005, 0x000a, SERVICE_2_UUID, true);
+    builder.AddService(0x000b, 0x000c, SERVICE_3_UUID, false);
+    builder.AddCharacteristic(0x0002, 0x0003, CHAR_1_UUID, 0x02);
+    builder.AddDescriptor(0x0004, DESC_1_UUID);
+    builder.AddIncludedService(0x0006, SERVICE_3_UUID, 0x000b, 0x000c);
+    builder.AddCharacteristic(0x0007, 0x0008, CHAR_2_UUID, 0x80);
+    builder.AddDescriptor(0x0009, CHARACTERISTIC_EXTENDED_PROPERTIES);
+    builder.AddDescriptor(0x000a, DESC_1_UUID);
+    builder.SetValueOfDescriptors({0x0001});
+    return builder.Build();
+  }
+
+  std::string path_;
+};
+}  // namespace
+
+TEST_F(DatabaseFileTest, round_trip_test) {
+  Database database = Build();
+  Octet16 hash = database.Hash();
+  ASSERT_TRUE(DatabaseFile::Write(path_, database.Serialize(), hash));
+
+  auto file = DatabaseFile::Open(path_);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(hash, file->Hash());
+  EXPECT_EQ(database.Serialize().size(), file->NumAttributes());
+
+  bool success = false;
+  Database loaded = file->ToDatabase(&success);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(database.ToString(), loaded.ToString());
+  EXPECT_EQ(hash, loaded.Hash());
+}
+
+TEST_F(DatabaseFileTest, find_attribute_test) {
+  Database database = Build();
+  ASSERT_TRUE(
+      DatabaseFile::Write(path_, database.Serialize(), database.Hash()));
+  auto file = DatabaseFile::Open(path_);
+  ASSERT_NE(nullptr, file);
+
+  StoredAttribute attr;
+  ASSERT_TRUE(file->FindAttribute(0x0006, &attr));
+  EXPECT_EQ(Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE), attr.type);
+  EXPECT_EQ(0x000b, attr.value.included_service.handle);
+  EXPECT_EQ(0x000c, attr.value.included_service.end_handle);
+  EXPECT_EQ(SERVICE_3_UUID, attr.value.included_service.uuid);
+
+  ASSERT_TRUE(file->FindAttribute(0x0007, &attr));
+  EXPECT_EQ(CHAR_2_UUID, attr.value.characteristic.uuid);
+  EXPECT_EQ(0x0008, attr.value.characteristic.value_handle);
+  EXPECT_EQ(0x80, attr.value.characteristic.properties);
+
+  ASSERT_TRUE(file->FindAttribute(0x0009, &attr));
+  EXPECT_EQ(CHARACTERISTIC_EXTENDED_PROPERTIES, attr.type);
+  EXPECT_EQ(0x0001, attr.value.characteristic_extended_properties);
+
+  /* characteristic values are not stored */
+  EXPECT_FALSE(file->FindAttribute(0x0008, &attr));
+  EXPECT_FALSE(file->FindAttribute(0x00ff, &attr));
+}
+
+TEST_F(DatabaseFileTest, links_share_mapping_test) {
+  Database database = Build();
+  ASSERT_TRUE(
+      DatabaseFile::Write(path_, database.Serialize(), database.Hash()));
+  std::string link_path = path_ + ".link";
+  ASSERT_EQ(0, link(path_.c_str(), link_path.c_str()));
+
+  auto file = DatabaseFile::Open(path_);
+  auto linked = DatabaseFile::Open(link_path);
+  unlink(link_path.c_str());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(file.get(), linked.get());
+}
+
+TEST_F(DatabaseFileTest, rejects_malformed_file_test) {
+  Database database = Build();
+  ASSERT_TRUE(
+      DatabaseFile::Write(path_, database.Serialize(), database.Hash()));
+  ASSERT_EQ(0, truncate(path_.c_str(), 40));
+  EXPECT_EQ(nullptr, DatabaseFile::Open(path_));
+
+  /* version 6 files start with the version and the attribute count */
+  FILE* fd = fopen(path_.c_str(), "wb");
+  ASSERT_NE(nullptr, fd);
+  uint16_t old_header[2] = {6, 0};
+  ASSERT_EQ(1u, fwrite(old_header, sizeof(old_header), 1, fd));
+  fclose(fd);
+  EXPECT_EQ(nullptr, DatabaseFile::Open(path_));
+}
+
+}  // namespace gatt
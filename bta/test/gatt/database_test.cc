@@ -256,6 +256,50 @@ TEST(GattDatabaseTest, hash_test) {
   EXPECT_EQ(hash, expected_hash);
 }
 
+/* This test makes sure that lookups by handle find exactly the attributes
+ * declared at the handle */
+TEST(GattDatabaseTest, find_by_handle_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x0005, Uuid::From16Bit(0x1800), true);
+  builder.AddService(0x0006, 0x000D, Uuid::From16Bit(0x1801), true);
+  builder.AddService(0x0020, 0x0030, Uuid::From16Bit(0x1808), true);
+
+  builder.AddCharacteristic(0x0002, 0x0003, Uuid::From16Bit(0x2A00), 0x0A);
+  builder.AddCharacteristic(0x0004, 0x0005, Uuid::From16Bit(0x2A01), 0x02);
+
+  builder.AddCharacteristic(0x0007, 0x0008, Uuid::From16Bit(0x2A05), 0x20);
+  builder.AddDescriptor(0x0009, Uuid::From16Bit(0x2902));
+  builder.AddCharacteristic(0x000A, 0x000B, Uuid::From16Bit(0x2B29), 0x0A);
+  builder.AddDescriptor(0x000C, Uuid::From16Bit(0x2902));
+  builder.AddDescriptor(0x000D, Uuid::From16Bit(0x2900));
+
+  Database db = builder.Build();
+
+  EXPECT_EQ(db.FindService(0x0001)->handle, 0x0001);
+  EXPECT_EQ(db.FindService(0x000D)->handle, 0x0006);
+  EXPECT_EQ(db.FindService(0x0025)->handle, 0x0020);
+  EXPECT_EQ(db.FindService(0x0000), nullptr);
+  EXPECT_EQ(db.FindService(0x0010), nullptr);
+  EXPECT_EQ(db.FindService(0x0031), nullptr);
+
+  EXPECT_EQ(db.FindCharacteristic(0x0003)->uuid, Uuid::From16Bit(0x2A00));
+  EXPECT_EQ(db.FindCharacteristic(0x000B)->uuid, Uuid::From16Bit(0x2B29));
+  // declarations and descriptors are not characteristic values
+  EXPECT_EQ(db.FindCharacteristic(0x0002), nullptr);
+  EXPECT_EQ(db.FindCharacteristic(0x0009), nullptr);
+  EXPECT_EQ(db.FindCharacteristic(0x0025), nullptr);
+
+  EXPECT_EQ(db.FindDescriptor(0x0009)->uuid, Uuid::From16Bit(0x2902));
+  EXPECT_EQ(db.FindDescriptor(0x000D)->uuid, Uuid::From16Bit(0x2900));
+  EXPECT_EQ(db.FindDescriptor(0x0008), nullptr);
+  EXPECT_EQ(db.FindDescriptor(0x0005), nullptr);
+
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0009)->value_handle, 0x0008);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x000C)->value_handle, 0x000B);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x000D)->value_handle, 0x000B);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x000B), nullptr);
+}
+
 /* This test makes sure that Descriptor represented in StoredAttribute have
  * proper binary format. */
 TEST(GattCacheTest,
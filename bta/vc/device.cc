@@ -47,6 +47,8 @@ void VolumeControlDevice::Disconnect(tGATT_IF gatt_if) {
 
   device_ready = false;
   handles_pending.clear();
+  control_point_busy = false;
+  pending_volume.reset();
 }
 
 /*
@@ -109,7 +111,7 @@ bool VolumeControlDevice::UpdateHandles(void) {
   ResetHandles();
 
   bool vcs_found = false;
-  const std::list<gatt::Service>* services =
+  const std::vector<gatt::Service>* services =
       BTA_GATTC_GetServices(connection_id);
   if (services == nullptr) {
     LOG(ERROR) << "No services found";
@@ -132,6 +134,8 @@ void VolumeControlDevice::ResetHandles(void) {
 
   // the handles are not valid, so discard pending GATT operations
   BtaGattQueue::Clean(connection_id);
+  control_point_busy = false;
+  pending_volume.reset();
 
   volume_state_handle = 0;
   volume_state_ccc_handle = 0;
@@ -152,6 +156,35 @@ void VolumeControlDevice::ControlPointOperation(uint8_t opcode,
                                     set_value, GATT_WRITE, cb, cb_data);
 }
 
+void VolumeControlDevice::SetVolume(uint8_t volume, GATT_WRITE_OP_CB cb,
+                                    void* cb_data) {
+  if (control_point_busy) {
+    pending_volume = volume;
+    return;
+  }
+
+  control_point_busy = true;
+  std::vector<uint8_t> arg({volume});
+  ControlPointOperation(kControlPointOpcodeSetAbsoluteVolume, &arg, cb,
+                        cb_data);
+}
+
+/*
+ * Write the latest volume that was requested while the previous Control Point
+ * write was in flight. The caller is expected to have refreshed the Volume
+ * State first, so that the change counter matches the server.
+ */
+bool VolumeControlDevice::FlushPendingVolume(GATT_WRITE_OP_CB cb,
+                                             void* cb_data) {
+  control_point_busy = false;
+  if (!pending_volume) return false;
+
+  uint8_t volume = *pending_volume;
+  pending_volume.reset();
+  SetVolume(volume, cb, cb_data);
+  return true;
+}
+
 bool VolumeControlDevice::subscribe_for_notifications(tGATT_IF gatt_if,
                                                       uint16_t handle,
                                                       uint16_t ccc_handle,
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <unordered_set>
 #include <vector>
 
@@ -61,6 +62,18 @@ class VolumeControlDevice {
   bool device_ready; /* Set when device read server status and registgered for
                         notifications */
 
+  /* Set while a Control Point write is outstanding. Volume requests arriving
+   * meanwhile only overwrite pending_volume, so a fast moving slider results
+   * in at most one queued write per device.
+   */
+  bool control_point_busy;
+  std::optional<uint8_t> pending_volume;
+
+  /* Last state reported to the upper layer, to skip duplicate reports */
+  bool state_reported;
+  uint8_t reported_volume;
+  bool reported_mute;
+
   VolumeControlDevice(const RawAddress& address, bool first_connection)
       : address(address),
         first_connection(first_connection),
@@ -76,7 +89,11 @@ class VolumeControlDevice {
         volume_control_point_handle(0),
         volume_flags_handle(0),
         volume_flags_ccc_handle(0),
-        device_ready(false) {}
+        device_ready(false),
+        control_point_busy(false),
+        state_reported(false),
+        reported_volume(0),
+        reported_mute(false) {}
 
   ~VolumeControlDevice() = default;
 
@@ -96,6 +113,8 @@ class VolumeControlDevice {
 
   void ControlPointOperation(uint8_t opcode, const std::vector<uint8_t>* arg,
                              GATT_WRITE_OP_CB cb, void* cb_data);
+  void SetVolume(uint8_t volume, GATT_WRITE_OP_CB cb, void* cb_data);
+  bool FlushPendingVolume(GATT_WRITE_OP_CB cb, void* cb_data);
   bool IsEncryptionEnabled();
 
   bool EnableEncryption(tBTM_SEC_CALLBACK* callback);
@@ -183,6 +202,19 @@ class VolumeControlDevices {
     }
   }
 
+  /* Each device has its own GATT queue, so the writes are issued to all the
+   * devices at once; only a device that still has a write outstanding gets
+   * the value parked as pending instead.
+   */
+  void SetVolume(std::vector<RawAddress>& devices, uint8_t volume,
+                 GATT_WRITE_OP_CB cb, void* cb_data) {
+    for (auto& addr : devices) {
+      VolumeControlDevice* device = FindByAddress(addr);
+      if (device && device->IsConnected())
+        device->SetVolume(volume, cb, cb_data);
+    }
+  }
+
  private:
   std::vector<VolumeControlDevice> devices_;
 };
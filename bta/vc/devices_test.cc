@@ -293,7 +293,7 @@ class VolumeControlDeviceTest : public ::testing::Test {
   gatt::MockBtaGattInterface gatt_interface;
   gatt::MockBtaGattQueue gatt_queue;
   bluetooth::manager::MockBtmInterface btm_interface;
-  std::list<gatt::Service> services;
+  std::vector<gatt::Service> services;
 };
 
 TEST_F(VolumeControlDeviceTest, test_service_volume_control_not_found) {
@@ -281,8 +281,10 @@ class VolumeControlImpl : public VolumeControl {
 
     if (!device->device_ready) return;
 
-    callbacks_->OnVolumeStateChanged(device->address, device->volume,
-                                     device->mute);
+    /* A newer volume is about to be written; report once it is applied */
+    if (device->pending_volume) return;
+
+    report_volume_state(device);
   }
 
   void OnVolumeControlFlagsChanged(VolumeControlDevice* device, uint16_t len,
@@ -381,6 +383,39 @@ class VolumeControlImpl : public VolumeControl {
 
     LOG(INFO) << "Write response handle: " << loghex(handle)
               << " status: " << loghex((int)(status));
+
+    if (!device->pending_volume) {
+      device->control_point_busy = false;
+      return;
+    }
+
+    /* The write above bumped the change counter on the server. Refresh the
+     * Volume State before sending the coalesced value, otherwise it would be
+     * rejected with Invalid Change Counter.
+     */
+    BtaGattQueue::ReadCharacteristic(
+        connection_id, device->volume_state_handle,
+        [](uint16_t conn_id, tGATT_STATUS status, uint16_t handle,
+           uint16_t len, uint8_t* value, void* data) {
+          if (instance)
+            instance->OnVolumeStateRefreshed(conn_id, status, handle, len,
+                                             value, data);
+        },
+        nullptr);
+  }
+
+  void OnVolumeStateRefreshed(uint16_t connection_id, tGATT_STATUS status,
+                              uint16_t handle, uint16_t len, uint8_t* value,
+                              void* data) {
+    OnCharacteristicValueChanged(connection_id, status, handle, len, value,
+                                 data);
+
+    VolumeControlDevice* device =
+        volume_control_devices_.FindByConnId(connection_id);
+    if (!device) return;
+
+    if (!device->FlushPendingVolume(write_control_response_static, nullptr))
+      report_volume_state(device);
   }
 
   void SetVolume(std::variant<RawAddress, int> addr_or_group_id,
@@ -390,13 +425,13 @@ class VolumeControlImpl : public VolumeControl {
     if (std::holds_alternative<RawAddress>(addr_or_group_id)) {
       std::vector<RawAddress> devices = {
           std::get<RawAddress>(addr_or_group_id)};
-      std::vector<uint8_t> arg({volume});
-      devices_control_point_helper(devices,
-                                   kControlPointOpcodeSetAbsoluteVolume, &arg);
+      volume_control_devices_.SetVolume(devices, volume,
+                                        write_control_response_static, nullptr);
       return;
     }
 
-    /* TODO implement handling group request */
+    /* TODO implement handling group request. Once group members can be
+     * resolved, pass them all to volume_control_devices_.SetVolume() */
   }
 
   void CleanUp() {
@@ -427,8 +462,7 @@ class VolumeControlImpl : public VolumeControl {
       device->first_connection = false;
 
       // once profile connected we can notify current states
-      callbacks_->OnVolumeStateChanged(device->address, device->volume,
-                                       device->mute);
+      report_volume_state(device, true);
 
       device->EnqueueRemainingRequests(gatt_if_, chrc_read_callback_static,
                                        OnGattWriteCccStatic);
@@ -443,18 +477,27 @@ class VolumeControlImpl : public VolumeControl {
     volume_control_devices_.Remove(device->address);
   }
 
-  void devices_control_point_helper(std::vector<RawAddress>& devices,
-                                    uint8_t opcode,
-                                    const std::vector<uint8_t>* arg) {
-    volume_control_devices_.ControlPointOperation(
-        devices, opcode, arg,
-        [](uint16_t connection_id, tGATT_STATUS status, uint16_t handle,
-           void* data) {
-          if (instance)
-            instance->OnWriteControlResponse(connection_id, status, handle,
-                                             data);
-        },
-        nullptr);
+  /* Skips reports which would not change anything for the upper layer, e.g.
+   * the intermediate states of a coalesced volume change.
+   */
+  void report_volume_state(VolumeControlDevice* device, bool force = false) {
+    if (!force && device->state_reported &&
+        device->reported_volume == device->volume &&
+        device->reported_mute == device->mute)
+      return;
+
+    device->state_reported = true;
+    device->reported_volume = device->volume;
+    device->reported_mute = device->mute;
+    callbacks_->OnVolumeStateChanged(device->address, device->volume,
+                                     device->mute);
+  }
+
+  static void write_control_response_static(uint16_t connection_id,
+                                            tGATT_STATUS status,
+                                            uint16_t handle, void* data) {
+    if (instance)
+      instance->OnWriteControlResponse(connection_id, status, handle, data);
   }
 
   void gattc_callback(tBTA_GATTC_EVT event, tBTA_GATTC* p_data) {
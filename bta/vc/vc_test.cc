@@ -170,7 +170,7 @@ class VolumeControlTest : public ::testing::Test {
         .WillByDefault(
             Invoke([&](uint16_t conn_id,
                        uint16_t handle) -> const gatt::Characteristic* {
-              std::list<gatt::Service>& services = services_map[conn_id];
+              std::vector<gatt::Service>& services = services_map[conn_id];
               for (auto const& service : services) {
                 for (auto const& characteristic : service.characteristics) {
                   if (characteristic.value_handle == handle) {
@@ -186,7 +186,7 @@ class VolumeControlTest : public ::testing::Test {
     ON_CALL(gatt_interface, GetOwningService(_, _))
         .WillByDefault(Invoke(
             [&](uint16_t conn_id, uint16_t handle) -> const gatt::Service* {
-              std::list<gatt::Service>& services = services_map[conn_id];
+              std::vector<gatt::Service>& services = services_map[conn_id];
               for (auto const& service : services) {
                 if (service.handle <= handle && service.end_handle >= handle) {
                   return &service;
@@ -199,7 +199,7 @@ class VolumeControlTest : public ::testing::Test {
     // default action for GetServices function call
     ON_CALL(gatt_interface, GetServices(_))
         .WillByDefault(WithArg<0>(
-            Invoke([&](uint16_t conn_id) -> std::list<gatt::Service>* {
+            Invoke([&](uint16_t conn_id) -> std::vector<gatt::Service>* {
               return &services_map[conn_id];
             })));
 
@@ -396,7 +396,7 @@ class VolumeControlTest : public ::testing::Test {
   gatt::MockBtaGattQueue gatt_queue;
   tBTA_GATTC_CBACK* gatt_callback;
   const uint8_t gatt_if = 0xff;
-  std::map<uint16_t, std::list<gatt::Service>> services_map;
+  std::map<uint16_t, std::vector<gatt::Service>> services_map;
 };
 
 TEST_F(VolumeControlTest, test_get_uninitialized) {
@@ -637,6 +637,32 @@ TEST_F(VolumeControlValueSetTest, test_set_volume) {
                                               GATT_WRITE, _, _));
   VolumeControl::Get()->SetVolume(test_address, 0x10);
 }
+
+TEST_F(VolumeControlValueSetTest, test_set_volume_coalesced) {
+  GATT_WRITE_OP_CB write_cb = nullptr;
+  void* write_cb_data = nullptr;
+  std::vector<uint8_t> first_data({0x04, 0x00, 0x10});
+  std::vector<uint8_t> skipped_data({0x04, 0x00, 0x20});
+  std::vector<uint8_t> last_data({0x04, 0x00, 0x30});
+
+  EXPECT_CALL(gatt_queue, WriteCharacteristic(conn_id, 0x0024, first_data,
+                                              GATT_WRITE, _, _))
+      .WillOnce(DoAll(SaveArg<4>(&write_cb), SaveArg<5>(&write_cb_data)));
+  EXPECT_CALL(gatt_queue, WriteCharacteristic(conn_id, 0x0024, skipped_data,
+                                              GATT_WRITE, _, _))
+      .Times(0);
+  EXPECT_CALL(gatt_queue, WriteCharacteristic(conn_id, 0x0024, last_data,
+                                              GATT_WRITE, _, _));
+  EXPECT_CALL(gatt_queue, ReadCharacteristic(conn_id, 0x0021, _, _));
+  EXPECT_CALL(*callbacks, OnVolumeStateChanged(test_address, _, _)).Times(0);
+
+  VolumeControl::Get()->SetVolume(test_address, 0x10);
+  VolumeControl::Get()->SetVolume(test_address, 0x20);
+  VolumeControl::Get()->SetVolume(test_address, 0x30);
+
+  ASSERT_NE(write_cb, nullptr);
+  write_cb(conn_id, GATT_SUCCESS, 0x0024, write_cb_data);
+}
 }  // namespace
 }  // namespace internal
 }  // namespace vc
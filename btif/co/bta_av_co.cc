@@ -383,6 +383,16 @@ class BtaAvCo {
    */
   bool SetActivePeer(const RawAddress& peer_address);
 
+  /**
+   * Check whether a peer can share the encoded stream of the active peer.
+   *
+   * @param peer_address the peer address
+   * @return true if the peer is opened with the same codec configuration and
+   * content protection as the active peer, and its MTU fits the encoded
+   * packets, otherwise false
+   */
+  bool IsFanoutCompatiblePeer(const RawAddress& peer_address);
+
   /**
    * Get the encoder parameters for a peer.
    *
@@ -1391,6 +1401,11 @@ void BtaAvCo::DataPacketWasDropped(tBTA_AV_HNDL bta_av_handle,
                                    const RawAddress& peer_address) {
   APPL_TRACE_ERROR("%s: peer %s dropped audio packet on handle 0x%x", __func__,
                    peer_address.ToString().c_str(), bta_av_handle);
+
+  // BTA AV drops packets only while the media channel is not draining
+  if (active_peer_ != nullptr && active_peer_->addr == peer_address) {
+    btif_a2dp_source_on_link_congestion();
+  }
 }
 
 void BtaAvCo::ProcessAudioDelay(tBTA_AV_HNDL bta_av_handle,
@@ -1443,6 +1458,25 @@ bool BtaAvCo::SetActivePeer(const RawAddress& peer_address) {
   return true;
 }
 
+bool BtaAvCo::IsFanoutCompatiblePeer(const RawAddress& peer_address) {
+  std::lock_guard<std::recursive_mutex> lock(codec_lock_);
+
+  if (active_peer_ == nullptr || active_peer_->addr == peer_address) {
+    return false;
+  }
+  BtaAvCoPeer* p_peer = FindPeer(peer_address);
+  if (p_peer == nullptr || !p_peer->opened || p_peer->p_sink == nullptr) {
+    return false;
+  }
+  if (p_peer->ContentProtectActive() != active_peer_->ContentProtectActive()) {
+    return false;
+  }
+  // The encoder sizes its packets for the MTU of the active peer
+  if (p_peer->mtu < active_peer_->mtu) return false;
+
+  return A2DP_CodecEquals(p_peer->codec_config, active_peer_->codec_config);
+}
+
 void BtaAvCo::GetPeerEncoderParameters(
     const RawAddress& peer_address,
     tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params) {
@@ -2176,6 +2210,10 @@ bool bta_av_co_set_active_peer(const RawAddress& peer_address) {
   return bta_av_co_cb.SetActivePeer(peer_address);
 }
 
+bool bta_av_co_is_fanout_compatible_peer(const RawAddress& peer_address) {
+  return bta_av_co_cb.IsFanoutCompatiblePeer(peer_address);
+}
+
 void bta_av_co_get_peer_params(const RawAddress& peer_address,
                                tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params) {
   bta_av_co_cb.GetPeerEncoderParameters(peer_address, p_peer_params);
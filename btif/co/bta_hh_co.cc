@@ -22,6 +22,7 @@
 #include <fcntl.h>
 #include <linux/uhid.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -33,6 +34,7 @@
 #include "bta_hh_co.h"
 #include "btif_hh.h"
 #include "btif_util.h"
+#include "common/time_util.h"
 #include "osi/include/osi.h"
 
 const char* dev_path = "/dev/uhid";
@@ -58,18 +60,20 @@ void uhid_set_non_blocking(int fd) {
                      strerror(errno));
 }
 
-/*Internal function to perform UHID write and error checking*/
-static int uhid_write(int fd, const struct uhid_event* ev) {
+/*Internal function to perform UHID write and error checking. uhid accepts
+ * events shorter than struct uhid_event, |len| may stop past the used part */
+static int uhid_write(int fd, const struct uhid_event* ev,
+                      size_t len = sizeof(struct uhid_event)) {
   ssize_t ret;
-  OSI_NO_INTR(ret = write(fd, ev, sizeof(*ev)));
+  OSI_NO_INTR(ret = write(fd, ev, len));
 
   if (ret < 0) {
     int rtn = -errno;
     APPL_TRACE_ERROR("%s: Cannot write to uhid:%s", __func__, strerror(errno));
     return rtn;
-  } else if (ret != (ssize_t)sizeof(*ev)) {
+  } else if (ret != (ssize_t)len) {
     APPL_TRACE_ERROR("%s: Wrong size written to uhid: %zd != %zu", __func__,
-                     ret, sizeof(*ev));
+                     ret, len);
     return -EFAULT;
   }
 
@@ -437,6 +441,18 @@ void bta_hh_co_close(uint8_t dev_handle, uint8_t app_id) {
   }
 }
 
+/* Waits a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
+ * device creation is pending. Returns whether data can be sent. */
+static bool bta_hh_co_wait_ready(btif_hh_device_t* p_dev) {
+  if (p_dev->fd < 0) return false;
+  uint32_t polling_attempts = 0;
+  while (!p_dev->ready_for_data &&
+         polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
+    usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
+  }
+  return p_dev->ready_for_data;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_data
@@ -471,18 +487,8 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
     return;
   }
 
-  // Wait a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
-  // device creation is pending.
-  if (p_dev->fd >= 0) {
-    uint32_t polling_attempts = 0;
-    while (!p_dev->ready_for_data &&
-           polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
-      usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
-    }
-  }
-
   // Send the HID data to the kernel.
-  if ((p_dev->fd >= 0) && p_dev->ready_for_data) {
+  if (bta_hh_co_wait_ready(p_dev)) {
     bta_hh_co_write(p_dev->fd, p_rpt, len);
   } else {
     APPL_TRACE_WARNING("%s: Error: fd = %d, ready %d, len = %d", __func__,
@@ -490,6 +496,61 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_input
+ *
+ * Description      This function is executed by BTA when an LE HID device
+ *                  notifies an input report, or a classic one sends it on
+ *                  the interrupt channel. It is written to uhid right
+ *                  away, from a preallocated event, as gaming devices send
+ *                  reports up to every millisecond.
+ *
+ * Parameters       dev_handle  - device handle
+ *                  rpt_id      - report ID prefixed to the report, 0 if none
+ *                  *p_rpt      - pointer to the report data
+ *                  len         - length of report data
+ *
+ * Returns          void
+ ******************************************************************************/
+void bta_hh_co_input(uint8_t dev_handle, uint8_t rpt_id, const uint8_t* p_rpt,
+                     uint16_t len) {
+  /* Only written to from the main thread */
+  static struct uhid_event ev;
+
+  btif_hh_device_t* p_dev = btif_hh_find_connected_dev_by_handle(dev_handle);
+  if (p_dev == NULL) {
+    APPL_TRACE_WARNING("%s: Error: unknown HID device handle %d", __func__,
+                       dev_handle);
+    return;
+  }
+  if (!bta_hh_co_wait_ready(p_dev)) {
+    APPL_TRACE_WARNING("%s: Error: fd = %d, ready %d, len = %d", __func__,
+                       p_dev->fd, p_dev->ready_for_data, len);
+    return;
+  }
+
+  size_t size = len + (rpt_id != 0 ? 1 : 0);
+  if (size > sizeof(ev.u.input2.data)) {
+    APPL_TRACE_WARNING("%s: Report size greater than allowed size", __func__);
+    return;
+  }
+  ev.type = UHID_INPUT2;
+  ev.u.input2.size = size;
+  uint8_t* p = ev.u.input2.data;
+  if (rpt_id != 0) *p++ = rpt_id;
+  memcpy(p, p_rpt, len);
+
+  if (uhid_write(p_dev->fd, &ev, offsetof(struct uhid_event, u.input2.data) +
+                                     size) == 0) {
+    uint64_t rx_time_us = btu_hci_rx_time_us();
+    if (rx_time_us != 0) {
+      btif_hh_record_input_latency(
+          bluetooth::common::time_get_os_boottime_us() - rx_time_us);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_send_hid_info
@@ -124,6 +124,10 @@ void btif_a2dp_source_set_tx_flush(bool enable);
 // Returns the next A2DP buffer to send if available, otherwise NULL.
 BT_HDR* btif_a2dp_source_audio_readbuf(void);
 
+// Notify the A2DP Source that a media packet for the active peer was dropped
+// below the TX queue because the L2CAP channel is congested.
+void btif_a2dp_source_on_link_congestion(void);
+
 // Dump debug-related information for the A2DP Source module.
 // |fd| is the file descriptor to use for writing the ASCII formatted
 // information.
@@ -26,6 +26,12 @@
 // Returns true on success, otherwise false.
 bool bta_av_co_set_active_peer(const RawAddress& peer_addr);
 
+// Checks whether the peer |peer_addr| can be fed the packets encoded for the
+// active peer: it must be opened with the same codec configuration and
+// content protection, and an MTU at least as large.
+// Returns true if the peer is compatible, otherwise false.
+bool bta_av_co_is_fanout_compatible_peer(const RawAddress& peer_addr);
+
 // Gets the A2DP peer parameters that are used to initialize the encoder.
 // The peer address is |peer_addr|.
 // The parameters are stored in |p_peer_params|.
@@ -53,6 +53,13 @@ void BtifAvrcpAudioTrackPause(void* handle);
  */
 void BtifAvrcpSetAudioTrackGain(void* handle, float gain);
 
+/**
+ * Sets the ratio of output to input frames. Once set, the written data is
+ * resampled with linear interpolation, which lets the caller compensate for
+ * drift between the remote and the local audio clocks.
+ */
+void BtifAvrcpAudioTrackSetResampleRatio(void* handle, float ratio);
+
 /**
  * Stop / Delete the audio track.
  * Delete should usually be called stop.
@@ -101,6 +101,13 @@ static constexpr int8_t kCriWarnRssi = -80;
 static constexpr uint8_t kCriWarnUnusedCh = 55;
 // The queue size of recording the BQR events.
 static constexpr uint8_t kBqrEventQueueSize = 25;
+// Length of the windows the Link Quality events of a connection are
+// aggregated over.
+static constexpr uint32_t kLinkQualityStatsWindowMs = 1000;
+// Size of the pending trace log data that triggers a write to the file.
+static constexpr size_t kTraceLogFlushBytes = 4096;
+// Delay after which pending trace log data is written to the file.
+static constexpr uint32_t kTraceLogFlushDelayMs = 1000;
 // The Property of BQR event mask configuration.
 static constexpr const char* kpPropertyEventMask =
     "persist.bluetooth.bqr.event_mask";
@@ -120,15 +127,6 @@ static constexpr const char* kpBtSchedulingTraceLogPath =
 static constexpr const char* kpBtSchedulingTraceLastLogPath =
     "/data/misc/bluetooth/logs/bt_scheduling_trace.log.last";
 
-// File Descriptor of LMP/LL message trace log
-static int LmpLlMessageTraceLogFd = INVALID_FD;
-// File Descriptor of Bluetooth Multi-profile/Coex scheduling trace log
-static int BtSchedulingTraceLogFd = INVALID_FD;
-// Counter of LMP/LL message trace
-static uint16_t LmpLlMessageTraceCounter = 0;
-// Counter of Bluetooth Multi-profile/Coex scheduling trace
-static uint16_t BtSchedulingTraceCounter = 0;
-
 // Action definition
 //
 // Action to Add, Delete or Clear the reporting of quality event(s).
@@ -256,6 +254,34 @@ typedef struct {
   uint8_t* vendor_specific_parameter;
 } BqrLogDumpEvent;
 
+// Link quality of a connection, aggregated over the Link Quality related BQR
+// events received during a window of kLinkQualityStatsWindowMs.
+typedef struct {
+  // Sequence number of the window, incremented each time a window of the
+  // connection completes.
+  uint32_t window_seq;
+  // Boot time of the first event of the window.
+  // Unit: ms
+  uint64_t window_start_ms;
+  // Count of the events received during the window.
+  uint16_t event_count;
+  // Count of the A2DP Audio Choppy events.
+  uint16_t a2dp_choppy_count;
+  // Count of the SCO Voice Choppy events.
+  uint16_t sco_choppy_count;
+  // Average and minimum of the RSSI values.
+  int8_t rssi_avg;
+  int8_t rssi_min;
+  // Average of the SNR values.
+  uint8_t snr_avg;
+  // Sums of the counts reported by the events.
+  uint32_t retransmission_count;
+  uint32_t no_rx_count;
+  uint32_t nak_count;
+  uint32_t flow_off_count;
+  uint32_t buffer_overflow_bytes;
+} BqrLinkQualityStats;
+
 // BQR sub-event of Vendor Specific Event
 class BqrVseSubEvt {
  public:
@@ -264,19 +290,14 @@ class BqrVseSubEvt {
   // @param length Total length of all parameters contained in the sub-event.
   // @param p_param_buf A pointer to the parameters contained in the sub-event.
   void ParseBqrLinkQualityEvt(uint8_t length, uint8_t* p_param_buf);
-  // Write the LMP/LL message trace to the log file.
-  //
-  // @param fd The File Descriptor of the log file.
-  // @param length Total length of all parameters contained in the sub-event.
-  // @param p_param_buf A pointer to the parameters contained in the sub-event.
-  void WriteLmpLlTraceLogFile(int fd, uint8_t length, uint8_t* p_param_buf);
-  // Write the Bluetooth Multi-profile/Coex scheduling trace to the log file.
+  // Parse the Log Dump related BQR event and append it to a trace log, as it
+  // is written to the trace log files. tm_timestamp_ shall already be set.
   //
-  // @param fd The File Descriptor of the log file.
   // @param length Total length of all parameters contained in the sub-event.
   // @param p_param_buf A pointer to the parameters contained in the sub-event.
-  void WriteBtSchedulingTraceLogFile(int fd, uint8_t length,
-                                     uint8_t* p_param_buf);
+  // @param p_log The trace log data to append the event to.
+  void AppendLogDumpEvt(uint8_t length, const uint8_t* p_param_buf,
+                        std::string* p_log);
   // Get a string representation of the Bluetooth Quality event.
   //
   // @return a string representation of the Bluetooth Quality event.
@@ -313,6 +334,7 @@ std::string PacketTypeToString(uint8_t packet_type);
 // property "persist.bluetooth.bqr.event_mask".
 // And the minimum time interval of quality event reporting depends on the
 // setting of property "persist.bluetooth.bqr.min_interval_ms".
+// The BQR thread the events are handled on runs while the report is enabled.
 //
 // @param is_enable True/False to enable/disable Bluetooth Quality Report
 //   mechanism in the Bluetooth controller.
@@ -346,23 +368,22 @@ void ConfigureBqrCmpl(uint32_t current_evt_mask);
 void CategorizeBqrEvent(uint8_t length, uint8_t* p_bqr_event);
 
 // Record a new incoming Link Quality related BQR event in quality event queue.
+// The event is parsed in place, then logged, reported and aggregated on the
+// BQR thread.
 //
 // @param length Lengths of the Link Quality related BQR event.
 // @param p_link_quality_event A pointer to the Link Quality related BQR event.
 void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event);
 
 // Dump the LMP/LL message handshaking with the remote device to a log file.
+// The event is copied and written in a batch from the BQR thread.
 //
 // @param length Lengths of the LMP/LL message trace event.
 // @param p_lmp_ll_message_event A pointer to the LMP/LL message trace event.
 void DumpLmpLlMessage(uint8_t length, uint8_t* p_lmp_ll_message_event);
 
-// Open the LMP/LL message trace log file.
-//
-// @return a file descriptor of the LMP/LL message trace log file.
-int OpenLmpLlTraceLogFile();
-
 // Dump the Bluetooth Multi-profile/Coex scheduling information to a log file.
+// The event is copied and written in a batch from the BQR thread.
 //
 // @param length Lengths of the Bluetooth Multi-profile/Coex scheduling trace
 //   event.
@@ -370,11 +391,15 @@ int OpenLmpLlTraceLogFile();
 //   scheduling trace event.
 void DumpBtScheduling(uint8_t length, uint8_t* p_bt_scheduling_event);
 
-// Open the Bluetooth Multi-profile/Coex scheduling trace log file.
+// Get the link quality of a connection, aggregated over the last completed
+// window. A window completes when the first event after its end is received.
+// This can be called from any thread.
 //
-// @return a file descriptor of the Bluetooth Multi-profile/Coex scheduling
-//   trace log file.
-int OpenBtSchedulingTraceLogFile();
+// @param connection_handle The connection handle of the connection.
+// @param p_stats The link quality of the connection, set on success.
+// @return true if a window of the connection has completed.
+bool GetLinkQualityStats(uint16_t connection_handle,
+                         BqrLinkQualityStats* p_stats);
 
 // Dump Bluetooth Quality Report information.
 //
@@ -23,7 +23,9 @@
 
 #include "bt_types.h"
 
+#include <functional>
 #include <list>
+#include <optional>
 #include <string>
 #include "osi/include/config.h"
 #include "types/ble_address_with_type.h"
@@ -37,10 +39,17 @@ static const std::string BT_CONFIG_KEY_SDP_DI_HW_VERSION =
     "SdpDiHardwareVersion";
 static const std::string BT_CONFIG_KEY_SDP_DI_VENDOR_ID_SRC =
     "SdpDiVendorIdSource";
+static const std::string BT_CONFIG_KEY_SDP_CACHE = "SdpCache";
+static const std::string BT_CONFIG_KEY_SDP_CACHE_FINGERPRINT =
+    "SdpCacheFingerprint";
 
 static const std::string BT_CONFIG_KEY_REMOTE_VER_MFCT = "Manufacturer";
 static const std::string BT_CONFIG_KEY_REMOTE_VER_VER = "LmpVer";
 static const std::string BT_CONFIG_KEY_REMOTE_VER_SUBVER = "LmpSubVer";
+static const std::string BT_CONFIG_KEY_RMT_NAME = "Name";
+static const std::string BT_CONFIG_KEY_RMT_NAME_TIME = "RmtNameTime";
+static const std::string BT_CONFIG_KEY_RMT_FEATURES = "RmtFeatures";
+static const std::string BT_CONFIG_KEY_RMT_INFO_TIME = "RmtInfoTime";
 
 bool btif_config_exist(const std::string& section, const std::string& key);
 bool btif_config_get_int(const std::string& section, const std::string& key,
@@ -65,6 +74,19 @@ size_t btif_config_get_bin_length(const std::string& section,
                                   const std::string& key);
 
 std::vector<RawAddress> btif_config_get_paired_devices();
+// Calls |visitor| with every property of the paired devices, in one pass over
+// the config. |visitor| must not call back into btif_config. Values are given
+// as stored, e.g. keys kept by the keystore read as "encrypted".
+void btif_config_for_each_paired_device_property(
+    const std::function<void(const RawAddress& address, const std::string& key,
+                             const std::string& value)>& visitor);
+// Returns a count of the changes made to the config, to tell whether data read
+// from it is still current, or std::nullopt if the config may change without
+// being counted.
+std::optional<uint64_t> btif_config_get_change_count(void);
+
+// Loads every encrypted key of the config from the keystore at once
+void btif_config_load_encrypted_keys(void);
 
 void btif_config_save(void);
 void btif_config_flush(void);
@@ -16,10 +16,11 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <unordered_set>
 
-#include "common/lru.h"
+#include "common/flat_lru.h"
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 #include "raw_address.h"
@@ -33,6 +34,11 @@ class BtifConfigCache {
   void Init(std::unique_ptr<config_t> source);
   std::vector<std::string> GetPersistentSectionNames();
   config_t PersistentSectionCopy();
+  // Calls |visitor| with every entry of the persistent sections, in order
+  void ForEachPersistentEntry(
+      const std::function<void(const std::string& section_name,
+                               const std::string& key,
+                               const std::string& value)>& visitor);
   bool HasSection(const std::string& section_name);
   bool HasUnpairedSection(const std::string& section_name);
   bool HasPersistentSection(const std::string& section_name);
@@ -55,7 +61,8 @@ class BtifConfigCache {
                               const std::string& key);
 
  private:
-  bluetooth::common::LegacyLruCache<std::string, section_t>
+  // accessed under the lock of btif_config.cc, like paired_devices_list_
+  bluetooth::common::FlatLruCache<std::string, section_t>
       unpaired_devices_cache_;
   config_t paired_devices_list_;
 };
@@ -137,4 +137,9 @@ extern void btif_hh_getreport(btif_hh_device_t* p_dev,
                               uint16_t bufferSize);
 extern void btif_hh_service_registration(bool enable);
 
+/* Records the time from the HCI reception of an input report to its write to
+ * uhid */
+extern void btif_hh_record_input_latency(uint64_t latency_us);
+extern void btif_debug_hh_dump(int fd);
+
 #endif
@@ -35,6 +35,15 @@ bt_status_t btif_queue_connect(uint16_t uuid, const RawAddress* bda,
                                btif_connect_cb_t connect_cb);
 void btif_queue_cleanup(uint16_t uuid);
 void btif_queue_advance();
+void btif_queue_advance_by_address(const RawAddress& bda);
+
+/**
+ * Run the connect requests of different devices in parallel, one per device,
+ * the ones of devices already connected first. Used to bring many devices
+ * back quickly when the stack comes up.
+ * NOTE: Must be called on the JNI thread.
+ */
+void btif_queue_set_fast_reconnect(bool enable);
 
 /**
  * Dispatch the next pending connect request.
@@ -0,0 +1,85 @@
+/*
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "common/lru.h"
+#include "raw_address.h"
+
+// Drops scan results that repeat the last result reported for the same
+// advertiser: same event type and advertising data, an RSSI within
+// |rssi_threshold| dB, less than |window_ms| after it. A |window_ms| of 0
+// reports every result.
+class BtifScanFilter {
+ public:
+  BtifScanFilter(size_t capacity, uint64_t window_ms, int rssi_threshold);
+
+  // Returns true if the result must be reported, false if it is a repeat
+  bool ShouldReport(const RawAddress& bd_addr, uint16_t evt_type, int8_t rssi,
+                    const std::vector<uint8_t>& data, uint64_t now_ms);
+  void Clear();
+
+  uint64_t GetReportedCount() const { return reported_count_; }
+  uint64_t GetSuppressedCount() const { return suppressed_count_; }
+
+ private:
+  struct LastReport {
+    uint16_t evt_type;
+    int8_t rssi;
+    uint64_t time_ms;
+    std::vector<uint8_t> data;
+  };
+
+  bluetooth::common::LegacyLruCache<RawAddress, LastReport> last_reports_;
+  uint64_t window_ms_;
+  int rssi_threshold_;
+  uint64_t reported_count_ = 0;
+  uint64_t suppressed_count_ = 0;
+};
+
+// The result filters of the registered scanners, keyed by scanner id. The
+// scanners share one result stream, so a result is dropped only if every
+// registered scanner has a filter and each of them drops it. Scanners report
+// every result until they set a filter.
+class BtifScannerFilters {
+ public:
+  explicit BtifScannerFilters(size_t capacity) : capacity_(capacity) {}
+
+  void AddScanner(int scanner_id);
+  void RemoveScanner(int scanner_id);
+
+  // Sets the filter of a registered scanner. A |window_ms| of 0 removes it.
+  void SetFilter(int scanner_id, uint64_t window_ms, int rssi_threshold);
+
+  bool ShouldReport(const RawAddress& bd_addr, uint16_t evt_type, int8_t rssi,
+                    const std::vector<uint8_t>& data, uint64_t now_ms);
+  void Clear();
+
+  uint64_t GetReportedCount() const { return reported_count_; }
+  uint64_t GetSuppressedCount() const { return suppressed_count_; }
+
+ private:
+  size_t capacity_;
+  // A scanner without a filter maps to nullptr
+  std::map<int, std::unique_ptr<BtifScanFilter>> scanners_;
+  uint64_t reported_count_ = 0;
+  uint64_t suppressed_count_ = 0;
+};
@@ -24,5 +24,7 @@
 
 const btsock_interface_t* btif_sock_get_interface(void);
 
+// Enables the sockets when the stack comes up. The socket threads and slots
+// are only started by the first listen or connect.
 bt_status_t btif_sock_init(uid_set_t* uid_set);
 void btif_sock_cleanup(void);
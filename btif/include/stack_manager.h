@@ -20,8 +20,6 @@
 
 #include <stdbool.h>
 
-#include "osi/include/future.h"
-
 typedef struct {
   void (*init_stack)(void);
   void (*start_up_stack_async)(void);
@@ -33,6 +31,10 @@ typedef struct {
 
 const stack_manager_t* stack_manager_get_interface();
 
-// TODO(zachoverflow): remove this terrible hack once the startup sequence is
-// more sane
-future_t* stack_manager_get_hack_future();
+// Signals that the asynchronous part of the pending stage of the stack start up
+// or shut down is done, e.g. that btif is enabled. Can be called from any
+// thread.
+void stack_manager_signal_stage_done();
+
+// Dumps the timings of the stages of the last stack start up and shut down
+void stack_manager_dump(int fd);
@@ -71,17 +71,22 @@
 #include "common/os_utils.h"
 #include "device/include/interop.h"
 #include "gd/common/init_flags.h"
+#include "gd/common/task_latency_stats.h"
+#include "gd/common/trace_ring.h"
 #include "main/shim/dumpsys.h"
 #include "main/shim/shim.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack/include/avdt_api.h"
 #include "stack/include/btm_api.h"
+#include "stack/include/btm_iso_api.h"
 #include "stack/include/btu.h"
+#include "stack/include/gatt_api.h"
 #include "stack_manager.h"
 
 using bluetooth::hearing_aid::HearingAidInterface;
@@ -114,6 +119,7 @@ extern const btav_sink_interface_t* btif_av_get_sink_interface();
 extern const btsock_interface_t* btif_sock_get_interface();
 /* hid host profile */
 extern const bthh_interface_t* btif_hh_get_interface();
+extern void btif_debug_hh_dump(int fd);
 /* hid device profile */
 extern const bthd_interface_t* btif_hd_get_interface();
 /*pan*/
@@ -388,20 +394,27 @@ static int read_energy_info() {
 }
 
 static void dump(int fd, const char** arguments) {
+  stack_manager_dump(fd);
   btif_debug_conn_dump(fd);
   btif_debug_bond_event_dump(fd);
   btif_debug_a2dp_dump(fd);
   btif_debug_av_dump(fd);
+  btif_debug_hh_dump(fd);
   bta_debug_av_dump(fd);
   stack_debug_avdtp_api_dump(fd);
   bluetooth::avrcp::AvrcpService::DebugDump(fd);
   btif_debug_config_dump(fd);
   BTA_HfClientDumpStatistics(fd);
+  BTA_DmPmDumpStatistics(fd);
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
   alarm_debug_dump(fd);
+  bluetooth::common::TaskLatencyStats::DebugDump(fd);
+  bluetooth::common::TraceRing::DebugDump(fd);
   HearingAid::DebugDump(fd);
+  bluetooth::hci::IsoManager::GetInstance()->Dump(fd);
   connection_manager::dump(fd);
+  GATT_Dump(fd);
   bluetooth::bqr::DebugDump(fd);
   if (bluetooth::shim::is_any_gd_enabled()) {
     bluetooth::shim::Dump(fd, arguments);
@@ -550,9 +563,17 @@ static bt_os_callouts_t wakelock_os_callouts_jni = {
     release_wake_lock_cb,
 };
 
+// Each wakelock acquired through the JNI callouts is a binder transaction to
+// the power manager: keep it across the short gaps between media and ACL
+// bursts rather than cycling it.
+#define WAKELOCK_HOLD_OVER_MS_PROPERTY "persist.bluetooth.wakelock_hold_over_ms"
+#define WAKELOCK_HOLD_OVER_MS_DEFAULT 100
+
 static int set_os_callouts(bt_os_callouts_t* callouts) {
   wakelock_os_callouts_saved = callouts;
   wakelock_set_os_callouts(&wakelock_os_callouts_jni);
+  wakelock_set_hold_over_ms(osi_property_get_int32(
+      WAKELOCK_HOLD_OVER_MS_PROPERTY, WAKELOCK_HOLD_OVER_MS_DEFAULT));
   return BT_STATUS_SUCCESS;
 }
 
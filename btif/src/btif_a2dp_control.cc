@@ -130,7 +130,7 @@ static void btif_a2dp_recv_ctrl_data(void) {
       if (btif_av_stream_ready()) {
         /* Setup audio data channel listener */
         UIPC_Open(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, btif_a2dp_data_cb,
-                  A2DP_DATA_PATH);
+                  A2DP_DATA_PATH, UIPC_CH_TYPE_SHM);
 
         /*
          * Post start event and wait for audio path to open.
@@ -149,7 +149,7 @@ static void btif_a2dp_recv_ctrl_data(void) {
          * back immediately.
          */
         UIPC_Open(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, btif_a2dp_data_cb,
-                  A2DP_DATA_PATH);
+                  A2DP_DATA_PATH, UIPC_CH_TYPE_SHM);
         btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
         break;
       }
@@ -20,9 +20,13 @@
 #define LOG_TAG "bt_btif_a2dp_sink"
 
 #include <base/bind.h>
+#include <inttypes.h>
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "bt_target.h"  // Must be first to define build configuration
 
@@ -31,14 +35,18 @@
 #include "btif/include/btif_av_co.h"
 #include "btif/include/btif_avrcp_audio_track.h"
 #include "btif/include/btif_util.h"  // CASE_RETURN_STR
+#include "common/lock_free_leaky_bonded_queue.h"
 #include "common/message_loop_thread.h"
+#include "common/time_util.h"
 #include "osi/include/alarm.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/allocator.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"  // UNUSED_ATTR
 #include "stack/include/bt_types.h"
 
+using bluetooth::common::LockFreeLeakyBondedQueue;
 using bluetooth::common::MessageLoopThread;
 using LockGuard = std::lock_guard<std::mutex>;
 
@@ -52,6 +60,29 @@ using LockGuard = std::lock_guard<std::mutex>;
 /* In case of A2DP Sink, we will delay start by 5 AVDTP Packets */
 #define MAX_A2DP_DELAYED_START_FRAME_COUNT 5
 
+/* Jitter buffer depth bounds, in AVDTP packets. The upper bound leaves room
+ * below MAX_INPUT_A2DP_FRAME_QUEUE_SZ so bursts are not dropped. */
+#define A2DP_SINK_JITTER_MIN_DEPTH 2
+#define A2DP_SINK_JITTER_MAX_DEPTH (MAX_INPUT_A2DP_FRAME_QUEUE_SZ / 2)
+
+/* Arrivals to observe before the depth follows the measured jitter */
+#define A2DP_SINK_JITTER_MIN_ARRIVALS 16
+
+/* Depth margin, in multiples of the mean inter-arrival deviation */
+#define A2DP_SINK_JITTER_MARGIN 4
+
+/* Gains of the PI loop on the buffer depth error (in seconds). The integral
+ * term settles on the clock drift between the source and the local clock. */
+#define A2DP_SINK_DRIFT_KP 0.005
+#define A2DP_SINK_DRIFT_KI 0.00002
+#define A2DP_SINK_DRIFT_MAX 0.002       /* 2000 ppm */
+#define A2DP_SINK_RATE_ADJUST_MAX 0.005 /* 5000 ppm */
+
+#define A2DP_SINK_HIST_BUCKETS 8
+
+/* Decoded PCM blocks, one per decode tick, waiting for the output thread */
+#define A2DP_SINK_PCM_RING_BLOCKS 8
+
 enum {
   BTIF_A2DP_SINK_STATE_OFF,
   BTIF_A2DP_SINK_STATE_STARTING_UP,
@@ -79,11 +110,65 @@ typedef struct {
   btif_a2dp_sink_focus_state_t focus_state;
 } tBTIF_MEDIA_SINK_FOCUS_UPDATE;
 
+/* Adaptive jitter buffer. The target depth follows the measured packet
+ * inter-arrival jitter, and each decode tick consumes the audio due for the
+ * elapsed time, scaled by a rate adjustment that keeps the depth on target.
+ * The same adjustment drives the fractional resampler of the audio track. */
+struct BtifA2dpSinkJitterBuffer {
+  /* Stream state, reset whenever the stream restarts */
+  uint64_t last_arrival_us = 0;
+  uint64_t last_tick_us = 0;
+  bool playing = false;        /* prebuffered and consuming */
+  double credit_frames = 0;    /* input frames still due for playout */
+  uint64_t decoded_frames = 0; /* PCM frames produced by the decoder */
+
+  /* Estimates, kept across restarts of the same stream */
+  uint32_t arrivals = 0;
+  double mean_interval_us = 0;
+  double jitter_us = 0; /* mean deviation from mean_interval_us */
+  size_t target_depth = MAX_A2DP_DELAYED_START_FRAME_COUNT;
+  double frames_per_packet = 0;
+  double depth_err_s = 0;
+  double drift = 0;       /* source rate / local rate - 1 */
+  double rate_adjust = 0; /* consumed / nominal input rate - 1 */
+
+  /* Statistics */
+  size_t underrun_count = 0;
+  uint64_t jitter_hist[A2DP_SINK_HIST_BUCKETS] = {};
+  uint64_t depth_hist[A2DP_SINK_HIST_BUCKETS] = {};
+
+  void RestartStream() {
+    last_arrival_us = 0;
+    last_tick_us = 0;
+    playing = false;
+    credit_frames = 0;
+  }
+
+  void ResetEstimates() {
+    RestartStream();
+    arrivals = 0;
+    mean_interval_us = 0;
+    jitter_us = 0;
+    target_depth = MAX_A2DP_DELAYED_START_FRAME_COUNT;
+    frames_per_packet = 0;
+    depth_err_s = 0;
+    drift = 0;
+    rate_adjust = 0;
+  }
+};
+
 /* BTIF A2DP Sink control block */
 class BtifA2dpSinkControlBlock {
  public:
-  explicit BtifA2dpSinkControlBlock(const std::string& thread_name)
+  BtifA2dpSinkControlBlock(const std::string& thread_name,
+                           const std::string& output_thread_name)
       : worker_thread(thread_name),
+        output_thread(output_thread_name),
+        pcm_ring(A2DP_SINK_PCM_RING_BLOCKS),
+        pcm_block(nullptr),
+        output_pending(false),
+        resample_ratio(0),
+        dropped_pcm_blocks(0),
         rx_audio_queue(nullptr),
         rx_flush(false),
         decode_alarm(nullptr),
@@ -94,11 +179,20 @@ class BtifA2dpSinkControlBlock {
         decoder_interface(nullptr) {}
 
   void Reset() {
-    if (audio_track != nullptr) {
-      BtifAvrcpAudioTrackStop(audio_track);
-      BtifAvrcpAudioTrackDelete(audio_track);
+    {
+      LockGuard lock(track_mutex);
+      if (audio_track != nullptr) {
+        BtifAvrcpAudioTrackStop(audio_track);
+        BtifAvrcpAudioTrackDelete(audio_track);
+      }
+      audio_track = nullptr;
     }
-    audio_track = nullptr;
+    pcm_ring.Clear();
+    delete pcm_block;
+    pcm_block = nullptr;
+    output_pending = false;
+    resample_ratio = 0;
+    dropped_pcm_blocks = 0;
     fixed_queue_free(rx_audio_queue, nullptr);
     rx_audio_queue = nullptr;
     alarm_free(decode_alarm);
@@ -108,9 +202,20 @@ class BtifA2dpSinkControlBlock {
     sample_rate = 0;
     channel_count = 0;
     decoder_interface = nullptr;
+    jitter_buffer = BtifA2dpSinkJitterBuffer();
   }
 
   MessageLoopThread worker_thread;
+  /* Writes the decoded PCM to the audio track, which may block, so that the
+   * decode ticks keep their pace */
+  MessageLoopThread output_thread;
+  LockFreeLeakyBondedQueue<std::vector<uint8_t>> pcm_ring;
+  std::vector<uint8_t>* pcm_block; /* PCM decoded in the current tick */
+  std::atomic<bool> output_pending; /* output thread has a drain queued */
+  std::atomic<float> resample_ratio; /* to apply on the next write, or 0 */
+  std::atomic<uint64_t> dropped_pcm_blocks;
+  /* Held by the output thread while it writes, and to change the track */
+  std::mutex track_mutex;
   fixed_queue_t* rx_audio_queue;
   bool rx_flush; /* discards any incoming data when true */
   alarm_t* decode_alarm;
@@ -120,12 +225,14 @@ class BtifA2dpSinkControlBlock {
   btif_a2dp_sink_focus_state_t rx_focus_state; /* audio focus state */
   void* audio_track;
   const tA2DP_DECODER_INTERFACE* decoder_interface;
+  BtifA2dpSinkJitterBuffer jitter_buffer;
 };
 
 // Mutex for below data structures.
 static std::mutex g_mutex;
 
-static BtifA2dpSinkControlBlock btif_a2dp_sink_cb("bt_a2dp_sink_worker_thread");
+static BtifA2dpSinkControlBlock btif_a2dp_sink_cb(
+    "bt_a2dp_sink_worker_thread", "bt_a2dp_sink_output_thread");
 
 static std::atomic<int> btif_a2dp_sink_state{BTIF_A2DP_SINK_STATE_OFF};
 
@@ -153,6 +260,8 @@ static void btif_a2dp_sink_audio_rx_flush_event();
 static void btif_a2dp_sink_clear_track_event_req();
 static void btif_a2dp_sink_on_start_event();
 static void btif_a2dp_sink_on_suspend_event();
+static void btif_a2dp_sink_output_pcm_block();
+static void btif_a2dp_sink_output_drain();
 
 UNUSED_ATTR static const char* dump_media_event(uint16_t event) {
   switch (event) {
@@ -188,6 +297,14 @@ bool btif_a2dp_sink_init() {
     return false;
   }
 
+  btif_a2dp_sink_cb.output_thread.StartUp();
+  if (!btif_a2dp_sink_cb.output_thread.IsRunning()) {
+    LOG_ERROR("%s: unable to start up media output thread", __func__);
+    btif_a2dp_sink_cb.worker_thread.ShutDown();
+    btif_a2dp_sink_state = BTIF_A2DP_SINK_STATE_OFF;
+    return false;
+  }
+
   btif_a2dp_sink_cb.rx_audio_queue = fixed_queue_new(SIZE_MAX);
 
   /* Schedule the rest of the operations */
@@ -195,6 +312,9 @@ bool btif_a2dp_sink_init() {
     LOG(FATAL) << __func__
                << ": Failed to increase A2DP decoder thread priority";
   }
+  if (!btif_a2dp_sink_cb.output_thread.EnableRealTimeScheduling()) {
+    LOG_ERROR("%s: unable to increase A2DP output thread priority", __func__);
+  }
   btif_a2dp_sink_cb.worker_thread.DoInThread(
       FROM_HERE, base::BindOnce(btif_a2dp_sink_init_delayed));
   return true;
@@ -322,6 +442,10 @@ void btif_a2dp_sink_cleanup() {
   btif_a2dp_sink_cb.worker_thread.DoInThread(
       FROM_HERE, base::BindOnce(btif_a2dp_sink_cleanup_delayed));
   btif_a2dp_sink_cb.worker_thread.ShutDown();
+
+  // Nothing is decoded anymore, drop what was not played yet
+  btif_a2dp_sink_cb.output_thread.ShutDown();
+  btif_a2dp_sink_cb.pcm_ring.Clear();
 }
 
 static void btif_a2dp_sink_cleanup_delayed() {
@@ -458,6 +582,7 @@ static void btif_a2dp_sink_audio_handle_stop_decoding() {
     LockGuard lock(g_mutex);
     btif_a2dp_sink_cb.rx_flush = true;
     btif_a2dp_sink_audio_rx_flush_req();
+    btif_a2dp_sink_cb.jitter_buffer.RestartStream();
     old_alarm = btif_a2dp_sink_cb.decode_alarm;
     btif_a2dp_sink_cb.decode_alarm = nullptr;
   }
@@ -470,6 +595,8 @@ static void btif_a2dp_sink_audio_handle_stop_decoding() {
 
   {
     LockGuard lock(g_mutex);
+    btif_a2dp_sink_cb.pcm_ring.Clear();
+    LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
 #ifndef OS_GENERIC
     BtifAvrcpAudioTrackPause(btif_a2dp_sink_cb.audio_track);
 #endif
@@ -485,6 +612,8 @@ static void btif_decode_alarm_cb(UNUSED_ATTR void* context) {
 static void btif_a2dp_sink_clear_track_event() {
   LOG_INFO("%s", __func__);
   LockGuard lock(g_mutex);
+  btif_a2dp_sink_cb.pcm_ring.Clear();
+  LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
 
 #ifndef OS_GENERIC
   BtifAvrcpAudioTrackStop(btif_a2dp_sink_cb.audio_track);
@@ -500,7 +629,10 @@ static void btif_a2dp_sink_audio_handle_start_decoding() {
     return;  // Already started decoding
 
 #ifndef OS_GENERIC
-  BtifAvrcpAudioTrackStart(btif_a2dp_sink_cb.audio_track);
+  {
+    LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
+    BtifAvrcpAudioTrackStart(btif_a2dp_sink_cb.audio_track);
+  }
 #endif
 
   btif_a2dp_sink_cb.decode_alarm = alarm_new_periodic("btif.a2dp_sink_decode");
@@ -513,10 +645,66 @@ static void btif_a2dp_sink_audio_handle_start_decoding() {
 }
 
 static void btif_a2dp_sink_on_decode_complete(uint8_t* data, uint32_t len) {
+  uint32_t frame_size =
+      btif_a2dp_sink_cb.channel_count * btif_a2dp_sink_cb.bits_per_sample / 8;
+  if (frame_size != 0) {
+    btif_a2dp_sink_cb.jitter_buffer.decoded_frames += len / frame_size;
+  }
+
+  // Written to the track by the output thread at the end of the tick
+  if (btif_a2dp_sink_cb.pcm_block == nullptr) {
+    btif_a2dp_sink_cb.pcm_block = new std::vector<uint8_t>();
+  }
+  btif_a2dp_sink_cb.pcm_block->insert(btif_a2dp_sink_cb.pcm_block->end(), data,
+                                      data + len);
+}
+
+// Must be called while locked, on the worker thread. Hands the PCM decoded
+// in this tick to the output thread.
+static void btif_a2dp_sink_output_pcm_block() {
+  std::vector<uint8_t>* block = btif_a2dp_sink_cb.pcm_block;
+  if (block == nullptr) return;
+  btif_a2dp_sink_cb.pcm_block = nullptr;
+
+  std::vector<uint8_t>* dropped =
+      btif_a2dp_sink_cb.pcm_ring.EnqueueWithPop(block);
+  if (dropped != nullptr) {
+    APPL_TRACE_WARNING("%s: output is late, dropping %zu PCM octets",
+                       __func__, dropped->size());
+    btif_a2dp_sink_cb.dropped_pcm_blocks++;
+    delete dropped;
+  }
+
+  if (!btif_a2dp_sink_cb.output_pending.exchange(true)) {
+    btif_a2dp_sink_cb.output_thread.DoInThread(
+        FROM_HERE, base::BindOnce(btif_a2dp_sink_output_drain));
+  }
+}
+
+// Runs on the output thread, never takes g_mutex so that a blocking write
+// does not hold up the decoding.
+static void btif_a2dp_sink_output_drain() {
+  // Cleared first, a block queued from now on schedules another drain
+  btif_a2dp_sink_cb.output_pending = false;
+
+  std::vector<uint8_t>* block;
+  while ((block = btif_a2dp_sink_cb.pcm_ring.Dequeue()) != nullptr) {
+    {
+      LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
 #ifndef OS_GENERIC
-  BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
-                               reinterpret_cast<void*>(data), len);
+      float ratio = btif_a2dp_sink_cb.resample_ratio.exchange(0);
+      if (btif_a2dp_sink_cb.audio_track != nullptr) {
+        if (ratio > 0) {
+          BtifAvrcpAudioTrackSetResampleRatio(btif_a2dp_sink_cb.audio_track,
+                                              ratio);
+        }
+        BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track,
+                                     block->data(), block->size());
+      }
 #endif
+    }
+    delete block;
+  }
 }
 
 // Must be called while locked.
@@ -533,11 +721,82 @@ static void btif_a2dp_sink_handle_inc_media(BT_HDR* p_msg) {
   }
 }
 
+// Log2 histogram bucket: 0, 1, [2,4), [4,8), ... up to the last bucket.
+static size_t btif_a2dp_sink_hist_bucket(uint64_t value) {
+  size_t bucket = 0;
+  while (value != 0 && bucket < A2DP_SINK_HIST_BUCKETS - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+// Must be called while locked.
+static void btif_a2dp_sink_jitter_on_arrival(uint64_t now_us) {
+  BtifA2dpSinkJitterBuffer& jb = btif_a2dp_sink_cb.jitter_buffer;
+
+  if (jb.last_arrival_us != 0) {
+    double interval_us = now_us - jb.last_arrival_us;
+    if (jb.arrivals == 0) {
+      jb.mean_interval_us = interval_us;
+    } else {
+      jb.mean_interval_us += (interval_us - jb.mean_interval_us) / 16;
+    }
+    double deviation_us = std::fabs(interval_us - jb.mean_interval_us);
+    jb.jitter_us += (deviation_us - jb.jitter_us) / 16;
+    jb.arrivals++;
+    jb.jitter_hist[btif_a2dp_sink_hist_bucket(deviation_us / 1000)]++;
+
+    // Cover one decode tick plus the jitter margin, and one more packet since
+    // a tick consumes whole packets
+    if (jb.arrivals >= A2DP_SINK_JITTER_MIN_ARRIVALS) {
+      double cover_us = A2DP_SINK_JITTER_MARGIN * jb.jitter_us +
+                        BTIF_SINK_MEDIA_TIME_TICK_MS * 1000;
+      size_t depth =
+          std::ceil(cover_us / std::max(jb.mean_interval_us, 1000.0)) + 1;
+      jb.target_depth = std::min<size_t>(
+          std::max<size_t>(depth, A2DP_SINK_JITTER_MIN_DEPTH),
+          A2DP_SINK_JITTER_MAX_DEPTH);
+    }
+  }
+  jb.last_arrival_us = now_us;
+}
+
+// Must be called while locked, after a decode tick consumed its audio.
+static void btif_a2dp_sink_jitter_update_rate() {
+  BtifA2dpSinkJitterBuffer& jb = btif_a2dp_sink_cb.jitter_buffer;
+  double sample_rate = btif_a2dp_sink_cb.sample_rate;
+  if (jb.frames_per_packet == 0 || sample_rate == 0) return;
+
+  // What is left should be the target depth less the tick just consumed
+  double depth_frames =
+      fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) *
+          jb.frames_per_packet -
+      jb.credit_frames;
+  double setpoint_frames = jb.target_depth * jb.frames_per_packet -
+                           sample_rate * BTIF_SINK_MEDIA_TIME_TICK_MS / 1000;
+  double err_s = (depth_frames - setpoint_frames) / sample_rate;
+
+  jb.depth_err_s += (err_s - jb.depth_err_s) / 8;
+  jb.drift = std::min(std::max(jb.drift + A2DP_SINK_DRIFT_KI * jb.depth_err_s,
+                               -A2DP_SINK_DRIFT_MAX),
+                      A2DP_SINK_DRIFT_MAX);
+  jb.rate_adjust =
+      std::min(std::max(jb.drift + A2DP_SINK_DRIFT_KP * jb.depth_err_s,
+                        -A2DP_SINK_RATE_ADJUST_MAX),
+               A2DP_SINK_RATE_ADJUST_MAX);
+
+  // Applied by the output thread, along with the audio of this tick
+  btif_a2dp_sink_cb.resample_ratio = 1.0 / (1.0 + jb.rate_adjust);
+}
+
 static void btif_a2dp_sink_avk_handle_timer() {
+  AllocationTagScope tag_scope(ALLOCATION_TAG_A2DP);
   LockGuard lock(g_mutex);
+  BtifA2dpSinkJitterBuffer& jb = btif_a2dp_sink_cb.jitter_buffer;
 
   BT_HDR* p_msg;
-  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
+  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue) && !jb.playing) {
     APPL_TRACE_DEBUG("%s: empty queue", __func__);
     return;
   }
@@ -554,19 +813,59 @@ static void btif_a2dp_sink_avk_handle_timer() {
     return;
   }
 
+  /* Still filling up to the target depth */
+  if (!jb.playing) {
+    APPL_TRACE_DEBUG("%s: prebuffering", __func__);
+    return;
+  }
+
+  /* Audio due for the elapsed time, capped so a stalled timer does not
+   * drain the buffer, at the rate that keeps the depth on target */
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  uint64_t elapsed_us = std::min<uint64_t>(
+      now_us - jb.last_tick_us, 4 * BTIF_SINK_MEDIA_TIME_TICK_MS * 1000);
+  jb.last_tick_us = now_us;
+  jb.credit_frames += elapsed_us * btif_a2dp_sink_cb.sample_rate *
+                      (1.0 + jb.rate_adjust) / 1000000;
+
   APPL_TRACE_DEBUG("%s: process frames begin", __func__);
-  while (true) {
+  while (jb.credit_frames > 0) {
     p_msg = (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue);
     if (p_msg == NULL) {
+      /* Ran dry: count it and prebuffer again */
+      APPL_TRACE_WARNING("%s: underrun, target depth %zu", __func__,
+                         jb.target_depth);
+      jb.underrun_count++;
+      jb.playing = false;
+      jb.credit_frames = 0;
       break;
     }
     APPL_TRACE_DEBUG("%s: number of packets in queue %zu", __func__,
                      fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue));
 
     /* Queue packet has less frames */
+    uint64_t decoded_frames = jb.decoded_frames;
     btif_a2dp_sink_handle_inc_media(p_msg);
     osi_free(p_msg);
+
+    double frames = jb.decoded_frames - decoded_frames;
+    if (frames > 0) {
+      jb.frames_per_packet =
+          (jb.frames_per_packet == 0)
+              ? frames
+              : jb.frames_per_packet + (frames - jb.frames_per_packet) / 16;
+    } else {
+      /* Nothing decoded, charge a typical packet so the loop ends */
+      frames = (jb.frames_per_packet > 0) ? jb.frames_per_packet
+                                          : jb.credit_frames;
+    }
+    jb.credit_frames -= frames;
   }
+
+  if (jb.playing) btif_a2dp_sink_jitter_update_rate();
+  btif_a2dp_sink_output_pcm_block();
+  jb.depth_hist[btif_a2dp_sink_hist_bucket(
+      fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue))]++;
   APPL_TRACE_DEBUG("%s: process frames end", __func__);
 }
 
@@ -581,8 +880,10 @@ void btif_a2dp_sink_set_rx_flush(bool enable) {
 static void btif_a2dp_sink_audio_rx_flush_event() {
   LOG_INFO("%s", __func__);
   LockGuard lock(g_mutex);
-  // Flush all received encoded audio buffers
+  // Flush all received encoded audio buffers, and the decoded audio
   fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_sink_cb.pcm_ring.Clear();
+  btif_a2dp_sink_cb.jitter_buffer.RestartStream();
 }
 
 static void btif_a2dp_sink_decoder_update_event(
@@ -617,6 +918,7 @@ static void btif_a2dp_sink_decoder_update_event(
   btif_a2dp_sink_cb.sample_rate = sample_rate;
   btif_a2dp_sink_cb.bits_per_sample = bits_per_sample;
   btif_a2dp_sink_cb.channel_count = channel_count;
+  btif_a2dp_sink_cb.jitter_buffer.ResetEstimates();
 
   btif_a2dp_sink_cb.rx_flush = false;
   APPL_TRACE_DEBUG("%s: reset to Sink role", __func__);
@@ -638,6 +940,8 @@ static void btif_a2dp_sink_decoder_update_event(
   }
 
   APPL_TRACE_DEBUG("%s: create audio track", __func__);
+  btif_a2dp_sink_cb.pcm_ring.Clear();
+  LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
   btif_a2dp_sink_cb.audio_track =
 #ifndef OS_GENERIC
       BtifAvrcpAudioTrackCreate(sample_rate, bits_per_sample, channel_count);
@@ -651,6 +955,7 @@ static void btif_a2dp_sink_decoder_update_event(
 }
 
 uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
+  AllocationTagScope tag_scope(ALLOCATION_TAG_A2DP);
   LockGuard lock(g_mutex);
   if (btif_a2dp_sink_cb.rx_flush) /* Flush enabled, do not enqueue */
     return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
@@ -662,6 +967,9 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
     return ret;
   }
 
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  btif_a2dp_sink_jitter_on_arrival(now_us);
+
   BTIF_TRACE_VERBOSE("%s +", __func__);
   /* Allocate and queue this buffer */
   BT_HDR* p_msg =
@@ -670,9 +978,15 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   p_msg->offset = 0;
   memcpy(p_msg->data, p_pkt->data + p_pkt->offset, p_pkt->len);
   fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
-  if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
-      MAX_A2DP_DELAYED_START_FRAME_COUNT) {
+
+  /* Start playout once the jitter buffer reached its target depth */
+  BtifA2dpSinkJitterBuffer& jb = btif_a2dp_sink_cb.jitter_buffer;
+  if (!jb.playing &&
+      fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) >= jb.target_depth) {
     BTIF_TRACE_DEBUG("%s: Initiate decoding", __func__);
+    jb.playing = true;
+    jb.credit_frames = 0;
+    jb.last_tick_us = now_us;
     btif_a2dp_sink_audio_handle_start_decoding();
   }
 
@@ -693,8 +1007,39 @@ void btif_a2dp_sink_audio_rx_flush_req() {
       FROM_HERE, base::BindOnce(btif_a2dp_sink_command_ready, p_buf));
 }
 
-void btif_a2dp_sink_debug_dump(UNUSED_ATTR int fd) {
-  // Nothing to do
+void btif_a2dp_sink_debug_dump(int fd) {
+  LockGuard lock(g_mutex);
+  const BtifA2dpSinkJitterBuffer& jb = btif_a2dp_sink_cb.jitter_buffer;
+
+  dprintf(fd, "\nA2DP Sink State:\n");
+  dprintf(fd, "  Jitter buffer (depth/target, packets)         : %zu / %zu\n",
+          (btif_a2dp_sink_cb.rx_audio_queue != nullptr)
+              ? fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue)
+              : 0,
+          jb.target_depth);
+  dprintf(fd, "  Packet interval (mean/jitter, ms)             : %.2f / %.2f\n",
+          jb.mean_interval_us / 1000, jb.jitter_us / 1000);
+  dprintf(fd,
+          "  Clock drift / playout rate adjustment (ppm)   : %+.1f / %+.1f\n",
+          jb.drift * 1e6, jb.rate_adjust * 1e6);
+  dprintf(fd, "  Underruns                                     : %zu\n",
+          jb.underrun_count);
+  dprintf(fd, "  Decoded PCM blocks (queued/dropped)           : %zu / %" PRIu64
+          "\n",
+          btif_a2dp_sink_cb.pcm_ring.Length(),
+          btif_a2dp_sink_cb.dropped_pcm_blocks.load());
+
+  static const char* kBucketNames[A2DP_SINK_HIST_BUCKETS] = {
+      "0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64+"};
+  dprintf(fd, "  Packet jitter histogram (ms)                  :");
+  for (size_t i = 0; i < A2DP_SINK_HIST_BUCKETS; i++) {
+    dprintf(fd, " %s:%" PRIu64, kBucketNames[i], jb.jitter_hist[i]);
+  }
+  dprintf(fd, "\n  Buffer depth histogram (packets)              :");
+  for (size_t i = 0; i < A2DP_SINK_HIST_BUCKETS; i++) {
+    dprintf(fd, " %s:%" PRIu64, kBucketNames[i], jb.depth_hist[i]);
+  }
+  dprintf(fd, "\n");
 }
 
 void btif_a2dp_sink_set_focus_state_req(btif_a2dp_sink_focus_state_t state) {
@@ -718,6 +1063,7 @@ static void btif_a2dp_sink_set_focus_state_event(
   btif_a2dp_sink_cb.rx_focus_state = state;
   if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED) {
     fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_sink_cb.pcm_ring.Clear();
     btif_a2dp_sink_cb.rx_flush = true;
   } else if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
     btif_a2dp_sink_cb.rx_flush = false;
@@ -727,6 +1073,7 @@ static void btif_a2dp_sink_set_focus_state_event(
 void btif_a2dp_sink_set_audio_track_gain(float gain) {
   LOG_INFO("%s: set gain to %f", __func__, gain);
   LockGuard lock(g_mutex);
+  LockGuard track_lock(btif_a2dp_sink_cb.track_mutex);
 
 #ifndef OS_GENERIC
   BtifAvrcpSetAudioTrackGain(btif_a2dp_sink_cb.audio_track, gain);
@@ -26,6 +26,8 @@
 #endif
 #include <inttypes.h>
 #include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
 #include <string.h>
 #include <algorithm>
 
@@ -39,18 +41,23 @@
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
+#include "btif_bqr.h"
 #include "btif_metrics_logging.h"
 #include "btif_util.h"
 #include "common/message_loop_thread.h"
 #include "common/metrics.h"
 #include "common/repeating_timer.h"
 #include "common/time_util.h"
+#include "gd/common/trace_ring.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/wakelock.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/acl_api_types.h"
+#include "stack/include/btm_api.h"
 #include "uipc.h"
 
 using bluetooth::common::A2dpSessionMetrics;
@@ -66,6 +73,45 @@ extern std::unique_ptr<tUIPC_STATE> a2dp_uipc;
  */
 #define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
+/**
+ * The encoder rate controller reevaluates the link once per window. Any
+ * dropped packet or new failed contact, a Bluetooth Quality Report window
+ * of the link with A2DP choppy events or TX buffer overflows, or a TX queue
+ * that averages above the high watermark, backs the rate off
+ * multiplicatively. The rate is raised again in small steps once the link
+ * stayed clean for the hold time.
+ */
+#define A2DP_SOURCE_RATE_CTRL_WINDOW_MS 500
+#define A2DP_SOURCE_RATE_CTRL_QUEUE_HIGH 3
+#define A2DP_SOURCE_RATE_CTRL_QUEUE_LOW 1
+#define A2DP_SOURCE_RATE_CTRL_MIN_PERCENT 50
+#define A2DP_SOURCE_RATE_CTRL_BACKOFF_PERCENT 75
+#define A2DP_SOURCE_RATE_CTRL_STEP_UP_PERCENT 5
+#define A2DP_SOURCE_RATE_CTRL_HOLD_MS 3000
+/* Period of the Failed Contact Counter reads while streaming */
+#define A2DP_SOURCE_RATE_CTRL_FCC_PERIOD_MS 2000
+
+/**
+ * With deadline scheduling the media task wakes up once per media packet, on
+ * the grid given by the packet duration of the encoder, instead of once per
+ * encoder interval. A wakeup is deferred to the next deadline while the link
+ * still holds the given number of packets not yet sent to the controller.
+ */
+#define A2DP_SOURCE_DEADLINE_SCHEDULING_PROPERTY \
+  "persist.bluetooth.a2dp_source.deadline_scheduling"
+#define A2DP_SOURCE_DEADLINE_MAX_PENDING_PACKETS 2
+
+/**
+ * The encoding runs on its own thread, apart from the session control. The
+ * SCHED_FIFO priority and the CPUs of that thread can be tuned per device.
+ * A zero CPU mask keeps the default affinity.
+ */
+#define A2DP_SOURCE_ENCODER_PRIORITY_PROPERTY \
+  "persist.bluetooth.a2dp_source.encoder_priority"
+#define A2DP_SOURCE_ENCODER_CPU_MASK_PROPERTY \
+  "persist.bluetooth.a2dp_source.encoder_cpu_mask"
+#define A2DP_SOURCE_ENCODER_DEFAULT_PRIORITY 1
+
 class SchedulingStats {
  public:
   SchedulingStats() { Reset(); }
@@ -136,6 +182,7 @@ class BtifMediaStats {
     media_read_total_underflow_bytes = 0;
     media_read_total_underflow_count = 0;
     media_read_last_underflow_us = 0;
+    media_timer_deferred_count = 0;
     codec_index = -1;
   }
 
@@ -166,9 +213,63 @@ class BtifMediaStats {
   size_t media_read_total_underflow_count;
   uint64_t media_read_last_underflow_us;
 
+  size_t media_timer_deferred_count;
+
   int codec_index = -1;
 };
 
+struct BtifA2dpSourceRateController {
+  /* Current evaluation window */
+  uint64_t window_start_us = 0;
+  size_t queue_length_sum = 0;
+  size_t queue_length_samples = 0;
+  size_t dropouts = 0;          /* TX queue overflows */
+  size_t congestion_events = 0; /* packets dropped below the TX queue */
+  size_t failed_contacts = 0;   /* new failed contacts */
+  size_t poor_bqr_windows = 0;  /* BQR windows reporting a poor link */
+
+  /* Failed Contact Counter of the active peer */
+  bool has_failed_contact_counter = false;
+  uint16_t failed_contact_counter = 0;
+  uint64_t last_failed_contact_read_us = 0;
+
+  /* Bluetooth Quality Report aggregates of the active peer link */
+  uint16_t acl_handle = HCI_INVALID_HANDLE;
+  uint32_t bqr_window_seq = 0;
+
+  /* Rate state, kept across restarts of the same encoder */
+  uint8_t rate_percent = 100;
+  bool rate_supported = true;
+  uint64_t last_backoff_us = 0;
+
+  /* Statistics */
+  size_t backoff_count = 0;
+  size_t recovery_count = 0;
+  size_t total_congestion_events = 0;
+  size_t total_failed_contacts = 0;
+  size_t total_poor_bqr_windows = 0;
+  uint8_t min_rate_percent = 100;
+
+  void RestartWindow(uint64_t now_us) {
+    window_start_us = now_us;
+    queue_length_sum = 0;
+    queue_length_samples = 0;
+    dropouts = 0;
+    congestion_events = 0;
+    failed_contacts = 0;
+    poor_bqr_windows = 0;
+  }
+
+  void RestartStream() {
+    RestartWindow(0);
+    has_failed_contact_counter = false;
+    last_failed_contact_read_us = 0;
+    acl_handle = HCI_INVALID_HANDLE;
+  }
+
+  void Reset() { *this = BtifA2dpSourceRateController(); }
+};
+
 class BtifA2dpSource {
  public:
   enum RunState {
@@ -183,6 +284,9 @@ class BtifA2dpSource {
         tx_flush(false),
         encoder_interface(nullptr),
         encoder_interval_ms(0),
+        media_interval_us(0),
+        deadline_scheduling(false),
+        tx_headroom(0),
         state_(kStateOff) {}
 
   void Reset() {
@@ -190,11 +294,15 @@ class BtifA2dpSource {
     tx_audio_queue = nullptr;
     tx_flush = false;
     media_alarm.CancelAndWait();
-    wakelock_release();
+    ReleaseWakelock();
     encoder_interface = nullptr;
     encoder_interval_ms = 0;
+    media_interval_us = 0;
+    deadline_scheduling = false;
+    tx_headroom = 0;
     stats.Reset();
     accumulated_stats.Reset();
+    rate_ctrl.Reset();
     state_ = kStateOff;
   }
 
@@ -214,20 +322,44 @@ class BtifA2dpSource {
 
   void SetState(BtifA2dpSource::RunState state) { state_ = state; }
 
+  // The wakelock is reference counted: acquire it once per streaming session
+  // so that every stop path can release it without unbalancing the count.
+  void AcquireWakelock() {
+    if (wakelock_held_) return;
+    wakelock_acquire();
+    wakelock_held_ = true;
+  }
+  void ReleaseWakelock() {
+    if (!wakelock_held_) return;
+    wakelock_release();
+    wakelock_held_ = false;
+  }
+
   fixed_queue_t* tx_audio_queue;
   bool tx_flush; /* Discards any outgoing data when true */
   RepeatingTimer media_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   uint64_t encoder_interval_ms; /* Local copy of the encoder interval */
+  uint64_t media_interval_us;   /* Period of the media task */
+  bool deadline_scheduling;     /* Media task runs once per media packet */
+  uint16_t tx_headroom;         /* Offset required in every encoded packet */
   BtifMediaStats stats;
   BtifMediaStats accumulated_stats;
+  BtifA2dpSourceRateController rate_ctrl;
 
  private:
   BtifA2dpSource::RunState state_;
+  bool wakelock_held_ = false;
 };
 
+// Session control: audio HAL setup, session start and end, codec user and
+// audio configuration updates.
 static bluetooth::common::MessageLoopThread btif_a2dp_source_thread(
     "bt_a2dp_source_worker_thread");
+// Data plane: encoder setup, media task and TX queue. Control requests for
+// the encoder are queued behind the running encode cycle.
+static bluetooth::common::MessageLoopThread btif_a2dp_source_encoder_thread(
+    "bt_a2dp_source_encoder_thread");
 static BtifA2dpSource btif_a2dp_source_cb;
 
 static uint8_t btif_a2dp_source_dynamic_audio_buffer_size =
@@ -240,6 +372,9 @@ static void btif_a2dp_source_start_session_delayed(
 static void btif_a2dp_source_end_session_delayed(
     const RawAddress& peer_address);
 static void btif_a2dp_source_shutdown_delayed(void);
+static void btif_a2dp_source_encoder_shutdown_delayed(
+    std::promise<void> encoder_stopped_promise);
+static void btif_a2dp_source_encoder_thread_configure(void);
 static void btif_a2dp_source_cleanup_delayed(void);
 static void btif_a2dp_source_audio_tx_start_event(void);
 static void btif_a2dp_source_audio_tx_stop_event(void);
@@ -258,6 +393,9 @@ static void btif_a2dp_source_audio_feeding_update_event(
     const btav_a2dp_codec_config_t& codec_audio_config);
 static bool btif_a2dp_source_audio_tx_flush_req(void);
 static void btif_a2dp_source_audio_handle_timer(void);
+static uint64_t btif_a2dp_source_media_interval_us(void);
+static void btif_a2dp_source_schedule_media_task(void);
+static void btif_a2dp_source_reschedule_media_task(void);
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len);
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read);
@@ -267,8 +405,16 @@ static void update_scheduling_stats(SchedulingStats* stats, uint64_t now_us,
 // Update the A2DP Source related metrics.
 // This function should be called before collecting the metrics.
 static void btif_a2dp_source_update_metrics(void);
+static void btif_a2dp_source_rate_ctrl_update(uint64_t now_us,
+                                              size_t transmit_queue_length);
+static void btif_a2dp_source_rate_ctrl_set_rate(uint8_t rate_percent);
+static void btif_a2dp_source_rate_ctrl_on_congestion(void);
+static void btif_a2dp_source_rate_ctrl_on_failed_contact_counter(
+    const RawAddress& peer_address, uint16_t failed_contact_counter);
+static void btif_a2dp_source_rate_ctrl_read_bqr_stats(void);
 static void btm_read_rssi_cb(void* data);
 static void btm_read_failed_contact_counter_cb(void* data);
+static void btm_poll_failed_contact_counter_cb(void* data);
 static void btm_read_tx_power_cb(void* data);
 
 void btif_a2dp_source_accumulate_scheduling_stats(SchedulingStats* src,
@@ -313,6 +459,7 @@ void btif_a2dp_source_accumulate_stats(BtifMediaStats* src,
   dst->media_read_total_underflow_count +=
       src->media_read_total_underflow_count;
   dst->media_read_last_underflow_us = src->media_read_last_underflow_us;
+  dst->media_timer_deferred_count += src->media_timer_deferred_count;
   if (dst->codec_index < 0) dst->codec_index = src->codec_index;
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_enqueue_stats,
                                                &dst->tx_queue_enqueue_stats);
@@ -326,6 +473,7 @@ bool btif_a2dp_source_init(void) {
 
   // Start A2DP Source media task
   btif_a2dp_source_thread.StartUp();
+  btif_a2dp_source_encoder_thread.StartUp();
   btif_a2dp_source_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_init_delayed));
   return true;
@@ -357,9 +505,7 @@ bool btif_a2dp_source_startup(void) {
 
 static void btif_a2dp_source_startup_delayed() {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
-  if (!btif_a2dp_source_thread.EnableRealTimeScheduling()) {
-    LOG(FATAL) << __func__ << ": unable to enable real time scheduling";
-  }
+  btif_a2dp_source_encoder_thread_configure();
   if (!bluetooth::audio::a2dp::init(&btif_a2dp_source_thread)) {
     if (btif_av_is_a2dp_offload_enabled()) {
       // TODO: BluetoothA2dp@1.0 is deprecated
@@ -372,6 +518,26 @@ static void btif_a2dp_source_startup_delayed() {
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateRunning);
 }
 
+static void btif_a2dp_source_encoder_thread_configure(void) {
+  int priority = osi_property_get_int32(A2DP_SOURCE_ENCODER_PRIORITY_PROPERTY,
+                                        A2DP_SOURCE_ENCODER_DEFAULT_PRIORITY);
+  priority = std::min(std::max(priority, sched_get_priority_min(SCHED_FIFO)),
+                      sched_get_priority_max(SCHED_FIFO));
+  if (!btif_a2dp_source_encoder_thread.EnableRealTimeScheduling(priority)) {
+    LOG(FATAL) << __func__ << ": unable to enable real time scheduling";
+  }
+
+  char value[PROPERTY_VALUE_MAX] = {0};
+  osi_property_get(A2DP_SOURCE_ENCODER_CPU_MASK_PROPERTY, value, "0");
+  uint64_t cpu_mask = strtoull(value, nullptr, 0);
+  if (cpu_mask != 0 &&
+      !btif_a2dp_source_encoder_thread.SetCpuAffinity(cpu_mask)) {
+    LOG_WARN("%s: keeping the default CPU affinity", __func__);
+  }
+  LOG_INFO("%s: priority=%d cpu_mask=0x%" PRIx64, __func__, priority,
+           cpu_mask);
+}
+
 bool btif_a2dp_source_start_session(const RawAddress& peer_address,
                                     std::promise<void> peer_ready_promise) {
   LOG(INFO) << __func__ << ": peer_address=" << peer_address
@@ -499,9 +665,16 @@ void btif_a2dp_source_shutdown(void) {
 static void btif_a2dp_source_shutdown_delayed(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
 
-  // Stop the timer
-  btif_a2dp_source_cb.media_alarm.CancelAndWait();
-  wakelock_release();
+  // Stop the encoding before releasing the audio path and the TX queue
+  std::promise<void> encoder_stopped_promise;
+  std::future<void> encoder_stopped_future =
+      encoder_stopped_promise.get_future();
+  if (btif_a2dp_source_encoder_thread.DoInThread(
+          FROM_HERE,
+          base::BindOnce(&btif_a2dp_source_encoder_shutdown_delayed,
+                         std::move(encoder_stopped_promise)))) {
+    encoder_stopped_future.wait();
+  }
 
   if (bluetooth::audio::a2dp::is_hal_2_0_enabled()) {
     bluetooth::audio::a2dp::cleanup();
@@ -517,6 +690,14 @@ static void btif_a2dp_source_shutdown_delayed(void) {
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 }
 
+static void btif_a2dp_source_encoder_shutdown_delayed(
+    std::promise<void> encoder_stopped_promise) {
+  // Stop the timer
+  btif_a2dp_source_cb.media_alarm.CancelAndWait();
+  btif_a2dp_source_cb.ReleaseWakelock();
+  encoder_stopped_promise.set_value();
+}
+
 void btif_a2dp_source_cleanup(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
 
@@ -526,8 +707,10 @@ void btif_a2dp_source_cleanup(void) {
   btif_a2dp_source_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_cleanup_delayed));
 
-  // Exit the thread
+  // Exit the threads, the control thread first as its shutdown still waits
+  // for the encoder thread
   btif_a2dp_source_thread.ShutDown();
+  btif_a2dp_source_encoder_thread.ShutDown();
 }
 
 static void btif_a2dp_source_cleanup_delayed(void) {
@@ -557,7 +740,7 @@ static void btif_a2dp_source_setup_codec(const RawAddress& peer_address) {
   CHECK(CHAR_BIT == 8);
 
   btif_a2dp_source_audio_tx_flush_req();
-  btif_a2dp_source_thread.DoInThread(
+  btif_a2dp_source_encoder_thread.DoInThread(
       FROM_HERE,
       base::Bind(&btif_a2dp_source_setup_codec_delayed, peer_address));
 }
@@ -588,6 +771,16 @@ static void btif_a2dp_source_setup_codec_delayed(
     return;
   }
 
+  // Every encoded packet must leave room for the L2CAP and HCI headers, and
+  // for the RTP header if the codec uses one, so that AVDTP and L2CAP can
+  // prepend their headers in place.
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+  btif_a2dp_source_cb.tx_headroom = AVDT_MEDIA_OFFSET - AVDT_MEDIA_HDR_SIZE;
+  if (a2dp_codec_config->copyOutOtaCodecConfig(codec_info) &&
+      A2DP_UsesRtpHeader(false, codec_info)) {
+    btif_a2dp_source_cb.tx_headroom = AVDT_MEDIA_OFFSET;
+  }
+
   btif_a2dp_source_cb.encoder_interface->encoder_init(
       &peer_params, a2dp_codec_config, btif_a2dp_source_read_callback,
       btif_a2dp_source_enqueue_callback);
@@ -596,6 +789,9 @@ static void btif_a2dp_source_setup_codec_delayed(
   btif_a2dp_source_cb.encoder_interval_ms =
       btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms();
 
+  // The encoder starts at its configured rate
+  btif_a2dp_source_cb.rate_ctrl.Reset();
+
   if (bluetooth::audio::a2dp::is_hal_2_0_enabled()) {
     bluetooth::audio::a2dp::setup_codec();
   }
@@ -604,14 +800,14 @@ static void btif_a2dp_source_setup_codec_delayed(
 void btif_a2dp_source_start_audio_req(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
 
-  btif_a2dp_source_thread.DoInThread(
+  btif_a2dp_source_encoder_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_audio_tx_start_event));
 }
 
 void btif_a2dp_source_stop_audio_req(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
 
-  btif_a2dp_source_thread.DoInThread(
+  btif_a2dp_source_encoder_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_audio_tx_stop_event));
 }
 
@@ -776,6 +972,8 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
       btif_a2dp_source_is_streaming() ? "true" : "false",
       btif_a2dp_source_cb.StateStr().c_str());
 
+  BTM_SetStreamingActive(true);
+
   if (btif_av_is_a2dp_offload_running()) return;
 
   /* Reset the media feeding state */
@@ -789,12 +987,10 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
   /* audio engine starting, reset tx suspended flag */
   btif_a2dp_source_cb.tx_flush = false;
 
-  wakelock_acquire();
-  btif_a2dp_source_cb.media_alarm.SchedulePeriodic(
-      btif_a2dp_source_thread.GetWeakPtr(), FROM_HERE,
-      base::Bind(&btif_a2dp_source_audio_handle_timer),
-      base::TimeDelta::FromMilliseconds(
-          btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms()));
+  btif_a2dp_source_cb.AcquireWakelock();
+  btif_a2dp_source_cb.deadline_scheduling =
+      osi_property_get_bool(A2DP_SOURCE_DEADLINE_SCHEDULING_PROPERTY, false);
+  btif_a2dp_source_schedule_media_task();
 
   btif_a2dp_source_cb.stats.Reset();
   // Assign session_start_us to 1 when
@@ -806,6 +1002,9 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
     btif_a2dp_source_cb.stats.session_start_us = 1;
   }
   btif_a2dp_source_cb.stats.session_end_us = 0;
+  btif_a2dp_source_cb.rate_ctrl.RestartStream();
+  btif_a2dp_source_cb.rate_ctrl.acl_handle = BTM_GetHCIConnHandle(
+      btif_av_source_active_peer(), BT_TRANSPORT_BR_EDR);
   A2dpCodecConfig* codec_config = bta_av_get_a2dp_current_codec();
   if (codec_config != nullptr) {
     btif_a2dp_source_cb.stats.codec_index = codec_config->codecIndex();
@@ -819,6 +1018,8 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
       btif_a2dp_source_is_streaming() ? "true" : "false",
       btif_a2dp_source_cb.StateStr().c_str());
 
+  BTM_SetStreamingActive(false);
+
   if (btif_av_is_a2dp_offload_running()) return;
 
   btif_a2dp_source_cb.stats.session_end_us =
@@ -841,7 +1042,7 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 
   /* Stop the timer first */
   btif_a2dp_source_cb.media_alarm.CancelAndWait();
-  wakelock_release();
+  btif_a2dp_source_cb.ReleaseWakelock();
 
   if (bluetooth::audio::a2dp::is_hal_2_0_enabled()) {
     bluetooth::audio::a2dp::ack_stream_suspended(A2DP_CTRL_ACK_SUCCESS);
@@ -875,6 +1076,8 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 static void btif_a2dp_source_audio_handle_timer(void) {
   if (btif_av_is_a2dp_offload_running()) return;
 
+  AllocationTagScope tag_scope(ALLOCATION_TAG_A2DP);
+
   uint64_t timestamp_us = bluetooth::common::time_get_os_boottime_us();
   log_tstamps_us("A2DP Source tx timer", timestamp_us);
 
@@ -893,11 +1096,67 @@ static void btif_a2dp_source_audio_handle_timer(void) {
     btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
         transmit_queue_length);
   }
-  btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
+  btif_a2dp_source_rate_ctrl_update(timestamp_us, transmit_queue_length);
+  if (btif_a2dp_source_cb.deadline_scheduling &&
+      transmit_queue_length >= A2DP_SOURCE_DEADLINE_MAX_PENDING_PACKETS) {
+    // The controller has not completed the previous packets yet: encoding
+    // now would only grow the TX queue, so the encoder catches up on the
+    // elapsed time at the next deadline.
+    btif_a2dp_source_cb.stats.media_timer_deferred_count++;
+  } else {
+    // Traced with the length of the TX queue before and after encoding
+    bluetooth::common::TraceRing::Record(
+        bluetooth::common::TraceEventId::A2DP_ENCODE_BEGIN, 0,
+        transmit_queue_length);
+    btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
+    bluetooth::common::TraceRing::Record(
+        bluetooth::common::TraceEventId::A2DP_ENCODE_END, 0,
+        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue));
+  }
   bta_av_ci_src_data_ready(BTA_AV_CHNL_AUDIO);
   update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_enqueue_stats,
-                          timestamp_us,
-                          btif_a2dp_source_cb.encoder_interval_ms * 1000);
+                          timestamp_us, btif_a2dp_source_cb.media_interval_us);
+
+  // Follow the packet duration if the encoder changed its packetization,
+  // e.g. after a bitpool change. The timer cannot be re-armed from its task.
+  if (btif_a2dp_source_cb.deadline_scheduling &&
+      btif_a2dp_source_media_interval_us() !=
+          btif_a2dp_source_cb.media_interval_us) {
+    btif_a2dp_source_encoder_thread.DoInThread(
+        FROM_HERE, base::Bind(&btif_a2dp_source_reschedule_media_task));
+  }
+}
+
+// Gets the period of the media task. With deadline scheduling each wakeup
+// reads and encodes the PCM of exactly one media packet, otherwise the media
+// task runs at the encoder interval.
+static uint64_t btif_a2dp_source_media_interval_us(void) {
+  uint64_t interval_us = btif_a2dp_source_cb.encoder_interval_ms * 1000;
+
+  if (!btif_a2dp_source_cb.deadline_scheduling) return interval_us;
+
+  A2dpCodecConfig* codec_config = bta_av_get_a2dp_current_codec();
+  if (codec_config == nullptr) return interval_us;
+
+  uint64_t packet_interval_us = codec_config->encoderPacketIntervalUs();
+  return (packet_interval_us != 0) ? packet_interval_us : interval_us;
+}
+
+static void btif_a2dp_source_reschedule_media_task(void) {
+  // The media task may have been stopped while this request was queued
+  if (!btif_a2dp_source_cb.media_alarm.IsScheduled()) return;
+  btif_a2dp_source_schedule_media_task();
+}
+
+static void btif_a2dp_source_schedule_media_task(void) {
+  btif_a2dp_source_cb.media_interval_us = btif_a2dp_source_media_interval_us();
+  LOG_INFO("%s: media task period %" PRIu64 " us%s", __func__,
+           btif_a2dp_source_cb.media_interval_us,
+           btif_a2dp_source_cb.deadline_scheduling ? " (deadline)" : "");
+  btif_a2dp_source_cb.media_alarm.SchedulePeriodic(
+      btif_a2dp_source_encoder_thread.GetWeakPtr(), FROM_HERE,
+      base::Bind(&btif_a2dp_source_audio_handle_timer),
+      base::TimeDelta::FromMicroseconds(btif_a2dp_source_cb.media_interval_us));
 }
 
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
@@ -937,6 +1196,14 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     return false;
   }
 
+  /* Check that the encoder left room for the protocol headers */
+  if (p_buf->offset < btif_a2dp_source_cb.tx_headroom) {
+    LOG_ERROR("%s: discarded frame without headroom: offset=%d required=%d",
+              __func__, p_buf->offset, btif_a2dp_source_cb.tx_headroom);
+    osi_free(p_buf);
+    return false;
+  }
+
   /* Check if the transmission queue has been flushed */
   if (btif_a2dp_source_cb.tx_flush) {
     LOG_VERBOSE("%s: tx suspended, discarded frame", __func__);
@@ -960,6 +1227,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     // Keep track of drop-outs
     btif_a2dp_source_cb.stats.tx_queue_dropouts++;
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
+    btif_a2dp_source_cb.rate_ctrl.dropouts++;
 
     // Flush all queued buffers
     size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
@@ -1035,11 +1303,136 @@ static void btif_a2dp_source_audio_tx_flush_event(void) {
 static bool btif_a2dp_source_audio_tx_flush_req(void) {
   LOG_INFO("%s: state=%s", __func__, btif_a2dp_source_cb.StateStr().c_str());
 
-  btif_a2dp_source_thread.DoInThread(
+  btif_a2dp_source_encoder_thread.DoInThread(
       FROM_HERE, base::Bind(&btif_a2dp_source_audio_tx_flush_event));
   return true;
 }
 
+void btif_a2dp_source_on_link_congestion(void) {
+  btif_a2dp_source_encoder_thread.DoInThread(
+      FROM_HERE, base::Bind(&btif_a2dp_source_rate_ctrl_on_congestion));
+}
+
+static void btif_a2dp_source_rate_ctrl_on_congestion(void) {
+  btif_a2dp_source_cb.rate_ctrl.congestion_events++;
+  btif_a2dp_source_cb.rate_ctrl.total_congestion_events++;
+}
+
+static void btif_a2dp_source_rate_ctrl_on_failed_contact_counter(
+    const RawAddress& peer_address, uint16_t failed_contact_counter) {
+  BtifA2dpSourceRateController& rate_ctrl = btif_a2dp_source_cb.rate_ctrl;
+
+  if (peer_address != btif_av_source_active_peer()) return;
+
+  if (rate_ctrl.has_failed_contact_counter) {
+    // The counter is 16 bits wide and wraps around
+    uint16_t new_failed_contacts =
+        failed_contact_counter - rate_ctrl.failed_contact_counter;
+    rate_ctrl.failed_contacts += new_failed_contacts;
+    rate_ctrl.total_failed_contacts += new_failed_contacts;
+  }
+  rate_ctrl.has_failed_contact_counter = true;
+  rate_ctrl.failed_contact_counter = failed_contact_counter;
+}
+
+// Counts the Bluetooth Quality Report windows of the active peer link that
+// completed since the last read and reported A2DP choppy events or TX buffer
+// overflows.
+static void btif_a2dp_source_rate_ctrl_read_bqr_stats(void) {
+  BtifA2dpSourceRateController& rate_ctrl = btif_a2dp_source_cb.rate_ctrl;
+  bluetooth::bqr::BqrLinkQualityStats stats;
+
+  if (rate_ctrl.acl_handle == HCI_INVALID_HANDLE ||
+      !bluetooth::bqr::GetLinkQualityStats(rate_ctrl.acl_handle, &stats) ||
+      stats.window_seq == rate_ctrl.bqr_window_seq) {
+    return;
+  }
+  rate_ctrl.bqr_window_seq = stats.window_seq;
+  if (stats.a2dp_choppy_count > 0 || stats.buffer_overflow_bytes > 0) {
+    rate_ctrl.poor_bqr_windows++;
+    rate_ctrl.total_poor_bqr_windows++;
+  }
+}
+
+// Feeds the TX queue length sampled on each media tick into the encoder rate
+// controller, and adjusts the encoder rate at the end of each window.
+static void btif_a2dp_source_rate_ctrl_update(uint64_t now_us,
+                                              size_t transmit_queue_length) {
+  BtifA2dpSourceRateController& rate_ctrl = btif_a2dp_source_cb.rate_ctrl;
+
+  if (rate_ctrl.window_start_us == 0) {
+    rate_ctrl.RestartWindow(now_us);
+    return;
+  }
+  rate_ctrl.queue_length_sum += transmit_queue_length;
+  rate_ctrl.queue_length_samples++;
+  if (now_us - rate_ctrl.window_start_us <
+      A2DP_SOURCE_RATE_CTRL_WINDOW_MS * 1000) {
+    return;
+  }
+
+  if (now_us - rate_ctrl.last_failed_contact_read_us >=
+      A2DP_SOURCE_RATE_CTRL_FCC_PERIOD_MS * 1000) {
+    rate_ctrl.last_failed_contact_read_us = now_us;
+    tBTM_STATUS status = BTM_ReadFailedContactCounter(
+        btif_av_source_active_peer(), btm_poll_failed_contact_counter_cb);
+    if (status != BTM_CMD_STARTED) {
+      LOG_VERBOSE("%s: Cannot read Failed Contact Counter: status %d",
+                  __func__, status);
+    }
+  }
+
+  btif_a2dp_source_rate_ctrl_read_bqr_stats();
+
+  size_t average_queue_length =
+      (rate_ctrl.queue_length_sum + rate_ctrl.queue_length_samples / 2) /
+      rate_ctrl.queue_length_samples;
+  bool congested = rate_ctrl.dropouts > 0 ||
+                   rate_ctrl.congestion_events > 0 ||
+                   rate_ctrl.failed_contacts > 0 ||
+                   rate_ctrl.poor_bqr_windows > 0 ||
+                   average_queue_length > A2DP_SOURCE_RATE_CTRL_QUEUE_HIGH;
+  uint8_t rate_percent = rate_ctrl.rate_percent;
+  if (congested) {
+    rate_percent = std::max<uint8_t>(
+        rate_percent * A2DP_SOURCE_RATE_CTRL_BACKOFF_PERCENT / 100,
+        A2DP_SOURCE_RATE_CTRL_MIN_PERCENT);
+    rate_ctrl.last_backoff_us = now_us;
+  } else if (average_queue_length <= A2DP_SOURCE_RATE_CTRL_QUEUE_LOW &&
+             now_us - rate_ctrl.last_backoff_us >=
+                 A2DP_SOURCE_RATE_CTRL_HOLD_MS * 1000) {
+    rate_percent = std::min<uint8_t>(
+        rate_percent + A2DP_SOURCE_RATE_CTRL_STEP_UP_PERCENT, 100);
+  }
+  rate_ctrl.RestartWindow(now_us);
+
+  if (rate_percent != rate_ctrl.rate_percent && rate_ctrl.rate_supported) {
+    btif_a2dp_source_rate_ctrl_set_rate(rate_percent);
+  }
+}
+
+static void btif_a2dp_source_rate_ctrl_set_rate(uint8_t rate_percent) {
+  BtifA2dpSourceRateController& rate_ctrl = btif_a2dp_source_cb.rate_ctrl;
+  A2dpCodecConfig* codec_config = bta_av_get_a2dp_current_codec();
+
+  if (codec_config == nullptr ||
+      !codec_config->setEncoderRatePercent(rate_percent)) {
+    LOG_INFO("%s: encoder does not support rate control", __func__);
+    rate_ctrl.rate_supported = false;
+    return;
+  }
+  LOG_INFO("%s: encoder rate %u%% -> %u%%", __func__, rate_ctrl.rate_percent,
+           rate_percent);
+  if (rate_percent < rate_ctrl.rate_percent) {
+    rate_ctrl.backoff_count++;
+  } else {
+    rate_ctrl.recovery_count++;
+  }
+  rate_ctrl.rate_percent = rate_percent;
+  rate_ctrl.min_rate_percent =
+      std::min(rate_ctrl.min_rate_percent, rate_percent);
+}
+
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
   BT_HDR* p_buf =
@@ -1050,8 +1443,7 @@ BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   if (p_buf != nullptr) {
     // Update the statistics
     update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_dequeue_stats,
-                            now_us,
-                            btif_a2dp_source_cb.encoder_interval_ms * 1000);
+                            now_us, btif_a2dp_source_cb.media_interval_us);
   }
 
   return p_buf;
@@ -1193,6 +1585,15 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  dprintf(fd,
+          "  Media task period in us (deadline scheduling)           : %llu "
+          "(%s)\n",
+          (unsigned long long)btif_a2dp_source_cb.media_interval_us,
+          btif_a2dp_source_cb.deadline_scheduling ? "true" : "false");
+  dprintf(fd,
+          "  Counts (deferred media task wakeups)                    : %zu\n",
+          accumulated_stats->media_timer_deferred_count);
+
   //
   // TxQueue enqueue stats
   //
@@ -1268,6 +1669,28 @@ void btif_a2dp_source_debug_dump(int fd) {
       (unsigned long long)dequeue_stats->max_premature_scheduling_delta_us /
           1000,
       (unsigned long long)ave_time_us / 1000);
+
+  //
+  // Encoder rate control
+  //
+  BtifA2dpSourceRateController* rate_ctrl = &btif_a2dp_source_cb.rate_ctrl;
+  dprintf(fd, "  Encoder rate control:\n");
+  dprintf(fd,
+          "  Rate in percent (current/min)                           : %u / "
+          "%u%s\n",
+          rate_ctrl->rate_percent, rate_ctrl->min_rate_percent,
+          rate_ctrl->rate_supported ? "" : " (not supported by the encoder)");
+  dprintf(fd,
+          "  Rate changes (backoff/recovery)                         : %zu / "
+          "%zu\n",
+          rate_ctrl->backoff_count, rate_ctrl->recovery_count);
+  dprintf(fd,
+          "  Link events (congestion drops/failed contacts)          : %zu / "
+          "%zu\n",
+          rate_ctrl->total_congestion_events, rate_ctrl->total_failed_contacts);
+  dprintf(fd,
+          "  Link quality reports (poor windows)                     : %zu\n",
+          rate_ctrl->total_poor_bqr_windows);
 }
 
 static void btif_a2dp_source_update_metrics(void) {
@@ -1290,11 +1713,13 @@ static void btif_a2dp_source_update_metrics(void) {
 
   if (enqueue_stats.total_updates > 1) {
     metrics.media_timer_min_ms =
-        btif_a2dp_source_cb.encoder_interval_ms -
-        (enqueue_stats.max_premature_scheduling_delta_us / 1000);
+        (btif_a2dp_source_cb.media_interval_us -
+         enqueue_stats.max_premature_scheduling_delta_us) /
+        1000;
     metrics.media_timer_max_ms =
-        btif_a2dp_source_cb.encoder_interval_ms +
-        (enqueue_stats.max_overdue_scheduling_delta_us / 1000);
+        (btif_a2dp_source_cb.media_interval_us +
+         enqueue_stats.max_overdue_scheduling_delta_us) /
+        1000;
 
     metrics.total_scheduling_count = enqueue_stats.overdue_scheduling_count +
                                      enqueue_stats.premature_scheduling_count +
@@ -1362,6 +1787,26 @@ static void btm_read_failed_contact_counter_cb(void* data) {
 
   LOG_WARN("%s: device: %s, Failed Contact Counter: %u", __func__,
            result->rem_bda.ToString().c_str(), result->failed_contact_counter);
+
+  btif_a2dp_source_encoder_thread.DoInThread(
+      FROM_HERE,
+      base::Bind(&btif_a2dp_source_rate_ctrl_on_failed_contact_counter,
+                 result->rem_bda, result->failed_contact_counter));
+}
+
+// Same as btm_read_failed_contact_counter_cb(), without the logging, for the
+// periodic reads of the encoder rate controller.
+static void btm_poll_failed_contact_counter_cb(void* data) {
+  if (data == nullptr) return;
+
+  tBTM_FAILED_CONTACT_COUNTER_RESULT* result =
+      (tBTM_FAILED_CONTACT_COUNTER_RESULT*)data;
+  if (result->status != BTM_SUCCESS) return;
+
+  btif_a2dp_source_encoder_thread.DoInThread(
+      FROM_HERE,
+      base::Bind(&btif_a2dp_source_rate_ctrl_on_failed_contact_counter,
+                 result->rem_bda, result->failed_contact_counter));
 }
 
 static void btm_read_tx_power_cb(void* data) {
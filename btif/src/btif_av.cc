@@ -57,6 +57,8 @@ static const std::string kBtifAvSourceServiceName = "Advanced Audio Source";
 static const std::string kBtifAvSinkServiceName = "Advanced Audio Sink";
 static constexpr int kDefaultMaxConnectedAudioDevices = 1;
 static constexpr tBTA_AV_HNDL kBtaHandleUnknown = 0;
+static constexpr char kFanoutProperty[] =
+    "persist.bluetooth.a2dp_source.fanout";
 
 namespace {
 constexpr char kBtmLogHistoryTag[] = "A2DP";
@@ -357,6 +359,7 @@ class BtifAvSource {
       : callbacks_(nullptr),
         enabled_(false),
         a2dp_offload_enabled_(false),
+        fanout_enabled_(false),
         max_connected_peers_(kDefaultMaxConnectedAudioDevices) {}
   ~BtifAvSource();
 
@@ -369,6 +372,7 @@ class BtifAvSource {
   btav_source_callbacks_t* Callbacks() { return callbacks_; }
   bool Enabled() const { return enabled_; }
   bool A2dpOffloadEnabled() const { return a2dp_offload_enabled_; }
+  bool FanoutEnabled() const { return fanout_enabled_; }
 
   BtifAvPeer* FindPeer(const RawAddress& peer_address);
   BtifAvPeer* FindPeerByHandle(tBTA_AV_HNDL bta_handle);
@@ -531,6 +535,7 @@ class BtifAvSource {
   btav_source_callbacks_t* callbacks_;
   bool enabled_;
   bool a2dp_offload_enabled_;
+  bool fanout_enabled_;  // Stream the active peer's audio to compatible peers
   int max_connected_peers_;
   std::map<RawAddress, BtifAvPeer*> peers_;
   std::set<RawAddress> silenced_peers_;
@@ -720,6 +725,14 @@ static BtifAvPeer* btif_av_find_active_peer() {
   return nullptr;
 }
 
+// Checks whether |peer| is a non-active Sink peer that is streamed the
+// packets encoded for the active peer.
+static bool btif_av_source_is_fanout_peer(const BtifAvPeer& peer) {
+  return btif_av_source.FanoutEnabled() && peer.IsSink() &&
+         !peer.IsActivePeer() &&
+         bta_av_co_is_fanout_compatible_peer(peer.PeerAddress());
+}
+
 /*****************************************************************************
  * Local helper functions
  *****************************************************************************/
@@ -977,6 +990,14 @@ bt_status_t BtifAvSource::Init(
       (strcmp(value_sup, "true") == 0) && (strcmp(value_dis, "false") == 0);
   BTIF_TRACE_DEBUG("a2dp_offload.enable = %d", a2dp_offload_enabled_);
 
+  // A2DP fan-out: the packets encoded for the active peer are also streamed
+  // to the other connected peers with the same codec configuration. Only the
+  // software encoding path can share its packets.
+  fanout_enabled_ = !a2dp_offload_enabled_ &&
+                    osi_property_get_bool(kFanoutProperty, false) &&
+                    max_connected_peers_ > 1;
+  BTIF_TRACE_DEBUG("a2dp_source.fanout = %d", fanout_enabled_);
+
   callbacks_ = callbacks;
   if (a2dp_offload_enabled_) {
     bluetooth::audio::a2dp::update_codec_offloading_capabilities(
@@ -1468,7 +1489,7 @@ bool BtifAvStateMachine::StateIdle::ProcessEvent(uint32_t event, void* p_data) {
             "peers",
             __PRETTY_FUNCTION__, peer_.PeerAddress().ToString().c_str());
         if (peer_.SelfInitiatedConnection()) {
-          btif_queue_advance();
+          btif_queue_advance_by_address(peer_.PeerAddress());
         }
         break;
       }
@@ -1591,7 +1612,7 @@ bool BtifAvStateMachine::StateIdle::ProcessEvent(uint32_t event, void* p_data) {
           BTA_AvOpenRc(peer_.BtaHandle());
         }
       }
-      btif_queue_advance();
+      btif_queue_advance_by_address(peer_.PeerAddress());
     } break;
 
     case BTA_AV_REMOTE_CMD_EVT:
@@ -1674,7 +1695,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(peer_.PeerAddress());
       }
       break;
     case BTA_AV_REJECT_EVT:
@@ -1686,7 +1707,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(peer_.PeerAddress());
       }
       break;
 
@@ -1740,7 +1761,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
         BTA_AvOpenRc(peer_.BtaHandle());
       }
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(peer_.PeerAddress());
       }
     } break;
 
@@ -1762,7 +1783,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
           "ignore Connect request",
           __PRETTY_FUNCTION__, peer_.PeerAddress().ToString().c_str(),
           BtifAvEvent::EventName(event).c_str());
-      btif_queue_advance();
+      btif_queue_advance_by_address(peer_.PeerAddress());
     } break;
 
     case BTA_AV_PENDING_EVT: {
@@ -1789,7 +1810,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(peer_.PeerAddress());
       }
       break;
 
@@ -1799,7 +1820,7 @@ bool BtifAvStateMachine::StateOpening::ProcessEvent(uint32_t event,
                                    BTAV_CONNECTION_STATE_DISCONNECTED);
       peer_.StateMachine().TransitionTo(BtifAvStateMachine::kStateIdle);
       if (peer_.SelfInitiatedConnection()) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(peer_.PeerAddress());
       }
       break;
 
@@ -1901,17 +1922,21 @@ bool BtifAvStateMachine::StateOpened::ProcessEvent(uint32_t event,
                        << peer_.PeerAddress()
                        << " : trigger Suspend as remote initiated";
           should_suspend = true;
-        } else if (!peer_.IsActivePeer()) {
+        } else if (!peer_.IsActivePeer() &&
+                   !btif_av_source_is_fanout_peer(peer_)) {
           LOG(WARNING) << __PRETTY_FUNCTION__ << ": Peer "
                        << peer_.PeerAddress()
                        << " : trigger Suspend as non-active";
           should_suspend = true;
         }
 
-        // If peer is A2DP Source, do ACK commands to audio HAL and start media
-        // task
-        if (btif_a2dp_on_started(peer_.PeerAddress(), &p_av->start)) {
-          // Only clear pending flag after acknowledgement
+        if (!peer_.IsActivePeer() && !should_suspend) {
+          // A fan-out peer shares the encoder and the audio HAL session of
+          // the active peer, so there is nothing to acknowledge
+          peer_.ClearFlags(BtifAvPeer::kFlagPendingStart);
+        } else if (btif_a2dp_on_started(peer_.PeerAddress(), &p_av->start)) {
+          // If peer is A2DP Source, do ACK commands to audio HAL and start
+          // media task. Only clear pending flag after acknowledgement
           peer_.ClearFlags(BtifAvPeer::kFlagPendingStart);
         }
       }
@@ -2010,7 +2035,7 @@ bool BtifAvStateMachine::StateOpened::ProcessEvent(uint32_t event,
                          __PRETTY_FUNCTION__,
                          peer_.PeerAddress().ToString().c_str(),
                          BtifAvEvent::EventName(event).c_str());
-      btif_queue_advance();
+      btif_queue_advance_by_address(peer_.PeerAddress());
     } break;
 
     case BTIF_AV_OFFLOAD_START_REQ_EVT:
@@ -2814,7 +2839,7 @@ static bt_status_t connect_int(RawAddress* peer_address, uint16_t uuid) {
       peer = btif_av_sink.FindOrCreatePeer(*peer_address, kBtaHandleUnknown);
     }
     if (peer == nullptr) {
-      btif_queue_advance();
+      btif_queue_advance_by_address(*peer_address);
       return;
     }
     peer->StateMachine().ProcessEvent(BTIF_AV_CONNECT_REQ_EVT, nullptr);
@@ -3058,6 +3083,26 @@ void btif_av_stream_start(void) {
   LOG_INFO("%s", __func__);
   btif_av_source_dispatch_sm_event(btif_av_source_active_peer(),
                                    BTIF_AV_START_STREAM_REQ_EVT);
+  if (!btif_av_source.FanoutEnabled()) return;
+
+  // Start the peers that share the encoded stream of the active peer. Each
+  // one has its own AVDTP stream, and is suspended independently.
+  auto src_do_fanout_start = []() {
+    for (auto it : btif_av_source.Peers()) {
+      const BtifAvPeer* peer = it.second;
+      if (peer->StateMachine().StateId() != BtifAvStateMachine::kStateOpened ||
+          peer->CheckFlags(BtifAvPeer::kFlagRemoteSuspend) ||
+          !btif_av_source_is_fanout_peer(*peer)) {
+        continue;
+      }
+      LOG_INFO("btif_av_stream_start: fan-out to peer %s",
+               peer->PeerAddress().ToString().c_str());
+      btif_av_source_dispatch_sm_event(peer->PeerAddress(),
+                                       BTIF_AV_START_STREAM_REQ_EVT);
+    }
+  };
+  // switch to main thread to prevent a race condition of accessing peers
+  do_in_main_thread(FROM_HERE, base::Bind(src_do_fanout_start));
 }
 
 void src_do_suspend_in_main_thread(btif_av_sm_event_t event) {
@@ -3410,6 +3455,8 @@ static void btif_debug_av_source_dump(int fd) {
   if (!enabled) return;
   dprintf(fd, "  Active peer: %s\n",
           btif_av_source.ActivePeer().ToString().c_str());
+  dprintf(fd, "  Fan-out: %s\n",
+          btif_av_source.FanoutEnabled() ? "Enabled" : "Disabled");
   for (auto it : btif_av_source.Peers()) {
     const BtifAvPeer* peer = it.second;
     btif_debug_av_peer_dump(fd, *peer);
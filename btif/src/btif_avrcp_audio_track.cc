@@ -23,6 +23,10 @@
 #include <base/logging.h>
 #include <utils/StrongPointer.h>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "bt_target.h"
 #include "osi/include/log.h"
 
@@ -34,6 +38,13 @@ typedef struct {
   int channelCount;
   float* buffer;
   size_t bufferLength;
+  // Drift compensation; inactive until a ratio has been set
+  bool resampleEnabled;
+  float resampleRatio;
+  double resamplePhase;
+  bool hasLastFrame;
+  std::vector<float> lastFrame;
+  std::vector<float> resampleBuffer;
 } BtifAvrcpAudioTrack;
 
 #if (DUMP_PCM_DATA == TRUE)
@@ -67,6 +78,11 @@ void* BtifAvrcpAudioTrackCreate(int trackFreq, int bitsPerSample,
   trackHolder->bufferLength =
       trackHolder->channelCount * AAudioStream_getBufferSizeInFrames(stream);
   trackHolder->buffer = new float[trackHolder->bufferLength]();
+  trackHolder->resampleEnabled = false;
+  trackHolder->resampleRatio = 1.0f;
+  trackHolder->resamplePhase = 0.0;
+  trackHolder->hasLastFrame = false;
+  trackHolder->lastFrame.resize(channelCount);
 
 #if (DUMP_PCM_DATA == TRUE)
   outputPcmSampleFile = fopen(outputFilename, "ab");
@@ -129,6 +145,8 @@ void BtifAvrcpAudioTrackPause(void* handle) {
     LOG_VERBOSE("%s Track.cpp: btPauseTrack", __func__);
     AAudioStream_requestPause(trackHolder->stream);
     AAudioStream_requestFlush(trackHolder->stream);
+    trackHolder->resamplePhase = 0.0;
+    trackHolder->hasLastFrame = false;
   }
 }
 
@@ -140,6 +158,17 @@ void BtifAvrcpSetAudioTrackGain(void* handle, float gain) {
   // Does nothing right now
 }
 
+void BtifAvrcpAudioTrackSetResampleRatio(void* handle, float ratio) {
+  if (handle == NULL) {
+    LOG_INFO("%s handle is null.", __func__);
+    return;
+  }
+  if (ratio <= 0.0f) return;
+  BtifAvrcpAudioTrack* trackHolder = static_cast<BtifAvrcpAudioTrack*>(handle);
+  trackHolder->resampleEnabled = true;
+  trackHolder->resampleRatio = ratio;
+}
+
 constexpr float kScaleQ15ToFloat = 1.0f / 32768.0f;
 constexpr float kScaleQ23ToFloat = 1.0f / 8388608.0f;
 constexpr float kScaleQ31ToFloat = 1.0f / 2147483648.0f;
@@ -193,6 +222,48 @@ static size_t transcodeToPcmFloat(uint8_t* buffer, size_t length,
   return -1;
 }
 
+// Resamples |inFrames| frames of trackHolder->buffer into
+// trackHolder->resampleBuffer and returns the number of output frames. The
+// interpolation phase and the last input frame carry over between calls, so
+// consecutive writes form one continuous stream.
+static int32_t resampleFrames(BtifAvrcpAudioTrack* trackHolder,
+                              int32_t inFrames) {
+  const int channels = trackHolder->channelCount;
+  const float* in = trackHolder->buffer;
+  if (inFrames <= 0) return 0;
+
+  if (!trackHolder->hasLastFrame) {
+    std::copy(in, in + channels, trackHolder->lastFrame.begin());
+    trackHolder->hasLastFrame = true;
+  }
+
+  const double step = 1.0 / trackHolder->resampleRatio;
+  trackHolder->resampleBuffer.resize(
+      ((size_t)((inFrames + 1) * trackHolder->resampleRatio) + 2) * channels);
+
+  // Position -1 is the last frame of the previous call
+  double pos = trackHolder->resamplePhase - 1.0;
+  int32_t outFrames = 0;
+  float* out = trackHolder->resampleBuffer.data();
+  while (pos < inFrames - 1) {
+    int32_t i = (int32_t)std::floor(pos);
+    float frac = (float)(pos - i);
+    const float* a =
+        (i < 0) ? trackHolder->lastFrame.data() : in + (size_t)i * channels;
+    const float* b = in + (size_t)(i + 1) * channels;
+    for (int c = 0; c < channels; c++) {
+      *out++ = a[c] + frac * (b[c] - a[c]);
+    }
+    outFrames++;
+    pos += step;
+  }
+
+  trackHolder->resamplePhase = pos - (inFrames - 1);
+  const float* last = in + (size_t)(inFrames - 1) * channels;
+  std::copy(last, last + channels, trackHolder->lastFrame.begin());
+  return outFrames;
+}
+
 constexpr int64_t kTimeoutNanos = 100 * 1000 * 1000;  // 100 ms
 
 int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
@@ -214,10 +285,16 @@ int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
         transcodeToPcmFloat(((uint8_t*)audioBuffer) + transcodedCount,
                             bufferLength - transcodedCount, trackHolder);
 
-    retval = AAudioStream_write(
-        trackHolder->stream, trackHolder->buffer,
-        transcodedCount / (sampleSize * trackHolder->channelCount),
-        kTimeoutNanos);
+    float* writeBuffer = trackHolder->buffer;
+    int32_t writeFrames =
+        transcodedCount / (sampleSize * trackHolder->channelCount);
+    if (trackHolder->resampleEnabled) {
+      writeFrames = resampleFrames(trackHolder, writeFrames);
+      writeBuffer = trackHolder->resampleBuffer.data();
+    }
+
+    retval = AAudioStream_write(trackHolder->stream, writeBuffer, writeFrames,
+                                kTimeoutNanos);
     LOG_VERBOSE("%s Track.cpp: btWriteData len = %d ret = %d", __func__,
                 bufferLength, retval);
   } while (transcodedCount < bufferLength);
@@ -31,6 +31,8 @@ void BtifAvrcpAudioTrackPause(void* handle) {}
 
 void BtifAvrcpSetAudioTrackGain(void* handle, float gain) {}
 
+void BtifAvrcpAudioTrackSetResampleRatio(void* handle, float ratio) {}
+
 int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
                                  int bufferlen) {
   return 0;
@@ -42,7 +42,9 @@
 #include "btif_dm.h"
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
+#include "btif_scan_filter.h"
 #include "btif_storage.h"
+#include "common/time_util.h"
 #include "osi/include/log.h"
 #include "stack/include/btu.h"
 #include "vendor_api.h"
@@ -54,6 +56,10 @@ using RegisterCallback = BleScannerInterface::RegisterCallback;
 
 extern const btgatt_callbacks_t* bt_gatt_callbacks;
 
+// Repeated scan results are dropped before they are posted to the JNI thread
+// once every scanner asks for it, see BtifScannerFilters.
+static constexpr size_t kScanFilterCapacity = 1024;
+
 #define SCAN_CBACK_IN_JNI(P_CBACK, ...)                              \
   do {                                                               \
     if (bt_gatt_callbacks && bt_gatt_callbacks->scanner->P_CBACK) {  \
@@ -92,6 +98,28 @@ void btif_address_cache_init(void) {
   remote_bdaddr_cache_ordered = {};
 }
 
+// all access to this variable should be done on the main thread
+BtifScannerFilters scan_filters(kScanFilterCapacity);
+
+void btif_scan_filter_init() { scan_filters.Clear(); }
+
+void btif_scan_filter_cleanup() {
+  LOG_INFO("%s: scan results reported %llu, suppressed %llu", __func__,
+           (unsigned long long)scan_filters.GetReportedCount(),
+           (unsigned long long)scan_filters.GetSuppressedCount());
+}
+
+void btif_scanner_registered(RegisterCallback cb, uint8_t scanner_id,
+                             uint8_t status) {
+  if (status == GATT_SUCCESS) scan_filters.AddScanner(scanner_id);
+  cb.Run(scanner_id, status);
+}
+
+void btif_scanner_unregister(int scanner_id) {
+  scan_filters.RemoveScanner(scanner_id);
+  BTA_GATTC_AppDeregister(scanner_id);
+}
+
 void bta_batch_scan_threshold_cb(tBTM_BLE_REF_VALUE ref_value) {
   SCAN_CBACK_IN_JNI(batchscan_threshold_cb, ref_value);
 }
@@ -114,12 +142,13 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
   bt_device_type_t dev_type;
   bt_property_t properties;
 
-  const uint8_t* p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-      value, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
+  AdIndex ad(value);
+  const uint8_t* p_eir_remote_name =
+      ad.GetFieldByType(BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
 
   if (p_eir_remote_name == NULL) {
-    p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-        value, BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
+    p_eir_remote_name =
+        ad.GetFieldByType(BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
   }
 
   if ((addr_type != BLE_ADDR_RANDOM) || (p_eir_remote_name)) {
@@ -184,6 +213,12 @@ void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
   }
 
   tBTA_DM_INQ_RES* r = &p_data->inq_res;
+  uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+  if (!scan_filters.ShouldReport(r->bd_addr, r->ble_evt_type, r->rssi, value,
+                                now_ms)) {
+    return;
+  }
+
   do_in_jni_thread(Bind(bta_scan_results_cb_impl, r->bd_addr, r->device_type,
                         r->rssi, r->ble_addr_type, r->ble_evt_type,
                         r->ble_primary_phy, r->ble_secondary_phy,
@@ -213,14 +248,28 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
                           [](RegisterCallback cb) {
                             BTA_GATTC_AppRegister(
                                 bta_cback,
-                                jni_thread_wrapper(FROM_HERE, std::move(cb)),
+                                Bind(&btif_scanner_registered,
+                                     jni_thread_wrapper(FROM_HERE,
+                                                        std::move(cb))),
                                 false);
                           },
                           std::move(cb)));
   }
 
   void Unregister(int scanner_id) override {
-    do_in_main_thread(FROM_HERE, Bind(&BTA_GATTC_AppDeregister, scanner_id));
+    do_in_main_thread(FROM_HERE, Bind(&btif_scanner_unregister, scanner_id));
+  }
+
+  void SetScanResultFilter(int scanner_id, int window_ms,
+                           int rssi_threshold) override {
+    do_in_main_thread(
+        FROM_HERE,
+        Bind(
+            [](int scanner_id, int window_ms, int rssi_threshold) {
+              scan_filters.SetFilter(scanner_id, window_ms > 0 ? window_ms : 0,
+                                     rssi_threshold);
+            },
+            scanner_id, window_ms, rssi_threshold));
   }
 
   void Scan(bool start) override {
@@ -229,10 +278,12 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
           if (!start) {
             do_in_main_thread(FROM_HERE,
                               Bind(&BTA_DmBleObserve, false, 0, nullptr));
+            do_in_main_thread(FROM_HERE, Bind(&btif_scan_filter_cleanup));
             return;
           }
 
           btif_address_cache_init();
+          do_in_main_thread(FROM_HERE, Bind(&btif_scan_filter_init));
           do_in_main_thread(
               FROM_HERE, Bind(&BTA_DmBleObserve, true, 0, bta_scan_results_cb));
         },
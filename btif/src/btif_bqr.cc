@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <base/bind.h>
+#include <base/location.h>
 #include <base/logging.h>
+#include <base/time/time.h>
 #include <errno.h>
 #include <fcntl.h>
 #ifdef OS_ANDROID
@@ -23,22 +26,132 @@
 #include <stdio.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "btif_bqr.h"
 #include "btif_common.h"
 #include "btm_api.h"
-#include "common/leaky_bonded_queue.h"
+#include "common/lock_free_leaky_bonded_queue.h"
+#include "common/message_loop_thread.h"
 #include "common/time_util.h"
 #include "osi/include/properties.h"
 
 namespace bluetooth {
 namespace bqr {
 
-using bluetooth::common::LeakyBondedQueue;
+using bluetooth::common::LockFreeLeakyBondedQueue;
+using bluetooth::common::MessageLoopThread;
 using std::chrono::system_clock;
 
-// The instance of BQR event queue
-static std::unique_ptr<LeakyBondedQueue<BqrVseSubEvt>> kpBqrEventQueue(
-    new LeakyBondedQueue<BqrVseSubEvt>(kBqrEventQueueSize));
+// The instance of BQR event queue. Its single producer is the BQR thread, or
+// the HCI event path while that thread is not running. Dumpsys drains it
+// without waiting on the producer.
+static std::unique_ptr<LockFreeLeakyBondedQueue<BqrVseSubEvt>> kpBqrEventQueue(
+    new LockFreeLeakyBondedQueue<BqrVseSubEvt>(kBqrEventQueueSize));
+
+// Logging, reporting and aggregating the events, and writing the trace logs,
+// is done on this thread, away from the HCI and main threads that receive them
+static MessageLoopThread bqr_thread("bt_bqr_thread");
+
+// A trace log file, only accessed from the BQR thread. Events are formatted
+// into |pending| and written to the file in batches.
+struct TraceLogFile {
+  const char* path;
+  const char* last_path;
+  int fd = INVALID_FD;
+  // Count of the events written to the current file
+  uint16_t event_count = 0;
+  std::string pending;
+};
+
+static TraceLogFile lmp_ll_message_trace_log = {
+    kpLmpLlMessageTraceLogPath, kpLmpLlMessageTraceLastLogPath};
+static TraceLogFile bt_scheduling_trace_log = {kpBtSchedulingTraceLogPath,
+                                               kpBtSchedulingTraceLastLogPath};
+static bool trace_log_flush_scheduled = false;
+
+// Link quality of the window in progress of a connection, only accessed from
+// the BQR thread
+struct LinkQualityWindow {
+  BqrLinkQualityStats stats = {};
+  int32_t rssi_sum = 0;
+  uint32_t snr_sum = 0;
+};
+
+static std::unordered_map<uint16_t, LinkQualityWindow> link_quality_windows;
+
+// Link quality of the last completed window of each connection
+static std::mutex link_quality_stats_mutex;
+static std::unordered_map<uint16_t, BqrLinkQualityStats> link_quality_stats;
+
+// Runs |task| on the BQR thread, or in place when it is not running
+static void RunInBqrThread(base::OnceClosure task) {
+  if (!bqr_thread.IsRunning()) {
+    std::move(task).Run();
+    return;
+  }
+  if (!bqr_thread.DoInThread(FROM_HERE, std::move(task))) {
+    LOG(ERROR) << __func__ << ": Unable to post to " << bqr_thread;
+  }
+}
+
+// Opens a new trace log file, the previous one is kept as the last log file
+static void OpenTraceLog(TraceLogFile* p_log) {
+  if (rename(p_log->path, p_log->last_path) != 0 && errno != ENOENT) {
+    LOG(ERROR) << __func__ << ": Unable to rename '" << p_log->path
+               << "' to '" << p_log->last_path << "' : " << strerror(errno);
+  }
+
+  mode_t prevmask = umask(0);
+  p_log->fd = open(p_log->path, O_WRONLY | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+  umask(prevmask);
+  if (p_log->fd == INVALID_FD) {
+    LOG(ERROR) << __func__ << ": Unable to open '" << p_log->path
+               << "' : " << strerror(errno);
+  } else {
+    p_log->event_count = 0;
+  }
+}
+
+static void FlushTraceLog(TraceLogFile* p_log) {
+  if (p_log->fd != INVALID_FD && !p_log->pending.empty()) {
+    TEMP_FAILURE_RETRY(
+        write(p_log->fd, p_log->pending.data(), p_log->pending.size()));
+  }
+  p_log->pending.clear();
+}
+
+static void CloseTraceLog(TraceLogFile* p_log) {
+  if (p_log->fd == INVALID_FD) {
+    return;
+  }
+  FlushTraceLog(p_log);
+  close(p_log->fd);
+  p_log->fd = INVALID_FD;
+}
+
+static void FlushTraceLogs() {
+  trace_log_flush_scheduled = false;
+  FlushTraceLog(&lmp_ll_message_trace_log);
+  FlushTraceLog(&bt_scheduling_trace_log);
+}
+
+static void CloseTraceLogs(uint32_t current_evt_mask) {
+  if (lmp_ll_message_trace_log.fd != INVALID_FD &&
+      (current_evt_mask & kQualityEventMaskLmpMessageTrace) == 0) {
+    LOG(INFO) << __func__ << ": Closing LMP/LL log file.";
+    CloseTraceLog(&lmp_ll_message_trace_log);
+  }
+  if (bt_scheduling_trace_log.fd != INVALID_FD &&
+      (current_evt_mask & kQualityEventMaskBtSchedulingTrace) == 0) {
+    LOG(INFO) << __func__ << ": Closing Scheduling log file.";
+    CloseTraceLog(&bt_scheduling_trace_log);
+  }
+}
 
 void BqrVseSubEvt::ParseBqrLinkQualityEvt(uint8_t length,
                                           uint8_t* p_param_buf) {
@@ -77,37 +190,12 @@ void BqrVseSubEvt::ParseBqrLinkQualityEvt(uint8_t length,
   localtime_r(&now, &tm_timestamp_);
 }
 
-void BqrVseSubEvt::WriteLmpLlTraceLogFile(int fd, uint8_t length,
-                                          uint8_t* p_param_buf) {
-  const auto now = system_clock::to_time_t(system_clock::now());
-  localtime_r(&now, &tm_timestamp_);
-
-  STREAM_TO_UINT8(bqr_log_dump_event_.quality_report_id, p_param_buf);
-  STREAM_TO_UINT16(bqr_log_dump_event_.connection_handle, p_param_buf);
-  length -= kLogDumpParamTotalLen;
-  bqr_log_dump_event_.vendor_specific_parameter = p_param_buf;
-
-  std::stringstream ss_log;
-  ss_log << "\n"
-         << std::put_time(&tm_timestamp_, "%m-%d %H:%M:%S ")
-         << "Handle: " << loghex(bqr_log_dump_event_.connection_handle)
-         << " VSP: ";
-
-  TEMP_FAILURE_RETRY(write(fd, ss_log.str().c_str(), ss_log.str().size()));
-  TEMP_FAILURE_RETRY(
-      write(fd, bqr_log_dump_event_.vendor_specific_parameter, length));
-  LmpLlMessageTraceCounter++;
-}
-
-void BqrVseSubEvt::WriteBtSchedulingTraceLogFile(int fd, uint8_t length,
-                                                 uint8_t* p_param_buf) {
-  const auto now = system_clock::to_time_t(system_clock::now());
-  localtime_r(&now, &tm_timestamp_);
-
+void BqrVseSubEvt::AppendLogDumpEvt(uint8_t length,
+                                    const uint8_t* p_param_buf,
+                                    std::string* p_log) {
   STREAM_TO_UINT8(bqr_log_dump_event_.quality_report_id, p_param_buf);
   STREAM_TO_UINT16(bqr_log_dump_event_.connection_handle, p_param_buf);
   length -= kLogDumpParamTotalLen;
-  bqr_log_dump_event_.vendor_specific_parameter = p_param_buf;
 
   std::stringstream ss_log;
   ss_log << "\n"
@@ -115,10 +203,8 @@ void BqrVseSubEvt::WriteBtSchedulingTraceLogFile(int fd, uint8_t length,
          << "Handle: " << loghex(bqr_log_dump_event_.connection_handle)
          << " VSP: ";
 
-  TEMP_FAILURE_RETRY(write(fd, ss_log.str().c_str(), ss_log.str().size()));
-  TEMP_FAILURE_RETRY(
-      write(fd, bqr_log_dump_event_.vendor_specific_parameter, length));
-  BtSchedulingTraceCounter++;
+  p_log->append(ss_log.str());
+  p_log->append(reinterpret_cast<const char*>(p_param_buf), length);
 }
 
 std::string BqrVseSubEvt::ToString() const {
@@ -243,6 +329,11 @@ void EnableBtQualityReport(bool is_enable) {
   BqrConfiguration bqr_config = {};
 
   if (is_enable) {
+    bqr_thread.StartUp();
+    if (!bqr_thread.IsRunning()) {
+      LOG(ERROR) << __func__ << ": Unable to start " << bqr_thread
+                 << ", events will be handled in place";
+    }
     bqr_config.report_action = REPORT_ACTION_ADD;
     bqr_config.quality_event_mask =
         static_cast<uint32_t>(atoi(bqr_prop_evtmask));
@@ -258,6 +349,16 @@ void EnableBtQualityReport(bool is_enable) {
             << ": Event Mask: " << loghex(bqr_config.quality_event_mask)
             << ", Interval: " << bqr_config.minimum_report_interval_ms;
   ConfigureBqr(bqr_config);
+
+  if (!is_enable) {
+    // The events already queued are handled before the thread exits, the ones
+    // received until the controller stops reporting are handled in place
+    bqr_thread.ShutDown();
+    FlushTraceLogs();
+    link_quality_windows.clear();
+    std::lock_guard<std::mutex> lock(link_quality_stats_mutex);
+    link_quality_stats.clear();
+  }
 }
 
 void ConfigureBqr(const BqrConfiguration& bqr_config) {
@@ -330,18 +431,7 @@ void ConfigureBqrCmpl(uint32_t current_evt_mask) {
     return;
   }
 
-  if (LmpLlMessageTraceLogFd != INVALID_FD &&
-      (current_evt_mask & kQualityEventMaskLmpMessageTrace) == 0) {
-    LOG(INFO) << __func__ << ": Closing LMP/LL log file.";
-    close(LmpLlMessageTraceLogFd);
-    LmpLlMessageTraceLogFd = INVALID_FD;
-  }
-  if (BtSchedulingTraceLogFd != INVALID_FD &&
-      (current_evt_mask & kQualityEventMaskBtSchedulingTrace) == 0) {
-    LOG(INFO) << __func__ << ": Closing Scheduling log file.";
-    close(BtSchedulingTraceLogFd);
-    BtSchedulingTraceLogFd = INVALID_FD;
-  }
+  RunInBqrThread(base::BindOnce(CloseTraceLogs, current_evt_mask));
 }
 
 void CategorizeBqrEvent(uint8_t length, uint8_t* p_bqr_event) {
@@ -383,42 +473,78 @@ void CategorizeBqrEvent(uint8_t length, uint8_t* p_bqr_event) {
   }
 }
 
-void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event) {
-  std::unique_ptr<BqrVseSubEvt> p_bqr_event = std::make_unique<BqrVseSubEvt>();
-  p_bqr_event->ParseBqrLinkQualityEvt(length, p_link_quality_event);
-
-  LOG(WARNING) << *p_bqr_event;
-  invoke_link_quality_report_cb(
-      bluetooth::common::time_get_os_boottime_ms(),
-      p_bqr_event->bqr_link_quality_event_.quality_report_id,
-      p_bqr_event->bqr_link_quality_event_.rssi,
-      p_bqr_event->bqr_link_quality_event_.snr,
-      p_bqr_event->bqr_link_quality_event_.retransmission_count,
-      p_bqr_event->bqr_link_quality_event_.no_rx_count,
-      p_bqr_event->bqr_link_quality_event_.nak_count);
+// Adds a Link Quality event to the window in progress of its connection, and
+// publishes the window once the event falls past its end
+static void AggregateLinkQualityEvent(const BqrLinkQualityEvent& evt,
+                                      uint64_t timestamp_ms) {
+  LinkQualityWindow& window = link_quality_windows[evt.connection_handle];
+  BqrLinkQualityStats& stats = window.stats;
+
+  if (stats.event_count > 0 &&
+      timestamp_ms - stats.window_start_ms >= kLinkQualityStatsWindowMs) {
+    stats.rssi_avg = window.rssi_sum / stats.event_count;
+    stats.snr_avg = window.snr_sum / stats.event_count;
+    stats.window_seq++;
+    {
+      std::lock_guard<std::mutex> lock(link_quality_stats_mutex);
+      link_quality_stats[evt.connection_handle] = stats;
+    }
+    uint32_t window_seq = stats.window_seq;
+    window = LinkQualityWindow();
+    stats.window_seq = window_seq;
+  }
+
+  if (stats.event_count == 0) {
+    stats.window_start_ms = timestamp_ms;
+    stats.rssi_min = evt.rssi;
+  }
+  stats.event_count++;
+  if (evt.quality_report_id == QUALITY_REPORT_ID_A2DP_AUDIO_CHOPPY) {
+    stats.a2dp_choppy_count++;
+  } else if (evt.quality_report_id == QUALITY_REPORT_ID_SCO_VOICE_CHOPPY) {
+    stats.sco_choppy_count++;
+  }
+  window.rssi_sum += evt.rssi;
+  window.snr_sum += evt.snr;
+  stats.rssi_min = std::min(stats.rssi_min, evt.rssi);
+  stats.retransmission_count += evt.retransmission_count;
+  stats.no_rx_count += evt.no_rx_count;
+  stats.nak_count += evt.nak_count;
+  stats.flow_off_count += evt.flow_off_count;
+  stats.buffer_overflow_bytes += evt.buffer_overflow_bytes;
+}
+
+static void HandleLinkQualityEvent(BqrVseSubEvt bqr_event,
+                                   uint64_t timestamp_ms) {
+  const BqrLinkQualityEvent& evt = bqr_event.bqr_link_quality_event_;
+
+  LOG(WARNING) << bqr_event;
+  invoke_link_quality_report_cb(timestamp_ms, evt.quality_report_id, evt.rssi,
+                                evt.snr, evt.retransmission_count,
+                                evt.no_rx_count, evt.nak_count);
 
 #ifdef OS_ANDROID
   int ret = android::util::stats_write(
       android::util::BLUETOOTH_QUALITY_REPORT_REPORTED,
-      p_bqr_event->bqr_link_quality_event_.quality_report_id,
-      p_bqr_event->bqr_link_quality_event_.packet_types,
-      p_bqr_event->bqr_link_quality_event_.connection_handle,
-      p_bqr_event->bqr_link_quality_event_.connection_role,
-      p_bqr_event->bqr_link_quality_event_.tx_power_level,
-      p_bqr_event->bqr_link_quality_event_.rssi,
-      p_bqr_event->bqr_link_quality_event_.snr,
-      p_bqr_event->bqr_link_quality_event_.unused_afh_channel_count,
-      p_bqr_event->bqr_link_quality_event_.afh_select_unideal_channel_count,
-      p_bqr_event->bqr_link_quality_event_.lsto,
-      p_bqr_event->bqr_link_quality_event_.connection_piconet_clock,
-      p_bqr_event->bqr_link_quality_event_.retransmission_count,
-      p_bqr_event->bqr_link_quality_event_.no_rx_count,
-      p_bqr_event->bqr_link_quality_event_.nak_count,
-      p_bqr_event->bqr_link_quality_event_.last_tx_ack_timestamp,
-      p_bqr_event->bqr_link_quality_event_.flow_off_count,
-      p_bqr_event->bqr_link_quality_event_.last_flow_on_timestamp,
-      p_bqr_event->bqr_link_quality_event_.buffer_overflow_bytes,
-      p_bqr_event->bqr_link_quality_event_.buffer_underflow_bytes);
+      evt.quality_report_id,
+      evt.packet_types,
+      evt.connection_handle,
+      evt.connection_role,
+      evt.tx_power_level,
+      evt.rssi,
+      evt.snr,
+      evt.unused_afh_channel_count,
+      evt.afh_select_unideal_channel_count,
+      evt.lsto,
+      evt.connection_piconet_clock,
+      evt.retransmission_count,
+      evt.no_rx_count,
+      evt.nak_count,
+      evt.last_tx_ack_timestamp,
+      evt.flow_off_count,
+      evt.last_flow_on_timestamp,
+      evt.buffer_overflow_bytes,
+      evt.buffer_underflow_bytes);
   if (ret < 0) {
     LOG(WARNING) << __func__ << ": failed to log BQR event to statsd, error "
                  << ret;
@@ -426,80 +552,94 @@ void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event) {
 #else
   // TODO(abps) Metrics for non-Android build
 #endif
-  kpBqrEventQueue->Enqueue(p_bqr_event.release());
+  AggregateLinkQualityEvent(evt, timestamp_ms);
+  kpBqrEventQueue->Enqueue(new BqrVseSubEvt(bqr_event));
 }
 
-void DumpLmpLlMessage(uint8_t length, uint8_t* p_lmp_ll_message_event) {
-  std::unique_ptr<BqrVseSubEvt> p_bqr_event = std::make_unique<BqrVseSubEvt>();
+void AddLinkQualityEventToQueue(uint8_t length, uint8_t* p_link_quality_event) {
+  BqrVseSubEvt bqr_event;
+  bqr_event.ParseBqrLinkQualityEvt(length, p_link_quality_event);
 
-  if (LmpLlMessageTraceLogFd == INVALID_FD ||
-      LmpLlMessageTraceCounter >= kLogDumpEventPerFile) {
-    LmpLlMessageTraceLogFd = OpenLmpLlTraceLogFile();
-  }
-  if (LmpLlMessageTraceLogFd != INVALID_FD) {
-    p_bqr_event->WriteLmpLlTraceLogFile(LmpLlMessageTraceLogFd, length,
-                                        p_lmp_ll_message_event);
+  RunInBqrThread(base::BindOnce(HandleLinkQualityEvent, bqr_event,
+                                bluetooth::common::time_get_os_boottime_ms()));
+}
+
+bool GetLinkQualityStats(uint16_t connection_handle,
+                         BqrLinkQualityStats* p_stats) {
+  std::lock_guard<std::mutex> lock(link_quality_stats_mutex);
+  auto it = link_quality_stats.find(connection_handle);
+  if (it == link_quality_stats.end()) {
+    return false;
   }
+  *p_stats = it->second;
+  return true;
 }
 
-int OpenLmpLlTraceLogFile() {
-  if (rename(kpLmpLlMessageTraceLogPath, kpLmpLlMessageTraceLastLogPath) != 0 &&
-      errno != ENOENT) {
-    LOG(ERROR) << __func__ << ": Unable to rename '"
-               << kpLmpLlMessageTraceLogPath << "' to '"
-               << kpLmpLlMessageTraceLastLogPath << "' : " << strerror(errno);
+// Appends a Log Dump event to its trace log. The pending data is written once
+// it grows past kTraceLogFlushBytes, or kTraceLogFlushDelayMs later.
+static void WriteTraceLog(TraceLogFile* p_log, std::time_t timestamp,
+                          std::vector<uint8_t> event) {
+  if (p_log->fd == INVALID_FD || p_log->event_count >= kLogDumpEventPerFile) {
+    CloseTraceLog(p_log);
+    OpenTraceLog(p_log);
+  }
+  if (p_log->fd == INVALID_FD) {
+    return;
   }
 
-  mode_t prevmask = umask(0);
-  int logfile_fd =
-      open(kpLmpLlMessageTraceLogPath, O_WRONLY | O_CREAT | O_TRUNC,
-           S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
-  umask(prevmask);
-  if (logfile_fd == INVALID_FD) {
-    LOG(ERROR) << __func__ << ": Unable to open '" << kpLmpLlMessageTraceLogPath
-               << "' : " << strerror(errno);
-  } else {
-    LmpLlMessageTraceCounter = 0;
+  BqrVseSubEvt bqr_event;
+  localtime_r(&timestamp, &bqr_event.tm_timestamp_);
+  bqr_event.AppendLogDumpEvt(event.size(), event.data(), &p_log->pending);
+  p_log->event_count++;
+
+  if (p_log->pending.size() >= kTraceLogFlushBytes ||
+      !bqr_thread.IsRunning()) {
+    FlushTraceLog(p_log);
+  } else if (!trace_log_flush_scheduled) {
+    trace_log_flush_scheduled = bqr_thread.DoInThreadDelayed(
+        FROM_HERE, base::BindOnce(FlushTraceLogs),
+        base::TimeDelta::FromMilliseconds(kTraceLogFlushDelayMs));
   }
-  return logfile_fd;
 }
 
-void DumpBtScheduling(uint8_t length, uint8_t* p_bt_scheduling_event) {
-  std::unique_ptr<BqrVseSubEvt> p_bqr_event = std::make_unique<BqrVseSubEvt>();
-
-  if (BtSchedulingTraceLogFd == INVALID_FD ||
-      BtSchedulingTraceCounter == kLogDumpEventPerFile) {
-    BtSchedulingTraceLogFd = OpenBtSchedulingTraceLogFile();
-  }
-  if (BtSchedulingTraceLogFd != INVALID_FD) {
-    p_bqr_event->WriteBtSchedulingTraceLogFile(BtSchedulingTraceLogFd, length,
-                                               p_bt_scheduling_event);
-  }
+// Copies a Log Dump event received on the HCI path, to be written from the BQR
+// thread
+static void QueueTraceLogEvent(TraceLogFile* p_log, uint8_t length,
+                               const uint8_t* p_event) {
+  std::vector<uint8_t> event(p_event, p_event + length);
+  RunInBqrThread(base::BindOnce(WriteTraceLog, p_log,
+                                system_clock::to_time_t(system_clock::now()),
+                                std::move(event)));
 }
 
-int OpenBtSchedulingTraceLogFile() {
-  if (rename(kpBtSchedulingTraceLogPath, kpBtSchedulingTraceLastLogPath) != 0 &&
-      errno != ENOENT) {
-    LOG(ERROR) << __func__ << ": Unable to rename '"
-               << kpBtSchedulingTraceLogPath << "' to '"
-               << kpBtSchedulingTraceLastLogPath << "' : " << strerror(errno);
-  }
+void DumpLmpLlMessage(uint8_t length, uint8_t* p_lmp_ll_message_event) {
+  QueueTraceLogEvent(&lmp_ll_message_trace_log, length,
+                     p_lmp_ll_message_event);
+}
 
-  mode_t prevmask = umask(0);
-  int logfile_fd =
-      open(kpBtSchedulingTraceLogPath, O_WRONLY | O_CREAT | O_TRUNC,
-           S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
-  umask(prevmask);
-  if (logfile_fd == INVALID_FD) {
-    LOG(ERROR) << __func__ << ": Unable to open '" << kpBtSchedulingTraceLogPath
-               << "' : " << strerror(errno);
-  } else {
-    BtSchedulingTraceCounter = 0;
-  }
-  return logfile_fd;
+void DumpBtScheduling(uint8_t length, uint8_t* p_bt_scheduling_event) {
+  QueueTraceLogEvent(&bt_scheduling_trace_log, length, p_bt_scheduling_event);
 }
 
 void DebugDump(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(link_quality_stats_mutex);
+    dprintf(fd, "\nBT Quality Report Link Quality (last %u ms window): \n",
+            kLinkQualityStatsWindowMs);
+    for (const auto& it : link_quality_stats) {
+      const BqrLinkQualityStats& stats = it.second;
+      dprintf(fd,
+              "  Handle: 0x%04x, Events: %u, A2DP/SCO Choppy: %u/%u, "
+              "RSSI avg/min: %d/%d, SNR: %u, ReTx: %u, NoRX: %u, NAK: %u, "
+              "FlowOff: %u, OverFlow: %u\n",
+              it.first, stats.event_count, stats.a2dp_choppy_count,
+              stats.sco_choppy_count, stats.rssi_avg, stats.rssi_min,
+              stats.snr_avg, stats.retransmission_count, stats.no_rx_count,
+              stats.nak_count, stats.flow_off_count,
+              stats.buffer_overflow_bytes);
+    }
+  }
+
   dprintf(fd, "\nBT Quality Report Events: \n");
 
   if (kpBqrEventQueue->Empty()) {
@@ -507,8 +647,8 @@ void DebugDump(int fd) {
     return;
   }
 
-  while (!kpBqrEventQueue->Empty()) {
-    std::unique_ptr<BqrVseSubEvt> p_event(kpBqrEventQueue->Dequeue());
+  for (std::unique_ptr<BqrVseSubEvt> p_event(kpBqrEventQueue->Dequeue());
+       p_event != nullptr; p_event.reset(kpBqrEventQueue->Dequeue())) {
 
     bool warning = (p_event->bqr_link_quality_event_.rssi < kCriWarnRssi ||
                     p_event->bqr_link_quality_event_.unused_afh_channel_count >
@@ -24,6 +24,7 @@
 #include <openssl/rand.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cstdio>
 #include <cstring>
@@ -43,6 +44,7 @@
 #include "btif_metrics_logging.h"
 #include "common/address_obfuscator.h"
 #include "common/metric_id_allocator.h"
+#include "common/time_util.h"
 #include "main/shim/config.h"
 #include "main/shim/shim.h"
 #include "osi/include/alarm.h"
@@ -84,6 +86,10 @@ static const char* CONFIG_LEGACY_FILE_PATH =
     "/data/misc/bluedroid/bt_config.xml";
 #endif  // defined(OS_GENERIC)
 static const uint64_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// Each change pushes the save back by CONFIG_SETTLE_PERIOD_MS so that bursts
+// of changes are saved once, but never further than this after the first
+// unsaved change, e.g. while many devices keep reconnecting.
+static const uint64_t CONFIG_MAX_SETTLE_PERIOD_MS = 10000;
 
 static void timer_config_save_cb(void* data);
 static void btif_config_write(uint16_t event, char* p_param);
@@ -241,7 +247,20 @@ static void init_metric_id_allocator() {
 }
 
 static std::recursive_mutex config_lock;  // protects operations on |config|.
+// Serializes writes of |config| to disk. Taken before |config_lock|, which is
+// only held to copy |config| so that readers do not wait on file I/O.
+static std::mutex config_save_lock;
+// Number of changes made to |config|, protected by |config_lock|.
+static uint64_t config_change_count = 0;
 static alarm_t* config_timer;
+// Protects |config_save_first_request_ms|.
+static std::mutex config_timer_lock;
+// When the save pending on |config_timer| was first requested.
+static uint64_t config_save_first_request_ms = 0;
+// Number and durations of the saves, protected by |config_save_lock|.
+static uint64_t config_save_count = 0;
+static uint64_t config_save_total_ms = 0;
+static uint64_t config_save_max_ms = 0;
 
 // limited btif config cache capacity
 static BtifConfigCache btif_config_cache(TEMPORARY_SECTION_CAPACITY);
@@ -293,14 +312,17 @@ static future_t* init(void) {
 
   // move persistent config data from btif_config file to btif config cache
   btif_config_cache.Init(std::move(config));
+  config_change_count++;
 
   if (!file_source.empty()) {
     btif_config_cache.SetString(INFO_SECTION, FILE_SOURCE, file_source);
+    config_change_count++;
   }
 
   // Cleanup temporary pairings if we have left guest mode
   if (!is_restricted_mode()) {
     btif_config_cache.RemovePersistentSectionsWithKey("Restricted");
+    config_change_count++;
   }
 
   // Read or set config file creation timestamp
@@ -312,6 +334,7 @@ static future_t* init(void) {
              time_created);
     btif_config_cache.SetString(INFO_SECTION, FILE_TIMESTAMP,
                                 btif_config_time_created);
+    config_change_count++;
   } else {
     strlcpy(btif_config_time_created, time_str->c_str(), TIME_STRING_LENGTH);
   }
@@ -339,6 +362,7 @@ error:
   alarm_free(config_timer);
   config.reset();
   btif_config_cache.Clear();
+  config_change_count++;
   config_timer = NULL;
   btif_config_source = NOT_LOADED;
   return future_new_immediate(FUTURE_FAIL);
@@ -378,6 +402,7 @@ static future_t* clean_up(void) {
   get_bluetooth_keystore_interface()->clear_map();
   close_metric_id_allocator();
   btif_config_cache.Clear();
+  config_change_count++;
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -420,6 +445,7 @@ bool btif_config_set_int(const std::string& section, const std::string& key,
   }
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   btif_config_cache.SetInt(section, key, value);
+  config_change_count++;
   return true;
 }
 
@@ -447,6 +473,7 @@ bool btif_config_set_uint64(const std::string& section, const std::string& key,
   }
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   btif_config_cache.SetUint64(section, key, value);
+  config_change_count++;
   return true;
 }
 
@@ -497,6 +524,7 @@ bool btif_config_set_str(const std::string& section, const std::string& key,
   }
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   btif_config_cache.SetString(section, key, value);
+  config_change_count++;
   return true;
 }
 
@@ -561,10 +589,12 @@ bool btif_config_get_bin(const std::string& section, const std::string& key,
       get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
           section + "-" + key, *value_str_from_config);
       btif_config_cache.SetString(section, key, ENCRYPTED_STR);
+      config_change_count++;
     }
   } else {
     if (in_encrypt_key_name_list && is_key_encrypted) {
       btif_config_cache.SetString(section, key, *value_str);
+      config_change_count++;
     }
   }
 
@@ -610,8 +640,20 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
   std::string value_str;
   if ((length > 0) && is_common_criteria_mode() &&
       btif_in_encrypt_key_name_list(key)) {
-    get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
-        section + "-" + key, str);
+    std::string prefix = section + "-" + key;
+    bool is_key_encrypted;
+    {
+      std::unique_lock<std::recursive_mutex> lock(config_lock);
+      auto value_str_from_config = btif_config_cache.GetString(section, key);
+      is_key_encrypted =
+          value_str_from_config && *value_str_from_config == ENCRYPTED_STR;
+    }
+    // Only re-encrypt the key if it changed
+    if (!is_key_encrypted ||
+        get_bluetooth_keystore_interface()->get_key(prefix) != str) {
+      get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
+          prefix, str);
+    }
     value_str = ENCRYPTED_STR;
   } else {
     value_str = str;
@@ -620,6 +662,7 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
   {
     std::unique_lock<std::recursive_mutex> lock(config_lock);
     btif_config_cache.SetString(section, key, value_str);
+    config_change_count++;
   }
 
   osi_free(str);
@@ -647,6 +690,38 @@ std::vector<RawAddress> btif_config_get_paired_devices() {
   return result;
 }
 
+void btif_config_for_each_paired_device_property(
+    const std::function<void(const RawAddress& address, const std::string& key,
+                             const std::string& value)>& visitor) {
+  // Entries come grouped by section, only parse each section name once
+  std::string section_name;
+  RawAddress address;
+  bool is_device = false;
+  auto visit_entry = [&](const std::string& section, const std::string& key,
+                         const std::string& value) {
+    if (section != section_name) {
+      section_name = section;
+      is_device = RawAddress::FromString(section, address);
+    }
+    if (is_device) visitor(address, key, value);
+  };
+  if (bluetooth::shim::is_any_gd_enabled()) {
+    CHECK(bluetooth::shim::is_gd_stack_started_up());
+    bluetooth::shim::BtifConfigInterface::ForEachPersistentProperty(
+        visit_entry);
+    return;
+  }
+  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  btif_config_cache.ForEachPersistentEntry(visit_entry);
+}
+
+std::optional<uint64_t> btif_config_get_change_count(void) {
+  // GD modules change the GD storage without going through btif_config
+  if (bluetooth::shim::is_any_gd_enabled()) return std::nullopt;
+  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  return config_change_count;
+}
+
 bool btif_config_remove(const std::string& section, const std::string& key) {
   if (bluetooth::shim::is_any_gd_enabled()) {
     CHECK(bluetooth::shim::is_gd_stack_started_up());
@@ -657,9 +732,29 @@ bool btif_config_remove(const std::string& section, const std::string& key) {
         section + "-" + key, "");
   }
   std::unique_lock<std::recursive_mutex> lock(config_lock);
+  config_change_count++;
   return btif_config_cache.RemoveKey(section, key);
 }
 
+void btif_config_load_encrypted_keys(void) {
+  if (bluetooth::shim::is_any_gd_enabled() || !is_common_criteria_mode()) {
+    return;
+  }
+  std::vector<std::string> prefixes;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    for (const auto& section : btif_config_cache.GetPersistentSectionNames()) {
+      for (const auto& key : encrypt_key_name_list) {
+        auto value_str = btif_config_cache.GetString(section, key);
+        if (value_str && *value_str == ENCRYPTED_STR) {
+          prefixes.push_back(section + "-" + key);
+        }
+      }
+    }
+  }
+  get_bluetooth_keystore_interface()->load_keys(std::move(prefixes));
+}
+
 void btif_config_save(void) {
   if (bluetooth::shim::is_any_gd_enabled()) {
     CHECK(bluetooth::shim::is_gd_stack_started_up());
@@ -668,7 +763,16 @@ void btif_config_save(void) {
   }
   CHECK(config_timer != NULL);
 
-  alarm_set(config_timer, CONFIG_SETTLE_PERIOD_MS, timer_config_save_cb, NULL);
+  std::unique_lock<std::mutex> lock(config_timer_lock);
+  uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+  if (!alarm_is_scheduled(config_timer)) {
+    config_save_first_request_ms = now_ms;
+  }
+  uint64_t deadline_ms =
+      config_save_first_request_ms + CONFIG_MAX_SETTLE_PERIOD_MS;
+  uint64_t delay_ms = deadline_ms > now_ms ? deadline_ms - now_ms : 0;
+  alarm_set(config_timer, std::min(delay_ms, CONFIG_SETTLE_PERIOD_MS),
+            timer_config_save_cb, NULL);
 }
 
 void btif_config_flush(void) {
@@ -694,14 +798,17 @@ bool btif_config_clear(void) {
 
   alarm_cancel(config_timer);
 
-  std::unique_lock<std::recursive_mutex> lock(config_lock);
-
-  btif_config_cache.Clear();
-  bool ret =
-      config_save(btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
-  btif_config_source = RESET;
+  std::unique_lock<std::mutex> save_lock(config_save_lock);
+  config_t config;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    btif_config_cache.Clear();
+    config_change_count++;
+    config = btif_config_cache.PersistentSectionCopy();
+    btif_config_source = RESET;
+  }
 
-  return ret;
+  return config_save(config, CONFIG_FILE_PATH);
 }
 
 static void timer_config_save_cb(UNUSED_ATTR void* data) {
@@ -715,13 +822,24 @@ static void btif_config_write(UNUSED_ATTR uint16_t event,
                               UNUSED_ATTR char* p_param) {
   CHECK(config_timer != NULL);
 
-  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  std::unique_lock<std::mutex> save_lock(config_save_lock);
+  uint64_t start_ms = bluetooth::common::time_get_os_boottime_ms();
+  config_t config;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    config = btif_config_cache.PersistentSectionCopy();
+  }
   rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
-  config_save(btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  config_save(config, CONFIG_FILE_PATH);
   if (is_common_criteria_mode()) {
     get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
         CONFIG_FILE_PREFIX, CONFIG_FILE_HASH);
   }
+  uint64_t duration_ms =
+      bluetooth::common::time_get_os_boottime_ms() - start_ms;
+  config_save_count++;
+  config_save_total_ms += duration_ms;
+  config_save_max_ms = std::max(config_save_max_ms, duration_ms);
 }
 
 void btif_debug_config_dump(int fd) {
@@ -764,6 +882,14 @@ void btif_debug_config_dump(int fd) {
   dprintf(fd, "  Devices loaded: %zu\n", devices.size());
   dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
   dprintf(fd, "  File source: %s\n", file_source->c_str());
+
+  if (!bluetooth::shim::is_any_gd_enabled()) {
+    std::unique_lock<std::mutex> save_lock(config_save_lock);
+    dprintf(fd, "  Saves: %llu, total %llu ms, max %llu ms\n",
+            (unsigned long long)config_save_count,
+            (unsigned long long)config_save_total_ms,
+            (unsigned long long)config_save_max_ms);
+  }
 }
 
 static bool is_factory_reset(void) {
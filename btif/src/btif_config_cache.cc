@@ -140,8 +140,7 @@ bool BtifConfigCache::RemoveKey(const std::string& section_name,
       paired_devices_list_.sections.erase(section_iter);
     } else if (!has_link_key_in_section(*section_iter)) {
       // if no link key in section after removal, move it to unpaired section
-      auto moved_section = std::move(*section_iter);
-      paired_devices_list_.sections.erase(section_iter);
+      auto moved_section = paired_devices_list_.sections.extract(section_iter);
       unpaired_devices_cache_.Put(section_name, std::move(moved_section));
     }
     return true;
@@ -163,6 +162,17 @@ config_t BtifConfigCache::PersistentSectionCopy() {
   return paired_devices_list_;
 }
 
+void BtifConfigCache::ForEachPersistentEntry(
+    const std::function<void(const std::string& section_name,
+                             const std::string& key, const std::string& value)>&
+        visitor) {
+  for (const auto& section : paired_devices_list_.sections) {
+    for (const auto& entry : section.entries) {
+      visitor(section.name, entry.key, entry.value);
+    }
+  }
+}
+
 void BtifConfigCache::SetString(std::string section_name, std::string key,
                                 std::string value) {
   if (trim_new_line(section_name) || trim_new_line(key) ||
@@ -179,28 +189,32 @@ void BtifConfigCache::SetString(std::string section_name, std::string key,
   }
   if (!paired_devices_list_.Has(section_name)) {
     // section is not in paired_device_list, handle it in unpaired devices cache
-    section_t section = {};
-    bool in_unpaired_cache = true;
-    if (!unpaired_devices_cache_.Get(section_name, &section)) {
-      // it's a new unpaired section, add it to unpaired devices cache
-      section.name = section_name;
-      in_unpaired_cache = false;
-    }
-    // set key to value and replace existing key if already exist
-    section.Set(key, value);
+    section_t* cached_section = unpaired_devices_cache_.Find(section_name);
 
     if (is_local_section_info(section_name) ||
         (is_link_key(key) && RawAddress::IsValidAddress(section_name))) {
-      // remove this section that has the LinkKey from unpaired devices cache.
-      if (in_unpaired_cache) {
+      section_t section = {};
+      if (cached_section != nullptr) {
+        // remove this section that has the LinkKey from unpaired devices
+        // cache.
+        section = std::move(*cached_section);
         unpaired_devices_cache_.Remove(section_name);
+      } else {
+        section.name = section_name;
       }
+      section.Set(key, value);
       // when a unpaired section got the LinkKey, move this section to the
       // paired devices list
       paired_devices_list_.sections.emplace_back(std::move(section));
+    } else if (cached_section != nullptr) {
+      // update the section in place, Find() already made it the most recent
+      cached_section->Set(key, value);
     } else {
-      // update to the unpaired devices cache
-      unpaired_devices_cache_.Put(section_name, section);
+      // it's a new unpaired section, add it to unpaired devices cache
+      section_t section = {};
+      section.name = section_name;
+      section.Set(key, value);
+      unpaired_devices_cache_.Put(section_name, std::move(section));
     }
   } else {
     // already have section in paired device list, add key-value entry.
@@ -225,12 +239,12 @@ std::optional<std::string> BtifConfigCache::GetString(
     return entry_iter->value;
   }
   // Check unpaired sections later
-  section_t section = {};
-  if (!unpaired_devices_cache_.Get(section_name, &section)) {
+  section_t* section = unpaired_devices_cache_.Find(section_name);
+  if (section == nullptr) {
     return std::nullopt;
   }
-  auto entry_iter = section.Find(key);
-  if (entry_iter == section.entries.end()) {
+  auto entry_iter = section->Find(key);
+  if (entry_iter == section->entries.end()) {
     return std::nullopt;
   }
   return entry_iter->value;
@@ -49,7 +49,6 @@
 #include "btif/include/stack_manager.h"
 #include "common/message_loop_thread.h"
 #include "device/include/controller.h"
-#include "osi/include/future.h"
 #include "osi/include/log.h"
 #include "osi/include/properties.h"
 #include "stack/include/a2dp_api.h"
@@ -295,7 +294,7 @@ void btif_enable_bluetooth_evt() {
 
   btif_dm_init(uid_set);
 
-  /* init rfcomm & l2cap api */
+  /* enable sockets, which start on first use */
   btif_sock_init(uid_set);
 
   /* init pan */
@@ -308,7 +307,7 @@ void btif_enable_bluetooth_evt() {
   btif_dm_load_local_oob();
 #endif
 
-  future_ready(stack_manager_get_hack_future(), FUTURE_SUCCESS);
+  stack_manager_signal_stage_done();
   LOG_INFO("Bluetooth enable event completed");
 }
 
@@ -40,6 +40,8 @@
 #include <unistd.h>
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include <bluetooth/uuid.h>
 #include <hardware/bluetooth.h>
@@ -180,6 +182,20 @@ static skip_sdp_entry_t sdp_rejectlist[] = {{76}};  // Apple Mouse and Keyboard
 /* This flag will be true if HCI_Inquiry is in progress */
 static bool btif_dm_inquiry_in_progress = false;
 
+/* What was saved and reported of a device found by the current discovery */
+typedef struct {
+  std::string name;
+  uint32_t cod;
+  bt_device_type_t dev_type;
+  tBLE_ADDR_TYPE addr_type;
+  int8_t rssi;
+} btif_dm_discovered_device_t;
+
+/* Devices found by the current discovery, cleared when it completes, so that
+ * the results repeating one are not saved again */
+static std::unordered_map<RawAddress, btif_dm_discovered_device_t>
+    btif_dm_discovered_devices;
+
 /*******************************************************************************
  *  Static variables
  ******************************************************************************/
@@ -1114,11 +1130,23 @@ static void btif_dm_search_devices_evt(tBTA_DM_SEARCH_EVT event,
         properties[0].val = p_search_data->disc_res.bd_name;
         properties[0].len = strlen((char*)p_search_data->disc_res.bd_name);
         RawAddress& bdaddr = p_search_data->disc_res.bd_addr;
-
-        status =
-            btif_storage_set_remote_device_property(&bdaddr, &properties[0]);
-        ASSERTC(status == BT_STATUS_SUCCESS,
-                "failed to save remote device property", status);
+        std::string name((const char*)p_search_data->disc_res.bd_name,
+                         properties[0].len);
+
+        /* The name may be known from the inquiry result already */
+        auto found = btif_dm_discovered_devices.find(bdaddr);
+        if (found != btif_dm_discovered_devices.end() &&
+            found->second.name == name) {
+          status = BT_STATUS_SUCCESS;
+        } else {
+          status =
+              btif_storage_set_remote_device_property(&bdaddr, &properties[0]);
+          ASSERTC(status == BT_STATUS_SUCCESS,
+                  "failed to save remote device property", status);
+          if (found != btif_dm_discovered_devices.end()) {
+            found->second.name = name;
+          }
+        }
         invoke_remote_device_properties_cb(status, bdaddr, 1, properties);
       }
       /* TODO: Services? */
@@ -1187,8 +1215,16 @@ static void btif_dm_search_devices_evt(tBTA_DM_SEARCH_EVT event,
         /* FixMe: Assumption is that bluetooth.h and BTE enums match */
 
         /* Verify if the device is dual mode in NVRAM */
+        auto found = btif_dm_discovered_devices.find(bdaddr);
         int stored_device_type = 0;
-        if (btif_get_device_type(bdaddr, &stored_device_type) &&
+        bool has_stored_type;
+        if (found != btif_dm_discovered_devices.end()) {
+          stored_device_type = found->second.dev_type;
+          has_stored_type = true;
+        } else {
+          has_stored_type = btif_get_device_type(bdaddr, &stored_device_type);
+        }
+        if (has_stored_type &&
             ((stored_device_type != BT_DEVICE_TYPE_BREDR &&
               p_search_data->inq_res.device_type == BT_DEVICE_TYPE_BREDR) ||
              (stored_device_type != BT_DEVICE_TYPE_BLE &&
@@ -1210,15 +1246,29 @@ static void btif_dm_search_devices_evt(tBTA_DM_SEARCH_EVT event,
                                    &(p_search_data->inq_res.rssi));
         num_properties++;
 
-        status =
-            btif_storage_add_remote_device(&bdaddr, num_properties, properties);
-        ASSERTC(status == BT_STATUS_SUCCESS,
-                "failed to save remote device (inquiry)", status);
-        status = btif_storage_set_remote_addr_type(&bdaddr, addr_type);
-        ASSERTC(status == BT_STATUS_SUCCESS,
-                "failed to save remote addr type (inquiry)", status);
-        /* Callback to notify upper layer of device */
-        invoke_device_found_cb(num_properties, properties);
+        btif_dm_discovered_device_t device = {
+            (const char*)bdname.name, cod, dev_type, addr_type,
+            p_search_data->inq_res.rssi};
+        bool changed = found == btif_dm_discovered_devices.end() ||
+                       found->second.name != device.name ||
+                       found->second.cod != device.cod ||
+                       found->second.dev_type != device.dev_type ||
+                       found->second.addr_type != device.addr_type;
+        if (changed) {
+          status = btif_storage_add_remote_device(&bdaddr, num_properties,
+                                                  properties);
+          ASSERTC(status == BT_STATUS_SUCCESS,
+                  "failed to save remote device (inquiry)", status);
+          status = btif_storage_set_remote_addr_type(&bdaddr, addr_type);
+          ASSERTC(status == BT_STATUS_SUCCESS,
+                  "failed to save remote addr type (inquiry)", status);
+        }
+        /* Callback to notify upper layer of device, unless it is the same
+         * result again */
+        if (changed || found->second.rssi != device.rssi) {
+          invoke_device_found_cb(num_properties, properties);
+        }
+        btif_dm_discovered_devices[bdaddr] = device;
       }
     } break;
 
@@ -1230,6 +1280,7 @@ static void btif_dm_search_devices_evt(tBTA_DM_SEARCH_EVT event,
                                             btm_status_value(BTM_SUCCESS)));
     } break;
     case BTA_DM_DISC_CMPL_EVT: {
+      btif_dm_discovered_devices.clear();
       invoke_discovery_state_changed_cb(BT_DISCOVERY_STOPPED);
     } break;
     case BTA_DM_SEARCH_CANCEL_CMPL_EVT: {
@@ -1248,6 +1299,7 @@ static void btif_dm_search_devices_evt(tBTA_DM_SEARCH_EVT event,
         BTM_BleAdvFilterParamSetup(BTM_BLE_SCAN_COND_DELETE, 0, nullptr,
                                    base::Bind(&bte_scan_filt_param_cfg_evt,
                                               btm_status_value(BTM_SUCCESS)));
+        btif_dm_discovered_devices.clear();
         invoke_discovery_state_changed_cb(BT_DISCOVERY_STOPPED);
       }
     } break;
@@ -1483,7 +1535,7 @@ void BTIF_dm_disable() {
   }
   bluetooth::bqr::EnableBtQualityReport(false);
   LOG_INFO("Stack device manager shutdown finished");
-  future_ready(stack_manager_get_hack_future(), FUTURE_SUCCESS);
+  stack_manager_signal_stage_done();
 }
 
 /*******************************************************************************
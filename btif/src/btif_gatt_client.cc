@@ -33,7 +33,10 @@
 #include <hardware/bluetooth.h>
 #include <hardware/bt_gatt.h>
 
+#include <deque>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "bta_api.h"
 #include "bta_gatt_api.h"
@@ -69,6 +72,7 @@ extern const btgatt_callbacks_t* bt_gatt_callbacks;
   do {                                                                         \
     if (bt_gatt_callbacks && bt_gatt_callbacks->client->P_CBACK) {             \
       BTIF_TRACE_API("HAL bt_gatt_callbacks->client->%s", #P_CBACK);           \
+      btif_gattc_close_notification_batch();                                   \
       do_in_jni_thread(Bind(bt_gatt_callbacks->client->P_CBACK, __VA_ARGS__)); \
     } else {                                                                   \
       ASSERTC(0, "Callback is NULL", 0);                                       \
@@ -89,6 +93,130 @@ namespace {
 
 uint8_t rssi_request_client_if;
 
+/* Notifications and indications are handed to the JNI thread in batches,
+ * keeping only the received octets of each value, instead of one context
+ * switch with a copy of the whole BTA event each. A batch takes notifications
+ * until another client event is posted to the JNI thread, so that the order
+ * of the events is kept. */
+struct PendingNotification {
+  int conn_id;
+  RawAddress bda;
+  uint16_t handle;
+  uint16_t len;
+  bool is_notify;
+  uint16_t cid;
+  size_t offset;  // of the value in NotificationBatch::values
+};
+
+struct NotificationBatch {
+  std::vector<PendingNotification> notifications;
+  std::vector<uint8_t> values;
+  bool open = true;
+};
+
+constexpr size_t kMaxSpareNotificationBatches = 2;
+
+std::mutex notification_batches_mutex;
+std::deque<NotificationBatch> notification_batches;
+// Delivered batches, kept to reuse their storage.
+std::vector<NotificationBatch> spare_notification_batches;
+
+void btif_gattc_close_notification_batch() {
+  std::lock_guard<std::mutex> lock(notification_batches_mutex);
+  if (!notification_batches.empty()) notification_batches.back().open = false;
+}
+
+void btif_gattc_deliver_notifications() {
+  NotificationBatch batch;
+  {
+    std::lock_guard<std::mutex> lock(notification_batches_mutex);
+    batch = std::move(notification_batches.front());
+    notification_batches.pop_front();
+  }
+
+  if (bt_gatt_callbacks && bt_gatt_callbacks->client->notify_batch_cb) {
+    // Only used on the JNI thread.
+    static std::vector<btgatt_notification_t> notifications;
+    notifications.clear();
+    for (const PendingNotification& pending : batch.notifications) {
+      notifications.push_back({
+          .conn_id = pending.conn_id,
+          .bda = pending.bda,
+          .handle = pending.handle,
+          .len = pending.len,
+          .is_notify = pending.is_notify,
+          .value = batch.values.data() + pending.offset,
+      });
+    }
+    HAL_CBACK(bt_gatt_callbacks, client->notify_batch_cb, notifications.data(),
+              notifications.size());
+  } else {
+    for (const PendingNotification& pending : batch.notifications) {
+      btgatt_notify_params_t data;
+      data.bda = pending.bda;
+      memcpy(data.value, batch.values.data() + pending.offset, pending.len);
+      data.handle = pending.handle;
+      data.is_notify = pending.is_notify;
+      data.len = pending.len;
+
+      HAL_CBACK(bt_gatt_callbacks, client->notify_cb, pending.conn_id, data);
+    }
+  }
+
+  for (const PendingNotification& pending : batch.notifications) {
+    if (!pending.is_notify)
+      BTA_GATTC_SendIndConfirm(pending.conn_id, pending.cid);
+  }
+
+  batch.notifications.clear();
+  batch.values.clear();
+  batch.open = true;
+
+  std::lock_guard<std::mutex> lock(notification_batches_mutex);
+  if (spare_notification_batches.size() < kMaxSpareNotificationBatches) {
+    spare_notification_batches.push_back(std::move(batch));
+  }
+}
+
+void btif_gattc_queue_notification(const tBTA_GATTC_NOTIFY& notify) {
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(notification_batches_mutex);
+    if (notification_batches.empty() || !notification_batches.back().open) {
+      if (spare_notification_batches.empty()) {
+        notification_batches.emplace_back();
+      } else {
+        notification_batches.push_back(
+            std::move(spare_notification_batches.back()));
+        spare_notification_batches.pop_back();
+      }
+      post = true;
+    }
+
+    NotificationBatch& batch = notification_batches.back();
+    batch.notifications.push_back({
+        .conn_id = notify.conn_id,
+        .bda = notify.bda,
+        .handle = notify.handle,
+        .len = notify.len,
+        .is_notify = notify.is_notify,
+        .cid = notify.cid,
+        .offset = batch.values.size(),
+    });
+    batch.values.insert(batch.values.end(), notify.value,
+                        notify.value + notify.len);
+  }
+
+  if (!post) return;
+
+  if (do_in_jni_thread(FROM_HERE,
+                       base::Bind(&btif_gattc_deliver_notifications)) !=
+      BT_STATUS_SUCCESS) {
+    std::lock_guard<std::mutex> lock(notification_batches_mutex);
+    notification_batches.pop_back();
+  }
+}
+
 std::string bta_gattc_event_text(const tBTA_GATTC_EVT& event) {
   switch (event) {
     case BTA_GATTC_DEREG_EVT:
@@ -145,25 +273,6 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
       break;
     }
 
-    case BTA_GATTC_NOTIF_EVT: {
-      btgatt_notify_params_t data;
-
-      data.bda = p_data->notify.bda;
-      memcpy(data.value, p_data->notify.value, p_data->notify.len);
-
-      data.handle = p_data->notify.handle;
-      data.is_notify = p_data->notify.is_notify;
-      data.len = p_data->notify.len;
-
-      HAL_CBACK(bt_gatt_callbacks, client->notify_cb, p_data->notify.conn_id,
-                data);
-
-      if (!p_data->notify.is_notify)
-        BTA_GATTC_SendIndConfirm(p_data->notify.conn_id, p_data->notify.cid);
-
-      break;
-    }
-
     case BTA_GATTC_OPEN_EVT: {
       DVLOG(1) << "BTA_GATTC_OPEN_EVT " << p_data->open.remote_bda;
       HAL_CBACK(bt_gatt_callbacks, client->open_cb, p_data->open.conn_id,
@@ -188,6 +297,10 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
       break;
     }
 
+    case BTA_GATTC_NOTIF_EVT:
+      // Delivered in batches by btif_gattc_deliver_notifications().
+      break;
+
     case BTA_GATTC_ACL_EVT:
     case BTA_GATTC_DEREG_EVT:
     case BTA_GATTC_SEARCH_RES_EVT:
@@ -235,6 +348,12 @@ static void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
 static void bta_gattc_cback(tBTA_GATTC_EVT event, tBTA_GATTC* p_data) {
   LOG_DEBUG(" gatt client callback event:%s [%d]",
             gatt_client_event_text(event).c_str(), event);
+  if (event == BTA_GATTC_NOTIF_EVT) {
+    btif_gattc_queue_notification(p_data->notify);
+    return;
+  }
+
+  btif_gattc_close_notification_batch();
   bt_status_t status =
       btif_transfer_context(btif_gattc_upstreams_evt, (uint16_t)event,
                             (char*)p_data, sizeof(tBTA_GATTC), NULL);
@@ -500,6 +619,26 @@ static bt_status_t btif_gattc_write_char(int conn_id, uint16_t handle,
                                write_char_cb, nullptr));
 }
 
+void write_stream_cb(uint16_t conn_id, tGATT_STATUS status, uint16_t handle,
+                     uint32_t sent, uint32_t total, void* data) {
+  // Unlike the results of the other operations, progress is optional
+  if (!bt_gatt_callbacks ||
+      !bt_gatt_callbacks->client->write_stream_progress_cb)
+    return;
+  CLI_CBACK_IN_JNI(write_stream_progress_cb, conn_id, status, handle, sent,
+                   total);
+}
+
+static bt_status_t btif_gattc_write_char_stream(int conn_id, uint16_t handle,
+                                                int auth_req,
+                                                vector<uint8_t> value) {
+  CHECK_BTGATT_INIT();
+
+  return do_in_jni_thread(Bind(&BTA_GATTC_WriteCharStream, conn_id, handle,
+                               std::move(value), auth_req, write_stream_cb,
+                               nullptr));
+}
+
 void write_descr_cb(uint16_t conn_id, tGATT_STATUS status, uint16_t handle,
                     void* data) {
   CLI_CBACK_IN_JNI(write_descriptor_cb, conn_id, status, handle);
@@ -520,7 +659,9 @@ static bt_status_t btif_gattc_write_char_descr(int conn_id, uint16_t handle,
 static bt_status_t btif_gattc_execute_write(int conn_id, int execute) {
   CHECK_BTGATT_INIT();
   return do_in_jni_thread(
-      Bind(&BTA_GATTC_ExecuteWrite, conn_id, (uint8_t)execute));
+      Bind(base::IgnoreResult(
+               static_cast<void (*)(uint16_t, bool)>(&BTA_GATTC_ExecuteWrite)),
+           conn_id, (uint8_t)execute));
 }
 
 static void btif_gattc_reg_for_notification_impl(tGATT_IF client_if,
@@ -660,4 +801,5 @@ const btgatt_client_interface_t btgattClientInterface = {
     btif_gattc_set_preferred_phy,
     btif_gattc_read_phy,
     btif_gattc_test_command,
-    btif_gattc_get_gatt_db};
+    btif_gattc_get_gatt_db,
+    btif_gattc_write_char_stream};
@@ -439,10 +439,21 @@ static bt_status_t btif_gatts_read_phy(
   return BT_STATUS_SUCCESS;
 }
 
+static bt_status_t btif_gatts_set_attribute_cache(int attribute_handle,
+                                                 vector<uint8_t> value,
+                                                 uint64_t ttl_ms) {
+  CHECK_BTGATT_INIT();
+
+  if (value.size() > BTGATT_MAX_ATTR_LEN) return BT_STATUS_PARM_INVALID;
+
+  return do_in_jni_thread(Bind(&BTA_GATTS_SetAttributeCache, attribute_handle,
+                               std::move(value), ttl_ms));
+}
+
 const btgatt_server_interface_t btgattServerInterface = {
-    btif_gatts_register_app,   btif_gatts_unregister_app,
-    btif_gatts_open,           btif_gatts_close,
-    btif_gatts_add_service,    btif_gatts_stop_service,
-    btif_gatts_delete_service, btif_gatts_send_indication,
-    btif_gatts_send_response,  btif_gatts_set_preferred_phy,
-    btif_gatts_read_phy};
+    btif_gatts_register_app,       btif_gatts_unregister_app,
+    btif_gatts_open,               btif_gatts_close,
+    btif_gatts_add_service,        btif_gatts_stop_service,
+    btif_gatts_delete_service,     btif_gatts_send_indication,
+    btif_gatts_send_response,      btif_gatts_set_preferred_phy,
+    btif_gatts_read_phy,           btif_gatts_set_attribute_cache};
@@ -356,8 +356,8 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
           bt_hf_callbacks->ConnectionStateCallback(
               BTHF_CONNECTION_STATE_DISCONNECTED,
               &(btif_hf_cb[idx].connected_bda));
+          btif_queue_advance_by_address(btif_hf_cb[idx].connected_bda);
           reset_control_block(&btif_hf_cb[idx]);
-          btif_queue_advance();
         }
       }
       if (p_data->open.status == BTA_AG_SUCCESS) {
@@ -385,7 +385,7 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
         reset_control_block(&btif_hf_cb[idx]);
         bt_hf_callbacks->ConnectionStateCallback(btif_hf_cb[idx].state,
                                                  &connected_bda);
-        btif_queue_advance();
+        btif_queue_advance_by_address(connected_bda);
       }
       break;
     case BTA_AG_CLOSE_EVT: {
@@ -404,7 +404,7 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
                                                &connected_bda);
       if (failed_to_setup_slc) {
         LOG(ERROR) << __func__ << ": failed to setup SLC for " << connected_bda;
-        btif_queue_advance();
+        btif_queue_advance_by_address(connected_bda);
       }
       break;
     }
@@ -415,7 +415,7 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
       bt_hf_callbacks->ConnectionStateCallback(btif_hf_cb[idx].state,
                                                &btif_hf_cb[idx].connected_bda);
       if (btif_hf_cb[idx].is_initiator) {
-        btif_queue_advance();
+        btif_queue_advance_by_address(btif_hf_cb[idx].connected_bda);
       }
       break;
 
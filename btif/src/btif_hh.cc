@@ -27,6 +27,9 @@
 
 #define LOG_TAG "bt_btif_hh"
 
+#include <inttypes.h>
+#include <stdio.h>
+
 #include <cstdint>
 
 #include "btif/include/btif_common.h"
@@ -62,6 +65,10 @@ static int btif_hh_keylockstates = 0;  // The current key state of each key
 
 #define BTIF_TIMEOUT_VUP_MS (3 * 1000)
 
+/* Input latency histogram, log2 buckets of 128 us */
+#define BTIF_HH_LATENCY_UNIT_US 128
+#define BTIF_HH_LATENCY_BUCKETS 8
+
 /* HH request events */
 typedef enum {
   BTIF_HH_CONNECT_REQ_EVT = 0,
@@ -77,6 +84,13 @@ typedef enum {
  *  Local type definitions
  ******************************************************************************/
 
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t hist[BTIF_HH_LATENCY_BUCKETS];
+} btif_hh_latency_stats_t;
+
 typedef struct hid_kb_list {
   uint16_t product_id;
   uint16_t version_id;
@@ -90,6 +104,8 @@ btif_hh_cb_t btif_hh_cb;
 
 static bthh_callbacks_t* bt_hh_callbacks = NULL;
 
+static btif_hh_latency_stats_t btif_hh_input_latency;
+
 /* List of HID keyboards for which the NUMLOCK state needs to be
  * turned ON by default. Add devices to this list to apply the
  * NUMLOCK state toggle on fpr first connect.*/
@@ -285,6 +301,50 @@ static void sync_lockstate_on_connect(btif_hh_device_t* p_dev) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_hh_record_input_latency
+ *
+ * Description      Record the time from the HCI reception of an input report
+ *                  to its write to uhid. Main thread.
+ *
+ * Returns          void
+ ******************************************************************************/
+void btif_hh_record_input_latency(uint64_t latency_us) {
+  btif_hh_latency_stats_t* p_stats = &btif_hh_input_latency;
+  uint64_t units = latency_us / BTIF_HH_LATENCY_UNIT_US;
+  size_t bucket = 0;
+  while (units != 0 && bucket < BTIF_HH_LATENCY_BUCKETS - 1) {
+    units >>= 1;
+    bucket++;
+  }
+  p_stats->hist[bucket]++;
+  p_stats->count++;
+  p_stats->total_us += latency_us;
+  if (latency_us > p_stats->max_us) p_stats->max_us = latency_us;
+}
+
+void btif_debug_hh_dump(int fd) {
+  static const char* kBucketNames[BTIF_HH_LATENCY_BUCKETS] = {
+      "<128us", "128-255us", "256-511us", "512-1023us",
+      "1-2ms",  "2-4ms",     "4-8ms",     "8ms+"};
+  const btif_hh_latency_stats_t* p_stats = &btif_hh_input_latency;
+
+  dprintf(fd, "\nHID Host:\n");
+  dprintf(fd, "  Input reports written to uhid                 : %" PRIu64 "\n",
+          p_stats->count);
+  if (p_stats->count == 0) return;
+  dprintf(fd,
+          "  HCI to uhid latency (us, avg/max)             : %" PRIu64
+          " / %" PRIu64 "\n",
+          p_stats->total_us / p_stats->count, p_stats->max_us);
+  dprintf(fd, "  HCI to uhid latency histogram                 :");
+  for (size_t i = 0; i < BTIF_HH_LATENCY_BUCKETS; i++) {
+    dprintf(fd, " %s:%" PRIu64, kBucketNames[i], p_stats->hist[i]);
+  }
+  dprintf(fd, "\n");
+}
+
 /*******************************************************************************
  *
  * Function         btif_hh_find_connected_dev_by_handle
@@ -18,12 +18,14 @@
 
 #include <btif_common.h>
 #include <btif_keystore.h>
+#include "btif_config.h"
 #include "btif_storage.h"
 
 #include <base/bind.h>
 #include <base/location.h>
 #include <base/logging.h>
 #include <hardware/bluetooth.h>
+#include <algorithm>
 #include <map>
 
 using base::Bind;
@@ -44,9 +46,12 @@ class BluetoothKeystoreInterfaceImpl
   void init(BluetoothKeystoreCallbacks* callbacks) override {
     VLOG(2) << __func__;
     this->callbacks = callbacks;
-    // Get bonded devices number to get all bonded devices key.
-    do_in_jni_thread(
-        FROM_HERE, base::Bind([]() { btif_storage_get_num_bonded_devices(); }));
+    // Load all encrypted keys at once, then get bonded devices number to get
+    // all bonded devices key.
+    do_in_jni_thread(FROM_HERE, base::Bind([]() {
+                       btif_config_load_encrypted_keys();
+                       btif_storage_get_num_bonded_devices();
+                     }));
   }
 
   void set_encrypt_key_or_remove_key(std::string prefix,
@@ -89,6 +94,31 @@ class BluetoothKeystoreInterfaceImpl
     return decryptedString;
   }
 
+  void load_keys(std::vector<std::string> prefixes) override {
+    VLOG(2) << __func__ << " prefixes: " << prefixes.size();
+
+    if (!callbacks) {
+      LOG(WARNING) << __func__ << " callback isn't ready.";
+      return;
+    }
+
+    // Only ask for the keys which are not in the map yet.
+    prefixes.erase(std::remove_if(prefixes.begin(), prefixes.end(),
+                                  [this](const std::string& prefix) {
+                                    return key_map.count(prefix) != 0;
+                                  }),
+                   prefixes.end());
+    if (prefixes.empty()) return;
+
+    std::map<std::string, std::string> keys = callbacks->get_keys(prefixes);
+    for (auto& prefix : prefixes) {
+      // Save the value into a map, keys which are not found are empty.
+      key_map[prefix] = std::move(keys[prefix]);
+    }
+    VLOG(2) << __func__ << ": get " << prefixes.size()
+            << " keys from bluetoothkeystore.";
+  }
+
   void clear_map() override {
     VLOG(2) << __func__;
 
@@ -35,7 +35,7 @@
 #include <linux/if_tun.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "bt_target.h"  // Must be first to define build configuration
@@ -63,8 +63,6 @@
                        __func__, #s, __LINE__)                           \
   } while (0)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 btpan_cb_t btpan_cb;
 
 static bool jni_initialized;
@@ -399,17 +397,17 @@ int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
     eth_hdr.h_dest = dst;
     eth_hdr.h_src = src;
     eth_hdr.h_proto = htons(proto);
-    char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
-    memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
     if (len > TAP_MAX_PKT_WRITE_LEN) {
       LOG_ERROR("btpan_tap_send eth packet size:%d is exceeded limit!", len);
       return -1;
     }
-    memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-    /* Send data to network interface */
+    /* Send data to network interface. The tap driver takes one frame per
+     * write, gathered from the header and the payload left in the BNEP
+     * buffer. */
+    struct iovec iov[2] = {{&eth_hdr, sizeof(tETH_HDR)}, {(void*)buf, len}};
     ssize_t ret;
-    OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
+    OSI_NO_INTR(ret = writev(tap_fd, iov, 2));
     BTIF_TRACE_DEBUG("ret:%d", ret);
     return (int)ret;
   }
@@ -646,10 +644,7 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
 static void btu_exec_tap_fd_read(int fd) {
-  struct pollfd ufd;
-
   if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
 
   // Don't occupy BTU context too long, avoid buffer overruns and
@@ -658,42 +653,28 @@ static void btu_exec_tap_fd_read(int fd) {
   for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
     BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
     buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
 
     uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
 
-    // If we don't have an undelivered packet left over, pull one from the TAP
-    // driver.
-    // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
-    if (!btpan_cb.congest_packet_size) {
-      ssize_t ret;
-      OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
-                             sizeof(btpan_cb.congest_packet)));
-      switch (ret) {
-        case -1:
-          BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
-                           strerror(errno));
-          osi_free(buffer);
-          // add fd back to monitor thread to try it again later
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        case 0:
-          BTIF_TRACE_WARNING("%s end of file reached.", __func__);
-          osi_free(buffer);
-          // add fd back to monitor thread to process the exception
-          btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
-          return;
-        default:
-          btpan_cb.congest_packet_size = ret;
-          break;
-      }
+    // Pull the frame from the TAP driver straight behind the headroom BNEP and
+    // L2CAP build their headers in. The TAP fd is non-blocking, so the batch
+    // ends once the driver has no more frames queued.
+    ssize_t ret;
+    OSI_NO_INTR(ret = read(fd, packet,
+                           PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset));
+    if (ret <= 0) {
+      if (ret == 0)
+        BTIF_TRACE_WARNING("%s end of file reached.", __func__);
+      else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
+                         strerror(errno));
+      osi_free(buffer);
+      // add fd back to monitor thread to wait for more frames or to process
+      // the exception
+      btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
+      return;
     }
-
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
+    buffer->len = ret;
 
     if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
       // Extract the ethernet header from the buffer since the PAN_WriteBuf
@@ -706,23 +687,15 @@ static void btu_exec_tap_fd_read(int fd) {
       // Skip the ethernet header.
       buffer->len -= sizeof(tETH_HDR);
       buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
+
+      // BNEP drops the frame when its queue is full, as a full NIC queue
+      // would. Leave the remaining frames queued in the driver.
+      if (forward_bnep(&hdr, buffer) == FORWARD_CONGEST) break;
     } else {
       BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
                          buffer->len);
-      btpan_cb.congest_packet_size = 0;
       osi_free(buffer);
     }
-
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
-
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
   }
 
   if (btpan_cb.flow) {
@@ -38,6 +38,8 @@
 #include "bt_common.h"
 #include "btif_common.h"
 #include "main/shim/dumpsys.h"
+#include "stack/include/acl_api.h"
+#include "stack/include/sdpdefs.h"
 #include "stack_manager.h"
 
 /*******************************************************************************
@@ -59,6 +61,7 @@ class ConnectNode {
 
   const RawAddress& address() const { return address_; }
   uint16_t uuid() const { return uuid_; }
+  bool busy() const { return busy_; }
 
   /**
    * Initiate the connection.
@@ -88,6 +91,12 @@ static std::list<ConnectNode> connect_queue;
 
 static const size_t MAX_REASONABLE_REQUESTS = 20;
 
+// In fast reconnection mode, the requests of different devices run in
+// parallel, one per device: the controller still pages one device at a time,
+// but the profiles of the devices already connected come up meanwhile.
+static bool fast_reconnect = false;
+static const size_t MAX_PARALLEL_DEVICES = 3;
+
 /*******************************************************************************
  *  Queue helper functions
  ******************************************************************************/
@@ -115,14 +124,100 @@ static void queue_int_add(uint16_t uuid, const RawAddress& bda,
 static void queue_int_advance() {
   if (connect_queue.empty()) return;
 
-  const ConnectNode& head = connect_queue.front();
+  // Without an address, the oldest request running is the one that completed
+  auto head = connect_queue.begin();
+  if (fast_reconnect) {
+    while (head != connect_queue.end() && !head->busy()) head++;
+    if (head == connect_queue.end()) return;
+  }
   LOG_INFO("%s: removing connection request: %s", __func__,
-           head.ToString().c_str());
-  connect_queue.pop_front();
+           head->ToString().c_str());
+  connect_queue.erase(head);
 
   btif_queue_connect_next();
 }
 
+static void queue_int_advance_by_address(const RawAddress& bda) {
+  if (!fast_reconnect) {
+    queue_int_advance();
+    return;
+  }
+
+  for (auto it = connect_queue.begin(); it != connect_queue.end(); it++) {
+    if (it->busy() && it->address() == bda) {
+      LOG_INFO("%s: removing connection request: %s", __func__,
+               it->ToString().c_str());
+      connect_queue.erase(it);
+      break;
+    }
+  }
+
+  btif_queue_connect_next();
+}
+
+static bool has_busy_request(const RawAddress& bda) {
+  for (const auto& node : connect_queue) {
+    if (node.busy() && node.address() == bda) return true;
+  }
+  return false;
+}
+
+// The lower the sooner: the profiles users notice first go first
+static int profile_rank(uint16_t uuid) {
+  switch (uuid) {
+    case UUID_SERVCLASS_AG_HANDSFREE:
+    case UUID_SERVCLASS_HF_HANDSFREE:
+      return 0;
+    case UUID_SERVCLASS_AUDIO_SOURCE:
+    case UUID_SERVCLASS_AUDIO_SINK:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+// Picks the next request to run in fast reconnection mode. Devices with an
+// ACL up need no page, their requests go first. Otherwise requests keep the
+// order they were queued in, most recently used devices first, as the profile
+// services reconnect them.
+static std::list<ConnectNode>::iterator queue_int_next_parallel() {
+  auto best = connect_queue.end();
+  bool best_acl_up = false;
+  for (auto it = connect_queue.begin(); it != connect_queue.end(); it++) {
+    if (has_busy_request(it->address())) continue;
+    bool acl_up = BTM_IsAclConnectionUp(it->address(), BT_TRANSPORT_BR_EDR);
+    if (best == connect_queue.end() || (acl_up && !best_acl_up) ||
+        (acl_up == best_acl_up &&
+         profile_rank(it->uuid()) < profile_rank(best->uuid()))) {
+      best = it;
+      best_acl_up = acl_up;
+    }
+  }
+  return best;
+}
+
+static bt_status_t queue_int_connect_parallel() {
+  size_t busy_devices = 0;
+  for (const auto& node : connect_queue) {
+    if (node.busy()) busy_devices++;
+  }
+
+  while (busy_devices < MAX_PARALLEL_DEVICES) {
+    auto next = queue_int_next_parallel();
+    if (next == connect_queue.end()) break;
+
+    LOG_INFO("Executing profile connection request:%s",
+             next->ToString().c_str());
+    if (next->connect() == BT_STATUS_SUCCESS) {
+      busy_devices++;
+    } else {
+      LOG_INFO("%s: connect %s failed", __func__, next->ToString().c_str());
+      connect_queue.erase(next);
+    }
+  }
+  return busy_devices > 0 ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
+}
+
 static void queue_int_cleanup(uint16_t uuid) {
   LOG_INFO("%s: UUID=%04X", __func__, uuid);
 
@@ -137,7 +232,10 @@ static void queue_int_cleanup(uint16_t uuid) {
   }
 }
 
-static void queue_int_release() { connect_queue.clear(); }
+static void queue_int_release() {
+  connect_queue.clear();
+  fast_reconnect = false;
+}
 
 /*******************************************************************************
  *
@@ -182,6 +280,37 @@ void btif_queue_advance() {
   do_in_jni_thread(FROM_HERE, base::Bind(&queue_int_advance));
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_queue_advance_by_address
+ *
+ * Description      Remove the connection request running for a device and
+ *                  advance to the next scheduled connection.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_queue_advance_by_address(const RawAddress& bda) {
+  do_in_jni_thread(FROM_HERE, base::Bind(&queue_int_advance_by_address, bda));
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_queue_set_fast_reconnect
+ *
+ * Description      Run the connection requests of different devices in
+ *                  parallel, instead of one request at a time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_queue_set_fast_reconnect(bool enable) {
+  // The call must be on the JNI thread, like btif_queue_connect_next()
+  CHECK(is_on_jni_thread());
+  LOG_INFO("%s: %s", __func__, enable ? "true" : "false");
+  fast_reconnect = enable;
+}
+
 bt_status_t btif_queue_connect_next(void) {
   // The call must be on the JNI thread, otherwise the access to connect_queue
   // is not thread-safe.
@@ -191,6 +320,8 @@ bt_status_t btif_queue_connect_next(void) {
   if (!stack_manager_get_interface()->get_stack_is_running())
     return BT_STATUS_FAIL;
 
+  if (fast_reconnect) return queue_int_connect_parallel();
+
   ConnectNode& head = connect_queue.front();
 
   LOG_INFO("Executing profile connection request:%s", head.ToString().c_str());
@@ -87,8 +87,29 @@
 #define MAX_VOLUME 128
 #define MAX_LABEL 16
 #define MAX_TRANSACTIONS_PER_SESSION 16
+/* Labels a track change prefetch leaves free for notification re-registration
+ * and user initiated commands */
+#define BTIF_RC_PREFETCH_RESERVED_LABELS 4
+/* Size of the now playing page fetched on track change */
+#define BTIF_RC_PREFETCH_NOW_PLAYING_ITEMS 20
 #define PLAY_STATUS_PLAYING 1
+#ifndef BTIF_RC_NUM_CONN
 #define BTIF_RC_NUM_CONN BT_RC_NUM_APP
+#endif
+
+static_assert(BTIF_RC_NUM_CONN <= 32,
+              "connected devices are tracked in a 32 bit mask");
+static_assert(MAX_TRANSACTIONS_PER_SESSION <= 16,
+              "free transaction labels are tracked in a 16 bit mask");
+
+/* Slots in the peer address index; a power of two with at least half of the
+ * slots always free so that probe sequences stay short and terminate */
+constexpr size_t rc_addr_index_size(size_t num_conn) {
+  size_t size = 1;
+  while (size < 2 * num_conn) size <<= 1;
+  return size;
+}
+#define BTIF_RC_ADDR_INDEX_SIZE rc_addr_index_size(BTIF_RC_NUM_CONN)
 
 #define CHECK_RC_CONNECTED(p_dev)                                          \
   do {                                                                     \
@@ -179,6 +200,7 @@ typedef struct {
 typedef struct {
   std::recursive_mutex lbllock;
   rc_transaction_t transaction[MAX_TRANSACTIONS_PER_SESSION];
+  uint16_t free_lbl_mask; /* bit n set if label n is not in use */
 } rc_transaction_set_t;
 
 /* TODO : Merge btif_rc_reg_notifications_t and btif_rc_cmd_ctxt_t to a single
@@ -208,6 +230,12 @@ typedef struct {
 typedef struct {
   std::mutex lock;
   btif_rc_device_cb_t rc_multi_cb[BTIF_RC_NUM_CONN];
+  /* Lookup indices over the connected entries of rc_multi_cb, maintained by
+   * add_device_index() and remove_device_index() */
+  uint32_t connected_mask; /* bit n set if rc_multi_cb[n] is connected */
+  btif_rc_device_cb_t* by_handle[UINT8_MAX + 1];
+  /* Open addressed on rc_addr; holds rc_multi_cb index + 1, 0 if empty */
+  uint8_t by_addr[BTIF_RC_ADDR_INDEX_SIZE];
 } rc_cb_t;
 
 typedef struct {
@@ -389,18 +417,79 @@ extern bool check_cod(const RawAddress& remote_bdaddr, uint32_t cod);
  *  Functions
  *****************************************************************************/
 static btif_rc_device_cb_t* alloc_device() {
-  for (int idx = 0; idx < BTIF_RC_NUM_CONN; idx++) {
-    if (btif_rc_cb.rc_multi_cb[idx].rc_state ==
-        BTRC_CONNECTION_STATE_DISCONNECTED) {
-      return (&btif_rc_cb.rc_multi_cb[idx]);
+  uint64_t all_mask = (1ULL << BTIF_RC_NUM_CONN) - 1;
+  uint64_t free_mask = ~(uint64_t)btif_rc_cb.connected_mask & all_mask;
+  if (free_mask == 0) return NULL;
+  return &btif_rc_cb.rc_multi_cb[__builtin_ctzll(free_mask)];
+}
+
+static size_t addr_index_home(const RawAddress& bd_addr) {
+  return std::hash<RawAddress>{}(bd_addr) & (BTIF_RC_ADDR_INDEX_SIZE - 1);
+}
+
+static size_t addr_index_next(size_t slot) {
+  return (slot + 1) & (BTIF_RC_ADDR_INDEX_SIZE - 1);
+}
+
+/* Registers a device that just became connected in the lookup indices. The
+ * rc_addr and rc_handle of the device must not change until it is removed. */
+static void add_device_index(btif_rc_device_cb_t* p_dev) {
+  int idx = p_dev - btif_rc_cb.rc_multi_cb;
+  if (btif_rc_cb.connected_mask & (1u << idx)) return;
+
+  btif_rc_cb.connected_mask |= 1u << idx;
+  btif_rc_cb.by_handle[p_dev->rc_handle] = p_dev;
+  size_t slot = addr_index_home(p_dev->rc_addr);
+  while (btif_rc_cb.by_addr[slot] != 0) slot = addr_index_next(slot);
+  btif_rc_cb.by_addr[slot] = idx + 1;
+}
+
+static void remove_device_index(btif_rc_device_cb_t* p_dev) {
+  int idx = p_dev - btif_rc_cb.rc_multi_cb;
+  if (!(btif_rc_cb.connected_mask & (1u << idx))) return;
+
+  btif_rc_cb.connected_mask &= ~(1u << idx);
+  if (btif_rc_cb.by_handle[p_dev->rc_handle] == p_dev) {
+    btif_rc_cb.by_handle[p_dev->rc_handle] = nullptr;
+  }
+
+  size_t slot = addr_index_home(p_dev->rc_addr);
+  while (btif_rc_cb.by_addr[slot] != idx + 1) {
+    if (btif_rc_cb.by_addr[slot] == 0) return;
+    slot = addr_index_next(slot);
+  }
+
+  /* Shift later entries of the probe sequence back so that no lookup stops
+   * early at the hole left behind */
+  btif_rc_cb.by_addr[slot] = 0;
+  for (size_t next = addr_index_next(slot); btif_rc_cb.by_addr[next] != 0;
+       next = addr_index_next(next)) {
+    const btif_rc_device_cb_t& entry =
+        btif_rc_cb.rc_multi_cb[btif_rc_cb.by_addr[next] - 1];
+    size_t home = addr_index_home(entry.rc_addr);
+    size_t mask = BTIF_RC_ADDR_INDEX_SIZE - 1;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      btif_rc_cb.by_addr[slot] = btif_rc_cb.by_addr[next];
+      btif_rc_cb.by_addr[next] = 0;
+      slot = next;
     }
   }
+}
+
+static btif_rc_device_cb_t* find_device_by_bda(const RawAddress& bd_addr) {
+  for (size_t slot = addr_index_home(bd_addr); btif_rc_cb.by_addr[slot] != 0;
+       slot = addr_index_next(slot)) {
+    btif_rc_device_cb_t* p_dev =
+        &btif_rc_cb.rc_multi_cb[btif_rc_cb.by_addr[slot] - 1];
+    if (p_dev->rc_addr == bd_addr) return p_dev;
+  }
   return NULL;
 }
 
 void initialize_device(btif_rc_device_cb_t* p_dev) {
   if (p_dev == nullptr) return;
 
+  remove_device_index(p_dev);
   p_dev->rc_connected = false;
   p_dev->br_connected = false;
   p_dev->rc_handle = 0;
@@ -451,28 +540,16 @@ static btif_rc_device_cb_t* get_connected_device(int index) {
 btif_rc_device_cb_t* btif_rc_get_device_by_bda(const RawAddress& bd_addr) {
   VLOG(1) << __func__ << ": bd_addr: " << bd_addr;
 
-  for (int idx = 0; idx < BTIF_RC_NUM_CONN; idx++) {
-    if ((btif_rc_cb.rc_multi_cb[idx].rc_state !=
-         BTRC_CONNECTION_STATE_DISCONNECTED) &&
-        btif_rc_cb.rc_multi_cb[idx].rc_addr == bd_addr) {
-      return (&btif_rc_cb.rc_multi_cb[idx]);
-    }
-  }
+  btif_rc_device_cb_t* p_dev = find_device_by_bda(bd_addr);
+  if (p_dev != NULL) return p_dev;
   BTIF_TRACE_ERROR("%s: device not found, returning NULL!", __func__);
   return NULL;
 }
 
 btif_rc_device_cb_t* btif_rc_get_device_by_handle(uint8_t handle) {
   BTIF_TRACE_DEBUG("%s: handle: 0x%x", __func__, handle);
-  for (int idx = 0; idx < BTIF_RC_NUM_CONN; idx++) {
-    if ((btif_rc_cb.rc_multi_cb[idx].rc_state !=
-         BTRC_CONNECTION_STATE_DISCONNECTED) &&
-        (btif_rc_cb.rc_multi_cb[idx].rc_handle == handle)) {
-      BTIF_TRACE_DEBUG("%s: btif_rc_cb.rc_multi_cb[idx].rc_handle: 0x%x",
-                       __func__, btif_rc_cb.rc_multi_cb[idx].rc_handle);
-      return (&btif_rc_cb.rc_multi_cb[idx]);
-    }
-  }
+  btif_rc_device_cb_t* p_dev = btif_rc_cb.by_handle[handle];
+  if (p_dev != NULL) return p_dev;
   BTIF_TRACE_ERROR("%s: returning NULL", __func__);
   return NULL;
 }
@@ -719,6 +796,7 @@ void handle_rc_connect(tBTA_AV_RC_OPEN* p_rc_open) {
   p_dev->rc_connected = true;
   p_dev->rc_handle = p_rc_open->rc_handle;
   p_dev->rc_state = BTRC_CONNECTION_STATE_CONNECTED;
+  add_device_index(p_dev);
   /* on locally initiated connection we will get remote features as part of
    * connect */
   if (p_dev->rc_features != 0 && bt_rc_callbacks != NULL) {
@@ -1166,14 +1244,8 @@ void btif_rc_handler(tBTA_AV_EVT event, tBTA_AV* p_data) {
 }
 
 bool btif_rc_is_connected_peer(const RawAddress& peer_addr) {
-  for (int idx = 0; idx < BTIF_RC_NUM_CONN; idx++) {
-    btif_rc_device_cb_t* p_dev = get_connected_device(idx);
-    if (p_dev != NULL && (p_dev->rc_connected == TRUE) &&
-        peer_addr == p_dev->rc_addr) {
-      return true;
-    }
-  }
-  return false;
+  btif_rc_device_cb_t* p_dev = find_device_by_bda(peer_addr);
+  return p_dev != NULL && p_dev->rc_connected;
 }
 
 /***************************************************************************
@@ -1962,66 +2034,71 @@ static bt_status_t register_notification_rsp(
   avrc_rsp.reg_notif.opcode = opcode_from_pdu(AVRC_PDU_REGISTER_NOTIFICATION);
   avrc_rsp.get_play_status.status = AVRC_STS_NO_ERROR;
 
-  for (int idx = 0; idx < BTIF_RC_NUM_CONN; idx++) {
-    memset(&(avrc_rsp.reg_notif.param), 0, sizeof(tAVRC_NOTIF_RSP_PARAM));
+  /* The response is the same for every peer, only the label differs */
+  memset(&(avrc_rsp.reg_notif.param), 0, sizeof(tAVRC_NOTIF_RSP_PARAM));
+  switch (event_id) {
+    case BTRC_EVT_PLAY_STATUS_CHANGED:
+      avrc_rsp.reg_notif.param.play_status = p_param->play_status;
+      break;
+    case BTRC_EVT_TRACK_CHANGE:
+      memcpy(&(avrc_rsp.reg_notif.param.track), &(p_param->track),
+             sizeof(btrc_uid_t));
+      break;
+    case BTRC_EVT_PLAY_POS_CHANGED:
+      avrc_rsp.reg_notif.param.play_pos = p_param->song_pos;
+      break;
+    case BTRC_EVT_AVAL_PLAYER_CHANGE:
+      break;
+    case BTRC_EVT_ADDR_PLAYER_CHANGE:
+      avrc_rsp.reg_notif.param.addr_player.player_id =
+          p_param->addr_player_changed.player_id;
+      avrc_rsp.reg_notif.param.addr_player.uid_counter =
+          p_param->addr_player_changed.uid_counter;
+      break;
+    case BTRC_EVT_UIDS_CHANGED:
+      avrc_rsp.reg_notif.param.uid_counter = p_param->uids_changed.uid_counter;
+      break;
+    case BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED:
+      break;
+
+    default:
+      BTIF_TRACE_WARNING("%s: Unhandled event ID: 0x%x", __func__, event_id);
+      return BT_STATUS_UNHANDLED;
+  }
+
+  uint8_t ctype = (type == BTRC_NOTIFICATION_TYPE_INTERIM) ? AVRC_CMD_NOTIF
+                                                           : AVRC_RSP_CHANGED;
+  bool notified = false;
+  for (uint32_t mask = btif_rc_cb.connected_mask; mask != 0;
+       mask &= mask - 1) {
+    btif_rc_device_cb_t* p_dev = &btif_rc_cb.rc_multi_cb[__builtin_ctz(mask)];
 
-    if (!(btif_rc_cb.rc_multi_cb[idx].rc_connected)) {
+    if (!p_dev->rc_connected) {
       BTIF_TRACE_ERROR("%s: Avrcp device is not connected, handle: 0x%x",
-                       __func__, btif_rc_cb.rc_multi_cb[idx].rc_handle);
+                       __func__, p_dev->rc_handle);
       continue;
     }
 
-    if (!btif_rc_cb.rc_multi_cb[idx].rc_notif[event_id - 1].bNotify) {
+    if (!p_dev->rc_notif[event_id - 1].bNotify) {
       BTIF_TRACE_WARNING(
           "%s: Avrcp Event id is not registered: event_id: %x, handle: 0x%x",
-          __func__, event_id, btif_rc_cb.rc_multi_cb[idx].rc_handle);
+          __func__, event_id, p_dev->rc_handle);
       continue;
     }
 
     BTIF_TRACE_DEBUG(
         "%s: Avrcp Event id is registered: event_id: %x handle: 0x%x", __func__,
-        event_id, btif_rc_cb.rc_multi_cb[idx].rc_handle);
+        event_id, p_dev->rc_handle);
 
-    switch (event_id) {
-      case BTRC_EVT_PLAY_STATUS_CHANGED:
-        avrc_rsp.reg_notif.param.play_status = p_param->play_status;
-        if (avrc_rsp.reg_notif.param.play_status == PLAY_STATUS_PLAYING)
-          btif_av_clear_remote_suspend_flag();
-        break;
-      case BTRC_EVT_TRACK_CHANGE:
-        memcpy(&(avrc_rsp.reg_notif.param.track), &(p_param->track),
-               sizeof(btrc_uid_t));
-        break;
-      case BTRC_EVT_PLAY_POS_CHANGED:
-        avrc_rsp.reg_notif.param.play_pos = p_param->song_pos;
-        break;
-      case BTRC_EVT_AVAL_PLAYER_CHANGE:
-        break;
-      case BTRC_EVT_ADDR_PLAYER_CHANGE:
-        avrc_rsp.reg_notif.param.addr_player.player_id =
-            p_param->addr_player_changed.player_id;
-        avrc_rsp.reg_notif.param.addr_player.uid_counter =
-            p_param->addr_player_changed.uid_counter;
-        break;
-      case BTRC_EVT_UIDS_CHANGED:
-        avrc_rsp.reg_notif.param.uid_counter =
-            p_param->uids_changed.uid_counter;
-        break;
-      case BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED:
-        break;
-
-      default:
-        BTIF_TRACE_WARNING("%s: Unhandled event ID: 0x%x", __func__, event_id);
-        return BT_STATUS_UNHANDLED;
+    if (!notified && event_id == BTRC_EVT_PLAY_STATUS_CHANGED &&
+        avrc_rsp.reg_notif.param.play_status == PLAY_STATUS_PLAYING) {
+      btif_av_clear_remote_suspend_flag();
     }
+    notified = true;
 
     /* Send the response. */
-    send_metamsg_rsp(
-        &btif_rc_cb.rc_multi_cb[idx], -1,
-        btif_rc_cb.rc_multi_cb[idx].rc_notif[event_id - 1].label,
-        ((type == BTRC_NOTIFICATION_TYPE_INTERIM) ? AVRC_CMD_NOTIF
-                                                  : AVRC_RSP_CHANGED),
-        &avrc_rsp);
+    send_metamsg_rsp(p_dev, -1, p_dev->rc_notif[event_id - 1].label, ctype,
+                     &avrc_rsp);
   }
   return BT_STATUS_SUCCESS;
 }
@@ -3213,6 +3290,45 @@ bool rc_is_track_id_valid(tAVRC_UID uid) {
   }
 }
 
+static int free_transaction_count(btif_rc_device_cb_t* p_dev) {
+  rc_transaction_set_t* transaction_set = &(p_dev->transaction_set);
+  std::unique_lock<std::recursive_mutex> lock(transaction_set->lbllock);
+  return __builtin_popcount(transaction_set->free_lbl_mask);
+}
+
+/***************************************************************************
+ *
+ * Function         prefetch_track_info
+ *
+ * Description      Issues the requests a controller UI needs after a track
+ *                  change back to back instead of one per response: the
+ *                  element attributes, the play status and, when enabled and
+ *                  the browsing channel is up, the first now playing page.
+ *                  The optional requests are skipped when they would leave
+ *                  fewer than BTIF_RC_PREFETCH_RESERVED_LABELS labels free.
+ *
+ * Returns          None
+ *
+ **************************************************************************/
+static void prefetch_track_info(btif_rc_device_cb_t* p_dev) {
+  get_metadata_attribute_cmd(get_requested_attributes_list_size(p_dev),
+                             get_requested_attributes_list(p_dev), p_dev);
+  get_play_status_cmd(p_dev);
+
+  if (!p_dev->br_connected ||
+      !osi_property_get_bool(
+          "persist.bluetooth.avrcpcontroller.prefetch_now_playing", false)) {
+    return;
+  }
+  if (free_transaction_count(p_dev) <= BTIF_RC_PREFETCH_RESERVED_LABELS) {
+    BTIF_TRACE_DEBUG("%s: skipping now playing prefetch, labels exhausted",
+                     __func__);
+    return;
+  }
+  get_folder_items_cmd(p_dev->rc_addr, AVRC_SCOPE_NOW_PLAYING, 0,
+                       BTIF_RC_PREFETCH_NOW_PLAYING_ITEMS - 1);
+}
+
 /***************************************************************************
  *
  * Function         handle_notification_response
@@ -3242,9 +3358,6 @@ static void handle_notification_response(tBTA_AV_META_MSG* pmeta_msg,
     return;
   }
 
-  const uint32_t* attr_list = get_requested_attributes_list(p_dev);
-  const uint8_t attr_list_size = get_requested_attributes_list_size(p_dev);
-
   if (pmeta_msg->code == AVRC_RSP_INTERIM) {
     btif_rc_supported_event_t* p_event;
     list_node_t* node;
@@ -3266,9 +3379,7 @@ static void handle_notification_response(tBTA_AV_META_MSG* pmeta_msg,
         } else {
           uint8_t* p_data = p_rsp->param.track;
           BE_STREAM_TO_UINT64(p_dev->rc_playing_uid, p_data);
-          get_play_status_cmd(p_dev);
-          get_metadata_attribute_cmd(attr_list_size, attr_list,
-                                    p_dev);
+          prefetch_track_info(p_dev);
         }
         break;
 
@@ -3380,7 +3491,7 @@ static void handle_notification_response(tBTA_AV_META_MSG* pmeta_msg,
         if (rc_is_track_id_valid(p_rsp->param.track) != true) {
           break;
         }
-        get_metadata_attribute_cmd(attr_list_size, attr_list, p_dev);
+        prefetch_track_info(p_dev);
         break;
 
       case AVRC_EVT_APP_SETTING_CHANGE: {
@@ -5394,6 +5505,7 @@ static void initialize_transaction(btif_rc_device_cb_t* p_dev, int lbl) {
     transaction_set->transaction[lbl].lbl = lbl;
     transaction_set->transaction[lbl].in_use = false;
     transaction_set->transaction[lbl].handle = 0;
+    transaction_set->free_lbl_mask |= 1 << lbl;
   }
 }
 
@@ -5454,15 +5566,15 @@ static bt_status_t get_transaction(btif_rc_device_cb_t* p_dev,
   rc_transaction_set_t* transaction_set = &(p_dev->transaction_set);
   std::unique_lock<std::recursive_mutex> lock(transaction_set->lbllock);
 
-  // Check for unused transactions in the device's transaction set
-  for (uint8_t i = 0; i < MAX_TRANSACTIONS_PER_SESSION; i++) {
-    if (!transaction_set->transaction[i].in_use) {
-      BTIF_TRACE_DEBUG("%s: p_dev=%s, label=%d, got free transaction!",
-                       __func__, p_dev->rc_addr.ToString().c_str(), i);
-      transaction_set->transaction[i].in_use = true;
-      *ptransaction = &(transaction_set->transaction[i]);
-      return BT_STATUS_SUCCESS;
-    }
+  // Take the lowest free label of the device's transaction set
+  if (transaction_set->free_lbl_mask != 0) {
+    int i = __builtin_ctz(transaction_set->free_lbl_mask);
+    BTIF_TRACE_DEBUG("%s: p_dev=%s, label=%d, got free transaction!", __func__,
+                     p_dev->rc_addr.ToString().c_str(), i);
+    transaction_set->free_lbl_mask &= ~(1 << i);
+    transaction_set->transaction[i].in_use = true;
+    *ptransaction = &(transaction_set->transaction[i]);
+    return BT_STATUS_SUCCESS;
   }
   BTIF_TRACE_ERROR("%s: p_dev=%s, failed to find free transaction", __func__,
                    p_dev->rc_addr.ToString().c_str());
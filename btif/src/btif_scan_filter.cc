@@ -0,0 +1,110 @@
+/*
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif_scan_filter.h"
+
+#include <stdlib.h>
+
+BtifScanFilter::BtifScanFilter(size_t capacity, uint64_t window_ms,
+                               int rssi_threshold)
+    : last_reports_(capacity, "bt_btif_scan_filter"),
+      window_ms_(window_ms),
+      rssi_threshold_(rssi_threshold) {}
+
+bool BtifScanFilter::ShouldReport(const RawAddress& bd_addr, uint16_t evt_type,
+                                  int8_t rssi,
+                                  const std::vector<uint8_t>& data,
+                                  uint64_t now_ms) {
+  if (window_ms_ == 0) {
+    reported_count_++;
+    return true;
+  }
+
+  LastReport* last = last_reports_.Find(bd_addr);
+  if (last != nullptr && last->evt_type == evt_type &&
+      now_ms - last->time_ms < window_ms_ &&
+      abs(rssi - last->rssi) < rssi_threshold_ && last->data == data) {
+    suppressed_count_++;
+    return false;
+  }
+
+  if (last != nullptr) {
+    // Reuse the buffer of the advertiser
+    last->evt_type = evt_type;
+    last->rssi = rssi;
+    last->time_ms = now_ms;
+    last->data.assign(data.begin(), data.end());
+  } else {
+    last_reports_.Put(bd_addr, LastReport{evt_type, rssi, now_ms, data});
+  }
+  reported_count_++;
+  return true;
+}
+
+void BtifScanFilter::Clear() { last_reports_.Clear(); }
+
+void BtifScannerFilters::AddScanner(int scanner_id) {
+  scanners_[scanner_id] = nullptr;
+}
+
+void BtifScannerFilters::RemoveScanner(int scanner_id) {
+  scanners_.erase(scanner_id);
+}
+
+void BtifScannerFilters::SetFilter(int scanner_id, uint64_t window_ms,
+                                   int rssi_threshold) {
+  auto it = scanners_.find(scanner_id);
+  if (it == scanners_.end()) return;
+
+  if (window_ms == 0) {
+    it->second.reset();
+  } else {
+    it->second = std::make_unique<BtifScanFilter>(capacity_, window_ms,
+                                                  rssi_threshold);
+  }
+}
+
+bool BtifScannerFilters::ShouldReport(const RawAddress& bd_addr,
+                                      uint16_t evt_type, int8_t rssi,
+                                      const std::vector<uint8_t>& data,
+                                      uint64_t now_ms) {
+  bool report = scanners_.empty();
+  for (auto& scanner : scanners_) {
+    if (scanner.second == nullptr) {
+      report = true;
+      continue;
+    }
+    // Every filter sees the result, to keep its last report up to date
+    if (scanner.second->ShouldReport(bd_addr, evt_type, rssi, data, now_ms)) {
+      report = true;
+    }
+  }
+
+  if (report) {
+    reported_count_++;
+  } else {
+    suppressed_count_++;
+  }
+  return report;
+}
+
+void BtifScannerFilters::Clear() {
+  for (auto& scanner : scanners_) {
+    if (scanner.second != nullptr) scanner.second->Clear();
+  }
+  reported_count_ = 0;
+  suppressed_count_ = 0;
+}
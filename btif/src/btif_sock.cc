@@ -19,6 +19,7 @@
 #define LOG_TAG "bt_btif_sock"
 
 #include <atomic>
+#include <mutex>
 
 #include <base/logging.h>
 
@@ -38,7 +39,9 @@
 #include "btif_uid.h"
 #include "btif_util.h"
 #include "device/include/controller.h"
+#include "device/include/esco_parameters.h"
 #include "osi/include/thread.h"
+#include "stack/include/btm_api.h"
 
 using bluetooth::Uuid;
 
@@ -56,6 +59,12 @@ static void btsock_signaled(int fd, int type, int flags, uint32_t user_id);
 static std::atomic_int thread_handle{-1};
 static thread_t* thread;
 
+// Guards the start of the socket threads and slots, which is deferred from
+// enable to the first listen or connect
+static std::mutex start_mutex;
+static bool sockets_enabled = false;
+static uid_set_t* sock_uid_set = NULL;
+
 const btsock_interface_t* btif_sock_get_interface(void) {
   static btsock_interface_t interface = {
       sizeof(interface), btsock_listen, /* listen */
@@ -67,9 +76,31 @@ const btsock_interface_t* btif_sock_get_interface(void) {
 }
 
 bt_status_t btif_sock_init(uid_set_t* uid_set) {
+  std::unique_lock<std::mutex> lock(start_mutex);
   CHECK(thread_handle == -1);
   CHECK(thread == NULL);
 
+  sock_uid_set = uid_set;
+  sockets_enabled = true;
+
+  // Set at enable rather than on first use, which would override the mode
+  // set by the profiles in the meantime
+  enh_esco_params_t params = esco_parameters_for_codec(SCO_CODEC_CVSD_D1);
+  BTM_SetEScoMode(&params);
+
+  return BT_STATUS_SUCCESS;
+}
+
+// Starts the socket threads and slots, unless they are already running
+static bt_status_t btif_sock_start(void) {
+  std::unique_lock<std::mutex> lock(start_mutex);
+  if (thread_handle != -1) return BT_STATUS_SUCCESS;
+  if (!sockets_enabled) {
+    LOG_WARN("%s sockets are not enabled", __func__);
+    return BT_STATUS_NOT_READY;
+  }
+  LOG_INFO("%s starting sockets on first use", __func__);
+
   bt_status_t status;
   btsock_thread_init();
   thread_handle = btsock_thread_create(btsock_signaled, NULL);
@@ -78,13 +109,13 @@ bt_status_t btif_sock_init(uid_set_t* uid_set) {
     goto error;
   }
 
-  status = btsock_rfc_init(thread_handle, uid_set);
+  status = btsock_rfc_init(thread_handle, sock_uid_set);
   if (status != BT_STATUS_SUCCESS) {
     LOG_ERROR("%s error initializing RFCOMM sockets: %d", __func__, status);
     goto error;
   }
 
-  status = btsock_l2cap_init(thread_handle, uid_set);
+  status = btsock_l2cap_init(thread_handle, sock_uid_set);
   if (status != BT_STATUS_SUCCESS) {
     LOG_ERROR("%s error initializing L2CAP sockets: %d", __func__, status);
     goto error;
@@ -111,11 +142,14 @@ error:;
   thread = NULL;
   if (thread_handle != -1) btsock_thread_exit(thread_handle);
   thread_handle = -1;
-  uid_set = NULL;
   return BT_STATUS_FAIL;
 }
 
 void btif_sock_cleanup(void) {
+  std::unique_lock<std::mutex> lock(start_mutex);
+  sockets_enabled = false;
+  sock_uid_set = NULL;
+
   int saved_handle = thread_handle;
   if (std::atomic_exchange(&thread_handle, -1) == -1) return;
 
@@ -135,6 +169,7 @@ static bt_status_t btsock_listen(btsock_type_t type, const char* service_name,
   }
 
   *sock_fd = INVALID_FD;
+  if (btif_sock_start() != BT_STATUS_SUCCESS) return BT_STATUS_NOT_READY;
   bt_status_t status = BT_STATUS_FAIL;
   int original_channel = channel;
 
@@ -195,6 +230,7 @@ static bt_status_t btsock_connect(const RawAddress* bd_addr, btsock_type_t type,
   CHECK(sock_fd != NULL);
 
   *sock_fd = INVALID_FD;
+  if (btif_sock_start() != BT_STATUS_SUCCESS) return BT_STATUS_NOT_READY;
   bt_status_t status = BT_STATUS_FAIL;
 
   log_socket_connection_state(*bd_addr, 0, type,
@@ -18,8 +18,11 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
+#include <vector>
 
 #include "bta/include/bta_jv_api.h"
 #include "btif/include/btif_metrics_logging.h"
@@ -34,11 +37,13 @@
 #include "stack/include/bt_types.h"
 #include "types/raw_address.h"
 
-struct packet {
-  struct packet *next, *prev;
-  uint32_t len;
-  uint8_t* data;
-};
+/* Size the receive ring of a socket starts with, it doubles up to
+ * L2CAP_MAX_RX_BUFFER bytes */
+#define SDU_RING_MIN_SIZE 0x10000
+/* Length of an SDU record that sends the reader back to the ring start */
+#define SDU_RING_WRAP UINT32_MAX
+/* Most SDUs read from the app socket and handed to BTA in one write */
+#define L2CAP_MAX_WRITE_BATCH 8
 
 typedef struct l2cap_socket {
   struct l2cap_socket* prev;  // link to prev list item
@@ -53,9 +58,15 @@ typedef struct l2cap_socket {
   int our_fd;                 // fd from our side
   int app_fd;                 // fd from app's side
 
-  unsigned bytes_buffered;
-  struct packet* first_packet;  // fist packet to be delivered to app
-  struct packet* last_packet;   // last packet to be delivered to app
+  // SDUs to be delivered to app. Each one is kept contiguous behind its
+  // uint32_t length, so it is read from L2CAP and sent to app with one copy.
+  std::mutex rx_lock;     // guards the ring, taken after state_lock
+  uint8_t* rx_ring;       // allocated on the first SDU
+  uint32_t rx_ring_size;  // bytes allocated
+  uint32_t rx_head;       // offset of the first SDU
+  uint32_t rx_tail;       // offset past the last SDU
+  uint32_t rx_used;       // bytes used, including lengths and wrapped space
+  uint32_t rx_head_sent;  // bytes of the first SDU already sent to app
 
   unsigned server : 1;            // is a server? (or connecting?)
   unsigned connected : 1;         // is connected?
@@ -96,86 +107,114 @@ static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV* p_data,
  * wait
  *       confirming the l2cap_ind until we have more space in the buffer. */
 
-/* returns false if none - caller must free "data" memory when done with it */
-static char packet_get_head_l(l2cap_socket* sock, uint8_t** data,
-                              uint32_t* len) {
-  struct packet* p = sock->first_packet;
-
-  if (!p) return false;
-
-  if (data) *data = sock->first_packet->data;
-  if (len) *len = sock->first_packet->len;
-  sock->first_packet = p->next;
-  if (sock->first_packet)
-    sock->first_packet->prev = NULL;
-  else
-    sock->last_packet = NULL;
+static uint32_t sdu_record_size(uint32_t len) {
+  return sizeof(uint32_t) + ((len + 3) & ~3u);
+}
 
-  if (len) sock->bytes_buffered -= *len;
+static uint32_t sdu_ring_read_len_l(const l2cap_socket* sock, uint32_t off) {
+  uint32_t len;
+  memcpy(&len, sock->rx_ring + off, sizeof(len));
+  return len;
+}
 
-  osi_free(p);
+/* Make room for a record of |rec| bytes by moving the queued SDUs to the
+ * start of a larger ring. Returns false if the ring can't grow enough. */
+static bool sdu_ring_grow_l(l2cap_socket* sock, uint32_t rec) {
+  uint64_t size = std::max<uint32_t>(sock->rx_ring_size, SDU_RING_MIN_SIZE);
+  while (size < (uint64_t)sock->rx_used + rec) size *= 2;
+  if (size > L2CAP_MAX_RX_BUFFER) size = L2CAP_MAX_RX_BUFFER;
+  if (size <= sock->rx_ring_size || size < (uint64_t)sock->rx_used + rec)
+    return false;
 
+  uint8_t* ring = (uint8_t*)osi_malloc(size);
+  uint32_t off = 0;
+  uint32_t head = sock->rx_head;
+  uint32_t used = sock->rx_used;
+  while (used > 0) {
+    if (sock->rx_ring_size - head < sizeof(uint32_t) ||
+        sdu_ring_read_len_l(sock, head) == SDU_RING_WRAP) {
+      used -= sock->rx_ring_size - head;
+      head = 0;
+      continue;
+    }
+    uint32_t len = sdu_record_size(sdu_ring_read_len_l(sock, head));
+    memcpy(ring + off, sock->rx_ring + head, len);
+    off += len;
+    head += len;
+    used -= len;
+  }
+
+  osi_free(sock->rx_ring);
+  sock->rx_ring = ring;
+  sock->rx_ring_size = size;
+  sock->rx_head = 0;
+  sock->rx_tail = off;
+  sock->rx_used = off;
   return true;
 }
 
-static struct packet* packet_alloc(const uint8_t* data, uint32_t len) {
-  struct packet* p = (struct packet*)osi_calloc(sizeof(*p));
-  uint8_t* buf = (uint8_t*)osi_malloc(len);
-
-  p->data = buf;
-  p->len = len;
-  memcpy(p->data, data, len);
-  return p;
+/* Returns where an SDU of |len| bytes is to be written, or NULL if the ring is
+ * full. The SDU is queued by sdu_ring_commit_l() */
+static uint8_t* sdu_ring_reserve_l(l2cap_socket* sock, uint32_t len) {
+  uint32_t rec = sdu_record_size(len);
+  if (sock->rx_used == 0) sock->rx_head = sock->rx_tail = 0;
+
+  for (;;) {
+    uint32_t size = sock->rx_ring_size;
+    if (sock->rx_used == 0 || sock->rx_tail > sock->rx_head) {
+      if (size - sock->rx_tail >= rec)
+        return sock->rx_ring + sock->rx_tail + sizeof(uint32_t);
+      if (sock->rx_head >= rec) {
+        if (size - sock->rx_tail >= sizeof(uint32_t)) {
+          uint32_t wrap = SDU_RING_WRAP;
+          memcpy(sock->rx_ring + sock->rx_tail, &wrap, sizeof(wrap));
+        }
+        sock->rx_used += size - sock->rx_tail;
+        sock->rx_tail = 0;
+        return sock->rx_ring + sizeof(uint32_t);
+      }
+    } else if (sock->rx_head - sock->rx_tail >= rec) {
+      return sock->rx_ring + sock->rx_tail + sizeof(uint32_t);
+    }
+    if (!sdu_ring_grow_l(sock, rec)) return NULL;
+  }
 }
 
-/* makes a copy of the data, returns true on success */
-static char packet_put_head_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
-
-  /*
-   * We do not check size limits here since this is used to undo "getting" a
-   * packet that the user read incompletely. That is to say the packet was
-   * already in the queue. We do check thos elimits in packet_put_tail_l() since
-   * that function is used to put new data into the queue.
-   */
-
-  if (!p) return false;
+/* Queue the SDU of |len| bytes written where sdu_ring_reserve_l() said */
+static void sdu_ring_commit_l(l2cap_socket* sock, uint32_t len) {
+  memcpy(sock->rx_ring + sock->rx_tail, &len, sizeof(len));
+  sock->rx_tail += sdu_record_size(len);
+  sock->rx_used += sdu_record_size(len);
+}
 
-  p->prev = NULL;
-  p->next = sock->first_packet;
-  sock->first_packet = p;
-  if (p->next)
-    p->next->prev = p;
-  else
-    sock->last_packet = p;
+/* returns false if none, the first SDU stays queued until consumed */
+static bool sdu_ring_front_l(l2cap_socket* sock, uint8_t** data,
+                             uint32_t* len) {
+  if (sock->rx_used == 0) return false;
 
-  sock->bytes_buffered += len;
+  if (sock->rx_ring_size - sock->rx_head < sizeof(uint32_t) ||
+      sdu_ring_read_len_l(sock, sock->rx_head) == SDU_RING_WRAP) {
+    sock->rx_used -= sock->rx_ring_size - sock->rx_head;
+    sock->rx_head = 0;
+  }
 
+  *data = sock->rx_ring + sock->rx_head + sizeof(uint32_t) + sock->rx_head_sent;
+  *len = sdu_ring_read_len_l(sock, sock->rx_head) - sock->rx_head_sent;
   return true;
 }
 
-/* makes a copy of the data, returns true on success */
-static char packet_put_tail_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  if (sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER) {
-    LOG_ERROR("Unable to add to buffer due to buffer overflow socket_id:%u",
-              sock->id);
-    return false;
+/* Drop |sent| bytes of the first SDU, and the SDU once all of it was sent */
+static void sdu_ring_consume_l(l2cap_socket* sock, uint32_t sent) {
+  uint32_t len = sdu_ring_read_len_l(sock, sock->rx_head);
+  if (sock->rx_head_sent + sent < len) {
+    sock->rx_head_sent += sent;
+    return;
   }
 
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
-  p->next = NULL;
-  p->prev = sock->last_packet;
-  sock->last_packet = p;
-  if (p->prev)
-    p->prev->next = p;
-  else
-    sock->first_packet = p;
-
-  sock->bytes_buffered += len;
-
-  return true;
+  sock->rx_head += sdu_record_size(len);
+  sock->rx_used -= sdu_record_size(len);
+  sock->rx_head_sent = 0;
+  if (sock->rx_used == 0) sock->rx_head = sock->rx_tail = 0;
 }
 
 static char is_inited(void) {
@@ -193,7 +232,6 @@ static l2cap_socket* btsock_l2cap_find_by_id_l(uint32_t id) {
 }
 
 static void btsock_l2cap_free_l(l2cap_socket* sock) {
-  uint8_t* buf;
   l2cap_socket* t = socks;
 
   while (t && t != sock) t = t->next;
@@ -201,6 +239,9 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
   if (!t) /* prever double-frees */
     return;
 
+  // wait for a flush or a data indication found the socket before us
+  { std::unique_lock<std::mutex> rx_lock(sock->rx_lock); }
+
   // Whenever a socket is freed, the connection must be dropped
   log_socket_connection_state(
       sock->addr, sock->id, sock->is_le_coc ? BTSOCK_L2CAP_LE : BTSOCK_L2CAP,
@@ -225,7 +266,7 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
              sock->id);
   }
 
-  while (packet_get_head_l(sock, &buf, NULL)) osi_free(buf);
+  osi_free(sock->rx_ring);
 
   // lower-level close() should be idempotent... so let's call it and see...
   if (sock->is_le_coc) {
@@ -250,7 +291,7 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
     }
   }
 
-  osi_free(sock);
+  delete sock;
 }
 
 static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
@@ -258,7 +299,7 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
                                           char is_server, int flags) {
   unsigned security = 0;
   int fds[2];
-  l2cap_socket* sock = (l2cap_socket*)osi_calloc(sizeof(*sock));
+  l2cap_socket* sock = new l2cap_socket{};
 
   if (flags & BTSOCK_FLAG_ENCRYPT)
     security |= is_server ? BTM_SEC_IN_ENCRYPT : BTM_SEC_OUT_ENCRYPT;
@@ -286,9 +327,6 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
   if (name) strncpy(sock->name, name, sizeof(sock->name) - 1);
   if (addr) sock->addr = *addr;
 
-  sock->first_packet = NULL;
-  sock->last_packet = NULL;
-
   sock->tx_mtu = L2CAP_LE_MIN_MTU;
 
   sock->next = socks;
@@ -317,7 +355,7 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
   return sock;
 
 fail_sockpair:
-  osi_free(sock);
+  delete sock;
   return NULL;
 }
 
@@ -594,14 +632,24 @@ static void on_l2cap_write_done(uint16_t len, uint32_t id) {
   uid_set_add_tx(uid_set, app_uid, len);
 }
 
+/* Find the socket with |id| and take its rx_lock. state_lock is only held
+ * for the lookup, btsock_l2cap_free_l() waits for rx_lock to be released. */
+static l2cap_socket* btsock_l2cap_lock_rx(uint32_t id,
+                                          std::unique_lock<std::mutex>* lock) {
+  std::unique_lock<std::mutex> state(state_lock);
+  l2cap_socket* sock = btsock_l2cap_find_by_id_l(id);
+  if (sock) *lock = std::unique_lock<std::mutex>(sock->rx_lock);
+  return sock;
+}
+
 static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
   l2cap_socket* sock;
 
   int app_uid = -1;
   uint32_t bytes_read = 0;
 
-  std::unique_lock<std::mutex> lock(state_lock);
-  sock = btsock_l2cap_find_by_id_l(id);
+  std::unique_lock<std::mutex> rx_lock;
+  sock = btsock_l2cap_lock_rx(id, &rx_lock);
   if (!sock) {
     LOG_ERROR("Unable to find l2cap socket with socket_id:%u", id);
     return;
@@ -612,20 +660,27 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
   uint32_t count;
 
   if (BTA_JvL2capReady(sock->handle, &count) == BTA_JV_SUCCESS) {
-    std::vector<uint8_t> buffer(count);
-    if (BTA_JvL2capRead(sock->handle, sock->id, buffer.data(), count) ==
+    uint8_t* sdu = sdu_ring_reserve_l(sock, count);
+    if (!sdu) {  // connection must be dropped
+      LOG_ERROR("Unable to add to buffer due to buffer overflow socket_id:%u",
+                sock->id);
+      rx_lock.unlock();
+
+      std::unique_lock<std::mutex> lock(state_lock);
+      sock = btsock_l2cap_find_by_id_l(id);
+      if (!sock) return;
+      LOG_WARN("Closing socket as unable to push data to socket socket_id:%u",
+               sock->id);
+      BTA_JvL2capClose(sock->handle);
+      btsock_l2cap_free_l(sock);
+      return;
+    }
+    if (BTA_JvL2capRead(sock->handle, sock->id, sdu, count) ==
         BTA_JV_SUCCESS) {
-      if (packet_put_tail_l(sock, buffer.data(), count)) {
-        bytes_read = count;
-        btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
-                             sock->id);
-      } else {  // connection must be dropped
-        LOG_WARN("Closing socket as unable to push data to socket socket_id:%u",
-                 sock->id);
-        BTA_JvL2capClose(sock->handle);
-        btsock_l2cap_free_l(sock);
-        return;
-      }
+      sdu_ring_commit_l(sock, count);
+      bytes_read = count;
+      btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                           sock->id);
     }
   }
 
@@ -807,23 +862,16 @@ static bool flush_incoming_que_on_wr_signal_l(l2cap_socket* sock) {
   uint8_t* buf;
   uint32_t len;
 
-  while (packet_get_head_l(sock, &buf, &len)) {
+  while (sdu_ring_front_l(sock, &buf, &len)) {
     ssize_t sent;
     OSI_NO_INTR(sent = send(sock->our_fd, buf, len, MSG_DONTWAIT));
     int saved_errno = errno;
 
-    if (sent == (signed)len)
-      osi_free(buf);
-    else if (sent >= 0) {
-      packet_put_head_l(sock, buf + sent, len - sent);
-      osi_free(buf);
-      if (!sent) /* special case if other end not keeping up */
-        return true;
-    } else {
-      packet_put_head_l(sock, buf, len);
-      osi_free(buf);
-      return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
-    }
+    if (sent < 0) return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
+
+    sdu_ring_consume_l(sock, sent);
+    if (!sent) /* special case if other end not keeping up */
+      return true;
   }
 
   return false;
@@ -842,9 +890,47 @@ inline uint8_t* get_l2cap_sdu_start_ptr(BT_HDR* msg) {
   return (uint8_t*)(msg) + BT_HDR_SIZE + msg->offset;
 }
 
+/* Read one SDU the app wrote to |fd|, at most |size| bytes. Returns nullptr
+ * if there was nothing to read. */
+static BT_HDR* read_l2cap_sdu(l2cap_socket* sock, int fd, int size) {
+  BT_HDR* buffer = malloc_l2cap_buf(size);
+  /* The socket is created with SOCK_SEQPACKET, hence we read one message
+   * at the time. */
+  ssize_t count;
+  OSI_NO_INTR(count = recv(fd, get_l2cap_sdu_start_ptr(buffer), size,
+                           MSG_NOSIGNAL | MSG_DONTWAIT | MSG_TRUNC));
+  if (count < 0) {
+    osi_free(buffer);
+    return nullptr;
+  }
+  if (count > sock->tx_mtu) {
+    /* This can't happen thanks to check in BluetoothSocket.java but leave
+     * this in case this socket is ever used anywhere else*/
+    LOG(ERROR) << "recv more than MTU. Data will be lost: " << count;
+    count = sock->tx_mtu;
+  }
+
+  /* When multiple packets smaller than MTU are flushed to the socket, the
+     size of the single packet read could be smaller than the ioctl
+     reported total size of awaiting packets. Hence, we adjust the buffer
+     length. */
+  buffer->len = count;
+  DVLOG(2) << __func__ << ": bytes received from socket: " << count;
+  return buffer;
+}
+
 void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
   char drop_it = false;
 
+  if (flags & SOCK_THREAD_FD_WR) {
+    // app is ready to receive more data, tell stack to enable the data flow
+    std::unique_lock<std::mutex> rx_lock;
+    l2cap_socket* sock = btsock_l2cap_lock_rx(user_id, &rx_lock);
+    if (sock && flush_incoming_que_on_wr_signal_l(sock) && sock->connected)
+      btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                           sock->id);
+  }
+
   /* We use MSG_DONTWAIT when sending data to JAVA, hence it can be accepted to
    * hold the lock. */
   std::unique_lock<std::mutex> lock(state_lock);
@@ -863,40 +949,37 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
            BluetoothSocket.write(...) guarantees that any packet send to this
            socket is broken into pieces no bigger than MTU bytes (as requested
            by BT spec). */
-        size = std::min(size, (int)sock->tx_mtu);
-
-        BT_HDR* buffer = malloc_l2cap_buf(size);
-        /* The socket is created with SOCK_SEQPACKET, hence we read one message
-         * at the time. */
-        ssize_t count;
-        OSI_NO_INTR(count = recv(fd, get_l2cap_sdu_start_ptr(buffer), size,
-                                 MSG_NOSIGNAL | MSG_DONTWAIT | MSG_TRUNC));
-        if (count > sock->tx_mtu) {
-          /* This can't happen thanks to check in BluetoothSocket.java but leave
-           * this in case this socket is ever used anywhere else*/
-          LOG(ERROR) << "recv more than MTU. Data will be lost: " << count;
-          count = sock->tx_mtu;
+        std::vector<BT_HDR*> buffers;
+        uint32_t total = 0;
+        /* Also pick up SDUs the app has already queued behind the first one,
+         * so they share one main thread task and one write completion. */
+        do {
+          size = std::min(size, (int)sock->tx_mtu);
+          BT_HDR* buffer = read_l2cap_sdu(sock, fd, size);
+          if (!buffer) break;
+          total += buffer->len;
+          buffers.push_back(buffer);
+        } while (buffers.size() < L2CAP_MAX_WRITE_BATCH &&
+                 total + sock->tx_mtu <= UINT16_MAX &&
+                 ioctl(sock->our_fd, FIONREAD, &size) == 0 && size > 0);
+
+        if (buffers.empty()) {
+          /* Nothing was read, so no write event will re-arm the socket */
+          btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP,
+                               SOCK_THREAD_FD_RD, sock->id);
+        } else if (buffers.size() == 1) {
+          // will take care of freeing buffer
+          BTA_JvL2capWrite(sock->handle, PTR_TO_UINT(buffers[0]), buffers[0],
+                           user_id);
+        } else {
+          uint32_t req_id = PTR_TO_UINT(buffers.back());
+          BTA_JvL2capWriteBatch(sock->handle, req_id, std::move(buffers),
+                                user_id);
         }
-
-        /* When multiple packets smaller than MTU are flushed to the socket, the
-           size of the single packet read could be smaller than the ioctl
-           reported total size of awaiting packets. Hence, we adjust the buffer
-           length. */
-        buffer->len = count;
-        DVLOG(2) << __func__ << ": bytes received from socket: " << count;
-
-        // will take care of freeing buffer
-        BTA_JvL2capWrite(sock->handle, PTR_TO_UINT(buffer), buffer, user_id);
       }
     } else
       drop_it = true;
   }
-  if (flags & SOCK_THREAD_FD_WR) {
-    // app is ready to receive more data, tell stack to enable the data flow
-    if (flush_incoming_que_on_wr_signal_l(sock) && sock->connected)
-      btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
-                           sock->id);
-  }
   if (drop_it || (flags & SOCK_THREAD_FD_EXCEPTION)) {
     int size = 0;
     if (drop_it || ioctl(sock->our_fd, FIONREAD, &size) != 0 || size == 0)
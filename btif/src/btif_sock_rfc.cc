@@ -22,6 +22,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <cstdint>
 #include <mutex>
 
@@ -56,6 +57,9 @@ using bluetooth::Uuid;
 // Maximum number of devices we can have an RFCOMM connection with.
 #define MAX_RFC_SESSION 7
 
+// Maximum number of queued buffers handed to the app socket in one call.
+#define RFC_MAX_BATCHED_BUFFERS 16
+
 typedef struct {
   int outgoing_congest : 1;
   int pending_sdp_request : 1;
@@ -799,10 +803,57 @@ static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
   return SENT_PARTIAL;
 }
 
+// Sends the buffers at the front of the incoming queue to the app with one
+// call, dropping the ones that were sent. SENT_ALL means all of them went out,
+// more may be queued.
+static sent_status_t send_queue_to_app(rfc_slot_t* slot) {
+  struct iovec iov[RFC_MAX_BATCHED_BUFFERS];
+  size_t iov_count = 0;
+  size_t total = 0;
+  for (const list_node_t* node = list_begin(slot->incoming_queue);
+       node != list_end(slot->incoming_queue) &&
+       iov_count < RFC_MAX_BATCHED_BUFFERS;
+       node = list_next(node)) {
+    BT_HDR* p_buf = (BT_HDR*)list_node(node);
+    iov[iov_count].iov_base = p_buf->data + p_buf->offset;
+    iov[iov_count].iov_len = p_buf->len;
+    iov_count++;
+    total += p_buf->len;
+  }
+
+  ssize_t sent = 0;
+  if (total != 0) {
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+    OSI_NO_INTR(sent = sendmsg(slot->fd, &msg, MSG_DONTWAIT));
+
+    if (sent == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
+      LOG_ERROR("%s error writing RFCOMM data back to app: %s", __func__,
+                strerror(errno));
+      return SENT_FAILED;
+    }
+
+    if (sent == 0) return SENT_FAILED;
+  }
+
+  for (size_t i = 0; i < iov_count; i++) {
+    BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
+    if (p_buf->len > sent) {
+      p_buf->offset += sent;
+      p_buf->len -= sent;
+      return SENT_PARTIAL;
+    }
+    sent -= p_buf->len;
+    list_remove(slot->incoming_queue, p_buf);
+  }
+  return SENT_ALL;
+}
+
 static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
   while (!list_is_empty(slot->incoming_queue)) {
-    BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
+    switch (send_queue_to_app(slot)) {
       case SENT_NONE:
       case SENT_PARTIAL:
         // monitor the fd to get callback when app is ready to receive data
@@ -811,11 +862,9 @@ static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
         return true;
 
       case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
         break;
 
       case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
         return false;
     }
   }
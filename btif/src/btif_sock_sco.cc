@@ -85,8 +85,6 @@ bt_status_t btsock_sco_init(thread_t* thread_) {
   if (!sco_sockets) return BT_STATUS_FAIL;
 
   thread = thread_;
-  enh_esco_params_t params = esco_parameters_for_codec(SCO_CODEC_CVSD_D1);
-  BTM_SetEScoMode(&params);
 
   return BT_STATUS_SUCCESS;
 }
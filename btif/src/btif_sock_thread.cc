@@ -20,7 +20,7 @@
  *
  *  Filename:      btif_sock_thread.cc
  *
- *  Description:   socket select thread
+ *  Description:   socket poll thread
  *
  ******************************************************************************/
 
@@ -38,8 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -49,6 +48,7 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 #include "bta_api.h"
 #include "btif_common.h"
@@ -66,10 +66,16 @@
 
 #define MAX_THREAD 8
 #define MAX_POLL 64
-#define POLL_EXCEPTION_EVENTS (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL)
+/* Most readiness events handled per epoll_wait() */
+#define MAX_POLL_EVENTS 16
+/* Sockets a poll thread serves before new ones go to another thread */
+#define POLL_SPREAD_THRESHOLD 32
+#define POLL_EXCEPTION_EVENTS (EPOLLHUP | EPOLLRDHUP | EPOLLERR)
 #define IS_EXCEPTION(e) ((e)&POLL_EXCEPTION_EVENTS)
-#define IS_READ(e) ((e)&POLLIN)
-#define IS_WRITE(e) ((e)&POLLOUT)
+#define IS_READ(e) ((e)&EPOLLIN)
+#define IS_WRITE(e) ((e)&EPOLLOUT)
+/* epoll_event data of the cmd fd, data fds carry their fd and poll slot */
+#define CMD_FD_EVENT_DATA UINT64_MAX
 /*cmd executes in socket poll thread */
 #define CMD_WAKEUP 1
 #define CMD_EXIT 2
@@ -78,20 +84,30 @@
 #define CMD_USER_PRIVATE 5
 
 struct poll_slot_t {
-  struct pollfd pfd;
+  int fd;
   uint32_t user_id;
   int type;
-  int flags;
+  int flags;  // monitored events, 0 once all of them were signaled
 };
 struct thread_slot_t {
   int cmd_fdr, cmd_fdw;
+  int epoll_fd;
   int poll_count;
   poll_slot_t ps[MAX_POLL];
-  int psi[MAX_POLL];  // index of poll slot
+  int free_ps[MAX_POLL];  // indexes of the unused poll slots
+  int free_count;
+  std::unordered_map<int, int> fd_ps;  // poll slot of each fd
   std::optional<pthread_t> thread_id;
   btsock_signaled_cb callback;
   btsock_cmd_cb cmd_callback;
   int used;
+  // Poll threads of one handle share its callbacks. The thread the handle
+  // was created for keeps the group, guarded by thread_slot_lock.
+  int leader;
+  int workers[MAX_THREAD];
+  int worker_count;
+  std::unordered_map<int, int> fd_worker;  // poll thread of each fd
+  int fd_count;                            // fds the group gave this thread
 };
 static thread_slot_t ts[MAX_THREAD];
 
@@ -128,7 +144,7 @@ static inline int create_thread(void* (*start_routine)(void*), void* arg,
   pthread_setschedparam(*thread_id, policy, &param);
   return ret;
 }
-static void init_poll(int cmd_fd);
+static bool init_poll(int cmd_fd);
 static int alloc_thread_slot() {
   std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
   int i;
@@ -145,6 +161,14 @@ static int alloc_thread_slot() {
 static void free_thread_slot(int h) {
   if (0 <= h && h < MAX_THREAD) {
     close_cmd_fd(h);
+    if (ts[h].epoll_fd != -1) {
+      close(ts[h].epoll_fd);
+      ts[h].epoll_fd = -1;
+    }
+    ts[h].fd_ps.clear();
+    ts[h].fd_worker.clear();
+    ts[h].leader = -1;
+    ts[h].worker_count = 0;
     ts[h].used = 0;
   } else
     APPL_TRACE_ERROR("invalid thread handle:%d", h);
@@ -156,44 +180,67 @@ void btsock_thread_init() {
     int h;
     for (h = 0; h < MAX_THREAD; h++) {
       ts[h].cmd_fdr = ts[h].cmd_fdw = -1;
+      ts[h].epoll_fd = -1;
       ts[h].used = 0;
       ts[h].thread_id = std::nullopt;
       ts[h].poll_count = 0;
       ts[h].callback = NULL;
       ts[h].cmd_callback = NULL;
+      ts[h].leader = -1;
+      ts[h].worker_count = 0;
+      ts[h].fd_count = 0;
     }
   }
 }
-int btsock_thread_create(btsock_signaled_cb callback,
-                         btsock_cmd_cb cmd_callback) {
-  asrt(callback || cmd_callback);
+/* start one more poll thread in the group of |leader| */
+static int start_poll_thread(int leader, btsock_signaled_cb callback,
+                             btsock_cmd_cb cmd_callback) {
   int h = alloc_thread_slot();
-  if (h >= 0) {
-    init_poll(h);
-    pthread_t thread;
-    int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
-    if (status) {
-      APPL_TRACE_ERROR("create_thread failed: %s", strerror(status));
-      free_thread_slot(h);
-      return -1;
-    }
+  if (h < 0) return -1;
 
-    ts[h].thread_id = thread;
-    ts[h].callback = callback;
-    ts[h].cmd_callback = cmd_callback;
+  if (!init_poll(h)) {
+    free_thread_slot(h);
+    return -1;
+  }
+  ts[h].callback = callback;
+  ts[h].cmd_callback = cmd_callback;
+  ts[h].leader = leader < 0 ? h : leader;
+  ts[h].worker_count = 0;
+  ts[h].fd_count = 0;
+
+  pthread_t thread;
+  int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
+  if (status) {
+    APPL_TRACE_ERROR("create_thread failed: %s", strerror(status));
+    free_thread_slot(h);
+    return -1;
   }
+  ts[h].thread_id = thread;
+
+  std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
+  thread_slot_t* group = &ts[ts[h].leader];
+  group->workers[group->worker_count++] = h;
   return h;
 }
+int btsock_thread_create(btsock_signaled_cb callback,
+                         btsock_cmd_cb cmd_callback) {
+  asrt(callback || cmd_callback);
+  return start_poll_thread(-1, callback, cmd_callback);
+}
 
-/* create dummy socket pair used to wake up select loop */
+/* create dummy socket pair used to wake up the poll loop */
 static inline void init_cmd_fd(int h) {
   asrt(ts[h].cmd_fdr == -1 && ts[h].cmd_fdw == -1);
   if (socketpair(AF_UNIX, SOCK_STREAM, 0, &ts[h].cmd_fdr) < 0) {
     APPL_TRACE_ERROR("socketpair failed: %s", strerror(errno));
     return;
   }
-  // add the cmd fd for read & write
-  add_poll(h, ts[h].cmd_fdr, 0, SOCK_THREAD_FD_RD, 0);
+  // commands are read one at a time, keep the cmd fd level triggered
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = CMD_FD_EVENT_DATA;
+  if (epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ts[h].cmd_fdr, &event) == -1)
+    APPL_TRACE_ERROR("epoll_ctl cmd fd failed: %s", strerror(errno));
 }
 static inline void close_cmd_fd(int h) {
   if (ts[h].cmd_fdr != -1) {
@@ -212,8 +259,45 @@ typedef struct {
   int flags;
   uint32_t user_id;
 } sock_cmd_t;
+static inline bool is_valid_handle(int h) {
+  return 0 <= h && h < MAX_THREAD && ts[h].used && ts[h].leader == h;
+}
+/* poll thread of the group |h| that polls |fd|, picking the least loaded one
+ * or starting a new one for an fd that is not polled yet */
+static int find_poll_thread(int h, int fd) {
+  std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
+  thread_slot_t* group = &ts[h];
+  auto it = group->fd_worker.find(fd);
+  if (it != group->fd_worker.end()) return it->second;
+
+  int worker = h;
+  for (int i = 0; i < group->worker_count; i++) {
+    int w = group->workers[i];
+    if (ts[w].fd_count < ts[worker].fd_count) worker = w;
+  }
+  if (ts[worker].fd_count >= POLL_SPREAD_THRESHOLD) {
+    int w = start_poll_thread(h, group->callback, group->cmd_callback);
+    if (w >= 0) {
+      LOG_INFO("h:%d, started poll thread %d for fd:%d", h, w, fd);
+      worker = w;
+    }
+  }
+  group->fd_worker[fd] = worker;
+  ts[worker].fd_count++;
+  return worker;
+}
+/* forget that poll thread |w| of the group |h| polls |fd| */
+static void release_poll_thread(int h, int w, int fd) {
+  std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
+  if (h < 0) return;
+  auto& fd_worker = ts[h].fd_worker;
+  auto it = fd_worker.find(fd);
+  if (it == fd_worker.end() || (w >= 0 && it->second != w)) return;
+  ts[it->second].fd_count--;
+  fd_worker.erase(it);
+}
 int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id) {
-  if (h < 0 || h >= MAX_THREAD) {
+  if (!is_valid_handle(h)) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
@@ -222,12 +306,13 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id) {
         "cmd socket is not created. socket thread may not initialized");
     return false;
   }
+  int w = find_poll_thread(h, fd);
   if (flags & SOCK_THREAD_ADD_FD_SYNC) {
     // must executed in socket poll thread
-    if (ts[h].thread_id.value() == pthread_self()) {
+    if (ts[w].thread_id.value() == pthread_self()) {
       // cleanup one-time flags
       flags &= ~SOCK_THREAD_ADD_FD_SYNC;
-      add_poll(h, fd, type, flags, user_id);
+      add_poll(w, fd, type, flags, user_id);
       return true;
     }
     LOG_WARN(
@@ -236,13 +321,13 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id) {
   sock_cmd_t cmd = {CMD_ADD_FD, fd, type, flags, user_id};
 
   ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
+  OSI_NO_INTR(ret = send(ts[w].cmd_fdw, &cmd, sizeof(cmd), 0));
 
   return ret == sizeof(cmd);
 }
 
 bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
-  if (thread_handle < 0 || thread_handle >= MAX_THREAD) {
+  if (!is_valid_handle(thread_handle)) {
     APPL_TRACE_ERROR("%s invalid thread handle: %d", __func__, thread_handle);
     return false;
   }
@@ -251,17 +336,25 @@ bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
     return false;
   }
 
+  int w = thread_handle;
+  {
+    std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
+    auto it = ts[thread_handle].fd_worker.find(fd);
+    if (it != ts[thread_handle].fd_worker.end()) w = it->second;
+    release_poll_thread(thread_handle, w, fd);
+  }
+
   sock_cmd_t cmd = {CMD_REMOVE_FD, fd, 0, 0, 0};
 
   ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[thread_handle].cmd_fdw, &cmd, sizeof(cmd), 0));
+  OSI_NO_INTR(ret = send(ts[w].cmd_fdw, &cmd, sizeof(cmd), 0));
 
   return ret == sizeof(cmd);
 }
 
 int btsock_thread_post_cmd(int h, int type, const unsigned char* data, int size,
                            uint32_t user_id) {
-  if (h < 0 || h >= MAX_THREAD) {
+  if (!is_valid_handle(h)) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
@@ -292,7 +385,7 @@ int btsock_thread_post_cmd(int h, int type, const unsigned char* data, int size,
   return ret == size_send;
 }
 int btsock_thread_wakeup(int h) {
-  if (h < 0 || h >= MAX_THREAD) {
+  if (!is_valid_handle(h)) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
@@ -307,11 +400,7 @@ int btsock_thread_wakeup(int h) {
 
   return ret == sizeof(cmd);
 }
-int btsock_thread_exit(int h) {
-  if (h < 0 || h >= MAX_THREAD) {
-    APPL_TRACE_ERROR("invalid bt thread slot:%d", h);
-    return false;
-  }
+static bool exit_poll_thread(int h) {
   if (ts[h].cmd_fdw == -1) {
     APPL_TRACE_ERROR("cmd socket is not created");
     return false;
@@ -331,29 +420,75 @@ int btsock_thread_exit(int h) {
   }
   return false;
 }
-static void init_poll(int h) {
+int btsock_thread_exit(int h) {
+  if (!is_valid_handle(h)) {
+    APPL_TRACE_ERROR("invalid bt thread slot:%d", h);
+    return false;
+  }
+  int workers[MAX_THREAD];
+  int worker_count;
+  {
+    std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
+    worker_count = ts[h].worker_count;
+    memcpy(workers, ts[h].workers, sizeof(workers));
+  }
+  // the leader goes last, it holds the group
+  for (int i = 0; i < worker_count; i++) {
+    if (workers[i] != h) exit_poll_thread(workers[i]);
+  }
+  return exit_poll_thread(h);
+}
+static bool init_poll(int h) {
   int i;
   ts[h].poll_count = 0;
   ts[h].thread_id = std::nullopt;
   ts[h].callback = NULL;
   ts[h].cmd_callback = NULL;
+  ts[h].fd_ps.clear();
+  ts[h].fd_worker.clear();
   for (i = 0; i < MAX_POLL; i++) {
-    ts[h].ps[i].pfd.fd = -1;
-    ts[h].psi[i] = -1;
+    ts[h].ps[i].fd = -1;
+    ts[h].free_ps[i] = MAX_POLL - 1 - i;
+  }
+  ts[h].free_count = MAX_POLL;
+  ts[h].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (ts[h].epoll_fd == -1) {
+    APPL_TRACE_ERROR("epoll_create1 failed: %s", strerror(errno));
+    return false;
   }
   init_cmd_fd(h);
+  return true;
 }
 static inline unsigned int flags2pevents(int flags) {
   unsigned int pevents = 0;
-  if (flags & SOCK_THREAD_FD_WR) pevents |= POLLOUT;
-  if (flags & SOCK_THREAD_FD_RD) pevents |= POLLIN;
-  pevents |= POLL_EXCEPTION_EVENTS;
+  if (flags & SOCK_THREAD_FD_WR) pevents |= EPOLLOUT;
+  if (flags & SOCK_THREAD_FD_RD) pevents |= EPOLLIN;
+  // signaled events are re-armed by EPOLL_CTL_MOD, which reports a socket
+  // that is already ready, so edge triggering loses no wakeup
+  if (flags) pevents |= POLL_EXCEPTION_EVENTS | EPOLLET;
   return pevents;
 }
 
+/* register poll slot |i| with epoll, or update its events to its flags */
+static void arm_poll(int h, int i, bool is_new) {
+  poll_slot_t* ps = &ts[h].ps[i];
+  struct epoll_event event = {};
+  event.events = flags2pevents(ps->flags);
+  event.data.u64 = ((uint64_t)(uint32_t)ps->fd << 32) | (uint32_t)i;
+  int op = is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  if (epoll_ctl(ts[h].epoll_fd, op, ps->fd, &event) == 0) return;
+  // a closed fd leaves the epoll set, its number may be back with a new socket
+  if (errno == ENOENT && op == EPOLL_CTL_MOD &&
+      epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, ps->fd, &event) == 0)
+    return;
+  if (errno == EEXIST && op == EPOLL_CTL_ADD &&
+      epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_MOD, ps->fd, &event) == 0)
+    return;
+  APPL_TRACE_ERROR("epoll_ctl fd:%d failed: %s", ps->fd, strerror(errno));
+}
 static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags,
                             uint32_t user_id) {
-  ps->pfd.fd = fd;
+  ps->fd = fd;
   ps->user_id = user_id;
   if (ps->type != 0 && ps->type != type)
     APPL_TRACE_ERROR(
@@ -361,45 +496,54 @@ static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags,
         ps->type, type);
   ps->type = type;
   ps->flags = flags;
-  ps->pfd.events = flags2pevents(flags);
-  ps->pfd.revents = 0;
+}
+static inline void free_poll(int h, int i) {
+  poll_slot_t* ps = &ts[h].ps[i];
+  epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, ps->fd, NULL);
+  ts[h].fd_ps.erase(ps->fd);
+  release_poll_thread(ts[h].leader, h, ps->fd);
+  memset(ps, 0, sizeof(*ps));
+  ps->fd = -1;
+  ts[h].free_ps[ts[h].free_count++] = i;
+  --ts[h].poll_count;
+}
+/* drop the slots whose events were all signaled, their sockets may be closed
+ * already */
+static void reclaim_poll_slots(int h) {
+  for (int i = 0; i < MAX_POLL; i++) {
+    if (ts[h].ps[i].fd != -1 && ts[h].ps[i].flags == 0) free_poll(h, i);
+  }
 }
 static inline void add_poll(int h, int fd, int type, int flags,
                             uint32_t user_id) {
   asrt(fd != -1);
-  int i;
-  int empty = -1;
   poll_slot_t* ps = ts[h].ps;
 
-  for (i = 0; i < MAX_POLL; i++) {
-    if (ps[i].pfd.fd == fd) {
-      asrt(ts[h].poll_count < MAX_POLL);
-
-      set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
-      return;
-    } else if (empty < 0 && ps[i].pfd.fd == -1)
-      empty = i;
+  auto it = ts[h].fd_ps.find(fd);
+  if (it != ts[h].fd_ps.end()) {
+    int i = it->second;
+    set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
+    arm_poll(h, i, false);
+    return;
   }
-  if (empty >= 0) {
-    asrt(ts[h].poll_count < MAX_POLL);
-    set_poll(&ps[empty], fd, type, flags, user_id);
+  if (ts[h].free_count == 0) reclaim_poll_slots(h);
+  if (ts[h].free_count > 0) {
+    int i = ts[h].free_ps[--ts[h].free_count];
+    set_poll(&ps[i], fd, type, flags, user_id);
+    ts[h].fd_ps[fd] = i;
     ++ts[h].poll_count;
+    arm_poll(h, i, true);
     return;
   }
   APPL_TRACE_ERROR("exceeded max poll slot:%d!", MAX_POLL);
 }
-static inline void remove_poll(int h, poll_slot_t* ps, int flags) {
-  if (flags == ps->flags) {
-    // all monitored events signaled. To remove it, just clear the slot
-    --ts[h].poll_count;
-    memset(ps, 0, sizeof(*ps));
-    ps->pfd.fd = -1;
-  } else {
-    // one read or one write monitor event signaled, removed the accordding bit
-    ps->flags &= ~flags;
-    // update the poll events mask
-    ps->pfd.events = flags2pevents(ps->flags);
-  }
+static inline void remove_poll(int h, int i, int flags) {
+  poll_slot_t* ps = &ts[h].ps[i];
+  // one read or one write monitor event signaled, removed the accordding bit.
+  // Once all of them are, the slot stays registered without events so that
+  // re-adding the fd costs a single epoll_ctl()
+  ps->flags &= ~flags;
+  arm_poll(h, i, false);
 }
 static int process_cmd_sock(int h) {
   sock_cmd_t cmd = {-1, 0, 0, 0, 0};
@@ -416,16 +560,12 @@ static int process_cmd_sock(int h) {
     case CMD_ADD_FD:
       add_poll(h, cmd.fd, cmd.type, cmd.flags, cmd.user_id);
       break;
-    case CMD_REMOVE_FD:
-      for (int i = 1; i < MAX_POLL; ++i) {
-        poll_slot_t* poll_slot = &ts[h].ps[i];
-        if (poll_slot->pfd.fd == cmd.fd) {
-          remove_poll(h, poll_slot, poll_slot->flags);
-          break;
-        }
-      }
+    case CMD_REMOVE_FD: {
+      auto it = ts[h].fd_ps.find(cmd.fd);
+      if (it != ts[h].fd_ps.end()) free_poll(h, it->second);
       close(cmd.fd);
       break;
+    }
     case CMD_WAKEUP:
       break;
     case CMD_USER_PRIVATE:
@@ -442,88 +582,64 @@ static int process_cmd_sock(int h) {
   return true;
 }
 
-static void process_data_sock(int h, struct pollfd* pfds, int count) {
-  asrt(count <= ts[h].poll_count);
-  int i;
-  for (i = 1; i < ts[h].poll_count; i++) {
-    if (pfds[i].revents) {
-      int ps_i = ts[h].psi[i];
-      asrt(pfds[i].fd == ts[h].ps[ps_i].pfd.fd);
-      uint32_t user_id = ts[h].ps[ps_i].user_id;
-      int type = ts[h].ps[ps_i].type;
-      int flags = 0;
-      if (IS_READ(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_RD;
-      }
-      if (IS_WRITE(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_WR;
-      }
-      if (IS_EXCEPTION(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_EXCEPTION;
-        // remove the whole slot not flags
-        remove_poll(h, &ts[h].ps[ps_i], ts[h].ps[ps_i].flags);
-      } else if (flags)
-        remove_poll(h, &ts[h].ps[ps_i],
-                    flags);  // remove the monitor flags that already processed
-      if (flags) ts[h].callback(pfds[i].fd, type, flags, user_id);
-    }
+static void process_data_sock(int h, const struct epoll_event* event) {
+  int ps_i = (int)(event->data.u64 & 0xffffffff);
+  int fd = (int)(event->data.u64 >> 32);
+  // the slot may have been freed by an earlier event of the same batch
+  if (ps_i >= MAX_POLL || ts[h].ps[ps_i].fd != fd) return;
+  poll_slot_t* ps = &ts[h].ps[ps_i];
+
+  // hang ups are reported even without events, drop the slot until the fd is
+  // added again
+  if (ps->flags == 0) {
+    if (IS_EXCEPTION(event->events)) free_poll(h, ps_i);
+    return;
   }
-}
 
-static void prepare_poll_fds(int h, struct pollfd* pfds) {
-  int count = 0;
-  int ps_i = 0;
-  int pfd_i = 0;
-  asrt(ts[h].poll_count <= MAX_POLL);
-  memset(pfds, 0, sizeof(pfds[0]) * ts[h].poll_count);
-  while (count < ts[h].poll_count) {
-    if (ps_i >= MAX_POLL) {
-      APPL_TRACE_ERROR(
-          "exceed max poll range, ps_i:%d, MAX_POLL:%d, count:%d, "
-          "ts[h].poll_count:%d",
-          ps_i, MAX_POLL, count, ts[h].poll_count);
-      return;
-    }
-    if (ts[h].ps[ps_i].pfd.fd >= 0) {
-      pfds[pfd_i] = ts[h].ps[ps_i].pfd;
-      ts[h].psi[pfd_i] = ps_i;
-      count++;
-      pfd_i++;
-    }
-    ps_i++;
+  uint32_t user_id = ps->user_id;
+  int type = ps->type;
+  int flags = 0;
+  if (IS_READ(event->events) && (ps->flags & SOCK_THREAD_FD_RD)) {
+    flags |= SOCK_THREAD_FD_RD;
+  }
+  if (IS_WRITE(event->events) && (ps->flags & SOCK_THREAD_FD_WR)) {
+    flags |= SOCK_THREAD_FD_WR;
   }
+  if (IS_EXCEPTION(event->events)) {
+    flags |= SOCK_THREAD_FD_EXCEPTION;
+    // remove the whole slot not flags
+    free_poll(h, ps_i);
+  } else if (flags) {
+    // remove the monitor flags that already processed
+    remove_poll(h, ps_i, flags);
+  }
+  if (flags) ts[h].callback(fd, type, flags, user_id);
 }
+
 static void* sock_poll_thread(void* arg) {
-  struct pollfd pfds[MAX_POLL];
-  memset(pfds, 0, sizeof(pfds));
+  struct epoll_event events[MAX_POLL_EVENTS];
   int h = (intptr_t)arg;
   for (;;) {
-    prepare_poll_fds(h, pfds);
     int ret;
-    OSI_NO_INTR(ret = poll(pfds, ts[h].poll_count, -1));
+    OSI_NO_INTR(ret = epoll_wait(ts[h].epoll_fd, events, MAX_POLL_EVENTS, -1));
     if (ret == -1) {
-      APPL_TRACE_ERROR("poll ret -1, exit the thread, errno:%d, err:%s", errno,
-                       strerror(errno));
+      APPL_TRACE_ERROR("epoll_wait ret -1, exit the thread, errno:%d, err:%s",
+                       errno, strerror(errno));
       break;
     }
-    if (ret != 0) {
-      int need_process_data_fd = true;
-      if (pfds[0].revents)  // cmd fd always is the first one
-      {
-        asrt(pfds[0].fd == ts[h].cmd_fdr);
+    bool exit = false;
+    for (int i = 0; i < ret; i++) {
+      if (events[i].data.u64 == CMD_FD_EVENT_DATA) {
         if (!process_cmd_sock(h)) {
           LOG_INFO("h:%d, process_cmd_sock return false, exit...", h);
+          exit = true;
           break;
         }
-        if (ret == 1)
-          need_process_data_fd = false;
-        else
-          ret--;  // exclude the cmd fd
+      } else {
+        process_data_sock(h, &events[i]);
       }
-      if (need_process_data_fd) process_data_sock(h, pfds, ret);
-    } else {
-      LOG_INFO("no data, select ret: %d", ret);
-    };
+    }
+    if (exit) break;
   }
   LOG_INFO("socket poll thread exiting, h:%d", h);
   return 0;
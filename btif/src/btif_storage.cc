@@ -39,6 +39,14 @@
 #include <string.h>
 #include <time.h>
 
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "bt_common.h"
 #include "bta_hd_api.h"
 #include "bta_hearing_aid_api.h"
@@ -162,6 +170,77 @@ typedef struct {
   RawAddress devices[BTM_SEC_MAX_DEVICE_RECORDS];
 } btif_bonded_devices_t;
 
+/* Properties of a bonded device, taken from the config in a single pass over
+ * all the bonded devices, so that loading the profiles at start does not look
+ * every property up in the config. The getters parse values like the
+ * btif_config getters do. Keys which the keystore may hold are still read
+ * through btif_config_get_bin(). */
+class btif_bonded_device_record_t {
+ public:
+  explicit btif_bonded_device_record_t(const RawAddress& address)
+      : address_(address) {}
+
+  const RawAddress& address() const { return address_; }
+
+  void add(const std::string& key, const std::string& value) {
+    properties_.insert_or_assign(key, value);
+  }
+
+  const std::string* get_str(const std::string& key) const {
+    auto it = properties_.find(key);
+    return it == properties_.end() ? nullptr : &it->second;
+  }
+
+  bool get_int(const std::string& key, int* value) const {
+    const std::string* str = get_str(key);
+    if (str == nullptr) return false;
+    char* endptr;
+    long ret = strtol(str->c_str(), &endptr, 0);
+    if (*endptr != '\0' || ret >= std::numeric_limits<int>::max()) {
+      return false;
+    }
+    *value = static_cast<int>(ret);
+    return true;
+  }
+
+  bool get_uint64(const std::string& key, uint64_t* value) const {
+    const std::string* str = get_str(key);
+    if (str == nullptr) return false;
+    char* endptr;
+    uint64_t ret = strtoull(str->c_str(), &endptr, 0);
+    if (*endptr != '\0') return false;
+    *value = ret;
+    return true;
+  }
+
+  size_t get_bin_length(const std::string& key) const {
+    const std::string* str = get_str(key);
+    if (str == nullptr || (str->length() % 2) != 0) return 0;
+    return str->length() / 2;
+  }
+
+  bool get_bin(const std::string& key, uint8_t* value, size_t* length) const {
+    const std::string* str = get_str(key);
+    if (str == nullptr) return false;
+    size_t value_len = str->length();
+    if ((value_len % 2) != 0 || *length < (value_len / 2)) return false;
+    for (char c : *str) {
+      if (!isxdigit(c)) return false;
+    }
+    const char* ptr = str->c_str();
+    for (*length = 0; *ptr; ptr += 2, *length += 1) {
+      sscanf(ptr, "%02hhx", &value[*length]);
+    }
+    return true;
+  }
+
+ private:
+  RawAddress address_;
+  std::unordered_map<std::string, std::string> properties_;
+};
+
+typedef std::vector<btif_bonded_device_record_t> btif_bonded_device_records_t;
+
 /*******************************************************************************
  *  External functions
  ******************************************************************************/
@@ -183,6 +262,46 @@ static bool btif_has_ble_keys(const std::string& bdstr);
  *  Static functions
  ******************************************************************************/
 
+/* Records of the bonded devices, kept until the config changes */
+static std::mutex bonded_device_records_lock;
+static std::shared_ptr<const btif_bonded_device_records_t>
+    bonded_device_records;
+static uint64_t bonded_device_records_change_count;
+
+/*******************************************************************************
+ *
+ * Function         btif_in_get_bonded_device_records
+ *
+ * Description      Internal helper function to get the records of the bonded
+ *                  devices, reading them from the config in one pass unless
+ *                  the config did not change since they were last read
+ *
+ * Returns          The records, in the order of the config
+ *
+ ******************************************************************************/
+static std::shared_ptr<const btif_bonded_device_records_t>
+btif_in_get_bonded_device_records() {
+  std::optional<uint64_t> change_count = btif_config_get_change_count();
+  std::unique_lock<std::mutex> lock(bonded_device_records_lock);
+  if (bonded_device_records && change_count &&
+      *change_count == bonded_device_records_change_count) {
+    return bonded_device_records;
+  }
+
+  auto records = std::make_shared<btif_bonded_device_records_t>();
+  btif_config_for_each_paired_device_property(
+      [&records](const RawAddress& address, const std::string& key,
+                 const std::string& value) {
+        if (records->empty() || records->back().address() != address) {
+          records->emplace_back(address);
+        }
+        records->back().add(key, value);
+      });
+  bonded_device_records = records;
+  bonded_device_records_change_count = change_count.value_or(0);
+  return records;
+}
+
 static int prop2cfg(const RawAddress* remote_bd_addr, bt_property_t* prop) {
   std::string bdstr;
   if (remote_bd_addr) {
@@ -446,7 +565,9 @@ static bt_status_t btif_in_fetch_bonded_devices(
   bool bt_linkkey_file_found = false;
   int device_type;
 
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
+  auto records = btif_in_get_bonded_device_records();
+  for (const auto& record : *records) {
+    const RawAddress& bd_addr = record.address();
     auto name = bd_addr.ToString();
 
     BTIF_TRACE_DEBUG("Remote device:%s", name.c_str());
@@ -454,18 +575,18 @@ static bt_status_t btif_in_fetch_bonded_devices(
     size_t size = sizeof(link_key);
     if (btif_config_get_bin(name, "LinkKey", link_key.data(), &size)) {
       int linkkey_type;
-      if (btif_config_get_int(name, "LinkKeyType", &linkkey_type)) {
+      if (record.get_int("LinkKeyType", &linkkey_type)) {
         if (add) {
           DEV_CLASS dev_class = {0, 0, 0};
           int cod;
           int pin_length = 0;
-          if (btif_config_get_int(name, "DevClass", &cod))
+          if (record.get_int("DevClass", &cod))
             uint2devclass((uint32_t)cod, dev_class);
-          btif_config_get_int(name, "PinLength", &pin_length);
+          record.get_int("PinLength", &pin_length);
           BTA_DmAddDevice(bd_addr, dev_class, link_key, (uint8_t)linkkey_type,
                           pin_length);
 
-          if (btif_config_get_int(name, "DevType", &device_type) &&
+          if (record.get_int("DevType", &device_type) &&
               (device_type == BT_DEVICE_TYPE_DUMO)) {
             btif_gatts_add_bonded_dev_from_nv(bd_addr);
           }
@@ -859,6 +980,21 @@ bt_status_t btif_storage_remove_bonded_device(
   if (btif_config_exist(bdstr, BTIF_STORAGE_KEY_GATT_SERVER_SUPPORTED)) {
     ret &= btif_config_remove(bdstr, BTIF_STORAGE_KEY_GATT_SERVER_SUPPORTED);
   }
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_SDP_CACHE)) {
+    ret &= btif_config_remove(bdstr, BT_CONFIG_KEY_SDP_CACHE);
+  }
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_SDP_CACHE_FINGERPRINT)) {
+    ret &= btif_config_remove(bdstr, BT_CONFIG_KEY_SDP_CACHE_FINGERPRINT);
+  }
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_RMT_NAME_TIME)) {
+    ret &= btif_config_remove(bdstr, BT_CONFIG_KEY_RMT_NAME_TIME);
+  }
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_RMT_FEATURES)) {
+    ret &= btif_config_remove(bdstr, BT_CONFIG_KEY_RMT_FEATURES);
+  }
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_RMT_INFO_TIME)) {
+    ret &= btif_config_remove(bdstr, BT_CONFIG_KEY_RMT_INFO_TIME);
+  }
 
   /* write bonded info immediately */
   btif_config_flush();
@@ -1363,13 +1499,15 @@ bt_status_t btif_storage_add_hid_device_info(
  *
  ******************************************************************************/
 bt_status_t btif_storage_load_bonded_hid_info(void) {
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
+  auto records = btif_in_get_bonded_device_records();
+  for (const auto& record : *records) {
+    const RawAddress& bd_addr = record.address();
     auto name = bd_addr.ToString();
 
     BTIF_TRACE_DEBUG("Remote device:%s", name.c_str());
 
     int value;
-    if (!btif_config_get_int(name, "HidAttrMask", &value)) continue;
+    if (!record.get_int("HidAttrMask", &value)) continue;
     uint16_t attr_mask = (uint16_t)value;
 
     if (btif_in_fetch_bonded_device(name) != BT_STATUS_SUCCESS) {
@@ -1380,38 +1518,38 @@ bt_status_t btif_storage_load_bonded_hid_info(void) {
     tBTA_HH_DEV_DSCP_INFO dscp_info;
     memset(&dscp_info, 0, sizeof(dscp_info));
 
-    btif_config_get_int(name, "HidSubClass", &value);
+    record.get_int("HidSubClass", &value);
     uint8_t sub_class = (uint8_t)value;
 
-    btif_config_get_int(name, "HidAppId", &value);
+    record.get_int("HidAppId", &value);
     uint8_t app_id = (uint8_t)value;
 
-    btif_config_get_int(name, "HidVendorId", &value);
+    record.get_int("HidVendorId", &value);
     dscp_info.vendor_id = (uint16_t)value;
 
-    btif_config_get_int(name, "HidProductId", &value);
+    record.get_int("HidProductId", &value);
     dscp_info.product_id = (uint16_t)value;
 
-    btif_config_get_int(name, "HidVersion", &value);
+    record.get_int("HidVersion", &value);
     dscp_info.version = (uint8_t)value;
 
-    btif_config_get_int(name, "HidCountryCode", &value);
+    record.get_int("HidCountryCode", &value);
     dscp_info.ctry_code = (uint8_t)value;
 
     value = 0;
-    btif_config_get_int(name, "HidSSRMaxLatency", &value);
+    record.get_int("HidSSRMaxLatency", &value);
     dscp_info.ssr_max_latency = (uint16_t)value;
 
     value = 0;
-    btif_config_get_int(name, "HidSSRMinTimeout", &value);
+    record.get_int("HidSSRMinTimeout", &value);
     dscp_info.ssr_min_tout = (uint16_t)value;
 
-    size_t len = btif_config_get_bin_length(name, "HidDescriptor");
+    size_t len = record.get_bin_length("HidDescriptor");
     if (len > 0) {
       dscp_info.descriptor.dl_len = (uint16_t)len;
       dscp_info.descriptor.dsc_list = (uint8_t*)alloca(len);
-      btif_config_get_bin(name, "HidDescriptor",
-                          (uint8_t*)dscp_info.descriptor.dsc_list, &len);
+      record.get_bin("HidDescriptor", (uint8_t*)dscp_info.descriptor.dsc_list,
+                     &len);
     }
 
     // add extracted information to BTA HH
@@ -1504,17 +1642,18 @@ void btif_storage_add_hearing_aid(const HearingDevice& dev_info) {
 
 /** Loads information about bonded hearing aid devices */
 void btif_storage_load_bonded_hearing_aids() {
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
+  auto records = btif_in_get_bonded_device_records();
+  for (const auto& record : *records) {
+    const RawAddress& bd_addr = record.address();
     const std::string& name = bd_addr.ToString();
 
-    int size = STORAGE_UUID_STRING_SIZE * HEARINGAID_MAX_NUM_UUIDS;
-    char uuid_str[size];
     bool isHearingaidDevice = false;
-    if (btif_config_get_str(name, BTIF_STORAGE_PATH_REMOTE_SERVICE, uuid_str,
-                            &size)) {
+    const std::string* uuid_str =
+        record.get_str(BTIF_STORAGE_PATH_REMOTE_SERVICE);
+    if (uuid_str != nullptr) {
       Uuid p_uuid[HEARINGAID_MAX_NUM_UUIDS];
-      size_t num_uuids =
-          btif_split_uuids_string(uuid_str, p_uuid, HEARINGAID_MAX_NUM_UUIDS);
+      size_t num_uuids = btif_split_uuids_string(
+          uuid_str->c_str(), p_uuid, HEARINGAID_MAX_NUM_UUIDS);
       for (size_t i = 0; i < num_uuids; i++) {
         if (p_uuid[i] == Uuid::FromString("FDF0")) {
           isHearingaidDevice = true;
@@ -1535,52 +1674,51 @@ void btif_storage_load_bonded_hearing_aids() {
 
     int value;
     uint8_t capabilities = 0;
-    if (btif_config_get_int(name, HEARING_AID_CAPABILITIES, &value))
+    if (record.get_int(HEARING_AID_CAPABILITIES, &value))
       capabilities = value;
 
     uint16_t codecs = 0;
-    if (btif_config_get_int(name, HEARING_AID_CODECS, &value)) codecs = value;
+    if (record.get_int(HEARING_AID_CODECS, &value)) codecs = value;
 
     uint16_t audio_control_point_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_AUDIO_CONTROL_POINT, &value))
+    if (record.get_int(HEARING_AID_AUDIO_CONTROL_POINT, &value))
       audio_control_point_handle = value;
 
     uint16_t audio_status_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_AUDIO_STATUS_HANDLE, &value))
+    if (record.get_int(HEARING_AID_AUDIO_STATUS_HANDLE, &value))
       audio_status_handle = value;
 
     uint16_t audio_status_ccc_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_AUDIO_STATUS_CCC_HANDLE, &value))
+    if (record.get_int(HEARING_AID_AUDIO_STATUS_CCC_HANDLE, &value))
       audio_status_ccc_handle = value;
 
     uint16_t service_changed_ccc_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_SERVICE_CHANGED_CCC_HANDLE,
-                            &value))
+    if (record.get_int(HEARING_AID_SERVICE_CHANGED_CCC_HANDLE, &value))
       service_changed_ccc_handle = value;
 
     uint16_t volume_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_VOLUME_HANDLE, &value))
+    if (record.get_int(HEARING_AID_VOLUME_HANDLE, &value))
       volume_handle = value;
 
     uint16_t read_psm_handle = 0;
-    if (btif_config_get_int(name, HEARING_AID_READ_PSM_HANDLE, &value))
+    if (record.get_int(HEARING_AID_READ_PSM_HANDLE, &value))
       read_psm_handle = value;
 
     uint64_t lvalue;
     uint64_t hi_sync_id = 0;
-    if (btif_config_get_uint64(name, HEARING_AID_SYNC_ID, &lvalue))
+    if (record.get_uint64(HEARING_AID_SYNC_ID, &lvalue))
       hi_sync_id = lvalue;
 
     uint16_t render_delay = 0;
-    if (btif_config_get_int(name, HEARING_AID_RENDER_DELAY, &value))
+    if (record.get_int(HEARING_AID_RENDER_DELAY, &value))
       render_delay = value;
 
     uint16_t preparation_delay = 0;
-    if (btif_config_get_int(name, HEARING_AID_PREPARATION_DELAY, &value))
+    if (record.get_int(HEARING_AID_PREPARATION_DELAY, &value))
       preparation_delay = value;
 
     uint16_t is_acceptlisted = 0;
-    if (btif_config_get_int(name, HEARING_AID_IS_ACCEPTLISTED, &value))
+    if (record.get_int(HEARING_AID_IS_ACCEPTLISTED, &value))
       is_acceptlisted = value;
 
     // add extracted information to BTA Hearing Aid
@@ -1722,13 +1860,15 @@ int btif_storage_get_num_bonded_devices(void) {
  *
  ******************************************************************************/
 bt_status_t btif_storage_load_hidd(void) {
-  for (const auto& bd_addr : btif_config_get_paired_devices()) {
+  auto records = btif_in_get_bonded_device_records();
+  for (const auto& record : *records) {
+    const RawAddress& bd_addr = record.address();
     auto name = bd_addr.ToString();
 
     BTIF_TRACE_DEBUG("Remote device:%s", name.c_str());
     int value;
     if (btif_in_fetch_bonded_device(name) == BT_STATUS_SUCCESS) {
-      if (btif_config_get_int(name, "HidDeviceCabled", &value)) {
+      if (record.get_int("HidDeviceCabled", &value)) {
         BTA_HdAddDevice(bd_addr);
         break;
       }
@@ -21,6 +21,12 @@
 #include "stack_manager.h"
 
 #include <hardware/bluetooth.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
 #if defined(STATIC_LIBBLUETOOTH)
 #include <cstdlib>
 #include <cstring>
@@ -36,6 +42,7 @@
 #include "main/shim/shim.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/semaphore.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/btm_client_interface.h"
@@ -73,6 +80,7 @@
 #include "device/include/interop.h"
 #include "internal_include/stack_config.h"
 #include "main/shim/controller.h"
+#include "stack/include/stack_metrics_logging.h"
 
 #ifndef BT_STACK_CLEANUP_WAIT_MS
 #define BT_STACK_CLEANUP_WAIT_MS 1000
@@ -86,6 +94,8 @@ void BTA_dm_on_hw_off();
 using bluetooth::common::MessageLoopThread;
 
 static MessageLoopThread management_thread("bt_stack_manager_thread");
+// Brings up the controller while the management thread initializes the stack
+static MessageLoopThread bring_up_thread("bt_stack_bring_up_thread");
 
 // If initialized, any of the bluetooth API functions can be called.
 // (e.g. turning logging on and off, enabling/disabling the stack, etc)
@@ -93,19 +103,69 @@ static bool stack_is_initialized;
 // If running, the stack is fully up and able to bluetooth.
 static bool stack_is_running;
 
+// Reconnects the bonded devices in parallel once the stack is up, see
+// btif_queue_set_fast_reconnect()
+static const char* kFastReconnectProperty = "persist.bluetooth.fast_reconnect";
+
+// The stack is started up and shut down in stages, each started by the
+// readiness events of the stages it depends on. The management thread never
+// waits for a stage to complete, requests arriving meanwhile are deferred until
+// the whole sequence is done.
+typedef enum {
+  // Start up
+  STAGE_CONTROLLER_BRING_UP,
+  STAGE_STACK_LAYERS,
+  STAGE_DEVICE_MANAGER,
+  STAGE_BTIF_ENABLE,
+  // Shut down
+  STAGE_DISABLE_PROFILES,
+  STAGE_DEVICE_MANAGER_OFF,
+  STAGE_STACK_LAYERS_OFF,
+  STAGE_SIGNAL_STACK_DOWN,
+  STAGE_COUNT,
+} stage_t;
+
+static const char* const stage_names[STAGE_COUNT] = {
+    "controller_bring_up", "stack_layers",       "device_manager",
+    "btif_enable",         "disable_profiles",   "device_manager_off",
+    "stack_layers_off",    "signal_stack_down",
+};
+
+static bool stack_is_starting;
+static bool stack_is_shutting_down;
+// Readiness events of the start up
+static bool controller_is_up;
+static bool stack_layers_are_up;
+// Stage waiting for stack_manager_signal_stage_done()
+static stage_t pending_stage = STAGE_COUNT;
+static std::deque<base::OnceClosure> deferred_requests;
+
+using stage_clock = std::chrono::steady_clock;
+
+typedef struct {
+  bool has_begun;
+  bool has_ended;
+  stage_clock::time_point begin;
+  stage_clock::time_point end;
+} stage_timing_t;
+
+// Timings of the last start up and shut down, read by dumpsys
+static std::mutex stage_timings_mutex;
+static stage_clock::time_point start_up_begin;
+static stage_clock::time_point shut_down_begin;
+static stage_timing_t stage_timings[STAGE_COUNT];
+
 static void event_init_stack(void* context);
 static void event_start_up_stack(void* context);
 static void event_shut_down_stack(void* context);
 static void event_clean_up_stack(std::promise<void> promise);
 
+static void event_controller_is_up(void* context);
+static void event_stage_done(void* context);
+
 static void event_signal_stack_up(void* context);
 static void event_signal_stack_down(void* context);
 
-// Unvetted includes/imports, etc which should be removed or vetted in the
-// future
-static future_t* hack_future;
-// End unvetted section
-
 // Interface functions
 
 static void init_stack() {
@@ -244,30 +304,84 @@ static void ensure_stack_is_initialized() {
   }
 }
 
-// Synchronous function to start up the stack
-static void event_start_up_stack(UNUSED_ATTR void* context) {
-  if (stack_is_running) {
-    LOG_INFO("%s stack already brought up", __func__);
-    return;
+static void begin_sequence(stage_clock::time_point* sequence_begin,
+                           stage_t first, stage_t end) {
+  std::lock_guard<std::mutex> lock(stage_timings_mutex);
+  *sequence_begin = stage_clock::now();
+  for (int stage = first; stage < end; stage++) {
+    stage_timings[stage] = {};
   }
+}
 
-  ensure_stack_is_initialized();
+static void stage_begin(stage_t stage) {
+  std::lock_guard<std::mutex> lock(stage_timings_mutex);
+  stage_timings[stage].has_begun = true;
+  stage_timings[stage].begin = stage_clock::now();
+}
 
-  LOG_INFO("%s is bringing up the stack", __func__);
-  future_t* local_hack_future = future_new();
-  hack_future = local_hack_future;
+static void stage_end(stage_t stage) {
+  std::lock_guard<std::mutex> lock(stage_timings_mutex);
+  stage_timings[stage].has_ended = true;
+  stage_timings[stage].end = stage_clock::now();
+}
+
+// Begins a stage which completes on stack_manager_signal_stage_done()
+static void await_stage(stage_t stage) {
+  stage_begin(stage);
+  pending_stage = stage;
+}
 
+static bool stack_is_busy() {
+  return stack_is_starting || stack_is_shutting_down;
+}
+
+static void run_deferred_requests() {
+  while (!stack_is_busy() && !deferred_requests.empty()) {
+    base::OnceClosure request = std::move(deferred_requests.front());
+    deferred_requests.pop_front();
+    std::move(request).Run();
+  }
+}
+
+// Runs on the bring up thread
+static void bring_up_controller(UNUSED_ATTR void* context) {
+  stage_begin(STAGE_CONTROLLER_BRING_UP);
   if (bluetooth::shim::is_any_gd_enabled()) {
     LOG_INFO("%s Gd shim module enabled", __func__);
     module_shut_down(get_local_module(GD_IDLE_MODULE));
     module_start_up(get_local_module(GD_SHIM_MODULE));
-    module_start_up(get_local_module(BTIF_CONFIG_MODULE));
   } else {
-    module_start_up(get_local_module(BTIF_CONFIG_MODULE));
     module_start_up(get_local_module(BTSNOOP_MODULE));
     module_start_up(get_local_module(HCI_MODULE));
   }
 
+  if (bluetooth::shim::is_gd_controller_enabled()) {
+    CHECK(module_start_up(get_local_module(GD_CONTROLLER_MODULE)));
+  } else {
+    CHECK(module_start_up(get_local_module(CONTROLLER_MODULE)));
+  }
+  stage_end(STAGE_CONTROLLER_BRING_UP);
+
+  management_thread.DoInThread(FROM_HERE,
+                               base::Bind(event_controller_is_up, nullptr));
+}
+
+static void start_up_device_manager_when_ready() {
+  if (!controller_is_up || !stack_layers_are_up) return;
+
+  stage_begin(STAGE_DEVICE_MANAGER);
+  BTM_reset_complete();
+  BTA_dm_on_hw_on();
+  stage_end(STAGE_DEVICE_MANAGER);
+
+  // Done by btif_enable_bluetooth_evt(), once the local name is read
+  await_stage(STAGE_BTIF_ENABLE);
+}
+
+static void start_up_stack_layers() {
+  stage_begin(STAGE_STACK_LAYERS);
+  module_start_up(get_local_module(BTIF_CONFIG_MODULE));
+
   get_btm_client_interface().lifecycle.btm_init();
   l2c_init();
   sdp_init();
@@ -293,6 +407,7 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   bta_ar_init();
   module_init(get_local_module(BTE_LOGMSG_MODULE));
 
+  stack_metrics_logging_start_up();
   main_thread_start_up();
 
   btif_init_ok();
@@ -301,38 +416,88 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
 
   bta_set_forward_hw_failures(true);
   btm_acl_device_down();
-  if (bluetooth::shim::is_gd_controller_enabled()) {
-    CHECK(module_start_up(get_local_module(GD_CONTROLLER_MODULE)));
-  } else {
-    CHECK(module_start_up(get_local_module(CONTROLLER_MODULE)));
+  stage_end(STAGE_STACK_LAYERS);
+
+  stack_layers_are_up = true;
+  start_up_device_manager_when_ready();
+}
+
+// Asynchronous function to start up the stack, which is up once btif is enabled
+static void event_start_up_stack(UNUSED_ATTR void* context) {
+  if (stack_is_busy()) {
+    LOG_INFO("%s deferred until the stack is brought up or down", __func__);
+    deferred_requests.push_back(base::BindOnce(event_start_up_stack, nullptr));
+    return;
   }
-  BTM_reset_complete();
 
-  BTA_dm_on_hw_on();
+  if (stack_is_running) {
+    LOG_INFO("%s stack already brought up", __func__);
+    return;
+  }
 
-  if (future_await(local_hack_future) != FUTURE_SUCCESS) {
-    LOG_ERROR("%s failed to start up the stack", __func__);
-    stack_is_running = true;  // So stack shutdown actually happens
-    event_shut_down_stack(nullptr);
+  ensure_stack_is_initialized();
+
+  LOG_INFO("%s is bringing up the stack", __func__);
+  stack_is_starting = true;
+  controller_is_up = false;
+  stack_layers_are_up = false;
+  begin_sequence(&start_up_begin, STAGE_CONTROLLER_BRING_UP,
+                 STAGE_DISABLE_PROFILES);
+
+  // The controller bring up mostly waits on the controller, e.g. for its
+  // firmware to be downloaded, the stack layers are initialized meanwhile.
+  if (!bring_up_thread.IsRunning()) bring_up_thread.StartUp();
+  if (!bring_up_thread.DoInThread(FROM_HERE,
+                                  base::Bind(bring_up_controller, nullptr))) {
+    LOG_ERROR("%s unable to bring up the controller in the background",
+              __func__);
+    bring_up_controller(nullptr);
+  }
+
+  // Past the Gd shim, the stack layers use the Gd modules it starts
+  if (!bluetooth::shim::is_any_gd_enabled()) {
+    start_up_stack_layers();
+  }
+}
+
+static void event_controller_is_up(UNUSED_ATTR void* context) {
+  controller_is_up = true;
+  if (bluetooth::shim::is_any_gd_enabled()) {
+    start_up_stack_layers();
     return;
   }
+  start_up_device_manager_when_ready();
+}
 
+static void finish_start_up() {
+  stack_is_starting = false;
   stack_is_running = true;
-  LOG_INFO("%s finished", __func__);
+  LOG_INFO("%s stack is up", __func__);
   do_in_jni_thread(FROM_HERE, base::Bind(event_signal_stack_up, nullptr));
+  run_deferred_requests();
 }
 
-// Synchronous function to shut down the stack
+// Asynchronous function to shut down the stack, which is down once the JNI
+// thread has reported it
 static void event_shut_down_stack(UNUSED_ATTR void* context) {
+  if (stack_is_busy()) {
+    LOG_INFO("%s deferred until the stack is brought up or down", __func__);
+    deferred_requests.push_back(base::BindOnce(event_shut_down_stack, nullptr));
+    return;
+  }
+
   if (!stack_is_running) {
     LOG_INFO("%s stack is already brought down", __func__);
     return;
   }
 
   LOG_INFO("%s is bringing down the stack", __func__);
-  future_t* local_hack_future = future_new();
-  hack_future = local_hack_future;
+  stack_is_shutting_down = true;
   stack_is_running = false;
+  begin_sequence(&shut_down_begin, STAGE_DISABLE_PROFILES, STAGE_COUNT);
+
+  // Done once the device manager is disabled, after the links are down
+  await_stage(STAGE_DISABLE_PROFILES);
 
   do_in_main_thread(FROM_HERE, base::Bind(&btm_ble_multi_adv_cleanup));
 
@@ -341,20 +506,23 @@ static void event_shut_down_stack(UNUSED_ATTR void* context) {
   btif_pan_cleanup();
 
   do_in_main_thread(FROM_HERE, base::Bind(bta_dm_disable));
+}
 
-  future_await(local_hack_future);
-  local_hack_future = future_new();
-  hack_future = local_hack_future;
+static void shut_down_device_manager() {
+  // Done by BTIF_dm_disable()
+  await_stage(STAGE_DEVICE_MANAGER_OFF);
 
   bta_sys_disable();
   bta_set_forward_hw_failures(false);
   BTA_dm_on_hw_off();
 
   module_shut_down(get_local_module(BTIF_CONFIG_MODULE));
+}
 
-  future_await(local_hack_future);
-
+static void shut_down_stack_layers() {
+  stage_begin(STAGE_STACK_LAYERS_OFF);
   main_thread_shut_down();
+  stack_metrics_logging_shut_down();
 
   module_clean_up(get_local_module(BTE_LOGMSG_MODULE));
 
@@ -377,33 +545,75 @@ static void event_shut_down_stack(UNUSED_ATTR void* context) {
       get_local_module(CONTROLLER_MODULE));  // Doesn't do any work, just
                                              // puts it in a restartable
                                              // state
+  stage_end(STAGE_STACK_LAYERS_OFF);
 
-  hack_future = future_new();
+  // Done by event_signal_stack_down()
+  await_stage(STAGE_SIGNAL_STACK_DOWN);
   do_in_jni_thread(FROM_HERE, base::Bind(event_signal_stack_down, nullptr));
-  future_await(hack_future);
-  LOG_INFO("%s finished", __func__);
 }
 
-static void ensure_stack_is_not_running() {
-  if (stack_is_running) {
-    LOG_WARN("%s found the stack was still running. Bringing it down now.",
-             __func__);
-    event_shut_down_stack(nullptr);
+static void finish_shut_down() {
+  stack_is_shutting_down = false;
+  LOG_INFO("%s stack is down", __func__);
+  run_deferred_requests();
+}
+
+static void event_stage_done(UNUSED_ATTR void* context) {
+  stage_t stage = pending_stage;
+  if (stage == STAGE_COUNT) {
+    LOG_WARN("%s no stage is pending", __func__);
+    return;
+  }
+  pending_stage = STAGE_COUNT;
+  stage_end(stage);
+
+  switch (stage) {
+    case STAGE_BTIF_ENABLE:
+      finish_start_up();
+      break;
+    case STAGE_DISABLE_PROFILES:
+      shut_down_device_manager();
+      break;
+    case STAGE_DEVICE_MANAGER_OFF:
+      shut_down_stack_layers();
+      break;
+    case STAGE_SIGNAL_STACK_DOWN:
+      finish_shut_down();
+      break;
+    default:
+      LOG_ERROR("%s unexpected stage %s", __func__, stage_names[stage]);
+      break;
   }
 }
 
-// Synchronous function to clean up the stack
+// Synchronous function to clean up the stack, once it is brought down
 static void event_clean_up_stack(std::promise<void> promise) {
+  if (stack_is_busy()) {
+    LOG_INFO("%s deferred until the stack is brought up or down", __func__);
+    deferred_requests.push_back(
+        base::BindOnce(event_clean_up_stack, std::move(promise)));
+    return;
+  }
+
   if (!stack_is_initialized) {
     LOG_INFO("%s found the stack already in a clean state", __func__);
     goto cleanup;
   }
 
-  ensure_stack_is_not_running();
+  if (stack_is_running) {
+    LOG_WARN("%s found the stack was still running. Bringing it down now.",
+             __func__);
+    event_shut_down_stack(nullptr);
+    deferred_requests.push_back(
+        base::BindOnce(event_clean_up_stack, std::move(promise)));
+    return;
+  }
 
   LOG_INFO("%s is cleaning up the stack", __func__);
   stack_is_initialized = false;
 
+  if (bring_up_thread.IsRunning()) bring_up_thread.ShutDown();
+
   btif_cleanup_bluetooth();
 
   module_clean_up(get_local_module(STACK_CONFIG_MODULE));
@@ -423,13 +633,15 @@ cleanup:;
 static void event_signal_stack_up(UNUSED_ATTR void* context) {
   // Notify BTIF connect queue that we've brought up the stack. It's
   // now time to dispatch all the pending profile connect requests.
+  btif_queue_set_fast_reconnect(
+      osi_property_get_bool(kFastReconnectProperty, false));
   btif_queue_connect_next();
   invoke_adapter_state_changed_cb(BT_STATE_ON);
 }
 
 static void event_signal_stack_down(UNUSED_ATTR void* context) {
   invoke_adapter_state_changed_cb(BT_STATE_OFF);
-  future_ready(stack_manager_get_hack_future(), FUTURE_SUCCESS);
+  stack_manager_signal_stage_done();
 }
 
 static void ensure_manager_initialized() {
@@ -451,4 +663,43 @@ const stack_manager_t* stack_manager_get_interface() {
   return &interface;
 }
 
-future_t* stack_manager_get_hack_future() { return hack_future; }
+void stack_manager_signal_stage_done() {
+  management_thread.DoInThread(FROM_HERE,
+                               base::Bind(event_stage_done, nullptr));
+}
+
+static double to_ms(stage_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static void dump_sequence(int fd, const char* name,
+                          stage_clock::time_point sequence_begin, stage_t first,
+                          stage_t end) {
+  if (!stage_timings[first].has_begun) {
+    dprintf(fd, "  %s: none\n", name);
+    return;
+  }
+  dprintf(fd, "  %s:\n", name);
+  for (int stage = first; stage < end; stage++) {
+    const stage_timing_t& timing = stage_timings[stage];
+    if (!timing.has_begun) {
+      dprintf(fd, "    %-20s not begun\n", stage_names[stage]);
+    } else if (!timing.has_ended) {
+      dprintf(fd, "    %-20s at %8.1f ms, in progress\n", stage_names[stage],
+              to_ms(timing.begin - sequence_begin));
+    } else {
+      dprintf(fd, "    %-20s at %8.1f ms, took %8.1f ms\n",
+              stage_names[stage], to_ms(timing.begin - sequence_begin),
+              to_ms(timing.end - timing.begin));
+    }
+  }
+}
+
+void stack_manager_dump(int fd) {
+  std::lock_guard<std::mutex> lock(stage_timings_mutex);
+  dprintf(fd, "\nStack manager stages:\n");
+  dump_sequence(fd, "Last start up", start_up_begin,
+                STAGE_CONTROLLER_BRING_UP, STAGE_DISABLE_PROFILES);
+  dump_sequence(fd, "Last shut down", shut_down_begin, STAGE_DISABLE_PROFILES,
+                STAGE_COUNT);
+}
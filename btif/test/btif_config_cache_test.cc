@@ -525,4 +525,28 @@ TEST(BtifConfigCacheTest, test_PersistentSectionCopy_Init) {
   EXPECT_TRUE(std::filesystem::remove(kTestConfigFile));
 }
 
+/* Test to visit the entries of the persistent sections
+ * 1. the entries of the Local device sections and the paired devices are
+ * visited in order
+ * 2. the unpaired devices are not visited
+ */
+TEST(BtifConfigCacheTest, test_ForEachPersistentEntry) {
+  BtifConfigCache test_btif_config_cache(kCapacity);
+  test_btif_config_cache.SetString(kBtAdapter, "Address", kBtLocalAddr);
+  test_btif_config_cache.SetString(kBtAddr1, "Name", "Headset_1");
+  const std::string kLinkKey = "fedcba0987654321fedcba0987654328";
+  test_btif_config_cache.SetString(kBtAddr1, "LinkKey", kLinkKey);
+  test_btif_config_cache.SetString(kBtAddr2, "Name", "Unpaired_1");
+
+  std::vector<std::string> entries;
+  test_btif_config_cache.ForEachPersistentEntry(
+      [&entries](const std::string& section_name, const std::string& key,
+                 const std::string& value) {
+        entries.push_back(section_name + "/" + key + "=" + value);
+      });
+  EXPECT_THAT(entries, ElementsAre(kBtAdapter + "/Address=" + kBtLocalAddr,
+                                   kBtAddr1 + "/Name=Headset_1",
+                                   kBtAddr1 + "/LinkKey=" + kLinkKey));
+}
+
 }  // namespace testing
@@ -23,7 +23,12 @@
 #include <base/callback.h>
 #include <base/location.h>
 
+#include <set>
+#include <vector>
+
+#include "stack/include/sdpdefs.h"
 #include "stack_manager.h"
+#include "types/bt_transport.h"
 #include "types/raw_address.h"
 
 typedef void(tBTIF_CBACK)(uint16_t event, char* p_param);
@@ -41,6 +46,11 @@ bt_status_t do_in_jni_thread(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 bool is_on_jni_thread() { return true; }
+static std::set<RawAddress> sAclUp;
+bool BTM_IsAclConnectionUp(const RawAddress& remote_bda,
+                           tBT_TRANSPORT transport) {
+  return sAclUp.count(remote_bda) != 0;
+}
 
 enum ResultType {
   NOT_SET = 0,
@@ -55,8 +65,8 @@ static ResultType sResult;
 
 class BtifProfileQueueTest : public ::testing::Test {
  public:
-  static const uint16_t kTestUuid1 = 0x9527;
-  static const uint16_t kTestUuid2 = 0x819F;
+  static constexpr uint16_t kTestUuid1 = 0x9527;
+  static constexpr uint16_t kTestUuid2 = 0x819F;
   static const RawAddress kTestAddr1;
   static const RawAddress kTestAddr2;
 
@@ -64,6 +74,7 @@ class BtifProfileQueueTest : public ::testing::Test {
   void SetUp() override {
     sStackRunning = true;
     sResult = NOT_SET;
+    sAclUp.clear();
   };
   void TearDown() override { btif_queue_release(); };
 };
@@ -263,3 +274,109 @@ TEST_F(BtifProfileQueueTest, test_cleanup_both_reverse_order) {
   btif_queue_connect_next();
   EXPECT_EQ(sResult, NOT_SET);
 }
+
+static std::vector<std::pair<RawAddress, uint16_t>> sConnects;
+
+static bt_status_t test_connect_cb_record(RawAddress* bda, uint16_t uuid) {
+  sConnects.emplace_back(*bda, uuid);
+  return BT_STATUS_SUCCESS;
+}
+
+static bt_status_t test_connect_cb_record_fail(RawAddress* bda,
+                                               uint16_t uuid) {
+  sConnects.emplace_back(*bda, uuid);
+  return BT_STATUS_FAIL;
+}
+
+static RawAddress test_address(uint8_t i) {
+  return RawAddress({0x00, 0x11, 0x22, 0x33, 0x44, i});
+}
+
+class BtifProfileQueueFastReconnectTest : public BtifProfileQueueTest {
+ protected:
+  void SetUp() override {
+    BtifProfileQueueTest::SetUp();
+    sConnects.clear();
+    btif_queue_set_fast_reconnect(true);
+  }
+
+  // Devices 1 to 3 take all the parallel connections
+  void ConnectThreeDevices() {
+    for (uint8_t i = 1; i <= 3; i++) {
+      RawAddress address = test_address(i);
+      btif_queue_connect(kTestUuid1, &address, test_connect_cb_record);
+    }
+    ASSERT_EQ(sConnects.size(), 3u);
+    sConnects.clear();
+  }
+};
+
+TEST_F(BtifProfileQueueFastReconnectTest, test_connects_devices_in_parallel) {
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record);
+  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb_record);
+  ASSERT_EQ(sConnects.size(), 2u);
+  EXPECT_EQ(sConnects[0].first, kTestAddr1);
+  EXPECT_EQ(sConnects[1].first, kTestAddr2);
+
+  // One request at a time for a given device
+  sConnects.clear();
+  btif_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb_record);
+  EXPECT_TRUE(sConnects.empty());
+
+  // The completion of ADDR2 doesn't start it
+  btif_queue_advance_by_address(kTestAddr2);
+  EXPECT_TRUE(sConnects.empty());
+
+  btif_queue_advance_by_address(kTestAddr1);
+  ASSERT_EQ(sConnects.size(), 1u);
+  EXPECT_EQ(sConnects[0].first, kTestAddr1);
+  EXPECT_EQ(sConnects[0].second, kTestUuid2);
+}
+
+TEST_F(BtifProfileQueueFastReconnectTest, test_connected_devices_go_first) {
+  ConnectThreeDevices();
+  RawAddress paged = test_address(4);
+  RawAddress connected = test_address(5);
+  btif_queue_connect(kTestUuid1, &paged, test_connect_cb_record);
+  btif_queue_connect(kTestUuid1, &connected, test_connect_cb_record);
+  EXPECT_TRUE(sConnects.empty());
+
+  sAclUp.insert(connected);
+  btif_queue_advance_by_address(test_address(1));
+  ASSERT_EQ(sConnects.size(), 1u);
+  EXPECT_EQ(sConnects[0].first, connected);
+}
+
+TEST_F(BtifProfileQueueFastReconnectTest, test_handsfree_goes_first) {
+  ConnectThreeDevices();
+  RawAddress a2dp = test_address(4);
+  RawAddress hfp = test_address(5);
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SOURCE, &a2dp,
+                     test_connect_cb_record);
+  btif_queue_connect(UUID_SERVCLASS_AG_HANDSFREE, &hfp, test_connect_cb_record);
+
+  btif_queue_advance_by_address(test_address(1));
+  ASSERT_EQ(sConnects.size(), 1u);
+  EXPECT_EQ(sConnects[0].first, hfp);
+}
+
+TEST_F(BtifProfileQueueFastReconnectTest, test_failed_connect_moves_on) {
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record_fail);
+  btif_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb_record);
+  ASSERT_EQ(sConnects.size(), 2u);
+  EXPECT_EQ(sConnects[1].second, kTestUuid2);
+}
+
+TEST_F(BtifProfileQueueFastReconnectTest, test_advance_without_address) {
+  btif_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb_record);
+  btif_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb_record);
+  btif_queue_connect(kTestUuid1, &kTestAddr2, test_connect_cb_record);
+  ASSERT_EQ(sConnects.size(), 2u);
+
+  // Completes the oldest request running, the one of ADDR1
+  sConnects.clear();
+  btif_queue_advance();
+  ASSERT_EQ(sConnects.size(), 1u);
+  EXPECT_EQ(sConnects[0].first, kTestAddr1);
+  EXPECT_EQ(sConnects[0].second, kTestUuid2);
+}
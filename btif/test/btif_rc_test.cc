@@ -122,10 +122,65 @@ TEST_F(BtifRcTest, get_element_attr_rsp) {
       .rc_pdu_info[IDX_GET_ELEMENT_ATTR_RSP]
       .is_rsp_pending = true;
   btif_rc_cb.rc_multi_cb[0].rc_state = BTRC_CONNECTION_STATE_CONNECTED;
+  add_device_index(&btif_rc_cb.rc_multi_cb[0]);
 
   btrc_element_attr_val_t p_attrs[BTRC_MAX_ELEM_ATTR_SIZE];
   uint8_t num_attr = BTRC_MAX_ELEM_ATTR_SIZE + 1;
 
   CHECK(get_element_attr_rsp(bd_addr, num_attr, p_attrs) == BT_STATUS_SUCCESS);
   CHECK(AVRC_BldResponse_ == 1);
+
+  initialize_device(&btif_rc_cb.rc_multi_cb[0]);
+}
+
+TEST_F(BtifRcTest, device_lookup_after_disconnect) {
+  for (int i = 0; i < BTIF_RC_NUM_CONN; i++) {
+    btif_rc_device_cb_t* p_dev = alloc_device();
+    CHECK(p_dev == &btif_rc_cb.rc_multi_cb[i]);
+    p_dev->rc_addr = RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, (uint8_t)i});
+    p_dev->rc_handle = i + 1;
+    p_dev->rc_connected = true;
+    p_dev->rc_state = BTRC_CONNECTION_STATE_CONNECTED;
+    add_device_index(p_dev);
+  }
+  CHECK(alloc_device() == nullptr);
+
+  // Free a slot in the middle, the others must stay reachable
+  btif_rc_device_cb_t* p_removed = &btif_rc_cb.rc_multi_cb[1];
+  RawAddress removed_addr = p_removed->rc_addr;
+  initialize_device(p_removed);
+  CHECK(btif_rc_get_device_by_bda(removed_addr) == nullptr);
+  CHECK(btif_rc_get_device_by_handle(2) == nullptr);
+  CHECK(alloc_device() == p_removed);
+
+  for (int i = 0; i < BTIF_RC_NUM_CONN; i++) {
+    if (i == 1) continue;
+    btif_rc_device_cb_t* p_dev = &btif_rc_cb.rc_multi_cb[i];
+    CHECK(btif_rc_get_device_by_bda(p_dev->rc_addr) == p_dev);
+    CHECK(btif_rc_get_device_by_handle(i + 1) == p_dev);
+    CHECK(btif_rc_is_connected_peer(p_dev->rc_addr));
+  }
+
+  for (int i = 0; i < BTIF_RC_NUM_CONN; i++) {
+    initialize_device(&btif_rc_cb.rc_multi_cb[i]);
+  }
+}
+
+TEST_F(BtifRcTest, transaction_label_reuse) {
+  btif_rc_device_cb_t* p_dev = &btif_rc_cb.rc_multi_cb[0];
+  initialize_device(p_dev);
+
+  rc_transaction_t* transactions[MAX_TRANSACTIONS_PER_SESSION];
+  for (int i = 0; i < MAX_TRANSACTIONS_PER_SESSION; i++) {
+    CHECK(get_transaction(p_dev, &transactions[i]) == BT_STATUS_SUCCESS);
+    CHECK(transactions[i]->lbl == i);
+  }
+  rc_transaction_t* p_transaction = nullptr;
+  CHECK(get_transaction(p_dev, &p_transaction) == BT_STATUS_NOMEM);
+
+  release_transaction(p_dev, 5);
+  CHECK(get_transaction(p_dev, &p_transaction) == BT_STATUS_SUCCESS);
+  CHECK(p_transaction->lbl == 5);
+
+  initialize_device(p_dev);
 }
@@ -0,0 +1,112 @@
+/*
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif/include/btif_scan_filter.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+const RawAddress kAddr1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kAddr2({0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF});
+const std::vector<uint8_t> kData1 = {0x02, 0x01, 0x06};
+const std::vector<uint8_t> kData2 = {0x02, 0x01, 0x1A};
+const uint16_t kEvtType = 0x13;
+const uint64_t kWindowMs = 1000;
+const int kRssiThreshold = 6;
+
+TEST(BtifScanFilterTest, suppress_repeated_result) {
+  BtifScanFilter filter(10, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_FALSE(filter.ShouldReport(kAddr1, kEvtType, -62, kData1, 100));
+  EXPECT_FALSE(filter.ShouldReport(kAddr1, kEvtType, -55, kData1, 999));
+  // The window runs from the last reported result
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 1000));
+  EXPECT_EQ(2u, filter.GetReportedCount());
+  EXPECT_EQ(2u, filter.GetSuppressedCount());
+}
+
+TEST(BtifScanFilterTest, report_changes) {
+  BtifScanFilter filter(10, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData2, 10));
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType + 1, -60, kData2, 20));
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType + 1, -66, kData2, 30));
+  EXPECT_TRUE(filter.ShouldReport(kAddr2, kEvtType + 1, -66, kData2, 40));
+  EXPECT_EQ(0u, filter.GetSuppressedCount());
+}
+
+TEST(BtifScanFilterTest, evicted_and_cleared_results_are_reported) {
+  BtifScanFilter filter(1, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_TRUE(filter.ShouldReport(kAddr2, kEvtType, -60, kData1, 10));
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 20));
+  filter.Clear();
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 30));
+}
+
+TEST(BtifScanFilterTest, disabled_filter_reports_everything) {
+  BtifScanFilter filter(10, 0, kRssiThreshold);
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_TRUE(filter.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_EQ(0u, filter.GetSuppressedCount());
+}
+
+TEST(BtifScannerFiltersTest, scanners_report_everything_by_default) {
+  BtifScannerFilters filters(10);
+  filters.AddScanner(1);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 10));
+  EXPECT_EQ(0u, filters.GetSuppressedCount());
+}
+
+TEST(BtifScannerFiltersTest, suppress_when_every_scanner_filters) {
+  BtifScannerFilters filters(10);
+  filters.AddScanner(1);
+  filters.AddScanner(2);
+  filters.SetFilter(1, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  // Scanner 2 still wants every result
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 10));
+
+  filters.SetFilter(2, kWindowMs / 2, kRssiThreshold);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 20));
+  EXPECT_FALSE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 30));
+  // Scanner 2's window is over, scanner 1's is not
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 600));
+  EXPECT_EQ(1u, filters.GetSuppressedCount());
+
+  // An unregistered scanner no longer takes part
+  filters.AddScanner(3);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 610));
+  filters.RemoveScanner(3);
+  EXPECT_FALSE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 620));
+}
+
+TEST(BtifScannerFiltersTest, zero_window_removes_filter) {
+  BtifScannerFilters filters(10);
+  filters.AddScanner(1);
+  filters.SetFilter(1, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 0));
+  EXPECT_FALSE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 10));
+  filters.SetFilter(1, 0, kRssiThreshold);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 20));
+  // Unregistered scanners can't set a filter
+  filters.SetFilter(2, kWindowMs, kRssiThreshold);
+  EXPECT_TRUE(filters.ShouldReport(kAddr1, kEvtType, -60, kData1, 30));
+}
+
+}  // namespace
@@ -36,6 +36,7 @@ bool AddressObfuscator::IsSaltValid(const Octet32& salt_256bit) {
 void AddressObfuscator::Initialize(const Octet32& salt_256bit) {
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
   salt_256bit_ = salt_256bit;
+  obfuscated_cache_.Clear();
 }
 
 bool AddressObfuscator::IsInitialized() {
@@ -46,13 +47,19 @@ bool AddressObfuscator::IsInitialized() {
 std::string AddressObfuscator::Obfuscate(const RawAddress& address) {
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
   CHECK(IsInitialized());
+  std::string obfuscated;
+  if (obfuscated_cache_.Get(address, &obfuscated)) {
+    return obfuscated;
+  }
   std::array<uint8_t, EVP_MAX_MD_SIZE> result = {};
   unsigned int out_len = 0;
   CHECK(::HMAC(EVP_sha256(), salt_256bit_.data(), salt_256bit_.size(),
                address.address, address.kLength, result.data(),
                &out_len) != nullptr);
   CHECK_EQ(out_len, static_cast<unsigned int>(kOctet32Length));
-  return std::string(reinterpret_cast<const char*>(result.data()), out_len);
+  obfuscated.assign(reinterpret_cast<const char*>(result.data()), out_len);
+  obfuscated_cache_.Put(address, obfuscated);
+  return obfuscated;
 }
 
 }  // namespace common
@@ -22,6 +22,7 @@
 #include <mutex>
 #include <string>
 
+#include "lru.h"
 #include "raw_address.h"
 
 namespace bluetooth {
@@ -30,6 +31,7 @@ namespace common {
 class AddressObfuscator {
  public:
   static constexpr unsigned int kOctet32Length = 32;
+  static constexpr size_t kMaxNumCachedAddresses = 16;
   using Octet32 = std::array<uint8_t, kOctet32Length>;
   static AddressObfuscator* GetInstance() {
     static auto instance = new AddressObfuscator();
@@ -49,6 +51,8 @@ class AddressObfuscator {
   /**
    * Initialize this obfuscator with necessary parameters
    *
+   * Drops the addresses obfuscated with the previous salt
+   *
    * @param salt_256bit a 256 bit salt used to hash the fixed length address
    */
   void Initialize(const Octet32& salt_256bit);
@@ -61,14 +65,20 @@ class AddressObfuscator {
   /**
    * Obfuscate Bluetooth MAC address into an anonymous ID string
    *
+   * The result for the kMaxNumCachedAddresses most recently obfuscated
+   * addresses is cached, the same few connected devices are logged repeatedly
+   *
    * @param address Bluetooth MAC address to be obfuscated
    * @return the obfuscated MAC address in 256 bit
    */
   std::string Obfuscate(const RawAddress& address);
 
  private:
-  AddressObfuscator() : salt_256bit_({0}) {}
+  AddressObfuscator()
+      : salt_256bit_({0}),
+        obfuscated_cache_(kMaxNumCachedAddresses, "AddressObfuscator") {}
   Octet32 salt_256bit_;
+  LegacyLruCache<RawAddress, std::string> obfuscated_cache_;
   std::recursive_mutex instance_mutex_;
 };
 
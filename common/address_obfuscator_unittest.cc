@@ -117,4 +117,23 @@ TEST(AddressObfuscatorTest, test_obfuscate_address_key2_max_address) {
       AddressObfuscator::GetInstance()->Obfuscate(kTestData2_3);
   EXPECT_EQ(result.size(), AddressObfuscator::kOctet32Length);
   EXPECT_EQ(result, kTestResult2_3);
-}
\ No newline at end of file
+}
+TEST(AddressObfuscatorTest, test_obfuscate_address_cached) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey2);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_1),
+              kTestResult2_1);
+    EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData2_3),
+              kTestResult2_3);
+  }
+}
+
+TEST(AddressObfuscatorTest, test_obfuscate_address_salt_rotation) {
+  AddressObfuscator::GetInstance()->Initialize(kTestKey2);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData1),
+            AddressObfuscator::GetInstance()->Obfuscate(kTestData1));
+  // The address obfuscated with the previous salt must not be served again
+  AddressObfuscator::GetInstance()->Initialize(kTestKey1);
+  EXPECT_EQ(AddressObfuscator::GetInstance()->Obfuscate(kTestData1),
+            kTestResult1);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+
+#include "common/leaky_bonded_queue.h"
+#include "common/lock_free_leaky_bonded_queue.h"
+
+using ::benchmark::State;
+using bluetooth::common::LeakyBondedQueue;
+using bluetooth::common::LockFreeLeakyBondedQueue;
+
+#define NUM_ITEMS_TO_SEND 100000
+#define QUEUE_CAPACITY 16
+
+struct Item {
+  int index;
+};
+
+// LeakyBondedQueue::Dequeue() requires a non empty queue
+template <class Queue>
+bool HasItems(Queue& queue) {
+  return !queue.Empty();
+}
+
+/*
+ * One producer enqueues NUM_ITEMS_TO_SEND items while a consumer thread
+ * drains the queue, as the media path does between the encoder and the
+ * transmit threads.
+ */
+template <class Queue>
+void BM_ProducerConsumer(State& state) {
+  for (auto _ : state) {
+    Queue queue(QUEUE_CAPACITY);
+    std::atomic<bool> done(false);
+    std::thread consumer([&] {
+      for (;;) {
+        if (HasItems(queue)) {
+          delete queue.Dequeue();
+        } else if (done) {
+          break;
+        }
+      }
+    });
+    for (int i = 0; i < NUM_ITEMS_TO_SEND; i++) {
+      queue.Enqueue(new Item{i});
+    }
+    done = true;
+    consumer.join();
+    queue.Clear();
+  }
+  state.SetItemsProcessed(state.iterations() * NUM_ITEMS_TO_SEND);
+}
+
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, LeakyBondedQueue<Item>)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, LockFreeLeakyBondedQueue<Item>)
+    ->UseRealTime();
+
+/* Uncontended enqueue and dequeue, the cost when the threads do not collide */
+template <class Queue>
+void BM_EnqueueDequeue(State& state) {
+  Queue queue(QUEUE_CAPACITY);
+  for (auto _ : state) {
+    queue.Enqueue(new Item{0});
+    delete queue.Dequeue();
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_EnqueueDequeue, LeakyBondedQueue<Item>);
+BENCHMARK_TEMPLATE(BM_EnqueueDequeue, LockFreeLeakyBondedQueue<Item>);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
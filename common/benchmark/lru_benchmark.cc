@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "common/flat_lru.h"
+#include "common/lru.h"
+
+using ::benchmark::State;
+using bluetooth::common::FlatLruCache;
+using bluetooth::common::LegacyLruCache;
+
+// Capacity of the btif config cache for unpaired devices
+#define CACHE_CAPACITY 10000
+// Distinct devices seen during a long discovery or scan
+#define NUM_DEVICES (4 * CACHE_CAPACITY)
+
+static std::vector<std::string> MakeAddresses() {
+  std::vector<std::string> addresses;
+  addresses.reserve(NUM_DEVICES);
+  for (int i = 0; i < NUM_DEVICES; i++) {
+    char address[18];
+    snprintf(address, sizeof(address), "00:11:22:%02x:%02x:%02x",
+             (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff);
+    addresses.emplace_back(address);
+  }
+  return addresses;
+}
+
+/*
+ * A new device is inserted for every iteration, evicting the oldest one once
+ * the cache is full, as when inquiry or scan results keep coming in.
+ */
+template <class Cache>
+void BM_PutNewDevices(State& state) {
+  static const std::vector<std::string> addresses = MakeAddresses();
+  Cache cache(CACHE_CAPACITY, "benchmark");
+  size_t i = 0;
+  for (auto _ : state) {
+    cache.Put(addresses[i], static_cast<int>(i));
+    if (++i == addresses.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_PutNewDevices, LegacyLruCache<std::string, int>);
+BENCHMARK_TEMPLATE(BM_PutNewDevices, FlatLruCache<std::string, int>);
+
+/*
+ * Properties of devices already in the cache are looked up and updated, as
+ * for every inquiry result or advertising report of a known device.
+ */
+template <class Cache>
+void BM_FindDevices(State& state) {
+  static const std::vector<std::string> addresses = MakeAddresses();
+  Cache cache(CACHE_CAPACITY, "benchmark");
+  for (int i = 0; i < CACHE_CAPACITY; i++) cache.Put(addresses[i], i);
+  size_t i = 0;
+  for (auto _ : state) {
+    int* value = cache.Find(addresses[i]);
+    benchmark::DoNotOptimize(value);
+    (*value)++;
+    i = (i + 7919) % CACHE_CAPACITY;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_FindDevices, LegacyLruCache<std::string, int>);
+BENCHMARK_TEMPLATE(BM_FindDevices, FlatLruCache<std::string, int>);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -19,6 +19,7 @@
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
 #include <future>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/once_timer.h"
@@ -267,6 +268,54 @@ BENCHMARK_REGISTER_F(BM_AlarmTaskPeriodicTimer, periodic_accuracy)
     ->Iterations(1)
     ->UseRealTime();
 
+// Sets and cancels alarms while |state.range(0)| other alarms are pending,
+// which is where the sorted list backend of osi alarm pays O(n) per insert.
+// Run once with persist.bluetooth.alarm_timer_wheel set to false and once
+// with it set to true to compare the two backends.
+class BM_OsiConcurrentAlarms : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    auto count = static_cast<int>(st.range(0));
+    for (int i = 0; i < count; i++) {
+      alarm_t* alarm = alarm_new("osi_concurrent_alarm_test");
+      // Spread the pending alarms between one and two hours out so that none
+      // of them fires while the benchmark is running.
+      alarm_set(alarm, 3600000 + (i * 3600000LL) / count, &TimerFire,
+                nullptr);
+      pending_alarms_.push_back(alarm);
+    }
+    alarm_ = alarm_new("osi_concurrent_alarm_test");
+  }
+
+  void TearDown(State& st) override {
+    alarm_free(alarm_);
+    for (alarm_t* alarm : pending_alarms_) alarm_free(alarm);
+    pending_alarms_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<alarm_t*> pending_alarms_;
+  alarm_t* alarm_ = nullptr;
+};
+
+BENCHMARK_DEFINE_F(BM_OsiConcurrentAlarms, set_cancel)(State& state) {
+  uint64_t interval_ms = 1000;
+  for (auto _ : state) {
+    // Vary the deadline so it lands at different positions among the
+    // pending alarms.
+    interval_ms = (interval_ms * 7919) % 7200000 + 1;
+    alarm_set(alarm_, interval_ms, &TimerFire, nullptr);
+    alarm_cancel(alarm_);
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_OsiConcurrentAlarms, set_cancel)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000);
+
 int main(int argc, char** argv) {
   // Disable LOG() output from libchrome
   logging::LoggingSettings log_settings;
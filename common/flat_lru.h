@@ -0,0 +1,287 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/logging.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/*
+ *   FlatLruCache<K, V>
+ *
+ * - Same interface and eviction order as LegacyLruCache<K, V>.
+ * - All storage is allocated by the constructor: entries live in a fixed
+ *   array of slots chained from most to least recently used by index, and
+ *   are looked up in an open addressing table of slot indexes. Put() and
+ *   Remove() never allocate besides what K and V themselves do.
+ * - NOT THREAD SAFE, callers serialize accesses with the lock that already
+ *   protects the data they cache.
+ * - Pointers returned by Find() stay valid until the key is removed or
+ *   evicted.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class FlatLruCache {
+ public:
+  using Node = std::pair<K, V>;
+
+  /**
+   * Constructor of the cache
+   *
+   * @param capacity maximum size of the cache
+   * @param log_tag, keyword to put at the head of log.
+   */
+  FlatLruCache(const size_t& capacity, const std::string& log_tag)
+      : capacity_(capacity), slots_(capacity) {
+    if (capacity_ == 0 || capacity_ >= kNil) {
+      // don't allow invalid capacity
+      LOG(FATAL) << log_tag << " unable to have " << capacity_
+                 << " LRU Cache capacity";
+    }
+    // Keep the table at most half full so that probe sequences stay short
+    size_t table_size = 1;
+    while (table_size < 2 * capacity_) table_size <<= 1;
+    table_.resize(table_size);
+    mask_ = table_size - 1;
+    Clear();
+  }
+
+  FlatLruCache(FlatLruCache const&) = delete;
+  FlatLruCache& operator=(FlatLruCache const&) = delete;
+
+  /**
+   * Clear the cache
+   */
+  void Clear() {
+    for (uint32_t i = 0; i < capacity_; i++) {
+      slots_[i].node.reset();
+      slots_[i].next = (i + 1 < capacity_) ? i + 1 : kNil;
+    }
+    std::fill(table_.begin(), table_.end(), kNil);
+    free_ = 0;
+    head_ = kNil;
+    tail_ = kNil;
+    size_ = 0;
+  }
+
+  /**
+   * Same as Get, but return a pointer to the accessed element
+   *
+   * @param key
+   * @return pointer to the underlying value to allow in-place modification
+   * nullptr when not found, will be invalidated when the key is evicted
+   */
+  V* Find(const K& key) {
+    size_t pos;
+    if (!Lookup(key, Hash()(key), &pos)) {
+      return nullptr;
+    }
+    uint32_t slot = table_[pos];
+    Unlink(slot);
+    LinkFront(slot);
+    return &slots_[slot].node->second;
+  }
+
+  /**
+   * Get the value of a key, and move the key to the head of cache, if there is
+   * one
+   *
+   * @param key
+   * @param value, output parameter of value of the key
+   * @return true if the cache has the key
+   */
+  bool Get(const K& key, V* value) {
+    CHECK(value != nullptr);
+    V* value_ptr = Find(key);
+    if (value_ptr == nullptr) {
+      return false;
+    }
+    *value = *value_ptr;
+    return true;
+  }
+
+  /**
+   * Check if the cache has the input key, move the key to the head
+   * if there is one
+   *
+   * @param key
+   * @return true if the cache has the key
+   */
+  bool HasKey(const K& key) { return Find(key) != nullptr; }
+
+  /**
+   * Put a key-value pair to the head of cache
+   *
+   * @param key
+   * @param value
+   * @return evicted node if tail value is popped, std::nullopt if no value
+   * is popped. std::optional can be treated as a boolean as well
+   */
+  std::optional<Node> Put(const K& key, V value) {
+    V* value_ptr = Find(key);
+    if (value_ptr != nullptr) {
+      *value_ptr = std::move(value);
+      return std::nullopt;
+    }
+
+    std::optional<Node> ret = std::nullopt;
+    if (size_ == capacity_) {
+      uint32_t slot = tail_;
+      ret = std::move(*slots_[slot].node);
+      Erase(slot);
+    }
+
+    size_t hash = Hash()(key);
+    size_t pos;
+    Lookup(key, hash, &pos);
+    uint32_t slot = free_;
+    free_ = slots_[slot].next;
+    slots_[slot].node.emplace(key, std::move(value));
+    slots_[slot].hash = hash;
+    LinkFront(slot);
+    table_[pos] = slot;
+    size_++;
+    return ret;
+  }
+
+  /**
+   * Delete a key from cache
+   *
+   * @param key
+   * @return true if deleted successfully
+   */
+  bool Remove(const K& key) {
+    size_t pos;
+    if (!Lookup(key, Hash()(key), &pos)) {
+      return false;
+    }
+    Erase(table_[pos]);
+    return true;
+  }
+
+  /**
+   * Return size of the cache
+   *
+   * @return size of the cache
+   */
+  int Size() const { return size_; }
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  struct Slot {
+    std::optional<Node> node;
+    size_t hash = 0;
+    // Links of the recency list, next is also the link of the free list
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+  };
+
+  // Returns true and the table position of |key| if present, false and the
+  // position it would be inserted at otherwise
+  bool Lookup(const K& key, size_t hash, size_t* pos) const {
+    size_t i = hash & mask_;
+    while (table_[i] != kNil) {
+      const Slot& slot = slots_[table_[i]];
+      if (slot.hash == hash && slot.node->first == key) {
+        *pos = i;
+        return true;
+      }
+      i = (i + 1) & mask_;
+    }
+    *pos = i;
+    return false;
+  }
+
+  // Removes |slot| from the table, the recency list, and frees it
+  void Erase(uint32_t slot) {
+    size_t i = slots_[slot].hash & mask_;
+    while (table_[i] != slot) i = (i + 1) & mask_;
+
+    // Shift back the entries that probed past the freed position, so that
+    // lookups never need tombstones
+    size_t j = i;
+    for (;;) {
+      j = (j + 1) & mask_;
+      if (table_[j] == kNil) break;
+      size_t home = slots_[table_[j]].hash & mask_;
+      if (((j - home) & mask_) >= ((j - i) & mask_)) {
+        table_[i] = table_[j];
+        i = j;
+      }
+    }
+    table_[i] = kNil;
+
+    Unlink(slot);
+    slots_[slot].node.reset();
+    slots_[slot].next = free_;
+    free_ = slot;
+    size_--;
+  }
+
+  void Unlink(uint32_t slot) {
+    Slot& s = slots_[slot];
+    if (s.prev != kNil) {
+      slots_[s.prev].next = s.next;
+    } else {
+      head_ = s.next;
+    }
+    if (s.next != kNil) {
+      slots_[s.next].prev = s.prev;
+    } else {
+      tail_ = s.prev;
+    }
+    s.prev = kNil;
+    s.next = kNil;
+  }
+
+  void LinkFront(uint32_t slot) {
+    Slot& s = slots_[slot];
+    s.prev = kNil;
+    s.next = head_;
+    if (head_ != kNil) {
+      slots_[head_].prev = slot;
+    } else {
+      tail_ = slot;
+    }
+    head_ = slot;
+  }
+
+  size_t capacity_;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> table_;
+  size_t mask_ = 0;
+  uint32_t free_ = kNil;  // first free slot, chained through Slot::next
+  uint32_t head_ = kNil;  // most recently used
+  uint32_t tail_ = kNil;  // least recently used
+  size_t size_ = 0;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+#include "common/flat_lru.h"
+#include "common/lru.h"
+
+namespace testing {
+
+using bluetooth::common::FlatLruCache;
+using bluetooth::common::LegacyLruCache;
+
+TEST(BluetoothFlatLruCacheTest, FlatLruCacheMainTest) {
+  int value = 0;
+  FlatLruCache<int, int> cache(3, "testing");
+  EXPECT_FALSE(cache.Put(1, 10));
+  EXPECT_FALSE(cache.Put(2, 20));
+  EXPECT_FALSE(cache.Put(3, 30));
+  EXPECT_EQ(cache.Size(), 3);
+
+  // 1 becomes the most recently used, 2 is evicted next
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_EQ(value, 10);
+  EXPECT_THAT(cache.Put(4, 40), Optional(Pair(2, 20)));
+  EXPECT_FALSE(cache.HasKey(2));
+  EXPECT_EQ(cache.Size(), 3);
+
+  // Updating a key warms it up without evicting anything
+  EXPECT_FALSE(cache.Put(3, 31));
+  EXPECT_THAT(cache.Put(5, 50), Optional(Pair(1, 10)));
+  EXPECT_TRUE(cache.Get(3, &value));
+  EXPECT_EQ(value, 31);
+}
+
+TEST(BluetoothFlatLruCacheTest, FlatLruCacheFindRemoveClearTest) {
+  FlatLruCache<std::string, std::string> cache(2, "testing");
+  EXPECT_EQ(cache.Find("a"), nullptr);
+  cache.Put("a", "1");
+  std::string* value = cache.Find("a");
+  ASSERT_NE(value, nullptr);
+  *value = "2";
+  EXPECT_EQ(*cache.Find("a"), "2");
+
+  EXPECT_FALSE(cache.Remove("b"));
+  EXPECT_TRUE(cache.Remove("a"));
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Find("a"), nullptr);
+
+  cache.Put("a", "1");
+  cache.Put("b", "2");
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_FALSE(cache.HasKey("a"));
+  EXPECT_FALSE(cache.Put("c", "3"));
+  EXPECT_FALSE(cache.Put("d", "4"));
+  EXPECT_THAT(cache.Put("e", "5"), Optional(Pair("c", "3")));
+}
+
+// Colliding hashes exercise the probing and the shifts done by removals
+struct BadHash {
+  size_t operator()(int key) const { return key % 4; }
+};
+
+TEST(BluetoothFlatLruCacheTest, FlatLruCacheMatchesLegacyLruCacheTest) {
+  for (size_t capacity : {1, 3, 16, 100}) {
+    FlatLruCache<int, int> flat(capacity, "testing");
+    FlatLruCache<int, int, BadHash> colliding(capacity, "testing");
+    LegacyLruCache<int, int> legacy(capacity, "testing");
+    std::mt19937 rng(capacity);
+
+    for (int i = 0; i < 20000; i++) {
+      int key = rng() % (3 * capacity);
+      int op = rng() % 4;
+      if (op == 0) {
+        bool removed = legacy.Remove(key);
+        ASSERT_EQ(flat.Remove(key), removed);
+        ASSERT_EQ(colliding.Remove(key), removed);
+      } else if (op == 1) {
+        int expected = -1, actual = -1, actual_colliding = -1;
+        bool found = legacy.Get(key, &expected);
+        ASSERT_EQ(flat.Get(key, &actual), found);
+        ASSERT_EQ(colliding.Get(key, &actual_colliding), found);
+        ASSERT_EQ(actual, expected);
+        ASSERT_EQ(actual_colliding, expected);
+      } else {
+        auto evicted = legacy.Put(key, i);
+        ASSERT_EQ(flat.Put(key, i), evicted);
+        ASSERT_EQ(colliding.Put(key, i), evicted);
+      }
+      ASSERT_EQ(flat.Size(), legacy.Size());
+      ASSERT_EQ(colliding.Size(), legacy.Size());
+    }
+  }
+}
+
+}  // namespace testing
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <base/logging.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace bluetooth {
+
+namespace common {
+
+/*
+ *   LockFreeLeakyBondedQueue<T>
+ *
+ * - Same semantics as LeakyBondedQueue<T>: a fixed size queue of owned items
+ *   that leaks the oldest item when reaching its capacity.
+ * - Items live in a ring indexed by ever increasing head and tail counters.
+ *   The producer publishes an item by advancing tail; an item is taken, by a
+ *   consumer or by the producer evicting the oldest one, by winning the
+ *   compare-and-swap that advances head past it. No thread ever blocks, so a
+ *   real-time consumer cannot be held up by a descheduled producer.
+ * - Enqueue() and EnqueueWithPop() must only be called from a single producer
+ *   thread. Dequeue() and Clear() may be called from any thread.
+ *
+ */
+template <class T>
+class LockFreeLeakyBondedQueue {
+ public:
+  LockFreeLeakyBondedQueue(size_t capacity);
+  /* Default destructor
+   *
+   * Call Clear() and free the queue structure itself
+   */
+  ~LockFreeLeakyBondedQueue();
+  /*
+   * Add item NEW_ITEM to the underlining queue. If the queue is full, pop
+   * the oldest item
+   */
+  void Enqueue(T* new_item);
+  /*
+   * Add item NEW_ITEM to the underlining queue. If the queue is full, dequeue
+   * the oldest item and returns it to the caller. Return nullptr otherwise.
+   */
+  T* EnqueueWithPop(T* new_item);
+  /*
+   * Dequeues the oldest item from the queue. Return nullptr if queue is empty
+   */
+  T* Dequeue();
+  /*
+   * Returns the length of queue
+   */
+  size_t Length();
+  /*
+   * Returns the defined capacity of the queue
+   */
+  size_t Capacity();
+  /*
+   * Returns whether the queue is empty
+   */
+  bool Empty();
+  /*
+   * Pops all items from the queue
+   */
+  void Clear();
+
+ private:
+  std::atomic<T*>& Slot(uint64_t position) {
+    return slots_[position % capacity_];
+  }
+
+  std::unique_ptr<std::atomic<T*>[]> slots_;
+  size_t capacity_;
+  // Position of the oldest item, advanced by whoever takes it
+  std::atomic<uint64_t> head_;
+  // Position the next item is written at, only advanced by the producer
+  std::atomic<uint64_t> tail_;
+};
+
+/*
+ * Definitions must be in the header for template classes
+ */
+
+template <class T>
+LockFreeLeakyBondedQueue<T>::LockFreeLeakyBondedQueue(size_t capacity)
+    : slots_(new std::atomic<T*>[capacity]),
+      capacity_(capacity),
+      head_(0),
+      tail_(0) {
+  // A full queue evicts from the slot it writes to, which needs one
+  CHECK(capacity_ > 0);
+  for (size_t i = 0; i < capacity_; i++) slots_[i].store(nullptr);
+}
+
+template <class T>
+LockFreeLeakyBondedQueue<T>::~LockFreeLeakyBondedQueue() {
+  Clear();
+}
+
+template <class T>
+void LockFreeLeakyBondedQueue<T>::Enqueue(T* new_item) {
+  delete EnqueueWithPop(new_item);
+}
+
+template <class T>
+T* LockFreeLeakyBondedQueue<T>::EnqueueWithPop(T* new_item) {
+  T* old_item = nullptr;
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  uint64_t head = head_.load(std::memory_order_acquire);
+  while (tail - head >= capacity_) {
+    // Full: take the oldest item unless a consumer takes it first
+    T* item = Slot(head).load(std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      old_item = item;
+      break;
+    }
+  }
+  Slot(tail).store(new_item, std::memory_order_relaxed);
+  tail_.store(tail + 1, std::memory_order_release);
+  return old_item;
+}
+
+template <class T>
+T* LockFreeLeakyBondedQueue<T>::Dequeue() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  for (;;) {
+    if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+    // The slot is only reused once head has moved past it, which makes the
+    // exchange below fail if the value read here is stale
+    T* item = Slot(head).load(std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      return item;
+    }
+  }
+}
+
+template <class T>
+void LockFreeLeakyBondedQueue<T>::Clear() {
+  T* item;
+  while ((item = Dequeue()) != nullptr) {
+    delete item;
+  }
+}
+
+template <class T>
+size_t LockFreeLeakyBondedQueue<T>::Length() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t tail = tail_.load(std::memory_order_acquire);
+  return tail > head ? tail - head : 0;
+}
+
+template <class T>
+size_t LockFreeLeakyBondedQueue<T>::Capacity() {
+  return capacity_;
+}
+
+template <class T>
+bool LockFreeLeakyBondedQueue<T>::Empty() {
+  return Length() == 0;
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
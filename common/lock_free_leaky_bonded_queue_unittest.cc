@@ -0,0 +1,143 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/lock_free_leaky_bonded_queue.h"
+
+namespace testing {
+
+using bluetooth::common::LockFreeLeakyBondedQueue;
+
+class CountedItem {
+ public:
+  CountedItem(int index, std::atomic<int>* destroyed)
+      : index(index), destroyed_(destroyed) {}
+  ~CountedItem() { (*destroyed_)++; }
+  int index;
+
+ private:
+  std::atomic<int>* destroyed_;
+};
+
+TEST(LockFreeLeakyBondedQueueTest, TestZeroCapacity) {
+  EXPECT_DEATH(LockFreeLeakyBondedQueue<CountedItem> queue(0), "");
+}
+
+TEST(LockFreeLeakyBondedQueueTest, TestEnqueueDequeue) {
+  std::atomic<int> destroyed(0);
+  LockFreeLeakyBondedQueue<CountedItem> queue(3);
+  EXPECT_EQ(queue.Capacity(), static_cast<size_t>(3));
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.Dequeue(), nullptr);
+
+  for (int i = 1; i <= 4; i++) {
+    queue.Enqueue(new CountedItem(i, &destroyed));
+    EXPECT_EQ(queue.Length(), static_cast<size_t>(std::min(i, 3)));
+  }
+  // The oldest item leaked when the fourth one was added
+  EXPECT_EQ(destroyed, 1);
+
+  for (int i = 2; i <= 4; i++) {
+    CountedItem* item = queue.Dequeue();
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(item->index, i);
+    delete item;
+  }
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.Dequeue(), nullptr);
+  EXPECT_EQ(destroyed, 4);
+}
+
+TEST(LockFreeLeakyBondedQueueTest, TestEnqueuePop) {
+  std::atomic<int> destroyed(0);
+  LockFreeLeakyBondedQueue<CountedItem> queue(2);
+  EXPECT_EQ(queue.EnqueueWithPop(new CountedItem(1, &destroyed)), nullptr);
+  EXPECT_EQ(queue.EnqueueWithPop(new CountedItem(2, &destroyed)), nullptr);
+
+  CountedItem* popped = queue.EnqueueWithPop(new CountedItem(3, &destroyed));
+  ASSERT_NE(popped, nullptr);
+  EXPECT_EQ(popped->index, 1);
+  EXPECT_EQ(destroyed, 0);
+  delete popped;
+
+  CountedItem* item = queue.Dequeue();
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->index, 2);
+  delete item;
+  EXPECT_EQ(queue.Length(), static_cast<size_t>(1));
+}
+
+TEST(LockFreeLeakyBondedQueueTest, TestQueueClearAndFree) {
+  std::atomic<int> destroyed(0);
+  {
+    LockFreeLeakyBondedQueue<CountedItem> queue(4);
+    for (int i = 0; i < 3; i++) queue.Enqueue(new CountedItem(i, &destroyed));
+    queue.Clear();
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(destroyed, 3);
+
+    for (int i = 0; i < 6; i++) queue.Enqueue(new CountedItem(i, &destroyed));
+    EXPECT_EQ(destroyed, 5);
+  }
+  EXPECT_EQ(destroyed, 9);
+}
+
+TEST(LockFreeLeakyBondedQueueTest, TestConcurrentProducerConsumers) {
+  constexpr int kItems = 200000;
+  constexpr int kConsumers = 2;
+  std::atomic<int> destroyed(0);
+  std::atomic<bool> done(false);
+  std::atomic<int> consumed(0);
+  LockFreeLeakyBondedQueue<CountedItem> queue(8);
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; c++) {
+    consumers.emplace_back([&] {
+      int last = -1;
+      for (;;) {
+        CountedItem* item = queue.Dequeue();
+        if (item == nullptr) {
+          if (done) break;
+          continue;
+        }
+        // Each consumer sees items in the order they were produced
+        EXPECT_GT(item->index, last);
+        last = item->index;
+        consumed++;
+        delete item;
+      }
+    });
+  }
+
+  for (int i = 0; i < kItems; i++) {
+    queue.Enqueue(new CountedItem(i, &destroyed));
+  }
+  done = true;
+  for (auto& consumer : consumers) consumer.join();
+  queue.Clear();
+
+  // Every item was either consumed or leaked, and freed exactly once
+  EXPECT_EQ(destroyed, kItems);
+  EXPECT_LE(consumed, kItems);
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace testing
@@ -16,8 +16,10 @@
 
 #include "message_loop_thread.h"
 
+#include <sched.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <algorithm>
 #include <thread>
 
 #include <base/strings/stringprintf.h>
@@ -45,7 +47,8 @@ MessageLoopThread::MessageLoopThread(const std::string& thread_name,
       weak_ptr_factory_(this),
       shutting_down_(false),
       is_main_(is_main),
-      rust_thread_(nullptr) {}
+      rust_thread_(nullptr),
+      task_latency_stats_(thread_name) {}
 
 MessageLoopThread::~MessageLoopThread() { ShutDown(); }
 
@@ -80,10 +83,93 @@ bool MessageLoopThread::DoInThread(const base::Location& from_here,
   return DoInThreadDelayed(from_here, std::move(task), base::TimeDelta());
 }
 
+bool MessageLoopThread::DoInThread(const base::Location& from_here,
+                                   InlineClosure task) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if ((is_main_ && init_flags::gd_rust_is_enabled()) ||
+      message_loop_ == nullptr) {
+    return DoInThreadDelayed(
+        from_here,
+        base::BindOnce([](InlineClosure task) { std::move(task).Run(); },
+                       std::move(task)),
+        base::TimeDelta());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+    inline_tasks_.push_back(
+        {std::move(task), from_here, base::TimeTicks::Now()});
+    if (inline_batch_open_) {
+      inline_batches_.back()++;
+      return true;
+    }
+    inline_batches_.push_back(1);
+    inline_batch_open_ = true;
+  }
+  if (!message_loop_->task_runner()->PostTask(
+          from_here, base::BindOnce(&MessageLoopThread::RunInlineTasks,
+                                    base::Unretained(this)))) {
+    LOG(ERROR) << __func__
+               << ": failed to post task to message loop for thread " << *this
+               << ", from " << from_here.ToString();
+    std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+    inline_tasks_.pop_back();
+    inline_batches_.pop_back();
+    inline_batch_open_ = false;
+    return false;
+  }
+  return true;
+}
+
+bool MessageLoopThread::DoInThread(const base::Location& from_here,
+                                   base::OnceClosure task, Priority priority) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (priority == Priority::kNormal ||
+      (is_main_ && init_flags::gd_rust_is_enabled()) ||
+      message_loop_ == nullptr) {
+    return DoInThread(from_here, std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(high_priority_tasks_mutex_);
+    high_priority_tasks_.push_back(
+        {std::move(task), from_here, base::TimeTicks::Now()});
+    high_priority_tasks_pending_++;
+  }
+  // Runs the task at its place in the message loop, unless a normal task
+  // ran it ahead
+  if (!message_loop_->task_runner()->PostTask(
+          from_here, base::BindOnce(
+                         base::IgnoreResult(
+                             &MessageLoopThread::RunHighPriorityTask),
+                         base::Unretained(this)))) {
+    LOG(ERROR) << __func__
+               << ": failed to post task to message loop for thread " << *this
+               << ", from " << from_here.ToString();
+    // Posts are serialized by api_mutex_, the task is the last one queued
+    // unless it already ran
+    std::lock_guard<std::mutex> lock(high_priority_tasks_mutex_);
+    if (!high_priority_tasks_.empty()) {
+      high_priority_tasks_.pop_back();
+      high_priority_tasks_pending_--;
+    }
+    return false;
+  }
+  return true;
+}
+
 bool MessageLoopThread::DoInThreadDelayed(const base::Location& from_here,
                                           base::OnceClosure task,
                                           const base::TimeDelta& delay) {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+  if (delay.is_zero()) {
+    // Inline tasks posted after this one must not run before it
+    std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+    inline_batch_open_ = false;
+  }
+  task = base::BindOnce(&MessageLoopThread::RunTask, base::Unretained(this),
+                        from_here, base::TimeTicks::Now() + delay,
+                        std::move(task));
   if (is_main_ && init_flags::gd_rust_is_enabled()) {
     if (rust_thread_ == nullptr) {
       LOG(ERROR) << __func__ << ": rust thread is null for thread " << *this
@@ -189,6 +275,10 @@ btbase::AbstractMessageLoop* MessageLoopThread::message_loop() const {
 }
 
 bool MessageLoopThread::EnableRealTimeScheduling() {
+  return EnableRealTimeScheduling(kRealTimeFifoSchedulingPriority);
+}
+
+bool MessageLoopThread::EnableRealTimeScheduling(int priority) {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
 
   if (!IsRunning()) {
@@ -196,12 +286,34 @@ bool MessageLoopThread::EnableRealTimeScheduling() {
     return false;
   }
 
-  struct sched_param rt_params = {.sched_priority =
-                                      kRealTimeFifoSchedulingPriority};
+  struct sched_param rt_params = {.sched_priority = priority};
   int rc = sched_setscheduler(linux_tid_, SCHED_FIFO, &rt_params);
   if (rc != 0) {
     LOG(ERROR) << __func__ << ": unable to set SCHED_FIFO priority "
-               << kRealTimeFifoSchedulingPriority << " for linux_tid "
+               << priority << " for linux_tid " << std::to_string(linux_tid_)
+               << ", thread " << *this << ", error: " << strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+bool MessageLoopThread::SetCpuAffinity(uint64_t cpu_mask) {
+  std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
+
+  if (!IsRunning()) {
+    LOG(ERROR) << __func__ << ": thread " << *this << " is not running";
+    return false;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+    if (cpu_mask & (UINT64_C(1) << cpu)) CPU_SET(cpu, &cpu_set);
+  }
+  int rc = sched_setaffinity(linux_tid_, sizeof(cpu_set), &cpu_set);
+  if (rc != 0) {
+    LOG(ERROR) << __func__ << ": unable to set CPU affinity 0x" << std::hex
+               << cpu_mask << std::dec << " for linux_tid "
                << std::to_string(linux_tid_) << ", thread " << *this
                << ", error: " << strerror(errno);
     return false;
@@ -242,11 +354,97 @@ void MessageLoopThread::Run(std::promise<void> start_up_promise) {
     message_loop_ = nullptr;
     delete run_loop_;
     run_loop_ = nullptr;
+    std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+    inline_tasks_.clear();
+    inline_batches_.clear();
+    inline_batch_open_ = false;
+    std::lock_guard<std::mutex> high_lock(high_priority_tasks_mutex_);
+    high_priority_tasks_.clear();
+    high_priority_tasks_pending_ = 0;
     LOG(INFO) << __func__ << ": message loop finished for thread "
               << thread_name_;
   }
 }
 
+void MessageLoopThread::RunInlineTasks() {
+  size_t count;
+  {
+    std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+    if (inline_batches_.empty()) {
+      return;
+    }
+    count = inline_batches_.front();
+    inline_batches_.pop_front();
+    if (inline_batches_.empty()) {
+      inline_batch_open_ = false;
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    InlineClosure task;
+    base::Location from_here;
+    base::TimeTicks due_time;
+    {
+      std::lock_guard<std::mutex> lock(inline_tasks_mutex_);
+      InlineTask& front = inline_tasks_.front();
+      task = std::move(front.task);
+      from_here = front.from_here;
+      due_time = front.due_time;
+      inline_tasks_.pop_front();
+    }
+    RunHighPriorityTasksAhead();
+    base::TimeTicks start_time = base::TimeTicks::Now();
+    std::move(task).Run();
+    RecordTask(from_here, due_time, start_time);
+  }
+}
+
+void MessageLoopThread::RunTask(const base::Location& from_here,
+                                base::TimeTicks due_time,
+                                base::OnceClosure task) {
+  RunHighPriorityTasksAhead();
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  std::move(task).Run();
+  RecordTask(from_here, due_time, start_time);
+}
+
+bool MessageLoopThread::RunHighPriorityTask() {
+  HighPriorityTask task;
+  {
+    std::lock_guard<std::mutex> lock(high_priority_tasks_mutex_);
+    if (high_priority_tasks_.empty()) {
+      return false;
+    }
+    task = std::move(high_priority_tasks_.front());
+    high_priority_tasks_.pop_front();
+    high_priority_tasks_pending_--;
+  }
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  std::move(task.task).Run();
+  RecordTask(task.from_here, task.due_time, start_time);
+  return true;
+}
+
+void MessageLoopThread::RunHighPriorityTasksAhead() {
+  // The high lane tasks left past the burst run at their own place in the
+  // message loop
+  size_t burst = 0;
+  while (burst < kMaxHighPriorityBurst && high_priority_tasks_pending_ > 0 &&
+         RunHighPriorityTask()) {
+    burst++;
+  }
+}
+
+void MessageLoopThread::RecordTask(const base::Location& from_here,
+                                   base::TimeTicks due_time,
+                                   base::TimeTicks start_time) {
+  base::TimeTicks end_time = base::TimeTicks::Now();
+  int64_t queue_delay_us =
+      std::max<int64_t>((start_time - due_time).InMicroseconds(), 0);
+  task_latency_stats_.Record(from_here.file_name(), from_here.line_number(),
+                             from_here.function_name(), queue_delay_us,
+                             (end_time - start_time).InMicroseconds());
+}
+
 }  // namespace common
 
 }  // namespace bluetooth
@@ -17,18 +17,24 @@
 #pragma once
 
 #include <unistd.h>
+#include <atomic>
+#include <deque>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
 #include <base/bind.h>
 #include <base/location.h>
+#include <base/time/time.h>
 #include <base/run_loop.h>
 #include <base/threading/platform_thread.h>
 #include "src/message_loop_thread.rs.h"
 
 #include "abstract_message_loop.h"
+#include "gd/common/inline_closure.h"
+#include "gd/common/task_latency_stats.h"
 
 namespace bluetooth {
 
@@ -39,6 +45,16 @@ namespace common {
  */
 class MessageLoopThread final {
  public:
+  /**
+   * Lane a task is posted to. Tasks of the high lane run before the normal
+   * tasks already queued, but never more than kMaxHighPriorityBurst of them
+   * back to back ahead of a normal task, so that the normal lane is not
+   * starved. Tasks of a lane run in the order they are posted.
+   */
+  enum class Priority { kNormal, kHigh };
+
+  static constexpr size_t kMaxHighPriorityBurst = 8;
+
   /**
    * Create a message loop thread with name. Thread won't be running until
    * StartUp is called.
@@ -72,6 +88,38 @@ class MessageLoopThread final {
    */
   bool DoInThread(const base::Location& from_here, base::OnceClosure task);
 
+  /**
+   * Post a small lambda to run on this thread without allocating a
+   * base::Callback for it
+   *
+   * Lambdas posted back to back are queued here and run by a single message
+   * loop task, so only the first post of a burst allocates. Tasks keep their
+   * order with respect to each other and to tasks posted with the
+   * base::OnceClosure overload of DoInThread().
+   *
+   * @param from_here location where this task is originated
+   * @param task lambda to run, captures of up to
+   * InlineClosure::kInlineCapacity bytes are kept inline
+   * @return true if task is successfully scheduled, false if task cannot be
+   * scheduled
+   */
+  bool DoInThread(const base::Location& from_here, InlineClosure task);
+
+  /**
+   * Post a task to run on this thread in the lane of |priority|
+   *
+   * Tasks of the high lane may run before tasks posted earlier to the normal
+   * lane, only post there tasks that do not depend on such ordering.
+   *
+   * @param from_here location where this task is originated
+   * @param task task created through base::Bind()
+   * @param priority lane of the task
+   * @return true if task is successfully scheduled, false if task cannot be
+   * scheduled
+   */
+  bool DoInThread(const base::Location& from_here, base::OnceClosure task,
+                  Priority priority);
+
   /**
    * Shutdown the current thread as if it is never started. IsRunning() and
    * DoInThread() will return false after this call. Blocks until the thread is
@@ -123,6 +171,23 @@ class MessageLoopThread final {
    */
   bool EnableRealTimeScheduling();
 
+  /**
+   * Attempt to make scheduling for this thread real time at |priority|
+   *
+   * @param priority SCHED_FIFO priority, within the range reported by
+   * sched_get_priority_min() and sched_get_priority_max()
+   * @return true on success, false otherwise
+   */
+  bool EnableRealTimeScheduling(int priority);
+
+  /**
+   * Attempt to restrict this thread to the CPUs set in |cpu_mask|
+   *
+   * @param cpu_mask bit N set allows the thread to run on CPU N
+   * @return true on success, false otherwise
+   */
+  bool SetCpuAffinity(uint64_t cpu_mask);
+
   /**
    * Return the weak pointer to this object. This can be useful when posting
    * delayed tasks to this MessageLoopThread using Timer.
@@ -187,6 +252,33 @@ class MessageLoopThread final {
    */
   void Run(std::promise<void> start_up_promise);
 
+  /**
+   * Run the oldest batch of tasks posted through DoInThread(InlineClosure)
+   */
+  void RunInlineTasks();
+
+  /**
+   * Run a task posted through DoInThreadDelayed() and record how late it
+   * started and how long it ran
+   */
+  void RunTask(const base::Location& from_here, base::TimeTicks due_time,
+               base::OnceClosure task);
+
+  void RecordTask(const base::Location& from_here, base::TimeTicks due_time,
+                  base::TimeTicks start_time);
+
+  /**
+   * Run the oldest task of the high lane, if any
+   *
+   * @return false if the high lane is empty
+   */
+  bool RunHighPriorityTask();
+
+  /**
+   * Run the high lane tasks that may go ahead of the normal task about to run
+   */
+  void RunHighPriorityTasksAhead();
+
   mutable std::recursive_mutex api_mutex_;
   const std::string thread_name_;
   btbase::AbstractMessageLoop* message_loop_;
@@ -200,6 +292,31 @@ class MessageLoopThread final {
   bool is_main_;
   ::rust::Box<shim::rust::MessageLoopThread>* rust_thread_ = nullptr;
 
+  TaskLatencyStats task_latency_stats_;
+
+  struct InlineTask {
+    InlineClosure task;
+    base::Location from_here;
+    base::TimeTicks due_time;
+  };
+  std::mutex inline_tasks_mutex_;
+  std::deque<InlineTask> inline_tasks_;
+  // Number of tasks in each batch, with one RunInlineTasks() posted per batch
+  std::deque<size_t> inline_batches_;
+  // Whether the last batch can still take tasks, i.e. nothing else was posted
+  // to the message loop after its RunInlineTasks()
+  bool inline_batch_open_ = false;
+
+  struct HighPriorityTask {
+    base::OnceClosure task;
+    base::Location from_here;
+    base::TimeTicks due_time;
+  };
+  std::mutex high_priority_tasks_mutex_;
+  std::deque<HighPriorityTask> high_priority_tasks_;
+  // Size of high_priority_tasks_, read without the lock before each task
+  std::atomic<size_t> high_priority_tasks_pending_{0};
+
   DISALLOW_COPY_AND_ASSIGN(MessageLoopThread);
 };
 
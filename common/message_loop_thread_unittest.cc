@@ -18,6 +18,7 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -59,6 +60,13 @@ class MessageLoopThreadTest : public ::testing::Test {
     execution_promise.set_value();
   }
 
+  void GetCpuAffinity(cpu_set_t* cpu_set,
+                      std::promise<void> execution_promise) {
+    CPU_ZERO(cpu_set);
+    ASSERT_EQ(sched_getaffinity(0, sizeof(*cpu_set), cpu_set), 0);
+    execution_promise.set_value();
+  }
+
   void SleepAndGetName(std::promise<std::string> name_promise, int sleep_ms) {
     std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
     GetName(std::move(name_promise));
@@ -219,6 +227,58 @@ TEST_F(MessageLoopThreadTest, test_set_realtime_priority_success) {
   ASSERT_EQ(param.sched_priority, 1);
 }
 
+TEST_F(MessageLoopThreadTest, test_set_realtime_priority_with_value) {
+  std::string name = "test_thread";
+  MessageLoopThread message_loop_thread(name);
+  ASSERT_FALSE(message_loop_thread.EnableRealTimeScheduling(2));
+  message_loop_thread.StartUp();
+  if (!message_loop_thread.EnableRealTimeScheduling(2)) {
+    ASSERT_FALSE(CanSetCurrentThreadPriority())
+        << "Cannot set real time priority even though we have permission";
+    return;
+  }
+  std::promise<void> execution_promise;
+  std::future<void> execution_future = execution_promise.get_future();
+  int scheduling_policy = -1;
+  int scheduling_priority = -1;
+  message_loop_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&MessageLoopThreadTest::GetSchedulingPolicyAndPriority,
+                     base::Unretained(this), &scheduling_policy,
+                     &scheduling_priority, std::move(execution_promise)));
+  execution_future.wait();
+  ASSERT_EQ(scheduling_policy, SCHED_FIFO);
+  ASSERT_EQ(scheduling_priority, 2);
+}
+
+TEST_F(MessageLoopThreadTest, test_set_cpu_affinity) {
+  std::string name = "test_thread";
+  MessageLoopThread message_loop_thread(name);
+  ASSERT_FALSE(message_loop_thread.SetCpuAffinity(1));
+  message_loop_thread.StartUp();
+
+  // Pin the thread to the first CPU the test itself is allowed to run on
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+  int cpu = 0;
+  while (cpu < 64 && !CPU_ISSET(cpu, &allowed)) cpu++;
+  ASSERT_LT(cpu, 64);
+  ASSERT_TRUE(message_loop_thread.SetCpuAffinity(UINT64_C(1) << cpu));
+
+  std::promise<void> execution_promise;
+  std::future<void> execution_future = execution_promise.get_future();
+  cpu_set_t cpu_set;
+  message_loop_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&MessageLoopThreadTest::GetCpuAffinity,
+                     base::Unretained(this), &cpu_set,
+                     std::move(execution_promise)));
+  execution_future.wait();
+  ASSERT_EQ(CPU_COUNT(&cpu_set), 1);
+  ASSERT_TRUE(CPU_ISSET(cpu, &cpu_set));
+}
+
 TEST_F(MessageLoopThreadTest, test_message_loop_null_before_start) {
   std::string name = "test_thread";
   MessageLoopThread message_loop_thread(name);
@@ -328,3 +388,123 @@ TEST_F(MessageLoopThreadTest, shut_down_start_up_multi_thread) {
   auto thread = std::thread(&MessageLoopThread::StartUp, &message_loop_thread);
   thread.join();
 }
+
+TEST_F(MessageLoopThreadTest, test_do_in_thread_inline_closure_before_start) {
+  MessageLoopThread message_loop_thread("test_thread");
+  ASSERT_FALSE(message_loop_thread.DoInThread(
+      FROM_HERE, [this]() { ShouldNotHappen(); }));
+}
+
+TEST_F(MessageLoopThreadTest, test_do_in_thread_inline_closure_keeps_order) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  std::vector<int> order;
+  for (int i = 0; i < 100; i++) {
+    if (i % 10 == 0) {
+      ASSERT_TRUE(message_loop_thread.DoInThread(
+          FROM_HERE, base::BindOnce(
+                         [](std::vector<int>* order, int i) {
+                           order->push_back(i);
+                         },
+                         &order, i)));
+    } else {
+      ASSERT_TRUE(message_loop_thread.DoInThread(
+          FROM_HERE, [&order, i]() { order.push_back(i); }));
+    }
+  }
+  std::promise<void> done;
+  auto future = done.get_future();
+  ASSERT_TRUE(message_loop_thread.DoInThread(
+      FROM_HERE, [&done]() { done.set_value(); }));
+  future.wait();
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(order[i], i);
+  }
+}
+
+TEST_F(MessageLoopThreadTest, test_do_in_thread_high_priority_before_start) {
+  MessageLoopThread message_loop_thread("test_thread");
+  ASSERT_FALSE(message_loop_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&MessageLoopThreadTest::ShouldNotHappen,
+                     base::Unretained(this)),
+      MessageLoopThread::Priority::kHigh));
+}
+
+TEST_F(MessageLoopThreadTest, test_do_in_thread_high_priority_goes_ahead) {
+  MessageLoopThread message_loop_thread("test_thread");
+  message_loop_thread.StartUp();
+  const int kNormalTasks = 3;
+  const int kHighTasks = 2 * MessageLoopThread::kMaxHighPriorityBurst + 4;
+  std::promise<void> started;
+  auto started_future = started.get_future();
+  std::promise<void> blocked;
+  std::shared_future<void> unblock = blocked.get_future().share();
+  ASSERT_TRUE(message_loop_thread.DoInThread(
+      FROM_HERE, base::BindOnce(
+                     [](std::promise<void>* started,
+                        std::shared_future<void> unblock) {
+                       started->set_value();
+                       unblock.wait();
+                     },
+                     &started, unblock)));
+  started_future.wait();
+
+  // Normal tasks are labelled with negative numbers
+  std::vector<int> order;
+  auto record = [](std::vector<int>* order, int i) { order->push_back(i); };
+  for (int i = 1; i <= kNormalTasks; i++) {
+    ASSERT_TRUE(message_loop_thread.DoInThread(
+        FROM_HERE, base::BindOnce(record, &order, -i)));
+  }
+  for (int i = 0; i < kHighTasks; i++) {
+    ASSERT_TRUE(message_loop_thread.DoInThread(
+        FROM_HERE, base::BindOnce(record, &order, i),
+        MessageLoopThread::Priority::kHigh));
+  }
+  std::promise<void> done;
+  auto future = done.get_future();
+  ASSERT_TRUE(message_loop_thread.DoInThread(
+      FROM_HERE, base::BindOnce(&std::promise<void>::set_value,
+                                base::Unretained(&done))));
+  blocked.set_value();
+  future.wait();
+
+  // At most a burst of high priority tasks runs ahead of each normal task
+  std::vector<int> expected;
+  int next_high = 0;
+  for (int i = 1; i <= kNormalTasks; i++) {
+    for (size_t n = 0; n < MessageLoopThread::kMaxHighPriorityBurst &&
+                       next_high < kHighTasks;
+         n++) {
+      expected.push_back(next_high++);
+    }
+    expected.push_back(-i);
+  }
+  ASSERT_EQ(next_high, kHighTasks);
+  ASSERT_EQ(order, expected);
+}
+
+TEST_F(MessageLoopThreadTest, test_task_latency_recorded) {
+  MessageLoopThread message_loop_thread("test_latency_thread");
+  message_loop_thread.StartUp();
+  std::promise<void> done;
+  auto future = done.get_future();
+  ASSERT_TRUE(message_loop_thread.DoInThread(
+      FROM_HERE, base::BindOnce(&std::promise<void>::set_value,
+                                base::Unretained(&done))));
+  future.wait();
+  // The task is recorded once it returns, shut down to make sure it did
+  message_loop_thread.ShutDown();
+
+  uint64_t count = 0;
+  for (const auto& thread :
+       bluetooth::common::TaskLatencyStats::GetAllSnapshots()) {
+    if (thread.thread_name != "test_latency_thread") continue;
+    for (const auto& location : thread.locations) {
+      count += location.execution_time.count;
+    }
+  }
+  ASSERT_EQ(count, 1u);
+}
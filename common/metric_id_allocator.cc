@@ -41,6 +41,18 @@ static_assert((MetricIdAllocator::kMaxNumUnpairedDevicesInMemory +
               "id space should always be larger than "
               "kMaxNumPairedDevicesInMemory + MaxNumUnpairedDevicesInMemory");
 
+// Address in the upper 48 bits, id in the lower 16 bits
+static uint64_t pack_address(const RawAddress& mac_address) {
+  uint64_t packed = 0;
+  for (size_t i = 0; i < RawAddress::kLength; i++) {
+    packed = (packed << 8) | mac_address.address[i];
+  }
+  return packed << 16;
+}
+
+static_assert(MetricIdAllocator::kMaxId <= 0xffff,
+              "ids must fit in the lower 16 bits of a recent paired id slot");
+
 MetricIdAllocator::MetricIdAllocator()
     : paired_device_cache_(kMaxNumPairedDevicesInMemory, LOGGING_TAG),
       temporary_device_cache_(kMaxNumUnpairedDevicesInMemory, LOGGING_TAG) {}
@@ -69,6 +81,7 @@ bool MetricIdAllocator::Init(
     }
     auto evicted = paired_device_cache_.Put(p.first, p.second);
     if (evicted) {
+      ForgetPairedId(evicted->first);
       ForgetDevicePostprocess(evicted->first, evicted->second);
     }
     id_set_.insert(p.second);
@@ -95,6 +108,9 @@ bool MetricIdAllocator::Close() {
   paired_device_cache_.Clear();
   temporary_device_cache_.Clear();
   id_set_.clear();
+  for (auto& slot : recent_paired_ids_) {
+    slot.store(0, std::memory_order_relaxed);
+  }
   initialized_ = false;
   return true;
 }
@@ -112,10 +128,17 @@ bool MetricIdAllocator::IsEmpty() const {
 
 // call this function when a new device is scanned
 int MetricIdAllocator::AllocateId(const RawAddress& mac_address) {
+  uint64_t recent =
+      RecentPairedIdSlot(mac_address).load(std::memory_order_acquire);
+  if (recent != 0 && (recent & ~0xffffull) == pack_address(mac_address)) {
+    return static_cast<int>(recent & 0xffff);
+  }
+
   std::lock_guard<std::mutex> lock(id_allocator_mutex_);
   int id = 0;
   // if already have an id, return it
   if (paired_device_cache_.Get(mac_address, &id)) {
+    RememberPairedId(mac_address, id);
     return id;
   }
   if (temporary_device_cache_.Get(mac_address, &id)) {
@@ -163,6 +186,7 @@ bool MetricIdAllocator::SaveDevice(const RawAddress& mac_address) {
   }
   auto evicted = paired_device_cache_.Put(mac_address, id);
   if (evicted) {
+    ForgetPairedId(evicted->first);
     ForgetDevicePostprocess(evicted->first, evicted->second);
   }
   if (!save_id_callback_(mac_address, id)) {
@@ -188,6 +212,7 @@ void MetricIdAllocator::ForgetDevice(const RawAddress& mac_address) {
                << "Failed to remove device from paired_device_cache_";
     return;
   }
+  ForgetPairedId(mac_address);
   ForgetDevicePostprocess(mac_address, id);
 }
 
@@ -195,6 +220,27 @@ bool MetricIdAllocator::IsValidId(const int id) {
   return id >= kMinId && id <= kMaxId;
 }
 
+std::atomic<uint64_t>& MetricIdAllocator::RecentPairedIdSlot(
+    const RawAddress& mac_address) {
+  return recent_paired_ids_[std::hash<RawAddress>{}(mac_address) %
+                            kNumRecentPairedIds];
+}
+
+void MetricIdAllocator::RememberPairedId(const RawAddress& mac_address,
+                                         const int id) {
+  RecentPairedIdSlot(mac_address)
+      .store(pack_address(mac_address) | static_cast<uint64_t>(id),
+             std::memory_order_release);
+}
+
+void MetricIdAllocator::ForgetPairedId(const RawAddress& mac_address) {
+  uint64_t packed = pack_address(mac_address);
+  auto& slot = RecentPairedIdSlot(mac_address);
+  if ((slot.load(std::memory_order_relaxed) & ~0xffffull) == packed) {
+    slot.store(0, std::memory_order_release);
+  }
+}
+
 void MetricIdAllocator::ForgetDevicePostprocess(const RawAddress& mac_address,
                                                 const int id) {
   id_set_.erase(id);
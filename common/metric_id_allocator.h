@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -40,6 +42,8 @@ class MetricIdAllocator {
   static const int kMinId;
   static const int kMaxId;
 
+  static constexpr size_t kNumRecentPairedIds = 16;
+
   ~MetricIdAllocator();
 
   /**
@@ -81,6 +85,9 @@ class MetricIdAllocator {
    * Allocate an id for a scanned device, or return the id if there is already
    * one
    *
+   * The id of a recently looked up paired device is returned without taking
+   * the allocator lock
+   *
    * @param mac_address mac address of Bluetooth device
    * @return the id of device
    */
@@ -128,6 +135,14 @@ class MetricIdAllocator {
   Callback save_id_callback_;
   Callback forget_device_callback_;
 
+  // Recently looked up paired devices, each slot packs the address and its id
+  // into one word so that AllocateId() can read it without the lock. Slots
+  // are only written with the lock held, 0 marks an empty slot as no id is 0.
+  std::array<std::atomic<uint64_t>, kNumRecentPairedIds> recent_paired_ids_{};
+
+  std::atomic<uint64_t>& RecentPairedIdSlot(const RawAddress& mac_address);
+  void RememberPairedId(const RawAddress& mac_address, const int id);
+  void ForgetPairedId(const RawAddress& mac_address);
   void ForgetDevicePostprocess(const RawAddress& mac_address, const int id);
 
   // delete copy constructor for singleton
@@ -178,6 +178,32 @@ TEST(BluetoothMetricIdAllocatorTest, MetricIdAllocatorMainTest1) {
   EXPECT_TRUE(allocator.Close());
 }
 
+TEST(BluetoothMetricIdAllocatorTest, MetricIdAllocatorRecentPairedIdTest) {
+  auto& allocator = MetricIdAllocator::GetInstance();
+  std::unordered_map<RawAddress, int> paired_device_map = {
+      {kthAddress(0), 10}, {kthAddress(1), 20}};
+  MetricIdAllocator::Callback callback = [](const RawAddress&, const int) {
+    return true;
+  };
+  EXPECT_TRUE(allocator.Init(paired_device_map, callback, callback));
+  // repeated lookups return the saved ids
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(allocator.AllocateId(kthAddress(0)), 10);
+    EXPECT_EQ(allocator.AllocateId(kthAddress(1)), 20);
+  }
+
+  // a forgotten device must get a new id
+  allocator.ForgetDevice(kthAddress(0));
+  EXPECT_EQ(allocator.AllocateId(kthAddress(0)), 21);
+  EXPECT_TRUE(allocator.Close());
+
+  // ids looked up before Close() must not survive it
+  paired_device_map = {{kthAddress(1), 30}};
+  EXPECT_TRUE(allocator.Init(paired_device_map, callback, callback));
+  EXPECT_EQ(allocator.AllocateId(kthAddress(1)), 30);
+  EXPECT_TRUE(allocator.Close());
+}
+
 TEST(BluetoothMetricIdAllocatorTest, MetricIdAllocatorFullPairedMap) {
   auto& allocator = MetricIdAllocator::GetInstance();
   // preset a full map
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "btcore/include/device_features.h"
+#include "btcore/include/version.h"
+#include "types/raw_address.h"
+
+#define HCI_SUPPORTED_COMMANDS_ARRAY_SIZE 64
+#define MAX_FEATURES_CLASSIC_PAGE_COUNT 3
+#define BLE_SUPPORTED_STATES_SIZE 8
+#define MAX_LOCAL_SUPPORTED_CODECS_SIZE 8
+
+// Capabilities the controller reports during start up. They stay the same as
+// long as its firmware does, so they are saved and reused on the next start up
+// of the same controller, keyed by its address and version information.
+// Snapshots are compared and saved as raw bytes: zero them before filling them
+// in, so that their padding is zeroed too.
+typedef struct {
+  RawAddress address;
+  bt_version_t bt_version;
+
+  uint8_t supported_commands[HCI_SUPPORTED_COMMANDS_ARRAY_SIZE];
+  bt_device_features_t features_classic[MAX_FEATURES_CLASSIC_PAGE_COUNT];
+  uint8_t last_features_classic_page_index;
+
+  uint16_t acl_data_size_classic;
+  uint16_t acl_buffer_count_classic;
+
+  // The LE capabilities are only read when the controller supports LE
+  uint16_t acl_data_size_ble;
+  uint8_t acl_buffer_count_ble;
+  uint16_t iso_data_size;
+  uint8_t iso_buffer_count;
+
+  uint8_t ble_acceptlist_size;
+  uint8_t ble_resolving_list_max_size;
+  uint8_t ble_supported_states[BLE_SUPPORTED_STATES_SIZE];
+  bt_device_features_t features_ble;
+  uint16_t ble_suggested_default_data_length;
+  uint16_t ble_supported_max_tx_octets;
+  uint16_t ble_supported_max_tx_time;
+  uint16_t ble_supported_max_rx_octets;
+  uint16_t ble_supported_max_rx_time;
+  uint16_t ble_maximum_advertising_data_length;
+  uint8_t ble_number_of_supported_advertising_sets;
+  uint8_t ble_periodic_advertiser_list_size;
+
+  uint8_t local_supported_codecs[MAX_LOCAL_SUPPORTED_CODECS_SIZE];
+  uint8_t number_of_local_supported_codecs;
+} controller_snapshot_t;
+
+// Loads the snapshot saved at |path| into |snapshot|. Returns false if there is
+// none, if it is corrupted, or if it was taken from a controller with another
+// address or version information.
+bool controller_snapshot_load(const char* path, const RawAddress& address,
+                              const bt_version_t& bt_version,
+                              controller_snapshot_t* snapshot);
+
+// Saves |snapshot| to |path|, replacing the previous one atomically.
+bool controller_snapshot_save(const char* path,
+                              const controller_snapshot_t& snapshot);
+
+bool controller_snapshot_equals(const controller_snapshot_t& a,
+                                const controller_snapshot_t& b);
@@ -115,13 +115,22 @@ typedef enum {
 
   // Some car kits do not send the AT+BIND command while establishing the SLC
   // which causes an HFP profile connection failure
-  INTEROP_SLC_SKIP_BIND_COMMAND
+  INTEROP_SLC_SKIP_BIND_COMMAND,
+
+  // Some AGs drop or reorder the responses of AT commands sent before the
+  // previous ones were answered. Send them one at a time to these AGs.
+  INTEROP_HF_CLIENT_DISABLE_AT_PIPELINING,
+
+  // Number of workarounds, keep it last. There can be at most 64.
+  END_OF_INTEROP_LIST
 } interop_feature_t;
 
 // Check if a given |addr| matches a known interoperability workaround as
 // identified by the |interop_feature_t| enum. This API is used for simple
 // address based lookups where more information is not available. No
 // look-ups or random address resolution are performed on |addr|.
+// The workarounds of an address are looked up once, and remembered until the
+// dynamic database changes.
 bool interop_match_addr(const interop_feature_t feature,
                         const RawAddress* addr);
 
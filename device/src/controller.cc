@@ -27,11 +27,14 @@
 #include "btcore/include/event_mask.h"
 #include "btcore/include/module.h"
 #include "btcore/include/version.h"
+#include "device/include/controller_snapshot.h"
 #include "hcimsgs.h"
 #include "main/shim/controller.h"
 #include "main/shim/shim.h"
 #include "osi/include/future.h"
+#include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/thread.h"
 #include "stack/include/btm_ble_api.h"
 
 const bt_event_mask_t BLE_EVENT_MASK = {{0x00, 0x00, 0x00, 0x00, 0x7F, 0x02,
@@ -49,13 +52,16 @@ const bt_event_mask_t CLASSIC_EVENT_MASK = {HCI_DUMO_EVENT_MASK_EXT};
 // TODO(zachoverflow): factor out into common module
 const uint8_t SCO_HOST_BUFFER_SIZE = 0xff;
 
-#define HCI_SUPPORTED_COMMANDS_ARRAY_SIZE 64
-#define MAX_FEATURES_CLASSIC_PAGE_COUNT 3
-#define BLE_SUPPORTED_STATES_SIZE 8
 #define BLE_SUPPORTED_FEATURES_SIZE 8
-#define MAX_LOCAL_SUPPORTED_CODECS_SIZE 8
 #define LL_FEATURE_BIT_ISO_HOST_SUPPORT 32
 
+#if defined(OS_GENERIC)
+static const char* CONTROLLER_SNAPSHOT_PATH = "bt_controller_snapshot";
+#else   // !defined(OS_GENERIC)
+static const char* CONTROLLER_SNAPSHOT_PATH =
+    "/data/misc/bluedroid/bt_controller_snapshot";
+#endif  // defined(OS_GENERIC)
+
 static const hci_t* local_hci;
 static const hci_packet_factory_t* packet_factory;
 static const hci_packet_parser_t* packet_parser;
@@ -97,195 +103,296 @@ static bool iso_supported;
 static bool simple_pairing_supported;
 static bool secure_connections_supported;
 
+// The capabilities in use, and the thread checking that the controller still
+// reports them when they were loaded from a previous start up
+static controller_snapshot_t snapshot;
+static thread_t* snapshot_check_thread;
+
 #define AWAIT_COMMAND(command) \
   static_cast<BT_HDR*>(        \
       future_await(local_hci->transmit_command_futured(command)))
 
 // Module lifecycle functions
 
-static future_t* start_up(void) {
+// Reads the capabilities of the controller into |s|. Page 1 of the controller
+// features reflects the LE host support, which must have been written before.
+static void read_snapshot(controller_snapshot_t* s) {
   BT_HDR* response;
 
-  // Send the initial reset command
-  response = AWAIT_COMMAND(packet_factory->make_reset());
-  packet_parser->parse_generic_command_complete(response);
-
-  // Request the classic buffer size next
   response = AWAIT_COMMAND(packet_factory->make_read_buffer_size());
   packet_parser->parse_read_buffer_size_response(
-      response, &acl_data_size_classic, &acl_buffer_count_classic);
-
-  // Tell the controller about our buffer sizes and buffer counts next
-  // TODO(zachoverflow): factor this out. eww l2cap contamination. And why just
-  // a hardcoded 10?
-  response = AWAIT_COMMAND(packet_factory->make_host_buffer_size(
-      L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
-
-  packet_parser->parse_generic_command_complete(response);
-
-  // Read the local version info off the controller next, including
-  // information such as manufacturer and supported HCI version
-  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
-  packet_parser->parse_read_local_version_info_response(response, &bt_version);
+      response, &s->acl_data_size_classic, &s->acl_buffer_count_classic);
 
-  // Read the bluetooth address off the controller next
-  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
-  packet_parser->parse_read_bd_addr_response(response, &address);
-
-  // Request the controller's supported commands next
   response =
       AWAIT_COMMAND(packet_factory->make_read_local_supported_commands());
   packet_parser->parse_read_local_supported_commands_response(
-      response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
-#if (BTM_SCO_ENHANCED_SYNC_ENABLED == FALSE)
-  supported_commands[29] &= ~0x08;
-#endif
+      response, s->supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
 
-  // Read page 0 of the controller features next
   uint8_t page_number = 0;
   response = AWAIT_COMMAND(
       packet_factory->make_read_local_extended_features(page_number));
   packet_parser->parse_read_local_extended_features_response(
-      response, &page_number, &last_features_classic_page_index,
-      features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
-
+      response, &page_number, &s->last_features_classic_page_index,
+      s->features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
   CHECK(page_number == 0);
   page_number++;
 
-  // Inform the controller what page 0 features we support, based on what
-  // it told us it supports. We need to do this first before we request the
-  // next page, because the controller's response for page 1 may be
-  // dependent on what we configure from page 0
-  simple_pairing_supported =
-      HCI_SIMPLE_PAIRING_SUPPORTED(features_classic[0].as_array);
-  if (simple_pairing_supported) {
-    response = AWAIT_COMMAND(
-        packet_factory->make_write_simple_pairing_mode(HCI_SP_MODE_ENABLED));
-    packet_parser->parse_generic_command_complete(response);
+  // The LE host support written sets page 1
+  if (HCI_LE_SPT_SUPPORTED(s->features_classic[0].as_array) &&
+      s->last_features_classic_page_index < 1) {
+    s->last_features_classic_page_index = 1;
   }
 
-  if (HCI_LE_SPT_SUPPORTED(features_classic[0].as_array)) {
-    uint8_t simultaneous_le_host =
-        HCI_SIMUL_LE_BREDR_SUPPORTED(features_classic[0].as_array)
-            ? BTM_BLE_SIMULTANEOUS_HOST
-            : 0;
-    response = AWAIT_COMMAND(packet_factory->make_ble_write_host_support(
-        BTM_BLE_HOST_SUPPORT, simultaneous_le_host));
-
-    packet_parser->parse_generic_command_complete(response);
-
-    // If we modified the BT_HOST_SUPPORT, we will need ext. feat. page 1
-    if (last_features_classic_page_index < 1)
-      last_features_classic_page_index = 1;
-  }
-
-  // Done telling the controller about what page 0 features we support
-  // Request the remaining feature pages
-  while (page_number <= last_features_classic_page_index &&
+  while (page_number <= s->last_features_classic_page_index &&
          page_number < MAX_FEATURES_CLASSIC_PAGE_COUNT) {
     response = AWAIT_COMMAND(
         packet_factory->make_read_local_extended_features(page_number));
     packet_parser->parse_read_local_extended_features_response(
-        response, &page_number, &last_features_classic_page_index,
-        features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
+        response, &page_number, &s->last_features_classic_page_index,
+        s->features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
 
     page_number++;
   }
 
-#if (SC_MODE_INCLUDED == TRUE)
-  secure_connections_supported =
-      HCI_SC_CTRLR_SUPPORTED(features_classic[2].as_array);
-  if (secure_connections_supported) {
-    response = AWAIT_COMMAND(
-        packet_factory->make_write_secure_connections_host_support(
-            HCI_SC_MODE_ENABLED));
-    packet_parser->parse_generic_command_complete(response);
-  }
-#endif
-
-  ble_supported = last_features_classic_page_index >= 1 &&
-                  HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
-  if (ble_supported) {
+  bool ble_host_supported =
+      s->last_features_classic_page_index >= 1 &&
+      HCI_LE_HOST_SUPPORTED(s->features_classic[1].as_array);
+  if (ble_host_supported) {
     // Request the ble acceptlist size next
     response = AWAIT_COMMAND(packet_factory->make_ble_read_acceptlist_size());
     packet_parser->parse_ble_read_acceptlist_size_response(
-        response, &ble_acceptlist_size);
+        response, &s->ble_acceptlist_size);
 
     // Request the ble supported features next
     response =
         AWAIT_COMMAND(packet_factory->make_ble_read_local_supported_features());
     packet_parser->parse_ble_read_local_supported_features_response(
-        response, &features_ble);
+        response, &s->features_ble);
 
-    iso_supported = HCI_LE_CIS_CENTRAL(features_ble.as_array) ||
-                    HCI_LE_CIS_PERIPHERAL(features_ble.as_array) ||
-                    HCI_LE_ISO_BROADCASTER(features_ble.as_array);
-
-    if (iso_supported) {
+    if (HCI_LE_CIS_CENTRAL(s->features_ble.as_array) ||
+        HCI_LE_CIS_PERIPHERAL(s->features_ble.as_array) ||
+        HCI_LE_ISO_BROADCASTER(s->features_ble.as_array)) {
       // Request the ble buffer size next
       response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size_v2());
       packet_parser->parse_ble_read_buffer_size_v2_response(
-          response, &acl_data_size_ble, &acl_buffer_count_ble, &iso_data_size,
-          &iso_buffer_count);
+          response, &s->acl_data_size_ble, &s->acl_buffer_count_ble,
+          &s->iso_data_size, &s->iso_buffer_count);
 
     } else {
       // Request the ble buffer size next
       response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size());
       packet_parser->parse_ble_read_buffer_size_response(
-          response, &acl_data_size_ble, &acl_buffer_count_ble);
+          response, &s->acl_data_size_ble, &s->acl_buffer_count_ble);
     }
 
     // Response of 0 indicates ble has the same buffer size as classic
-    if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
+    if (s->acl_data_size_ble == 0)
+      s->acl_data_size_ble = s->acl_data_size_classic;
 
     // Request the ble supported states next
     response = AWAIT_COMMAND(packet_factory->make_ble_read_supported_states());
     packet_parser->parse_ble_read_supported_states_response(
-        response, ble_supported_states, sizeof(ble_supported_states));
+        response, s->ble_supported_states, sizeof(s->ble_supported_states));
 
-    if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
+    if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(s->features_ble.as_array)) {
       response =
           AWAIT_COMMAND(packet_factory->make_ble_read_resolving_list_size());
       packet_parser->parse_ble_read_resolving_list_size_response(
-          response, &ble_resolving_list_max_size);
+          response, &s->ble_resolving_list_max_size);
     }
 
-    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
+    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(s->features_ble.as_array)) {
       response =
           AWAIT_COMMAND(packet_factory->make_ble_read_maximum_data_length());
       packet_parser->parse_ble_read_maximum_data_length_response(
-          response, &ble_supported_max_tx_octets, &ble_supported_max_tx_time,
-          &ble_supported_max_rx_octets, &ble_supported_max_rx_time);
+          response, &s->ble_supported_max_tx_octets,
+          &s->ble_supported_max_tx_time, &s->ble_supported_max_rx_octets,
+          &s->ble_supported_max_rx_time);
 
       response = AWAIT_COMMAND(
           packet_factory->make_ble_read_suggested_default_data_length());
       packet_parser->parse_ble_read_suggested_default_data_length_response(
-          response, &ble_suggested_default_data_length);
+          response, &s->ble_suggested_default_data_length);
     }
 
-    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
+    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(s->features_ble.as_array)) {
       response = AWAIT_COMMAND(
           packet_factory->make_ble_read_maximum_advertising_data_length());
       packet_parser->parse_ble_read_maximum_advertising_data_length(
-          response, &ble_maxium_advertising_data_length);
+          response, &s->ble_maximum_advertising_data_length);
 
       response = AWAIT_COMMAND(
           packet_factory->make_ble_read_number_of_supported_advertising_sets());
       packet_parser->parse_ble_read_number_of_supported_advertising_sets(
-          response, &ble_number_of_supported_advertising_sets);
+          response, &s->ble_number_of_supported_advertising_sets);
     } else {
       /* If LE Excended Advertising is not supported, use the default value */
-      ble_maxium_advertising_data_length = 31;
+      s->ble_maximum_advertising_data_length = 31;
     }
 
-    if (HCI_LE_PERIODIC_ADVERTISING_SUPPORTED(features_ble.as_array)) {
+    if (HCI_LE_PERIODIC_ADVERTISING_SUPPORTED(s->features_ble.as_array)) {
       response = AWAIT_COMMAND(
           packet_factory->make_ble_read_periodic_advertiser_list_size());
 
       packet_parser->parse_ble_read_size_of_advertiser_list(
-          response, &ble_periodic_advertiser_list_size);
+          response, &s->ble_periodic_advertiser_list_size);
     }
+  }
+
+  // read local supported codecs
+  if (HCI_READ_LOCAL_CODECS_SUPPORTED(s->supported_commands)) {
+    response =
+        AWAIT_COMMAND(packet_factory->make_read_local_supported_codecs());
+    packet_parser->parse_read_local_supported_codecs_response(
+        response, &s->number_of_local_supported_codecs,
+        s->local_supported_codecs);
+  }
+}
+
+static void apply_snapshot(const controller_snapshot_t& s) {
+  memcpy(supported_commands, s.supported_commands, sizeof(supported_commands));
+#if (BTM_SCO_ENHANCED_SYNC_ENABLED == FALSE)
+  supported_commands[29] &= ~0x08;
+#endif
+  memcpy(features_classic, s.features_classic, sizeof(features_classic));
+  last_features_classic_page_index = s.last_features_classic_page_index;
+
+  acl_data_size_classic = s.acl_data_size_classic;
+  acl_buffer_count_classic = s.acl_buffer_count_classic;
+
+  ble_supported = last_features_classic_page_index >= 1 &&
+                  HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
+  acl_data_size_ble = s.acl_data_size_ble;
+  acl_buffer_count_ble = s.acl_buffer_count_ble;
+  iso_data_size = s.iso_data_size;
+  iso_buffer_count = s.iso_buffer_count;
+  ble_acceptlist_size = s.ble_acceptlist_size;
+  ble_resolving_list_max_size = s.ble_resolving_list_max_size;
+  memcpy(ble_supported_states, s.ble_supported_states,
+         sizeof(ble_supported_states));
+  features_ble = s.features_ble;
+  iso_supported = HCI_LE_CIS_CENTRAL(features_ble.as_array) ||
+                  HCI_LE_CIS_PERIPHERAL(features_ble.as_array) ||
+                  HCI_LE_ISO_BROADCASTER(features_ble.as_array);
+  ble_suggested_default_data_length = s.ble_suggested_default_data_length;
+  ble_supported_max_tx_octets = s.ble_supported_max_tx_octets;
+  ble_supported_max_tx_time = s.ble_supported_max_tx_time;
+  ble_supported_max_rx_octets = s.ble_supported_max_rx_octets;
+  ble_supported_max_rx_time = s.ble_supported_max_rx_time;
+  ble_maxium_advertising_data_length = s.ble_maximum_advertising_data_length;
+  ble_number_of_supported_advertising_sets =
+      s.ble_number_of_supported_advertising_sets;
+  ble_periodic_advertiser_list_size = s.ble_periodic_advertiser_list_size;
+
+  memcpy(local_supported_codecs, s.local_supported_codecs,
+         sizeof(local_supported_codecs));
+  number_of_local_supported_codecs = s.number_of_local_supported_codecs;
+}
+
+// Reads the capabilities again once the stack is up, and saves them for the
+// next start up if they are not the ones loaded. They only differ if the
+// firmware changed without changing its version information.
+static void check_snapshot(UNUSED_ATTR void* context) {
+  controller_snapshot_t current;
+  memset(&current, 0, sizeof(current));
+  current.address = snapshot.address;
+  current.bt_version = snapshot.bt_version;
+  read_snapshot(&current);
+
+  if (controller_snapshot_equals(current, snapshot)) {
+    return;
+  }
+  LOG(WARNING) << __func__
+               << ": controller capabilities changed, they are used from the "
+                  "next start up";
+  controller_snapshot_save(CONTROLLER_SNAPSHOT_PATH, current);
+}
+
+static future_t* start_up(void) {
+  BT_HDR* response;
+
+  // Send the initial reset command
+  response = AWAIT_COMMAND(packet_factory->make_reset());
+  packet_parser->parse_generic_command_complete(response);
 
+  // Tell the controller about our buffer sizes and buffer counts next
+  // TODO(zachoverflow): factor this out. eww l2cap contamination. And why just
+  // a hardcoded 10?
+  response = AWAIT_COMMAND(packet_factory->make_host_buffer_size(
+      L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
+
+  packet_parser->parse_generic_command_complete(response);
+
+  // Read the local version info off the controller next, including
+  // information such as manufacturer and supported HCI version
+  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
+  packet_parser->parse_read_local_version_info_response(response, &bt_version);
+
+  // Read the bluetooth address off the controller next
+  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
+  packet_parser->parse_read_bd_addr_response(response, &address);
+
+  // The other capabilities are the ones saved on a previous start up of the
+  // same controller and firmware, when there are any
+  memset(&snapshot, 0, sizeof(snapshot));
+  bool snapshot_loaded = controller_snapshot_load(
+      CONTROLLER_SNAPSHOT_PATH, address, bt_version, &snapshot);
+
+  bt_device_features_t features_page_0;
+  if (snapshot_loaded) {
+    features_page_0 = snapshot.features_classic[0];
+  } else {
+    uint8_t page_number = 0;
+    uint8_t last_page_index;
+    response = AWAIT_COMMAND(
+        packet_factory->make_read_local_extended_features(page_number));
+    packet_parser->parse_read_local_extended_features_response(
+        response, &page_number, &last_page_index, &features_page_0, 1);
+  }
+
+  // Inform the controller what page 0 features we support, based on what
+  // it told us it supports. We need to do this first before we request the
+  // next page, because the controller's response for page 1 may be
+  // dependent on what we configure from page 0
+  simple_pairing_supported =
+      HCI_SIMPLE_PAIRING_SUPPORTED(features_page_0.as_array);
+  if (simple_pairing_supported) {
+    response = AWAIT_COMMAND(
+        packet_factory->make_write_simple_pairing_mode(HCI_SP_MODE_ENABLED));
+    packet_parser->parse_generic_command_complete(response);
+  }
+
+  if (HCI_LE_SPT_SUPPORTED(features_page_0.as_array)) {
+    uint8_t simultaneous_le_host =
+        HCI_SIMUL_LE_BREDR_SUPPORTED(features_page_0.as_array)
+            ? BTM_BLE_SIMULTANEOUS_HOST
+            : 0;
+    response = AWAIT_COMMAND(packet_factory->make_ble_write_host_support(
+        BTM_BLE_HOST_SUPPORT, simultaneous_le_host));
+
+    packet_parser->parse_generic_command_complete(response);
+  }
+
+  if (!snapshot_loaded) {
+    snapshot.address = address;
+    snapshot.bt_version = bt_version;
+    read_snapshot(&snapshot);
+    controller_snapshot_save(CONTROLLER_SNAPSHOT_PATH, snapshot);
+  }
+  apply_snapshot(snapshot);
+
+#if (SC_MODE_INCLUDED == TRUE)
+  secure_connections_supported =
+      HCI_SC_CTRLR_SUPPORTED(features_classic[2].as_array);
+  if (secure_connections_supported) {
+    response = AWAIT_COMMAND(
+        packet_factory->make_write_secure_connections_host_support(
+            HCI_SC_MODE_ENABLED));
+    packet_parser->parse_generic_command_complete(response);
+  }
+#endif
+
+  if (ble_supported) {
     // Set the ble event mask next
     response =
         AWAIT_COMMAND(packet_factory->make_ble_set_event_mask(&BLE_EVENT_MASK));
@@ -304,23 +411,24 @@ static future_t* start_up(void) {
     packet_parser->parse_generic_command_complete(response);
   }
 
-  // read local supported codecs
-  if (HCI_READ_LOCAL_CODECS_SUPPORTED(supported_commands)) {
-    response =
-        AWAIT_COMMAND(packet_factory->make_read_local_supported_codecs());
-    packet_parser->parse_read_local_supported_codecs_response(
-        response, &number_of_local_supported_codecs, local_supported_codecs);
-  }
-
   if (!HCI_READ_ENCR_KEY_SIZE_SUPPORTED(supported_commands)) {
     LOG(FATAL) << " Controller must support Read Encryption Key Size command";
   }
 
+  if (snapshot_loaded) {
+    snapshot_check_thread = thread_new("bt_controller_snapshot");
+    thread_post(snapshot_check_thread, check_snapshot, NULL);
+  }
+
   readable = true;
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
 static future_t* shut_down(void) {
+  if (snapshot_check_thread != NULL) {
+    thread_free(snapshot_check_thread);
+    snapshot_check_thread = NULL;
+  }
   readable = false;
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_controller_snapshot"
+
+#include "device/include/controller_snapshot.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+// "BTCS"
+constexpr uint32_t kSnapshotMagic = 0x53435442;
+// Bumped whenever controller_snapshot_t changes
+constexpr uint32_t kSnapshotFormatVersion = 1;
+
+struct snapshot_file_t {
+  uint32_t magic;
+  uint32_t format_version;
+  uint32_t size;
+  controller_snapshot_t snapshot;
+  uint32_t checksum;
+};
+
+// FNV-1a, to tell a snapshot that was partially written or corrupted
+uint32_t checksum(const controller_snapshot_t& snapshot) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&snapshot);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(snapshot); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+bool version_equals(const bt_version_t& a, const bt_version_t& b) {
+  return a.hci_version == b.hci_version && a.hci_revision == b.hci_revision &&
+         a.lmp_version == b.lmp_version && a.manufacturer == b.manufacturer &&
+         a.lmp_subversion == b.lmp_subversion;
+}
+
+}  // namespace
+
+bool controller_snapshot_load(const char* path, const RawAddress& address,
+                              const bt_version_t& bt_version,
+                              controller_snapshot_t* snapshot) {
+  CHECK(path != nullptr);
+  CHECK(snapshot != nullptr);
+
+  FILE* fp = fopen(path, "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  snapshot_file_t file;
+  size_t read = fread(&file, sizeof(file), 1, fp);
+  fclose(fp);
+
+  if (read != 1 || file.magic != kSnapshotMagic ||
+      file.format_version != kSnapshotFormatVersion ||
+      file.size != sizeof(controller_snapshot_t) ||
+      file.checksum != checksum(file.snapshot)) {
+    LOG(WARNING) << __func__ << ": ignoring invalid snapshot '" << path
+                 << "'";
+    return false;
+  }
+  if (file.snapshot.address != address ||
+      !version_equals(file.snapshot.bt_version, bt_version)) {
+    LOG(INFO) << __func__ << ": snapshot '" << path
+              << "' is for another controller or firmware";
+    return false;
+  }
+
+  *snapshot = file.snapshot;
+  return true;
+}
+
+bool controller_snapshot_save(const char* path,
+                              const controller_snapshot_t& snapshot) {
+  CHECK(path != nullptr);
+
+  snapshot_file_t file;
+  memset(&file, 0, sizeof(file));
+  file.magic = kSnapshotMagic;
+  file.format_version = kSnapshotFormatVersion;
+  file.size = sizeof(controller_snapshot_t);
+  file.snapshot = snapshot;
+  file.checksum = checksum(snapshot);
+
+  // Written to a temporary file first, which replaces the snapshot once it is
+  // complete. A snapshot lost on power loss is simply taken again.
+  const std::string temp_path = std::string(path) + ".new";
+  FILE* fp = fopen(temp_path.c_str(), "wb");
+  if (fp == nullptr) {
+    LOG(ERROR) << __func__ << ": unable to write to file '" << temp_path
+               << "': " << strerror(errno);
+    return false;
+  }
+  bool written = fwrite(&file, sizeof(file), 1, fp) == 1 && fflush(fp) == 0 &&
+                 fsync(fileno(fp)) == 0;
+  if (fclose(fp) != 0) {
+    written = false;
+  }
+  if (!written || rename(temp_path.c_str(), path) != 0) {
+    LOG(ERROR) << __func__ << ": unable to save snapshot to '" << path
+               << "': " << strerror(errno);
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool controller_snapshot_equals(const controller_snapshot_t& a,
+                                const controller_snapshot_t& b) {
+  return memcmp(&a, &b, sizeof(controller_snapshot_t)) == 0;
+}
@@ -19,28 +19,50 @@
 #define LOG_TAG "bt_device_interop"
 
 #include <base/logging.h>
-#include <string.h>  // For memcmp
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "device/include/interop.h"
 #include "device/include/interop_database.h"
-#include "osi/include/allocator.h"
-#include "osi/include/list.h"
 #include "osi/include/log.h"
 
 #define CASE_RETURN_STR(const) \
   case const:                  \
     return #const;
 
-static list_t* interop_list = NULL;
+// Workarounds of an address or a name, one bit per |interop_feature_t|
+typedef uint64_t interop_mask_t;
+static_assert(END_OF_INTEROP_LIST <= 64, "interop_mask_t is too small");
+
+// Node of the name prefix trie, |mask| holds the workarounds of the names
+// ending on it
+typedef struct {
+  std::vector<std::pair<char, size_t>> children;
+  interop_mask_t mask;
+} interop_name_node_t;
+
+// Addresses remembered before the cache is cleared
+#define INTEROP_ADDR_CACHE_MAX 64
+
+// The static and dynamic databases, compiled on first use. Address entries
+// are indexed by their prefix, with the prefix lengths in use, and names are
+// in a prefix trie.
+static std::mutex interop_mutex;
+static bool interop_compiled = false;
+static std::unordered_map<uint64_t, interop_mask_t> interop_addr_index;
+static uint8_t interop_addr_lengths = 0;
+static std::vector<interop_name_node_t> interop_name_trie;
+static std::unordered_map<RawAddress, interop_mask_t> interop_addr_cache;
 
 static const char* interop_feature_string_(const interop_feature_t feature);
-static void interop_free_entry_(void* data);
-static void interop_lazy_init_(void);
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr);
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr);
+static void interop_compile_(void);
+static void interop_index_addr_(uint16_t feature, const RawAddress* addr,
+                                size_t length);
+static interop_mask_t interop_addr_mask_(const RawAddress* addr);
+static interop_mask_t interop_name_mask_(const char* name);
 
 // Interface functions
 
@@ -48,8 +70,7 @@ bool interop_match_addr(const interop_feature_t feature,
                         const RawAddress* addr) {
   CHECK(addr);
 
-  if (interop_match_fixed_(feature, addr) ||
-      interop_match_dynamic_(feature, addr)) {
+  if (interop_addr_mask_(addr) & (interop_mask_t{1} << feature)) {
     LOG_INFO("%s() Device %s is a match for interop workaround %s.", __func__,
              addr->ToString().c_str(), interop_feature_string_(feature));
     return true;
@@ -61,17 +82,10 @@ bool interop_match_addr(const interop_feature_t feature,
 bool interop_match_name(const interop_feature_t feature, const char* name) {
   CHECK(name);
 
-  const size_t db_size =
-      sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name,
-                interop_name_database[i].length) == 0) {
-      LOG_INFO("%s() Device %s is a match for interop workaround %s.", __func__,
-               name, interop_feature_string_(feature));
-      return true;
-    }
+  if (interop_name_mask_(name) & (interop_mask_t{1} << feature)) {
+    LOG_INFO("%s() Device %s is a match for interop workaround %s.", __func__,
+             name, interop_feature_string_(feature));
+    return true;
   }
 
   return false;
@@ -83,25 +97,24 @@ void interop_database_add(uint16_t feature, const RawAddress* addr,
   CHECK(length > 0);
   CHECK(length < RawAddress::kLength);
 
-  interop_addr_entry_t* entry = static_cast<interop_addr_entry_t*>(
-      osi_calloc(sizeof(interop_addr_entry_t)));
-  memcpy(&entry->addr, addr, length);
-  entry->feature = static_cast<interop_feature_t>(feature);
-  entry->length = length;
+  // Unknown workarounds are never looked up
+  if (feature >= END_OF_INTEROP_LIST) return;
 
-  interop_lazy_init_();
-  list_append(interop_list, entry);
+  std::lock_guard<std::mutex> lock(interop_mutex);
+  interop_compile_();
+  interop_index_addr_(feature, addr, length);
+  interop_addr_cache.clear();
 }
 
 void interop_database_clear() {
-  if (interop_list) list_clear(interop_list);
+  std::lock_guard<std::mutex> lock(interop_mutex);
+  interop_compiled = false;
 }
 
 // Module life-cycle functions
 
 static future_t* interop_clean_up(void) {
-  list_free(interop_list);
-  interop_list = NULL;
+  interop_database_clear();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -135,54 +148,107 @@ static const char* interop_feature_string_(const interop_feature_t feature) {
     CASE_RETURN_STR(INTEROP_DISABLE_SNIFF)
     CASE_RETURN_STR(INTEROP_DISABLE_AVDTP_SUSPEND)
     CASE_RETURN_STR(INTEROP_SLC_SKIP_BIND_COMMAND);
+    CASE_RETURN_STR(INTEROP_HF_CLIENT_DISABLE_AT_PIPELINING);
+    CASE_RETURN_STR(END_OF_INTEROP_LIST);
   }
 
   return "UNKNOWN";
 }
 
-static void interop_free_entry_(void* data) {
-  interop_addr_entry_t* entry = (interop_addr_entry_t*)data;
-  osi_free(entry);
+// Key of the first |length| bytes of |addr| in the address index
+static uint64_t interop_addr_key_(const RawAddress* addr, size_t length) {
+  uint64_t key = length;
+  for (size_t i = 0; i < length; i++) key = (key << 8) | addr->address[i];
+  return key;
 }
 
-static void interop_lazy_init_(void) {
-  if (interop_list == NULL) {
-    interop_list = list_new(interop_free_entry_);
-  }
+static void interop_index_addr_(uint16_t feature, const RawAddress* addr,
+                                size_t length) {
+  interop_addr_index[interop_addr_key_(addr, length)] |= interop_mask_t{1}
+                                                         << feature;
+  interop_addr_lengths |= 1 << length;
 }
 
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0) return false;
+static void interop_index_name_(interop_feature_t feature, const char* name,
+                                size_t length) {
+  size_t node = 0;
+  for (size_t i = 0; i < length; i++) {
+    size_t next = 0;
+    for (const auto& child : interop_name_trie[node].children) {
+      if (child.first == name[i]) {
+        next = child.second;
+        break;
+      }
+    }
+    if (next == 0) {
+      next = interop_name_trie.size();
+      interop_name_trie[node].children.emplace_back(name[i], next);
+      interop_name_trie.push_back({});
+    }
+    node = next;
+  }
+  interop_name_trie[node].mask |= interop_mask_t{1} << feature;
+}
 
-  const list_node_t* node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t* entry =
-        static_cast<interop_addr_entry_t*>(list_node(node));
-    CHECK(entry);
+// Compiles the static database, dropping the dynamic entries and the
+// addresses looked up. Called with |interop_mutex| held.
+static void interop_compile_(void) {
+  if (interop_compiled) return;
 
-    if (feature == entry->feature &&
-        memcmp(addr, &entry->addr, entry->length) == 0)
-      return true;
+  interop_addr_index.clear();
+  interop_addr_lengths = 0;
+  interop_addr_cache.clear();
+  for (const interop_addr_entry_t& entry : interop_addr_database) {
+    interop_index_addr_(entry.feature, &entry.addr, entry.length);
+  }
 
-    node = list_next(node);
+  interop_name_trie.clear();
+  interop_name_trie.push_back({});
+  for (const interop_name_entry_t& entry : interop_name_database) {
+    interop_index_name_(entry.feature, entry.name, entry.length);
   }
-  return false;
+
+  interop_compiled = true;
 }
 
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr) {
-  CHECK(addr);
+static interop_mask_t interop_addr_mask_(const RawAddress* addr) {
+  std::lock_guard<std::mutex> lock(interop_mutex);
+  interop_compile_();
 
-  const size_t db_size =
-      sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr,
-               interop_addr_database[i].length) == 0) {
-      return true;
-    }
+  auto cached = interop_addr_cache.find(*addr);
+  if (cached != interop_addr_cache.end()) return cached->second;
+
+  interop_mask_t mask = 0;
+  for (size_t length = 1; length < RawAddress::kLength; length++) {
+    if (!(interop_addr_lengths & (1 << length))) continue;
+    auto entry = interop_addr_index.find(interop_addr_key_(addr, length));
+    if (entry != interop_addr_index.end()) mask |= entry->second;
   }
 
-  return false;
+  if (interop_addr_cache.size() >= INTEROP_ADDR_CACHE_MAX)
+    interop_addr_cache.clear();
+  interop_addr_cache[*addr] = mask;
+  return mask;
+}
+
+static interop_mask_t interop_name_mask_(const char* name) {
+  std::lock_guard<std::mutex> lock(interop_mutex);
+  interop_compile_();
+
+  // Every node on the path of |name| is one of its prefixes
+  interop_mask_t mask = 0;
+  size_t node = 0;
+  for (const char* p = name; *p != '\0'; p++) {
+    size_t next = 0;
+    for (const auto& child : interop_name_trie[node].children) {
+      if (child.first == *p) {
+        next = child.second;
+        break;
+      }
+    }
+    if (next == 0) break;
+    node = next;
+    mask |= interop_name_trie[node].mask;
+  }
+  return mask;
 }
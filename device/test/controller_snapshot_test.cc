@@ -0,0 +1,128 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "device/include/controller_snapshot.h"
+
+namespace {
+
+class ControllerSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir_template[] = "/tmp/controller_snapshot_test.XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    dir_ = dir_template;
+    path_ = dir_ + "/bt_controller_snapshot";
+
+    memset(&snapshot_, 0, sizeof(snapshot_));
+    RawAddress::FromString("00:11:22:33:44:55", snapshot_.address);
+    snapshot_.bt_version = {.hci_version = 0x0b,
+                            .hci_revision = 0x1234,
+                            .lmp_version = 0x0b,
+                            .manufacturer = 0x001d,
+                            .lmp_subversion = 0x5678};
+    snapshot_.supported_commands[0] = 0xff;
+    snapshot_.features_classic[0].as_array[0] = 0xbf;
+    snapshot_.last_features_classic_page_index = 2;
+    snapshot_.acl_data_size_classic = 1021;
+    snapshot_.acl_buffer_count_classic = 8;
+    snapshot_.acl_data_size_ble = 251;
+    snapshot_.ble_resolving_list_max_size = 16;
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    rmdir(dir_.c_str());
+  }
+
+  std::string dir_;
+  std::string path_;
+  controller_snapshot_t snapshot_;
+};
+
+TEST_F(ControllerSnapshotTest, save_and_load) {
+  ASSERT_TRUE(controller_snapshot_save(path_.c_str(), snapshot_));
+
+  controller_snapshot_t loaded;
+  memset(&loaded, 0, sizeof(loaded));
+  ASSERT_TRUE(controller_snapshot_load(path_.c_str(), snapshot_.address,
+                                       snapshot_.bt_version, &loaded));
+  EXPECT_TRUE(controller_snapshot_equals(snapshot_, loaded));
+  EXPECT_EQ(loaded.acl_data_size_classic, 1021);
+  EXPECT_EQ(loaded.ble_resolving_list_max_size, 16);
+}
+
+TEST_F(ControllerSnapshotTest, no_snapshot) {
+  controller_snapshot_t loaded;
+  EXPECT_FALSE(controller_snapshot_load(path_.c_str(), snapshot_.address,
+                                        snapshot_.bt_version, &loaded));
+}
+
+TEST_F(ControllerSnapshotTest, other_controller) {
+  ASSERT_TRUE(controller_snapshot_save(path_.c_str(), snapshot_));
+
+  controller_snapshot_t loaded;
+  RawAddress other_address;
+  RawAddress::FromString("00:11:22:33:44:66", other_address);
+  EXPECT_FALSE(controller_snapshot_load(path_.c_str(), other_address,
+                                        snapshot_.bt_version, &loaded));
+}
+
+TEST_F(ControllerSnapshotTest, other_firmware) {
+  ASSERT_TRUE(controller_snapshot_save(path_.c_str(), snapshot_));
+
+  controller_snapshot_t loaded;
+  bt_version_t other_version = snapshot_.bt_version;
+  other_version.lmp_subversion++;
+  EXPECT_FALSE(controller_snapshot_load(path_.c_str(), snapshot_.address,
+                                        other_version, &loaded));
+}
+
+TEST_F(ControllerSnapshotTest, corrupted_snapshot) {
+  ASSERT_TRUE(controller_snapshot_save(path_.c_str(), snapshot_));
+
+  // Flip a byte in the middle of the capabilities
+  FILE* fp = fopen(path_.c_str(), "r+b");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(fseek(fp, 64, SEEK_SET), 0);
+  int byte = fgetc(fp);
+  ASSERT_EQ(fseek(fp, 64, SEEK_SET), 0);
+  fputc(byte ^ 0xff, fp);
+  fclose(fp);
+
+  controller_snapshot_t loaded;
+  EXPECT_FALSE(controller_snapshot_load(path_.c_str(), snapshot_.address,
+                                        snapshot_.bt_version, &loaded));
+}
+
+TEST_F(ControllerSnapshotTest, truncated_snapshot) {
+  ASSERT_TRUE(controller_snapshot_save(path_.c_str(), snapshot_));
+  ASSERT_EQ(truncate(path_.c_str(), 20), 0);
+
+  controller_snapshot_t loaded;
+  EXPECT_FALSE(controller_snapshot_load(path_.c_str(), snapshot_.address,
+                                        snapshot_.bt_version, &loaded));
+}
+
+}  // namespace
@@ -80,3 +80,29 @@ TEST(InteropTest, test_name_miss) {
   EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "audi"));
   EXPECT_FALSE(interop_match_name(INTEROP_AUTO_RETRY_PAIRING, "BMW M3"));
 }
+
+TEST(InteropTest, test_dynamic_prefix_lengths) {
+  RawAddress test_address;
+  RawAddress::FromString("a1:b2:c3:d4:e5:f6", test_address);
+  interop_database_add(INTEROP_DISABLE_AUTO_PAIRING, &test_address, 1);
+  interop_database_add(INTEROP_AUTO_RETRY_PAIRING, &test_address, 5);
+
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  RawAddress::FromString("a1:00:00:00:00:00", test_address);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+  EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
+
+  // Remembered results must not outlive the dynamic database
+  interop_database_clear();
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_AUTO_PAIRING, &test_address));
+}
+
+TEST(InteropTest, test_name_overlapping_prefixes) {
+  // "Car" and "CAR" are both in the database, lookups are case sensitive
+  EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "CAR-1234"));
+  EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Car"));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Ca"));
+  EXPECT_FALSE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, ""));
+}
@@ -32,6 +32,12 @@
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -263,6 +269,91 @@ static int16_t qmf_coeffs[12] =
 {
        3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
 };
+
+/* Apply the transmit QMF to the 24 sample history |x|. The odd taps run over
+   the even samples, the even taps over the odd samples with the coefficients
+   reversed. The history only holds 16 bit PCM, so the vector paths are bit
+   exact with the plain C one. */
+#if defined(__ARM_NEON) || defined(__SSE2__)
+static int16_t qmf_coeffs_rev[12] =
+{
+     -11,   53, -156,  362, -805, 3876,  951, -210,   32,   12,  -11,    3,
+};
+#endif
+
+#if defined(__ARM_NEON)
+static __inline void transmit_qmf(const int x[24], int *sumeven, int *sumodd)
+{
+    int32x4x2_t x0 = vld2q_s32(x);
+    int32x4x2_t x1 = vld2q_s32(x + 8);
+    int32x4x2_t x2 = vld2q_s32(x + 16);
+    int32x4_t odd;
+    int32x4_t even;
+    int32x2_t sums;
+
+    odd = vmulq_s32(x0.val[0], vmovl_s16(vld1_s16(qmf_coeffs)));
+    odd = vmlaq_s32(odd, x1.val[0], vmovl_s16(vld1_s16(qmf_coeffs + 4)));
+    odd = vmlaq_s32(odd, x2.val[0], vmovl_s16(vld1_s16(qmf_coeffs + 8)));
+    even = vmulq_s32(x0.val[1], vmovl_s16(vld1_s16(qmf_coeffs_rev)));
+    even = vmlaq_s32(even, x1.val[1], vmovl_s16(vld1_s16(qmf_coeffs_rev + 4)));
+    even = vmlaq_s32(even, x2.val[1], vmovl_s16(vld1_s16(qmf_coeffs_rev + 8)));
+    sums = vpadd_s32(vadd_s32(vget_low_s32(odd), vget_high_s32(odd)),
+                     vadd_s32(vget_low_s32(even), vget_high_s32(even)));
+    *sumodd = vget_lane_s32(sums, 0);
+    *sumeven = vget_lane_s32(sums, 1);
+}
+#elif defined(__SSE2__)
+static __inline int horizontal_sum(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+static __inline void transmit_qmf(const int x[24], int *sumeven, int *sumodd)
+{
+    const __m128i *xv = (const __m128i *) x;
+    const __m128i zero = _mm_setzero_si128();
+    __m128i x0 = _mm_packs_epi32(_mm_loadu_si128(xv), _mm_loadu_si128(xv + 1));
+    __m128i x1 = _mm_packs_epi32(_mm_loadu_si128(xv + 2),
+                                 _mm_loadu_si128(xv + 3));
+    __m128i x2 = _mm_packs_epi32(_mm_loadu_si128(xv + 4),
+                                 _mm_loadu_si128(xv + 5));
+    __m128i c0 = _mm_loadu_si128((const __m128i *) qmf_coeffs);
+    __m128i c1 = _mm_loadl_epi64((const __m128i *) (qmf_coeffs + 8));
+    __m128i r0 = _mm_loadu_si128((const __m128i *) qmf_coeffs_rev);
+    __m128i r1 = _mm_loadl_epi64((const __m128i *) (qmf_coeffs_rev + 8));
+    __m128i odd;
+    __m128i even;
+
+    /* Interleave the coefficients with zeros, so that each multiply-add
+       only picks the even or the odd samples */
+    odd = _mm_madd_epi16(x0, _mm_unpacklo_epi16(c0, zero));
+    odd = _mm_add_epi32(odd, _mm_madd_epi16(x1, _mm_unpackhi_epi16(c0, zero)));
+    odd = _mm_add_epi32(odd, _mm_madd_epi16(x2, _mm_unpacklo_epi16(c1, zero)));
+    even = _mm_madd_epi16(x0, _mm_unpacklo_epi16(zero, r0));
+    even = _mm_add_epi32(even,
+                         _mm_madd_epi16(x1, _mm_unpackhi_epi16(zero, r0)));
+    even = _mm_add_epi32(even,
+                         _mm_madd_epi16(x2, _mm_unpacklo_epi16(zero, r1)));
+    *sumodd = horizontal_sum(odd);
+    *sumeven = horizontal_sum(even);
+}
+#else
+static __inline void transmit_qmf(const int x[24], int *sumeven, int *sumodd)
+{
+    int i;
+
+    *sumeven = 0;
+    *sumodd = 0;
+    for (i = 0;  i < 12;  i++)
+    {
+        *sumodd += x[2*i]*qmf_coeffs[i];
+        *sumeven += x[2*i + 1]*qmf_coeffs[11 - i];
+    }
+}
+#endif
+
 static int16_t ihn[3] = {0, 1, 0};
 static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
@@ -317,13 +408,7 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
                 s->x[23] = amp[j++];
     
                 /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
+                transmit_qmf(s->x, &sumeven, &sumodd);
                 /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
                    to allow for us summing two filters, plus 1 to allow for the 15 bit
                    input to the G.722 algorithm. */
@@ -79,6 +79,7 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_mSBC_SYNCWORD 0xad
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -237,6 +238,8 @@ typedef struct {
   uint8_t limitFrameFormat;
   uint8_t restrictSubbands;
   uint8_t enhancedEnabled;
+  /* Boolean, set by OI_CODEC_SBC_DecoderConfigureMSbc() */
+  uint8_t mSbcEnabled;
   uint8_t bufferedBlocks;
 } OI_CODEC_SBC_DECODER_CONTEXT;
 
@@ -297,6 +300,19 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
 OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                     OI_BOOL enhanced, uint8_t subbands);
 
+/**
+ * This function configures the decoder for mSBC, the frame format of the HFP
+ * wide band speech. Its headers carry no parameters: every frame is 16 kHz
+ * mono, 8 subbands, 15 blocks, loudness allocation and bitpool 26. After it is
+ * called, OI_CODEC_SBC_DecodeFrame() only looks for mSBC syncwords, until the
+ * next call to OI_CODEC_SBC_DecoderReset().
+ *
+ * @param context   Pointer to the decoder context structure, reset with
+ *                  OI_CODEC_SBC_DecoderReset() beforehand.
+ */
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMSbc(
+    OI_CODEC_SBC_DECODER_CONTEXT* context);
+
 /**
  * This function sets the decoder parameters for a raw decode where the decoder
  * parameters are not available in the sbc data stream.
@@ -395,6 +411,39 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    uint32_t* frameBytes, int16_t* pcmData,
                                    uint32_t* pcmBytes);
 
+/**
+ * Decode up to frameCount consecutive SBC frames, such as the frames of one
+ * A2DP media packet, writing their audio data back to back.
+ *
+ * @param context       Pointer to a decoder context structure. The same context
+ *                      must be used each time when decoding from the same
+ *                      stream.
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      successfully decoded.
+ *
+ * @param frameBytes    Pointer to a uint32_t containing the number of available
+ *                      bytes of frame data. This value will be updated to
+ *                      reflect the number of bytes remaining.
+ *
+ * @param frameCount    Number of frames to decode.
+ *
+ * @param pcmData       Address of an array of int16_t pairs, which will be
+ *                      populated with the decoded audio data. This address
+ *                      is not updated.
+ *
+ * @param pcmBytes      Pointer to a uint32_t in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the number of bytes
+ *                      written by the frames successfully decoded, including
+ *                      when an error is returned for a later frame.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, uint8_t frameCount,
+                                    int16_t* pcmData, uint32_t* pcmBytes);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
@@ -176,6 +176,14 @@ PRIVATE void OI_SBC_ComputeBitAllocation(OI_CODEC_SBC_COMMON_CONTEXT* frame);
 PRIVATE uint8_t OI_SBC_CalculateChecksum(OI_CODEC_SBC_FRAME_INFO* frame,
                                          OI_BYTE const* data);
 
+/** Per subband constants of OI_SBC_Dequant(), which only change from one frame
+ * to the next, so that a whole block can be dequantized at once. */
+typedef struct {
+  uint32_t mult[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+  uint32_t offset[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+  int32_t shift[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+} OI_SBC_DEQUANT_PARAMS;
+
 /* Transform functions */
 PRIVATE void shift_buffer(SBC_BUFFER_T* dest, SBC_BUFFER_T* src,
                           OI_UINT wordCount);
@@ -215,6 +223,13 @@ PRIVATE void OI_SBC_SynthFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                int16_t* pcm, OI_UINT start_block,
                                OI_UINT nrof_blocks);
 INLINE int32_t OI_SBC_Dequant(uint32_t raw, OI_UINT scale_factor, OI_UINT bits);
+PRIVATE void OI_SBC_DequantPrepare(OI_SBC_DEQUANT_PARAMS* params,
+                                   const int8_t* scale_factor,
+                                   const uint8_t* bits, OI_UINT count);
+PRIVATE void OI_SBC_DequantBlock(int32_t* RESTRICT out,
+                                 const uint32_t* RESTRICT raw,
+                                 const OI_SBC_DEQUANT_PARAMS* params,
+                                 OI_UINT count);
 PRIVATE OI_BOOL OI_SBC_ExamineCommandPacket(
     OI_CODEC_SBC_DECODER_CONTEXT* context, const OI_BYTE* data, uint32_t len);
 PRIVATE void OI_SBC_GenerateTestSignal(int16_t pcmData[][2],
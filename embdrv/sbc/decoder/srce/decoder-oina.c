@@ -114,6 +114,14 @@ OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return OI_OK;
 }
 
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMSbc(
+    OI_CODEC_SBC_DECODER_CONTEXT* context) {
+  context->enhancedEnabled = FALSE;
+  context->limitFrameFormat = FALSE;
+  context->mSbcEnabled = TRUE;
+  return OI_OK;
+}
+
 /**
 @}
 */
@@ -73,6 +73,7 @@ INLINE OI_STATUS internal_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->common.codecInfo = OI_Codec_Copyright;
   context->common.maxBitneed = 0;
   context->limitFrameFormat = FALSE;
+  context->mSbcEnabled = FALSE;
   OI_SBC_ExpandFrameFields(&context->common.frameInfo);
 
   /*PLATFORM_DECODER_RESET(context);*/
@@ -90,7 +91,27 @@ INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
   OI_CODEC_SBC_FRAME_INFO* frame = &common->frameInfo;
   uint8_t d1;
 
-  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD);
+  OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD ||
+            data[0] == OI_mSBC_SYNCWORD);
+
+  /* mSBC headers carry no parameters. The fields match the cached header of
+   * 16 kHz mono 8 subbands 16 blocks loudness frames but for the number of
+   * blocks, DecoderReset restores it before the decoder accepts SBC again */
+  if (data[0] == OI_mSBC_SYNCWORD) {
+    frame->freqIndex = SBC_FREQ_16000;
+    frame->frequency = freq_values[frame->freqIndex];
+    frame->blocks = SBC_BLOCKS_16;
+    frame->nrof_blocks = 15;
+    frame->mode = SBC_MONO;
+    frame->nrof_channels = channel_values[frame->mode];
+    frame->alloc = SBC_LOUDNESS;
+    frame->subbands = SBC_SUBBANDS_8;
+    frame->nrof_subbands = band_values[frame->subbands];
+    frame->cachedInfo = (SBC_BLOCKS_16 << 4) | SBC_SUBBANDS_8;
+    frame->bitpool = 26;
+    frame->crc = data[3];
+    return;
+  }
 
   /* Avoid filling out all these strucutures if we already remember the values
    * from last time. Just in case we get a stream corresponding to data[1] ==
@@ -185,21 +206,23 @@ PRIVATE void OI_SBC_ReadSamples(OI_CODEC_SBC_DECODER_CONTEXT* context,
   OI_UINT bitPtr = global_bs->bitPtr;
   const OI_UINT iter_count =
       common->frameInfo.nrof_channels * common->frameInfo.nrof_subbands;
+  OI_SBC_DEQUANT_PARAMS dequant;
+  uint32_t raw[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+
+  OI_SBC_DequantPrepare(&dequant, common->scale_factor, common->bits.uint8,
+                        iter_count);
   do {
     OI_UINT n;
     for (n = 0; n < iter_count; ++n) {
-      int32_t dequant;
       OI_UINT bits = common->bits.uint8[n];
-      OI_INT sf = common->scale_factor[n];
       if (bits) {
-        uint32_t raw;
-        OI_BITSTREAM_READUINT(raw, bits, ptr, value, bitPtr);
-        dequant = OI_SBC_Dequant(raw, sf, bits);
+        OI_BITSTREAM_READUINT(raw[n], bits, ptr, value, bitPtr);
       } else {
-        dequant = 0;
+        raw[n] = 0;
       }
-      *s++ = dequant;
     }
+    OI_SBC_DequantBlock(s, raw, &dequant, iter_count);
+    s += iter_count;
   } while (--nrof_blocks);
 }
 
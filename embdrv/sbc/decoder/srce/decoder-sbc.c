@@ -42,7 +42,8 @@
 /**
  * Scans through a buffer looking for a codec syncword. If the decoder has been
  * set for enhanced operation using OI_CODEC_SBC_DecoderReset(), it will search
- * for both a standard and an enhanced syncword.
+ * for both a standard and an enhanced syncword. If it has been configured for
+ * mSBC, it only searches for an mSBC syncword.
  */
 PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                const OI_BYTE** frameData,
@@ -56,6 +57,18 @@ PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
     return OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA;
   }
 
+  if (context->mSbcEnabled) {
+    while (*frameBytes && (**frameData != OI_mSBC_SYNCWORD)) {
+      (*frameBytes)--;
+      (*frameData)++;
+    }
+    if (*frameBytes == 0) {
+      return OI_CODEC_SBC_NO_SYNCWORD;
+    }
+    context->common.frameInfo.enhanced = FALSE;
+    return OI_OK;
+  }
+
 #ifdef SBC_ENHANCED
   if (context->limitFrameFormat && context->enhancedEnabled) {
     /* If the context is restricted, only search for specified SYNCWORD */
@@ -350,6 +363,28 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, uint8_t frameCount,
+                                    int16_t* pcmData, uint32_t* pcmBytes) {
+  OI_STATUS status = OI_OK;
+  uint32_t pcmAvail = *pcmBytes;
+  uint8_t i;
+
+  for (i = 0; i < frameCount; i++) {
+    uint32_t frameOut = pcmAvail;
+    status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes, pcmData,
+                                      &frameOut);
+    if (!OI_SUCCESS(status)) {
+      break;
+    }
+    pcmAvail -= frameOut;
+    pcmData += frameOut / sizeof(int16_t);
+  }
+  *pcmBytes -= pcmAvail;
+  return status;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                  const OI_BYTE** frameData,
                                  uint32_t* frameBytes) {
@@ -105,6 +105,10 @@
 
 #include <oi_codec_sbc_private.h>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #ifndef SBC_DEQUANT_LONG_SCALED_OFFSET
 #define SBC_DEQUANT_LONG_SCALED_OFFSET 1555931970
 #endif
@@ -180,6 +184,59 @@ INLINE int32_t OI_SBC_Dequant(uint32_t raw, OI_UINT scale_factor,
   return result >> (15 - scale_factor);
 }
 
+/**
+ OI_SBC_Dequant() split into the constants derived from the scale factor and
+ bit allocation of each subband, computed once per frame by
+ OI_SBC_DequantPrepare(), and the per sample arithmetic, applied to a block at
+ a time by OI_SBC_DequantBlock(). The results are identical. Subbands with no
+ more than one bit get a zero multiplier and offset so that they dequantize to
+ zero without a branch.
+ */
+PRIVATE void OI_SBC_DequantPrepare(OI_SBC_DEQUANT_PARAMS* params,
+                                   const int8_t* scale_factor,
+                                   const uint8_t* bits, OI_UINT count) {
+  OI_UINT i;
+
+  for (i = 0; i < count; i++) {
+    OI_ASSERT(scale_factor[i] <= 15);
+    OI_ASSERT(bits[i] <= 16);
+
+    if (bits[i] <= 1) {
+      params->mult[i] = 0;
+      params->offset[i] = 0;
+    } else {
+      params->mult[i] = dequant_long_scaled[bits[i]];
+      params->offset[i] = SBC_DEQUANT_LONG_SCALED_OFFSET;
+    }
+    params->shift[i] = 15 - scale_factor[i];
+  }
+}
+
+/** Dequantizes |count| raw samples, where |count| is a multiple of 4. */
+PRIVATE void OI_SBC_DequantBlock(int32_t* RESTRICT out,
+                                 const uint32_t* RESTRICT raw,
+                                 const OI_SBC_DEQUANT_PARAMS* params,
+                                 OI_UINT count) {
+  OI_UINT i;
+
+#if defined(__ARM_NEON)
+  for (i = 0; i < count; i += 4) {
+    uint32x4_t d = vmlaq_u32(vdupq_n_u32(1), vld1q_u32(raw + i),
+                             vdupq_n_u32(2));
+    d = vmulq_u32(d, vld1q_u32(params->mult + i));
+    d = vsubq_u32(d, vld1q_u32(params->offset + i));
+    /* vshlq_s32() shifts right by the negated count */
+    vst1q_s32(out + i, vshlq_s32(vreinterpretq_s32_u32(d),
+                                 vnegq_s32(vld1q_s32(params->shift + i))));
+  }
+#else
+  for (i = 0; i < count; i++) {
+    uint32_t d = ((raw[i] * 2) + 1) * params->mult[i];
+    out[i] = (int32_t)(d - params->offset[i]) >> params->shift[i];
+  }
+#endif
+}
+
 /* This version of Dequant does not incorporate the scaling factor of 1.38. It
  * is intended for use with implementations of the filterbank which are
  * hard-coded into a DSP. Output is Q16.4 format, so that after joint stereo
@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ @file
+
+ NEON version of SynthWindow80_generated(), bit exact with it.
+
+ Output j, for j = 0..3, and output 8-j, for j = 1..4, both accumulate
+ buffer[16p+4+j] and buffer[16p+12-j] for p = 0..4, each term being a 16x16
+ bit product shifted by its own amount. Outputs 0..3 and 4..7 are therefore
+ computed four at a time from two contiguous loads per group of 16 buffer
+ entries, one of which is reversed. The tables below hold, for each p, the
+ coefficients and shifts of the generated code in that lane order, zero where
+ a lane has no term:
+
+ @code
+    [ 0.. 3] buffer[16p+4..7]      -> outputs 0..3
+    [ 4.. 7] buffer[16p+12..9]     -> outputs 0..3
+    [ 8..11] buffer[16p+8..5]      -> outputs 4..7
+    [12..15] buffer[16p+8..11]     -> outputs 4..7
+ @endcode
+
+ @ingroup codec_internal
+ */
+
+/**
+@addtogroup codec_internal
+@{
+*/
+
+#include <oi_codec_sbc_private.h>
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+static const int16_t synth80_coef[5][16] = {
+    {0, -3263, -10385, -16457,
+     8235, 29293, 24995, 19083,
+     10445, 16913, 11167, 9293,
+     0, -8443, -10337, -6087},
+    {-23167, -5229, -309, -23641,
+     26479, 30835, 9161, -29015,
+     -5297, 3687, 1917, 1247,
+     0, -301, -30605, -2893},
+    {-17397, -27021, -23063, -12889,
+     9399, 31633, 27561, 6145,
+     22299, 15447, 8317, 23671,
+     0, 10255, 9553, 18055},
+    {17397, 17319, 2309, 24211,
+     26479, 26663, 12705, 23469,
+     10603, -18233, 22117, 11537,
+     0, 9405, 16383, 1747},
+    {23167, 4555, 6239, 21223,
+     8235, 12419, 9251, 26913,
+     9539, 1499, 7543, 685,
+     0, 26189, 8603, 8721},
+};
+
+/* Positive values shift left, negative values shift right */
+static const int32_t synth80_shift[5][16] = {
+    {0, -5, -6, -6,
+     -3, -5, -5, -5,
+     -4, -5, -4, -3,
+     0, -7, -4, -2},
+    {-3, 0, 4, -2,
+     -2, -3, -3, -4,
+     1, 1, 2, 3,
+     0, 5, -1, 3},
+    {1, 1, 1, 2,
+     3, 1, 1, 3,
+     2, 2, 3, 2,
+     0, 2, 2, 1},
+    {1, 1, 3, -1,
+     -2, -2, -1, -2,
+     0, -3, -4, -1,
+     0, -1, -2, 1},
+    {-3, -1, -3, -8,
+     -3, -4, -4, -6,
+     -4, -1, -3, 1,
+     0, -7, -6, -7},
+};
+
+static inline int32x4_t synth80_term(int32x4_t acc, int16x4_t x,
+                                     const int16_t* coef,
+                                     const int32_t* shift) {
+  return vaddq_s32(
+      acc, vshlq_s32(vmull_s16(x, vld1_s16(coef)), vld1q_s32(shift)));
+}
+
+/* pcm / 32768 rounded towards zero, then clipped to 16 bits */
+static inline int16x4_t synth80_output(int32x4_t pcm) {
+  uint32x4_t bias =
+      vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(pcm, 31)), 17);
+  return vqmovn_s32(
+      vshrq_n_s32(vaddq_s32(pcm, vreinterpretq_s32_u32(bias)), 15));
+}
+
+PRIVATE void SynthWindow80_neon(int16_t* pcm,
+                                SBC_BUFFER_T const* RESTRICT buffer,
+                                OI_UINT strideShift) {
+  int32x4_t pcm_a = vdupq_n_s32(0);
+  int32x4_t pcm_b = vdupq_n_s32(0);
+  int16_t out[8];
+  OI_UINT p;
+  OI_UINT i;
+
+  for (p = 0; p < 5; p++) {
+    SBC_BUFFER_T const* x = buffer + 16 * p;
+    const int16_t* coef = synth80_coef[p];
+    const int32_t* shift = synth80_shift[p];
+
+    pcm_a = synth80_term(pcm_a, vld1_s16(x + 4), coef, shift);
+    pcm_a = synth80_term(pcm_a, vrev64_s16(vld1_s16(x + 9)), coef + 4,
+                         shift + 4);
+    pcm_b = synth80_term(pcm_b, vrev64_s16(vld1_s16(x + 5)), coef + 8,
+                         shift + 8);
+    pcm_b = synth80_term(pcm_b, vld1_s16(x + 8), coef + 12, shift + 12);
+  }
+
+  if (strideShift == 0) {
+    vst1_s16(pcm, synth80_output(pcm_a));
+    vst1_s16(pcm + 4, synth80_output(pcm_b));
+  } else {
+    vst1_s16(out, synth80_output(pcm_a));
+    vst1_s16(out + 4, synth80_output(pcm_b));
+    for (i = 0; i < 8; i++) {
+      pcm[i << strideShift] = out[i];
+    }
+  }
+}
+
+#endif /* __ARM_NEON */
+
+/**
+@}
+*/
@@ -265,6 +265,13 @@ typedef void (*SYNTH_FRAME)(OI_CODEC_SBC_DECODER_CONTEXT* context, int16_t* pcm,
 #define DCT2_8(dst, src) dct2_8(dst, src)
 #endif
 
+#if defined(__ARM_NEON)
+PRIVATE void SynthWindow80_neon(int16_t* pcm,
+                                SBC_BUFFER_T const* RESTRICT buffer,
+                                OI_UINT strideShift);
+#define SYNTH80 SynthWindow80_neon
+#endif
+
 #ifndef SYNTH80
 #define SYNTH80 SynthWindow80_generated
 #endif
@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "embdrv/sbc/decoder/include/oi_codec_sbc.h"
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumFrames = 64;
+/* A2DP media packets carry at most 15 SBC frames */
+constexpr int kFramesPerPacket = 15;
+
+/* Encodes kNumFrames frames of a 1kHz tone on the left channel and a 440Hz
+ * tone on the right, at 44.1kHz */
+std::vector<uint8_t> BuildReferenceStream(int subbands, int blocks, int mode,
+                                          int bitpool) {
+  SBC_ENC_PARAMS params = {};
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16NumOfSubBands = subbands;
+  params.s16NumOfBlocks = blocks;
+  params.s16ChannelMode = mode;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = bitpool;
+
+  size_t samples_per_frame = subbands * blocks;
+  std::vector<int16_t> pcm(samples_per_frame * 2);
+  std::vector<uint8_t> stream(kNumFrames * SBC_MAX_FRAME_LEN);
+  size_t stream_len = 0;
+  size_t t = 0;
+  for (int frame = 0; frame < kNumFrames; frame++) {
+    for (size_t i = 0; i < samples_per_frame; i++, t++) {
+      pcm[2 * i] = 16384 * std::sin(2 * M_PI * 1000 * t / 44100);
+      pcm[2 * i + 1] = 16384 * std::sin(2 * M_PI * 440 * t / 44100);
+    }
+    stream_len += SBC_Encode(&params, pcm.data(), stream.data() + stream_len);
+  }
+  stream.resize(stream_len);
+  return stream;
+}
+
+/* Arguments: number of subbands, number of blocks, channel mode, bitpool.
+ * Decodes packets of kFramesPerPacket frames like the A2DP sink does. */
+void BM_SbcDecode(benchmark::State& state) {
+  int subbands = state.range(0);
+  int blocks = state.range(1);
+  std::vector<uint8_t> stream =
+      BuildReferenceStream(subbands, blocks, state.range(2), state.range(3));
+  size_t frame_len = stream.size() / kNumFrames;
+
+  OI_CODEC_SBC_DECODER_CONTEXT context;
+  uint32_t context_data[CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS)];
+  std::vector<int16_t> pcm(kFramesPerPacket * SBC_MAX_SAMPLES_PER_FRAME *
+                           SBC_MAX_CHANNELS);
+  OI_CODEC_SBC_DecoderReset(&context, context_data, sizeof(context_data), 2, 2,
+                            false);
+
+  size_t frame = 0;
+  for (auto _ : state) {
+    if (frame + kFramesPerPacket > kNumFrames) frame = 0;
+    const OI_BYTE* data = stream.data() + frame * frame_len;
+    uint32_t data_len = kFramesPerPacket * frame_len;
+    uint32_t pcm_len = pcm.size() * sizeof(int16_t);
+    OI_STATUS status = OI_CODEC_SBC_DecodeFrames(
+        &context, &data, &data_len, kFramesPerPacket, pcm.data(), &pcm_len);
+    if (!OI_SUCCESS(status)) {
+      state.SkipWithError("OI_CODEC_SBC_DecodeFrames failed");
+      break;
+    }
+    frame += kFramesPerPacket;
+  }
+  state.SetItemsProcessed(state.iterations() * kFramesPerPacket * subbands *
+                          blocks);
+}
+
+void SbcDecodeArguments(benchmark::internal::Benchmark* b) {
+  for (int subbands : {SUB_BANDS_4, SUB_BANDS_8}) {
+    for (int blocks : {4, 8, 12, 16}) {
+      for (int mode : {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+        /* Bitpools of the A2DP middle and high quality SBC configurations */
+        for (int bitpool : {35, 53}) {
+          if (mode == SBC_MONO || mode == SBC_DUAL) {
+            b->Args({subbands, blocks, mode, bitpool / 2});
+          } else {
+            b->Args({subbands, blocks, mode, bitpool});
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SbcDecode)->Apply(SbcDecodeArguments);
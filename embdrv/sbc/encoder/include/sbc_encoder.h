@@ -63,6 +63,18 @@
 #define SBC_BLOCK_2 12
 #define SBC_BLOCK_3 16
 
+/* Frame formats: A2DP SBC, or the mSBC of the HFP wide band speech. mSBC
+ * frames are 16 kHz mono, 8 subbands, 15 blocks, loudness and bitpool 26 */
+#define SBC_FORMAT_GENERAL 0
+#define SBC_FORMAT_MSBC 1
+
+#define SBC_MSBC_SYNC_WORD 0xAD
+#define SBC_MSBC_NUM_OF_BLOCKS 15
+#define SBC_MSBC_BITPOOL 26
+/* Number of bytes of an mSBC frame, and of the PCM samples it encodes */
+#define SBC_MSBC_FRAME_LEN 57
+#define SBC_MSBC_PCM_SAMPLES (SBC_MSBC_NUM_OF_BLOCKS * SUB_BANDS_8)
+
 #define SBC_NULL 0
 
 #ifndef SBC_MAX_NUM_FRAME
@@ -113,6 +125,21 @@
 #define SBC_IS_64_MULT_IN_WINDOW_ACCU FALSE
 #endif /*SBC_IS_64_MULT_IN_WINDOW_ACCU */
 
+/* Set SBC_SIMD_OPT to TRUE to compute the windowing with SSE2 or NEON
+ * intrinsics. The output is bit exact with the SBC_IPAQ_OPT windowing it
+ * replaces. Both instruction sets are mandatory on x86-64, arm64 and Android
+ * armv7 targets, so it is enabled at build time without runtime detection.
+ */
+#ifndef SBC_SIMD_OPT
+#if (SBC_IPAQ_OPT == TRUE && SBC_ARM_ASM_OPT == FALSE && \
+     SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE) &&         \
+    (defined(__SSE2__) || defined(__ARM_NEON))
+#define SBC_SIMD_OPT TRUE
+#else
+#define SBC_SIMD_OPT FALSE
+#endif
+#endif /* SBC_SIMD_OPT */
+
 /* Set SBC_IS_64_MULT_IN_IDCT to TRUE to use 64 bits multiplication in the DCT
  * of Matrixing
  */
@@ -185,6 +212,9 @@ typedef struct SBC_ENC_PARAMS_TAG {
 
   uint16_t FrameHeader;
 
+  /* SBC_FORMAT_GENERAL or SBC_FORMAT_MSBC, mSBC overrides the other
+   * parameters in SBC_Encoder_Init() */
+  uint8_t Format;
 } SBC_ENC_PARAMS;
 
 #ifdef __cplusplus
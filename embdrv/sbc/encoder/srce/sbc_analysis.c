@@ -26,6 +26,13 @@
 #include "sbc_enc_func_declare.h"
 #include "sbc_encoder.h"
 /*#include <math.h>*/
+#if (SBC_SIMD_OPT == TRUE)
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
 
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
 #define WIND_4_SUBBANDS_0_1                                              \
@@ -274,7 +281,118 @@ static int16_t* s16X =
     }                                                            \
   }
 
-#if (SBC_ARM_ASM_OPT == TRUE)
+#if (SBC_SIMD_OPT == TRUE)
+/* The WIND_x_SUBBANDS_i_j coefficients laid out so that each s32DCTY[i] is the
+ * dot product of column i with s16X[ChOffset + i + j * n], j = 0..4, where n is
+ * twice the number of subbands. The outputs are then computed side by side. */
+static const int16_t gas16WindowFor4SBs[5 * 8] = {
+    /* s16X[ChOffset + i] */
+    0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4,
+    WIND_4_SUBBANDS_1_4,
+    /* s16X[ChOffset + i + 8] */
+    WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1,
+    WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3,
+    WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3,
+    /* s16X[ChOffset + i + 16] */
+    WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2,
+    WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2,
+    WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2,
+    /* s16X[ChOffset + i + 24] */
+    -WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3,
+    WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1,
+    WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1,
+    /* s16X[ChOffset + i + 32] */
+    -WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4,
+    WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0,
+    WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0,
+};
+
+static const int16_t gas16WindowFor8SBs[5 * 16] = {
+    /* s16X[ChOffset + i] */
+    0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0,
+    WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4,
+    WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_4_4,
+    WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4,
+    /* s16X[ChOffset + i + 16] */
+    WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_1_3,
+    /* s16X[ChOffset + i + 32] */
+    WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_8_2,
+    WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+    WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2,
+    WIND_8_SUBBANDS_1_2,
+    /* s16X[ChOffset + i + 48] */
+    -WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3,
+    WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3,
+    WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_8_1,
+    WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+    WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1,
+    WIND_8_SUBBANDS_1_1,
+    /* s16X[ChOffset + i + 64] */
+    -WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4,
+    WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4,
+    WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_8_0,
+    WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+    WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0,
+    WIND_8_SUBBANDS_1_0,
+};
+
+static void sbc_window_simd(const int16_t* x, const int16_t* coef, int32_t n) {
+  int32_t i;
+#if defined(__ARM_NEON)
+  for (i = 0; i < n; i += 4) {
+    int32x4_t acc = vmull_s16(vld1_s16(x + i), vld1_s16(coef + i));
+    acc = vmlal_s16(acc, vld1_s16(x + i + n), vld1_s16(coef + i + n));
+    acc = vmlal_s16(acc, vld1_s16(x + i + 2 * n), vld1_s16(coef + i + 2 * n));
+    acc = vmlal_s16(acc, vld1_s16(x + i + 3 * n), vld1_s16(coef + i + 3 * n));
+    acc = vmlal_s16(acc, vld1_s16(x + i + 4 * n), vld1_s16(coef + i + 4 * n));
+    vst1q_s32(s32DCTY + i, acc);
+  }
+#else
+  const __m128i zero = _mm_setzero_si128();
+  for (i = 0; i < n; i += 8) {
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(x + i));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(x + i + n));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(x + i + 2 * n));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(x + i + 3 * n));
+    __m128i x4 = _mm_loadu_si128((const __m128i*)(x + i + 4 * n));
+    __m128i c0 = _mm_loadu_si128((const __m128i*)(coef + i));
+    __m128i c1 = _mm_loadu_si128((const __m128i*)(coef + i + n));
+    __m128i c2 = _mm_loadu_si128((const __m128i*)(coef + i + 2 * n));
+    __m128i c3 = _mm_loadu_si128((const __m128i*)(coef + i + 3 * n));
+    __m128i c4 = _mm_loadu_si128((const __m128i*)(coef + i + 4 * n));
+    /* pair the taps so that each madd sums two of them per output */
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(x0, x1),
+                                _mm_unpacklo_epi16(c0, c1));
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(x0, x1),
+                                _mm_unpackhi_epi16(c0, c1));
+    lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x2, x3),
+                                          _mm_unpacklo_epi16(c2, c3)));
+    hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x2, x3),
+                                          _mm_unpackhi_epi16(c2, c3)));
+    lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x4, zero),
+                                          _mm_unpacklo_epi16(c4, zero)));
+    hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x4, zero),
+                                          _mm_unpackhi_epi16(c4, zero)));
+    _mm_storeu_si128((__m128i*)(s32DCTY + i), lo);
+    _mm_storeu_si128((__m128i*)(s32DCTY + i + 4), hi);
+  }
+#endif
+}
+
+#define WINDOW_PARTIAL_4                                        \
+  { sbc_window_simd(s16X + ChOffset, gas16WindowFor4SBs, 8); }
+#define WINDOW_PARTIAL_8                                         \
+  { sbc_window_simd(s16X + ChOffset, gas16WindowFor8SBs, 16); }
+#elif (SBC_ARM_ASM_OPT == TRUE)
 #define WINDOW_ACCU_8_0                                                                                                                                                                                      \
   {                                                                                                                                                                                                          \
     __asm {\
@@ -1199,7 +1317,8 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t Offset, Offset2, ChOffset;
-#if (SBC_ARM_ASM_OPT == TRUE)
+#if (SBC_SIMD_OPT == TRUE)
+#elif (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
 #if (SBC_IPAQ_OPT == TRUE)
@@ -1290,7 +1409,8 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t ChOffset;
-#if (SBC_ARM_ASM_OPT == TRUE)
+#if (SBC_SIMD_OPT == TRUE)
+#elif (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
 #if (SBC_IPAQ_OPT == TRUE)
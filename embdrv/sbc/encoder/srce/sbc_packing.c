@@ -80,10 +80,18 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
 #endif
 
   pu8PacketPtr = output;           /*Initialize the ptr*/
-  *pu8PacketPtr++ = (uint8_t)0x9C; /*Sync word*/
-  *pu8PacketPtr++ = (uint8_t)(pstrEncParams->FrameHeader);
+  if (pstrEncParams->Format == SBC_FORMAT_MSBC) {
+    /* Sync word and the two reserved bytes, covered by the CRC as the header
+     * of SBC frames are */
+    *pu8PacketPtr++ = (uint8_t)SBC_MSBC_SYNC_WORD;
+    *pu8PacketPtr++ = 0;
+    *pu8PacketPtr = 0;
+  } else {
+    *pu8PacketPtr++ = (uint8_t)0x9C; /*Sync word*/
+    *pu8PacketPtr++ = (uint8_t)(pstrEncParams->FrameHeader);
 
-  *pu8PacketPtr = (uint8_t)(pstrEncParams->s16BitPool & 0x00FF);
+    *pu8PacketPtr = (uint8_t)(pstrEncParams->s16BitPool & 0x00FF);
+  }
   pu8PacketPtr += 2; /*skip for CRC*/
 
   /*here it indicate if it is byte boundary or nibble boundary*/
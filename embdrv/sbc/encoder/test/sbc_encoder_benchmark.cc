@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumFrames = 64;
+constexpr int kMaxFrameSize = 512;
+
+/* Two channels of interleaved 44.1kHz PCM: a 1kHz tone on the left and a
+ * 440Hz tone on the right, both at -6dBFS, so that every subband and the
+ * joint stereo decision see non trivial content */
+std::vector<int16_t> BuildReferencePcm(size_t samples_per_channel) {
+  std::vector<int16_t> pcm(samples_per_channel * 2);
+  for (size_t i = 0; i < samples_per_channel; i++) {
+    double t = static_cast<double>(i) / 44100;
+    pcm[2 * i] = static_cast<int16_t>(16384 * std::sin(2 * M_PI * 1000 * t));
+    pcm[2 * i + 1] = static_cast<int16_t>(16384 * std::sin(2 * M_PI * 440 * t));
+  }
+  return pcm;
+}
+
+/* Arguments: number of subbands, number of blocks, channel mode, bitpool */
+void BM_SbcEncode(benchmark::State& state) {
+  SBC_ENC_PARAMS params = {};
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16NumOfSubBands = state.range(0);
+  params.s16NumOfBlocks = state.range(1);
+  params.s16ChannelMode = state.range(2);
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  SBC_Encoder_Init(&params);
+  /* SBC_Encoder_Init() derives the bitpool from u16BitRate, override it */
+  params.s16BitPool = state.range(3);
+
+  size_t samples_per_frame = params.s16NumOfSubBands * params.s16NumOfBlocks;
+  std::vector<int16_t> pcm = BuildReferencePcm(samples_per_frame * kNumFrames);
+  /* SBC_Encode() reads interleaved samples, one channel only in mono */
+  size_t pcm_step = samples_per_frame * params.s16NumOfChannels;
+  uint8_t output[kMaxFrameSize];
+  size_t frame = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(SBC_Encode(
+        &params, pcm.data() + (frame++ % kNumFrames) * pcm_step, output));
+  }
+  state.SetItemsProcessed(state.iterations() * samples_per_frame);
+}
+
+void SbcEncodeArguments(benchmark::internal::Benchmark* b) {
+  for (int subbands : {SUB_BANDS_4, SUB_BANDS_8}) {
+    for (int blocks : {4, 8, 12, 16}) {
+      for (int mode : {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO}) {
+        /* A2DP v1.3.2 section 4.3.2: the bitpool is bounded by 16 * subbands
+         * per channel in mono and dual channel modes, by 32 * subbands for
+         * both channels together otherwise, and never exceeds 250 */
+        int max_bitpool = (mode == SBC_MONO || mode == SBC_DUAL)
+                              ? 16 * subbands
+                              : std::min(32 * subbands, 250);
+        for (int bitpool : {2, 35, 53, max_bitpool}) {
+          if (bitpool > max_bitpool) continue;
+          b->Args({subbands, blocks, mode, bitpool});
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SbcEncode)->Apply(SbcEncodeArguments);
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "btaa/activity_attribution.h"
+#include "hci/address.h"
+
+namespace bluetooth {
+namespace activity_attribution {
+
+// Activity aggregated per device and activity in fixed memory, however many devices are seen, e.g. while scanning.
+// Entries live in an open addressing table: a new entry takes a free slot among the kMaxProbes slots following its
+// hash, or replaces the entry with the fewest bytes among them.
+class DeviceActivityTable {
+ public:
+  // Power of two
+  static constexpr size_t kCapacity = 256;
+  static constexpr size_t kMaxProbes = 8;
+
+  // Return the entry of |address| and |activity|, created with |now| as its creation time if there is none
+  BtaaAggregationEntry& Get(const hci::Address& address, Activity activity, CreationTime now);
+
+  std::vector<BtaaAggregationEntry> GetEntries() const;
+  size_t Size() const;
+  // Number of entries replaced by another device or activity since the creation of the table
+  uint64_t GetNumEvicted() const;
+  void Clear();
+
+ private:
+  struct Slot {
+    bool used = false;
+    BtaaAggregationEntry entry;
+  };
+
+  static size_t Hash(const hci::Address& address, Activity activity);
+
+  std::array<Slot, kCapacity> slots_;
+  size_t size_ = 0;
+  uint64_t num_evicted_ = 0;
+};
+
+// Totals per activity of all devices, rolled up in time buckets. The buckets are reused in turn, so the last
+// kNumTimeBuckets periods of kTimeBucketDuration are kept.
+class ActivityRollup {
+ public:
+  static constexpr size_t kNumTimeBuckets = 24;
+  static constexpr std::chrono::hours kTimeBucketDuration{1};
+  static constexpr size_t kNumActivities = static_cast<size_t>(Activity::VENDOR) + 1;
+
+  struct ActivityTotals {
+    uint32_t wakeup_count = 0;
+    uint32_t byte_count = 0;
+    uint32_t wakelock_duration_ms = 0;
+  };
+
+  struct TimeBucket {
+    CreationTime start_time;
+    std::array<ActivityTotals, kNumActivities> activities;
+  };
+
+  void Add(
+      Activity activity, uint32_t wakeup_count, uint32_t byte_count, uint32_t wakelock_duration_ms, CreationTime now);
+
+  // The buckets used within the last kNumTimeBuckets periods, oldest first
+  std::vector<TimeBucket> GetTimeBuckets(CreationTime now) const;
+
+ private:
+  struct Bucket {
+    bool used = false;
+    TimeBucket time_bucket;
+  };
+
+  std::array<Bucket, kNumTimeBuckets> buckets_;
+};
+
+}  // namespace activity_attribution
+}  // namespace bluetooth
@@ -17,8 +17,8 @@
 #pragma once
 
 #include <cstdint>
-#include <unordered_map>
 
+#include "btaa/activity_aggregator.h"
 #include "hci_processor.h"
 
 namespace bluetooth {
@@ -26,26 +26,9 @@ namespace activity_attribution {
 
 static constexpr size_t kWakeupAggregatorSize = 200;
 
-struct AddressActivityKey {
-  hci::Address address;
-  Activity activity;
-
-  bool operator==(const AddressActivityKey& other) const {
-    return (address == other.address && activity == other.activity);
-  }
-};
-
-struct AddressActivityKeyHasher {
-  std::size_t operator()(const AddressActivityKey& key) const {
-    return (
-        (std::hash<std::string>()(key.address.ToString()) ^
-         (std::hash<unsigned char>()(static_cast<unsigned char>(key.activity)))));
-  }
-};
-
 struct WakeupDescriptor {
   Activity activity_;
-  const hci::Address address_;
+  hci::Address address_;
   WakeupDescriptor(Activity activity, const hci::Address address) : activity_(activity), address_(address) {}
   virtual ~WakeupDescriptor() {}
 };
@@ -60,8 +43,10 @@ class AttributionProcessor {
 
  private:
   bool wakeup_ = false;
-  std::unordered_map<AddressActivityKey, BtaaAggregationEntry, AddressActivityKeyHasher> btaa_aggregator_;
-  std::unordered_map<AddressActivityKey, BtaaAggregationEntry, AddressActivityKeyHasher> wakelock_duration_aggregator_;
+  DeviceActivityTable btaa_aggregator_;
+  // Activity since the last wakelock release
+  DeviceActivityTable wakelock_duration_aggregator_;
+  ActivityRollup activity_rollup_;
   common::TimestampedCircularBuffer<WakeupDescriptor> wakeup_aggregator_ =
       common::TimestampedCircularBuffer<WakeupDescriptor>(kWakeupAggregatorSize);
   const char* ActivityToString(Activity activity);
@@ -24,10 +24,12 @@ namespace activity_attribution {
 
 struct CmdEvtActivityClassification {
   Activity activity;
-  uint16_t connection_handle_pos;
-  uint16_t address_pos;
+  uint8_t connection_handle_pos;
+  uint8_t address_pos;
 };
 
+// Constant time lookups in precomputed tables
+
 CmdEvtActivityClassification lookup_cmd(hci::OpCode opcode);
 CmdEvtActivityClassification lookup_event(hci::EventCode event_code);
 CmdEvtActivityClassification lookup_le_event(hci::SubeventCode subevent_code);
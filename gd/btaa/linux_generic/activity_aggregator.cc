@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "btaa/activity_aggregator.h"
+
+#include <algorithm>
+
+namespace bluetooth {
+namespace activity_attribution {
+
+static_assert(
+    (DeviceActivityTable::kCapacity & (DeviceActivityTable::kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+size_t DeviceActivityTable::Hash(const hci::Address& address, Activity activity) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (uint8_t byte : address.address) {
+    hash = (hash ^ byte) * 16777619u;
+  }
+  hash = (hash ^ static_cast<uint8_t>(activity)) * 16777619u;
+  return hash;
+}
+
+BtaaAggregationEntry& DeviceActivityTable::Get(const hci::Address& address, Activity activity, CreationTime now) {
+  size_t start = Hash(address, activity);
+  Slot* victim = nullptr;
+  for (size_t probe = 0; probe < kMaxProbes; probe++) {
+    Slot& slot = slots_[(start + probe) & (kCapacity - 1)];
+    if (!slot.used) {
+      victim = &slot;
+      size_++;
+      break;
+    }
+    if (slot.entry.address == address && slot.entry.activity == activity) {
+      return slot.entry;
+    }
+    if (victim == nullptr || slot.entry.byte_count < victim->entry.byte_count) {
+      victim = &slot;
+    }
+  }
+  if (victim->used) {
+    num_evicted_++;
+  }
+  victim->used = true;
+  victim->entry = {};
+  victim->entry.address = address;
+  victim->entry.activity = activity;
+  victim->entry.creation_time = now;
+  return victim->entry;
+}
+
+std::vector<BtaaAggregationEntry> DeviceActivityTable::GetEntries() const {
+  std::vector<BtaaAggregationEntry> entries;
+  entries.reserve(size_);
+  for (const auto& slot : slots_) {
+    if (slot.used) {
+      entries.push_back(slot.entry);
+    }
+  }
+  return entries;
+}
+
+size_t DeviceActivityTable::Size() const {
+  return size_;
+}
+
+uint64_t DeviceActivityTable::GetNumEvicted() const {
+  return num_evicted_;
+}
+
+void DeviceActivityTable::Clear() {
+  for (auto& slot : slots_) {
+    slot.used = false;
+  }
+  size_ = 0;
+}
+
+namespace {
+
+CreationTime BucketStartTime(CreationTime time) {
+  auto since_epoch = time.time_since_epoch();
+  return time - (since_epoch % ActivityRollup::kTimeBucketDuration);
+}
+
+size_t BucketIndex(CreationTime start_time) {
+  return static_cast<size_t>(
+      std::chrono::duration_cast<std::chrono::hours>(start_time.time_since_epoch()).count() /
+      ActivityRollup::kTimeBucketDuration.count() % ActivityRollup::kNumTimeBuckets);
+}
+
+}  // namespace
+
+void ActivityRollup::Add(
+    Activity activity, uint32_t wakeup_count, uint32_t byte_count, uint32_t wakelock_duration_ms, CreationTime now) {
+  CreationTime start_time = BucketStartTime(now);
+  Bucket& bucket = buckets_[BucketIndex(start_time)];
+  if (!bucket.used || bucket.time_bucket.start_time != start_time) {
+    bucket.used = true;
+    bucket.time_bucket = {};
+    bucket.time_bucket.start_time = start_time;
+  }
+  ActivityTotals& totals = bucket.time_bucket.activities[static_cast<size_t>(activity)];
+  totals.wakeup_count += wakeup_count;
+  totals.byte_count += byte_count;
+  totals.wakelock_duration_ms += wakelock_duration_ms;
+}
+
+std::vector<ActivityRollup::TimeBucket> ActivityRollup::GetTimeBuckets(CreationTime now) const {
+  CreationTime oldest_start_time = BucketStartTime(now) - (kNumTimeBuckets - 1) * kTimeBucketDuration;
+  std::vector<TimeBucket> time_buckets;
+  for (const auto& bucket : buckets_) {
+    if (bucket.used && bucket.time_bucket.start_time >= oldest_start_time) {
+      time_buckets.push_back(bucket.time_bucket);
+    }
+  }
+  std::sort(time_buckets.begin(), time_buckets.end(), [](const TimeBucket& a, const TimeBucket& b) {
+    return a.start_time < b.start_time;
+  });
+  return time_buckets;
+}
+
+}  // namespace activity_attribution
+}  // namespace bluetooth
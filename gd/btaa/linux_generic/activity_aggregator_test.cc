@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "btaa/activity_aggregator.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace activity_attribution {
+namespace {
+
+hci::Address MakeAddress(uint32_t index) {
+  return hci::Address({0x00, 0x11, 0x22, static_cast<uint8_t>(index >> 16), static_cast<uint8_t>(index >> 8),
+                       static_cast<uint8_t>(index)});
+}
+
+TEST(DeviceActivityTableTest, entries_are_found_again) {
+  DeviceActivityTable table;
+  auto now = std::chrono::system_clock::now();
+  table.Get(MakeAddress(1), Activity::ACL, now).byte_count += 10;
+  table.Get(MakeAddress(1), Activity::SCAN, now).byte_count += 20;
+  table.Get(MakeAddress(1), Activity::ACL, now + std::chrono::seconds(1)).byte_count += 5;
+
+  ASSERT_EQ(2u, table.Size());
+  auto& entry = table.Get(MakeAddress(1), Activity::ACL, now);
+  ASSERT_EQ(15u, entry.byte_count);
+  ASSERT_EQ(now, entry.creation_time);
+  ASSERT_EQ(MakeAddress(1), entry.address);
+  ASSERT_EQ(Activity::ACL, entry.activity);
+}
+
+TEST(DeviceActivityTableTest, memory_is_bounded) {
+  DeviceActivityTable table;
+  auto now = std::chrono::system_clock::now();
+  // A busy device, then many devices seen once
+  table.Get(MakeAddress(0), Activity::ACL, now).byte_count = 100000;
+  for (uint32_t i = 1; i <= 10 * DeviceActivityTable::kCapacity; i++) {
+    table.Get(MakeAddress(i), Activity::ADVERTISE, now).byte_count += 1 + i % 7;
+  }
+  ASSERT_LE(table.Size(), DeviceActivityTable::kCapacity);
+  ASSERT_GT(table.GetNumEvicted(), 0u);
+  ASSERT_EQ(table.Size(), table.GetEntries().size());
+
+  // Entries with the most bytes are kept
+  bool found = false;
+  for (const auto& entry : table.GetEntries()) {
+    found |= entry.address == MakeAddress(0);
+  }
+  ASSERT_TRUE(found);
+}
+
+TEST(DeviceActivityTableTest, clear) {
+  DeviceActivityTable table;
+  auto now = std::chrono::system_clock::now();
+  table.Get(MakeAddress(1), Activity::ACL, now).byte_count = 10;
+  table.Clear();
+  ASSERT_EQ(0u, table.Size());
+  ASSERT_TRUE(table.GetEntries().empty());
+  ASSERT_EQ(0u, table.Get(MakeAddress(1), Activity::ACL, now).byte_count);
+}
+
+TEST(ActivityRollupTest, totals_per_time_bucket) {
+  ActivityRollup rollup;
+  auto now = std::chrono::system_clock::now();
+  auto earlier = now - ActivityRollup::kTimeBucketDuration;
+  rollup.Add(Activity::ACL, 1, 100, 10, earlier);
+  rollup.Add(Activity::ACL, 0, 50, 5, now);
+  rollup.Add(Activity::SCAN, 2, 20, 1, now);
+
+  auto time_buckets = rollup.GetTimeBuckets(now);
+  ASSERT_EQ(2u, time_buckets.size());
+  ASSERT_LT(time_buckets[0].start_time, time_buckets[1].start_time);
+  ASSERT_LE(time_buckets[1].start_time, now);
+  ASSERT_EQ(100u, time_buckets[0].activities[static_cast<size_t>(Activity::ACL)].byte_count);
+  const auto& acl = time_buckets[1].activities[static_cast<size_t>(Activity::ACL)];
+  ASSERT_EQ(0u, acl.wakeup_count);
+  ASSERT_EQ(50u, acl.byte_count);
+  ASSERT_EQ(5u, acl.wakelock_duration_ms);
+  ASSERT_EQ(2u, time_buckets[1].activities[static_cast<size_t>(Activity::SCAN)].wakeup_count);
+}
+
+TEST(ActivityRollupTest, old_buckets_are_reused) {
+  ActivityRollup rollup;
+  auto now = std::chrono::system_clock::now();
+  auto old = now - ActivityRollup::kNumTimeBuckets * ActivityRollup::kTimeBucketDuration;
+  rollup.Add(Activity::ACL, 1, 100, 10, old);
+  ASSERT_TRUE(rollup.GetTimeBuckets(now).empty());
+
+  // Same bucket slot, a later period
+  rollup.Add(Activity::ACL, 0, 7, 0, now);
+  auto time_buckets = rollup.GetTimeBuckets(now);
+  ASSERT_EQ(1u, time_buckets.size());
+  ASSERT_EQ(7u, time_buckets[0].activities[static_cast<size_t>(Activity::ACL)].byte_count);
+}
+
+}  // namespace
+}  // namespace activity_attribution
+}  // namespace bluetooth
@@ -25,26 +25,15 @@ namespace activity_attribution {
 constexpr char kActivityAttributionTimeFormat[] = "%Y-%m-%d %H:%M:%S";
 // A device-activity aggregation entry expires after two days (172800 seconds)
 static const int kDurationToKeepDeviceActivityEntrySecs = 172800;
-// A transient device-activity aggregation entry is defined as an entry with very few Byte count
-// (200 Bytes, this is about the size of 5 advertising packets) over a period of time (15 minutes)
-static const int kByteCountTransientDeviceActivityEntry = 200;
-static const int kDurationTransientDeviceActivityEntrySecs = 900;
-static const int kMapSizeTrimDownAggregationEntry = 200;
 
 void AttributionProcessor::OnBtaaPackets(std::vector<BtaaHciPacket> btaa_packets) {
-  AddressActivityKey key;
-
   for (auto& btaa_packet : btaa_packets) {
-    key.address = btaa_packet.address;
-    key.activity = btaa_packet.activity;
-
-    if (wakelock_duration_aggregator_.find(key) == wakelock_duration_aggregator_.end()) {
-      wakelock_duration_aggregator_[key] = {};
-    }
-    wakelock_duration_aggregator_[key].byte_count += btaa_packet.byte_count;
+    // The creation time of these entries is not used
+    auto& entry = wakelock_duration_aggregator_.Get(btaa_packet.address, btaa_packet.activity, CreationTime());
+    entry.byte_count += btaa_packet.byte_count;
 
     if (wakeup_) {
-      wakelock_duration_aggregator_[key].wakeup_count += 1;
+      entry.wakeup_count += 1;
       wakeup_aggregator_.Push(std::move(WakeupDescriptor(btaa_packet.activity, btaa_packet.address)));
     }
   }
@@ -55,8 +44,9 @@ void AttributionProcessor::OnWakelockReleased(uint32_t duration_ms) {
   uint32_t total_byte_count = 0;
   uint32_t ms_per_byte = 0;
 
-  for (auto& it : wakelock_duration_aggregator_) {
-    total_byte_count += it.second.byte_count;
+  auto entries = wakelock_duration_aggregator_.GetEntries();
+  for (auto& entry : entries) {
+    total_byte_count += entry.byte_count;
   }
 
   if (total_byte_count == 0) {
@@ -65,40 +55,25 @@ void AttributionProcessor::OnWakelockReleased(uint32_t duration_ms) {
 
   ms_per_byte = duration_ms / total_byte_count;
   auto cur_time = std::chrono::system_clock::now();
-  for (auto& it : wakelock_duration_aggregator_) {
-    it.second.wakelock_duration_ms = ms_per_byte * it.second.byte_count;
-    if (btaa_aggregator_.find(it.first) == btaa_aggregator_.end()) {
-      btaa_aggregator_[it.first] = {};
-      btaa_aggregator_[it.first].creation_time = cur_time;
-    }
+  for (auto& entry : entries) {
+    entry.wakelock_duration_ms = ms_per_byte * entry.byte_count;
+    auto& aggregated = btaa_aggregator_.Get(entry.address, entry.activity, cur_time);
 
     auto elapsed_time_sec =
-        std::chrono::duration_cast<std::chrono::seconds>(cur_time - btaa_aggregator_[it.first].creation_time).count();
+        std::chrono::duration_cast<std::chrono::seconds>(cur_time - aggregated.creation_time).count();
     if (elapsed_time_sec > kDurationToKeepDeviceActivityEntrySecs) {
-      btaa_aggregator_[it.first].wakeup_count = 0;
-      btaa_aggregator_[it.first].byte_count = 0;
-      btaa_aggregator_[it.first].wakelock_duration_ms = 0;
-      btaa_aggregator_[it.first].creation_time = cur_time;
+      aggregated.wakeup_count = 0;
+      aggregated.byte_count = 0;
+      aggregated.wakelock_duration_ms = 0;
+      aggregated.creation_time = cur_time;
     }
 
-    btaa_aggregator_[it.first].wakeup_count += it.second.wakeup_count;
-    btaa_aggregator_[it.first].byte_count += it.second.byte_count;
-    btaa_aggregator_[it.first].wakelock_duration_ms += it.second.wakelock_duration_ms;
-  }
-  wakelock_duration_aggregator_.clear();
-
-  if (btaa_aggregator_.size() < kMapSizeTrimDownAggregationEntry) {
-    return;
-  }
-  // Trim down the transient entries in the aggregator to avoid that it overgrows
-  for (auto& it : btaa_aggregator_) {
-    auto elapsed_time_sec =
-        std::chrono::duration_cast<std::chrono::seconds>(cur_time - it.second.creation_time).count();
-    if (elapsed_time_sec > kDurationTransientDeviceActivityEntrySecs &&
-        it.second.byte_count < kByteCountTransientDeviceActivityEntry) {
-      btaa_aggregator_.erase(it.first);
-    }
+    aggregated.wakeup_count += entry.wakeup_count;
+    aggregated.byte_count += entry.byte_count;
+    aggregated.wakelock_duration_ms += entry.wakelock_duration_ms;
+    activity_rollup_.Add(entry.activity, entry.wakeup_count, entry.byte_count, entry.wakelock_duration_ms, cur_time);
   }
+  wakelock_duration_aggregator_.Clear();
 }
 
 void AttributionProcessor::OnWakeup() {
@@ -129,28 +104,59 @@ void AttributionProcessor::Dump(
   // Dump device-based activity aggregation data
   auto title_device_activity = fb_builder->CreateString("----- Device-based Activity Attribution Dumpsys -----");
   std::vector<flatbuffers::Offset<DeviceActivityAggregationEntry>> aggregation_entry_offsets;
-  for (auto& it : btaa_aggregator_) {
+  for (auto& it : btaa_aggregator_.GetEntries()) {
     DeviceActivityAggregationEntryBuilder device_entry_builder(*fb_builder);
-    device_entry_builder.add_address(fb_builder->CreateString(it.first.address.ToString()));
-    device_entry_builder.add_activity(fb_builder->CreateString((ActivityToString(it.first.activity))));
-    device_entry_builder.add_wakeup_count(it.second.wakeup_count);
-    device_entry_builder.add_byte_count(it.second.byte_count);
-    device_entry_builder.add_wakelock_duration_ms(it.second.wakelock_duration_ms);
+    device_entry_builder.add_address(fb_builder->CreateString(it.address.ToString()));
+    device_entry_builder.add_activity(fb_builder->CreateString((ActivityToString(it.activity))));
+    device_entry_builder.add_wakeup_count(it.wakeup_count);
+    device_entry_builder.add_byte_count(it.byte_count);
+    device_entry_builder.add_wakelock_duration_ms(it.wakelock_duration_ms);
     device_entry_builder.add_creation_time(fb_builder->CreateString(
-        bluetooth::common::StringFormatTimeWithMilliseconds(kActivityAttributionTimeFormat, it.second.creation_time)
-            .c_str()));
+        bluetooth::common::StringFormatTimeWithMilliseconds(kActivityAttributionTimeFormat, it.creation_time).c_str()));
     aggregation_entry_offsets.push_back(device_entry_builder.Finish());
   }
   auto aggregation_entries = fb_builder->CreateVector(aggregation_entry_offsets);
 
+  // Dump activity totals per time bucket
+  auto title_time_buckets = fb_builder->CreateString("----- Activity Time Buckets Dumpsys -----");
+  std::vector<flatbuffers::Offset<TimeBucketEntry>> time_bucket_offsets;
+  for (auto& time_bucket : activity_rollup_.GetTimeBuckets(std::chrono::system_clock::now())) {
+    std::vector<flatbuffers::Offset<ActivityRollupEntry>> activity_offsets;
+    for (size_t i = 0; i < time_bucket.activities.size(); i++) {
+      const auto& totals = time_bucket.activities[i];
+      if (totals.wakeup_count == 0 && totals.byte_count == 0 && totals.wakelock_duration_ms == 0) {
+        continue;
+      }
+      auto activity = fb_builder->CreateString(ActivityToString(static_cast<Activity>(i)));
+      ActivityRollupEntryBuilder activity_builder(*fb_builder);
+      activity_builder.add_activity(activity);
+      activity_builder.add_wakeup_count(totals.wakeup_count);
+      activity_builder.add_byte_count(totals.byte_count);
+      activity_builder.add_wakelock_duration_ms(totals.wakelock_duration_ms);
+      activity_offsets.push_back(activity_builder.Finish());
+    }
+    auto start_time = fb_builder->CreateString(
+        bluetooth::common::StringFormatTimeWithMilliseconds(kActivityAttributionTimeFormat, time_bucket.start_time)
+            .c_str());
+    auto activities = fb_builder->CreateVector(activity_offsets);
+    TimeBucketEntryBuilder time_bucket_builder(*fb_builder);
+    time_bucket_builder.add_start_time(start_time);
+    time_bucket_builder.add_activities(activities);
+    time_bucket_offsets.push_back(time_bucket_builder.Finish());
+  }
+  auto time_buckets = fb_builder->CreateVector(time_bucket_offsets);
+
   ActivityAttributionDataBuilder builder(*fb_builder);
   builder.add_title_wakeup(title_wakeup);
   builder.add_num_wakeup(wakeup_aggregator.size());
   builder.add_wakeup_attribution(wakeup_entries);
   builder.add_title_activity(title_device_activity);
-  builder.add_num_device_activity(btaa_aggregator_.size());
+  builder.add_num_device_activity(btaa_aggregator_.Size());
   builder.add_device_activity_aggregation(aggregation_entries);
-  btaa_aggregator_.clear();
+  builder.add_num_evicted_device_activity(btaa_aggregator_.GetNumEvicted());
+  builder.add_title_time_buckets(title_time_buckets);
+  builder.add_time_buckets(time_buckets);
+  btaa_aggregator_.Clear();
 
   flatbuffers::Offset<ActivityAttributionData> dumpsys_data = builder.Finish();
   promise.set_value(dumpsys_data);
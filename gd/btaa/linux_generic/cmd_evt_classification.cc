@@ -16,10 +16,14 @@
 
 #include "btaa/cmd_evt_classification.h"
 
+#include <array>
+
 namespace bluetooth {
 namespace activity_attribution {
 
-CmdEvtActivityClassification lookup_cmd(hci::OpCode opcode) {
+namespace {
+
+CmdEvtActivityClassification classify_cmd(hci::OpCode opcode) {
   CmdEvtActivityClassification classification = {};
   switch (opcode) {
     case hci::OpCode::INQUIRY:
@@ -327,7 +331,7 @@ CmdEvtActivityClassification lookup_cmd(hci::OpCode opcode) {
   return classification;
 }
 
-CmdEvtActivityClassification lookup_event(hci::EventCode event_code) {
+CmdEvtActivityClassification classify_event(hci::EventCode event_code) {
   CmdEvtActivityClassification classification = {};
   switch (event_code) {
     case hci::EventCode::INQUIRY_COMPLETE:
@@ -397,7 +401,7 @@ CmdEvtActivityClassification lookup_event(hci::EventCode event_code) {
   return classification;
 }
 
-CmdEvtActivityClassification lookup_le_event(hci::SubeventCode subevent_code) {
+CmdEvtActivityClassification classify_le_event(hci::SubeventCode subevent_code) {
   CmdEvtActivityClassification classification = {};
   switch (subevent_code) {
     case hci::SubeventCode::CONNECTION_COMPLETE:
@@ -461,5 +465,63 @@ CmdEvtActivityClassification lookup_le_event(hci::SubeventCode subevent_code) {
   return classification;
 }
 
+// Every packet is classified, so the classifications above are looked up in tables built once.
+// Commands are indexed by OGF and by the low byte of the OCF. All the opcodes of the specification have an OCF below
+// 0x100, the Android vendor specific ones (OGF 0x3f) have an OCF in [0x100, 0x200) and get their own row.
+constexpr uint16_t kVendorSpecificOgf = 0x3f;
+constexpr size_t kVendorSpecificRow = 9;
+constexpr size_t kNumOgfRows = 10;
+constexpr size_t kNumOcfsPerRow = 0x100;
+
+struct ClassificationTables {
+  ClassificationTables() {
+    for (size_t row = 0; row < kNumOgfRows; row++) {
+      uint16_t ogf = row == kVendorSpecificRow ? kVendorSpecificOgf : row;
+      uint16_t ocf_base = row == kVendorSpecificRow ? kNumOcfsPerRow : 0;
+      for (size_t ocf = 0; ocf < kNumOcfsPerRow; ocf++) {
+        auto opcode = static_cast<hci::OpCode>((ogf << 10) | (ocf_base + ocf));
+        commands[row * kNumOcfsPerRow + ocf] = classify_cmd(opcode);
+      }
+    }
+    for (size_t code = 0; code < events.size(); code++) {
+      events[code] = classify_event(static_cast<hci::EventCode>(code));
+      le_events[code] = classify_le_event(static_cast<hci::SubeventCode>(code));
+    }
+  }
+
+  std::array<CmdEvtActivityClassification, kNumOgfRows * kNumOcfsPerRow> commands;
+  std::array<CmdEvtActivityClassification, 0x100> events;
+  std::array<CmdEvtActivityClassification, 0x100> le_events;
+};
+
+const ClassificationTables& get_tables() {
+  static const ClassificationTables* tables = new ClassificationTables();
+  return *tables;
+}
+
+}  // namespace
+
+CmdEvtActivityClassification lookup_cmd(hci::OpCode opcode) {
+  uint16_t ogf = static_cast<uint16_t>(opcode) >> 10;
+  uint16_t ocf = static_cast<uint16_t>(opcode) & 0x3ff;
+  size_t row;
+  if (ogf < kVendorSpecificRow && ocf < kNumOcfsPerRow) {
+    row = ogf;
+  } else if (ogf == kVendorSpecificOgf && ocf >= kNumOcfsPerRow && ocf < 2 * kNumOcfsPerRow) {
+    row = kVendorSpecificRow;
+  } else {
+    return CmdEvtActivityClassification{.activity = Activity::UNKNOWN, .connection_handle_pos = 0, .address_pos = 0};
+  }
+  return get_tables().commands[row * kNumOcfsPerRow + (ocf % kNumOcfsPerRow)];
+}
+
+CmdEvtActivityClassification lookup_event(hci::EventCode event_code) {
+  return get_tables().events[static_cast<uint8_t>(event_code)];
+}
+
+CmdEvtActivityClassification lookup_le_event(hci::SubeventCode subevent_code) {
+  return get_tables().le_events[static_cast<uint8_t>(subevent_code)];
+}
+
 }  // namespace activity_attribution
 }  // namespace bluetooth
@@ -14,7 +14,8 @@
 #   See the License for the specific language governing permissions and
 #   limitations under the License.
 
-from datetime import datetime
+import json
+from datetime import datetime, timedelta
 
 
 class PerformanceTestLogger(object):
@@ -28,12 +29,21 @@ class PerformanceTestLogger(object):
         self.start_interval_points = {}
         self.end_interval_points = {}
         self.single_points = {}
+        self.values = {}
 
     def log_single_point(self, label=""):
         if label not in self.single_points:
             self.single_points[label] = []
         self.single_points[label].append(datetime.now())
 
+    def log_value(self, label, value):
+        """
+        Log a measurement which is not an interval, like a throughput
+        """
+        if label not in self.values:
+            self.values[label] = []
+        self.values[label].append(value)
+
     def start_interval(self, label=""):
         if label not in self.start_interval_points:
             self.start_interval_points[label] = []
@@ -69,3 +79,32 @@ class PerformanceTestLogger(object):
             self._check_interval_label(label)
             yield ((label, self.start_interval_points[label][i], self.end_interval_points[label][i])
                    for i in range(len(self.start_interval_points[label])))
+
+    def get_summary_of_intervals(self, label):
+        """
+        Return the number, mean, min, median, 90th percentile and max of the
+        duration of the intervals with specified label, in milliseconds.
+        """
+        durations = sorted(d / timedelta(milliseconds=1) for d in self.get_duration_of_intervals(label))
+        if not durations:
+            return {"count": 0}
+        return {
+            "count": len(durations),
+            "mean_ms": sum(durations) / len(durations),
+            "min_ms": durations[0],
+            "p50_ms": durations[len(durations) // 2],
+            "p90_ms": durations[min(len(durations) - 1, len(durations) * 9 // 10)],
+            "max_ms": durations[-1],
+        }
+
+    def dump_json(self, path):
+        """
+        Write the summary of all intervals and the logged values to path, to be
+        compared across runs
+        """
+        results = {
+            "intervals": {label: self.get_summary_of_intervals(label) for label in self.start_interval_points},
+            "values": self.values,
+        }
+        with open(path, "w") as f:
+            json.dump(results, f, indent=2, sort_keys=True)
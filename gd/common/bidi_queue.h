@@ -29,6 +29,7 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
  public:
   using EnqueueCallback = Callback<std::unique_ptr<TENQUEUE>()>;
   using DequeueCallback = Callback<void()>;
+  using BatchDequeueCallback = Callback<void(std::vector<std::unique_ptr<TDEQUEUE>>)>;
 
   BidiQueueEnd(::bluetooth::os::IQueueEnqueue<TENQUEUE>* tx, ::bluetooth::os::IQueueDequeue<TDEQUEUE>* rx)
       : tx_(tx), rx_(rx) {}
@@ -41,10 +42,19 @@ class BidiQueueEnd : public ::bluetooth::os::IQueueEnqueue<TENQUEUE>, public ::b
     tx_->UnregisterEnqueue();
   }
 
+  size_t TryEnqueue(std::queue<std::unique_ptr<TENQUEUE>>* items) override {
+    return tx_->TryEnqueue(items);
+  }
+
   void RegisterDequeue(::bluetooth::os::Handler* handler, DequeueCallback callback) override {
     rx_->RegisterDequeue(handler, callback);
   }
 
+  void RegisterBatchDequeue(
+      ::bluetooth::os::Handler* handler, size_t max_batch, BatchDequeueCallback callback) override {
+    rx_->RegisterBatchDequeue(handler, max_batch, callback);
+  }
+
   void UnregisterDequeue() override {
     rx_->UnregisterDequeue();
   }
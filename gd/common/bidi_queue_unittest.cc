@@ -17,6 +17,7 @@
 #include "common/bidi_queue.h"
 
 #include <future>
+#include <vector>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -111,6 +112,35 @@ class TestBidiQueueEnd {
     promise->set_value(end_->TryDequeue().get());
   }
 
+  std::promise<std::vector<TB*>>* ReceiveBatch(size_t max_batch) {
+    std::promise<std::vector<TB*>>* promise = new std::promise<std::vector<TB*>>();
+    handler_->Post(BindOnce(
+        &TestBidiQueueEnd<TA, TB>::handle_receive_batch,
+        common::Unretained(this),
+        max_batch,
+        common::Unretained(promise)));
+    return promise;
+  }
+
+  void handle_receive_batch(size_t max_batch, std::promise<std::vector<TB*>>* promise) {
+    end_->RegisterBatchDequeue(
+        handler_,
+        max_batch,
+        Bind(
+            &TestBidiQueueEnd<TA, TB>::handle_register_batch_dequeue,
+            common::Unretained(this),
+            common::Unretained(promise)));
+  }
+
+  void handle_register_batch_dequeue(std::promise<std::vector<TB*>>* promise, std::vector<std::unique_ptr<TB>> batch) {
+    end_->UnregisterDequeue();
+    std::vector<TB*> received;
+    for (auto& value : batch) {
+      received.push_back(value.get());
+    }
+    promise->set_value(received);
+  }
+
  private:
   Handler* handler_;
   BidiQueueEnd<TA, TB>* end_;
@@ -138,6 +168,28 @@ TEST_F(BidiQueueTest, simple_test) {
   delete promise_sending_a;
 }
 
+TEST_F(BidiQueueTest, batch_dequeue) {
+  BidiQueue<A, B> queue(100);
+  TestBidiQueueEnd<B, A> test_up(queue.GetUpEnd(), up_handler_);
+  TestBidiQueueEnd<A, B> test_down(queue.GetDownEnd(), down_handler_);
+
+  auto first_b = new B();
+  auto second_b = new B();
+  auto promise_sending_first_b = test_up.Send(first_b);
+  promise_sending_first_b->get_future().wait();
+  auto promise_sending_second_b = test_up.Send(second_b);
+  promise_sending_second_b->get_future().wait();
+  // The item is only queued once the enqueue callback returns on the up thread
+  std::promise<void> up_synced;
+  up_handler_->Post(BindOnce(&std::promise<void>::set_value, common::Unretained(&up_synced)));
+  up_synced.get_future().wait();
+  auto promise_receive_batch = test_down.ReceiveBatch(8);
+  EXPECT_EQ(promise_receive_batch->get_future().get(), std::vector<B*>({first_b, second_b}));
+  delete promise_receive_batch;
+  delete promise_sending_second_b;
+  delete promise_sending_first_b;
+}
+
 }  // namespace
 }  // namespace common
 }  // namespace bluetooth
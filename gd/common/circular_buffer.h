@@ -21,6 +21,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 namespace bluetooth {
 namespace common {
@@ -32,14 +33,26 @@ class CircularBuffer {
 
   // Push one item to the circular buffer
   void Push(T item);
+  // Push all items of [first, last) to the circular buffer, under one lock
+  template <typename Iterator>
+  void Append(Iterator first, Iterator last);
   // Take a snapshot of the circular buffer and return it as a vector
   std::vector<T> Pull() const;
   // Drain everything from the circular buffer and return them as a vector
   std::vector<T> Drain();
+  // Call |segment| with the at most two contiguous runs of items, oldest
+  // first, without copying them. The buffer is locked during the calls.
+  template <typename Function>
+  void ForEachSegment(Function segment) const;
 
  private:
+  void PushLocked(T&& item);
+
   const size_t size_;
-  std::deque<T> queue_;
+  // Grows up to size_ items, then the oldest one is overwritten in place
+  std::vector<T> items_;
+  // Index of the oldest item once items_ is full
+  size_t head_ = 0;
   mutable std::mutex mutex_;
 };
 
@@ -85,25 +98,62 @@ template <typename T>
 bluetooth::common::CircularBuffer<T>::CircularBuffer(size_t size) : size_(size) {}
 
 template <typename T>
-void bluetooth::common::CircularBuffer<T>::Push(const T item) {
+void bluetooth::common::CircularBuffer<T>::PushLocked(T&& item) {
+  if (size_ == 0) return;
+  if (items_.size() < size_) {
+    items_.push_back(std::move(item));
+    return;
+  }
+  items_[head_] = std::move(item);
+  head_ = (head_ + 1) % size_;
+}
+
+template <typename T>
+void bluetooth::common::CircularBuffer<T>::Push(T item) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  PushLocked(std::move(item));
+}
+
+template <typename T>
+template <typename Iterator>
+void bluetooth::common::CircularBuffer<T>::Append(Iterator first, Iterator last) {
   std::unique_lock<std::mutex> lock(mutex_);
-  queue_.push_back(item);
-  while (queue_.size() > size_) {
-    queue_.pop_front();
+  for (; first != last; ++first) {
+    PushLocked(T(*first));
   }
 }
 
 template <typename T>
-std::vector<T> bluetooth::common::CircularBuffer<T>::Pull() const {
+template <typename Function>
+void bluetooth::common::CircularBuffer<T>::ForEachSegment(Function segment) const {
   std::unique_lock<std::mutex> lock(mutex_);
-  return std::vector<T>(queue_.cbegin(), queue_.cend());
+  if (head_ < items_.size()) segment(items_.data() + head_, items_.size() - head_);
+  if (head_ > 0) segment(items_.data(), head_);
+}
+
+template <typename T>
+std::vector<T> bluetooth::common::CircularBuffer<T>::Pull() const {
+  std::vector<T> items;
+  ForEachSegment([&items](const T* first, size_t count) {
+    items.reserve(items.size() + count);
+    items.insert(items.end(), first, first + count);
+  });
+  return items;
 }
 
 template <typename T>
 std::vector<T> bluetooth::common::CircularBuffer<T>::Drain() {
   std::unique_lock<std::mutex> lock(mutex_);
-  std::vector<T> items(std::make_move_iterator(queue_.begin()), std::make_move_iterator(queue_.end()));
-  queue_.clear();
+  std::vector<T> items;
+  if (head_ == 0) {
+    items.swap(items_);
+  } else {
+    items.reserve(items_.size());
+    std::move(items_.begin() + head_, items_.end(), std::back_inserter(items));
+    std::move(items_.begin(), items_.begin() + head_, std::back_inserter(items));
+    items_.clear();
+  }
+  head_ = 0;
   return items;
 }
 
@@ -113,9 +163,9 @@ bluetooth::common::TimestampedCircularBuffer<T>::TimestampedCircularBuffer(
     : CircularBuffer<TimestampedEntry<T>>(size), timestamper_(std::move(timestamper)) {}
 
 template <typename T>
-void bluetooth::common::TimestampedCircularBuffer<T>::Push(const T item) {
-  TimestampedEntry<T> timestamped_entry{timestamper_->GetTimestamp(), item};
-  bluetooth::common::CircularBuffer<TimestampedEntry<T>>::Push(timestamped_entry);
+void bluetooth::common::TimestampedCircularBuffer<T>::Push(T item) {
+  TimestampedEntry<T> timestamped_entry{timestamper_->GetTimestamp(), std::move(item)};
+  bluetooth::common::CircularBuffer<TimestampedEntry<T>>::Push(std::move(timestamped_entry));
 }
 
 template <typename T>
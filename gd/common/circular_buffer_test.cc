@@ -103,4 +103,42 @@ TEST(CircularBufferTest, max_timestamps) {
   }
 }
 
+TEST(CircularBufferTest, append_wraps_around) {
+  bluetooth::common::CircularBuffer<int> buffer(4);
+
+  std::vector<int> values = {0, 1, 2, 3, 4, 5};
+  buffer.Append(values.begin(), values.end());
+
+  ASSERT_EQ(std::vector<int>({2, 3, 4, 5}), buffer.Pull());
+
+  buffer.Push(6);
+  ASSERT_EQ(std::vector<int>({3, 4, 5, 6}), buffer.Drain());
+  ASSERT_TRUE(buffer.Pull().empty());
+}
+
+TEST(CircularBufferTest, for_each_segment) {
+  bluetooth::common::CircularBuffer<int> buffer(4);
+
+  std::vector<std::vector<int>> segments;
+  auto collect = [&segments](const int* first, size_t count) {
+    segments.push_back(std::vector<int>(first, first + count));
+  };
+
+  buffer.ForEachSegment(collect);
+  ASSERT_TRUE(segments.empty());
+
+  buffer.Push(0);
+  buffer.Push(1);
+  buffer.ForEachSegment(collect);
+  ASSERT_EQ(1u, segments.size());
+  ASSERT_EQ(std::vector<int>({0, 1}), segments[0]);
+
+  segments.clear();
+  for (int i = 2; i < 7; i++) buffer.Push(i);
+  buffer.ForEachSegment(collect);
+  ASSERT_EQ(2u, segments.size());
+  ASSERT_EQ(std::vector<int>({3}), segments[0]);
+  ASSERT_EQ(std::vector<int>({4, 5, 6}), segments[1]);
+}
+
 }  // namespace testing
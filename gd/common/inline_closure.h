@@ -0,0 +1,152 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace bluetooth {
+namespace common {
+
+// Move-only closure that runs once, like OnceClosure, but keeps callables of up to kInlineCapacity bytes in its own
+// storage instead of allocating a BindState. Larger callables are moved to the heap.
+// Only callables invocable with operator() are accepted, so base::Callback objects keep binding to the OnceClosure
+// overloads of the posting APIs.
+class InlineClosure {
+ public:
+  static constexpr size_t kInlineCapacity = 48;
+
+  InlineClosure() = default;
+
+  template <
+      typename F,
+      typename Callable = std::decay_t<F>,
+      typename = std::enable_if_t<!std::is_same<Callable, InlineClosure>::value && std::is_invocable<Callable&>::value>>
+  InlineClosure(F&& callable) {  // NOLINT(google-explicit-constructor)
+    if constexpr (FitsInline<Callable>()) {
+      new (storage_) Callable(std::forward<F>(callable));
+      ops_ = &InlineOps<Callable>::kOps;
+    } else {
+      *reinterpret_cast<Callable**>(storage_) = new Callable(std::forward<F>(callable));
+      ops_ = &HeapOps<Callable>::kOps;
+    }
+  }
+
+  InlineClosure(InlineClosure&& other) noexcept {
+    take(other);
+  }
+
+  InlineClosure& operator=(InlineClosure&& other) noexcept {
+    if (this != &other) {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+
+  InlineClosure(const InlineClosure&) = delete;
+  InlineClosure& operator=(const InlineClosure&) = delete;
+
+  ~InlineClosure() {
+    reset();
+  }
+
+  explicit operator bool() const {
+    return ops_ != nullptr;
+  }
+
+  // Return true if the callable is held without a heap allocation
+  bool IsInline() const {
+    return ops_ != nullptr && ops_->is_inline;
+  }
+
+  // Run the callable and release it. Must not be empty.
+  void Run() && {
+    InlineClosure closure(std::move(*this));
+    closure.ops_->invoke(closure.storage_);
+  }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* storage);
+    // Move construct into |to| and destroy what is left in |from|
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* storage);
+    bool is_inline;
+  };
+
+  template <typename Callable>
+  static constexpr bool FitsInline() {
+    // The stack is built without exceptions, so a move constructor that isn't declared noexcept is still fine here
+    return sizeof(Callable) <= kInlineCapacity && alignof(Callable) <= alignof(std::max_align_t) &&
+           std::is_move_constructible<Callable>::value;
+  }
+
+  template <typename Callable>
+  struct InlineOps {
+    static void invoke(void* storage) {
+      (*static_cast<Callable*>(storage))();
+    }
+    static void relocate(void* from, void* to) {
+      Callable* source = static_cast<Callable*>(from);
+      new (to) Callable(std::move(*source));
+      source->~Callable();
+    }
+    static void destroy(void* storage) {
+      static_cast<Callable*>(storage)->~Callable();
+    }
+    static constexpr Ops kOps = {&invoke, &relocate, &destroy, true};
+  };
+
+  template <typename Callable>
+  struct HeapOps {
+    static void invoke(void* storage) {
+      (**static_cast<Callable**>(storage))();
+    }
+    static void relocate(void* from, void* to) {
+      *static_cast<Callable**>(to) = *static_cast<Callable**>(from);
+    }
+    static void destroy(void* storage) {
+      delete *static_cast<Callable**>(storage);
+    }
+    static constexpr Ops kOps = {&invoke, &relocate, &destroy, false};
+  };
+
+  void take(InlineClosure& other) {
+    if (other.ops_ == nullptr) {
+      return;
+    }
+    other.ops_->relocate(other.storage_, storage_);
+    ops_ = other.ops_;
+    other.ops_ = nullptr;
+  }
+
+  void reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineCapacity];
+  const Ops* ops_ = nullptr;
+};
+
+}  // namespace common
+}  // namespace bluetooth
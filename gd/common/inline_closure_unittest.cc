@@ -0,0 +1,86 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/inline_closure.h"
+
+#include <array>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+namespace testing {
+
+using bluetooth::common::InlineClosure;
+
+TEST(InlineClosureTest, empty) {
+  InlineClosure closure;
+  EXPECT_FALSE(closure);
+  EXPECT_FALSE(closure.IsInline());
+}
+
+TEST(InlineClosureTest, small_capture_is_inline) {
+  int val = 0;
+  InlineClosure closure([&val]() { val++; });
+  EXPECT_TRUE(closure);
+  EXPECT_TRUE(closure.IsInline());
+  std::move(closure).Run();
+  EXPECT_EQ(val, 1);
+  EXPECT_FALSE(closure);
+}
+
+TEST(InlineClosureTest, large_capture_is_on_heap) {
+  std::array<char, InlineClosure::kInlineCapacity + 1> big{};
+  big[0] = 'a';
+  char result = 0;
+  InlineClosure closure([big, &result]() { result = big[0]; });
+  EXPECT_FALSE(closure.IsInline());
+  InlineClosure moved(std::move(closure));
+  EXPECT_FALSE(closure);
+  std::move(moved).Run();
+  EXPECT_EQ(result, 'a');
+}
+
+TEST(InlineClosureTest, move_only_capture) {
+  auto value = std::make_unique<int>(42);
+  int result = 0;
+  InlineClosure closure([value = std::move(value), &result]() { result = *value; });
+  EXPECT_TRUE(closure.IsInline());
+  InlineClosure other;
+  other = std::move(closure);
+  std::move(other).Run();
+  EXPECT_EQ(result, 42);
+}
+
+TEST(InlineClosureTest, capture_destroyed_once) {
+  auto counter = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = counter;
+  {
+    InlineClosure closure([counter = std::move(counter)]() {});
+    InlineClosure moved(std::move(closure));
+    EXPECT_FALSE(weak.expired());
+  }
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(InlineClosureTest, capture_released_after_run) {
+  auto counter = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = counter;
+  InlineClosure closure([counter = std::move(counter)]() { (*counter)++; });
+  std::move(closure).Run();
+  EXPECT_TRUE(weak.expired());
+}
+
+}  // namespace testing
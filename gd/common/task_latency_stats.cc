@@ -0,0 +1,150 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/task_latency_stats.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <set>
+
+namespace bluetooth {
+namespace common {
+
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  std::set<const TaskLatencyStats*> stats;
+};
+
+// Never destroyed, static MessageLoopThreads unregister themselves during exit
+Registry& GetRegistry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+void dump_histogram(int fd, const char* name, const TaskLatencyStats::Histogram& histogram) {
+  dprintf(
+      fd,
+      "      %s: avg %llu us, max %llu us, buckets:",
+      name,
+      static_cast<unsigned long long>(histogram.count == 0 ? 0 : histogram.total_us / histogram.count),
+      static_cast<unsigned long long>(histogram.max_us));
+  for (size_t i = 0; i < TaskLatencyStats::kNumBuckets; i++) {
+    if (histogram.buckets[i] == 0) {
+      continue;
+    }
+    dprintf(
+        fd,
+        " <%lluus:%llu",
+        static_cast<unsigned long long>(TaskLatencyStats::BucketUpperBoundUs(i)),
+        static_cast<unsigned long long>(histogram.buckets[i]));
+  }
+  dprintf(fd, "\n");
+}
+
+}  // namespace
+
+void TaskLatencyStats::Histogram::Record(uint64_t value_us) {
+  size_t bucket = value_us == 0 ? 0 : 64 - __builtin_clzll(value_us);
+  buckets[std::min(bucket, kNumBuckets - 1)]++;
+  count++;
+  total_us += value_us;
+  max_us = std::max(max_us, value_us);
+}
+
+TaskLatencyStats::TaskLatencyStats(const std::string& thread_name) : thread_name_(thread_name) {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.stats.insert(this);
+}
+
+TaskLatencyStats::~TaskLatencyStats() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.stats.erase(this);
+}
+
+void TaskLatencyStats::Record(
+    const char* file_name, int line_number, const char* function_name, uint64_t queue_delay_us, uint64_t execution_us) {
+  if (file_name == nullptr) {
+    file_name = "unknown";
+  }
+  if (function_name == nullptr) {
+    function_name = "unknown";
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto result = locations_.try_emplace(Key(file_name, line_number));
+  LocationStats& location = result.first->second;
+  if (result.second) {
+    location.file_name = file_name;
+    location.line_number = line_number;
+    location.function_name = function_name;
+  }
+  location.queue_delay.Record(queue_delay_us);
+  location.execution_time.Record(execution_us);
+}
+
+TaskLatencyStats::ThreadStats TaskLatencyStats::GetSnapshot() const {
+  ThreadStats snapshot;
+  snapshot.thread_name = thread_name_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshot.locations.reserve(locations_.size());
+  for (const auto& location : locations_) {
+    snapshot.locations.push_back(location.second);
+  }
+  std::sort(
+      snapshot.locations.begin(), snapshot.locations.end(), [](const LocationStats& a, const LocationStats& b) {
+        return a.execution_time.total_us > b.execution_time.total_us;
+      });
+  return snapshot;
+}
+
+std::vector<TaskLatencyStats::ThreadStats> TaskLatencyStats::GetAllSnapshots() {
+  std::vector<ThreadStats> snapshots;
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const TaskLatencyStats* stats : registry.stats) {
+    snapshots.push_back(stats->GetSnapshot());
+  }
+  return snapshots;
+}
+
+void TaskLatencyStats::DebugDump(int fd) {
+  dprintf(fd, "\nTask latency statistics:\n");
+  for (const ThreadStats& thread : GetAllSnapshots()) {
+    dprintf(fd, "  Thread %s:\n", thread.thread_name.c_str());
+    for (const LocationStats& location : thread.locations) {
+      dprintf(
+          fd,
+          "    %s@%s:%d tasks %llu\n",
+          location.function_name,
+          location.file_name,
+          location.line_number,
+          static_cast<unsigned long long>(location.execution_time.count));
+      dump_histogram(fd, "queue delay", location.queue_delay);
+      dump_histogram(fd, "execution", location.execution_time);
+    }
+  }
+}
+
+uint64_t TaskLatencyStats::BucketUpperBoundUs(size_t bucket) {
+  return 1ULL << bucket;
+}
+
+}  // namespace common
+}  // namespace bluetooth
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace common {
+
+// Per posting location statistics of the tasks run by one thread: the delay between a task being due and it starting
+// to run, and the time it took to run, each in a log-scale histogram.
+// Every instance registers itself so that all threads can be dumped together.
+class TaskLatencyStats {
+ public:
+  // Bucket i counts values in [2^(i-1), 2^i) microseconds, bucket 0 counts values under 1 microsecond and the last
+  // bucket also counts everything above its range
+  static constexpr size_t kNumBuckets = 24;
+
+  struct Histogram {
+    std::array<uint64_t, kNumBuckets> buckets{};
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+
+    void Record(uint64_t value_us);
+  };
+
+  struct LocationStats {
+    const char* file_name;
+    int line_number;
+    const char* function_name;
+    Histogram queue_delay;
+    Histogram execution_time;
+  };
+
+  struct ThreadStats {
+    std::string thread_name;
+    std::vector<LocationStats> locations;
+  };
+
+  explicit TaskLatencyStats(const std::string& thread_name);
+  ~TaskLatencyStats();
+
+  TaskLatencyStats(const TaskLatencyStats&) = delete;
+  TaskLatencyStats& operator=(const TaskLatencyStats&) = delete;
+
+  // Record one task posted from |file_name|:|line_number|. The strings must outlive this object, which is the case for
+  // the string literals held by base::Location.
+  void Record(
+      const char* file_name, int line_number, const char* function_name, uint64_t queue_delay_us, uint64_t execution_us);
+
+  // Return a copy of the statistics of this thread
+  ThreadStats GetSnapshot() const;
+
+  // Return a copy of the statistics of every registered thread
+  static std::vector<ThreadStats> GetAllSnapshots();
+
+  // Write a human readable report of every registered thread, with the locations sorted by total execution time
+  static void DebugDump(int fd);
+
+  // Return the upper bound, in microseconds, of the given histogram bucket
+  static uint64_t BucketUpperBoundUs(size_t bucket);
+
+ private:
+  using Key = std::pair<const char*, int>;
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return std::hash<const char*>()(key.first) ^ (std::hash<int>()(key.second) << 1);
+    }
+  };
+
+  const std::string thread_name_;
+  mutable std::mutex mutex_;
+  std::unordered_map<Key, LocationStats, KeyHash> locations_;
+};
+
+}  // namespace common
+}  // namespace bluetooth
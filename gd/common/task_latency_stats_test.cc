@@ -0,0 +1,80 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/task_latency_stats.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace testing {
+
+using bluetooth::common::TaskLatencyStats;
+
+static const char kFile[] = "file.cc";
+static const char kFunction[] = "Function";
+
+TEST(TaskLatencyStatsTest, histogram_buckets_are_log_scale) {
+  TaskLatencyStats::Histogram histogram;
+  histogram.Record(0);
+  histogram.Record(1);
+  histogram.Record(3);
+  histogram.Record(1000);
+  histogram.Record(UINT64_MAX / 2);
+  EXPECT_EQ(histogram.buckets[0], 1u);
+  EXPECT_EQ(histogram.buckets[1], 1u);
+  EXPECT_EQ(histogram.buckets[2], 1u);
+  // 512 <= 1000 < 1024
+  EXPECT_EQ(histogram.buckets[10], 1u);
+  EXPECT_EQ(histogram.buckets[TaskLatencyStats::kNumBuckets - 1], 1u);
+  EXPECT_EQ(histogram.count, 5u);
+  EXPECT_EQ(histogram.max_us, UINT64_MAX / 2);
+  EXPECT_EQ(TaskLatencyStats::BucketUpperBoundUs(10), 1024u);
+}
+
+TEST(TaskLatencyStatsTest, records_per_location) {
+  TaskLatencyStats stats("test_thread");
+  stats.Record(kFile, 10, kFunction, 5, 100);
+  stats.Record(kFile, 10, kFunction, 7, 300);
+  stats.Record(kFile, 20, kFunction, 1, 1000);
+
+  auto snapshot = stats.GetSnapshot();
+  EXPECT_EQ(snapshot.thread_name, "test_thread");
+  ASSERT_EQ(snapshot.locations.size(), 2u);
+  // Sorted by total execution time
+  EXPECT_EQ(snapshot.locations[0].line_number, 20);
+  EXPECT_EQ(snapshot.locations[1].line_number, 10);
+  EXPECT_EQ(snapshot.locations[1].queue_delay.count, 2u);
+  EXPECT_EQ(snapshot.locations[1].queue_delay.total_us, 12u);
+  EXPECT_EQ(snapshot.locations[1].execution_time.total_us, 400u);
+  EXPECT_EQ(snapshot.locations[1].execution_time.max_us, 300u);
+}
+
+TEST(TaskLatencyStatsTest, registered_while_alive) {
+  auto count_thread = [](const std::string& name) {
+    auto snapshots = TaskLatencyStats::GetAllSnapshots();
+    return std::count_if(snapshots.begin(), snapshots.end(), [&name](const TaskLatencyStats::ThreadStats& thread) {
+      return thread.thread_name == name;
+    });
+  };
+  {
+    TaskLatencyStats stats("registered_thread");
+    EXPECT_EQ(count_thread("registered_thread"), 1);
+  }
+  EXPECT_EQ(count_thread("registered_thread"), 0);
+}
+
+}  // namespace testing
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/trace_ring.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace bluetooth {
+namespace common {
+
+namespace {
+
+static_assert((TraceRing::kRingSize & (TraceRing::kRingSize - 1)) == 0, "kRingSize must be a power of two");
+
+// Written by its thread only. An event is packed in two words, stored with relaxed atomics so that dumping may read
+// them while they are overwritten, |begun| and |done| tell which slots could have been.
+struct Ring {
+  std::string thread_name;
+  int thread_id = 0;
+  std::atomic<bool> thread_exited{false};
+  // Number of events whose recording began, and ended
+  std::atomic<uint64_t> begun{0};
+  std::atomic<uint64_t> done{0};
+  std::array<std::array<std::atomic<uint64_t>, 2>, TraceRing::kRingSize> slots;
+};
+
+struct Registry {
+  std::mutex mutex;
+  // In order of creation
+  std::vector<std::shared_ptr<Ring>> rings;
+};
+
+// Never destroyed, threads may record events during exit
+Registry& GetRegistry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+std::shared_ptr<Ring> RegisterRing() {
+  auto ring = std::make_shared<Ring>();
+  char name[16] = {};
+  pthread_getname_np(pthread_self(), name, sizeof(name));
+  ring->thread_name = name;
+  ring->thread_id = static_cast<int>(syscall(SYS_gettid));
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  size_t num_exited = 0;
+  for (const auto& registered : registry.rings) {
+    num_exited += registered->thread_exited.load(std::memory_order_relaxed);
+  }
+  for (auto it = registry.rings.begin(); it != registry.rings.end() && num_exited > TraceRing::kMaxExitedThreads;) {
+    if ((*it)->thread_exited.load(std::memory_order_relaxed)) {
+      it = registry.rings.erase(it);
+      num_exited--;
+    } else {
+      it++;
+    }
+  }
+  registry.rings.push_back(ring);
+  return ring;
+}
+
+// Owned by the registry, the thread only marks its ring as exited
+struct ThreadRing {
+  ThreadRing() : ring(RegisterRing()) {}
+  ~ThreadRing() {
+    ring->thread_exited.store(true, std::memory_order_relaxed);
+  }
+  std::shared_ptr<Ring> ring;
+};
+
+Ring& GetThreadRing() {
+  thread_local ThreadRing thread_ring;
+  return *thread_ring.ring;
+}
+
+uint64_t Pack(TraceEventId id, uint16_t handle, uint32_t arg) {
+  return static_cast<uint64_t>(id) | (static_cast<uint64_t>(handle) << 16) | (static_cast<uint64_t>(arg) << 32);
+}
+
+TraceRing::Event Unpack(uint64_t timestamp_ns, uint64_t packed) {
+  return TraceRing::Event{
+      .timestamp_ns = timestamp_ns,
+      .id = static_cast<TraceEventId>(packed & 0xffff),
+      .handle = static_cast<uint16_t>(packed >> 16),
+      .arg = static_cast<uint32_t>(packed >> 32),
+  };
+}
+
+std::vector<TraceRing::Event> ReadRing(const Ring& ring) {
+  uint64_t end = ring.done.load(std::memory_order_acquire);
+  uint64_t begin = end > TraceRing::kRingSize ? end - TraceRing::kRingSize : 0;
+  std::vector<std::pair<uint64_t, uint64_t>> words;
+  words.reserve(end - begin);
+  for (uint64_t i = begin; i < end; i++) {
+    const auto& slot = ring.slots[i & (TraceRing::kRingSize - 1)];
+    words.emplace_back(slot[0].load(std::memory_order_relaxed), slot[1].load(std::memory_order_relaxed));
+  }
+  // Events whose slot was reused while copying are dropped, they may be torn
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t begun = ring.begun.load(std::memory_order_relaxed);
+  uint64_t first_valid = begun > TraceRing::kRingSize ? begun - TraceRing::kRingSize : 0;
+
+  std::vector<TraceRing::Event> events;
+  events.reserve(words.size());
+  for (uint64_t i = std::max(begin, first_valid); i < end; i++) {
+    const auto& event_words = words[i - begin];
+    events.push_back(Unpack(event_words.first, event_words.second));
+  }
+  return events;
+}
+
+// Events traced as the begin and end of a slice, the others are instants
+bool IsBegin(TraceEventId id) {
+  return id == TraceEventId::A2DP_ENCODE_BEGIN;
+}
+
+bool IsEnd(TraceEventId id) {
+  return id == TraceEventId::A2DP_ENCODE_END;
+}
+
+}  // namespace
+
+std::string TraceEventIdText(TraceEventId id) {
+  switch (id) {
+    case TraceEventId::HCI_COMMAND_TX:
+      return "HCI_COMMAND_TX";
+    case TraceEventId::HCI_EVENT_RX:
+      return "HCI_EVENT_RX";
+    case TraceEventId::HCI_ACL_TX:
+      return "HCI_ACL_TX";
+    case TraceEventId::HCI_ACL_RX:
+      return "HCI_ACL_RX";
+    case TraceEventId::HCI_SCO_TX:
+      return "HCI_SCO_TX";
+    case TraceEventId::HCI_SCO_RX:
+      return "HCI_SCO_RX";
+    case TraceEventId::HCI_ISO_TX:
+      return "HCI_ISO_TX";
+    case TraceEventId::HCI_ISO_RX:
+      return "HCI_ISO_RX";
+    case TraceEventId::L2CAP_ENQUEUE:
+      return "L2CAP_ENQUEUE";
+    case TraceEventId::L2CAP_DEQUEUE:
+      return "L2CAP_DEQUEUE";
+    case TraceEventId::A2DP_ENCODE_BEGIN:
+    case TraceEventId::A2DP_ENCODE_END:
+      return "A2DP_ENCODE";
+    case TraceEventId::GATT_REQUEST:
+      return "GATT_REQUEST";
+    case TraceEventId::GATT_RESPONSE:
+      return "GATT_RESPONSE";
+    case TraceEventId::NUM_EVENT_IDS:
+      break;
+  }
+  return "UNKNOWN(" + std::to_string(static_cast<uint16_t>(id)) + ")";
+}
+
+void TraceRing::Record(TraceEventId id, uint16_t handle, uint32_t arg) {
+  uint64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+  Ring& ring = GetThreadRing();
+  uint64_t index = ring.begun.load(std::memory_order_relaxed);
+  ring.begun.store(index + 1, std::memory_order_relaxed);
+  // Orders |begun| before the slot stores, for readers to see that the slot is reused
+  std::atomic_thread_fence(std::memory_order_release);
+  auto& slot = ring.slots[index & (kRingSize - 1)];
+  slot[0].store(timestamp_ns, std::memory_order_relaxed);
+  slot[1].store(Pack(id, handle, arg), std::memory_order_relaxed);
+  ring.done.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceRing::ThreadEvents> TraceRing::GetAllEvents() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    rings = registry.rings;
+  }
+  std::vector<ThreadEvents> threads;
+  for (const auto& ring : rings) {
+    auto events = ReadRing(*ring);
+    if (events.empty()) {
+      continue;
+    }
+    threads.push_back(ThreadEvents{
+        .thread_name = ring->thread_name,
+        .thread_id = ring->thread_id,
+        .events = std::move(events),
+    });
+  }
+  return threads;
+}
+
+void TraceRing::DebugDump(int fd) {
+  dprintf(fd, "\nTrace ring, Chrome JSON trace format (open with ui.perfetto.dev):\n");
+  int pid = static_cast<int>(getpid());
+  dprintf(fd, "{\"traceEvents\":[\n");
+  bool first = true;
+  for (const ThreadEvents& thread : GetAllEvents()) {
+    dprintf(
+        fd,
+        "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        first ? "" : ",\n",
+        pid,
+        thread.thread_id,
+        thread.thread_name.c_str());
+    first = false;
+    for (const Event& event : thread.events) {
+      const char* phase = IsBegin(event.id) ? "B" : IsEnd(event.id) ? "E" : "i";
+      dprintf(
+          fd,
+          ",\n{\"name\":\"%s\",\"cat\":\"bluetooth\",\"ph\":\"%s\",\"s\":\"t\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d,"
+          "\"args\":{\"handle\":%u,\"arg\":%u}}",
+          TraceEventIdText(event.id).c_str(),
+          phase,
+          static_cast<unsigned long long>(event.timestamp_ns / 1000),
+          static_cast<unsigned>(event.timestamp_ns % 1000),
+          pid,
+          thread.thread_id,
+          event.handle,
+          event.arg);
+    }
+  }
+  dprintf(fd, "\n]}\n");
+}
+
+}  // namespace common
+}  // namespace bluetooth
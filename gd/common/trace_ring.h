@@ -0,0 +1,87 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+namespace common {
+
+enum class TraceEventId : uint16_t {
+  HCI_COMMAND_TX = 0,
+  HCI_EVENT_RX,
+  HCI_ACL_TX,
+  HCI_ACL_RX,
+  HCI_SCO_TX,
+  HCI_SCO_RX,
+  HCI_ISO_TX,
+  HCI_ISO_RX,
+  L2CAP_ENQUEUE,
+  L2CAP_DEQUEUE,
+  A2DP_ENCODE_BEGIN,
+  A2DP_ENCODE_END,
+  GATT_REQUEST,
+  GATT_RESPONSE,
+  NUM_EVENT_IDS,
+};
+
+std::string TraceEventIdText(TraceEventId id);
+
+// Always on trace of compact events at key points of the data path (HCI, L2CAP, A2DP, GATT), to follow the latency of
+// a packet through the stack in any build.
+// Each thread records into its own ring of its last kRingSize events, without locks or allocation once the ring
+// exists, so recording costs a clock read and a few stores. Dumping reads the rings of all threads concurrently, and
+// leaves out the events being overwritten meanwhile.
+class TraceRing {
+ public:
+  // Power of two
+  static constexpr size_t kRingSize = 1024;
+  // Rings of exited threads kept for dumping, the oldest are dropped beyond this
+  static constexpr size_t kMaxExitedThreads = 8;
+
+  struct Event {
+    // steady_clock, i.e. CLOCK_MONOTONIC
+    uint64_t timestamp_ns;
+    TraceEventId id;
+    // Connection handle, channel or other identifier of the traced flow
+    uint16_t handle;
+    // Event specific, e.g. a length or an opcode
+    uint32_t arg;
+  };
+
+  struct ThreadEvents {
+    std::string thread_name;
+    int thread_id;
+    // Oldest first
+    std::vector<Event> events;
+  };
+
+  // Record an event on the calling thread
+  static void Record(TraceEventId id, uint16_t handle = 0, uint32_t arg = 0);
+
+  // Return a copy of the events of every thread that recorded any
+  static std::vector<ThreadEvents> GetAllEvents();
+
+  // Write the events of every thread in the Chrome JSON trace format, which Perfetto opens
+  static void DebugDump(int fd);
+};
+
+}  // namespace common
+}  // namespace bluetooth
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "common/trace_ring.h"
+
+using ::benchmark::State;
+using bluetooth::common::TraceEventId;
+using bluetooth::common::TraceRing;
+
+static void BM_TraceRing_record(State& state) {
+  uint32_t arg = 0;
+  for (auto _ : state) {
+    TraceRing::Record(TraceEventId::HCI_ACL_RX, 1, arg++);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceRing_record)->ThreadRange(1, 4);
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/trace_ring.h"
+
+#include <gtest/gtest.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+namespace testing {
+
+using bluetooth::common::TraceEventId;
+using bluetooth::common::TraceRing;
+
+static int CurrentThreadId() {
+  return static_cast<int>(syscall(SYS_gettid));
+}
+
+static std::vector<TraceRing::Event> GetThreadEvents(int thread_id) {
+  for (auto& thread : TraceRing::GetAllEvents()) {
+    if (thread.thread_id == thread_id) {
+      return thread.events;
+    }
+  }
+  return {};
+}
+
+TEST(TraceRingTest, records_in_order) {
+  std::vector<TraceRing::Event> events;
+  int thread_id = 0;
+  std::thread thread([&thread_id]() {
+    thread_id = CurrentThreadId();
+    TraceRing::Record(TraceEventId::HCI_ACL_TX, 1, 27);
+    TraceRing::Record(TraceEventId::HCI_ACL_RX, 2, 0xffffffff);
+  });
+  thread.join();
+  // Kept after the thread exited
+  events = GetThreadEvents(thread_id);
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].id, TraceEventId::HCI_ACL_TX);
+  EXPECT_EQ(events[0].handle, 1);
+  EXPECT_EQ(events[0].arg, 27u);
+  EXPECT_EQ(events[1].id, TraceEventId::HCI_ACL_RX);
+  EXPECT_EQ(events[1].handle, 2);
+  EXPECT_EQ(events[1].arg, 0xffffffffu);
+  EXPECT_LE(events[0].timestamp_ns, events[1].timestamp_ns);
+}
+
+TEST(TraceRingTest, keeps_last_events) {
+  int thread_id = 0;
+  std::thread thread([&thread_id]() {
+    thread_id = CurrentThreadId();
+    for (uint32_t i = 0; i < TraceRing::kRingSize + 10; i++) {
+      TraceRing::Record(TraceEventId::L2CAP_ENQUEUE, 0, i);
+    }
+  });
+  thread.join();
+  auto events = GetThreadEvents(thread_id);
+  ASSERT_EQ(events.size(), TraceRing::kRingSize);
+  EXPECT_EQ(events.front().arg, 10u);
+  EXPECT_EQ(events.back().arg, TraceRing::kRingSize + 9);
+}
+
+TEST(TraceRingTest, read_while_recording) {
+  std::atomic<bool> stop = false;
+  std::atomic<int> thread_id = 0;
+  std::thread thread([&stop, &thread_id]() {
+    thread_id = CurrentThreadId();
+    for (uint32_t i = 0; !stop; i++) {
+      // The handle and argument of each event match
+      TraceRing::Record(TraceEventId::GATT_REQUEST, static_cast<uint16_t>(i), i);
+    }
+  });
+  while (thread_id == 0) {
+  }
+  for (int i = 0; i < 100; i++) {
+    auto events = GetThreadEvents(thread_id);
+    for (size_t j = 0; j < events.size(); j++) {
+      ASSERT_EQ(events[j].handle, static_cast<uint16_t>(events[j].arg));
+      if (j > 0) {
+        ASSERT_EQ(events[j].arg, events[j - 1].arg + 1);
+      }
+    }
+  }
+  stop = true;
+  thread.join();
+}
+
+TEST(TraceRingTest, exited_threads_are_bounded) {
+  for (size_t i = 0; i < TraceRing::kMaxExitedThreads + 4; i++) {
+    std::thread([]() { TraceRing::Record(TraceEventId::GATT_RESPONSE); }).join();
+  }
+  // Registering a thread drops the oldest exited ones
+  std::thread([]() { TraceRing::Record(TraceEventId::GATT_RESPONSE); }).join();
+  EXPECT_LE(TraceRing::GetAllEvents().size(), TraceRing::kMaxExitedThreads + 2);
+}
+
+TEST(TraceRingTest, event_id_text) {
+  EXPECT_EQ(bluetooth::common::TraceEventIdText(TraceEventId::HCI_EVENT_RX), "HCI_EVENT_RX");
+  EXPECT_EQ(bluetooth::common::TraceEventIdText(TraceEventId::NUM_EVENT_IDS), "UNKNOWN(14)");
+}
+
+}  // namespace testing
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crypto_toolbox/aes_hw.h"
+
+#include <atomic>
+#include <cstring>
+
+/* AES-NI is compiled in on every x86 build and only used when the CPU has it. The ARMv8 instructions need the build to
+ * target them, the CPU is checked at run time as well */
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#define AES_HW_X86 1
+#define AES_NI_TARGET __attribute__((target("aes,sse2")))
+#elif (defined(__aarch64__) || defined(__arm__)) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#include <arm_neon.h>
+#define AES_HW_ARMV8 1
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr int kAes128Rounds = 10;
+constexpr size_t kAesBlockSize = 16;
+
+#if defined(AES_HW_X86)
+AES_NI_TARGET void aes_ni_cbc_mac(const uint8_t* blocks, size_t num_blocks, uint8_t* x, const aes_context& ctx) {
+  const __m128i* ksch = reinterpret_cast<const __m128i*>(ctx.ksch);
+  __m128i round_keys[kAes128Rounds + 1];
+  for (int round = 0; round <= kAes128Rounds; round++) {
+    round_keys[round] = _mm_loadu_si128(ksch + round);
+  }
+
+  __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+  for (size_t i = 0; i < num_blocks; i++) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * kAesBlockSize));
+    state = _mm_xor_si128(_mm_xor_si128(state, block), round_keys[0]);
+    for (int round = 1; round < kAes128Rounds; round++) {
+      state = _mm_aesenc_si128(state, round_keys[round]);
+    }
+    state = _mm_aesenclast_si128(state, round_keys[kAes128Rounds]);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(x), state);
+}
+
+bool cpu_has_aes_ni() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes") && __builtin_cpu_supports("sse2");
+}
+#endif
+
+#if defined(AES_HW_ARMV8)
+void armv8_cbc_mac(const uint8_t* blocks, size_t num_blocks, uint8_t* x, const aes_context& ctx) {
+  uint8x16_t round_keys[kAes128Rounds + 1];
+  for (int round = 0; round <= kAes128Rounds; round++) {
+    round_keys[round] = vld1q_u8(ctx.ksch + round * kAesBlockSize);
+  }
+
+  uint8x16_t state = vld1q_u8(x);
+  for (size_t i = 0; i < num_blocks; i++) {
+    state = veorq_u8(state, vld1q_u8(blocks + i * kAesBlockSize));
+    for (int round = 0; round < kAes128Rounds - 1; round++) {
+      state = vaesmcq_u8(vaeseq_u8(state, round_keys[round]));
+    }
+    state = vaeseq_u8(state, round_keys[kAes128Rounds - 1]);
+    state = veorq_u8(state, round_keys[kAes128Rounds]);
+  }
+  vst1q_u8(x, state);
+}
+
+bool cpu_has_armv8_aes() {
+#if defined(__linux__) && defined(__aarch64__)
+  return (getauxval(AT_HWCAP) & (1 << 3) /* HWCAP_AES */) != 0;
+#elif defined(__linux__)
+  return (getauxval(AT_HWCAP2) & (1 << 0) /* HWCAP2_AES */) != 0;
+#else
+  return true;
+#endif
+}
+#endif
+
+void software_cbc_mac(const uint8_t* blocks, size_t num_blocks, uint8_t* x, const aes_context& ctx) {
+  for (size_t i = 0; i < num_blocks; i++) {
+    for (size_t j = 0; j < kAesBlockSize; j++) {
+      x[j] ^= blocks[i * kAesBlockSize + j];
+    }
+    aes_encrypt(x, x, &ctx);
+  }
+}
+
+bool is_supported(AesBackend backend) {
+  switch (backend) {
+    case AesBackend::kSoftware:
+      return true;
+    case AesBackend::kAesNi:
+#if defined(AES_HW_X86)
+      return cpu_has_aes_ni();
+#else
+      return false;
+#endif
+    case AesBackend::kArmv8:
+#if defined(AES_HW_ARMV8)
+      return cpu_has_armv8_aes();
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+std::atomic<AesBackend>& selected_backend() {
+  static std::atomic<AesBackend> backend{aes_detect_backend()};
+  return backend;
+}
+
+}  // namespace
+
+AesBackend aes_detect_backend() {
+  if (is_supported(AesBackend::kAesNi)) return AesBackend::kAesNi;
+  if (is_supported(AesBackend::kArmv8)) return AesBackend::kArmv8;
+  return AesBackend::kSoftware;
+}
+
+AesBackend aes_get_backend() {
+  return selected_backend().load(std::memory_order_relaxed);
+}
+
+bool aes_set_backend(AesBackend backend) {
+  if (!is_supported(backend)) return false;
+  selected_backend().store(backend, std::memory_order_relaxed);
+  return true;
+}
+
+void aes_encrypt_block(const uint8_t* in, uint8_t* out, const aes_context& ctx) {
+  uint8_t state[16] = {0};
+  aes_cbc_mac(in, 1, state, ctx);
+  memcpy(out, state, sizeof(state));
+}
+
+void aes_cbc_mac(const uint8_t* blocks, size_t num_blocks, uint8_t* x, const aes_context& ctx) {
+  switch (aes_get_backend()) {
+#if defined(AES_HW_X86)
+    case AesBackend::kAesNi:
+      aes_ni_cbc_mac(blocks, num_blocks, x, ctx);
+      return;
+#endif
+#if defined(AES_HW_ARMV8)
+    case AesBackend::kArmv8:
+      armv8_cbc_mac(blocks, num_blocks, x, ctx);
+      return;
+#endif
+    default:
+      software_cbc_mac(blocks, num_blocks, x, ctx);
+      return;
+  }
+}
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "crypto_toolbox/aes.h"
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+/* Implementations of the AES-128 block encryption. The software one is always available, the others depend on the
+ * CPU the stack runs on */
+enum class AesBackend {
+  kSoftware,
+  kAesNi,  /* x86 AES-NI */
+  kArmv8,  /* ARMv8 Cryptography Extensions */
+};
+
+/* Returns the fastest backend the CPU supports */
+AesBackend aes_detect_backend();
+
+/* Returns the backend the block functions below run on, the detected one unless aes_set_backend() picked another */
+AesBackend aes_get_backend();
+
+/* Makes the block functions run on |backend|, for tests and benchmarks. Returns false, and keeps the current backend,
+ * if the CPU lacks it */
+bool aes_set_backend(AesBackend backend);
+
+/* Encrypts the block |in| into |out| with the expanded key |ctx|, all in AES byte order */
+void aes_encrypt_block(const uint8_t* in, uint8_t* out, const aes_context& ctx);
+
+/* CBC-MAC over |num_blocks| consecutive blocks of |blocks|: for each block, |x| = AES(ctx, |x| XOR block). The blocks
+ * and |x| are in AES byte order. The round keys and the chaining value stay in registers for the whole message on the
+ * hardware backends */
+void aes_cbc_mac(const uint8_t* blocks, size_t num_blocks, uint8_t* x, const aes_context& ctx);
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "crypto_toolbox/aes.h"
+#include "crypto_toolbox/aes_hw.h"
 
 namespace bluetooth {
 namespace crypto_toolbox {
@@ -352,5 +353,30 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+// Every backend the CPU supports computes the same AES and CMAC as the software one, over messages of all the lengths
+// around the block boundaries and longer than a chunk
+TEST(CryptoToolboxTest, aes_backends_test) {
+  Octet16 key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+  std::vector<uint8_t> message(600);
+  for (size_t i = 0; i < message.size(); i++) message[i] = i * 7 + 3;
+
+  AesBackend detected = aes_get_backend();
+  ASSERT_TRUE(aes_set_backend(AesBackend::kSoftware));
+  std::vector<Octet16> expected;
+  for (size_t length = 0; length <= message.size(); length++) {
+    expected.push_back(aes_cmac(key, message.data(), length));
+  }
+  Octet16 expected_aes = aes_128(key, message.data(), OCTET16_LEN);
+
+  for (AesBackend backend : {AesBackend::kAesNi, AesBackend::kArmv8}) {
+    if (!aes_set_backend(backend)) continue;
+    EXPECT_EQ(expected_aes, aes_128(key, message.data(), OCTET16_LEN));
+    for (size_t length = 0; length <= message.size(); length++) {
+      ASSERT_EQ(expected[length], aes_cmac(key, message.data(), length)) << "length " << length;
+    }
+  }
+  ASSERT_TRUE(aes_set_backend(detected));
+}
+
 }  // namespace crypto_toolbox
 }  // namespace bluetooth
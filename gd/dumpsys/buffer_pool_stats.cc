@@ -0,0 +1,45 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dumpsys/buffer_pool_stats.h"
+#include "buffer_pool_generated.h"
+#include "packet/buffer_pool.h"
+
+#include <vector>
+
+flatbuffers::Offset<bluetooth::packet::BufferPoolData> bluetooth::dumpsys::BufferPoolStats::Dump(
+    flatbuffers::FlatBufferBuilder* fb_builder) {
+  auto stats = packet::BufferPool::Get().GetStats();
+
+  std::vector<flatbuffers::Offset<packet::BufferPoolSizeClassData>> size_classes;
+  for (const auto& size_class : stats.size_classes) {
+    packet::BufferPoolSizeClassDataBuilder builder(*fb_builder);
+    builder.add_buffer_size(size_class.buffer_size);
+    builder.add_num_allocations(size_class.num_allocations);
+    builder.add_num_reused(size_class.num_reused);
+    builder.add_num_in_use(size_class.num_in_use);
+    builder.add_num_cached(size_class.num_cached);
+    size_classes.push_back(builder.Finish());
+  }
+
+  auto title = fb_builder->CreateString("----- Packet Buffer Pool -----");
+  auto size_classes_vector = fb_builder->CreateVector(size_classes);
+  packet::BufferPoolDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_size_classes(size_classes_vector);
+  builder.add_num_oversized_allocations(stats.num_oversized_allocations);
+  return builder.Finish();
+}
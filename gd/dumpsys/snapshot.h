@@ -0,0 +1,51 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace bluetooth {
+namespace dumpsys {
+
+// The last published copy of some state, for dumpsys to read from its own thread without posting to, and waiting on,
+// the thread owning the state.
+// Publish() and Read() only exchange a shared pointer, so neither waits for the other to copy the state, and a copy
+// being read stays valid while newer ones are published.
+template <typename T>
+class Snapshot {
+ public:
+  Snapshot() = default;
+  Snapshot(const Snapshot&) = delete;
+  Snapshot& operator=(const Snapshot&) = delete;
+
+  void Publish(T value) {
+    std::atomic_store(&value_, std::shared_ptr<const T>(std::make_shared<T>(std::move(value))));
+  }
+
+  // nullptr until the first Publish()
+  std::shared_ptr<const T> Read() const {
+    return std::atomic_load(&value_);
+  }
+
+ private:
+  std::shared_ptr<const T> value_;
+};
+
+}  // namespace dumpsys
+}  // namespace bluetooth
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dumpsys/snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+namespace testing {
+
+using bluetooth::dumpsys::Snapshot;
+
+TEST(DumpsysSnapshotTest, read_before_publish) {
+  Snapshot<std::string> snapshot;
+  ASSERT_EQ(snapshot.Read(), nullptr);
+}
+
+TEST(DumpsysSnapshotTest, read_keeps_copy) {
+  Snapshot<std::string> snapshot;
+  snapshot.Publish("first");
+  auto first = snapshot.Read();
+  snapshot.Publish("second");
+  ASSERT_EQ(*first, "first");
+  ASSERT_EQ(*snapshot.Read(), "second");
+}
+
+TEST(DumpsysSnapshotTest, publish_while_reading) {
+  Snapshot<std::pair<int, int>> snapshot;
+  snapshot.Publish({0, 0});
+  std::thread publisher([&snapshot]() {
+    for (int i = 1; i <= 10000; i++) {
+      snapshot.Publish({i, -i});
+    }
+  });
+  int last = 0;
+  while (last < 10000) {
+    auto value = snapshot.Read();
+    // Each copy is read whole, and copies are published in order
+    ASSERT_EQ(value->first, -value->second);
+    ASSERT_GE(value->first, last);
+    last = value->first;
+  }
+  publisher.join();
+}
+
+}  // namespace testing
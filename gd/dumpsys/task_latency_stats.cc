@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common/task_latency_stats.h"
+#include "dumpsys/task_latency_stats.h"
+#include "task_latency_stats_generated.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+flatbuffers::Offset<bluetooth::common::TaskLatencyHistogramData> dump_histogram(
+    flatbuffers::FlatBufferBuilder* fb_builder, const bluetooth::common::TaskLatencyStats::Histogram& histogram) {
+  auto buckets = fb_builder->CreateVector(histogram.buckets.data(), histogram.buckets.size());
+  bluetooth::common::TaskLatencyHistogramDataBuilder builder(*fb_builder);
+  builder.add_count(histogram.count);
+  builder.add_total_us(histogram.total_us);
+  builder.add_max_us(histogram.max_us);
+  builder.add_buckets(buckets);
+  return builder.Finish();
+}
+
+}  // namespace
+
+flatbuffers::Offset<bluetooth::common::TaskLatencyStatsData> bluetooth::dumpsys::TaskLatencyStats::Dump(
+    flatbuffers::FlatBufferBuilder* fb_builder) {
+  std::vector<flatbuffers::Offset<common::TaskThreadData>> threads;
+  for (const auto& thread : common::TaskLatencyStats::GetAllSnapshots()) {
+    std::vector<flatbuffers::Offset<common::TaskLocationData>> locations;
+    for (const auto& location : thread.locations) {
+      auto location_name =
+          fb_builder->CreateString(std::string(location.file_name) + ":" + std::to_string(location.line_number));
+      auto function_name = fb_builder->CreateString(location.function_name);
+      auto queue_delay = dump_histogram(fb_builder, location.queue_delay);
+      auto execution_time = dump_histogram(fb_builder, location.execution_time);
+      common::TaskLocationDataBuilder location_builder(*fb_builder);
+      location_builder.add_location(location_name);
+      location_builder.add_function_name(function_name);
+      location_builder.add_queue_delay(queue_delay);
+      location_builder.add_execution_time(execution_time);
+      locations.push_back(location_builder.Finish());
+    }
+    auto thread_name = fb_builder->CreateString(thread.thread_name);
+    auto locations_vector = fb_builder->CreateVector(locations);
+    common::TaskThreadDataBuilder thread_builder(*fb_builder);
+    thread_builder.add_thread_name(thread_name);
+    thread_builder.add_locations(locations_vector);
+    threads.push_back(thread_builder.Finish());
+  }
+
+  std::vector<uint64_t> bucket_upper_bounds;
+  for (size_t i = 0; i < common::TaskLatencyStats::kNumBuckets; i++) {
+    bucket_upper_bounds.push_back(common::TaskLatencyStats::BucketUpperBoundUs(i));
+  }
+
+  auto title = fb_builder->CreateString("----- Task Latency Statistics -----");
+  auto bucket_upper_bounds_vector = fb_builder->CreateVector(bucket_upper_bounds);
+  auto threads_vector = fb_builder->CreateVector(threads);
+  common::TaskLatencyStatsDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_bucket_upper_bounds_us(bucket_upper_bounds_vector);
+  builder.add_threads(threads_vector);
+  return builder.Finish();
+}
@@ -31,6 +31,7 @@ class FuzzHciHal : public HciHal {
 
   void sendHciCommand(HciPacket command) override;
   void sendAclData(HciPacket packet) override {}
+  void sendAclDataV(const HciPacketSlices& packet) override {}
   void sendScoData(HciPacket packet) override {}
   void sendIsoData(HciPacket packet) override {}
 
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <sys/uio.h>
+
+#include <memory>
 #include <vector>
 
 #include "module.h"
@@ -24,6 +27,8 @@ namespace bluetooth {
 namespace hal {
 
 using HciPacket = std::vector<uint8_t>;
+// A packet stored as byte ranges that are sent back to back, e.g. a header followed by a payload kept where it is
+using HciPacketSlices = std::vector<iovec>;
 
 enum class Status : int32_t { SUCCESS, TRANSPORT_ERROR, INITIALIZATION_ERROR, UNKNOWN };
 
@@ -51,6 +56,24 @@ class HciHalCallbacks {
   // Send an ISO data packet from the controller to the host
   // @param data the ISO HCI packet to be passed to the host stack
   virtual void isoDataReceived(HciPacket data) = 0;
+
+  // Variants invoked with a buffer from AllocateRxBuffer() (see hal/hci_rx_buffer.h) when an rx buffer allocator is
+  // installed. Callbacks that can share the buffer override these; by default the packet is copied into an HciPacket.
+  virtual void hciEventBufferReceived(std::shared_ptr<const uint8_t> event, size_t size) {
+    hciEventReceived(HciPacket(event.get(), event.get() + size));
+  }
+
+  virtual void aclDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) {
+    aclDataReceived(HciPacket(data.get(), data.get() + size));
+  }
+
+  virtual void scoDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) {
+    scoDataReceived(HciPacket(data.get(), data.get() + size));
+  }
+
+  virtual void isoDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) {
+    isoDataReceived(HciPacket(data.get(), data.get() + size));
+  }
 };
 
 // Mirrors hardware/interfaces/bluetooth/1.0/IBluetoothHci.hal in Android
@@ -88,6 +111,18 @@ class HciHal : public ::bluetooth::Module {
   // Packets must be processed in order.
   virtual void sendAclData(HciPacket data) = 0;
 
+  // Same as sendAclData(), with the packet split in slices. The slices are only valid for the duration of the call.
+  // HALs that can hand slices to the transport as they are override this; by default they are joined into an
+  // HciPacket.
+  virtual void sendAclDataV(const HciPacketSlices& data) {
+    HciPacket packet;
+    for (const auto& slice : data) {
+      auto base = static_cast<const uint8_t*>(slice.iov_base);
+      packet.insert(packet.end(), base, base + slice.iov_len);
+    }
+    sendAclData(std::move(packet));
+  }
+
   // Send an SCO data packet (as specified in the Bluetooth Specification
   // V4.2, Vol 2, Part 5, Section 5.4.3) to the Bluetooth controller.
   // Packets must be processed in order.
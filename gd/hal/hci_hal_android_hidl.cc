@@ -17,9 +17,14 @@
 #include <android/hardware/bluetooth/1.0/types.h>
 #include <android/hardware/bluetooth/1.1/IBluetoothHci.h>
 #include <android/hardware/bluetooth/1.1/IBluetoothHciCallbacks.h>
+#include <sched.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <future>
+#include <memory>
 #include <vector>
 
 #include "btaa/activity_attribution.h"
@@ -27,8 +32,11 @@
 #include "common/stop_watch.h"
 #include "common/strings.h"
 #include "hal/hci_hal.h"
+#include "hal/hci_rx_buffer.h"
 #include "hal/snoop_logger.h"
 #include "os/log.h"
+#include "os/system_properties.h"
+#include "packet/buffer_pool.h"
 
 using ::android::hardware::hidl_vec;
 using ::android::hardware::Return;
@@ -53,6 +61,43 @@ class HciDeathRecipient : public ::android::hardware::hidl_death_recipient {
 
 android::sp<HciDeathRecipient> hci_death_recipient_ = new HciDeathRecipient();
 
+// SCHED_FIFO priority of the HIDL threads delivering HCI packets, left to the binder default when unset or 0
+constexpr char kCallbackPriorityProperty[] = "persist.bluetooth.hal.callback_priority";
+// Comma separated CPUs the HIDL threads delivering HCI packets are pinned to, e.g. "2,3"
+constexpr char kCallbackCpusProperty[] = "persist.bluetooth.hal.callback_cpus";
+
+struct CallbackThreadConfig {
+  int fifo_priority = 0;
+  std::vector<int> cpus;
+};
+
+CallbackThreadConfig ReadCallbackThreadConfig() {
+  CallbackThreadConfig config;
+  auto priority_prop = os::GetSystemProperty(kCallbackPriorityProperty);
+  if (priority_prop) {
+    auto priority = common::Int64FromString(priority_prop.value());
+    if (priority && *priority >= sched_get_priority_min(SCHED_FIFO) &&
+        *priority <= sched_get_priority_max(SCHED_FIFO)) {
+      config.fifo_priority = *priority;
+    } else if (!priority || *priority != 0) {
+      LOG_WARN("Ignoring invalid %s '%s'", kCallbackPriorityProperty, priority_prop->c_str());
+    }
+  }
+  auto cpus_prop = os::GetSystemProperty(kCallbackCpusProperty);
+  if (cpus_prop) {
+    for (const auto& token : common::StringSplit(cpus_prop.value(), ",")) {
+      auto cpu = common::Int64FromString(common::StringTrim(token));
+      if (!cpu || *cpu < 0 || *cpu >= CPU_SETSIZE) {
+        LOG_WARN("Ignoring invalid %s '%s'", kCallbackCpusProperty, cpus_prop->c_str());
+        config.cpus.clear();
+        break;
+      }
+      config.cpus.push_back(*cpu);
+    }
+  }
+  return config;
+}
+
 template <class VecType>
 std::string GetTimerText(const char* func_name, VecType vec) {
   return common::StringFormat(
@@ -64,8 +109,11 @@ std::string GetTimerText(const char* func_name, VecType vec) {
 
 class InternalHciCallbacks : public IBluetoothHciCallbacks {
  public:
-  InternalHciCallbacks(activity_attribution::ActivityAttribution* btaa_logger_, SnoopLogger* btsnoop_logger)
-      : btaa_logger_(btaa_logger_), btsnoop_logger_(btsnoop_logger) {
+  InternalHciCallbacks(
+      activity_attribution::ActivityAttribution* btaa_logger_,
+      SnoopLogger* btsnoop_logger,
+      CallbackThreadConfig thread_config)
+      : btaa_logger_(btaa_logger_), btsnoop_logger_(btsnoop_logger), thread_config_(std::move(thread_config)) {
     init_promise_ = new std::promise<void>();
   }
 
@@ -84,6 +132,7 @@ class InternalHciCallbacks : public IBluetoothHciCallbacks {
 
   Return<void> initializationComplete(HidlStatus status) {
     common::StopWatch(__func__);
+    configure_callback_thread();
     ASSERT(status == HidlStatus::SUCCESS);
     init_promise_->set_value();
     return Void();
@@ -91,58 +140,85 @@ class InternalHciCallbacks : public IBluetoothHciCallbacks {
 
   Return<void> hciEventReceived(const hidl_vec<uint8_t>& event) override {
     common::StopWatch(GetTimerText(__func__, event));
-    std::vector<uint8_t> received_hci_packet(event.begin(), event.end());
-    btsnoop_logger_->Capture(received_hci_packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
-    if (common::init_flags::btaa_hci_is_enabled()) {
-      btaa_logger_->Capture(received_hci_packet, SnoopLogger::PacketType::EVT);
-    }
-    if (callback_ != nullptr) {
-      callback_->hciEventReceived(std::move(received_hci_packet));
-    }
+    configure_callback_thread();
+    receive_into_buffer(event, SnoopLogger::PacketType::EVT, &HciHalCallbacks::hciEventBufferReceived);
     return Void();
   }
 
   Return<void> aclDataReceived(const hidl_vec<uint8_t>& data) override {
     common::StopWatch(GetTimerText(__func__, data));
-    std::vector<uint8_t> received_hci_packet(data.begin(), data.end());
-    btsnoop_logger_->Capture(received_hci_packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
-    if (common::init_flags::btaa_hci_is_enabled()) {
-      btaa_logger_->Capture(received_hci_packet, SnoopLogger::PacketType::ACL);
-    }
-    if (callback_ != nullptr) {
-      callback_->aclDataReceived(std::move(received_hci_packet));
-    }
+    configure_callback_thread();
+    receive_into_buffer(data, SnoopLogger::PacketType::ACL, &HciHalCallbacks::aclDataBufferReceived);
     return Void();
   }
 
   Return<void> scoDataReceived(const hidl_vec<uint8_t>& data) override {
     common::StopWatch(GetTimerText(__func__, data));
-    std::vector<uint8_t> received_hci_packet(data.begin(), data.end());
-    btsnoop_logger_->Capture(received_hci_packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
-    if (common::init_flags::btaa_hci_is_enabled()) {
-      btaa_logger_->Capture(received_hci_packet, SnoopLogger::PacketType::SCO);
-    }
-    if (callback_ != nullptr) {
-      callback_->scoDataReceived(std::move(received_hci_packet));
-    }
+    configure_callback_thread();
+    receive_into_buffer(data, SnoopLogger::PacketType::SCO, &HciHalCallbacks::scoDataBufferReceived);
     return Void();
   }
 
   Return<void> isoDataReceived(const hidl_vec<uint8_t>& data) override {
     common::StopWatch(GetTimerText(__func__, data));
-    std::vector<uint8_t> received_hci_packet(data.begin(), data.end());
-    btsnoop_logger_->Capture(received_hci_packet, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ISO);
-    if (callback_ != nullptr) {
-      callback_->isoDataReceived(std::move(received_hci_packet));
-    }
+    configure_callback_thread();
+    receive_into_buffer(data, SnoopLogger::PacketType::ISO, &HciHalCallbacks::isoDataBufferReceived);
     return Void();
   }
 
  private:
+  // Packets are delivered on whichever thread of the process' HIDL threadpool picked up the transaction. Apply the
+  // configured priority and affinity the first time each of those threads calls in, so the first hop into the stack
+  // is not preempted by ordinary threads.
+  void configure_callback_thread() {
+    thread_local const InternalHciCallbacks* configured_for = nullptr;
+    if (configured_for == this) {
+      return;
+    }
+    configured_for = this;
+    if (thread_config_.fifo_priority > 0) {
+      struct sched_param param = {.sched_priority = thread_config_.fifo_priority};
+      if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+        LOG_ERROR("Unable to set HAL callback thread priority: %s", strerror(errno));
+      }
+    }
+    if (!thread_config_.cpus.empty()) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      for (int cpu : thread_config_.cpus) {
+        CPU_SET(cpu, &cpu_set);
+      }
+      if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        LOG_ERROR("Unable to set HAL callback thread affinity: %s", strerror(errno));
+      }
+    }
+  }
+
+  // Copy the packet out of the HIDL vector straight into an rx buffer, so the stack can keep it without another copy.
+  // The buffer comes from the rx buffer allocator installed by the stack if any, from the packet buffer pool otherwise.
+  void receive_into_buffer(
+      const hidl_vec<uint8_t>& packet,
+      SnoopLogger::PacketType type,
+      void (HciHalCallbacks::*received)(std::shared_ptr<const uint8_t>, size_t)) {
+    auto buffer = AllocateRxBuffer(packet.size());
+    if (buffer == nullptr) {
+      buffer = packet::BufferPool::Get().Allocate(packet.size());
+    }
+    std::copy(packet.begin(), packet.end(), buffer.get());
+    btsnoop_logger_->Capture(buffer.get(), packet.size(), SnoopLogger::Direction::INCOMING, type);
+    if (type != SnoopLogger::PacketType::ISO && common::init_flags::btaa_hci_is_enabled()) {
+      btaa_logger_->Capture(HciPacket(packet.begin(), packet.end()), type);
+    }
+    if (callback_ != nullptr) {
+      (callback_->*received)(std::move(buffer), packet.size());
+    }
+  }
+
   std::promise<void>* init_promise_ = nullptr;
   HciHalCallbacks* callback_ = nullptr;
   activity_attribution::ActivityAttribution* btaa_logger_ = nullptr;
   SnoopLogger* btsnoop_logger_ = nullptr;
+  const CallbackThreadConfig thread_config_;
 };
 
 }  // namespace
@@ -173,6 +249,26 @@ class HciHalHidl : public HciHal {
     bt_hci_->sendAclData(packet);
   }
 
+  void sendAclDataV(const HciPacketSlices& slices) override {
+    // The HIDL interface only takes a contiguous buffer, so join the slices straight into it
+    size_t size = 0;
+    for (const auto& slice : slices) {
+      size += slice.iov_len;
+    }
+    hidl_vec<uint8_t> packet;
+    packet.resize(size);
+    uint8_t* out = packet.data();
+    for (const auto& slice : slices) {
+      out = std::copy_n(static_cast<const uint8_t*>(slice.iov_base), slice.iov_len, out);
+    }
+    btsnoop_logger_->Capture(
+        packet.data(), packet.size(), SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    if (common::init_flags::btaa_hci_is_enabled()) {
+      btaa_logger_->Capture(HciPacket(packet.begin(), packet.end()), SnoopLogger::PacketType::ACL);
+    }
+    bt_hci_->sendAclData(packet);
+  }
+
   void sendScoData(HciPacket packet) override {
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
     if (common::init_flags::btaa_hci_is_enabled()) {
@@ -218,7 +314,7 @@ class HciHalHidl : public HciHal {
     ASSERT_LOG(death_link.isOk(), "Unable to set the death recipient for the Bluetooth HAL");
     // Block allows allocation of a variable that might be bypassed by goto.
     {
-      callbacks_ = new InternalHciCallbacks(btaa_logger_, btsnoop_logger_);
+      callbacks_ = new InternalHciCallbacks(btaa_logger_, btsnoop_logger_, ReadCallbackThreadConfig());
       if (bt_hci_1_1_ != nullptr) {
         bt_hci_1_1_->initialize_1_1(callbacks_);
       } else {
@@ -21,18 +21,24 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <csignal>
+#include <cstring>
+#include <deque>
 #include <mutex>
-#include <queue>
 
 #include "hal/hci_hal.h"
+#include "hal/hci_rx_buffer.h"
 #include "hal/snoop_logger.h"
 #include "os/log.h"
 #include "os/reactor.h"
 #include "os/thread.h"
+#include "packet/buffer_pool.h"
 
 namespace {
 constexpr int INVALID_FD = -1;
@@ -48,7 +54,10 @@ constexpr uint8_t kHciAclHeaderSize = 4;
 constexpr uint8_t kHciScoHeaderSize = 3;
 constexpr uint8_t kHciEvtHeaderSize = 2;
 constexpr uint8_t kHciIsoHeaderSize = 4;
-constexpr int kBufSize = 1024 + 4 + 1;  // DeviceProperties::acl_data_packet_size_ + ACL header + H4 header
+// Holds the largest ACL packet, and many packets of the usual sizes read with one recv()
+constexpr size_t kRxBufferSize = kH4HeaderSize + kHciAclHeaderSize + 0xffff;
+// Most queued packets written with one sendmmsg()
+constexpr size_t kMaxWriteBatch = 32;
 
 #ifdef USE_LINUX_HCI_SOCKET
 constexpr uint8_t BTPROTO_HCI = 1;
@@ -275,7 +284,7 @@ class HciHalHost : public HciHal {
     std::vector<uint8_t> packet = std::move(command);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::CMD);
     packet.insert(packet.cbegin(), kH4Command);
-    write_to_fd(packet);
+    write_to_fd(std::move(packet));
   }
 
   void sendAclData(HciPacket data) override {
@@ -284,7 +293,33 @@ class HciHalHost : public HciHal {
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
     packet.insert(packet.cbegin(), kH4Acl);
-    write_to_fd(packet);
+    write_to_fd(std::move(packet));
+  }
+
+  void sendAclDataV(const HciPacketSlices& data) override {
+    std::lock_guard<std::mutex> lock(api_mutex_);
+    ASSERT(sock_fd_ != INVALID_FD);
+    btsnoop_logger_->Capture(data, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+    uint8_t type = kH4Acl;
+    if (hci_outgoing_queue_.empty()) {
+      // Nothing queued ahead of this packet, so write the H4 type and the slices in place with one writev()
+      HciPacketSlices slices;
+      slices.reserve(data.size() + 1);
+      slices.push_back({&type, kH4HeaderSize});
+      slices.insert(slices.end(), data.begin(), data.end());
+      ssize_t bytes_written;
+      RUN_NO_INTR(bytes_written = writev(sock_fd_, slices.data(), slices.size()));
+      if (bytes_written == -1) {
+        abort();
+      }
+      return;
+    }
+    HciPacket packet = {type};
+    for (const auto& slice : data) {
+      auto base = static_cast<const uint8_t*>(slice.iov_base);
+      packet.insert(packet.end(), base, base + slice.iov_len);
+    }
+    write_to_fd(std::move(packet));
   }
 
   void sendScoData(HciPacket data) override {
@@ -293,7 +328,7 @@ class HciHalHost : public HciHal {
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::SCO);
     packet.insert(packet.cbegin(), kH4Sco);
-    write_to_fd(packet);
+    write_to_fd(std::move(packet));
   }
 
   void sendIsoData(HciPacket data) override {
@@ -302,7 +337,7 @@ class HciHalHost : public HciHal {
     std::vector<uint8_t> packet = std::move(data);
     btsnoop_logger_->Capture(packet, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ISO);
     packet.insert(packet.cbegin(), kH4Iso);
-    write_to_fd(packet);
+    write_to_fd(std::move(packet));
   }
 
  protected:
@@ -355,12 +390,14 @@ class HciHalHost : public HciHal {
   bluetooth::os::Thread hci_incoming_thread_ =
       bluetooth::os::Thread("hci_incoming_thread", bluetooth::os::Thread::Priority::NORMAL);
   bluetooth::os::Reactor::Reactable* reactable_ = nullptr;
-  std::queue<std::vector<uint8_t>> hci_outgoing_queue_;
+  std::deque<std::vector<uint8_t>> hci_outgoing_queue_;
+  std::vector<uint8_t> rx_buffer_ = std::vector<uint8_t>(kRxBufferSize);
+  size_t rx_buffer_used_ = 0;
   SnoopLogger* btsnoop_logger_ = nullptr;
 
   void write_to_fd(HciPacket packet) {
     // TODO: replace this with new queue when it's ready
-    hci_outgoing_queue_.emplace(packet);
+    hci_outgoing_queue_.emplace_back(std::move(packet));
     if (hci_outgoing_queue_.size() == 1) {
       hci_incoming_thread_.GetReactor()->ModifyRegistration(
           reactable_,
@@ -369,14 +406,24 @@ class HciHalHost : public HciHal {
     }
   }
 
+  // Writes the queued packets, up to kMaxWriteBatch of them with one sendmmsg(). Each packet is its own message, so
+  // packets stay separate datagrams on the HCI socket.
   void send_packet_ready() {
     std::lock_guard<std::mutex> lock(this->api_mutex_);
-    auto packet_to_send = this->hci_outgoing_queue_.front();
-    auto bytes_written = write(this->sock_fd_, (void*)packet_to_send.data(), packet_to_send.size());
-    this->hci_outgoing_queue_.pop();
-    if (bytes_written == -1) {
+    size_t count = std::min(hci_outgoing_queue_.size(), kMaxWriteBatch);
+    std::array<struct iovec, kMaxWriteBatch> iovs;
+    std::array<struct mmsghdr, kMaxWriteBatch> messages = {};
+    for (size_t i = 0; i < count; i++) {
+      iovs[i] = {hci_outgoing_queue_[i].data(), hci_outgoing_queue_[i].size()};
+      messages[i].msg_hdr.msg_iov = &iovs[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    int messages_sent;
+    RUN_NO_INTR(messages_sent = sendmmsg(this->sock_fd_, messages.data(), count, 0));
+    if (messages_sent == -1) {
       abort();
     }
+    hci_outgoing_queue_.erase(hci_outgoing_queue_.begin(), hci_outgoing_queue_.begin() + messages_sent);
     if (hci_outgoing_queue_.empty()) {
       this->hci_incoming_thread_.GetReactor()->ModifyRegistration(
           this->reactable_,
@@ -385,6 +432,80 @@ class HciHalHost : public HciHal {
     }
   }
 
+  // Copy a received packet into a buffer shared with the stack: one from the rx buffer allocator installed by the stack
+  // if any, from the packet buffer pool otherwise.
+  void deliver_packet(
+      const uint8_t* packet,
+      size_t size,
+      SnoopLogger::PacketType type,
+      void (HciHalCallbacks::*received)(std::shared_ptr<const uint8_t>, size_t)) {
+    auto buffer = AllocateRxBuffer(size);
+    if (buffer == nullptr) {
+      buffer = packet::BufferPool::Get().Allocate(size);
+    }
+    std::copy(packet, packet + size, buffer.get());
+    btsnoop_logger_->Capture(buffer.get(), size, SnoopLogger::Direction::INCOMING, type);
+    std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
+    if (incoming_packet_callback_ == nullptr) {
+      LOG_INFO("Dropping a packet of type %d after processing", static_cast<int>(type));
+      return;
+    }
+    (incoming_packet_callback_->*received)(std::move(buffer), size);
+  }
+
+  // Size of the H4 header plus HCI header of a packet of type |type|, 0 for an unknown type
+  static size_t header_size(uint8_t type) {
+    switch (type) {
+      case kH4Event:
+        return kH4HeaderSize + kHciEvtHeaderSize;
+      case kH4Acl:
+        return kH4HeaderSize + kHciAclHeaderSize;
+      case kH4Sco:
+        return kH4HeaderSize + kHciScoHeaderSize;
+      case kH4Iso:
+        return kH4HeaderSize + kHciIsoHeaderSize;
+      default:
+        return 0;
+    }
+  }
+
+  // Payload length announced in the HCI header following the H4 header at |h4|
+  static size_t payload_size(const uint8_t* h4) {
+    switch (h4[0]) {
+      case kH4Event:
+        return h4[2];
+      case kH4Acl:
+        return (h4[4] << 8) + h4[3];
+      case kH4Sco:
+        return h4[3];
+      case kH4Iso:
+        return ((h4[4] & 0x3f) << 8) + h4[3];
+      default:
+        return 0;
+    }
+  }
+
+  void deliver_h4_packet(const uint8_t* h4, size_t size) {
+    const uint8_t* packet = h4 + kH4HeaderSize;
+    size -= kH4HeaderSize;
+    switch (h4[0]) {
+      case kH4Event:
+        deliver_packet(packet, size, SnoopLogger::PacketType::EVT, &HciHalCallbacks::hciEventBufferReceived);
+        break;
+      case kH4Acl:
+        deliver_packet(packet, size, SnoopLogger::PacketType::ACL, &HciHalCallbacks::aclDataBufferReceived);
+        break;
+      case kH4Sco:
+        deliver_packet(packet, size, SnoopLogger::PacketType::SCO, &HciHalCallbacks::scoDataBufferReceived);
+        break;
+      case kH4Iso:
+        deliver_packet(packet, size, SnoopLogger::PacketType::ISO, &HciHalCallbacks::isoDataBufferReceived);
+        break;
+    }
+  }
+
+  // Reads as much as the socket has into the rx buffer with a single recv(), then delivers every complete H4 packet
+  // in it. The bytes of a packet that is not complete yet are kept at the head of the buffer for the next read.
   void incoming_packet_received() {
     {
       std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
@@ -393,123 +514,44 @@ class HciHalHost : public HciHal {
         return;
       }
     }
-    uint8_t buf[kBufSize] = {};
 
     ssize_t received_size;
-    RUN_NO_INTR(received_size = recv(sock_fd_, buf, kH4HeaderSize, 0));
+    RUN_NO_INTR(
+        received_size = recv(sock_fd_, rx_buffer_.data() + rx_buffer_used_, rx_buffer_.size() - rx_buffer_used_, 0));
     ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
     if (received_size == 0) {
-      LOG_WARN("Can't read H4 header. EOF received");
+      LOG_WARN("Can't read H4 packet. EOF received");
       raise(SIGINT);
       return;
     }
-
-    if (buf[0] == kH4Event) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciEvtHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciEvtHeaderSize, "malformed HCI event header received");
-
-      uint8_t hci_evt_parameter_total_length = buf[2];
-      ssize_t payload_size;
-      RUN_NO_INTR(
-          payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciEvtHeaderSize, hci_evt_parameter_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(
-          payload_size == hci_evt_parameter_total_length,
-          "malformed HCI event total parameter size received: %zu != %d",
-          payload_size,
-          hci_evt_parameter_total_length);
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciEvtHeaderSize + payload_size);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::EVT);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping an event after processing");
-          return;
-        }
-        incoming_packet_callback_->hciEventReceived(receivedHciPacket);
+    rx_buffer_used_ += received_size;
+
+    size_t offset = 0;
+    while (offset < rx_buffer_used_) {
+      const uint8_t* h4 = rx_buffer_.data() + offset;
+      size_t available = rx_buffer_used_ - offset;
+      size_t headers = header_size(h4[0]);
+      if (headers == 0) {
+        LOG_WARN("Dropping a byte of unknown H4 type 0x%02x", h4[0]);
+        offset++;
+        continue;
       }
-    }
-
-    if (buf[0] == kH4Acl) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciAclHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciAclHeaderSize, "malformed ACL header received");
-
-      uint16_t hci_acl_data_total_length = (buf[4] << 8) + buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciAclHeaderSize, hci_acl_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(
-          payload_size == hci_acl_data_total_length,
-          "malformed ACL length received: %d != %d",
-          payload_size,
-          hci_acl_data_total_length);
-      ASSERT_LOG(hci_acl_data_total_length <= kBufSize - kH4HeaderSize - kHciAclHeaderSize, "packet too long");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciAclHeaderSize + payload_size);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping an ACL packet after processing");
-          return;
-        }
-        incoming_packet_callback_->aclDataReceived(receivedHciPacket);
+      if (available < headers) {
+        break;
       }
-    }
-
-    if (buf[0] == kH4Sco) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciScoHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciScoHeaderSize, "malformed SCO header received");
-
-      uint8_t hci_sco_data_total_length = buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciScoHeaderSize, hci_sco_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_sco_data_total_length, "malformed SCO packet received: size mismatch");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciScoHeaderSize + payload_size);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::SCO);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping a SCO packet after processing");
-          return;
-        }
-        incoming_packet_callback_->scoDataReceived(receivedHciPacket);
+      size_t size = headers + payload_size(h4);
+      ASSERT_LOG(size <= rx_buffer_.size(), "packet too long");
+      if (available < size) {
+        break;
       }
+      deliver_h4_packet(h4, size);
+      offset += size;
     }
 
-    if (buf[0] == kH4Iso) {
-      RUN_NO_INTR(received_size = recv(sock_fd_, buf + kH4HeaderSize, kHciIsoHeaderSize, 0));
-      ASSERT_LOG(received_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(received_size == kHciIsoHeaderSize, "malformed ISO header received");
-
-      uint16_t hci_iso_data_total_length = ((buf[4] & 0x3f) << 8) + buf[3];
-      int payload_size;
-      RUN_NO_INTR(payload_size = recv(sock_fd_, buf + kH4HeaderSize + kHciIsoHeaderSize, hci_iso_data_total_length, 0));
-      ASSERT_LOG(payload_size != -1, "Can't receive from socket: %s", strerror(errno));
-      ASSERT_LOG(payload_size == hci_iso_data_total_length, "malformed ISO packet received: size mismatch");
-
-      HciPacket receivedHciPacket;
-      receivedHciPacket.assign(buf + kH4HeaderSize, buf + kH4HeaderSize + kHciIsoHeaderSize + payload_size);
-      btsnoop_logger_->Capture(receivedHciPacket, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ISO);
-      {
-        std::lock_guard<std::mutex> incoming_packet_callback_lock(incoming_packet_callback_mutex_);
-        if (incoming_packet_callback_ == nullptr) {
-          LOG_INFO("Dropping a ISO packet after processing");
-          return;
-        }
-        incoming_packet_callback_->isoDataReceived(receivedHciPacket);
-      }
+    rx_buffer_used_ -= offset;
+    if (offset > 0 && rx_buffer_used_ > 0) {
+      std::memmove(rx_buffer_.data(), rx_buffer_.data() + offset, rx_buffer_used_);
     }
-    memset(buf, 0, kBufSize);
   }
 };
 
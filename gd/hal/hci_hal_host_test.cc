@@ -25,6 +25,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstring>
 #include <queue>
 #include <thread>
@@ -347,6 +348,39 @@ TEST_F(HciHalRootcanalTest, receive_multiple_acl_sequential) {
   }
 }
 
+TEST_F(HciHalRootcanalTest, receive_multiple_packets_in_one_write) {
+  std::vector<H4Packet> incoming_packets = {
+      make_sample_h4_evt_pkt(3), make_sample_h4_acl_pkt(200), make_sample_h4_sco_pkt(60), make_sample_h4_iso_pkt(5)};
+  H4Packet stream;
+  for (const auto& incoming_packet : incoming_packets) {
+    stream.insert(stream.end(), incoming_packet.begin(), incoming_packet.end());
+  }
+  write(fake_server_socket_, stream.data(), stream.size());
+  while (incoming_packets_queue_.size() != incoming_packets.size()) {
+  }
+  for (const auto& incoming_packet : incoming_packets) {
+    auto packet = incoming_packets_queue_.front();
+    incoming_packets_queue_.pop();
+    check_packet_equal(packet, incoming_packet);
+  }
+}
+
+TEST_F(HciHalRootcanalTest, receive_packet_split_across_writes) {
+  H4Packet incoming_packet = make_sample_h4_acl_pkt(200);
+  // Split within the ACL header, then within the payload
+  write(fake_server_socket_, incoming_packet.data(), 3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  write(fake_server_socket_, incoming_packet.data() + 3, 100);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_TRUE(incoming_packets_queue_.empty());
+  write(fake_server_socket_, incoming_packet.data() + 103, incoming_packet.size() - 103);
+  while (incoming_packets_queue_.size() != 1) {
+  }
+  auto packet = incoming_packets_queue_.front();
+  incoming_packets_queue_.pop();
+  check_packet_equal(packet, incoming_packet);
+}
+
 TEST_F(HciHalRootcanalTest, send_hci_cmd) {
   uint8_t hci_cmd_param_size = 2;
   HciPacket hci_data = make_sample_hci_cmd_pkt(hci_cmd_param_size);
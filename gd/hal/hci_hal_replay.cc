@@ -0,0 +1,336 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_hal_replay.h"
+
+#include <time.h>
+
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+constexpr uint8_t kBtSnoopPattern[] = {'b', 't', 's', 'n', 'o', 'o', 'p', '\0'};
+constexpr uint32_t kBtSnoopVersion = 1;
+constexpr uint32_t kBtSnoopDatalinkHciUart = 1002;
+constexpr uint32_t kFlagIncoming = 0x01;
+constexpr uint64_t kBtSnoopEpochDelta = 0x00dcddb30f2f8000ULL;
+constexpr size_t kFileHeaderSize = 16;
+constexpr size_t kRecordHeaderSize = 24;
+
+constexpr uint8_t kCommandCompleteCode = 0x0e;
+constexpr uint8_t kCommandStatusCode = 0x0f;
+constexpr uint8_t kUnknownHciCommand = 0x01;
+
+uint32_t read_be32(const uint8_t* data) {
+  return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) | (uint32_t{data[2]} << 8) | data[3];
+}
+
+uint64_t read_be64(const uint8_t* data) {
+  return (uint64_t{read_be32(data)} << 32) | read_be32(data + 4);
+}
+
+// Returns true and the opcode of |event| if it is a Command Complete or a Command Status for a command
+bool get_command_response_opcode(const HciPacket& event, uint16_t* opcode) {
+  size_t offset;
+  if (event.size() >= 5 && event[0] == kCommandCompleteCode) {
+    offset = 3;
+  } else if (event.size() >= 6 && event[0] == kCommandStatusCode) {
+    offset = 4;
+  } else {
+    return false;
+  }
+  *opcode = event[offset] | (event[offset + 1] << 8);
+  // Opcode 0x0000 only returns command credits, it answers no command
+  return *opcode != 0;
+}
+
+std::chrono::microseconds get_process_cpu_time() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::duration_cast<std::chrono::microseconds>(
+                                               std::chrono::nanoseconds(ts.tv_nsec));
+}
+
+void add_sample(HciHalReplay::PacketStats* stats, size_t size, std::chrono::microseconds time) {
+  stats->count++;
+  stats->bytes += size;
+  stats->total_time += time;
+  if (time > stats->max_time) {
+    stats->max_time = time;
+  }
+}
+}  // namespace
+
+bool HciHalReplay::ParseBtsnoop(const std::string& path, std::vector<Record>* records) {
+  std::ifstream file(path, std::ios::binary);
+  uint8_t file_header[kFileHeaderSize];
+  if (!file.read(reinterpret_cast<char*>(file_header), sizeof(file_header)) ||
+      std::memcmp(file_header, kBtSnoopPattern, sizeof(kBtSnoopPattern)) != 0 ||
+      read_be32(file_header + 8) != kBtSnoopVersion || read_be32(file_header + 12) != kBtSnoopDatalinkHciUart) {
+    LOG_WARN("%s is not a btsnoop capture of HCI packets", path.c_str());
+    return false;
+  }
+
+  records->clear();
+  uint64_t first_timestamp = 0;
+  uint8_t header[kRecordHeaderSize];
+  while (file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    uint32_t length_original = read_be32(header);
+    uint32_t length_captured = read_be32(header + 4);
+    uint32_t flags = read_be32(header + 8);
+    uint64_t timestamp = read_be64(header + 16) - kBtSnoopEpochDelta;
+
+    std::vector<uint8_t> data(length_captured);
+    if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) {
+      LOG_WARN("%s ends in the middle of a record", path.c_str());
+      break;
+    }
+    if (length_captured == 0 || length_captured != length_original || data[0] < SnoopLogger::PacketType::CMD ||
+        data[0] > SnoopLogger::PacketType::ISO) {
+      continue;
+    }
+    if (records->empty()) {
+      first_timestamp = timestamp;
+    }
+    records->push_back(Record{
+        .type = static_cast<SnoopLogger::PacketType>(data[0]),
+        .incoming = (flags & kFlagIncoming) != 0,
+        .timestamp = std::chrono::microseconds(timestamp - first_timestamp),
+        .packet = HciPacket(data.begin() + 1, data.end()),
+    });
+  }
+  return true;
+}
+
+HciHalReplay::HciHalReplay(std::vector<Record> records, double speed) : records_(std::move(records)), speed_(speed) {
+  for (size_t i = 0; i < records_.size(); i++) {
+    uint16_t opcode;
+    if (records_[i].incoming && records_[i].type == SnoopLogger::PacketType::EVT &&
+        get_command_response_opcode(records_[i].packet, &opcode)) {
+      command_responses_[opcode].push_back(i);
+    }
+  }
+}
+
+HciHalReplay::~HciHalReplay() {
+  if (thread_.joinable()) {
+    Stop();
+  }
+}
+
+void HciHalReplay::registerIncomingPacketCallback(HciHalCallbacks* callback) {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  ASSERT(callback_ == nullptr && callback != nullptr);
+  callback_ = callback;
+}
+
+void HciHalReplay::unregisterIncomingPacketCallback() {
+  std::lock_guard<std::mutex> lock(callback_mutex_);
+  callback_ = nullptr;
+}
+
+void HciHalReplay::sendHciCommand(HciPacket command) {
+  ASSERT(command.size() >= 2);
+  uint16_t opcode = command[0] | (command[1] << 8);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_outgoing(SnoopLogger::PacketType::CMD, command.size());
+  commands_sent_++;
+  auto responses = command_responses_.find(opcode);
+  if (responses != command_responses_.end() && !responses->second.empty()) {
+    pending_responses_.push_back(records_[responses->second.front()].packet);
+    responses->second.pop_front();
+  } else {
+    LOG_WARN("No recorded response to opcode 0x%04hx", opcode);
+    pending_responses_.push_back(
+        {kCommandCompleteCode, 0x04, 0x01, static_cast<uint8_t>(opcode), static_cast<uint8_t>(opcode >> 8),
+         kUnknownHciCommand});
+  }
+  cv_.notify_all();
+}
+
+void HciHalReplay::sendAclData(HciPacket data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_outgoing(SnoopLogger::PacketType::ACL, data.size());
+}
+
+void HciHalReplay::sendScoData(HciPacket data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_outgoing(SnoopLogger::PacketType::SCO, data.size());
+}
+
+void HciHalReplay::sendIsoData(HciPacket data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  count_outgoing(SnoopLogger::PacketType::ISO, data.size());
+}
+
+bool HciHalReplay::WaitForCompletion(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return cv_.wait_for(lock, timeout, [this] { return completed_; });
+}
+
+HciHalReplay::PacketStats HciHalReplay::GetIncomingStats(SnoopLogger::PacketType type) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto stats = incoming_stats_.find(type);
+  return stats == incoming_stats_.end() ? PacketStats() : stats->second;
+}
+
+HciHalReplay::PacketStats HciHalReplay::GetOutgoingStats(SnoopLogger::PacketType type) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto stats = outgoing_stats_.find(type);
+  return stats == outgoing_stats_.end() ? PacketStats() : stats->second;
+}
+
+std::chrono::microseconds HciHalReplay::GetProcessCpuTime() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return (completed_ ? completion_cpu_time_ : get_process_cpu_time()) - start_cpu_time_;
+}
+
+void HciHalReplay::Start() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    start_cpu_time_ = get_process_cpu_time();
+  }
+  thread_ = std::thread(&HciHalReplay::replay, this);
+}
+
+void HciHalReplay::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    cv_.notify_all();
+  }
+  thread_.join();
+}
+
+void HciHalReplay::replay() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto anchor = std::chrono::steady_clock::now();
+  std::chrono::microseconds anchor_timestamp{0};
+  size_t recorded_commands = 0;
+
+  for (const Record& record : records_) {
+    deliver_responses(lock);
+    if (stopping_) {
+      return;
+    }
+
+    if (!record.incoming) {
+      if (record.type != SnoopLogger::PacketType::CMD) {
+        continue;
+      }
+      // Hold playback until the host catches up, then play the rest relative to that point
+      recorded_commands++;
+      auto deadline = std::chrono::steady_clock::now() + kCommandTimeout;
+      while (!stopping_ && commands_sent_ < recorded_commands) {
+        if (cv_.wait_until(lock, deadline) == std::cv_status::timeout) {
+          LOG_WARN("Host did not send recorded command %zu", recorded_commands);
+          break;
+        }
+        deliver_responses(lock);
+      }
+      anchor = std::chrono::steady_clock::now();
+      anchor_timestamp = record.timestamp;
+      continue;
+    }
+
+    uint16_t opcode;
+    if (record.type == SnoopLogger::PacketType::EVT && get_command_response_opcode(record.packet, &opcode)) {
+      // Sent when the host sends the command
+      continue;
+    }
+
+    if (speed_ > 0) {
+      auto due = anchor + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              (record.timestamp - anchor_timestamp) / speed_);
+      while (!stopping_ && cv_.wait_until(lock, due) != std::cv_status::timeout) {
+        deliver_responses(lock);
+      }
+      if (stopping_) {
+        return;
+      }
+    }
+    deliver(lock, record.type, record.packet);
+  }
+
+  completion_cpu_time_ = get_process_cpu_time();
+  completed_ = true;
+  cv_.notify_all();
+  LOG_INFO("Played back %zu records", records_.size());
+
+  // Keep answering the commands of the host
+  while (!stopping_) {
+    deliver_responses(lock);
+    cv_.wait(lock, [this] { return stopping_ || !pending_responses_.empty(); });
+  }
+}
+
+void HciHalReplay::deliver_responses(std::unique_lock<std::mutex>& lock) {
+  while (!pending_responses_.empty()) {
+    HciPacket response = std::move(pending_responses_.front());
+    pending_responses_.pop_front();
+    deliver(lock, SnoopLogger::PacketType::EVT, response);
+  }
+}
+
+void HciHalReplay::deliver(std::unique_lock<std::mutex>& lock, SnoopLogger::PacketType type, const HciPacket& packet) {
+  lock.unlock();
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> callback_lock(callback_mutex_);
+    if (callback_ != nullptr) {
+      switch (type) {
+        case SnoopLogger::PacketType::EVT:
+          callback_->hciEventReceived(packet);
+          break;
+        case SnoopLogger::PacketType::ACL:
+          callback_->aclDataReceived(packet);
+          break;
+        case SnoopLogger::PacketType::SCO:
+          callback_->scoDataReceived(packet);
+          break;
+        case SnoopLogger::PacketType::ISO:
+          callback_->isoDataReceived(packet);
+          break;
+        case SnoopLogger::PacketType::CMD:
+          break;
+      }
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  lock.lock();
+
+  add_sample(&incoming_stats_[type], packet.size(), std::chrono::duration_cast<std::chrono::microseconds>(end - start));
+  delivered_ = true;
+  last_delivery_ = end;
+}
+
+void HciHalReplay::count_outgoing(SnoopLogger::PacketType type, size_t size) {
+  std::chrono::microseconds latency{0};
+  if (delivered_) {
+    latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - last_delivery_);
+  }
+  add_sample(&outgoing_stats_[type], size, latency);
+}
+
+}  // namespace hal
+}  // namespace bluetooth
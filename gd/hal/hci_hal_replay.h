@@ -0,0 +1,130 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "hal/hci_hal.h"
+#include "hal/snoop_logger.h"
+
+namespace bluetooth {
+namespace hal {
+
+// An HciHal that plays the controller side of a btsnoop capture back to the stack, to profile recorded workloads
+// deterministically. Packets from the controller are delivered with the recorded gaps divided by the speed, or back to
+// back with a speed of zero. Commands from the host are answered with the next recorded Command Complete or Command
+// Status for their opcode, and recorded host commands hold playback until the host has sent as many. Packets sent by
+// the host are otherwise dropped.
+//
+// There is no Factory for it: it is injected in place of HciHal::Factory, like the fake HALs of the tests.
+class HciHalReplay : public HciHal {
+ public:
+  struct Record {
+    SnoopLogger::PacketType type;
+    // From the controller to the host
+    bool incoming;
+    // Since the first record of the capture
+    std::chrono::microseconds timestamp;
+    HciPacket packet;
+  };
+
+  struct PacketStats {
+    size_t count = 0;
+    size_t bytes = 0;
+    // For packets from the controller, the time spent in the stack callback. For packets from the host, the time
+    // since the last packet was delivered to it.
+    std::chrono::microseconds total_time{0};
+    std::chrono::microseconds max_time{0};
+  };
+
+  // How long playback waits on a recorded host command the host does not send
+  static constexpr std::chrono::milliseconds kCommandTimeout{1000};
+
+  // Returns false if |path| is not a btsnoop capture of HCI packets with type (datalink 1002). Truncated records are
+  // left out.
+  static bool ParseBtsnoop(const std::string& path, std::vector<Record>* records);
+
+  HciHalReplay(std::vector<Record> records, double speed);
+  ~HciHalReplay() override;
+
+  void registerIncomingPacketCallback(HciHalCallbacks* callback) override;
+  void unregisterIncomingPacketCallback() override;
+  void sendHciCommand(HciPacket command) override;
+  void sendAclData(HciPacket data) override;
+  void sendScoData(HciPacket data) override;
+  void sendIsoData(HciPacket data) override;
+
+  // Returns true once every record was played back, false if it took longer than |timeout|
+  bool WaitForCompletion(std::chrono::milliseconds timeout);
+
+  PacketStats GetIncomingStats(SnoopLogger::PacketType type) const;
+  PacketStats GetOutgoingStats(SnoopLogger::PacketType type) const;
+
+  // CPU time used by the whole process from Start() until the playback completed, or until now
+  std::chrono::microseconds GetProcessCpuTime() const;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {}
+  void Start() override;
+  void Stop() override;
+  std::string ToString() const override {
+    return std::string("HciHalReplay");
+  }
+
+ private:
+  void replay();
+  // Delivers the queued command responses, releasing |lock| around the callbacks
+  void deliver_responses(std::unique_lock<std::mutex>& lock);
+  void deliver(std::unique_lock<std::mutex>& lock, SnoopLogger::PacketType type, const HciPacket& packet);
+  void count_outgoing(SnoopLogger::PacketType type, size_t size);
+
+  const std::vector<Record> records_;
+  const double speed_;
+
+  // Indices in records_ of the Command Complete and Command Status events, by opcode
+  std::unordered_map<uint16_t, std::deque<size_t>> command_responses_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<HciPacket> pending_responses_;
+  size_t commands_sent_ = 0;
+  bool stopping_ = false;
+  bool completed_ = false;
+  bool delivered_ = false;
+  std::chrono::steady_clock::time_point last_delivery_;
+  std::map<SnoopLogger::PacketType, PacketStats> incoming_stats_;
+  std::map<SnoopLogger::PacketType, PacketStats> outgoing_stats_;
+  std::chrono::microseconds start_cpu_time_{0};
+  std::chrono::microseconds completion_cpu_time_{0};
+
+  std::mutex callback_mutex_;
+  HciHalCallbacks* callback_ = nullptr;
+
+  std::thread thread_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_hal_replay.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "module.h"
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+using std::chrono::milliseconds;
+
+constexpr uint64_t kBtSnoopEpochDelta = 0x00dcddb30f2f8000ULL;
+
+const HciPacket kReset = {0x03, 0x0c, 0x00};
+const HciPacket kResetComplete = {0x0e, 0x04, 0x01, 0x03, 0x0c, 0x00};
+const HciPacket kDisconnectionComplete = {0x05, 0x04, 0x00, 0x01, 0x00, 0x13};
+const HciPacket kAcl = {0x01, 0x20, 0x01, 0x00, 0xaa};
+
+struct TestRecord {
+  SnoopLogger::PacketType type;
+  bool incoming;
+  uint64_t timestamp_us;
+  HciPacket packet;
+};
+
+void write_be32(std::ofstream& file, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    file.put(static_cast<char>(value >> shift));
+  }
+}
+
+void write_btsnoop(const std::filesystem::path& path, const std::vector<TestRecord>& records) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write("btsnoop\0", 8);
+  write_be32(file, 1);
+  write_be32(file, 1002);
+  for (const auto& record : records) {
+    uint32_t length = record.packet.size() + 1;
+    write_be32(file, length);
+    write_be32(file, length);
+    write_be32(file, (record.incoming ? 0x01 : 0x00) | (record.type == SnoopLogger::PacketType::CMD ||
+                                                                record.type == SnoopLogger::PacketType::EVT
+                                                            ? 0x02
+                                                            : 0x00));
+    write_be32(file, 0);
+    uint64_t timestamp = record.timestamp_us + kBtSnoopEpochDelta;
+    write_be32(file, timestamp >> 32);
+    write_be32(file, timestamp);
+    file.put(static_cast<char>(record.type));
+    file.write(reinterpret_cast<const char*>(record.packet.data()), record.packet.size());
+  }
+}
+
+class TestHciHalCallbacks : public HciHalCallbacks {
+ public:
+  void hciEventReceived(HciPacket event) override {
+    received(SnoopLogger::PacketType::EVT, std::move(event));
+  }
+
+  void aclDataReceived(HciPacket data) override {
+    received(SnoopLogger::PacketType::ACL, std::move(data));
+  }
+
+  void scoDataReceived(HciPacket data) override {
+    received(SnoopLogger::PacketType::SCO, std::move(data));
+  }
+
+  void isoDataReceived(HciPacket data) override {
+    received(SnoopLogger::PacketType::ISO, std::move(data));
+  }
+
+  std::vector<std::pair<SnoopLogger::PacketType, HciPacket>> WaitForPackets(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, milliseconds(2000), [this, count] { return packets_.size() >= count; });
+    return packets_;
+  }
+
+ private:
+  void received(SnoopLogger::PacketType type, HciPacket packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    packets_.emplace_back(type, std::move(packet));
+    cv_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::pair<SnoopLogger::PacketType, HciPacket>> packets_;
+};
+
+class HciHalReplayTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    capture_ = std::filesystem::temp_directory_path() / "btsnoop_replay.log";
+  }
+
+  void TearDown() override {
+    if (hal_ != nullptr) {
+      hal_->unregisterIncomingPacketCallback();
+      fake_registry_.StopAll();
+    }
+    std::filesystem::remove(capture_);
+  }
+
+  void StartReplay(const std::vector<TestRecord>& records, double speed) {
+    write_btsnoop(capture_, records);
+    std::vector<HciHalReplay::Record> parsed;
+    ASSERT_TRUE(HciHalReplay::ParseBtsnoop(capture_, &parsed));
+    hal_ = new HciHalReplay(std::move(parsed), speed);
+    hal_->registerIncomingPacketCallback(&callbacks_);
+    fake_registry_.InjectTestModule(&HciHal::Factory, hal_);
+  }
+
+  std::filesystem::path capture_;
+  TestModuleRegistry fake_registry_;
+  TestHciHalCallbacks callbacks_;
+  HciHalReplay* hal_ = nullptr;
+};
+
+TEST_F(HciHalReplayTest, parse_btsnoop) {
+  write_btsnoop(
+      capture_,
+      {
+          {SnoopLogger::PacketType::CMD, false, 1000, kReset},
+          {SnoopLogger::PacketType::EVT, true, 1500, kResetComplete},
+          {SnoopLogger::PacketType::ACL, true, 3000, kAcl},
+      });
+
+  std::vector<HciHalReplay::Record> records;
+  ASSERT_TRUE(HciHalReplay::ParseBtsnoop(capture_, &records));
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].type, SnoopLogger::PacketType::CMD);
+  EXPECT_FALSE(records[0].incoming);
+  EXPECT_EQ(records[0].timestamp.count(), 0);
+  EXPECT_EQ(records[0].packet, kReset);
+  EXPECT_TRUE(records[1].incoming);
+  EXPECT_EQ(records[1].timestamp.count(), 500);
+  EXPECT_EQ(records[2].type, SnoopLogger::PacketType::ACL);
+  EXPECT_EQ(records[2].timestamp.count(), 2000);
+  EXPECT_EQ(records[2].packet, kAcl);
+}
+
+TEST_F(HciHalReplayTest, parse_rejects_other_files) {
+  {
+    std::ofstream file(capture_, std::ios::binary | std::ios::trunc);
+    file << "not a capture of HCI packets";
+  }
+  std::vector<HciHalReplay::Record> records;
+  EXPECT_FALSE(HciHalReplay::ParseBtsnoop(capture_, &records));
+}
+
+TEST_F(HciHalReplayTest, answers_commands_from_capture) {
+  StartReplay(
+      {
+          {SnoopLogger::PacketType::CMD, false, 0, kReset},
+          {SnoopLogger::PacketType::EVT, true, 100, kResetComplete},
+          {SnoopLogger::PacketType::EVT, true, 200, kDisconnectionComplete},
+          {SnoopLogger::PacketType::ACL, true, 300, kAcl},
+          {SnoopLogger::PacketType::ACL, false, 400, kAcl},
+      },
+      0);
+
+  hal_->sendHciCommand(kReset);
+  ASSERT_TRUE(hal_->WaitForCompletion(milliseconds(2000)));
+
+  auto packets = callbacks_.WaitForPackets(3);
+  ASSERT_EQ(packets.size(), 3u);
+  EXPECT_EQ(packets[0].second, kResetComplete);
+  EXPECT_EQ(packets[1].second, kDisconnectionComplete);
+  EXPECT_EQ(packets[2].first, SnoopLogger::PacketType::ACL);
+  EXPECT_EQ(packets[2].second, kAcl);
+
+  EXPECT_EQ(hal_->GetIncomingStats(SnoopLogger::PacketType::EVT).count, 2u);
+  EXPECT_EQ(hal_->GetIncomingStats(SnoopLogger::PacketType::ACL).count, 1u);
+  EXPECT_EQ(hal_->GetIncomingStats(SnoopLogger::PacketType::ACL).bytes, kAcl.size());
+  EXPECT_EQ(hal_->GetOutgoingStats(SnoopLogger::PacketType::CMD).count, 1u);
+  EXPECT_EQ(hal_->GetOutgoingStats(SnoopLogger::PacketType::ACL).count, 0u);
+}
+
+TEST_F(HciHalReplayTest, unrecorded_command_is_unknown) {
+  StartReplay({{SnoopLogger::PacketType::EVT, true, 0, kDisconnectionComplete}}, 0);
+  ASSERT_TRUE(hal_->WaitForCompletion(milliseconds(2000)));
+
+  hal_->sendHciCommand(kReset);
+  auto packets = callbacks_.WaitForPackets(2);
+  ASSERT_EQ(packets.size(), 2u);
+  EXPECT_EQ(packets[1].second, HciPacket({0x0e, 0x04, 0x01, 0x03, 0x0c, 0x01}));
+}
+
+TEST_F(HciHalReplayTest, keeps_recorded_timing) {
+  auto start = std::chrono::steady_clock::now();
+  StartReplay(
+      {
+          {SnoopLogger::PacketType::EVT, true, 0, kDisconnectionComplete},
+          {SnoopLogger::PacketType::EVT, true, 400000, kDisconnectionComplete},
+      },
+      2);
+  ASSERT_TRUE(hal_->WaitForCompletion(milliseconds(2000)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(200));
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
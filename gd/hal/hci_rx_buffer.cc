@@ -0,0 +1,71 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_rx_buffer.h"
+
+#include <atomic>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+namespace {
+
+std::atomic<const RxBufferAllocator*> rx_buffer_allocator{nullptr};
+
+struct RxBufferDeleter {
+  const RxBufferAllocator* allocator;
+  bool released = false;
+
+  void operator()(uint8_t* payload) const {
+    if (!released) {
+      allocator->free(payload - allocator->headroom);
+    }
+  }
+};
+
+}  // namespace
+
+void SetRxBufferAllocator(const RxBufferAllocator* allocator) {
+  rx_buffer_allocator = allocator;
+}
+
+bool IsRxBufferAllocatorSet() {
+  return rx_buffer_allocator.load() != nullptr;
+}
+
+std::shared_ptr<uint8_t> AllocateRxBuffer(size_t size) {
+  const RxBufferAllocator* allocator = rx_buffer_allocator;
+  if (allocator == nullptr) {
+    return nullptr;
+  }
+  auto block = static_cast<uint8_t*>(allocator->alloc(allocator->headroom + size));
+  ASSERT(block != nullptr);
+  return std::shared_ptr<uint8_t>(block + allocator->headroom, RxBufferDeleter{allocator});
+}
+
+void* ReleaseRxBuffer(const std::shared_ptr<const uint8_t>& buffer) {
+  auto deleter = std::get_deleter<RxBufferDeleter>(buffer);
+  if (deleter == nullptr || deleter->released || buffer.use_count() != 1) {
+    return nullptr;
+  }
+  deleter->released = true;
+  return const_cast<uint8_t*>(buffer.get()) - deleter->allocator->headroom;
+}
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace bluetooth {
+namespace hal {
+
+// Receive buffers with room reserved in front of the payload.
+// A consumer that wraps incoming packets in its own header (e.g. BT_HDR in the legacy stack) installs an allocator
+// whose headroom fits that header. The HAL then receives straight into such a buffer, GD PacketViews share it, and
+// once the last view is gone the consumer can take the whole block back with ReleaseRxBuffer() instead of copying.
+struct RxBufferAllocator {
+  size_t headroom;
+  void* (*alloc)(size_t size);
+  void (*free)(void* block);
+};
+
+// Install the allocator used by AllocateRxBuffer(). Passing nullptr goes back to plain HciPacket vectors.
+void SetRxBufferAllocator(const RxBufferAllocator* allocator);
+
+// Return true if an allocator is installed
+bool IsRxBufferAllocatorSet();
+
+// Allocate size bytes of payload behind the installed allocator's headroom. Returns nullptr if no allocator is set.
+std::shared_ptr<uint8_t> AllocateRxBuffer(size_t size);
+
+// Take ownership of the block backing an rx buffer. Returns the start of the block, headroom included, or nullptr if
+// the buffer did not come from AllocateRxBuffer() or is still shared. On success the shared_ptr no longer frees the
+// block when it goes away; the caller frees it with the allocator's free function.
+void* ReleaseRxBuffer(const std::shared_ptr<const uint8_t>& buffer);
+
+}  // namespace hal
+}  // namespace bluetooth
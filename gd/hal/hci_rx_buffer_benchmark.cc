@@ -0,0 +1,113 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hal/hci_rx_buffer.h"
+#include "packet/packet_view.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hal {
+
+// Same layout as the legacy stack's BT_HDR, which the shim wraps every incoming packet in
+struct LegacyHeader {
+  uint16_t event;
+  uint16_t len;
+  uint16_t offset;
+  uint16_t layer_specific;
+  uint8_t data[];
+};
+
+const RxBufferAllocator kLegacyHeaderAllocator = {sizeof(LegacyHeader), malloc, free};
+
+// Mirrors a packet's trip from the HIDL callback to the legacy stack: the HAL copies it out of the HIDL vector, the
+// HCI layer builds a PacketView on top, and the shim hands a BT_HDR upwards
+class BM_HciRxPath : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    hidl_packet_.resize(st.range(0));
+    std::generate(hidl_packet_.begin(), hidl_packet_.end(), [n = 0]() mutable { return n++; });
+    copies_ = 0;
+  }
+
+  void TearDown(State& st) override {
+    SetRxBufferAllocator(nullptr);
+    st.counters["copies_per_packet"] = ::benchmark::Counter(copies_, ::benchmark::Counter::kAvgIterations);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  LegacyHeader* wrap_and_copy(const packet::PacketView<packet::kLittleEndian>& view) {
+    auto header = static_cast<LegacyHeader*>(malloc(sizeof(LegacyHeader) + view.size()));
+    header->offset = 0;
+    header->len = view.size();
+    std::copy(view.begin(), view.end(), header->data);
+    copies_++;
+    return header;
+  }
+
+  std::vector<uint8_t> hidl_packet_;
+  int64_t copies_;
+};
+
+BENCHMARK_DEFINE_F(BM_HciRxPath, copy_into_bt_hdr)(State& state) {
+  for (auto _ : state) {
+    std::vector<uint8_t> received(hidl_packet_.begin(), hidl_packet_.end());
+    copies_++;
+    auto view = std::make_unique<packet::PacketView<packet::kLittleEndian>>(
+        std::make_shared<std::vector<uint8_t>>(std::move(received)));
+    LegacyHeader* header = wrap_and_copy(*view);
+    view.reset();
+    benchmark::DoNotOptimize(header->data[0]);
+    free(header);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_HciRxPath, copy_into_bt_hdr)->Arg(16)->Arg(259)->Arg(1021);
+
+BENCHMARK_DEFINE_F(BM_HciRxPath, release_rx_buffer)(State& state) {
+  SetRxBufferAllocator(&kLegacyHeaderAllocator);
+  for (auto _ : state) {
+    auto buffer = AllocateRxBuffer(hidl_packet_.size());
+    std::copy(hidl_packet_.begin(), hidl_packet_.end(), buffer.get());
+    copies_++;
+    auto view = std::make_unique<packet::PacketView<packet::kLittleEndian>>(std::move(buffer), hidl_packet_.size());
+    LegacyHeader* header = nullptr;
+    const packet::View* fragment = view->GetSingleFragment();
+    void* block = ReleaseRxBuffer(fragment->GetStorage());
+    if (block != nullptr) {
+      header = static_cast<LegacyHeader*>(block);
+      header->offset = fragment->GetStorageOffset();
+      header->len = view->size();
+    } else {
+      header = wrap_and_copy(*view);
+    }
+    view.reset();
+    benchmark::DoNotOptimize(header->data[header->offset]);
+    free(header);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_HciRxPath, release_rx_buffer)->Arg(16)->Arg(259)->Arg(1021);
+
+}  // namespace hal
+}  // namespace bluetooth
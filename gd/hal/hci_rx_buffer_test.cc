@@ -0,0 +1,120 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/hci_rx_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "packet/packet_view.h"
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr size_t kHeadroom = 8;
+int blocks_allocated = 0;
+
+void* test_alloc(size_t size) {
+  blocks_allocated++;
+  return malloc(size);
+}
+
+void test_free(void* block) {
+  blocks_allocated--;
+  free(block);
+}
+
+const RxBufferAllocator kTestAllocator = {kHeadroom, test_alloc, test_free};
+
+class HciRxBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    blocks_allocated = 0;
+    SetRxBufferAllocator(&kTestAllocator);
+  }
+
+  void TearDown() override {
+    SetRxBufferAllocator(nullptr);
+    EXPECT_EQ(blocks_allocated, 0);
+  }
+};
+
+TEST_F(HciRxBufferTest, no_allocator) {
+  SetRxBufferAllocator(nullptr);
+  EXPECT_FALSE(IsRxBufferAllocatorSet());
+  EXPECT_EQ(AllocateRxBuffer(10), nullptr);
+}
+
+TEST_F(HciRxBufferTest, freed_with_last_reference) {
+  EXPECT_TRUE(IsRxBufferAllocatorSet());
+  auto buffer = AllocateRxBuffer(10);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_EQ(blocks_allocated, 1);
+  buffer.reset();
+  EXPECT_EQ(blocks_allocated, 0);
+}
+
+TEST_F(HciRxBufferTest, release_returns_block_with_headroom) {
+  auto buffer = AllocateRxBuffer(10);
+  uint8_t* payload = buffer.get();
+  std::shared_ptr<const uint8_t> shared = std::move(buffer);
+  void* block = ReleaseRxBuffer(shared);
+  ASSERT_EQ(block, payload - kHeadroom);
+  shared.reset();
+  EXPECT_EQ(blocks_allocated, 1);
+  test_free(block);
+}
+
+TEST_F(HciRxBufferTest, release_fails_while_shared) {
+  std::shared_ptr<const uint8_t> buffer = AllocateRxBuffer(10);
+  auto copy = buffer;
+  EXPECT_EQ(ReleaseRxBuffer(buffer), nullptr);
+  copy.reset();
+  void* block = ReleaseRxBuffer(buffer);
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(ReleaseRxBuffer(buffer), nullptr);
+  buffer.reset();
+  test_free(block);
+}
+
+TEST_F(HciRxBufferTest, release_fails_for_other_buffers) {
+  auto vector = std::make_shared<const std::vector<uint8_t>>(10);
+  std::shared_ptr<const uint8_t> aliased(vector, vector->data());
+  vector.reset();
+  EXPECT_EQ(ReleaseRxBuffer(aliased), nullptr);
+}
+
+TEST_F(HciRxBufferTest, release_through_packet_view) {
+  std::shared_ptr<const uint8_t> buffer = AllocateRxBuffer(4);
+  const uint8_t* payload = buffer.get();
+  auto packet = std::make_unique<packet::PacketView<packet::kLittleEndian>>(std::move(buffer), 4);
+  auto subview = packet->GetLittleEndianSubview(1, 3);
+  const packet::View* fragment = subview.GetSingleFragment();
+  ASSERT_NE(fragment, nullptr);
+  EXPECT_EQ(ReleaseRxBuffer(fragment->GetStorage()), nullptr);
+  packet.reset();
+  void* block = ReleaseRxBuffer(fragment->GetStorage());
+  ASSERT_EQ(block, payload - kHeadroom);
+  EXPECT_EQ(fragment->GetStorageOffset(), 1u);
+  test_free(block);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
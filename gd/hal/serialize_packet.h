@@ -24,11 +24,7 @@ namespace bluetooth {
 namespace hal {
 
 inline std::vector<uint8_t> SerializePacket(std::unique_ptr<packet::BasePacketBuilder> packet) {
-  std::vector<uint8_t> packet_bytes;
-  packet_bytes.reserve(packet->size());
-  packet::BitInserter it(packet_bytes);
-  packet->Serialize(it);
-  return packet_bytes;
+  return packet->SerializeToBytes();
 }
 
 }  // namespace hal
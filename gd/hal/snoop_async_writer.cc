@@ -0,0 +1,137 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_async_writer.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+SnoopAsyncWriter::SnoopAsyncWriter(
+    Output* output, size_t ring_capacity, size_t records_per_file, std::chrono::milliseconds sync_interval)
+    : output_(output),
+      records_per_file_(records_per_file),
+      sync_interval_(sync_interval),
+      ring_(ring_capacity),
+      last_sync_(std::chrono::steady_clock::now()) {
+  ASSERT(output_ != nullptr);
+  batch_.reserve(kBatchSize);
+  thread_ = std::thread(&SnoopAsyncWriter::run, this);
+}
+
+SnoopAsyncWriter::~SnoopAsyncWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+}
+
+bool SnoopAsyncWriter::Push(const void* header, size_t header_size, const iovec* slices, size_t slice_count) {
+  if (!ring_.Push(header, header_size, slices, slice_count)) {
+    return false;
+  }
+  if (idle_.load()) {
+    // Taking the lock orders this with the writer going to sleep, so the wakeup can't be missed
+    std::lock_guard<std::mutex> lock(mutex_);
+    wakeup_.notify_one();
+  } else if (ring_.GetUsedBytes() >= kBatchSize && !batch_ready_.exchange(true)) {
+    // The writer is waiting for a partial batch with a timeout anyway, a missed wakeup only delays it
+    wakeup_.notify_one();
+  }
+  return true;
+}
+
+void SnoopAsyncWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t request = ++flush_requests_;
+  wakeup_.notify_one();
+  flushed_.wait(lock, [this, request]() { return flushes_done_ >= request; });
+}
+
+uint64_t SnoopAsyncWriter::GetDroppedCount() const {
+  return ring_.GetDroppedCount();
+}
+
+bool SnoopAsyncWriter::has_work_locked() const {
+  return stopping_ || flush_requests_ != flushes_done_;
+}
+
+void SnoopAsyncWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (!has_work_locked()) {
+      if (ring_.GetUsedBytes() == 0) {
+        idle_.store(true);
+        wakeup_.wait(lock, [this]() { return has_work_locked() || ring_.GetUsedBytes() > 0; });
+        idle_.store(false);
+      }
+      // Give a partial batch some time to fill up
+      wakeup_.wait_for(
+          lock, kFlushInterval, [this]() { return has_work_locked() || ring_.GetUsedBytes() >= kBatchSize; });
+    }
+    bool stopping = stopping_;
+    uint64_t flush_request = flush_requests_;
+    batch_ready_.store(false);
+
+    lock.unlock();
+    drain();
+    if (sync_interval_.count() > 0 &&
+        (stopping || std::chrono::steady_clock::now() - last_sync_ >= sync_interval_)) {
+      output_->Sync();
+      last_sync_ = std::chrono::steady_clock::now();
+    }
+    lock.lock();
+
+    flushes_done_ = flush_request;
+    flushed_.notify_all();
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void SnoopAsyncWriter::drain() {
+  const uint8_t* data;
+  size_t size;
+  while (ring_.Front(&data, &size)) {
+    if (records_per_file_ > 0 && records_in_file_ >= records_per_file_) {
+      write_batch();
+      output_->Rotate();
+      records_in_file_ = 0;
+    }
+    if (batch_.size() + size > kBatchSize) {
+      write_batch();
+    }
+    batch_.insert(batch_.end(), data, data + size);
+    ring_.PopFront();
+    records_in_file_++;
+  }
+  write_batch();
+}
+
+void SnoopAsyncWriter::write_batch() {
+  if (batch_.empty()) {
+    return;
+  }
+  output_->Write(batch_.data(), batch_.size());
+  batch_.clear();
+}
+
+}  // namespace hal
+}  // namespace bluetooth
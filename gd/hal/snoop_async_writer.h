@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hal/snoop_ring.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+// Moves snoop records off the HCI path. Push() only copies into a SnoopRing; a writer thread drains the ring and
+// hands records to the output in batches of up to kBatchSize bytes, so file writes, rotation and syncs never block
+// the threads sending and receiving HCI packets.
+class SnoopAsyncWriter {
+ public:
+  class Output {
+   public:
+    virtual ~Output() = default;
+    // Append data made of whole records to the current file
+    virtual void Write(const uint8_t* data, size_t size) = 0;
+    // Make everything written so far durable
+    virtual void Sync() = 0;
+    // Close the current file and start the next one
+    virtual void Rotate() = 0;
+  };
+
+  static constexpr size_t kBatchSize = 64 * 1024;
+  // How long a partial batch may wait for more records
+  static constexpr std::chrono::milliseconds kFlushInterval = std::chrono::milliseconds(200);
+
+  // Output methods are only invoked from the writer thread. The output is rotated before the record that would make
+  // a file hold more than records_per_file. A zero sync_interval never syncs; otherwise the output is synced at most
+  // once per interval, and on destruction.
+  SnoopAsyncWriter(
+      Output* output, size_t ring_capacity, size_t records_per_file, std::chrono::milliseconds sync_interval);
+  DISALLOW_COPY_AND_ASSIGN(SnoopAsyncWriter);
+
+  // Write out everything pushed so far and stop the writer thread
+  ~SnoopAsyncWriter();
+
+  // Queue one record made of the header followed by the slices. Returns false and counts the record as dropped if
+  // the ring is full.
+  bool Push(const void* header, size_t header_size, const iovec* slices, size_t slice_count);
+
+  // Block until every record pushed before this call has been handed to the output
+  void Flush();
+
+  uint64_t GetDroppedCount() const;
+
+ private:
+  bool has_work_locked() const;
+  void run();
+  void drain();
+  void write_batch();
+
+  Output* output_;
+  const size_t records_per_file_;
+  const std::chrono::milliseconds sync_interval_;
+  SnoopRing ring_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable flushed_;
+  bool stopping_ = false;
+  uint64_t flush_requests_ = 0;
+  uint64_t flushes_done_ = 0;
+  // Set while the writer waits for an empty ring to get data; the producer that sees it wakes the writer up
+  std::atomic_bool idle_{false};
+  std::atomic_bool batch_ready_{false};
+
+  // Writer thread only
+  std::vector<uint8_t> batch_;
+  size_t records_in_file_ = 0;
+  std::chrono::steady_clock::time_point last_sync_;
+
+  std::thread thread_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_async_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+class TestOutput : public SnoopAsyncWriter::Output {
+ public:
+  void Write(const uint8_t* data, size_t size) override {
+    files_.back().insert(files_.back().end(), data, data + size);
+  }
+
+  void Sync() override {
+    syncs_++;
+  }
+
+  void Rotate() override {
+    files_.emplace_back();
+  }
+
+  std::vector<std::vector<uint8_t>> files_{1};
+  size_t syncs_ = 0;
+};
+
+void push_record(SnoopAsyncWriter& writer, uint8_t header, uint8_t payload) {
+  iovec slice = {&payload, sizeof(payload)};
+  ASSERT_TRUE(writer.Push(&header, sizeof(header), &slice, 1));
+}
+
+TEST(SnoopAsyncWriterTest, flush_writes_pushed_records) {
+  TestOutput output;
+  SnoopAsyncWriter writer(&output, 4096, 0, std::chrono::milliseconds(0));
+  for (uint8_t i = 0; i < 10; i++) {
+    push_record(writer, i, i + 100);
+  }
+  writer.Flush();
+  ASSERT_EQ(1u, output.files_.size());
+  ASSERT_EQ(20u, output.files_[0].size());
+  ASSERT_EQ(9, output.files_[0][18]);
+  ASSERT_EQ(109, output.files_[0][19]);
+  ASSERT_EQ(0u, output.syncs_);
+}
+
+TEST(SnoopAsyncWriterTest, rotate_after_records_per_file) {
+  TestOutput output;
+  SnoopAsyncWriter writer(&output, 4096, 3, std::chrono::milliseconds(0));
+  for (uint8_t i = 0; i < 7; i++) {
+    push_record(writer, i, i);
+  }
+  writer.Flush();
+  ASSERT_EQ(3u, output.files_.size());
+  ASSERT_EQ(6u, output.files_[0].size());
+  ASSERT_EQ(6u, output.files_[1].size());
+  ASSERT_EQ(2u, output.files_[2].size());
+  ASSERT_EQ(3, output.files_[1][0]);
+  ASSERT_EQ(6, output.files_[2][0]);
+}
+
+TEST(SnoopAsyncWriterTest, destruction_writes_and_syncs) {
+  TestOutput output;
+  {
+    SnoopAsyncWriter writer(&output, 4096, 0, std::chrono::hours(1));
+    push_record(writer, 1, 2);
+  }
+  ASSERT_EQ(2u, output.files_[0].size());
+  ASSERT_EQ(1u, output.syncs_);
+}
+
+TEST(SnoopAsyncWriterTest, full_ring_counts_drops) {
+  TestOutput output;
+  SnoopAsyncWriter writer(&output, 64, 0, std::chrono::milliseconds(0));
+  std::vector<uint8_t> payload(100);
+  iovec slice = {payload.data(), payload.size()};
+  uint8_t header = 0;
+  ASSERT_FALSE(writer.Push(&header, sizeof(header), &slice, 1));
+  ASSERT_EQ(1u, writer.GetDroppedCount());
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -17,16 +17,18 @@
 #include "hal/snoop_logger.h"
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <bitset>
 #include <chrono>
 #include <sstream>
 
-#include "common/circular_buffer.h"
 #include "common/init_flags.h"
 #include "common/strings.h"
+#include "common/trace_ring.h"
 #include "os/files.h"
 #include "os/log.h"
 #include "os/parameter_provider.h"
@@ -73,9 +75,11 @@ constexpr size_t kDefaultBtsnoozMaxMemoryUsageBytes = 256 * 1024;
 constexpr size_t kDefaultBtSnoozMaxBytesPerPacket = 150;
 constexpr size_t kDefaultBtSnoozMaxPayloadBytesPerPacket =
     kDefaultBtSnoozMaxBytesPerPacket - sizeof(SnoopLogger::PacketHeaderType);
-// Calculate max number of packets based on max memory usage and max packet size
-constexpr size_t kDefaultBtSnoozMaxPacketsPerBuffer =
-    kDefaultBtsnoozMaxMemoryUsageBytes / kDefaultBtSnoozMaxBytesPerPacket;
+// Packets are compressed in chunks of this size once a chunk fills up
+constexpr size_t kBtSnoozChunkSize = 16 * 1024;
+
+// Records waiting for the background writer. Over a second of full speed EDR ACL traffic in both directions.
+constexpr size_t kAsyncWriterRingBytes = 1024 * 1024;
 
 std::string get_btsnoop_log_path(std::string log_dir, bool filtered) {
   if (filtered) {
@@ -107,7 +111,10 @@ void delete_btsnoop_files(const std::string& log_path) {
   }
 }
 
-size_t get_btsnooz_packet_length_to_write(const HciPacket& packet, SnoopLogger::PacketType type) {
+// get_btsnooz_packet_length_to_write() only looks at the ACL and L2CAP headers
+constexpr size_t kBtsnoozPrefixSize = 8;
+
+size_t get_btsnooz_packet_length_to_write(const uint8_t* packet, size_t size, SnoopLogger::PacketType type) {
   static const size_t kAclHeaderSize = 4;
   static const size_t kL2capHeaderSize = 4;
   static const size_t kL2capCidOffset = (kAclHeaderSize + 2);
@@ -123,14 +130,14 @@ size_t get_btsnooz_packet_length_to_write(const HciPacket& packet, SnoopLogger::
   switch (type) {
     case SnoopLogger::PacketType::CMD:
     case SnoopLogger::PacketType::EVT:
-      included_length = packet.size();
+      included_length = size;
       break;
 
     case SnoopLogger::PacketType::ACL: {
       // Log ACL and L2CAP header by default
       size_t len_hci_acl = kAclHeaderSize + kL2capHeaderSize;
       // Check if we have enough data for an L2CAP header
-      if (packet.size() > len_hci_acl) {
+      if (size > len_hci_acl) {
         uint16_t l2cap_cid =
             static_cast<uint16_t>(packet[kL2capCidOffset]) |
             static_cast<uint16_t>((static_cast<uint16_t>(packet[kL2capCidOffset + 1]) << static_cast<uint16_t>(8)));
@@ -138,13 +145,13 @@ size_t get_btsnooz_packet_length_to_write(const HciPacket& packet, SnoopLogger::
           // For the signaling CID, take the full packet.
           // That way, the PSM setup is captured, allowing decoding of PSMs down
           // the road.
-          return packet.size();
+          return size;
         } else {
           // Otherwise, return as much as we reasonably can
           len_hci_acl = kMaxBtsnoozAclSize;
         }
       }
-      included_length = std::min(len_hci_acl, packet.size());
+      included_length = std::min(len_hci_acl, size);
       break;
     }
 
@@ -157,6 +164,74 @@ size_t get_btsnooz_packet_length_to_write(const HciPacket& packet, SnoopLogger::
   return std::min(included_length, kDefaultBtSnoozMaxPayloadBytesPerPacket);
 }
 
+// Copy up to max_length bytes from the start of the packet
+void copy_slices(const iovec* slices, size_t slice_count, uint8_t* out, size_t max_length) {
+  for (size_t i = 0; i < slice_count && max_length > 0; i++) {
+    size_t length = std::min(slices[i].iov_len, max_length);
+    std::copy_n(static_cast<const uint8_t*>(slices[i].iov_base), length, out);
+    out += length;
+    max_length -= length;
+  }
+}
+
+// Return the slices holding the first length bytes of the packet
+std::vector<iovec> truncate_slices(const iovec* slices, size_t slice_count, size_t length) {
+  std::vector<iovec> truncated;
+  for (size_t i = 0; i < slice_count && length > 0; i++) {
+    size_t slice_length = std::min(slices[i].iov_len, length);
+    truncated.push_back({slices[i].iov_base, slice_length});
+    length -= slice_length;
+  }
+  return truncated;
+}
+
+// Write the first length bytes of the packet
+bool write_slices(std::ostream& stream, const iovec* slices, size_t slice_count, size_t length) {
+  for (size_t i = 0; i < slice_count && length > 0; i++) {
+    size_t slice_length = std::min(slices[i].iov_len, length);
+    if (!stream.write(static_cast<const char*>(slices[i].iov_base), slice_length)) {
+      return false;
+    }
+    length -= slice_length;
+  }
+  return true;
+}
+
+// Trace the packet in common::TraceRing with the connection handle of data packets, and with the opcode of commands
+// and the event code of events in place of the length
+void trace_packet(
+    const iovec* slices,
+    size_t slice_count,
+    size_t size,
+    SnoopLogger::Direction direction,
+    SnoopLogger::PacketType type) {
+  const uint8_t* header = slice_count > 0 ? static_cast<const uint8_t*>(slices[0].iov_base) : nullptr;
+  size_t header_size = slice_count > 0 ? slices[0].iov_len : 0;
+  bool incoming = direction == SnoopLogger::Direction::INCOMING;
+  uint16_t handle = header_size >= 2 ? (header[0] | (header[1] << 8)) & 0x0fff : 0;
+  switch (type) {
+    case SnoopLogger::PacketType::CMD:
+      common::TraceRing::Record(
+          common::TraceEventId::HCI_COMMAND_TX, 0, header_size >= 2 ? header[0] | (header[1] << 8) : 0);
+      break;
+    case SnoopLogger::PacketType::EVT:
+      common::TraceRing::Record(common::TraceEventId::HCI_EVENT_RX, 0, header_size >= 1 ? header[0] : 0);
+      break;
+    case SnoopLogger::PacketType::ACL:
+      common::TraceRing::Record(
+          incoming ? common::TraceEventId::HCI_ACL_RX : common::TraceEventId::HCI_ACL_TX, handle, size);
+      break;
+    case SnoopLogger::PacketType::SCO:
+      common::TraceRing::Record(
+          incoming ? common::TraceEventId::HCI_SCO_RX : common::TraceEventId::HCI_SCO_TX, handle, size);
+      break;
+    case SnoopLogger::PacketType::ISO:
+      common::TraceRing::Record(
+          incoming ? common::TraceEventId::HCI_ISO_RX : common::TraceEventId::HCI_ISO_TX, handle, size);
+      break;
+  }
+}
+
 }  // namespace
 
 const std::string SnoopLogger::kBtSnoopLogModeDisabled = "disabled";
@@ -167,6 +242,45 @@ const std::string SnoopLogger::kBtSnoopMaxPacketsPerFileProperty = "persist.blue
 const std::string SnoopLogger::kIsDebuggableProperty = "ro.debuggable";
 const std::string SnoopLogger::kBtSnoopLogModeProperty = "persist.bluetooth.btsnooplogmode";
 const std::string SnoopLogger::kBtSnoopDefaultLogModeProperty = "persist.bluetooth.btsnoopdefaultmode";
+const std::string SnoopLogger::kBtSnoopAsyncWriterProperty = "persist.bluetooth.btsnoopasync";
+const std::string SnoopLogger::kBtSnoopSyncIntervalProperty = "persist.bluetooth.btsnoopsyncms";
+const std::string SnoopLogger::kBtSnoopTruncateProperty = "persist.bluetooth.btsnooptruncate";
+
+// Runs on the background writer thread, which is the only one touching the file while the writer exists
+class SnoopLogger::AsyncOutput : public SnoopAsyncWriter::Output {
+ public:
+  explicit AsyncOutput(SnoopLogger* logger) : logger_(logger) {}
+
+  void Write(const uint8_t* data, size_t size) override {
+    std::lock_guard<std::recursive_mutex> lock(logger_->file_mutex_);
+    if (!logger_->btsnoop_ostream_.write(reinterpret_cast<const char*>(data), size)) {
+      LOG_ERROR("Failed to write packets for btsnoop, error: \"%s\"", strerror(errno));
+    }
+    if (!logger_->btsnoop_ostream_.flush()) {
+      LOG_ERROR("Failed to flush, error: \"%s\"", strerror(errno));
+    }
+  }
+
+  void Sync() override {
+    // std::ofstream does not expose its descriptor, but syncing any descriptor of the file syncs its data
+    int fd = open(logger_->snoop_log_path_.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+      LOG_ERROR("Failed to open \"%s\" for sync, error: \"%s\"", logger_->snoop_log_path_.c_str(), strerror(errno));
+      return;
+    }
+    if (fdatasync(fd) != 0) {
+      LOG_ERROR("Failed to sync, error: \"%s\"", strerror(errno));
+    }
+    close(fd);
+  }
+
+  void Rotate() override {
+    logger_->OpenNextSnoopLogFile();
+  }
+
+ private:
+  SnoopLogger* logger_;
+};
 
 SnoopLogger::SnoopLogger(
     std::string snoop_log_path,
@@ -176,7 +290,7 @@ SnoopLogger::SnoopLogger(
     : snoop_log_path_(std::move(snoop_log_path)),
       snooz_log_path_(std::move(snooz_log_path)),
       max_packets_per_file_(max_packets_per_file),
-      btsnooz_buffer_(kDefaultBtSnoozMaxPacketsPerBuffer) {
+      btsnooz_buffer_(kDefaultBtsnoozMaxMemoryUsageBytes, kBtSnoozChunkSize) {
   if (false && btsnoop_mode == kBtSnoopLogModeFiltered) {
     // TODO(b/163733538): implement filtered snoop log in GD, currently filtered == disabled
     LOG_INFO("Filtered Snoop Logs enabled");
@@ -206,6 +320,8 @@ SnoopLogger::SnoopLogger(
   snoop_log_path_ = get_btsnoop_log_path(snoop_log_path_, is_filtered_);
 }
 
+SnoopLogger::~SnoopLogger() = default;
+
 void SnoopLogger::CloseCurrentSnoopLogFile() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (btsnoop_ostream_.is_open()) {
@@ -248,6 +364,24 @@ void SnoopLogger::OpenNextSnoopLogFile() {
 }
 
 void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketType type) {
+  Capture(packet.data(), packet.size(), direction, type);
+}
+
+void SnoopLogger::Capture(const uint8_t* packet, size_t size, Direction direction, PacketType type) {
+  iovec slice = {const_cast<uint8_t*>(packet), size};
+  capture(&slice, 1, direction, type);
+}
+
+void SnoopLogger::Capture(const HciPacketSlices& packet, Direction direction, PacketType type) {
+  capture(packet.data(), packet.size(), direction, type);
+}
+
+void SnoopLogger::capture(const iovec* slices, size_t slice_count, Direction direction, PacketType type) {
+  size_t size = 0;
+  for (size_t i = 0; i < slice_count; i++) {
+    size += slices[i].iov_len;
+  }
+  trace_packet(slices, slice_count, size, direction, type);
   uint64_t timestamp_us =
       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
           .count();
@@ -271,24 +405,42 @@ void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketTy
       flags.set(1, true);
       break;
   }
-  uint32_t length = packet.size() + /* type byte */ 1;
+  size_t captured_size = size;
+  std::vector<iovec> truncated_slices;
+  if (is_truncating_ && type == PacketType::ACL) {
+    captured_size = get_captured_length(slices, slice_count, size, direction);
+    if (captured_size < size) {
+      truncated_slices = truncate_slices(slices, slice_count, captured_size);
+      slices = truncated_slices.data();
+      slice_count = truncated_slices.size();
+    }
+  }
+  uint32_t length = size + /* type byte */ 1;
   PacketHeaderType header = {.length_original = htonl(length),
-                             .length_captured = htonl(length),
+                             .length_captured = htonl(captured_size + /* type byte */ 1),
                              .flags = htonl(static_cast<uint32_t>(flags.to_ulong())),
                              .dropped_packets = 0,
                              .timestamp = htonll(timestamp_us + kBtSnoopEpochDelta),
                              .type = static_cast<uint8_t>(type)};
+  if (async_writer_ != nullptr) {
+    // The writer thread owns the file; only copy the record into its ring here
+    header.dropped_packets = htonl(static_cast<uint32_t>(async_writer_->GetDroppedCount()));
+    async_writer_->Push(&header, sizeof(PacketHeaderType), slices, slice_count);
+    return;
+  }
   {
     std::lock_guard<std::recursive_mutex> lock(file_mutex_);
     if (!is_enabled_) {
       // btsnoop disabled, log in-memory btsnooz log only
       std::stringstream ss;
-      size_t included_length = get_btsnooz_packet_length_to_write(packet, type);
+      uint8_t prefix[kBtsnoozPrefixSize];
+      copy_slices(slices, slice_count, prefix, sizeof(prefix));
+      size_t included_length = get_btsnooz_packet_length_to_write(prefix, size, type);
       header.length_captured = htonl(included_length + /* type byte */ 1);
       if (!ss.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
         LOG_ERROR("Failed to write packet header for btsnooz, error: \"%s\"", strerror(errno));
       }
-      if (!ss.write(reinterpret_cast<const char*>(packet.data()), included_length)) {
+      if (!write_slices(ss, slices, slice_count, included_length)) {
         LOG_ERROR("Failed to write packet payload for btsnooz, error: \"%s\"", strerror(errno));
       }
       btsnooz_buffer_.Push(ss.str());
@@ -301,7 +453,7 @@ void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketTy
     if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(&header), sizeof(PacketHeaderType))) {
       LOG_ERROR("Failed to write packet header for btsnoop, error: \"%s\"", strerror(errno));
     }
-    if (!btsnoop_ostream_.write(reinterpret_cast<const char*>(packet.data()), packet.size())) {
+    if (!write_slices(btsnoop_ostream_, slices, slice_count, captured_size)) {
       LOG_ERROR("Failed to write packet payload for btsnoop, error: \"%s\"", strerror(errno));
     }
     // std::ofstream::flush() pushes user data into kernel memory. The data will be written even if this process
@@ -314,6 +466,51 @@ void SnoopLogger::Capture(const HciPacket& packet, Direction direction, PacketTy
   }
 }
 
+size_t SnoopLogger::get_captured_length(const iovec* slices, size_t slice_count, size_t size, Direction direction) {
+  static const size_t kAclHeaderSize = 4;
+  static const size_t kL2capHeaderSize = 4;
+  static const uint16_t kContinuingFragment = 0b01;
+
+  uint8_t prefix[kBtsnoozPrefixSize] = {};
+  copy_slices(slices, slice_count, prefix, sizeof(prefix));
+  uint16_t handle_and_flags = static_cast<uint16_t>(prefix[0]) | static_cast<uint16_t>(prefix[1] << 8);
+  auto link = std::make_pair(static_cast<uint16_t>(handle_and_flags & 0x0fff), direction);
+
+  std::lock_guard<std::mutex> lock(truncation_mutex_);
+  if (truncation_limits_.empty()) {
+    return size;
+  }
+  if (((handle_and_flags >> 12) & 0b11) == kContinuingFragment) {
+    return truncated_pdus_.count(link) != 0 ? std::min(size, kAclHeaderSize) : size;
+  }
+  truncated_pdus_.erase(link);
+  if (size < kAclHeaderSize + kL2capHeaderSize) {
+    return size;
+  }
+  uint16_t cid = static_cast<uint16_t>(prefix[6]) | static_cast<uint16_t>(prefix[7] << 8);
+  auto limit = truncation_limits_.find(std::make_tuple(link.first, direction, cid));
+  if (limit == truncation_limits_.end() || kAclHeaderSize + kL2capHeaderSize + limit->second >= size) {
+    return size;
+  }
+  truncated_pdus_.insert(link);
+  return kAclHeaderSize + kL2capHeaderSize + limit->second;
+}
+
+void SnoopLogger::SetL2capChannelTruncation(
+    uint16_t connection_handle, uint16_t local_cid, uint16_t remote_cid, size_t max_payload_length) {
+  std::lock_guard<std::mutex> lock(truncation_mutex_);
+  truncation_limits_[std::make_tuple(connection_handle, Direction::INCOMING, local_cid)] = max_payload_length;
+  truncation_limits_[std::make_tuple(connection_handle, Direction::OUTGOING, remote_cid)] = max_payload_length;
+}
+
+void SnoopLogger::ClearL2capChannelTruncation(uint16_t connection_handle, uint16_t local_cid, uint16_t remote_cid) {
+  std::lock_guard<std::mutex> lock(truncation_mutex_);
+  truncation_limits_.erase(std::make_tuple(connection_handle, Direction::INCOMING, local_cid));
+  truncation_limits_.erase(std::make_tuple(connection_handle, Direction::OUTGOING, remote_cid));
+  truncated_pdus_.erase(std::make_pair(connection_handle, Direction::INCOMING));
+  truncated_pdus_.erase(std::make_pair(connection_handle, Direction::OUTGOING));
+}
+
 void SnoopLogger::DumpSnoozLogToFile(const std::vector<std::string>& data) const {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (is_enabled_) {
@@ -362,10 +559,20 @@ void SnoopLogger::Start() {
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   if (is_enabled_) {
     OpenNextSnoopLogFile();
+    is_truncating_ = IsTruncationEnabled();
+    if (IsAsyncWriterEnabled()) {
+      LOG_INFO("Writing snoop logs from a background thread");
+      async_output_ = std::make_unique<AsyncOutput>(this);
+      async_writer_ = std::make_unique<SnoopAsyncWriter>(
+          async_output_.get(), kAsyncWriterRingBytes, max_packets_per_file_, GetSyncInterval());
+    }
   }
 }
 
 void SnoopLogger::Stop() {
+  // Let the writer thread finish with the file first; it takes file_mutex_ itself
+  async_writer_.reset();
+  async_output_.reset();
   std::lock_guard<std::recursive_mutex> lock(file_mutex_);
   LOG_DEBUG("Dumping btsnooz log data to %s", snooz_log_path_.c_str());
   DumpSnoozLogToFile(btsnooz_buffer_.Drain());
@@ -394,6 +601,27 @@ size_t SnoopLogger::GetMaxPacketsPerFile() {
   return max_packets_per_file;
 }
 
+bool SnoopLogger::IsAsyncWriterEnabled() {
+  auto async_writer_prop = os::GetSystemProperty(kBtSnoopAsyncWriterProperty);
+  return async_writer_prop.has_value() && common::StringTrim(async_writer_prop.value()) == "true";
+}
+
+bool SnoopLogger::IsTruncationEnabled() {
+  auto truncate_prop = os::GetSystemProperty(kBtSnoopTruncateProperty);
+  return truncate_prop.has_value() && common::StringTrim(truncate_prop.value()) == "true";
+}
+
+std::chrono::milliseconds SnoopLogger::GetSyncInterval() {
+  auto sync_interval_prop = os::GetSystemProperty(kBtSnoopSyncIntervalProperty);
+  if (sync_interval_prop) {
+    auto sync_interval_ms = common::Uint64FromString(sync_interval_prop.value());
+    if (sync_interval_ms) {
+      return std::chrono::milliseconds(sync_interval_ms.value());
+    }
+  }
+  return std::chrono::milliseconds(0);
+}
+
 std::string SnoopLogger::GetBtSnoopMode() {
   // Default mode is DISABLED on user build.
   // In userdebug/eng build, it can also be overwritten by modifying the global setting
@@ -16,13 +16,20 @@
 
 #pragma once
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <string>
+#include <tuple>
+#include <utility>
 
-#include "common/circular_buffer.h"
 #include "hal/hci_hal.h"
+#include "hal/snoop_async_writer.h"
+#include "hal/snooz_compressed_buffer.h"
 #include "module.h"
 
 namespace bluetooth {
@@ -40,6 +47,9 @@ class SnoopLogger : public ::bluetooth::Module {
   static const std::string kIsDebuggableProperty;
   static const std::string kBtSnoopLogModeProperty;
   static const std::string kBtSnoopDefaultLogModeProperty;
+  static const std::string kBtSnoopAsyncWriterProperty;
+  static const std::string kBtSnoopSyncIntervalProperty;
+  static const std::string kBtSnoopTruncateProperty;
 
   // Put in header for test
   struct PacketHeaderType {
@@ -66,6 +76,18 @@ class SnoopLogger : public ::bluetooth::Module {
   // Changes to this values is only effective after restarting Bluetooth
   static std::string GetBtSnoopMode();
 
+  // Returns true if snoop records are written to the file from a background thread instead of the HCI path
+  // Changes to this value is only effective after restarting Bluetooth
+  static bool IsAsyncWriterEnabled();
+
+  // Returns how often the background writer syncs the log to storage, zero meaning never
+  // Changes to this value is only effective after restarting Bluetooth
+  static std::chrono::milliseconds GetSyncInterval();
+
+  // Returns true if ACL payloads on channels given a truncation limit are cut short in the snoop log
+  // Changes to this value is only effective after restarting Bluetooth
+  static bool IsTruncationEnabled();
+
   // Has to be defined from 1 to 4 per btsnoop format
   enum PacketType {
     CMD = 1,
@@ -81,6 +103,15 @@ class SnoopLogger : public ::bluetooth::Module {
   };
 
   void Capture(const HciPacket& packet, Direction direction, PacketType type);
+  void Capture(const uint8_t* packet, size_t size, Direction direction, PacketType type);
+  void Capture(const HciPacketSlices& packet, Direction direction, PacketType type);
+
+  // Log at most max_payload_length bytes past the L2CAP header of ACL packets on this channel, e.g. only the media
+  // headers of an audio stream. Incoming packets are matched on the local CID and outgoing ones on the remote CID.
+  // The limit is applied before the packet is copied, and only while IsTruncationEnabled().
+  void SetL2capChannelTruncation(
+      uint16_t connection_handle, uint16_t local_cid, uint16_t remote_cid, size_t max_payload_length);
+  void ClearL2capChannelTruncation(uint16_t connection_handle, uint16_t local_cid, uint16_t remote_cid);
 
  protected:
   void ListDependencies(ModuleList* list) override;
@@ -97,20 +128,34 @@ class SnoopLogger : public ::bluetooth::Module {
       std::string snooz_log_path,
       size_t max_packets_per_file,
       const std::string& btsnoop_mode);
+  ~SnoopLogger() override;
   void CloseCurrentSnoopLogFile();
   void OpenNextSnoopLogFile();
   void DumpSnoozLogToFile(const std::vector<std::string>& data) const;
 
  private:
+  class AsyncOutput;
+
+  void capture(const iovec* slices, size_t slice_count, Direction direction, PacketType type);
+  size_t get_captured_length(const iovec* slices, size_t slice_count, size_t size, Direction direction);
+
   std::string snoop_log_path_;
   std::string snooz_log_path_;
   std::ofstream btsnoop_ostream_;
   bool is_enabled_ = false;
   bool is_filtered_ = false;
   size_t max_packets_per_file_;
-  common::CircularBuffer<std::string> btsnooz_buffer_;
+  SnoozCompressedBuffer btsnooz_buffer_;
   size_t packet_counter_ = 0;
   mutable std::recursive_mutex file_mutex_;
+  std::unique_ptr<AsyncOutput> async_output_;
+  std::unique_ptr<SnoopAsyncWriter> async_writer_;
+  bool is_truncating_ = false;
+  std::mutex truncation_mutex_;
+  // (connection handle, direction, CID in the packet) to the number of L2CAP payload bytes to keep
+  std::map<std::tuple<uint16_t, Direction, uint16_t>, size_t> truncation_limits_;
+  // Links whose current L2CAP PDU was truncated, so its continuing fragments are too
+  std::set<std::pair<uint16_t, Direction>> truncated_pdus_;
 };
 
 }  // namespace hal
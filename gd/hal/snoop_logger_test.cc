@@ -19,6 +19,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "os/system_properties.h"
+
 namespace testing {
 
 namespace {
@@ -47,6 +49,11 @@ std::vector<uint8_t> kAvdtpSuspend = {0x02, 0x02, 0x00, 0x07, 0x00, 0x03, 0x00,
 std::vector<uint8_t> kHfpAtNrec0 = {0x02, 0x02, 0x20, 0x13, 0x00, 0x0f, 0x00, 0x41, 0x00, 0x09, 0xff, 0x15,
                                     0x01, 0x41, 0x54, 0x2b, 0x4e, 0x52, 0x45, 0x43, 0x3d, 0x30, 0x0d, 0x5c};
 
+// Start of an L2CAP PDU on handle 0x0002 and CID 0x0041, followed by a continuing fragment of it
+std::vector<uint8_t> kMediaStart = {0x02, 0x20, 0x0c, 0x00, 0x0c, 0x00, 0x41, 0x00,
+                                    0x80, 0x60, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00};
+std::vector<uint8_t> kMediaContinuation = {0x02, 0x10, 0x04, 0x00, 0x9c, 0xbd, 0x10, 0xaa};
+
 }  // namespace
 
 using bluetooth::TestModuleRegistry;
@@ -299,4 +306,27 @@ TEST_F(SnoopLoggerModuleTest, rotate_file_after_full_test) {
       sizeof(SnoopLogger::FileHeaderType) + (sizeof(SnoopLogger::PacketHeaderType) + kInformationRequest.size()) * 10);
 }
 
+TEST_F(SnoopLoggerModuleTest, truncate_l2cap_channel_test) {
+  ASSERT_TRUE(bluetooth::os::SetSystemProperty(SnoopLogger::kBtSnoopTruncateProperty, "true"));
+  auto* snoop_looger = new TestSnoopLoggerModule(
+      temp_snoop_log_.string(), temp_snooz_log_.string(), 10, SnoopLogger::kBtSnoopLogModeFull);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&SnoopLogger::Factory, snoop_looger);
+
+  snoop_looger->SetL2capChannelTruncation(0x0002, 0x0040, 0x0041, 2);
+  // Outgoing packets are matched on the remote CID
+  snoop_looger->Capture(kMediaStart, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+  snoop_looger->Capture(kMediaContinuation, SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+  // Not the local CID, kept whole
+  snoop_looger->Capture(kMediaStart, SnoopLogger::Direction::INCOMING, SnoopLogger::PacketType::ACL);
+
+  test_registry.StopAll();
+  bluetooth::os::ClearSystemPropertiesForHost();
+
+  ASSERT_EQ(
+      std::filesystem::file_size(temp_snoop_log_),
+      sizeof(SnoopLogger::FileHeaderType) + sizeof(SnoopLogger::PacketHeaderType) * 3 + (8 + 2) + 4 +
+          kMediaStart.size());
+}
+
 }  // namespace testing
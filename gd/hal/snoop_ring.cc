@@ -0,0 +1,138 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_ring.h"
+
+#include <cstring>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
+
+SnoopRing::SnoopRing(size_t capacity) : capacity_(64) {
+  ASSERT(capacity <= kSizeMask);
+  while (capacity_ < capacity) {
+    capacity_ <<= 1;
+  }
+  // Zeroed on allocation, and every range is zeroed again when it is popped, so a control word a producer has
+  // reserved but not written yet always reads as uncommitted
+  storage_ = std::make_unique<uint32_t[]>(capacity_ / sizeof(uint32_t));
+  buffer_ = reinterpret_cast<uint8_t*>(storage_.get());
+}
+
+size_t SnoopRing::record_span(size_t record_size) {
+  return (kControlSize + record_size + kControlSize - 1) & ~(kControlSize - 1);
+}
+
+std::atomic<uint32_t>* SnoopRing::control_at(uint64_t position) {
+  return reinterpret_cast<std::atomic<uint32_t>*>(buffer_ + (position & (capacity_ - 1)));
+}
+
+bool SnoopRing::Push(const void* header, size_t header_size, const iovec* slices, size_t slice_count) {
+  size_t size = header_size;
+  for (size_t i = 0; i < slice_count; i++) {
+    size += slices[i].iov_len;
+  }
+  size_t span = record_span(size);
+  if (span > capacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // A record never wraps around; if it does not fit before the end, the rest of the ring becomes padding
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  uint64_t start;
+  do {
+    size_t to_end = capacity_ - (head & (capacity_ - 1));
+    start = span <= to_end ? head : head + to_end;
+    if (start + span > tail_.load(std::memory_order_acquire) + capacity_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (!head_.compare_exchange_weak(head, start + span, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+  if (start != head) {
+    control_at(head)->store(kCommitted | kPadding | static_cast<uint32_t>(start - head), std::memory_order_release);
+  }
+  uint8_t* out = buffer_ + (start & (capacity_ - 1)) + kControlSize;
+  std::memcpy(out, header, header_size);
+  out += header_size;
+  for (size_t i = 0; i < slice_count; i++) {
+    std::memcpy(out, slices[i].iov_base, slices[i].iov_len);
+    out += slices[i].iov_len;
+  }
+  control_at(start)->store(kCommitted | static_cast<uint32_t>(size), std::memory_order_release);
+  return true;
+}
+
+void SnoopRing::skip_padding() {
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  uint32_t control = control_at(tail)->load(std::memory_order_relaxed);
+  size_t padding = control & kSizeMask;
+  control_at(tail)->store(0, std::memory_order_relaxed);
+  tail_.store(tail + padding, std::memory_order_release);
+}
+
+bool SnoopRing::Front(const uint8_t** data, size_t* size) {
+  while (true) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    uint32_t control = control_at(tail)->load(std::memory_order_acquire);
+    if ((control & kCommitted) == 0) {
+      // Reserved, but the producer is still copying
+      return false;
+    }
+    if ((control & kPadding) != 0) {
+      skip_padding();
+      continue;
+    }
+    *data = buffer_ + (tail & (capacity_ - 1)) + kControlSize;
+    *size = control & kSizeMask;
+    return true;
+  }
+}
+
+void SnoopRing::PopFront() {
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  uint32_t control = control_at(tail)->load(std::memory_order_relaxed);
+  ASSERT((control & kCommitted) != 0 && (control & kPadding) == 0);
+  size_t span = record_span(control & kSizeMask);
+  control_at(tail)->store(0, std::memory_order_relaxed);
+  std::memset(buffer_ + (tail & (capacity_ - 1)) + kControlSize, 0, span - kControlSize);
+  tail_.store(tail + span, std::memory_order_release);
+}
+
+size_t SnoopRing::GetUsedBytes() const {
+  // Tail first: it only grows towards head, so the difference can't go negative
+  uint64_t tail = tail_.load(std::memory_order_acquire);
+  return head_.load(std::memory_order_acquire) - tail;
+}
+
+size_t SnoopRing::GetCapacity() const {
+  return capacity_;
+}
+
+uint64_t SnoopRing::GetDroppedCount() const {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+}  // namespace hal
+}  // namespace bluetooth
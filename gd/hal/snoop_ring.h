@@ -0,0 +1,75 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace hal {
+
+// Bounded ring of variable sized records, filled by any number of threads and drained by a single one.
+// Producers reserve space with a compare-and-swap and never block. When the ring is full the record is dropped and
+// counted instead.
+class SnoopRing {
+ public:
+  // capacity is rounded up to a power of two
+  explicit SnoopRing(size_t capacity);
+  DISALLOW_COPY_AND_ASSIGN(SnoopRing);
+
+  // Copy the header followed by the slices into the ring as one record. Returns false if it did not fit.
+  bool Push(const void* header, size_t header_size, const iovec* slices, size_t slice_count);
+
+  // Consumer side. Point to the oldest record and return true, or return false if the oldest record is not fully
+  // written yet or there is none. The record stays valid until PopFront().
+  bool Front(const uint8_t** data, size_t* size);
+  void PopFront();
+
+  // Bytes reserved by producers and not popped yet
+  size_t GetUsedBytes() const;
+  size_t GetCapacity() const;
+
+  // Number of records dropped because the ring was full
+  uint64_t GetDroppedCount() const;
+
+ private:
+  // Every record starts with a 32-bit control word holding its size and flags, aligned to 4 bytes
+  static constexpr uint32_t kCommitted = 1u << 31;
+  static constexpr uint32_t kPadding = 1u << 30;
+  static constexpr uint32_t kSizeMask = kPadding - 1;
+  static constexpr size_t kControlSize = sizeof(uint32_t);
+
+  static size_t record_span(size_t record_size);
+  std::atomic<uint32_t>* control_at(uint64_t position);
+  void skip_padding();
+
+  size_t capacity_;
+  std::unique_ptr<uint32_t[]> storage_;
+  uint8_t* buffer_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+}  // namespace hal
+}  // namespace bluetooth
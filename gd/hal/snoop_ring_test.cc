@@ -0,0 +1,138 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+bool push_bytes(SnoopRing& ring, uint8_t header, std::vector<uint8_t> payload) {
+  iovec slice = {payload.data(), payload.size()};
+  return ring.Push(&header, sizeof(header), &slice, 1);
+}
+
+std::vector<uint8_t> pop_bytes(SnoopRing& ring) {
+  const uint8_t* data;
+  size_t size;
+  if (!ring.Front(&data, &size)) {
+    return {};
+  }
+  std::vector<uint8_t> record(data, data + size);
+  ring.PopFront();
+  return record;
+}
+
+TEST(SnoopRingTest, capacity_is_a_power_of_two) {
+  SnoopRing ring(100);
+  ASSERT_EQ(128u, ring.GetCapacity());
+}
+
+TEST(SnoopRingTest, records_come_out_in_order) {
+  SnoopRing ring(256);
+  ASSERT_TRUE(push_bytes(ring, 1, {2, 3}));
+  ASSERT_TRUE(push_bytes(ring, 4, {5, 6, 7}));
+  ASSERT_EQ(std::vector<uint8_t>({1, 2, 3}), pop_bytes(ring));
+  ASSERT_EQ(std::vector<uint8_t>({4, 5, 6, 7}), pop_bytes(ring));
+  ASSERT_EQ(0u, ring.GetUsedBytes());
+  ASSERT_TRUE(pop_bytes(ring).empty());
+}
+
+TEST(SnoopRingTest, full_ring_drops_and_counts) {
+  SnoopRing ring(64);
+  std::vector<uint8_t> payload(27);
+  // Each record takes 4 bytes of control, 1 byte of header and 27 bytes of payload
+  ASSERT_TRUE(push_bytes(ring, 0, payload));
+  ASSERT_TRUE(push_bytes(ring, 1, payload));
+  ASSERT_FALSE(push_bytes(ring, 2, payload));
+  ASSERT_EQ(1u, ring.GetDroppedCount());
+
+  ASSERT_EQ(0, pop_bytes(ring)[0]);
+  ASSERT_TRUE(push_bytes(ring, 3, payload));
+  ASSERT_EQ(1, pop_bytes(ring)[0]);
+  ASSERT_EQ(3, pop_bytes(ring)[0]);
+}
+
+TEST(SnoopRingTest, record_larger_than_ring_is_dropped) {
+  SnoopRing ring(64);
+  ASSERT_FALSE(push_bytes(ring, 0, std::vector<uint8_t>(64)));
+  ASSERT_EQ(1u, ring.GetDroppedCount());
+}
+
+TEST(SnoopRingTest, records_do_not_wrap) {
+  SnoopRing ring(64);
+  std::vector<uint8_t> payload(19);
+  // 24 bytes each: the third record does not fit in the last 16 bytes and restarts at the beginning
+  ASSERT_TRUE(push_bytes(ring, 0, payload));
+  ASSERT_TRUE(push_bytes(ring, 1, payload));
+  ASSERT_EQ(0, pop_bytes(ring)[0]);
+  ASSERT_TRUE(push_bytes(ring, 2, payload));
+  ASSERT_EQ(1, pop_bytes(ring)[0]);
+  std::vector<uint8_t> record = pop_bytes(ring);
+  ASSERT_EQ(20u, record.size());
+  ASSERT_EQ(2, record[0]);
+  ASSERT_EQ(0u, ring.GetUsedBytes());
+}
+
+TEST(SnoopRingTest, concurrent_producers) {
+  constexpr int kProducers = 4;
+  constexpr uint32_t kRecordsPerProducer = 10000;
+  SnoopRing ring(4096);
+  std::vector<std::thread> producers;
+  for (uint8_t producer = 0; producer < kProducers; producer++) {
+    producers.emplace_back([&ring, producer]() {
+      for (uint32_t i = 0; i < kRecordsPerProducer;) {
+        iovec slice = {&i, sizeof(i)};
+        if (ring.Push(&producer, sizeof(producer), &slice, 1)) {
+          i++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<uint32_t> next(kProducers, 0);
+  uint32_t received = 0;
+  while (received < kProducers * kRecordsPerProducer) {
+    const uint8_t* data;
+    size_t size;
+    if (!ring.Front(&data, &size)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(5u, size);
+    uint32_t sequence;
+    std::memcpy(&sequence, data + 1, sizeof(sequence));
+    // Records from one producer stay in order
+    ASSERT_EQ(next[data[0]]++, sequence);
+    ring.PopFront();
+    received++;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snooz_compressed_buffer.h"
+
+#include <zlib.h>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hal {
+
+SnoozCompressedBuffer::SnoozCompressedBuffer(size_t memory_budget, size_t chunk_size)
+    : memory_budget_(memory_budget), chunk_size_(chunk_size) {
+  ASSERT(chunk_size_ > 0 && chunk_size_ < memory_budget_);
+  open_chunk_.reserve(chunk_size_);
+}
+
+void SnoozCompressedBuffer::Push(const std::string& record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!open_chunk_.empty() && open_chunk_.size() + record.size() > chunk_size_) {
+    close_chunk_locked();
+  }
+  open_chunk_.append(record);
+}
+
+void SnoozCompressedBuffer::close_chunk_locked() {
+  Chunk chunk = {std::string(compressBound(open_chunk_.size()), '\0'), open_chunk_.size(), true};
+  uLongf compressed_size = chunk.data.size();
+  // This runs on the capture path, so favour speed; snooz records compress well even at the lowest level
+  int result = compress2(
+      reinterpret_cast<Bytef*>(&chunk.data[0]),
+      &compressed_size,
+      reinterpret_cast<const Bytef*>(open_chunk_.data()),
+      open_chunk_.size(),
+      Z_BEST_SPEED);
+  if (result == Z_OK && compressed_size < open_chunk_.size()) {
+    chunk.data.resize(compressed_size);
+    chunk.data.shrink_to_fit();
+  } else {
+    if (result != Z_OK) {
+      LOG_WARN("Failed to compress snooz chunk, error %d, keeping it as is", result);
+    }
+    chunk.data = open_chunk_;
+    chunk.compressed = false;
+  }
+  open_chunk_.clear();
+
+  chunk_bytes_ += chunk.data.size();
+  chunks_.push_back(std::move(chunk));
+  // The open chunk grows up to chunk_size_ again, keep room for it
+  while (!chunks_.empty() && chunk_bytes_ + chunk_size_ > memory_budget_) {
+    chunk_bytes_ -= chunks_.front().data.size();
+    chunks_.pop_front();
+  }
+}
+
+std::vector<std::string> SnoozCompressedBuffer::pull_locked() const {
+  std::vector<std::string> history;
+  history.reserve(chunks_.size() + 1);
+  for (const auto& chunk : chunks_) {
+    if (!chunk.compressed) {
+      history.push_back(chunk.data);
+      continue;
+    }
+    std::string inflated(chunk.uncompressed_size, '\0');
+    uLongf inflated_size = inflated.size();
+    int result = uncompress(
+        reinterpret_cast<Bytef*>(&inflated[0]),
+        &inflated_size,
+        reinterpret_cast<const Bytef*>(chunk.data.data()),
+        chunk.data.size());
+    if (result != Z_OK || inflated_size != chunk.uncompressed_size) {
+      LOG_ERROR("Failed to decompress snooz chunk, error %d, skipping it", result);
+      continue;
+    }
+    history.push_back(std::move(inflated));
+  }
+  if (!open_chunk_.empty()) {
+    history.push_back(open_chunk_);
+  }
+  return history;
+}
+
+std::vector<std::string> SnoozCompressedBuffer::Pull() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pull_locked();
+}
+
+std::vector<std::string> SnoozCompressedBuffer::Drain() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto history = pull_locked();
+  chunks_.clear();
+  chunk_bytes_ = 0;
+  open_chunk_.clear();
+  return history;
+}
+
+size_t SnoozCompressedBuffer::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return chunk_bytes_ + open_chunk_.capacity();
+}
+
+}  // namespace hal
+}  // namespace bluetooth
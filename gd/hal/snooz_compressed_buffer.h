@@ -0,0 +1,65 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+
+// In-memory history of snooz records, kept deflated to hold more of it in the same memory.
+// Records are appended to an open chunk. Once the chunk reaches chunk_size it is compressed on its own, so the oldest
+// chunk can be dropped without touching the others. Chunks are only inflated again when the history is read.
+class SnoozCompressedBuffer {
+ public:
+  // The compressed chunks plus the open chunk stay within memory_budget bytes
+  SnoozCompressedBuffer(size_t memory_budget, size_t chunk_size);
+
+  // Append one complete record
+  void Push(const std::string& record);
+  // Take a snapshot of the history. Each element holds whole records, oldest first.
+  std::vector<std::string> Pull() const;
+  // Return the history like Pull() and clear it
+  std::vector<std::string> Drain();
+
+  // Bytes held by compressed chunks and the open chunk
+  size_t GetMemoryUsage() const;
+
+ private:
+  struct Chunk {
+    std::string data;
+    size_t uncompressed_size;
+    bool compressed;
+  };
+
+  void close_chunk_locked();
+  std::vector<std::string> pull_locked() const;
+
+  const size_t memory_budget_;
+  const size_t chunk_size_;
+  std::deque<Chunk> chunks_;
+  size_t chunk_bytes_ = 0;
+  std::string open_chunk_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace hal
+}  // namespace bluetooth
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snooz_compressed_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+// Looks like a snooz record: a mostly constant header followed by a counter
+std::string make_record(uint32_t sequence) {
+  std::string record(40, '\x01');
+  record.append(reinterpret_cast<const char*>(&sequence), sizeof(sequence));
+  return record;
+}
+
+std::string join(const std::vector<std::string>& history) {
+  std::string joined;
+  for (const auto& part : history) {
+    joined.append(part);
+  }
+  return joined;
+}
+
+TEST(SnoozCompressedBufferTest, pull_returns_records_in_order) {
+  SnoozCompressedBuffer buffer(4096, 256);
+  std::string expected;
+  for (uint32_t i = 0; i < 20; i++) {
+    buffer.Push(make_record(i));
+    expected.append(make_record(i));
+  }
+  ASSERT_EQ(expected, join(buffer.Pull()));
+  // Pulling does not consume
+  ASSERT_EQ(expected, join(buffer.Pull()));
+}
+
+TEST(SnoozCompressedBufferTest, drain_clears) {
+  SnoozCompressedBuffer buffer(4096, 256);
+  for (uint32_t i = 0; i < 20; i++) {
+    buffer.Push(make_record(i));
+  }
+  ASSERT_FALSE(join(buffer.Drain()).empty());
+  ASSERT_TRUE(buffer.Pull().empty());
+}
+
+TEST(SnoozCompressedBufferTest, keeps_more_history_than_memory_used) {
+  constexpr size_t kBudget = 16 * 1024;
+  constexpr uint32_t kRecords = 10000;
+  SnoozCompressedBuffer buffer(kBudget, 1024);
+  for (uint32_t i = 0; i < kRecords; i++) {
+    buffer.Push(make_record(i));
+  }
+  ASSERT_LE(buffer.GetMemoryUsage(), kBudget);
+
+  std::string history = join(buffer.Pull());
+  size_t record_size = make_record(0).size();
+  ASSERT_EQ(0u, history.size() % record_size);
+  ASSERT_GT(history.size(), 4 * kBudget);
+  // The newest records are kept, oldest first, with nothing missing in between
+  size_t kept = history.size() / record_size;
+  for (size_t i = 0; i < kept; i++) {
+    ASSERT_EQ(make_record(kRecords - kept + i), history.substr(i * record_size, record_size));
+  }
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
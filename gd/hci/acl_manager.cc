@@ -19,13 +19,17 @@
 #include <atomic>
 #include <future>
 #include <set>
+#include <vector>
 
 #include "common/bidi_queue.h"
+#include "common/init_flags.h"
 #include "hci/acl_manager/classic_impl.h"
 #include "hci/acl_manager/connection_management_callbacks.h"
 #include "hci/acl_manager/le_acl_connection.h"
 #include "hci/acl_manager/le_impl.h"
+#include "hci/acl_manager/link_statistics.h"
 #include "hci/acl_manager/round_robin_scheduler.h"
+#include "hci/acl_manager/weighted_fair_scheduler.h"
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "hci_acl_manager_generated.h"
@@ -49,7 +53,10 @@ using acl_manager::le_impl;
 using acl_manager::LeAclConnection;
 using acl_manager::LeConnectionCallbacks;
 
+using acl_manager::AclScheduler;
+using acl_manager::LinkStatistics;
 using acl_manager::RoundRobinScheduler;
+using acl_manager::WeightedFairScheduler;
 
 struct AclManager::impl {
   impl(const AclManager& acl_manager) : acl_manager_(acl_manager) {}
@@ -58,22 +65,26 @@ struct AclManager::impl {
     hci_layer_ = acl_manager_.GetDependency<HciLayer>();
     handler_ = acl_manager_.GetHandler();
     controller_ = acl_manager_.GetDependency<Controller>();
-    round_robin_scheduler_ = new RoundRobinScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd());
+    if (common::init_flags::gd_acl_fair_scheduler_is_enabled()) {
+      acl_scheduler_ =
+          new WeightedFairScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd(), &link_statistics_);
+    } else {
+      acl_scheduler_ = new RoundRobinScheduler(handler_, controller_, hci_layer_->GetAclQueueEnd(), &link_statistics_);
+    }
 
     hci_queue_end_ = hci_layer_->GetAclQueueEnd();
     hci_queue_end_->RegisterDequeue(
         handler_, common::Bind(&impl::dequeue_and_route_acl_packet_to_connection, common::Unretained(this)));
     bool crash_on_unknown_handle = false;
-    classic_impl_ =
-        new classic_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, crash_on_unknown_handle);
-    le_impl_ = new le_impl(hci_layer_, controller_, handler_, round_robin_scheduler_, crash_on_unknown_handle);
+    classic_impl_ = new classic_impl(hci_layer_, controller_, handler_, acl_scheduler_, crash_on_unknown_handle);
+    le_impl_ = new le_impl(hci_layer_, controller_, handler_, acl_scheduler_, crash_on_unknown_handle);
   }
 
   void Stop() {
     delete le_impl_;
     delete classic_impl_;
     hci_queue_end_->UnregisterDequeue();
-    delete round_robin_scheduler_;
+    delete acl_scheduler_;
     if (enqueue_registered_.exchange(false)) {
       hci_queue_end_->UnregisterEnqueue();
     }
@@ -94,6 +105,7 @@ struct AclManager::impl {
     if (handle == kQualcommDebugHandle) {
       return;
     }
+    link_statistics_.OnFragmentReceived(handle, packet->size());
     auto connection_pair = classic_impl_->acl_connections_.find(handle);
     if (connection_pair != classic_impl_->acl_connections_.end()) {
       connection_pair->second.assembler_.on_incoming_packet(*packet);
@@ -117,7 +129,8 @@ struct AclManager::impl {
   os::Handler* handler_ = nullptr;
   Controller* controller_ = nullptr;
   HciLayer* hci_layer_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
+  LinkStatistics link_statistics_;
   common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
   std::atomic_bool enqueue_registered_ = false;
   uint16_t default_link_policy_settings_ = 0xffff;
@@ -276,7 +289,7 @@ void AclManager::HACK_SetScoDisconnectCallback(std::function<void(uint16_t, uint
 }
 
 void AclManager::HACK_SetAclTxPriority(uint8_t handle, bool high_priority) {
-  CallOn(pimpl_->round_robin_scheduler_, &RoundRobinScheduler::SetLinkPriority, handle, high_priority);
+  CallOn(pimpl_->acl_scheduler_, &AclScheduler::SetLinkPriority, handle, high_priority);
 }
 
 void AclManager::ListDependencies(ModuleList* list) {
@@ -304,8 +317,50 @@ AclManager::~AclManager() = default;
 void AclManager::impl::Dump(
     std::promise<flatbuffers::Offset<AclManagerData>> promise, flatbuffers::FlatBufferBuilder* fb_builder) const {
   auto title = fb_builder->CreateString("----- Acl Manager Dumpsys -----");
+
+  std::vector<uint64_t> bucket_upper_bounds;
+  for (size_t i = 0; i < common::TaskLatencyStats::kNumBuckets; i++) {
+    bucket_upper_bounds.push_back(common::TaskLatencyStats::BucketUpperBoundUs(i));
+  }
+  auto bucket_upper_bounds_offset = fb_builder->CreateVector(bucket_upper_bounds);
+
+  auto dump_histogram = [fb_builder](const LinkStatistics::Histogram& histogram) {
+    auto buckets = fb_builder->CreateVector(histogram.buckets.data(), histogram.buckets.size());
+    AclLinkHistogramDataBuilder builder(*fb_builder);
+    builder.add_count(histogram.count);
+    builder.add_total_us(histogram.total_us);
+    builder.add_max_us(histogram.max_us);
+    builder.add_buckets(buckets);
+    return builder.Finish();
+  };
+
+  std::vector<flatbuffers::Offset<AclLinkStatsData>> links;
+  for (const auto& stats : link_statistics_.GetSnapshot()) {
+    auto connection_type =
+        fb_builder->CreateString(stats.connection_type == AclScheduler::ConnectionType::CLASSIC ? "CLASSIC" : "LE");
+    auto credit_wait = dump_histogram(stats.credit_wait);
+    auto completion_time = dump_histogram(stats.completion_time);
+    AclLinkStatsDataBuilder link_builder(*fb_builder);
+    link_builder.add_handle(stats.handle);
+    link_builder.add_connection_type(connection_type);
+    link_builder.add_tx_packets(stats.tx_packets);
+    link_builder.add_tx_fragments(stats.tx_fragments);
+    link_builder.add_tx_bytes(stats.tx_bytes);
+    link_builder.add_rx_fragments(stats.rx_fragments);
+    link_builder.add_rx_bytes(stats.rx_bytes);
+    link_builder.add_queue_depth(stats.queue_depth);
+    link_builder.add_max_queue_depth(stats.max_queue_depth);
+    link_builder.add_unacknowledged_fragments(stats.unacknowledged_fragments);
+    link_builder.add_credit_wait(credit_wait);
+    link_builder.add_completion_time(completion_time);
+    links.push_back(link_builder.Finish());
+  }
+  auto links_offset = fb_builder->CreateVector(links);
+
   AclManagerDataBuilder builder(*fb_builder);
   builder.add_title(title);
+  builder.add_bucket_upper_bounds_us(bucket_upper_bounds_offset);
+  builder.add_links(links_offset);
   flatbuffers::Offset<AclManagerData> dumpsys_data = builder.Finish();
   promise.set_value(dumpsys_data);
 }
@@ -17,7 +17,6 @@
 #include "hci/acl_manager/acl_fragmenter.h"
 
 #include "os/log.h"
-#include "packet/fragmenting_inserter.h"
 
 namespace bluetooth {
 namespace hci {
@@ -26,12 +25,8 @@ namespace acl_manager {
 AclFragmenter::AclFragmenter(size_t mtu, std::unique_ptr<packet::BasePacketBuilder> packet)
     : mtu_(mtu), packet_(std::move(packet)) {}
 
-std::vector<std::unique_ptr<packet::RawBuilder>> AclFragmenter::GetFragments() {
-  std::vector<std::unique_ptr<packet::RawBuilder>> to_return;
-  packet::FragmentingInserter fragmenting_inserter(mtu_, std::back_insert_iterator(to_return));
-  packet_->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
-  return to_return;
+std::vector<std::unique_ptr<packet::SliceBuilder>> AclFragmenter::GetFragments() {
+  return packet::SliceBuilder::Fragment(*packet_, mtu_);
 }
 
 }  // namespace acl_manager
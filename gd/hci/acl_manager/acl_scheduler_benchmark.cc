@@ -0,0 +1,133 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "hci/acl_manager/deficit_round_robin.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Ten links sharing the controller buffers: two A2DP streams and two HID devices on classic links, three GATT links
+// on LE, and bulk transfers on both. The controller frees one classic and one LE buffer per tick, which the bulk
+// transfers alone could fill. Packets carry the tick they were queued at, and the counters report the worst number
+// of ticks a packet of each class waited for its turn.
+class BM_AclScheduler : public ::benchmark::Fixture {
+ protected:
+  struct SimulatedLink {
+    uint16_t handle;
+    LatencyClass latency_class;
+    bool le;
+    size_t size;
+    // A new packet every period ticks, 0 for a link that always has packets queued
+    int period;
+  };
+
+  static constexpr std::array<SimulatedLink, 10> kLinks = {{
+      {1, LatencyClass::AUDIO, false, 660, 10},
+      {2, LatencyClass::AUDIO, false, 660, 10},
+      {3, LatencyClass::HID, false, 20, 5},
+      {4, LatencyClass::HID, false, 20, 5},
+      {5, LatencyClass::GATT, true, 27, 6},
+      {6, LatencyClass::GATT, true, 27, 6},
+      {7, LatencyClass::GATT, true, 27, 6},
+      {8, LatencyClass::BULK, false, 1021, 0},
+      {9, LatencyClass::BULK, false, 1021, 0},
+      {10, LatencyClass::BULK, true, 251, 0},
+  }};
+  static constexpr int kTicks = 1000;
+  static constexpr int kBufferCount = 8;
+  static constexpr size_t kBulkBacklog = 4;
+
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    worst_wait_.fill(0);
+  }
+
+  void TearDown(State& st) override {
+    st.counters["audio_worst_wait"] = worst_wait_[static_cast<size_t>(LatencyClass::AUDIO)];
+    st.counters["hid_worst_wait"] = worst_wait_[static_cast<size_t>(LatencyClass::HID)];
+    st.counters["gatt_worst_wait"] = worst_wait_[static_cast<size_t>(LatencyClass::GATT)];
+    st.counters["bulk_worst_wait"] = worst_wait_[static_cast<size_t>(LatencyClass::BULK)];
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  static const SimulatedLink& get_link(uint16_t handle) {
+    return kLinks[handle - 1];
+  }
+
+  // With equal_share every link is BULK, so the queues are served like a plain round robin in bytes
+  void run(bool equal_share) {
+    DeficitRoundRobin<int> queues;
+    for (const auto& link : kLinks) {
+      queues.AddLink(link.handle, equal_share ? LatencyClass::BULK : link.latency_class);
+    }
+    int classic_credits = kBufferCount;
+    int le_credits = kBufferCount;
+    auto has_credit = [&](uint16_t handle) { return (get_link(handle).le ? le_credits : classic_credits) > 0; };
+
+    for (int tick = 0; tick < kTicks; tick++) {
+      for (const auto& link : kLinks) {
+        if (link.period == 0) {
+          while (queues.GetQueueDepth(link.handle) < kBulkBacklog) {
+            queues.Push(link.handle, tick, link.size);
+          }
+        } else if (tick % link.period == 0) {
+          queues.Push(link.handle, tick, link.size);
+        }
+      }
+      uint16_t handle;
+      int queued_at;
+      while (queues.Pop(has_credit, &handle, &queued_at)) {
+        const auto& link = get_link(handle);
+        (link.le ? le_credits : classic_credits)--;
+        auto& worst = worst_wait_[static_cast<size_t>(link.latency_class)];
+        worst = std::max(worst, tick - queued_at);
+      }
+      classic_credits = std::min(classic_credits + 1, kBufferCount);
+      le_credits = std::min(le_credits + 1, kBufferCount);
+    }
+    benchmark::DoNotOptimize(queues.GetSize());
+  }
+
+  std::array<int, 4> worst_wait_;
+};
+
+BENCHMARK_DEFINE_F(BM_AclScheduler, equal_share)(State& state) {
+  for (auto _ : state) {
+    run(true);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_AclScheduler, equal_share);
+
+BENCHMARK_DEFINE_F(BM_AclScheduler, latency_classes)(State& state) {
+  for (auto _ : state) {
+    run(false);
+  }
+}
+
+BENCHMARK_REGISTER_F(BM_AclScheduler, latency_classes);
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
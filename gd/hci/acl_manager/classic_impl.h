@@ -17,9 +17,9 @@
 #pragma once
 
 #include "common/bind.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/acl_manager/assembler.h"
 #include "hci/acl_manager/event_checkers.h"
-#include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/controller.h"
 #include "security/security_manager_listener.h"
 #include "security/security_module.h"
@@ -42,11 +42,11 @@ struct classic_impl : public security::ISecurityManagerListener {
       HciLayer* hci_layer,
       Controller* controller,
       os::Handler* handler,
-      RoundRobinScheduler* round_robin_scheduler,
+      AclScheduler* acl_scheduler,
       bool crash_on_unknown_handle)
       : hci_layer_(hci_layer),
         controller_(controller),
-        round_robin_scheduler_(round_robin_scheduler),
+        acl_scheduler_(acl_scheduler),
         crash_on_unknown_handle_(crash_on_unknown_handle) {
     hci_layer_ = hci_layer;
     controller_ = controller;
@@ -131,7 +131,7 @@ struct classic_impl : public security::ISecurityManagerListener {
   void on_classic_disconnect(uint16_t handle, ErrorCode reason) {
     auto callbacks = get_callbacks(handle);
     if (callbacks != nullptr) {
-      round_robin_scheduler_->Unregister(handle);
+      acl_scheduler_->Unregister(handle);
       callbacks->OnDisconnection(reason);
       acl_connections_.erase(handle);
     } else {
@@ -271,7 +271,7 @@ struct classic_impl : public security::ISecurityManagerListener {
         std::forward_as_tuple(
             AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS}, queue->GetDownEnd(), handler_));
     ASSERT(conn_pair.second);  // Make sure it's not a duplicate
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::CLASSIC, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::CLASSIC, handle, queue);
     std::unique_ptr<ClassicAclConnection> connection(
         new ClassicAclConnection(std::move(queue), acl_connection_interface_, handle, address));
     connection->locally_initiated_ = locally_initiated;
@@ -680,7 +680,7 @@ struct classic_impl : public security::ISecurityManagerListener {
 
   HciLayer* hci_layer_ = nullptr;
   Controller* controller_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
   AclConnectionInterface* acl_connection_interface_ = nullptr;
   os::Handler* handler_ = nullptr;
   ConnectionCallbacks* client_callbacks_ = nullptr;
@@ -0,0 +1,263 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// How latency sensitive the traffic of a link is, most sensitive first
+enum class LatencyClass : uint8_t {
+  AUDIO = 0,
+  HID = 1,
+  GATT = 2,
+  BULK = 3,
+};
+
+constexpr uint16_t GetDefaultWeight(LatencyClass latency_class) {
+  switch (latency_class) {
+    case LatencyClass::AUDIO:
+    case LatencyClass::HID:
+    case LatencyClass::GATT:
+      return 4;
+    case LatencyClass::BULK:
+      return 1;
+  }
+  return 1;
+}
+
+/**
+ * Per-link packet queues served by deficit round robin.
+ * AUDIO links, then HID links, are served strictly before all others: their traffic is small and periodic, and a
+ * late packet is a glitch. GATT and BULK links share the remaining capacity in proportion to their weights, so a bulk
+ * transfer can slow GATT links down but never starve them. Links in the same class take turns; each turn a link may
+ * send up to weight * kQuantum bytes, and unused credit carries over while it stays backlogged.
+ * Packets of a link are always popped in the order they were pushed.
+ */
+template <typename T>
+class DeficitRoundRobin {
+ public:
+  // Bytes of credit per unit of weight per turn
+  static constexpr size_t kQuantum = 256;
+
+  void AddLink(uint16_t handle, LatencyClass latency_class) {
+    ASSERT_LOG(links_.count(handle) == 0, "handle 0x%hx is already added", handle);
+    links_[handle].latency_class = latency_class;
+    add_to_tier(handle, latency_class);
+  }
+
+  // Queued packets of the link are dropped
+  void RemoveLink(uint16_t handle) {
+    auto link = links_.find(handle);
+    ASSERT_LOG(link != links_.end(), "unknown handle 0x%hx", handle);
+    size_ -= link->second.packets.size();
+    remove_from_tier(handle, link->second.latency_class);
+    links_.erase(link);
+  }
+
+  bool HasLink(uint16_t handle) const {
+    return links_.count(handle) != 0;
+  }
+
+  void SetLatencyClass(uint16_t handle, LatencyClass latency_class) {
+    auto& link = get_link(handle);
+    if (link.latency_class == latency_class) {
+      return;
+    }
+    remove_from_tier(handle, link.latency_class);
+    link.latency_class = latency_class;
+    link.deficit = 0;
+    link.turn_started = false;
+    add_to_tier(handle, latency_class);
+  }
+
+  LatencyClass GetLatencyClass(uint16_t handle) const {
+    return get_link(handle).latency_class;
+  }
+
+  // A weight of 0 restores the default weight of the link's class
+  void SetWeight(uint16_t handle, uint16_t weight) {
+    get_link(handle).weight = weight;
+  }
+
+  uint16_t GetWeight(uint16_t handle) const {
+    const auto& link = get_link(handle);
+    return link.weight != 0 ? link.weight : GetDefaultWeight(link.latency_class);
+  }
+
+  void Push(uint16_t handle, T packet, size_t size) {
+    get_link(handle).packets.emplace_back(std::move(packet), size);
+    size_++;
+  }
+
+  size_t GetQueueDepth(uint16_t handle) const {
+    return get_link(handle).packets.size();
+  }
+
+  // Total number of queued packets
+  size_t GetSize() const {
+    return size_;
+  }
+
+  // Whether Pop() would return a packet
+  template <typename Eligible>
+  bool HasPacket(Eligible eligible) const {
+    for (const auto& link : links_) {
+      if (!link.second.packets.empty() && eligible(link.first)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Pop the next packet to send from the links accepted by eligible(handle), e.g. the links whose controller buffer
+   * has room. Ineligible links keep their place and credit. Returns false if no eligible link has a packet.
+   */
+  template <typename Eligible>
+  bool Pop(Eligible eligible, uint16_t* handle, T* packet) {
+    for (auto& tier : tiers_) {
+      if (pop_from_tier(tier, eligible, handle, packet)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct Link {
+    LatencyClass latency_class;
+    uint16_t weight = 0;
+    size_t deficit = 0;
+    bool turn_started = false;
+    std::deque<std::pair<T, size_t>> packets;
+  };
+
+  struct Tier {
+    std::vector<uint16_t> handles;
+    size_t cursor = 0;
+  };
+
+  static size_t tier_of(LatencyClass latency_class) {
+    switch (latency_class) {
+      case LatencyClass::AUDIO:
+        return 0;
+      case LatencyClass::HID:
+        return 1;
+      case LatencyClass::GATT:
+      case LatencyClass::BULK:
+        return 2;
+    }
+    return 2;
+  }
+
+  Link& get_link(uint16_t handle) {
+    auto link = links_.find(handle);
+    ASSERT_LOG(link != links_.end(), "unknown handle 0x%hx", handle);
+    return link->second;
+  }
+
+  const Link& get_link(uint16_t handle) const {
+    auto link = links_.find(handle);
+    ASSERT_LOG(link != links_.end(), "unknown handle 0x%hx", handle);
+    return link->second;
+  }
+
+  void add_to_tier(uint16_t handle, LatencyClass latency_class) {
+    tiers_[tier_of(latency_class)].handles.push_back(handle);
+  }
+
+  void remove_from_tier(uint16_t handle, LatencyClass latency_class) {
+    auto& tier = tiers_[tier_of(latency_class)];
+    auto it = std::find(tier.handles.begin(), tier.handles.end(), handle);
+    size_t index = it - tier.handles.begin();
+    tier.handles.erase(it);
+    if (index < tier.cursor) {
+      tier.cursor--;
+    }
+    if (tier.cursor >= tier.handles.size()) {
+      tier.cursor = 0;
+    }
+  }
+
+  void end_turn(Tier& tier, Link& link) {
+    link.turn_started = false;
+    tier.cursor = (tier.cursor + 1) % tier.handles.size();
+  }
+
+  template <typename Eligible>
+  bool pop_from_tier(Tier& tier, Eligible& eligible, uint16_t* handle, T* packet) {
+    // Each visit to an eligible backlogged link adds to its credit, so one is served within a bounded number of
+    // turns. Give up after a full round without any.
+    size_t idle_visits = 0;
+    while (idle_visits < tier.handles.size()) {
+      uint16_t current = tier.handles[tier.cursor];
+      auto& link = links_.find(current)->second;
+      if (link.packets.empty()) {
+        link.deficit = 0;
+        end_turn(tier, link);
+        idle_visits++;
+        continue;
+      }
+      if (!eligible(current)) {
+        end_turn(tier, link);
+        idle_visits++;
+        continue;
+      }
+      idle_visits = 0;
+      if (!link.turn_started) {
+        link.turn_started = true;
+        link.deficit += GetWeight(current) * kQuantum;
+      }
+      size_t size = link.packets.front().second;
+      if (link.deficit < size) {
+        end_turn(tier, link);
+        continue;
+      }
+      link.deficit -= size;
+      *handle = current;
+      *packet = std::move(link.packets.front().first);
+      link.packets.pop_front();
+      size_--;
+      if (link.packets.empty()) {
+        link.deficit = 0;
+        end_turn(tier, link);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  std::map<uint16_t, Link> links_;
+  std::array<Tier, 3> tiers_;
+  size_t size_ = 0;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
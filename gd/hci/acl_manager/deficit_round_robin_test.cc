@@ -0,0 +1,150 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/deficit_round_robin.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+constexpr auto kAll = [](uint16_t) { return true; };
+
+TEST(DeficitRoundRobinTest, keeps_order_within_link) {
+  DeficitRoundRobin<int> queues;
+  queues.AddLink(1, LatencyClass::BULK);
+  for (int i = 0; i < 5; i++) {
+    queues.Push(1, i, 1000);
+  }
+  ASSERT_EQ(5u, queues.GetQueueDepth(1));
+  for (int i = 0; i < 5; i++) {
+    uint16_t handle;
+    int packet;
+    ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+    ASSERT_EQ(1, handle);
+    ASSERT_EQ(i, packet);
+  }
+  uint16_t handle;
+  int packet;
+  ASSERT_FALSE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(0u, queues.GetSize());
+}
+
+TEST(DeficitRoundRobinTest, shares_bytes_by_weight) {
+  DeficitRoundRobin<int> queues;
+  queues.AddLink(1, LatencyClass::BULK);
+  queues.AddLink(2, LatencyClass::GATT);
+  for (int i = 0; i < 100; i++) {
+    queues.Push(1, 0, 256);
+    queues.Push(2, 0, 256);
+  }
+  std::map<uint16_t, int> served;
+  for (int i = 0; i < 50; i++) {
+    uint16_t handle;
+    int packet;
+    ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+    served[handle]++;
+  }
+  ASSERT_EQ(10, served[1]);
+  ASSERT_EQ(40, served[2]);
+
+  queues.SetWeight(1, 4);
+  served.clear();
+  for (int i = 0; i < 40; i++) {
+    uint16_t handle;
+    int packet;
+    ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+    served[handle]++;
+  }
+  ASSERT_EQ(20, served[1]);
+  ASSERT_EQ(20, served[2]);
+}
+
+TEST(DeficitRoundRobinTest, audio_and_hid_go_first) {
+  DeficitRoundRobin<int> queues;
+  queues.AddLink(1, LatencyClass::BULK);
+  queues.AddLink(2, LatencyClass::HID);
+  queues.AddLink(3, LatencyClass::AUDIO);
+  queues.Push(1, 0, 100);
+  queues.Push(2, 0, 100);
+  queues.Push(3, 0, 2000);
+  queues.Push(2, 1, 100);
+
+  uint16_t handle;
+  int packet;
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(3, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(2, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(2, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(1, handle);
+}
+
+TEST(DeficitRoundRobinTest, ineligible_links_are_skipped) {
+  DeficitRoundRobin<int> queues;
+  queues.AddLink(1, LatencyClass::AUDIO);
+  queues.AddLink(2, LatencyClass::BULK);
+  queues.Push(1, 0, 100);
+  queues.Push(2, 0, 100);
+
+  auto not_audio = [](uint16_t handle) { return handle != 1; };
+  uint16_t handle;
+  int packet;
+  ASSERT_TRUE(queues.Pop(not_audio, &handle, &packet));
+  ASSERT_EQ(2, handle);
+  ASSERT_FALSE(queues.Pop(not_audio, &handle, &packet));
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(1, handle);
+}
+
+TEST(DeficitRoundRobinTest, remove_and_reclassify_links) {
+  DeficitRoundRobin<int> queues;
+  queues.AddLink(1, LatencyClass::BULK);
+  queues.AddLink(2, LatencyClass::BULK);
+  queues.AddLink(3, LatencyClass::BULK);
+  for (uint16_t link = 1; link <= 3; link++) {
+    queues.Push(link, link, 100);
+    queues.Push(link, link, 100);
+  }
+  queues.RemoveLink(2);
+  ASSERT_FALSE(queues.HasLink(2));
+  ASSERT_EQ(4u, queues.GetSize());
+
+  queues.SetLatencyClass(3, LatencyClass::AUDIO);
+  ASSERT_EQ(LatencyClass::AUDIO, queues.GetLatencyClass(3));
+  uint16_t handle;
+  int packet;
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(3, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(3, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(1, handle);
+  ASSERT_TRUE(queues.Pop(kAll, &handle, &packet));
+  ASSERT_EQ(1, handle);
+  ASSERT_FALSE(queues.Pop(kAll, &handle, &packet));
+}
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
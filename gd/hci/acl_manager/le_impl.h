@@ -18,8 +18,8 @@
 
 #include "common/bind.h"
 #include "crypto_toolbox/crypto_toolbox.h"
+#include "hci/acl_manager/acl_scheduler.h"
 #include "hci/acl_manager/assembler.h"
-#include "hci/acl_manager/round_robin_scheduler.h"
 #include "hci/le_address_manager.h"
 #include "os/alarm.h"
 #include "os/rand.h"
@@ -37,6 +37,9 @@ constexpr uint16_t kScanWindowFast = 0x0030;
 constexpr uint16_t kScanIntervalSlow = 0x0800;
 constexpr uint16_t kScanWindowSlow = 0x0030;
 constexpr std::chrono::milliseconds kCreateConnectionTimeoutMs = std::chrono::milliseconds(30 * 1000);
+constexpr uint8_t kPhyLe1M = 0x01;
+constexpr uint8_t kPhyLe2M = 0x02;
+constexpr uint8_t kPhyLeCoded = 0x04;
 
 struct le_acl_connection {
   le_acl_connection(AddressWithType remote_address, AclConnection::QueueDownEnd* queue_down_end, os::Handler* handler)
@@ -52,11 +55,11 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
       HciLayer* hci_layer,
       Controller* controller,
       os::Handler* handler,
-      RoundRobinScheduler* round_robin_scheduler,
+      AclScheduler* acl_scheduler,
       bool crash_on_unknown_handle)
       : hci_layer_(hci_layer),
         controller_(controller),
-        round_robin_scheduler_(round_robin_scheduler),
+        acl_scheduler_(acl_scheduler),
         crash_on_unknown_handle_(crash_on_unknown_handle) {
     hci_layer_ = hci_layer;
     controller_ = controller;
@@ -123,12 +126,13 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     if (callbacks == nullptr) {
       return;
     }
-    round_robin_scheduler_->Unregister(handle);
+    acl_scheduler_->Unregister(handle);
     callbacks->OnDisconnection(reason);
     le_acl_connections_.erase(handle);
   }
 
   void on_common_le_connection_complete(AddressWithType address_with_type) {
+    initiating_ = false;
     auto connecting_addr_with_type = connecting_le_.find(address_with_type);
     if (connecting_addr_with_type == connecting_le_.end()) {
       LOG_WARN("No prior connection request for %s", address_with_type.ToString().c_str());
@@ -188,7 +192,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
         std::forward_as_tuple(remote_address, queue->GetDownEnd(), handler_));
     ASSERT(emplace_pair.second);  // Make sure the connection is unique
     auto& connection_proxy = emplace_pair.first->second;
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::LE, handle, queue);
     std::unique_ptr<LeAclConnection> connection(new LeAclConnection(
         std::move(queue), le_acl_connection_interface_, handle, local_address, remote_address, role));
     connection_proxy.le_connection_management_callbacks_ = connection->GetEventCallbacks();
@@ -254,7 +258,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
         std::forward_as_tuple(remote_address, queue->GetDownEnd(), handler_));
     ASSERT(emplace_pair.second);  // Make sure it's not a duplicate
     auto& connection_proxy = emplace_pair.first->second;
-    round_robin_scheduler_->Register(RoundRobinScheduler::ConnectionType::LE, handle, queue);
+    acl_scheduler_->Register(AclScheduler::ConnectionType::LE, handle, queue);
     std::unique_ptr<LeAclConnection> connection(new LeAclConnection(
         std::move(queue), le_acl_connection_interface_, handle, local_address, remote_address, role));
     connection_proxy.le_connection_management_callbacks_ = connection->GetEventCallbacks();
@@ -364,22 +368,22 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   }
 
   void add_device_to_connect_list(AddressWithType address_with_type) {
-    AddressType address_type = address_with_type.GetAddressType();
     if (!address_manager_registered) {
       le_address_manager_->Register(this);
       address_manager_registered = true;
     }
-    pause_connection = true;
-    switch (address_type) {
-      case AddressType::PUBLIC_DEVICE_ADDRESS:
-      case AddressType::PUBLIC_IDENTITY_ADDRESS: {
-        le_address_manager_->AddDeviceToConnectList(ConnectListAddressType::PUBLIC, address_with_type.GetAddress());
-      } break;
-      case AddressType::RANDOM_DEVICE_ADDRESS:
-      case AddressType::RANDOM_IDENTITY_ADDRESS: {
-        le_address_manager_->AddDeviceToConnectList(ConnectListAddressType::RANDOM, address_with_type.GetAddress());
-      }
+    if (!connect_list_.insert(connect_list_entry(address_with_type)).second) {
+      // Already in the controller list, no command to wait for
+      return;
     }
+    pause_connection = true;
+    update_connect_list();
+  }
+
+  // The address manager sends the difference with what the controller list holds
+  void update_connect_list() {
+    le_address_manager_->SetConnectList(
+        std::vector<LeAddressManager::ConnectListEntry>(connect_list_.begin(), connect_list_.end()));
   }
 
   void add_device_to_resolving_list(
@@ -406,10 +410,36 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     }
   }
 
+  LeAddressManager::ConnectListEntry connect_list_entry(AddressWithType address_with_type) {
+    switch (address_with_type.GetAddressType()) {
+      case AddressType::RANDOM_DEVICE_ADDRESS:
+      case AddressType::RANDOM_IDENTITY_ADDRESS:
+        return {ConnectListAddressType::RANDOM, address_with_type.GetAddress()};
+      default:
+        return {ConnectListAddressType::PUBLIC, address_with_type.GetAddress()};
+    }
+  }
+
+  // Direct connections scan fast, background ones slow. The initiator serves all of its targets with the fastest
+  // parameters any of them needs.
+  bool initiator_needs_fast_scan() const {
+    return !direct_connections_.empty();
+  }
+
+  // The controller doesn't allow editing the connect list while initiating from it, so a new target costs a cancel
+  // and a new create connection command, unless the running initiator already looks for it with fitting parameters.
+  bool initiator_covers(AddressWithType address_with_type, bool is_direct) {
+    return initiating_ && !pause_connection && connect_list_.count(connect_list_entry(address_with_type)) != 0 &&
+           (!is_direct || initiating_fast_);
+  }
+
   void create_le_connection(AddressWithType address_with_type, bool add_to_connect_list, bool is_direct) {
     // TODO: Configure default LE connection parameters?
     if (add_to_connect_list) {
-      add_device_to_connect_list(address_with_type);
+      bool covered = initiator_covers(address_with_type, is_direct);
+      if (!covered) {
+        add_device_to_connect_list(address_with_type);
+      }
       if (is_direct) {
         direct_connections_.insert(address_with_type);
         if (create_connection_timeout_alarms_.find(address_with_type) == create_connection_timeout_alarms_.end()) {
@@ -423,6 +453,10 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
                   kCreateConnectionTimeoutMs);
         }
       }
+      if (covered) {
+        connecting_le_.insert(address_with_type);
+        return;
+      }
     }
 
     if (!address_manager_registered) {
@@ -448,7 +482,8 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     uint16_t le_scan_interval = kScanIntervalSlow;
     uint16_t le_scan_window = kScanWindowSlow;
     // If there is any direct connection in the connection list, use the fast parameter
-    if (!direct_connections_.empty()) {
+    bool fast_scan = initiator_needs_fast_scan();
+    if (fast_scan) {
       le_scan_interval = kScanIntervalFast;
       le_scan_window = kScanWindowFast;
     }
@@ -462,6 +497,8 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
     ASSERT(check_connection_parameters(conn_interval_min, conn_interval_max, conn_latency, supervision_timeout));
 
     connecting_le_.insert(address_with_type);
+    initiating_ = true;
+    initiating_fast_ = fast_scan;
 
     if (initiator_filter_policy == InitiatorFilterPolicy::USE_CONNECT_LIST) {
       address_with_type = AddressWithType();
@@ -478,10 +515,23 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
       tmp.min_ce_length_ = 0x00;
       tmp.max_ce_length_ = 0x00;
 
+      // One entry per initiating PHY, in PHY order. The controller alternates scanning on 1M and coded PHYs, the 2M
+      // entry only sets the connection parameters of a connection established there.
+      uint8_t initiating_phys = kPhyLe1M;
+      std::vector<LeCreateConnPhyScanParameters> phy_scan_parameters = {tmp};
+      if (controller_->SupportsBle2mPhy()) {
+        initiating_phys |= kPhyLe2M;
+        phy_scan_parameters.push_back(tmp);
+      }
+      if (controller_->SupportsBleCodedPhy()) {
+        initiating_phys |= kPhyLeCoded;
+        phy_scan_parameters.push_back(tmp);
+      }
+
       le_acl_connection_interface_->EnqueueCommand(
           LeExtendedCreateConnectionBuilder::Create(initiator_filter_policy, own_address_type,
                                                     address_with_type.GetAddressType(), address_with_type.GetAddress(),
-                                                    0x01 /* 1M PHY ONLY */, {tmp}),
+                                                    initiating_phys, phy_scan_parameters),
           handler_->BindOnce([](CommandStatusView status) {
             ASSERT(status.IsValid());
             ASSERT(status.GetCommandOpCode() == OpCode::LE_EXTENDED_CREATE_CONNECTION);
@@ -520,25 +570,17 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   }
 
   void remove_device_from_connect_list(AddressWithType address_with_type) {
-    AddressType address_type = address_with_type.GetAddressType();
     direct_connections_.erase(address_with_type);
+    if (connect_list_.erase(connect_list_entry(address_with_type)) == 0) {
+      // Not a target of the initiator, which can keep running
+      return;
+    }
     if (!address_manager_registered) {
       le_address_manager_->Register(this);
       address_manager_registered = true;
     }
     pause_connection = true;
-    switch (address_type) {
-      case AddressType::PUBLIC_DEVICE_ADDRESS:
-      case AddressType::PUBLIC_IDENTITY_ADDRESS: {
-        le_address_manager_->RemoveDeviceFromConnectList(
-            ConnectListAddressType::PUBLIC, address_with_type.GetAddress());
-      } break;
-      case AddressType::RANDOM_DEVICE_ADDRESS:
-      case AddressType::RANDOM_IDENTITY_ADDRESS: {
-        le_address_manager_->RemoveDeviceFromConnectList(
-            ConnectListAddressType::RANDOM, address_with_type.GetAddress());
-      }
-    }
+    update_connect_list();
   }
 
   void remove_device_from_resolving_list(AddressWithType address_with_type) {
@@ -626,6 +668,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
       return;
     }
     canceled_connections_ = connecting_le_;
+    initiating_ = false;
     le_acl_connection_interface_->EnqueueCommand(
         LeCreateConnectionCancelBuilder::Create(),
         handler_->BindOnce(&le_impl::on_create_connection_cancel_complete, common::Unretained(this)));
@@ -686,7 +729,7 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   HciLayer* hci_layer_ = nullptr;
   Controller* controller_ = nullptr;
   os::Handler* handler_ = nullptr;
-  RoundRobinScheduler* round_robin_scheduler_ = nullptr;
+  AclScheduler* acl_scheduler_ = nullptr;
   LeAddressManager* le_address_manager_ = nullptr;
   LeAclConnectionInterface* le_acl_connection_interface_ = nullptr;
   LeConnectionCallbacks* le_client_callbacks_ = nullptr;
@@ -695,6 +738,10 @@ struct le_impl : public bluetooth::hci::LeAddressManagerCallback {
   std::set<AddressWithType> connecting_le_;
   std::set<AddressWithType> canceled_connections_;
   std::set<AddressWithType> direct_connections_;
+  // Targets of the initiator, as written to the controller connect list
+  std::set<LeAddressManager::ConnectListEntry> connect_list_;
+  bool initiating_ = false;       // a create connection command is pending
+  bool initiating_fast_ = false;  // and it uses the fast scan parameters
   bool address_manager_registered = false;
   bool ready_to_unregister = false;
   bool pause_connection = false;
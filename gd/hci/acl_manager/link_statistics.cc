@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/link_statistics.h"
+
+#include <algorithm>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+namespace {
+
+uint64_t ElapsedUs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+}  // namespace
+
+void LinkStatistics::AddLink(uint16_t handle, AclScheduler::ConnectionType connection_type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Link& link = links_[handle];
+  link = Link();
+  link.stats.handle = handle;
+  link.stats.connection_type = connection_type;
+}
+
+void LinkStatistics::RemoveLink(uint16_t handle) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  links_.erase(handle);
+}
+
+void LinkStatistics::OnPacketBuffered(uint16_t handle, size_t num_fragments) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    return;
+  }
+  LinkStats& stats = link->second.stats;
+  stats.tx_packets++;
+  stats.queue_depth += num_fragments;
+  stats.max_queue_depth = std::max(stats.max_queue_depth, stats.queue_depth);
+}
+
+void LinkStatistics::OnFragmentSent(uint16_t handle, size_t size, std::chrono::steady_clock::time_point buffered) {
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    return;
+  }
+  LinkStats& stats = link->second.stats;
+  stats.tx_fragments++;
+  stats.tx_bytes += size;
+  if (stats.queue_depth > 0) {
+    stats.queue_depth--;
+  }
+  stats.credit_wait.Record(ElapsedUs(buffered, now));
+  link->second.sent.push_back(now);
+  stats.unacknowledged_fragments = link->second.sent.size();
+}
+
+void LinkStatistics::OnFragmentsCompleted(uint16_t handle, uint16_t count) {
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    return;
+  }
+  auto& sent = link->second.sent;
+  if (count > sent.size()) {
+    LOG_WARN("handle 0x%hx completed %hu fragments, only %zu were sent", handle, count, sent.size());
+    count = sent.size();
+  }
+  for (uint16_t i = 0; i < count; i++) {
+    link->second.stats.completion_time.Record(ElapsedUs(sent.front(), now));
+    sent.pop_front();
+  }
+  link->second.stats.unacknowledged_fragments = sent.size();
+}
+
+void LinkStatistics::OnFragmentReceived(uint16_t handle, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    return;
+  }
+  link->second.stats.rx_fragments++;
+  link->second.stats.rx_bytes += size;
+}
+
+std::vector<LinkStatistics::LinkStats> LinkStatistics::GetSnapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<LinkStats> snapshot;
+  snapshot.reserve(links_.size());
+  for (const auto& link : links_) {
+    snapshot.push_back(link.second.stats);
+  }
+  return snapshot;
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "common/task_latency_stats.h"
+#include "hci/acl_manager/acl_scheduler.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Per connection handle counters of the ACL data path, to find the links which hold the controller buffers.
+// The scheduler reports the outgoing fragments, the AclManager the incoming ones, and dumpsys reads a snapshot from
+// another thread, hence the lock, which is never contended on the data path.
+class LinkStatistics {
+ public:
+  using Histogram = common::TaskLatencyStats::Histogram;
+
+  struct LinkStats {
+    uint16_t handle = 0;
+    AclScheduler::ConnectionType connection_type = AclScheduler::ConnectionType::CLASSIC;
+    // Packets taken off the connection queue, and the fragments they were split in
+    uint64_t tx_packets = 0;
+    uint64_t tx_fragments = 0;
+    uint64_t tx_bytes = 0;
+    uint64_t rx_fragments = 0;
+    uint64_t rx_bytes = 0;
+    // Fragments buffered by the scheduler and not sent yet
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    // Fragments sent whose Number Of Completed Packets is pending
+    size_t unacknowledged_fragments = 0;
+    // From buffering a fragment until it is handed to the HCI layer, mostly waiting for controller credits
+    Histogram credit_wait;
+    // From handing a fragment to the HCI layer until the controller reports it completed
+    Histogram completion_time;
+  };
+
+  void AddLink(uint16_t handle, AclScheduler::ConnectionType connection_type);
+  void RemoveLink(uint16_t handle);
+
+  // A packet taken off the connection queue was split in |num_fragments| fragments
+  void OnPacketBuffered(uint16_t handle, size_t num_fragments);
+  // A fragment of |size| bytes, buffered at |buffered|, was handed to the HCI layer
+  void OnFragmentSent(uint16_t handle, size_t size, std::chrono::steady_clock::time_point buffered);
+  // The controller reported |count| fragments completed, the oldest are assumed
+  void OnFragmentsCompleted(uint16_t handle, uint16_t count);
+  void OnFragmentReceived(uint16_t handle, size_t size);
+
+  // Ordered by handle
+  std::vector<LinkStats> GetSnapshot() const;
+
+ private:
+  struct Link {
+    LinkStats stats;
+    // Send times of the unacknowledged fragments, oldest first
+    std::deque<std::chrono::steady_clock::time_point> sent;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<uint16_t, Link> links_;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
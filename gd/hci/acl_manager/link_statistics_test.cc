@@ -0,0 +1,116 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/link_statistics.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+namespace {
+
+constexpr uint16_t kHandle = 0x123;
+constexpr uint16_t kLeHandle = 0x41;
+
+TEST(LinkStatisticsTest, counts_fragments) {
+  LinkStatistics statistics;
+  statistics.AddLink(kHandle, AclScheduler::ConnectionType::CLASSIC);
+  statistics.OnPacketBuffered(kHandle, 3);
+  auto buffered = std::chrono::steady_clock::now();
+  statistics.OnFragmentSent(kHandle, 1021, buffered);
+  statistics.OnFragmentSent(kHandle, 1021, buffered);
+  statistics.OnFragmentReceived(kHandle, 27);
+
+  auto snapshot = statistics.GetSnapshot();
+  ASSERT_EQ(1u, snapshot.size());
+  const auto& stats = snapshot[0];
+  ASSERT_EQ(kHandle, stats.handle);
+  ASSERT_EQ(AclScheduler::ConnectionType::CLASSIC, stats.connection_type);
+  ASSERT_EQ(1u, stats.tx_packets);
+  ASSERT_EQ(2u, stats.tx_fragments);
+  ASSERT_EQ(2042u, stats.tx_bytes);
+  ASSERT_EQ(1u, stats.rx_fragments);
+  ASSERT_EQ(27u, stats.rx_bytes);
+  ASSERT_EQ(1u, stats.queue_depth);
+  ASSERT_EQ(3u, stats.max_queue_depth);
+  ASSERT_EQ(2u, stats.unacknowledged_fragments);
+  ASSERT_EQ(2u, stats.credit_wait.count);
+  ASSERT_EQ(0u, stats.completion_time.count);
+}
+
+TEST(LinkStatisticsTest, completed_fragments) {
+  LinkStatistics statistics;
+  statistics.AddLink(kHandle, AclScheduler::ConnectionType::CLASSIC);
+  statistics.OnPacketBuffered(kHandle, 2);
+  auto buffered = std::chrono::steady_clock::now();
+  statistics.OnFragmentSent(kHandle, 10, buffered);
+  statistics.OnFragmentSent(kHandle, 10, buffered);
+
+  statistics.OnFragmentsCompleted(kHandle, 1);
+  auto stats = statistics.GetSnapshot()[0];
+  ASSERT_EQ(1u, stats.unacknowledged_fragments);
+  ASSERT_EQ(1u, stats.completion_time.count);
+
+  // More completions than sent fragments are ignored
+  statistics.OnFragmentsCompleted(kHandle, 5);
+  stats = statistics.GetSnapshot()[0];
+  ASSERT_EQ(0u, stats.unacknowledged_fragments);
+  ASSERT_EQ(2u, stats.completion_time.count);
+}
+
+TEST(LinkStatisticsTest, unknown_handles_are_ignored) {
+  LinkStatistics statistics;
+  statistics.OnPacketBuffered(kHandle, 1);
+  statistics.OnFragmentSent(kHandle, 10, std::chrono::steady_clock::now());
+  statistics.OnFragmentsCompleted(kHandle, 1);
+  statistics.OnFragmentReceived(kHandle, 10);
+  ASSERT_TRUE(statistics.GetSnapshot().empty());
+}
+
+TEST(LinkStatisticsTest, links_are_ordered_and_removed) {
+  LinkStatistics statistics;
+  statistics.AddLink(kHandle, AclScheduler::ConnectionType::CLASSIC);
+  statistics.AddLink(kLeHandle, AclScheduler::ConnectionType::LE);
+  auto snapshot = statistics.GetSnapshot();
+  ASSERT_EQ(2u, snapshot.size());
+  ASSERT_EQ(kLeHandle, snapshot[0].handle);
+  ASSERT_EQ(AclScheduler::ConnectionType::LE, snapshot[0].connection_type);
+  ASSERT_EQ(kHandle, snapshot[1].handle);
+
+  statistics.RemoveLink(kLeHandle);
+  snapshot = statistics.GetSnapshot();
+  ASSERT_EQ(1u, snapshot.size());
+  ASSERT_EQ(kHandle, snapshot[0].handle);
+}
+
+TEST(LinkStatisticsTest, handle_reuse_resets_counters) {
+  LinkStatistics statistics;
+  statistics.AddLink(kHandle, AclScheduler::ConnectionType::CLASSIC);
+  statistics.OnFragmentReceived(kHandle, 10);
+  statistics.RemoveLink(kHandle);
+  statistics.AddLink(kHandle, AclScheduler::ConnectionType::LE);
+  auto stats = statistics.GetSnapshot()[0];
+  ASSERT_EQ(AclScheduler::ConnectionType::LE, stats.connection_type);
+  ASSERT_EQ(0u, stats.rx_fragments);
+}
+
+}  // namespace
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -22,8 +22,11 @@ namespace hci {
 namespace acl_manager {
 
 RoundRobinScheduler::RoundRobinScheduler(
-    os::Handler* handler, Controller* controller, common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end)
-    : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end) {
+    os::Handler* handler,
+    Controller* controller,
+    common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end,
+    LinkStatistics* link_statistics)
+    : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end), link_statistics_(link_statistics) {
   max_acl_packet_credits_ = controller_->GetNumAclPacketBuffers();
   acl_packet_credits_ = max_acl_packet_credits_;
   hci_mtu_ = controller_->GetAclPacketLength();
@@ -43,6 +46,9 @@ void RoundRobinScheduler::Register(ConnectionType connection_type, uint16_t hand
                                    std::shared_ptr<acl_manager::AclConnection::Queue> queue) {
   acl_queue_handler acl_queue_handler = {connection_type, std::move(queue), false, 0};
   acl_queue_handlers_.insert(std::pair<uint16_t, RoundRobinScheduler::acl_queue_handler>(handle, acl_queue_handler));
+  if (link_statistics_ != nullptr) {
+    link_statistics_->AddLink(handle, connection_type);
+  }
   if (fragments_to_send_.size() == 0) {
     start_round_robin();
   }
@@ -64,6 +70,9 @@ void RoundRobinScheduler::Unregister(uint16_t handle) {
     acl_queue_handler.queue_->GetDownEnd()->UnregisterDequeue();
   }
   acl_queue_handlers_.erase(handle);
+  if (link_statistics_ != nullptr) {
+    link_statistics_->RemoveLink(handle);
+  }
   starting_point_ = acl_queue_handlers_.begin();
 }
 
@@ -89,7 +98,7 @@ void RoundRobinScheduler::start_round_robin() {
     return;
   }
   if (!fragments_to_send_.empty()) {
-    auto connection_type = fragments_to_send_.front().first;
+    auto connection_type = fragments_to_send_.front().connection_type;
     bool classic_buffer_full = acl_packet_credits_ == 0 && connection_type == ConnectionType::CLASSIC;
     bool le_buffer_full = le_acl_packet_credits_ == 0 && connection_type == ConnectionType::LE;
     if (classic_buffer_full || le_buffer_full) {
@@ -143,21 +152,33 @@ void RoundRobinScheduler::buffer_packet(std::map<uint16_t, acl_queue_handler>::i
                                                 : PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE;
 
   int acl_priority = acl_queue_handler->second.high_priority_ ? 1 : 0;
+  auto buffered = std::chrono::steady_clock::now();
   if (packet->size() <= mtu) {
     fragments_to_send_.push(
-        std::make_pair(
-            connection_type, AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet))),
+        Fragment{
+            connection_type,
+            handle,
+            buffered,
+            AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet))},
         acl_priority);
+    if (link_statistics_ != nullptr) {
+      link_statistics_->OnPacketBuffered(handle, 1);
+    }
   } else {
     auto fragments = AclFragmenter(mtu, std::move(packet)).GetFragments();
     for (size_t i = 0; i < fragments.size(); i++) {
       fragments_to_send_.push(
-          std::make_pair(
+          Fragment{
               connection_type,
-              AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i]))),
+              handle,
+              buffered,
+              AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i]))},
           acl_priority);
       packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
     }
+    if (link_statistics_ != nullptr) {
+      link_statistics_->OnPacketBuffered(handle, fragments.size());
+    }
   }
   ASSERT(fragments_to_send_.size() > 0);
   unregister_all_connections();
@@ -185,7 +206,7 @@ void RoundRobinScheduler::send_next_fragment() {
 
 // Invoked from some external Queue Reactable context 1
 std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment() {
-  ConnectionType connection_type = fragments_to_send_.front().first;
+  ConnectionType connection_type = fragments_to_send_.front().connection_type;
   if (connection_type == ConnectionType::CLASSIC) {
     ASSERT(acl_packet_credits_ > 0);
     acl_packet_credits_ -= 1;
@@ -194,7 +215,11 @@ std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment()
     le_acl_packet_credits_ -= 1;
   }
 
-  auto raw_pointer = fragments_to_send_.front().second.release();
+  auto& fragment = fragments_to_send_.front();
+  if (link_statistics_ != nullptr) {
+    link_statistics_->OnFragmentSent(fragment.handle, fragment.packet->size(), fragment.buffered);
+  }
+  auto raw_pointer = fragment.packet.release();
   fragments_to_send_.pop();
   if (fragments_to_send_.empty()) {
     if (enqueue_registered_.exchange(false)) {
@@ -202,7 +227,7 @@ std::unique_ptr<AclBuilder> RoundRobinScheduler::handle_enqueue_next_fragment()
     }
     handler_->Post(common::BindOnce(&RoundRobinScheduler::start_round_robin, common::Unretained(this)));
   } else {
-    ConnectionType next_connection_type = fragments_to_send_.front().first;
+    ConnectionType next_connection_type = fragments_to_send_.front().connection_type;
     bool classic_buffer_full = next_connection_type == ConnectionType::CLASSIC && acl_packet_credits_ == 0;
     bool le_buffer_full = next_connection_type == ConnectionType::LE && le_acl_packet_credits_ == 0;
     if ((classic_buffer_full || le_buffer_full) && enqueue_registered_.exchange(false)) {
@@ -218,6 +243,9 @@ void RoundRobinScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits
     LOG_INFO("Dropping %hx received credits to unknown connection 0x%0hx", credits, handle);
     return;
   }
+  if (link_statistics_ != nullptr) {
+    link_statistics_->OnFragmentsCompleted(handle, credits);
+  }
 
   if (acl_queue_handler->second.number_of_sent_packets_ >= credits) {
     acl_queue_handler->second.number_of_sent_packets_ -= credits;
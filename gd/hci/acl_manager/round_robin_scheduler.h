@@ -18,9 +18,13 @@
 
 #include <stdint.h>
 
+#include <chrono>
+
 #include "common/bidi_queue.h"
 #include "common/multi_priority_queue.h"
 #include "hci/acl_manager.h"
+#include "hci/acl_manager/acl_scheduler.h"
+#include "hci/acl_manager/link_statistics.h"
 #include "hci/controller.h"
 #include "hci/hci_packets.h"
 #include "os/handler.h"
@@ -29,13 +33,15 @@ namespace bluetooth {
 namespace hci {
 namespace acl_manager {
 
-class RoundRobinScheduler {
+class RoundRobinScheduler : public AclScheduler {
  public:
+  // |link_statistics|, when given, must outlive the scheduler
   RoundRobinScheduler(
-      os::Handler* handler, Controller* controller, common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end);
-  ~RoundRobinScheduler();
-
-  enum ConnectionType { CLASSIC, LE };
+      os::Handler* handler,
+      Controller* controller,
+      common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end,
+      LinkStatistics* link_statistics = nullptr);
+  ~RoundRobinScheduler() override;
 
   struct acl_queue_handler {
     ConnectionType connection_type_;
@@ -46,13 +52,20 @@ class RoundRobinScheduler {
   };
 
   void Register(ConnectionType connection_type, uint16_t handle,
-                std::shared_ptr<acl_manager::AclConnection::Queue> queue);
-  void Unregister(uint16_t handle);
-  void SetLinkPriority(uint16_t handle, bool high_priority);
-  uint16_t GetCredits();
-  uint16_t GetLeCredits();
+                std::shared_ptr<acl_manager::AclConnection::Queue> queue) override;
+  void Unregister(uint16_t handle) override;
+  void SetLinkPriority(uint16_t handle, bool high_priority) override;
+  uint16_t GetCredits() override;
+  uint16_t GetLeCredits() override;
 
  private:
+  struct Fragment {
+    ConnectionType connection_type;
+    uint16_t handle;
+    std::chrono::steady_clock::time_point buffered;
+    std::unique_ptr<AclBuilder> packet;
+  };
+
   void start_round_robin();
   void buffer_packet(std::map<uint16_t, acl_queue_handler>::iterator acl_queue_handler);
   void unregister_all_connections();
@@ -63,7 +76,7 @@ class RoundRobinScheduler {
   os::Handler* handler_ = nullptr;
   Controller* controller_ = nullptr;
   std::map<uint16_t, acl_queue_handler> acl_queue_handlers_;
-  common::MultiPriorityQueue<std::pair<ConnectionType, std::unique_ptr<AclBuilder>>, 2> fragments_to_send_;
+  common::MultiPriorityQueue<Fragment, 2> fragments_to_send_;
   uint16_t max_acl_packet_credits_ = 0;
   uint16_t acl_packet_credits_ = 0;
   uint16_t le_max_acl_packet_credits_ = 0;
@@ -72,6 +85,7 @@ class RoundRobinScheduler {
   size_t le_hci_mtu_{0};
   std::atomic_bool enqueue_registered_ = false;
   common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
+  LinkStatistics* link_statistics_ = nullptr;
   // first register queue end for the Round-robin schedule
   std::map<uint16_t, acl_queue_handler>::iterator starting_point_;
 };
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/weighted_fair_scheduler.h"
+
+#include <algorithm>
+
+#include "hci/acl_manager/acl_fragmenter.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+WeightedFairScheduler::WeightedFairScheduler(
+    os::Handler* handler,
+    Controller* controller,
+    common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end,
+    LinkStatistics* link_statistics)
+    : handler_(handler), controller_(controller), hci_queue_end_(hci_queue_end), link_statistics_(link_statistics) {
+  max_acl_packet_credits_ = controller_->GetNumAclPacketBuffers();
+  acl_packet_credits_ = max_acl_packet_credits_;
+  hci_mtu_ = controller_->GetAclPacketLength();
+  LeBufferSize le_buffer_size = controller_->GetLeBufferSize();
+  le_max_acl_packet_credits_ = le_buffer_size.total_num_le_packets_;
+  le_acl_packet_credits_ = le_max_acl_packet_credits_;
+  le_hci_mtu_ = le_buffer_size.le_data_packet_length_;
+  controller_->RegisterCompletedAclPacketsCallback(
+      handler->BindOn(this, &WeightedFairScheduler::incoming_acl_credits));
+}
+
+WeightedFairScheduler::~WeightedFairScheduler() {
+  for (auto& link : links_) {
+    unregister_dequeue(link.second);
+  }
+  if (enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  controller_->UnregisterCompletedAclPacketsCallback();
+}
+
+void WeightedFairScheduler::Register(
+    ConnectionType connection_type, uint16_t handle, std::shared_ptr<acl_manager::AclConnection::Queue> queue) {
+  ASSERT_LOG(links_.count(handle) == 0, "handle 0x%hx is already registered", handle);
+  Link& link = links_[handle];
+  link.connection_type = connection_type;
+  link.queue = std::move(queue);
+  fragments_.AddLink(handle, default_latency_class(connection_type));
+  if (link_statistics_ != nullptr) {
+    link_statistics_->AddLink(handle, connection_type);
+  }
+  register_dequeue(handle, link);
+}
+
+void WeightedFairScheduler::Unregister(uint16_t handle) {
+  auto link = links_.find(handle);
+  ASSERT(link != links_.end());
+  // Reclaim outstanding packets
+  if (link->second.connection_type == ConnectionType::CLASSIC) {
+    acl_packet_credits_ += link->second.number_of_sent_packets;
+  } else {
+    le_acl_packet_credits_ += link->second.number_of_sent_packets;
+  }
+  unregister_dequeue(link->second);
+  fragments_.RemoveLink(handle);
+  links_.erase(link);
+  if (link_statistics_ != nullptr) {
+    link_statistics_->RemoveLink(handle);
+  }
+
+  auto eligible = [this](uint16_t link_handle) { return has_credits(link_handle); };
+  if (!fragments_.HasPacket(eligible) && enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  // Reclaimed credits may let other links go
+  send_next_fragment();
+}
+
+void WeightedFairScheduler::SetLinkPriority(uint16_t handle, bool high_priority) {
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    LOG_WARN("handle %d is invalid", handle);
+    return;
+  }
+  fragments_.SetLatencyClass(
+      handle, high_priority ? LatencyClass::AUDIO : default_latency_class(link->second.connection_type));
+}
+
+uint16_t WeightedFairScheduler::GetCredits() {
+  return acl_packet_credits_;
+}
+
+uint16_t WeightedFairScheduler::GetLeCredits() {
+  return le_acl_packet_credits_;
+}
+
+void WeightedFairScheduler::SetLatencyClass(uint16_t handle, LatencyClass latency_class) {
+  if (links_.count(handle) == 0) {
+    LOG_WARN("handle %d is invalid", handle);
+    return;
+  }
+  fragments_.SetLatencyClass(handle, latency_class);
+}
+
+void WeightedFairScheduler::SetLinkWeight(uint16_t handle, uint16_t weight) {
+  if (links_.count(handle) == 0) {
+    LOG_WARN("handle %d is invalid", handle);
+    return;
+  }
+  fragments_.SetWeight(handle, weight);
+}
+
+WeightedFairScheduler::LinkStats WeightedFairScheduler::GetLinkStats(uint16_t handle) const {
+  LinkStats stats;
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    LOG_WARN("handle %d is invalid", handle);
+    return stats;
+  }
+  stats.queue_depth = fragments_.GetQueueDepth(handle);
+  stats.packets_sent = link->second.packets_sent;
+  if (link->second.packets_sent > 0) {
+    stats.average_service_time = link->second.total_service_time / link->second.packets_sent;
+  }
+  stats.max_service_time = link->second.max_service_time;
+  return stats;
+}
+
+LatencyClass WeightedFairScheduler::default_latency_class(ConnectionType connection_type) {
+  return connection_type == ConnectionType::CLASSIC ? LatencyClass::BULK : LatencyClass::GATT;
+}
+
+bool WeightedFairScheduler::has_credits(uint16_t handle) const {
+  auto link = links_.find(handle);
+  ASSERT(link != links_.end());
+  if (link->second.connection_type == ConnectionType::CLASSIC) {
+    return acl_packet_credits_ > 0;
+  }
+  return le_acl_packet_credits_ > 0;
+}
+
+void WeightedFairScheduler::register_dequeue(uint16_t handle, Link& link) {
+  if (link.dequeue_is_registered || link.pending_packets >= kMaxPendingPackets) {
+    return;
+  }
+  link.dequeue_is_registered = true;
+  link.queue->GetDownEnd()->RegisterDequeue(
+      handler_, common::Bind(&WeightedFairScheduler::dequeue_packet, common::Unretained(this), handle));
+}
+
+void WeightedFairScheduler::unregister_dequeue(Link& link) {
+  if (link.dequeue_is_registered) {
+    link.dequeue_is_registered = false;
+    link.queue->GetDownEnd()->UnregisterDequeue();
+  }
+}
+
+void WeightedFairScheduler::dequeue_packet(uint16_t handle) {
+  auto& link = links_.find(handle)->second;
+  auto packet = link.queue->GetDownEnd()->TryDequeue();
+  ASSERT(packet != nullptr);
+  auto dequeued = std::chrono::steady_clock::now();
+
+  BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
+  size_t mtu = link.connection_type == ConnectionType::CLASSIC ? hci_mtu_ : le_hci_mtu_;
+  PacketBoundaryFlag packet_boundary_flag = (packet->IsFlushable())
+                                                ? PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE
+                                                : PacketBoundaryFlag::FIRST_NON_AUTOMATICALLY_FLUSHABLE;
+  if (packet->size() <= mtu) {
+    auto fragment = AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(packet));
+    size_t size = fragment->size();
+    fragments_.Push(handle, Fragment{std::move(fragment), dequeued, true}, size);
+    if (link_statistics_ != nullptr) {
+      link_statistics_->OnPacketBuffered(handle, 1);
+    }
+  } else {
+    auto fragments = AclFragmenter(mtu, std::move(packet)).GetFragments();
+    for (size_t i = 0; i < fragments.size(); i++) {
+      auto fragment = AclBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i]));
+      size_t size = fragment->size();
+      fragments_.Push(handle, Fragment{std::move(fragment), dequeued, i + 1 == fragments.size()}, size);
+      packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
+    }
+    if (link_statistics_ != nullptr) {
+      link_statistics_->OnPacketBuffered(handle, fragments.size());
+    }
+  }
+
+  link.pending_packets++;
+  if (link.pending_packets >= kMaxPendingPackets) {
+    unregister_dequeue(link);
+  }
+  send_next_fragment();
+}
+
+void WeightedFairScheduler::send_next_fragment() {
+  if (!fragments_.HasPacket([this](uint16_t handle) { return has_credits(handle); })) {
+    return;
+  }
+  if (!enqueue_registered_.exchange(true)) {
+    hci_queue_end_->RegisterEnqueue(
+        handler_, common::Bind(&WeightedFairScheduler::handle_enqueue_next_fragment, common::Unretained(this)));
+  }
+}
+
+// Invoked from some external Queue Reactable context
+std::unique_ptr<AclBuilder> WeightedFairScheduler::handle_enqueue_next_fragment() {
+  auto eligible = [this](uint16_t handle) { return has_credits(handle); };
+  uint16_t handle;
+  Fragment fragment;
+  bool popped = fragments_.Pop(eligible, &handle, &fragment);
+  ASSERT(popped);
+
+  auto& link = links_.find(handle)->second;
+  if (link.connection_type == ConnectionType::CLASSIC) {
+    ASSERT(acl_packet_credits_ > 0);
+    acl_packet_credits_ -= 1;
+  } else {
+    ASSERT(le_acl_packet_credits_ > 0);
+    le_acl_packet_credits_ -= 1;
+  }
+  link.number_of_sent_packets++;
+  if (link_statistics_ != nullptr) {
+    link_statistics_->OnFragmentSent(handle, fragment.packet->size(), fragment.dequeued);
+  }
+
+  if (fragment.last) {
+    auto service_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - fragment.dequeued);
+    link.packets_sent++;
+    link.total_service_time += service_time;
+    link.max_service_time = std::max(link.max_service_time, service_time);
+    link.pending_packets--;
+    register_dequeue(handle, link);
+  }
+
+  if (!fragments_.HasPacket(eligible) && enqueue_registered_.exchange(false)) {
+    hci_queue_end_->UnregisterEnqueue();
+  }
+  return std::move(fragment.packet);
+}
+
+void WeightedFairScheduler::incoming_acl_credits(uint16_t handle, uint16_t credits) {
+  auto link = links_.find(handle);
+  if (link == links_.end()) {
+    LOG_INFO("Dropping %hx received credits to unknown connection 0x%0hx", credits, handle);
+    return;
+  }
+  if (link_statistics_ != nullptr) {
+    link_statistics_->OnFragmentsCompleted(handle, credits);
+  }
+
+  if (link->second.number_of_sent_packets >= credits) {
+    link->second.number_of_sent_packets -= credits;
+  } else {
+    LOG_WARN("receive more credits than we sent");
+    link->second.number_of_sent_packets = 0;
+  }
+
+  if (link->second.connection_type == ConnectionType::CLASSIC) {
+    acl_packet_credits_ += credits;
+    if (acl_packet_credits_ > max_acl_packet_credits_) {
+      acl_packet_credits_ = max_acl_packet_credits_;
+      LOG_WARN("acl packet credits overflow due to receive %hx credits", credits);
+    }
+  } else {
+    le_acl_packet_credits_ += credits;
+    if (le_acl_packet_credits_ > le_max_acl_packet_credits_) {
+      le_acl_packet_credits_ = le_max_acl_packet_credits_;
+      LOG_WARN("le acl packet credits overflow due to receive %hx credits", credits);
+    }
+  }
+  send_next_fragment();
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include "common/bidi_queue.h"
+#include "hci/acl_manager.h"
+#include "hci/acl_manager/acl_scheduler.h"
+#include "hci/acl_manager/deficit_round_robin.h"
+#include "hci/acl_manager/link_statistics.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+// Serves connections by latency class and weight (see DeficitRoundRobin) instead of taking turns packet by packet.
+// Each connection may have up to kMaxPendingPackets packets taken from its queue and fragmented, so the scheduler
+// always sees which connections are backlogged. Classic and LE fragments are only sent while their own controller
+// buffer has credits, so a full LE buffer never holds up classic traffic and vice versa.
+class WeightedFairScheduler : public AclScheduler {
+ public:
+  static constexpr size_t kMaxPendingPackets = 2;
+
+  struct LinkStats {
+    // Fragments taken from the connection queue and not sent yet
+    size_t queue_depth = 0;
+    uint32_t packets_sent = 0;
+    // From taking a packet off the connection queue until its last fragment is handed to the HCI layer
+    std::chrono::microseconds average_service_time{0};
+    std::chrono::microseconds max_service_time{0};
+  };
+
+  // |link_statistics|, when given, must outlive the scheduler
+  WeightedFairScheduler(
+      os::Handler* handler,
+      Controller* controller,
+      common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end,
+      LinkStatistics* link_statistics = nullptr);
+  ~WeightedFairScheduler() override;
+
+  // Classic connections start as BULK, LE connections as GATT
+  void Register(ConnectionType connection_type, uint16_t handle,
+                std::shared_ptr<acl_manager::AclConnection::Queue> queue) override;
+  void Unregister(uint16_t handle) override;
+  // High priority makes the link AUDIO, otherwise it goes back to its default class
+  void SetLinkPriority(uint16_t handle, bool high_priority) override;
+  uint16_t GetCredits() override;
+  uint16_t GetLeCredits() override;
+
+  void SetLatencyClass(uint16_t handle, LatencyClass latency_class);
+  // A weight of 0 restores the default weight of the link's class
+  void SetLinkWeight(uint16_t handle, uint16_t weight);
+  LinkStats GetLinkStats(uint16_t handle) const;
+
+ private:
+  struct Fragment {
+    std::unique_ptr<AclBuilder> packet;
+    std::chrono::steady_clock::time_point dequeued;
+    bool last = false;
+  };
+
+  struct Link {
+    ConnectionType connection_type;
+    std::shared_ptr<acl_manager::AclConnection::Queue> queue;
+    bool dequeue_is_registered = false;
+    uint16_t number_of_sent_packets = 0;  // Track credits
+    size_t pending_packets = 0;
+    uint32_t packets_sent = 0;
+    std::chrono::microseconds total_service_time{0};
+    std::chrono::microseconds max_service_time{0};
+  };
+
+  static LatencyClass default_latency_class(ConnectionType connection_type);
+  bool has_credits(uint16_t handle) const;
+  void register_dequeue(uint16_t handle, Link& link);
+  void unregister_dequeue(Link& link);
+  void dequeue_packet(uint16_t handle);
+  void send_next_fragment();
+  std::unique_ptr<AclBuilder> handle_enqueue_next_fragment();
+  void incoming_acl_credits(uint16_t handle, uint16_t credits);
+
+  os::Handler* handler_ = nullptr;
+  Controller* controller_ = nullptr;
+  common::BidiQueueEnd<AclBuilder, AclView>* hci_queue_end_ = nullptr;
+  LinkStatistics* link_statistics_ = nullptr;
+  std::map<uint16_t, Link> links_;
+  DeficitRoundRobin<Fragment> fragments_;
+  uint16_t max_acl_packet_credits_ = 0;
+  uint16_t acl_packet_credits_ = 0;
+  uint16_t le_max_acl_packet_credits_ = 0;
+  uint16_t le_acl_packet_credits_ = 0;
+  size_t hci_mtu_{0};
+  size_t le_hci_mtu_{0};
+  std::atomic_bool enqueue_registered_ = false;
+};
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_manager/weighted_fair_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include "common/bidi_queue.h"
+#include "common/callback.h"
+#include "hci/acl_manager.h"
+#include "hci/controller.h"
+#include "hci/hci_packets.h"
+#include "os/handler.h"
+#include "os/log.h"
+#include "packet/raw_builder.h"
+
+using ::bluetooth::common::BidiQueue;
+using ::bluetooth::common::Callback;
+using ::bluetooth::os::Handler;
+using ::bluetooth::os::Thread;
+
+namespace bluetooth {
+namespace hci {
+namespace acl_manager {
+
+class TestController : public Controller {
+ public:
+  uint16_t GetNumAclPacketBuffers() const {
+    return max_acl_packet_credits_;
+  }
+
+  uint16_t GetAclPacketLength() const {
+    return hci_mtu_;
+  }
+
+  LeBufferSize GetLeBufferSize() const {
+    LeBufferSize le_buffer_size;
+    le_buffer_size.le_data_packet_length_ = le_hci_mtu_;
+    le_buffer_size.total_num_le_packets_ = le_max_acl_packet_credits_;
+    return le_buffer_size;
+  }
+
+  void RegisterCompletedAclPacketsCallback(CompletedAclPacketsCallback cb) {
+    acl_credits_callback_ = cb;
+  }
+
+  void SendCompletedAclPacketsCallback(uint16_t handle, uint16_t credits) {
+    acl_credits_callback_.Invoke(handle, credits);
+  }
+
+  void UnregisterCompletedAclPacketsCallback() {
+    acl_credits_callback_ = {};
+  }
+
+  const uint16_t max_acl_packet_credits_ = 10;
+  const uint16_t hci_mtu_ = 1024;
+  const uint16_t le_max_acl_packet_credits_ = 15;
+  const uint16_t le_hci_mtu_ = 27;
+
+ private:
+  CompletedAclPacketsCallback acl_credits_callback_;
+};
+
+class WeightedFairSchedulerTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    thread_ = new Thread("thread", Thread::Priority::NORMAL);
+    handler_ = new Handler(thread_);
+    controller_ = new TestController();
+    scheduler_ = new WeightedFairScheduler(handler_, controller_, hci_queue_.GetUpEnd());
+    hci_queue_.GetDownEnd()->RegisterDequeue(
+        handler_, common::Bind(&WeightedFairSchedulerTest::HciDownEndDequeue, common::Unretained(this)));
+  }
+
+  void TearDown() override {
+    hci_queue_.GetDownEnd()->UnregisterDequeue();
+    delete scheduler_;
+    delete controller_;
+    handler_->Clear();
+    delete handler_;
+    delete thread_;
+  }
+
+  void sync_handler() {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    handler_->BindOnceOn(&promise, &std::promise<void>::set_value).Invoke();
+    auto status = future.wait_for(std::chrono::milliseconds(3));
+    EXPECT_EQ(status, std::future_status::ready);
+  }
+
+  void EnqueueAclUpEnd(AclConnection::QueueUpEnd* queue_up_end, std::vector<uint8_t> packet) {
+    if (enqueue_promise_ != nullptr) {
+      enqueue_future_->wait();
+    }
+    enqueue_promise_ = std::make_unique<std::promise<void>>();
+    enqueue_future_ = std::make_unique<std::future<void>>(enqueue_promise_->get_future());
+    queue_up_end->RegisterEnqueue(handler_, common::Bind(&WeightedFairSchedulerTest::enqueue_callback,
+                                                         common::Unretained(this), queue_up_end, packet));
+  }
+
+  std::unique_ptr<packet::BasePacketBuilder> enqueue_callback(AclConnection::QueueUpEnd* queue_up_end,
+                                                              std::vector<uint8_t> packet) {
+    auto packet_one = std::make_unique<packet::RawBuilder>(2000);
+    packet_one->AddOctets(packet);
+    queue_up_end->UnregisterEnqueue();
+    enqueue_promise_->set_value();
+    return packet_one;
+  };
+
+  void HciDownEndDequeue() {
+    auto packet = hci_queue_.GetDownEnd()->TryDequeue();
+    // Convert from a Builder to a View
+    auto bytes = std::make_shared<std::vector<uint8_t>>();
+    bluetooth::packet::BitInserter i(*bytes);
+    bytes->reserve(packet->size());
+    packet->Serialize(i);
+    auto packet_view = bluetooth::packet::PacketView<bluetooth::packet::kLittleEndian>(bytes);
+    AclView acl_packet_view = AclView::Create(packet_view);
+    ASSERT_TRUE(acl_packet_view.IsValid());
+    PacketView<true> count_view = acl_packet_view.GetPayload();
+    sent_acl_packets_.push(acl_packet_view);
+
+    packet_count_--;
+    if (packet_count_ == 0) {
+      packet_promise_->set_value();
+      packet_promise_ = nullptr;
+    }
+  }
+
+  void VerifyPacket(uint16_t handle, std::vector<uint8_t> packet) {
+    auto acl_packet_view = sent_acl_packets_.front();
+    ASSERT_EQ(handle, acl_packet_view.GetHandle());
+    auto payload = acl_packet_view.GetPayload();
+    for (size_t i = 0; i < payload.size(); i++) {
+      ASSERT_EQ(payload[i], packet[i]);
+    }
+    sent_acl_packets_.pop();
+  }
+
+  void SetPacketFuture(uint16_t count) {
+    ASSERT_LOG(packet_promise_ == nullptr, "Promises, Promises, ... Only one at a time.");
+    packet_count_ = count;
+    packet_promise_ = std::make_unique<std::promise<void>>();
+    packet_future_ = std::make_unique<std::future<void>>(packet_promise_->get_future());
+  }
+
+  BidiQueue<AclView, AclBuilder> hci_queue_{3};
+  Thread* thread_;
+  Handler* handler_;
+  TestController* controller_;
+  WeightedFairScheduler* scheduler_;
+  std::queue<AclView> sent_acl_packets_;
+  uint16_t packet_count_;
+  std::unique_ptr<std::promise<void>> packet_promise_;
+  std::unique_ptr<std::future<void>> packet_future_;
+  std::unique_ptr<std::promise<void>> enqueue_promise_;
+  std::unique_ptr<std::future<void>> enqueue_future_;
+};
+
+TEST_F(WeightedFairSchedulerTest, startup_teardown) {}
+
+TEST_F(WeightedFairSchedulerTest, register_unregister_connection) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, buffer_packet) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+
+  SetPacketFuture(2);
+  AclConnection::QueueUpEnd* queue_up_end = connection_queue->GetUpEnd();
+  std::vector<uint8_t> packet1 = {0x01, 0x02, 0x03};
+  std::vector<uint8_t> packet2 = {0x04, 0x05, 0x06};
+  EnqueueAclUpEnd(queue_up_end, packet1);
+  EnqueueAclUpEnd(queue_up_end, packet2);
+
+  packet_future_->wait();
+  sync_handler();
+  VerifyPacket(handle, packet1);
+  VerifyPacket(handle, packet2);
+  ASSERT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 2);
+  auto stats = scheduler_->GetLinkStats(handle);
+  ASSERT_EQ(stats.packets_sent, 2u);
+  ASSERT_EQ(stats.queue_depth, 0u);
+  ASSERT_LE(stats.average_service_time, stats.max_service_time);
+
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, do_not_send_when_credits_is_zero) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(15);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+
+  SetPacketFuture(10);
+  AclConnection::QueueUpEnd* queue_up_end = connection_queue->GetUpEnd();
+  for (uint8_t i = 0; i < 15; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    EnqueueAclUpEnd(queue_up_end, packet);
+  }
+
+  packet_future_->wait();
+  for (uint8_t i = 0; i < 10; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    VerifyPacket(handle, packet);
+  }
+  ASSERT_EQ(scheduler_->GetCredits(), 0);
+
+  SetPacketFuture(5);
+  controller_->SendCompletedAclPacketsCallback(0x01, 10);
+  sync_handler();
+  packet_future_->wait();
+  for (uint8_t i = 10; i < 15; i++) {
+    std::vector<uint8_t> packet = {0x01, 0x02, 0x03, i};
+    VerifyPacket(handle, packet);
+  }
+  ASSERT_EQ(scheduler_->GetCredits(), 5);
+
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, full_le_buffer_does_not_block_classic) {
+  uint16_t handle = 0x01;
+  uint16_t le_handle = 0x02;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(20);
+  auto le_connection_queue = std::make_shared<AclConnection::Queue>(20);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::LE, le_handle, le_connection_queue);
+
+  SetPacketFuture(controller_->le_max_acl_packet_credits_ + 1);
+  std::vector<uint8_t> le_packet = {0x04, 0x05, 0x06};
+  for (uint16_t i = 0; i < controller_->le_max_acl_packet_credits_ + 1; i++) {
+    EnqueueAclUpEnd(le_connection_queue->GetUpEnd(), le_packet);
+  }
+  std::vector<uint8_t> packet = {0x01, 0x02, 0x03};
+  EnqueueAclUpEnd(connection_queue->GetUpEnd(), packet);
+
+  packet_future_->wait();
+  sync_handler();
+  ASSERT_EQ(scheduler_->GetLeCredits(), 0);
+  ASSERT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 1);
+  ASSERT_EQ(scheduler_->GetLinkStats(le_handle).queue_depth, 1u);
+
+  scheduler_->Unregister(handle);
+  scheduler_->Unregister(le_handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, send_fragments_of_a_packet_in_order) {
+  uint16_t handle = 0x01;
+  auto connection_queue = std::make_shared<AclConnection::Queue>(10);
+  scheduler_->Register(WeightedFairScheduler::ConnectionType::CLASSIC, handle, connection_queue);
+  scheduler_->SetLinkPriority(handle, true);
+
+  SetPacketFuture(2);
+  std::vector<uint8_t> packet(controller_->hci_mtu_, 0xff);
+  std::vector<uint8_t> packet_part1(controller_->hci_mtu_, 0xff);
+  std::vector<uint8_t> packet_part2 = {0x03, 0x02, 0x01};
+  packet.insert(packet.end(), packet_part2.begin(), packet_part2.end());
+  EnqueueAclUpEnd(connection_queue->GetUpEnd(), packet);
+
+  packet_future_->wait();
+  sync_handler();
+  VerifyPacket(handle, packet_part1);
+  VerifyPacket(handle, packet_part2);
+  ASSERT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_ - 2);
+  ASSERT_EQ(scheduler_->GetLinkStats(handle).packets_sent, 1u);
+
+  scheduler_->Unregister(handle);
+}
+
+TEST_F(WeightedFairSchedulerTest, reveived_completed_callback_with_unknown_handle) {
+  controller_->SendCompletedAclPacketsCallback(0x00, 1);
+  sync_handler();
+  EXPECT_EQ(scheduler_->GetCredits(), controller_->max_acl_packet_credits_);
+  EXPECT_EQ(scheduler_->GetLeCredits(), controller_->le_max_acl_packet_credits_);
+}
+
+}  // namespace acl_manager
+}  // namespace hci
+}  // namespace bluetooth
@@ -827,6 +827,27 @@ TEST_F(AclManagerTest, create_connection_with_slow_mode) {
   ASSERT_EQ(first_connection_status, std::future_status::ready);
 }
 
+TEST_F(AclManagerTest, create_connection_to_initiator_target) {
+  AddressWithType remote_with_type(remote, AddressType::PUBLIC_DEVICE_ADDRESS);
+  test_hci_layer_->SetCommandFuture();
+  acl_manager_->CreateLeConnection(remote_with_type, false);
+  test_hci_layer_->GetLastCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  test_hci_layer_->SetCommandFuture();
+  test_hci_layer_->GetLastCommand(OpCode::LE_CREATE_CONNECTION);
+  test_hci_layer_->IncomingEvent(LeCreateConnectionStatusBuilder::Create(ErrorCode::SUCCESS, 0x01));
+
+  // The initiator already looks for the device, it is neither canceled nor restarted
+  acl_manager_->CreateLeConnection(remote_with_type, false);
+  fake_registry_.SynchronizeModuleHandler(&AclManager::Factory, std::chrono::milliseconds(20));
+  ASSERT_FALSE(test_hci_layer_->GetLastCommand().IsValid());
+
+  // A direct connection needs the fast scan parameters, the initiator restarts with them
+  test_hci_layer_->SetCommandFuture();
+  acl_manager_->CreateLeConnection(remote_with_type, true);
+  test_hci_layer_->GetLastCommand(OpCode::LE_CREATE_CONNECTION_CANCEL);
+}
+
 TEST_F(AclManagerWithLeConnectionTest, acl_send_data_one_le_connection) {
   ASSERT_EQ(connection_->GetRemoteAddress(), remote_with_type_);
   ASSERT_EQ(connection_->GetHandle(), handle_);
@@ -96,6 +96,22 @@ class LeScanningManagerFacadeService : public LeScanningManagerFacade::Service,
   void OnFilterParamSetup(uint8_t available_spaces, ApcfAction action, uint8_t status){};
   void OnFilterConfigCallback(
       ApcfFilterType filter_type, uint8_t available_spaces, ApcfAction action, uint8_t status){};
+  void OnPeriodicSyncStarted(
+      int request_id,
+      ErrorCode status,
+      uint16_t sync_handle,
+      uint8_t advertising_sid,
+      AddressWithType address_with_type,
+      SecondaryPhyType phy,
+      uint16_t interval){};
+  void OnPeriodicSyncReport(
+      int request_id,
+      uint16_t sync_handle,
+      int8_t tx_power,
+      int8_t rssi,
+      DataStatus status,
+      std::vector<uint8_t> data){};
+  void OnPeriodicSyncLost(int request_id, uint16_t sync_handle){};
 
   LeScanningManager* le_scanning_manager_;
   os::Handler* facade_handler_;
@@ -16,6 +16,9 @@
 
 #include "hci/hci_layer.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "common/bind.h"
 #include "common/init_flags.h"
 #include "common/stop_watch.h"
@@ -24,6 +27,7 @@
 #include "os/metrics.h"
 #include "os/queue.h"
 #include "packet/packet_builder.h"
+#include "packet/scatter_inserter.h"
 #include "storage/storage_module.h"
 
 namespace bluetooth {
@@ -70,6 +74,8 @@ class CommandQueueEntry {
 
   unique_ptr<CommandBuilder> command;
   unique_ptr<CommandView> command_view;
+  OpCode op_code{OpCode::NONE};
+  std::chrono::steady_clock::time_point deadline;
 
   bool waiting_for_status_;
   ContextualOnceCallback<void(CommandStatusView)> on_status;
@@ -92,7 +98,8 @@ class CommandQueueEntry {
 };
 
 struct HciLayer::impl {
-  impl(hal::HciHal* hal, HciLayer& module) : hal_(hal), module_(module) {
+  impl(hal::HciHal* hal, HciLayer& module)
+      : hal_(hal), module_(module), pipelining_(common::init_flags::gd_hci_command_pipelining_is_enabled()) {
     hci_timeout_alarm_ = new Alarm(module.GetHandler());
   }
 
@@ -106,6 +113,7 @@ struct HciLayer::impl {
       delete hci_abort_alarm_;
     }
     command_queue_.clear();
+    sent_commands_.clear();
   }
 
   void drop(EventView event) {
@@ -114,18 +122,16 @@ struct HciLayer::impl {
 
   void on_outbound_acl_ready() {
     auto packet = acl_queue_.GetDownEnd()->TryDequeue();
+    // Only headers are copied; payloads are handed to the HAL where they are, while the packet is still alive
     std::vector<uint8_t> bytes;
-    BitInserter bi(bytes);
-    packet->Serialize(bi);
-    hal_->sendAclData(bytes);
+    packet::ScatterInserter si(bytes);
+    packet->Serialize(si);
+    hal_->sendAclDataV(si.GetSlices());
   }
 
   void on_outbound_iso_ready() {
     auto packet = iso_queue_.GetDownEnd()->TryDequeue();
-    std::vector<uint8_t> bytes;
-    BitInserter bi(bytes);
-    packet->Serialize(bi);
-    hal_->sendIsoData(bytes);
+    hal_->sendIsoData(packet->SerializeToBytes());
   }
 
   template <typename TResponse>
@@ -165,32 +171,37 @@ struct HciLayer::impl {
     }
     bool is_status = logging_id == "status";
 
-    ASSERT_LOG(!command_queue_.empty(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(), op_code,
-               OpCodeText(op_code).c_str());
-    ASSERT_LOG(waiting_command_ == op_code, "Waiting for 0x%02hx (%s), got 0x%02hx (%s)", waiting_command_,
-               OpCodeText(waiting_command_).c_str(), op_code, OpCodeText(op_code).c_str());
-    ASSERT_LOG(command_queue_.front().waiting_for_status_ == is_status, "0x%02hx (%s) was not expecting %s event",
-               op_code, OpCodeText(op_code).c_str(), logging_id.c_str());
+    auto command = find_sent_command(op_code);
+    ASSERT_LOG(command != sent_commands_.end(), "Unexpected %s event with OpCode 0x%02hx (%s)", logging_id.c_str(),
+               op_code, OpCodeText(op_code).c_str());
+    ASSERT_LOG(command->waiting_for_status_ == is_status, "0x%02hx (%s) was not expecting %s event", op_code,
+               OpCodeText(op_code).c_str(), logging_id.c_str());
 
-    command_queue_.front().GetCallback<TResponse>()->Invoke(move(response_view));
-    command_queue_.pop_front();
-    waiting_command_ = OpCode::NONE;
+    command->GetCallback<TResponse>()->Invoke(move(response_view));
+    sent_commands_.erase(command);
     if (hci_timeout_alarm_ != nullptr) {
-      hci_timeout_alarm_->Cancel();
+      rearm_command_timeout();
       send_next_command();
     }
   }
 
+  // Responses to commands with the same opcode come back in the order the commands were sent
+  std::list<CommandQueueEntry>::iterator find_sent_command(OpCode op_code) {
+    return std::find_if(sent_commands_.begin(), sent_commands_.end(), [op_code](const CommandQueueEntry& entry) {
+      return entry.op_code == op_code;
+    });
+  }
+
   void on_hci_timeout(OpCode op_code) {
     common::StopWatch::DumpStopWatchLog();
     LOG_ERROR("Timed out waiting for 0x%02hx (%s)", op_code, OpCodeText(op_code).c_str());
     // TODO: LogMetricHciTimeoutEvent(static_cast<uint32_t>(op_code));
 
-    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size());
+    LOG_ERROR("Flushing %zd waiting commands", command_queue_.size() + sent_commands_.size());
     // Clear any waiting commands (there is an abort coming anyway)
     command_queue_.clear();
+    sent_commands_.clear();
     command_credits_ = 1;
-    waiting_command_ = OpCode::NONE;
     enqueue_command(
         ControllerDebugInfoBuilder::Create(), module_.GetHandler()->BindOnce(&fail_if_reset_complete_not_success));
     // Don't time out for this one;
@@ -207,33 +218,77 @@ struct HciLayer::impl {
     }
   }
 
-  void send_next_command() {
-    if (command_credits_ == 0) {
+  // Each sent command has its own deadline. They all use the same timeout, so the oldest one expires first.
+  void rearm_command_timeout() {
+    hci_timeout_alarm_->Cancel();
+    if (sent_commands_.empty()) {
       return;
     }
-    if (waiting_command_ != OpCode::NONE) {
-      return;
+    const CommandQueueEntry& oldest = sent_commands_.front();
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        oldest.deadline - std::chrono::steady_clock::now());
+    hci_timeout_alarm_->Schedule(
+        BindOnce(&impl::on_hci_timeout, common::Unretained(this), oldest.op_code),
+        std::max(remaining, std::chrono::milliseconds(0)));
+  }
+
+  // Commands that change controller state wholesale, or whose side effects are unknown to the stack, run alone
+  static bool must_run_alone(OpCode op_code) {
+    constexpr uint16_t kVendorSpecificOgf = 0x3f;
+    return op_code == OpCode::RESET || (static_cast<uint16_t>(op_code) >> 10) == kVendorSpecificOgf;
+  }
+
+  bool can_send(const CommandQueueEntry& command) const {
+    if (command_credits_ == 0) {
+      return false;
     }
-    if (command_queue_.size() == 0) {
-      return;
+    if (sent_commands_.empty()) {
+      return true;
     }
-    std::shared_ptr<std::vector<uint8_t>> bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter bi(*bytes);
-    command_queue_.front().command->Serialize(bi);
-    hal_->sendHciCommand(*bytes);
+    if (!pipelining_) {
+      return false;
+    }
+    return !must_run_alone(command.op_code) && !must_run_alone(sent_commands_.back().op_code);
+  }
+
+  void send_next_command() {
+    // Commands are sent in the order they were enqueued; one that has to wait holds back the ones behind it
+    while (!command_queue_.empty()) {
+      CommandQueueEntry& command = command_queue_.front();
+      if (command.command_view == nullptr) {
+        serialize_command(command);
+      }
+      if (!can_send(command)) {
+        return;
+      }
+      send_command(command);
+      sent_commands_.splice(sent_commands_.end(), command_queue_, command_queue_.begin());
+    }
+  }
 
+  void serialize_command(CommandQueueEntry& command) {
+    auto bytes = std::make_shared<std::vector<uint8_t>>(command.command->SerializeToBytes());
     auto cmd_view = CommandView::Create(PacketView<kLittleEndian>(bytes));
     ASSERT(cmd_view.IsValid());
-    OpCode op_code = cmd_view.GetOpCode();
-    command_queue_.front().command_view = std::make_unique<CommandView>(std::move(cmd_view));
-    log_link_layer_connection_command_status(command_queue_.front().command_view, ErrorCode::STATUS_UNKNOWN);
-    log_classic_pairing_command_status(command_queue_.front().command_view, ErrorCode::STATUS_UNKNOWN);
-    waiting_command_ = op_code;
-    command_credits_ = 0;  // Only allow one outstanding command
-    if (hci_timeout_alarm_ != nullptr) {
-      hci_timeout_alarm_->Schedule(BindOnce(&impl::on_hci_timeout, common::Unretained(this), op_code), kHciTimeoutMs);
+    command.op_code = cmd_view.GetOpCode();
+    command.command_view = std::make_unique<CommandView>(std::move(cmd_view));
+  }
+
+  void send_command(CommandQueueEntry& command) {
+    hal_->sendHciCommand(hal::HciPacket(command.command_view->begin(), command.command_view->end()));
+    log_link_layer_connection_command_status(command.command_view, ErrorCode::STATUS_UNKNOWN);
+    log_classic_pairing_command_status(command.command_view, ErrorCode::STATUS_UNKNOWN);
+    if (pipelining_) {
+      command_credits_--;
     } else {
-      LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(op_code).c_str());
+      command_credits_ = 0;  // Only allow one outstanding command
+    }
+    command.deadline = std::chrono::steady_clock::now() + kHciTimeoutMs;
+    if (hci_timeout_alarm_ == nullptr) {
+      LOG_WARN("%s sent without an hci-timeout timer", OpCodeText(command.op_code).c_str());
+    } else if (sent_commands_.empty()) {
+      hci_timeout_alarm_->Schedule(
+          BindOnce(&impl::on_hci_timeout, common::Unretained(this), command.op_code), kHciTimeoutMs);
     }
   }
 
@@ -297,9 +352,30 @@ struct HciLayer::impl {
     }
   }
 
+  // The command a Command Complete or Command Status event answers, for metrics logging
+  unique_ptr<CommandView>& sent_command_view_for(EventView event) {
+    OpCode op_code = OpCode::NONE;
+    if (event.GetEventCode() == EventCode::COMMAND_COMPLETE) {
+      auto complete_view = CommandCompleteView::Create(event);
+      if (complete_view.IsValid()) {
+        op_code = complete_view.GetCommandOpCode();
+      }
+    } else if (event.GetEventCode() == EventCode::COMMAND_STATUS) {
+      auto status_view = CommandStatusView::Create(event);
+      if (status_view.IsValid()) {
+        op_code = status_view.GetCommandOpCode();
+      }
+    }
+    auto command = find_sent_command(op_code);
+    if (op_code == OpCode::NONE || command == sent_commands_.end()) {
+      return no_command_view_;
+    }
+    return command->command_view;
+  }
+
   void on_hci_event(EventView event) {
     ASSERT(event.IsValid());
-    log_hci_event(command_queue_.front().command_view, event, module_.GetDependency<storage::StorageModule>());
+    log_hci_event(sent_command_view_for(event), event, module_.GetDependency<storage::StorageModule>());
     EventCode event_code = event.GetEventCode();
     // Root Inflamation is a special case, since it aborts here
     if (event_code == EventCode::VENDOR_SPECIFIC) {
@@ -336,11 +412,15 @@ struct HciLayer::impl {
   HciLayer& module_;
 
   // Command Handling
+  // Commands waiting to be sent, then commands sent and waiting for their response, both in order
   std::list<CommandQueueEntry> command_queue_;
+  std::list<CommandQueueEntry> sent_commands_;
+  // Send as many commands as the controller has credits for, instead of one at a time
+  const bool pipelining_;
+  unique_ptr<CommandView> no_command_view_;
 
   std::map<EventCode, ContextualCallback<void(EventView)>> event_handlers_;
   std::map<SubeventCode, ContextualCallback<void(LeMetaEventView)>> subevent_handlers_;
-  OpCode waiting_command_{OpCode::NONE};
   uint8_t command_credits_{1};  // Send reset first
   Alarm* hci_timeout_alarm_{nullptr};
   Alarm* hci_abort_alarm_{nullptr};
@@ -359,15 +439,11 @@ struct HciLayer::hal_callbacks : public hal::HciHalCallbacks {
   hal_callbacks(HciLayer& module) : module_(module) {}
 
   void hciEventReceived(hal::HciPacket event_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(event_bytes));
-    EventView event = EventView::Create(packet);
-    module_.CallOn(module_.impl_, &impl::on_hci_event, move(event));
+    on_event(packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(event_bytes))));
   }
 
   void aclDataReceived(hal::HciPacket data_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
-    auto acl = std::make_unique<AclView>(AclView::Create(packet));
-    module_.impl_->incoming_acl_buffer_.Enqueue(move(acl), module_.GetHandler());
+    on_acl(packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes))));
   }
 
   void scoDataReceived(hal::HciPacket data_bytes) override {
@@ -375,7 +451,37 @@ struct HciLayer::hal_callbacks : public hal::HciHalCallbacks {
   }
 
   void isoDataReceived(hal::HciPacket data_bytes) override {
-    auto packet = packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes)));
+    on_iso(packet::PacketView<packet::kLittleEndian>(std::make_shared<std::vector<uint8_t>>(move(data_bytes))));
+  }
+
+  // The views share the HAL receive buffer, so a consumer of the view can take the buffer over without copying
+  void hciEventBufferReceived(std::shared_ptr<const uint8_t> event, size_t size) override {
+    on_event(packet::PacketView<packet::kLittleEndian>(move(event), size));
+  }
+
+  void aclDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) override {
+    on_acl(packet::PacketView<packet::kLittleEndian>(move(data), size));
+  }
+
+  void scoDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) override {
+    // Not implemented yet
+  }
+
+  void isoDataBufferReceived(std::shared_ptr<const uint8_t> data, size_t size) override {
+    on_iso(packet::PacketView<packet::kLittleEndian>(move(data), size));
+  }
+
+  void on_event(packet::PacketView<packet::kLittleEndian> packet) {
+    EventView event = EventView::Create(packet);
+    module_.CallOn(module_.impl_, &impl::on_hci_event, move(event));
+  }
+
+  void on_acl(packet::PacketView<packet::kLittleEndian> packet) {
+    auto acl = std::make_unique<AclView>(AclView::Create(packet));
+    module_.impl_->incoming_acl_buffer_.Enqueue(move(acl), module_.GetHandler());
+  }
+
+  void on_iso(packet::PacketView<packet::kLittleEndian> packet) {
     auto iso = std::make_unique<IsoView>(IsoView::Create(packet));
     module_.impl_->incoming_iso_buffer_.Enqueue(move(iso), module_.GetHandler());
   }
@@ -20,6 +20,7 @@
 #include <list>
 #include <memory>
 
+#include "common/init_flags.h"
 #include "hal/hci_hal.h"
 #include "hci/hci_packets.h"
 #include "module.h"
@@ -904,5 +905,101 @@ TEST_F(HciTest, receiveMultipleIsoPackets) {
   ASSERT_EQ(handle, itr.extract<uint16_t>());
   ASSERT_EQ(received_packets, itr.extract<uint16_t>());
 }
+
+class HciPipeliningTest : public HciTest {
+ public:
+  void SetUp() override {
+    const char* flags[] = {"INIT_gd_hci_command_pipelining=true", nullptr};
+    common::InitFlags::Load(flags);
+    HciTest::SetUp();
+  }
+
+  void TearDown() override {
+    HciTest::TearDown();
+    common::InitFlags::Load(nullptr);
+  }
+
+  // Incoming events bounce through the HCI handler twice before a command is sent
+  void Sync() {
+    fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, std::chrono::milliseconds(20));
+    fake_registry_.SynchronizeModuleHandler(&HciLayer::Factory, std::chrono::milliseconds(20));
+  }
+
+  void SendVersionComplete(uint8_t num_packets) {
+    LocalVersionInformation local_version_information;
+    local_version_information.hci_version_ = HciVersion::V_5_0;
+    hal->callbacks->hciEventReceived(GetPacketBytes(
+        ReadLocalVersionInformationCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS, local_version_information)));
+  }
+};
+
+TEST_F(HciPipeliningTest, commandsFillCredits) {
+  uint8_t num_packets = 3;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+  Sync();
+
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedCommandsBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalSupportedFeaturesBuilder::Create());
+  Sync();
+
+  // Verify that the first three are sent without waiting for a response
+  ASSERT_EQ(3, hal->GetNumSentCommands());
+  ASSERT_EQ(OpCode::READ_LOCAL_VERSION_INFORMATION, hal->GetSentCommand().GetOpCode());
+  ASSERT_EQ(OpCode::READ_LOCAL_SUPPORTED_COMMANDS, hal->GetSentCommand().GetOpCode());
+  ASSERT_EQ(OpCode::READ_LOCAL_VERSION_INFORMATION, hal->GetSentCommand().GetOpCode());
+
+  // Responses may come out of order, and each one returns a credit
+  std::array<uint8_t, 64> supported_commands{};
+  auto event_future = upper->GetReceivedEventFuture();
+  hal->callbacks->hciEventReceived(GetPacketBytes(
+      ReadLocalSupportedCommandsCompleteBuilder::Create(1, ErrorCode::SUCCESS, supported_commands)));
+  ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+  ASSERT_TRUE(ReadLocalSupportedCommandsCompleteView::Create(
+                  CommandCompleteView::Create(EventView::Create(upper->GetReceivedEvent())))
+                  .IsValid());
+  Sync();
+
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_EQ(OpCode::READ_LOCAL_SUPPORTED_FEATURES, hal->GetSentCommand().GetOpCode());
+
+  // Both outstanding version commands complete in the order they were sent
+  for (int i = 0; i < 2; i++) {
+    event_future = upper->GetReceivedEventFuture();
+    SendVersionComplete(1);
+    ASSERT_EQ(event_future.wait_for(kTimeout), std::future_status::ready);
+    ASSERT_TRUE(ReadLocalVersionInformationCompleteView::Create(
+                    CommandCompleteView::Create(EventView::Create(upper->GetReceivedEvent())))
+                    .IsValid());
+  }
+  ASSERT_EQ(0, hal->GetNumSentCommands());
+}
+
+TEST_F(HciPipeliningTest, resetIsSentAlone) {
+  uint8_t num_packets = 3;
+  hal->callbacks->hciEventReceived(GetPacketBytes(NoCommandCompleteBuilder::Create(num_packets)));
+  Sync();
+
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ResetBuilder::Create());
+  upper->SendHciCommandExpectingComplete(ReadLocalVersionInformationBuilder::Create());
+  Sync();
+
+  // Verify that reset waits for the command in flight
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_EQ(OpCode::READ_LOCAL_VERSION_INFORMATION, hal->GetSentCommand().GetOpCode());
+
+  SendVersionComplete(num_packets);
+  Sync();
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_EQ(OpCode::RESET, hal->GetSentCommand().GetOpCode());
+
+  // Verify that nothing follows reset until it completes
+  hal->callbacks->hciEventReceived(GetPacketBytes(ResetCompleteBuilder::Create(num_packets, ErrorCode::SUCCESS)));
+  Sync();
+  ASSERT_EQ(1, hal->GetNumSentCommands());
+  ASSERT_EQ(OpCode::READ_LOCAL_VERSION_INFORMATION, hal->GetSentCommand().GetOpCode());
+}
 }  // namespace hci
 }  // namespace bluetooth
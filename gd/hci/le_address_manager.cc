@@ -348,6 +348,26 @@ uint8_t LeAddressManager::GetResolvingListSize() {
   return resolving_list_size_;
 }
 
+OpCode LeAddressManager::command_op_code(CommandType command_type) {
+  switch (command_type) {
+    case CommandType::ROTATE_RANDOM_ADDRESS:
+      return OpCode::LE_SET_RANDOM_ADDRESS;
+    case CommandType::ADD_DEVICE_TO_CONNECT_LIST:
+      return OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST;
+    case CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST:
+      return OpCode::LE_REMOVE_DEVICE_FROM_CONNECT_LIST;
+    case CommandType::CLEAR_CONNECT_LIST:
+      return OpCode::LE_CLEAR_CONNECT_LIST;
+    case CommandType::ADD_DEVICE_TO_RESOLVING_LIST:
+      return OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST;
+    case CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST:
+      return OpCode::LE_REMOVE_DEVICE_FROM_RESOLVING_LIST;
+    case CommandType::CLEAR_RESOLVING_LIST:
+      return OpCode::LE_CLEAR_RESOLVING_LIST;
+  }
+  return OpCode::NONE;
+}
+
 void LeAddressManager::handle_next_command() {
   for (auto client : registered_clients_) {
     if (client.second != ClientState::PAUSED) {
@@ -356,23 +376,33 @@ void LeAddressManager::handle_next_command() {
       return;
     }
   }
+  if (!commands_in_flight_.empty()) {
+    // OnCommandComplete continues once the commands already sent are done
+    return;
+  }
 
   ASSERT(!cached_commands_.empty());
-  auto command = std::move(cached_commands_.front());
-  cached_commands_.pop();
-
-  if (command.command_type == CommandType::ROTATE_RANDOM_ADDRESS) {
+  if (cached_commands_.front().command_type == CommandType::ROTATE_RANDOM_ADDRESS) {
+    cached_commands_.pop();
+    commands_in_flight_.insert(OpCode::LE_SET_RANDOM_ADDRESS);
     rotate_random_address();
-  } else {
+    return;
+  }
+
+  // List updates don't depend on each other's results, so send all of them up to the next rotation at once
+  while (!cached_commands_.empty() && cached_commands_.front().command_type != CommandType::ROTATE_RANDOM_ADDRESS) {
+    auto command = std::move(cached_commands_.front());
+    cached_commands_.pop();
+    commands_in_flight_.insert(command_op_code(command.command_type));
     enqueue_command_.Run(std::move(command.command_packet));
   }
 }
 
 void LeAddressManager::AddDeviceToConnectList(
     ConnectListAddressType connect_list_address_type, bluetooth::hci::Address address) {
-  auto packet_builder = hci::LeAddDeviceToConnectListBuilder::Create(connect_list_address_type, address);
-  Command command = {CommandType::ADD_DEVICE_TO_CONNECT_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  handler_->BindOnceOn(
+              this, &LeAddressManager::add_device_to_connect_list, ConnectListEntry(connect_list_address_type, address))
+      .Invoke();
 }
 
 void LeAddressManager::AddDeviceToResolvingList(
@@ -380,37 +410,160 @@ void LeAddressManager::AddDeviceToResolvingList(
     Address peer_identity_address,
     const std::array<uint8_t, 16>& peer_irk,
     const std::array<uint8_t, 16>& local_irk) {
-  auto packet_builder = hci::LeAddDeviceToResolvingListBuilder::Create(
-      peer_identity_address_type, peer_identity_address, peer_irk, local_irk);
-  Command command = {CommandType::ADD_DEVICE_TO_RESOLVING_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  ResolvingListEntry entry = {peer_identity_address_type, peer_identity_address, peer_irk, local_irk};
+  handler_->BindOnceOn(this, &LeAddressManager::add_device_to_resolving_list, entry).Invoke();
 }
 
 void LeAddressManager::RemoveDeviceFromConnectList(
     ConnectListAddressType connect_list_address_type, bluetooth::hci::Address address) {
-  auto packet_builder = hci::LeRemoveDeviceFromConnectListBuilder::Create(connect_list_address_type, address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  handler_
+      ->BindOnceOn(
+          this, &LeAddressManager::remove_device_from_connect_list, ConnectListEntry(connect_list_address_type, address))
+      .Invoke();
 }
 
 void LeAddressManager::RemoveDeviceFromResolvingList(
     PeerAddressType peer_identity_address_type, Address peer_identity_address) {
-  auto packet_builder =
-      hci::LeRemoveDeviceFromResolvingListBuilder::Create(peer_identity_address_type, peer_identity_address);
-  Command command = {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  handler_
+      ->BindOnceOn(
+          this, &LeAddressManager::remove_device_from_resolving_list, peer_identity_address_type, peer_identity_address)
+      .Invoke();
 }
 
 void LeAddressManager::ClearConnectList() {
+  handler_->BindOnceOn(this, &LeAddressManager::clear_connect_list).Invoke();
+}
+
+void LeAddressManager::ClearResolvingList() {
+  handler_->BindOnceOn(this, &LeAddressManager::clear_resolving_list).Invoke();
+}
+
+void LeAddressManager::SetConnectList(std::vector<ConnectListEntry> connect_list) {
+  handler_->BindOnceOn(this, &LeAddressManager::set_connect_list, std::move(connect_list)).Invoke();
+}
+
+void LeAddressManager::SetResolvingList(std::vector<ResolvingListEntry> resolving_list) {
+  handler_->BindOnceOn(this, &LeAddressManager::set_resolving_list, std::move(resolving_list)).Invoke();
+}
+
+void LeAddressManager::add_device_to_connect_list(ConnectListEntry entry) {
+  connect_list_.insert(entry);
+  auto packet_builder = hci::LeAddDeviceToConnectListBuilder::Create(entry.first, entry.second);
+  Command command = {CommandType::ADD_DEVICE_TO_CONNECT_LIST, std::move(packet_builder)};
+  push_command(std::move(command));
+}
+
+void LeAddressManager::remove_device_from_connect_list(ConnectListEntry entry) {
+  connect_list_.erase(entry);
+  auto packet_builder = hci::LeRemoveDeviceFromConnectListBuilder::Create(entry.first, entry.second);
+  Command command = {CommandType::REMOVE_DEVICE_FROM_CONNECT_LIST, std::move(packet_builder)};
+  push_command(std::move(command));
+}
+
+void LeAddressManager::clear_connect_list() {
+  connect_list_.clear();
   auto packet_builder = hci::LeClearConnectListBuilder::Create();
   Command command = {CommandType::CLEAR_CONNECT_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  push_command(std::move(command));
 }
 
-void LeAddressManager::ClearResolvingList() {
+void LeAddressManager::set_connect_list(std::vector<ConnectListEntry> connect_list) {
+  if (connect_list.size() > connect_list_size_) {
+    LOG_WARN("%zu devices requested for a connect list of %hhu", connect_list.size(), connect_list_size_);
+  }
+  std::set<ConnectListEntry> desired(connect_list.begin(), connect_list.end());
+  std::vector<ConnectListEntry> to_remove;
+  std::vector<ConnectListEntry> to_add;
+  for (const auto& entry : connect_list_) {
+    if (desired.count(entry) == 0) {
+      to_remove.push_back(entry);
+    }
+  }
+  for (const auto& entry : desired) {
+    if (connect_list_.count(entry) == 0) {
+      to_add.push_back(entry);
+    }
+  }
+
+  if (1 + desired.size() < to_remove.size() + to_add.size()) {
+    clear_connect_list();
+    to_remove.clear();
+    to_add.assign(desired.begin(), desired.end());
+  }
+  // Removals go first so the additions fit in the controller list
+  for (const auto& entry : to_remove) {
+    remove_device_from_connect_list(entry);
+  }
+  for (const auto& entry : to_add) {
+    add_device_to_connect_list(entry);
+  }
+}
+
+void LeAddressManager::add_device_to_resolving_list(ResolvingListEntry entry) {
+  resolving_list_[{entry.peer_identity_address_type, entry.peer_identity_address}] = entry;
+  auto packet_builder = hci::LeAddDeviceToResolvingListBuilder::Create(
+      entry.peer_identity_address_type, entry.peer_identity_address, entry.peer_irk, entry.local_irk);
+  Command command = {CommandType::ADD_DEVICE_TO_RESOLVING_LIST, std::move(packet_builder)};
+  push_command(std::move(command));
+}
+
+void LeAddressManager::remove_device_from_resolving_list(
+    PeerAddressType peer_identity_address_type, Address peer_identity_address) {
+  resolving_list_.erase({peer_identity_address_type, peer_identity_address});
+  auto packet_builder =
+      hci::LeRemoveDeviceFromResolvingListBuilder::Create(peer_identity_address_type, peer_identity_address);
+  Command command = {CommandType::REMOVE_DEVICE_FROM_RESOLVING_LIST, std::move(packet_builder)};
+  push_command(std::move(command));
+}
+
+void LeAddressManager::clear_resolving_list() {
+  resolving_list_.clear();
   auto packet_builder = hci::LeClearResolvingListBuilder::Create();
   Command command = {CommandType::CLEAR_RESOLVING_LIST, std::move(packet_builder)};
-  handler_->BindOnceOn(this, &LeAddressManager::push_command, std::move(command)).Invoke();
+  push_command(std::move(command));
+}
+
+void LeAddressManager::set_resolving_list(std::vector<ResolvingListEntry> resolving_list) {
+  if (resolving_list.size() > resolving_list_size_) {
+    LOG_WARN("%zu devices requested for a resolving list of %hhu", resolving_list.size(), resolving_list_size_);
+  }
+  std::map<std::pair<PeerAddressType, Address>, ResolvingListEntry> desired;
+  for (const auto& entry : resolving_list) {
+    desired[{entry.peer_identity_address_type, entry.peer_identity_address}] = entry;
+  }
+  // A device whose keys changed has to be removed and added again
+  auto same_keys = [](const ResolvingListEntry& a, const ResolvingListEntry& b) {
+    return a.peer_irk == b.peer_irk && a.local_irk == b.local_irk;
+  };
+  std::vector<std::pair<PeerAddressType, Address>> to_remove;
+  std::vector<ResolvingListEntry> to_add;
+  for (const auto& cached : resolving_list_) {
+    auto wanted = desired.find(cached.first);
+    if (wanted == desired.end() || !same_keys(wanted->second, cached.second)) {
+      to_remove.push_back(cached.first);
+    }
+  }
+  for (const auto& wanted : desired) {
+    auto cached = resolving_list_.find(wanted.first);
+    if (cached == resolving_list_.end() || !same_keys(wanted.second, cached->second)) {
+      to_add.push_back(wanted.second);
+    }
+  }
+
+  if (1 + desired.size() < to_remove.size() + to_add.size()) {
+    clear_resolving_list();
+    to_remove.clear();
+    to_add.clear();
+    for (const auto& wanted : desired) {
+      to_add.push_back(wanted.second);
+    }
+  }
+  for (const auto& key : to_remove) {
+    remove_device_from_resolving_list(key.first, key.second);
+  }
+  for (const auto& entry : to_add) {
+    add_device_to_resolving_list(entry);
+  }
 }
 
 void LeAddressManager::OnCommandComplete(bluetooth::hci::CommandCompleteView view) {
@@ -420,6 +573,11 @@ void LeAddressManager::OnCommandComplete(bluetooth::hci::CommandCompleteView vie
   }
   std::string op_code = OpCodeText(view.GetCommandOpCode());
   LOG_INFO("Received command complete with op_code %s", op_code.c_str());
+  auto in_flight = commands_in_flight_.find(view.GetCommandOpCode());
+  bool sent_by_batch = in_flight != commands_in_flight_.end();
+  if (sent_by_batch) {
+    commands_in_flight_.erase(in_flight);
+  }
 
   // The command was sent before any client registered, we can make sure all the clients paused when command complete.
   if (view.GetCommandOpCode() == OpCode::LE_SET_RANDOM_ADDRESS) {
@@ -439,6 +597,9 @@ void LeAddressManager::OnCommandComplete(bluetooth::hci::CommandCompleteView vie
     }
   }
 
+  if (!sent_by_batch || !commands_in_flight_.empty()) {
+    return;
+  }
   if (cached_commands_.empty()) {
     handler_->BindOnceOn(this, &LeAddressManager::resume_registered_clients).Invoke();
   } else {
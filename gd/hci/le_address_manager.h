@@ -18,6 +18,8 @@
 #include <map>
 #include <mutex>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include "common/callback.h"
 #include "hci/address_with_type.h"
@@ -74,6 +76,14 @@ class LeAddressManager {
   AddressWithType GetCurrentAddress();          // What was set in SetRandomAddress()
   virtual AddressWithType GetAnotherAddress();  // A new random address without rotating.
 
+  using ConnectListEntry = std::pair<ConnectListAddressType, Address>;
+  struct ResolvingListEntry {
+    PeerAddressType peer_identity_address_type;
+    Address peer_identity_address;
+    std::array<uint8_t, 16> peer_irk;
+    std::array<uint8_t, 16> local_irk;
+  };
+
   uint8_t GetConnectListSize();
   uint8_t GetResolvingListSize();
   void AddDeviceToConnectList(ConnectListAddressType connect_list_address_type, Address address);
@@ -86,6 +96,11 @@ class LeAddressManager {
   void RemoveDeviceFromResolvingList(PeerAddressType peer_identity_address_type, Address peer_identity_address);
   void ClearConnectList();
   void ClearResolvingList();
+  // Bring the controller list to the given contents. Only the difference with what was last written is sent, or a
+  // clear and the full list when that is shorter. The commands go out back to back in one pause of the clients, so the
+  // HCI layer can pipeline them.
+  void SetConnectList(std::vector<ConnectListEntry> connect_list);
+  void SetResolvingList(std::vector<ResolvingListEntry> resolving_list);
   void OnCommandComplete(CommandCompleteView view);
   std::chrono::milliseconds GetNextPrivateAddressIntervalMs();
 
@@ -112,6 +127,7 @@ class LeAddressManager {
     std::unique_ptr<CommandBuilder> command_packet;
   };
 
+  static OpCode command_op_code(CommandType command_type);
   void pause_registered_clients();
   void push_command(Command command);
   void ack_pause(LeAddressManagerCallback* callback);
@@ -126,6 +142,14 @@ class LeAddressManager {
   hci::Address generate_rpa();
   hci::Address generate_nrpa();
   void handle_next_command();
+  void add_device_to_connect_list(ConnectListEntry entry);
+  void remove_device_from_connect_list(ConnectListEntry entry);
+  void clear_connect_list();
+  void set_connect_list(std::vector<ConnectListEntry> connect_list);
+  void add_device_to_resolving_list(ResolvingListEntry entry);
+  void remove_device_from_resolving_list(PeerAddressType peer_identity_address_type, Address peer_identity_address);
+  void clear_resolving_list();
+  void set_resolving_list(std::vector<ResolvingListEntry> resolving_list);
 
   common::Callback<void(std::unique_ptr<CommandBuilder>)> enqueue_command_;
   os::Handler* handler_;
@@ -142,6 +166,12 @@ class LeAddressManager {
   uint8_t connect_list_size_;
   uint8_t resolving_list_size_;
   std::queue<Command> cached_commands_;
+  // Op codes of the commands sent and not completed yet. Commands are sent in runs, and the next run waits for all of
+  // them. Completions of commands sent by anyone else, like the first set random address, don't count.
+  std::multiset<OpCode> commands_in_flight_;
+  // What the controller lists hold once the commands sent or queued so far complete
+  std::set<ConnectListEntry> connect_list_;
+  std::map<std::pair<PeerAddressType, Address>, ResolvingListEntry> resolving_list_;
 };
 
 }  // namespace hci
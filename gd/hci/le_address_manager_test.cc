@@ -439,6 +439,98 @@ TEST_F(LeAddressManagerWithSingleClientTest, clear_resolving_list) {
   clients[0].get()->WaitForResume();
 }
 
+TEST_F(LeAddressManagerWithSingleClientTest, set_connect_list_sends_difference) {
+  Address first, second, third;
+  Address::FromString("01:02:03:04:05:06", first);
+  Address::FromString("01:02:03:04:05:07", second);
+  Address::FromString("01:02:03:04:05:08", third);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->SetConnectList(
+      {{ConnectListAddressType::RANDOM, first}, {ConnectListAddressType::PUBLIC, second}});
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+  // Verify that the second command is sent before the first one completes
+  sync_handler(handler_);
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->SetConnectList(
+      {{ConnectListAddressType::PUBLIC, second}, {ConnectListAddressType::RANDOM, third}});
+  auto packet = test_hci_layer_->GetCommand(OpCode::LE_REMOVE_DEVICE_FROM_CONNECT_LIST);
+  auto remove_view = LeRemoveDeviceFromConnectListView::Create(
+      LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+  ASSERT_TRUE(remove_view.IsValid());
+  ASSERT_EQ(first, remove_view.GetAddress());
+  sync_handler(handler_);
+  packet = test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+  auto add_view =
+      LeAddDeviceToConnectListView::Create(LeConnectionManagementCommandView::Create(AclCommandView::Create(packet)));
+  ASSERT_TRUE(add_view.IsValid());
+  ASSERT_EQ(third, add_view.GetAddress());
+  test_hci_layer_->IncomingEvent(LeRemoveDeviceFromConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, completion_of_other_command_does_not_end_batch) {
+  Address first, second;
+  Address::FromString("01:02:03:04:05:06", first);
+  Address::FromString("01:02:03:04:05:07", second);
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->SetConnectList(
+      {{ConnectListAddressType::RANDOM, first}, {ConnectListAddressType::PUBLIC, second}});
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+  sync_handler(handler_);
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_CONNECT_LIST);
+
+  // A set random address the batch didn't send completes in the middle of it
+  auto stray = CommandCompleteView::Create(
+      EventView::Create(GetPacketView(LeSetRandomAddressCompleteBuilder::Create(0x01, ErrorCode::SUCCESS))));
+  handler_->Post(
+      common::BindOnce(&LeAddressManager::OnCommandComplete, common::Unretained(le_address_manager_), stray));
+  sync_handler(handler_);
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  sync_handler(handler_);
+  ASSERT_TRUE(clients[0].get()->paused);
+
+  test_hci_layer_->IncomingEvent(LeAddDeviceToConnectListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+}
+
+TEST_F(LeAddressManagerWithSingleClientTest, set_resolving_list_clears_when_shorter) {
+  Address first, second, third;
+  Address::FromString("01:02:03:04:05:06", first);
+  Address::FromString("01:02:03:04:05:07", second);
+  Address::FromString("01:02:03:04:05:08", third);
+  Octet16 peer_irk = {0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05, 0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  Octet16 local_irk = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+  auto identity = PeerAddressType::PUBLIC_DEVICE_OR_IDENTITY_ADDRESS;
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->SetResolvingList(
+      {{identity, first, peer_irk, local_irk}, {identity, second, peer_irk, local_irk}});
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST);
+  sync_handler(handler_);
+  test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST);
+  test_hci_layer_->IncomingEvent(LeAddDeviceToResolvingListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  test_hci_layer_->IncomingEvent(LeAddDeviceToResolvingListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+
+  // Removing two devices costs more than clearing the list and adding one
+  test_hci_layer_->SetCommandFuture();
+  le_address_manager_->SetResolvingList({{identity, third, peer_irk, local_irk}});
+  test_hci_layer_->GetCommand(OpCode::LE_CLEAR_RESOLVING_LIST);
+  sync_handler(handler_);
+  auto packet = test_hci_layer_->GetCommand(OpCode::LE_ADD_DEVICE_TO_RESOLVING_LIST);
+  auto add_view = LeAddDeviceToResolvingListView::Create(LeSecurityCommandView::Create(packet));
+  ASSERT_TRUE(add_view.IsValid());
+  ASSERT_EQ(third, add_view.GetPeerIdentityAddress());
+  test_hci_layer_->IncomingEvent(LeClearResolvingListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  test_hci_layer_->IncomingEvent(LeAddDeviceToResolvingListCompleteBuilder::Create(0x01, ErrorCode::SUCCESS));
+  clients[0].get()->WaitForResume();
+}
+
 TEST_F(LeAddressManagerWithSingleClientTest, register_during_command_complete) {
   Address address;
   Address::FromString("01:02:03:04:05:06", address);
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/lru_cache.h"
+#include "hci/address_with_type.h"
+
+namespace bluetooth {
+namespace hci {
+
+// Reassembles the advertising data of each advertiser from its report fragments and scan responses.
+//
+// Every report looks up its advertiser, so the entries are hash indexed and the least recently used advertiser is
+// evicted once the cache is full. Fragments are appended in place to the buffer of their advertiser.
+class LeAdvertisingCache {
+ public:
+  static constexpr size_t kCacheMax = 1000;
+
+  LeAdvertisingCache() : items_(kCacheMax) {}
+
+  // Start the data of |address_with_type| over with |data|
+  const std::vector<uint8_t>& Set(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
+    auto it = items_.find(address_with_type);
+    if (it != items_.end()) {
+      it->second = std::move(data);
+      return it->second;
+    }
+    return Insert(address_with_type, std::move(data));
+  }
+
+  bool Exist(const AddressWithType& address_with_type) {
+    return items_.contains(address_with_type);
+  }
+
+  // Append |data| to the data of |address_with_type|
+  const std::vector<uint8_t>& Append(const AddressWithType& address_with_type, const std::vector<uint8_t>& data) {
+    auto it = items_.find(address_with_type);
+    if (it != items_.end()) {
+      it->second.insert(it->second.end(), data.begin(), data.end());
+      return it->second;
+    }
+    return Insert(address_with_type, data);
+  }
+
+  // Clear data for device |address_with_type|
+  void Clear(const AddressWithType& address_with_type) {
+    items_.extract(address_with_type);
+  }
+
+  void ClearAll() {
+    items_.clear();
+  }
+
+  size_t Size() const {
+    return items_.size();
+  }
+
+ private:
+  const std::vector<uint8_t>& Insert(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
+    auto result = items_.try_emplace(address_with_type, std::move(data));
+    return std::get<0>(result)->second;
+  }
+
+  common::LruCache<AddressWithType, std::vector<uint8_t>> items_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
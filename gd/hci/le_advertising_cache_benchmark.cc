@@ -0,0 +1,116 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/le_advertising_cache.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+
+// A dense environment: every advertiser in range sends a scannable advertisement followed by its scan response, or an
+// extended advertisement split in three fragments, and the reports of all advertisers interleave. The trace is
+// replayed through the cache the way the scanning manager processes the reports.
+class BM_LeAdvertisingCache : public ::benchmark::Fixture {
+ protected:
+  enum class ReportType { ADVERTISEMENT, SCAN_RESPONSE, FIRST_FRAGMENT, FRAGMENT, LAST_FRAGMENT };
+
+  struct Report {
+    AddressWithType address_with_type;
+    ReportType type;
+  };
+
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    std::mt19937 random(0);
+    std::vector<std::vector<ReportType>> pending;
+    std::vector<AddressWithType> addresses;
+    for (int64_t i = 0; i < st.range(0); i++) {
+      Address address({0x00, 0x11, 0x22, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i});
+      addresses.emplace_back(address, AddressType::RANDOM_DEVICE_ADDRESS);
+      if (i % 2) {
+        pending.push_back({ReportType::SCAN_RESPONSE, ReportType::ADVERTISEMENT});
+      } else {
+        pending.push_back({ReportType::LAST_FRAGMENT, ReportType::FRAGMENT, ReportType::FIRST_FRAGMENT});
+      }
+    }
+    // Interleave the reports, keeping the order of the reports of each advertiser
+    std::vector<size_t> active(pending.size());
+    for (size_t i = 0; i < active.size(); i++) {
+      active[i] = i;
+    }
+    while (!active.empty()) {
+      size_t pick = random() % active.size();
+      size_t device = active[pick];
+      trace_.push_back({addresses[device], pending[device].back()});
+      pending[device].pop_back();
+      if (pending[device].empty()) {
+        active[pick] = active.back();
+        active.pop_back();
+      }
+    }
+  }
+
+  void TearDown(State& st) override {
+    trace_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<Report> trace_;
+};
+
+BENCHMARK_DEFINE_F(BM_LeAdvertisingCache, replay_reports)(State& state) {
+  const std::vector<uint8_t> data(31, 0x42);
+  LeAdvertisingCache cache;
+  for (auto _ : state) {
+    for (const auto& report : trace_) {
+      switch (report.type) {
+        case ReportType::ADVERTISEMENT:
+          cache.Set(report.address_with_type, data);
+          break;
+        case ReportType::SCAN_RESPONSE:
+          if (cache.Exist(report.address_with_type)) {
+            ::benchmark::DoNotOptimize(cache.Append(report.address_with_type, data).data());
+            cache.Clear(report.address_with_type);
+          }
+          break;
+        case ReportType::FIRST_FRAGMENT:
+        case ReportType::FRAGMENT:
+          cache.Append(report.address_with_type, data);
+          break;
+        case ReportType::LAST_FRAGMENT:
+          ::benchmark::DoNotOptimize(cache.Append(report.address_with_type, data).data());
+          cache.Clear(report.address_with_type);
+          break;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * trace_.size());
+}
+
+BENCHMARK_REGISTER_F(BM_LeAdvertisingCache, replay_reports)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000);
+
+}  // namespace hci
+}  // namespace bluetooth
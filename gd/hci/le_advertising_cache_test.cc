@@ -0,0 +1,72 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/le_advertising_cache.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+AddressWithType MakeAddress(uint32_t i) {
+  Address address({0x00, 0x11, 0x22, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i});
+  return AddressWithType(address, AddressType::RANDOM_DEVICE_ADDRESS);
+}
+
+TEST(LeAdvertisingCacheTest, reassembles_fragments) {
+  LeAdvertisingCache cache;
+  auto address = MakeAddress(1);
+  ASSERT_FALSE(cache.Exist(address));
+  cache.Set(address, {0x01, 0x02});
+  ASSERT_TRUE(cache.Exist(address));
+  auto& data = cache.Append(address, {0x03});
+  ASSERT_EQ(std::vector<uint8_t>({0x01, 0x02, 0x03}), data);
+
+  ASSERT_EQ(std::vector<uint8_t>({0x04}), cache.Set(address, {0x04}));
+  ASSERT_EQ(1u, cache.Size());
+
+  cache.Clear(address);
+  ASSERT_FALSE(cache.Exist(address));
+  ASSERT_EQ(std::vector<uint8_t>({0x05}), cache.Append(address, {0x05}));
+}
+
+TEST(LeAdvertisingCacheTest, keeps_address_types_apart) {
+  LeAdvertisingCache cache;
+  Address address({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+  cache.Set(AddressWithType(address, AddressType::PUBLIC_DEVICE_ADDRESS), {0x01});
+  ASSERT_FALSE(cache.Exist(AddressWithType(address, AddressType::RANDOM_DEVICE_ADDRESS)));
+}
+
+TEST(LeAdvertisingCacheTest, evicts_least_recently_used) {
+  LeAdvertisingCache cache;
+  for (uint32_t i = 0; i < LeAdvertisingCache::kCacheMax; i++) {
+    cache.Set(MakeAddress(i), {(uint8_t)i});
+  }
+  // Advertiser 0 sends its scan response, so advertiser 1 is now the coldest
+  cache.Append(MakeAddress(0), {0xff});
+  cache.Set(MakeAddress(LeAdvertisingCache::kCacheMax), {0x00});
+  ASSERT_EQ(LeAdvertisingCache::kCacheMax, cache.Size());
+  ASSERT_TRUE(cache.Exist(MakeAddress(0)));
+  ASSERT_FALSE(cache.Exist(MakeAddress(1)));
+
+  cache.ClearAll();
+  ASSERT_EQ(0u, cache.Size());
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -56,8 +56,32 @@ struct Advertiser {
   bool started = false;
   bool connectable = false;
   std::unique_ptr<os::Alarm> address_rotation_alarm;
+
+  // Advertising data [0] or scan response data [1] of the set
+  struct DataState {
+    bool programmed_valid = false;
+    std::vector<GapData> programmed;  // last data the controller accepted
+    uint64_t write_in_flight = 0;     // id of the write in flight, 0 when none
+    std::vector<GapData> writing;
+    size_t writing_callbacks = 0;
+    std::vector<GapData> pending;  // latest update waiting for the write in flight
+    size_t pending_callbacks = 0;
+  };
+  DataState data_state[2];
 };
 
+static bool is_same_data(const std::vector<GapData>& a, const std::vector<GapData>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].data_type_ != b[i].data_type_ || a[i].data_ != b[i].data_) {
+      return false;
+    }
+  }
+  return true;
+}
+
 ExtendedAdvertisingConfig::ExtendedAdvertisingConfig(const AdvertisingConfig& config) : AdvertisingConfig(config) {
   switch (config.advertising_type) {
     case AdvertisingType::ADV_IND:
@@ -430,6 +454,10 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
   void set_parameters(AdvertiserId advertiser_id, ExtendedAdvertisingConfig config) {
     advertising_sets_[advertiser_id].connectable = config.connectable;
     advertising_sets_[advertiser_id].tx_power = config.tx_power;
+    // The data may not survive new parameters, write it again on the next update
+    for (auto& state : advertising_sets_[advertiser_id].data_state) {
+      state.programmed_valid = false;
+    }
 
     switch (advertising_api_type_) {
       case (AdvertisingApiType::LEGACY): {
@@ -556,29 +584,61 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
       }
     }
 
+    // Apps updating their data faster than the controller takes it, beacons refreshing a counter for example, only
+    // get their latest data written once the write in flight completes
+    auto& state = advertising_sets_[advertiser_id].data_state[set_scan_rsp];
+    if (state.write_in_flight != 0) {
+      state.pending = std::move(data);
+      state.pending_callbacks++;
+      return;
+    }
+    write_data(advertiser_id, set_scan_rsp, std::move(data), 1);
+  }
+
+  void write_data(AdvertiserId advertiser_id, bool set_scan_rsp, std::vector<GapData> data, size_t num_callbacks) {
+    auto& state = advertising_sets_[advertiser_id].data_state[set_scan_rsp];
+    if (state.programmed_valid && is_same_data(state.programmed, data)) {
+      if (advertising_sets_[advertiser_id].started) {
+        on_data_set(advertiser_id, set_scan_rsp, AdvertisingCallback::AdvertisingStatus::SUCCESS, num_callbacks);
+      }
+      return;
+    }
+
     switch (advertising_api_type_) {
       case (AdvertisingApiType::LEGACY): {
+        uint64_t write_id = start_data_write(advertiser_id, set_scan_rsp, data, num_callbacks);
         if (set_scan_rsp) {
           le_advertising_interface_->EnqueueCommand(
               hci::LeSetScanResponseDataBuilder::Create(data),
               module_handler_->BindOnceOn(
-                  this, &impl::check_status_with_id<LeSetScanResponseDataCompleteView>, advertiser_id));
+                  this,
+                  &impl::on_set_data_complete<LeSetScanResponseDataCompleteView>,
+                  advertiser_id,
+                  set_scan_rsp,
+                  write_id));
         } else {
           le_advertising_interface_->EnqueueCommand(
               hci::LeSetAdvertisingDataBuilder::Create(data),
               module_handler_->BindOnceOn(
-                  this, &impl::check_status_with_id<LeSetAdvertisingDataCompleteView>, advertiser_id));
+                  this,
+                  &impl::on_set_data_complete<LeSetAdvertisingDataCompleteView>,
+                  advertiser_id,
+                  set_scan_rsp,
+                  write_id));
         }
       } break;
       case (AdvertisingApiType::ANDROID_HCI): {
+        uint64_t write_id = start_data_write(advertiser_id, set_scan_rsp, data, num_callbacks);
         if (set_scan_rsp) {
           le_advertising_interface_->EnqueueCommand(
               hci::LeMultiAdvtSetScanRespBuilder::Create(data, advertiser_id),
-              module_handler_->BindOnceOn(this, &impl::check_status_with_id<LeMultiAdvtCompleteView>, advertiser_id));
+              module_handler_->BindOnceOn(
+                  this, &impl::on_set_data_complete<LeMultiAdvtCompleteView>, advertiser_id, set_scan_rsp, write_id));
         } else {
           le_advertising_interface_->EnqueueCommand(
               hci::LeMultiAdvtSetDataBuilder::Create(data, advertiser_id),
-              module_handler_->BindOnceOn(this, &impl::check_status_with_id<LeMultiAdvtCompleteView>, advertiser_id));
+              module_handler_->BindOnceOn(
+                  this, &impl::on_set_data_complete<LeMultiAdvtCompleteView>, advertiser_id, set_scan_rsp, write_id));
         }
       } break;
       case (AdvertisingApiType::EXTENDED): {
@@ -587,15 +647,8 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
         for (int i = 0; i < data.size(); i++) {
           if (data[i].size() > kLeMaximumFragmentLength) {
             LOG_WARN("AD data len shall not greater than %d", kLeMaximumFragmentLength);
-            if (advertising_callbacks_ != nullptr) {
-              if (set_scan_rsp) {
-                advertising_callbacks_->OnScanResponseDataSet(
-                    advertiser_id, AdvertisingCallback::AdvertisingStatus::INTERNAL_ERROR);
-              } else {
-                advertising_callbacks_->OnAdvertisingDataSet(
-                    advertiser_id, AdvertisingCallback::AdvertisingStatus::INTERNAL_ERROR);
-              }
-            }
+            on_data_set(
+                advertiser_id, set_scan_rsp, AdvertisingCallback::AdvertisingStatus::INTERNAL_ERROR, num_callbacks);
             return;
           }
           data_len += data[i].size();
@@ -605,20 +658,14 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
           LOG_WARN(
               "advertising data len exceeds le_maximum_advertising_data_length_ %d",
               le_maximum_advertising_data_length_);
-          if (advertising_callbacks_ != nullptr) {
-            if (set_scan_rsp) {
-              advertising_callbacks_->OnScanResponseDataSet(
-                  advertiser_id, AdvertisingCallback::AdvertisingStatus::DATA_TOO_LARGE);
-            } else {
-              advertising_callbacks_->OnAdvertisingDataSet(
-                  advertiser_id, AdvertisingCallback::AdvertisingStatus::DATA_TOO_LARGE);
-            }
-          }
+          on_data_set(
+              advertiser_id, set_scan_rsp, AdvertisingCallback::AdvertisingStatus::DATA_TOO_LARGE, num_callbacks);
           return;
         }
 
+        uint64_t write_id = start_data_write(advertiser_id, set_scan_rsp, data, num_callbacks);
         if (data_len <= kLeMaximumFragmentLength) {
-          send_data_fragment(advertiser_id, set_scan_rsp, data, Operation::COMPLETE_ADVERTISEMENT);
+          send_data_fragment(advertiser_id, set_scan_rsp, data, Operation::COMPLETE_ADVERTISEMENT, write_id);
         } else {
           std::vector<GapData> sub_data;
           uint16_t sub_data_len = 0;
@@ -626,7 +673,7 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
 
           for (int i = 0; i < data.size(); i++) {
             if (sub_data_len + data[i].size() > kLeMaximumFragmentLength) {
-              send_data_fragment(advertiser_id, set_scan_rsp, sub_data, operation);
+              send_data_fragment(advertiser_id, set_scan_rsp, sub_data, operation, write_id);
               operation = Operation::INTERMEDIATE_FRAGMENT;
               sub_data_len = 0;
               sub_data.clear();
@@ -634,26 +681,65 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
             sub_data.push_back(data[i]);
             sub_data_len += data[i].size();
           }
-          send_data_fragment(advertiser_id, set_scan_rsp, sub_data, Operation::LAST_FRAGMENT);
+          send_data_fragment(advertiser_id, set_scan_rsp, sub_data, Operation::LAST_FRAGMENT, write_id);
         }
       } break;
     }
   }
 
+  // Records the write of |data| about to be enqueued, returns its id
+  uint64_t start_data_write(
+      AdvertiserId advertiser_id, bool set_scan_rsp, const std::vector<GapData>& data, size_t num_callbacks) {
+    auto& state = advertising_sets_[advertiser_id].data_state[set_scan_rsp];
+    state.write_in_flight = ++last_data_write_id_;
+    state.writing = data;
+    state.writing_callbacks = num_callbacks;
+    return state.write_in_flight;
+  }
+
+  void on_data_set(
+      AdvertiserId advertiser_id,
+      bool set_scan_rsp,
+      AdvertisingCallback::AdvertisingStatus status,
+      size_t num_callbacks) {
+    if (advertising_callbacks_ == nullptr) {
+      return;
+    }
+    for (size_t i = 0; i < num_callbacks; i++) {
+      if (set_scan_rsp) {
+        advertising_callbacks_->OnScanResponseDataSet(advertiser_id, status);
+      } else {
+        advertising_callbacks_->OnAdvertisingDataSet(advertiser_id, status);
+      }
+    }
+  }
+
   void send_data_fragment(
-      AdvertiserId advertiser_id, bool set_scan_rsp, std::vector<GapData> data, Operation operation) {
+      AdvertiserId advertiser_id,
+      bool set_scan_rsp,
+      std::vector<GapData> data,
+      Operation operation,
+      uint64_t write_id) {
     if (operation == Operation::COMPLETE_ADVERTISEMENT || operation == Operation::LAST_FRAGMENT) {
       if (set_scan_rsp) {
         le_advertising_interface_->EnqueueCommand(
             hci::LeSetExtendedAdvertisingScanResponseBuilder::Create(
                 advertiser_id, operation, kFragment_preference, data),
             module_handler_->BindOnceOn(
-                this, &impl::check_status_with_id<LeSetExtendedAdvertisingScanResponseCompleteView>, advertiser_id));
+                this,
+                &impl::on_set_data_complete<LeSetExtendedAdvertisingScanResponseCompleteView>,
+                advertiser_id,
+                set_scan_rsp,
+                write_id));
       } else {
         le_advertising_interface_->EnqueueCommand(
             hci::LeSetExtendedAdvertisingDataBuilder::Create(advertiser_id, operation, kFragment_preference, data),
             module_handler_->BindOnceOn(
-                this, &impl::check_status_with_id<LeSetExtendedAdvertisingDataCompleteView>, advertiser_id));
+                this,
+                &impl::on_set_data_complete<LeSetExtendedAdvertisingDataCompleteView>,
+                advertiser_id,
+                set_scan_rsp,
+                write_id));
       }
     } else {
       // For first and intermediate fragment, do not trigger advertising_callbacks_.
@@ -912,6 +998,7 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
   int8_t le_physical_channel_tx_power_ = 0;
   hci::LeAdvertisingInterface* le_advertising_interface_;
   std::map<AdvertiserId, Advertiser> advertising_sets_;
+  uint64_t last_data_write_id_ = 0;
   hci::LeAddressManager* le_address_manager_;
   hci::AclManager* acl_manager_;
   bool address_manager_registered = false;
@@ -1050,6 +1137,32 @@ struct LeAdvertisingManager::impl : public bluetooth::hci::LeAddressManagerCallb
     }
   }
 
+  template <class View>
+  void on_set_data_complete(AdvertiserId id, bool set_scan_rsp, uint64_t write_id, CommandCompleteView view) {
+    auto it = advertising_sets_.find(id);
+    if (it == advertising_sets_.end() || it->second.data_state[set_scan_rsp].write_in_flight != write_id) {
+      // The advertiser was removed while the data was written
+      check_status_with_id<View>(id, view);
+      return;
+    }
+
+    auto& state = it->second.data_state[set_scan_rsp];
+    auto status_view = View::Create(view);
+    ASSERT(status_view.IsValid());
+    state.write_in_flight = 0;
+    state.programmed_valid = status_view.GetStatus() == ErrorCode::SUCCESS;
+    state.programmed = std::move(state.writing);
+    for (size_t i = 0; i < state.writing_callbacks; i++) {
+      check_status_with_id<View>(id, view);
+    }
+
+    if (state.pending_callbacks != 0) {
+      size_t num_callbacks = state.pending_callbacks;
+      state.pending_callbacks = 0;
+      write_data(id, set_scan_rsp, std::move(state.pending), num_callbacks);
+    }
+  }
+
   template <class View>
   void check_status_with_id(AdvertiserId id, CommandCompleteView view) {
     ASSERT(view.IsValid());
@@ -164,6 +164,11 @@ class TestHciLayer : public HciLayer {
     return command;
   }
 
+  size_t CommandQueueSize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return command_queue_.size();
+  }
+
   void RegisterEventHandler(EventCode event_code, common::ContextualCallback<void(EventView)> event_handler) override {
     registered_events_[event_code] = event_handler;
   }
@@ -876,6 +881,63 @@ TEST_F(LeAndroidHciAdvertisingAPITest, set_data_test) {
   sync_client_handler();
 }
 
+TEST_F(LeExtendedAdvertisingAPITest, set_unchanged_data_test) {
+  std::vector<GapData> advertising_data{};
+  GapData data_item{};
+  data_item.data_type_ = GapDataType::COMPLETE_LOCAL_NAME;
+  data_item.data_ = {'t', 'e', 's', 't', ' ', 'd', 'e', 'v', 'i', 'c', 'e'};
+  advertising_data.push_back(data_item);
+  test_hci_layer_->SetCommandFuture();
+  le_advertising_manager_->SetData(advertiser_id_, false, advertising_data);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_ADVERTISING_DATA);
+  EXPECT_CALL(
+      mock_advertising_callback_,
+      OnAdvertisingDataSet(advertiser_id_, AdvertisingCallback::AdvertisingStatus::SUCCESS))
+      .Times(2);
+  test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingDataCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+  sync_client_handler();
+
+  // The data is already in the controller
+  le_advertising_manager_->SetData(advertiser_id_, false, advertising_data);
+  sync_client_handler();
+  ASSERT_EQ(0u, test_hci_layer_->CommandQueueSize());
+}
+
+TEST_F(LeExtendedAdvertisingAPITest, set_data_coalesced_test) {
+  std::vector<GapData> advertising_data{};
+  GapData data_item{};
+  data_item.data_type_ = GapDataType::SERVICE_DATA_16_BIT_UUIDS;
+  data_item.data_ = {0xaa, 0xfe, 0x00};
+  advertising_data.push_back(data_item);
+  test_hci_layer_->SetCommandFuture();
+  le_advertising_manager_->SetData(advertiser_id_, false, advertising_data);
+  test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_ADVERTISING_DATA);
+
+  // Updates while the first write is in flight, only the latest one is written
+  advertising_data[0].data_[2] = 0x01;
+  le_advertising_manager_->SetData(advertiser_id_, false, advertising_data);
+  advertising_data[0].data_[2] = 0x02;
+  le_advertising_manager_->SetData(advertiser_id_, false, advertising_data);
+  sync_client_handler();
+  ASSERT_EQ(0u, test_hci_layer_->CommandQueueSize());
+
+  EXPECT_CALL(
+      mock_advertising_callback_,
+      OnAdvertisingDataSet(advertiser_id_, AdvertisingCallback::AdvertisingStatus::SUCCESS))
+      .Times(3);
+  test_hci_layer_->SetCommandFuture();
+  test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingDataCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+  auto command = LeSetExtendedAdvertisingDataView::Create(LeAdvertisingCommandView::Create(
+      test_hci_layer_->GetCommand(OpCode::LE_SET_EXTENDED_ADVERTISING_DATA)));
+  ASSERT_TRUE(command.IsValid());
+  // Flags first, the advertiser is connectable
+  ASSERT_EQ(2u, command.GetAdvertisingData().size());
+  ASSERT_EQ(0x02, command.GetAdvertisingData()[1].data_[2]);
+  test_hci_layer_->IncomingEvent(LeSetExtendedAdvertisingDataCompleteBuilder::Create(uint8_t{1}, ErrorCode::SUCCESS));
+  sync_client_handler();
+  ASSERT_EQ(0u, test_hci_layer_->CommandQueueSize());
+}
+
 TEST_F(LeExtendedAdvertisingAPITest, set_data_fragments_test) {
   // Set advertising data
   std::vector<GapData> advertising_data{};
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "hci/address_with_type.h"
+#include "hci/hci_packets.h"
+#include "hci/le_scanning_interface.h"
+#include "hci/le_scanning_manager.h"
+#include "os/alarm.h"
+#include "os/handler.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+
+// Shares periodic advertising syncs between all the requests for the same train.
+//
+// The controller holds only a few syncs and creates one at a time, so the requests for the same (SID, address) join a
+// single sync, which lives until its last request stops, and every report of the sync goes to all of its requests.
+// Syncs are created one after the other; a creation that gets no sync in time is cancelled and the next one starts.
+// The first request of a sync picks its skip and timeout.
+class PeriodicSyncManager {
+ public:
+  static constexpr std::chrono::milliseconds kCreateSyncTimeout = std::chrono::seconds(30);
+
+  explicit PeriodicSyncManager(ScanningCallback* callbacks) : callbacks_(callbacks) {}
+
+  void Init(LeScanningInterface* le_scanning_interface, os::Handler* handler) {
+    le_scanning_interface_ = le_scanning_interface;
+    handler_ = handler;
+    create_sync_timeout_ = std::make_unique<os::Alarm>(handler);
+  }
+
+  void SetScanningCallback(ScanningCallback* callbacks) {
+    callbacks_ = callbacks;
+  }
+
+  void StartSync(
+      int request_id, uint8_t sid, const AddressWithType& address_with_type, uint16_t skip, uint16_t timeout) {
+    auto sync = std::find_if(syncs_.begin(), syncs_.end(), [&](const Sync& s) {
+      return s.sid == sid && s.address_with_type.GetAddress() == address_with_type.GetAddress();
+    });
+    if (sync == syncs_.end()) {
+      sync = syncs_.insert(syncs_.end(), Sync{sid, address_with_type, skip, timeout});
+    }
+    sync->requests.push_back(request_id);
+
+    if (sync->established) {
+      LOG_INFO("Request %d joins sync 0x%04hx", request_id, sync->sync_handle);
+      callbacks_->OnPeriodicSyncStarted(
+          request_id,
+          ErrorCode::SUCCESS,
+          sync->sync_handle,
+          sync->sid,
+          sync->address_with_type,
+          sync->phy,
+          sync->interval);
+      return;
+    }
+    create_next_sync();
+  }
+
+  void StopSync(int request_id) {
+    auto sync = std::find_if(syncs_.begin(), syncs_.end(), [request_id](const Sync& s) {
+      return std::find(s.requests.begin(), s.requests.end(), request_id) != s.requests.end();
+    });
+    if (sync == syncs_.end()) {
+      LOG_WARN("No sync for request %d", request_id);
+      return;
+    }
+    sync->requests.erase(std::find(sync->requests.begin(), sync->requests.end(), request_id));
+    if (!sync->requests.empty()) return;
+
+    if (sync->established) {
+      le_scanning_interface_->EnqueueCommand(
+          LePeriodicAdvertisingTerminateSyncBuilder::Create(sync->sync_handle),
+          handler_->BindOnce(check_complete<LePeriodicAdvertisingTerminateSyncCompleteView>));
+      syncs_.erase(sync);
+    } else if (sync->creating) {
+      // Dropped once the controller reports the cancelled creation
+      sync->cancelled = true;
+      cancel_create_sync();
+    } else {
+      syncs_.erase(sync);
+    }
+  }
+
+  void HandleSyncEstablished(LePeriodicAdvertisingSyncEstablishedView event_view) {
+    ASSERT(event_view.IsValid());
+    auto sync = std::find_if(syncs_.begin(), syncs_.end(), [](const Sync& s) { return s.creating; });
+    if (sync == syncs_.end()) {
+      LOG_WARN("Sync established without a pending creation");
+      return;
+    }
+    create_sync_timeout_->Cancel();
+    sync->creating = false;
+
+    ErrorCode status = event_view.GetStatus();
+    if (status == ErrorCode::SUCCESS && sync->requests.empty()) {
+      le_scanning_interface_->EnqueueCommand(
+          LePeriodicAdvertisingTerminateSyncBuilder::Create(event_view.GetSyncHandle()),
+          handler_->BindOnce(check_complete<LePeriodicAdvertisingTerminateSyncCompleteView>));
+      syncs_.erase(sync);
+    } else if (status == ErrorCode::SUCCESS) {
+      sync->established = true;
+      sync->sync_handle = event_view.GetSyncHandle();
+      sync->phy = event_view.GetAdvertiserPhy();
+      sync->interval = event_view.GetPeriodicAdvertisingInterval();
+      for (int request_id : sync->requests) {
+        callbacks_->OnPeriodicSyncStarted(
+            request_id, status, sync->sync_handle, sync->sid, sync->address_with_type, sync->phy, sync->interval);
+      }
+    } else if (sync->cancelled && !sync->requests.empty()) {
+      // New requests came in while the creation was being cancelled, try again
+      sync->cancelled = false;
+    } else {
+      fail_sync(sync, status);
+    }
+    create_next_sync();
+  }
+
+  void HandlePeriodicAdvertisingReport(LePeriodicAdvertisingReportView event_view) {
+    ASSERT(event_view.IsValid());
+    auto sync = find_established(event_view.GetSyncHandle());
+    if (sync == syncs_.end()) return;
+
+    std::vector<uint8_t> data = event_view.GetData();
+    for (int request_id : sync->requests) {
+      callbacks_->OnPeriodicSyncReport(
+          request_id,
+          sync->sync_handle,
+          static_cast<int8_t>(event_view.GetTxPower()),
+          static_cast<int8_t>(event_view.GetRssi()),
+          event_view.GetDataStatus(),
+          data);
+    }
+  }
+
+  void HandleSyncLost(LePeriodicAdvertisingSyncLostView event_view) {
+    ASSERT(event_view.IsValid());
+    auto sync = find_established(event_view.GetSyncHandle());
+    if (sync == syncs_.end()) return;
+
+    for (int request_id : sync->requests) {
+      callbacks_->OnPeriodicSyncLost(request_id, sync->sync_handle);
+    }
+    syncs_.erase(sync);
+  }
+
+ private:
+  struct Sync {
+    uint8_t sid;
+    AddressWithType address_with_type;
+    uint16_t skip;
+    uint16_t timeout;
+    std::vector<int> requests{};
+    bool creating = false;
+    bool cancelled = false;
+    bool established = false;
+    uint16_t sync_handle = 0;
+    SecondaryPhyType phy = SecondaryPhyType::NO_PACKETS;
+    uint16_t interval = 0;
+  };
+
+  std::list<Sync>::iterator find_established(uint16_t sync_handle) {
+    return std::find_if(syncs_.begin(), syncs_.end(), [sync_handle](const Sync& s) {
+      return s.established && s.sync_handle == sync_handle;
+    });
+  }
+
+  void create_next_sync() {
+    for (const auto& sync : syncs_) {
+      if (sync.creating) return;
+    }
+    auto sync = std::find_if(syncs_.begin(), syncs_.end(), [](const Sync& s) { return !s.established; });
+    if (sync == syncs_.end()) return;
+
+    sync->creating = true;
+    AddressType type = sync->address_with_type.GetAddressType();
+    bool is_public = type == AddressType::PUBLIC_DEVICE_ADDRESS || type == AddressType::PUBLIC_IDENTITY_ADDRESS;
+    AdvertisingAddressType address_type =
+        is_public ? AdvertisingAddressType::PUBLIC_ADDRESS : AdvertisingAddressType::RANDOM_ADDRESS;
+    le_scanning_interface_->EnqueueCommand(
+        LePeriodicAdvertisingCreateSyncBuilder::Create(
+            0, 0, sync->sid, address_type, sync->address_with_type.GetAddress(), sync->skip, sync->timeout, 0),
+        handler_->BindOnceOn(this, &PeriodicSyncManager::on_create_sync_status));
+    create_sync_timeout_->Schedule(
+        common::BindOnce(&PeriodicSyncManager::cancel_create_sync, common::Unretained(this)), kCreateSyncTimeout);
+  }
+
+  void on_create_sync_status(CommandStatusView view) {
+    ASSERT(view.IsValid());
+    if (view.GetStatus() == ErrorCode::SUCCESS) return;
+
+    LOG_WARN("Create sync failed: %s", ErrorCodeText(view.GetStatus()).c_str());
+    auto sync = std::find_if(syncs_.begin(), syncs_.end(), [](const Sync& s) { return s.creating; });
+    if (sync == syncs_.end()) return;
+    create_sync_timeout_->Cancel();
+    fail_sync(sync, view.GetStatus());
+    create_next_sync();
+  }
+
+  void cancel_create_sync() {
+    le_scanning_interface_->EnqueueCommand(
+        LePeriodicAdvertisingCreateSyncCancelBuilder::Create(),
+        handler_->BindOnce(check_complete<LePeriodicAdvertisingCreateSyncCancelCompleteView>));
+  }
+
+  void fail_sync(std::list<Sync>::iterator sync, ErrorCode status) {
+    for (int request_id : sync->requests) {
+      callbacks_->OnPeriodicSyncStarted(request_id, status, 0, sync->sid, sync->address_with_type, sync->phy, 0);
+    }
+    syncs_.erase(sync);
+  }
+
+  template <class View>
+  static void check_complete(CommandCompleteView view) {
+    ASSERT(view.IsValid());
+    auto status_view = View::Create(view);
+    ASSERT(status_view.IsValid());
+    if (status_view.GetStatus() != ErrorCode::SUCCESS) {
+      LOG_WARN(
+          "Got a command complete with status %s for %s",
+          ErrorCodeText(status_view.GetStatus()).c_str(),
+          OpCodeText(view.GetCommandOpCode()).c_str());
+    }
+  }
+
+  ScanningCallback* callbacks_;
+  LeScanningInterface* le_scanning_interface_ = nullptr;
+  os::Handler* handler_ = nullptr;
+  std::unique_ptr<os::Alarm> create_sync_timeout_;
+  std::list<Sync> syncs_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
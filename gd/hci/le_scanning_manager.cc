@@ -13,6 +13,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -21,6 +22,8 @@
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "hci/hci_packets.h"
+#include "hci/le_advertising_cache.h"
+#include "hci/le_periodic_sync_manager.h"
 #include "hci/le_scanning_interface.h"
 #include "hci/le_scanning_manager.h"
 #include "hci/vendor_specific_event_manager.h"
@@ -36,6 +39,7 @@ constexpr uint16_t kLeScanWindowMax = 0x4000;
 constexpr uint16_t kDefaultLeExtendedScanWindow = 4800;
 constexpr uint16_t kLeExtendedScanWindowMax = 0xFFFF;
 constexpr uint16_t kLeScanIntervalMin = 0x0004;
+constexpr uint16_t kScanDutyCycleUnlimited = 1000;  // Per mille
 constexpr uint16_t kLeScanIntervalMax = 0x4000;
 constexpr uint16_t kDefaultLeExtendedScanInterval = 4800;
 constexpr uint16_t kLeExtendedScanIntervalMax = 0xFFFF;
@@ -59,80 +63,6 @@ struct Scanner {
   bool in_use;
 };
 
-class AdvertisingCache {
- public:
-  const std::vector<uint8_t>& Set(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
-  }
-
-  bool Exist(const AddressWithType& address_with_type) {
-    auto it = Find(address_with_type);
-    if (it == items.end()) {
-      return false;
-    }
-    return true;
-  }
-
-  const std::vector<uint8_t>& Append(const AddressWithType& address_with_type, std::vector<uint8_t> data) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(address_with_type, std::move(data));
-    return items.front().data;
-  }
-
-  /* Clear data for device |addr_type, addr| */
-  void Clear(AddressWithType address_with_type) {
-    auto it = Find(address_with_type);
-    if (it != items.end()) {
-      items.erase(it);
-    }
-  }
-
-  void ClearAll() {
-    items.clear();
-  }
-
-  struct Item {
-    AddressWithType address_with_type;
-    std::vector<uint8_t> data;
-
-    Item(const AddressWithType& address_with_type, std::vector<uint8_t> data)
-        : address_with_type(address_with_type), data(data) {}
-  };
-
-  std::list<Item>::iterator Find(const AddressWithType& address_with_type) {
-    for (auto it = items.begin(); it != items.end(); it++) {
-      if (it->address_with_type == address_with_type) {
-        return it;
-      }
-    }
-    return items.end();
-  }
-
-  /* we keep maximum 7 devices in the cache */
-  const size_t cache_max = 1000;
-  std::list<Item> items;
-};
-
 class NullScanningCallback : public ScanningCallback {
   void OnScannerRegistered(const bluetooth::hci::Uuid app_uuid, ScannerId scanner_id, ScanningStatus status) {
     LOG_INFO("OnScannerRegistered in NullScanningCallback");
@@ -172,6 +102,28 @@ class NullScanningCallback : public ScanningCallback {
       ApcfFilterType filter_type, uint8_t available_spaces, ApcfAction action, uint8_t status) {
     LOG_INFO("OnFilterConfigCallback in NullScanningCallback");
   }
+  void OnPeriodicSyncStarted(
+      int request_id,
+      ErrorCode status,
+      uint16_t sync_handle,
+      uint8_t advertising_sid,
+      AddressWithType address_with_type,
+      SecondaryPhyType phy,
+      uint16_t interval) {
+    LOG_INFO("OnPeriodicSyncStarted in NullScanningCallback");
+  }
+  void OnPeriodicSyncReport(
+      int request_id,
+      uint16_t sync_handle,
+      int8_t tx_power,
+      int8_t rssi,
+      DataStatus status,
+      std::vector<uint8_t> data) {
+    LOG_INFO("OnPeriodicSyncReport in NullScanningCallback");
+  }
+  void OnPeriodicSyncLost(int request_id, uint16_t sync_handle) {
+    LOG_INFO("OnPeriodicSyncLost in NullScanningCallback");
+  }
 };
 
 enum class BatchScanState {
@@ -197,7 +149,8 @@ struct BatchScanConfig {
 };
 
 struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback {
-  impl(Module* module) : module_(module), le_scanning_interface_(nullptr) {}
+  impl(Module* module)
+      : module_(module), le_scanning_interface_(nullptr), periodic_sync_manager_(&null_scanning_callback_) {}
 
   ~impl() {
     if (address_manager_registered_) {
@@ -218,6 +171,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     le_address_manager_ = acl_manager->GetLeAddressManager();
     le_scanning_interface_ = hci_layer_->GetLeScanningInterface(
         module_handler_->BindOn(this, &LeScanningManager::impl::handle_scan_results));
+    periodic_sync_manager_.Init(le_scanning_interface_, module_handler_);
     if (controller_->IsSupported(OpCode::LE_SET_EXTENDED_SCAN_PARAMETERS)) {
       api_type_ = ScanApiType::EXTENDED;
       interval_ms_ = kDefaultLeExtendedScanInterval;
@@ -257,6 +211,7 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     batch_scan_config_.current_state = BatchScanState::DISABLED_STATE;
     batch_scan_config_.ref_value = kInvalidScannerId;
     scanning_callbacks_ = &null_scanning_callback_;
+    periodic_sync_manager_.SetScanningCallback(&null_scanning_callback_);
   }
 
   void handle_scan_results(LeMetaEventView event) {
@@ -273,6 +228,15 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
       case hci::SubeventCode::SCAN_TIMEOUT:
         scanning_callbacks_->OnTimeout();
         break;
+      case hci::SubeventCode::PERIODIC_ADVERTISING_SYNC_ESTABLISHED:
+        periodic_sync_manager_.HandleSyncEstablished(LePeriodicAdvertisingSyncEstablishedView::Create(event));
+        break;
+      case hci::SubeventCode::PERIODIC_ADVERTISING_REPORT:
+        periodic_sync_manager_.HandlePeriodicAdvertisingReport(LePeriodicAdvertisingReportView::Create(event));
+        break;
+      case hci::SubeventCode::PERIODIC_ADVERTISING_SYNC_LOST:
+        periodic_sync_manager_.HandleSyncLost(LePeriodicAdvertisingSyncLostView::Create(event));
+        break;
       default:
         LOG_ALWAYS_FATAL("Unknown advertising subevent %s", hci::SubeventCodeText(event.GetSubeventCode()).c_str());
     }
@@ -439,8 +403,9 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
 
     bool is_start = is_legacy && is_scannable && !is_scan_response;
 
-    std::vector<uint8_t> const& adv_data = is_start ? advertising_cache_.Set(address_with_type, advertising_data)
-                                                    : advertising_cache_.Append(address_with_type, advertising_data);
+    std::vector<uint8_t> const& adv_data =
+        is_start ? advertising_cache_.Set(address_with_type, std::move(advertising_data))
+                 : advertising_cache_.Append(address_with_type, advertising_data);
 
     uint8_t data_status = event_type >> kDataStatusBits;
     if (data_status == (uint8_t)DataStatus::CONTINUING) {
@@ -468,10 +433,20 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     advertising_cache_.Clear(address_with_type);
   }
 
+  // Scan window of the scan parameters, shortened to respect the duty cycle limit
+  uint16_t limited_window() const {
+    if (scan_duty_cycle_limit_ >= kScanDutyCycleUnlimited) {
+      return window_ms_;
+    }
+    uint32_t window = interval_ms_ * scan_duty_cycle_limit_ / kScanDutyCycleUnlimited;
+    return std::min<uint32_t>(window_ms_, std::max<uint32_t>(window, kLeScanWindowMin));
+  }
+
   void configure_scan() {
+    uint16_t window = limited_window();
     std::vector<PhyScanParameters> parameter_vector;
     PhyScanParameters phy_scan_parameters;
-    phy_scan_parameters.le_scan_window_ = window_ms_;
+    phy_scan_parameters.le_scan_window_ = window;
     phy_scan_parameters.le_scan_interval_ = interval_ms_;
     phy_scan_parameters.le_scan_type_ = le_scan_type_;
     parameter_vector.push_back(phy_scan_parameters);
@@ -492,14 +467,14 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
         break;
       case ScanApiType::ANDROID_HCI:
         le_scanning_interface_->EnqueueCommand(
-            hci::LeExtendedScanParamsBuilder::Create(LeScanType::ACTIVE, interval_ms_, window_ms_, own_address_type_,
+            hci::LeExtendedScanParamsBuilder::Create(LeScanType::ACTIVE, interval_ms_, window, own_address_type_,
                                                      filter_policy_),
             module_handler_->BindOnce(impl::check_status));
 
         break;
       case ScanApiType::LEGACY:
         le_scanning_interface_->EnqueueCommand(
-            hci::LeSetScanParametersBuilder::Create(LeScanType::ACTIVE, interval_ms_, window_ms_, own_address_type_,
+            hci::LeSetScanParametersBuilder::Create(LeScanType::ACTIVE, interval_ms_, window, own_address_type_,
                                                     filter_policy_),
             module_handler_->BindOnce(impl::check_status));
         break;
@@ -628,6 +603,23 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     window_ms_ = scan_window;
   }
 
+  void set_scan_duty_cycle_limit(uint16_t limit) {
+    if (limit == scan_duty_cycle_limit_) {
+      return;
+    }
+    scan_duty_cycle_limit_ = limit;
+    LOG_INFO("Scan duty cycle limit:%hu window:%hu interval:%u", limit, limited_window(), interval_ms_);
+    if (paused_) {
+      configure_on_resume_ = true;
+      return;
+    }
+    // A running scan is reconfigured right away, otherwise the limit applies at the next scan
+    if (is_scanning_) {
+      configure_scan();
+      start_scan();
+    }
+  }
+
   void scan_filter_enable(bool enable) {
     if (!is_filter_support_) {
       LOG_WARN("Advertising filter is not supported");
@@ -1001,8 +993,23 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
     tracker_id = scanner_id;
   }
 
+  void start_sync(int request_id, uint8_t sid, AddressWithType address_with_type, uint16_t skip, uint16_t timeout) {
+    if (!controller_->IsSupported(OpCode::LE_PERIODIC_ADVERTISING_CREATE_SYNC)) {
+      LOG_WARN("Periodic advertising sync is not supported");
+      scanning_callbacks_->OnPeriodicSyncStarted(
+          request_id, ErrorCode::UNKNOWN_HCI_COMMAND, 0, sid, address_with_type, SecondaryPhyType::NO_PACKETS, 0);
+      return;
+    }
+    periodic_sync_manager_.StartSync(request_id, sid, address_with_type, skip, timeout);
+  }
+
+  void stop_sync(int request_id) {
+    periodic_sync_manager_.StopSync(request_id);
+  }
+
   void register_scanning_callback(ScanningCallback* scanning_callbacks) {
     scanning_callbacks_ = scanning_callbacks;
+    periodic_sync_manager_.SetScanningCallback(scanning_callbacks);
   }
 
   void on_advertising_filter_complete(CommandCompleteView view) {
@@ -1204,8 +1211,12 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   void OnResume() override {
     paused_ = false;
     if (scan_on_resume_ == true) {
+      if (configure_on_resume_) {
+        configure_scan();
+      }
       start_scan();
     }
+    configure_on_resume_ = false;
     le_address_manager_->AckResume(this);
   }
 
@@ -1225,18 +1236,21 @@ struct LeScanningManager::impl : public bluetooth::hci::LeAddressManagerCallback
   bool is_scanning_ = false;
   bool scan_on_resume_ = false;
   bool paused_ = false;
-  AdvertisingCache advertising_cache_;
+  bool configure_on_resume_ = false;
+  LeAdvertisingCache advertising_cache_;
   bool is_filter_support_ = false;
   bool is_batch_scan_support_ = false;
 
   LeScanType le_scan_type_ = LeScanType::ACTIVE;
   uint32_t interval_ms_{1000};
   uint16_t window_ms_{1000};
+  uint16_t scan_duty_cycle_limit_{kScanDutyCycleUnlimited};
   OwnAddressType own_address_type_{OwnAddressType::PUBLIC_DEVICE_ADDRESS};
   LeScanningFilterPolicy filter_policy_{LeScanningFilterPolicy::ACCEPT_ALL};
   BatchScanConfig batch_scan_config_;
   std::map<ScannerId, std::vector<uint8_t>> batch_scan_result_cache_;
   ScannerId tracker_id = kInvalidScannerId;
+  PeriodicSyncManager periodic_sync_manager_;
 
   static void check_status(CommandCompleteView view) {
     switch (view.GetCommandOpCode()) {
@@ -1316,6 +1330,10 @@ void LeScanningManager::SetScanParameters(LeScanType scan_type, uint16_t scan_in
   CallOn(pimpl_.get(), &impl::set_scan_parameters, scan_type, scan_interval, scan_window);
 }
 
+void LeScanningManager::SetScanDutyCycleLimit(uint16_t limit) {
+  CallOn(pimpl_.get(), &impl::set_scan_duty_cycle_limit, limit);
+}
+
 void LeScanningManager::ScanFilterEnable(bool enable) {
   CallOn(pimpl_.get(), &impl::scan_filter_enable, enable);
 }
@@ -1370,6 +1388,15 @@ void LeScanningManager::TrackAdvertiser(ScannerId scanner_id) {
   CallOn(pimpl_.get(), &impl::track_advertiser, scanner_id);
 }
 
+void LeScanningManager::StartSync(
+    int request_id, uint8_t sid, AddressWithType address_with_type, uint16_t skip, uint16_t timeout) {
+  CallOn(pimpl_.get(), &impl::start_sync, request_id, sid, address_with_type, skip, timeout);
+}
+
+void LeScanningManager::StopSync(int request_id) {
+  CallOn(pimpl_.get(), &impl::stop_sync, request_id);
+}
+
 void LeScanningManager::RegisterScanningCallback(ScanningCallback* scanning_callback) {
   CallOn(pimpl_.get(), &impl::register_scanning_callback, scanning_callback);
 }
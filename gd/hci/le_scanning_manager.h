@@ -74,6 +74,22 @@ class ScanningCallback {
   virtual void OnFilterParamSetup(uint8_t available_spaces, ApcfAction action, uint8_t status) = 0;
   virtual void OnFilterConfigCallback(
       ApcfFilterType filter_type, uint8_t available_spaces, ApcfAction action, uint8_t status) = 0;
+  virtual void OnPeriodicSyncStarted(
+      int request_id,
+      ErrorCode status,
+      uint16_t sync_handle,
+      uint8_t advertising_sid,
+      AddressWithType address_with_type,
+      SecondaryPhyType phy,
+      uint16_t interval) = 0;
+  virtual void OnPeriodicSyncReport(
+      int request_id,
+      uint16_t sync_handle,
+      int8_t tx_power,
+      int8_t rssi,
+      DataStatus status,
+      std::vector<uint8_t> data) = 0;
+  virtual void OnPeriodicSyncLost(int request_id, uint16_t sync_handle) = 0;
 };
 
 class AdvertisingPacketContentFilterCommand {
@@ -128,6 +144,9 @@ class LeScanningManager : public bluetooth::Module {
 
   void SetScanParameters(LeScanType scan_type, uint16_t scan_interval, uint16_t scan_window);
 
+  // Caps the scan window to |limit| per mille of the scan interval, 1000 lifts the cap
+  void SetScanDutyCycleLimit(uint16_t limit);
+
   /* Scan filter */
   void ScanFilterEnable(bool enable);
 
@@ -152,6 +171,10 @@ class LeScanningManager : public bluetooth::Module {
 
   void TrackAdvertiser(ScannerId scanner_id);
 
+  /* Periodic advertising sync, shared by all the requests for the same advertising set */
+  void StartSync(int request_id, uint8_t sid, AddressWithType address_with_type, uint16_t skip, uint16_t timeout);
+  void StopSync(int request_id);
+
   void RegisterScanningCallback(ScanningCallback* scanning_callback);
 
   static const ModuleFactory Factory;
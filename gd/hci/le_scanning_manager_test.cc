@@ -38,6 +38,7 @@ namespace {
 using packet::kLittleEndian;
 using packet::PacketView;
 using packet::RawBuilder;
+using testing::_;
 
 PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilder> packet) {
   auto bytes = std::make_shared<std::vector<uint8_t>>();
@@ -106,6 +107,10 @@ class TestHciLayer : public HciLayer {
     }
   }
 
+  size_t CommandQueueSize() {
+    return command_queue_.size();
+  }
+
   ConnectionManagementCommandView GetCommand(OpCode op_code) {
     CommandView command_packet_view = GetLastCommand();
     auto command = ConnectionManagementCommandView::Create(AclCommandView::Create(command_packet_view));
@@ -333,6 +338,28 @@ class LeScanningManagerTest : public ::testing::Test {
         OnFilterConfigCallback,
         (ApcfFilterType filter_type, uint8_t available_spaces, ApcfAction action, uint8_t status),
         (override));
+    MOCK_METHOD(
+        void,
+        OnPeriodicSyncStarted,
+        (int request_id,
+         ErrorCode status,
+         uint16_t sync_handle,
+         uint8_t advertising_sid,
+         AddressWithType address_with_type,
+         SecondaryPhyType phy,
+         uint16_t interval),
+        (override));
+    MOCK_METHOD(
+        void,
+        OnPeriodicSyncReport,
+        (int request_id,
+         uint16_t sync_handle,
+         int8_t tx_power,
+         int8_t rssi,
+         DataStatus status,
+         std::vector<uint8_t> data),
+        (override));
+    MOCK_METHOD(void, OnPeriodicSyncLost, (int request_id, uint16_t sync_handle), (override));
   } mock_callbacks_;
 
   OpCode param_opcode_{OpCode::LE_SET_ADVERTISING_PARAMETERS};
@@ -553,6 +580,100 @@ TEST_F(LeExtendedScanningManagerTest, start_scan_test) {
   test_hci_layer_->IncomingLeMetaEvent(LeExtendedAdvertisingReportBuilder::Create({report}));
 }
 
+TEST_F(LeExtendedScanningManagerTest, periodic_sync_shared_test) {
+  test_controller_->AddSupported(OpCode::LE_PERIODIC_ADVERTISING_CREATE_SYNC);
+  Address address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  AddressWithType address_with_type(address, AddressType::RANDOM_DEVICE_ADDRESS);
+
+  auto next_command_future = test_hci_layer_->GetCommandFuture();
+  le_scanning_manager->StartSync(1, 0x02, address_with_type, 0, 0x0100);
+  auto result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  auto create_sync =
+      LePeriodicAdvertisingCreateSyncView::Create(LeScanningCommandView::Create(test_hci_layer_->GetLastCommand()));
+  ASSERT_TRUE(create_sync.IsValid());
+  EXPECT_EQ(0x02, create_sync.GetAdvertisingSid());
+  EXPECT_EQ(address, create_sync.GetAdvertiserAddress());
+  test_hci_layer_->IncomingEvent(LePeriodicAdvertisingCreateSyncStatusBuilder::Create(ErrorCode::SUCCESS, 0x01));
+
+  // A second request for the same train joins the pending sync
+  le_scanning_manager->StartSync(2, 0x02, address_with_type, 0, 0x0100);
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+  EXPECT_EQ(0u, test_hci_layer_->CommandQueueSize());
+
+  EXPECT_CALL(
+      mock_callbacks_, OnPeriodicSyncStarted(1, ErrorCode::SUCCESS, 0x0010, 0x02, _, SecondaryPhyType::LE_2M, _));
+  EXPECT_CALL(
+      mock_callbacks_, OnPeriodicSyncStarted(2, ErrorCode::SUCCESS, 0x0010, 0x02, _, SecondaryPhyType::LE_2M, _));
+  test_hci_layer_->IncomingLeMetaEvent(LePeriodicAdvertisingSyncEstablishedBuilder::Create(
+      ErrorCode::SUCCESS,
+      0x0010,
+      0x02,
+      AddressType::RANDOM_DEVICE_ADDRESS,
+      address,
+      SecondaryPhyType::LE_2M,
+      0x0100,
+      ClockAccuracy::PPM_500));
+
+  // Every report of the sync goes to both requests
+  std::vector<uint8_t> data = {0x03, 0xff, 0x01, 0x02};
+  EXPECT_CALL(mock_callbacks_, OnPeriodicSyncReport(1, 0x0010, _, _, DataStatus::COMPLETE, data));
+  EXPECT_CALL(mock_callbacks_, OnPeriodicSyncReport(2, 0x0010, _, _, DataStatus::COMPLETE, data));
+  test_hci_layer_->IncomingLeMetaEvent(
+      LePeriodicAdvertisingReportBuilder::Create(0x0010, 0x7f, 0xc4, 0xff, DataStatus::COMPLETE, data));
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+
+  // The sync lives until its last request stops
+  le_scanning_manager->StopSync(1);
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+  EXPECT_EQ(0u, test_hci_layer_->CommandQueueSize());
+
+  next_command_future = test_hci_layer_->GetCommandFuture();
+  le_scanning_manager->StopSync(2);
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  auto terminate_sync =
+      LePeriodicAdvertisingTerminateSyncView::Create(LeScanningCommandView::Create(test_hci_layer_->GetLastCommand()));
+  ASSERT_TRUE(terminate_sync.IsValid());
+  EXPECT_EQ(0x0010, terminate_sync.GetSyncHandle());
+}
+
+TEST_F(LeExtendedScanningManagerTest, periodic_sync_creation_serialized_test) {
+  test_controller_->AddSupported(OpCode::LE_PERIODIC_ADVERTISING_CREATE_SYNC);
+  Address address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  AddressWithType address_with_type(address, AddressType::RANDOM_DEVICE_ADDRESS);
+
+  auto next_command_future = test_hci_layer_->GetCommandFuture();
+  le_scanning_manager->StartSync(1, 0x02, address_with_type, 0, 0x0100);
+  auto result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  test_hci_layer_->GetLastCommand();
+  test_hci_layer_->IncomingEvent(LePeriodicAdvertisingCreateSyncStatusBuilder::Create(ErrorCode::SUCCESS, 0x01));
+
+  // The controller creates one sync at a time
+  le_scanning_manager->StartSync(2, 0x03, address_with_type, 0, 0x0100);
+  fake_registry_.SynchronizeModuleHandler(&LeScanningManager::Factory, std::chrono::milliseconds(20));
+  EXPECT_EQ(0u, test_hci_layer_->CommandQueueSize());
+
+  EXPECT_CALL(mock_callbacks_, OnPeriodicSyncStarted(1, ErrorCode::CONNECTION_FAILED_ESTABLISHMENT, _, 0x02, _, _, _));
+  next_command_future = test_hci_layer_->GetCommandFuture();
+  test_hci_layer_->IncomingLeMetaEvent(LePeriodicAdvertisingSyncEstablishedBuilder::Create(
+      ErrorCode::CONNECTION_FAILED_ESTABLISHMENT,
+      0x0000,
+      0x02,
+      AddressType::RANDOM_DEVICE_ADDRESS,
+      address,
+      SecondaryPhyType::NO_PACKETS,
+      0x0000,
+      ClockAccuracy::PPM_500));
+  result = next_command_future.wait_for(std::chrono::duration(std::chrono::milliseconds(100)));
+  ASSERT_EQ(std::future_status::ready, result);
+  auto create_sync =
+      LePeriodicAdvertisingCreateSyncView::Create(LeScanningCommandView::Create(test_hci_layer_->GetLastCommand()));
+  ASSERT_TRUE(create_sync.IsValid());
+  EXPECT_EQ(0x03, create_sync.GetAdvertisingSid());
+}
+
 }  // namespace
 }  // namespace hci
 }  // namespace bluetooth
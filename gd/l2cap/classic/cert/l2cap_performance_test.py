@@ -13,8 +13,10 @@
 #   See the License for the specific language governing permissions and
 #   limitations under the License.
 
+import os
 from datetime import datetime, timedelta
 
+from acts.context import get_current_context
 from bluetooth_packets_python3 import RawBuilder
 from cert.matchers import L2capMatchers
 from cert.truth import assertThat
@@ -33,6 +35,8 @@ class L2capPerformanceTest(L2capTestBase):
         self.performance_test_logger = PerformanceTestLogger()
 
     def teardown_test(self):
+        self.performance_test_logger.dump_json(
+            os.path.join(get_current_context().get_full_output_path(), 'performance.json'))
         super().teardown_test()
 
     def _basic_mode_tx(self, mtu, packets):
@@ -33,9 +33,12 @@ bluetooth::l2cap::classic::internal::DumpsysHelper::DumpActiveDynamicChannels(
     const l2cap::internal::DynamicChannelAllocator& channel_allocator) const {
   std::vector<flatbuffers::Offset<bluetooth::l2cap::classic::ChannelData>> channel_offsets;
 
-  for (auto it = channel_allocator.channels_.cbegin(); it != channel_allocator.channels_.cend(); ++it) {
+  for (const auto& channel : channel_allocator.channels_) {
+    if (channel == nullptr) {
+      continue;
+    }
     ChannelDataBuilder builder(*fb_builder);
-    builder.add_cid(it->first);
+    builder.add_cid(channel->GetCid());
     channel_offsets.push_back(builder.Finish());
   }
   return channel_offsets;
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace bluetooth {
@@ -28,6 +29,9 @@ class Fcs {
 
   void AddByte(uint8_t byte);
 
+  // Same as calling AddByte() for each of the |size| bytes at |data|, eight bytes at a time
+  void AddBytes(const uint8_t* data, size_t size);
+
   uint16_t GetChecksum() const;
 
  private:
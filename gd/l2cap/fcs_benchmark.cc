@@ -0,0 +1,51 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "l2cap/fcs.h"
+
+using ::benchmark::State;
+using ::bluetooth::l2cap::Fcs;
+
+// FCS of an I-frame of range(0) bytes
+static void BM_Fcs_add_byte(State& state) {
+  std::vector<uint8_t> frame(state.range(0), 0x5a);
+  for (auto _ : state) {
+    Fcs fcs;
+    fcs.Initialize();
+    for (uint8_t byte : frame) {
+      fcs.AddByte(byte);
+    }
+    ::benchmark::DoNotOptimize(fcs.GetChecksum());
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_Fcs_add_byte)->Arg(64)->Arg(1021);
+
+static void BM_Fcs_add_bytes(State& state) {
+  std::vector<uint8_t> frame(state.range(0), 0x5a);
+  for (auto _ : state) {
+    Fcs fcs;
+    fcs.Initialize();
+    fcs.AddBytes(frame.data(), frame.size());
+    ::benchmark::DoNotOptimize(fcs.GetChecksum());
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_Fcs_add_bytes)->Arg(64)->Arg(1021);
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/fcs.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace l2cap {
+namespace {
+
+// Bit by bit reference of the FCS
+uint16_t ReferenceFcs(const std::vector<uint8_t>& bytes) {
+  uint16_t crc = 0;
+  for (uint8_t byte : bytes) {
+    crc ^= byte;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+std::vector<uint8_t> TestBytes(size_t size) {
+  std::vector<uint8_t> bytes(size);
+  uint32_t state = 12345;
+  for (auto& byte : bytes) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(state >> 16);
+  }
+  return bytes;
+}
+
+TEST(FcsTest, known_value) {
+  const std::vector<uint8_t> bytes = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  Fcs fcs;
+  fcs.Initialize();
+  fcs.AddBytes(bytes.data(), bytes.size());
+  EXPECT_EQ(fcs.GetChecksum(), 0xbb3d);
+}
+
+TEST(FcsTest, add_bytes_matches_add_byte) {
+  for (size_t size = 0; size < 100; size++) {
+    auto bytes = TestBytes(size);
+    Fcs by_byte;
+    by_byte.Initialize();
+    for (uint8_t byte : bytes) {
+      by_byte.AddByte(byte);
+    }
+    Fcs by_bytes;
+    by_bytes.Initialize();
+    by_bytes.AddBytes(bytes.data(), bytes.size());
+    EXPECT_EQ(by_byte.GetChecksum(), ReferenceFcs(bytes)) << "size " << size;
+    EXPECT_EQ(by_bytes.GetChecksum(), ReferenceFcs(bytes)) << "size " << size;
+  }
+}
+
+TEST(FcsTest, fragments) {
+  // A frame received in several fragments, mixing both ways of adding bytes
+  auto bytes = TestBytes(1021);
+  for (size_t split : {1, 7, 8, 9, 500, 1020}) {
+    Fcs fcs;
+    fcs.Initialize();
+    fcs.AddBytes(bytes.data(), split);
+    fcs.AddByte(bytes[split]);
+    fcs.AddBytes(bytes.data() + split + 1, bytes.size() - split - 1);
+    EXPECT_EQ(fcs.GetChecksum(), ReferenceFcs(bytes)) << "split " << split;
+  }
+}
+
+}  // namespace
+}  // namespace l2cap
+}  // namespace bluetooth
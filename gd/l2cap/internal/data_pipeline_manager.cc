@@ -31,6 +31,7 @@ void DataPipelineManager::AttachChannel(Cid cid, std::shared_ptr<ChannelImpl> ch
   ASSERT(sender_map_.find(cid) == sender_map_.end());
   sender_map_.emplace(std::piecewise_construct, std::forward_as_tuple(cid),
                       std::forward_as_tuple(handler_, link_, scheduler_.get(), channel, mode));
+  scheduler_->SetChannelPriority(cid, GetDefaultChannelPriority(cid));
 }
 
 void DataPipelineManager::DetachChannel(Cid cid) {
@@ -62,6 +63,16 @@ void DataPipelineManager::SetChannelTxPriority(Cid cid, bool high_priority) {
   scheduler_->SetChannelTxPriority(cid, high_priority);
 }
 
+void DataPipelineManager::SetChannelPriority(Cid cid, ChannelPriority priority) {
+  ASSERT(sender_map_.find(cid) != sender_map_.end());
+  scheduler_->SetChannelPriority(cid, priority);
+}
+
+void DataPipelineManager::SetChannelQuantum(Cid cid, int quantum) {
+  ASSERT(sender_map_.find(cid) != sender_map_.end());
+  scheduler_->SetChannelQuantum(cid, quantum);
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
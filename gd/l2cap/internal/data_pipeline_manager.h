@@ -27,7 +27,7 @@
 #include "l2cap/internal/channel_impl.h"
 #include "l2cap/internal/receiver.h"
 #include "l2cap/internal/scheduler.h"
-#include "l2cap/internal/scheduler_fifo.h"
+#include "l2cap/internal/scheduler_priority.h"
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/mtu.h"
 #include "os/handler.h"
@@ -56,17 +56,21 @@ class DataPipelineManager {
   using LowerQueueUpEnd = common::BidiQueueEnd<LowerEnqueue, LowerDequeue>;
 
   DataPipelineManager(os::Handler* handler, ILink* link, LowerQueueUpEnd* link_queue_up_end)
-      : handler_(handler), link_(link), scheduler_(std::make_unique<Fifo>(this, link_queue_up_end, handler)),
+      : handler_(handler), link_(link), scheduler_(std::make_unique<SchedulerPriority>(this, link_queue_up_end, handler)),
         receiver_(link_queue_up_end, handler, this) {}
 
   using ChannelMode = Sender::ChannelMode;
+  using ChannelPriority = Scheduler::ChannelPriority;
 
+  // The channel is scheduled at the default priority of its cid until SetChannelPriority() is called
   virtual void AttachChannel(Cid cid, std::shared_ptr<ChannelImpl> channel, ChannelMode mode);
   virtual void DetachChannel(Cid cid);
   virtual DataController* GetDataController(Cid cid);
   virtual void OnPacketSent(Cid cid);
   virtual void UpdateClassicConfiguration(Cid cid, classic::internal::ChannelConfigurationState config);
   virtual void SetChannelTxPriority(Cid cid, bool high_priority);
+  virtual void SetChannelPriority(Cid cid, ChannelPriority priority);
+  virtual void SetChannelQuantum(Cid cid, int quantum);
   virtual ~DataPipelineManager() = default;
 
  private:
@@ -37,6 +37,8 @@ class MockDataPipelineManager : public DataPipelineManager {
   MOCK_METHOD(void, DetachChannel, (Cid), (override));
   MOCK_METHOD(DataController*, GetDataController, (Cid), (override));
   MOCK_METHOD(void, OnPacketSent, (Cid), (override));
+  MOCK_METHOD(void, SetChannelPriority, (Cid, ChannelPriority), (override));
+  MOCK_METHOD(void, SetChannelQuantum, (Cid, int), (override));
 };
 
 }  // namespace testing
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <unordered_map>
 
 #include "l2cap/cid.h"
@@ -27,101 +28,137 @@ namespace bluetooth {
 namespace l2cap {
 namespace internal {
 
+namespace {
+constexpr size_t kBitsPerWord = 64;
+constexpr size_t kNumDynamicCids = kLastDynamicChannel - kFirstDynamicChannel + 1;
+}  // namespace
+
+Cid DynamicChannelAllocator::AllocateCid() {
+  size_t word = first_free_word_;
+  while (word < used_cid_bitmap_.size() && used_cid_bitmap_[word] == UINT64_MAX) {
+    word++;
+  }
+  if (word == used_cid_bitmap_.size()) {
+    if (word * kBitsPerWord >= kNumDynamicCids) {
+      return kInvalidCid;
+    }
+    used_cid_bitmap_.push_back(0);
+  }
+  size_t bit = __builtin_ctzll(~used_cid_bitmap_[word]);
+  size_t index = word * kBitsPerWord + bit;
+  if (index >= kNumDynamicCids) {
+    return kInvalidCid;
+  }
+  used_cid_bitmap_[word] |= uint64_t{1} << bit;
+  first_free_word_ = word;
+  return kFirstDynamicChannel + index;
+}
+
+void DynamicChannelAllocator::ReleaseCid(Cid cid) {
+  if (cid < kFirstDynamicChannel) {
+    return;
+  }
+  size_t index = cid - kFirstDynamicChannel;
+  size_t word = index / kBitsPerWord;
+  if (word >= used_cid_bitmap_.size()) {
+    return;
+  }
+  used_cid_bitmap_[word] &= ~(uint64_t{1} << (index % kBitsPerWord));
+  first_free_word_ = std::min(first_free_word_, word);
+}
+
+std::shared_ptr<DynamicChannelImpl> DynamicChannelAllocator::AddChannel(Cid cid, Psm psm, Cid remote_cid) {
+  size_t index = cid - kFirstDynamicChannel;
+  if (index >= channels_.size()) {
+    channels_.resize(index + 1);
+  }
+  auto& channel = channels_[index];
+  ASSERT_LOG(channel == nullptr, "Failed to create channel for psm 0x%x device %s", psm,
+             link_->GetDevice().ToString().c_str());
+  channel = std::make_shared<DynamicChannelImpl>(psm, cid, remote_cid, link_, l2cap_handler_);
+  channels_by_remote_cid_.emplace(remote_cid, channel);
+  psm_use_count_[psm]++;
+  num_channels_++;
+  return channel;
+}
+
 std::shared_ptr<DynamicChannelImpl> DynamicChannelAllocator::AllocateChannel(Psm psm, Cid remote_cid) {
-  if (used_remote_cid_.find(remote_cid) != used_remote_cid_.end()) {
+  if (channels_by_remote_cid_.find(remote_cid) != channels_by_remote_cid_.end()) {
     LOG_INFO("Remote cid 0x%x is used", remote_cid);
     return nullptr;
   }
-  Cid cid = kFirstDynamicChannel;
-  for (; cid <= kLastDynamicChannel; cid++) {
-    if (used_cid_.find(cid) == used_cid_.end()) break;
-  }
-  if (cid > kLastDynamicChannel) {
+  Cid cid = AllocateCid();
+  if (cid == kInvalidCid) {
     LOG_WARN("All cid are used");
     return nullptr;
   }
-  auto elem =
-      channels_.try_emplace(cid, std::make_shared<DynamicChannelImpl>(psm, cid, remote_cid, link_, l2cap_handler_));
-  ASSERT_LOG(elem.second, "Failed to create channel for psm 0x%x device %s", psm,
-             link_->GetDevice().ToString().c_str());
-  ASSERT(elem.first->second != nullptr);
-  used_remote_cid_.insert(remote_cid);
-  used_cid_.insert(cid);
-  return elem.first->second;
+  return AddChannel(cid, psm, remote_cid);
 }
 
 std::shared_ptr<DynamicChannelImpl> DynamicChannelAllocator::AllocateReservedChannel(Cid reserved_cid, Psm psm,
                                                                                      Cid remote_cid) {
-  if (used_remote_cid_.find(remote_cid) != used_remote_cid_.end()) {
+  if (channels_by_remote_cid_.find(remote_cid) != channels_by_remote_cid_.end()) {
     LOG_INFO("Remote cid 0x%x is used", remote_cid);
     return nullptr;
   }
-  auto elem = channels_.try_emplace(
-      reserved_cid, std::make_shared<DynamicChannelImpl>(psm, reserved_cid, remote_cid, link_, l2cap_handler_));
-  ASSERT_LOG(elem.second, "Failed to create channel for psm 0x%x device %s", psm,
-             link_->GetDevice().ToString().c_str());
-  ASSERT(elem.first->second != nullptr);
-  used_remote_cid_.insert(remote_cid);
-  return elem.first->second;
+  ASSERT_LOG(reserved_cid >= kFirstDynamicChannel, "Invalid reserved cid 0x%x", reserved_cid);
+  return AddChannel(reserved_cid, psm, remote_cid);
 }
 
 Cid DynamicChannelAllocator::ReserveChannel() {
-  Cid cid = kFirstDynamicChannel;
-  for (; cid <= kLastDynamicChannel; cid++) {
-    if (used_cid_.find(cid) == used_cid_.end()) break;
-  }
-  if (cid > kLastDynamicChannel) {
+  Cid cid = AllocateCid();
+  if (cid == kInvalidCid) {
     LOG_WARN("All cid are used");
-    return kInvalidCid;
   }
-  used_cid_.insert(cid);
   return cid;
 }
 
 void DynamicChannelAllocator::FreeChannel(Cid cid) {
-  used_cid_.erase(cid);
+  ReleaseCid(cid);
   auto channel = FindChannelByCid(cid);
   if (channel == nullptr) {
     LOG_INFO("Channel is not in use: cid %d, device %s", cid, link_->GetDevice().ToString().c_str());
     return;
   }
-  used_remote_cid_.erase(channel->GetRemoteCid());
-  channels_.erase(cid);
+  channels_by_remote_cid_.erase(channel->GetRemoteCid());
+  auto psm_count = psm_use_count_.find(channel->GetPsm());
+  if (--psm_count->second == 0) {
+    psm_use_count_.erase(psm_count);
+  }
+  channels_[cid - kFirstDynamicChannel].reset();
+  num_channels_--;
 }
 
 bool DynamicChannelAllocator::IsPsmUsed(Psm psm) const {
-  for (const auto& channel : channels_) {
-    if (channel.second->GetPsm() == psm) {
-      return true;
-    }
-  }
-  return false;
+  return psm_use_count_.find(psm) != psm_use_count_.end();
 }
 
 std::shared_ptr<DynamicChannelImpl> DynamicChannelAllocator::FindChannelByCid(Cid cid) {
-  if (channels_.find(cid) == channels_.end()) {
+  size_t index = cid - kFirstDynamicChannel;
+  if (cid < kFirstDynamicChannel || index >= channels_.size() || channels_[index] == nullptr) {
     LOG_WARN("Can't find cid %d", cid);
     return nullptr;
   }
-  return channels_.find(cid)->second;
+  return channels_[index];
 }
 
 std::shared_ptr<DynamicChannelImpl> DynamicChannelAllocator::FindChannelByRemoteCid(Cid remote_cid) {
-  for (auto& channel : channels_) {
-    if (channel.second->GetRemoteCid() == remote_cid) {
-      return channel.second;
-    }
+  auto channel = channels_by_remote_cid_.find(remote_cid);
+  if (channel == channels_by_remote_cid_.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return channel->second;
 }
 
 size_t DynamicChannelAllocator::NumberOfChannels() const {
-  return channels_.size();
+  return num_channels_;
 }
 
 void DynamicChannelAllocator::OnAclDisconnected(hci::ErrorCode reason) {
-  for (auto& elem : channels_) {
-    elem.second->OnClosed(reason);
+  for (auto& channel : channels_) {
+    if (channel != nullptr) {
+      channel->OnClosed(reason);
+    }
   }
 }
 
@@ -16,8 +16,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "hci/acl_manager.h"
 #include "l2cap/cid.h"
@@ -75,11 +76,24 @@ class DynamicChannelAllocator {
 
  private:
   friend class bluetooth::l2cap::classic::internal::DumpsysHelper;
+
+  // Marks the lowest unused cid as used and returns it, kInvalidCid if all are used
+  Cid AllocateCid();
+  void ReleaseCid(Cid cid);
+  std::shared_ptr<DynamicChannelImpl> AddChannel(Cid cid, Psm psm, Cid remote_cid);
+
   l2cap::internal::ILink* link_;
   os::Handler* l2cap_handler_;
-  std::unordered_set<Cid> used_cid_;
-  std::unordered_map<Cid, std::shared_ptr<DynamicChannelImpl>> channels_;
-  std::unordered_set<Cid> used_remote_cid_;
+  // Bit i is set when cid kFirstDynamicChannel + i is allocated or reserved. Cids are handed out lowest first, so the
+  // bitmap only grows to cover as many channels as the link had at once.
+  std::vector<uint64_t> used_cid_bitmap_;
+  // No word of used_cid_bitmap_ before this one has a free cid
+  size_t first_free_word_ = 0;
+  // Indexed by cid - kFirstDynamicChannel, nullptr for a cid without a channel
+  std::vector<std::shared_ptr<DynamicChannelImpl>> channels_;
+  size_t num_channels_ = 0;
+  std::unordered_map<Cid, std::shared_ptr<DynamicChannelImpl>> channels_by_remote_cid_;
+  std::unordered_map<Psm, size_t> psm_use_count_;
 };
 
 }  // namespace internal
@@ -16,6 +16,7 @@
 
 #include "l2cap/internal/dynamic_channel_allocator.h"
 #include "l2cap/classic/internal/link_mock.h"
+#include "l2cap/internal/dynamic_channel_impl.h"
 #include "l2cap/internal/parameter_provider_mock.h"
 
 #include <gmock/gmock.h>
@@ -87,6 +88,41 @@ TEST_F(L2capClassicDynamicChannelAllocatorTest, reserve_channel) {
   EXPECT_FALSE(channel_allocator_->IsPsmUsed(psm));
 }
 
+TEST_F(L2capClassicDynamicChannelAllocatorTest, allocate_lowest_free_cid) {
+  Psm psm = 0x03;
+  std::vector<std::shared_ptr<DynamicChannelImpl>> channels;
+  for (Cid i = 0; i < 100; i++) {
+    channels.push_back(channel_allocator_->AllocateChannel(psm, kFirstDynamicChannel + i));
+    ASSERT_NE(channels.back(), nullptr);
+    EXPECT_EQ(channels.back()->GetCid(), kFirstDynamicChannel + i);
+  }
+  EXPECT_EQ(channel_allocator_->NumberOfChannels(), 100u);
+
+  channel_allocator_->FreeChannel(kFirstDynamicChannel + 70);
+  channel_allocator_->FreeChannel(kFirstDynamicChannel + 5);
+  EXPECT_EQ(channel_allocator_->FindChannelByCid(kFirstDynamicChannel + 5), nullptr);
+  EXPECT_EQ(channel_allocator_->FindChannelByRemoteCid(kFirstDynamicChannel + 5), nullptr);
+  EXPECT_EQ(channel_allocator_->NumberOfChannels(), 98u);
+
+  EXPECT_EQ(channel_allocator_->ReserveChannel(), kFirstDynamicChannel + 5);
+  auto channel = channel_allocator_->AllocateChannel(psm, 0x1000);
+  ASSERT_NE(channel, nullptr);
+  EXPECT_EQ(channel->GetCid(), kFirstDynamicChannel + 70);
+  EXPECT_EQ(channel_allocator_->FindChannelByRemoteCid(0x1000), channel);
+  EXPECT_EQ(channel_allocator_->FindChannelByCid(kFirstDynamicChannel + 70), channel);
+  EXPECT_EQ(channel_allocator_->AllocateChannel(psm, kFirstDynamicChannel + 99), nullptr);
+}
+
+TEST_F(L2capClassicDynamicChannelAllocatorTest, psm_used_until_last_channel_freed) {
+  Psm psm = 0x03;
+  auto channel1 = channel_allocator_->AllocateChannel(psm, kFirstDynamicChannel);
+  auto channel2 = channel_allocator_->AllocateChannel(psm, kFirstDynamicChannel + 1);
+  channel_allocator_->FreeChannel(channel1->GetCid());
+  EXPECT_TRUE(channel_allocator_->IsPsmUsed(psm));
+  channel_allocator_->FreeChannel(channel2->GetCid());
+  EXPECT_FALSE(channel_allocator_->IsPsmUsed(psm));
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
@@ -23,8 +23,7 @@
 #include "common/bind.h"
 #include "l2cap/internal/ilink.h"
 #include "os/alarm.h"
-#include "packet/fragmenting_inserter.h"
-#include "packet/raw_builder.h"
+#include "packet/slice_builder.h"
 
 namespace bluetooth {
 namespace l2cap {
@@ -80,9 +79,10 @@ struct ErtmController::impl {
   int unacked_frames_ = 0;
   // TODO: Instead of having a map, we may consider about a better data structure
   // Map from TxSeq to (SAR, SDU size for START packet, information payload)
-  std::map<uint8_t, std::tuple<SegmentationAndReassembly, uint16_t, std::shared_ptr<packet::RawBuilder>>> unacked_list_;
+  std::map<uint8_t, std::tuple<SegmentationAndReassembly, uint16_t, std::shared_ptr<packet::SliceBuilder>>>
+      unacked_list_;
   // Stores (SAR, SDU size for START packet, information payload)
-  std::queue<std::tuple<SegmentationAndReassembly, uint16_t, std::unique_ptr<packet::RawBuilder>>> pending_frames_;
+  std::queue<std::tuple<SegmentationAndReassembly, uint16_t, std::unique_ptr<packet::SliceBuilder>>> pending_frames_;
   int retry_count_ = 0;
   std::map<uint8_t /* tx_seq, */, int /* count */> retry_i_frames_;
   bool rnr_sent_ = false;
@@ -97,7 +97,7 @@ struct ErtmController::impl {
 
   // Events (@see 8.6.5.4)
 
-  void data_request(SegmentationAndReassembly sar, std::unique_ptr<packet::RawBuilder> pdu, uint16_t sdu_size = 0) {
+  void data_request(SegmentationAndReassembly sar, std::unique_ptr<packet::SliceBuilder> pdu, uint16_t sdu_size = 0) {
     // Note: sdu_size only applies to START packet
     if (tx_state_ == TxState::XMIT && !remote_busy() && rem_window_not_full()) {
       send_data(sar, sdu_size, std::move(pdu));
@@ -597,9 +597,9 @@ struct ErtmController::impl {
     controller_->send_pdu(std::move(builder));
   }
 
-  void send_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::RawBuilder> segment,
+  void send_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::SliceBuilder> segment,
                  Final f = Final::NOT_SET) {
-    std::shared_ptr<packet::RawBuilder> shared_segment(segment.release());
+    std::shared_ptr<packet::SliceBuilder> shared_segment(segment.release());
     unacked_list_.emplace(std::piecewise_construct, std::forward_as_tuple(next_tx_seq_),
                           std::forward_as_tuple(sar, sdu_size, shared_segment));
 
@@ -613,7 +613,7 @@ struct ErtmController::impl {
     start_retrans_timer();
   }
 
-  void pend_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::RawBuilder> data) {
+  void pend_data(SegmentationAndReassembly sar, uint16_t sdu_size, std::unique_ptr<packet::SliceBuilder> data) {
     pending_frames_.emplace(std::make_tuple(sar, sdu_size, std::move(data)));
   }
 
@@ -812,12 +812,14 @@ struct ErtmController::impl {
 // Segmentation is handled here
 void ErtmController::OnSdu(std::unique_ptr<packet::BasePacketBuilder> sdu) {
   auto sdu_size = sdu->size();
-  std::vector<std::unique_ptr<packet::RawBuilder>> segments;
+  if (sdu_size == 0) {
+    LOG_WARN("Received empty SDU");
+    return;
+  }
   auto size_each_packet = (remote_mps_ - 4 /* basic L2CAP header */ - 2 /* SDU length */ - 2 /* Enhanced control */ -
                            (fcs_enabled_ ? 2 : 0));
-  packet::FragmentingInserter fragmenting_inserter(size_each_packet, std::back_insert_iterator(segments));
-  sdu->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
+  // The SDU is serialized once, segments and their retransmissions reference slices of it
+  auto segments = packet::SliceBuilder::Fragment(*sdu, size_each_packet);
   if (segments.size() == 1) {
     pimpl_->data_request(SegmentationAndReassembly::UNSEGMENTED, std::move(segments[0]));
     return;
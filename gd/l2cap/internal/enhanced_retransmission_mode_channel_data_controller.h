@@ -31,7 +31,7 @@
 #include "os/queue.h"
 #include "packet/base_packet_builder.h"
 #include "packet/packet_view.h"
-#include "packet/raw_builder.h"
+#include "packet/slice_builder.h"
 
 namespace bluetooth {
 namespace l2cap {
@@ -82,14 +82,14 @@ class ErtmController : public DataController {
 
   class CopyablePacketBuilder : public packet::BasePacketBuilder {
    public:
-    CopyablePacketBuilder(std::shared_ptr<packet::RawBuilder> builder) : builder_(std::move(builder)) {}
+    CopyablePacketBuilder(std::shared_ptr<packet::SliceBuilder> builder) : builder_(std::move(builder)) {}
 
     void Serialize(BitInserter& it) const override;
 
     size_t size() const override;
 
    private:
-    std::shared_ptr<packet::RawBuilder> builder_;
+    std::shared_ptr<packet::SliceBuilder> builder_;
   };
 
   PacketViewForReassembly reassembly_stage_{PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>())};
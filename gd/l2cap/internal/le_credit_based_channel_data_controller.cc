@@ -18,8 +18,7 @@
 
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/le/internal/link.h"
-#include "packet/fragmenting_inserter.h"
-#include "packet/raw_builder.h"
+#include "packet/slice_builder.h"
 
 namespace bluetooth {
 namespace l2cap {
@@ -40,11 +39,9 @@ void LeCreditBasedDataController::OnSdu(std::unique_ptr<packet::BasePacketBuilde
   if (sdu_size > mtu_) {
     LOG_WARN("Received sdu_size %d > mtu %d", static_cast<int>(sdu_size), mtu_);
   }
-  std::vector<std::unique_ptr<packet::RawBuilder>> segments;
   // TODO: We don't need to waste 2 bytes for continuation segment.
-  packet::FragmentingInserter fragmenting_inserter(mps_ - 2, std::back_insert_iterator(segments));
-  sdu->Serialize(fragmenting_inserter);
-  fragmenting_inserter.finalize();
+  // The SDU is serialized once, segments reference slices of it
+  auto segments = packet::SliceBuilder::Fragment(*sdu, mps_ - 2);
   std::unique_ptr<BasicFrameBuilder> builder;
   builder = FirstLeInformationFrameBuilder::Create(remote_cid_, sdu_size, std::move(segments[0]));
   pdu_queue_.emplace(std::move(builder));
@@ -65,19 +62,26 @@ void LeCreditBasedDataController::OnSdu(std::unique_ptr<packet::BasePacketBuilde
 }
 
 void LeCreditBasedDataController::OnPdu(packet::PacketView<true> pdu) {
+  // Every PDU costs the remote a credit, whether we keep it or not
+  reassembly_pdus_++;
+  send_credits(local_credits_.OnPduReceived());
+  on_sdus_dequeued();
   auto basic_frame_view = BasicFrameView::Create(pdu);
   if (!basic_frame_view.IsValid()) {
     LOG_WARN("Received invalid frame");
+    release_pdus(1);
     return;
   }
   if (basic_frame_view.size() > mps_) {
     LOG_WARN("Received frame size %d > mps %d, dropping the packet", static_cast<int>(basic_frame_view.size()), mps_);
+    release_pdus(1);
     return;
   }
   if (remaining_sdu_continuation_packet_size_ == 0) {
     auto start_frame_view = FirstLeInformationFrameView::Create(basic_frame_view);
     if (!start_frame_view.IsValid()) {
       LOG_WARN("Received invalid frame");
+      release_pdus(1);
       return;
     }
     auto payload = start_frame_view.GetPayload();
@@ -90,15 +94,21 @@ void LeCreditBasedDataController::OnPdu(packet::PacketView<true> pdu) {
     reassembly_stage_.AppendPacketView(payload);
   }
   if (remaining_sdu_continuation_packet_size_ == 0) {
+    enqueued_sdu_pdus_.push(reassembly_pdus_);
+    reassembly_pdus_ = 0;
     enqueue_buffer_.Enqueue(std::make_unique<PacketView<kLittleEndian>>(reassembly_stage_), handler_);
+    if (!empty_notification_registered_) {
+      empty_notification_registered_ = true;
+      enqueue_buffer_.NotifyOnEmpty(common::BindOnce(&LeCreditBasedDataController::on_enqueue_buffer_empty,
+                                                     common::Unretained(this)));
+    }
   } else if (remaining_sdu_continuation_packet_size_ < 0 || reassembly_stage_.size() > mtu_) {
     LOG_WARN("Received larger SDU size than expected");
     reassembly_stage_ = PacketViewForReassembly(PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>()));
     remaining_sdu_continuation_packet_size_ = 0;
+    release_pdus(reassembly_pdus_);
     link_->SendDisconnectionRequest(cid_, remote_cid_);
   }
-  // TODO: Improve the logic by sending credit only after user dequeued the SDU
-  link_->SendLeCredit(cid_, 1);
 }
 
 std::unique_ptr<packet::BasePacketBuilder> LeCreditBasedDataController::GetNextPacket() {
@@ -116,6 +126,10 @@ void LeCreditBasedDataController::SetMps(uint16_t mps) {
   mps_ = mps;
 }
 
+void LeCreditBasedDataController::SetLocalCredits(uint16_t initial_credits, size_t memory_cap) {
+  local_credits_.Reset(mps_, initial_credits, memory_cap);
+}
+
 void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   int total_credits = credits_ + credits;
   if (total_credits > 0xffff) {
@@ -133,6 +147,34 @@ void LeCreditBasedDataController::OnCredit(uint16_t credits) {
   }
 }
 
+void LeCreditBasedDataController::release_pdus(size_t pdus) {
+  reassembly_pdus_ -= pdus;
+  send_credits(local_credits_.OnPdusConsumed(pdus));
+}
+
+void LeCreditBasedDataController::on_sdus_dequeued() {
+  size_t pdus = 0;
+  while (enqueued_sdu_pdus_.size() > enqueue_buffer_.Size()) {
+    pdus += enqueued_sdu_pdus_.front();
+    enqueued_sdu_pdus_.pop();
+  }
+  if (pdus > 0) {
+    send_credits(local_credits_.OnPdusConsumed(pdus));
+  }
+}
+
+void LeCreditBasedDataController::on_enqueue_buffer_empty() {
+  // Invoked by enqueue_buffer_ with its lock held, so don't call back into it from here
+  empty_notification_registered_ = false;
+  on_sdus_dequeued();
+}
+
+void LeCreditBasedDataController::send_credits(uint16_t credits) {
+  if (credits > 0) {
+    link_->SendLeCredit(cid_, credits);
+  }
+}
+
 }  // namespace internal
 }  // namespace l2cap
 }  // namespace bluetooth
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <memory>
+#include <queue>
 #include <unordered_map>
 #include <utility>
 
@@ -25,6 +26,7 @@
 #include "l2cap/internal/channel_impl.h"
 #include "l2cap/internal/data_controller.h"
 #include "l2cap/internal/ilink.h"
+#include "l2cap/internal/le_credit_manager.h"
 #include "l2cap/internal/scheduler.h"
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/mtu.h"
@@ -55,10 +57,18 @@ class LeCreditBasedDataController : public DataController {
   // TODO: Set MTU and MPS from signalling channel
   void SetMtu(Mtu mtu);
   void SetMps(uint16_t mps);
+  // Credits we granted to the remote when the channel was opened, and the most memory the PDUs it sends may hold.
+  // Call after SetMps().
+  void SetLocalCredits(uint16_t initial_credits, size_t memory_cap);
   // TODO: Handle credits
   void OnCredit(uint16_t credits);
 
  private:
+  void release_pdus(size_t pdus);
+  void on_sdus_dequeued();
+  void on_enqueue_buffer_empty();
+  void send_credits(uint16_t credits);
+
   Cid cid_;
   Cid remote_cid_;
   os::EnqueueBuffer<UpperEnqueue> enqueue_buffer_;
@@ -71,6 +81,14 @@ class LeCreditBasedDataController : public DataController {
   uint16_t credits_ = 0;
   uint16_t pending_frames_count_ = 0;
 
+  // Same as ParameterProvider::GetLeInitialCredit(), until SetLocalCredits() is called
+  static constexpr uint16_t kDefaultLocalCredits = 100;
+  LeCreditManager local_credits_{mps_, kDefaultLocalCredits, LeCreditManager::kDefaultMemoryCap};
+  // Number of PDUs of each SDU in enqueue_buffer_, oldest first
+  std::queue<uint16_t> enqueued_sdu_pdus_;
+  uint16_t reassembly_pdus_ = 0;
+  bool empty_notification_registered_ = false;
+
   class PacketViewForReassembly : public packet::PacketView<kLittleEndian> {
    public:
     PacketViewForReassembly(const PacketView& packetView) : PacketView(packetView) {}
@@ -151,7 +151,6 @@ TEST_F(LeCreditBasedDataControllerTest, receive_segmented) {
   auto segment2 = CreateSdu({'e', 'f', 'g'});
   auto builder2 = BasicFrameBuilder::Create(0x41, std::move(segment2));
   base_view = GetPacketView(std::move(builder2));
-  EXPECT_CALL(link, SendLeCredit(0x41, 1));
   controller.OnPdu(base_view);
   sync_handler(queue_handler_);
   auto payload = channel_queue.GetUpEnd()->TryDequeue();
@@ -179,6 +178,26 @@ TEST_F(LeCreditBasedDataControllerTest, receive_segmented_with_wrong_sdu_length)
   EXPECT_EQ(payload, nullptr);
 }
 
+TEST_F(LeCreditBasedDataControllerTest, credits_return_as_sdus_are_dequeued) {
+  common::BidiQueue<Scheduler::UpperEnqueue, Scheduler::UpperDequeue> channel_queue{10};
+  testing::MockScheduler scheduler;
+  testing::MockILink link;
+  LeCreditBasedDataController controller{&link, 0x41, 0x41, channel_queue.GetDownEnd(), queue_handler_, &scheduler};
+  controller.SetMps(100);
+  // Room for two PDUs only, so no credit can be given back until the SDU they hold is dequeued
+  controller.SetLocalCredits(2, 200);
+  auto segment1 = CreateSdu({'a', 'b', 'c', 'd'});
+  auto builder1 = FirstLeInformationFrameBuilder::Create(0x41, 7, std::move(segment1));
+  controller.OnPdu(GetPacketView(std::move(builder1)));
+  auto segment2 = CreateSdu({'e', 'f', 'g'});
+  auto builder2 = BasicFrameBuilder::Create(0x41, std::move(segment2));
+  EXPECT_CALL(link, SendLeCredit(0x41, 2));
+  controller.OnPdu(GetPacketView(std::move(builder2)));
+  sync_handler(queue_handler_);
+  auto payload = channel_queue.GetUpEnd()->TryDequeue();
+  EXPECT_NE(payload, nullptr);
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace l2cap
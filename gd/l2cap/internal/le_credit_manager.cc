@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/le_credit_manager.h"
+
+#include <algorithm>
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+LeCreditManager::LeCreditManager(uint16_t mps, uint16_t initial_credits, size_t memory_cap) {
+  Reset(mps, initial_credits, memory_cap);
+}
+
+void LeCreditManager::Reset(uint16_t mps, uint16_t initial_credits, size_t memory_cap) {
+  size_t max_credits = memory_cap / std::max<uint16_t>(mps, 1);
+  max_credits_ = static_cast<uint16_t>(std::clamp<size_t>(max_credits, 1, UINT16_MAX));
+  min_window_ = std::min(kMinWindow, max_credits_);
+  window_ = std::clamp(initial_credits, min_window_, max_credits_);
+  peer_credits_ = initial_credits;
+  buffered_pdus_ = 0;
+  consumer_behind_ = false;
+}
+
+uint16_t LeCreditManager::OnPduReceived() {
+  if (peer_credits_ > 0) {
+    peer_credits_--;
+  }
+  buffered_pdus_++;
+  if (!consumer_behind_ && buffered_pdus_ > window_) {
+    // The peer sends faster than the consumer drains, a smaller window is enough to keep the consumer busy
+    consumer_behind_ = true;
+    window_ = std::max<uint16_t>(min_window_, window_ / 2);
+  }
+  return top_up();
+}
+
+uint16_t LeCreditManager::OnPdusConsumed(size_t pdus) {
+  buffered_pdus_ -= std::min(pdus, buffered_pdus_);
+  if (consumer_behind_ && buffered_pdus_ <= window_ / 2) {
+    consumer_behind_ = false;
+  }
+  return top_up();
+}
+
+uint16_t LeCreditManager::top_up() {
+  if (peer_credits_ > window_ / 2) {
+    return 0;
+  }
+  if (buffered_pdus_ <= window_ / 4) {
+    // The peer spent half of its window while the consumer kept up, let it go faster
+    window_ = std::min<size_t>(max_credits_, window_ + std::max(1, window_ / 4));
+  }
+  size_t in_use = peer_credits_ + buffered_pdus_;
+  if (in_use >= max_credits_) {
+    return 0;
+  }
+  size_t credits = std::min<size_t>(window_ - peer_credits_, max_credits_ - in_use);
+  peer_credits_ += credits;
+  return static_cast<uint16_t>(credits);
+}
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
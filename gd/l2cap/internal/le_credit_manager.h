@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+/**
+ * Decides when to give LE credits back to the sender of a credit based channel.
+ *
+ * Every PDU received spends one of the peer's credits and is held until the consumer takes the SDU it belongs to, so
+ * once the memory cap is reached credits only come back as fast as the consumer drains. The peer is topped up to a
+ * window of credits as soon as it falls to half of it, rather than when it runs out, so a fast sender is not left idle
+ * while a credit packet is in flight. The window grows while the consumer keeps up and shrinks when it falls behind,
+ * and the PDUs held plus the credits outstanding never cover more than memory_cap bytes.
+ */
+class LeCreditManager {
+ public:
+  static constexpr size_t kDefaultMemoryCap = 64 * 1024;
+  // The window never shrinks below this, unless the memory cap is smaller
+  static constexpr uint16_t kMinWindow = 4;
+
+  LeCreditManager(uint16_t mps, uint16_t initial_credits, size_t memory_cap);
+
+  // Start over after initial_credits were granted to the peer, e.g. in the connection request or response
+  void Reset(uint16_t mps, uint16_t initial_credits, size_t memory_cap);
+
+  // The peer spent a credit on a PDU. Returns the number of credits to send back now, possibly 0.
+  uint16_t OnPduReceived();
+
+  // The consumer took (or we dropped) the given number of received PDUs. Returns the number of credits to send back
+  // now, possibly 0.
+  uint16_t OnPdusConsumed(size_t pdus);
+
+  // Credits the peer has left
+  uint16_t GetPeerCredits() const {
+    return peer_credits_;
+  }
+  // PDUs received but not consumed yet
+  size_t GetBufferedPdus() const {
+    return buffered_pdus_;
+  }
+  uint16_t GetWindow() const {
+    return window_;
+  }
+  // Most credits the peer may hold, as the memory cap allows
+  uint16_t GetMaxCredits() const {
+    return max_credits_;
+  }
+
+ private:
+  uint16_t top_up();
+
+  uint16_t max_credits_ = 1;
+  uint16_t min_window_ = 1;
+  uint16_t window_ = 1;
+  uint16_t peer_credits_ = 0;
+  size_t buffered_pdus_ = 0;
+  // Set while the consumer is more than a window behind
+  bool consumer_behind_ = false;
+};
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
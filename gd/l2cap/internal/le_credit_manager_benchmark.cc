@@ -0,0 +1,190 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "l2cap/internal/le_credit_manager.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+// A peer pushing a firmware image over an LE credit based channel, in ticks of 100us. The link carries 25 bytes per
+// tick, and a credit packet reaches the peer one 7.5ms connection interval after it is sent. The consumer drains 40
+// bytes per tick but stops for 20ms out of every 100ms, like a flash write would. Each policy decides when credits
+// are given back; the counters report the SDU bytes delivered per second, the credit packets sent and the most bytes
+// held by the receiver at once.
+class BM_LeCredits : public ::benchmark::Fixture {
+ protected:
+  static constexpr int kTicks = 20000;
+  static constexpr int kTicksPerSecond = 10000;
+  static constexpr size_t kLinkBytesPerTick = 25;
+  static constexpr int kCreditDelayTicks = 75;
+  static constexpr size_t kConsumerBytesPerTick = 40;
+  static constexpr int kConsumerPeriodTicks = 1000;
+  static constexpr int kConsumerPauseTicks = 200;
+  static constexpr size_t kHeaderSize = 4;
+  static constexpr uint16_t kInitialCredits = 100;
+
+  // Credit after every PDU received, as soon as it is received
+  struct PerPdu {
+    PerPdu(uint16_t mps) {}
+    uint16_t OnPduReceived() {
+      return 1;
+    }
+    uint16_t OnPdusConsumed(size_t pdus) {
+      return 0;
+    }
+  };
+
+  // Give back everything consumed in one batch, once the peer has run out of credits
+  struct FixedBatch {
+    FixedBatch(uint16_t mps) {}
+    uint16_t OnPduReceived() {
+      peer_credits_--;
+      return replenish();
+    }
+    uint16_t OnPdusConsumed(size_t pdus) {
+      consumed_ += pdus;
+      return replenish();
+    }
+    uint16_t replenish() {
+      if (peer_credits_ > 0) {
+        return 0;
+      }
+      uint16_t credits = consumed_;
+      peer_credits_ += credits;
+      consumed_ = 0;
+      return credits;
+    }
+    size_t peer_credits_ = kInitialCredits;
+    size_t consumed_ = 0;
+  };
+
+  struct Adaptive : public LeCreditManager {
+    Adaptive(uint16_t mps) : LeCreditManager(mps, kInitialCredits, kDefaultMemoryCap) {}
+  };
+
+  template <typename Policy>
+  void run(State& state, uint16_t mps, uint16_t mtu) {
+    Policy policy{mps};
+    // Segmented the way LeCreditBasedDataController::OnSdu() does
+    const size_t segment_size = mps - 2;
+    const size_t segments_per_sdu = (mtu + segment_size - 1) / segment_size;
+
+    size_t peer_credits = kInitialCredits;
+    std::deque<std::pair<int, uint16_t>> credits_in_flight;
+    size_t segments_sent = 0;
+    size_t air_budget = 0;
+    size_t reassembly_bytes = 0;
+    size_t reassembly_pdus = 0;
+    std::deque<std::pair<size_t, size_t>> consumer_queue;  // bytes left, PDUs of each SDU
+    size_t held_bytes = 0;
+    size_t peak_held_bytes = 0;
+    uint64_t delivered_bytes = 0;
+    uint64_t credit_packets = 0;
+
+    auto send_credits = [&](int tick, uint16_t credits) {
+      if (credits > 0) {
+        credits_in_flight.emplace_back(tick + kCreditDelayTicks, credits);
+        credit_packets++;
+      }
+    };
+
+    for (int tick = 0; tick < kTicks; tick++) {
+      while (!credits_in_flight.empty() && credits_in_flight.front().first <= tick) {
+        peer_credits += credits_in_flight.front().second;
+        credits_in_flight.pop_front();
+      }
+
+      size_t pdu_payload = segments_sent + 1 == segments_per_sdu ? mtu - segments_sent * segment_size : segment_size;
+      size_t pdu_size = kHeaderSize + (segments_sent == 0 ? 2 : 0) + pdu_payload;
+      // An idle link can't save up air time
+      air_budget = std::min(air_budget + kLinkBytesPerTick, pdu_size + kLinkBytesPerTick);
+      while (peer_credits > 0 && air_budget >= pdu_size) {
+        air_budget -= pdu_size;
+        peer_credits--;
+        segments_sent = (segments_sent + 1) % segments_per_sdu;
+
+        send_credits(tick, policy.OnPduReceived());
+        reassembly_bytes += pdu_payload;
+        reassembly_pdus++;
+        held_bytes += pdu_payload;
+        if (segments_sent == 0) {
+          consumer_queue.emplace_back(reassembly_bytes, reassembly_pdus);
+          reassembly_bytes = 0;
+          reassembly_pdus = 0;
+        }
+        pdu_payload = segments_sent + 1 == segments_per_sdu ? mtu - segments_sent * segment_size : segment_size;
+        pdu_size = kHeaderSize + (segments_sent == 0 ? 2 : 0) + pdu_payload;
+      }
+      peak_held_bytes = std::max(peak_held_bytes, held_bytes);
+
+      size_t drain = tick % kConsumerPeriodTicks < kConsumerPauseTicks ? 0 : kConsumerBytesPerTick;
+      while (drain > 0 && !consumer_queue.empty()) {
+        auto& sdu = consumer_queue.front();
+        size_t taken = std::min(drain, sdu.first);
+        sdu.first -= taken;
+        drain -= taken;
+        held_bytes -= taken;
+        delivered_bytes += taken;
+        if (sdu.first == 0) {
+          send_credits(tick, policy.OnPdusConsumed(sdu.second));
+          consumer_queue.pop_front();
+        }
+      }
+    }
+    state.counters["throughput_Bps"] = static_cast<double>(delivered_bytes) * kTicksPerSecond / kTicks;
+    state.counters["credit_packets"] = credit_packets;
+    state.counters["peak_held_bytes"] = peak_held_bytes;
+  }
+};
+
+BENCHMARK_DEFINE_F(BM_LeCredits, per_pdu)(State& state) {
+  for (auto _ : state) {
+    run<PerPdu>(state, state.range(0), state.range(1));
+  }
+}
+
+BENCHMARK_DEFINE_F(BM_LeCredits, fixed_batch)(State& state) {
+  for (auto _ : state) {
+    run<FixedBatch>(state, state.range(0), state.range(1));
+  }
+}
+
+BENCHMARK_DEFINE_F(BM_LeCredits, adaptive)(State& state) {
+  for (auto _ : state) {
+    run<Adaptive>(state, state.range(0), state.range(1));
+  }
+}
+
+// {MPS, MTU}
+#define LE_CREDITS_ARGS \
+  ArgNames({"mps", "mtu"})->Args({23, 23})->Args({100, 512})->Args({251, 512})->Args({251, 4096})->Args({512, 4096})
+
+BENCHMARK_REGISTER_F(BM_LeCredits, per_pdu)->LE_CREDITS_ARGS;
+BENCHMARK_REGISTER_F(BM_LeCredits, fixed_batch)->LE_CREDITS_ARGS;
+BENCHMARK_REGISTER_F(BM_LeCredits, adaptive)->LE_CREDITS_ARGS;
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
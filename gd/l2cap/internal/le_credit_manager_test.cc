@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/le_credit_manager.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+TEST(LeCreditManagerTest, tops_up_at_half_window) {
+  LeCreditManager credits{100, 10, 100 * 100};
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ(0, credits.OnPduReceived());
+    ASSERT_EQ(0, credits.OnPdusConsumed(1));
+  }
+  ASSERT_EQ(6, credits.GetPeerCredits());
+  // The peer is down to half of its window before running out; the consumer kept up, so the window grows
+  ASSERT_EQ(7, credits.OnPduReceived());
+  ASSERT_EQ(12, credits.GetWindow());
+  ASSERT_EQ(12, credits.GetPeerCredits());
+  ASSERT_EQ(0, credits.OnPdusConsumed(1));
+}
+
+TEST(LeCreditManagerTest, window_grows_to_memory_cap) {
+  LeCreditManager credits{250, 10, 64 * 250};
+  ASSERT_EQ(64, credits.GetMaxCredits());
+  for (int i = 0; i < 1000; i++) {
+    credits.OnPduReceived();
+    credits.OnPdusConsumed(1);
+  }
+  ASSERT_EQ(64, credits.GetWindow());
+  ASSERT_LE(credits.GetPeerCredits(), 64);
+}
+
+TEST(LeCreditManagerTest, held_pdus_count_against_memory_cap) {
+  LeCreditManager credits{100, 8, 8 * 100};
+  // Nothing is consumed: every credit spent stays in memory, so none can come back
+  for (int i = 0; i < 8; i++) {
+    ASSERT_EQ(0, credits.OnPduReceived());
+    ASSERT_LE(credits.GetPeerCredits() + credits.GetBufferedPdus(), 8u);
+  }
+  ASSERT_EQ(0, credits.GetPeerCredits());
+  ASSERT_EQ(8u, credits.GetBufferedPdus());
+  // Credits come back only as fast as the consumer drains
+  ASSERT_EQ(3, credits.OnPdusConsumed(3));
+  ASSERT_EQ(3, credits.GetPeerCredits());
+  ASSERT_EQ(5u, credits.GetBufferedPdus());
+}
+
+TEST(LeCreditManagerTest, window_shrinks_when_consumer_falls_behind) {
+  LeCreditManager credits{100, 40, 1000 * 100};
+  // The consumer takes one PDU out of three
+  for (int i = 0; i < 300; i++) {
+    credits.OnPduReceived();
+    if (i % 3 == 0) {
+      credits.OnPdusConsumed(1);
+    }
+  }
+  ASSERT_LT(credits.GetWindow(), 40);
+  ASSERT_GE(credits.GetWindow(), LeCreditManager::kMinWindow);
+}
+
+TEST(LeCreditManagerTest, small_memory_cap) {
+  LeCreditManager credits{251, 100, 100};
+  ASSERT_EQ(1, credits.GetMaxCredits());
+  ASSERT_EQ(1, credits.GetWindow());
+  // The peer was granted more than the cap before we could say otherwise; nothing is given back until it is spent
+  for (int i = 0; i < 99; i++) {
+    ASSERT_EQ(0, credits.OnPduReceived());
+    ASSERT_EQ(0, credits.OnPdusConsumed(1));
+  }
+  credits.OnPduReceived();
+  ASSERT_EQ(1, credits.OnPdusConsumed(1));
+}
+
+TEST(LeCreditManagerTest, reset) {
+  LeCreditManager credits{100, 10, 100 * 100};
+  credits.OnPduReceived();
+  credits.Reset(50, 20, 100 * 50);
+  ASSERT_EQ(20, credits.GetPeerCredits());
+  ASSERT_EQ(0u, credits.GetBufferedPdus());
+  ASSERT_EQ(20, credits.GetWindow());
+  ASSERT_EQ(100, credits.GetMaxCredits());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 
 namespace bluetooth {
 namespace l2cap {
@@ -42,6 +43,10 @@ class ParameterProvider {
   virtual uint16_t GetLeInitialCredit() {
     return 100;
   }
+  // Most memory the PDUs received on one LE credit based channel may hold before we stop granting credits
+  virtual size_t GetLeCreditMemoryCap() {
+    return 64 * 1024;
+  }
 };
 
 }  // namespace internal
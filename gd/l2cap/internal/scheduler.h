@@ -49,6 +49,15 @@ class Scheduler {
   using LowerDequeue = UpperEnqueue;
   using LowerQueueUpEnd = common::BidiQueueEnd<LowerEnqueue, LowerDequeue>;
 
+  /**
+   * Transmit priority of a channel, highest first
+   */
+  enum class ChannelPriority : uint8_t {
+    HIGH = 0,
+    MEDIUM = 1,
+    LOW = 2,
+  };
+
   /**
    * Callback from the sender to indicate that the scheduler could dequeue number_packets from it
    */
@@ -60,6 +69,16 @@ class Scheduler {
    */
   virtual void SetChannelTxPriority(Cid cid, bool high_priority) {}
 
+  /**
+   * Set the priority the channel is scheduled at while it is not set to high tx priority.
+   */
+  virtual void SetChannelPriority(Cid cid, ChannelPriority priority) {}
+
+  /**
+   * Set how many packets the channel may send in a row before other channels of the same priority get a turn.
+   */
+  virtual void SetChannelQuantum(Cid cid, int quantum) {}
+
   /**
    * Called by data controller to indicate that a channel is closed and packets should be dropped
    */
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "l2cap/internal/scheduler_priority.h"
+
+#include <algorithm>
+
+#include "l2cap/internal/data_pipeline_manager.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+namespace {
+constexpr Psm kRfcommPsm = 0x0003;
+constexpr Psm kHidControlPsm = 0x0011;
+constexpr Psm kHidInterruptPsm = 0x0013;
+constexpr Psm kAvdtpPsm = 0x0019;
+constexpr Psm kEattPsm = 0x0027;
+}  // namespace
+
+Scheduler::ChannelPriority GetDefaultChannelPriority(Cid cid, Psm psm) {
+  switch (cid) {
+    case kClassicSignallingCid:
+    case kLeSignallingCid:
+      return Scheduler::ChannelPriority::HIGH;
+    case kLeAttributeCid:
+    case kSmpCid:
+    case kSmpBrCid:
+      return Scheduler::ChannelPriority::MEDIUM;
+    default:
+      break;
+  }
+  switch (psm) {
+    case kHidControlPsm:
+    case kHidInterruptPsm:
+    case kAvdtpPsm:
+    case kEattPsm:
+      return Scheduler::ChannelPriority::MEDIUM;
+    case kRfcommPsm:
+    default:
+      return Scheduler::ChannelPriority::LOW;
+  }
+}
+
+SchedulerPriority::SchedulerPriority(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end,
+                                     os::Handler* handler)
+    : data_pipeline_manager_(data_pipeline_manager), link_queue_up_end_(link_queue_up_end), handler_(handler) {
+  ASSERT(link_queue_up_end_ != nullptr && handler_ != nullptr);
+}
+
+// Invoked from some external Handler context
+SchedulerPriority::~SchedulerPriority() {
+  try_unregister_link_queue_enqueue();
+}
+
+// Invoked within L2CAP Handler context
+void SchedulerPriority::OnPacketsReady(Cid cid, int number_packets) {
+  if (number_packets == 0) {
+    return;
+  }
+  auto& channel = channels_[cid];
+  if (channel.packets_ready == 0) {
+    ready_channels_[level_of(channel)].push_back(cid);
+  }
+  channel.packets_ready += number_packets;
+  try_register_link_queue_enqueue();
+}
+
+// Invoked within L2CAP Handler context
+void SchedulerPriority::SetChannelTxPriority(Cid cid, bool high_priority) {
+  auto channel = channels_.find(cid);
+  if (channel == channels_.end()) {
+    if (!high_priority) {
+      return;
+    }
+    channel = channels_.emplace(cid, ChannelState{}).first;
+  }
+  set_level(cid, channel->second, channel->second.priority, high_priority);
+}
+
+// Invoked within L2CAP Handler context
+void SchedulerPriority::SetChannelPriority(Cid cid, ChannelPriority priority) {
+  auto& channel = channels_[cid];
+  set_level(cid, channel, priority, channel.high_tx_priority);
+}
+
+// Invoked within L2CAP Handler context
+void SchedulerPriority::SetChannelQuantum(Cid cid, int quantum) {
+  ASSERT(quantum > 0);
+  channels_[cid].quantum = quantum;
+}
+
+void SchedulerPriority::RemoveChannel(Cid cid) {
+  auto channel = channels_.find(cid);
+  if (channel == channels_.end()) {
+    return;
+  }
+  if (channel->second.packets_ready > 0) {
+    ready_channels_[level_of(channel->second)].remove(cid);
+  }
+  channels_.erase(channel);
+  if (!has_ready_channel()) {
+    try_unregister_link_queue_enqueue();
+  }
+}
+
+size_t SchedulerPriority::level_of(const ChannelState& channel) {
+  if (channel.high_tx_priority) {
+    return static_cast<size_t>(ChannelPriority::HIGH);
+  }
+  return static_cast<size_t>(channel.priority);
+}
+
+void SchedulerPriority::set_level(Cid cid, ChannelState& channel, ChannelPriority priority, bool high_tx_priority) {
+  size_t old_level = level_of(channel);
+  channel.priority = priority;
+  channel.high_tx_priority = high_tx_priority;
+  size_t new_level = level_of(channel);
+  if (channel.packets_ready == 0 || old_level == new_level) {
+    return;
+  }
+  ready_channels_[old_level].remove(cid);
+  ready_channels_[new_level].push_back(cid);
+  channel.sent_this_turn = 0;
+}
+
+bool SchedulerPriority::has_ready_channel() const {
+  return std::any_of(ready_channels_.begin(), ready_channels_.end(),
+                     [](const std::list<Cid>& channels) { return !channels.empty(); });
+}
+
+// Invoked from some external Queue Reactable context
+std::unique_ptr<SchedulerPriority::UpperDequeue> SchedulerPriority::link_queue_enqueue_callback() {
+  auto ready = std::find_if(ready_channels_.begin(), ready_channels_.end(),
+                            [](const std::list<Cid>& channels) { return !channels.empty(); });
+  ASSERT(ready != ready_channels_.end());
+  Cid cid = ready->front();
+  auto& channel = channels_.find(cid)->second;
+  channel.packets_ready--;
+  channel.sent_this_turn++;
+  if (channel.packets_ready == 0) {
+    ready->pop_front();
+    channel.sent_this_turn = 0;
+  } else if (channel.sent_this_turn >= channel.quantum) {
+    ready->splice(ready->end(), *ready, ready->begin());
+    channel.sent_this_turn = 0;
+  }
+  auto packet = data_pipeline_manager_->GetDataController(cid)->GetNextPacket();
+
+  data_pipeline_manager_->OnPacketSent(cid);
+  if (!has_ready_channel()) {
+    try_unregister_link_queue_enqueue();
+  }
+  return packet;
+}
+
+void SchedulerPriority::try_register_link_queue_enqueue() {
+  if (link_queue_enqueue_registered_.exchange(true)) {
+    return;
+  }
+  link_queue_up_end_->RegisterEnqueue(
+      handler_, common::Bind(&SchedulerPriority::link_queue_enqueue_callback, common::Unretained(this)));
+}
+
+void SchedulerPriority::try_unregister_link_queue_enqueue() {
+  if (link_queue_enqueue_registered_.exchange(false)) {
+    link_queue_up_end_->UnregisterEnqueue();
+  }
+}
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "l2cap/cid.h"
+#include "l2cap/internal/scheduler.h"
+#include "l2cap/psm.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+class DataPipelineManager;
+
+/**
+ * Default priority of a channel: fixed channels by cid, dynamic channels by the psm of their service. Signalling is
+ * HIGH; ATT, SMP, AVDTP and HID are MEDIUM; everything else, e.g. RFCOMM and OBEX, is LOW.
+ */
+Scheduler::ChannelPriority GetDefaultChannelPriority(Cid cid, Psm psm = kDefaultPsm);
+
+/**
+ * Strict priority between channels, round robin between channels of the same priority. A channel with high tx
+ * priority is scheduled as HIGH. Each turn a channel sends up to its quantum of packets (1 by default).
+ */
+class SchedulerPriority : public Scheduler {
+ public:
+  SchedulerPriority(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end,
+                    os::Handler* handler);
+  ~SchedulerPriority();
+  void OnPacketsReady(Cid cid, int number_packets) override;
+  void SetChannelTxPriority(Cid cid, bool high_priority) override;
+  void SetChannelPriority(Cid cid, ChannelPriority priority) override;
+  void SetChannelQuantum(Cid cid, int quantum) override;
+  void RemoveChannel(Cid cid) override;
+
+ private:
+  static constexpr size_t kNumPriorities = 3;
+
+  struct ChannelState {
+    ChannelPriority priority = ChannelPriority::LOW;
+    bool high_tx_priority = false;
+    int quantum = 1;
+    int packets_ready = 0;
+    int sent_this_turn = 0;
+  };
+
+  DataPipelineManager* data_pipeline_manager_;
+  LowerQueueUpEnd* link_queue_up_end_;
+  os::Handler* handler_;
+  std::unordered_map<Cid, ChannelState> channels_;
+  // Channels with packets ready, per priority; the front one has the turn
+  std::array<std::list<Cid>, kNumPriorities> ready_channels_;
+  std::atomic_bool link_queue_enqueue_registered_ = false;
+
+  static size_t level_of(const ChannelState& channel);
+  void set_level(Cid cid, ChannelState& channel, ChannelPriority priority, bool high_tx_priority);
+  bool has_ready_channel() const;
+  void try_register_link_queue_enqueue();
+  void try_unregister_link_queue_enqueue();
+  std::unique_ptr<LowerEnqueue> link_queue_enqueue_callback();
+};
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/scheduler_priority.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "l2cap/internal/channel_impl_mock.h"
+#include "l2cap/internal/data_controller_mock.h"
+#include "l2cap/internal/data_pipeline_manager_mock.h"
+#include "os/handler.h"
+#include "os/mock_queue.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+using ::testing::_;
+using ::testing::Return;
+
+std::unique_ptr<packet::BasePacketBuilder> CreateSdu(std::vector<uint8_t> payload) {
+  auto raw_builder = std::make_unique<packet::RawBuilder>();
+  raw_builder->AddOctets(payload);
+  return raw_builder;
+}
+
+PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilder> packet) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  bytes->reserve(packet->size());
+  packet->Serialize(i);
+  return packet::PacketView<packet::kLittleEndian>(bytes);
+}
+
+class MyDataController : public testing::MockDataController {
+ public:
+  std::unique_ptr<BasePacketBuilder> GetNextPacket() override {
+    auto next = std::move(next_packets.front());
+    next_packets.pop();
+    return next;
+  }
+
+  std::queue<std::unique_ptr<BasePacketBuilder>> next_packets;
+};
+
+class L2capSchedulerPriorityTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    thread_ = new os::Thread("test_thread", os::Thread::Priority::NORMAL);
+    queue_handler_ = new os::Handler(thread_);
+    mock_data_pipeline_manager_ = new testing::MockDataPipelineManager(queue_handler_, &queue_end_);
+    scheduler_ = new SchedulerPriority(mock_data_pipeline_manager_, &queue_end_, queue_handler_);
+    EXPECT_CALL(*mock_data_pipeline_manager_, GetDataController(1)).WillRepeatedly(Return(&data_controller_1_));
+    EXPECT_CALL(*mock_data_pipeline_manager_, GetDataController(2)).WillRepeatedly(Return(&data_controller_2_));
+    EXPECT_CALL(*mock_data_pipeline_manager_, OnPacketSent(_)).Times(::testing::AnyNumber());
+  }
+
+  void TearDown() override {
+    delete scheduler_;
+    delete mock_data_pipeline_manager_;
+    queue_handler_->Clear();
+    delete queue_handler_;
+    delete thread_;
+  }
+
+  void PushPacket(Cid cid, int number_packets) {
+    auto& data_controller = cid == 1 ? data_controller_1_ : data_controller_2_;
+    for (int i = 0; i < number_packets; i++) {
+      data_controller.next_packets.push(BasicFrameBuilder::Create(cid, CreateSdu({'a', 'b', 'c'})));
+    }
+    scheduler_->OnPacketsReady(cid, number_packets);
+  }
+
+  // Channel ids of the packets sent so far, in order
+  std::vector<Cid> TakeSentCids() {
+    std::vector<Cid> cids;
+    while (!enqueue_.enqueued.empty()) {
+      auto packet_view = GetPacketView(std::move(enqueue_.enqueued.front()));
+      enqueue_.enqueued.pop();
+      auto basic_frame_view = BasicFrameView::Create(packet_view);
+      EXPECT_TRUE(basic_frame_view.IsValid());
+      cids.push_back(basic_frame_view.GetChannelId());
+    }
+    return cids;
+  }
+
+  os::Thread* thread_ = nullptr;
+  os::Handler* queue_handler_ = nullptr;
+  os::MockIQueueDequeue<Scheduler::LowerDequeue> dequeue_;
+  os::MockIQueueEnqueue<Scheduler::LowerEnqueue> enqueue_;
+  common::BidiQueueEnd<Scheduler::LowerEnqueue, Scheduler::LowerDequeue> queue_end_{&enqueue_, &dequeue_};
+  testing::MockDataPipelineManager* mock_data_pipeline_manager_ = nullptr;
+  MyDataController data_controller_1_;
+  MyDataController data_controller_2_;
+  SchedulerPriority* scheduler_ = nullptr;
+};
+
+TEST_F(L2capSchedulerPriorityTest, send_packet) {
+  PushPacket(1, 1);
+  enqueue_.run_enqueue();
+  auto packet_view = GetPacketView(std::move(enqueue_.enqueued.front()));
+  enqueue_.enqueued.pop();
+  auto basic_frame_view = BasicFrameView::Create(packet_view);
+  ASSERT_TRUE(basic_frame_view.IsValid());
+  ASSERT_EQ(basic_frame_view.GetChannelId(), 1);
+  auto payload = basic_frame_view.GetPayload();
+  ASSERT_EQ(std::string(payload.begin(), payload.end()), "abc");
+  ASSERT_EQ(enqueue_.registered_handler, nullptr);
+}
+
+TEST_F(L2capSchedulerPriorityTest, higher_priority_goes_first) {
+  scheduler_->SetChannelPriority(1, Scheduler::ChannelPriority::LOW);
+  scheduler_->SetChannelPriority(2, Scheduler::ChannelPriority::MEDIUM);
+  PushPacket(1, 2);
+  PushPacket(2, 2);
+  enqueue_.run_enqueue(4);
+  ASSERT_EQ(TakeSentCids(), std::vector<Cid>({2, 2, 1, 1}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, round_robin_within_priority) {
+  scheduler_->SetChannelQuantum(1, 2);
+  PushPacket(1, 5);
+  PushPacket(2, 2);
+  enqueue_.run_enqueue(7);
+  ASSERT_EQ(TakeSentCids(), std::vector<Cid>({1, 1, 2, 1, 1, 2, 1}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, tx_priority_overrides_priority) {
+  scheduler_->SetChannelPriority(1, Scheduler::ChannelPriority::MEDIUM);
+  scheduler_->SetChannelPriority(2, Scheduler::ChannelPriority::LOW);
+  PushPacket(1, 2);
+  PushPacket(2, 2);
+  scheduler_->SetChannelTxPriority(2, true);
+  enqueue_.run_enqueue(3);
+  ASSERT_EQ(TakeSentCids(), std::vector<Cid>({2, 2, 1}));
+
+  PushPacket(2, 1);
+  scheduler_->SetChannelTxPriority(2, false);
+  enqueue_.run_enqueue(2);
+  ASSERT_EQ(TakeSentCids(), std::vector<Cid>({1, 2}));
+}
+
+TEST_F(L2capSchedulerPriorityTest, remove_channel) {
+  PushPacket(1, 1);
+  PushPacket(2, 1);
+  scheduler_->RemoveChannel(1);
+  enqueue_.run_enqueue(2);
+  ASSERT_EQ(TakeSentCids(), std::vector<Cid>({2}));
+  scheduler_->RemoveChannel(2);
+  ASSERT_EQ(enqueue_.registered_handler, nullptr);
+}
+
+TEST(L2capSchedulerPriorityDefaultTest, default_channel_priority) {
+  ASSERT_EQ(GetDefaultChannelPriority(kClassicSignallingCid), Scheduler::ChannelPriority::HIGH);
+  ASSERT_EQ(GetDefaultChannelPriority(kLeAttributeCid), Scheduler::ChannelPriority::MEDIUM);
+  ASSERT_EQ(GetDefaultChannelPriority(0x40, 0x0019), Scheduler::ChannelPriority::MEDIUM);
+  ASSERT_EQ(GetDefaultChannelPriority(0x41, 0x0003), Scheduler::ChannelPriority::LOW);
+  ASSERT_EQ(GetDefaultChannelPriority(0x42, 0x1001), Scheduler::ChannelPriority::LOW);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -0,0 +1,97 @@
+#
+#   Copyright 2021 - The Android Open Source Project
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#       http://www.apache.org/licenses/LICENSE-2.0
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+
+import os
+from datetime import timedelta
+
+from acts.context import get_current_context
+from bluetooth_packets_python3 import RawBuilder
+from cert.matchers import L2capMatchers
+from cert.performance_test_logger import PerformanceTestLogger
+from cert.truth import assertThat
+from l2cap.le.cert.le_l2cap_test import LeL2capTest
+
+# Fits in a single K-frame with the default MPS of 100
+SDU_SIZE = 90
+
+
+class LeL2capPerformanceTest(LeL2capTest):
+    """
+    Measures the LE connection setup, credit based channel setup, throughput
+    and latency of the DUT stack against root-canal. The results of each test
+    are written to performance.json in its output directory.
+    """
+
+    def setup_test(self):
+        super().setup_test()
+        self.performance_test_logger = PerformanceTestLogger()
+        self.packets = int(self.user_params.get('performance_test_packets', 100))
+
+    def teardown_test(self):
+        self.performance_test_logger.dump_json(
+            os.path.join(get_current_context().get_full_output_path(), 'performance.json'))
+        super().teardown_test()
+
+    def _connect_and_open_channel_from_cert(self, initial_credit):
+        self.performance_test_logger.start_interval("CONNECT")
+        self._setup_link_from_cert()
+        self.performance_test_logger.end_interval("CONNECT")
+
+        self.performance_test_logger.start_interval("OPEN_CHANNEL")
+        (dut_channel, cert_channel) = self._open_channel_from_cert(initial_credit=initial_credit)
+        self.performance_test_logger.end_interval("OPEN_CHANNEL")
+        return (dut_channel, cert_channel)
+
+    def test_tx_throughput(self):
+        (dut_channel, cert_channel) = self._connect_and_open_channel_from_cert(initial_credit=self.packets)
+
+        self.performance_test_logger.start_interval("TX")
+        for _ in range(self.packets):
+            dut_channel.send(b'a' * SDU_SIZE)
+        assertThat(cert_channel).emits(
+            L2capMatchers.FirstLeIFrame(b'a' * SDU_SIZE, sdu_size=SDU_SIZE),
+            at_least_times=self.packets,
+            timeout=timedelta(seconds=60))
+        self.performance_test_logger.end_interval("TX")
+
+        duration = self.performance_test_logger.get_duration_of_intervals("TX")[0]
+        kbps = self.packets * SDU_SIZE * 8 / 1000 / duration.total_seconds()
+        self.performance_test_logger.log_value("TX_KBPS", kbps)
+        self.log.info("TX throughput: %.1f kbps" % kbps)
+
+    def test_tx_latency(self):
+        (dut_channel, cert_channel) = self._connect_and_open_channel_from_cert(initial_credit=self.packets)
+
+        for _ in range(self.packets):
+            self.performance_test_logger.start_interval("TX")
+            dut_channel.send(b'a' * SDU_SIZE)
+            assertThat(cert_channel).emits(L2capMatchers.FirstLeIFrame(b'a' * SDU_SIZE, sdu_size=SDU_SIZE))
+            self.performance_test_logger.end_interval("TX")
+
+        self.log.info("TX latency: %s" % self.performance_test_logger.get_summary_of_intervals("TX"))
+
+    def test_rx_latency(self):
+        (dut_channel, cert_channel) = self._connect_and_open_channel_from_cert(initial_credit=6)
+
+        # The DUT may only give credits back once they are all used
+        data = b'a' * SDU_SIZE
+        data_packet = RawBuilder([x for x in data])
+        for _ in range(min(self.packets, cert_channel.credits_left())):
+            self.performance_test_logger.start_interval("RX")
+            cert_channel.send_first_le_i_frame(SDU_SIZE, data_packet)
+            assertThat(dut_channel).emits(L2capMatchers.PacketPayloadRawData(data))
+            self.performance_test_logger.end_interval("RX")
+
+        self.log.info("RX latency: %s" % self.performance_test_logger.get_summary_of_intervals("RX"))
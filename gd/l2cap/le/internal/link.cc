@@ -208,6 +208,8 @@ std::shared_ptr<l2cap::internal::DynamicChannelImpl> Link::AllocateDynamicChanne
   if (channel != nullptr) {
     data_pipeline_manager_.AttachChannel(channel->GetCid(), channel,
                                          l2cap::internal::DataPipelineManager::ChannelMode::LE_CREDIT_BASED);
+    data_pipeline_manager_.SetChannelPriority(
+        channel->GetCid(), l2cap::internal::GetDefaultChannelPriority(channel->GetCid(), channel->GetPsm()));
     RefreshRefCount();
     channel->local_initiated_ = false;
   }
@@ -220,6 +222,8 @@ std::shared_ptr<l2cap::internal::DynamicChannelImpl> Link::AllocateReservedDynam
   if (channel != nullptr) {
     data_pipeline_manager_.AttachChannel(channel->GetCid(), channel,
                                          l2cap::internal::DataPipelineManager::ChannelMode::LE_CREDIT_BASED);
+    data_pipeline_manager_.SetChannelPriority(
+        channel->GetCid(), l2cap::internal::GetDefaultChannelPriority(channel->GetCid(), channel->GetPsm()));
     RefreshRefCount();
     channel->local_initiated_ = true;
   }
@@ -275,6 +279,10 @@ uint16_t Link::GetInitialCredit() const {
   return parameter_provider_->GetLeInitialCredit();
 }
 
+size_t Link::GetCreditMemoryCap() const {
+  return parameter_provider_->GetLeCreditMemoryCap();
+}
+
 void Link::SendLeCredit(Cid local_cid, uint16_t credit) {
   signalling_manager_.SendCredit(local_cid, credit);
 }
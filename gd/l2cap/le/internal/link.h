@@ -141,6 +141,8 @@ class Link : public l2cap::internal::ILink, public hci::acl_manager::LeConnectio
 
   virtual uint16_t GetInitialCredit() const;
 
+  virtual size_t GetCreditMemoryCap() const;
+
   void SendLeCredit(Cid local_cid, uint16_t credit) override;
 
   LinkOptions* GetLinkOptions() {
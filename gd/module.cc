@@ -16,17 +16,26 @@
 #define LOG_TAG "BtGdModule"
 
 #include "module.h"
+
+#include <condition_variable>
+#include <memory>
+
 #include "common/init_flags.h"
 #include "dumpsys/init_flags.h"
+#include "dumpsys/buffer_pool_stats.h"
+#include "dumpsys/task_latency_stats.h"
+#include "os/thread_pool.h"
 #include "os/wakelock_manager.h"
 
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::Thread;
+using ::bluetooth::os::ThreadPool;
 using ::bluetooth::os::WakelockManager;
 
 namespace bluetooth {
 
 constexpr std::chrono::milliseconds kModuleStopTimeout = std::chrono::milliseconds(2000);
+constexpr std::chrono::milliseconds kModuleStartTimeout = std::chrono::milliseconds(3000);
 
 ModuleFactory::ModuleFactory(std::function<Module*()> ctor) : ctor_(ctor) {
 }
@@ -56,19 +65,27 @@ Module* Module::GetDependency(const ModuleFactory* module) const {
 }
 
 Module* ModuleRegistry::Get(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto instance = started_modules_.find(module);
   ASSERT(instance != started_modules_.end());
   return instance->second;
 }
 
 bool ModuleRegistry::IsStarted(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   return started_modules_.find(module) != started_modules_.end();
 }
 
 void ModuleRegistry::Start(ModuleList* modules, Thread* thread) {
+  auto begin = std::chrono::steady_clock::now();
+  if (start_order_.empty()) {
+    start_begin_ = begin;
+  }
   for (auto it = modules->list_.begin(); it != modules->list_.end(); it++) {
-    Start(*it, thread);
+    StartModule(*it, thread);
   }
+  start_duration_ +=
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
 }
 
 void ModuleRegistry::set_registry_and_handler(Module* instance, Thread* thread) const {
@@ -77,9 +94,19 @@ void ModuleRegistry::set_registry_and_handler(Module* instance, Thread* thread)
 }
 
 Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
-  auto started_instance = started_modules_.find(module);
-  if (started_instance != started_modules_.end()) {
-    return started_instance->second;
+  if (start_order_.empty()) {
+    start_begin_ = std::chrono::steady_clock::now();
+  }
+  return StartModule(module, thread);
+}
+
+Module* ModuleRegistry::StartModule(const ModuleFactory* module, Thread* thread) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto started_instance = started_modules_.find(module);
+    if (started_instance != started_modules_.end()) {
+      return started_instance->second;
+    }
   }
 
   LOG_DEBUG("Constructing next module");
@@ -89,15 +116,143 @@ Module* ModuleRegistry::Start(const ModuleFactory* module, Thread* thread) {
 
   LOG_DEBUG("Starting dependencies of %s", instance->ToString().c_str());
   instance->ListDependencies(&instance->dependencies_);
-  Start(&instance->dependencies_, thread);
+  for (auto dependency : instance->dependencies_.list_) {
+    StartModule(dependency, thread);
+  }
 
   LOG_DEBUG("Finished starting dependencies and calling Start() of %s", instance->ToString().c_str());
 
+  auto begin = std::chrono::steady_clock::now();
   instance->Start();
+  RecordStart(module, instance, begin);
+  LOG_DEBUG("Started %s", instance->ToString().c_str());
+  return instance;
+}
+
+void ModuleRegistry::RecordStart(
+    const ModuleFactory* module, Module* instance, std::chrono::steady_clock::time_point begin) {
+  auto end = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
   start_order_.push_back(module);
   started_modules_[module] = instance;
+  start_times_[module] = StartTime{
+      .offset = std::chrono::duration_cast<std::chrono::microseconds>(begin - start_begin_),
+      .duration = std::chrono::duration_cast<std::chrono::microseconds>(end - begin),
+  };
+}
+
+// The modules to start in parallel, with the dependencies each of them still waits for
+struct ModuleRegistry::ParallelStart {
+  struct Node {
+    Module* instance = nullptr;
+    // Its own, as Start() of a module may run on any worker
+    std::unique_ptr<Handler> start_handler;
+    size_t num_pending_dependencies = 0;
+    std::vector<const ModuleFactory*> dependents;
+  };
+
+  std::mutex mutex;
+  std::condition_variable all_started;
+  std::map<const ModuleFactory*, Node> nodes;
+  size_t num_pending = 0;
+};
+
+void ModuleRegistry::StartInParallel(ModuleList* modules, Thread* thread, size_t num_start_threads) {
+  ASSERT(num_start_threads > 0);
+  auto begin = std::chrono::steady_clock::now();
+  if (start_order_.empty()) {
+    start_begin_ = begin;
+  }
+  started_in_parallel_ = true;
+
+  // Construct the modules which are not started yet, to know the dependencies of each of them
+  ParallelStart start;
+  std::vector<const ModuleFactory*> to_construct(modules->list_.begin(), modules->list_.end());
+  while (!to_construct.empty()) {
+    const ModuleFactory* module = to_construct.back();
+    to_construct.pop_back();
+    if (IsStarted(module) || start.nodes.find(module) != start.nodes.end()) {
+      continue;
+    }
+    Module* instance = module->ctor_();
+    set_registry_and_handler(instance, thread);
+    instance->ListDependencies(&instance->dependencies_);
+    start.nodes[module].instance = instance;
+    to_construct.insert(
+        to_construct.end(), instance->dependencies_.list_.begin(), instance->dependencies_.list_.end());
+  }
+  for (auto& node : start.nodes) {
+    for (auto dependency : node.second.instance->dependencies_.list_) {
+      auto dependency_node = start.nodes.find(dependency);
+      if (dependency_node != start.nodes.end()) {
+        dependency_node->second.dependents.push_back(node.first);
+        node.second.num_pending_dependencies++;
+      }
+    }
+  }
+  if (start.nodes.empty()) {
+    return;
+  }
+
+  ThreadPool pool("module_start", num_start_threads, Thread::Priority::NORMAL);
+  for (auto& node : start.nodes) {
+    node.second.start_handler = std::make_unique<Handler>(&pool);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(start.mutex);
+    start.num_pending = start.nodes.size();
+    for (auto& node : start.nodes) {
+      if (node.second.num_pending_dependencies == 0) {
+        PostModuleStart(&start, node.first);
+      }
+    }
+    // Modules which can't start are left waiting for a dependency, i.e. a dependency cycle
+    ASSERT_LOG(
+        start.all_started.wait_for(lock, kModuleStartTimeout, [&start]() { return start.num_pending == 0; }),
+        "Can't start modules in parallel, last instance: %s",
+        last_instance_.c_str());
+  }
+
+  for (auto& node : start.nodes) {
+    node.second.start_handler->Clear();
+    node.second.start_handler->WaitUntilStopped(kModuleStopTimeout);
+    node.second.start_handler.reset();
+  }
+  pool.Stop();
+  start_duration_ +=
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+}
+
+// Called with |start->mutex| held
+void ModuleRegistry::PostModuleStart(ParallelStart* start, const ModuleFactory* module) {
+  start->nodes.at(module).start_handler->Post(common::BindOnce(
+      &ModuleRegistry::StartModuleInParallel, common::Unretained(this), common::Unretained(start), module));
+}
+
+void ModuleRegistry::StartModuleInParallel(ParallelStart* start, const ModuleFactory* module) {
+  // The nodes are only added before the modules start
+  Module* instance = start->nodes.at(module).instance;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_instance_ = "starting " + instance->ToString();
+  }
+
+  LOG_DEBUG("Dependencies started, calling Start() of %s", instance->ToString().c_str());
+  auto begin = std::chrono::steady_clock::now();
+  instance->Start();
+  RecordStart(module, instance, begin);
   LOG_DEBUG("Started %s", instance->ToString().c_str());
-  return instance;
+
+  std::lock_guard<std::mutex> lock(start->mutex);
+  for (auto dependent : start->nodes.at(module).dependents) {
+    if (--start->nodes.at(dependent).num_pending_dependencies == 0) {
+      PostModuleStart(start, dependent);
+    }
+  }
+  if (--start->num_pending == 0) {
+    start->all_started.notify_one();
+  }
 }
 
 void ModuleRegistry::StopAll() {
@@ -124,9 +279,13 @@ void ModuleRegistry::StopAll() {
 
   ASSERT(started_modules_.empty());
   start_order_.clear();
+  start_times_.clear();
+  start_duration_ = std::chrono::microseconds(0);
+  started_in_parallel_ = false;
 }
 
 os::Handler* ModuleRegistry::GetModuleHandler(const ModuleFactory* module) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto started_instance = started_modules_.find(module);
   if (started_instance != started_modules_.end()) {
     return started_instance->second->GetHandler();
@@ -134,6 +293,41 @@ os::Handler* ModuleRegistry::GetModuleHandler(const ModuleFactory* module) const
   return nullptr;
 }
 
+flatbuffers::Offset<ModuleRegistryData> ModuleDumper::DumpStartTimes(flatbuffers::FlatBufferBuilder* builder) const {
+  std::vector<std::pair<const Module*, ModuleRegistry::StartTime>> start_times;
+  bool started_in_parallel;
+  std::chrono::microseconds start_duration;
+  {
+    std::lock_guard<std::mutex> lock(module_registry_.mutex_);
+    for (auto module : module_registry_.start_order_) {
+      auto start_time = module_registry_.start_times_.find(module);
+      // Test modules are injected without being started by the registry
+      if (start_time != module_registry_.start_times_.end()) {
+        start_times.emplace_back(module_registry_.started_modules_.at(module), start_time->second);
+      }
+    }
+    started_in_parallel = module_registry_.started_in_parallel_;
+    start_duration = module_registry_.start_duration_;
+  }
+
+  std::vector<flatbuffers::Offset<ModuleStartTimeData>> modules;
+  for (const auto& start_time : start_times) {
+    auto name = builder->CreateString(start_time.first->ToString());
+    ModuleStartTimeDataBuilder module_builder(*builder);
+    module_builder.add_name(name);
+    module_builder.add_start_offset_us(start_time.second.offset.count());
+    module_builder.add_start_duration_us(start_time.second.duration.count());
+    modules.push_back(module_builder.Finish());
+  }
+  auto modules_offset = builder->CreateVector(modules);
+
+  ModuleRegistryDataBuilder registry_builder(*builder);
+  registry_builder.add_started_in_parallel(started_in_parallel);
+  registry_builder.add_total_start_duration_us(start_duration.count());
+  registry_builder.add_modules(modules_offset);
+  return registry_builder.Finish();
+}
+
 void ModuleDumper::DumpState(std::string* output) const {
   ASSERT(output != nullptr);
 
@@ -142,6 +336,9 @@ void ModuleDumper::DumpState(std::string* output) const {
 
   auto init_flags_offset = dumpsys::InitFlags::Dump(&builder);
   auto wakelock_offset = WakelockManager::Get().GetDumpsysData(&builder);
+  auto task_latency_stats_offset = dumpsys::TaskLatencyStats::Dump(&builder);
+  auto buffer_pool_offset = dumpsys::BufferPoolStats::Dump(&builder);
+  auto module_registry_offset = DumpStartTimes(&builder);
 
   std::queue<DumpsysDataFinisher> queue;
   for (auto it = module_registry_.start_order_.rbegin(); it != module_registry_.start_order_.rend(); it++) {
@@ -154,6 +351,9 @@ void ModuleDumper::DumpState(std::string* output) const {
   data_builder.add_title(title);
   data_builder.add_init_flags(init_flags_offset);
   data_builder.add_wakelock_manager_data(wakelock_offset);
+  data_builder.add_task_latency_stats(task_latency_stats_offset);
+  data_builder.add_buffer_pool_data(buffer_pool_offset);
+  data_builder.add_module_registry_data(module_registry_offset);
 
   while (!queue.empty()) {
     queue.front()(&data_builder);
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <flatbuffers/flatbuffers.h>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -137,6 +139,10 @@ class ModuleRegistry {
   // in dependency order
   void Start(ModuleList* modules, ::bluetooth::os::Thread* thread);
 
+  // Same as Start(), but the Start() of modules not depending on each other run concurrently, on up to
+  // |num_start_threads| threads. A module still starts once all its dependencies have started.
+  void StartInParallel(ModuleList* modules, ::bluetooth::os::Thread* thread, size_t num_start_threads);
+
   template <class T>
   T* Start(::bluetooth::os::Thread* thread) {
     return static_cast<T*>(Start(&T::Factory, thread));
@@ -154,9 +160,30 @@ class ModuleRegistry {
 
   os::Handler* GetModuleHandler(const ModuleFactory* module) const;
 
+  struct StartTime {
+    // Since the start of the modules began
+    std::chrono::microseconds offset;
+    // Of the module's Start() only, without its dependencies
+    std::chrono::microseconds duration;
+  };
+
+  // Guards the started modules while they are started in parallel
+  mutable std::mutex mutex_;
   std::map<const ModuleFactory*, Module*> started_modules_;
   std::vector<const ModuleFactory*> start_order_;
+  std::map<const ModuleFactory*, StartTime> start_times_;
+  std::chrono::steady_clock::time_point start_begin_;
+  std::chrono::microseconds start_duration_{0};
+  bool started_in_parallel_ = false;
   std::string last_instance_;
+
+ private:
+  struct ParallelStart;
+
+  Module* StartModule(const ModuleFactory* module, ::bluetooth::os::Thread* thread);
+  void StartModuleInParallel(ParallelStart* start, const ModuleFactory* module);
+  void PostModuleStart(ParallelStart* start, const ModuleFactory* module);
+  void RecordStart(const ModuleFactory* module, Module* instance, std::chrono::steady_clock::time_point begin);
 };
 
 class ModuleDumper {
@@ -166,6 +193,8 @@ class ModuleDumper {
   void DumpState(std::string* output) const;
 
  private:
+  flatbuffers::Offset<ModuleRegistryData> DumpStartTimes(flatbuffers::FlatBufferBuilder* builder) const;
+
   const ModuleRegistry& module_registry_;
   const std::string title_;
 };
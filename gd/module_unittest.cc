@@ -21,9 +21,11 @@
 
 #include "gtest/gtest.h"
 
+#include <atomic>
 #include <functional>
 #include <future>
 #include <string>
+#include <thread>
 
 using ::bluetooth::os::Thread;
 
@@ -219,6 +221,68 @@ class TestModuleDumpState : public Module {
 
 const ModuleFactory TestModuleDumpState::Factory = ModuleFactory([]() { return new TestModuleDumpState(); });
 
+// Each one waits in Start() until the other one has entered its Start() too, so they only start if they run
+// concurrently
+std::atomic<int> num_concurrent_modules_entered{0};
+std::atomic<bool> concurrent_modules_overlapped{false};
+
+void WaitForOtherConcurrentModule() {
+  num_concurrent_modules_entered++;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (num_concurrent_modules_entered < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (num_concurrent_modules_entered >= 2) {
+    concurrent_modules_overlapped = true;
+  }
+}
+
+class TestModuleConcurrentOne : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {
+    list->add<TestModuleNoDependency>();
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    WaitForOtherConcurrentModule();
+  }
+
+  void Stop() override {}
+
+  std::string ToString() const override {
+    return std::string("TestModuleConcurrentOne");
+  }
+};
+
+const ModuleFactory TestModuleConcurrentOne::Factory = ModuleFactory([]() { return new TestModuleConcurrentOne(); });
+
+class TestModuleConcurrentTwo : public Module {
+ public:
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override {
+    list->add<TestModuleNoDependency>();
+  }
+
+  void Start() override {
+    EXPECT_TRUE(GetModuleRegistry()->IsStarted<TestModuleNoDependency>());
+    WaitForOtherConcurrentModule();
+  }
+
+  void Stop() override {}
+
+  std::string ToString() const override {
+    return std::string("TestModuleConcurrentTwo");
+  }
+};
+
+const ModuleFactory TestModuleConcurrentTwo::Factory = ModuleFactory([]() { return new TestModuleConcurrentTwo(); });
+
 TEST_F(ModuleTest, no_dependency) {
   ModuleList list;
   list.add<TestModuleNoDependency>();
@@ -316,5 +380,63 @@ TEST_F(ModuleTest, dump_state) {
   registry_->StopAll();
 }
 
+TEST_F(ModuleTest, two_dependencies_in_parallel) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 2);
+
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleTwoDependencies>());
+
+  registry_->StopAll();
+
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleOneDependency>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleNoDependencyTwo>());
+  EXPECT_FALSE(registry_->IsStarted<TestModuleTwoDependencies>());
+}
+
+TEST_F(ModuleTest, independent_modules_start_concurrently) {
+  num_concurrent_modules_entered = 0;
+  concurrent_modules_overlapped = false;
+
+  ModuleList list;
+  list.add<TestModuleConcurrentOne>();
+  list.add<TestModuleConcurrentTwo>();
+  registry_->StartInParallel(&list, thread_, 2);
+
+  EXPECT_TRUE(concurrent_modules_overlapped);
+  EXPECT_TRUE(registry_->IsStarted<TestModuleConcurrentOne>());
+  EXPECT_TRUE(registry_->IsStarted<TestModuleConcurrentTwo>());
+
+  registry_->StopAll();
+}
+
+TEST_F(ModuleTest, dump_start_times) {
+  ModuleList list;
+  list.add<TestModuleTwoDependencies>();
+  registry_->StartInParallel(&list, thread_, 2);
+
+  ModuleDumper dumper(*registry_, "Test Dump Title");
+  std::string output;
+  dumper.DumpState(&output);
+
+  auto data = flatbuffers::GetRoot<DumpsysData>(output.data());
+  auto registry_data = data->module_registry_data();
+  ASSERT_NE(registry_data, nullptr);
+  EXPECT_TRUE(registry_data->started_in_parallel());
+  ASSERT_EQ(registry_data->modules()->size(), 4u);
+  // Dependencies come first
+  EXPECT_STREQ("TestModuleTwoDependencies", registry_data->modules()->Get(3)->name()->c_str());
+  for (auto module : *registry_data->modules()) {
+    EXPECT_GE(module->start_duration_us(), 0);
+    EXPECT_LE(module->start_offset_us() + module->start_duration_us(), registry_data->total_start_duration_us());
+  }
+
+  registry_->StopAll();
+}
+
 }  // namespace
 }  // namespace bluetooth
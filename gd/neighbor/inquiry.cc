@@ -48,6 +48,7 @@ struct InquiryModule::impl {
   void StopPeriodicInquiry();
 
   void SetScanActivity(ScanParameters params);
+  void SetScanDutyCycleLimit(ScanDutyCycle limit);
 
   void SetScanType(hci::InquiryScanType scan_type);
 
@@ -70,13 +71,16 @@ struct InquiryModule::impl {
   bool active_general_periodic_{false};
   bool active_limited_periodic_{false};
 
-  ScanParameters inquiry_scan_;
+  ScanParameters inquiry_scan_{};
+  ScanDutyCycle scan_duty_cycle_limit_{kScanDutyCycleUnlimited};
   hci::InquiryMode inquiry_mode_;
   hci::InquiryScanType inquiry_scan_type_;
   int8_t inquiry_response_tx_power_;
 
   bool IsInquiryActive() const;
 
+  void WriteScanActivity();
+
   void EnqueueCommandComplete(std::unique_ptr<hci::CommandBuilder> command);
   void EnqueueCommandStatus(std::unique_ptr<hci::CommandBuilder> command);
   void OnCommandComplete(hci::CommandCompleteView view);
@@ -155,6 +159,9 @@ void neighbor::InquiryModule::impl::OnCommandComplete(hci::CommandCompleteView v
       ASSERT(packet.GetStatus() == hci::ErrorCode::SUCCESS);
       inquiry_scan_.interval = packet.GetInquiryScanInterval();
       inquiry_scan_.window = packet.GetInquiryScanWindow();
+      if (scan_duty_cycle_limit_ != kScanDutyCycleUnlimited) {
+        WriteScanActivity();
+      }
     } break;
 
     case hci::OpCode::WRITE_INQUIRY_SCAN_TYPE: {
@@ -363,14 +370,29 @@ void neighbor::InquiryModule::impl::SetInquiryMode(hci::InquiryMode mode) {
 }
 
 void neighbor::InquiryModule::impl::SetScanActivity(ScanParameters params) {
-  EnqueueCommandComplete(hci::WriteInquiryScanActivityBuilder::Create(params.interval, params.window));
   inquiry_scan_ = params;
+  WriteScanActivity();
+}
+
+void neighbor::InquiryModule::impl::SetScanDutyCycleLimit(ScanDutyCycle limit) {
+  if (limit == scan_duty_cycle_limit_) return;
+  scan_duty_cycle_limit_ = limit;
+  // The requested activity is not known until the initial read completes, which then applies the limit
+  if (inquiry_scan_.interval != 0) {
+    WriteScanActivity();
+  }
+}
+
+void neighbor::InquiryModule::impl::WriteScanActivity() {
+  ScanParameters params = LimitScanDutyCycle(inquiry_scan_, scan_duty_cycle_limit_);
+  EnqueueCommandComplete(hci::WriteInquiryScanActivityBuilder::Create(params.interval, params.window));
   LOG_INFO(
-      "Set scan activity interval:0x%x/%.02fms window:0x%x/%.02fms",
+      "Set scan activity interval:0x%x/%.02fms window:0x%x/%.02fms duty cycle limit:%hu",
       params.interval,
       ScanIntervalTimeMs(params.interval),
       params.window,
-      ScanWindowTimeMs(params.window));
+      ScanWindowTimeMs(params.window),
+      scan_duty_cycle_limit_);
 }
 
 void neighbor::InquiryModule::impl::SetScanType(hci::InquiryScanType scan_type) {
@@ -457,6 +479,11 @@ void neighbor::InquiryModule::SetScanActivity(ScanParameters params) {
       common::BindOnce(&neighbor::InquiryModule::impl::SetScanActivity, common::Unretained(pimpl_.get()), params));
 }
 
+void neighbor::InquiryModule::SetScanDutyCycleLimit(ScanDutyCycle limit) {
+  GetHandler()->Post(common::BindOnce(
+      &neighbor::InquiryModule::impl::SetScanDutyCycleLimit, common::Unretained(pimpl_.get()), limit));
+}
+
 void neighbor::InquiryModule::SetInterlacedScan() {
   GetHandler()->Post(common::BindOnce(
       &neighbor::InquiryModule::impl::SetScanType, common::Unretained(pimpl_.get()), hci::InquiryScanType::INTERLACED));
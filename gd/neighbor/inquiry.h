@@ -56,6 +56,8 @@ class InquiryModule : public bluetooth::Module {
   void StopPeriodicInquiry();
 
   void SetScanActivity(ScanParameters parms);
+  // Caps the inquiry scan window to |limit| per mille of the interval set with SetScanActivity
+  void SetScanDutyCycleLimit(ScanDutyCycle limit);
 
   void SetInterlacedScan();
   void SetStandardScan();
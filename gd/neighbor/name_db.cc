@@ -17,6 +17,7 @@
 
 #include "neighbor/name_db.h"
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -35,6 +36,14 @@ struct PendingRemoteNameRead {
   ReadRemoteNameDbCallback callback_;
   os::Handler* handler_;
 };
+
+// Names read less than this ago are used instead of reading them again
+constexpr std::chrono::hours kNameCacheTtl(24);
+
+struct CachedRemoteName {
+  RemoteName name_;
+  std::chrono::steady_clock::time_point read_time_;
+};
 }  // namespace
 
 struct NameDbModule::impl {
@@ -50,7 +59,7 @@ struct NameDbModule::impl {
 
  private:
   std::unordered_map<hci::Address, std::list<PendingRemoteNameRead>> address_to_pending_read_map_;
-  std::unordered_map<hci::Address, RemoteName> address_to_name_map_;
+  std::unordered_map<hci::Address, CachedRemoteName> address_to_name_map_;
 
   void OnRemoteNameResponse(hci::ErrorCode status, hci::Address address, RemoteName name);
 
@@ -66,6 +75,11 @@ neighbor::NameDbModule::impl::impl(const neighbor::NameDbModule& module) : modul
 
 void neighbor::NameDbModule::impl::ReadRemoteNameRequest(
     hci::Address address, ReadRemoteNameDbCallback callback, os::Handler* handler) {
+  if (IsNameCached(address)) {
+    handler->Call(std::move(callback), address, true);
+    return;
+  }
+
   if (address_to_pending_read_map_.find(address) != address_to_pending_read_map_.end()) {
     LOG_WARN("Already have remote read db in progress; adding callback to callback list");
     address_to_pending_read_map_[address].push_back({std::move(callback), handler});
@@ -92,7 +106,7 @@ void neighbor::NameDbModule::impl::ReadRemoteNameRequest(
 void neighbor::NameDbModule::impl::OnRemoteNameResponse(hci::ErrorCode status, hci::Address address, RemoteName name) {
   ASSERT(address_to_pending_read_map_.find(address) != address_to_pending_read_map_.end());
   if (status == hci::ErrorCode::SUCCESS) {
-    address_to_name_map_[address] = name;
+    address_to_name_map_[address] = {name, std::chrono::steady_clock::now()};
   }
   auto& callback_list = address_to_pending_read_map_.at(address);
   for (auto& it : callback_list) {
@@ -102,12 +116,13 @@ void neighbor::NameDbModule::impl::OnRemoteNameResponse(hci::ErrorCode status, h
 }
 
 bool neighbor::NameDbModule::impl::IsNameCached(hci::Address address) const {
-  return address_to_name_map_.count(address) == 1;
+  auto it = address_to_name_map_.find(address);
+  return it != address_to_name_map_.end() && std::chrono::steady_clock::now() - it->second.read_time_ < kNameCacheTtl;
 }
 
 RemoteName neighbor::NameDbModule::impl::ReadCachedRemoteName(hci::Address address) const {
   ASSERT(IsNameCached(address));
-  return address_to_name_map_.at(address);
+  return address_to_name_map_.at(address).name_;
 }
 
 /**
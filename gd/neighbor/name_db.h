@@ -34,6 +34,7 @@ class NameDbModule : public bluetooth::Module {
  public:
   virtual void ReadRemoteNameRequest(hci::Address address, ReadRemoteNameDbCallback callback, os::Handler* handler);
 
+  // Names are cached for a day, requests for a cached name complete without reading it over the air
   bool IsNameCached(hci::Address address) const;
   RemoteName ReadCachedRemoteName(hci::Address address) const;
 
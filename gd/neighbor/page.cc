@@ -32,6 +32,7 @@ namespace neighbor {
 
 struct PageModule::impl {
   void SetScanActivity(ScanParameters params);
+  void SetScanDutyCycleLimit(ScanDutyCycle limit);
   ScanParameters GetScanActivity() const;
 
   void SetScanType(hci::PageScanType type);
@@ -47,9 +48,14 @@ struct PageModule::impl {
   PageModule& module_;
 
   ScanParameters scan_parameters_;
+  // Activity requested by SetScanActivity, or read at start, before the duty cycle limit is applied
+  ScanParameters requested_scan_parameters_{};
+  ScanDutyCycle scan_duty_cycle_limit_{kScanDutyCycleUnlimited};
   hci::PageScanType scan_type_;
   PageTimeout timeout_;
 
+  void WriteScanActivity();
+
   void OnCommandComplete(hci::CommandCompleteView status);
 
   hci::HciLayer* hci_layer_;
@@ -74,6 +80,12 @@ void neighbor::PageModule::impl::OnCommandComplete(hci::CommandCompleteView view
       ASSERT(packet.GetStatus() == hci::ErrorCode::SUCCESS);
       scan_parameters_.interval = packet.GetPageScanInterval();
       scan_parameters_.window = packet.GetPageScanWindow();
+      if (requested_scan_parameters_.interval == 0) {
+        requested_scan_parameters_ = scan_parameters_;
+        if (scan_duty_cycle_limit_ != kScanDutyCycleUnlimited) {
+          WriteScanActivity();
+        }
+      }
     } break;
 
     case hci::OpCode::WRITE_PAGE_SCAN_TYPE: {
@@ -128,6 +140,21 @@ void neighbor::PageModule::impl::Stop() {
 }
 
 void neighbor::PageModule::impl::SetScanActivity(ScanParameters params) {
+  requested_scan_parameters_ = params;
+  WriteScanActivity();
+}
+
+void neighbor::PageModule::impl::SetScanDutyCycleLimit(ScanDutyCycle limit) {
+  if (limit == scan_duty_cycle_limit_) return;
+  scan_duty_cycle_limit_ = limit;
+  // The requested activity is not known until the initial read completes, which then applies the limit
+  if (requested_scan_parameters_.interval != 0) {
+    WriteScanActivity();
+  }
+}
+
+void neighbor::PageModule::impl::WriteScanActivity() {
+  ScanParameters params = LimitScanDutyCycle(requested_scan_parameters_, scan_duty_cycle_limit_);
   hci_layer_->EnqueueCommand(
       hci::WritePageScanActivityBuilder::Create(params.interval, params.window),
       handler_->BindOnceOn(this, &impl::OnCommandComplete));
@@ -135,11 +162,12 @@ void neighbor::PageModule::impl::SetScanActivity(ScanParameters params) {
   hci_layer_->EnqueueCommand(
       hci::ReadPageScanActivityBuilder::Create(), handler_->BindOnceOn(this, &impl::OnCommandComplete));
   LOG_INFO(
-      "Set page scan activity interval:0x%x/%.02fms window:0x%x/%.02fms",
+      "Set page scan activity interval:0x%x/%.02fms window:0x%x/%.02fms duty cycle limit:%hu",
       params.interval,
       ScanIntervalTimeMs(params.interval),
       params.window,
-      ScanWindowTimeMs(params.window));
+      ScanWindowTimeMs(params.window),
+      scan_duty_cycle_limit_);
 }
 
 ScanParameters neighbor::PageModule::impl::GetScanActivity() const {
@@ -177,6 +205,10 @@ void neighbor::PageModule::SetScanActivity(ScanParameters params) {
   pimpl_->SetScanActivity(params);
 }
 
+void neighbor::PageModule::SetScanDutyCycleLimit(ScanDutyCycle limit) {
+  CallOn(pimpl_.get(), &impl::SetScanDutyCycleLimit, limit);
+}
+
 ScanParameters neighbor::PageModule::GetScanActivity() const {
   return pimpl_->GetScanActivity();
 }
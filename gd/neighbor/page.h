@@ -33,6 +33,8 @@ inline double PageTimeoutMs(PageTimeout timeout) {
 class PageModule : public bluetooth::Module {
  public:
   void SetScanActivity(ScanParameters params);
+  // Caps the page scan window to |limit| per mille of the interval set with SetScanActivity
+  void SetScanDutyCycleLimit(ScanDutyCycle limit);
   ScanParameters GetScanActivity() const;
 
   void SetInterlacedScan();
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define LOG_TAG "bt_gd_neigh"
+
+#include "neighbor/radio_scheduler.h"
+
+#include <memory>
+#include <mutex>
+
+#include "hci/le_scanning_manager.h"
+#include "module.h"
+#include "neighbor/inquiry.h"
+#include "neighbor/page.h"
+#include "os/handler.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace neighbor {
+
+// Limits when streaming: the stream gets nearly all of the radio, scans only keep the device reachable
+static constexpr ScanDutyCycles kStreamingDutyCycles = {20, 20, 50};
+// Limits when streaming while pairing: pairing stays possible at the cost of some stream margin
+static constexpr ScanDutyCycles kStreamingPairingDutyCycles = {100, 50, 200};
+static constexpr ScanDutyCycle kPairingLeScanDutyCycle = 800;
+static constexpr ScanDutyCycle kBackgroundLeScanDutyCycle = 300;
+
+ScanDutyCycles ComputeScanDutyCycles(bool streaming, bool pairing, bool background) {
+  if (streaming) {
+    return pairing ? kStreamingPairingDutyCycles : kStreamingDutyCycles;
+  }
+  ScanDutyCycles duty_cycles = {kScanDutyCycleUnlimited, kScanDutyCycleUnlimited, kScanDutyCycleUnlimited};
+  if (pairing) {
+    duty_cycles.le_scan = kPairingLeScanDutyCycle;
+  } else if (background) {
+    duty_cycles.le_scan = kBackgroundLeScanDutyCycle;
+  }
+  return duty_cycles;
+}
+
+struct RadioScheduler::impl {
+  void AddUseCase(RadioUseCase use_case);
+  void RemoveUseCase(RadioUseCase use_case);
+  ScanDutyCycles GetDutyCycles() const;
+
+  void Start();
+  void Stop();
+
+  impl(RadioScheduler& radio_scheduler);
+
+ private:
+  RadioScheduler& module_;
+
+  InquiryModule* inquiry_module_;
+  PageModule* page_module_;
+  hci::LeScanningManager* le_scanning_manager_;
+
+  int streaming_count_{0};
+  int pairing_count_{0};
+  int background_count_{0};
+
+  mutable std::mutex mutex_;
+  ScanDutyCycles duty_cycles_ = {kScanDutyCycleUnlimited, kScanDutyCycleUnlimited, kScanDutyCycleUnlimited};
+
+  int* Count(RadioUseCase use_case);
+  void Apply();
+};
+
+const ModuleFactory neighbor::RadioScheduler::Factory = ModuleFactory([]() { return new RadioScheduler(); });
+
+neighbor::RadioScheduler::impl::impl(neighbor::RadioScheduler& module) : module_(module) {}
+
+int* neighbor::RadioScheduler::impl::Count(RadioUseCase use_case) {
+  switch (use_case) {
+    case RadioUseCase::STREAMING:
+      return &streaming_count_;
+    case RadioUseCase::PAIRING:
+      return &pairing_count_;
+    case RadioUseCase::BACKGROUND:
+      return &background_count_;
+  }
+  return nullptr;
+}
+
+void neighbor::RadioScheduler::impl::AddUseCase(RadioUseCase use_case) {
+  (*Count(use_case))++;
+  Apply();
+}
+
+void neighbor::RadioScheduler::impl::RemoveUseCase(RadioUseCase use_case) {
+  int* count = Count(use_case);
+  if (*count == 0) {
+    LOG_WARN("Removing inactive radio use case:%d", static_cast<int>(use_case));
+    return;
+  }
+  (*count)--;
+  Apply();
+}
+
+ScanDutyCycles neighbor::RadioScheduler::impl::GetDutyCycles() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return duty_cycles_;
+}
+
+// Programs all the scan limits from one plan, so that the scans never run with limits from different use cases
+void neighbor::RadioScheduler::impl::Apply() {
+  ScanDutyCycles duty_cycles = ComputeScanDutyCycles(streaming_count_ > 0, pairing_count_ > 0, background_count_ > 0);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (duty_cycles == duty_cycles_) return;
+    duty_cycles_ = duty_cycles;
+  }
+  LOG_INFO(
+      "Scan duty cycles inquiry:%hu page:%hu le:%hu streaming:%d pairing:%d background:%d",
+      duty_cycles.inquiry_scan,
+      duty_cycles.page_scan,
+      duty_cycles.le_scan,
+      streaming_count_,
+      pairing_count_,
+      background_count_);
+  inquiry_module_->SetScanDutyCycleLimit(duty_cycles.inquiry_scan);
+  page_module_->SetScanDutyCycleLimit(duty_cycles.page_scan);
+  le_scanning_manager_->SetScanDutyCycleLimit(duty_cycles.le_scan);
+}
+
+void neighbor::RadioScheduler::impl::Start() {
+  inquiry_module_ = module_.GetDependency<InquiryModule>();
+  page_module_ = module_.GetDependency<PageModule>();
+  le_scanning_manager_ = module_.GetDependency<hci::LeScanningManager>();
+}
+
+void neighbor::RadioScheduler::impl::Stop() {
+  ScanDutyCycles duty_cycles = GetDutyCycles();
+  LOG_INFO(
+      "Scan duty cycles inquiry:%hu page:%hu le:%hu",
+      duty_cycles.inquiry_scan,
+      duty_cycles.page_scan,
+      duty_cycles.le_scan);
+}
+
+/**
+ * General API here
+ */
+neighbor::RadioScheduler::RadioScheduler() : pimpl_(std::make_unique<impl>(*this)) {}
+
+neighbor::RadioScheduler::~RadioScheduler() {
+  pimpl_.reset();
+}
+
+void neighbor::RadioScheduler::AddUseCase(RadioUseCase use_case) {
+  CallOn(pimpl_.get(), &impl::AddUseCase, use_case);
+}
+
+void neighbor::RadioScheduler::RemoveUseCase(RadioUseCase use_case) {
+  CallOn(pimpl_.get(), &impl::RemoveUseCase, use_case);
+}
+
+ScanDutyCycles neighbor::RadioScheduler::GetDutyCycles() const {
+  return pimpl_->GetDutyCycles();
+}
+
+/**
+ * Module methods here
+ */
+void neighbor::RadioScheduler::ListDependencies(ModuleList* list) {
+  list->add<InquiryModule>();
+  list->add<PageModule>();
+  list->add<hci::LeScanningManager>();
+}
+
+void neighbor::RadioScheduler::Start() {
+  pimpl_->Start();
+}
+
+void neighbor::RadioScheduler::Stop() {
+  pimpl_->Stop();
+}
+
+}  // namespace neighbor
+}  // namespace bluetooth
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+
+#include "module.h"
+#include "neighbor/scan_parameters.h"
+
+namespace bluetooth {
+namespace neighbor {
+
+// Activities competing for the radio time left to scans
+enum class RadioUseCase {
+  STREAMING,   // Isochronous audio, which needs most of the radio time
+  PAIRING,     // Inquiry or user initiated discovery, scans must stay responsive
+  BACKGROUND,  // Opportunistic LE scans
+};
+
+// Per mille of the radio time each scan may use
+struct ScanDutyCycles {
+  ScanDutyCycle inquiry_scan;
+  ScanDutyCycle page_scan;
+  ScanDutyCycle le_scan;
+
+  bool operator==(const ScanDutyCycles& other) const {
+    return inquiry_scan == other.inquiry_scan && page_scan == other.page_scan && le_scan == other.le_scan;
+  }
+};
+
+// Returns the scan duty cycle limits for the set of active use cases
+ScanDutyCycles ComputeScanDutyCycles(bool streaming, bool pairing, bool background);
+
+// Arbitrates the radio time between inquiry scan, page scan and LE scan. Each use case is reference counted, and
+// every change programs the three scan duty cycle limits together from a single plan.
+class RadioScheduler : public bluetooth::Module {
+ public:
+  RadioScheduler();
+  ~RadioScheduler();
+
+  void AddUseCase(RadioUseCase use_case);
+  void RemoveUseCase(RadioUseCase use_case);
+
+  // Limits programmed for the current use cases
+  ScanDutyCycles GetDutyCycles() const;
+
+  static const ModuleFactory Factory;
+
+ protected:
+  void ListDependencies(ModuleList* list) override;
+  void Start() override;
+  void Stop() override;
+  std::string ToString() const override {
+    return std::string("RadioScheduler");
+  }
+
+ private:
+  struct impl;
+  std::unique_ptr<impl> pimpl_;
+
+  DISALLOW_COPY_AND_ASSIGN(RadioScheduler);
+};
+
+}  // namespace neighbor
+}  // namespace bluetooth
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "neighbor/radio_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include "neighbor/scan_parameters.h"
+
+namespace bluetooth {
+namespace neighbor {
+namespace {
+
+static constexpr ScanDutyCycles kUnlimited = {
+    kScanDutyCycleUnlimited, kScanDutyCycleUnlimited, kScanDutyCycleUnlimited};
+
+TEST(RadioSchedulerTest, idle_radio_is_unlimited) {
+  ASSERT_EQ(kUnlimited, ComputeScanDutyCycles(false, false, false));
+}
+
+TEST(RadioSchedulerTest, background_only_limits_le_scan) {
+  ScanDutyCycles duty_cycles = ComputeScanDutyCycles(false, false, true);
+  ASSERT_EQ(kScanDutyCycleUnlimited, duty_cycles.inquiry_scan);
+  ASSERT_EQ(kScanDutyCycleUnlimited, duty_cycles.page_scan);
+  ASSERT_LT(duty_cycles.le_scan, kScanDutyCycleUnlimited);
+}
+
+TEST(RadioSchedulerTest, pairing_scans_more_than_background) {
+  ScanDutyCycles pairing = ComputeScanDutyCycles(false, true, true);
+  ASSERT_EQ(pairing, ComputeScanDutyCycles(false, true, false));
+  ASSERT_GT(pairing.le_scan, ComputeScanDutyCycles(false, false, true).le_scan);
+}
+
+TEST(RadioSchedulerTest, streaming_limits_every_scan) {
+  ScanDutyCycles streaming = ComputeScanDutyCycles(true, false, false);
+  ASSERT_EQ(streaming, ComputeScanDutyCycles(true, false, true));
+  ASSERT_LE(streaming.inquiry_scan, 100);
+  ASSERT_LE(streaming.page_scan, 100);
+  ASSERT_LE(streaming.le_scan, 100);
+
+  ScanDutyCycles streaming_pairing = ComputeScanDutyCycles(true, true, false);
+  ASSERT_GT(streaming_pairing.inquiry_scan, streaming.inquiry_scan);
+  ASSERT_GT(streaming_pairing.le_scan, streaming.le_scan);
+  ASSERT_LT(streaming_pairing.le_scan, ComputeScanDutyCycles(false, true, false).le_scan);
+}
+
+TEST(RadioSchedulerTest, limit_keeps_parameters_within_limit) {
+  ScanParameters params = {0x0800, 0x0012};
+  ScanParameters limited = LimitScanDutyCycle(params, 20);
+  ASSERT_EQ(params.interval, limited.interval);
+  ASSERT_EQ(params.window, limited.window);
+
+  ASSERT_EQ(0x0800, LimitScanDutyCycle({0x0800, 0x0800}, kScanDutyCycleUnlimited).window);
+}
+
+TEST(RadioSchedulerTest, limit_shortens_window) {
+  ScanParameters limited = LimitScanDutyCycle({0x0800, 0x0400}, 100);
+  ASSERT_EQ(0x0800, limited.interval);
+  ASSERT_EQ(0x00cc, limited.window);
+  ASSERT_LE(GetScanDutyCycle(limited), 100);
+}
+
+TEST(RadioSchedulerTest, limit_stretches_interval_below_minimum_window) {
+  ScanParameters limited = LimitScanDutyCycle({0x0100, 0x0080}, 20);
+  ASSERT_EQ(kScanWindowMin, limited.window);
+  ASSERT_EQ(0, limited.interval % 2);
+  ASSERT_LE(limited.interval, kScanIntervalMax);
+  ASSERT_LE(GetScanDutyCycle(limited), 20);
+
+  // The longest interval is the best effort when the minimum window exceeds the limit
+  limited = LimitScanDutyCycle({0x0100, 0x0080}, 1);
+  ASSERT_EQ(kScanWindowMin, limited.window);
+  ASSERT_EQ(kScanIntervalMax, limited.interval);
+}
+
+}  // namespace
+}  // namespace neighbor
+}  // namespace bluetooth
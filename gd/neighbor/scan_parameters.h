@@ -15,6 +15,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 
 namespace bluetooth {
@@ -38,5 +39,33 @@ using ScanParameters = struct {
   ScanWindow window;
 };
 
+static constexpr ScanWindow kScanWindowMin = 0x0011;
+static constexpr ScanInterval kScanIntervalMax = 0x1000;
+
+using ScanDutyCycle = uint16_t;  // Per mille of the radio time spent scanning
+static constexpr ScanDutyCycle kScanDutyCycleUnlimited = 1000;
+
+inline ScanDutyCycle GetScanDutyCycle(ScanParameters params) {
+  if (params.interval == 0) return 0;
+  return static_cast<uint32_t>(params.window) * kScanDutyCycleUnlimited / params.interval;
+}
+
+// Returns |params| with a window of at most |limit| per mille of the interval. When that window would be
+// shorter than the minimum window, the minimum window is kept and the interval is stretched instead.
+inline ScanParameters LimitScanDutyCycle(ScanParameters params, ScanDutyCycle limit) {
+  if (limit >= kScanDutyCycleUnlimited || GetScanDutyCycle(params) <= limit) return params;
+  uint32_t window = static_cast<uint32_t>(params.interval) * limit / kScanDutyCycleUnlimited;
+  if (window >= kScanWindowMin) {
+    params.window = window;
+    return params;
+  }
+  params.window = std::min<ScanWindow>(params.window, kScanWindowMin);
+  uint32_t interval = limit == 0 ? kScanIntervalMax
+                                 : (static_cast<uint32_t>(params.window) * kScanDutyCycleUnlimited + limit - 1) / limit;
+  interval = std::min<uint32_t>(interval + (interval & 1), kScanIntervalMax);
+  params.interval = std::max<uint32_t>(interval, params.interval);
+  return params;
+}
+
 }  // namespace neighbor
 }  // namespace bluetooth
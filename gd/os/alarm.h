@@ -29,8 +29,8 @@ namespace bluetooth {
 namespace os {
 
 // A single-shot alarm for reactor-based thread, implemented by Linux timerfd.
-// When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
-// itself from the thread.
+// The timerfd is created and registered on the specified thread the first time Schedule() is invoked; when it's
+// destroyed, it will unregister itself from the thread. Alarms scheduled with slack don't use a timerfd of their own.
 class Alarm {
  public:
   // Create and register a single-shot alarm on a given handler
@@ -44,16 +44,26 @@ class Alarm {
   // Schedule the alarm with given delay
   void Schedule(common::OnceClosure task, std::chrono::milliseconds delay);
 
+  // Schedule the alarm to fire at any point between delay and delay + slack. Expiries of all slack alarms on the same
+  // thread are batched into one wakeup whenever their windows overlap, so use it for timers that can run late.
+  void ScheduleWithSlack(common::OnceClosure task, std::chrono::milliseconds delay, std::chrono::milliseconds slack);
+
   // Cancel the alarm. No-op if it's not armed.
   void Cancel();
 
  private:
   common::OnceClosure task_;
   Handler* handler_;
-  int fd_ = 0;
-  Reactor::Reactable* token_;
+  int fd_ = -1;
+  Reactor::Reactable* token_ = nullptr;
+  uint64_t slack_id_ = 0;
+  uint64_t generation_ = 0;
   mutable std::mutex mutex_;
   void on_fire();
+  void on_slack_fire(uint64_t generation);
+  void disarm_locked();
+  uint64_t take_slack_id_locked();
+  void cancel_slack(uint64_t slack_id);
 };
 
 }  // namespace os
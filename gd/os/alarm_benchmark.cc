@@ -14,9 +14,17 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <future>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "common/bind.h"
@@ -140,3 +148,112 @@ BENCHMARK_REGISTER_F(BM_ReactableAlarm, periodic_accuracy)
     ->Args({2000, 15, 20})
     ->Iterations(1)
     ->UseRealTime();
+
+namespace {
+
+size_t CountOpenFds() {
+  size_t count = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir == nullptr) {
+    return 0;
+  }
+  while (readdir(dir) != nullptr) {
+    count++;
+  }
+  closedir(dir);
+  return count;
+}
+
+// Every time the thread goes back to epoll_wait() and is woken up again, it is counted as a voluntary context switch
+uint64_t CountWakeups(pid_t tid) {
+  std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+  std::string key;
+  while (status >> key) {
+    if (key == "voluntary_ctxt_switches:") {
+      uint64_t value = 0;
+      status >> value;
+      return value;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+class BM_ReactableAlarmCoalescing : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    thread_ = std::make_unique<Thread>("timer_benchmark", Thread::Priority::NORMAL);
+    handler_ = std::make_unique<Handler>(thread_.get());
+    fire_count_ = 0;
+  }
+
+  void TearDown(State& st) override {
+    handler_->Clear();
+    handler_ = nullptr;
+    thread_->Stop();
+    thread_ = nullptr;
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  pid_t GetThreadId() {
+    std::promise<pid_t> promise;
+    auto future = promise.get_future();
+    handler_->Post(bluetooth::common::BindOnce(
+        [](std::promise<pid_t>* promise) { promise->set_value(static_cast<pid_t>(syscall(SYS_gettid))); },
+        bluetooth::common::Unretained(&promise)));
+    return future.get();
+  }
+
+  void OnFire() {
+    fire_count_++;
+  }
+
+  std::atomic<uint64_t> fire_count_;
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<Handler> handler_;
+};
+
+// Run range(0) repeating alarms with staggered periods on one thread for a few seconds. With range(1) == 0 each alarm
+// uses its own timerfd, otherwise it is scheduled with range(1) milliseconds of slack and all alarms share one timerfd.
+BENCHMARK_DEFINE_F(BM_ReactableAlarmCoalescing, many_repeating_alarms)(State& state) {
+  constexpr auto kMeasurementTime = std::chrono::seconds(2);
+  auto num_alarms = static_cast<int>(state.range(0));
+  auto slack = std::chrono::milliseconds(state.range(1));
+  for (auto _ : state) {
+    pid_t tid = GetThreadId();
+    size_t fds_before = CountOpenFds();
+    std::vector<std::unique_ptr<RepeatingAlarm>> alarms;
+    for (int i = 0; i < num_alarms; i++) {
+      alarms.push_back(std::make_unique<RepeatingAlarm>(handler_.get()));
+      auto task = Bind(
+          &BM_ReactableAlarmCoalescing_many_repeating_alarms_Benchmark::OnFire, bluetooth::common::Unretained(this));
+      auto period = std::chrono::milliseconds(200 + i % 50);
+      if (slack.count() == 0) {
+        alarms.back()->Schedule(task, period);
+      } else {
+        alarms.back()->ScheduleWithSlack(task, period, slack);
+      }
+    }
+    size_t fds = CountOpenFds() - fds_before;
+
+    uint64_t wakeups_before = CountWakeups(tid);
+    uint64_t fires_before = fire_count_;
+    std::this_thread::sleep_for(kMeasurementTime);
+    uint64_t wakeups = CountWakeups(tid) - wakeups_before;
+    uint64_t fires = fire_count_ - fires_before;
+    alarms.clear();
+
+    state.counters["fds"] = fds;
+    state.counters["wakeups_per_sec"] = static_cast<double>(wakeups) / kMeasurementTime.count();
+    state.counters["fires_per_sec"] = static_cast<double>(fires) / kMeasurementTime.count();
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_ReactableAlarmCoalescing, many_repeating_alarms)
+    ->Args({500, 0})
+    ->Args({500, 50})
+    ->Args({5000, 50})
+    ->Iterations(1)
+    ->UseRealTime();
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -24,12 +25,15 @@
 #include "common/bind.h"
 #include "common/callback.h"
 #include "common/contextual_callback.h"
+#include "common/inline_closure.h"
 #include "os/thread.h"
 #include "os/utils.h"
 
 namespace bluetooth {
 namespace os {
 
+class ThreadPool;
+
 // A message-queue style handler for reactor-based thread to handle incoming events from different threads. When it's
 // constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister itself
 // from the thread.
@@ -38,6 +42,10 @@ class Handler : public common::IPostableContext {
   // Create and register a handler on given thread
   explicit Handler(Thread* thread);
 
+  // Create a handler whose tasks run on any worker of the given pool, one at a time and in the order they were posted.
+  // Such a handler can't be used with Alarm, RepeatingAlarm or Queue.
+  explicit Handler(ThreadPool* pool);
+
   // Unregister this handler from the thread and release resource. Unhandled events will be discarded and not executed.
   virtual ~Handler();
 
@@ -46,6 +54,10 @@ class Handler : public common::IPostableContext {
   // Enqueue a closure to the queue of this handler
   virtual void Post(common::OnceClosure closure) override;
 
+  // Enqueue a closure to the queue of this handler. Small lambdas are stored in the queue itself, which saves the
+  // BindState allocation of a OnceClosure on per-packet paths.
+  void Post(common::InlineClosure closure);
+
   // Remove all pending events from the queue of this handler
   void Clear();
 
@@ -96,16 +108,30 @@ class Handler : public common::IPostableContext {
 
   friend class RepeatingAlarm;
 
+  friend class ThreadPool;
+
  private:
   inline bool was_cleared() const {
     return tasks_ == nullptr;
   };
-  std::queue<common::OnceClosure>* tasks_;
+  std::queue<common::InlineClosure>* tasks_;
   Thread* thread_;
   int fd_;
   Reactor::Reactable* reactable_;
   mutable std::mutex mutex_;
   void handle_next_event();
+
+  ThreadPool* pool_ = nullptr;
+  // Set from the post that finds the handler idle until its tasks are drained: while the handler is queued on or
+  // running on a pool worker, or while its eventfd is signaled or its tasks are running on the thread. Posts made
+  // meanwhile don't signal it again.
+  bool scheduled_ = false;
+  // Set while handle_next_event() runs tasks on the thread
+  bool running_ = false;
+  std::condition_variable idle_;
+  // Run up to |max_tasks| tasks on the calling pool worker. Return true if tasks are left and the handler must be
+  // scheduled again.
+  bool run_pooled_tasks(size_t max_tasks);
 };
 
 }  // namespace os
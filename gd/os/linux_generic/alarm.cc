@@ -23,6 +23,7 @@
 
 #include "common/bind.h"
 #include "os/linux_generic/linux.h"
+#include "os/linux_generic/slack_timer_queue.h"
 #include "os/log.h"
 #include "os/utils.h"
 
@@ -37,14 +38,15 @@ namespace os {
 using common::Closure;
 using common::OnceClosure;
 
-Alarm::Alarm(Handler* handler) : handler_(handler), fd_(TIMERFD_CREATE(ALARM_CLOCK, 0)) {
-  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
-
-  token_ = handler_->thread_->GetReactor()->Register(
-      fd_, common::Bind(&Alarm::on_fire, common::Unretained(this)), Closure());
+Alarm::Alarm(Handler* handler) : handler_(handler) {
+  ASSERT_LOG(handler_->thread_ != nullptr, "Alarm needs a handler created on a Thread");
 }
 
 Alarm::~Alarm() {
+  Cancel();
+  if (token_ == nullptr) {
+    return;
+  }
   handler_->thread_->GetReactor()->Unregister(token_);
 
   int close_status;
@@ -53,20 +55,42 @@ Alarm::~Alarm() {
 }
 
 void Alarm::Schedule(OnceClosure task, std::chrono::milliseconds delay) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t slack_id = take_slack_id_locked();
+  if (token_ == nullptr) {
+    fd_ = TIMERFD_CREATE(ALARM_CLOCK, 0);
+    ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
+    token_ = handler_->thread_->GetReactor()->Register(
+        fd_, common::Bind(&Alarm::on_fire, common::Unretained(this)), Closure());
+  }
   long delay_ms = delay.count();
   itimerspec timer_itimerspec{{/* interval for periodic timer */}, {delay_ms / 1000, delay_ms % 1000 * 1000000}};
   int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
   ASSERT(result == 0);
 
   task_ = std::move(task);
+  lock.unlock();
+  cancel_slack(slack_id);
+}
+
+void Alarm::ScheduleWithSlack(OnceClosure task, std::chrono::milliseconds delay, std::chrono::milliseconds slack) {
+  auto* queue = handler_->thread_->get_slack_timer_queue();
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t previous_slack_id = take_slack_id_locked();
+  disarm_locked();
+  task_ = std::move(task);
+  slack_id_ = queue->Schedule(
+      common::BindOnce(&Alarm::on_slack_fire, common::Unretained(this), generation_), delay, slack);
+  lock.unlock();
+  cancel_slack(previous_slack_id);
 }
 
 void Alarm::Cancel() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  itimerspec disarm_itimerspec{/* disarm timer */};
-  int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
-  ASSERT(result == 0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t slack_id = take_slack_id_locked();
+  disarm_locked();
+  lock.unlock();
+  cancel_slack(slack_id);
 }
 
 void Alarm::on_fire() {
@@ -80,5 +104,40 @@ void Alarm::on_fire() {
   ASSERT(times_invoked == static_cast<uint64_t>(1));
 }
 
+void Alarm::on_slack_fire(uint64_t generation) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The alarm was cancelled or rescheduled after this expiry was taken off the queue
+  if (generation != generation_ || task_.is_null()) {
+    return;
+  }
+  auto task = std::move(task_);
+  lock.unlock();
+  std::move(task).Run();
+}
+
+void Alarm::disarm_locked() {
+  if (token_ == nullptr) {
+    return;
+  }
+  itimerspec disarm_itimerspec{/* disarm timer */};
+  int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
+  ASSERT(result == 0);
+}
+
+// Invalidate any pending slack expiry and return its id, which must be cancelled once mutex_ is released since
+// cancelling may wait for on_slack_fire() to finish on the reactor thread
+uint64_t Alarm::take_slack_id_locked() {
+  generation_++;
+  uint64_t slack_id = slack_id_;
+  slack_id_ = 0;
+  return slack_id;
+}
+
+void Alarm::cancel_slack(uint64_t slack_id) {
+  if (slack_id != 0) {
+    handler_->thread_->get_slack_timer_queue()->Cancel(slack_id);
+  }
+}
+
 }  // namespace os
 }  // namespace bluetooth
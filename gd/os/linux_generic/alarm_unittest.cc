@@ -93,6 +93,54 @@ TEST_F(AlarmTest, delete_while_alarm_armed) {
   std::this_thread::sleep_for(std::chrono::milliseconds(10));
 }
 
+TEST_F(AlarmTest, schedule_with_slack) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  auto before = std::chrono::steady_clock::now();
+  int delay_ms = 10;
+  int slack_ms = 20;
+  alarm_->ScheduleWithSlack(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)),
+      std::chrono::milliseconds(delay_ms),
+      std::chrono::milliseconds(slack_ms));
+  future.get();
+  auto after = std::chrono::steady_clock::now();
+  auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(after - before);
+  ASSERT_GE(duration_ms.count(), delay_ms);
+  ASSERT_LE(duration_ms.count(), delay_ms + slack_ms + 3);
+}
+
+TEST_F(AlarmTest, cancel_alarm_with_slack) {
+  alarm_->ScheduleWithSlack(
+      BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }),
+      std::chrono::milliseconds(3),
+      std::chrono::milliseconds(1));
+  alarm_->Cancel();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+TEST_F(AlarmTest, schedule_replaces_schedule_with_slack) {
+  alarm_->ScheduleWithSlack(
+      BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(1));
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  alarm_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)), std::chrono::milliseconds(10));
+  future.get();
+}
+
+TEST_F(AlarmTest, delete_while_alarm_with_slack_armed) {
+  alarm_->ScheduleWithSlack(
+      BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(1));
+  delete alarm_;
+  alarm_ = nullptr;
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
 }  // namespace
 }  // namespace os
 }  // namespace bluetooth
@@ -28,6 +28,7 @@
 #include <string>
 
 #include "os/log.h"
+#include "os/utils.h"
 
 namespace {
 
@@ -133,7 +134,7 @@ bool WriteToFile(const std::string& path, const std::string& data) {
     return false;
   }
 
-  if (std::fprintf(fp, "%s", data.c_str()) < 0) {
+  if (std::fwrite(data.data(), 1, data.size(), fp) != data.size()) {
     LOG_ERROR("unable to write to file '%s', error: %s", temp_path.c_str(), strerror(errno));
     HandleError(temp_path, &dir_fd, &fp);
     return false;
@@ -187,6 +188,53 @@ bool WriteToFile(const std::string& path, const std::string& data) {
   return true;
 }
 
+bool AppendToFile(const std::string& path, const std::string& data) {
+  ASSERT(!path.empty());
+  bool created = !FileExists(path);
+  int fd;
+  RUN_NO_INTR(fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP));
+  if (fd < 0) {
+    LOG_ERROR("unable to open file '%s', error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t ret;
+    RUN_NO_INTR(ret = write(fd, data.data() + written, data.size() - written));
+    if (ret < 0) {
+      LOG_ERROR("unable to append to file '%s', error: %s", path.c_str(), strerror(errno));
+      close(fd);
+      return false;
+    }
+    written += ret;
+  }
+
+  // Sync appended data out to disk. fdatasync() is enough as the file metadata that matters, its size, is included
+  if (fdatasync(fd) != 0) {
+    LOG_WARN("unable to fdatasync file '%s', error: %s", path.c_str(), strerror(errno));
+    // Allow fdatasync to fail and continue
+  }
+
+  if (close(fd) != 0) {
+    LOG_ERROR("unable to close file '%s', error: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  if (created) {
+    // Make sure the directory entry of a new file reaches the disk as well
+    std::string temp_path_for_dir(path);
+    int dir_fd = open(dirname(temp_path_for_dir.data()), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+      if (fsync(dir_fd) != 0) {
+        LOG_WARN("unable to fsync dir of '%s', error: %s", path.c_str(), strerror(errno));
+      }
+      close(dir_fd);
+    }
+  }
+  return true;
+}
+
 bool RemoveFile(const std::string& path) {
   if (remove(path.c_str()) != 0) {
     LOG_ERROR("unable to remove file '%s', error: %s", path.c_str(), strerror(errno));
@@ -25,35 +25,53 @@
 #include "common/callback.h"
 #include "os/log.h"
 #include "os/reactor.h"
+#include "os/thread_pool.h"
 #include "os/utils.h"
 
-#ifndef EFD_SEMAPHORE
-#define EFD_SEMAPHORE 1
-#endif
-
 namespace bluetooth {
 namespace os {
+using common::InlineClosure;
 using common::OnceClosure;
 
+namespace {
+
+// Tasks run by one wakeup of a thread handler before it yields to the other reactables of the thread
+constexpr size_t kMaxTasksPerWakeup = 64;
+
+}  // namespace
+
 Handler::Handler(Thread* thread)
-    : tasks_(new std::queue<OnceClosure>()), thread_(thread), fd_(eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK)) {
+    : tasks_(new std::queue<InlineClosure>()), thread_(thread), fd_(eventfd(0, EFD_NONBLOCK)) {
   ASSERT(fd_ != -1);
   reactable_ = thread_->GetReactor()->Register(
       fd_, common::Bind(&Handler::handle_next_event, common::Unretained(this)), common::Closure());
 }
 
+Handler::Handler(ThreadPool* pool)
+    : tasks_(new std::queue<InlineClosure>()), thread_(nullptr), fd_(-1), reactable_(nullptr), pool_(pool) {}
+
 Handler::~Handler() {
   {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
     ASSERT_LOG(was_cleared(), "Handlers must be cleared before they are destroyed");
+    // A worker may still hold this handler until it notices that it has been cleared
+    idle_.wait(lock, [this]() { return !scheduled_; });
   }
 
+  if (pool_ != nullptr) {
+    return;
+  }
   int close_status;
   RUN_NO_INTR(close_status = close(fd_));
   ASSERT(close_status != -1);
 }
 
 void Handler::Post(OnceClosure closure) {
+  Post(InlineClosure([closure = std::move(closure)]() mutable { std::move(closure).Run(); }));
+}
+
+void Handler::Post(InlineClosure closure) {
+  bool schedule = false;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     if (was_cleared()) {
@@ -61,6 +79,16 @@ void Handler::Post(OnceClosure closure) {
       return;
     }
     tasks_->emplace(std::move(closure));
+    // One wakeup drains all the tasks queued, only the post that finds the handler idle needs to signal it
+    schedule = !scheduled_;
+    scheduled_ = true;
+  }
+  if (!schedule) {
+    return;
+  }
+  if (pool_ != nullptr) {
+    pool_->schedule(this);
+    return;
   }
   uint64_t val = 1;
   auto write_result = eventfd_write(fd_, val);
@@ -68,14 +96,22 @@ void Handler::Post(OnceClosure closure) {
 }
 
 void Handler::Clear() {
-  std::queue<OnceClosure>* tmp = nullptr;
+  std::queue<InlineClosure>* tmp = nullptr;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     ASSERT_LOG(!was_cleared(), "Handlers must only be cleared once");
     std::swap(tasks_, tmp);
+    if (pool_ == nullptr && !running_) {
+      // The reactable is unregistered below, no wakeup will come for the tasks dropped. When tasks are running, the
+      // thread resets it once it notices that the handler has been cleared.
+      scheduled_ = false;
+    }
   }
   delete tmp;
 
+  if (pool_ != nullptr) {
+    return;
+  }
   uint64_t val;
   while (eventfd_read(fd_, &val) == 0) {
   }
@@ -85,12 +121,17 @@ void Handler::Clear() {
 }
 
 void Handler::WaitUntilStopped(std::chrono::milliseconds timeout) {
+  if (pool_ != nullptr) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ASSERT(was_cleared());
+    ASSERT(idle_.wait_for(lock, timeout, [this]() { return !scheduled_; }));
+    return;
+  }
   ASSERT(reactable_ == nullptr);
   ASSERT(thread_->GetReactor()->WaitForUnregisteredReactable(timeout));
 }
 
 void Handler::handle_next_event() {
-  common::OnceClosure closure;
   {
     std::lock_guard<std::mutex> lock(mutex_);
     uint64_t val = 0;
@@ -100,11 +141,52 @@ void Handler::handle_next_event() {
       return;
     }
     ASSERT_LOG(read_result != -1, "eventfd read error %d %s", errno, strerror(errno));
+    running_ = true;
+  }
+  for (size_t i = 0;; i++) {
+    InlineClosure closure;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (was_cleared() || tasks_->empty()) {
+        running_ = false;
+        scheduled_ = false;
+        idle_.notify_all();
+        return;
+      }
+      if (i == kMaxTasksPerWakeup) {
+        // Tasks are left, wake up again once the other reactables of the thread had their turn
+        running_ = false;
+        uint64_t val = 1;
+        auto write_result = eventfd_write(fd_, val);
+        ASSERT(write_result != -1);
+        return;
+      }
+      closure = std::move(tasks_->front());
+      tasks_->pop();
+    }
+    std::move(closure).Run();
+  }
+}
 
-    closure = std::move(tasks_->front());
-    tasks_->pop();
+bool Handler::run_pooled_tasks(size_t max_tasks) {
+  for (size_t i = 0; i <= max_tasks; i++) {
+    InlineClosure closure;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (was_cleared() || tasks_->empty()) {
+        scheduled_ = false;
+        idle_.notify_all();
+        return false;
+      }
+      if (i == max_tasks) {
+        return true;
+      }
+      closure = std::move(tasks_->front());
+      tasks_->pop();
+    }
+    std::move(closure).Run();
   }
-  std::move(closure).Run();
+  return true;
 }
 
 }  // namespace os
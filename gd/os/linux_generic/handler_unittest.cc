@@ -20,6 +20,7 @@
 
 #include <future>
 #include <thread>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -110,6 +111,83 @@ TEST_F(HandlerTest, callback_with_promise) {
   handler_->Clear();
 }
 
+TEST_F(HandlerTest, post_inline_closure_in_order_with_once_closure) {
+  std::vector<int> order;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler_->Post([&order]() { order.push_back(1); });
+  handler_->Post(common::BindOnce([](std::vector<int>* order) { order->push_back(2); }, common::Unretained(&order)));
+  auto value = std::make_unique<int>(3);
+  handler_->Post([&order, value = std::move(value)]() { order.push_back(*value); });
+  handler_->Post([&promise]() { promise.set_value(); });
+  future.wait();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, post_burst_from_other_threads) {
+  constexpr int kPostingThreads = 4;
+  constexpr int kPostsPerThread = 1000;
+  std::vector<std::vector<int>> order(kPostingThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kPostingThreads; t++) {
+    threads.emplace_back([this, t, &order]() {
+      for (int i = 0; i < kPostsPerThread; i++) {
+        handler_->Post([&order, t, i]() { order[t].push_back(i); });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler_->Post([&promise]() { promise.set_value(); });
+  future.wait();
+  // Coalesced wakeups run every task, in the order each thread posted them
+  for (int t = 0; t < kPostingThreads; t++) {
+    ASSERT_EQ(order[t].size(), static_cast<size_t>(kPostsPerThread));
+    for (int i = 0; i < kPostsPerThread; i++) {
+      ASSERT_EQ(order[t][i], i);
+    }
+  }
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, post_from_task_runs_after_it) {
+  std::vector<int> order;
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler_->Post([this, &order, &promise]() {
+    order.push_back(1);
+    handler_->Post([&order, &promise]() {
+      order.push_back(3);
+      promise.set_value();
+    });
+    order.push_back(2);
+  });
+  future.wait();
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+  handler_->Clear();
+}
+
+TEST_F(HandlerTest, clear_with_pending_tasks) {
+  std::promise<void> started;
+  std::promise<void> can_finish;
+  auto can_finish_future = can_finish.get_future();
+  handler_->Post([&started, &can_finish_future]() {
+    started.set_value();
+    can_finish_future.wait();
+  });
+  started.get_future().wait();
+  for (int i = 0; i < 10; i++) {
+    handler_->Post([]() { FAIL() << "Cleared task ran"; });
+  }
+  handler_->Clear();
+  can_finish.set_value();
+  handler_->WaitUntilStopped(std::chrono::milliseconds(1000));
+}
+
 // For Death tests, all the threading needs to be done in the ASSERT_DEATH call
 class HandlerDeathTest : public ::testing::Test {
  protected:
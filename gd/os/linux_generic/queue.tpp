@@ -15,7 +15,7 @@
  */
 
 template <typename T>
-Queue<T>::Queue(size_t capacity) : enqueue_(capacity), dequeue_(0){};
+Queue<T>::Queue(size_t capacity) : capacity_(capacity), enqueue_(capacity), dequeue_(0){};
 
 template <typename T>
 Queue<T>::~Queue() {
@@ -28,6 +28,7 @@ void Queue<T>::RegisterEnqueue(Handler* handler, EnqueueCallback callback) {
   std::lock_guard<std::mutex> lock(mutex_);
   ASSERT(enqueue_.handler_ == nullptr);
   ASSERT(enqueue_.reactable_ == nullptr);
+  ASSERT_LOG(handler->thread_ != nullptr, "Queue needs a handler created on a Thread");
   enqueue_.handler_ = handler;
   enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(
       enqueue_.reactive_semaphore_.GetFd(),
@@ -55,16 +56,48 @@ void Queue<T>::UnregisterEnqueue() {
   }
 }
 
+template <typename T>
+size_t Queue<T>::TryEnqueue(std::queue<std::unique_ptr<T>>* items) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(enqueue_.reactable_ == nullptr);
+  size_t count = std::min(items->size(), capacity_ - queue_.size());
+  for (size_t i = 0; i < count; i++) {
+    ASSERT(items->front() != nullptr);
+    enqueue_.reactive_semaphore_.Decrease();
+    queue_.push(std::move(items->front()));
+    items->pop();
+  }
+  if (count > 0) {
+    dequeue_.reactive_semaphore_.Increase(count);
+  }
+  return count;
+}
+
 template <typename T>
 void Queue<T>::RegisterDequeue(Handler* handler, DequeueCallback callback) {
   std::lock_guard<std::mutex> lock(mutex_);
   ASSERT(dequeue_.handler_ == nullptr);
   ASSERT(dequeue_.reactable_ == nullptr);
+  ASSERT_LOG(handler->thread_ != nullptr, "Queue needs a handler created on a Thread");
   dequeue_.handler_ = handler;
   dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(
       dequeue_.reactive_semaphore_.GetFd(), callback, base::Closure());
 }
 
+template <typename T>
+void Queue<T>::RegisterBatchDequeue(Handler* handler, size_t max_batch, BatchDequeueCallback callback) {
+  ASSERT(max_batch > 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ASSERT(dequeue_.handler_ == nullptr);
+  ASSERT(dequeue_.reactable_ == nullptr);
+  ASSERT_LOG(handler->thread_ != nullptr, "Queue needs a handler created on a Thread");
+  dequeue_.handler_ = handler;
+  dequeue_.reactable_ = dequeue_.handler_->thread_->GetReactor()->Register(
+      dequeue_.reactive_semaphore_.GetFd(),
+      base::Bind(&Queue<T>::BatchDequeueCallbackInternal, base::Unretained(this), max_batch, std::move(callback)),
+      base::Closure());
+}
+
 template <typename T>
 void Queue<T>::UnregisterDequeue() {
   Reactor* reactor = nullptr;
@@ -112,3 +145,23 @@ void Queue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
   queue_.push(std::move(data));
   dequeue_.reactive_semaphore_.Increase();
 }
+
+template <typename T>
+void Queue<T>::BatchDequeueCallbackInternal(size_t max_batch, BatchDequeueCallback callback) {
+  std::vector<std::unique_ptr<T>> batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min(max_batch, queue_.size());
+    if (count == 0) {
+      return;
+    }
+    batch.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      dequeue_.reactive_semaphore_.Decrease();
+      batch.push_back(std::move(queue_.front()));
+      queue_.pop();
+    }
+    enqueue_.reactive_semaphore_.Increase(count);
+  }
+  callback.Run(std::move(batch));
+}
@@ -21,6 +21,7 @@
 #include <atomic>
 #include <future>
 #include <unordered_map>
+#include <vector>
 
 #include "common/bind.h"
 #include "gtest/gtest.h"
@@ -800,6 +801,159 @@ TEST_F(QueueTest, unregister_dequeue_and_wait) {
   delete indicator;
 }
 
+std::unique_ptr<int> enqueue_until(Queue<int>* queue, int* next, int last, std::promise<void>* promise) {
+  int value = (*next)++;
+  if (value == last) {
+    queue->UnregisterEnqueue();
+    promise->set_value();
+  }
+  return std::make_unique<int>(value);
+}
+
+void collect_batch(
+    std::vector<size_t>* batch_sizes,
+    std::vector<int>* values,
+    size_t expected,
+    std::promise<void>* promise,
+    std::vector<std::unique_ptr<int>> batch) {
+  batch_sizes->push_back(batch.size());
+  for (auto& data : batch) {
+    values->push_back(*data);
+  }
+  if (values->size() == expected) {
+    promise->set_value();
+  }
+}
+
+TEST_F(QueueTest, batch_dequeue_with_full_queue) {
+  Queue<int> queue(kQueueSize);
+  int next = 0;
+  std::promise<void> enqueue_promise;
+  auto enqueue_future = enqueue_promise.get_future();
+  queue.RegisterEnqueue(
+      enqueue_handler_,
+      common::Bind(
+          &enqueue_until,
+          common::Unretained(&queue),
+          common::Unretained(&next),
+          kQueueSize - 1,
+          common::Unretained(&enqueue_promise)));
+  enqueue_future.wait();
+
+  std::vector<size_t> batch_sizes;
+  std::vector<int> values;
+  std::promise<void> dequeue_promise;
+  auto dequeue_future = dequeue_promise.get_future();
+  queue.RegisterBatchDequeue(
+      dequeue_handler_,
+      4,
+      common::Bind(
+          &collect_batch,
+          common::Unretained(&batch_sizes),
+          common::Unretained(&values),
+          kQueueSize,
+          common::Unretained(&dequeue_promise)));
+  dequeue_future.wait();
+  queue.UnregisterDequeue();
+
+  EXPECT_EQ(batch_sizes, std::vector<size_t>({4, 4, 2}));
+  for (int i = 0; i < kQueueSize; i++) {
+    EXPECT_EQ(values[i], i);
+  }
+}
+
+TEST_F(QueueTest, batch_dequeue_frees_enqueue_slots) {
+  Queue<int> queue(kQueueSizeOne);
+  int next = 0;
+  std::promise<void> enqueue_promise;
+  auto enqueue_future = enqueue_promise.get_future();
+  std::vector<size_t> batch_sizes;
+  std::vector<int> values;
+  std::promise<void> dequeue_promise;
+  auto dequeue_future = dequeue_promise.get_future();
+  queue.RegisterBatchDequeue(
+      dequeue_handler_,
+      kQueueSize,
+      common::Bind(
+          &collect_batch,
+          common::Unretained(&batch_sizes),
+          common::Unretained(&values),
+          kDoubleOfQueueSize,
+          common::Unretained(&dequeue_promise)));
+  queue.RegisterEnqueue(
+      enqueue_handler_,
+      common::Bind(
+          &enqueue_until,
+          common::Unretained(&queue),
+          common::Unretained(&next),
+          kDoubleOfQueueSize - 1,
+          common::Unretained(&enqueue_promise)));
+  enqueue_future.wait();
+  dequeue_future.wait();
+  queue.UnregisterDequeue();
+
+  ASSERT_EQ(values.size(), static_cast<size_t>(kDoubleOfQueueSize));
+  for (int i = 0; i < kDoubleOfQueueSize; i++) {
+    EXPECT_EQ(values[i], i);
+  }
+  for (size_t size : batch_sizes) {
+    EXPECT_EQ(size, static_cast<size_t>(kQueueSizeOne));
+  }
+}
+
+TEST_F(QueueTest, try_enqueue_until_full) {
+  Queue<int> queue(kQueueSize);
+  std::queue<std::unique_ptr<int>> items;
+  for (int i = 0; i < kDoubleOfQueueSize; i++) {
+    items.push(std::make_unique<int>(i));
+  }
+
+  EXPECT_EQ(queue.TryEnqueue(&items), static_cast<size_t>(kQueueSize));
+  EXPECT_EQ(items.size(), static_cast<size_t>(kQueueSize));
+  EXPECT_EQ(queue.TryEnqueue(&items), 0u);
+
+  for (int i = 0; i < kHalfOfQueueSize; i++) {
+    EXPECT_EQ(*queue.TryDequeue(), i);
+  }
+  EXPECT_EQ(queue.TryEnqueue(&items), static_cast<size_t>(kHalfOfQueueSize));
+  EXPECT_EQ(*items.front(), kQueueSize + kHalfOfQueueSize);
+
+  for (int i = kHalfOfQueueSize; i < kQueueSize + kHalfOfQueueSize; i++) {
+    EXPECT_EQ(*queue.TryDequeue(), i);
+  }
+  EXPECT_EQ(queue.TryDequeue(), nullptr);
+}
+
+TEST_F(QueueTest, try_enqueue_wakes_dequeue) {
+  Queue<int> queue(kQueueSize);
+  std::vector<size_t> batch_sizes;
+  std::vector<int> values;
+  std::promise<void> dequeue_promise;
+  auto dequeue_future = dequeue_promise.get_future();
+  queue.RegisterBatchDequeue(
+      dequeue_handler_,
+      kQueueSize,
+      common::Bind(
+          &collect_batch,
+          common::Unretained(&batch_sizes),
+          common::Unretained(&values),
+          kHalfOfQueueSize,
+          common::Unretained(&dequeue_promise)));
+
+  std::queue<std::unique_ptr<int>> items;
+  for (int i = 0; i < kHalfOfQueueSize; i++) {
+    items.push(std::make_unique<int>(i));
+  }
+  EXPECT_EQ(queue.TryEnqueue(&items), static_cast<size_t>(kHalfOfQueueSize));
+  dequeue_future.wait();
+  queue.UnregisterDequeue();
+
+  ASSERT_EQ(values.size(), static_cast<size_t>(kHalfOfQueueSize));
+  for (int i = 0; i < kHalfOfQueueSize; i++) {
+    EXPECT_EQ(values[i], i);
+  }
+}
+
 // Create all threads for death tests in the function that dies
 class QueueDeathTest : public ::testing::Test {
  public:
@@ -29,8 +29,8 @@ class ReactiveSemaphore {
   ~ReactiveSemaphore();
   // Decrements the value of |fd_|, this will cause a crash if |fd_| unreadable.
   void Decrease();
-  // Increase the value of |fd_|, this will cause a crash if |fd_| unwritable.
-  void Increase();
+  // Increase the value of |fd_| by |count|, this will cause a crash if |fd_| unwritable.
+  void Increase(unsigned int count = 1);
   int GetFd();
 
   DISALLOW_COPY_AND_ASSIGN(ReactiveSemaphore);
@@ -34,6 +34,8 @@ namespace {
 constexpr int kEpollMaxEvents = 64;
 constexpr uint64_t kStopReactor = 1 << 0;
 constexpr uint64_t kWaitForIdle = 1 << 1;
+// Shortest busy poll window, the window does not shrink further while events keep coming
+constexpr int64_t kMinBusyPollWindowUs = 10;
 
 }  // namespace
 
@@ -58,7 +60,7 @@ class Reactor::Reactable {
   std::unique_ptr<std::promise<void>> finished_promise_;
 };
 
-Reactor::Reactor() : epoll_fd_(0), control_fd_(0), is_running_(false) {
+Reactor::Reactor() : epoll_fd_(0), control_fd_(0), is_running_(false), busy_poll_max_window_us_(0) {
   RUN_NO_INTR(epoll_fd_ = epoll_create1(EPOLL_CLOEXEC));
   ASSERT_LOG(epoll_fd_ != -1, "could not create epoll fd: %s", strerror(errno));
 
@@ -89,15 +91,36 @@ void Reactor::Run() {
 
   int timeout_ms = -1;
   bool waiting_for_idle = false;
+  bool had_events = false;
+  int64_t busy_poll_window_us = 0;
   for (;;) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       invalidation_list_.clear();
     }
     epoll_event events[kEpollMaxEvents];
-    int count;
-    RUN_NO_INTR(count = epoll_wait(epoll_fd_, events, kEpollMaxEvents, timeout_ms));
-    ASSERT(count != -1);
+    int count = 0;
+    int64_t busy_poll_max_window_us = busy_poll_max_window_us_;
+    if (had_events && timeout_ms == -1 && busy_poll_max_window_us > 0) {
+      if (busy_poll_window_us == 0 || busy_poll_window_us > busy_poll_max_window_us) {
+        busy_poll_window_us = busy_poll_max_window_us;
+      }
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(busy_poll_window_us);
+      do {
+        RUN_NO_INTR(count = epoll_wait(epoll_fd_, events, kEpollMaxEvents, 0));
+        ASSERT(count != -1);
+      } while (count == 0 && std::chrono::steady_clock::now() < deadline);
+      if (count > 0) {
+        busy_poll_window_us = std::min(busy_poll_window_us * 2, busy_poll_max_window_us);
+      } else {
+        busy_poll_window_us = std::max(busy_poll_window_us / 2, kMinBusyPollWindowUs);
+      }
+    }
+    if (count == 0) {
+      RUN_NO_INTR(count = epoll_wait(epoll_fd_, events, kEpollMaxEvents, timeout_ms));
+      ASSERT(count != -1);
+    }
+    had_events = count > 0;
     if (waiting_for_idle && count == 0) {
       timeout_ms = -1;
       waiting_for_idle = false;
@@ -243,6 +266,10 @@ bool Reactor::WaitForIdle(std::chrono::milliseconds timeout) {
   return idle_status == std::future_status::ready;
 }
 
+void Reactor::SetBusyPollWindow(std::chrono::microseconds max_window) {
+  busy_poll_max_window_us_ = std::max<int64_t>(max_window.count(), 0);
+}
+
 void Reactor::ModifyRegistration(Reactor::Reactable* reactable, Closure on_read_ready, Closure on_write_ready) {
   ASSERT(reactable != nullptr);
 
@@ -432,6 +432,43 @@ TEST_F(ReactorTest, modify_registration) {
   reactor_->Unregister(reactable);
 }
 
+TEST_F(ReactorTest, busy_poll_handles_events) {
+  constexpr int kEvents = 100;
+  reactor_->SetBusyPollWindow(std::chrono::microseconds(200));
+  int fd = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK);
+  ASSERT_NE(fd, -1);
+  int handled = 0;
+  std::promise<void> all_handled;
+  auto future = all_handled.get_future();
+  auto* reactable = reactor_->Register(
+      fd,
+      common::Bind(
+          [](int fd, int* handled, std::promise<void>* all_handled) {
+            uint64_t value = 0;
+            ASSERT_EQ(eventfd_read(fd, &value), 0);
+            if (++*handled == kEvents) {
+              all_handled->set_value();
+            }
+          },
+          fd,
+          common::Unretained(&handled),
+          common::Unretained(&all_handled)),
+      common::Closure());
+  auto reactor_thread = std::thread(&Reactor::Run, reactor_);
+  for (int i = 0; i < kEvents; i++) {
+    ASSERT_EQ(eventfd_write(fd, 1), 0);
+    if (i % 10 == 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+  ASSERT_EQ(future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+
+  reactor_->Stop();
+  reactor_thread.join();
+  reactor_->Unregister(reactable);
+  close(fd);
+}
+
 }  // namespace
 }  // namespace os
 }  // namespace bluetooth
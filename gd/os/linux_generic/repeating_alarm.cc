@@ -23,6 +23,7 @@
 
 #include "common/bind.h"
 #include "os/linux_generic/linux.h"
+#include "os/linux_generic/slack_timer_queue.h"
 #include "os/log.h"
 #include "os/utils.h"
 
@@ -36,14 +37,15 @@ namespace bluetooth {
 namespace os {
 using common::Closure;
 
-RepeatingAlarm::RepeatingAlarm(Handler* handler) : handler_(handler), fd_(TIMERFD_CREATE(ALARM_CLOCK, 0)) {
-  ASSERT(fd_ != -1);
-
-  token_ = handler_->thread_->GetReactor()->Register(
-      fd_, common::Bind(&RepeatingAlarm::on_fire, common::Unretained(this)), common::Closure());
+RepeatingAlarm::RepeatingAlarm(Handler* handler) : handler_(handler) {
+  ASSERT_LOG(handler_->thread_ != nullptr, "RepeatingAlarm needs a handler created on a Thread");
 }
 
 RepeatingAlarm::~RepeatingAlarm() {
+  Cancel();
+  if (token_ == nullptr) {
+    return;
+  }
   handler_->thread_->GetReactor()->Unregister(token_);
 
   int close_status;
@@ -52,7 +54,14 @@ RepeatingAlarm::~RepeatingAlarm() {
 }
 
 void RepeatingAlarm::Schedule(Closure task, std::chrono::milliseconds period) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t slack_id = take_slack_id_locked();
+  if (token_ == nullptr) {
+    fd_ = TIMERFD_CREATE(ALARM_CLOCK, 0);
+    ASSERT(fd_ != -1);
+    token_ = handler_->thread_->GetReactor()->Register(
+        fd_, common::Bind(&RepeatingAlarm::on_fire, common::Unretained(this)), common::Closure());
+  }
   long period_ms = period.count();
   itimerspec timer_itimerspec{{period_ms / 1000, period_ms % 1000 * 1000000},
                               {period_ms / 1000, period_ms % 1000 * 1000000}};
@@ -60,13 +69,31 @@ void RepeatingAlarm::Schedule(Closure task, std::chrono::milliseconds period) {
   ASSERT(result == 0);
 
   task_ = std::move(task);
+  lock.unlock();
+  cancel_slack(slack_id);
+}
+
+void RepeatingAlarm::ScheduleWithSlack(
+    Closure task, std::chrono::milliseconds period, std::chrono::milliseconds slack) {
+  auto* queue = handler_->thread_->get_slack_timer_queue();
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t previous_slack_id = take_slack_id_locked();
+  disarm_locked();
+  task_ = std::move(task);
+  period_ = period;
+  slack_ = slack;
+  slack_id_ = queue->Schedule(
+      common::BindOnce(&RepeatingAlarm::on_slack_fire, common::Unretained(this), generation_), period_, slack_);
+  lock.unlock();
+  cancel_slack(previous_slack_id);
 }
 
 void RepeatingAlarm::Cancel() {
-  std::lock_guard<std::mutex> lock(mutex_);
-  itimerspec disarm_itimerspec{/* disarm timer */};
-  int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
-  ASSERT(result == 0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t slack_id = take_slack_id_locked();
+  disarm_locked();
+  lock.unlock();
+  cancel_slack(slack_id);
 }
 
 void RepeatingAlarm::on_fire() {
@@ -79,5 +106,46 @@ void RepeatingAlarm::on_fire() {
   ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)));
 }
 
+void RepeatingAlarm::on_slack_fire(uint64_t generation) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (generation != generation_ || task_.is_null()) {
+    return;
+  }
+  auto task = task_;
+  lock.unlock();
+  task.Run();
+
+  // Only rearm if the task didn't cancel or reschedule the alarm
+  lock.lock();
+  if (generation == generation_) {
+    slack_id_ = handler_->thread_->get_slack_timer_queue()->Schedule(
+        common::BindOnce(&RepeatingAlarm::on_slack_fire, common::Unretained(this), generation_), period_, slack_);
+  }
+}
+
+void RepeatingAlarm::disarm_locked() {
+  if (token_ == nullptr) {
+    return;
+  }
+  itimerspec disarm_itimerspec{/* disarm timer */};
+  int result = TIMERFD_SETTIME(fd_, 0, &disarm_itimerspec, nullptr);
+  ASSERT(result == 0);
+}
+
+// Invalidate any pending slack expiry and return its id, which must be cancelled once mutex_ is released since
+// cancelling may wait for on_slack_fire() to finish on the reactor thread
+uint64_t RepeatingAlarm::take_slack_id_locked() {
+  generation_++;
+  uint64_t slack_id = slack_id_;
+  slack_id_ = 0;
+  return slack_id;
+}
+
+void RepeatingAlarm::cancel_slack(uint64_t slack_id) {
+  if (slack_id != 0) {
+    handler_->thread_->get_slack_timer_queue()->Cancel(slack_id);
+  }
+}
+
 }  // namespace os
 }  // namespace bluetooth
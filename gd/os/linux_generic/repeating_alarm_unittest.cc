@@ -143,6 +143,47 @@ TEST_F(RepeatingAlarmTest, verify_large) {
   VerifyMultipleDelayedTasks(100, 3, 10);
 }
 
+TEST_F(RepeatingAlarmTest, schedule_with_slack) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  int counter = 0;
+  alarm_->ScheduleWithSlack(
+      common::Bind(
+          [](int* counter, std::promise<void>* promise) {
+            if (++*counter == 5) {
+              promise->set_value();
+            }
+          },
+          common::Unretained(&counter),
+          common::Unretained(&promise)),
+      std::chrono::milliseconds(10),
+      std::chrono::milliseconds(5));
+  future.get();
+  alarm_->Cancel();
+}
+
+TEST_F(RepeatingAlarmTest, cancel_alarm_with_slack) {
+  alarm_->ScheduleWithSlack(should_not_happen_, std::chrono::milliseconds(10), std::chrono::milliseconds(5));
+  alarm_->Cancel();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+}
+
+TEST_F(RepeatingAlarmTest, cancel_alarm_with_slack_from_callback) {
+  int counter = 0;
+  alarm_->ScheduleWithSlack(
+      common::Bind(
+          [](RepeatingAlarm* alarm, int* counter) {
+            ++*counter;
+            alarm->Cancel();
+          },
+          common::Unretained(alarm_),
+          common::Unretained(&counter)),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_EQ(counter, 1);
+}
+
 }  // namespace
 }  // namespace os
 }  // namespace bluetooth
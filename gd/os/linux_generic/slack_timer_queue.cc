@@ -0,0 +1,168 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/linux_generic/slack_timer_queue.h"
+
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include "common/bind.h"
+#include "os/linux_generic/linux.h"
+#include "os/log.h"
+
+#ifdef OS_ANDROID
+#define ALARM_CLOCK CLOCK_BOOTTIME_ALARM
+#else
+#define ALARM_CLOCK CLOCK_BOOTTIME
+#endif
+
+namespace bluetooth {
+namespace os {
+using common::Closure;
+using common::OnceClosure;
+
+SlackTimerQueue::SlackTimerQueue(Reactor* reactor) : reactor_(reactor), fd_(TIMERFD_CREATE(ALARM_CLOCK, TFD_NONBLOCK)) {
+  ASSERT_LOG(fd_ != -1, "cannot create timerfd: %s", strerror(errno));
+
+  token_ = reactor_->Register(fd_, common::Bind(&SlackTimerQueue::on_fire, common::Unretained(this)), Closure());
+}
+
+SlackTimerQueue::~SlackTimerQueue() {
+  reactor_->Unregister(token_);
+  // Tasks may still be running on the reactor thread and touch this queue once they return
+  reactor_->WaitForUnregisteredReactable(std::chrono::milliseconds(1000));
+
+  int close_status;
+  RUN_NO_INTR(close_status = TIMERFD_CLOSE(fd_));
+  ASSERT(close_status != -1);
+}
+
+SlackTimerQueue::Id SlackTimerQueue::Schedule(
+    OnceClosure task, std::chrono::milliseconds delay, std::chrono::milliseconds slack) {
+  ASSERT(slack.count() >= 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  TimePoint earliest = now() + delay;
+  Id id = next_id_++;
+  Entry& entry = entries_[id];
+  entry.task = std::move(task);
+  entry.earliest = by_earliest_.emplace(earliest, id);
+  entry.latest = by_latest_.emplace(earliest + slack, id);
+  rearm_locked();
+  return id;
+}
+
+void SlackTimerQueue::Cancel(Id id) {
+  if (id == kInvalidId) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (id == executing_id_ && std::this_thread::get_id() != executing_thread_) {
+    executing_finished_.wait(lock, [this, id]() { return executing_id_ != id; });
+    return;
+  }
+  auto entry = entries_.find(id);
+  if (entry == entries_.end()) {
+    return;
+  }
+  erase_locked(entry);
+  rearm_locked();
+}
+
+size_t SlackTimerQueue::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+uint64_t SlackTimerQueue::GetWakeupCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return wakeup_count_;
+}
+
+SlackTimerQueue::TimePoint SlackTimerQueue::now() {
+  timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return std::chrono::duration_cast<TimePoint>(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+}
+
+void SlackTimerQueue::erase_locked(std::map<Id, Entry>::iterator entry) {
+  by_earliest_.erase(entry->second.earliest);
+  by_latest_.erase(entry->second.latest);
+  entries_.erase(entry);
+}
+
+void SlackTimerQueue::rearm_locked() {
+  TimePoint target = by_latest_.empty() ? TimePoint(0) : by_latest_.begin()->first;
+  if (target == armed_at_) {
+    return;
+  }
+  armed_at_ = target;
+
+  itimerspec timer_itimerspec{/* disarm timer */};
+  if (target.count() != 0) {
+    // A zero it_value disarms the timer, so a deadline already in the past fires after the shortest possible delay
+    long delay_ms = std::max<long>((target - now()).count(), 1);
+    timer_itimerspec.it_value = {delay_ms / 1000, delay_ms % 1000 * 1000000};
+  }
+  int result = TIMERFD_SETTIME(fd_, 0, &timer_itimerspec, nullptr);
+  ASSERT(result == 0);
+}
+
+void SlackTimerQueue::on_fire() {
+  // Rearming between the expiry and this read resets the expiration count, so an empty read is expected
+  uint64_t times_invoked;
+  ssize_t bytes_read;
+  RUN_NO_INTR(bytes_read = read(fd_, &times_invoked, sizeof(uint64_t)));
+  ASSERT(bytes_read == static_cast<ssize_t>(sizeof(uint64_t)) || (bytes_read == -1 && errno == EAGAIN));
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  wakeup_count_++;
+  armed_at_ = TimePoint(0);
+
+  // Everything that may run by now goes in this wakeup, not only the task whose latest deadline armed the timer
+  std::vector<Id> due;
+  TimePoint current = now();
+  for (auto it = by_earliest_.begin(); it != by_earliest_.end() && it->first <= current; it++) {
+    due.push_back(it->second);
+  }
+
+  for (Id id : due) {
+    // A task run earlier in this wakeup may have cancelled this one
+    auto entry = entries_.find(id);
+    if (entry == entries_.end()) {
+      continue;
+    }
+    auto task = std::move(entry->second.task);
+    erase_locked(entry);
+    executing_id_ = id;
+    executing_thread_ = std::this_thread::get_id();
+    lock.unlock();
+    std::move(task).Run();
+    lock.lock();
+    executing_id_ = kInvalidId;
+    executing_finished_.notify_all();
+  }
+
+  rearm_locked();
+}
+
+}  // namespace os
+}  // namespace bluetooth
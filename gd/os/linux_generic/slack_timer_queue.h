@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "common/callback.h"
+#include "os/reactor.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace os {
+
+// Timers that tolerate running late, backed by a single timerfd per reactor thread.
+// Each task may run anywhere between its delay and its delay plus slack. The timerfd is armed at the earliest latest
+// deadline, and every task whose delay has elapsed by then runs in the same wakeup, so tasks with overlapping windows
+// share one wakeup instead of waking the thread one by one.
+class SlackTimerQueue {
+ public:
+  using Id = uint64_t;
+  static constexpr Id kInvalidId = 0;
+
+  // Create the timerfd and register it on the given reactor
+  explicit SlackTimerQueue(Reactor* reactor);
+
+  // Unregister from the reactor. Pending tasks are discarded and not executed.
+  ~SlackTimerQueue();
+
+  DISALLOW_COPY_AND_ASSIGN(SlackTimerQueue);
+
+  // Run the task on the reactor thread no earlier than delay and no later than delay + slack from now. Returns an id
+  // used to cancel the task.
+  Id Schedule(common::OnceClosure task, std::chrono::milliseconds delay, std::chrono::milliseconds slack);
+
+  // Cancel a scheduled task. No-op if it already ran or was cancelled. If the task is running on the reactor thread
+  // and this is invoked from another thread, block until it finishes.
+  void Cancel(Id id);
+
+  // Return the number of tasks waiting to run
+  size_t GetPendingCount() const;
+
+  // Return the number of times the timerfd has woken up the reactor thread
+  uint64_t GetWakeupCount() const;
+
+ private:
+  using TimePoint = std::chrono::milliseconds;
+  struct Entry {
+    common::OnceClosure task;
+    std::multimap<TimePoint, Id>::iterator earliest;
+    std::multimap<TimePoint, Id>::iterator latest;
+  };
+
+  static TimePoint now();
+  void erase_locked(std::map<Id, Entry>::iterator entry);
+  void rearm_locked();
+  void on_fire();
+
+  mutable std::mutex mutex_;
+  std::condition_variable executing_finished_;
+  Reactor* reactor_;
+  int fd_;
+  Reactor::Reactable* token_;
+  Id next_id_ = 1;
+  std::map<Id, Entry> entries_;
+  std::multimap<TimePoint, Id> by_earliest_;
+  std::multimap<TimePoint, Id> by_latest_;
+  TimePoint armed_at_{0};
+  Id executing_id_ = kInvalidId;
+  std::thread::id executing_thread_;
+  uint64_t wakeup_count_ = 0;
+};
+
+}  // namespace os
+}  // namespace bluetooth
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/linux_generic/slack_timer_queue.h"
+
+#include <future>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+#include "os/thread.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+using common::BindOnce;
+
+class SlackTimerQueueTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    thread_ = new Thread("test_thread", Thread::Priority::NORMAL);
+    queue_ = new SlackTimerQueue(thread_->GetReactor());
+  }
+
+  void TearDown() override {
+    delete queue_;
+    delete thread_;
+  }
+
+  SlackTimerQueue* queue_;
+
+ private:
+  Thread* thread_;
+};
+
+TEST_F(SlackTimerQueueTest, cancel_invalid_id) {
+  queue_->Cancel(SlackTimerQueue::kInvalidId);
+  queue_->Cancel(42);
+}
+
+TEST_F(SlackTimerQueueTest, schedule_fires_within_window) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  auto before = std::chrono::steady_clock::now();
+  int delay_ms = 10;
+  int slack_ms = 20;
+  queue_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)),
+      std::chrono::milliseconds(delay_ms),
+      std::chrono::milliseconds(slack_ms));
+  future.get();
+  auto duration_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - before).count();
+  ASSERT_GE(duration_ms, delay_ms);
+  ASSERT_LE(duration_ms, delay_ms + slack_ms + 5);
+  ASSERT_EQ(queue_->GetPendingCount(), 0u);
+}
+
+TEST_F(SlackTimerQueueTest, overlapping_windows_share_wakeup) {
+  std::promise<void> first;
+  std::promise<void> second;
+  auto first_future = first.get_future();
+  auto second_future = second.get_future();
+  queue_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&first)),
+      std::chrono::milliseconds(10),
+      std::chrono::milliseconds(100));
+  queue_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&second)),
+      std::chrono::milliseconds(40),
+      std::chrono::milliseconds(10));
+  first_future.get();
+  second_future.get();
+  ASSERT_EQ(queue_->GetWakeupCount(), 1u);
+}
+
+TEST_F(SlackTimerQueueTest, disjoint_windows_wake_separately) {
+  std::promise<void> first;
+  std::promise<void> second;
+  auto first_future = first.get_future();
+  auto second_future = second.get_future();
+  queue_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&first)),
+      std::chrono::milliseconds(5),
+      std::chrono::milliseconds(0));
+  queue_->Schedule(
+      BindOnce(&std::promise<void>::set_value, common::Unretained(&second)),
+      std::chrono::milliseconds(50),
+      std::chrono::milliseconds(0));
+  first_future.get();
+  second_future.get();
+  ASSERT_EQ(queue_->GetWakeupCount(), 2u);
+}
+
+TEST_F(SlackTimerQueueTest, cancel) {
+  auto id = queue_->Schedule(
+      BindOnce([]() { ASSERT_TRUE(false) << "Should not happen"; }),
+      std::chrono::milliseconds(3),
+      std::chrono::milliseconds(0));
+  ASSERT_EQ(queue_->GetPendingCount(), 1u);
+  queue_->Cancel(id);
+  ASSERT_EQ(queue_->GetPendingCount(), 0u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(queue_->GetWakeupCount(), 0u);
+}
+
+TEST_F(SlackTimerQueueTest, cancel_waits_for_running_task) {
+  std::promise<void> started;
+  auto started_future = started.get_future();
+  bool finished = false;
+  auto id = queue_->Schedule(
+      BindOnce(
+          [](std::promise<void>* started, bool* finished) {
+            started->set_value();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            *finished = true;
+          },
+          common::Unretained(&started),
+          common::Unretained(&finished)),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(0));
+  started_future.get();
+  queue_->Cancel(id);
+  ASSERT_TRUE(finished);
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
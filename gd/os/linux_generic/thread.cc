@@ -23,6 +23,7 @@
 #include <cerrno>
 #include <cstring>
 
+#include "os/linux_generic/slack_timer_queue.h"
 #include "os/log.h"
 
 namespace bluetooth {
@@ -72,6 +73,12 @@ Reactor* Thread::GetReactor() const {
   return &reactor_;
 }
 
+SlackTimerQueue* Thread::get_slack_timer_queue() {
+  std::call_once(
+      slack_timer_queue_once_, [this]() { slack_timer_queue_ = std::make_unique<SlackTimerQueue>(&reactor_); });
+  return slack_timer_queue_.get();
+}
+
 std::string Thread::GetThreadName() const {
   return name_;
 }
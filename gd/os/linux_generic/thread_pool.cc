@@ -0,0 +1,173 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/thread_pool.h"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "os/handler.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace os {
+
+namespace {
+constexpr int kRealTimeFifoSchedulingPriority = 1;
+// Number of tasks a worker runs from one handler before giving the other runnable handlers a turn
+constexpr size_t kTasksPerTurn = 16;
+}  // namespace
+
+ThreadPool::ThreadPool(const std::string& name, size_t num_threads, Thread::Priority priority) : name_(name) {
+  ASSERT(num_threads > 0);
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_[i]->thread_ = std::thread(&ThreadPool::run, this, i, priority);
+    workers_[i]->id_ = workers_[i]->thread_.get_id();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    workers_ready_ = true;
+  }
+  workers_ready_cv_.notify_all();
+}
+
+ThreadPool::~ThreadPool() {
+  Stop();
+}
+
+bool ThreadPool::Stop() {
+  std::lock_guard<std::mutex> stop_lock(stop_mutex_);
+  ASSERT(!IsSameThread());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      return false;
+    }
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread_.join();
+  }
+  return true;
+}
+
+bool ThreadPool::IsSameThread() const {
+  return find_current_worker() != -1;
+}
+
+size_t ThreadPool::GetNumThreads() const {
+  return workers_.size();
+}
+
+std::string ThreadPool::ToString() const {
+  return "ThreadPool " + name_ + " (" + std::to_string(workers_.size()) + " threads)";
+}
+
+void ThreadPool::schedule(Handler* handler) {
+  // Keep a handler rescheduled from a worker on that worker, its data is still in the cache there
+  int current = find_current_worker();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t index = current != -1 ? static_cast<size_t>(current) : next_worker_++ % workers_.size();
+    {
+      std::lock_guard<std::mutex> worker_lock(workers_[index]->mutex_);
+      workers_[index]->runnable_.push_back(handler);
+    }
+    runnable_count_++;
+  }
+  work_available_.notify_one();
+}
+
+Handler* ThreadPool::take_runnable(size_t worker_index) {
+  // Take the oldest handler from our own queue, otherwise steal the newest one from another worker
+  for (size_t i = 0; i < workers_.size(); i++) {
+    Worker& worker = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex_);
+    if (worker.runnable_.empty()) {
+      continue;
+    }
+    Handler* handler;
+    if (i == 0) {
+      handler = worker.runnable_.front();
+      worker.runnable_.pop_front();
+    } else {
+      handler = worker.runnable_.back();
+      worker.runnable_.pop_back();
+    }
+    return handler;
+  }
+  return nullptr;
+}
+
+void ThreadPool::run(size_t worker_index, Thread::Priority priority) {
+  // POSIX thread names are limited to 15 characters, keep the worker index visible
+  std::string index = std::to_string(worker_index);
+  pthread_setname_np(pthread_self(), (name_.substr(0, 15 - index.size()) + index).c_str());
+
+  if (priority == Thread::Priority::REAL_TIME) {
+    struct sched_param rt_params = {.sched_priority = kRealTimeFifoSchedulingPriority};
+    auto linux_tid = static_cast<pid_t>(syscall(SYS_gettid));
+    int rc;
+    RUN_NO_INTR(rc = sched_setscheduler(linux_tid, SCHED_FIFO, &rt_params));
+    if (rc != 0) {
+      LOG_ERROR("unable to set SCHED_FIFO priority: %s", strerror(errno));
+    }
+  }
+
+  {
+    // A worker started early would otherwise see the threads of the later ones still being assigned
+    std::unique_lock<std::mutex> lock(mutex_);
+    workers_ready_cv_.wait(lock, [this]() { return workers_ready_; });
+  }
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock, [this]() { return stopping_ || runnable_count_ > 0; });
+      if (runnable_count_ == 0) {
+        return;
+      }
+      // Every counted handler is already on a queue, so reserving one here guarantees there is one to take
+      runnable_count_--;
+    }
+    Handler* handler = take_runnable(worker_index);
+    ASSERT(handler != nullptr);
+    if (handler->run_pooled_tasks(kTasksPerTurn)) {
+      schedule(handler);
+    }
+  }
+}
+
+int ThreadPool::find_current_worker() const {
+  auto current = std::this_thread::get_id();
+  for (size_t i = 0; i < workers_.size(); i++) {
+    if (workers_[i]->id_ == current) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+}  // namespace os
+}  // namespace bluetooth
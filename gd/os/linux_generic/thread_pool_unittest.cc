@@ -0,0 +1,198 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "os/thread_pool.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "common/bind.h"
+#include "gtest/gtest.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace os {
+namespace {
+
+constexpr size_t kNumThreads = 4;
+
+class ThreadPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    pool_ = new ThreadPool("test_pool", kNumThreads, Thread::Priority::NORMAL);
+  }
+  void TearDown() override {
+    delete pool_;
+  }
+
+  ThreadPool* pool_;
+};
+
+TEST_F(ThreadPoolTest, num_threads) {
+  EXPECT_EQ(pool_->GetNumThreads(), kNumThreads);
+  EXPECT_FALSE(pool_->IsSameThread());
+}
+
+TEST_F(ThreadPoolTest, post_task_invoked_on_worker) {
+  Handler handler(pool_);
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  handler.Post(common::BindOnce(
+      [](ThreadPool* pool, std::promise<bool> promise) { promise.set_value(pool->IsSameThread()); },
+      common::Unretained(pool_),
+      std::move(promise)));
+  EXPECT_TRUE(future.get());
+  handler.Clear();
+}
+
+TEST_F(ThreadPoolTest, tasks_of_one_handler_run_in_order_and_never_concurrently) {
+  Handler handler(pool_);
+  constexpr int kNumTasks = 10000;
+  std::vector<int> order;
+  std::atomic<int> running(0);
+  bool overlapped = false;
+  for (int i = 0; i < kNumTasks; i++) {
+    handler.Post(common::BindOnce(
+        [](std::vector<int>* order, std::atomic<int>* running, bool* overlapped, int i) {
+          if (running->fetch_add(1) != 0) {
+            *overlapped = true;
+          }
+          order->push_back(i);
+          running->fetch_sub(1);
+        },
+        common::Unretained(&order),
+        common::Unretained(&running),
+        common::Unretained(&overlapped),
+        i));
+  }
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler.Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+  future.wait();
+  handler.Clear();
+  handler.WaitUntilStopped(std::chrono::milliseconds(1000));
+
+  EXPECT_FALSE(overlapped);
+  ASSERT_EQ(order.size(), static_cast<size_t>(kNumTasks));
+  for (int i = 0; i < kNumTasks; i++) {
+    ASSERT_EQ(order[i], i);
+  }
+}
+
+TEST_F(ThreadPoolTest, handlers_run_in_parallel) {
+  // Every handler blocks until all of them are running, which only completes if they run on different workers
+  Handler first(pool_);
+  Handler second(pool_);
+  std::promise<void> first_started;
+  std::promise<void> second_started;
+  auto first_started_future = first_started.get_future();
+  auto second_started_future = second_started.get_future();
+  std::promise<void> first_done;
+  std::promise<void> second_done;
+  auto first_done_future = first_done.get_future();
+  auto second_done_future = second_done.get_future();
+  first.Post(common::BindOnce(
+      [](std::promise<void> started, std::future<void>* other_started, std::promise<void> done) {
+        started.set_value();
+        other_started->wait();
+        done.set_value();
+      },
+      std::move(first_started),
+      common::Unretained(&second_started_future),
+      std::move(first_done)));
+  second.Post(common::BindOnce(
+      [](std::promise<void> started, std::future<void>* other_started, std::promise<void> done) {
+        started.set_value();
+        other_started->wait();
+        done.set_value();
+      },
+      std::move(second_started),
+      common::Unretained(&first_started_future),
+      std::move(second_done)));
+  EXPECT_EQ(first_done_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  EXPECT_EQ(second_done_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  first.Clear();
+  second.Clear();
+}
+
+TEST_F(ThreadPoolTest, idle_worker_steals_from_busy_worker) {
+  Handler busy(pool_);
+  Handler other(pool_);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> busy_started;
+  auto busy_started_future = busy_started.get_future();
+
+  // Post |other| from inside the blocked task so that it lands on the queue of the worker that is blocked
+  std::promise<void> other_ran;
+  auto other_ran_future = other_ran.get_future();
+  busy.Post(common::BindOnce(
+      [](Handler* other, std::promise<void>* other_ran, std::promise<void> started, std::shared_future<void> released) {
+        other->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(other_ran)));
+        started.set_value();
+        released.wait();
+      },
+      common::Unretained(&other),
+      common::Unretained(&other_ran),
+      std::move(busy_started),
+      released));
+  busy_started_future.wait();
+  EXPECT_EQ(other_ran_future.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+  release.set_value();
+  busy.Clear();
+  other.Clear();
+  busy.WaitUntilStopped(std::chrono::milliseconds(1000));
+}
+
+TEST_F(ThreadPoolTest, clear_discards_pending_tasks) {
+  Handler handler(pool_);
+  std::promise<void> started;
+  auto started_future = started.get_future();
+  std::promise<void> can_continue;
+  std::shared_future<void> can_continue_future = can_continue.get_future().share();
+  int val = 0;
+  handler.Post(common::BindOnce(
+      [](std::promise<void> started, std::shared_future<void> can_continue) {
+        started.set_value();
+        can_continue.wait();
+      },
+      std::move(started),
+      can_continue_future));
+  handler.Post(common::BindOnce([](int* val) { *val = 1; }, common::Unretained(&val)));
+  started_future.wait();
+  handler.Clear();
+  can_continue.set_value();
+  handler.WaitUntilStopped(std::chrono::milliseconds(1000));
+  EXPECT_EQ(val, 0);
+}
+
+TEST_F(ThreadPoolTest, stop_drains_runnable_handlers) {
+  Handler handler(pool_);
+  std::atomic<int> count(0);
+  for (int i = 0; i < 100; i++) {
+    handler.Post(common::BindOnce([](std::atomic<int>* count) { (*count)++; }, common::Unretained(&count)));
+  }
+  EXPECT_TRUE(pool_->Stop());
+  EXPECT_FALSE(pool_->Stop());
+  EXPECT_EQ(count, 100);
+  handler.Clear();
+}
+
+}  // namespace
+}  // namespace os
+}  // namespace bluetooth
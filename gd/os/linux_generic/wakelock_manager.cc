@@ -47,6 +47,7 @@ const std::string WakelockManager::kBtWakelockId = "bluetooth_gd_timer";
 struct WakelockManager::Stats {
   bool is_acquired = false;
   size_t acquired_count = 0;
+  size_t coalesced_count = 0;
   size_t released_count = 0;
   size_t acquired_errors = 0;
   size_t released_errors = 0;
@@ -63,6 +64,7 @@ struct WakelockManager::Stats {
   void Reset() {
     is_acquired = false;
     acquired_count = 0;
+    coalesced_count = 0;
     released_count = 0;
     acquired_errors = 0;
     released_errors = 0;
@@ -131,7 +133,7 @@ struct WakelockManager::Stats {
   }
 
   flatbuffers::Offset<WakelockManagerData> GetDumpsysData(
-      flatbuffers::FlatBufferBuilder* fb_builder, bool is_native) const {
+      flatbuffers::FlatBufferBuilder* fb_builder, bool is_native, std::chrono::milliseconds hold_over) const {
     const uint64_t just_now_ms = now_ms();
     // Compute the last acquired interval if the wakelock is still acquired
     uint64_t delta_ms = 0;
@@ -156,6 +158,12 @@ struct WakelockManager::Stats {
       avg_interval_ms = total_interval_ms / acquired_count;
     }
 
+    const uint64_t run_time_ms = just_now_ms - last_reset_timestamp_ms;
+    uint64_t acquired_per_minute = 0;
+    if (run_time_ms > 0) {
+      acquired_per_minute = acquired_count * 60000 / run_time_ms;
+    }
+
     WakelockManagerDataBuilder builder(*fb_builder);
     builder.add_title(fb_builder->CreateString("Bluetooth Wakelock Statistics"));
     builder.add_is_acquired(is_acquired);
@@ -173,7 +181,10 @@ struct WakelockManager::Stats {
     builder.add_min_interval_millis(min_interval_ms);
     builder.add_avg_interval_millis(avg_interval_ms);
     builder.add_total_interval_millis(total_interval_ms);
-    builder.add_total_time_since_reset_millis(just_now_ms - last_reset_timestamp_ms);
+    builder.add_total_time_since_reset_millis(run_time_ms);
+    builder.add_coalesced_count(coalesced_count);
+    builder.add_acquired_per_minute(acquired_per_minute);
+    builder.add_hold_over_millis(hold_over.count());
     return builder.Finish();
   }
 };
@@ -201,6 +212,57 @@ bool WakelockManager::Acquire() {
     initialized_ = true;
   }
 
+  // Holders coming while the wakelock is held, or during its hold-over, share it
+  if (is_system_lock_held_) {
+    holder_count_++;
+    release_deadline_.reset();
+    pstats_->coalesced_count++;
+    return true;
+  }
+
+  if (!AcquireSystemLock()) {
+    return false;
+  }
+  holder_count_++;
+  return true;
+}
+
+bool WakelockManager::Release() {
+  std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
+  if (!initialized_) {
+    if (is_native_) {
+      WakelockNative::Get().Initialize();
+    }
+    initialized_ = true;
+  }
+
+  if (holder_count_ == 0) {
+    LOG_WARN("unbalanced release, the wake lock has no holder");
+    return true;
+  }
+  if (--holder_count_ > 0) {
+    return true;
+  }
+
+  if (hold_over_.count() == 0) {
+    return ReleaseSystemLock();
+  }
+
+  release_deadline_ = std::chrono::steady_clock::now() + hold_over_;
+  if (!release_thread_.joinable()) {
+    release_thread_stop_ = false;
+    release_thread_ = std::thread(&WakelockManager::ReleaseThreadMain, this);
+  }
+  release_cv_.notify_one();
+  return true;
+}
+
+void WakelockManager::SetHoldOver(std::chrono::milliseconds hold_over) {
+  std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
+  hold_over_ = hold_over;
+}
+
+bool WakelockManager::AcquireSystemLock() {
   StatusCode status;
   if (is_native_) {
     status = WakelockNative::Get().Acquire(kBtWakelockId);
@@ -213,19 +275,19 @@ bool WakelockManager::Acquire() {
 
   if (status != StatusCode::SUCCESS) {
     LOG_ERROR("unable to acquire wake lock, error code: %u", status);
+    return false;
   }
 
-  return status == StatusCode ::SUCCESS;
+  is_system_lock_held_ = true;
+  return true;
 }
 
-bool WakelockManager::Release() {
-  std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
-  if (!initialized_) {
-    if (is_native_) {
-      WakelockNative::Get().Initialize();
-    }
-    initialized_ = true;
+bool WakelockManager::ReleaseSystemLock() {
+  release_deadline_.reset();
+  if (!is_system_lock_held_) {
+    return true;
   }
+  is_system_lock_held_ = false;
 
   StatusCode status;
   if (is_native_) {
@@ -244,16 +306,45 @@ bool WakelockManager::Release() {
   return status == StatusCode ::SUCCESS;
 }
 
+// Releases the system wakelock once the hold-over after the last holder has passed without a new holder
+void WakelockManager::ReleaseThreadMain() {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  while (!release_thread_stop_) {
+    if (!release_deadline_) {
+      release_cv_.wait(lock);
+    } else if (std::chrono::steady_clock::now() >= *release_deadline_) {
+      ReleaseSystemLock();
+    } else {
+      release_cv_.wait_until(lock, *release_deadline_);
+    }
+  }
+}
+
+void WakelockManager::StopReleaseThread() {
+  {
+    std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
+    release_thread_stop_ = true;
+  }
+  release_cv_.notify_one();
+  if (release_thread_.joinable()) {
+    release_thread_.join();
+  }
+}
+
 void WakelockManager::CleanUp() {
+  StopReleaseThread();
   std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
   if (!initialized_) {
     LOG_ERROR("Already uninitialized");
     return;
   }
-  if (pstats_->is_acquired) {
-    LOG_ERROR("Releasing wake lock as part of cleanup");
-    Release();
+  if (is_system_lock_held_) {
+    if (!release_deadline_) {
+      LOG_ERROR("Releasing wake lock as part of cleanup");
+    }
+    ReleaseSystemLock();
   }
+  holder_count_ = 0;
   if (is_native_) {
     WakelockNative::Get().CleanUp();
   }
@@ -263,12 +354,14 @@ void WakelockManager::CleanUp() {
 
 flatbuffers::Offset<WakelockManagerData> WakelockManager::GetDumpsysData(flatbuffers::FlatBufferBuilder* fb_builder) {
   std::lock_guard<std::recursive_mutex> lock_guard(mutex_);
-  return pstats_->GetDumpsysData(fb_builder, is_native_);
+  return pstats_->GetDumpsysData(fb_builder, is_native_, hold_over_);
 }
 
 WakelockManager::WakelockManager() : pstats_(std::make_unique<Stats>()) {}
 
-WakelockManager::~WakelockManager() = default;
+WakelockManager::~WakelockManager() {
+  StopReleaseThread();
+}
 
 }  // namespace os
 }  // namespace bluetooth
\ No newline at end of file
@@ -16,6 +16,7 @@
  *
  ******************************************************************************/
 #include <optional>
+#include <thread>
 #include <unordered_map>
 
 #include <gmock/gmock.h>
@@ -107,15 +108,20 @@ TEST_F(WakelockManagerTest, test_set_os_callouts_repeated_acquire) {
   ASSERT_EQ(os_callouts.acquired_lock_counts.size(), 1);
   ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(1)));
 
+  // Repeated acquire calls share the held wakelock
   WakelockManager::Get().Acquire();
   SyncHandler();
   ASSERT_EQ(os_callouts.acquired_lock_counts.size(), 1);
-  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(2)));
+  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(1)));
 
   WakelockManager::Get().Release();
   SyncHandler();
   ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(1)));
 
+  WakelockManager::Get().Release();
+  SyncHandler();
+  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(0)));
+
   WakelockManager::Get().CleanUp();
   SyncHandler();
 }
@@ -138,10 +144,10 @@ TEST_F(WakelockManagerTest, test_set_os_callouts_repeated_release) {
   ASSERT_EQ(os_callouts.acquired_lock_counts.size(), 1);
   ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(0)));
 
-  // OS callouts allow pass through for repeated release calls
+  // Releases without holder are ignored
   WakelockManager::Get().Release();
   SyncHandler();
-  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(-1)));
+  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(0)));
 
   WakelockManager::Get().CleanUp();
   SyncHandler();
@@ -189,4 +195,37 @@ TEST_F(WakelockManagerTest, test_with_os_callouts_in_a_loop_and_dump) {
   }
 }
 
+TEST_F(WakelockManagerTest, test_hold_over_coalesces_acquire) {
+  TestOsCallouts os_callouts;
+  WakelockManager::Get().SetOsCallouts(&os_callouts, handler_);
+  WakelockManager::Get().SetHoldOver(std::chrono::milliseconds(100));
+
+  for (size_t i = 0; i < 100; i++) {
+    WakelockManager::Get().Acquire();
+    WakelockManager::Get().Release();
+  }
+  SyncHandler();
+  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(1)));
+
+  {
+    flatbuffers::FlatBufferBuilder builder(1024);
+    auto offset = WakelockManager::Get().GetDumpsysData(&builder);
+    FinishWakelockManagerDataBuffer(builder, offset);
+    auto data = GetWakelockManagerData(builder.GetBufferPointer());
+
+    ASSERT_EQ(data->acquired_count(), 1);
+    ASSERT_EQ(data->coalesced_count(), 99);
+    ASSERT_EQ(data->hold_over_millis(), 100);
+  }
+
+  // Released once the hold-over has passed without holder
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  SyncHandler();
+  ASSERT_THAT(os_callouts.GetNetAcquiredCount(WakelockManager::kBtWakelockId), Optional(Eq(0)));
+
+  WakelockManager::Get().SetHoldOver(std::chrono::milliseconds(0));
+  WakelockManager::Get().CleanUp();
+  SyncHandler();
+}
+
 }  // namespace testing
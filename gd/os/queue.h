@@ -18,9 +18,11 @@
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -41,6 +43,12 @@ class IQueueEnqueue {
   virtual ~IQueueEnqueue() = default;
   virtual void RegisterEnqueue(Handler* handler, EnqueueCallback callback) = 0;
   virtual void UnregisterEnqueue() = 0;
+  // Moves items from the front of |items| for as long as there is room, without waiting on an enqueue callback, and
+  // returns the number moved. Must not be called while an enqueue callback is registered. The default implementation
+  // moves nothing, so that callers fall back to RegisterEnqueue().
+  virtual size_t TryEnqueue(std::queue<std::unique_ptr<T>>* items) {
+    return 0;
+  }
 };
 
 // See documentation for |Queue|
@@ -48,10 +56,32 @@ template <typename T>
 class IQueueDequeue {
  public:
   using DequeueCallback = common::Callback<void()>;
+  using BatchDequeueCallback = common::Callback<void(std::vector<std::unique_ptr<T>>)>;
   virtual ~IQueueDequeue() = default;
   virtual void RegisterDequeue(Handler* handler, DequeueCallback callback) = 0;
+  // Drains up to |max_batch| items per callback. The default implementation runs TryDequeue() from a regular dequeue
+  // callback, so it never calls back with an empty batch. Unregister with UnregisterDequeue().
+  virtual void RegisterBatchDequeue(Handler* handler, size_t max_batch, BatchDequeueCallback callback) {
+    ASSERT(max_batch > 0);
+    RegisterDequeue(
+        handler, common::Bind(&IQueueDequeue<T>::dequeue_batch, common::Unretained(this), max_batch, callback));
+  }
   virtual void UnregisterDequeue() = 0;
   virtual std::unique_ptr<T> TryDequeue() = 0;
+
+ private:
+  void dequeue_batch(size_t max_batch, BatchDequeueCallback callback) {
+    std::vector<std::unique_ptr<T>> batch;
+    for (std::unique_ptr<T> data = TryDequeue(); data != nullptr; data = TryDequeue()) {
+      batch.push_back(std::move(data));
+      if (batch.size() == max_batch) {
+        break;
+      }
+    }
+    if (!batch.empty()) {
+      callback.Run(std::move(batch));
+    }
+  }
 };
 
 template <typename T>
@@ -63,6 +93,8 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   // A function moving data form queue to dequeue end buffer, it will be continually be invoked until queue
   // is empty. TryDequeue should be use in this function to get data from queue.
   using DequeueCallback = common::Callback<void()>;
+  // A function receiving between one and |max_batch| items taken from the queue at once, in enqueue order.
+  using BatchDequeueCallback = common::Callback<void(std::vector<std::unique_ptr<T>>)>;
   // Create a queue with |capacity| is the maximum number of messages a queue can contain
   explicit Queue(size_t capacity);
   ~Queue();
@@ -71,9 +103,16 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   void RegisterEnqueue(Handler* handler, EnqueueCallback callback) override;
   // Unregister current EnqueueCallback from this queue, this will cause a crash if not registered yet.
   void UnregisterEnqueue() override;
+  // Move as many items from the front of |items| as the queue has room for at once, under a single lock acquisition,
+  // and return the number moved. This will cause a crash if an EnqueueCallback is registered.
+  size_t TryEnqueue(std::queue<std::unique_ptr<T>>* items) override;
   // Register |callback| that will be called on |handler| when the queue has at least one piece of data ready
   // for dequeue. This will cause a crash if handler or callback has already been registered before.
   void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
+  // Register |callback| that will be called on |handler| with up to |max_batch| items each time the queue has data
+  // ready for dequeue, so that one reactor wakeup and one lock acquisition cover the whole batch. Unregister with
+  // UnregisterDequeue(). This will cause a crash if handler or callback has already been registered before.
+  void RegisterBatchDequeue(Handler* handler, size_t max_batch, BatchDequeueCallback callback) override;
   // Unregister current DequeueCallback from this queue, this will cause a crash if not registered yet.
   void UnregisterDequeue() override;
 
@@ -82,8 +121,10 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
 
  private:
   void EnqueueCallbackInternal(EnqueueCallback callback);
+  void BatchDequeueCallbackInternal(size_t max_batch, BatchDequeueCallback callback);
   // An internal queue that holds at most |capacity| pieces of data
   std::queue<std::unique_ptr<T>> queue_;
+  const size_t capacity_;
   // A mutex that guards data in this queue
   std::mutex mutex_;
 
@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <future>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "os/handler.h"
@@ -37,8 +39,10 @@ class BM_QueuePerformance : public ::benchmark::Fixture {
   }
 
   void TearDown(State& st) override {
+    enqueue_handler_->Clear();
     delete enqueue_handler_;
     delete enqueue_thread_;
+    dequeue_handler_->Clear();
     delete dequeue_handler_;
     delete dequeue_thread_;
     enqueue_handler_ = nullptr;
@@ -137,6 +141,50 @@ class TestDequeueEnd {
   }
 };
 
+using TimePoint = std::chrono::steady_clock::time_point;
+
+std::unique_ptr<TimePoint> EnqueueTimestampForTest(Queue<TimePoint>* queue, int64_t* remaining) {
+  (*remaining)--;
+  if (*remaining == 0) {
+    queue->UnregisterEnqueue();
+  }
+  return std::make_unique<TimePoint>(std::chrono::steady_clock::now());
+}
+
+class TestBatchDequeueEnd {
+ public:
+  explicit TestBatchDequeueEnd(int64_t count, Queue<TimePoint>* queue, Handler* handler, std::promise<void>* promise)
+      : count_(count), handler_(handler), queue_(queue), promise_(promise) {}
+
+  void RegisterBatchDequeue(size_t max_batch) {
+    queue_->RegisterBatchDequeue(
+        handler_, max_batch, common::Bind(&TestBatchDequeueEnd::BatchDequeueCallbackForTest, common::Unretained(this)));
+  }
+
+  void BatchDequeueCallbackForTest(std::vector<std::unique_ptr<TimePoint>> batch) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& enqueued_at : batch) {
+      total_latency_ += now - *enqueued_at;
+    }
+    callbacks_++;
+
+    count_ -= batch.size();
+    if (count_ == 0) {
+      queue_->UnregisterDequeue();
+      promise_->set_value();
+    }
+  }
+
+  int64_t count_;
+  int64_t callbacks_ = 0;
+  std::chrono::nanoseconds total_latency_{0};
+
+ private:
+  Handler* handler_;
+  Queue<TimePoint>* queue_;
+  std::promise<void>* promise_;
+};
+
 BENCHMARK_DEFINE_F(BM_QueuePerformance, send_packet_vary_by_packet_num)(State& state) {
   for (auto _ : state) {
     int64_t num_data_to_send_ = state.range(0);
@@ -202,5 +250,43 @@ BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
     ->Iterations(100)
     ->UseRealTime();
 
+// Throughput and enqueue to dequeue latency between two threads when up to range(0) items are dequeued per callback
+BENCHMARK_DEFINE_F(BM_QueuePerformance, send_10000_packet_vary_by_batch_size)(State& state) {
+  constexpr int64_t kNumDataToSend = 10000;
+  constexpr size_t kCapacity = 100;
+  auto max_batch = static_cast<size_t>(state.range(0));
+  std::chrono::nanoseconds total_latency(0);
+  int64_t total_callbacks = 0;
+  for (auto _ : state) {
+    Queue<TimePoint> queue(kCapacity);
+
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    TestBatchDequeueEnd test_dequeue_end(kNumDataToSend, &queue, dequeue_handler_, &dequeue_promise);
+    test_dequeue_end.RegisterBatchDequeue(max_batch);
+
+    int64_t remaining = kNumDataToSend;
+    queue.RegisterEnqueue(
+        enqueue_handler_,
+        common::Bind(&EnqueueTimestampForTest, common::Unretained(&queue), common::Unretained(&remaining)));
+    dequeue_future.wait();
+
+    total_latency += test_dequeue_end.total_latency_;
+    total_callbacks += test_dequeue_end.callbacks_;
+  }
+
+  int64_t total_items = static_cast<int64_t>(state.iterations()) * kNumDataToSend;
+  state.SetItemsProcessed(total_items);
+  state.counters["avg_latency_us"] = static_cast<double>(total_latency.count()) / 1000 / total_items;
+  state.counters["dequeue_callbacks"] = static_cast<double>(total_callbacks) / state.iterations();
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_batch_size)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Iterations(100)
+    ->UseRealTime();
+
 }  // namespace os
 }  // namespace bluetooth
@@ -19,6 +19,7 @@
 #include <sys/epoll.h>
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <list>
@@ -71,11 +72,17 @@ class Reactor {
   // Modify the registration for a reactable with given reactable
   void ModifyRegistration(Reactable* reactable, common::Closure on_read_ready, common::Closure on_write_ready);
 
+  // Keep polling for up to |max_window| after handling events, before blocking again, so that bursts of events are
+  // picked up without a sleep and a wakeup each. The window adapts to the traffic: it doubles up to |max_window| when
+  // polling finds events, and halves when it does not. Zero, the default, disables busy polling.
+  void SetBusyPollWindow(std::chrono::microseconds max_window);
+
  private:
   mutable std::mutex mutex_;
   int epoll_fd_;
   int control_fd_;
   std::atomic<bool> is_running_;
+  std::atomic<int64_t> busy_poll_max_window_us_;
   std::list<Reactable*> invalidation_list_;
   std::shared_ptr<std::future<void>> executing_reactable_finished_;
   std::shared_ptr<std::promise<void>> idle_promise_;
@@ -29,8 +29,8 @@ namespace bluetooth {
 namespace os {
 
 // A repeating alarm for reactor-based thread, implemented by Linux timerfd.
-// When it's constructed, it will register a reactable on the specified thread; when it's destroyed, it will unregister
-// itself from the thread.
+// The timerfd is created and registered on the specified thread the first time Schedule() is invoked; when it's
+// destroyed, it will unregister itself from the thread. Alarms scheduled with slack don't use a timerfd of their own.
 class RepeatingAlarm {
  public:
   // Create and register a repeating alarm on a given handler
@@ -44,16 +44,28 @@ class RepeatingAlarm {
   // Schedule a repeating alarm with given period
   void Schedule(common::Closure task, std::chrono::milliseconds period);
 
+  // Schedule a repeating alarm which fires between period and period + slack after the previous run. Expiries of all
+  // slack alarms on the same thread are batched into one wakeup whenever their windows overlap.
+  void ScheduleWithSlack(common::Closure task, std::chrono::milliseconds period, std::chrono::milliseconds slack);
+
   // Cancel the alarm. No-op if it's not armed.
   void Cancel();
 
  private:
   common::Closure task_;
   Handler* handler_;
-  int fd_ = 0;
-  Reactor::Reactable* token_;
+  int fd_ = -1;
+  Reactor::Reactable* token_ = nullptr;
+  std::chrono::milliseconds period_{0};
+  std::chrono::milliseconds slack_{0};
+  uint64_t slack_id_ = 0;
+  uint64_t generation_ = 0;
   mutable std::mutex mutex_;
   void on_fire();
+  void on_slack_fire(uint64_t generation);
+  void disarm_locked();
+  uint64_t take_slack_id_locked();
+  void cancel_slack(uint64_t slack_id);
 };
 
 }  // namespace os
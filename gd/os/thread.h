@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -26,6 +27,8 @@
 namespace bluetooth {
 namespace os {
 
+class SlackTimerQueue;
+
 // Reactor-based looper thread implementation. The thread runs immediately after it is constructed, and stops after
 // Stop() is invoked. To assign task to this thread, user needs to register a reactable object to the underlying
 // reactor.
@@ -63,11 +66,19 @@ class Thread {
   // Return the pointer of underlying reactor. The ownership is NOT transferred.
   Reactor* GetReactor() const;
 
+  friend class Alarm;
+
+  friend class RepeatingAlarm;
+
  private:
   void run(Priority priority);
+  // Return the timer queue shared by all slack alarms on this thread, creating it on first use
+  SlackTimerQueue* get_slack_timer_queue();
   mutable std::mutex mutex_;
   const std::string name_;
   mutable Reactor reactor_;
+  std::once_flag slack_timer_queue_once_;
+  std::unique_ptr<SlackTimerQueue> slack_timer_queue_;
   std::thread running_thread_;
 };
 
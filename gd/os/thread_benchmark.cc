@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
 #include <future>
 #include <memory>
 #include <thread>
@@ -22,11 +24,13 @@
 #include "common/bind.h"
 #include "os/handler.h"
 #include "os/thread.h"
+#include "os/thread_pool.h"
 
 using ::benchmark::State;
 using ::bluetooth::common::BindOnce;
 using ::bluetooth::os::Handler;
 using ::bluetooth::os::Thread;
+using ::bluetooth::os::ThreadPool;
 
 #define NUM_MESSAGES_TO_SEND 100000
 
@@ -64,6 +68,7 @@ class BM_ReactorThread : public BM_ThreadPerformance {
     handler_ = std::make_unique<Handler>(thread_.get());
   }
   void TearDown(State& st) override {
+    handler_->Clear();
     handler_ = nullptr;
     thread_->Stop();
     thread_ = nullptr;
@@ -95,6 +100,28 @@ BENCHMARK_REGISTER_F(BM_ReactorThread, batch_enque_dequeue)
     ->Iterations(1)
     ->UseRealTime();
 
+// Same as above, posting lambdas which the handler keeps in its queue without allocating a OnceClosure
+BENCHMARK_DEFINE_F(BM_ReactorThread, batch_enque_dequeue_inline_closure)(State& state) {
+  for (auto _ : state) {
+    num_messages_to_send_ = state.range(0);
+    counter_ = 0;
+    counter_promise_ = std::promise<void>();
+    std::future<void> counter_future = counter_promise_.get_future();
+    for (int i = 0; i < num_messages_to_send_; i++) {
+      handler_->Post([this]() { callback_batch(); });
+    }
+    counter_future.wait();
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_ReactorThread, batch_enque_dequeue_inline_closure)
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Iterations(1)
+    ->UseRealTime();
+
 BENCHMARK_DEFINE_F(BM_ReactorThread, sequential_execution)(State& state) {
   for (auto _ : state) {
     num_messages_to_send_ = state.range(0);
@@ -115,3 +142,77 @@ BENCHMARK_REGISTER_F(BM_ReactorThread, sequential_execution)
     ->Arg(100000)
     ->Iterations(1)
     ->UseRealTime();
+
+// A bulk handler keeps posting tasks that take a millisecond each, while a latency sensitive handler is pinged. With a
+// single thread every ping waits behind the bulk task being run; with a pool an idle worker picks the ping up.
+class BM_MixedLoad : public BM_ThreadPerformance {
+ protected:
+  void SetUp(State& st) override {
+    BM_ThreadPerformance::SetUp(st);
+    if (st.range(0) == 0) {
+      thread_ = std::make_unique<Thread>("BM_MixedLoad thread", Thread::Priority::NORMAL);
+      bulk_handler_ = std::make_unique<Handler>(thread_.get());
+      latency_handler_ = std::make_unique<Handler>(thread_.get());
+    } else {
+      pool_ = std::make_unique<ThreadPool>("BM_MixedLoad", st.range(0), Thread::Priority::NORMAL);
+      bulk_handler_ = std::make_unique<Handler>(pool_.get());
+      latency_handler_ = std::make_unique<Handler>(pool_.get());
+    }
+    bulk_running_ = true;
+    for (int i = 0; i < kBulkTasksInFlight; i++) {
+      bulk_handler_->Post(BindOnce(&BM_MixedLoad::bulk_task, bluetooth::common::Unretained(this)));
+    }
+  }
+  void TearDown(State& st) override {
+    bulk_running_ = false;
+    bulk_handler_->Clear();
+    latency_handler_->Clear();
+    bulk_handler_->WaitUntilStopped(std::chrono::milliseconds(1000));
+    latency_handler_->WaitUntilStopped(std::chrono::milliseconds(1000));
+    bulk_handler_ = nullptr;
+    latency_handler_ = nullptr;
+    if (thread_ != nullptr) {
+      thread_->Stop();
+      thread_ = nullptr;
+    }
+    pool_ = nullptr;
+    BM_ThreadPerformance::TearDown(st);
+  }
+
+  void bulk_task() {
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+    if (bulk_running_) {
+      bulk_handler_->Post(BindOnce(&BM_MixedLoad::bulk_task, bluetooth::common::Unretained(this)));
+    }
+  }
+
+  static constexpr int kBulkTasksInFlight = 4;
+  std::unique_ptr<Thread> thread_;
+  std::unique_ptr<ThreadPool> pool_;
+  std::unique_ptr<Handler> bulk_handler_;
+  std::unique_ptr<Handler> latency_handler_;
+  std::atomic<bool> bulk_running_;
+};
+
+BENCHMARK_DEFINE_F(BM_MixedLoad, ping_latency)(State& state) {
+  int64_t total_latency_us = 0;
+  int64_t pings = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < 200; i++) {
+      counter_promise_ = std::promise<void>();
+      std::future<void> counter_future = counter_promise_.get_future();
+      auto start = std::chrono::steady_clock::now();
+      latency_handler_->Post(BindOnce(&BM_MixedLoad_ping_latency_Benchmark::callback, bluetooth::common::Unretained(this)));
+      counter_future.wait();
+      total_latency_us +=
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+      pings++;
+    }
+  }
+  state.counters["avg_latency_us"] = static_cast<double>(total_latency_us) / pings;
+};
+
+// Arg 0 runs both handlers on a single Thread, other args are the number of pool workers
+BENCHMARK_REGISTER_F(BM_MixedLoad, ping_latency)->Arg(0)->Arg(2)->Arg(4)->Iterations(1)->UseRealTime();
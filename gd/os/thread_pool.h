@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "os/thread.h"
+#include "os/utils.h"
+
+namespace bluetooth {
+namespace os {
+
+class Handler;
+
+// Work-stealing executor for Handlers which only run posted tasks. Each worker thread keeps its own queue of runnable
+// handlers and steals from the other workers when it runs out, so one busy handler doesn't hold up the others. A
+// handler runs on at most one worker at a time and its tasks run in the order they were posted.
+// Handlers created on a pool have no reactor of their own, so Alarm, RepeatingAlarm and Queue keep needing a Handler
+// created on a Thread.
+class ThreadPool {
+ public:
+  // name: prefix of the POSIX thread names
+  // num_threads: number of worker threads, at least one
+  // priority: priority for kernel scheduler, applied to every worker
+  ThreadPool(const std::string& name, size_t num_threads, Thread::Priority priority);
+
+  // Stop and destroy this pool. All handlers created on it must be destroyed first.
+  ~ThreadPool();
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+
+  // Stop all workers once the runnable handlers are drained. Must be invoked from another thread. After the pool is
+  // stopped, it cannot be started again.
+  bool Stop();
+
+  // Return true if this function is invoked from one of the worker threads
+  bool IsSameThread() const;
+
+  // Return the number of worker threads
+  size_t GetNumThreads() const;
+
+  // Return a user-friendly string representation of this pool
+  std::string ToString() const;
+
+  friend class Handler;
+
+ private:
+  struct Worker {
+    std::mutex mutex_;
+    std::deque<Handler*> runnable_;
+    std::thread thread_;
+    // Copy of the id of |thread_|, which join() resets. Set before the workers are published and never changed.
+    std::thread::id id_;
+  };
+
+  // Make |handler| runnable. Called by the handler when a task is posted to it while it's idle.
+  void schedule(Handler* handler);
+  Handler* take_runnable(size_t worker_index);
+  void run(size_t worker_index, Thread::Priority priority);
+  int find_current_worker() const;
+
+  const std::string name_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  size_t runnable_count_ = 0;   // guarded by |mutex_|
+  size_t next_worker_ = 0;      // guarded by |mutex_|
+  bool stopping_ = false;       // guarded by |mutex_|
+  bool workers_ready_ = false;  // guarded by |mutex_|, workers wait for it before looking at |workers_|
+  std::condition_variable workers_ready_cv_;
+  std::mutex stop_mutex_;
+};
+
+}  // namespace os
+}  // namespace bluetooth
@@ -18,9 +18,13 @@
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 
 #include <flatbuffers/flatbuffers.h>
 
@@ -59,15 +63,22 @@ class WakelockManager {
   void SetOsCallouts(OsCallouts* callouts, Handler* handler);
 
   // Acquire the Bluetooth wakelock.
+  // Acquisitions are reference counted, the wakelock is held until each successful Acquire() has been released.
   // Return true on success, otherwise false.
   // The function is thread safe.
   bool Acquire();
 
   // Release the Bluetooth wakelock.
+  // Releases without a matching Acquire() are ignored.
   // Return true on success, otherwise false.
   // The function is thread safe.
   bool Release();
 
+  // Keep the wakelock for |hold_over| after its last holder released it, so that holders coming in the meantime
+  // reuse it instead of acquiring it again. Zero, the default, releases the wakelock as soon as it has no holder.
+  // The function is thread safe.
+  void SetHoldOver(std::chrono::milliseconds hold_over);
+
   // Cleanup the wakelock internal runtime state.
   // This will NOT clean up the callouts
   void CleanUp();
@@ -80,12 +91,29 @@ class WakelockManager {
  private:
   WakelockManager();
 
+  // Must be called with |mutex_| held
+  bool AcquireSystemLock();
+  bool ReleaseSystemLock();
+
+  void ReleaseThreadMain();
+  // Must be called without |mutex_| held
+  void StopReleaseThread();
+
   std::recursive_mutex mutex_;
   bool initialized_ = false;
   OsCallouts* os_callouts_ = nullptr;
   Handler* os_callouts_handler_ = nullptr;
   bool is_native_ = true;
 
+  size_t holder_count_ = 0;
+  bool is_system_lock_held_ = false;
+  std::chrono::milliseconds hold_over_{0};
+  // Time the system wakelock is released at, if a release is pending
+  std::optional<std::chrono::steady_clock::time_point> release_deadline_;
+  std::condition_variable_any release_cv_;
+  std::thread release_thread_;
+  bool release_thread_stop_ = false;
+
   struct Stats;
   std::unique_ptr<Stats> pstats_;
 };
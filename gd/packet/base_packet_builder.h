@@ -38,6 +38,16 @@ class BasePacketBuilder {
   // Write to the vector with the given iterator.
   virtual void Serialize(BitInserter& it) const = 0;
 
+  // Serialize the whole packet, including nested builders, into one buffer allocated to the size of the packet up
+  // front, rather than grown as the fields are inserted.
+  std::vector<uint8_t> SerializeToBytes() const {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(size());
+    BitInserter it(bytes);
+    Serialize(it);
+    return bytes;
+  }
+
   void SetFlushable(bool is_flushable) {
     is_flushable_ = is_flushable;
   }
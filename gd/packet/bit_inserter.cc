@@ -44,5 +44,17 @@ void BitInserter::insert_byte(uint8_t byte) {
   insert_bits(byte, 8);
 }
 
+void BitInserter::insert_bytes(const uint8_t* data, size_t size) {
+  // Bytes following a partial byte have to be shifted one at a time
+  if (num_saved_bits_ != 0) {
+    for (size_t i = 0; i < size; i++) {
+      insert_byte(data[i]);
+    }
+    return;
+  }
+  on_bytes(data, size);
+  append_bytes(data, size);
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -35,6 +35,11 @@ class BitInserter : public ByteInserter {
 
   void insert_byte(uint8_t byte) override;
 
+  // Insert size whole bytes. Subclasses may reference data instead of copying it, so it must stay valid for as long
+  // as the inserted packet is used. Byte aligned runs skip insert_bits(), so subclasses overriding insert_bits() must
+  // override this too.
+  virtual void insert_bytes(const uint8_t* data, size_t size);
+
  protected:
   size_t num_saved_bits_{0};
   uint8_t saved_bits_{0};
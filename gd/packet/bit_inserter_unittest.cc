@@ -78,5 +78,34 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+TEST(BitInserterTest, observerBytesTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  size_t num_runs = 0;
+
+  it.RegisterObserver(ByteObserver(
+      [&copy](uint8_t byte) { copy.push_back(byte); },
+      [&copy, &num_runs](const uint8_t* data, size_t size) {
+        copy.insert(copy.end(), data, data + size);
+        num_runs++;
+      },
+      []() { return 0; }));
+
+  const uint8_t run[] = {0x01, 0x02, 0x03, 0x04};
+  it.insert_bytes(run, sizeof(run));
+  ASSERT_EQ(1u, num_runs);
+  // Unaligned runs are observed byte by byte
+  it.insert_bits(0b1, 4);
+  it.insert_bytes(run, sizeof(run));
+  it.insert_bits(0b1, 4);
+  ASSERT_EQ(1u, num_runs);
+
+  std::vector<uint8_t> result = {0x01, 0x02, 0x03, 0x04, 0x11, 0x20, 0x30, 0x40, 0x10};
+  ASSERT_EQ(result, bytes);
+  ASSERT_EQ(result, copy);
+  it.UnregisterObserver();
+}
+
 }  // namespace packet
 }  // namespace bluetooth
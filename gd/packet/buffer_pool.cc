@@ -0,0 +1,170 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/buffer_pool.h"
+
+#include <new>
+#include <utility>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace packet {
+
+namespace {
+
+template <size_t size>
+struct Buffer {
+  // Leave the bytes uninitialized, they are written before the buffer is used
+  Buffer() {}
+  uint8_t data[size];
+};
+
+}  // namespace
+
+// Allocates the block holding a buffer and its reference count, built by std::allocate_shared, from the free blocks
+// of a size class
+template <typename T>
+class BufferPool::BlockAllocator {
+ public:
+  using value_type = T;
+
+  BlockAllocator(BufferPool* pool, size_t class_index) : pool_(pool), class_index_(class_index) {}
+
+  template <typename U>
+  BlockAllocator(const BlockAllocator<U>& other) : pool_(other.pool_), class_index_(other.class_index_) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(pool_->TakeBlock(class_index_, n * sizeof(T)));
+  }
+
+  void deallocate(T* block, size_t n) {
+    pool_->ReturnBlock(class_index_, block, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const BlockAllocator<U>& other) const {
+    return pool_ == other.pool_ && class_index_ == other.class_index_;
+  }
+
+  template <typename U>
+  bool operator!=(const BlockAllocator<U>& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  template <typename U>
+  friend class BlockAllocator;
+
+  BufferPool* pool_;
+  size_t class_index_;
+};
+
+BufferPool::BufferPool(size_t max_cached_buffers) : max_cached_buffers_(max_cached_buffers) {
+  for (size_t i = 0; i < kNumSizeClasses; i++) {
+    size_classes_[i].stats.buffer_size = kSizeClasses[i];
+    size_classes_[i].free_blocks.reserve(max_cached_buffers_);
+  }
+}
+
+BufferPool::~BufferPool() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& size_class : size_classes_) {
+    ASSERT_LOG(size_class.stats.num_in_use == 0, "%zu buffers still in use", size_class.stats.num_in_use);
+    for (void* block : size_class.free_blocks) {
+      ::operator delete(block);
+    }
+  }
+}
+
+BufferPool& BufferPool::Get() {
+  static BufferPool* pool = new BufferPool();
+  return *pool;
+}
+
+std::shared_ptr<uint8_t> BufferPool::Allocate(size_t size) {
+  for (size_t i = 0; i < kNumSizeClasses; i++) {
+    if (size <= kSizeClasses[i]) {
+      return AllocateFromClass(i, std::make_index_sequence<kNumSizeClasses>());
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    num_oversized_allocations_++;
+  }
+  return std::shared_ptr<uint8_t>(new uint8_t[size], std::default_delete<uint8_t[]>());
+}
+
+template <size_t... indexes>
+std::shared_ptr<uint8_t> BufferPool::AllocateFromClass(size_t class_index, std::index_sequence<indexes...>) {
+  using AllocateFunction = std::shared_ptr<uint8_t> (BufferPool::*)();
+  static constexpr AllocateFunction kAllocateFunctions[] = {&BufferPool::AllocateFromClass<indexes>...};
+  return (this->*kAllocateFunctions[class_index])();
+}
+
+template <size_t index>
+std::shared_ptr<uint8_t> BufferPool::AllocateFromClass() {
+  using BufferType = Buffer<kSizeClasses[index]>;
+  auto buffer = std::allocate_shared<BufferType>(BlockAllocator<BufferType>(this, index));
+  // Share the ownership of the block, and point at its bytes
+  return std::shared_ptr<uint8_t>(buffer, buffer->data);
+}
+
+void* BufferPool::TakeBlock(size_t class_index, size_t block_size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& size_class = size_classes_[class_index];
+    size_class.stats.num_allocations++;
+    size_class.stats.num_in_use++;
+    if (size_class.block_size == block_size && !size_class.free_blocks.empty()) {
+      void* block = size_class.free_blocks.back();
+      size_class.free_blocks.pop_back();
+      size_class.stats.num_reused++;
+      return block;
+    }
+  }
+  return ::operator new(block_size);
+}
+
+void BufferPool::ReturnBlock(size_t class_index, void* block, size_t block_size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& size_class = size_classes_[class_index];
+    size_class.stats.num_in_use--;
+    if (size_class.block_size == 0) {
+      size_class.block_size = block_size;
+    }
+    if (size_class.block_size == block_size && size_class.free_blocks.size() < max_cached_buffers_) {
+      size_class.free_blocks.push_back(block);
+      return;
+    }
+  }
+  ::operator delete(block);
+}
+
+BufferPool::Stats BufferPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  for (size_t i = 0; i < kNumSizeClasses; i++) {
+    stats.size_classes[i] = size_classes_[i].stats;
+    stats.size_classes[i].num_cached = size_classes_[i].free_blocks.size();
+  }
+  stats.num_oversized_allocations = num_oversized_allocations_;
+  return stats;
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace packet {
+
+// Recycles the buffers backing received packets, which View and PacketView share through
+// std::shared_ptr<const uint8_t>.
+// Each buffer is allocated together with its reference count, and is kept once the last view of it is gone to back a
+// later packet of the same size class, so a packet costs no heap allocation once the pool is warm.
+// The pool must outlive the buffers it hands out, Get() returns a pool that is never destroyed.
+class BufferPool {
+ public:
+  // Size classes fitting the HCI packet types:
+  // - short events, e.g. Number Of Completed Packets for a few handles
+  // - any event (2 + 255 bytes) and LE ACL packets (4 + 251 bytes)
+  // - BR/EDR ACL packets up to 3-DH5 (4 + 1021 bytes)
+  // - larger ACL and ISO packets
+  // Buffers larger than the last class are not pooled.
+  static constexpr size_t kNumSizeClasses = 4;
+  static constexpr std::array<size_t, kNumSizeClasses> kSizeClasses = {64, 264, 1032, 4104};
+  static constexpr size_t kDefaultMaxCachedBuffers = 32;
+
+  struct SizeClassStats {
+    size_t buffer_size = 0;
+    uint64_t num_allocations = 0;
+    // Allocations served with a cached buffer
+    uint64_t num_reused = 0;
+    size_t num_in_use = 0;
+    size_t num_cached = 0;
+  };
+
+  struct Stats {
+    std::array<SizeClassStats, kNumSizeClasses> size_classes;
+    uint64_t num_oversized_allocations = 0;
+  };
+
+  // Keep up to |max_cached_buffers| free buffers of each size class
+  explicit BufferPool(size_t max_cached_buffers = kDefaultMaxCachedBuffers);
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+  ~BufferPool();
+
+  // The pool for received packets
+  static BufferPool& Get();
+
+  // Allocate a buffer of at least |size| bytes. Its content is not initialized.
+  std::shared_ptr<uint8_t> Allocate(size_t size);
+
+  Stats GetStats() const;
+
+ private:
+  template <typename T>
+  class BlockAllocator;
+
+  struct SizeClass {
+    // Size of the blocks, holding the buffer and its reference count, set by the first allocation
+    size_t block_size = 0;
+    std::vector<void*> free_blocks;
+    SizeClassStats stats;
+  };
+
+  template <size_t... indexes>
+  std::shared_ptr<uint8_t> AllocateFromClass(size_t class_index, std::index_sequence<indexes...>);
+  template <size_t index>
+  std::shared_ptr<uint8_t> AllocateFromClass();
+
+  void* TakeBlock(size_t class_index, size_t block_size);
+  void ReturnBlock(size_t class_index, void* block, size_t block_size);
+
+  const size_t max_cached_buffers_;
+  mutable std::mutex mutex_;
+  std::array<SizeClass, kNumSizeClasses> size_classes_;
+  uint64_t num_oversized_allocations_ = 0;
+};
+
+}  // namespace packet
+}  // namespace bluetooth
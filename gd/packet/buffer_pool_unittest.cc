@@ -0,0 +1,91 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/buffer_pool.h"
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+
+#include "packet/packet_view.h"
+
+namespace bluetooth {
+namespace packet {
+
+TEST(BufferPoolTest, buffersAreReused) {
+  BufferPool pool;
+  auto buffer = pool.Allocate(10);
+  ASSERT_NE(buffer, nullptr);
+  const uint8_t* first = buffer.get();
+  buffer.reset();
+
+  auto stats = pool.GetStats();
+  ASSERT_EQ(stats.size_classes[0].num_allocations, 1u);
+  ASSERT_EQ(stats.size_classes[0].num_reused, 0u);
+  ASSERT_EQ(stats.size_classes[0].num_in_use, 0u);
+  ASSERT_EQ(stats.size_classes[0].num_cached, 1u);
+
+  buffer = pool.Allocate(BufferPool::kSizeClasses[0]);
+  ASSERT_EQ(buffer.get(), first);
+  stats = pool.GetStats();
+  ASSERT_EQ(stats.size_classes[0].num_reused, 1u);
+  ASSERT_EQ(stats.size_classes[0].num_in_use, 1u);
+  ASSERT_EQ(stats.size_classes[0].num_cached, 0u);
+}
+
+TEST(BufferPoolTest, sizeClasses) {
+  BufferPool pool;
+  for (size_t i = 0; i < BufferPool::kNumSizeClasses; i++) {
+    size_t size = BufferPool::kSizeClasses[i];
+    auto buffer = pool.Allocate(size);
+    // The whole buffer is usable
+    std::memset(buffer.get(), 0xaa, size);
+    ASSERT_EQ(pool.GetStats().size_classes[i].num_in_use, 1u);
+  }
+  auto oversized = pool.Allocate(BufferPool::kSizeClasses.back() + 1);
+  ASSERT_NE(oversized, nullptr);
+  ASSERT_EQ(pool.GetStats().num_oversized_allocations, 1u);
+}
+
+TEST(BufferPoolTest, cacheIsBounded) {
+  BufferPool pool(2);
+  auto first = pool.Allocate(1);
+  auto second = pool.Allocate(1);
+  auto third = pool.Allocate(1);
+  first.reset();
+  second.reset();
+  third.reset();
+  ASSERT_EQ(pool.GetStats().size_classes[0].num_cached, 2u);
+}
+
+TEST(BufferPoolTest, bufferSharedByPacketViews) {
+  BufferPool pool;
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(4);
+  const uint8_t bytes[] = {0x01, 0x02, 0x03, 0x04};
+  std::memcpy(buffer.get(), bytes, sizeof(bytes));
+  {
+    PacketView<kLittleEndian> packet(std::move(buffer), sizeof(bytes));
+    auto subview = packet.GetLittleEndianSubview(2, 4);
+    ASSERT_EQ(subview.begin().extract<uint16_t>(), 0x0403);
+    ASSERT_EQ(pool.GetStats().size_classes[0].num_in_use, 1u);
+  }
+  // Returned to the pool with the last view
+  ASSERT_EQ(pool.GetStats().size_classes[0].num_in_use, 0u);
+  ASSERT_EQ(pool.GetStats().size_classes[0].num_cached, 1u);
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -43,6 +43,20 @@ void ByteInserter::on_byte(uint8_t byte) {
   }
 }
 
+void ByteInserter::on_bytes(const uint8_t* data, size_t size) {
+  for (auto& observer : registered_observers_) {
+    observer.OnBytes(data, size);
+  }
+}
+
+void ByteInserter::append_bytes(const uint8_t* data, size_t size) {
+  container->insert(container->end(), data, data + size);
+}
+
+bool ByteInserter::has_observers() const {
+  return !registered_observers_.empty();
+}
+
 void ByteInserter::insert_byte(uint8_t byte) {
   on_byte(byte);
   std::back_insert_iterator<std::vector<uint8_t>>::operator=(byte);
@@ -40,6 +40,13 @@ class ByteInserter : public std::back_insert_iterator<std::vector<uint8_t>> {
  protected:
   void on_byte(uint8_t);
 
+  void on_bytes(const uint8_t* data, size_t size);
+
+  // Append |size| bytes to the vector at once, once the observers have seen them
+  void append_bytes(const uint8_t* data, size_t size);
+
+  bool has_observers() const;
+
  private:
   std::vector<ByteObserver> registered_observers_;
 };
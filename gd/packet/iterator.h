@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
 #include <memory>
 #include <type_traits>
@@ -28,10 +30,14 @@ namespace bluetooth {
 namespace packet {
 
 // Templated Iterator for endianness
+//
+// An iterator over a single contiguous fragment, which covers nearly every received packet, reads the bytes through a
+// pointer to the fragment; only iterators over several fragments keep the list of fragments and walk it for each byte.
 template <bool little_endian>
 class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t> {
  public:
   Iterator(const std::forward_list<View>& data, size_t offset);
+  Iterator(const View& contiguous_data, size_t offset);
   Iterator(const Iterator& itr) = default;
   virtual ~Iterator() = default;
 
@@ -69,6 +75,10 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
     FixedWidthPODType extracted_value{};
     uint8_t* value_ptr = (uint8_t*)&extracted_value;
 
+    if (IsContiguousRange(sizeof(FixedWidthPODType))) {
+      ExtractContiguous(value_ptr, sizeof(FixedWidthPODType));
+      return extracted_value;
+    }
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
       size_t index = (little_endian ? i : sizeof(FixedWidthPODType) - i - 1);
       value_ptr[index] = this->operator*();
@@ -80,6 +90,10 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
   template <typename T, typename std::enable_if<std::is_base_of_v<CustomFieldFixedSizeInterface<T>, T>, int>::type = 0>
   T extract() {
     T extracted_value{};
+    if (IsContiguousRange(CustomFieldFixedSizeInterface<T>::length())) {
+      ExtractContiguous(extracted_value.data(), CustomFieldFixedSizeInterface<T>::length());
+      return extracted_value;
+    }
     for (size_t i = 0; i < CustomFieldFixedSizeInterface<T>::length(); i++) {
       size_t index = (little_endian ? i : CustomFieldFixedSizeInterface<T>::length() - i - 1);
       extracted_value.data()[index] = this->operator*();
@@ -89,7 +103,26 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
   }
 
  private:
+  // Whether the next |length| bytes are in bounds and can be read from |contiguous_data_|
+  bool IsContiguousRange(size_t length) const {
+    return contiguous_data_ != nullptr && index_ >= begin_ && index_ <= end_ && end_ - index_ >= length;
+  }
+
+  // Copy the next |length| bytes, checked by IsContiguousRange(), to |destination| in host order
+  void ExtractContiguous(uint8_t* destination, size_t length) {
+    std::memcpy(destination, contiguous_data_ + index_, length);
+    if (!little_endian) {
+      std::reverse(destination, destination + length);
+    }
+    index_ += length;
+  }
+
+  // Fragments of an iterator over several fragments, empty for a contiguous one
   std::forward_list<View> data_;
+  // Keeps the contiguous fragment alive while |contiguous_data_| points into it
+  std::shared_ptr<const uint8_t> contiguous_storage_;
+  // First byte of the contiguous fragment, nullptr for an iterator over several fragments
+  const uint8_t* contiguous_data_ = nullptr;
   size_t index_;
   size_t begin_;
   size_t end_;
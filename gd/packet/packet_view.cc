@@ -17,6 +17,8 @@
 #include "packet/packet_view.h"
 
 #include <algorithm>
+#include <cstring>
+#include <iterator>
 
 #include "os/log.h"
 
@@ -24,24 +26,54 @@ namespace bluetooth {
 namespace packet {
 
 template <bool little_endian>
-PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments)
-    : fragments_(fragments), length_(0) {
-  for (auto fragment : fragments_) {
+PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments) : length_(0) {
+  SetFragments(std::move(fragments));
+}
+
+template <bool little_endian>
+PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet)
+    : single_fragment_(View(packet, 0, packet->size())), length_(packet->size()) {}
+
+template <bool little_endian>
+PacketView<little_endian>::PacketView(std::shared_ptr<const uint8_t> packet, size_t size)
+    : single_fragment_(View(std::move(packet), size, 0, size)), length_(size) {}
+
+template <bool little_endian>
+void PacketView<little_endian>::SetFragments(std::forward_list<View> fragments) {
+  length_ = 0;
+  for (const auto& fragment : fragments) {
     length_ += fragment.size();
   }
+  if (!fragments.empty() && std::next(fragments.begin()) == fragments.end()) {
+    single_fragment_.emplace(fragments.front());
+    fragments_.clear();
+  } else {
+    single_fragment_.reset();
+    fragments_ = std::move(fragments);
+  }
 }
 
 template <bool little_endian>
-PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet)
-    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {}
+std::forward_list<View> PacketView<little_endian>::GetFragments() const {
+  if (single_fragment_) {
+    return {*single_fragment_};
+  }
+  return fragments_;
+}
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::begin() const {
+  if (single_fragment_) {
+    return Iterator<little_endian>(*single_fragment_, 0);
+  }
   return Iterator<little_endian>(this->fragments_, 0);
 }
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::end() const {
+  if (single_fragment_) {
+    return Iterator<little_endian>(*single_fragment_, size());
+  }
   return Iterator<little_endian>(this->fragments_, size());
 }
 
@@ -53,6 +85,9 @@ uint8_t PacketView<little_endian>::operator[](size_t index) const {
 template <bool little_endian>
 uint8_t PacketView<little_endian>::at(size_t index) const {
   ASSERT_LOG(index < length_, "Index %zu out of bounds", index);
+  if (single_fragment_) {
+    return single_fragment_->data()[index];
+  }
   for (const auto& fragment : fragments_) {
     if (index < fragment.size()) {
       return fragment[index];
@@ -73,6 +108,9 @@ std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin,
   ASSERT(begin <= end);
   ASSERT(end <= length_);
 
+  if (single_fragment_) {
+    return {View(*single_fragment_, begin, end)};
+  }
   std::forward_list<View> view_list;
   std::forward_list<View>::iterator it = view_list.before_begin();
   size_t length = end - begin;
@@ -99,9 +137,30 @@ PacketView<false> PacketView<little_endian>::GetBigEndianSubview(size_t begin, s
   return PacketView<false>(GetSubviewList(begin, end));
 }
 
+template <bool little_endian>
+const View* PacketView<little_endian>::GetSingleFragment() const {
+  if (single_fragment_) {
+    return &*single_fragment_;
+  }
+  return nullptr;
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::CopyTo(uint8_t* destination) const {
+  if (single_fragment_) {
+    std::memcpy(destination, single_fragment_->data(), single_fragment_->size());
+    return;
+  }
+  for (const auto& fragment : fragments_) {
+    std::memcpy(destination, fragment.data(), fragment.size());
+    destination += fragment.size();
+  }
+}
+
 template <bool little_endian>
 void PacketView<little_endian>::Append(PacketView to_add) {
-  auto insertion_point = fragments_.begin();
+  auto fragments = GetFragments();
+  auto insertion_point = fragments.begin();
   size_t remaining_length = length_;
   while (remaining_length > 0) {
     remaining_length -= insertion_point->size();
@@ -109,12 +168,12 @@ void PacketView<little_endian>::Append(PacketView to_add) {
       insertion_point++;
     }
   }
-  ASSERT(insertion_point != fragments_.end());
-  for (const auto& fragment : to_add.fragments_) {
-    fragments_.insert_after(insertion_point, fragment);
+  ASSERT(insertion_point != fragments.end());
+  for (const auto& fragment : to_add.GetFragments()) {
+    fragments.insert_after(insertion_point, fragment);
     insertion_point++;
   }
-  length_ += to_add.length_;
+  SetFragments(std::move(fragments));
 }
 
 // Explicit instantiations for both types of PacketViews.
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
+#include <optional>
+#include <type_traits>
 
 #include "packet/iterator.h"
 #include "packet/view.h"
@@ -36,6 +40,7 @@ class PacketView {
   explicit PacketView(std::forward_list<View> fragments);
   PacketView(const PacketView& PacketView) = default;
   explicit PacketView(std::shared_ptr<std::vector<uint8_t>> packet);
+  PacketView(std::shared_ptr<const uint8_t> packet, size_t size);
   PacketView<little_endian>() = delete;
   virtual ~PacketView() = default;
 
@@ -53,12 +58,42 @@ class PacketView {
 
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
 
+  // Return the only fragment when the packet is backed by one contiguous range, nullptr otherwise
+  const View* GetSingleFragment() const;
+
+  // Flatten the packet into destination, which must hold size() bytes. Copies one fragment at a time rather than
+  // byte by byte through the iterator.
+  void CopyTo(uint8_t* destination) const;
+
  protected:
   void Append(PacketView to_add);
 
+  // Extract the value |offset| bytes into the packet. The generated views read the fields at an offset known when the
+  // packet is generated with it, after IsValid() checked once that the packet is long enough. A value held by the only
+  // fragment of the packet is copied from it directly, other values are read through an iterator.
+  template <typename FixedWidthPODType>
+  FixedWidthPODType ExtractAt(size_t offset) const {
+    static_assert(std::is_pod<FixedWidthPODType>::value, "PacketView::ExtractAt requires a fixed-width type.");
+    if (!single_fragment_ || offset > length_ || length_ - offset < sizeof(FixedWidthPODType)) {
+      return (begin() + offset).template extract<FixedWidthPODType>();
+    }
+    FixedWidthPODType extracted_value{};
+    uint8_t* value_ptr = (uint8_t*)&extracted_value;
+    std::memcpy(value_ptr, single_fragment_->data() + offset, sizeof(FixedWidthPODType));
+    if (!little_endian) {
+      std::reverse(value_ptr, value_ptr + sizeof(FixedWidthPODType));
+    }
+    return extracted_value;
+  }
+
  private:
+  // Packets backed by one contiguous range, nearly all received packets, keep it in |single_fragment_| and are read
+  // through a pointer to it. |fragments_| holds the fragments of the other packets and is empty for those.
+  std::optional<View> single_fragment_;
   std::forward_list<View> fragments_;
   size_t length_;
+  void SetFragments(std::forward_list<View> fragments);
+  std::forward_list<View> GetFragments() const;
   std::forward_list<View> GetSubviewList(size_t begin, size_t end) const;
 };
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/hci_packets.h"
+#include "l2cap/l2cap_packets.h"
+#include "packet/packet_view.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace packet {
+
+namespace {
+
+// Number Of Completed Packets event for 4 connection handles
+const std::vector<uint8_t> kNumberOfCompletedPackets = {
+    0x13, 0x11, 0x04, 0x01, 0x00, 0x02, 0x00, 0x02, 0x00, 0x01, 0x00,
+    0x03, 0x00, 0x05, 0x00, 0x04, 0x00, 0x01, 0x00};
+
+// Command Complete event for Read BD_ADDR
+const std::vector<uint8_t> kReadBdAddrComplete = {
+    0x0e, 0x0a, 0x01, 0x09, 0x10, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+
+// ACL packet on handle 0x0001 carrying an L2CAP basic frame with 12 bytes of payload on channel 0x0040
+const std::vector<uint8_t> kAclL2capPacket = {0x01, 0x20, 0x10, 0x00, 0x0c, 0x00, 0x40, 0x00, 0x01, 0x02,
+                                              0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c};
+
+PacketView<kLittleEndian> SingleFragment(const std::vector<uint8_t>& bytes) {
+  return PacketView<kLittleEndian>(std::make_shared<std::vector<uint8_t>>(bytes));
+}
+
+// The same bytes split in two fragments after the first |split| bytes, which takes the fragment walking path
+PacketView<kLittleEndian> TwoFragments(const std::vector<uint8_t>& bytes, size_t split) {
+  auto head = std::make_shared<const std::vector<uint8_t>>(bytes.begin(), bytes.begin() + split);
+  auto tail = std::make_shared<const std::vector<uint8_t>>(bytes.begin() + split, bytes.end());
+  return PacketView<kLittleEndian>(
+      std::forward_list<View>({View(head, 0, head->size()), View(tail, 0, tail->size())}));
+}
+
+void ParseNumberOfCompletedPackets(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto event = hci::EventView::Create(packet);
+    auto view = hci::NumberOfCompletedPacketsView::Create(event);
+    if (!view.IsValid()) {
+      state.SkipWithError("invalid event");
+      break;
+    }
+    for (const auto& completed_packets : view.GetCompletedPackets()) {
+      ::benchmark::DoNotOptimize(completed_packets.connection_handle_);
+      ::benchmark::DoNotOptimize(completed_packets.host_num_of_completed_packets_);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void ParseReadBdAddrComplete(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto event = hci::EventView::Create(packet);
+    auto view = hci::ReadBdAddrCompleteView::Create(hci::CommandCompleteView::Create(event));
+    if (!view.IsValid()) {
+      state.SkipWithError("invalid event");
+      break;
+    }
+    ::benchmark::DoNotOptimize(view.GetCommandOpCode());
+    ::benchmark::DoNotOptimize(view.GetStatus());
+    ::benchmark::DoNotOptimize(view.GetBdAddr());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void ParseAclL2capHeaders(State& state, const PacketView<kLittleEndian>& packet) {
+  for (auto _ : state) {
+    auto acl = hci::AclView::Create(packet);
+    if (!acl.IsValid()) {
+      state.SkipWithError("invalid ACL packet");
+      break;
+    }
+    ::benchmark::DoNotOptimize(acl.GetHandle());
+    ::benchmark::DoNotOptimize(acl.GetPacketBoundaryFlag());
+    ::benchmark::DoNotOptimize(acl.GetBroadcastFlag());
+    auto basic_frame = l2cap::BasicFrameView::Create(acl.GetPayload());
+    if (!basic_frame.IsValid()) {
+      state.SkipWithError("invalid L2CAP frame");
+      break;
+    }
+    ::benchmark::DoNotOptimize(basic_frame.GetChannelId());
+    ::benchmark::DoNotOptimize(basic_frame.GetPayload().size());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+static void BM_PacketView_number_of_completed_packets(State& state) {
+  ParseNumberOfCompletedPackets(state, SingleFragment(kNumberOfCompletedPackets));
+}
+BENCHMARK(BM_PacketView_number_of_completed_packets);
+
+static void BM_PacketView_number_of_completed_packets_fragmented(State& state) {
+  ParseNumberOfCompletedPackets(state, TwoFragments(kNumberOfCompletedPackets, 8));
+}
+BENCHMARK(BM_PacketView_number_of_completed_packets_fragmented);
+
+static void BM_PacketView_read_bd_addr_complete(State& state) {
+  ParseReadBdAddrComplete(state, SingleFragment(kReadBdAddrComplete));
+}
+BENCHMARK(BM_PacketView_read_bd_addr_complete);
+
+static void BM_PacketView_acl_l2cap_headers(State& state) {
+  ParseAclL2capHeaders(state, SingleFragment(kAclL2capPacket));
+}
+BENCHMARK(BM_PacketView_acl_l2cap_headers);
+
+static void BM_PacketView_acl_l2cap_headers_fragmented(State& state) {
+  ParseAclL2capHeaders(state, TwoFragments(kAclL2capPacket, 6));
+}
+BENCHMARK(BM_PacketView_acl_l2cap_headers_fragmented);
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -630,5 +630,92 @@ TEST(ViewTest, zeroSubviewTest) {
   View subview(view, view.size(), view.size() + 1);
   ASSERT_EQ(subview.size(), 0u);
 }
+TEST(ViewTest, sharedBufferTest) {
+  std::shared_ptr<uint8_t> buffer(new uint8_t[count_all.size()], std::default_delete<uint8_t[]>());
+  std::copy(count_all.begin(), count_all.end(), buffer.get());
+  View view(buffer, count_all.size(), 0, count_all.size() + 1);
+  ASSERT_EQ(view.size(), count_all.size());
+  View subview(view, 3, 6);
+  ASSERT_EQ(subview.size(), 3u);
+  ASSERT_EQ(subview[0], 3);
+  ASSERT_EQ(subview.data(), buffer.get() + 3);
+  ASSERT_EQ(subview.GetStorage().get(), buffer.get());
+  ASSERT_EQ(subview.GetStorageOffset(), 3u);
+}
+
+TEST(PacketViewBufferTest, sharedBufferTest) {
+  std::shared_ptr<uint8_t> buffer(new uint8_t[count_all.size()], std::default_delete<uint8_t[]>());
+  std::copy(count_all.begin(), count_all.end(), buffer.get());
+  PacketView<true> packet(buffer, count_all.size());
+  ASSERT_EQ(packet.size(), count_all.size());
+  ASSERT_EQ(packet[5], count_all[5]);
+
+  PacketView<true> subview = packet.GetLittleEndianSubview(2, 8);
+  const View* fragment = subview.GetSingleFragment();
+  ASSERT_NE(fragment, nullptr);
+  ASSERT_EQ(fragment->GetStorage().get(), buffer.get());
+  ASSERT_EQ(fragment->GetStorageOffset(), 2u);
+}
+
+TEST_F(PacketViewMultiViewTest, singleFragmentTest) {
+  ASSERT_EQ(multi_view.GetSingleFragment(), nullptr);
+  ASSERT_NE(single_view.GetSingleFragment(), nullptr);
+}
+
+TEST_F(PacketViewMultiViewTest, copyToTest) {
+  std::vector<uint8_t> flattened(multi_view.size());
+  multi_view.CopyTo(flattened.data());
+  ASSERT_EQ(flattened, count_all);
+
+  PacketView<true> subview = multi_view.GetLittleEndianSubview(1, multi_view.size() - 1);
+  std::vector<uint8_t> flattened_subview(subview.size());
+  subview.CopyTo(flattened_subview.data());
+  ASSERT_EQ(flattened_subview, std::vector<uint8_t>(count_all.begin() + 1, count_all.end() - 1));
+}
+
+TEST_F(PacketViewMultiViewTest, extractAcrossFragmentsTest) {
+  // Values straddling fragment boundaries are read byte by byte, the same as from a single fragment
+  for (size_t offset = 0; offset + sizeof(uint64_t) <= count_all.size(); offset++) {
+    auto single_it = single_view.begin() + offset;
+    auto multi_it = multi_view.begin() + offset;
+    ASSERT_EQ(single_it.extract<uint64_t>(), multi_it.extract<uint64_t>());
+    ASSERT_EQ(single_it, multi_it);
+  }
+  auto single_it = single_view.GetBigEndianSubview(2, 6).begin();
+  auto multi_it = multi_view.GetBigEndianSubview(2, 6).begin();
+  ASSERT_EQ(0x02030405u, single_it.extract<uint32_t>());
+  ASSERT_EQ(0x02030405u, multi_it.extract<uint32_t>());
+}
+
+TEST_F(PacketViewMultiViewTest, subviewOfSingleFragmentTest) {
+  PacketView<true> subview = single_view.GetLittleEndianSubview(4, 8);
+  ASSERT_NE(subview.GetSingleFragment(), nullptr);
+  ASSERT_EQ(subview.size(), 4u);
+  ASSERT_EQ(subview[0], 0x04);
+  ASSERT_EQ(0x07060504u, subview.begin().extract<uint32_t>());
+  ASSERT_DEATH(subview.begin().Subrange(1, 3).extract<uint32_t>(), "");
+}
+
+template <bool little_endian>
+class ExtractAtPacketView : public PacketView<little_endian> {
+ public:
+  explicit ExtractAtPacketView(PacketView<little_endian> packet) : PacketView<little_endian>(packet) {}
+  using PacketView<little_endian>::ExtractAt;
+};
+
+TEST_F(PacketViewMultiViewTest, extractAtTest) {
+  // Values read directly from a single fragment match the ones read through an iterator over several fragments
+  ExtractAtPacketView<true> single(single_view);
+  ExtractAtPacketView<true> multi(multi_view);
+  for (size_t offset = 0; offset + sizeof(uint32_t) <= count_all.size(); offset++) {
+    ASSERT_EQ(single.ExtractAt<uint32_t>(offset), (single_view.begin() + offset).extract<uint32_t>());
+    ASSERT_EQ(single.ExtractAt<uint32_t>(offset), multi.ExtractAt<uint32_t>(offset));
+  }
+  ExtractAtPacketView<false> big_endian(single_view.GetBigEndianSubview(2, 6));
+  ASSERT_EQ(0x02030405u, big_endian.ExtractAt<uint32_t>(0));
+  ASSERT_EQ(0x0304u, big_endian.ExtractAt<uint16_t>(1));
+  // Values past the end of the packet are not read from the fragment
+  ASSERT_DEATH(big_endian.ExtractAt<uint32_t>(1), "");
+}
 }  // namespace packet
 }  // namespace bluetooth
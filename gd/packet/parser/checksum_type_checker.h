@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace bluetooth {
 namespace packet {
@@ -49,6 +53,38 @@ class ChecksumTypeChecker {
   // This checks which template was matched
   static constexpr bool value = (sizeof(Test<T, TRET>(0, 0, 0)) == sizeof(int));
 };
+
+// Checks for the optional AddBytes(const uint8_t* data, size_t size), for checksums faster over a run of bytes
+template <typename T, typename = void>
+struct HasAddBytes : std::false_type {};
+
+template <typename T>
+struct HasAddBytes<T, std::void_t<decltype(std::declval<T&>().AddBytes(std::declval<const uint8_t*>(), size_t{}))>>
+    : std::true_type {};
+
+template <typename T>
+void AddBytesToChecksum(T& checksum, const uint8_t* data, size_t size) {
+  if constexpr (HasAddBytes<T>::value) {
+    checksum.AddBytes(data, size);
+  } else {
+    for (size_t i = 0; i < size; i++) {
+      checksum.AddByte(data[i]);
+    }
+  }
+}
+
+// Add the bytes of a packet view, at once when it is one contiguous range
+template <typename T, typename View>
+void AddViewToChecksum(T& checksum, const View& view) {
+  auto fragment = view.GetSingleFragment();
+  if (fragment != nullptr) {
+    AddBytesToChecksum(checksum, fragment->data(), fragment->size());
+    return;
+  }
+  for (uint8_t byte : view) {
+    checksum.AddByte(byte);
+  }
+}
 }  // namespace parser
 }  // namespace packet
 }  // namespace bluetooth
@@ -114,16 +114,17 @@ void PayloadField::GenStringRepresentation(std::ostream& s, std::string) const {
 }
 
 std::string PayloadField::GetRustDataType() const {
-  return "Vec::<u8>";
+  return "Bytes";
 }
 
 void PayloadField::GenRustGetter(std::ostream& s, Size start_offset, Size) const {
+  // The payload shares the buffer of the parsed packet
   s << "let " << GetName() << ": " << GetRustDataType() << " = ";
   if (size_field_ == nullptr) {
-    s << "bytes[" << start_offset.bytes() << "..].into();";
+    s << "bytes.slice(" << start_offset.bytes() << "..);";
   } else {
-    s << "bytes[" << start_offset.bytes() << "..(";
-    s << start_offset.bytes() << " + " << size_field_->GetName() << " as usize)].into();";
+    s << "bytes.slice(" << start_offset.bytes() << "..(";
+    s << start_offset.bytes() << " + " << size_field_->GetName() << " as usize));";
   }
 }
 
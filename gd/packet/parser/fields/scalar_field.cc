@@ -73,7 +73,12 @@ void ScalarField::GenExtractor(std::ostream& s, int num_leading_bits, bool) cons
   // current field to start in the middle of a byte.
   std::string extract_type = util::GetTypeForSize(size.bits() + num_leading_bits);
   s << "auto extracted_value = " << GetName() << "_it.extract<" << extract_type << ">();";
+  GenShiftAndMask(s, num_leading_bits);
+  s << "*" << GetName() << "_ptr = static_cast<" << GetDataType() << ">(extracted_value);";
+}
 
+void ScalarField::GenShiftAndMask(std::ostream& s, int num_leading_bits) const {
+  Size size = GetSize();
   // Right shift the result to remove leading bits.
   if (num_leading_bits != 0) {
     s << "extracted_value >>= " << num_leading_bits << ";";
@@ -87,7 +92,6 @@ void ScalarField::GenExtractor(std::ostream& s, int num_leading_bits, bool) cons
     }
     s << "extracted_value &= 0x" << std::hex << mask << std::dec << ";";
   }
-  s << "*" << GetName() << "_ptr = static_cast<" << GetDataType() << ">(extracted_value);";
 }
 
 std::string ScalarField::GetGetterFunctionName() const {
@@ -99,6 +103,18 @@ std::string ScalarField::GetGetterFunctionName() const {
 void ScalarField::GenGetter(std::ostream& s, Size start_offset, Size end_offset) const {
   s << GetDataType() << " " << GetGetterFunctionName() << "() const {";
   s << "ASSERT(was_validated_);";
+  // The offset of a field preceded by fixed size fields only is a constant, read it directly since IsValid() has
+  // checked the fixed size fields fit in the packet.
+  if (!start_offset.empty() && !start_offset.has_dynamic()) {
+    int num_leading_bits = start_offset.bits() % 8;
+    std::string extract_type = util::GetTypeForSize(GetSize().bits() + num_leading_bits);
+    s << "static constexpr size_t " << GetName() << "_offset = " << start_offset.bits() / 8 << ";";
+    s << "auto extracted_value = ExtractAt<" << extract_type << ">(" << GetName() << "_offset);";
+    GenShiftAndMask(s, num_leading_bits);
+    s << "return static_cast<" << GetDataType() << ">(extracted_value);";
+    s << "}";
+    return;
+  }
   s << "auto to_bound = begin();";
   int num_leading_bits = GenBounds(s, start_offset, end_offset, GetSize());
   s << GetDataType() << " " << GetName() << "_value{};";
@@ -161,6 +177,16 @@ int ScalarField::GetRustBitOffset(
 }
 
 void ScalarField::GenRustGetter(std::ostream& s, Size start_offset, Size end_offset) const {
+  GenRustRawGetter(s, start_offset, end_offset);
+
+  // needs casting from primitive
+  if (GetRustParseDataType() != GetRustDataType()) {
+    s << "let " << GetName() << " = ";
+    s << GetRustDataType() << "::from_" << GetRustParseDataType() << "(" << GetName() << ").unwrap();";
+  }
+}
+
+void ScalarField::GenRustRawGetter(std::ostream& s, Size start_offset, Size end_offset) const {
   Size size = GetSize();
 
   int num_leading_bits = GetRustBitOffset(s, start_offset, end_offset, GetSize());
@@ -203,12 +229,6 @@ void ScalarField::GenRustGetter(std::ostream& s, Size start_offset, Size end_off
     s << "let " << GetName() << " = ";
     s << GetName() << " & 0x" << std::hex << mask << std::dec << ";";
   }
-
-  // needs casting from primitive
-  if (GetRustParseDataType() != GetRustDataType()) {
-    s << "let " << GetName() << " = ";
-    s << GetRustDataType() << "::from_" << GetRustParseDataType() << "(" << GetName() << ").unwrap();";
-  }
 }
 
 void ScalarField::GenRustWriter(std::ostream& s, Size start_offset, Size end_offset) const {
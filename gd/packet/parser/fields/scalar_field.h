@@ -60,6 +60,9 @@ class ScalarField : public PacketField {
 
   void GenRustGetter(std::ostream& s, Size start_offset, Size end_offset) const override;
 
+  // Same as GenRustGetter, without the conversion to the Rust data type.
+  void GenRustRawGetter(std::ostream& s, Size start_offset, Size end_offset) const;
+
   void GenRustWriter(std::ostream& s, Size start_offset, Size end_offset) const override;
 
   virtual bool GetterIsByRef() const override {
@@ -67,5 +70,8 @@ class ScalarField : public PacketField {
   }
 
  private:
+  // Shift out the |num_leading_bits| of the previous fields from extracted_value and mask the bits following the field
+  void GenShiftAndMask(std::ostream& s, int num_leading_bits) const;
+
   const int size_;
 };
@@ -54,6 +54,16 @@ pub enum Error {
 pub trait Packet {
   fn to_bytes(self) -> Bytes;
   fn to_vec(self) -> Vec<u8>;
+  /// Size of the serialized packet
+  fn total_size(&self) -> usize;
+  /// Serialize into |buffer|, which must be exactly |total_size()| bytes long
+  fn write_into(&self, buffer: &mut [u8]);
+  /// Serialize at the end of |buffer|, without an intermediate buffer
+  fn write_to_bytes_mut(&self, buffer: &mut BytesMut) {
+    let start = buffer.len();
+    buffer.resize(start + self.total_size(), 0);
+    self.write_into(&mut buffer[start..]);
+  }
 }
 
 )";
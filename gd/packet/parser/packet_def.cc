@@ -73,7 +73,10 @@ void PacketDef::GenParserDefinition(std::ostream& s) const {
   // Constructor from a View
   if (parent_ != nullptr) {
     s << "explicit " << name_ << "View(" << parent_->name_ << "View parent)";
-    s << " : " << parent_->name_ << "View(std::move(parent)) { was_validated_ = false; }";
+    // A parent validated before this view was created vouches for all of the ancestors of this view.
+    s << " : " << parent_->name_ << "View(std::move(parent)) {";
+    s << "if (was_validated_) { num_validated_ancestors_ = " << GetAncestors().size() << "; }";
+    s << "was_validated_ = false; }";
   } else {
     s << "explicit " << name_ << "View(PacketView<" << (is_little_endian_ ? "" : "!") << "kLittleEndian> packet) ";
     s << " : PacketView<" << (is_little_endian_ ? "" : "!") << "kLittleEndian>(packet) { was_validated_ = false;}";
@@ -185,8 +188,10 @@ void PacketDef::GenValidator(std::ostream& s) const {
   s << "protected:";
   s << "virtual bool IsValid_() const {";
 
+  // Only validate the ancestors which were not validated before this view was created from them.
   if (parent_ != nullptr) {
-    s << "if (!" << parent_->name_ << "View::IsValid_()) { return false; } ";
+    s << "if (num_validated_ancestors_ < " << GetAncestors().size() << " && !" << parent_->name_
+      << "View::IsValid_()) { return false; } ";
   }
 
   // Offset by the parents known size. We know that any dynamic fields can
@@ -243,8 +248,7 @@ void PacketDef::GenValidator(std::ostream& s) const {
       }
       s << started_field->GetDataType() << " checksum;";
       s << "checksum.Initialize();";
-      s << "for (uint8_t byte : checksum_view) { ";
-      s << "checksum.AddByte(byte);}";
+      s << "::bluetooth::packet::parser::AddViewToChecksum(checksum, checksum_view);";
       s << "if (checksum.GetChecksum() != (begin() + end_sum_index).extract<"
         << util::GetTypeForSize(started_field->GetSize().bits()) << ">()) { return false; }";
 
@@ -314,6 +318,7 @@ void PacketDef::GenValidator(std::ostream& s) const {
   s << "}\n";
   if (parent_ == nullptr) {
     s << "bool was_validated_{false};\n";
+    s << "size_t num_validated_ancestors_{0};\n";
   }
 }
 
@@ -909,9 +914,9 @@ void PacketDef::GenRustStructImpls(std::ostream& s) const {
     auto constraint = FindConstraintField();
     auto constraint_field = GetParamList().GetField(constraint);
     auto constraint_type = constraint_field->GetRustDataType();
-    s << "fn parse(bytes: &[u8], " << constraint << ": " << constraint_type << ") -> Result<Self> {";
+    s << "fn parse(bytes: &Bytes, " << constraint << ": " << constraint_type << ") -> Result<Self> {";
   } else {
-    s << "fn parse(bytes: &[u8]) -> Result<Self> {";
+    s << "fn parse(bytes: &Bytes) -> Result<Self> {";
   }
   fields = fields_.GetFieldsWithoutTypes({
       BodyField::kFieldType,
@@ -964,10 +969,10 @@ void PacketDef::GenRustStructImpls(std::ostream& s) const {
         s << name_ << "DataChild::";
         s << desc_path[0]->name_ << "(Arc::new(";
         if (desc_path[0]->parent_constraints_.empty()) {
-          s << desc_path[0]->name_ << "Data::parse(&bytes[..]";
+          s << desc_path[0]->name_ << "Data::parse(bytes";
           s << ", " << enum_variant << ")?))";
         } else {
-          s << desc_path[0]->name_ << "Data::parse(&bytes[..])?))";
+          s << desc_path[0]->name_ << "Data::parse(bytes)?))";
         }
       } else if (constraint_type == ScalarField::kFieldType) {
         s << std::get<int64_t>(desc.second) << " => {";
@@ -984,7 +989,7 @@ void PacketDef::GenRustStructImpls(std::ostream& s) const {
     s << "};\n";
   } else if (children_.size() == 1) {
     auto child = children_.at(0);
-    s << "let child = match " << child->name_ << "Data::parse(&bytes[..]) {";
+    s << "let child = match " << child->name_ << "Data::parse(bytes) {";
     s << " Ok(c) if " << child->name_ << "Data::conforms(&bytes[..]) => {";
     s << name_ << "DataChild::" << child->name_ << "(Arc::new(c))";
     s << " },";
@@ -993,7 +998,7 @@ void PacketDef::GenRustStructImpls(std::ostream& s) const {
     s << "};";
   } else if (fields_.HasPayload()) {
     s << "let child = if payload.len() > 0 {";
-    s << name_ << "DataChild::Payload(Bytes::from(payload))";
+    s << name_ << "DataChild::Payload(payload)";
     s << "} else {";
     s << name_ << "DataChild::None";
     s << "};";
@@ -1025,7 +1030,7 @@ void PacketDef::GenRustStructImpls(std::ostream& s) const {
   s << "}\n";
 
   // write_to function
-  s << "fn write_to(&self, buffer: &mut BytesMut) {";
+  s << "fn write_to(&self, buffer: &mut [u8]) {";
   GenRustWriteToFields(s);
 
   if (HasChildEnums()) {
@@ -1080,13 +1085,23 @@ void PacketDef::GenRustAccessStructImpls(std::ostream& s) const {
   s << " buffer.freeze()";
   s << "}\n";
 
-  s << "fn to_vec(self) -> Vec<u8> { self.to_bytes().to_vec() }\n";
+  s << "fn to_vec(self) -> Vec<u8> {";
+  s << " let mut buffer = vec![0; self." << root_accessor << ".get_total_size()];";
+  s << " self." << root_accessor << ".write_to(&mut buffer);";
+  s << " buffer";
+  s << "}\n";
+  s << "fn total_size(&self) -> usize { self." << root_accessor << ".get_total_size() }\n";
+  s << "fn write_into(&self, buffer: &mut [u8]) { self." << root_accessor << ".write_to(buffer) }\n";
   s << "}";
 
   s << "impl " << name_ << "Packet {";
   if (parent_ == nullptr) {
     s << "pub fn parse(bytes: &[u8]) -> Result<Self> { ";
-    s << "Ok(Self::new(Arc::new(" << name_ << "Data::parse(bytes)?)))";
+    s << "Self::parse_bytes(Bytes::copy_from_slice(bytes))";
+    s << "}";
+    // Payloads of the packet are slices of |bytes|, nothing is copied
+    s << "pub fn parse_bytes(bytes: Bytes) -> Result<Self> { ";
+    s << "Ok(Self::new(Arc::new(" << name_ << "Data::parse(&bytes)?)))";
     s << "}";
   }
 
@@ -1241,6 +1256,10 @@ void PacketDef::GenRustBuilderStructImpls(std::ostream& s) const {
   s << name_ << "Packet::new(" << util::CamelCaseToUnderScore(prev->name_) << ")";
   s << "}\n";
 
+  s << "pub fn write_to_bytes_mut(self, buffer: &mut BytesMut) {";
+  s << " self.build().write_to_bytes_mut(buffer)";
+  s << "}\n";
+
   s << "}\n";
   for (const auto ancestor : GetAncestors()) {
     s << "impl Into<" << ancestor->name_ << "Packet> for " << name_ << "Builder {";
@@ -1298,6 +1317,16 @@ void PacketDef::GenRustBuilderTest(std::ostream& s) const {
         s << "let rebuilder_base : " << lineage[0]->name_ << "Packet = rebuilder.into();";
         s << "let rebuilder_bytes : &[u8] = &rebuilder_base.to_bytes();";
         s << "assert_eq!(rebuilder_bytes, raw_bytes);";
+        std::vector<std::pair<const ParentDef*, const PacketField*>> view_fields;
+        Size view_min_size;
+        std::string view_min_size_field;
+        if (GetRustViewFields(&view_fields, &view_min_size, &view_min_size_field)) {
+          s << "let view = " << name_ << "View::new(raw_bytes).unwrap();";
+          for (const auto& field : view_fields) {
+            s << "assert_eq!(view.get_" << field.second->GetName() << "(), packet.get_" << field.second->GetName()
+              << "());";
+          }
+        }
         s << "}";
       }
     }
@@ -1328,11 +1357,169 @@ void PacketDef::GenRustBuilderTest(std::ostream& s) const {
   }
 }
 
+bool PacketDef::GetRustViewFields(std::vector<std::pair<const ParentDef*, const PacketField*>>* fields,
+                                  Size* min_size, std::string* min_size_field) const {
+  auto lineage = GetAncestors();
+  lineage.push_back(this);
+
+  *min_size = Size(0);
+  for (auto def : lineage) {
+    for (const auto field : def->fields_) {
+      if (field->GetFieldType() == BodyField::kFieldType) {
+        continue;
+      }
+      auto offset = def->GetOffsetForField(field->GetName(), false);
+      if (offset.empty() || offset.has_dynamic()) {
+        continue;
+      }
+      auto size = field->GetSize();
+      if (!size.empty() && !size.has_dynamic() && offset.bits() + size.bits() > min_size->bits()) {
+        *min_size = Size(offset.bits() + size.bits());
+        *min_size_field = field->GetName();
+      }
+      auto field_type = field->GetFieldType();
+      if (field_type == ScalarField::kFieldType || field_type == EnumField::kFieldType) {
+        fields->push_back(std::make_pair(def, field));
+      }
+    }
+  }
+
+  for (const auto& constraint : GetAllConstraints()) {
+    auto it = std::find_if(fields->begin(), fields->end(), [&constraint](const auto& f) {
+      return f.second->GetName() == constraint.first;
+    });
+    if (it == fields->end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PacketDef::GenRustViewStructImpls(std::ostream& s) const {
+  std::vector<std::pair<const ParentDef*, const PacketField*>> fields;
+  Size min_size;
+  std::string min_size_field;
+  if (!GetRustViewFields(&fields, &min_size, &min_size_field)) {
+    return;
+  }
+  auto lineage = GetAncestors();
+  lineage.push_back(this);
+
+  const SizeField* payload_size_field = nullptr;
+  Size payload_offset;
+  if (fields_.HasPayload()) {
+    auto payload = static_cast<const PayloadField*>(fields_.GetFieldsWithTypes({PayloadField::kFieldType})[0]);
+    payload_offset = GetOffsetForField(payload->GetName(), false);
+    payload_size_field = payload->size_field_;
+    if (payload_size_field != nullptr) {
+      auto size_offset = GetOffsetForField(payload_size_field->GetName(), false);
+      if (size_offset.empty() || size_offset.has_dynamic()) {
+        payload_offset = Size();
+      }
+    }
+  }
+  bool has_payload = !payload_offset.empty() && !payload_offset.has_dynamic();
+
+  s << "#[derive(Debug, Clone, Copy)] ";
+  s << "pub struct " << name_ << "View<'a> { bytes: &'a [u8], }\n";
+
+  s << "impl<'a> " << name_ << "View<'a> {";
+
+  // Only what the accessors rely on is checked, the other fields are left
+  // for the owned packet to parse
+  s << "pub fn new(bytes: &'a [u8]) -> Result<Self> {";
+  if (min_size.bytes() > 0) {
+    s << "if bytes.len() < " << min_size.bytes() << " {";
+    s << " return Err(Error::InvalidLengthError{";
+    s << "    obj: \"" << name_ << "View\".to_string(),";
+    s << "    field: \"" << min_size_field << "\".to_string(),";
+    s << "    wanted: " << min_size.bytes() << ",";
+    s << "    got: bytes.len()});";
+    s << "}";
+  }
+  for (auto it = lineage.begin() + 1; it != lineage.end(); it++) {
+    s << "if !" << (*it)->name_ << "Data::conforms(bytes) { return Err(Error::InvalidPacketError); }";
+  }
+  for (const auto& field : fields) {
+    const auto* scalar = static_cast<const ScalarField*>(field.second);
+    if (scalar->GetRustParseDataType() == scalar->GetRustDataType()) {
+      continue;
+    }
+    s << "{";
+    scalar->GenRustRawGetter(s, field.first->GetOffsetForField(scalar->GetName(), false),
+                             field.first->GetOffsetForField(scalar->GetName(), true));
+    s << "if " << scalar->GetRustDataType() << "::from_" << scalar->GetRustParseDataType() << "(" << scalar->GetName()
+      << ").is_none() {";
+    s << " return Err(Error::ConstraintOutOfBounds{field: \"" << scalar->GetName() << "\".to_string(), value: "
+      << scalar->GetName() << " as u64});";
+    s << "}";
+    s << "}";
+  }
+  s << "let view = Self { bytes };";
+  for (const auto& constraint : GetAllConstraints()) {
+    auto field = std::find_if(fields.begin(), fields.end(), [&constraint](const auto& f) {
+                   return f.second->GetName() == constraint.first;
+                 })->second;
+    s << "if view.get_" << field->GetName() << "() != ";
+    if (field->GetFieldType() == ScalarField::kFieldType) {
+      s << std::get<int64_t>(constraint.second);
+    } else {
+      auto value = std::get<std::string>(constraint.second);
+      auto constant = value.substr(value.find("::") + 2, std::string::npos);
+      s << field->GetDataType() << "::" << util::ConstantCaseToCamelCase(constant);
+    }
+    s << " { return Err(Error::InvalidPacketError); }";
+  }
+  if (has_payload && payload_size_field != nullptr) {
+    s << "{ let bytes = view.bytes;";
+    payload_size_field->GenRustGetter(s, GetOffsetForField(payload_size_field->GetName(), false),
+                                      GetOffsetForField(payload_size_field->GetName(), true));
+    s << "let wanted = " << payload_offset.bytes() << " + " << payload_size_field->GetName() << " as usize;";
+    s << "if bytes.len() < wanted {";
+    s << " return Err(Error::InvalidLengthError{";
+    s << "    obj: \"" << name_ << "View\".to_string(),";
+    s << "    field: \"payload\".to_string(),";
+    s << "    wanted,";
+    s << "    got: bytes.len()});";
+    s << "}";
+    s << "}";
+  }
+  s << "Ok(view)";
+  s << "}\n";
+
+  s << "pub fn bytes(&self) -> &'a [u8] { self.bytes }\n";
+
+  for (const auto& field : fields) {
+    s << "pub fn get_" << field.second->GetName() << "(&self) -> " << field.second->GetRustDataType() << " {";
+    s << "let bytes = self.bytes;";
+    field.second->GenRustGetter(s, field.first->GetOffsetForField(field.second->GetName(), false),
+                                field.first->GetOffsetForField(field.second->GetName(), true));
+    s << field.second->GetName();
+    s << "}\n";
+  }
+
+  if (has_payload) {
+    s << "pub fn get_payload(&self) -> &'a [u8] {";
+    s << "let bytes = self.bytes;";
+    if (payload_size_field == nullptr) {
+      s << "&bytes[" << payload_offset.bytes() << "..]";
+    } else {
+      payload_size_field->GenRustGetter(s, GetOffsetForField(payload_size_field->GetName(), false),
+                                        GetOffsetForField(payload_size_field->GetName(), true));
+      s << "&bytes[" << payload_offset.bytes() << ".." << payload_offset.bytes() << " + "
+        << payload_size_field->GetName() << " as usize]";
+    }
+    s << "}\n";
+  }
+  s << "}\n";
+}
+
 void PacketDef::GenRustDef(std::ostream& s) const {
   GenRustChildEnums(s);
   GenRustStructDeclarations(s);
   GenRustStructImpls(s);
   GenRustAccessStructImpls(s);
   GenRustBuilderStructImpls(s);
+  GenRustViewStructImpls(s);
   GenRustBuilderTest(s);
 }
@@ -81,5 +81,13 @@ class PacketDef : public ParentDef {
 
   void GenRustBuilderTest(std::ostream& s) const;
 
+  // Get the scalar and enum fields of the lineage that a borrowed view reads
+  // lazily, and the number of bytes the view needs before any access.
+  // Returns false if the view can't check the constraints of the lineage.
+  bool GetRustViewFields(std::vector<std::pair<const ParentDef*, const PacketField*>>* fields, Size* min_size,
+                         std::string* min_size_field) const;
+
+  void GenRustViewStructImpls(std::ostream& s) const;
+
   void GenRustDef(std::ostream& s) const;
 };
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/scatter_inserter.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace packet {
+
+ScatterInserter::ScatterInserter(std::vector<uint8_t>& vector) : BitInserter(vector), vector_(vector) {
+  copied_up_to_ = vector_.size();
+}
+
+void ScatterInserter::insert_bytes(const uint8_t* data, size_t size) {
+  // Observers (e.g. checksums) and unaligned bits need the bytes copied by BitInserter
+  if (size < kMinReferencedSize || num_saved_bits_ != 0 || has_observers()) {
+    BitInserter::insert_bytes(data, size);
+    return;
+  }
+  if (vector_.size() > copied_up_to_) {
+    segments_.push_back({nullptr, copied_up_to_, vector_.size() - copied_up_to_});
+    copied_up_to_ = vector_.size();
+  }
+  segments_.push_back({data, 0, size});
+}
+
+std::vector<iovec> ScatterInserter::GetSlices() const {
+  ASSERT(num_saved_bits_ == 0);
+  std::vector<iovec> slices;
+  slices.reserve(segments_.size() + 1);
+  for (const auto& segment : segments_) {
+    const uint8_t* base = segment.data != nullptr ? segment.data : vector_.data() + segment.offset;
+    slices.push_back({const_cast<uint8_t*>(base), segment.size});
+  }
+  if (vector_.size() > copied_up_to_) {
+    slices.push_back({vector_.data() + copied_up_to_, vector_.size() - copied_up_to_});
+  }
+  return slices;
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "packet/bit_inserter.h"
+
+namespace bluetooth {
+namespace packet {
+
+// Serializes a packet as a list of byte ranges instead of one contiguous buffer.
+// Headers and other fields are written to the given vector, while large byte runs (e.g. RawBuilder payloads) are
+// referenced where they are. The slices are only valid while the builder that was serialized is alive.
+class ScatterInserter : public BitInserter {
+ public:
+  // Byte runs shorter than this are copied, since an extra slice costs more than copying them
+  static constexpr size_t kMinReferencedSize = 32;
+
+  explicit ScatterInserter(std::vector<uint8_t>& vector);
+
+  void insert_bytes(const uint8_t* data, size_t size) override;
+
+  // Return the serialized packet in order. Do not insert more bytes once this has been called.
+  std::vector<iovec> GetSlices() const;
+
+ private:
+  struct Segment {
+    // nullptr for a range of the vector, starting at offset
+    const uint8_t* data;
+    size_t offset;
+    size_t size;
+  };
+
+  std::vector<uint8_t>& vector_;
+  std::vector<Segment> segments_;
+  size_t copied_up_to_{0};
+};
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/scatter_inserter.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "packet/raw_builder.h"
+
+using std::vector;
+
+namespace {
+vector<uint8_t> flatten(const vector<iovec>& slices) {
+  vector<uint8_t> bytes;
+  for (const auto& slice : slices) {
+    auto base = static_cast<const uint8_t*>(slice.iov_base);
+    bytes.insert(bytes.end(), base, base + slice.iov_len);
+  }
+  return bytes;
+}
+
+vector<uint8_t> payload(size_t size) {
+  vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8_t>(i);
+  }
+  return bytes;
+}
+}  // namespace
+
+namespace bluetooth {
+namespace packet {
+
+TEST(ScatterInserterTest, largePayloadIsReferenced) {
+  RawBuilder builder(payload(100));
+  vector<uint8_t> header{0xaa, 0xbb};
+  ScatterInserter it(header);
+  it.insert_byte(0xcc);
+  builder.Serialize(it);
+  it.insert_byte(0xdd);
+
+  auto slices = it.GetSlices();
+  ASSERT_EQ(slices.size(), 3u);
+  ASSERT_EQ(slices[0].iov_len, 1u);
+  ASSERT_EQ(slices[1].iov_len, 100u);
+  ASSERT_EQ(slices[2].iov_len, 1u);
+  // The 2 bytes already in the vector are not part of this packet
+  ASSERT_EQ(header.size(), 4u);
+
+  vector<uint8_t> expected{0xcc};
+  auto bytes = payload(100);
+  expected.insert(expected.end(), bytes.begin(), bytes.end());
+  expected.push_back(0xdd);
+  ASSERT_EQ(flatten(slices), expected);
+}
+
+TEST(ScatterInserterTest, smallPayloadIsCopied) {
+  RawBuilder builder(payload(ScatterInserter::kMinReferencedSize - 1));
+  vector<uint8_t> bytes;
+  ScatterInserter it(bytes);
+  it.insert_byte(0x01);
+  builder.Serialize(it);
+
+  auto slices = it.GetSlices();
+  ASSERT_EQ(slices.size(), 1u);
+  ASSERT_EQ(bytes.size(), ScatterInserter::kMinReferencedSize);
+  ASSERT_EQ(flatten(slices), bytes);
+}
+
+TEST(ScatterInserterTest, unalignedPayloadIsCopied) {
+  RawBuilder builder(payload(64));
+  vector<uint8_t> bytes;
+  ScatterInserter it(bytes);
+  it.insert_bits(0x1, 4);
+  builder.Serialize(it);
+  it.insert_bits(0x2, 4);
+
+  auto slices = it.GetSlices();
+  ASSERT_EQ(slices.size(), 1u);
+  ASSERT_EQ(bytes.size(), 65u);
+}
+
+TEST(ScatterInserterTest, consecutivePayloads) {
+  RawBuilder first(payload(40));
+  RawBuilder second(payload(50));
+  vector<uint8_t> bytes;
+  ScatterInserter it(bytes);
+  first.Serialize(it);
+  second.Serialize(it);
+
+  auto slices = it.GetSlices();
+  ASSERT_EQ(slices.size(), 2u);
+  ASSERT_TRUE(bytes.empty());
+  ASSERT_EQ(flatten(slices).size(), 90u);
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/slice_builder.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace packet {
+
+SliceBuilder::SliceBuilder(std::shared_ptr<const std::vector<uint8_t>> buffer, size_t offset, size_t size)
+    : buffer_(std::move(buffer)), offset_(offset), size_(size) {
+  ASSERT(buffer_ != nullptr);
+  ASSERT(offset_ + size_ <= buffer_->size());
+}
+
+size_t SliceBuilder::size() const {
+  return size_;
+}
+
+void SliceBuilder::Serialize(BitInserter& it) const {
+  it.insert_bytes(buffer_->data() + offset_, size_);
+}
+
+std::vector<std::unique_ptr<SliceBuilder>> SliceBuilder::Fragment(const BasePacketBuilder& packet, size_t mtu) {
+  ASSERT(mtu > 0);
+  auto buffer = std::make_shared<const std::vector<uint8_t>>(packet.SerializeToBytes());
+  std::vector<std::unique_ptr<SliceBuilder>> slices;
+  slices.reserve((buffer->size() + mtu - 1) / mtu);
+  for (size_t offset = 0; offset < buffer->size(); offset += mtu) {
+    slices.push_back(std::make_unique<SliceBuilder>(buffer, offset, std::min(mtu, buffer->size() - offset)));
+  }
+  return slices;
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "packet/base_packet_builder.h"
+#include "packet/bit_inserter.h"
+
+namespace bluetooth {
+namespace packet {
+
+// A range of a buffer shared with other slices, used to segment a packet without copying each segment.
+// The segments of a packet serialized once by Fragment() keep its buffer alive, and serializing them through a
+// ScatterInserter references the buffer instead of copying it again.
+class SliceBuilder : public BasePacketBuilder {
+ public:
+  SliceBuilder(std::shared_ptr<const std::vector<uint8_t>> buffer, size_t offset, size_t size);
+  virtual ~SliceBuilder() = default;
+
+  size_t size() const override;
+
+  void Serialize(BitInserter& it) const override;
+
+  // Serialize |packet| once and return it as consecutive slices of |mtu| bytes, the last one may be shorter.
+  // An empty packet gives no slice.
+  static std::vector<std::unique_ptr<SliceBuilder>> Fragment(const BasePacketBuilder& packet, size_t mtu);
+
+ private:
+  std::shared_ptr<const std::vector<uint8_t>> buffer_;
+  size_t offset_;
+  size_t size_;
+};
+
+}  // namespace packet
+}  // namespace bluetooth
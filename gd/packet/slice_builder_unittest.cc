@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "packet/slice_builder.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "packet/raw_builder.h"
+#include "packet/scatter_inserter.h"
+
+using std::vector;
+
+namespace {
+vector<uint8_t> payload(size_t size) {
+  vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8_t>(i);
+  }
+  return bytes;
+}
+}  // namespace
+
+namespace bluetooth {
+namespace packet {
+
+TEST(SliceBuilderTest, fragmentSlicesThePacketInOrder) {
+  RawBuilder builder(payload(250));
+  auto slices = SliceBuilder::Fragment(builder, 100);
+
+  ASSERT_EQ(slices.size(), 3u);
+  ASSERT_EQ(slices[0]->size(), 100u);
+  ASSERT_EQ(slices[1]->size(), 100u);
+  ASSERT_EQ(slices[2]->size(), 50u);
+
+  vector<uint8_t> bytes;
+  for (const auto& slice : slices) {
+    auto slice_bytes = slice->SerializeToBytes();
+    bytes.insert(bytes.end(), slice_bytes.begin(), slice_bytes.end());
+  }
+  ASSERT_EQ(bytes, payload(250));
+}
+
+TEST(SliceBuilderTest, fragmentExactMultipleAndEmptyPacket) {
+  RawBuilder builder(payload(200));
+  ASSERT_EQ(SliceBuilder::Fragment(builder, 100).size(), 2u);
+
+  RawBuilder empty;
+  ASSERT_TRUE(SliceBuilder::Fragment(empty, 100).empty());
+}
+
+TEST(SliceBuilderTest, slicesShareOneBufferAndAreReferenced) {
+  RawBuilder builder(payload(200));
+  auto slices = SliceBuilder::Fragment(builder, 100);
+  ASSERT_EQ(slices.size(), 2u);
+
+  vector<uint8_t> first_bytes;
+  ScatterInserter first(first_bytes);
+  slices[0]->Serialize(first);
+  vector<uint8_t> second_bytes;
+  ScatterInserter second(second_bytes);
+  slices[1]->Serialize(second);
+
+  // Nothing is copied, both slices point into the same serialized packet
+  ASSERT_TRUE(first_bytes.empty());
+  ASSERT_TRUE(second_bytes.empty());
+  auto first_slices = first.GetSlices();
+  auto second_slices = second.GetSlices();
+  ASSERT_EQ(first_slices.size(), 1u);
+  ASSERT_EQ(second_slices.size(), 1u);
+  ASSERT_EQ(static_cast<uint8_t*>(first_slices[0].iov_base) + 100, second_slices[0].iov_base);
+
+  // The buffer outlives the other slices
+  slices.erase(slices.begin());
+  auto bytes = payload(200);
+  ASSERT_EQ(slices[0]->SerializeToBytes(), vector<uint8_t>(bytes.begin() + 100, bytes.end()));
+}
+
+}  // namespace packet
+}  // namespace bluetooth
@@ -22,8 +22,11 @@ namespace bluetooth {
 namespace packet {
 
 View::View(std::shared_ptr<const std::vector<uint8_t>> data, size_t begin, size_t end)
-    : data_(data), begin_(begin < data_->size() ? begin : data_->size()),
-      end_(end < data_->size() ? end : data_->size()) {}
+    : data_(data, data->data()), begin_(begin < data->size() ? begin : data->size()),
+      end_(end < data->size() ? end : data->size()) {}
+
+View::View(std::shared_ptr<const uint8_t> data, size_t data_size, size_t begin, size_t end)
+    : data_(std::move(data)), begin_(begin < data_size ? begin : data_size), end_(end < data_size ? end : data_size) {}
 
 View::View(const View& view, size_t begin, size_t end) : data_(view.data_) {
   begin_ = (begin < view.size() ? begin : view.size());
@@ -34,11 +37,24 @@ View::View(const View& view, size_t begin, size_t end) : data_(view.data_) {
 
 uint8_t View::operator[](size_t i) const {
   ASSERT_LOG(i + begin_ < end_, "Out of bounds access at %zu", i);
-  return data_->operator[](i + begin_);
+  return data_.get()[i + begin_];
 }
 
 size_t View::size() const {
   return end_ - begin_;
 }
+
+const uint8_t* View::data() const {
+  return data_.get() + begin_;
+}
+
+const std::shared_ptr<const uint8_t>& View::GetStorage() const {
+  return data_;
+}
+
+size_t View::GetStorageOffset() const {
+  return begin_;
+}
+
 }  // namespace packet
 }  // namespace bluetooth
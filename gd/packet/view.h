@@ -27,6 +27,8 @@ namespace packet {
 class View {
  public:
   View(std::shared_ptr<const std::vector<uint8_t>> data, size_t begin, size_t end);
+  // Share storage that is not owned by a vector, e.g. a receive buffer handed over by the HAL.
+  View(std::shared_ptr<const uint8_t> data, size_t data_size, size_t begin, size_t end);
   View(const View& view, size_t begin, size_t end);
   View(const View& view) = default;
   virtual ~View() = default;
@@ -35,8 +37,15 @@ class View {
 
   size_t size() const;
 
+  // Pointer to the first byte of this view
+  const uint8_t* data() const;
+
+  // The whole buffer this view points into, and the offset of the view within it
+  const std::shared_ptr<const uint8_t>& GetStorage() const;
+  size_t GetStorageOffset() const;
+
  private:
-  std::shared_ptr<const std::vector<uint8_t>> data_;
+  std::shared_ptr<const uint8_t> data_;
   size_t begin_;
   size_t end_;
 };
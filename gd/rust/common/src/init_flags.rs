@@ -86,7 +86,12 @@ init_flags!(
         gatt_robust_caching,
         btaa_hci,
         gd_rust,
-        gd_link_policy
+        gd_link_policy,
+        gd_hci_command_pipelining,
+        gd_acl_fair_scheduler,
+        gd_parallel_module_start,
+        gd_reactor_busy_poll,
+        gd_radio_scheduler
     },
     dependencies: {
         gd_core => gd_security,
@@ -96,7 +101,9 @@ init_flags!(
         gd_advertising => gd_acl,
         gd_acl => gd_controller,
         gd_controller => gd_hci,
-        gd_link_policy => gd_acl
+        gd_link_policy => gd_acl,
+        gd_radio_scheduler => gd_core,
+        gd_radio_scheduler => gd_scanning
     }
 );
 
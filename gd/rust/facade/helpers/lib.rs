@@ -15,6 +15,15 @@ pub trait U8SliceRunnable {
     fn run(&self, data: &[u8]);
 }
 
+/// Sink that packets are serialized straight into, so that they cross the shim
+/// boundary without a copy
+pub trait U8BufferSink {
+    /// Buffer of exactly |len| bytes to serialize the next packet into
+    fn alloc(&mut self, len: usize) -> &mut [u8];
+    /// Hand over the packet serialized into the last buffer
+    fn deliver(&mut self);
+}
+
 /// Helper for interfacing channels with shim or gRPC boundaries
 #[derive(Clone)]
 pub struct RxAdapter<T> {
@@ -66,4 +75,22 @@ impl<T: 'static + Packet + Send> RxAdapter<T> {
             }
         });
     }
+
+    /// Stream out the channel into the provided shim sink
+    pub fn stream_sink<S: 'static + U8BufferSink + Send>(
+        &mut self,
+        rt: &Arc<Runtime>,
+        mut sink: S,
+    ) {
+        assert!(!self.running);
+        self.running = true;
+
+        let clone_rx = self.rx.clone();
+        rt.spawn(async move {
+            while let Some(payload) = clone_rx.lock().await.recv().await {
+                payload.write_into(sink.alloc(payload.total_size()));
+                sink.deliver();
+            }
+        });
+    }
 }
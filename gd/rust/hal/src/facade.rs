@@ -50,7 +50,7 @@ impl HciHalFacade for HciHalFacadeService {
     fn send_command(&mut self, ctx: RpcContext<'_>, mut data: Data, sink: UnarySink<Empty>) {
         let cmd_tx = self.control.tx.clone();
         ctx.spawn(async move {
-            cmd_tx.send(CommandPacket::parse(&data.take_payload()).unwrap()).await.unwrap();
+            cmd_tx.send(CommandPacket::parse_bytes(data.take_payload().into()).unwrap()).await.unwrap();
             sink.success(Empty::default()).await.unwrap();
         });
     }
@@ -58,7 +58,7 @@ impl HciHalFacade for HciHalFacadeService {
     fn send_acl(&mut self, ctx: RpcContext<'_>, mut data: Data, sink: UnarySink<Empty>) {
         let acl_tx = self.acl.tx.clone();
         ctx.spawn(async move {
-            acl_tx.send(AclPacket::parse(&data.take_payload()).unwrap()).await.unwrap();
+            acl_tx.send(AclPacket::parse_bytes(data.take_payload().into()).unwrap()).await.unwrap();
             sink.success(Empty::default()).await.unwrap();
         });
     }
@@ -70,7 +70,7 @@ impl HciHalFacade for HciHalFacadeService {
     fn send_iso(&mut self, ctx: RpcContext<'_>, mut data: Data, sink: UnarySink<Empty>) {
         let iso_tx = self.iso.tx.clone();
         ctx.spawn(async move {
-            iso_tx.send(IsoPacket::parse(&data.take_payload()).unwrap()).await.unwrap();
+            iso_tx.send(IsoPacket::parse_bytes(data.take_payload().into()).unwrap()).await.unwrap();
             sink.success(Empty::default()).await.unwrap();
         });
     }
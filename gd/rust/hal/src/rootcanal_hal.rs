@@ -94,7 +94,7 @@ where
             reader.read_exact(&mut payload).await?;
             buffer.unsplit(payload);
             let frozen = buffer.freeze();
-            match EventPacket::parse(&frozen) {
+            match EventPacket::parse_bytes(frozen.clone()) {
                 Ok(p) => evt_tx.send(p).unwrap(),
                 Err(e) => log::error!("dropping invalid event packet: {}: {:02x}", e, frozen),
             }
@@ -107,7 +107,7 @@ where
             reader.read_exact(&mut payload).await?;
             buffer.unsplit(payload);
             let frozen = buffer.freeze();
-            match AclPacket::parse(&frozen) {
+            match AclPacket::parse_bytes(frozen.clone()) {
                 Ok(p) => acl_tx.send(p).unwrap(),
                 Err(e) => log::error!("dropping invalid ACL packet: {}: {:02x}", e, frozen),
             }
@@ -120,7 +120,7 @@ where
             reader.read_exact(&mut payload).await?;
             buffer.unsplit(payload);
             let frozen = buffer.freeze();
-            match IsoPacket::parse(&frozen) {
+            match IsoPacket::parse_bytes(frozen.clone()) {
                 Ok(p) => iso_tx.send(p).unwrap(),
                 Err(e) => log::error!("dropping invalid ISO packet: {}: {:02x}", e, frozen),
             }
@@ -4,17 +4,22 @@ use crate::internal::RawHal;
 use bt_common::sys_prop;
 use bt_packets::hci::{AclPacket, CommandPacket, EventPacket, IsoPacket, Packet};
 use bytes::{BufMut, Bytes, BytesMut};
+use flate2::read::DeflateDecoder;
+use flate2::write::DeflateEncoder;
+use flate2::Compression;
 use gddi::{module, part_out, provides, Stoppable};
-use log::error;
+use log::{error, warn};
+use std::collections::VecDeque;
 use std::convert::TryFrom;
+use std::io::{Read, Write};
 use std::sync::Arc;
 use std::time::SystemTime;
 use tokio::fs::{remove_file, rename, File};
 use tokio::io::AsyncWriteExt;
 use tokio::runtime::Runtime;
 use tokio::select;
-use tokio::sync::mpsc::{channel, Receiver, Sender, UnboundedReceiver};
-use tokio::sync::Mutex;
+use tokio::sync::mpsc::{channel, error::TrySendError, Receiver, Sender, UnboundedReceiver};
+use tokio::sync::{oneshot, Mutex};
 
 #[part_out]
 #[derive(Clone, Stoppable)]
@@ -22,6 +27,7 @@ struct Hal {
     control: ControlHal,
     acl: AclHal,
     iso: IsoHal,
+    snoop: SnoopControl,
 }
 
 /// Command & event tx/rx
@@ -51,6 +57,23 @@ pub struct IsoHal {
     pub rx: Arc<Mutex<Receiver<IsoPacket>>>,
 }
 
+/// Access to the snoop writer
+#[derive(Clone, Stoppable)]
+pub struct SnoopControl {
+    snooz_requests: Sender<oneshot::Sender<Vec<u8>>>,
+}
+
+impl SnoopControl {
+    /// Returns the in-memory snooz history as a btsnoop file
+    pub async fn snooz_history(&self) -> Vec<u8> {
+        let (tx, rx) = oneshot::channel();
+        if self.snooz_requests.send(tx).await.is_err() {
+            return Vec::new();
+        }
+        rx.await.unwrap_or_default()
+    }
+}
+
 /// The different modes snoop logging can be in
 #[derive(Clone)]
 pub enum SnoopMode {
@@ -62,6 +85,15 @@ pub enum SnoopMode {
     Full,
 }
 
+impl SnoopMode {
+    fn file_suffix(&self) -> &'static str {
+        match self {
+            SnoopMode::Filtered => ".filtered",
+            _ => "",
+        }
+    }
+}
+
 /// There was an error parsing the mode from a string
 pub struct SnoopModeParseError;
 
@@ -137,9 +169,12 @@ async fn provide_snooped_hal(config: SnoopConfig, raw_hal: RawHal, rt: Arc<Runti
     let (acl_up_tx, acl_up_rx) = channel::<AclPacket>(10);
     let (iso_down_tx, mut iso_down_rx) = channel::<IsoPacket>(10);
     let (iso_up_tx, iso_up_rx) = channel::<IsoPacket>(10);
+    let (record_tx, record_rx) = channel::<Record>(RECORD_QUEUE_SIZE);
+    let (snooz_tx, snooz_rx) = channel::<oneshot::Sender<Vec<u8>>>(1);
 
+    let mut capture = SnoopCapture::new(config.mode.clone(), record_tx);
+    rt.spawn(run_writer(config, record_rx, snooz_rx));
     rt.spawn(async move {
-        let mut logger = SnoopLogger::new(config).await;
         loop {
             select! {
                 Some(evt) = consume(&raw_hal.evt_rx) => {
@@ -147,42 +182,42 @@ async fn provide_snooped_hal(config: SnoopConfig, raw_hal: RawHal, rt: Arc<Runti
                         error!("evt channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Evt, Direction::Up, evt.to_bytes()).await;
+                    capture.capture(Direction::Up, Captured::Evt(evt));
                 },
                 Some(cmd) = cmd_down_rx.recv() => {
                     if let Err(e) = raw_hal.cmd_tx.send(cmd.clone())  {
                         error!("cmd channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Cmd, Direction::Down, cmd.to_bytes()).await;
+                    capture.capture(Direction::Down, Captured::Cmd(cmd));
                 },
                 Some(acl) = acl_down_rx.recv() => {
                     if let Err(e) = raw_hal.acl_tx.send(acl.clone()) {
                         error!("acl down channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Acl, Direction::Down, acl.to_bytes()).await;
+                    capture.capture(Direction::Down, Captured::Acl(acl));
                 },
                 Some(acl) = consume(&raw_hal.acl_rx) => {
                     if let Err(e) = acl_up_tx.send(acl.clone()).await {
                         error!("acl up channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Acl, Direction::Up, acl.to_bytes()).await;
+                    capture.capture(Direction::Up, Captured::Acl(acl));
                 },
                 Some(iso) = iso_down_rx.recv() => {
                     if let Err(e) = raw_hal.iso_tx.send(iso.clone()) {
                         error!("iso down channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Iso, Direction::Down, iso.to_bytes()).await;
+                    capture.capture(Direction::Down, Captured::Iso(iso));
                 },
                 Some(iso) = consume(&raw_hal.iso_rx) => {
                     if let Err(e) = iso_up_tx.send(iso.clone()).await {
                         error!("iso up channel closed {:?}", e);
                         break;
                     }
-                    logger.log(Type::Iso, Direction::Up, iso.to_bytes()).await;
+                    capture.capture(Direction::Up, Captured::Iso(iso));
                 },
                 else => break,
             }
@@ -193,6 +228,7 @@ async fn provide_snooped_hal(config: SnoopConfig, raw_hal: RawHal, rt: Arc<Runti
         control: ControlHal { tx: cmd_down_tx, rx: Arc::new(Mutex::new(evt_up_rx)) },
         acl: AclHal { tx: acl_down_tx, rx: Arc::new(Mutex::new(acl_up_rx)) },
         iso: IsoHal { tx: iso_down_tx, rx: Arc::new(Mutex::new(iso_up_rx)) },
+        snoop: SnoopControl { snooz_requests: snooz_tx },
     }
 }
 
@@ -201,6 +237,7 @@ async fn consume<T>(rx: &Arc<Mutex<UnboundedReceiver<T>>>) -> Option<T> {
 }
 
 #[allow(unused)]
+#[derive(Clone, Copy, PartialEq)]
 enum Type {
     Cmd = 1,
     Acl,
@@ -209,86 +246,334 @@ enum Type {
     Iso,
 }
 
+#[derive(Clone, Copy)]
 enum Direction {
     Up,
     Down,
 }
 
-struct SnoopLogger {
-    config: SnoopConfig,
-    file: Option<File>,
-    packets: u32,
+/// A captured packet, serialized by the writer rather than on the HAL task
+enum Captured {
+    Cmd(CommandPacket),
+    Evt(EventPacket),
+    Acl(AclPacket),
+    Iso(IsoPacket),
+}
+
+impl Captured {
+    fn packet_type(&self) -> Type {
+        match self {
+            Captured::Cmd(_) => Type::Cmd,
+            Captured::Evt(_) => Type::Evt,
+            Captured::Acl(_) => Type::Acl,
+            Captured::Iso(_) => Type::Iso,
+        }
+    }
+
+    fn to_bytes(self) -> Bytes {
+        match self {
+            Captured::Cmd(p) => p.to_bytes(),
+            Captured::Evt(p) => p.to_bytes(),
+            Captured::Acl(p) => p.to_bytes(),
+            Captured::Iso(p) => p.to_bytes(),
+        }
+    }
+}
+
+/// How much of a packet goes to the log file, decided at capture
+#[derive(Clone, Copy, PartialEq)]
+enum Policy {
+    /// Only kept in the snooz history
+    SnoozOnly,
+    /// Logged with ACL payloads cut down to their headers
+    Sanitized,
+    /// Logged whole
+    Full,
+}
+
+#[derive(Clone, Copy)]
+struct RecordHeader {
+    direction: Direction,
+    timestamp: u64,
+    /// Records dropped at capture so far
+    dropped: u32,
+}
+
+struct Record {
+    packet: Captured,
+    header: RecordHeader,
+    policy: Policy,
 }
 
 // micros since 0000-01-01
 const SNOOP_EPOCH_DELTA: u64 = 0x00dcddb30f2f8000;
 
-impl SnoopLogger {
-    async fn new(mut config: SnoopConfig) -> Self {
-        // filtered snoop is not available at this time
-        if let SnoopMode::Filtered = config.mode {
-            config.mode = SnoopMode::Disabled;
+const BTSNOOP_FILE_HEADER: &[u8] = b"btsnoop\x00\x00\x00\x00\x01\x00\x00\x03\xea";
+const RECORD_HEADER_SIZE: usize = 25;
+
+// Records waiting for the writer. Capture drops records rather than waiting
+// when the writer falls this far behind, and counts them in the next record.
+const RECORD_QUEUE_SIZE: usize = 1024;
+// The writer gathers the records that are ready into writes of about this size
+const WRITE_BATCH_SIZE: usize = 64 * 1024;
+
+// The snooz history keeps at most this much memory, in deflated chunks
+const SNOOZ_MEMORY_BUDGET: usize = 256 * 1024;
+const SNOOZ_CHUNK_SIZE: usize = 16 * 1024;
+const SNOOZ_MAX_PAYLOAD_SIZE: usize = 150 - RECORD_HEADER_SIZE;
+
+const ACL_HEADER_SIZE: usize = 4;
+const L2CAP_HEADER_SIZE: usize = 4;
+const L2CAP_SIGNALING_CID: u16 = 0x0001;
+// Enough for an RFCOMM frame up to the frame check; not enough for a HID
+// report or audio data
+const MAX_SANITIZED_ACL_SIZE: usize = 14;
+
+/// Runs on the HAL task: stamps packets and hands them to the writer without
+/// ever waiting on it
+struct SnoopCapture {
+    mode: SnoopMode,
+    records: Sender<Record>,
+    dropped: u32,
+}
+
+impl SnoopCapture {
+    fn new(mode: SnoopMode, records: Sender<Record>) -> Self {
+        Self { mode, records, dropped: 0 }
+    }
+
+    fn capture(&mut self, direction: Direction, packet: Captured) {
+        let policy = match self.mode {
+            SnoopMode::Disabled => Policy::SnoozOnly,
+            SnoopMode::Filtered => Policy::Sanitized,
+            SnoopMode::Full => Policy::Full,
+        };
+        // Audio data is only ever kept in a full log
+        if policy != Policy::Full && packet.packet_type() == Type::Iso {
+            return;
         }
 
-        remove_file(&config.path).await.ok();
-        remove_file(config.path.clone() + ".last").await.ok();
-        if let SnoopMode::Disabled = config.mode {
-            remove_file(config.path.clone() + ".filtered").await.ok();
-            remove_file(config.path.clone() + ".filtered.last").await.ok();
+        let timestamp = u64::try_from(
+            SystemTime::now().duration_since(SystemTime::UNIX_EPOCH).unwrap().as_micros(),
+        )
+        .unwrap()
+            + SNOOP_EPOCH_DELTA;
+        let header = RecordHeader { direction, timestamp, dropped: self.dropped };
+        let record = Record { packet, header, policy };
+        match self.records.try_send(record) {
+            Ok(()) => {}
+            Err(TrySendError::Full(_)) => self.dropped = self.dropped.wrapping_add(1),
+            Err(TrySendError::Closed(_)) => {}
         }
+    }
+}
 
-        let mut ret = Self { config, file: None, packets: 0 };
-        ret.open_next_file().await;
+/// Number of bytes of an ACL packet that are kept when it is sanitized
+fn sanitized_acl_length(bytes: &[u8]) -> usize {
+    let headers_size = ACL_HEADER_SIZE + L2CAP_HEADER_SIZE;
+    if bytes.len() <= headers_size {
+        return bytes.len();
+    }
+    let cid = u16::from_le_bytes([bytes[ACL_HEADER_SIZE + 2], bytes[ACL_HEADER_SIZE + 3]]);
+    if cid == L2CAP_SIGNALING_CID {
+        // Keep the whole signaling packet, so that the PSM setup is captured
+        bytes.len()
+    } else {
+        bytes.len().min(MAX_SANITIZED_ACL_SIZE)
+    }
+}
 
-        ret
+fn put_record(
+    buffer: &mut BytesMut,
+    t: Type,
+    header: &RecordHeader,
+    bytes: &[u8],
+    included_length: usize,
+) {
+    let mut flags = 0;
+    if let Direction::Up = header.direction {
+        flags |= 0b01;
+    }
+    if let Type::Cmd | Type::Evt = t {
+        flags |= 0b10;
+    }
+
+    // Add one for the type byte
+    buffer.put_u32(u32::try_from(bytes.len()).unwrap() + 1); // original length
+    buffer.put_u32(u32::try_from(included_length).unwrap() + 1); // captured length
+    buffer.put_u32(flags); // flags
+    buffer.put_u32(header.dropped); // dropped packets
+    buffer.put_u64(header.timestamp); // timestamp
+    buffer.put_u8(t as u8); // type
+    buffer.put_slice(&bytes[..included_length]);
+}
+
+/// In-memory history of snooz records, kept deflated so that more of it fits
+/// in the same memory. Each chunk is deflated on its own, so that the oldest
+/// can be dropped without touching the others.
+struct SnoozRing {
+    chunks: VecDeque<Vec<u8>>,
+    chunk_bytes: usize,
+    open_chunk: BytesMut,
+}
+
+impl SnoozRing {
+    fn new() -> Self {
+        Self {
+            chunks: VecDeque::new(),
+            chunk_bytes: 0,
+            open_chunk: BytesMut::with_capacity(SNOOZ_CHUNK_SIZE),
+        }
+    }
+
+    fn push(&mut self, t: Type, header: &RecordHeader, bytes: &[u8]) {
+        let included_length = match t {
+            Type::Cmd | Type::Evt => bytes.len(),
+            Type::Acl => sanitized_acl_length(bytes),
+            _ => return,
+        }
+        .min(SNOOZ_MAX_PAYLOAD_SIZE);
+        put_record(&mut self.open_chunk, t, header, bytes, included_length);
+        if self.open_chunk.len() >= SNOOZ_CHUNK_SIZE {
+            self.close_chunk();
+        }
     }
 
-    async fn log(&mut self, t: Type, dir: Direction, bytes: Bytes) {
-        if let SnoopMode::Disabled = self.config.mode {
+    fn close_chunk(&mut self) {
+        let mut encoder = DeflateEncoder::new(Vec::new(), Compression::fast());
+        if encoder.write_all(&self.open_chunk).is_err() {
+            error!("Failed to deflate snooz chunk");
             return;
         }
+        self.open_chunk.clear();
+        let chunk = match encoder.finish() {
+            Ok(chunk) => chunk,
+            Err(e) => {
+                error!("Failed to deflate snooz chunk {:?}", e);
+                return;
+            }
+        };
+        self.chunk_bytes += chunk.len();
+        self.chunks.push_back(chunk);
+        while self.chunk_bytes + SNOOZ_CHUNK_SIZE > SNOOZ_MEMORY_BUDGET {
+            match self.chunks.pop_front() {
+                Some(oldest) => self.chunk_bytes -= oldest.len(),
+                None => break,
+            }
+        }
+    }
 
-        let mut flags = 0;
-        if let Direction::Up = dir {
-            flags |= 0b01;
+    /// The history as a btsnoop file, oldest record first
+    fn to_btsnoop(&self) -> Vec<u8> {
+        let mut file = BTSNOOP_FILE_HEADER.to_vec();
+        for chunk in &self.chunks {
+            if DeflateDecoder::new(&chunk[..]).read_to_end(&mut file).is_err() {
+                error!("Failed to inflate snooz chunk");
+            }
         }
-        if let Type::Cmd | Type::Evt = t {
-            flags |= 0b10;
+        file.extend_from_slice(&self.open_chunk);
+        file
+    }
+}
+
+async fn run_writer(
+    config: SnoopConfig,
+    mut records: Receiver<Record>,
+    mut snooz_requests: Receiver<oneshot::Sender<Vec<u8>>>,
+) {
+    let mut writer = SnoopWriter::new(config).await;
+    loop {
+        select! {
+            Some(record) = records.recv() => {
+                writer.add(record).await;
+                // Gather whatever else is ready into the same write
+                while writer.batch.len() < WRITE_BATCH_SIZE {
+                    match records.try_recv() {
+                        Ok(record) => writer.add(record).await,
+                        Err(_) => break,
+                    }
+                }
+                writer.write_batch().await;
+            },
+            Some(reply) = snooz_requests.recv() => {
+                reply.send(writer.snooz.to_btsnoop()).ok();
+            },
+            else => break,
         }
+    }
+    writer.write_batch().await;
+}
 
-        let timestamp: u64 = u64::try_from(
-            SystemTime::now().duration_since(SystemTime::UNIX_EPOCH).unwrap().as_micros(),
-        )
-        .unwrap()
-            + SNOOP_EPOCH_DELTA;
+/// Runs on its own task: serializes records into the log file and the snooz
+/// history
+struct SnoopWriter {
+    config: SnoopConfig,
+    path: String,
+    file: Option<File>,
+    packets: u32,
+    batch: BytesMut,
+    snooz: SnoozRing,
+}
+
+impl SnoopWriter {
+    async fn new(config: SnoopConfig) -> Self {
+        remove_file(&config.path).await.ok();
+        remove_file(config.path.clone() + ".last").await.ok();
+        if let SnoopMode::Disabled = config.mode {
+            remove_file(config.path.clone() + ".filtered").await.ok();
+            remove_file(config.path.clone() + ".filtered.last").await.ok();
+        }
+
+        let path = config.path.clone() + config.mode.file_suffix();
+        let mut ret = Self {
+            config,
+            path,
+            file: None,
+            packets: 0,
+            batch: BytesMut::with_capacity(WRITE_BATCH_SIZE),
+            snooz: SnoozRing::new(),
+        };
+        if !matches!(ret.config.mode, SnoopMode::Disabled) {
+            ret.open_next_file().await;
+        }
 
-        // Add one for the type byte
-        let length = u32::try_from(bytes.len()).unwrap() + 1;
+        ret
+    }
+
+    async fn add(&mut self, record: Record) {
+        let t = record.packet.packet_type();
+        let bytes = record.packet.to_bytes();
+        self.snooz.push(t, &record.header, &bytes);
 
-        let mut buffer = BytesMut::new();
-        buffer.put_u32(length); // original length
-        buffer.put_u32(length); // captured length
-        buffer.put_u32(flags); // flags
-        buffer.put_u32(0); // dropped packets
-        buffer.put_u64(timestamp); // timestamp
-        buffer.put_u8(t as u8); // type
-        buffer.put(bytes);
+        let included_length = match (record.policy, t) {
+            (Policy::SnoozOnly, _) => return,
+            (Policy::Sanitized, Type::Acl) => sanitized_acl_length(&bytes),
+            _ => bytes.len(),
+        };
 
         self.packets += 1;
         if self.packets > self.config.max_packets_per_file {
+            self.write_batch().await;
             self.open_next_file().await;
         }
+        put_record(&mut self.batch, t, &record.header, &bytes, included_length);
+    }
 
+    async fn write_batch(&mut self) {
+        if self.batch.is_empty() {
+            return;
+        }
         if let Some(file) = &mut self.file {
-            if file.write_all(&buffer).await.is_err() {
+            if file.write_all(&self.batch).await.is_err() {
                 error!("Failed to write");
             }
             if file.flush().await.is_err() {
                 error!("Failed to flush");
             }
         } else {
-            panic!("Logging without a backing file");
+            warn!("Dropping snoop records without a backing file");
         }
+        self.batch.clear();
     }
 
     async fn close_file(&mut self) {
@@ -302,11 +587,9 @@ impl SnoopLogger {
     async fn open_next_file(&mut self) {
         self.close_file().await;
 
-        rename(&self.config.path, self.config.path.clone() + ".last").await.ok();
-        let mut file = File::create(&self.config.path).await.expect("could not open snoop log");
-        file.write_all(b"btsnoop\x00\x00\x00\x00\x01\x00\x00\x03\xea")
-            .await
-            .expect("could not write snoop header");
+        rename(&self.path, self.path.clone() + ".last").await.ok();
+        let mut file = File::create(&self.path).await.expect("could not open snoop log");
+        file.write_all(BTSNOOP_FILE_HEADER).await.expect("could not write snoop header");
         if file.flush().await.is_err() {
             error!("Failed to flush");
         }
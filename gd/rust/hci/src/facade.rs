@@ -85,7 +85,7 @@ impl GrpcFacade for HciFacadeService {
 
 impl HciFacade for HciFacadeService {
     fn send_command(&mut self, ctx: RpcContext<'_>, mut data: Data, sink: UnarySink<Empty>) {
-        let packet = CommandPacket::parse(&data.take_payload()).unwrap();
+        let packet = CommandPacket::parse_bytes(data.take_payload().into()).unwrap();
         let mut commands = self.commands.clone();
         let evt_tx = self.evt_tx.clone();
         ctx.spawn(async move {
@@ -119,7 +119,7 @@ impl HciFacade for HciFacadeService {
     fn send_acl(&mut self, ctx: RpcContext<'_>, mut packet: Data, sink: UnarySink<Empty>) {
         let acl_tx = self.acl_tx.clone();
         ctx.spawn(async move {
-            acl_tx.send(AclPacket::parse(&packet.take_payload()).unwrap()).await.unwrap();
+            acl_tx.send(AclPacket::parse_bytes(packet.take_payload().into()).unwrap()).await.unwrap();
             sink.success(Empty::default()).await.unwrap();
         });
     }
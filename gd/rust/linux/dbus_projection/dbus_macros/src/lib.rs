@@ -9,7 +9,9 @@ use std::path::Path;
 use syn::parse::Parser;
 use syn::punctuated::Punctuated;
 use syn::token::Comma;
-use syn::{Expr, FnArg, ImplItem, ItemImpl, ItemStruct, Meta, Pat, ReturnType, Type};
+use syn::{
+    Expr, FnArg, ImplItem, ItemImpl, ItemStruct, Lit, Meta, NestedMeta, Pat, ReturnType, Type,
+};
 
 use crate::proc_macro::TokenStream;
 
@@ -309,7 +311,8 @@ pub fn dbus_propmap(attr: TokenStream, item: TokenStream) -> TokenStream {
                         #field_ident.arg_type().as_str(),
                     )))));
                 }
-                let #field_ident = *any.downcast_ref::<<#field_type_ident as DBusArg>::DBusType>().unwrap();
+                let #field_ident =
+                    any.downcast_ref::<<#field_type_ident as DBusArg>::DBusType>().unwrap().clone();
                 let #field_ident = #field_type_ident::from_dbus(
                     #field_ident,
                     conn.clone(),
@@ -377,6 +380,14 @@ pub fn dbus_propmap(attr: TokenStream, item: TokenStream) -> TokenStream {
 }
 
 /// Generates a DBusArg implementation of a Remote RPC proxy object.
+///
+/// The generated methods are not sent to clients which filtered them out with
+/// `SetCallbackFilter`.
+///
+/// A `dbus_method` with `batch_size` (and optionally `batch_interval_ms`, 100 by default) is
+/// batched: its calls are grouped per client and sent as one D-Bus call with an array of their
+/// arguments, either when `batch_size` calls are pending or `batch_interval_ms` after the first.
+/// Only methods with a single argument can be batched.
 #[proc_macro_attribute]
 pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
     let ori_item: proc_macro2::TokenStream = item.clone().into();
@@ -396,6 +407,9 @@ pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
     };
 
     let mut method_impls = quote! {};
+    let mut batch_fields = quote! {};
+    let mut batch_inits = quote! {};
+    let mut batch_idents = quote! {};
 
     let ast: ItemImpl = syn::parse(item.clone()).unwrap();
     let self_ty = ast.self_ty;
@@ -413,36 +427,121 @@ pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
             }
 
             let attr_args = attr.parse_meta().unwrap();
-            let dbus_method_name = if let Meta::List(meta_list) = attr_args {
-                Some(meta_list.nested[0].clone())
+            let meta_list = if let Meta::List(meta_list) = attr_args {
+                meta_list
             } else {
-                None
+                continue;
             };
 
-            if dbus_method_name.is_none() {
-                continue;
+            let dbus_method_name = meta_list.nested[0].clone();
+
+            // A method with a `batch_size` is batched: its calls are grouped and sent with arrays
+            // of their arguments.
+            let mut batch_size: Option<usize> = None;
+            let mut batch_interval_ms: u64 = 100;
+            for nested in meta_list.nested.iter().skip(1) {
+                if let NestedMeta::Meta(Meta::NameValue(nv)) = nested {
+                    let value = if let Lit::Int(i) = &nv.lit {
+                        i.base10_parse::<u64>().unwrap()
+                    } else {
+                        panic!("batch parameters must be integers");
+                    };
+
+                    match nv.path.get_ident().unwrap().to_string().as_str() {
+                        "batch_size" => batch_size = Some(value as usize),
+                        "batch_interval_ms" => batch_interval_ms = value,
+                        other => panic!("unknown dbus_method parameter {}", other),
+                    }
+                }
             }
 
             let method_sig = method.sig.clone();
+            let method_name = method.sig.ident.clone();
 
             let mut method_args = quote! {};
+            let mut arg_idents = vec![];
+            let mut arg_types = vec![];
 
             for input in method.sig.inputs {
                 if let FnArg::Typed(ref typed) = input {
                     if let Pat::Ident(pat_ident) = &*typed.pat {
                         let ident = pat_ident.ident.clone();
+                        let arg_type = &typed.ty;
 
                         method_args = quote! {
                             #method_args DBusArg::to_dbus(#ident).unwrap(),
                         };
+                        arg_idents.push(ident);
+                        arg_types.push(arg_type.clone());
                     }
                 }
             }
 
-            method_impls = quote! {
-                #method_impls
-                #[allow(unused_variables)]
-                #method_sig {
+            let send = if let Some(batch_size) = batch_size {
+                if batch_size == 0 {
+                    panic!("batch_size must be at least 1");
+                }
+                if arg_idents.len() != 1 {
+                    panic!("only methods with exactly one argument can be batched");
+                }
+
+                let batch_ident = format_ident!("{}_batch", method_name);
+                let item_type = &arg_types[0];
+                let item = &arg_idents[0];
+
+                batch_fields = quote! {
+                    #batch_fields
+                    #batch_ident: Arc<dbus_projection::BatchedEmitter<#item_type>>,
+                };
+                batch_idents = quote! { #batch_idents #batch_ident, };
+                batch_inits = quote! {
+                    #batch_inits
+                    let #batch_ident = {
+                        let conn = conn.clone();
+                        let remote = remote.clone();
+                        let objpath = objpath.clone();
+                        Arc::new(dbus_projection::BatchedEmitter::new(
+                            dbus_projection::BatchConfig {
+                                max_size: #batch_size,
+                                flush_interval: std::time::Duration::from_millis(
+                                    #batch_interval_ms,
+                                ),
+                            },
+                            Arc::new(move |items: Vec<#item_type>| {
+                                let remote = remote.clone();
+                                let objpath = objpath.clone();
+                                let conn = conn.clone();
+                                bt_topshim::topstack::get_runtime().spawn(async move {
+                                    let proxy = dbus::nonblock::Proxy::new(
+                                        remote,
+                                        objpath,
+                                        std::time::Duration::from_secs(2),
+                                        conn,
+                                    );
+                                    let future: dbus::nonblock::MethodReply<()> = proxy
+                                        .method_call(
+                                            #dbus_iface_name,
+                                            #dbus_method_name,
+                                            (DBusArg::to_dbus(items).unwrap(),),
+                                        );
+                                    let _result = future.await;
+                                });
+                            }),
+                            Arc::new(|delay, flush| {
+                                bt_topshim::topstack::get_runtime().spawn(async move {
+                                    tokio::time::sleep(delay).await;
+                                    flush();
+                                });
+                            }),
+                        ))
+                    };
+                };
+
+                quote! {
+                    self.#batch_ident.emit(#item);
+                }
+            } else {
+                quote! {
                     let remote = self.remote.clone();
                     let objpath = self.objpath.clone();
                     let conn = self.conn.clone();
@@ -462,6 +561,22 @@ pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
                     });
                 }
             };
+
+            method_impls = quote! {
+                #method_impls
+                #[allow(unused_variables)]
+                #method_sig {
+                    if !dbus_projection::callback_filters().lock().unwrap().wants(
+                        &self.remote,
+                        &self.objpath,
+                        #dbus_method_name,
+                    ) {
+                        return;
+                    }
+
+                    #send
+                }
+            };
         }
     }
 
@@ -477,6 +592,7 @@ pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
             remote: BusName<'static>,
             objpath: Path<'static>,
             disconnect_watcher: Arc<Mutex<DisconnectWatcher>>,
+            #batch_fields
         }
 
         impl #trait_ for #struct_ident {
@@ -498,7 +614,14 @@ pub fn dbus_proxy_obj(attr: TokenStream, item: TokenStream) -> TokenStream {
                 remote: BusName<'static>,
                 disconnect_watcher: Arc<Mutex<DisconnectWatcher>>,
             ) -> Result<Box<dyn #trait_ + Send>, Box<dyn Error>> {
-                Ok(Box::new(#struct_ident { conn, remote, objpath, disconnect_watcher }))
+                #batch_inits
+                Ok(Box::new(#struct_ident {
+                    conn,
+                    remote,
+                    objpath,
+                    disconnect_watcher,
+                    #batch_idents
+                }))
             }
 
             fn to_dbus(_data: Box<dyn #trait_ + Send>) -> Result<Path<'static>, Box<dyn Error>> {
@@ -2,13 +2,19 @@
 //!
 //! For D-Bus projection to work automatically, the API needs to follow certain restrictions.
 
+#[macro_use]
+extern crate lazy_static;
+
 use dbus::channel::MatchingReceiver;
 use dbus::message::MatchRule;
 use dbus::nonblock::SyncConnection;
-use dbus::strings::BusName;
+use dbus::strings::{BusName, Path};
+
+use dbus_crossroads::{Context, Crossroads, IfaceBuilder};
 
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use std::sync::{Arc, Mutex};
+use std::time::Duration;
 
 /// A D-Bus "NameOwnerChanged" handler that continuously monitors client disconnects.
 pub struct DisconnectWatcher {
@@ -73,6 +79,219 @@ impl DisconnectWatcher {
     }
 }
 
+/// Configures how the calls to a batched callback method are grouped.
+///
+/// Batched methods are marked with `batch_size` and `batch_interval_ms` in their `dbus_method`
+/// attribute, and each D-Bus call carries an array of the items since the previous call.
+#[derive(Clone, Copy, Debug)]
+pub struct BatchConfig {
+    /// The most items sent in one D-Bus call.
+    pub max_size: usize,
+    /// How long the first item of a batch waits for others before the batch is sent.
+    pub flush_interval: Duration,
+}
+
+/// What the caller of `CallBatch::push` has to do with the batch.
+pub enum BatchAction<T> {
+    /// Nothing, the batch is already waiting for its flush.
+    Wait,
+    /// The batch was empty, so flush it with `CallBatch::take` after the flush interval.
+    ScheduleFlush(u64),
+    /// The batch is full, so send these items now.
+    Send(Vec<T>),
+}
+
+/// The pending calls of a batched callback method of one client.
+pub struct CallBatch<T> {
+    config: BatchConfig,
+    items: Vec<T>,
+    // Counts the batches sent, so that the scheduled flush of a batch which was already sent
+    // because it was full does not send the next batch early.
+    generation: u64,
+}
+
+impl<T> CallBatch<T> {
+    /// Creates an empty batch.
+    pub fn new(config: BatchConfig) -> CallBatch<T> {
+        CallBatch { config, items: vec![], generation: 0 }
+    }
+
+    /// Adds an item to the batch.
+    pub fn push(&mut self, item: T) -> BatchAction<T> {
+        self.items.push(item);
+
+        if self.items.len() >= self.config.max_size {
+            self.generation += 1;
+            return BatchAction::Send(std::mem::take(&mut self.items));
+        }
+
+        if self.items.len() == 1 {
+            return BatchAction::ScheduleFlush(self.generation);
+        }
+
+        BatchAction::Wait
+    }
+
+    /// Takes the items of the batch scheduled for flush as `generation`, if it was not sent yet.
+    pub fn take(&mut self, generation: u64) -> Option<Vec<T>> {
+        if generation != self.generation || self.items.is_empty() {
+            return None;
+        }
+
+        self.generation += 1;
+        Some(std::mem::take(&mut self.items))
+    }
+}
+
+/// Sends the D-Bus call of a batched callback method with the items of a batch.
+pub type BatchSender<T> = Arc<dyn Fn(Vec<T>) + Send + Sync>;
+
+/// Runs a batch flush after the flush interval.
+pub type FlushScheduler = Arc<dyn Fn(Duration, Box<dyn FnOnce() + Send>) + Send + Sync>;
+
+/// The emitter behind a batched callback method of a projected proxy object.
+///
+/// `dbus_proxy_obj` generates one per batched method and client callback object. The emitter
+/// sends a batch as soon as it is full, or once the flush interval has passed since its first
+/// item.
+pub struct BatchedEmitter<T> {
+    batch: Arc<Mutex<CallBatch<T>>>,
+    flush_interval: Duration,
+    send: BatchSender<T>,
+    schedule: FlushScheduler,
+}
+
+impl<T: Send + 'static> BatchedEmitter<T> {
+    /// Creates an emitter which sends its batches with `send` and delays flushes with `schedule`.
+    pub fn new(config: BatchConfig, send: BatchSender<T>, schedule: FlushScheduler) -> Self {
+        BatchedEmitter {
+            batch: Arc::new(Mutex::new(CallBatch::new(config))),
+            flush_interval: config.flush_interval,
+            send,
+            schedule,
+        }
+    }
+
+    /// Queues one call of the batched method.
+    pub fn emit(&self, item: T) {
+        let action = self.batch.lock().unwrap().push(item);
+        match action {
+            BatchAction::Wait => {}
+            BatchAction::Send(items) => (self.send)(items),
+            BatchAction::ScheduleFlush(generation) => {
+                let batch = self.batch.clone();
+                let send = self.send.clone();
+                (self.schedule)(
+                    self.flush_interval,
+                    Box::new(move || {
+                        let items = batch.lock().unwrap().take(generation);
+                        if let Some(items) = items {
+                            send(items);
+                        }
+                    }),
+                );
+            }
+        }
+    }
+}
+
+/// The callback methods each client wants to receive on its callback objects.
+///
+/// A client which did not set a filter on a callback object receives all of its methods.
+pub struct CallbackFilters {
+    wanted: HashMap<(BusName<'static>, Path<'static>), HashSet<String>>,
+}
+
+impl CallbackFilters {
+    fn new() -> CallbackFilters {
+        CallbackFilters { wanted: HashMap::new() }
+    }
+
+    /// Sets the D-Bus methods the callback object `objpath` of `remote` wants. An empty list
+    /// removes the filter.
+    pub fn set(&mut self, remote: BusName<'static>, objpath: Path<'static>, methods: Vec<String>) {
+        if methods.is_empty() {
+            self.wanted.remove(&(remote, objpath));
+        } else {
+            self.wanted.insert((remote, objpath), methods.into_iter().collect());
+        }
+    }
+
+    /// Removes the filters of a disconnected client.
+    pub fn remove_client(&mut self, remote: &BusName<'static>) {
+        self.wanted.retain(|(r, _), _| r != remote);
+    }
+
+    /// Returns whether the callback object `objpath` of `remote` wants the D-Bus method `method`.
+    pub fn wants(&self, remote: &BusName<'static>, objpath: &Path<'static>, method: &str) -> bool {
+        if self.wanted.is_empty() {
+            return true;
+        }
+
+        match self.wanted.get(&(remote.clone(), objpath.clone())) {
+            Some(methods) => methods.contains(method),
+            None => true,
+        }
+    }
+}
+
+lazy_static! {
+    static ref CALLBACK_FILTERS: Arc<Mutex<CallbackFilters>> =
+        Arc::new(Mutex::new(CallbackFilters::new()));
+}
+
+/// Returns the callback filters checked by the projected callback objects.
+pub fn callback_filters() -> Arc<Mutex<CallbackFilters>> {
+    CALLBACK_FILTERS.clone()
+}
+
+/// Exports the D-Bus method with which clients filter the callbacks they receive.
+///
+/// `SetCallbackFilter(callback, methods)` limits the callback object `callback` of the caller to
+/// the D-Bus methods in `methods`, so that the service does not send the others at all. The
+/// filters of a client are dropped when it disconnects.
+pub fn export_callback_filter(
+    path: &'static str,
+    iface_name: &'static str,
+    cr: &mut Crossroads,
+    disconnect_watcher: Arc<Mutex<DisconnectWatcher>>,
+) {
+    let iface_token = cr.register(iface_name, |ibuilder: &mut IfaceBuilder<()>| {
+        ibuilder.method(
+            "SetCallbackFilter",
+            ("callback", "methods"),
+            (),
+            move |ctx: &mut Context,
+                  _: &mut (),
+                  (objpath, methods): (Path<'static>, Vec<String>)| {
+                let remote = ctx.message().sender().unwrap().into_static();
+
+                let known = {
+                    let filters = callback_filters();
+                    let mut filters = filters.lock().unwrap();
+                    let known = filters.wanted.keys().any(|(r, _)| *r == remote);
+                    filters.set(remote.clone(), objpath, methods);
+                    known
+                };
+
+                if !known {
+                    let disconnected = remote.clone();
+                    disconnect_watcher.lock().unwrap().add(
+                        remote,
+                        Box::new(move || {
+                            callback_filters().lock().unwrap().remove_client(&disconnected);
+                        }),
+                    );
+                }
+
+                Ok(())
+            },
+        );
+    });
+
+    cr.insert(path, &[iface_token], ());
+}
+
 #[macro_export]
 macro_rules! impl_dbus_arg_enum {
     ($enum_type:ty) => {
@@ -100,3 +319,84 @@ macro_rules! impl_dbus_arg_enum {
         }
     };
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    // Records the sent batches, and keeps the scheduled flushes until the test runs them.
+    struct TestEmitter {
+        emitter: BatchedEmitter<u32>,
+        sent: Arc<Mutex<Vec<Vec<u32>>>>,
+        flushes: Arc<Mutex<Vec<(Duration, Box<dyn FnOnce() + Send>)>>>,
+    }
+
+    impl TestEmitter {
+        fn new(max_size: usize) -> TestEmitter {
+            let sent = Arc::new(Mutex::new(vec![]));
+            let flushes = Arc::new(Mutex::new(vec![]));
+            let sent_clone = sent.clone();
+            let flushes_clone = flushes.clone();
+            let emitter = BatchedEmitter::new(
+                BatchConfig { max_size, flush_interval: Duration::from_millis(100) },
+                Arc::new(move |items| sent_clone.lock().unwrap().push(items)),
+                Arc::new(move |delay, flush| flushes_clone.lock().unwrap().push((delay, flush))),
+            );
+            TestEmitter { emitter, sent, flushes }
+        }
+
+        fn run_flushes(&self) {
+            let flushes: Vec<_> = self.flushes.lock().unwrap().drain(..).collect();
+            for (_, flush) in flushes {
+                flush();
+            }
+        }
+    }
+
+    #[test]
+    fn sends_full_batches_at_once() {
+        let test = TestEmitter::new(3);
+        for i in 0..7 {
+            test.emitter.emit(i);
+        }
+        assert_eq!(*test.sent.lock().unwrap(), vec![vec![0, 1, 2], vec![3, 4, 5]]);
+
+        // Only the flush of the batch still pending sends anything.
+        assert_eq!(test.flushes.lock().unwrap().len(), 3);
+        test.run_flushes();
+        assert_eq!(*test.sent.lock().unwrap(), vec![vec![0, 1, 2], vec![3, 4, 5], vec![6]]);
+    }
+
+    #[test]
+    fn flushes_partial_batch_after_interval() {
+        let test = TestEmitter::new(32);
+        test.emitter.emit(1);
+        test.emitter.emit(2);
+        assert!(test.sent.lock().unwrap().is_empty());
+        assert_eq!(test.flushes.lock().unwrap().len(), 1);
+        assert_eq!(test.flushes.lock().unwrap()[0].0, Duration::from_millis(100));
+
+        test.run_flushes();
+        assert_eq!(*test.sent.lock().unwrap(), vec![vec![1, 2]]);
+
+        // The next item starts a new batch with its own flush.
+        test.emitter.emit(3);
+        test.run_flushes();
+        assert_eq!(*test.sent.lock().unwrap(), vec![vec![1, 2], vec![3]]);
+    }
+
+    #[test]
+    fn callback_filter_defaults_to_all_methods() {
+        let mut filters = CallbackFilters::new();
+        let remote = BusName::new(":1.1").unwrap().into_static();
+        let objpath = Path::new("/cb").unwrap().into_static();
+        assert!(filters.wants(&remote, &objpath, "OnDevicesFound"));
+
+        filters.set(remote.clone(), objpath.clone(), vec![String::from("OnBluetoothStateChange")]);
+        assert!(!filters.wants(&remote, &objpath, "OnDevicesFound"));
+        assert!(filters.wants(&remote, &objpath, "OnBluetoothStateChange"));
+
+        filters.remove_client(&remote);
+        assert!(filters.wants(&remote, &objpath, "OnDevicesFound"));
+    }
+}
@@ -1,20 +1,29 @@
 extern crate bt_shim;
 
-use btstack::bluetooth::{IBluetooth, IBluetoothCallback};
+use btstack::bluetooth::{BluetoothDevice, IBluetooth, IBluetoothCallback};
 use btstack::RPCProxy;
 
+use dbus::arg::RefArg;
+
 use dbus::nonblock::SyncConnection;
 use dbus::strings::{BusName, Path};
 
-use dbus_macros::{dbus_method, dbus_proxy_obj, generate_dbus_exporter};
+use dbus_macros::{dbus_method, dbus_propmap, dbus_proxy_obj, generate_dbus_exporter};
 
 use dbus_projection::DisconnectWatcher;
 
+use std::collections::HashMap;
 use std::error::Error;
 use std::sync::Arc;
 use std::sync::Mutex;
 
-use crate::dbus_arg::DBusArg;
+use crate::dbus_arg::{DBusArg, DBusArgError};
+
+#[dbus_propmap(BluetoothDevice)]
+pub struct BluetoothDeviceDBus {
+    address: String,
+    name: String,
+}
 
 #[allow(dead_code)]
 struct BluetoothCallbackDBus {}
@@ -25,6 +34,8 @@ impl IBluetoothCallback for BluetoothCallbackDBus {
     fn on_bluetooth_state_changed(&self, prev_state: u32, new_state: u32) {}
     #[dbus_method("OnBluetoothAddressChanged")]
     fn on_bluetooth_address_changed(&self, addr: String) {}
+    #[dbus_method("OnDevicesFound", batch_size = 32, batch_interval_ms = 100)]
+    fn on_device_found(&self, remote_device: BluetoothDevice) {}
 }
 
 #[allow(dead_code)]
@@ -48,4 +59,14 @@ impl IBluetooth for IBluetoothDBus {
     fn get_address(&self) -> String {
         String::from("")
     }
+
+    #[dbus_method("StartDiscovery")]
+    fn start_discovery(&self) -> bool {
+        false
+    }
+
+    #[dbus_method("CancelDiscovery")]
+    fn cancel_discovery(&self) -> bool {
+        false
+    }
 }
@@ -1,5 +1,5 @@
 use btstack::bluetooth_gatt::{
-    IBluetoothGatt, IScannerCallback, RSSISettings, ScanFilter, ScanSettings, ScanType,
+    IBluetoothGatt, IScannerCallback, RSSISettings, ScanFilter, ScanResult, ScanSettings, ScanType,
 };
 use btstack::RPCProxy;
 
@@ -28,6 +28,16 @@ struct ScannerCallbackDBus {}
 impl IScannerCallback for ScannerCallbackDBus {
     #[dbus_method("OnScannerRegistered")]
     fn on_scanner_registered(&self, _status: i32, _scanner_id: i32) {}
+
+    #[dbus_method("OnScanResults", batch_size = 32, batch_interval_ms = 100)]
+    fn on_scan_result(&self, scan_result: ScanResult) {}
+}
+
+#[dbus_propmap(ScanResult)]
+pub struct ScanResultDBus {
+    address: String,
+    addr_type: i32,
+    rssi: i32,
 }
 
 #[dbus_propmap(RSSISettings)]
@@ -60,14 +70,14 @@ struct IBluetoothGattDBus {}
 #[generate_dbus_exporter(export_bluetooth_gatt_dbus_obj, "org.chromium.bluetooth.BluetoothGatt")]
 impl IBluetoothGatt for IBluetoothGattDBus {
     #[dbus_method("RegisterScanner")]
-    fn register_scanner(&self, callback: Box<dyn IScannerCallback + Send>) {}
+    fn register_scanner(&mut self, callback: Box<dyn IScannerCallback + Send>) {}
 
     #[dbus_method("UnregisterScanner")]
-    fn unregister_scanner(&self, scanner_id: i32) {}
+    fn unregister_scanner(&mut self, scanner_id: i32) {}
 
     #[dbus_method("StartScan")]
-    fn start_scan(&self, scanner_id: i32, settings: ScanSettings, filters: Vec<ScanFilter>) {}
+    fn start_scan(&mut self, scanner_id: i32, settings: ScanSettings, filters: Vec<ScanFilter>) {}
 
     #[dbus_method("StopScan")]
-    fn stop_scan(&self, scanner_id: i32) {}
+    fn stop_scan(&mut self, scanner_id: i32) {}
 }
@@ -27,6 +27,8 @@ mod iface_bluetooth_gatt;
 const DBUS_SERVICE_NAME: &str = "org.chromium.bluetooth";
 const OBJECT_BLUETOOTH: &str = "/org/chromium/bluetooth/adapter";
 const OBJECT_BLUETOOTH_GATT: &str = "/org/chromium/bluetooth/gatt";
+const OBJECT_CALLBACK_FILTER: &str = "/org/chromium/bluetooth/callback_filter";
+const INTERFACE_CALLBACK_FILTER: &str = "org.chromium.bluetooth.CallbackFilter";
 
 /// Runs the Bluetooth daemon serving D-Bus IPC.
 fn main() -> Result<(), Box<dyn Error>> {
@@ -59,10 +61,15 @@ fn main() -> Result<(), Box<dyn Error>> {
             }),
         )));
 
-        intf.lock().unwrap().initialize(Arc::new(btif_bluetooth_callbacks(tx)), vec![]);
+        intf.lock().unwrap().initialize(Arc::new(btif_bluetooth_callbacks(tx.clone())), vec![]);
+        bluetooth_gatt.lock().unwrap().init_profiles(tx);
 
         // Run the stack main dispatch loop.
-        topstack::get_runtime().spawn(Stack::dispatch(rx, bluetooth.clone()));
+        topstack::get_runtime().spawn(Stack::dispatch(
+            rx,
+            bluetooth.clone(),
+            bluetooth_gatt.clone(),
+        ));
 
         // Set up the disconnect watcher to monitor client disconnects.
         let disconnect_watcher = Arc::new(Mutex::new(DisconnectWatcher::new()));
@@ -84,6 +91,13 @@ fn main() -> Result<(), Box<dyn Error>> {
             bluetooth_gatt,
             disconnect_watcher.clone(),
         );
+        // Let clients filter the callbacks they receive.
+        dbus_projection::export_callback_filter(
+            OBJECT_CALLBACK_FILTER,
+            INTERFACE_CALLBACK_FILTER,
+            &mut cr,
+            disconnect_watcher.clone(),
+        );
 
         conn.start_receive(
             MatchRule::new_method_call(),
@@ -32,7 +32,8 @@ pub fn stack_message(_attr: TokenStream, item: TokenStream) -> TokenStream {
 
 /// Generates a topshim callback object that contains closures.
 ///
-/// The closures are generated to be calls to the corresponding `Stack::Message`.
+/// The closures are generated to send the corresponding `Stack::Message` to the dispatch loop,
+/// straight from the callback thread.
 #[proc_macro_attribute]
 pub fn btif_callbacks_generator(attr: TokenStream, item: TokenStream) -> TokenStream {
     let args = Punctuated::<Expr, Comma>::parse_separated_nonempty.parse(attr.clone()).unwrap();
@@ -95,13 +96,9 @@ pub fn btif_callbacks_generator(attr: TokenStream, item: TokenStream) -> TokenSt
                 #closure_defs
                 let tx_clone = tx.clone();
                 let #method_ident = Box::new(move |#arg_names| {
-                    let tx = tx_clone.clone();
-                    topstack::get_runtime().spawn(async move {
-                        let result = tx.send(Message::#stack_message(#arg_names)).await;
-                        if let Err(e) = result {
-                            eprintln!("Error in sending message: {}", e);
-                        }
-                    });
+                    if tx_clone.send(Message::#stack_message(#arg_names)).is_err() {
+                        eprintln!("Error in sending message: dispatch loop is gone");
+                    }
                 });
             };
         }
@@ -113,14 +110,15 @@ pub fn btif_callbacks_generator(attr: TokenStream, item: TokenStream) -> TokenSt
         #ori_item
 
         /// Returns a callback object to be passed to topshim.
-        pub fn #fn_ident(tx: tokio::sync::mpsc::Sender<Message>) -> #callbacks_struct_ident {
+        pub fn #fn_ident(
+            tx: bt_topshim::topstack::EventSender<Message>,
+        ) -> #callbacks_struct_ident {
             #closure_defs
             #callbacks_struct_ident {
                 #fn_names
                 // TODO: Handle these in main loop.
                 acl_state_changed: Box::new(|_, _, _, _| {}),
                 bond_state_changed: Box::new(|_, _, _| {}),
-                device_found: Box::new(|_, _| {}),
                 discovery_state_changed: Box::new(|_| {}),
                 pin_request: Box::new(|_, _, _, _| {}),
                 remote_device_properties_changed: Box::new(|_, _, _, _| {}),
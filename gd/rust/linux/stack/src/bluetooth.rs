@@ -2,7 +2,7 @@
 
 use bt_topshim::btif::ffi;
 use bt_topshim::btif::{BluetoothCallbacks, BluetoothInterface, BtState};
-use bt_topshim::topstack;
+use bt_topshim::topstack::{self, EventSender};
 
 use btif_macros::btif_callbacks_generator;
 use btif_macros::stack_message;
@@ -14,8 +14,6 @@ use std::fmt::Debug;
 use std::sync::Arc;
 use std::sync::Mutex;
 
-use tokio::sync::mpsc::Sender;
-
 use crate::{BDAddr, Message, RPCProxy};
 
 /// Defines the adapter API.
@@ -35,6 +33,23 @@ pub trait IBluetooth {
 
     /// Returns the Bluetooth address of the local adapter.
     fn get_address(&self) -> String;
+
+    /// Starts BREDR Inquiry and LE scanning for nearby devices.
+    ///
+    /// Returns true if the request is accepted.
+    fn start_discovery(&self) -> bool;
+
+    /// Cancels an ongoing device discovery.
+    ///
+    /// Returns true if the request is accepted.
+    fn cancel_discovery(&self) -> bool;
+}
+
+/// A remote Bluetooth device found during discovery.
+#[derive(Debug, Default, Clone)]
+pub struct BluetoothDevice {
+    pub address: String,
+    pub name: String,
 }
 
 /// The interface for adapter callbacks registered through `IBluetooth::register_callback`.
@@ -44,6 +59,9 @@ pub trait IBluetoothCallback: RPCProxy {
 
     /// When any of the adapter local address is changed.
     fn on_bluetooth_address_changed(&self, addr: String);
+
+    /// When a device is found during discovery.
+    fn on_device_found(&self, remote_device: BluetoothDevice);
 }
 
 /// Implementation of the adapter API.
@@ -52,13 +70,13 @@ pub struct Bluetooth {
     state: BtState,
     callbacks: Vec<(u32, Box<dyn IBluetoothCallback + Send>)>,
     callbacks_last_id: u32,
-    tx: Sender<Message>,
+    tx: EventSender<Message>,
     local_address: Option<BDAddr>,
 }
 
 impl Bluetooth {
     /// Constructs the IBluetooth implementation.
-    pub fn new(tx: Sender<Message>, intf: Arc<Mutex<BluetoothInterface>>) -> Bluetooth {
+    pub fn new(tx: EventSender<Message>, intf: Arc<Mutex<BluetoothInterface>>) -> Bluetooth {
         Bluetooth {
             tx,
             intf,
@@ -94,6 +112,9 @@ pub(crate) trait BtifBluetoothCallbacks {
         num_properties: i32,
         properties: Vec<ffi::BtProperty>,
     );
+
+    #[stack_message(BluetoothDeviceFound)]
+    fn device_found(&mut self, n: i32, properties: Vec<ffi::BtProperty>);
 }
 
 #[derive(FromPrimitive, ToPrimitive, PartialEq, PartialOrd)]
@@ -154,6 +175,28 @@ impl BtifBluetoothCallbacks for Bluetooth {
             }
         }
     }
+
+    #[allow(unused_variables)]
+    fn device_found(&mut self, n: i32, properties: Vec<ffi::BtProperty>) {
+        let mut device = BluetoothDevice::default();
+
+        for prop in properties {
+            match PropertyType::from_i32(prop.prop_type) {
+                Some(PropertyType::BDAddr) if prop.val.len() == 6 => {
+                    device.address = BDAddr::from_byte_vec(&prop.val).to_string();
+                }
+                Some(PropertyType::BDName) => {
+                    let len = prop.val.iter().position(|&b| b == 0).unwrap_or(prop.val.len());
+                    device.name = String::from_utf8_lossy(&prop.val[..len]).into_owned();
+                }
+                _ => {}
+            }
+        }
+
+        for callback in &self.callbacks {
+            callback.1.on_device_found(device.clone());
+        }
+    }
 }
 
 // TODO: Add unit tests for this implementation
@@ -165,10 +208,11 @@ impl IBluetooth for Bluetooth {
         self.callbacks_last_id += 1;
         let id = self.callbacks_last_id;
 
+        // Disconnects are observed on the runtime, where sending must not block.
         callback.register_disconnect(Box::new(move || {
             let tx = tx.clone();
             topstack::get_runtime().spawn(async move {
-                let _result = tx.send(Message::BluetoothCallbackDisconnected(id)).await;
+                let _result = tx.send_async(Message::BluetoothCallbackDisconnected(id)).await;
             });
         }));
 
@@ -189,4 +233,12 @@ impl IBluetooth for Bluetooth {
             Some(addr) => addr.to_string(),
         }
     }
+
+    fn start_discovery(&self) -> bool {
+        self.intf.lock().unwrap().start_discovery() == 0
+    }
+
+    fn cancel_discovery(&self) -> bool {
+        self.intf.lock().unwrap().cancel_discovery() == 0
+    }
 }
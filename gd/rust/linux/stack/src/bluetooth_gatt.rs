@@ -1,23 +1,31 @@
 //! Anything related to the GATT API (IBluetoothGatt).
 
 use bt_topshim::btif::BluetoothInterface;
+use bt_topshim::gatt::{ffi, GattScanner, GattScannerCallbacks};
+use bt_topshim::topstack::EventSender;
 
+use std::collections::HashMap;
 use std::sync::{Arc, Mutex};
 
+use crate::{BDAddr, Message};
+
 /// Defines the GATT API.
 pub trait IBluetoothGatt {
-    fn register_scanner(&self, callback: Box<dyn IScannerCallback + Send>);
+    fn register_scanner(&mut self, callback: Box<dyn IScannerCallback + Send>);
 
-    fn unregister_scanner(&self, scanner_id: i32);
+    fn unregister_scanner(&mut self, scanner_id: i32);
 
-    fn start_scan(&self, scanner_id: i32, settings: ScanSettings, filters: Vec<ScanFilter>);
-    fn stop_scan(&self, scanner_id: i32);
+    fn start_scan(&mut self, scanner_id: i32, settings: ScanSettings, filters: Vec<ScanFilter>);
+    fn stop_scan(&mut self, scanner_id: i32);
 }
 
 /// Interface for scanner callbacks to clients, passed to `IBluetoothGatt::register_scanner`.
 pub trait IScannerCallback {
     /// When the `register_scanner` request is done.
     fn on_scanner_registered(&self, status: i32, scanner_id: i32);
+
+    /// When an advertisement is received while the scanner is scanning.
+    fn on_scan_result(&self, scan_result: ScanResult);
 }
 
 #[derive(Debug, FromPrimitive, ToPrimitive)]
@@ -55,32 +63,155 @@ pub struct ScanSettings {
 #[derive(Debug, Default)]
 pub struct ScanFilter {}
 
+/// An advertisement received while scanning, passed to `IScannerCallback::on_scan_result`.
+#[derive(Debug, Default, Clone)]
+pub struct ScanResult {
+    pub address: String,
+    pub addr_type: i32,
+    pub rssi: i32,
+    pub adv_data: Vec<u8>,
+}
+
+/// Returns the LE scanner callbacks, which pass the scanner events to the stack dispatch loop.
+fn gatt_scanner_callbacks(tx: EventSender<Message>) -> GattScannerCallbacks {
+    let tx_clone = tx.clone();
+    GattScannerCallbacks {
+        scanner_registered: Box::new(move |uuid, scanner_id, status| {
+            if tx_clone.send(Message::GattScannerRegistered(uuid, scanner_id, status)).is_err() {
+                eprintln!("Error in sending message: dispatch loop is gone");
+            }
+        }),
+        scan_result: Box::new(move |result| {
+            if tx.send(Message::GattScanResult(result)).is_err() {
+                eprintln!("Error in sending message: dispatch loop is gone");
+            }
+        }),
+    }
+}
+
+struct Scanner {
+    callback: Box<dyn IScannerCallback + Send>,
+    scanning: bool,
+}
+
 /// Implementation of the GATT API (IBluetoothGatt).
 pub struct BluetoothGatt {
-    _intf: Arc<Mutex<BluetoothInterface>>,
+    intf: Arc<Mutex<BluetoothInterface>>,
+    scanner: Option<GattScanner>,
+    // Scanners waiting for their registration, by app UUID.
+    pending_scanners: HashMap<[u8; 16], Box<dyn IScannerCallback + Send>>,
+    scanners: HashMap<u8, Scanner>,
+    scanner_uuid_last: u128,
 }
 
 impl BluetoothGatt {
     /// Constructs a new IBluetoothGatt implementation.
     pub fn new(intf: Arc<Mutex<BluetoothInterface>>) -> BluetoothGatt {
-        BluetoothGatt { _intf: intf }
+        BluetoothGatt {
+            intf,
+            scanner: None,
+            pending_scanners: HashMap::new(),
+            scanners: HashMap::new(),
+            scanner_uuid_last: 0,
+        }
+    }
+
+    /// Initializes the native GATT interface, once the Bluetooth interface is initialized.
+    pub fn init_profiles(&mut self, tx: EventSender<Message>) {
+        let scanner = GattScanner::new(&self.intf.lock().unwrap());
+        let mut scanner = match scanner {
+            Some(scanner) => scanner,
+            None => {
+                eprintln!("GATT interface is not available");
+                return;
+            }
+        };
+
+        if scanner.initialize(gatt_scanner_callbacks(tx)) {
+            self.scanner = Some(scanner);
+        }
+    }
+
+    pub(crate) fn scanner_registered(&mut self, uuid: [u8; 16], scanner_id: u8, status: u8) {
+        let callback = match self.pending_scanners.remove(&uuid) {
+            Some(callback) => callback,
+            None => return,
+        };
+
+        callback.on_scanner_registered(status.into(), scanner_id.into());
+        if status == 0 {
+            self.scanners.insert(scanner_id, Scanner { callback, scanning: false });
+        }
+    }
+
+    pub(crate) fn scan_result(&mut self, result: ffi::GattScanResult) {
+        let scan_result = ScanResult {
+            address: BDAddr { val: result.address }.to_string(),
+            addr_type: result.addr_type.into(),
+            rssi: result.rssi.into(),
+            adv_data: result.adv_data,
+        };
+
+        for scanner in self.scanners.values().filter(|s| s.scanning) {
+            scanner.callback.on_scan_result(scan_result.clone());
+        }
+    }
+
+    // The native scan is shared by all scanners, so it runs while any of them is scanning.
+    fn update_scan(&mut self, was_scanning: bool) {
+        let scanning = self.scanners.values().any(|s| s.scanning);
+        if scanning != was_scanning {
+            if let Some(scanner) = &mut self.scanner {
+                scanner.scan(scanning);
+            }
+        }
+    }
+
+    fn set_scanning(&mut self, scanner_id: i32, scanning: bool) {
+        let was_scanning = self.scanners.values().any(|s| s.scanning);
+        if let Some(scanner) = self.scanners.get_mut(&(scanner_id as u8)) {
+            scanner.scanning = scanning;
+        }
+        self.update_scan(was_scanning);
     }
 }
 
 impl IBluetoothGatt for BluetoothGatt {
-    fn register_scanner(&self, _callback: Box<dyn IScannerCallback + Send>) {
-        // TODO: implement
+    fn register_scanner(&mut self, callback: Box<dyn IScannerCallback + Send>) {
+        let scanner = match &mut self.scanner {
+            Some(scanner) => scanner,
+            None => {
+                callback.on_scanner_registered(1, 0);
+                return;
+            }
+        };
+
+        // The app UUIDs only need to be unique within the daemon.
+        self.scanner_uuid_last += 1;
+        let uuid = self.scanner_uuid_last.to_be_bytes();
+
+        self.pending_scanners.insert(uuid, callback);
+        scanner.register_scanner(uuid);
     }
 
-    fn unregister_scanner(&self, _scanner_id: i32) {
-        // TODO: implement
+    fn unregister_scanner(&mut self, scanner_id: i32) {
+        let was_scanning = self.scanners.values().any(|s| s.scanning);
+        if self.scanners.remove(&(scanner_id as u8)).is_none() {
+            return;
+        }
+
+        if let Some(scanner) = &mut self.scanner {
+            scanner.unregister(scanner_id as u8);
+        }
+        self.update_scan(was_scanning);
     }
 
-    fn start_scan(&self, _scanner_id: i32, _settings: ScanSettings, _filters: Vec<ScanFilter>) {
-        // TODO: implement
+    // TODO: Apply the settings and filters.
+    fn start_scan(&mut self, scanner_id: i32, _settings: ScanSettings, _filters: Vec<ScanFilter>) {
+        self.set_scanning(scanner_id, true);
     }
 
-    fn stop_scan(&self, _scanner_id: i32) {
-        // TODO: implement
+    fn stop_scan(&mut self, scanner_id: i32) {
+        self.set_scanning(scanner_id, false);
     }
 }
@@ -11,15 +11,15 @@ pub mod bluetooth_gatt;
 
 use bt_topshim::btif::ffi;
 use bt_topshim::btif::BtState;
+use bt_topshim::gatt::ffi::GattScanResult;
+use bt_topshim::topstack::{event_ring, EventReceiver, EventSender};
 
 use std::convert::TryInto;
 use std::fmt::{Debug, Formatter, Result};
 use std::sync::{Arc, Mutex};
 
-use tokio::sync::mpsc::channel;
-use tokio::sync::mpsc::{Receiver, Sender};
-
 use crate::bluetooth::{Bluetooth, BtifBluetoothCallbacks};
+use crate::bluetooth_gatt::BluetoothGatt;
 
 /// Represents a Bluetooth address.
 // TODO: Add support for LE random addresses.
@@ -57,43 +57,72 @@ impl BDAddr {
 pub enum Message {
     BluetoothAdapterStateChanged(BtState),
     BluetoothAdapterPropertiesChanged(i32, i32, Vec<ffi::BtProperty>),
+    BluetoothDeviceFound(i32, Vec<ffi::BtProperty>),
     BluetoothCallbackDisconnected(u32),
+    GattScannerRegistered([u8; 16], u8, u8),
+    GattScanResult(GattScanResult),
 }
 
+// The messages the ring holds before senders wait, and the most handled per batch.
+const MESSAGE_RING_CAPACITY: usize = 256;
+const DISPATCH_BATCH_SIZE: usize = 64;
+
 /// Umbrella class for the Bluetooth stack.
 pub struct Stack {}
 
 impl Stack {
-    /// Creates an mpsc channel for passing messages to the main dispatch loop.
-    pub fn create_channel() -> (Sender<Message>, Receiver<Message>) {
-        channel::<Message>(1)
+    /// Creates a ring for passing messages to the main dispatch loop.
+    pub fn create_channel() -> (EventSender<Message>, EventReceiver<Message>) {
+        event_ring::<Message>(MESSAGE_RING_CAPACITY)
     }
 
     /// Runs the main dispatch loop.
-    pub async fn dispatch(mut rx: Receiver<Message>, bluetooth: Arc<Mutex<Bluetooth>>) {
-        loop {
-            let m = rx.recv().await;
+    pub async fn dispatch(
+        mut rx: EventReceiver<Message>,
+        bluetooth: Arc<Mutex<Bluetooth>>,
+        bluetooth_gatt: Arc<Mutex<BluetoothGatt>>,
+    ) {
+        let mut messages = Vec::with_capacity(DISPATCH_BATCH_SIZE);
 
-            if m.is_none() {
+        loop {
+            if !rx.recv_batch(&mut messages, DISPATCH_BATCH_SIZE).await {
                 eprintln!("Message dispatch loop quit");
                 break;
             }
 
-            match m.unwrap() {
-                Message::BluetoothAdapterStateChanged(state) => {
-                    bluetooth.lock().unwrap().adapter_state_changed(state);
-                }
+            // Handle the whole batch under one lock of each.
+            let mut bluetooth = bluetooth.lock().unwrap();
+            let mut bluetooth_gatt = bluetooth_gatt.lock().unwrap();
 
-                Message::BluetoothAdapterPropertiesChanged(status, num_properties, properties) => {
-                    bluetooth.lock().unwrap().adapter_properties_changed(
+            for m in messages.drain(..) {
+                match m {
+                    Message::BluetoothAdapterStateChanged(state) => {
+                        bluetooth.adapter_state_changed(state);
+                    }
+
+                    Message::BluetoothAdapterPropertiesChanged(
                         status,
                         num_properties,
                         properties,
-                    );
-                }
+                    ) => {
+                        bluetooth.adapter_properties_changed(status, num_properties, properties);
+                    }
+
+                    Message::BluetoothDeviceFound(n, properties) => {
+                        bluetooth.device_found(n, properties);
+                    }
+
+                    Message::BluetoothCallbackDisconnected(id) => {
+                        bluetooth.callback_disconnected(id);
+                    }
+
+                    Message::GattScannerRegistered(uuid, scanner_id, status) => {
+                        bluetooth_gatt.scanner_registered(uuid, scanner_id, status);
+                    }
 
-                Message::BluetoothCallbackDisconnected(id) => {
-                    bluetooth.lock().unwrap().callback_disconnected(id);
+                    Message::GattScanResult(result) => {
+                        bluetooth_gatt.scan_result(result);
+                    }
                 }
             }
         }
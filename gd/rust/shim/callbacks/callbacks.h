@@ -63,6 +63,16 @@ class OnceClosure {
   base::OnceClosure* closure_;
 };
 
+// Receives packets that Rust serializes straight into buffers of the C++ side,
+// so that they cross the bridge without a copy. Alloc() returns the buffer for
+// the next packet, which Deliver() then hands over.
+class u8BufferSink {
+ public:
+  virtual ~u8BufferSink() = default;
+  virtual ::rust::Slice<uint8_t> Alloc(size_t len) = 0;
+  virtual void Deliver() = 0;
+};
+
 using u8SliceCallback = TrampolineCallback<::rust::Slice<const uint8_t>>;
 using u8SliceOnceCallback = TrampolineOnceCallback<::rust::Slice<const uint8_t>>;
 
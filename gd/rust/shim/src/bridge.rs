@@ -21,6 +21,9 @@ pub mod ffi {
 
         // HCI
         fn hci_set_acl_callback(hci: &mut Hci, callback: UniquePtr<u8SliceCallback>);
+        fn hci_set_acl_sink(hci: &mut Hci, sink: UniquePtr<u8BufferSink>);
+        fn hci_set_evt_sink(hci: &mut Hci, sink: UniquePtr<u8BufferSink>);
+        fn hci_set_le_evt_sink(hci: &mut Hci, sink: UniquePtr<u8BufferSink>);
         fn hci_set_evt_callback(hci: &mut Hci, callback: UniquePtr<u8SliceCallback>);
         fn hci_set_le_evt_callback(hci: &mut Hci, callback: UniquePtr<u8SliceCallback>);
 
@@ -109,5 +112,9 @@ pub mod ffi {
 
         type u8SliceOnceCallback;
         fn Run(self: &u8SliceOnceCallback, data: &[u8]);
+
+        type u8BufferSink;
+        fn Alloc(self: Pin<&mut u8BufferSink>, len: usize) -> &mut [u8];
+        fn Deliver(self: Pin<&mut u8BufferSink>);
     }
 }
@@ -1,7 +1,7 @@
 //! Hci shim
 
 use crate::bridge::ffi;
-use bt_facade_helpers::U8SliceRunnable;
+use bt_facade_helpers::{U8BufferSink, U8SliceRunnable};
 use bt_hci::facade::HciFacadeService;
 use bt_packets::hci::{AclPacket, CommandPacket, Packet};
 use std::sync::Arc;
@@ -10,6 +10,7 @@ use tokio::runtime::Runtime;
 // we take ownership when we get the callbacks
 unsafe impl Send for ffi::u8SliceCallback {}
 unsafe impl Send for ffi::u8SliceOnceCallback {}
+unsafe impl Send for ffi::u8BufferSink {}
 
 struct CallbackWrapper {
     cb: cxx::UniquePtr<ffi::u8SliceCallback>,
@@ -21,6 +22,20 @@ impl U8SliceRunnable for CallbackWrapper {
     }
 }
 
+struct SinkWrapper {
+    sink: cxx::UniquePtr<ffi::u8BufferSink>,
+}
+
+impl U8BufferSink for SinkWrapper {
+    fn alloc(&mut self, len: usize) -> &mut [u8] {
+        self.sink.pin_mut().Alloc(len)
+    }
+
+    fn deliver(&mut self) {
+        self.sink.pin_mut().Deliver();
+    }
+}
+
 pub struct Hci {
     internal: HciFacadeService,
     rt: Arc<Runtime>,
@@ -87,3 +102,15 @@ pub fn hci_set_evt_callback(hci: &mut Hci, cb: cxx::UniquePtr<ffi::u8SliceCallba
 pub fn hci_set_le_evt_callback(hci: &mut Hci, cb: cxx::UniquePtr<ffi::u8SliceCallback>) {
     hci.internal.le_evt_rx.stream_runnable(&hci.rt, CallbackWrapper { cb });
 }
+
+pub fn hci_set_acl_sink(hci: &mut Hci, sink: cxx::UniquePtr<ffi::u8BufferSink>) {
+    hci.internal.acl_rx.stream_sink(&hci.rt, SinkWrapper { sink });
+}
+
+pub fn hci_set_evt_sink(hci: &mut Hci, sink: cxx::UniquePtr<ffi::u8BufferSink>) {
+    hci.internal.evt_rx.stream_sink(&hci.rt, SinkWrapper { sink });
+}
+
+pub fn hci_set_le_evt_sink(hci: &mut Hci, sink: cxx::UniquePtr<ffi::u8BufferSink>) {
+    hci.internal.le_evt_rx.stream_sink(&hci.rt, SinkWrapper { sink });
+}
@@ -16,6 +16,11 @@ mod ffi {
         fn btaa_hci_is_enabled() -> bool;
         fn gd_rust_is_enabled() -> bool;
         fn gd_link_policy_is_enabled() -> bool;
+        fn gd_hci_command_pipelining_is_enabled() -> bool;
+        fn gd_acl_fair_scheduler_is_enabled() -> bool;
+        fn gd_parallel_module_start_is_enabled() -> bool;
+        fn gd_reactor_busy_poll_is_enabled() -> bool;
+        fn gd_radio_scheduler_is_enabled() -> bool;
     }
 }
 
@@ -324,6 +324,12 @@ int BluetoothIntf::SspReply(const RustRawAddress& address, int ssp_variant, uint
   return intf_->ssp_reply(&addr, static_cast<bt_ssp_variant_t>(ssp_variant), accept, passkey);
 }
 
+const void* BluetoothIntf::GetProfileInterface(const char* profile_id) const {
+  if (!init_) return nullptr;
+
+  return intf_->get_profile_interface(profile_id);
+}
+
 std::unique_ptr<BluetoothIntf> Load() {
   // Don't allow the bluetooth interface to be allocated twice
   if (internal::g_btif) std::abort();
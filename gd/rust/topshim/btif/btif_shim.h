@@ -65,6 +65,9 @@ class BluetoothIntf {
   int PinReply(const RustRawAddress& address, uint8_t accept, uint8_t pin_len, const BtPinCode& code) const;
   int SspReply(const RustRawAddress& address, int ssp_variant, uint8_t accept, uint32_t passkey) const;
 
+  // Returns the native interface of a profile, for the profile shims.
+  const void* GetProfileInterface(const char* profile_id) const;
+
   ::rust::Box<RustCallbacks>& GetCallbacks() {
     return *callbacks_;
   }
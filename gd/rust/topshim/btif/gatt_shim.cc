@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gd/rust/topshim/btif/gatt_shim.h"
+
+#include <base/bind.h>
+#include <base/callback.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "include/hardware/bluetooth.h"
+#include "rust/cxx.h"
+#include "src/gatt.rs.h"
+
+namespace bluetooth {
+namespace topshim {
+namespace rust {
+namespace internal {
+// Like the adapter callbacks, the legacy scanner callbacks don't pass back a
+// pointer to the scanner, so there can only be one.
+static GattScannerIntf* g_scanner;
+
+namespace rusty = ::bluetooth::topshim::rust;
+
+static GattUuid to_rust_uuid(const bluetooth::Uuid& uuid) {
+  GattUuid ruuid;
+  const auto& bytes = uuid.To128BitBE();
+  std::copy(std::begin(bytes), std::end(bytes), std::begin(ruuid.uuid));
+
+  return ruuid;
+}
+
+static bluetooth::Uuid from_rust_uuid(const GattUuid& uuid) {
+  return bluetooth::Uuid::From128BitBE(uuid.uuid.data());
+}
+
+static void scanner_registered_cb(bluetooth::Uuid app_uuid, uint8_t scanner_id, uint8_t status) {
+  g_scanner->OnScannerRegistered(app_uuid, scanner_id, status);
+}
+
+static void scan_result_cb(
+    uint16_t event_type,
+    uint8_t addr_type,
+    RawAddress* bda,
+    uint8_t primary_phy,
+    uint8_t secondary_phy,
+    uint8_t advertising_sid,
+    int8_t tx_power,
+    int8_t rssi,
+    uint16_t periodic_adv_int,
+    std::vector<uint8_t> adv_data,
+    RawAddress* original_bda) {
+  g_scanner->OnScanResult(
+      event_type,
+      addr_type,
+      *bda,
+      primary_phy,
+      secondary_phy,
+      advertising_sid,
+      tx_power,
+      rssi,
+      periodic_adv_int,
+      std::move(adv_data));
+}
+
+// The GATT client and server are not used yet; btif checks each callback for
+// null before calling it.
+static const btgatt_client_callbacks_t g_client_callbacks = {};
+static const btgatt_server_callbacks_t g_server_callbacks = {};
+
+static const btgatt_scanner_callbacks_t g_scanner_callbacks = {
+    scan_result_cb,
+    nullptr,  // batchscan_reports_cb
+    nullptr,  // batchscan_threshold_cb
+    nullptr,  // track_adv_event_cb
+};
+
+static const btgatt_callbacks_t g_gatt_callbacks = {
+    sizeof(btgatt_callbacks_t),
+    &g_client_callbacks,
+    &g_server_callbacks,
+    &g_scanner_callbacks,
+};
+}  // namespace internal
+
+GattScannerIntf::GattScannerIntf(const btgatt_interface_t* gatt) : gatt_(gatt) {}
+
+GattScannerIntf::~GattScannerIntf() {
+  internal::g_scanner = nullptr;
+}
+
+bool GattScannerIntf::Initialize(::rust::Box<RustGattScannerCallbacks> callbacks) {
+  if (callbacks_) return true;
+
+  callbacks_ = std::make_unique<::rust::Box<RustGattScannerCallbacks>>(std::move(callbacks));
+  if (gatt_->init(&internal::g_gatt_callbacks) != BT_STATUS_SUCCESS) {
+    callbacks_.reset();
+    return false;
+  }
+
+  gatt_->scanner->RegisterCallbacks(this);
+  return true;
+}
+
+void GattScannerIntf::RegisterScanner(const GattUuid& uuid) const {
+  auto app_uuid = internal::from_rust_uuid(uuid);
+
+  gatt_->scanner->RegisterScanner(app_uuid, base::Bind(&internal::scanner_registered_cb, app_uuid));
+}
+
+void GattScannerIntf::Unregister(uint8_t scanner_id) const {
+  gatt_->scanner->Unregister(scanner_id);
+}
+
+void GattScannerIntf::Scan(bool start) const {
+  gatt_->scanner->Scan(start);
+}
+
+void GattScannerIntf::OnScannerRegistered(const bluetooth::Uuid app_uuid, uint8_t scanner_id, uint8_t status) {
+  if (!callbacks_) return;
+
+  internal::rusty::scanner_registered_callback(**callbacks_, internal::to_rust_uuid(app_uuid), scanner_id, status);
+}
+
+void GattScannerIntf::OnScanResult(
+    uint16_t event_type,
+    uint8_t addr_type,
+    RawAddress bda,
+    uint8_t primary_phy,
+    uint8_t secondary_phy,
+    uint8_t advertising_sid,
+    int8_t tx_power,
+    int8_t rssi,
+    uint16_t periodic_adv_int,
+    std::vector<uint8_t> adv_data) {
+  if (!callbacks_) return;
+
+  GattScanResult result;
+  result.event_type = event_type;
+  result.addr_type = addr_type;
+  std::copy(std::begin(bda.address), std::end(bda.address), std::begin(result.address));
+  result.primary_phy = primary_phy;
+  result.secondary_phy = secondary_phy;
+  result.advertising_sid = advertising_sid;
+  result.tx_power = tx_power;
+  result.rssi = rssi;
+  result.periodic_adv_int = periodic_adv_int;
+  result.adv_data.reserve(adv_data.size());
+  for (auto byte : adv_data) {
+    result.adv_data.push_back(byte);
+  }
+
+  internal::rusty::scan_result_callback(**callbacks_, std::move(result));
+}
+
+std::unique_ptr<GattScannerIntf> GetGattScannerIntf(const BluetoothIntf& btif) {
+  // Don't allow the scanner to be allocated twice
+  if (internal::g_scanner) std::abort();
+
+  auto gatt = static_cast<const btgatt_interface_t*>(btif.GetProfileInterface(BT_PROFILE_GATT_ID));
+  if (!gatt) return nullptr;
+
+  auto scanner = std::make_unique<GattScannerIntf>(gatt);
+  internal::g_scanner = scanner.get();
+  return scanner;
+}
+
+}  // namespace rust
+}  // namespace topshim
+}  // namespace bluetooth
@@ -337,6 +337,11 @@ impl BluetoothInterface {
     pub fn get_connection_state(&mut self, address: &ffi::RustRawAddress) -> i32 {
         self.internal.GetConnectionState(address)
     }
+
+    /// Returns the C++ interface, for the profile shims.
+    pub(crate) fn as_ffi(&self) -> &ffi::BluetoothIntf {
+        self.internal.as_ref().unwrap()
+    }
 }
 
 unsafe impl Send for BluetoothInterface {}
@@ -0,0 +1,122 @@
+//! GATT interface shim
+//!
+//! Shim for the LE scanner of the native GATT interface. The scanner events come in on the native
+//! JNI thread.
+
+use crate::btif::BluetoothInterface;
+
+#[cxx::bridge(namespace = bluetooth::topshim::rust)]
+pub mod ffi {
+    pub struct GattUuid {
+        uuid: [u8; 16],
+    }
+
+    pub struct GattScanResult {
+        event_type: u16,
+        addr_type: u8,
+        address: [u8; 6],
+        primary_phy: u8,
+        secondary_phy: u8,
+        advertising_sid: u8,
+        tx_power: i8,
+        rssi: i8,
+        periodic_adv_int: u16,
+        adv_data: Vec<u8>,
+    }
+
+    unsafe extern "C++" {
+        include!("btif/gatt_shim.h");
+
+        type BluetoothIntf = crate::btif::ffi::BluetoothIntf;
+
+        // Opaque type meant to represent the C++ LE scanner shim.
+        type GattScannerIntf;
+
+        // Returns null if the stack is not initialized or has no GATT interface.
+        fn GetGattScannerIntf(btif: &BluetoothIntf) -> UniquePtr<GattScannerIntf>;
+
+        fn Initialize(
+            self: Pin<&mut GattScannerIntf>,
+            callbacks: Box<RustGattScannerCallbacks>,
+        ) -> bool;
+
+        fn RegisterScanner(&self, uuid: &GattUuid);
+        fn Unregister(&self, scanner_id: u8);
+        fn Scan(&self, start: bool);
+    }
+
+    extern "Rust" {
+        type RustGattScannerCallbacks;
+
+        fn scanner_registered_callback(
+            cb: &RustGattScannerCallbacks,
+            uuid: GattUuid,
+            scanner_id: u8,
+            status: u8,
+        );
+        fn scan_result_callback(cb: &RustGattScannerCallbacks, result: GattScanResult);
+    }
+
+    unsafe impl Box<RustGattScannerCallbacks> {}
+}
+
+/// Rust struct of closures for the LE scanner callbacks from C++.
+pub struct GattScannerCallbacks {
+    pub scanner_registered: Box<dyn Fn([u8; 16], u8, u8) + Send>,
+    pub scan_result: Box<dyn Fn(ffi::GattScanResult) + Send>,
+}
+
+pub struct RustGattScannerCallbacks {
+    inner: GattScannerCallbacks,
+}
+
+/// Rust interface to the native LE scanner.
+pub struct GattScanner {
+    internal: cxx::UniquePtr<ffi::GattScannerIntf>,
+}
+
+impl GattScanner {
+    /// Gets the LE scanner of an initialized Bluetooth interface.
+    pub fn new(intf: &BluetoothInterface) -> Option<GattScanner> {
+        let internal = ffi::GetGattScannerIntf(intf.as_ffi());
+        if internal.is_null() {
+            return None;
+        }
+
+        Some(GattScanner { internal })
+    }
+
+    /// Initializes the native GATT interface with the scanner callbacks.
+    pub fn initialize(&mut self, callbacks: GattScannerCallbacks) -> bool {
+        self.internal.pin_mut().Initialize(Box::new(RustGattScannerCallbacks { inner: callbacks }))
+    }
+
+    /// Registers a scanner for `uuid`. Triggers a scanner_registered callback.
+    pub fn register_scanner(&mut self, uuid: [u8; 16]) {
+        self.internal.RegisterScanner(&ffi::GattUuid { uuid })
+    }
+
+    pub fn unregister(&mut self, scanner_id: u8) {
+        self.internal.Unregister(scanner_id)
+    }
+
+    /// Starts or stops LE scanning. Scan results trigger scan_result callbacks.
+    pub fn scan(&mut self, start: bool) {
+        self.internal.Scan(start)
+    }
+}
+
+unsafe impl Send for GattScanner {}
+
+fn scanner_registered_callback(
+    cb: &RustGattScannerCallbacks,
+    uuid: ffi::GattUuid,
+    scanner_id: u8,
+    status: u8,
+) {
+    (cb.inner.scanner_registered)(uuid.uuid, scanner_id, status);
+}
+
+fn scan_result_callback(cb: &RustGattScannerCallbacks, result: ffi::GattScanResult) {
+    (cb.inner.scan_result)(result);
+}
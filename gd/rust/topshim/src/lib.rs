@@ -5,4 +5,5 @@ extern crate lazy_static;
 extern crate num_derive;
 
 pub mod btif;
+pub mod gatt;
 pub mod topstack;
@@ -2,8 +2,10 @@
 //!
 //! Helpers for dealing with the stack on top of the Bluetooth interface.
 
-use std::sync::Arc;
+use std::collections::VecDeque;
+use std::sync::{Arc, Condvar, Mutex, MutexGuard};
 use tokio::runtime::{Builder, Runtime};
+use tokio::sync::Notify;
 
 lazy_static! {
     // Shared runtime for topshim handlers. All async tasks will get run by this
@@ -21,3 +23,238 @@ lazy_static! {
 pub fn get_runtime() -> Arc<Runtime> {
     RUNTIME.clone()
 }
+
+struct EventRingState<T> {
+    events: VecDeque<T>,
+    capacity: usize,
+    senders: usize,
+    receiver_alive: bool,
+}
+
+struct EventRing<T> {
+    state: Mutex<EventRingState<T>>,
+    // Wakes the receiver when the ring stops being empty.
+    notify: Notify,
+    // Wake the blocking and the async senders when a full ring has room again.
+    space: Condvar,
+    space_notify: Notify,
+}
+
+/// Creates a ring passing events from topshim callbacks to a stack dispatch loop.
+///
+/// The events are kept inline in a ring of `capacity` events allocated up front, so passing an
+/// event neither boxes it nor spawns a task to send it, and the dispatch loop takes all the pending
+/// events at once with `EventReceiver::recv_batch`.
+///
+/// The ring never grows. A sender finding it full waits for the dispatch loop to make room, which
+/// keeps the backpressure of a bounded channel: `EventSender::send` blocks the calling thread, for
+/// the native callback threads, and `EventSender::send_async` waits in a task, for the producers
+/// running on the runtime that also runs the dispatch loop.
+pub fn event_ring<T>(capacity: usize) -> (EventSender<T>, EventReceiver<T>) {
+    assert!(capacity > 0, "an event ring needs room for at least one event");
+
+    let ring = Arc::new(EventRing {
+        state: Mutex::new(EventRingState {
+            events: VecDeque::with_capacity(capacity),
+            capacity,
+            senders: 1,
+            receiver_alive: true,
+        }),
+        notify: Notify::new(),
+        space: Condvar::new(),
+        space_notify: Notify::new(),
+    });
+
+    (EventSender { ring: ring.clone() }, EventReceiver { ring })
+}
+
+/// The sending side of an `event_ring`, which can be cloned for each producer.
+pub struct EventSender<T> {
+    ring: Arc<EventRing<T>>,
+}
+
+impl<T> EventSender<T> {
+    /// Adds an event to the ring, blocking the calling thread while the ring is full. Returns the
+    /// event back if the receiver is gone.
+    ///
+    /// Must not be called from the runtime running the receiver, use `send_async` there.
+    pub fn send(&self, event: T) -> Result<(), T> {
+        let mut state = self.ring.state.lock().unwrap();
+        while state.receiver_alive && state.events.len() >= state.capacity {
+            state = self.ring.space.wait(state).unwrap();
+        }
+
+        self.push(state, event)
+    }
+
+    /// Adds an event to the ring, waiting without blocking the runtime while the ring is full.
+    /// Returns the event back if the receiver is gone.
+    pub async fn send_async(&self, event: T) -> Result<(), T> {
+        loop {
+            // Registered before checking for room, so that a receive in between still wakes it.
+            let space = self.ring.space_notify.notified();
+
+            {
+                let state = self.ring.state.lock().unwrap();
+                if !state.receiver_alive || state.events.len() < state.capacity {
+                    return self.push(state, event);
+                }
+            }
+
+            space.await;
+        }
+    }
+
+    fn push(&self, mut state: MutexGuard<EventRingState<T>>, event: T) -> Result<(), T> {
+        if !state.receiver_alive {
+            return Err(event);
+        }
+
+        // The receiver only waits once it has found the ring empty.
+        let was_empty = state.events.is_empty();
+        state.events.push_back(event);
+        drop(state);
+
+        if was_empty {
+            self.ring.notify.notify_one();
+        }
+
+        Ok(())
+    }
+}
+
+impl<T> Clone for EventSender<T> {
+    fn clone(&self) -> Self {
+        self.ring.state.lock().unwrap().senders += 1;
+        EventSender { ring: self.ring.clone() }
+    }
+}
+
+impl<T> Drop for EventSender<T> {
+    fn drop(&mut self) {
+        let mut state = self.ring.state.lock().unwrap();
+        state.senders -= 1;
+        if state.senders == 0 {
+            drop(state);
+            self.ring.notify.notify_one();
+        }
+    }
+}
+
+/// The receiving side of an `event_ring`.
+pub struct EventReceiver<T> {
+    ring: Arc<EventRing<T>>,
+}
+
+impl<T> EventReceiver<T> {
+    /// Waits for events and moves up to `max` of them to `events`.
+    ///
+    /// Returns false once all senders are gone and the ring is empty.
+    pub async fn recv_batch(&mut self, events: &mut Vec<T>, max: usize) -> bool {
+        loop {
+            {
+                let mut state = self.ring.state.lock().unwrap();
+                if !state.events.is_empty() {
+                    let was_full = state.events.len() >= state.capacity;
+                    let count = std::cmp::min(max, state.events.len());
+                    events.extend(state.events.drain(..count));
+                    drop(state);
+
+                    if was_full {
+                        self.ring.space.notify_all();
+                        self.ring.space_notify.notify_waiters();
+                    }
+
+                    return true;
+                }
+
+                if state.senders == 0 {
+                    return false;
+                }
+            }
+
+            self.ring.notify.notified().await;
+        }
+    }
+}
+
+impl<T> Drop for EventReceiver<T> {
+    fn drop(&mut self) {
+        let mut state = self.ring.state.lock().unwrap();
+        state.receiver_alive = false;
+        state.events.clear();
+        drop(state);
+
+        // Senders waiting for room get their events back.
+        self.ring.space.notify_all();
+        self.ring.space_notify.notify_waiters();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::thread;
+    use std::time::Duration;
+
+    fn test_runtime() -> Runtime {
+        Builder::new_current_thread().enable_all().build().unwrap()
+    }
+
+    #[test]
+    fn send_blocks_while_ring_is_full() {
+        let rt = test_runtime();
+        let (tx, mut rx) = event_ring::<u32>(2);
+        let producer = thread::spawn(move || {
+            for i in 0..10 {
+                tx.send(i).unwrap();
+            }
+        });
+
+        let mut received = vec![];
+        rt.block_on(async {
+            let mut batch = vec![];
+            while rx.recv_batch(&mut batch, 8).await {
+                // The ring never holds more than its capacity.
+                assert!(batch.len() <= 2);
+                received.append(&mut batch);
+            }
+        });
+
+        producer.join().unwrap();
+        assert_eq!(received, (0..10).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn send_async_waits_for_room() {
+        let rt = test_runtime();
+        let (tx, mut rx) = event_ring::<u32>(1);
+        rt.block_on(async {
+            tx.send_async(1).await.unwrap();
+            let tx2 = tx.clone();
+            let pending = tokio::spawn(async move { tx2.send_async(2).await });
+            tokio::task::yield_now().await;
+            assert!(!pending.is_finished());
+
+            let mut batch = vec![];
+            assert!(rx.recv_batch(&mut batch, 8).await);
+            assert_eq!(batch, vec![1]);
+            assert_eq!(pending.await.unwrap(), Ok(()));
+
+            batch.clear();
+            assert!(rx.recv_batch(&mut batch, 8).await);
+            assert_eq!(batch, vec![2]);
+        });
+    }
+
+    #[test]
+    fn dropping_receiver_releases_blocked_sender() {
+        let (tx, rx) = event_ring::<u32>(1);
+        tx.send(1).unwrap();
+        let producer = thread::spawn(move || tx.send(2));
+
+        thread::sleep(Duration::from_millis(50));
+        drop(rx);
+        assert_eq!(producer.join().unwrap(), Err(2));
+    }
+}
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "security/ecc/multprecision.h"
+#include "security/ecc/p_256_engine.h"
 
 namespace bluetooth {
 namespace security {
@@ -240,6 +241,16 @@ void ECC_PointMult_Bin_NAF(Point* q, const Point* p, uint32_t* n) {
   multiprecision_mersenns_mult_mod(q->y, q->y, q->z, modp);
 }
 
+void ECC_PointMult(Point* q, const Point* p, uint32_t* n) {
+  if (memcmp(p->x, curve_p256.G.x, sizeof(p->x)) == 0 && memcmp(p->y, curve_p256.G.y, sizeof(p->y)) == 0) {
+    P256ScalarMultBase(n, q->x, q->y);
+  } else {
+    P256ScalarMult(n, p->x, p->y, q->x, q->y);
+  }
+  multiprecision_init(q->z);
+  q->z[0] = 1;
+}
+
 bool ECC_ValidatePoint(const Point& pt) {
   // Ensure y^2 = x^3 + a*x + b (mod p); a = -3
 
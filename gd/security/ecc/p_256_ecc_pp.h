@@ -69,7 +69,9 @@ bool ECC_ValidatePoint(const Point& point);
 
 void ECC_PointMult_Bin_NAF(Point* q, const Point* p, uint32_t* n);
 
-#define ECC_PointMult(q, p, n) ECC_PointMult_Bin_NAF(q, p, n)
+// q = n * p, in constant time. Multiples of the base point curve_p256.G use its precomputed tables. q->z is set to 1
+// and n is left untouched.
+void ECC_PointMult(Point* q, const Point* p, uint32_t* n);
 
 }  // namespace ecc
 }  // namespace security
@@ -0,0 +1,476 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+
+// Constant-time P-256 scalar multiplication, shared by the legacy SMP and the GD security module.
+//
+// Field elements are kept in Montgomery form on four 64-bit limbs and points in Jacobian coordinates. Scalars are
+// recoded into signed 5-bit windows, so every multiplication runs the same sequence of field operations and table
+// scans whatever the scalar is. Multiples of the base point use precomputed affine tables, one per window, and need
+// no doublings at all.
+//
+// Scalars and coordinates are eight 32-bit words, least significant word first, like the Point of p_256_ecc_pp.h.
+// The point at infinity comes out as (0, 0).
+namespace p256 {
+
+using Fe = uint64_t[4];
+
+constexpr int kWindowBits = 5;
+constexpr int kNumWindows = (256 + kWindowBits) / kWindowBits;  // 52, the top one takes the carry of the recoding
+constexpr int kTableSize = 1 << (kWindowBits - 1);              // multiples 1..16 of a point
+
+constexpr uint64_t kP[4] = {0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000, 0xffffffff00000001};
+constexpr uint64_t kPMinus2[4] = {0xfffffffffffffffd, 0x00000000ffffffff, 0x0000000000000000, 0xffffffff00000001};
+// R mod p and R^2 mod p, with R = 2^256
+constexpr uint64_t kOne[4] = {0x0000000000000001, 0xffffffff00000000, 0xffffffffffffffff, 0x00000000fffffffe};
+constexpr uint64_t kRR[4] = {0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe, 0x00000004fffffffd};
+
+constexpr uint32_t kGx[8] = {
+    0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2};
+constexpr uint32_t kGy[8] = {
+    0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2};
+
+inline uint64_t AddCarry(uint64_t a, uint64_t b, uint64_t carry_in, uint64_t* carry_out) {
+  uint64_t sum = a + carry_in;
+  uint64_t carry = sum < carry_in;
+  sum += b;
+  *carry_out = carry + (sum < b);
+  return sum;
+}
+
+inline uint64_t SubBorrow(uint64_t a, uint64_t b, uint64_t borrow_in, uint64_t* borrow_out) {
+  uint64_t diff = a - b;
+  uint64_t borrow = a < b;
+  *borrow_out = borrow | (diff < borrow_in);
+  return diff - borrow_in;
+}
+
+// Returns the low half of a * b and stores the high half in |hi|
+inline uint64_t MulWide(uint64_t a, uint64_t b, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+  *hi = static_cast<uint64_t>(product >> 64);
+  return static_cast<uint64_t>(product);
+#else
+  uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+  uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo;
+  uint64_t hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+  *hi = (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi;
+  return (cross << 32) | (lo_lo & 0xffffffff);
+#endif
+}
+
+// All ones if |a| is zero, zero otherwise
+inline uint64_t IsZeroMask(uint64_t a) {
+  return ((a | (0 - a)) >> 63) - 1;
+}
+
+inline uint64_t FeIsZero(const Fe a) {
+  return IsZeroMask(a[0] | a[1] | a[2] | a[3]);
+}
+
+inline void FeCopy(Fe r, const Fe a) {
+  for (int i = 0; i < 4; i++) r[i] = a[i];
+}
+
+// r = mask ? a : r
+inline void FeSelect(Fe r, const Fe a, uint64_t mask) {
+  for (int i = 0; i < 4; i++) r[i] = (a[i] & mask) | (r[i] & ~mask);
+}
+
+// r = carry * 2^256 + t mod p, for carry * 2^256 + t < 2p
+inline void FeReduceOnce(Fe r, const uint64_t t[4], uint64_t carry) {
+  uint64_t d[4];
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) d[i] = SubBorrow(t[i], kP[i], borrow, &borrow);
+  uint64_t keep_t = 0 - (borrow & ~carry & 1);
+  for (int i = 0; i < 4; i++) r[i] = (t[i] & keep_t) | (d[i] & ~keep_t);
+}
+
+inline void FeAdd(Fe r, const Fe a, const Fe b) {
+  uint64_t t[4];
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) t[i] = AddCarry(a[i], b[i], carry, &carry);
+  FeReduceOnce(r, t, carry);
+}
+
+inline void FeSub(Fe r, const Fe a, const Fe b) {
+  uint64_t t[4];
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) t[i] = SubBorrow(a[i], b[i], borrow, &borrow);
+  uint64_t mask = 0 - borrow;
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) r[i] = AddCarry(t[i], kP[i] & mask, carry, &carry);
+}
+
+// r = a * b / R mod p. The lowest limb of p is all ones, so -p^-1 mod 2^64 is 1 and the Montgomery factor of each
+// round is the lowest limb itself.
+inline void FeMul(Fe r, const Fe a, const Fe b) {
+  uint64_t t[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < 4; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < 4; j++) {
+      uint64_t hi, c1, c2;
+      uint64_t lo = MulWide(a[j], b[i], &hi);
+      lo = AddCarry(lo, t[j], 0, &c1);
+      t[j] = AddCarry(lo, carry, 0, &c2);
+      carry = hi + c1 + c2;
+    }
+    uint64_t c3;
+    t[4] = AddCarry(t[4], carry, 0, &c3);
+    t[5] = c3;
+
+    uint64_t m = t[0];
+    carry = 0;
+    for (int j = 0; j < 4; j++) {
+      uint64_t hi, c1, c2;
+      uint64_t lo = MulWide(m, kP[j], &hi);
+      lo = AddCarry(lo, t[j], 0, &c1);
+      lo = AddCarry(lo, carry, 0, &c2);
+      if (j > 0) t[j - 1] = lo;
+      carry = hi + c1 + c2;
+    }
+    t[3] = AddCarry(t[4], carry, 0, &c3);
+    t[4] = t[5] + c3;
+  }
+  FeReduceOnce(r, t, t[4]);
+}
+
+inline void FeSqr(Fe r, const Fe a) {
+  FeMul(r, a, a);
+}
+
+// r = a^(p - 2) = a^-1, zero for zero. The exponent is public, so the ladder does not need to hide it.
+inline void FeInv(Fe r, const Fe a) {
+  uint64_t acc[4];
+  FeCopy(acc, kOne);
+  for (int bit = 255; bit >= 0; bit--) {
+    FeSqr(acc, acc);
+    if ((kPMinus2[bit / 64] >> (bit % 64)) & 1) FeMul(acc, acc, a);
+  }
+  FeCopy(r, acc);
+}
+
+inline void FeFromWords(Fe r, const uint32_t words[8]) {
+  uint64_t t[4];
+  for (int i = 0; i < 4; i++) t[i] = words[2 * i] | static_cast<uint64_t>(words[2 * i + 1]) << 32;
+  FeReduceOnce(t, t, 0);
+  FeMul(r, t, kRR);
+}
+
+inline void FeToWords(uint32_t words[8], const Fe a) {
+  const uint64_t one[4] = {1, 0, 0, 0};
+  uint64_t t[4];
+  FeMul(t, a, one);
+  for (int i = 0; i < 4; i++) {
+    words[2 * i] = static_cast<uint32_t>(t[i]);
+    words[2 * i + 1] = static_cast<uint32_t>(t[i] >> 32);
+  }
+}
+
+// Jacobian (X, Y, Z) is the affine point (X / Z^2, Y / Z^3); Z = 0 is the point at infinity
+struct JacobianPoint {
+  Fe x, y, z;
+};
+
+struct AffinePoint {
+  Fe x, y;
+};
+
+// r = 2p, with a = -3 (dbl-2001-b)
+inline void PointDouble(JacobianPoint* r, const JacobianPoint& p) {
+  uint64_t delta[4], gamma[4], beta[4], alpha[4], t0[4], t1[4];
+  FeSqr(delta, p.z);
+  FeSqr(gamma, p.y);
+  FeMul(beta, p.x, gamma);
+  FeSub(t0, p.x, delta);
+  FeAdd(t1, p.x, delta);
+  FeMul(t0, t0, t1);
+  FeAdd(alpha, t0, t0);
+  FeAdd(alpha, alpha, t0);
+
+  uint64_t x3[4], y3[4], z3[4];
+  FeAdd(t0, beta, beta);
+  FeAdd(t0, t0, t0);  // 4 beta
+  FeSqr(x3, alpha);
+  FeSub(x3, x3, t0);
+  FeSub(x3, x3, t0);
+
+  FeAdd(z3, p.y, p.z);
+  FeSqr(z3, z3);
+  FeSub(z3, z3, gamma);
+  FeSub(z3, z3, delta);
+
+  FeSub(y3, t0, x3);
+  FeMul(y3, alpha, y3);
+  FeSqr(t1, gamma);
+  FeAdd(t1, t1, t1);
+  FeAdd(t1, t1, t1);
+  FeAdd(t1, t1, t1);  // 8 gamma^2
+  FeSub(y3, y3, t1);
+
+  FeCopy(r->x, x3);
+  FeCopy(r->y, y3);
+  FeCopy(r->z, z3);
+}
+
+// r = a + b (add-2007-bl). Either side may be the point at infinity, which is picked up with masks. When a == b the
+// formula degenerates and the doubling is taken instead; the scalar multiplications only get there for negligibly few
+// scalars, which is the one data dependent branch.
+inline void PointAdd(JacobianPoint* r, const JacobianPoint& a, const JacobianPoint& b) {
+  uint64_t z1z1[4], z2z2[4], u1[4], u2[4], s1[4], s2[4], h[4], rr[4];
+  FeSqr(z1z1, a.z);
+  FeSqr(z2z2, b.z);
+  FeMul(u1, a.x, z2z2);
+  FeMul(u2, b.x, z1z1);
+  FeMul(s1, b.z, z2z2);
+  FeMul(s1, a.y, s1);
+  FeMul(s2, a.z, z1z1);
+  FeMul(s2, b.y, s2);
+  FeSub(h, u2, u1);
+  FeSub(rr, s2, s1);
+
+  uint64_t a_is_infinity = FeIsZero(a.z);
+  uint64_t b_is_infinity = FeIsZero(b.z);
+  if (FeIsZero(h) & FeIsZero(rr) & ~a_is_infinity & ~b_is_infinity) {
+    PointDouble(r, a);
+    return;
+  }
+
+  uint64_t i[4], j[4], v[4], t[4];
+  FeAdd(i, h, h);
+  FeSqr(i, i);
+  FeMul(j, h, i);
+  FeAdd(rr, rr, rr);
+  FeMul(v, u1, i);
+
+  JacobianPoint sum;
+  FeSqr(sum.x, rr);
+  FeSub(sum.x, sum.x, j);
+  FeSub(sum.x, sum.x, v);
+  FeSub(sum.x, sum.x, v);
+
+  FeSub(sum.y, v, sum.x);
+  FeMul(sum.y, rr, sum.y);
+  FeMul(t, s1, j);
+  FeAdd(t, t, t);
+  FeSub(sum.y, sum.y, t);
+
+  FeAdd(sum.z, a.z, b.z);
+  FeSqr(sum.z, sum.z);
+  FeSub(sum.z, sum.z, z1z1);
+  FeSub(sum.z, sum.z, z2z2);
+  FeMul(sum.z, sum.z, h);
+
+  FeSelect(sum.x, b.x, a_is_infinity);
+  FeSelect(sum.y, b.y, a_is_infinity);
+  FeSelect(sum.z, b.z, a_is_infinity);
+  FeSelect(sum.x, a.x, b_is_infinity);
+  FeSelect(sum.y, a.y, b_is_infinity);
+  FeSelect(sum.z, a.z, b_is_infinity);
+  *r = sum;
+}
+
+// Returns the six scalar bits [pos, pos + 5] as a window, bit -1 being zero
+inline uint32_t ScalarWindow(const uint64_t k[4], int pos) {
+  if (pos < 0) return static_cast<uint32_t>(k[0] << 1) & 0x3f;
+  int limb = pos / 64;
+  int shift = pos % 64;
+  uint64_t bits = k[limb] >> shift;
+  if (shift > 64 - 6 && limb < 3) bits |= k[limb + 1] << (64 - shift);
+  return static_cast<uint32_t>(bits) & 0x3f;
+}
+
+// Booth recoding of a window into a digit in [-16, 16], returned as its magnitude and sign
+inline void RecodeWindow(uint32_t window, uint32_t* digit, uint32_t* negative) {
+  uint32_t sign = 0 - (window >> kWindowBits);  // all ones if the top bit is set
+  uint32_t d = ((1 << (kWindowBits + 1)) - window - 1) & sign;
+  d |= window & ~sign;
+  *digit = (d >> 1) + (d & 1);
+  *negative = sign & 1;
+}
+
+// Conditionally negates y, in constant time
+inline void FeCondNeg(Fe y, uint32_t negative) {
+  const uint64_t zero[4] = {0, 0, 0, 0};
+  uint64_t minus_y[4];
+  FeSub(minus_y, zero, y);
+  FeSelect(y, minus_y, 0 - static_cast<uint64_t>(negative));
+}
+
+// Reads table[digit - 1], or the point at infinity for digit 0, scanning the whole table
+inline void SelectJacobian(JacobianPoint* r, const JacobianPoint table[kTableSize], uint32_t digit) {
+  *r = JacobianPoint{};
+  for (uint32_t i = 0; i < kTableSize; i++) {
+    uint64_t mask = IsZeroMask((i + 1) ^ digit);
+    FeSelect(r->x, table[i].x, mask);
+    FeSelect(r->y, table[i].y, mask);
+    FeSelect(r->z, table[i].z, mask);
+  }
+}
+
+inline void SelectAffine(JacobianPoint* r, const AffinePoint table[kTableSize], uint32_t digit) {
+  *r = JacobianPoint{};
+  for (uint32_t i = 0; i < kTableSize; i++) {
+    uint64_t mask = IsZeroMask((i + 1) ^ digit);
+    FeSelect(r->x, table[i].x, mask);
+    FeSelect(r->y, table[i].y, mask);
+  }
+  FeSelect(r->z, kOne, ~IsZeroMask(digit));
+}
+
+inline void ScalarFromWords(uint64_t k[4], const uint32_t words[8]) {
+  for (int i = 0; i < 4; i++) k[i] = words[2 * i] | static_cast<uint64_t>(words[2 * i + 1]) << 32;
+}
+
+inline void ToAffineWords(const JacobianPoint& p, uint32_t x[8], uint32_t y[8]) {
+  uint64_t z_inv[4], z_inv2[4], t[4];
+  FeInv(z_inv, p.z);
+  FeSqr(z_inv2, z_inv);
+  FeMul(t, p.x, z_inv2);
+  FeToWords(x, t);
+  FeMul(z_inv2, z_inv2, z_inv);
+  FeMul(t, p.y, z_inv2);
+  FeToWords(y, t);
+}
+
+// Affine multiples of the base point: window i holds j * 2^(5i) * G for j = 1..16, so that k * G is the sum of one
+// entry per window
+class BaseTable {
+ public:
+  static const BaseTable& Get() {
+    // Built on first use and never freed, like the other lazily created singletons
+    static const BaseTable* table = new BaseTable();
+    return *table;
+  }
+
+  const AffinePoint* Window(int i) const {
+    return points_[i];
+  }
+
+ private:
+  BaseTable() {
+    static_assert(kNumWindows * kTableSize > 0, "empty table");
+    JacobianPoint* jacobian = new JacobianPoint[kNumWindows * kTableSize];
+    JacobianPoint base;
+    FeFromWords(base.x, kGx);
+    FeFromWords(base.y, kGy);
+    FeCopy(base.z, kOne);
+    for (int i = 0; i < kNumWindows; i++) {
+      JacobianPoint* window = &jacobian[i * kTableSize];
+      window[0] = base;
+      PointDouble(&window[1], base);
+      for (int j = 2; j < kTableSize; j++) PointAdd(&window[j], window[j - 1], base);
+      for (int j = 0; j < kWindowBits; j++) PointDouble(&base, base);
+    }
+
+    // One inversion for the whole table: prefix products of the Z coordinates, inverted once and unwound backwards
+    constexpr int kNumPoints = kNumWindows * kTableSize;
+    uint64_t(*prefix)[4] = new uint64_t[kNumPoints][4];
+    FeCopy(prefix[0], jacobian[0].z);
+    for (int i = 1; i < kNumPoints; i++) FeMul(prefix[i], prefix[i - 1], jacobian[i].z);
+    uint64_t inv[4];
+    FeInv(inv, prefix[kNumPoints - 1]);
+    for (int i = kNumPoints - 1; i >= 0; i--) {
+      uint64_t z_inv[4], z_inv2[4];
+      if (i > 0) {
+        FeMul(z_inv, inv, prefix[i - 1]);
+        FeMul(inv, inv, jacobian[i].z);
+      } else {
+        FeCopy(z_inv, inv);
+      }
+      AffinePoint* point = &points_[i / kTableSize][i % kTableSize];
+      FeSqr(z_inv2, z_inv);
+      FeMul(point->x, jacobian[i].x, z_inv2);
+      FeMul(z_inv2, z_inv2, z_inv);
+      FeMul(point->y, jacobian[i].y, z_inv2);
+    }
+    delete[] prefix;
+    delete[] jacobian;
+  }
+
+  AffinePoint points_[kNumWindows][kTableSize];
+};
+
+inline void MultBase(const uint32_t k[8], uint32_t x[8], uint32_t y[8]) {
+  const BaseTable& table = BaseTable::Get();
+  uint64_t scalar[4];
+  ScalarFromWords(scalar, k);
+
+  JacobianPoint acc{};
+  for (int i = 0; i < kNumWindows; i++) {
+    uint32_t digit, negative;
+    RecodeWindow(ScalarWindow(scalar, kWindowBits * i - 1), &digit, &negative);
+    JacobianPoint entry;
+    SelectAffine(&entry, table.Window(i), digit);
+    FeCondNeg(entry.y, negative);
+    PointAdd(&acc, acc, entry);
+  }
+  ToAffineWords(acc, x, y);
+}
+
+inline void Mult(const uint32_t k[8], const uint32_t px[8], const uint32_t py[8], uint32_t x[8], uint32_t y[8]) {
+  uint64_t scalar[4];
+  ScalarFromWords(scalar, k);
+
+  JacobianPoint table[kTableSize];
+  FeFromWords(table[0].x, px);
+  FeFromWords(table[0].y, py);
+  FeCopy(table[0].z, kOne);
+  PointDouble(&table[1], table[0]);
+  for (int j = 2; j < kTableSize; j++) PointAdd(&table[j], table[j - 1], table[0]);
+
+  JacobianPoint acc{};
+  for (int i = kNumWindows - 1; i >= 0; i--) {
+    if (i != kNumWindows - 1) {
+      for (int j = 0; j < kWindowBits; j++) PointDouble(&acc, acc);
+    }
+    uint32_t digit, negative;
+    RecodeWindow(ScalarWindow(scalar, kWindowBits * i - 1), &digit, &negative);
+    JacobianPoint entry;
+    SelectJacobian(&entry, table, digit);
+    FeCondNeg(entry.y, negative);
+    PointAdd(&acc, acc, entry);
+  }
+  ToAffineWords(acc, x, y);
+}
+
+}  // namespace p256
+
+// (x, y) = k * G
+inline void P256ScalarMultBase(const uint32_t k[8], uint32_t x[8], uint32_t y[8]) {
+  p256::MultBase(k, x, y);
+}
+
+// (x, y) = k * (px, py), for a point (px, py) on the curve
+inline void P256ScalarMult(
+    const uint32_t k[8], const uint32_t px[8], const uint32_t py[8], uint32_t x[8], uint32_t y[8]) {
+  p256::Mult(k, px, py, x, y);
+}
+
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
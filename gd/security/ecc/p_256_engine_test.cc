@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "security/ecc/p_256_engine.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+#include "security/ecc/p_256_ecc_pp.h"
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace {
+
+// Test data from Bluetooth Core Specification Version 5.0 | Vol 2, Part G | 7.1.2
+constexpr uint32_t kPrivateA[8] = {
+    0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b, 0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+constexpr uint32_t kPublicAx[8] = {
+    0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111, 0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2};
+constexpr uint32_t kPublicAy[8] = {
+    0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2, 0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49};
+constexpr uint32_t kPublicBx[8] = {
+    0x2faaa190, 0x559077b2, 0x8615a69f, 0x47b58afd, 0xf19e4c00, 0x09592284, 0x1faf1d96, 0x1ea1f0f0};
+constexpr uint32_t kPublicBy[8] = {
+    0x15b1214a, 0x5f89aff9, 0xe28e3676, 0x472d1130, 0x9ab85160, 0x7356703a, 0x429dad37, 0x4c55f33e};
+constexpr uint32_t kDhKey[8] = {
+    0x73bfa698, 0x868d34f3, 0xb4f866f1, 0x99796b13, 0x0a397d9b, 0x341010a6, 0x57c8ad05, 0xec0234a3};
+
+// Random scalars below the order of the curve
+void RandomScalar(std::mt19937* rng, uint32_t k[8]) {
+  for (int i = 0; i < 8; i++) k[i] = (*rng)();
+  k[7] &= 0x7fffffff;
+}
+
+TEST(P256EngineTest, base_point_matches_spec) {
+  uint32_t x[8], y[8];
+  P256ScalarMultBase(kPrivateA, x, y);
+  EXPECT_EQ(0, memcmp(x, kPublicAx, sizeof(x)));
+  EXPECT_EQ(0, memcmp(y, kPublicAy, sizeof(y)));
+}
+
+TEST(P256EngineTest, dh_key_matches_spec) {
+  uint32_t x[8], y[8];
+  P256ScalarMult(kPrivateA, kPublicBx, kPublicBy, x, y);
+  EXPECT_EQ(0, memcmp(x, kDhKey, sizeof(x)));
+}
+
+TEST(P256EngineTest, small_scalars) {
+  uint32_t k[8] = {0};
+  uint32_t x[8], y[8];
+  P256ScalarMultBase(k, x, y);
+  uint32_t zero[8] = {0};
+  EXPECT_EQ(0, memcmp(x, zero, sizeof(x)));
+  EXPECT_EQ(0, memcmp(y, zero, sizeof(y)));
+
+  k[0] = 1;
+  P256ScalarMultBase(k, x, y);
+  EXPECT_EQ(0, memcmp(x, curve_p256.G.x, sizeof(x)));
+  EXPECT_EQ(0, memcmp(y, curve_p256.G.y, sizeof(y)));
+  P256ScalarMult(k, curve_p256.G.x, curve_p256.G.y, x, y);
+  EXPECT_EQ(0, memcmp(x, curve_p256.G.x, sizeof(x)));
+  EXPECT_EQ(0, memcmp(y, curve_p256.G.y, sizeof(y)));
+}
+
+TEST(P256EngineTest, matches_binary_naf) {
+  std::mt19937 rng(0x256);
+  for (int i = 0; i < 64; i++) {
+    uint32_t k[8], copy[8];
+    RandomScalar(&rng, k);
+
+    Point expected;
+    memcpy(copy, k, sizeof(copy));
+    ECC_PointMult_Bin_NAF(&expected, &curve_p256.G, copy);
+    uint32_t x[8], y[8];
+    P256ScalarMultBase(k, x, y);
+    ASSERT_EQ(0, memcmp(x, expected.x, sizeof(x)));
+    ASSERT_EQ(0, memcmp(y, expected.y, sizeof(y)));
+
+    // The same scalar on a point other than the base point
+    Point peer = expected;
+    multiprecision_init(peer.z);
+    peer.z[0] = 1;
+    RandomScalar(&rng, k);
+    memcpy(copy, k, sizeof(copy));
+    ECC_PointMult_Bin_NAF(&expected, &peer, copy);
+    P256ScalarMult(k, peer.x, peer.y, x, y);
+    ASSERT_EQ(0, memcmp(x, expected.x, sizeof(x)));
+    ASSERT_EQ(0, memcmp(y, expected.y, sizeof(y)));
+  }
+}
+
+TEST(P256EngineTest, point_mult_dispatch) {
+  uint32_t k[8];
+  memcpy(k, kPrivateA, sizeof(k));
+  Point q;
+  ECC_PointMult(&q, &curve_p256.G, k);
+  EXPECT_EQ(0, memcmp(q.x, kPublicAx, sizeof(q.x)));
+  EXPECT_EQ(0, memcmp(q.y, kPublicAy, sizeof(q.y)));
+  EXPECT_EQ(0, memcmp(k, kPrivateA, sizeof(k)));
+
+  Point peer;
+  memcpy(peer.x, kPublicBx, sizeof(peer.x));
+  memcpy(peer.y, kPublicBy, sizeof(peer.y));
+  ECC_PointMult(&q, &peer, k);
+  EXPECT_EQ(0, memcmp(q.x, kDhKey, sizeof(q.x)));
+}
+
+}  // namespace
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
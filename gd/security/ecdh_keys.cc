@@ -25,8 +25,10 @@
 #include <string.h>
 #include <chrono>
 #include <cstdlib>
+#include <mutex>
 
 #include "security/ecc/p_256_ecc_pp.h"
+#include "security/key_pair_pool.h"
 
 namespace {
 
@@ -45,6 +47,15 @@ static std::array<uint8_t, SIZE> GenerateRandom() {
   for (size_t i = 0; i < SIZE; i++) r[i] = std::rand();
   return r;
 }
+
+// One ready pair covers the next pairing; the pairing tops the pool up again once it is over. Pairs are never reused
+// across pairings.
+constexpr size_t kEcdhKeyPoolSize = 1;
+constexpr int kEcdhKeyMaxUses = 1;
+
+std::mutex key_pool_mutex;
+bluetooth::security::KeyPairPool<std::array<uint8_t, 32>, bluetooth::security::EcdhPublicKey> key_pool(
+    kEcdhKeyPoolSize, kEcdhKeyMaxUses);
 }  // namespace
 /*********************************************************************************************************************/
 
@@ -66,6 +77,28 @@ std::pair<std::array<uint8_t, 32>, EcdhPublicKey> GenerateECDHKeyPair() {
   return std::make_pair<std::array<uint8_t, 32>, EcdhPublicKey>(std::move(private_key), std::move(pk));
 }
 
+std::pair<std::array<uint8_t, 32>, EcdhPublicKey> TakeECDHKeyPair() {
+  {
+    std::lock_guard<std::mutex> lock(key_pool_mutex);
+    auto key_pair = key_pool.Take();
+    if (key_pair) return *key_pair;
+  }
+  return GenerateECDHKeyPair();
+}
+
+void RefillECDHKeyPool() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(key_pool_mutex);
+      if (key_pool.Missing() == 0) return;
+    }
+    // Generated outside of the lock, so that a pairing taking a key never waits for the multiplication
+    auto [private_key, public_key] = GenerateECDHKeyPair();
+    std::lock_guard<std::mutex> lock(key_pool_mutex);
+    key_pool.Put(private_key, public_key);
+  }
+}
+
 bool ValidateECDHPoint(EcdhPublicKey pk) {
   ecc::Point public_key;
   memcpy(public_key.x, pk.x.data(), 32);
@@ -31,6 +31,13 @@ struct EcdhPublicKey {
 /* this generates private and public Eliptic Curve Diffie Helman keys */
 std::pair<std::array<uint8_t, 32>, EcdhPublicKey> GenerateECDHKeyPair();
 
+/* Returns a key pair generated ahead of time by RefillECDHKeyPool(), or a new one if none is ready. Every pair is
+ * handed out only once. Thread safe. */
+std::pair<std::array<uint8_t, 32>, EcdhPublicKey> TakeECDHKeyPair();
+
+/* Generates the key pairs missing from the pool of TakeECDHKeyPair(), off the critical path of a pairing */
+void RefillECDHKeyPool();
+
 /* This function validates that the given public key (point) lays on the special
  * Bluetooth curve */
 bool ValidateECDHPoint(EcdhPublicKey pk);
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <utility>
+
+namespace bluetooth {
+namespace security {
+
+// Local key pairs generated ahead of the pairings that use them, so that a pairing starts with a ready key instead of
+// waiting for the random numbers and the scalar multiplication. Shared by the legacy SMP and the GD pairing handler.
+//
+// The pool holds up to |capacity| pairs and hands each of them to up to |max_uses| pairings; with the default of one
+// use every pairing gets a fresh key. A pairing that fails drops the pair it used, so a peer probing the key never
+// gets another pairing with it. Not thread safe.
+template <typename PrivateKey, typename PublicKey>
+class KeyPairPool {
+ public:
+  KeyPairPool(size_t capacity, int max_uses) : capacity_(capacity), max_uses_(max_uses < 1 ? 1 : max_uses) {}
+
+  ~KeyPairPool() {
+    Clear();
+  }
+
+  // Returns the next ready pair, if any
+  std::optional<std::pair<PrivateKey, PublicKey>> Take() {
+    if (entries_.empty()) return std::nullopt;
+    Entry& entry = entries_.front();
+    std::pair<PrivateKey, PublicKey> key_pair(entry.private_key, entry.public_key);
+    if (--entry.uses_left == 0) Erase(entries_.begin());
+    return key_pair;
+  }
+
+  void Put(const PrivateKey& private_key, const PublicKey& public_key) {
+    if (Missing() == 0) return;
+    entries_.push_back(Entry{private_key, public_key, max_uses_});
+  }
+
+  // Forgets the pair of |private_key|, for a pairing that failed with it
+  void Drop(const PrivateKey& private_key) {
+    for (auto it = entries_.begin(); it != entries_.end(); it++) {
+      if (it->private_key == private_key) {
+        Erase(it);
+        return;
+      }
+    }
+  }
+
+  // Number of pairs to generate to fill the pool
+  size_t Missing() const {
+    return entries_.size() < capacity_ ? capacity_ - entries_.size() : 0;
+  }
+
+  void Clear() {
+    while (!entries_.empty()) Erase(entries_.begin());
+  }
+
+ private:
+  struct Entry {
+    PrivateKey private_key;
+    PublicKey public_key;
+    int uses_left;
+  };
+
+  void Erase(typename std::deque<Entry>::iterator it) {
+    // Do not leave the private key behind in freed memory
+    volatile unsigned char* p = reinterpret_cast<volatile unsigned char*>(&it->private_key);
+    for (size_t i = 0; i < sizeof(PrivateKey); i++) p[i] = 0;
+    entries_.erase(it);
+  }
+
+  size_t capacity_;
+  int max_uses_;
+  std::deque<Entry> entries_;
+};
+
+}  // namespace security
+}  // namespace bluetooth
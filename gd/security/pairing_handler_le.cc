@@ -34,6 +34,7 @@ MyOobData PairingHandlerLe::GenerateOobData() {
 
 void PairingHandlerLe::PairingMain(InitialInformations i) {
   LOG_INFO("Pairing Started");
+  step_timer_.Start();
 
   if (i.remotely_initiated) {
     LOG_INFO("Was remotely initiated, presenting user with the accept prompt");
@@ -53,10 +54,12 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
     }
 
     LOG_INFO("Pairing prompt accepted");
+    step_timer_.Mark("accept_prompt");
   }
 
   /************************************************ PHASE 1 *********************************************************/
   Phase1ResultOrFailure phase_1_result = ExchangePairingFeature(i);
+  step_timer_.Mark("feature_exchange");
   if (std::holds_alternative<PairingFailure>(phase_1_result)) {
     LOG_WARN("Pairing failed in phase 1");
     // We already send pairing fialed in lower layer. Which one should do that ? how about disconneciton?
@@ -104,18 +107,23 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
       i.OnPairingFinished(std::get<PairingFailure>(key_exchange_result));
       return;
     }
-    auto [PKa, PKb, dhkey] = std::get<KeyExchangeResult>(key_exchange_result);
+    auto [PKa, PKb, dhkey_future] = std::get<KeyExchangeResult>(std::move(key_exchange_result));
 
-    // Public key exchange finished, Diffie-Hellman key computed.
+    // Public key exchange finished, Diffie-Hellman key being computed.
 
     Stage1ResultOrFailure stage1result = DoSecureConnectionsStage1(i, PKa, PKb, pairing_request, pairing_response);
+    step_timer_.Mark("authentication_stage1");
     if (std::holds_alternative<PairingFailure>(stage1result)) {
       i.OnPairingFinished(std::get<PairingFailure>(stage1result));
       return;
     }
 
+    std::array<uint8_t, 32> dhkey = dhkey_future.get();
+    step_timer_.Mark("dhkey_wait");
+
     Stage2ResultOrFailure stage_2_result = DoSecureConnectionsStage2(i, PKa, PKb, pairing_request, pairing_response,
                                                                      std::get<Stage1Result>(stage1result), dhkey);
+    step_timer_.Mark("dhkey_check");
     if (std::holds_alternative<PairingFailure>(stage_2_result)) {
       i.OnPairingFinished(std::get<PairingFailure>(stage_2_result));
       return;
@@ -137,6 +145,7 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
     LOG_INFO("Pairing Phase 2 LE legacy pairing Started");
 
     LegacyStage1ResultOrFailure stage1result = DoLegacyStage1(i, pairing_request, pairing_response);
+    step_timer_.Mark("legacy_stage1");
     if (std::holds_alternative<PairingFailure>(stage1result)) {
       LOG_ERROR("Phase 1 failed");
       i.OnPairingFinished(std::get<PairingFailure>(stage1result));
@@ -145,6 +154,7 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
 
     Octet16 tk = std::get<Octet16>(stage1result);
     StkOrFailure stage2result = DoLegacyStage2(i, pairing_request, pairing_response, tk);
+    step_timer_.Mark("legacy_stage2");
     if (std::holds_alternative<PairingFailure>(stage2result)) {
       LOG_ERROR("stage 2 failed");
       i.OnPairingFinished(std::get<PairingFailure>(stage2result));
@@ -166,6 +176,7 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
   /************************************************ PHASE 3 *********************************************************/
   LOG_INFO("Waiting for encryption changed");
   auto encryption_change_result = WaitEncryptionChanged();
+  step_timer_.Mark("encryption");
   if (std::holds_alternative<PairingFailure>(encryption_change_result)) {
     i.OnPairingFinished(std::get<PairingFailure>(encryption_change_result));
     return;
@@ -190,6 +201,7 @@ void PairingHandlerLe::PairingMain(InitialInformations i) {
   LOG_INFO("Encryption change finished successfully");
 
   DistributedKeysOrFailure keyExchangeStatus = DistributeKeys(i, pairing_response, isSecureConnections);
+  step_timer_.Mark("key_distribution");
   if (std::holds_alternative<PairingFailure>(keyExchangeStatus)) {
     i.OnPairingFinished(std::get<PairingFailure>(keyExchangeStatus));
     LOG_ERROR("Key exchange failed");
@@ -227,9 +239,7 @@ Phase1ResultOrFailure PairingHandlerLe::ExchangePairingFeature(const InitialInfo
     // basically pairing_request = myPairingCapabilities;
 
     // Convert builder to view
-    std::shared_ptr<std::vector<uint8_t>> packet_bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter it(*packet_bytes);
-    pairing_request_builder->Serialize(it);
+    auto packet_bytes = std::make_shared<std::vector<uint8_t>>(pairing_request_builder->SerializeToBytes());
     PacketView<kLittleEndian> packet_bytes_view(packet_bytes);
     auto temp_cmd_view = CommandView::Create(packet_bytes_view);
     auto pairing_request = PairingRequestView::Create(temp_cmd_view);
@@ -304,9 +314,7 @@ Phase1ResultOrFailure PairingHandlerLe::ExchangePairingFeature(const InitialInfo
                                        x.responder_key_distribution & pairing_request->GetResponderKeyDistribution());
 
     // Convert builder to view
-    std::shared_ptr<std::vector<uint8_t>> packet_bytes = std::make_shared<std::vector<uint8_t>>();
-    BitInserter it(*packet_bytes);
-    pairing_response_builder->Serialize(it);
+    auto packet_bytes = std::make_shared<std::vector<uint8_t>>(pairing_response_builder->SerializeToBytes());
     PacketView<kLittleEndian> packet_bytes_view(packet_bytes);
     auto temp_cmd_view = CommandView::Create(packet_bytes_view);
     auto pairing_response = PairingResponseView::Create(temp_cmd_view);
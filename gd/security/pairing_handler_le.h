@@ -21,16 +21,21 @@
 #include <array>
 #include <chrono>
 #include <condition_variable>
+#include <future>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <string>
 #include <thread>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "common/bind.h"
 #include "crypto_toolbox/crypto_toolbox.h"
 #include "hci/hci_packets.h"
 #include "hci/le_security_interface.h"
+#include "os/log.h"
 #include "packet/packet_view.h"
 #include "security/ecdh_keys.h"
 #include "security/initial_informations.h"
@@ -85,8 +90,9 @@ constexpr int SMP_TIMEOUT = 30;
 using CommandViewOrFailure = std::variant<CommandView, PairingFailure>;
 using Phase1Result = std::pair<PairingRequestView /* pairning_request*/, PairingResponseView /* pairing_response */>;
 using Phase1ResultOrFailure = std::variant<PairingFailure, Phase1Result>;
+// The DHKey is computed on a worker thread while authentication stage 1 runs, it is only needed in stage 2
 using KeyExchangeResult =
-    std::tuple<EcdhPublicKey /* PKa */, EcdhPublicKey /* PKb */, std::array<uint8_t, 32> /*dhkey*/>;
+    std::tuple<EcdhPublicKey /* PKa */, EcdhPublicKey /* PKb */, std::future<std::array<uint8_t, 32>> /*dhkey*/>;
 using Stage1Result = std::tuple<Octet16, Octet16, Octet16, Octet16>;
 using Stage1ResultOrFailure = std::variant<PairingFailure, Stage1Result>;
 using Stage2ResultOrFailure = std::variant<PairingFailure, Octet16 /* LTK */>;
@@ -96,12 +102,47 @@ using LegacyStage1Result = Octet16 /*TK*/;
 using LegacyStage1ResultOrFailure = std::variant<PairingFailure, LegacyStage1Result>;
 using StkOrFailure = std::variant<PairingFailure, Octet16 /* STK */>;
 
+/* Splits the duration of a pairing into named steps, so that a slow pairing can be attributed to the user, the remote
+ * device or the crypto. */
+class PairingStepTimer {
+ public:
+  void Start() {
+    start_ = last_ = std::chrono::steady_clock::now();
+    steps_.clear();
+  }
+
+  // Ends the step that began at the previous mark
+  void Mark(const char* step) {
+    auto now = std::chrono::steady_clock::now();
+    steps_.emplace_back(step, now - last_);
+    last_ = now;
+  }
+
+  std::string ToString() const {
+    std::string str = "total=" + FormatMs(std::chrono::steady_clock::now() - start_);
+    for (const auto& [step, duration] : steps_) {
+      str += " " + std::string(step) + "=" + FormatMs(duration);
+    }
+    return str;
+  }
+
+ private:
+  static std::string FormatMs(std::chrono::steady_clock::duration duration) {
+    return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()) + "ms";
+  }
+
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::steady_clock::time_point last_;
+  std::vector<std::pair<const char*, std::chrono::steady_clock::duration>> steps_;
+};
+
 /* PairingHandlerLe takes care of the Pairing process. Pairing is strictly defined
  * exchange of messages and UI interactions, divided into PHASES.
  *
  * Each PairingHandlerLe have a thread executing |PairingMain| method. Thread is
  * blocked when waiting for UI/L2CAP/HCI interactions, and moves through all the
- * phases.
+ * phases. Once the pairing is over, the thread logs how long each step took and
+ * generates the ECDH key pair for the next pairing before exiting.
  */
 class PairingHandlerLe {
  public:
@@ -116,7 +157,11 @@ class PairingHandlerLe {
 
   // All the knowledge to initiate the pairing process must be passed into this function
   PairingHandlerLe(PAIRING_PHASE phase, InitialInformations informations)
-      : phase(phase), queue_guard(), thread_(&PairingHandlerLe::PairingMain, this, informations) {}
+      : phase(phase), queue_guard(), thread_([this, informations] {
+          PairingMain(informations);
+          LOG_INFO("Pairing steps: %s", step_timer_.ToString().c_str());
+          RefillECDHKeyPool();
+        }) {}
 
   ~PairingHandlerLe() {
     SendExitSignal();
@@ -537,6 +582,9 @@ class PairingHandlerLe {
   std::mutex queue_guard;
   std::queue<PairingEvent> queue;
 
+  // Only used from thread_, must be constructed before it
+  PairingStepTimer step_timer_;
+
   std::thread thread_;
 
   // holds pairing_confirm, if received out of order
@@ -29,7 +29,7 @@ std::variant<PairingFailure, KeyExchangeResult> PairingHandlerLe::ExchangePublic
                                                                                      OobDataFlag remote_have_oob_data) {
   // Generate ECDH, or use one that was used for OOB data
   const auto [private_key, public_key] = (remote_have_oob_data == OobDataFlag::NOT_PRESENT || !i.my_oob_data)
-                                             ? GenerateECDHKeyPair()
+                                             ? TakeECDHKeyPair()
                                              : std::make_pair(i.my_oob_data->private_key, i.my_oob_data->public_key);
 
   LOG_INFO("Public key exchange start");
@@ -81,13 +81,16 @@ std::variant<PairingFailure, KeyExchangeResult> PairingHandlerLe::ExchangePublic
   }
 
   LOG_INFO("Public key exchange finish");
+  step_timer_.Mark("public_key_exchange");
 
-  std::array<uint8_t, 32> dhkey = ComputeDHKey(private_key, remote_public_key);
+  // Overlaps the point multiplication with the stage 1 round trips and user confirmation
+  std::future<std::array<uint8_t, 32>> dhkey =
+      std::async(std::launch::async, ComputeDHKey, private_key, remote_public_key);
 
   const EcdhPublicKey& PKa = IAmCentral(i) ? public_key : remote_public_key;
   const EcdhPublicKey& PKb = IAmCentral(i) ? remote_public_key : public_key;
 
-  return KeyExchangeResult{PKa, PKb, dhkey};
+  return KeyExchangeResult{PKa, PKb, std::move(dhkey)};
 }
 
 Stage1ResultOrFailure PairingHandlerLe::DoSecureConnectionsStage1(const InitialInformations& i,
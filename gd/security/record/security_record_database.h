@@ -17,6 +17,7 @@
 #pragma once
 
 #include <set>
+#include <unordered_map>
 
 #include "hci/address_with_type.h"
 #include "security/record/security_record.h"
@@ -33,14 +34,23 @@ class SecurityRecordDatabase {
 
   using iterator = std::set<std::shared_ptr<SecurityRecord>>::iterator;
 
+  // Bounds the memo of resolved RPAs, peers rotate their RPA every few minutes
+  static constexpr size_t kMaxResolvedRpas = 64;
+
   std::shared_ptr<SecurityRecord> FindOrCreate(hci::AddressWithType address) {
     auto it = Find(address);
     // Security record check
-    if (it != records_.end()) return *it;
+    if (it != records_.end()) {
+      // The caller may update the record, have it written on the next save
+      dirty_records_.insert(*it);
+      return *it;
+    }
 
     // No security record, create one
     auto record_ptr = std::make_shared<SecurityRecord>(address);
     records_.insert(record_ptr);
+    dirty_records_.insert(record_ptr);
+    address_index_.emplace(address, record_ptr);
     return record_ptr;
   }
 
@@ -50,30 +60,69 @@ class SecurityRecordDatabase {
     // No record exists
     if (it == records_.end()) return;
 
+    dirty_records_.erase(*it);
     records_.erase(it);
+    RebuildIndex();
     security_record_storage_.RemoveDevice(address);
   }
 
   iterator Find(hci::AddressWithType address) {
+    // Identity and pseudo addresses are matched through the index
+    auto indexed = address_index_.find(address);
+    if (indexed != address_index_.end()) return records_.find(indexed->second);
+
+    if (!address.IsRpa()) return records_.end();
+
+    auto resolved = resolved_rpas_.find(address);
+    if (resolved != resolved_rpas_.end()) return records_.find(resolved->second);
+
+    // Unknown RPA, this costs one AES computation per record with an IRK
     for (auto it = records_.begin(); it != records_.end(); ++it) {
       std::shared_ptr<SecurityRecord> record = *it;
-      if (record->identity_address_.has_value() && record->identity_address_.value() == address) return it;
-      if (record->GetPseudoAddress() == address) return it;
-      if (record->remote_irk.has_value() && address.IsRpaThatMatchesIrk(record->remote_irk.value())) return it;
+      if (record->remote_irk.has_value() && address.IsRpaThatMatchesIrk(record->remote_irk.value())) {
+        if (resolved_rpas_.size() >= kMaxResolvedRpas) resolved_rpas_.clear();
+        resolved_rpas_.emplace(address, record);
+        return it;
+      }
     }
     return records_.end();
   }
 
   void LoadRecordsFromStorage() {
     security_record_storage_.LoadSecurityRecords(&records_);
+    dirty_records_.clear();
+    RebuildIndex();
   }
 
+  // Writes the records handed out by FindOrCreate() since the last save
   void SaveRecordsToStorage() {
-    security_record_storage_.SaveSecurityRecords(&records_);
+    // Addresses and IRKs are set on the records after pairing, index them
+    RebuildIndex();
+    security_record_storage_.SaveSecurityRecords(&dirty_records_);
+    dirty_records_.clear();
   }
 
   std::set<std::shared_ptr<SecurityRecord>> records_;
   record::SecurityRecordStorage security_record_storage_;
+
+ private:
+  void RebuildIndex() {
+    address_index_.clear();
+    resolved_rpas_.clear();
+    // Identity addresses take precedence over pseudo addresses
+    for (auto& record : records_) {
+      if (record->identity_address_.has_value()) address_index_.emplace(record->identity_address_.value(), record);
+    }
+    for (auto& record : records_) {
+      if (record->pseudo_address_.has_value()) address_index_.emplace(record->pseudo_address_.value(), record);
+    }
+  }
+
+  // Identity and pseudo address of every record
+  std::unordered_map<hci::AddressWithType, std::shared_ptr<SecurityRecord>> address_index_;
+  // RPAs already resolved against the IRK of a record
+  std::unordered_map<hci::AddressWithType, std::shared_ptr<SecurityRecord>> resolved_rpas_;
+  std::set<std::shared_ptr<SecurityRecord>> dirty_records_;
 };
 
 }  // namespace record
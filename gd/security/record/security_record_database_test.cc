@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "security/record/security_record_database.h"
+
+#include <gtest/gtest.h>
+
+namespace bluetooth {
+namespace security {
+namespace record {
+namespace {
+
+const crypto_toolbox::Octet16 kIrk = {
+    0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10};
+
+hci::AddressWithType MakeRpa(const crypto_toolbox::Octet16& irk, uint8_t prand_lsb) {
+  hci::Address address({0x40, 0x11, prand_lsb, 0x00, 0x00, 0x00});
+  uint8_t prand[3] = {address.address[2], address.address[1], address.address[0]};
+  crypto_toolbox::Octet16 hash = crypto_toolbox::aes_128(irk, &prand[0], 3);
+  address.address[5] = hash[0];
+  address.address[4] = hash[1];
+  address.address[3] = hash[2];
+  return hci::AddressWithType(address, hci::AddressType::RANDOM_DEVICE_ADDRESS);
+}
+
+class SecurityRecordDatabaseTest : public ::testing::Test {
+ protected:
+  SecurityRecordDatabase database_{SecurityRecordStorage(nullptr, nullptr)};
+  hci::AddressWithType pseudo_{hci::Address({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}),
+                               hci::AddressType::PUBLIC_DEVICE_ADDRESS};
+  hci::AddressWithType identity_{hci::Address({0xc1, 0x02, 0x03, 0x04, 0x05, 0x06}),
+                                 hci::AddressType::RANDOM_DEVICE_ADDRESS};
+};
+
+TEST_F(SecurityRecordDatabaseTest, find_by_pseudo_address) {
+  auto record = database_.FindOrCreate(pseudo_);
+  ASSERT_NE(database_.Find(pseudo_), database_.records_.end());
+  ASSERT_EQ(*database_.Find(pseudo_), record);
+  ASSERT_EQ(database_.FindOrCreate(pseudo_), record);
+  ASSERT_EQ(database_.records_.size(), 1u);
+}
+
+TEST_F(SecurityRecordDatabaseTest, find_by_identity_address_after_save) {
+  auto record = database_.FindOrCreate(pseudo_);
+  record->identity_address_ = identity_;
+  record->remote_irk = kIrk;
+  // Temporary records are not written, the test has no storage module
+  record->SetIsTemporary(true);
+  database_.SaveRecordsToStorage();
+
+  ASSERT_NE(database_.Find(identity_), database_.records_.end());
+  ASSERT_EQ(*database_.Find(identity_), record);
+  ASSERT_EQ(*database_.Find(pseudo_), record);
+}
+
+TEST_F(SecurityRecordDatabaseTest, resolve_rpa) {
+  auto record = database_.FindOrCreate(pseudo_);
+  record->remote_irk = kIrk;
+  database_.FindOrCreate(identity_);
+
+  hci::AddressWithType rpa = MakeRpa(kIrk, 0x22);
+  ASSERT_TRUE(rpa.IsRpa());
+  ASSERT_NE(database_.Find(rpa), database_.records_.end());
+  ASSERT_EQ(*database_.Find(rpa), record);
+  // The second lookup is served from the resolved RPAs
+  ASSERT_EQ(*database_.Find(rpa), record);
+  ASSERT_EQ(database_.FindOrCreate(rpa), record);
+}
+
+TEST_F(SecurityRecordDatabaseTest, unknown_rpa_not_found) {
+  auto record = database_.FindOrCreate(pseudo_);
+  record->remote_irk = kIrk;
+
+  crypto_toolbox::Octet16 other_irk = kIrk;
+  other_irk[0] ^= 0xff;
+  ASSERT_EQ(database_.Find(MakeRpa(other_irk, 0x33)), database_.records_.end());
+}
+
+}  // namespace
+}  // namespace record
+}  // namespace security
+}  // namespace bluetooth
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "security/key_pair_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+namespace bluetooth {
+namespace security {
+namespace {
+
+using PrivateKey = std::array<uint8_t, 4>;
+using TestPool = KeyPairPool<PrivateKey, int>;
+
+TEST(KeyPairPoolTest, single_use) {
+  TestPool pool(2, 1);
+  EXPECT_EQ(2u, pool.Missing());
+  EXPECT_FALSE(pool.Take());
+
+  pool.Put({1, 1, 1, 1}, 1);
+  pool.Put({2, 2, 2, 2}, 2);
+  pool.Put({3, 3, 3, 3}, 3);
+  EXPECT_EQ(0u, pool.Missing());
+
+  auto first = pool.Take();
+  ASSERT_TRUE(first);
+  EXPECT_EQ((PrivateKey{1, 1, 1, 1}), first->first);
+  EXPECT_EQ(1, first->second);
+  EXPECT_EQ(1u, pool.Missing());
+
+  auto second = pool.Take();
+  ASSERT_TRUE(second);
+  EXPECT_EQ(2, second->second);
+  EXPECT_FALSE(pool.Take());
+}
+
+TEST(KeyPairPoolTest, reuse_until_max_uses) {
+  TestPool pool(1, 3);
+  pool.Put({1, 1, 1, 1}, 1);
+  for (int i = 0; i < 3; i++) {
+    auto key_pair = pool.Take();
+    ASSERT_TRUE(key_pair);
+    EXPECT_EQ(1, key_pair->second);
+  }
+  EXPECT_FALSE(pool.Take());
+  EXPECT_EQ(1u, pool.Missing());
+}
+
+TEST(KeyPairPoolTest, drop_after_failure) {
+  TestPool pool(2, 3);
+  pool.Put({1, 1, 1, 1}, 1);
+  pool.Put({2, 2, 2, 2}, 2);
+
+  auto used = pool.Take();
+  ASSERT_TRUE(used);
+  pool.Drop(used->first);
+  pool.Drop({7, 7, 7, 7});
+  EXPECT_EQ(1u, pool.Missing());
+
+  auto next = pool.Take();
+  ASSERT_TRUE(next);
+  EXPECT_EQ(2, next->second);
+}
+
+}  // namespace
+}  // namespace security
+}  // namespace bluetooth
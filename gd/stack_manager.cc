@@ -23,6 +23,7 @@
 #include <queue>
 
 #include "common/bind.h"
+#include "common/init_flags.h"
 #include "module.h"
 #include "os/handler.h"
 #include "os/log.h"
@@ -36,6 +37,7 @@ using ::bluetooth::os::WakelockManager;
 namespace bluetooth {
 
 constexpr char bluetooth_pid_file[] = "/var/run/bluetooth";
+constexpr size_t kNumModuleStartThreads = 4;
 
 void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
   management_thread_ = new Thread("management_thread", Thread::Priority::NORMAL);
@@ -65,7 +67,11 @@ void StackManager::StartUp(ModuleList* modules, Thread* stack_thread) {
 }
 
 void StackManager::handle_start_up(ModuleList* modules, Thread* stack_thread, std::promise<void> promise) {
-  registry_.Start(modules, stack_thread);
+  if (common::init_flags::gd_parallel_module_start_is_enabled()) {
+    registry_.StartInParallel(modules, stack_thread, kNumModuleStartThreads);
+  } else {
+    registry_.Start(modules, stack_thread);
+  }
   promise.set_value();
 }
 
@@ -54,8 +54,10 @@ ConfigCache::ConfigCache(size_t temp_device_capacity, std::unordered_set<std::st
       persistent_devices_(),
       temporary_devices_(temp_device_capacity) {}
 
-void ConfigCache::SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+void ConfigCache::SetPersistentConfigChangedCallback(
+    std::function<void(const std::string& section, const std::string& property, size_t changed_bytes)>
+        persistent_config_changed_callback) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   persistent_config_changed_callback_ = std::move(persistent_config_changed_callback);
 }
 
@@ -64,7 +66,8 @@ ConfigCache::ConfigCache(ConfigCache&& other) noexcept
       persistent_property_names_(std::move(other.persistent_property_names_)),
       information_sections_(std::move(other.information_sections_)),
       persistent_devices_(std::move(other.persistent_devices_)),
-      temporary_devices_(std::move(other.temporary_devices_)) {
+      temporary_devices_(std::move(other.temporary_devices_)),
+      changed_sections_(std::move(other.changed_sections_)) {
   // std::function will be in a valid but unspecified state after std::move(), hence resetting it
   other.persistent_config_changed_callback_ = {};
 }
@@ -73,20 +76,24 @@ ConfigCache& ConfigCache::operator=(ConfigCache&& other) noexcept {
   if (&other == this) {
     return *this;
   }
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(other.mutex_);
+  std::scoped_lock lock(mutex_, other.mutex_);
   persistent_config_changed_callback_.swap(other.persistent_config_changed_callback_);
   other.persistent_config_changed_callback_ = {};
   persistent_property_names_ = std::move(other.persistent_property_names_);
   information_sections_ = std::move(other.information_sections_);
   persistent_devices_ = std::move(other.persistent_devices_);
   temporary_devices_ = std::move(other.temporary_devices_);
+  changed_sections_ = std::move(other.changed_sections_);
   return *this;
 }
 
 bool ConfigCache::operator==(const ConfigCache& rhs) const {
-  std::lock_guard<std::recursive_mutex> my_lock(mutex_);
-  std::lock_guard<std::recursive_mutex> others_lock(rhs.mutex_);
+  if (&rhs == this) {
+    return true;
+  }
+  std::shared_lock<std::shared_mutex> my_lock(mutex_);
+  std::shared_lock<std::shared_mutex> others_lock(rhs.mutex_);
+  std::scoped_lock temporary_devices_lock(temporary_devices_mutex_, rhs.temporary_devices_mutex_);
   return persistent_property_names_ == rhs.persistent_property_names_ &&
          information_sections_ == rhs.information_sections_ && persistent_devices_ == rhs.persistent_devices_ &&
          temporary_devices_ == rhs.temporary_devices_;
@@ -97,14 +104,20 @@ bool ConfigCache::operator!=(const ConfigCache& rhs) const {
 }
 
 void ConfigCache::Clear() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   if (information_sections_.size() > 0) {
+    for (const auto& section : information_sections_) {
+      changed_sections_.insert(section.first);
+    }
     information_sections_.clear();
-    PersistentConfigChangedCallback();
+    PersistentConfigChangedCallback("", "", 0);
   }
   if (persistent_devices_.size() > 0) {
+    for (const auto& section : persistent_devices_) {
+      changed_sections_.insert(section.first);
+    }
     persistent_devices_.clear();
-    PersistentConfigChangedCallback();
+    PersistentConfigChangedCallback("", "", 0);
   }
   if (temporary_devices_.size() > 0) {
     temporary_devices_.clear();
@@ -112,13 +125,16 @@ void ConfigCache::Clear() {
 }
 
 bool ConfigCache::HasSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
-  return information_sections_.contains(section) || persistent_devices_.contains(section) ||
-         temporary_devices_.contains(section);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  if (information_sections_.contains(section) || persistent_devices_.contains(section)) {
+    return true;
+  }
+  std::lock_guard<std::mutex> temporary_devices_lock(temporary_devices_mutex_);
+  return temporary_devices_.contains(section);
 }
 
 bool ConfigCache::HasProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
     return section_iter->second.find(property) != section_iter->second.end();
@@ -127,6 +143,7 @@ bool ConfigCache::HasProperty(const std::string& section, const std::string& pro
   if (section_iter != persistent_devices_.end()) {
     return section_iter->second.find(property) != section_iter->second.end();
   }
+  std::lock_guard<std::mutex> temporary_devices_lock(temporary_devices_mutex_);
   section_iter = temporary_devices_.find(section);
   if (section_iter != temporary_devices_.end()) {
     return section_iter->second.find(property) != section_iter->second.end();
@@ -135,7 +152,7 @@ bool ConfigCache::HasProperty(const std::string& section, const std::string& pro
 }
 
 std::optional<std::string> ConfigCache::GetProperty(const std::string& section, const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
     auto property_iter = section_iter->second.find(property);
@@ -150,6 +167,7 @@ std::optional<std::string> ConfigCache::GetProperty(const std::string& section,
       return property_iter->second;
     }
   }
+  std::lock_guard<std::mutex> temporary_devices_lock(temporary_devices_mutex_);
   section_iter = temporary_devices_.find(section);
   if (section_iter != temporary_devices_.end()) {
     auto property_iter = section_iter->second.find(property);
@@ -161,19 +179,25 @@ std::optional<std::string> ConfigCache::GetProperty(const std::string& section,
 }
 
 void ConfigCache::SetProperty(std::string section, std::string property, std::string value) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  SetPropertyImpl(std::move(section), std::move(property), std::move(value));
+}
+
+void ConfigCache::SetPropertyImpl(std::string section, std::string property, std::string value) {
   if (TrimAfterNewLine(section) || TrimAfterNewLine(property) || TrimAfterNewLine(value)) {
     android_errorWriteLog(0x534e4554, "70808273");
   }
   ASSERT_LOG(!section.empty(), "Empty section name not allowed");
   ASSERT_LOG(!property.empty(), "Empty property name not allowed");
+  size_t changed_bytes = section.size() + property.size() + value.size();
   if (!IsDeviceSection(section)) {
     auto section_iter = information_sections_.find(section);
     if (section_iter == information_sections_.end()) {
       section_iter = information_sections_.try_emplace_back(section, common::ListMap<std::string, std::string>{}).first;
     }
     section_iter->second.insert_or_assign(property, std::move(value));
-    PersistentConfigChangedCallback();
+    changed_sections_.insert(section);
+    PersistentConfigChangedCallback(section, property, changed_bytes);
     return;
   }
   auto section_iter = persistent_devices_.find(section);
@@ -188,7 +212,8 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
   }
   if (section_iter != persistent_devices_.end()) {
     section_iter->second.insert_or_assign(property, std::move(value));
-    PersistentConfigChangedCallback();
+    changed_sections_.insert(section);
+    PersistentConfigChangedCallback(section, property, changed_bytes);
     return;
   }
   section_iter = temporary_devices_.find(section);
@@ -200,18 +225,55 @@ void ConfigCache::SetProperty(std::string section, std::string property, std::st
 }
 
 bool ConfigCache::RemoveSection(const std::string& section) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemoveSectionImpl(section);
+}
+
+bool ConfigCache::RemoveSectionImpl(const std::string& section) {
   // sections are unique among all three maps, hence removing from one of them is enough
   if (information_sections_.extract(section) || persistent_devices_.extract(section)) {
-    PersistentConfigChangedCallback();
+    changed_sections_.insert(section);
+    PersistentConfigChangedCallback(section, "", section.size());
     return true;
   } else {
     return temporary_devices_.extract(section).has_value();
   }
 }
 
+void ConfigCache::SetSection(std::string section, common::ListMap<std::string, std::string> properties) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  bool was_persistent = information_sections_.extract(section) || persistent_devices_.extract(section);
+  temporary_devices_.extract(section);
+  bool has_persistent_property = false;
+  size_t changed_bytes = section.size();
+  for (const auto& property : properties) {
+    has_persistent_property = has_persistent_property || IsPersistentProperty(property.first);
+    changed_bytes += property.first.size() + property.second.size();
+  }
+  bool is_persistent = true;
+  if (properties.size() == 0) {
+    // empty section is not allowed
+    is_persistent = false;
+  } else if (!IsDeviceSection(section)) {
+    information_sections_.insert_or_assign(section, std::move(properties));
+  } else if (has_persistent_property) {
+    persistent_devices_.insert_or_assign(section, std::move(properties));
+  } else {
+    temporary_devices_.insert_or_assign(section, std::move(properties));
+    is_persistent = false;
+  }
+  if (was_persistent || is_persistent) {
+    PersistentConfigChangedCallback(section, "", changed_bytes);
+    changed_sections_.insert(std::move(section));
+  }
+}
+
 bool ConfigCache::RemoveProperty(const std::string& section, const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return RemovePropertyImpl(section, property);
+}
+
+bool ConfigCache::RemovePropertyImpl(const std::string& section, const std::string& property) {
   auto section_iter = information_sections_.find(section);
   if (section_iter != information_sections_.end()) {
     auto value = section_iter->second.extract(property);
@@ -220,7 +282,8 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
       information_sections_.erase(section_iter);
     }
     if (value.has_value()) {
-      PersistentConfigChangedCallback();
+      changed_sections_.insert(section);
+      PersistentConfigChangedCallback(section, property, section.size() + property.size());
       return true;
     } else {
       return false;
@@ -238,7 +301,8 @@ bool ConfigCache::RemoveProperty(const std::string& section, const std::string&
       temporary_devices_.insert_or_assign(section, std::move(section_properties->second));
     }
     if (value.has_value()) {
-      PersistentConfigChangedCallback();
+      changed_sections_.insert(section);
+      PersistentConfigChangedCallback(section, property, section.size() + property.size());
       return true;
     } else {
       return false;
@@ -264,12 +328,13 @@ bool ConfigCache::IsPersistentProperty(const std::string& property) const {
 }
 
 void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   size_t num_persistent_removed = 0;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto it = config_section->begin(); it != config_section->end();) {
       if (it->second.contains(property)) {
         LOG_INFO("Removing persistent section %s with property %s", it->first.c_str(), property.c_str());
+        changed_sections_.insert(it->first);
         it = config_section->erase(it);
         num_persistent_removed++;
         continue;
@@ -286,12 +351,12 @@ void ConfigCache::RemoveSectionWithProperty(const std::string& property) {
     it++;
   }
   if (num_persistent_removed > 0) {
-    PersistentConfigChangedCallback();
+    PersistentConfigChangedCallback("", "", 0);
   }
 }
 
 std::vector<std::string> ConfigCache::GetPersistentSections() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<std::string> paired_devices;
   paired_devices.reserve(persistent_devices_.size());
   for (const auto& elem : persistent_devices_) {
@@ -301,19 +366,19 @@ std::vector<std::string> ConfigCache::GetPersistentSections() const {
 }
 
 void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   while (!mutation_entries.empty()) {
     auto entry = std::move(mutation_entries.front());
     mutation_entries.pop();
     switch (entry.entry_type) {
       case MutationEntry::EntryType::SET:
-        SetProperty(std::move(entry.section), std::move(entry.property), std::move(entry.value));
+        SetPropertyImpl(std::move(entry.section), std::move(entry.property), std::move(entry.value));
         break;
       case MutationEntry::EntryType::REMOVE_PROPERTY:
-        RemoveProperty(entry.section, entry.property);
+        RemovePropertyImpl(entry.section, entry.property);
         break;
       case MutationEntry::EntryType::REMOVE_SECTION:
-        RemoveSection(entry.section);
+        RemoveSectionImpl(entry.section);
         break;
         // do not write a default case so that when a new enum is defined, compilation would fail automatically
     }
@@ -321,7 +386,7 @@ void ConfigCache::Commit(std::queue<MutationEntry>& mutation_entries) {
 }
 
 std::string ConfigCache::SerializeToLegacyFormat() const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::stringstream serialized;
   for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (const auto& section : *config_section) {
@@ -335,9 +400,42 @@ std::string ConfigCache::SerializeToLegacyFormat() const {
   return serialized.str();
 }
 
+void ConfigCache::ForEachPersistentProperty(
+    const std::function<void(const std::string& section, const std::string& property, const std::string& value)>&
+        visitor) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
+    for (const auto& section : *config_section) {
+      for (const auto& property : section.second) {
+        visitor(section.first, property.first, property.second);
+      }
+    }
+  }
+}
+
+std::string ConfigCache::TakeChangedSectionsInLegacyFormat() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  std::stringstream serialized;
+  for (const auto& section_name : changed_sections_) {
+    serialized << "[" << section_name << "]" << std::endl;
+    for (const auto* config_section : {&information_sections_, &persistent_devices_}) {
+      auto section = config_section->find(section_name);
+      if (section == config_section->end()) {
+        continue;
+      }
+      for (const auto& property : section->second) {
+        serialized << property.first << " = " << property.second << std::endl;
+      }
+    }
+    serialized << std::endl;
+  }
+  changed_sections_.clear();
+  return serialized.str();
+}
+
 std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWithProperty(
     const std::string& property) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   std::vector<SectionAndPropertyValue> result;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (const auto& elem : *config_section) {
@@ -348,6 +446,7 @@ std::vector<ConfigCache::SectionAndPropertyValue> ConfigCache::GetSectionNamesWi
       }
     }
   }
+  std::lock_guard<std::mutex> temporary_devices_lock(temporary_devices_mutex_);
   for (const auto& elem : temporary_devices_) {
     auto it = elem.second.find(property);
     if (it != elem.second.end()) {
@@ -401,11 +500,12 @@ bool FixDeviceTypeInconsistencyInSection(
 }  // namespace
 
 bool ConfigCache::FixDeviceTypeInconsistencies() {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   bool persistent_device_changed = false;
   for (auto* config_section : {&information_sections_, &persistent_devices_}) {
     for (auto& elem : *config_section) {
       if (FixDeviceTypeInconsistencyInSection(elem.first, elem.second)) {
+        changed_sections_.insert(elem.first);
         persistent_device_changed = true;
       }
     }
@@ -417,14 +517,15 @@ bool ConfigCache::FixDeviceTypeInconsistencies() {
     }
   }
   if (persistent_device_changed) {
-    PersistentConfigChangedCallback();
+    PersistentConfigChangedCallback("", "", 0);
   }
   return persistent_device_changed || temp_device_changed;
 }
 
 bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
     const std::string& section, const std::unordered_set<std::string_view>& property_names) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::unique_lock<std::mutex> temporary_devices_lock(temporary_devices_mutex_, std::defer_lock);
   const common::ListMap<std::string, std::string>* section_ptr;
   if (!IsDeviceSection(section)) {
     auto section_iter = information_sections_.find(section);
@@ -435,6 +536,8 @@ bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
   } else {
     auto section_iter = persistent_devices_.find(section);
     if (section_iter == persistent_devices_.end()) {
+      // the temporary device stays locked until its properties are checked
+      temporary_devices_lock.lock();
       section_iter = temporary_devices_.find(section);
       if (section_iter == temporary_devices_.end()) {
         return false;
@@ -451,7 +554,7 @@ bool ConfigCache::HasAtLeastOneMatchingPropertiesInSection(
 }
 
 bool ConfigCache::IsPersistentSection(const std::string& section) const {
-  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   return persistent_devices_.contains(section);
 }
 
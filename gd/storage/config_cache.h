@@ -20,6 +20,7 @@
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -48,7 +49,8 @@ class Mutation;
 // The definition of persistent sections is up to the user and is defined through the |persistent_property_names|
 // argument. When these properties are link key properties, then persistent sections is equal to bonded devices
 //
-// This class is thread safe
+// This class is thread safe. Observers share a reader lock and only wait for modifiers, so readers do not block each
+// other nor the thread serializing the config to save it
 class ConfigCache {
  public:
   ConfigCache(size_t temp_device_capacity, std::unordered_set<std::string_view> persistent_property_names);
@@ -81,6 +83,15 @@ class ConfigCache {
   virtual bool IsPersistentProperty(const std::string& property) const;
   // Serialize to legacy config format
   virtual std::string SerializeToLegacyFormat() const;
+  // Call |visitor| with each property that is written to disk, in the order of SerializeToLegacyFormat(). |visitor| is
+  // called while holding the reader lock and must not modify this config cache
+  virtual void ForEachPersistentProperty(
+      const std::function<void(const std::string& section, const std::string& property, const std::string& value)>&
+          visitor) const;
+  // Serialize the persistent sections changed since the last call to legacy config format, and forget the changes.
+  // A changed section is written with all its current properties; a section that was removed, or became temporary, is
+  // written as a header without properties. Used to journal changes instead of rewriting the whole config
+  virtual std::string TakeChangedSectionsInLegacyFormat();
   // Return a copy of pair<section_name, property_value> with property
   struct SectionAndPropertyValue {
     std::string section;
@@ -99,14 +110,22 @@ class ConfigCache {
   virtual void Commit(std::queue<MutationEntry>& mutation);
   virtual void SetProperty(std::string section, std::string property, std::string value);
   virtual bool RemoveSection(const std::string& section);
+  // Set |section| to |properties| at once, replacing the section if it exists. Meant to load a config serialized from
+  // this class: unlike SetProperty(), names and values are not checked
+  virtual void SetSection(std::string section, common::ListMap<std::string, std::string> properties);
   virtual bool RemoveProperty(const std::string& section, const std::string& property);
   // TODO: have a systematic way of doing this instead of specialized methods
   // Remove sections with |property| set
   virtual void RemoveSectionWithProperty(const std::string& property);
   // remove all content in this config cache, restore it to the state after the explicit constructor
   virtual void Clear();
-  // Set a callback to notify interested party that a persistent config change has just happened
-  virtual void SetPersistentConfigChangedCallback(std::function<void()> persistent_config_changed_callback);
+  // Set a callback to notify interested party that a persistent config change has just happened. The callback is given
+  // the section and property changed, an empty property when the whole section changed and empty both when several
+  // sections changed at once, and roughly how many bytes of the config changed. It is called while holding the config
+  // lock and must not call back into this config cache
+  virtual void SetPersistentConfigChangedCallback(
+      std::function<void(const std::string& section, const std::string& property, size_t changed_bytes)>
+          persistent_config_changed_callback);
 
   // Device config specific methods
   // TODO: methods here should be moved to a device specific config cache if this config cache is supposed to be generic
@@ -121,9 +140,19 @@ class ConfigCache {
   static const std::string kDefaultSectionName;
 
  private:
-  mutable std::recursive_mutex mutex_;
+  // Modifiers for Commit(), called while holding |mutex_| exclusively
+  void SetPropertyImpl(std::string section, std::string property, std::string value);
+  bool RemoveSectionImpl(const std::string& section);
+  bool RemovePropertyImpl(const std::string& section, const std::string& property);
+
+  // Held shared by observers and exclusively by modifiers
+  mutable std::shared_mutex mutex_;
+  // Finding a temporary device moves it to the front of the LRU cache, observers hold this while they look into
+  // |temporary_devices_|; modifiers do not need it as they already exclude every observer
+  mutable std::mutex temporary_devices_mutex_;
   // A callback to notify interested party that a persistent config change has just happened, empty by default
-  std::function<void()> persistent_config_changed_callback_;
+  std::function<void(const std::string& section, const std::string& property, size_t changed_bytes)>
+      persistent_config_changed_callback_;
   // A set of property names that if set would make a section persistent and if non of these properties are set, a
   // section would become temporary again
   std::unordered_set<std::string_view> persistent_property_names_;
@@ -134,11 +163,15 @@ class ConfigCache {
   // Information about temporary devices, normally unpaired, will not be written to disk, will be evicted automatically
   // if capacity exceeds given value during initialization
   common::LruCache<std::string, common::ListMap<std::string, std::string>> temporary_devices_;
+  // Names of the sections added, changed or removed among information_sections_ and persistent_devices_ since the
+  // last TakeChangedSectionsInLegacyFormat()
+  std::unordered_set<std::string> changed_sections_;
 
   // Convenience method to check if the callback is valid before calling it
-  inline void PersistentConfigChangedCallback() const {
+  inline void PersistentConfigChangedCallback(
+      const std::string& section, const std::string& property, size_t changed_bytes) const {
     if (persistent_config_changed_callback_) {
-      persistent_config_changed_callback_();
+      persistent_config_changed_callback_(section, property, changed_bytes);
     }
   }
 };
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "hci/address.h"
+#include "storage/config_cache.h"
+#include "storage/device.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace storage {
+
+// A config with bonded devices read by the profiles while other threads read it too, or while the storage module
+// serializes it to save it. Each iteration reads one property of every bonded device on the benchmark thread.
+class BM_ConfigCache : public ::benchmark::Fixture {
+ protected:
+  static constexpr int kNumDevices = 100;
+
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int i = 0; i < kNumDevices; i++) {
+      auto section = hci::Address({0x00, 0x11, 0x22, 0x33, 0x44, (uint8_t)i}).ToString();
+      cache_.SetProperty(section, "Name", "device " + std::to_string(i));
+      cache_.SetProperty(section, "DevClass", "2360344");
+      cache_.SetProperty(section, "LinkKey", "fedcba0987654321fedcba0987654328");
+      cache_.SetProperty(section, "LinkKeyType", "4");
+      sections_.push_back(std::move(section));
+    }
+    // A couple of temporary devices, as found by inquiry
+    cache_.SetProperty("AA:BB:CC:DD:EE:00", "Name", "unpaired");
+    cache_.SetProperty("AA:BB:CC:DD:EE:01", "Name", "unpaired");
+  }
+
+  void TearDown(State& st) override {
+    StopBackgroundThreads();
+    cache_.Clear();
+    sections_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  void StartBackgroundThreads(int64_t num_threads, std::function<void()> work) {
+    running_ = true;
+    for (int64_t i = 0; i < num_threads; i++) {
+      threads_.emplace_back([this, work] {
+        while (running_) {
+          work();
+        }
+      });
+    }
+  }
+
+  void StopBackgroundThreads() {
+    running_ = false;
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  void ReadAllDevices() {
+    for (const auto& section : sections_) {
+      ::benchmark::DoNotOptimize(cache_.GetProperty(section, "LinkKey"));
+    }
+  }
+
+  void Serialize() {
+    ::benchmark::DoNotOptimize(cache_.SerializeToLegacyFormat());
+  }
+
+  void ReadTemporaryDevices() {
+    ::benchmark::DoNotOptimize(cache_.GetProperty("AA:BB:CC:DD:EE:00", "Name"));
+    ::benchmark::DoNotOptimize(cache_.GetProperty("AA:BB:CC:DD:EE:01", "Name"));
+  }
+
+  ConfigCache cache_{100, Device::kLinkKeyProperties};
+  std::vector<std::string> sections_;
+  std::atomic<bool> running_ = false;
+  std::vector<std::thread> threads_;
+};
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, get_property_with_concurrent_readers)(State& state) {
+  StartBackgroundThreads(state.range(0), [this] { ReadAllDevices(); });
+  for (auto _ : state) {
+    ReadAllDevices();
+  }
+  StopBackgroundThreads();
+  state.SetItemsProcessed(state.iterations() * kNumDevices);
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, get_property_with_concurrent_readers)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(3)
+    ->Arg(7)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, get_property_with_concurrent_temporary_device_readers)(State& state) {
+  StartBackgroundThreads(state.range(0), [this] { ReadTemporaryDevices(); });
+  for (auto _ : state) {
+    ReadAllDevices();
+  }
+  StopBackgroundThreads();
+  state.SetItemsProcessed(state.iterations() * kNumDevices);
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, get_property_with_concurrent_temporary_device_readers)
+    ->Arg(1)
+    ->Arg(3)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConfigCache, get_property_while_saving)(State& state) {
+  StartBackgroundThreads(state.range(0), [this] { Serialize(); });
+  for (auto _ : state) {
+    ReadAllDevices();
+  }
+  StopBackgroundThreads();
+  state.SetItemsProcessed(state.iterations() * kNumDevices);
+}
+
+BENCHMARK_REGISTER_F(BM_ConfigCache, get_property_while_saving)->Arg(0)->Arg(1)->UseRealTime();
+
+}  // namespace storage
+}  // namespace bluetooth
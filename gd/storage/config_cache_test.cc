@@ -258,7 +258,14 @@ TEST(ConfigCacheTest, remove_section_with_property_test) {
 TEST(ConfigCacheTest, persistent_config_changed_callback_test) {
   ConfigCache config(100, Device::kLinkKeyProperties);
   int num_change = 0;
-  config.SetPersistentConfigChangedCallback([&num_change] { num_change++; });
+  std::string last_section;
+  std::string last_property;
+  config.SetPersistentConfigChangedCallback(
+      [&](const std::string& section, const std::string& property, size_t changed_bytes) {
+        num_change++;
+        last_section = section;
+        last_property = property;
+      });
   config.SetProperty("A", "B", "C");
   ASSERT_EQ(num_change, 1);
   config.SetProperty("AA:BB:CC:DD:EE:FF", "B", "C");
@@ -269,10 +276,19 @@ TEST(ConfigCacheTest, persistent_config_changed_callback_test) {
   ASSERT_EQ(num_change, 1);
   config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
   ASSERT_EQ(num_change, 2);
+  ASSERT_EQ(last_section, "CC:DD:EE:FF:00:11");
+  ASSERT_EQ(last_property, "LinkKey");
   config.RemoveProperty("CC:DD:EE:FF:00:11", "LinkKey");
   ASSERT_EQ(num_change, 3);
   config.RemoveSectionWithProperty("B");
   ASSERT_EQ(num_change, 4);
+  ASSERT_EQ(last_section, "");
+  ASSERT_EQ(last_property, "");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  config.RemoveSection("CC:DD:EE:FF:00:11");
+  ASSERT_EQ(num_change, 6);
+  ASSERT_EQ(last_section, "CC:DD:EE:FF:00:11");
+  ASSERT_EQ(last_property, "");
 }
 
 TEST(ConfigCacheTest, fix_device_type_inconsistency_test) {
@@ -337,4 +353,30 @@ TEST(ConfigCacheTest, test_empty_persistent_properties) {
   ASSERT_THAT(config.GetPersistentSections(), ElementsAre());
 }
 
+TEST(ConfigCacheTest, set_section_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("CC:DD:EE:FF:00:11", "Name", "old");
+  bluetooth::common::ListMap<std::string, std::string> properties;
+  properties.insert_or_assign("Name", "new");
+  properties.insert_or_assign("LinkKey", "AABBAABBCCDDEE");
+  config.SetSection("CC:DD:EE:FF:00:11", properties);
+  properties.clear();
+  properties.insert_or_assign("Address", "01:02:03:ab:cd:ef");
+  config.SetSection("Adapter", properties);
+
+  ConfigCache expected(100, Device::kLinkKeyProperties);
+  expected.SetProperty("CC:DD:EE:FF:00:11", "Name", "new");
+  expected.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  expected.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+  ASSERT_EQ(config.SerializeToLegacyFormat(), expected.SerializeToLegacyFormat());
+  ASSERT_THAT(config.GetPersistentSections(), ElementsAre("CC:DD:EE:FF:00:11"));
+
+  // A section without persistent properties is temporary
+  properties.clear();
+  properties.insert_or_assign("Name", "unpaired");
+  config.SetSection("CC:DD:EE:FF:00:11", properties);
+  ASSERT_THAT(config.GetPersistentSections(), ElementsAre());
+  ASSERT_THAT(config.GetProperty("CC:DD:EE:FF:00:11", "Name"), Optional(StrEq("unpaired")));
+}
+
 }  // namespace testing
\ No newline at end of file
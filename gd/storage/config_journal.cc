@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "storage/config_journal.h"
+
+#include <queue>
+#include <sstream>
+
+#include "common/strings.h"
+#include "os/files.h"
+#include "os/log.h"
+#include "storage/mutation_entry.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+const std::string kRecordHeader = "#journal";
+
+// FNV-1a, enough to tell a complete record from one torn by a crash
+uint32_t Checksum(const std::string& data) {
+  uint32_t hash = 2166136261u;
+  for (unsigned char c : data) {
+    hash = (hash ^ c) * 16777619u;
+  }
+  return hash;
+}
+
+// Turn a record in legacy config format into mutation entries replacing the sections it lists
+bool ParseRecord(const std::string& record, std::queue<MutationEntry>* entries) {
+  std::istringstream stream(record);
+  std::string line;
+  std::optional<std::string> section;
+  while (std::getline(stream, line)) {
+    line = common::StringTrim(std::move(line));
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    if (line.front() == '[') {
+      if (line.back() != ']') {
+        return false;
+      }
+      section = line.substr(1, line.size() - 2);
+      entries->push(MutationEntry::Remove(MutationEntry::PropertyType::NORMAL, *section));
+      continue;
+    }
+    auto tokens = common::StringSplit(line, "=", 2);
+    if (!section || tokens.size() != 2) {
+      return false;
+    }
+    entries->push(MutationEntry::Set(
+        MutationEntry::PropertyType::NORMAL,
+        *section,
+        common::StringTrim(std::move(tokens[0])),
+        common::StringTrim(std::move(tokens[1]))));
+  }
+  return true;
+}
+
+}  // namespace
+
+ConfigJournal::ConfigJournal(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+bool ConfigJournal::Append(const std::string& changes) {
+  std::string record =
+      kRecordHeader + " " + std::to_string(changes.size()) + " " + std::to_string(Checksum(changes)) + "\n" + changes;
+  if (!os::AppendToFile(path_, record)) {
+    return false;
+  }
+  size_ += record.size();
+  return true;
+}
+
+size_t ConfigJournal::Replay(ConfigCache* cache) {
+  ASSERT(cache != nullptr);
+  size_ = 0;
+  if (!os::FileExists(path_)) {
+    return 0;
+  }
+  auto journal = os::ReadSmallFile(path_);
+  if (!journal) {
+    return 0;
+  }
+  size_ = journal->size();
+
+  size_t num_records = 0;
+  size_t pos = 0;
+  while (pos < journal->size()) {
+    size_t header_end = journal->find('\n', pos);
+    if (header_end == std::string::npos) {
+      break;
+    }
+    auto header = common::StringSplit(journal->substr(pos, header_end - pos), " ");
+    if (header.size() != 3 || header[0] != kRecordHeader) {
+      break;
+    }
+    auto length = common::Uint64FromString(header[1]);
+    auto checksum = common::Uint64FromString(header[2]);
+    if (!length || !checksum || *length > journal->size() - header_end - 1) {
+      break;
+    }
+    std::string record = journal->substr(header_end + 1, *length);
+    std::queue<MutationEntry> entries;
+    if (Checksum(record) != *checksum || !ParseRecord(record, &entries)) {
+      break;
+    }
+    cache->Commit(entries);
+    num_records++;
+    pos = header_end + 1 + *length;
+  }
+  if (pos < journal->size()) {
+    LOG_WARN("dropping %zu bytes of incomplete journal at the end of '%s'", journal->size() - pos, path_.c_str());
+  }
+  return num_records;
+}
+
+bool ConfigJournal::Delete() {
+  size_ = 0;
+  if (!os::FileExists(path_)) {
+    return true;
+  }
+  return os::RemoveFile(path_);
+}
+
+}  // namespace storage
+}  // namespace bluetooth
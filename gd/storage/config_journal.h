@@ -0,0 +1,62 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "storage/config_cache.h"
+
+namespace bluetooth {
+namespace storage {
+
+// Append-only log of the config changes made since the config file was last written in full
+//
+// Each record holds the sections that changed, in legacy config format as produced by
+// ConfigCache::TakeChangedSectionsInLegacyFormat(), framed by a header with its length and checksum:
+//
+//   #journal <length> <checksum>
+//   [section]
+//   property = value
+//
+// A record replaces the sections it lists; a section listed without properties is removed. Replaying records is hence
+// idempotent, and replaying the journal on top of the last full config restores the latest state. A record cut short by
+// a crash fails its checksum and is dropped, together with anything after it.
+class ConfigJournal {
+ public:
+  static ConfigJournal FromPath(std::string path) {
+    return ConfigJournal(std::move(path));
+  }
+  explicit ConfigJournal(std::string path);
+  // Append |changes| as one record, return true on success
+  bool Append(const std::string& changes);
+  // Apply the complete records of the journal on disk to |cache| through mutations, in order, return the number of
+  // records applied
+  size_t Replay(ConfigCache* cache);
+  // Size of the journal on disk, in bytes, as of the last Replay(), Append() or Delete()
+  size_t Size() const {
+    return size_;
+  }
+  bool Delete();
+
+ private:
+  std::string path_;
+  size_t size_ = 0;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_journal.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "os/files.h"
+#include "storage/device.h"
+
+namespace testing {
+
+using bluetooth::os::AppendToFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigJournal;
+using bluetooth::storage::Device;
+
+class ConfigJournalTest : public Test {
+ protected:
+  void SetUp() override {
+    temp_journal_ = std::filesystem::temp_directory_path() / "temp_config.journal";
+    std::filesystem::remove(temp_journal_);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(temp_journal_);
+  }
+
+  std::filesystem::path temp_journal_;
+};
+
+TEST_F(ConfigJournalTest, replay_changes_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  config.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+  config.SetProperty("AA:BB:CC:DD:EE:FF", "Name", "temporary");
+  ConfigCache base(100, Device::kLinkKeyProperties);
+  base.SetProperty("A", "B", "C");
+  base.SetProperty("A", "D", "E");
+  base.SetProperty("11:22:33:44:55:66", "LinkKey", "1122");
+
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(journal.Append(config.TakeChangedSectionsInLegacyFormat()));
+  EXPECT_EQ(config.TakeChangedSectionsInLegacyFormat(), "");
+
+  // A section that becomes temporary is removed from the persistent config
+  config.SetProperty("11:22:33:44:55:66", "LinkKey", "1122");
+  config.SetProperty("11:22:33:44:55:66", "Name", "bonded");
+  config.RemoveProperty("11:22:33:44:55:66", "LinkKey");
+  config.SetProperty("CC:DD:EE:FF:00:11", "Name", "bonded too");
+  ASSERT_TRUE(journal.Append(config.TakeChangedSectionsInLegacyFormat()));
+  EXPECT_EQ(journal.Size(), std::filesystem::file_size(temp_journal_));
+
+  auto replayed = ConfigJournal::FromPath(temp_journal_.string());
+  EXPECT_EQ(replayed.Replay(&base), 2u);
+  EXPECT_EQ(replayed.Size(), journal.Size());
+  EXPECT_EQ(base.SerializeToLegacyFormat(), config.SerializeToLegacyFormat());
+  EXPECT_FALSE(base.HasProperty("A", "D"));
+  EXPECT_FALSE(base.HasSection("11:22:33:44:55:66"));
+  EXPECT_THAT(base.GetPersistentSections(), ElementsAre("CC:DD:EE:FF:00:11"));
+}
+
+TEST_F(ConfigJournalTest, drop_torn_record_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  config.SetProperty("A", "B", "C");
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  ASSERT_TRUE(journal.Append(config.TakeChangedSectionsInLegacyFormat()));
+  config.SetProperty("A", "B", "D");
+  std::string changes = config.TakeChangedSectionsInLegacyFormat();
+  ASSERT_TRUE(AppendToFile(
+      temp_journal_.string(), "#journal " + std::to_string(changes.size()) + " 1\n" + changes.substr(0, 4)));
+
+  ConfigCache replayed(100, Device::kLinkKeyProperties);
+  EXPECT_EQ(ConfigJournal::FromPath(temp_journal_.string()).Replay(&replayed), 1u);
+  EXPECT_THAT(replayed.GetProperty("A", "B"), Optional(StrEq("C")));
+}
+
+TEST_F(ConfigJournalTest, replay_missing_journal_test) {
+  ConfigCache config(100, Device::kLinkKeyProperties);
+  auto journal = ConfigJournal::FromPath(temp_journal_.string());
+  EXPECT_EQ(journal.Replay(&config), 0u);
+  EXPECT_EQ(journal.Size(), 0u);
+  EXPECT_TRUE(journal.Delete());
+}
+
+}  // namespace testing
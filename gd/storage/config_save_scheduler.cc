@@ -0,0 +1,105 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "storage/config_save_scheduler.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_set>
+
+#include "storage/config_cache.h"
+#include "storage/device.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+// Device properties refreshed by inquiry, remote name requests and on each connection, losing their latest value in a
+// crash costs nothing
+const std::unordered_set<std::string_view> kMetadataProperties = {
+    "Name", "Timestamp", "DevClass", "DevType", "Manufacturer", "LmpVer", "LmpSubVer"};
+
+}  // namespace
+
+ConfigSaveScheduler::ConfigSaveScheduler(
+    std::chrono::milliseconds normal_latency, std::chrono::milliseconds metadata_latency, size_t max_dirty_bytes)
+    : normal_latency_(normal_latency), metadata_latency_(metadata_latency), max_dirty_bytes_(max_dirty_bytes) {}
+
+ConfigSaveScheduler::Priority ConfigSaveScheduler::GetPriority(const std::string& section, const std::string& property) {
+  if (property.empty() || Device::kLinkKeyProperties.find(property) != Device::kLinkKeyProperties.end()) {
+    return Priority::BOND;
+  }
+  if (ConfigCache::IsDeviceSection(section) && kMetadataProperties.find(property) != kMetadataProperties.end()) {
+    return Priority::METADATA;
+  }
+  return Priority::NORMAL;
+}
+
+std::optional<ConfigSaveScheduler::Clock::time_point> ConfigSaveScheduler::OnChange(
+    Priority priority, size_t changed_bytes, Clock::time_point now) {
+  stats_.num_changes++;
+  dirty_bytes_ += changed_bytes;
+  Clock::time_point deadline = now;
+  Trigger trigger = Trigger::LATENCY;
+  if (priority == Priority::BOND) {
+    trigger = Trigger::BOND;
+  } else if (dirty_bytes_ >= max_dirty_bytes_) {
+    trigger = Trigger::DIRTY_BYTES;
+  } else {
+    deadline += priority == Priority::METADATA ? metadata_latency_ : normal_latency_;
+  }
+  if (deadline_ && *deadline_ <= deadline) {
+    return std::nullopt;
+  }
+  deadline_ = deadline;
+  deadline_trigger_ = trigger;
+  return deadline;
+}
+
+void ConfigSaveScheduler::OnSaveStarted(bool requested) {
+  Trigger trigger = requested ? Trigger::REQUESTED : deadline_trigger_;
+  stats_.num_saves_by_trigger[static_cast<size_t>(trigger)]++;
+  deadline_.reset();
+  deadline_trigger_ = Trigger::LATENCY;
+  dirty_bytes_ = 0;
+}
+
+void ConfigSaveScheduler::OnSaveDone(bool full_save, std::chrono::microseconds duration) {
+  if (full_save) {
+    stats_.num_full_saves++;
+  } else {
+    stats_.num_journal_saves++;
+  }
+  stats_.total_save_duration += duration;
+  stats_.max_save_duration = std::max(stats_.max_save_duration, duration);
+}
+
+std::string ConfigSaveScheduler::TriggerText(Trigger trigger) {
+  switch (trigger) {
+    case Trigger::BOND:
+      return "BOND";
+    case Trigger::LATENCY:
+      return "LATENCY";
+    case Trigger::DIRTY_BYTES:
+      return "DIRTY_BYTES";
+    case Trigger::REQUESTED:
+      return "REQUESTED";
+  }
+  return "UNKNOWN";
+}
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace bluetooth {
+namespace storage {
+
+// Decides when the config changes are written to disk. Each persistent change has a priority given by the property it
+// touches, and must be on disk within the latency of that priority:
+// - Bonding keys, and removed sections, are saved right away so that a bond or an unbond survives a crash
+// - Device names and other metadata learnt again on the next connection wait the longest
+// - Anything else waits the config save delay
+// Changes join the earliest pending save instead of pushing it back, so a burst of changes, e.g. many devices
+// reconnecting at boot, costs at most one save per latency period and never delays a save past its bound. Once the
+// changes pending a save exceed a number of bytes, the save runs right away to bound what a crash loses.
+//
+// Not thread safe, the storage module only uses it from its I/O handler.
+class ConfigSaveScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Priority { BOND, NORMAL, METADATA };
+
+  // What made a save run
+  enum class Trigger { BOND, LATENCY, DIRTY_BYTES, REQUESTED };
+  static constexpr size_t kNumTriggers = static_cast<size_t>(Trigger::REQUESTED) + 1;
+
+  struct Stats {
+    uint64_t num_changes = 0;
+    std::array<uint64_t, kNumTriggers> num_saves_by_trigger = {};
+    uint64_t num_journal_saves = 0;
+    uint64_t num_full_saves = 0;
+    std::chrono::microseconds total_save_duration = std::chrono::microseconds(0);
+    std::chrono::microseconds max_save_duration = std::chrono::microseconds(0);
+  };
+
+  ConfigSaveScheduler(
+      std::chrono::milliseconds normal_latency, std::chrono::milliseconds metadata_latency, size_t max_dirty_bytes);
+
+  // Priority of a change to |property| of |section|, as given to the config changed callback of ConfigCache
+  static Priority GetPriority(const std::string& section, const std::string& property);
+
+  // Record a change of |changed_bytes| made at |now|. Returns when the pending save must run if this change starts it or
+  // brings it forward, and std::nullopt if the save already pending is early enough
+  std::optional<Clock::time_point> OnChange(Priority priority, size_t changed_bytes, Clock::time_point now);
+
+  // Record that a save starts, the changes made from now on are pending the next save. |requested| is true when the save
+  // was asked for, e.g. when the stack stops, rather than scheduled by this class
+  void OnSaveStarted(bool requested);
+
+  // Record that a save, of the whole config when |full_save| is true and of the changes only otherwise, took |duration|
+  void OnSaveDone(bool full_save, std::chrono::microseconds duration);
+
+  bool HasPendingSave() const {
+    return deadline_.has_value();
+  }
+
+  const Stats& GetStats() const {
+    return stats_;
+  }
+
+  static std::string TriggerText(Trigger trigger);
+
+ private:
+  std::chrono::milliseconds normal_latency_;
+  std::chrono::milliseconds metadata_latency_;
+  size_t max_dirty_bytes_;
+  // When the pending save must run, and why, empty when no change is pending
+  std::optional<Clock::time_point> deadline_;
+  Trigger deadline_trigger_ = Trigger::LATENCY;
+  size_t dirty_bytes_ = 0;
+  Stats stats_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
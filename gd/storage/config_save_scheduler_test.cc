@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_save_scheduler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace testing {
+
+using bluetooth::storage::ConfigSaveScheduler;
+using Priority = ConfigSaveScheduler::Priority;
+using Trigger = ConfigSaveScheduler::Trigger;
+
+static const std::chrono::milliseconds kNormalLatency = std::chrono::milliseconds(3000);
+static const std::chrono::milliseconds kMetadataLatency = std::chrono::milliseconds(30000);
+static const size_t kMaxDirtyBytes = 100;
+
+static uint64_t NumSaves(const ConfigSaveScheduler& scheduler, Trigger trigger) {
+  return scheduler.GetStats().num_saves_by_trigger[static_cast<size_t>(trigger)];
+}
+
+TEST(ConfigSaveSchedulerTest, priority_test) {
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", "LinkKey"), Priority::BOND);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", "LE_KEY_PENC"), Priority::BOND);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", ""), Priority::BOND);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("", ""), Priority::BOND);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", "Name"), Priority::METADATA);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", "Timestamp"), Priority::METADATA);
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("AA:BB:CC:DD:EE:FF", "Service"), Priority::NORMAL);
+  // The adapter name is set by the user, not learnt again
+  EXPECT_EQ(ConfigSaveScheduler::GetPriority("Adapter", "Name"), Priority::NORMAL);
+}
+
+TEST(ConfigSaveSchedulerTest, changes_join_pending_save_test) {
+  ConfigSaveScheduler scheduler(kNormalLatency, kMetadataLatency, kMaxDirtyBytes);
+  auto now = ConfigSaveScheduler::Clock::now();
+  EXPECT_FALSE(scheduler.HasPendingSave());
+  EXPECT_THAT(scheduler.OnChange(Priority::NORMAL, 1, now), Optional(Eq(now + kNormalLatency)));
+  EXPECT_TRUE(scheduler.HasPendingSave());
+  // Later changes do not push the pending save back
+  EXPECT_EQ(scheduler.OnChange(Priority::NORMAL, 1, now + std::chrono::milliseconds(1000)), std::nullopt);
+  EXPECT_EQ(scheduler.OnChange(Priority::METADATA, 1, now + std::chrono::milliseconds(2000)), std::nullopt);
+  scheduler.OnSaveStarted(false);
+  scheduler.OnSaveDone(false, std::chrono::microseconds(500));
+  EXPECT_FALSE(scheduler.HasPendingSave());
+  EXPECT_EQ(NumSaves(scheduler, Trigger::LATENCY), 1u);
+  EXPECT_EQ(scheduler.GetStats().num_changes, 3u);
+  EXPECT_EQ(scheduler.GetStats().num_journal_saves, 1u);
+  EXPECT_EQ(scheduler.GetStats().max_save_duration, std::chrono::microseconds(500));
+}
+
+TEST(ConfigSaveSchedulerTest, metadata_save_deferred_test) {
+  ConfigSaveScheduler scheduler(kNormalLatency, kMetadataLatency, kMaxDirtyBytes);
+  auto now = ConfigSaveScheduler::Clock::now();
+  EXPECT_THAT(scheduler.OnChange(Priority::METADATA, 1, now), Optional(Eq(now + kMetadataLatency)));
+  // A normal change brings the save forward
+  auto later = now + std::chrono::milliseconds(1000);
+  EXPECT_THAT(scheduler.OnChange(Priority::NORMAL, 1, later), Optional(Eq(later + kNormalLatency)));
+}
+
+TEST(ConfigSaveSchedulerTest, bond_saves_immediately_test) {
+  ConfigSaveScheduler scheduler(kNormalLatency, kMetadataLatency, kMaxDirtyBytes);
+  auto now = ConfigSaveScheduler::Clock::now();
+  scheduler.OnChange(Priority::NORMAL, 1, now);
+  auto later = now + std::chrono::milliseconds(10);
+  EXPECT_THAT(scheduler.OnChange(Priority::BOND, 1, later), Optional(Eq(later)));
+  scheduler.OnSaveStarted(false);
+  EXPECT_EQ(NumSaves(scheduler, Trigger::BOND), 1u);
+}
+
+TEST(ConfigSaveSchedulerTest, dirty_bytes_bound_test) {
+  ConfigSaveScheduler scheduler(kNormalLatency, kMetadataLatency, kMaxDirtyBytes);
+  auto now = ConfigSaveScheduler::Clock::now();
+  EXPECT_TRUE(scheduler.OnChange(Priority::METADATA, kMaxDirtyBytes / 2, now));
+  EXPECT_THAT(scheduler.OnChange(Priority::METADATA, kMaxDirtyBytes / 2, now), Optional(Eq(now)));
+  scheduler.OnSaveStarted(false);
+  EXPECT_EQ(NumSaves(scheduler, Trigger::DIRTY_BYTES), 1u);
+  // Dirty bytes are counted from the last save
+  EXPECT_THAT(scheduler.OnChange(Priority::METADATA, kMaxDirtyBytes / 2, now), Optional(Eq(now + kMetadataLatency)));
+  scheduler.OnSaveStarted(true);
+  scheduler.OnSaveDone(true, std::chrono::microseconds(100));
+  EXPECT_EQ(NumSaves(scheduler, Trigger::REQUESTED), 1u);
+  EXPECT_EQ(scheduler.GetStats().num_full_saves, 1u);
+}
+
+}  // namespace testing
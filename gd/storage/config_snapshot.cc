@@ -0,0 +1,210 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "storage/config_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "os/files.h"
+#include "os/log.h"
+#include "os/utils.h"
+#include "storage/device.h"
+
+namespace bluetooth {
+namespace storage {
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x53434742;  // "BGCS"
+constexpr uint32_t kSnapshotVersion = 1;
+
+// Identifies the content of the config file the snapshot was written with
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t config_size;
+  int64_t config_mtime_sec;
+  int64_t config_mtime_nsec;
+};
+
+// Records following the header, all strings are prefixed by their uint32_t length
+enum RecordType : uint8_t {
+  SECTION = 'S',   // name; the following properties belong to it
+  PROPERTY = 'P',  // property, value
+};
+
+bool StatConfig(const std::string& config_path, SnapshotHeader* header) {
+  struct stat config_stat;
+  if (stat(config_path.c_str(), &config_stat) != 0) {
+    return false;
+  }
+  header->magic = kSnapshotMagic;
+  header->version = kSnapshotVersion;
+  header->config_size = config_stat.st_size;
+  header->config_mtime_sec = config_stat.st_mtim.tv_sec;
+  header->config_mtime_nsec = config_stat.st_mtim.tv_nsec;
+  return true;
+}
+
+void AppendString(std::string* out, const std::string& str) {
+  uint32_t length = str.size();
+  out->append(reinterpret_cast<const char*>(&length), sizeof(length));
+  out->append(str);
+}
+
+// Bounds checked reader over the mapped snapshot
+class SnapshotReader {
+ public:
+  SnapshotReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  bool Done() const {
+    return pos_ == size_;
+  }
+
+  template <typename T>
+  bool Read(T* value) {
+    if (size_ - pos_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(std::string* str) {
+    uint32_t length;
+    if (!Read(&length) || size_ - pos_ < length) {
+      return false;
+    }
+    str->assign(data_ + pos_, length);
+    pos_ += length;
+    return true;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+ConfigSnapshot::ConfigSnapshot(std::string path) : path_(std::move(path)) {
+  ASSERT(!path_.empty());
+}
+
+bool ConfigSnapshot::Write(const ConfigCache& cache, const std::string& config_path) {
+  SnapshotHeader header;
+  if (!StatConfig(config_path, &header)) {
+    LOG_WARN("unable to stat config '%s', error: %s", config_path.c_str(), strerror(errno));
+    return false;
+  }
+  std::string snapshot(reinterpret_cast<const char*>(&header), sizeof(header));
+  std::string section_name;
+  cache.ForEachPersistentProperty(
+      [&snapshot, &section_name](const std::string& section, const std::string& property, const std::string& value) {
+        if (snapshot.size() == sizeof(SnapshotHeader) || section != section_name) {
+          section_name = section;
+          snapshot.push_back(RecordType::SECTION);
+          AppendString(&snapshot, section);
+        }
+        snapshot.push_back(RecordType::PROPERTY);
+        AppendString(&snapshot, property);
+        AppendString(&snapshot, value);
+      });
+  return os::WriteToFile(path_, snapshot);
+}
+
+std::optional<ConfigCache> ConfigSnapshot::Read(const std::string& config_path, size_t temp_devices_capacity) {
+  SnapshotHeader expected;
+  if (!os::FileExists(path_) || !StatConfig(config_path, &expected)) {
+    return std::nullopt;
+  }
+  int fd;
+  RUN_NO_INTR(fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd < 0) {
+    LOG_WARN("unable to open snapshot '%s', error: %s", path_.c_str(), strerror(errno));
+    return std::nullopt;
+  }
+  struct stat snapshot_stat;
+  if (fstat(fd, &snapshot_stat) != 0 || snapshot_stat.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+    close(fd);
+    return std::nullopt;
+  }
+  size_t size = snapshot_stat.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_WARN("unable to map snapshot '%s', error: %s", path_.c_str(), strerror(errno));
+    return std::nullopt;
+  }
+
+  SnapshotReader reader(static_cast<const char*>(data), size);
+  SnapshotHeader header;
+  reader.Read(&header);
+  std::optional<ConfigCache> cache;
+  if (header.magic == expected.magic && header.version == expected.version &&
+      header.config_size == expected.config_size && header.config_mtime_sec == expected.config_mtime_sec &&
+      header.config_mtime_nsec == expected.config_mtime_nsec) {
+    cache.emplace(temp_devices_capacity, Device::kLinkKeyProperties);
+    std::optional<std::string> section;
+    common::ListMap<std::string, std::string> properties;
+    std::string property;
+    std::string value;
+    bool corrupted = false;
+    while (!reader.Done() && !corrupted) {
+      uint8_t type = 0;
+      reader.Read(&type);
+      if (type == RecordType::SECTION) {
+        if (section) {
+          cache->SetSection(std::move(*section), std::move(properties));
+          properties.clear();
+        }
+        section.emplace();
+        corrupted = !reader.ReadString(&section.value());
+      } else if (type == RecordType::PROPERTY && section && reader.ReadString(&property) && reader.ReadString(&value)) {
+        properties.insert_or_assign(property, std::move(value));
+      } else {
+        corrupted = true;
+      }
+    }
+    if (corrupted) {
+      LOG_WARN("snapshot '%s' is corrupted", path_.c_str());
+      cache.reset();
+    } else if (section) {
+      cache->SetSection(std::move(*section), std::move(properties));
+    }
+  } else {
+    LOG_INFO("snapshot '%s' does not match config '%s'", path_.c_str(), config_path.c_str());
+  }
+  munmap(data, size);
+  return cache;
+}
+
+bool ConfigSnapshot::Delete() {
+  if (!os::FileExists(path_)) {
+    return true;
+  }
+  return os::RemoveFile(path_);
+}
+
+}  // namespace storage
+}  // namespace bluetooth
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "storage/config_cache.h"
+
+namespace bluetooth {
+namespace storage {
+
+// Binary copy of the config file, written next to it so that the stack can load the config at start without parsing
+// text. The snapshot records the size and modification time of the config file it was written with, and is only used
+// while the config file still matches them; otherwise, e.g. after the config file was edited or restored, the config
+// file is read as usual.
+//
+// The snapshot is mapped into memory and decoded in place: each section is a length-prefixed name followed by its
+// length-prefixed properties and values, so loading it costs a copy of each string into the config cache and nothing
+// else.
+class ConfigSnapshot {
+ public:
+  static ConfigSnapshot FromPath(std::string path) {
+    return ConfigSnapshot(std::move(path));
+  }
+  explicit ConfigSnapshot(std::string path);
+  // Write the persistent content of |cache| as the snapshot of the config file at |config_path|, which must hold the
+  // same content already
+  bool Write(const ConfigCache& cache, const std::string& config_path);
+  // Read the snapshot if it is valid and matches the config file at |config_path|
+  std::optional<ConfigCache> Read(const std::string& config_path, size_t temp_devices_capacity);
+  bool Delete();
+
+ private:
+  std::string path_;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
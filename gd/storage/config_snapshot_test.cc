@@ -0,0 +1,95 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/config_snapshot.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "os/files.h"
+#include "storage/device.h"
+#include "storage/legacy_config_file.h"
+
+namespace testing {
+
+using bluetooth::os::ReadSmallFile;
+using bluetooth::os::WriteToFile;
+using bluetooth::storage::ConfigCache;
+using bluetooth::storage::ConfigSnapshot;
+using bluetooth::storage::Device;
+using bluetooth::storage::LegacyConfigFile;
+
+class ConfigSnapshotTest : public Test {
+ protected:
+  void SetUp() override {
+    auto temp_dir = std::filesystem::temp_directory_path();
+    temp_config_ = temp_dir / "temp_config.txt";
+    temp_snapshot_ = temp_dir / "temp_config.snapshot";
+    config_.SetProperty("Adapter", "Address", "01:02:03:ab:cd:ef");
+    config_.SetProperty("Adapter", "Empty", "");
+    config_.SetProperty("CC:DD:EE:FF:00:11", "LinkKey", "AABBAABBCCDDEE");
+    config_.SetProperty("CC:DD:EE:FF:00:11", "Name", "name = with [separators]");
+    config_.SetProperty("AA:BB:CC:DD:EE:FF", "Name", "temporary");
+    ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config_));
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(temp_config_);
+    std::filesystem::remove(temp_snapshot_);
+  }
+
+  ConfigCache config_{100, Device::kLinkKeyProperties};
+  std::filesystem::path temp_config_;
+  std::filesystem::path temp_snapshot_;
+};
+
+TEST_F(ConfigSnapshotTest, write_and_read_loop_back_test) {
+  auto snapshot = ConfigSnapshot::FromPath(temp_snapshot_.string());
+  ASSERT_TRUE(snapshot.Write(config_, temp_config_.string()));
+  auto config_read = snapshot.Read(temp_config_.string(), 100);
+  ASSERT_TRUE(config_read);
+  // Unpaired devices do not exist in persistent config file
+  config_.RemoveSection("AA:BB:CC:DD:EE:FF");
+  EXPECT_EQ(config_, *config_read);
+  EXPECT_EQ(config_read->SerializeToLegacyFormat(), *ReadSmallFile(temp_config_.string()));
+}
+
+TEST_F(ConfigSnapshotTest, stale_snapshot_test) {
+  auto snapshot = ConfigSnapshot::FromPath(temp_snapshot_.string());
+  ASSERT_TRUE(snapshot.Write(config_, temp_config_.string()));
+  config_.SetProperty("Adapter", "Name", "changed");
+  ASSERT_TRUE(LegacyConfigFile::FromPath(temp_config_.string()).Write(config_));
+  EXPECT_FALSE(snapshot.Read(temp_config_.string(), 100));
+}
+
+TEST_F(ConfigSnapshotTest, corrupted_snapshot_test) {
+  auto snapshot = ConfigSnapshot::FromPath(temp_snapshot_.string());
+  ASSERT_TRUE(snapshot.Write(config_, temp_config_.string()));
+  auto content = ReadSmallFile(temp_snapshot_.string());
+  ASSERT_TRUE(content);
+  // Keep the header, which still matches the config file, and cut a property short
+  ASSERT_TRUE(WriteToFile(temp_snapshot_.string(), content->substr(0, content->size() - 3)));
+  EXPECT_FALSE(snapshot.Read(temp_config_.string(), 100));
+}
+
+TEST_F(ConfigSnapshotTest, missing_snapshot_test) {
+  EXPECT_FALSE(ConfigSnapshot::FromPath(temp_snapshot_.string()).Read(temp_config_.string(), 100));
+  EXPECT_TRUE(ConfigSnapshot::FromPath(temp_snapshot_.string()).Delete());
+}
+
+}  // namespace testing
@@ -16,6 +16,7 @@
 
 #include "storage/storage_module.h"
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -23,14 +24,19 @@
 #include <utility>
 
 #include "common/bind.h"
+#include "dumpsys/snapshot.h"
 #include "os/alarm.h"
 #include "os/files.h"
 #include "os/handler.h"
 #include "os/parameter_provider.h"
 #include "os/system_properties.h"
+#include "os/thread.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
+#include "storage/config_snapshot.h"
 #include "storage/legacy_config_file.h"
 #include "storage/mutation.h"
+#include "storage_module_generated.h"
 
 namespace bluetooth {
 namespace storage {
@@ -39,6 +45,7 @@ using common::ListMap;
 using common::LruCache;
 using os::Alarm;
 using os::Handler;
+using os::Thread;
 
 static const std::string kFactoryResetProperty = "persist.bluetooth.factoryreset";
 
@@ -48,6 +55,15 @@ static const std::chrono::milliseconds kDefaultConfigSaveDelay = std::chrono::mi
 // Writing a config to disk takes a minimum 10 ms on a decent x86_64 machine, and 20 ms if including backup file
 // The config saving delay must be bigger than this value to avoid overwhelming the disk
 static const std::chrono::milliseconds kMinConfigSaveDelay = std::chrono::milliseconds(20);
+// Device metadata, e.g. names, is learnt again on the next connection, so its changes wait this many times the config
+// save delay before being saved; a burst of reconnections then only rewrites the names once
+static const int kMetadataConfigSaveDelayFactor = 10;
+// Changes pending a save are written right away once they add up to this size, to bound what a crash loses
+static const size_t kMaxConfigDirtyBytes = 8 * 1024;
+static const std::chrono::milliseconds kIoHandlerStopTimeout = std::chrono::milliseconds(2000);
+// Changes are appended to a journal instead of rewriting the config; the journal is folded back into the config once it
+// grows past the size of the config itself, and at least this size, so that replaying it at start stays cheap
+static const size_t kMinJournalSizeToCompact = 16 * 1024;
 
 const std::string StorageModule::kInfoSection = "Info";
 const std::string StorageModule::kFileSourceProperty = "FileSource";
@@ -69,6 +85,10 @@ StorageModule::StorageModule(
       is_single_user_mode_(is_single_user_mode) {
   // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.bak"
   config_backup_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".bak";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.journal"
+  config_journal_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".journal";
+  // e.g. "/data/misc/bluedroid/bt_config.conf" to "/data/misc/bluedroid/bt_config.snapshot"
+  config_snapshot_path_ = config_file_path_.substr(0, config_file_path_.find_last_of('.')) + ".snapshot";
   ASSERT_LOG(
       config_save_delay > kMinConfigSaveDelay,
       "Config save delay of %lld ms is not enough, must be at least %lld ms to avoid overwhelming the disk",
@@ -87,12 +107,35 @@ const ModuleFactory StorageModule::Factory = ModuleFactory([]() {
 });
 
 struct StorageModule::impl {
-  explicit impl(Handler* handler, ConfigCache cache, size_t in_memory_cache_size_limit)
-      : config_save_alarm_(handler), cache_(std::move(cache)), memory_only_cache_(in_memory_cache_size_limit, {}) {}
+  explicit impl(
+      ConfigCache cache, size_t in_memory_cache_size_limit, ConfigJournal journal, ConfigSaveScheduler save_scheduler)
+      : io_thread_("storage_io_thread", Thread::Priority::NORMAL),
+        io_handler_(&io_thread_),
+        config_save_alarm_(&io_handler_),
+        cache_(std::move(cache)),
+        memory_only_cache_(in_memory_cache_size_limit, {}),
+        journal_(std::move(journal)),
+        save_scheduler_(std::move(save_scheduler)) {}
+  ~impl() {
+    io_handler_.Clear();
+    io_handler_.WaitUntilStopped(kIoHandlerStopTimeout);
+  }
+  // Config saving runs on its own thread
+  Thread io_thread_;
+  Handler io_handler_;
   Alarm config_save_alarm_;
   ConfigCache cache_;
   ConfigCache memory_only_cache_;
-  bool has_pending_config_save_ = false;
+  // The statistics of |save_scheduler_|, published on |io_handler_| for dumpsys to read without waiting for a save in
+  // progress
+  dumpsys::Snapshot<ConfigSaveScheduler::Stats> save_stats_;
+  // The members below are only used on |io_handler_|
+  ConfigJournal journal_;
+  ConfigSaveScheduler save_scheduler_;
+  // The config on disk cannot be brought up to date by journaling, e.g. it was restored from backup
+  bool has_pending_full_config_save_ = false;
+  // Size of the config when last written in full
+  size_t config_size_ = 0;
 };
 
 Mutation StorageModule::Modify() {
@@ -112,28 +155,95 @@ ConfigCache* StorageModule::GetMemoryOnlyConfigCache() {
 
 void StorageModule::SaveDelayed() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  if (pimpl_->has_pending_config_save_) {
+  pimpl_->io_handler_.CallOn(this, &StorageModule::ScheduleSave, ConfigSaveScheduler::Priority::NORMAL, 0);
+}
+
+void StorageModule::ScheduleSave(ConfigSaveScheduler::Priority priority, size_t changed_bytes) {
+  auto now = ConfigSaveScheduler::Clock::now();
+  auto save_time = pimpl_->save_scheduler_.OnChange(priority, changed_bytes, now);
+  pimpl_->save_stats_.Publish(pimpl_->save_scheduler_.GetStats());
+  if (!save_time) {
+    return;
+  }
+  if (*save_time <= now) {
+    // Posted rather than run here, so that the changes whose notifications are already queued join this save
+    pimpl_->config_save_alarm_.Cancel();
+    pimpl_->io_handler_.CallOn(this, &StorageModule::SaveChanges);
     return;
   }
   pimpl_->config_save_alarm_.Schedule(
-      common::BindOnce(&StorageModule::SaveImmediately, common::Unretained(this)), config_save_delay_);
-  pimpl_->has_pending_config_save_ = true;
+      common::BindOnce(&StorageModule::SaveChanges, common::Unretained(this)),
+      std::chrono::ceil<std::chrono::milliseconds>(*save_time - now));
+}
+
+void StorageModule::SaveChanges() {
+  // The changes were saved along with the whole config since this save was scheduled
+  if (!pimpl_->save_scheduler_.HasPendingSave()) {
+    return;
+  }
+  auto start_time = ConfigSaveScheduler::Clock::now();
+  pimpl_->save_scheduler_.OnSaveStarted(false);
+  bool full_save = pimpl_->has_pending_full_config_save_ ||
+                   pimpl_->journal_.Size() >= std::max(kMinJournalSizeToCompact, pimpl_->config_size_);
+  if (!full_save) {
+    auto changes = pimpl_->cache_.TakeChangedSectionsInLegacyFormat();
+    if (changes.empty()) {
+      return;
+    }
+    if (!pimpl_->journal_.Append(changes)) {
+      LOG_WARN("cannot append to journal at %s, saving the whole config", config_journal_path_.c_str());
+      full_save = true;
+    }
+  }
+  if (full_save) {
+    WriteConfig();
+  }
+  pimpl_->save_scheduler_.OnSaveDone(
+      full_save,
+      std::chrono::duration_cast<std::chrono::microseconds>(ConfigSaveScheduler::Clock::now() - start_time));
+  pimpl_->save_stats_.Publish(pimpl_->save_scheduler_.GetStats());
 }
 
 void StorageModule::SaveImmediately() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
-  if (pimpl_->has_pending_config_save_) {
-    pimpl_->config_save_alarm_.Cancel();
-    pimpl_->has_pending_config_save_ = false;
-  }
+  ASSERT(!pimpl_->io_thread_.IsSameThread());
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  pimpl_->io_handler_.Post(common::BindOnce(&StorageModule::SaveAll, common::Unretained(this), std::move(promise)));
+  future.wait();
+}
+
+void StorageModule::SaveAll(std::promise<void> promise) {
+  auto start_time = ConfigSaveScheduler::Clock::now();
+  pimpl_->config_save_alarm_.Cancel();
+  pimpl_->save_scheduler_.OnSaveStarted(true);
+  WriteConfig();
+  pimpl_->save_scheduler_.OnSaveDone(
+      true, std::chrono::duration_cast<std::chrono::microseconds>(ConfigSaveScheduler::Clock::now() - start_time));
+  pimpl_->save_stats_.Publish(pimpl_->save_scheduler_.GetStats());
+  promise.set_value();
+}
+
+void StorageModule::WriteConfig() {
+  // Changes made from here on are journaled again, replaying them on top of the config written below is harmless
+  pimpl_->cache_.TakeChangedSectionsInLegacyFormat();
+  std::string serialized = pimpl_->cache_.SerializeToLegacyFormat();
   // 1. rename old config to backup name
   if (os::FileExists(config_file_path_)) {
     ASSERT(os::RenameFile(config_file_path_, config_backup_path_));
   }
-  // 2. write in-memory config to disk, if failed, backup can still be used
-  ASSERT(LegacyConfigFile::FromPath(config_file_path_).Write(pimpl_->cache_));
+  // 2. write in-memory config to disk, if failed, backup and journal can still be used
+  ASSERT(os::WriteToFile(config_file_path_, serialized));
   // 3. now write back up to disk as well
-  ASSERT(LegacyConfigFile::FromPath(config_backup_path_).Write(pimpl_->cache_));
+  ASSERT(os::WriteToFile(config_backup_path_, serialized));
+  // 4. write the snapshot of the config for the next start, a missing or stale one only costs parsing the config
+  if (!ConfigSnapshot::FromPath(config_snapshot_path_).Write(pimpl_->cache_, config_file_path_)) {
+    LOG_WARN("cannot write config snapshot at %s", config_snapshot_path_.c_str());
+  }
+  // 5. the config and its backup contain the journaled changes, drop them
+  pimpl_->journal_.Delete();
+  pimpl_->has_pending_full_config_save_ = false;
+  pimpl_->config_size_ = serialized.size();
 }
 
 void StorageModule::ListDependencies(ModuleList* list) {
@@ -146,8 +256,14 @@ void StorageModule::Start() {
   if (os::GetSystemProperty(kFactoryResetProperty) == "true") {
     LegacyConfigFile::FromPath(config_file_path_).Delete();
     LegacyConfigFile::FromPath(config_backup_path_).Delete();
+    ConfigJournal::FromPath(config_journal_path_).Delete();
+    ConfigSnapshot::FromPath(config_snapshot_path_).Delete();
+  }
+  // The snapshot holds the same content as the config file, when it still matches it, without the parsing
+  auto config = ConfigSnapshot::FromPath(config_snapshot_path_).Read(config_file_path_, temp_devices_capacity_);
+  if (!config || !config->HasSection(kAdapterSection)) {
+    config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
   }
-  auto config = LegacyConfigFile::FromPath(config_file_path_).Read(temp_devices_capacity_);
   if (!config || !config->HasSection(kAdapterSection)) {
     LOG_WARN("cannot load config at %s, using backup at %s.", config_file_path_.c_str(), config_backup_path_.c_str());
     config = LegacyConfigFile::FromPath(config_backup_path_).Read(temp_devices_capacity_);
@@ -158,6 +274,16 @@ void StorageModule::Start() {
     config.emplace(temp_devices_capacity_, Device::kLinkKeyProperties);
     file_source = "Empty";
   }
+  // Bring the config up to date with the changes journaled since it was written
+  auto journal = ConfigJournal::FromPath(config_journal_path_);
+  size_t num_journal_records = journal.Replay(&config.value());
+  if (num_journal_records > 0) {
+    LOG_INFO("replayed %zu journal records from %s", num_journal_records, config_journal_path_.c_str());
+  }
+  // Only changes made from now on are journaled
+  config->TakeChangedSectionsInLegacyFormat();
+  // Fold a journal left by a crash, or a config not read from the main file, into a fresh config file
+  bool has_pending_full_config_save = !file_source.empty() || journal.Size() > 0;
   if (!file_source.empty()) {
     config->SetProperty(kInfoSection, kFileSourceProperty, std::move(file_source));
   }
@@ -175,18 +301,70 @@ void StorageModule::Start() {
     config->SetProperty(kInfoSection, kTimeCreatedProperty, ss.str());
   }
   config->FixDeviceTypeInconsistencies();
-  config->SetPersistentConfigChangedCallback([this] { this->CallOn(this, &StorageModule::SaveDelayed); });
   // TODO (b/158035889) Migrate metrics module to GD
-  pimpl_ = std::make_unique<impl>(GetHandler(), std::move(config.value()), temp_devices_capacity_);
+  pimpl_ = std::make_unique<impl>(
+      std::move(config.value()),
+      temp_devices_capacity_,
+      std::move(journal),
+      ConfigSaveScheduler(config_save_delay_, config_save_delay_ * kMetadataConfigSaveDelayFactor, kMaxConfigDirtyBytes));
+  pimpl_->has_pending_full_config_save_ = has_pending_full_config_save;
+  auto* io_handler = &pimpl_->io_handler_;
+  pimpl_->cache_.SetPersistentConfigChangedCallback(
+      [this, io_handler](const std::string& section, const std::string& property, size_t changed_bytes) {
+        io_handler->CallOn(
+            this, &StorageModule::ScheduleSave, ConfigSaveScheduler::GetPriority(section, property), changed_bytes);
+      });
   SaveDelayed();
 }
 
 void StorageModule::Stop() {
   std::lock_guard<std::recursive_mutex> lock(mutex_);
+  // Changes made from now on are dropped with the config
+  pimpl_->cache_.SetPersistentConfigChangedCallback({});
   SaveImmediately();
+  const auto& stats = pimpl_->save_scheduler_.GetStats();
+  LOG_INFO(
+      "config saved %llu times in journal and %llu times in full, for %llu changes, max save duration %lld us",
+      static_cast<unsigned long long>(stats.num_journal_saves),
+      static_cast<unsigned long long>(stats.num_full_saves),
+      static_cast<unsigned long long>(stats.num_changes),
+      static_cast<long long>(stats.max_save_duration.count()));
   pimpl_.reset();
 }
 
+DumpsysDataFinisher StorageModule::GetDumpsysData(flatbuffers::FlatBufferBuilder* fb_builder) const {
+  ASSERT(fb_builder != nullptr);
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (!pimpl_) {
+    return Module::GetDumpsysData(fb_builder);
+  }
+
+  // The save statistics are updated on the storage I/O thread, which may be busy saving
+  auto save_stats = pimpl_->save_stats_.Read();
+  auto stats = save_stats ? *save_stats : ConfigSaveScheduler::Stats{};
+
+  auto title = fb_builder->CreateString("----- Storage Module Dumpsys -----");
+  auto num_saves = [&stats](ConfigSaveScheduler::Trigger trigger) {
+    return stats.num_saves_by_trigger[static_cast<size_t>(trigger)];
+  };
+  StorageModuleDataBuilder builder(*fb_builder);
+  builder.add_title(title);
+  builder.add_num_changes(stats.num_changes);
+  builder.add_num_bond_saves(num_saves(ConfigSaveScheduler::Trigger::BOND));
+  builder.add_num_latency_saves(num_saves(ConfigSaveScheduler::Trigger::LATENCY));
+  builder.add_num_dirty_bytes_saves(num_saves(ConfigSaveScheduler::Trigger::DIRTY_BYTES));
+  builder.add_num_requested_saves(num_saves(ConfigSaveScheduler::Trigger::REQUESTED));
+  builder.add_num_journal_saves(stats.num_journal_saves);
+  builder.add_num_full_saves(stats.num_full_saves);
+  builder.add_total_save_duration_us(stats.total_save_duration.count());
+  builder.add_max_save_duration_us(stats.max_save_duration.count());
+  flatbuffers::Offset<StorageModuleData> dumpsys_data = builder.Finish();
+
+  return [dumpsys_data](DumpsysDataBuilder* dumpsys_builder) {
+    dumpsys_builder->add_storage_module_dumpsys_data(dumpsys_data);
+  };
+}
+
 std::string StorageModule::ToString() const {
   return "Storage Module";
 }
@@ -18,6 +18,7 @@
 #include <array>
 #include <chrono>
 #include <cstdint>
+#include <future>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -27,6 +28,7 @@
 #include "module.h"
 #include "storage/adapter_config.h"
 #include "storage/config_cache.h"
+#include "storage/config_save_scheduler.h"
 #include "storage/device.h"
 #include "storage/mutation.h"
 
@@ -109,6 +111,7 @@ class StorageModule : public bluetooth::Module {
   void ListDependencies(ModuleList* list) override;
   void Start() override;
   void Stop() override;
+  DumpsysDataFinisher GetDumpsysData(flatbuffers::FlatBufferBuilder* builder) const override;
   std::string ToString() const override;
 
   friend shim::BtifConfigInterface;
@@ -116,11 +119,14 @@ class StorageModule : public bluetooth::Module {
   ConfigCache* GetConfigCache();
   // For unit test only
   ConfigCache* GetMemoryOnlyConfigCache();
-  // Normally, underlying config will be saved at most 3 seconds after the first config change in a series of changes
-  // This method triggers the delayed saving automatically, the delay is equal to |config_save_delay_|
+  // Normally, underlying config will be saved at most 3 seconds after the first config change in a series of changes,
+  // sooner for bonding keys and later for device metadata, see ConfigSaveScheduler. Config changes trigger the delayed
+  // saving automatically, this method requests it explicitly with a delay equal to |config_save_delay_|
   void SaveDelayed();
-  // In some cases, one may want to save the config immediately to disk. Call this method with caution as it runs
-  // immediately on the calling thread
+
+  // In some cases, one may want to save the config immediately to disk. Call this method with caution as it blocks the
+  // calling thread until the storage I/O thread has written the config. The whole config is rewritten and the journal
+  // is emptied. Must not be called from the storage I/O thread
   void SaveImmediately();
 
   // Create the storage module where:
@@ -136,11 +142,23 @@ class StorageModule : public bluetooth::Module {
       bool is_single_user_mode);
 
  private:
+  // The methods below run on the storage I/O thread, so that file I/O never blocks the module handler
+  // Account for a config change of |priority| and schedule the save it requires
+  void ScheduleSave(ConfigSaveScheduler::Priority priority, size_t changed_bytes);
+  // Write the changes made since the last save to disk, by appending them to the config journal, or by rewriting the
+  // whole config when the journal has grown too large
+  void SaveChanges();
+  // Rewrite the whole config for SaveImmediately()
+  void SaveAll(std::promise<void> promise);
+  void WriteConfig();
+
   struct impl;
   mutable std::recursive_mutex mutex_;
   std::unique_ptr<impl> pimpl_;
   std::string config_file_path_;
   std::string config_backup_path_;
+  std::string config_journal_path_;
+  std::string config_snapshot_path_;
   std::chrono::milliseconds config_save_delay_;
   size_t temp_devices_capacity_;
   bool is_restricted_mode_;
@@ -30,6 +30,7 @@
 #include "module.h"
 #include "os/files.h"
 #include "storage/config_cache.h"
+#include "storage/config_journal.h"
 #include "storage/device.h"
 #include "storage/legacy_config_file.h"
 
@@ -108,9 +109,13 @@ class StorageModuleTest : public Test {
     temp_dir_ = std::filesystem::temp_directory_path();
     temp_config_ = temp_dir_ / "temp_config.txt";
     temp_backup_config_ = temp_dir_ / "temp_config.bak";
+    temp_journal_ = temp_dir_ / "temp_config.journal";
+    temp_snapshot_ = temp_dir_ / "temp_config.snapshot";
     DeleteConfigFiles();
     ASSERT_FALSE(std::filesystem::exists(temp_config_));
     ASSERT_FALSE(std::filesystem::exists(temp_backup_config_));
+    ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+    ASSERT_FALSE(std::filesystem::exists(temp_snapshot_));
   }
 
   void TearDown() override {
@@ -124,11 +129,28 @@ class StorageModuleTest : public Test {
     if (std::filesystem::exists(temp_backup_config_)) {
       ASSERT_TRUE(std::filesystem::remove(temp_backup_config_));
     }
+    if (std::filesystem::exists(temp_journal_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_journal_));
+    }
+    if (std::filesystem::exists(temp_snapshot_)) {
+      ASSERT_TRUE(std::filesystem::remove(temp_snapshot_));
+    }
+  }
+
+  // The config on disk: the config file with the changes journaled since it was written
+  std::optional<ConfigCache> ReadConfigWithJournal() {
+    auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+    if (config) {
+      ConfigJournal::FromPath(temp_journal_.string()).Replay(&config.value());
+    }
+    return config;
   }
 
   std::filesystem::path temp_dir_;
   std::filesystem::path temp_config_;
   std::filesystem::path temp_backup_config_;
+  std::filesystem::path temp_journal_;
+  std::filesystem::path temp_snapshot_;
 };
 
 TEST_F(StorageModuleTest, empty_config_no_op_test) {
@@ -251,21 +273,21 @@ TEST_F(StorageModuleTest, save_config_test) {
   storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
   ASSERT_THAT(storage->GetConfigCachePublic()->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  auto config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  auto config = ReadConfigWithJournal();
   ASSERT_TRUE(config);
   ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
 
   // Remove a property
   storage->GetConfigCachePublic()->RemoveProperty("01:02:03:ab:cd:ea", "name");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadConfigWithJournal();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasProperty("01:02:03:ab:cd:ea", "name"));
 
   // Remove a section
   storage->GetConfigCachePublic()->RemoveSection("01:02:03:ab:cd:ea");
   std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
-  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  config = ReadConfigWithJournal();
   ASSERT_TRUE(config);
   ASSERT_FALSE(config->HasSection("01:02:03:ab:cd:ea"));
 
@@ -275,6 +297,7 @@ TEST_F(StorageModuleTest, save_config_test) {
   config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
   ASSERT_TRUE(config);
   ASSERT_TRUE(config->HasSection("01:02:03:ab:cd:eb"));
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
 
   // Tear down
   test_registry.StopAll();
@@ -283,6 +306,45 @@ TEST_F(StorageModuleTest, save_config_test) {
   ASSERT_TRUE(std::filesystem::exists(temp_config_));
 }
 
+TEST_F(StorageModuleTest, journal_config_changes_test) {
+  // Prepare config file
+  ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
+
+  // Set up
+  auto* storage = new TestStorageModule(temp_config_.string(), kTestConfigSaveDelay, 10, false, false);
+  TestModuleRegistry test_registry;
+  test_registry.InjectTestModule(&StorageModule::Factory, storage);
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  auto config_on_disk = bluetooth::os::ReadSmallFile(temp_config_.string());
+  ASSERT_TRUE(config_on_disk);
+
+  // Changes go to the journal, the config file is left untouched
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:ea", "name", "foo");
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  storage->GetConfigCachePublic()->SetProperty("01:02:03:ab:cd:eb", "LinkKey", "123456");
+  storage->GetConfigCachePublic()->RemoveSection("Metrics");
+  std::this_thread::sleep_for(kTestConfigSaveWaitDelay);
+  ASSERT_TRUE(std::filesystem::exists(temp_journal_));
+  ASSERT_THAT(bluetooth::os::ReadSmallFile(temp_config_.string()), Optional(StrEq(*config_on_disk)));
+
+  // A crash in the middle of an append drops that append only
+  ASSERT_TRUE(bluetooth::os::AppendToFile(temp_journal_.string(), "#journal 100 12345\n[01:02:03:ab:cd:ea]\n"));
+  auto config = ReadConfigWithJournal();
+  ASSERT_TRUE(config);
+  ASSERT_TRUE(*config == *storage->GetConfigCachePublic());
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_TRUE(config->HasSection("01:02:03:ab:cd:eb"));
+  ASSERT_FALSE(config->HasSection("Metrics"));
+
+  // Tear down, the journal is folded into the config file
+  test_registry.StopAll();
+  ASSERT_FALSE(std::filesystem::exists(temp_journal_));
+  config = LegacyConfigFile::FromPath(temp_config_.string()).Read(10);
+  ASSERT_TRUE(config);
+  ASSERT_THAT(config->GetProperty("01:02:03:ab:cd:ea", "name"), Optional(StrEq("foo")));
+  ASSERT_FALSE(config->HasSection("Metrics"));
+}
+
 TEST_F(StorageModuleTest, get_bonded_devices_test) {
   // Prepare config file
   ASSERT_TRUE(bluetooth::os::WriteToFile(temp_config_.string(), kReadTestConfig));
@@ -51,6 +51,12 @@ typedef struct btsnoop_t {
   // Clear an L2CAP channel from being filtered.
   void (*clear_l2cap_allowlist)(uint16_t conn_handle, uint16_t local_cid,
                                 uint16_t remote_cid);
+
+  // Keep at most |max_payload| bytes past the L2CAP header of packets with
+  // that L2CAP CID, e.g. only the media headers of an audio stream. Applied in
+  // filtered mode, and in full mode if truncation is enabled. The limit is
+  // dropped with the channel by |clear_l2cap_allowlist|.
+  void (*truncate_l2c_channel)(uint16_t local_cid, uint16_t max_payload);
 } btsnoop_t;
 
 const btsnoop_t* btsnoop_get_interface(void);
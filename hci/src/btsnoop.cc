@@ -35,12 +35,14 @@
 #include <sys/time.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "bt_types.h"
 #include "common/time_util.h"
+#include "gd/common/trace_ring.h"
 #include "hci/include/btsnoop.h"
 #include "hci/include/btsnoop_mem.h"
 #include "hci_layer.h"
@@ -70,6 +72,7 @@
 #define BTSNOOP_PATH_PROPERTY "persist.bluetooth.btsnooppath"
 #define DEFAULT_BTSNOOP_PATH "/data/misc/bluetooth/logs/btsnoop_hci.log"
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
+#define BTSNOOP_TRUNCATE_PROPERTY "persist.bluetooth.btsnooptruncate"
 
 typedef enum {
   kCommandPacket = 1,
@@ -110,6 +113,9 @@ class FilterTracker {
   uint16_t rfc_local_cid = 0;
   uint16_t rfc_remote_cid = 0;
   std::unordered_set<uint16_t> rfc_channels = {0};
+  // L2CAP CID to the number of payload bytes to keep
+  std::unordered_map<uint16_t, uint16_t> l2c_local_truncation;
+  std::unordered_map<uint16_t, uint16_t> l2c_remote_truncation;
 
   // Adds L2C channel to allowlist.
   void addL2cCid(uint16_t local_cid, uint16_t remote_cid) {
@@ -134,6 +140,15 @@ class FilterTracker {
 
     l2c_local_cid.erase(local_cid);
     l2c_remote_cid.erase(remote_cid);
+    l2c_local_truncation.erase(local_cid);
+    l2c_remote_truncation.erase(remote_cid);
+  }
+
+  // Limits the payload logged for an L2C channel.
+  void setL2cTruncation(uint16_t local_cid, uint16_t remote_cid,
+                        uint16_t max_payload) {
+    l2c_local_truncation[local_cid] = max_payload;
+    l2c_remote_truncation[remote_cid] = max_payload;
   }
 
   void addRfcDlci(uint8_t channel) { rfc_channels.insert(channel); }
@@ -151,6 +166,15 @@ class FilterTracker {
   bool isAllowlistedDlci(uint8_t dlci) {
     return rfc_channels.find(dlci) != rfc_channels.end();
   }
+
+  // Returns false if the channel has no payload limit.
+  bool getL2cTruncation(bool local, uint16_t cid, uint16_t* max_payload) {
+    const auto& map = local ? l2c_local_truncation : l2c_remote_truncation;
+    auto it = map.find(cid);
+    if (it == map.end()) return false;
+    *max_payload = it->second;
+    return true;
+  }
 };
 
 std::mutex filter_list_mutex;
@@ -161,6 +185,8 @@ std::unordered_map<uint16_t, uint16_t> local_cid_to_acl;
 // checked for every packet.
 static bool is_btsnoop_enabled;
 static bool is_btsnoop_filtered;
+// Whether per channel payload limits are applied.
+static bool is_btsnoop_truncated;
 
 // TODO(zachoverflow): merge btsnoop and btsnoop_net together
 void btsnoop_net_open();
@@ -213,6 +239,11 @@ static future_t* start_up() {
     delete_btsnoop_files(false);
   }
 
+  is_btsnoop_truncated =
+      is_btsnoop_filtered ||
+      (is_btsnoop_enabled &&
+       osi_property_get_bool(BTSNOOP_TRUNCATE_PROPERTY, false));
+
   if (is_btsnoop_enabled) {
     open_next_snoop_file();
     packets_per_file = osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
@@ -254,9 +285,49 @@ EXPORT_SYMBOL extern const module_t btsnoop_module = {
     .dependencies = {STACK_CONFIG_MODULE, NULL}};
 
 // Interface functions
+// Trace the packet with the connection handle of data packets, and with the
+// opcode of commands and the event code of events in place of the length
+static void trace_packet(const BT_HDR* buffer, bool is_received) {
+  using bluetooth::common::TraceEventId;
+  using bluetooth::common::TraceRing;
+
+  const uint8_t* p = buffer->data + buffer->offset;
+  uint16_t handle = buffer->len >= 2 ? (p[0] | (p[1] << 8)) & 0x0fff : 0;
+  switch (buffer->event & MSG_EVT_MASK) {
+    case MSG_HC_TO_STACK_HCI_EVT:
+      TraceRing::Record(TraceEventId::HCI_EVENT_RX, 0,
+                        buffer->len >= 1 ? p[0] : 0);
+      break;
+    case MSG_STACK_TO_HC_HCI_CMD:
+      TraceRing::Record(TraceEventId::HCI_COMMAND_TX, 0,
+                        buffer->len >= 2 ? p[0] | (p[1] << 8) : 0);
+      break;
+    case MSG_HC_TO_STACK_HCI_ACL:
+    case MSG_STACK_TO_HC_HCI_ACL:
+      TraceRing::Record(is_received ? TraceEventId::HCI_ACL_RX
+                                    : TraceEventId::HCI_ACL_TX,
+                        handle, buffer->len);
+      break;
+    case MSG_HC_TO_STACK_HCI_SCO:
+    case MSG_STACK_TO_HC_HCI_SCO:
+      TraceRing::Record(is_received ? TraceEventId::HCI_SCO_RX
+                                    : TraceEventId::HCI_SCO_TX,
+                        handle, buffer->len);
+      break;
+    case MSG_HC_TO_STACK_HCI_ISO:
+    case MSG_STACK_TO_HC_HCI_ISO:
+      TraceRing::Record(is_received ? TraceEventId::HCI_ISO_RX
+                                    : TraceEventId::HCI_ISO_TX,
+                        handle, buffer->len);
+      break;
+  }
+}
+
 static void capture(const BT_HDR* buffer, bool is_received) {
   uint8_t* p = const_cast<uint8_t*>(buffer->data + buffer->offset);
 
+  trace_packet(buffer, is_received);
+
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
 
   struct timespec ts_now = {};
@@ -346,9 +417,27 @@ static void clear_l2cap_allowlist(uint16_t conn_handle, uint16_t local_cid,
   filter_list[conn_handle].removeL2cCid(local_cid, remote_cid);
 }
 
-static const btsnoop_t interface = {capture, allowlist_l2c_channel,
-                                    allowlist_rfc_dlci, add_rfc_l2c_channel,
-                                    clear_l2cap_allowlist};
+static void truncate_l2c_channel(uint16_t local_cid, uint16_t max_payload) {
+  LOG(INFO) << __func__
+            << ": Truncating l2cap channel. cid=" << loghex(local_cid)
+            << " max_payload=" << max_payload;
+  if (bluetooth::shim::is_any_gd_enabled()) {
+    return;
+  }
+  std::lock_guard lock(filter_list_mutex);
+
+  tL2C_CCB* p_ccb = l2cu_find_ccb_by_cid(nullptr, local_cid);
+  if (p_ccb == nullptr) return;
+  filter_list[p_ccb->p_lcb->Handle()].setL2cTruncation(
+      local_cid, p_ccb->remote_cid, max_payload);
+}
+
+static const btsnoop_t interface = {capture,
+                                    allowlist_l2c_channel,
+                                    allowlist_rfc_dlci,
+                                    add_rfc_l2c_channel,
+                                    clear_l2cap_allowlist,
+                                    truncate_l2c_channel};
 
 const btsnoop_t* btsnoop_get_interface() { return &interface; }
 
@@ -419,15 +508,8 @@ static uint64_t htonll(uint64_t ll) {
   return ll;
 }
 
-static bool should_filter_log(bool is_received, uint8_t* packet) {
-  uint16_t acl_handle =
-      HCID_GET_HANDLE((((uint16_t)packet[ACL_CHANNEL_OFFSET + 1]) << 8) +
-                      packet[ACL_CHANNEL_OFFSET]);
-
-  std::lock_guard lock(filter_list_mutex);
-  auto& filters = filter_list[acl_handle];
-  uint16_t l2c_channel =
-      (packet[L2C_CHANNEL_OFFSET + 1] << 8) + packet[L2C_CHANNEL_OFFSET];
+static bool should_filter_log(FilterTracker& filters, bool is_received,
+                              uint8_t* packet, uint16_t l2c_channel) {
   if (filters.isRfcChannel(is_received, l2c_channel)) {
     uint8_t rfc_event = packet[RFC_EVENT_OFFSET] & 0b11101111;
     if (rfc_event == RFCOMM_SABME || rfc_event == RFCOMM_UA) {
@@ -445,6 +527,30 @@ static bool should_filter_log(bool is_received, uint8_t* packet) {
   return false;
 }
 
+// Returns how much of an ACL packet of |length| bytes, including the type
+// byte, goes into the log.
+static uint32_t get_captured_length(bool is_received, uint8_t* packet,
+                                    uint32_t length) {
+  uint16_t acl_handle =
+      HCID_GET_HANDLE((((uint16_t)packet[ACL_CHANNEL_OFFSET + 1]) << 8) +
+                      packet[ACL_CHANNEL_OFFSET]);
+
+  std::lock_guard lock(filter_list_mutex);
+  auto& filters = filter_list[acl_handle];
+  uint16_t l2c_channel =
+      (packet[L2C_CHANNEL_OFFSET + 1] << 8) + packet[L2C_CHANNEL_OFFSET];
+  if (is_btsnoop_filtered &&
+      should_filter_log(filters, is_received, packet, l2c_channel)) {
+    return std::min(length, L2C_HEADER_SIZE);
+  }
+
+  uint16_t max_payload;
+  if (filters.getL2cTruncation(is_received, l2c_channel, &max_payload)) {
+    return std::min(length, L2C_HEADER_SIZE + max_payload);
+  }
+  return length;
+}
+
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us) {
   uint32_t length_he = 0;
@@ -476,14 +582,12 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
   btsnoop_header_t header;
   header.length_original = htonl(length_he);
 
-  bool rejectlisted = false;
-  if (is_btsnoop_filtered && type == kAclPacket) {
-    rejectlisted = should_filter_log(is_received, packet);
+  // Only the captured part of the packet is ever copied out
+  if (is_btsnoop_truncated && type == kAclPacket) {
+    length_he = get_captured_length(is_received, packet, length_he);
   }
 
-  header.length_captured =
-      rejectlisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
-  if (rejectlisted) length_he = L2C_HEADER_SIZE;
+  header.length_captured = htonl(length_he);
   header.flags = htonl(flags);
   header.dropped_packets = 0;
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
@@ -106,47 +106,70 @@ static int rfkill(int block);
 int reader_thread_ctrl_fd = -1;
 Thread* reader_thread = NULL;
 
+static void dispatch_packet(const allocator_t* buffer_allocator,
+                            const uint8_t* buf, size_t buf_size, size_t len) {
+  uint8_t type = buf[0];
+
+  size_t packet_size = buf_size + BT_HDR_SIZE;
+  BT_HDR* packet =
+      reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  packet->len = len - 1;
+  memcpy(packet->data, buf + 1, len - 1);
+
+  switch (type) {
+    case HCI_PACKET_TYPE_COMMAND:
+      packet->event = MSG_HC_TO_STACK_HCI_EVT;
+      hci_event_received(FROM_HERE, packet);
+      break;
+    case HCI_PACKET_TYPE_ACL_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_ACL;
+      acl_event_received(packet);
+      break;
+    case HCI_PACKET_TYPE_SCO_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_SCO;
+      sco_data_received(packet);
+      break;
+    case HCI_PACKET_TYPE_EVENT:
+      packet->event = MSG_HC_TO_STACK_HCI_EVT;
+      hci_event_received(FROM_HERE, packet);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected event type: " << +type;
+      break;
+  }
+}
+
 void monitor_socket(int ctrl_fd, int fd) {
   const allocator_t* buffer_allocator = buffer_allocator_get_interface();
   const size_t buf_size = 2000;
-  uint8_t buf[buf_size];
-  ssize_t len = read(fd, buf, buf_size);
-
-  while (len > 0) {
-    if (len == buf_size)
-      LOG(FATAL) << "This packet filled buffer, if it have continuation we "
-                    "don't know how to merge it, increase buffer size!";
-
-    uint8_t type = buf[0];
-
-    size_t packet_size = buf_size + BT_HDR_SIZE;
-    BT_HDR* packet =
-        reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
-    packet->offset = 0;
-    packet->layer_specific = 0;
-    packet->len = len - 1;
-    memcpy(packet->data, buf + 1, len - 1);
-
-    switch (type) {
-      case HCI_PACKET_TYPE_COMMAND:
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        hci_event_received(FROM_HERE, packet);
-        break;
-      case HCI_PACKET_TYPE_ACL_DATA:
-        packet->event = MSG_HC_TO_STACK_HCI_ACL;
-        acl_event_received(packet);
-        break;
-      case HCI_PACKET_TYPE_SCO_DATA:
-        packet->event = MSG_HC_TO_STACK_HCI_SCO;
-        sco_data_received(packet);
-        break;
-      case HCI_PACKET_TYPE_EVENT:
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        hci_event_received(FROM_HERE, packet);
-        break;
-      default:
-        LOG(FATAL) << "Unexpected event type: " << +type;
-        break;
+  // Each packet is a datagram on the HCI socket, up to this many of them are
+  // received with a single recvmmsg()
+  const size_t max_batch = 16;
+  uint8_t bufs[max_batch][buf_size];
+  struct iovec iovs[max_batch];
+  struct mmsghdr msgs[max_batch];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < max_batch; i++) {
+    iovs[i].iov_base = bufs[i];
+    iovs[i].iov_len = buf_size;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  // Waits for the first datagram only, then takes those already queued
+  int count;
+  OSI_NO_INTR(count = recvmmsg(fd, msgs, max_batch, MSG_WAITFORONE, NULL));
+
+  while (count > 0) {
+    for (int i = 0; i < count; i++) {
+      size_t len = msgs[i].msg_len;
+      if (len == buf_size)
+        LOG(FATAL) << "This packet filled buffer, if it have continuation we "
+                      "don't know how to merge it, increase buffer size!";
+      if (len == 0) continue;
+      dispatch_packet(buffer_allocator, bufs[i], buf_size, len);
     }
 
     fd_set fds;
@@ -161,7 +184,7 @@ void monitor_socket(int ctrl_fd, int fd) {
       return;
     }
 
-    len = read(fd, buf, buf_size);
+    OSI_NO_INTR(count = recvmmsg(fd, msgs, max_batch, MSG_WAITFORONE, NULL));
   }
 }
 
@@ -149,31 +149,39 @@ static void fragment_and_dispatch_iso(BT_HDR* packet) {
   if (remaining_length <= max_packet_size) {
     stream = packet->data + packet->offset;
     UINT16_TO_STREAM(stream, HCI_ISO_SET_COMPLETE_FLAG(handle));
-  } else {
-    while (remaining_length > max_packet_size) {
-      // Make sure we use the right ISO packet size
-      stream = packet->data + packet->offset;
-      STREAM_SKIP_UINT16(stream);
-      UINT16_TO_STREAM(stream, max_data_size);
+    callbacks->fragmented(packet, true);
+    return;
+  }
 
-      packet->len = max_packet_size;
-      callbacks->fragmented(packet, false);
+  // The headers of the fragments only differ by their flags. Each one is
+  // written in place, over the end of the previous fragment, which was sent.
+  uint16_t first_handle = handle & 0x4FFF;
+  uint16_t continuation_handle =
+      HCI_ISO_SET_CONTINUATION_FLAG(handle & HANDLE_MASK);
+  uint16_t end_handle = HCI_ISO_SET_END_FRAG_FLAG(handle & HANDLE_MASK);
 
-      packet->offset += max_data_size;
-      remaining_length -= max_data_size;
-      packet->len = remaining_length;
+  stream = packet->data + packet->offset;
+  UINT16_TO_STREAM(stream, first_handle);
 
-      // Write the ISO header for the next fragment
-      stream = packet->data + packet->offset;
-      if (remaining_length > max_packet_size) {
-        UINT16_TO_STREAM(stream,
-                         HCI_ISO_SET_CONTINUATION_FLAG(handle & HANDLE_MASK));
-      } else {
-        UINT16_TO_STREAM(stream,
-                         HCI_ISO_SET_END_FRAG_FLAG(handle & HANDLE_MASK));
-      }
-      UINT16_TO_STREAM(stream, remaining_length - HCI_ISO_PREAMBLE_SIZE);
-    }
+  while (remaining_length > max_packet_size) {
+    // Make sure we use the right ISO packet size
+    stream = packet->data + packet->offset;
+    STREAM_SKIP_UINT16(stream);
+    UINT16_TO_STREAM(stream, max_data_size);
+
+    packet->len = max_packet_size;
+    callbacks->fragmented(packet, false);
+
+    packet->offset += max_data_size;
+    remaining_length -= max_data_size;
+    packet->len = remaining_length;
+
+    // Write the ISO header for the next fragment
+    stream = packet->data + packet->offset;
+    UINT16_TO_STREAM(stream, remaining_length > max_packet_size
+                                 ? continuation_handle
+                                 : end_handle);
+    UINT16_TO_STREAM(stream, remaining_length - HCI_ISO_PREAMBLE_SIZE);
   }
   callbacks->fragmented(packet, true);
 }
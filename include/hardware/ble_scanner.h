@@ -122,6 +122,16 @@ class BleScannerInterface {
   /** Start or stop LE device scanning */
   virtual void Scan(bool start) = 0;
 
+  /**
+   * Lets a scanner do without scan results repeating the last one from the
+   * same advertiser (same event type and data, RSSI within |rssi_threshold|
+   * dB) for |window_ms|. Repeats are dropped only once every registered
+   * scanner set such a window. A |window_ms| of 0, the default, reports every
+   * result.
+   */
+  virtual void SetScanResultFilter(int scanner_id, int window_ms,
+                                   int rssi_threshold) {}
+
   /** Setup scan filter params */
   virtual void ScanFilterParamSetup(
       uint8_t client_if, uint8_t action, uint8_t filt_index,
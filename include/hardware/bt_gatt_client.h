@@ -63,6 +63,17 @@ typedef struct {
   uint8_t is_notify;
 } btgatt_notify_params_t;
 
+/** A notification or indication delivered by notify_batch_callback. |value|
+ * points to |len| octets that are only valid during the callback. */
+typedef struct {
+  int conn_id;
+  RawAddress bda;
+  uint16_t handle;
+  uint16_t len;
+  uint8_t is_notify;
+  const uint8_t* value;
+} btgatt_notification_t;
+
 typedef struct {
   RawAddress* bda1;
   bluetooth::Uuid* uuid1;
@@ -124,6 +135,22 @@ typedef void (*register_for_notification_callback)(int conn_id, int registered,
 typedef void (*notify_callback)(int conn_id,
                                 const btgatt_notify_params_t& p_data);
 
+/**
+ * Optional replacement of notify_callback, invoked with all the notifications
+ * and indications received since the previous call, in order.
+ */
+typedef void (*notify_batch_callback)(
+    const btgatt_notification_t* notifications, size_t count);
+
+/**
+ * Reports the progress of write_characteristic_stream, in octets handed to
+ * the controller. The stream is over once |status| is not 0 or |sent| equals
+ * |total|.
+ */
+typedef void (*write_stream_progress_callback)(int conn_id, int status,
+                                               uint16_t handle, uint32_t sent,
+                                               uint32_t total);
+
 /** Reports result of a GATT read operation */
 typedef void (*read_characteristic_callback)(int conn_id, int status,
                                              btgatt_read_params_t* p_data);
@@ -205,6 +232,8 @@ typedef struct {
   phy_updated_callback phy_updated_cb;
   conn_updated_callback conn_updated_cb;
   service_changed_callback service_changed_cb;
+  notify_batch_callback notify_batch_cb;
+  write_stream_progress_callback write_stream_progress_cb;
 } btgatt_client_callbacks_t;
 
 /** Represents the standard BT-GATT client interface. */
@@ -310,6 +339,12 @@ typedef struct {
   /** Get gatt db content */
   bt_status_t (*get_gatt_db)(int conn_id);
 
+  /** Write a stream of data to a characteristic with Write Commands, as fast
+   * as the link takes them */
+  bt_status_t (*write_characteristic_stream)(int conn_id, uint16_t handle,
+                                             int auth_req,
+                                             std::vector<uint8_t> value);
+
 } btgatt_client_interface_t;
 
 __END_DECLS
@@ -178,6 +178,13 @@ typedef struct {
       const RawAddress& bd_addr,
       base::Callback<void(uint8_t tx_phy, uint8_t rx_phy, uint8_t status)> cb);
 
+  /** Let the stack answer reads of a characteristic or descriptor with
+   * |value|, for |ttl_ms| milliseconds or for good if 0. An empty |value|
+   * stops caching. The cached value is dropped when a client writes it. */
+  bt_status_t (*set_attribute_cache)(int attribute_handle,
+                                     std::vector<uint8_t> value,
+                                     uint64_t ttl_ms);
+
 } btgatt_server_interface_t;
 
 __END_DECLS
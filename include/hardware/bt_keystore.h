@@ -14,6 +14,12 @@
  * limitations under the License.
  */
 
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
 namespace bluetooth {
 namespace bluetooth_keystore {
 
@@ -27,6 +33,19 @@ class BluetoothKeystoreCallbacks {
 
   /** Callback for get key. */
   virtual std::string get_key(std::string prefix) = 0;
+
+  /**
+   * Callback for get keys, returns the keys found for |prefixes| at once.
+   * Override to decrypt them in a single call; defaults to one get_key each.
+   */
+  virtual std::map<std::string, std::string> get_keys(
+      std::vector<std::string> prefixes) {
+    std::map<std::string, std::string> keys;
+    for (auto& prefix : prefixes) {
+      keys[prefix] = get_key(prefix);
+    }
+    return keys;
+  }
 };
 
 class BluetoothKeystoreInterface {
@@ -43,6 +62,9 @@ class BluetoothKeystoreInterface {
   /** Interface for get key. */
   virtual std::string get_key(std::string prefix) = 0;
 
+  /** Interface for loading keys of |prefixes| into the map at once. */
+  virtual void load_keys(std::vector<std::string> prefixes) = 0;
+
   /** Interface for clear map. */
   virtual void clear_map() = 0;
 };
@@ -107,8 +107,10 @@
 #define BTA_AV_CO_CP_SCMS_T FALSE
 #endif
 
+/* Initial size of the discovery database of a service discovery, it grows up
+ * to SDP_MAX_DISC_DB_SIZE as needed */
 #ifndef BTA_DM_SDP_DB_SIZE
-#define BTA_DM_SDP_DB_SIZE 20000
+#define BTA_DM_SDP_DB_SIZE 4096
 #endif
 
 #ifndef HL_INCLUDED
@@ -282,6 +284,18 @@
 #define BTM_INQ_DB_SIZE 40
 #endif
 
+/* How long, in seconds, the name of a peer device read with a remote name
+ * request is used instead of reading it again. */
+#ifndef BTM_RMT_NAME_CACHE_TTL_S
+#define BTM_RMT_NAME_CACHE_TTL_S (24 * 60 * 60)
+#endif
+
+/* How long, in seconds, the LMP version and features of a peer device are
+ * used instead of reading them again on connection. */
+#ifndef BTM_RMT_INFO_CACHE_TTL_S
+#define BTM_RMT_INFO_CACHE_TTL_S (30 * 24 * 60 * 60)
+#endif
+
 /* Sets the Page_Scan_Window:  the length of time that the device is performing
  * a page scan. */
 #ifndef BTM_DEFAULT_CONN_WINDOW
@@ -673,6 +687,24 @@
 #define SDP_MAX_LIST_BYTE_COUNT 4096
 #endif
 
+/* The maximum size, in bytes, of the search attribute responses cached for a
+ * peer device. The oldest responses are dropped first. */
+#ifndef SDP_MAX_CACHE_SIZE
+#define SDP_MAX_CACHE_SIZE 4096
+#endif
+
+/* The maximum size, in bytes, a discovery database allocated by
+ * SDP_CreateDiscoveryDb grows to. */
+#ifndef SDP_MAX_DISC_DB_SIZE
+#define SDP_MAX_DISC_DB_SIZE 65536
+#endif
+
+/* The size, in bytes, of the blocks a growing discovery database is extended
+ * by. */
+#ifndef SDP_DISC_DB_BLOCK_SIZE
+#define SDP_DISC_DB_BLOCK_SIZE 2048
+#endif
+
 /* The maximum number of parameters in an SDP protocol element. */
 #ifndef SDP_MAX_PROTOCOL_PARAMS
 #define SDP_MAX_PROTOCOL_PARAMS 2
@@ -761,6 +793,29 @@
 #define PORT_TX_BUF_CRITICAL_WM 15
 #endif
 
+/* The most buffers a port adapting its flow control to the link grants the
+ * peer credits for. */
+#ifndef PORT_RX_BUF_ADAPTIVE_MAX_WM
+#define PORT_RX_BUF_ADAPTIVE_MAX_WM 64
+#endif
+
+/* The highest transmit queue high watermark, in number of buffers, a port
+ * adapting its flow control to the link uses. */
+#ifndef PORT_TX_BUF_ADAPTIVE_MAX_WM
+#define PORT_TX_BUF_ADAPTIVE_MAX_WM 64
+#endif
+
+/* The most queued data, in bytes, the adaptive watermarks of all the ports of
+ * one multiplexer may allow. */
+#ifndef PORT_MCB_MAX_QUEUE_SIZE
+#define PORT_MCB_MAX_QUEUE_SIZE (256 * 1024)
+#endif
+
+/* The window, in milliseconds, over which port throughput is measured. */
+#ifndef PORT_FLOW_RATE_WINDOW_MS
+#define PORT_FLOW_RATE_WINDOW_MS 250
+#endif
+
 /* The RFCOMM multiplexer preferred flow control mechanism. */
 #ifndef PORT_FC_DEFAULT
 #define PORT_FC_DEFAULT PORT_FC_CREDIT
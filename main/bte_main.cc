@@ -35,12 +35,15 @@
 #include "btif/include/btif_config.h"
 #include "btsnoop.h"
 #include "btu.h"
+#include "common/time_util.h"
 #include "device/include/interop.h"
 #include "hci_layer.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "shim/hci_layer.h"
 #include "shim/shim.h"
+#include "stack/btm/btm_sco.h"
+#include "stack/include/hcidefs.h"
 #include "stack_config.h"
 
 /*******************************************************************************
@@ -51,12 +54,38 @@ static const hci_t* hci;
 /*******************************************************************************
  *  Externs
  ******************************************************************************/
-extern void btu_hci_msg_process(BT_HDR* p_msg);
+extern void btu_hci_msg_process_received(BT_HDR* p_msg, uint64_t rx_time_us);
 
 /*******************************************************************************
  *  Static functions
  ******************************************************************************/
 
+/* Inquiry and LE scan results come in bursts and nothing waits on them, so
+ * they stay in the normal lane, along with the events that end them */
+static bool is_discovery_event(const BT_HDR* p_msg) {
+  if ((p_msg->event & BT_EVT_MASK) != BT_EVT_TO_BTU_HCI_EVT || p_msg->len < 3) {
+    return false;
+  }
+  const uint8_t* p = p_msg->data + p_msg->offset;
+  switch (p[0]) {
+    case HCI_INQUIRY_COMP_EVT:
+    case HCI_INQUIRY_RESULT_EVT:
+    case HCI_INQUIRY_RSSI_RESULT_EVT:
+    case HCI_EXTENDED_INQUIRY_RESULT_EVT:
+      return true;
+    case HCI_BLE_EVENT:
+      switch (p[2]) {
+        case HCI_BLE_ADV_PKT_RPT_EVT:
+        case HCI_BLE_DIRECT_ADV_EVT:
+        case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
+        case HCI_BLE_SCAN_TIMEOUT_EVT:
+          return true;
+      }
+      return false;
+  }
+  return false;
+}
+
 /******************************************************************************
  *
  * Function         post_to_hci_message_loop
@@ -67,9 +96,25 @@ extern void btu_hci_msg_process(BT_HDR* p_msg);
  *
  *****************************************************************************/
 void post_to_main_message_loop(const base::Location& from_here, BT_HDR* p_msg) {
-  if (do_in_main_thread(from_here, base::Bind(&btu_hci_msg_process, p_msg)) !=
+  /* SCO data routed through the software path skips the main thread */
+  if ((p_msg->event & BT_EVT_MASK) == BT_EVT_TO_BTU_HCI_SCO &&
+      bluetooth::audio::sco::enqueue_packet(p_msg)) {
+    return;
+  }
+  const uint64_t rx_time_us = bluetooth::common::time_get_os_boottime_us();
+  auto task = base::Bind(&btu_hci_msg_process_received, p_msg, rx_time_us);
+  if (is_discovery_event(p_msg)) {
+    if (do_in_main_thread(from_here, std::move(task)) != BT_STATUS_SUCCESS) {
+      LOG(ERROR) << __func__ << ": do_in_main_thread failed from "
+                 << from_here.ToString();
+    }
+    return;
+  }
+  /* Everything else received from the controller shares the high priority
+   * lane, so that data never overtakes the events it depends on */
+  if (do_in_main_thread_high_priority(from_here, std::move(task)) !=
       BT_STATUS_SUCCESS) {
-    LOG(ERROR) << __func__ << ": do_in_main_thread failed from "
+    LOG(ERROR) << __func__ << ": do_in_main_thread_high_priority failed from "
                << from_here.ToString();
   }
 }
@@ -21,13 +21,17 @@
 #include <time.h>
 #include <unordered_set>
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "btif/include/btif_hh.h"
 #include "device/include/controller.h"
@@ -58,6 +62,7 @@
 #include "stack/include/btm_status.h"
 #include "stack/include/sec_hci_link_interface.h"
 #include "stack/l2cap/l2c_int.h"
+#include "stack/rfcomm/rfc_int.h"
 
 extern tBTM_CB btm_cb;
 
@@ -77,6 +82,7 @@ using TeardownTime = std::chrono::time_point<std::chrono::system_clock>;
 constexpr char kBtmLogTag[] = "ACL";
 
 using SendDataUpwards = void (*const)(BT_HDR*);
+using OnTxCongestion = void (*const)(uint16_t handle, bool congested);
 using OnDisconnect = std::function<void(HciHandle, hci::ErrorCode reason)>;
 
 constexpr char kConnectionDescriptorTimeFormat[] = "%Y-%m-%d %H:%M:%S";
@@ -249,15 +255,114 @@ void ValidateAclInterface(const shim::legacy::acl_interface_t& acl_interface) {
 
 constexpr HciHandle kInvalidHciHandle = 0xffff;
 
+namespace {
+
+// Counters of the inbound ACL batches of all links, for dumpsys
+struct AclRxStats {
+  std::atomic<uint64_t> packets{0};
+  std::atomic<uint64_t> drain_tasks{0};
+  std::atomic<size_t> largest_drain{0};
+} acl_rx_stats;
+
+// Received ACL data of a link waiting for the main thread. A drain task is
+// only posted when the batch goes from empty to non empty, and it delivers
+// every packet queued before it runs, in order. The task shares the batch,
+// so that packets received just before a disconnection are still delivered.
+// The vectors keep their capacity, so that steady traffic costs no
+// allocation beyond the packet buffers.
+class AclRxBatch {
+ public:
+  explicit AclRxBatch(SendDataUpwards send_data_upwards)
+      : send_data_upwards_(send_data_upwards) {}
+
+  static void Add(const std::shared_ptr<AclRxBatch>& batch, BT_HDR* p_buf) {
+    bool post_task;
+    {
+      std::lock_guard<std::mutex> lock(batch->mutex_);
+      post_task = batch->pending_.empty();
+      batch->pending_.push_back(p_buf);
+    }
+    if (post_task &&
+        do_in_main_thread(FROM_HERE, base::Bind(&AclRxBatch::Drain, batch)) !=
+            BT_STATUS_SUCCESS) {
+      std::lock_guard<std::mutex> lock(batch->mutex_);
+      for (BT_HDR* packet : batch->pending_) osi_free(packet);
+      batch->pending_.clear();
+    }
+  }
+
+ private:
+  static void Drain(std::shared_ptr<AclRxBatch> batch) {
+    {
+      std::lock_guard<std::mutex> lock(batch->mutex_);
+      batch->draining_.swap(batch->pending_);
+    }
+    size_t count = batch->draining_.size();
+    for (BT_HDR* packet : batch->draining_) batch->send_data_upwards_(packet);
+    batch->draining_.clear();
+
+    acl_rx_stats.packets.fetch_add(count, std::memory_order_relaxed);
+    acl_rx_stats.drain_tasks.fetch_add(1, std::memory_order_relaxed);
+    if (count > acl_rx_stats.largest_drain.load(std::memory_order_relaxed)) {
+      acl_rx_stats.largest_drain.store(count, std::memory_order_relaxed);
+    }
+  }
+
+  SendDataUpwards send_data_upwards_;
+  std::mutex mutex_;
+  std::vector<BT_HDR*> pending_;
+  // Only used on the main thread
+  std::vector<BT_HDR*> draining_;
+};
+
+// Packets of a link sent by legacy L2CAP and not yet handed to the gd ACL
+// queue. L2CAP is told to hold the packets of the link once
+// kTxQueueCongestedSize are waiting, and to resume once no more than
+// kTxQueueUncongestedSize are left. L2CAP sends on the main thread while the
+// packets are handed to gd on the gd thread, so the count is shared.
+constexpr size_t kTxQueueCongestedSize = 32;
+constexpr size_t kTxQueueUncongestedSize = 8;
+
+struct AclTxState {
+  std::atomic<size_t> queued{0};
+  // Only used on the main thread
+  bool congested{false};
+};
+
+// Runs on the main thread, before L2CAP gets to send another packet
+void CheckTxCongested(const std::shared_ptr<AclTxState>& state,
+                      OnTxCongestion on_tx_congestion, HciHandle handle) {
+  size_t queued = ++state->queued;
+  if (state->congested || queued < kTxQueueCongestedSize) return;
+  state->congested = true;
+  LOG_DEBUG("ACL tx queue handle:0x%04x congested queued:%zu", handle, queued);
+  if (on_tx_congestion != nullptr) on_tx_congestion(handle, true);
+}
+
+void CheckTxUncongested(std::shared_ptr<AclTxState> state,
+                        OnTxCongestion on_tx_congestion, HciHandle handle) {
+  size_t queued = state->queued.load();
+  if (!state->congested || queued > kTxQueueUncongestedSize) return;
+  state->congested = false;
+  LOG_DEBUG("ACL tx queue handle:0x%04x uncongested queued:%zu", handle,
+            queued);
+  if (on_tx_congestion != nullptr) on_tx_congestion(handle, false);
+}
+
+}  // namespace
+
 class ShimAclConnection {
  public:
   ShimAclConnection(const HciHandle handle, SendDataUpwards send_data_upwards,
-                    os::Handler* handler,
+                    OnTxCongestion on_tx_congestion, os::Handler* handler,
                     hci::acl_manager::AclConnection::QueueUpEnd* queue_up_end,
                     CreationTime creation_time)
       : handle_(handle),
         handler_(handler),
         send_data_upwards_(send_data_upwards),
+        rx_batch_(std::make_shared<AclRxBatch>(send_data_upwards)),
+        on_tx_congestion_(on_tx_congestion),
+        tx_state_(std::make_shared<AclTxState>()),
         queue_up_end_(queue_up_end),
         creation_time_(creation_time) {
     queue_up_end_->RegisterDequeue(
@@ -275,9 +380,18 @@ class ShimAclConnection {
   }
 
   void EnqueuePacket(std::unique_ptr<packet::RawBuilder> packet) {
-    // TODO Handle queue size exceeds some threshold
     queue_.push(std::move(packet));
-    RegisterEnqueue();
+
+    // Hand packets over to the gd queue while it has room, and only wait on
+    // it for an enqueue callback once it is full
+    if (!is_enqueue_registered_) {
+      size_t queued = queue_.size();
+      queue_up_end_->TryEnqueue(&queue_);
+      OnTxHandedOver(queued - queue_.size());
+      if (!queue_.empty()) {
+        RegisterEnqueue();
+      }
+    }
   }
 
   std::unique_ptr<packet::BasePacketBuilder> handle_enqueue() {
@@ -286,28 +400,21 @@ class ShimAclConnection {
     if (queue_.empty()) {
       UnregisterEnqueue();
     }
+    OnTxHandedOver(1);
     return packet;
   }
 
+  // Counts the packets of the link legacy L2CAP sends until they are handed
+  // to gd
+  std::shared_ptr<AclTxState> TxState() const { return tx_state_; }
+
   void data_ready_callback() {
     auto packet = queue_up_end_->TryDequeue();
-    uint16_t length = packet->size();
-    std::vector<uint8_t> preamble;
-    preamble.push_back(LowByte(handle_));
-    preamble.push_back(HighByte(handle_));
-    preamble.push_back(LowByte(length));
-    preamble.push_back(HighByte(length));
-    BT_HDR* p_buf = MakeLegacyBtHdrPacket(std::move(packet), preamble);
-    ASSERT_LOG(p_buf != nullptr,
-               "Unable to allocate BT_HDR legacy packet handle:%04x", handle_);
     if (send_data_upwards_ == nullptr) {
       LOG_WARN("Dropping ACL data with no callback");
-      osi_free(p_buf);
-    } else if (do_in_main_thread(FROM_HERE,
-                                 base::Bind(send_data_upwards_, p_buf)) !=
-               BT_STATUS_SUCCESS) {
-      osi_free(p_buf);
+      return;
     }
+    AclRxBatch::Add(rx_batch_, MakeLegacyAclPacket(handle_, *packet));
   }
 
   virtual void InitiateDisconnect(hci::DisconnectReason reason) = 0;
@@ -347,9 +454,12 @@ class ShimAclConnection {
 
  private:
   SendDataUpwards send_data_upwards_;
+  std::shared_ptr<AclRxBatch> rx_batch_;
+  OnTxCongestion on_tx_congestion_;
+  std::shared_ptr<AclTxState> tx_state_;
   hci::acl_manager::AclConnection::QueueUpEnd* queue_up_end_;
 
-  std::queue<std::unique_ptr<packet::RawBuilder>> queue_;
+  std::queue<std::unique_ptr<packet::BasePacketBuilder>> queue_;
   bool is_enqueue_registered_{false};
   bool is_disconnected_{false};
   CreationTime creation_time_;
@@ -365,6 +475,18 @@ class ShimAclConnection {
                                common::Unretained(this)));
   }
 
+  void OnTxHandedOver(size_t count) {
+    if (count == 0) return;
+    size_t queued = tx_state_->queued.fetch_sub(count) - count;
+    // Only a drop below the threshold can end the congestion
+    if (queued > kTxQueueUncongestedSize ||
+        queued + count <= kTxQueueUncongestedSize) {
+      return;
+    }
+    do_in_main_thread(FROM_HERE, base::Bind(&CheckTxUncongested, tx_state_,
+                                            on_tx_congestion_, handle_));
+  }
+
   virtual void RegisterCallbacks() = 0;
 };
 
@@ -373,12 +495,14 @@ class ClassicShimAclConnection
       public hci::acl_manager::ConnectionManagementCallbacks {
  public:
   ClassicShimAclConnection(
-      SendDataUpwards send_data_upwards, OnDisconnect on_disconnect,
+      SendDataUpwards send_data_upwards, OnTxCongestion on_tx_congestion,
+      OnDisconnect on_disconnect,
       const shim::legacy::acl_classic_link_interface_t& interface,
       os::Handler* handler,
       std::unique_ptr<hci::acl_manager::ClassicAclConnection> connection,
       CreationTime creation_time)
-      : ShimAclConnection(connection->GetHandle(), send_data_upwards, handler,
+      : ShimAclConnection(connection->GetHandle(), send_data_upwards,
+                          on_tx_congestion, handler,
                           connection->GetAclQueueEnd(), creation_time),
         on_disconnect_(on_disconnect),
         interface_(interface),
@@ -591,12 +715,14 @@ class LeShimAclConnection
       public hci::acl_manager::LeConnectionManagementCallbacks {
  public:
   LeShimAclConnection(
-      SendDataUpwards send_data_upwards, OnDisconnect on_disconnect,
+      SendDataUpwards send_data_upwards, OnTxCongestion on_tx_congestion,
+      OnDisconnect on_disconnect,
       const shim::legacy::acl_le_link_interface_t& interface,
       os::Handler* handler,
       std::unique_ptr<hci::acl_manager::LeAclConnection> connection,
       std::chrono::time_point<std::chrono::system_clock> creation_time)
-      : ShimAclConnection(connection->GetHandle(), send_data_upwards, handler,
+      : ShimAclConnection(connection->GetHandle(), send_data_upwards,
+                          on_tx_congestion, handler,
                           connection->GetAclQueueEnd(), creation_time),
         on_disconnect_(on_disconnect),
         interface_(interface),
@@ -685,6 +811,26 @@ struct shim::legacy::Acl::impl {
 
   ShadowAcceptlist shadow_acceptlist_;
 
+  // Tx state of the connected links, also looked up on the main thread
+  std::mutex tx_states_mutex_;
+  std::map<HciHandle, std::shared_ptr<AclTxState>> tx_states_;
+
+  void AddTxState(HciHandle handle, std::shared_ptr<AclTxState> state) {
+    std::lock_guard<std::mutex> lock(tx_states_mutex_);
+    tx_states_[handle] = std::move(state);
+  }
+
+  void RemoveTxState(HciHandle handle) {
+    std::lock_guard<std::mutex> lock(tx_states_mutex_);
+    tx_states_.erase(handle);
+  }
+
+  std::shared_ptr<AclTxState> GetTxState(HciHandle handle) {
+    std::lock_guard<std::mutex> lock(tx_states_mutex_);
+    auto state = tx_states_.find(handle);
+    return state == tx_states_.end() ? nullptr : state->second;
+  }
+
   bool IsClassicAcl(HciHandle handle) {
     return handle_to_classic_connection_map_.find(handle) !=
            handle_to_classic_connection_map_.end();
@@ -885,6 +1031,11 @@ struct shim::legacy::Acl::impl {
     for (auto& entry : acceptlist) {
       LOG_DUMPSYS(fd, "%03u le acceptlist:%s", ++cnt, entry.ToString().c_str());
     }
+    LOG_DUMPSYS(
+        fd, "Inbound acl packets:%llu drain tasks:%llu largest drain:%zu",
+        static_cast<unsigned long long>(acl_rx_stats.packets.load()),
+        static_cast<unsigned long long>(acl_rx_stats.drain_tasks.load()),
+        acl_rx_stats.largest_drain.load());
   }
 #undef DUMPSYS_TAG
 };
@@ -898,6 +1049,21 @@ void DumpsysL2cap(int fd) {
     if (!lcb.in_use) continue;
     LOG_DUMPSYS(fd, "link_state:%s", link_state_text(lcb.link_state).c_str());
     LOG_DUMPSYS(fd, "handle:0x%04x", lcb.Handle());
+    if (lcb.transport == BT_TRANSPORT_LE) {
+      const LeLinkTuner& tuner = lcb.tuner;
+      LOG_DUMPSYS(fd,
+                  "  le tuner enabled:%s load:%s rate:%uB/s peak:%uB/s "
+                  "bulk:%u idle:%u pinned:%s",
+                  common::ToString(l2cb.ble_tuner_enabled).c_str(),
+                  l2cble_tuner_load_text(tuner.load()), tuner.rate(),
+                  tuner.peak_rate(), tuner.bulk_count(), tuner.idle_count(),
+                  common::ToString(tuner.params_pinned()).c_str());
+      LOG_DUMPSYS(fd,
+                  "  le tuner conn_update_failures:%hhu phy_failures:%hhu "
+                  "quirks:0x%02x tx_data_len:%hu",
+                  tuner.conn_update_failures(), tuner.phy_failures(),
+                  tuner.quirks(), lcb.tx_data_len);
+    }
 
     const tL2C_CCB* ccb = lcb.ccb_queue.p_first_ccb;
     while (ccb != nullptr) {
@@ -905,11 +1071,60 @@ void DumpsysL2cap(int fd) {
           fd, "  active channel lcid:0x%04x rcid:0x%04x is_ecoc:%s in_use:%s",
           ccb->local_cid, ccb->remote_cid, common::ToString(ccb->ecoc).c_str(),
           common::ToString(ccb->in_use).c_str());
+      if (ccb->peer_cfg.fcr.mode == L2CAP_FCR_ERTM_MODE) {
+        const tL2C_FCRB& fcrb = ccb->fcrb;
+        const tL2C_FCR_STATS& stats = fcrb.stats;
+        LOG_DUMPSYS(fd,
+                    "    ertm adaptive:%s tx_window:%hhu/%hhu "
+                    "min_tx_window:%hhu rtrans_tout:%ums srtt:%ums rttvar:%ums",
+                    common::ToString(l2cb.fcr_adaptive).c_str(),
+                    fcrb.tx_win_sz != 0 ? fcrb.tx_win_sz
+                                        : ccb->peer_cfg.fcr.tx_win_sz,
+                    ccb->peer_cfg.fcr.tx_win_sz,
+                    stats.min_tx_window,
+                    fcrb.rtrans_tout != 0 ? fcrb.rtrans_tout
+                                          : ccb->our_cfg.fcr.rtrans_tout,
+                    fcrb.srtt_ms, fcrb.rttvar_ms);
+        LOG_DUMPSYS(fd,
+                    "    ertm i_frames:%u retransmitted:%u timeouts:%u "
+                    "rejects:%u rtt_samples:%u rtt_min:%ums rtt_max:%ums",
+                    stats.i_frames_sent, stats.i_frames_retransmitted,
+                    stats.retrans_timeouts, stats.rejects_received,
+                    stats.rtt_samples, stats.min_rtt_ms, stats.max_rtt_ms);
+      }
       ccb = ccb->p_next_ccb;
     }
   }
 }
 
+#undef DUMPSYS_TAG
+#define DUMPSYS_TAG "shim::legacy::rfcomm"
+void DumpsysRfcomm(int fd) {
+  LOG_DUMPSYS_TITLE(fd, DUMPSYS_TAG);
+  LOG_DUMPSYS(fd, "adaptive_flow:%s",
+              common::ToString(rfc_cb.rfc.adaptive_flow).c_str());
+  for (const tPORT& port : rfc_cb.port.port) {
+    if (!port.in_use || port.rfc.p_mcb == nullptr) continue;
+    const tPORT_FLOW& flow = port.flow;
+    LOG_DUMPSYS(fd, "port handle:%hhu peer:%s dlci:%hhu mtu:%hu peer_mtu:%hu",
+                port.handle, PRIVATE_ADDRESS(port.bd_addr), port.dlci,
+                port.mtu, port.peer_mtu);
+    LOG_DUMPSYS(fd,
+                "  credits tx:%hu rx:%hu rx_max:%hu (peak %hu) rx_low:%hu "
+                "rx_buf_critical:%hu tx_buf_high:%hu (peak %hu)",
+                port.credit_tx, port.credit_rx, port.credit_rx_max,
+                flow.peak_credit_rx_max, port.credit_rx_low,
+                port.rx_buf_critical, port.tx_buf_high,
+                flow.peak_tx_buf_high);
+    LOG_DUMPSYS(fd,
+                "  rx:%uB/s (%u bytes) tx:%uB/s (%u bytes) srtt:%ums "
+                "rtt_samples:%u adjustments:%u",
+                flow.rx.rate, flow.rx.total_bytes, flow.tx.rate,
+                flow.tx.total_bytes, flow.srtt_ms, flow.rtt_samples,
+                flow.adjustments);
+  }
+}
+
 #undef DUMPSYS_TAG
 #define DUMPSYS_TAG "shim::legacy::acl"
 void DumpsysAcl(int fd) {
@@ -1037,6 +1252,7 @@ void shim::legacy::Acl::Dump(int fd) const {
   DumpsysRecord(fd);
   DumpsysAcl(fd);
   DumpsysL2cap(fd);
+  DumpsysRfcomm(fd);
   DumpsysBtm(fd);
 }
 
@@ -1121,6 +1337,12 @@ void shim::legacy::Acl::write_data_sync(
 
 void shim::legacy::Acl::WriteData(HciHandle handle,
                                   std::unique_ptr<packet::RawBuilder> packet) {
+  // Counted here so L2CAP holds its next packets as soon as this one makes
+  // the link congested
+  auto tx_state = pimpl_->GetTxState(handle);
+  if (tx_state != nullptr) {
+    CheckTxCongested(tx_state, acl_interface_.on_tx_congestion, handle);
+  }
   handler_->Post(common::BindOnce(&Acl::write_data_sync,
                                   common::Unretained(this), handle,
                                   std::move(packet)));
@@ -1166,6 +1388,7 @@ void shim::legacy::Acl::OnClassicLinkDisconnected(HciHandle handle,
 
   TeardownTime teardown_time = std::chrono::system_clock::now();
 
+  pimpl_->RemoveTxState(handle);
   pimpl_->handle_to_classic_connection_map_.erase(handle);
   TRY_POSTING_ON_MAIN(acl_interface_.connection.classic.on_disconnected,
                       ToLegacyHciErrorCode(hci::ErrorCode::SUCCESS), handle,
@@ -1206,6 +1429,7 @@ void shim::legacy::Acl::OnLeLinkDisconnected(HciHandle handle,
 
   TeardownTime teardown_time = std::chrono::system_clock::now();
 
+  pimpl_->RemoveTxState(handle);
   pimpl_->handle_to_le_connection_map_.erase(handle);
   TRY_POSTING_ON_MAIN(acl_interface_.connection.le.on_disconnected,
                       ToLegacyHciErrorCode(hci::ErrorCode::SUCCESS), handle,
@@ -1234,11 +1458,14 @@ void shim::legacy::Acl::OnConnectSuccess(
   pimpl_->handle_to_classic_connection_map_.emplace(
       handle, std::make_unique<ClassicShimAclConnection>(
                   acl_interface_.on_send_data_upwards,
+                  acl_interface_.on_tx_congestion,
                   std::bind(&shim::legacy::Acl::OnClassicLinkDisconnected, this,
                             std::placeholders::_1, std::placeholders::_2),
                   acl_interface_.link.classic, handler_, std::move(connection),
                   std::chrono::system_clock::now()));
   pimpl_->handle_to_classic_connection_map_[handle]->RegisterCallbacks();
+  pimpl_->AddTxState(
+      handle, pimpl_->handle_to_classic_connection_map_[handle]->TxState());
   pimpl_->handle_to_classic_connection_map_[handle]
       ->ReadRemoteControllerInformation();
 
@@ -1301,11 +1528,14 @@ void shim::legacy::Acl::OnLeConnectSuccess(
   pimpl_->handle_to_le_connection_map_.emplace(
       handle, std::make_unique<LeShimAclConnection>(
                   acl_interface_.on_send_data_upwards,
+                  acl_interface_.on_tx_congestion,
                   std::bind(&shim::legacy::Acl::OnLeLinkDisconnected, this,
                             std::placeholders::_1, std::placeholders::_2),
                   acl_interface_.link.le, handler_, std::move(connection),
                   std::chrono::system_clock::now()));
   pimpl_->handle_to_le_connection_map_[handle]->RegisterCallbacks();
+  pimpl_->AddTxState(handle,
+                     pimpl_->handle_to_le_connection_map_[handle]->TxState());
 
   pimpl_->handle_to_le_connection_map_[handle]
       ->ReadRemoteControllerInformation();
@@ -30,6 +30,7 @@ const acl_interface_t GetAclInterface() {
   acl_interface_t acl_interface{
       .on_send_data_upwards = acl_rcv_acl_data,
       .on_packets_completed = acl_packets_completed,
+      .on_tx_congestion = acl_tx_congestion,
 
       .connection.classic.on_connected = on_acl_br_edr_connected,
       .connection.classic.on_failed = on_acl_br_edr_failed,
@@ -135,6 +135,7 @@ typedef struct {
 typedef struct {
   void (*on_send_data_upwards)(BT_HDR*);
   void (*on_packets_completed)(uint16_t handle, uint16_t num_packets);
+  void (*on_tx_congestion)(uint16_t handle, bool congested);
   acl_connection_interface_t connection;
   acl_link_interface_t link;
 } acl_interface_t;
@@ -150,9 +150,21 @@ void Btm::ScanningCallbacks::OnFilterParamSetup(
 void Btm::ScanningCallbacks::OnFilterConfigCallback(
     bluetooth::hci::ApcfFilterType filter_type, uint8_t available_spaces,
     bluetooth::hci::ApcfAction action, uint8_t status){};
-
-Btm::Btm(os::Handler* handler, neighbor::InquiryModule* inquiry)
-    : scanning_timer_(handler), observing_timer_(handler) {
+void Btm::ScanningCallbacks::OnPeriodicSyncStarted(
+    int request_id, bluetooth::hci::ErrorCode status, uint16_t sync_handle,
+    uint8_t advertising_sid, bluetooth::hci::AddressWithType address_with_type,
+    bluetooth::hci::SecondaryPhyType phy, uint16_t interval){};
+void Btm::ScanningCallbacks::OnPeriodicSyncReport(
+    int request_id, uint16_t sync_handle, int8_t tx_power, int8_t rssi,
+    bluetooth::hci::DataStatus status, std::vector<uint8_t> data){};
+void Btm::ScanningCallbacks::OnPeriodicSyncLost(int request_id,
+                                                uint16_t sync_handle){};
+
+Btm::Btm(os::Handler* handler, neighbor::InquiryModule* inquiry,
+         neighbor::RadioScheduler* radio_scheduler)
+    : scanning_timer_(handler),
+      observing_timer_(handler),
+      radio_scheduler_(radio_scheduler) {
   ASSERT(handler != nullptr);
   ASSERT(inquiry != nullptr);
   bluetooth::neighbor::InquiryCallbacks inquiry_callbacks = {
@@ -222,6 +234,7 @@ void Btm::OnInquiryComplete(bluetooth::hci::ErrorCode status) {
                                     active_inquiry_mode_);
 
   active_inquiry_mode_ = kInquiryModeOff;
+  UpdateRadioUseCases();
 }
 
 void Btm::SetStandardInquiryResultMode() {
@@ -286,6 +299,7 @@ bool Btm::StartInquiry(
       LOG_WARN("%s Unknown inquiry mode:%d", __func__, mode);
       return false;
   }
+  UpdateRadioUseCases();
   return true;
 }
 
@@ -296,6 +310,7 @@ void Btm::CancelInquiry() {
     limited_inquiry_active_ = false;
     general_inquiry_active_ = false;
   }
+  UpdateRadioUseCases();
 }
 
 bool Btm::IsInquiryActive() const {
@@ -584,7 +599,11 @@ void Btm::StopConnectability() { StopAdvertising(); }
 
 void Btm::StartActiveScanning() { StartScanning(kActiveScanning); }
 
-void Btm::StopActiveScanning() { GetScanning()->Scan(false); }
+void Btm::StopActiveScanning() {
+  GetScanning()->Scan(false);
+  le_scanning_active_ = false;
+  UpdateRadioUseCases();
+}
 
 void Btm::SetScanningTimer(uint64_t duration_ms,
                            common::OnceCallback<void()> callback) {
@@ -609,6 +628,33 @@ void Btm::CancelObservingTimer() { observing_timer_.Cancel(); }
 void Btm::StartScanning(bool use_active_scanning) {
   GetScanning()->RegisterScanningCallback(&scanning_callbacks_);
   GetScanning()->Scan(true);
+  le_scanning_active_ = true;
+  UpdateRadioUseCases();
+}
+
+void Btm::SetStreamingActive(bool active) {
+  SetRadioUseCase(neighbor::RadioUseCase::STREAMING, &streaming_use_case_,
+                  active);
+}
+
+void Btm::SetRadioUseCase(neighbor::RadioUseCase use_case, bool* in_use,
+                          bool active) {
+  if (radio_scheduler_ == nullptr || *in_use == active) return;
+  *in_use = active;
+  if (active) {
+    radio_scheduler_->AddUseCase(use_case);
+  } else {
+    radio_scheduler_->RemoveUseCase(use_case);
+  }
+}
+
+// Scans run during an inquiry belong to the discovery the user is waiting
+// for, any other LE scan is opportunistic
+void Btm::UpdateRadioUseCases() {
+  SetRadioUseCase(neighbor::RadioUseCase::PAIRING, &pairing_use_case_,
+                  IsInquiryActive());
+  SetRadioUseCase(neighbor::RadioUseCase::BACKGROUND, &background_use_case_,
+                  le_scanning_active_);
 }
 
 size_t Btm::GetNumberOfAdvertisingInstances() const {
@@ -33,6 +33,7 @@
 #include "gd/hci/le_advertising_manager.h"
 #include "gd/hci/le_scanning_manager.h"
 #include "gd/neighbor/inquiry.h"
+#include "gd/neighbor/radio_scheduler.h"
 #include "gd/os/alarm.h"
 
 //
@@ -87,7 +88,9 @@ namespace shim {
 class Btm {
  public:
   // |handler| is used to run timer tasks and scan callbacks
-  Btm(os::Handler* handler, neighbor::InquiryModule* inquiry);
+  // |radio_scheduler| is null when the radio scheduler is disabled
+  Btm(os::Handler* handler, neighbor::InquiryModule* inquiry,
+      neighbor::RadioScheduler* radio_scheduler);
   ~Btm() = default;
 
   // Inquiry result callbacks
@@ -169,6 +172,9 @@ class Btm {
 
   size_t GetNumberOfAdvertisingInstances() const;
 
+  // Audio streaming limits the radio time given to scans
+  void SetStreamingActive(bool active);
+
   void SetObservingTimer(uint64_t duration_ms,
                          common::OnceCallback<void()> callback);
   void CancelObservingTimer();
@@ -195,6 +201,15 @@ class Btm {
   LegacyInquiryCompleteCallback legacy_inquiry_complete_callback_{};
   uint8_t active_inquiry_mode_ = 0;
 
+  neighbor::RadioScheduler* radio_scheduler_{nullptr};
+  bool le_scanning_active_{false};
+  bool streaming_use_case_{false};
+  bool pairing_use_case_{false};
+  bool background_use_case_{false};
+  void SetRadioUseCase(neighbor::RadioUseCase use_case, bool* in_use,
+                       bool active);
+  void UpdateRadioUseCases();
+
   class ReadRemoteName {
    public:
     ReadRemoteName() = default;
@@ -234,6 +249,16 @@ class Btm {
                                 uint8_t available_spaces,
                                 bluetooth::hci::ApcfAction action,
                                 uint8_t status);
+    void OnPeriodicSyncStarted(
+        int request_id, bluetooth::hci::ErrorCode status, uint16_t sync_handle,
+        uint8_t advertising_sid,
+        bluetooth::hci::AddressWithType address_with_type,
+        bluetooth::hci::SecondaryPhyType phy, uint16_t interval);
+    void OnPeriodicSyncReport(int request_id, uint16_t sync_handle,
+                              int8_t tx_power, int8_t rssi,
+                              bluetooth::hci::DataStatus status,
+                              std::vector<uint8_t> data);
+    void OnPeriodicSyncLost(int request_id, uint16_t sync_handle);
   };
   ScanningCallbacks scanning_callbacks_;
 
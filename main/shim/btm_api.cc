@@ -724,6 +724,10 @@ void bluetooth::shim::BTM_EnableInterlacedPageScan() {
   Stack::GetInstance()->GetBtm()->SetInterlacedPageScan();
 }
 
+void bluetooth::shim::BTM_SetStreamingActive(bool active) {
+  Stack::GetInstance()->GetBtm()->SetStreamingActive(active);
+}
+
 tBTM_STATUS bluetooth::shim::BTM_SetInquiryMode(uint8_t inquiry_mode) {
   switch (inquiry_mode) {
     case kStandardInquiryResult:
@@ -102,6 +102,12 @@ void BTM_EnableInterlacedInquiryScan();
 
 void BTM_EnableInterlacedPageScan();
 
+/**
+ * Tells the radio scheduler whether audio is streaming, which limits the
+ * radio time given to inquiry, page and LE scans
+ */
+void BTM_SetStreamingActive(bool active);
+
 /*******************************************************************************
  *
  * Function         BTM_SetInquiryMode
@@ -156,6 +156,13 @@ std::vector<std::string> BtifConfigInterface::GetPersistentDevices() {
   return GetStorage()->GetConfigCache()->GetPersistentSections();
 }
 
+void BtifConfigInterface::ForEachPersistentProperty(
+    const std::function<void(const std::string& section,
+                             const std::string& property,
+                             const std::string& value)>& visitor) {
+  GetStorage()->GetConfigCache()->ForEachPersistentProperty(visitor);
+}
+
 void BtifConfigInterface::Save() { GetStorage()->SaveDelayed(); }
 
 void BtifConfigInterface::Flush() { GetStorage()->SaveImmediately(); }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <optional>
 #include <string>
@@ -53,6 +54,10 @@ class BtifConfigInterface {
   static bool RemoveProperty(const std::string& section,
                              const std::string& key);
   static std::vector<std::string> GetPersistentDevices();
+  static void ForEachPersistentProperty(
+      const std::function<void(const std::string& section,
+                               const std::string& property,
+                               const std::string& value)>& visitor);
   static void Save();
   static void Flush();
   static void Clear();
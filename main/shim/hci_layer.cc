@@ -25,6 +25,7 @@
 
 #include "callbacks/callbacks.h"
 #include "gd/common/init_flags.h"
+#include "gd/hal/hci_rx_buffer.h"
 #include "hci/hci_packets.h"
 #include "hci/include/packet_fragmenter.h"
 #include "hci/le_acl_connection_interface.h"
@@ -323,12 +324,33 @@ static BT_HDR* WrapPacketAndCopy(
   return packet;
 }
 
+// Take over the HAL receive buffer behind the view when nothing else holds it.
+// The buffer was allocated with BT_HDR headroom, so only the header is filled
+// in. Otherwise fall back to copying.
+static BT_HDR* WrapPacket(
+    uint16_t event,
+    bluetooth::hci::PacketView<bluetooth::hci::kLittleEndian>* data) {
+  const bluetooth::packet::View* fragment = data->GetSingleFragment();
+  if (fragment != nullptr) {
+    void* block = bluetooth::hal::ReleaseRxBuffer(fragment->GetStorage());
+    if (block != nullptr) {
+      BT_HDR* packet = reinterpret_cast<BT_HDR*>(block);
+      packet->offset = fragment->GetStorageOffset();
+      packet->len = data->size();
+      packet->layer_specific = 0;
+      packet->event = event;
+      return packet;
+    }
+  }
+  return WrapPacketAndCopy(event, data);
+}
+
 static void event_callback(bluetooth::hci::EventView event_packet_view) {
   if (!send_data_upwards) {
     return;
   }
-  send_data_upwards.Run(FROM_HERE, WrapPacketAndCopy(MSG_HC_TO_STACK_HCI_EVT,
-                                                     &event_packet_view));
+  send_data_upwards.Run(FROM_HERE,
+                        WrapPacket(MSG_HC_TO_STACK_HCI_EVT, &event_packet_view));
 }
 
 static void subevent_callback(
@@ -336,8 +358,8 @@ static void subevent_callback(
   if (!send_data_upwards) {
     return;
   }
-  send_data_upwards.Run(FROM_HERE, WrapPacketAndCopy(MSG_HC_TO_STACK_HCI_EVT,
-                                                     &le_meta_event_view));
+  send_data_upwards.Run(FROM_HERE, WrapPacket(MSG_HC_TO_STACK_HCI_EVT,
+                                              &le_meta_event_view));
 }
 
 static void vendor_specific_event_callback(
@@ -347,7 +369,7 @@ static void vendor_specific_event_callback(
   }
   send_data_upwards.Run(
       FROM_HERE,
-      WrapPacketAndCopy(MSG_HC_TO_STACK_HCI_EVT, &vendor_specific_event_view));
+      WrapPacket(MSG_HC_TO_STACK_HCI_EVT, &vendor_specific_event_view));
 }
 
 void OnTransmitPacketCommandComplete(command_complete_cb complete_callback,
@@ -355,8 +377,7 @@ void OnTransmitPacketCommandComplete(command_complete_cb complete_callback,
                                      bluetooth::hci::CommandCompleteView view) {
   LOG_DEBUG("Received cmd complete for %s",
             bluetooth::hci::OpCodeText(view.GetCommandOpCode()).c_str());
-  std::vector<uint8_t> data(view.begin(), view.end());
-  BT_HDR* response = WrapPacketAndCopy(MSG_HC_TO_STACK_HCI_EVT, &view);
+  BT_HDR* response = WrapPacket(MSG_HC_TO_STACK_HCI_EVT, &view);
   complete_callback(response, context);
 }
 
@@ -452,7 +473,7 @@ static void acl_data_callback() {
   if (!send_data_upwards) {
     return;
   }
-  auto data = WrapPacketAndCopy(MSG_HC_TO_STACK_HCI_ACL, packet.get());
+  auto data = WrapPacket(MSG_HC_TO_STACK_HCI_ACL, packet.get());
   packet_fragmenter->reassemble_and_dispatch(data);
 }
 
@@ -505,13 +526,11 @@ static void on_shutting_down() {
 
 }  // namespace cpp
 
-using bluetooth::common::Bind;
 using bluetooth::common::BindOnce;
 using bluetooth::common::Unretained;
 
 namespace rust {
 
-using bluetooth::shim::rust::u8SliceCallback;
 using bluetooth::shim::rust::u8SliceOnceCallback;
 
 static BT_HDR* WrapRustPacketAndCopy(uint16_t event,
@@ -526,20 +545,53 @@ static BT_HDR* WrapRustPacketAndCopy(uint16_t event,
   return packet;
 }
 
-static void on_acl(::rust::Slice<const uint8_t> data) {
+// Received packets are serialized by the Rust stack straight into legacy
+// packets, so that they cross the bridge without a copy
+class LegacyPacketSink : public bluetooth::shim::rust::u8BufferSink {
+ public:
+  LegacyPacketSink(uint16_t event, void (*deliver)(BT_HDR*))
+      : event_(event), deliver_(deliver) {}
+  ~LegacyPacketSink() override {
+    if (packet_ != nullptr) osi_free(packet_);
+  }
+
+  ::rust::Slice<uint8_t> Alloc(size_t len) override {
+    if (packet_ != nullptr) osi_free(packet_);
+    packet_ = reinterpret_cast<BT_HDR*>(osi_malloc(len + kBtHdrSize));
+    packet_->offset = 0;
+    packet_->len = len;
+    packet_->layer_specific = 0;
+    packet_->event = event_;
+    return ::rust::Slice<uint8_t>(packet_->data, len);
+  }
+
+  void Deliver() override {
+    CHECK(packet_ != nullptr);
+    BT_HDR* packet = packet_;
+    packet_ = nullptr;
+    deliver_(packet);
+  }
+
+ private:
+  const uint16_t event_;
+  void (*const deliver_)(BT_HDR*);
+  BT_HDR* packet_ = nullptr;
+};
+
+static void on_acl(BT_HDR* packet) {
   if (!send_data_upwards) {
+    osi_free(packet);
     return;
   }
-  auto legacy_data = WrapRustPacketAndCopy(MSG_HC_TO_STACK_HCI_ACL, &data);
-  packet_fragmenter->reassemble_and_dispatch(legacy_data);
+  packet_fragmenter->reassemble_and_dispatch(packet);
 }
 
-static void on_event(::rust::Slice<const uint8_t> data) {
+static void on_event(BT_HDR* packet) {
   if (!send_data_upwards) {
+    osi_free(packet);
     return;
   }
-  send_data_upwards.Run(FROM_HERE,
-                        WrapRustPacketAndCopy(MSG_HC_TO_STACK_HCI_EVT, &data));
+  send_data_upwards.Run(FROM_HERE, packet);
 }
 
 void OnRustTransmitPacketCommandComplete(command_complete_cb complete_callback,
@@ -609,18 +661,21 @@ static void register_le_event(bluetooth::hci::SubeventCode subevent_code) {
 }
 
 static void hci_on_reset_complete() {
-  bluetooth::shim::rust::hci_set_evt_callback(
+  bluetooth::shim::rust::hci_set_evt_sink(
       **bluetooth::shim::Stack::GetInstance()->GetRustHci(),
-      std::make_unique<u8SliceCallback>(Bind(rust::on_event)));
-  bluetooth::shim::rust::hci_set_le_evt_callback(
+      std::make_unique<LegacyPacketSink>(MSG_HC_TO_STACK_HCI_EVT,
+                                         rust::on_event));
+  bluetooth::shim::rust::hci_set_le_evt_sink(
       **bluetooth::shim::Stack::GetInstance()->GetRustHci(),
-      std::make_unique<u8SliceCallback>(Bind(rust::on_event)));
+      std::make_unique<LegacyPacketSink>(MSG_HC_TO_STACK_HCI_EVT,
+                                         rust::on_event));
 }
 
 static void register_for_acl() {
-  bluetooth::shim::rust::hci_set_acl_callback(
+  bluetooth::shim::rust::hci_set_acl_sink(
       **bluetooth::shim::Stack::GetInstance()->GetRustHci(),
-      std::make_unique<u8SliceCallback>(Bind(rust::on_acl)));
+      std::make_unique<LegacyPacketSink>(MSG_HC_TO_STACK_HCI_ACL,
+                                         rust::on_acl));
 }
 
 static void on_shutting_down() {}
@@ -715,7 +770,14 @@ static hci_t interface = {.set_data_cb = set_data_cb,
                           .transmit_command_futured = transmit_command_futured,
                           .transmit_downward = transmit_downward};
 
+// Incoming packets are received behind room for a BT_HDR, see WrapPacket()
+static const bluetooth::hal::RxBufferAllocator rx_buffer_allocator = {
+    .headroom = kBtHdrSize, .alloc = osi_malloc, .free = osi_free};
+
 const hci_t* bluetooth::shim::hci_layer_get_interface() {
+  if (!bluetooth::common::init_flags::gd_rust_is_enabled()) {
+    bluetooth::hal::SetRxBufferAllocator(&rx_buffer_allocator);
+  }
   packet_fragmenter = packet_fragmenter_get_interface();
   packet_fragmenter->init(&packet_fragmenter_callbacks);
   return &interface;
@@ -117,13 +117,33 @@ inline BT_HDR* MakeLegacyBtHdrPacket(
     std::unique_ptr<bluetooth::hci::PacketView<bluetooth::hci::kLittleEndian>>
         packet,
     const std::vector<uint8_t>& preamble) {
-  std::vector<uint8_t> packet_vector(packet->begin(), packet->end());
+  // Reassembled packets are chains of fragments; flatten them straight into
+  // the legacy buffer
+  size_t packet_size = packet->size();
   BT_HDR* buffer = static_cast<BT_HDR*>(
-      osi_calloc(packet_vector.size() + preamble.size() + sizeof(BT_HDR)));
+      osi_calloc(packet_size + preamble.size() + sizeof(BT_HDR)));
   std::copy(preamble.begin(), preamble.end(), buffer->data);
-  std::copy(packet_vector.begin(), packet_vector.end(),
-            buffer->data + preamble.size());
-  buffer->len = preamble.size() + packet_vector.size();
+  packet->CopyTo(buffer->data + preamble.size());
+  buffer->len = preamble.size() + packet_size;
+  return buffer;
+}
+
+// Received ACL data is handed to the legacy stack with its ACL header in
+// front; write the header and the payload straight into a single buffer
+inline BT_HDR* MakeLegacyAclPacket(
+    uint16_t handle,
+    const bluetooth::hci::PacketView<bluetooth::hci::kLittleEndian>& packet) {
+  uint16_t packet_size = packet.size();
+  BT_HDR* buffer = static_cast<BT_HDR*>(
+      osi_malloc(sizeof(BT_HDR) + HCI_DATA_PREAMBLE_SIZE + packet_size));
+  buffer->event = 0;
+  buffer->len = HCI_DATA_PREAMBLE_SIZE + packet_size;
+  buffer->offset = 0;
+  buffer->layer_specific = 0;
+  uint8_t* p = buffer->data;
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, packet_size);
+  packet.CopyTo(p);
   return buffer;
 }
 
@@ -806,7 +806,8 @@ bool L2CA_ReconfigCreditBasedConnsReq(const RawAddress& bd_addr,
 
 std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
                                                  const RawAddress& p_bd_addr,
-                                                 tL2CAP_LE_CFG_INFO* p_cfg) {
+                                                 tL2CAP_LE_CFG_INFO* p_cfg,
+                                                 uint8_t num_of_channels) {
   LOG_INFO("UNIMPLEMENTED %s addr:%s", __func__, p_bd_addr.ToString().c_str());
   std::vector<uint16_t> result;
   return result;
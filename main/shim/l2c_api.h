@@ -179,7 +179,8 @@ bool L2CA_ReconfigCreditBasedConnsReq(const RawAddress& bd_addr,
  ******************************************************************************/
 
 extern std::vector<uint16_t> L2CA_ConnectCreditBasedReq(
-    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg);
+    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg,
+    uint8_t num_of_channels);
 
 /*******************************************************************************
  *
@@ -22,6 +22,9 @@
 #include <base/threading/thread.h>
 #include <hardware/bluetooth.h>
 #include <stdio.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <unordered_set>
 
 #include "btif/include/btif_common.h"
@@ -215,12 +218,31 @@ class BleScannerInterfaceImpl : public BleScannerInterface,
                  uint16_t timeout, StartSyncCb start_cb, SyncReportCb report_cb,
                  SyncLostCb lost_cb) {
     LOG(INFO) << __func__ << " in shim layer";
-    // This function doesn't implement in the old stack
+    tBLE_ADDR_TYPE address_type = BLE_ADDR_RANDOM;
+    tINQ_DB_ENT* p_i = btm_inq_db_find(address);
+    if (p_i != nullptr &&
+        p_i->inq_info.results.ble_addr_type == BLE_ADDR_PUBLIC) {
+      address_type = BLE_ADDR_PUBLIC;
+    }
+
+    int request_id;
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      request_id = next_sync_request_id_++;
+      sync_requests_[request_id] = {sid,      address,   0,      false,
+                                    start_cb, report_cb, lost_cb};
+    }
+    bluetooth::shim::GetScanning()->StartSync(
+        request_id, sid, ToAddressWithType(address, address_type), skip,
+        timeout);
   }
 
   void StopSync(uint16_t handle) {
     LOG(INFO) << __func__ << " in shim layer";
-    // This function doesn't implement in the old stack
+    // The apps sharing a sync all got its handle, stop the request of one
+    StopSyncRequest([handle](const SyncRequest& request) {
+      return request.started && request.sync_handle == handle;
+    });
   }
 
   void RegisterCallbacks(ScanningCallbacks* callbacks) {
@@ -333,7 +355,68 @@ class BleScannerInterfaceImpl : public BleScannerInterface,
 
   ScanningCallbacks* scanning_callbacks_;
 
-  void CancelCreateSync(uint8_t sid, RawAddress address) override {}
+  void CancelCreateSync(uint8_t sid, RawAddress address) override {
+    LOG(INFO) << __func__ << " in shim layer";
+    StopSyncRequest([sid, address](const SyncRequest& request) {
+      return !request.started && request.sid == sid &&
+             request.address == address;
+    });
+  }
+
+  void OnPeriodicSyncStarted(int request_id, bluetooth::hci::ErrorCode status,
+                             uint16_t sync_handle, uint8_t advertising_sid,
+                             bluetooth::hci::AddressWithType address_with_type,
+                             bluetooth::hci::SecondaryPhyType phy,
+                             uint16_t interval) {
+    StartSyncCb start_cb;
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      auto it = sync_requests_.find(request_id);
+      if (it == sync_requests_.end()) return;
+      start_cb = it->second.start_cb;
+      if (status == bluetooth::hci::ErrorCode::SUCCESS) {
+        it->second.started = true;
+        it->second.sync_handle = sync_handle;
+      } else {
+        sync_requests_.erase(it);
+      }
+    }
+    do_in_jni_thread(
+        FROM_HERE,
+        base::Bind(start_cb, static_cast<uint8_t>(status), sync_handle,
+                   advertising_sid,
+                   static_cast<uint8_t>(address_with_type.GetAddressType()),
+                   ToRawAddress(address_with_type.GetAddress()),
+                   static_cast<uint8_t>(phy), interval));
+  }
+
+  void OnPeriodicSyncReport(int request_id, uint16_t sync_handle,
+                            int8_t tx_power, int8_t rssi,
+                            bluetooth::hci::DataStatus status,
+                            std::vector<uint8_t> data) {
+    SyncReportCb report_cb;
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      auto it = sync_requests_.find(request_id);
+      if (it == sync_requests_.end()) return;
+      report_cb = it->second.report_cb;
+    }
+    do_in_jni_thread(FROM_HERE, base::Bind(report_cb, sync_handle, tx_power,
+                                           rssi, static_cast<uint8_t>(status),
+                                           std::move(data)));
+  }
+
+  void OnPeriodicSyncLost(int request_id, uint16_t sync_handle) {
+    SyncLostCb lost_cb;
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      auto it = sync_requests_.find(request_id);
+      if (it == sync_requests_.end()) return;
+      lost_cb = it->second.lost_cb;
+      sync_requests_.erase(it);
+    }
+    do_in_jni_thread(FROM_HERE, base::Bind(lost_cb, sync_handle));
+  }
   void TransferSync(RawAddress address, uint16_t service_data,
                          uint16_t sync_handle, SyncTransferCb cb) override {}
 
@@ -418,10 +501,11 @@ class BleScannerInterfaceImpl : public BleScannerInterface,
       return;
     }
 
+    AdIndex ad(advertising_data);
+
     auto device_type = bluetooth::hci::DeviceType::LE;
     uint8_t flag_len;
-    const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
-        advertising_data, BTM_BLE_AD_TYPE_FLAG, &flag_len);
+    const uint8_t* p_flag = ad.GetFieldByType(BTM_BLE_AD_TYPE_FLAG, &flag_len);
     if (p_flag != NULL && flag_len != 0) {
       if ((BTM_BLE_BREDR_NOT_SPT & *p_flag) == 0) {
         device_type = bluetooth::hci::DeviceType::DUAL;
@@ -429,12 +513,12 @@ class BleScannerInterfaceImpl : public BleScannerInterface,
     }
 
     uint8_t remote_name_len;
-    const uint8_t* p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-        advertising_data, BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
+    const uint8_t* p_eir_remote_name =
+        ad.GetFieldByType(BTM_EIR_COMPLETE_LOCAL_NAME_TYPE, &remote_name_len);
 
     if (p_eir_remote_name == NULL) {
-      p_eir_remote_name = AdvertiseDataParser::GetFieldByType(
-          advertising_data, BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
+      p_eir_remote_name =
+          ad.GetFieldByType(BT_EIR_SHORTENED_LOCAL_NAME_TYPE, &remote_name_len);
     }
 
     // update device name
@@ -503,6 +587,39 @@ class BleScannerInterfaceImpl : public BleScannerInterface,
     remote_bdaddr_cache_ordered_ = {};
   }
 
+  struct SyncRequest {
+    uint8_t sid;
+    RawAddress address;
+    uint16_t sync_handle;
+    bool started;
+    StartSyncCb start_cb;
+    SyncReportCb report_cb;
+    SyncLostCb lost_cb;
+  };
+
+  template <typename Matches>
+  void StopSyncRequest(Matches matches) {
+    int request_id;
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      auto it = std::find_if(
+          sync_requests_.begin(), sync_requests_.end(),
+          [&matches](const auto& entry) { return matches(entry.second); });
+      if (it == sync_requests_.end()) {
+        LOG_WARN("No matching sync request");
+        return;
+      }
+      request_id = it->first;
+      sync_requests_.erase(it);
+    }
+    bluetooth::shim::GetScanning()->StopSync(request_id);
+  }
+
+  // Sync requests are made from the app threads and answered on the gd thread
+  std::mutex sync_mutex_;
+  std::map<int, SyncRequest> sync_requests_;
+  int next_sync_request_id_ = 0;
+
   // all access to this variable should be done on the jni thread
   std::set<RawAddress> remote_bdaddr_cache_;
   std::queue<RawAddress> remote_bdaddr_cache_ordered_;
@@ -36,6 +36,7 @@
 #include "gd/neighbor/name.h"
 #include "gd/neighbor/name_db.h"
 #include "gd/neighbor/page.h"
+#include "gd/neighbor/radio_scheduler.h"
 #include "gd/neighbor/scan.h"
 #include "gd/os/log.h"
 #include "gd/security/security_module.h"
@@ -55,6 +56,9 @@
 namespace bluetooth {
 namespace shim {
 
+// Longest busy poll of the stack thread reactor, with gd_reactor_busy_poll
+constexpr std::chrono::microseconds kStackThreadBusyPollWindow(50);
+
 Stack* Stack::GetInstance() {
   static Stack instance;
   return &instance;
@@ -135,14 +139,22 @@ void Stack::StartEverything() {
     modules.add<neighbor::ScanModule>();
     modules.add<storage::StorageModule>();
   }
+  if (common::init_flags::gd_radio_scheduler_is_enabled()) {
+    modules.add<neighbor::RadioScheduler>();
+  }
   Start(&modules);
   is_running_ = true;
   // Make sure the leaf modules are started
   ASSERT(stack_manager_.GetInstance<storage::StorageModule>() != nullptr);
   ASSERT(stack_manager_.GetInstance<shim::Dumpsys>() != nullptr);
   if (common::init_flags::gd_core_is_enabled()) {
+    neighbor::RadioScheduler* radio_scheduler = nullptr;
+    if (common::init_flags::gd_radio_scheduler_is_enabled()) {
+      radio_scheduler = stack_manager_.GetInstance<neighbor::RadioScheduler>();
+    }
     btm_ = new Btm(stack_handler_,
-                   stack_manager_.GetInstance<neighbor::InquiryModule>());
+                   stack_manager_.GetInstance<neighbor::InquiryModule>(),
+                   radio_scheduler);
   }
   if (common::init_flags::gd_acl_is_enabled()) {
     if (!common::init_flags::gd_core_is_enabled()) {
@@ -176,6 +188,11 @@ void Stack::Start(ModuleList* modules) {
 
   stack_thread_ =
       new os::Thread("gd_stack_thread", os::Thread::Priority::NORMAL);
+  if (common::init_flags::gd_reactor_busy_poll_is_enabled()) {
+    // The HCI layer and the ACL manager run on this thread, poll briefly
+    // between packets of a stream instead of sleeping after each one
+    stack_thread_->GetReactor()->SetBusyPollWindow(kStackThreadBusyPollWindow);
+  }
   stack_manager_.StartUp(modules, stack_thread_);
 
   stack_handler_ = new os::Handler(stack_thread_);
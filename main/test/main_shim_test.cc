@@ -51,6 +51,7 @@
 #include "stack/btm/btm_int_types.h"
 #include "stack/include/btu.h"
 #include "stack/l2cap/l2c_int.h"
+#include "stack/rfcomm/rfc_int.h"
 #include "test/common/main_handler.h"
 #include "test/mock/mock_main_shim_entry.h"
 
@@ -62,6 +63,7 @@ namespace test = bluetooth::hci::testing;
 const uint8_t kMaxLeAcceptlistSize = 16;
 std::map<std::string, int> mock_function_count_map;
 tL2C_CB l2cb;
+tRFC_CB rfc_cb;
 tBTM_CB btm_cb;
 btif_hh_cb_t btif_hh_cb;
 
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "main/shim/helpers.h"
+#include "osi/include/allocator.h"
+
+using ::benchmark::State;
+using bluetooth::hci::kLittleEndian;
+using bluetooth::hci::PacketView;
+
+namespace {
+
+constexpr uint16_t kHandle = 0x0001;
+
+PacketView<kLittleEndian> MakePayload(size_t size) {
+  return PacketView<kLittleEndian>(
+      std::make_shared<std::vector<uint8_t>>(size, 0xa5));
+}
+
+// Conversion of a received packet as done before the direct path: a preamble
+// vector and a zeroed copy of the packet
+void BM_AclRxPreambleCopy(State& state) {
+  auto payload = MakePayload(state.range(0));
+  for (auto _ : state) {
+    uint16_t length = payload.size();
+    std::vector<uint8_t> preamble;
+    preamble.push_back(kHandle & 0xff);
+    preamble.push_back(kHandle >> 8);
+    preamble.push_back(length & 0xff);
+    preamble.push_back(length >> 8);
+    BT_HDR* p_buf = bluetooth::MakeLegacyBtHdrPacket(
+        std::make_unique<PacketView<kLittleEndian>>(payload), preamble);
+    benchmark::DoNotOptimize(p_buf->data);
+    osi_free(p_buf);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AclRxPreambleCopy)->Arg(27)->Arg(251)->Arg(1021);
+
+void BM_AclRxDirect(State& state) {
+  auto payload = MakePayload(state.range(0));
+  for (auto _ : state) {
+    BT_HDR* p_buf = bluetooth::MakeLegacyAclPacket(kHandle, payload);
+    benchmark::DoNotOptimize(p_buf->data);
+    osi_free(p_buf);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AclRxDirect)->Arg(27)->Arg(251)->Arg(1021);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Allocation tags account the memory handed out by the osi_malloc family to
+// the module it was allocated for. Modules set the tag of the current thread
+// for the scope of their work with AllocationTagScope, and each allocation
+// keeps that tag in a small header in front of it, so that it is accounted to
+// the same tag whichever thread frees it.
+//
+// Tagging is enabled with the persist.bluetooth.allocation_tags property. It
+// is decided once, on the first allocation, since every live allocation must
+// have been made with or without the header. When disabled, it costs one
+// check per allocation and free.
+typedef enum : uint8_t {
+  ALLOCATION_TAG_NONE = 0,
+  ALLOCATION_TAG_DM,
+  ALLOCATION_TAG_SDP,
+  ALLOCATION_TAG_GATT,
+  ALLOCATION_TAG_A2DP,
+  ALLOCATION_TAG_AVRCP,
+  ALLOCATION_TAG_HFP,
+  ALLOCATION_TAG_HID,
+  ALLOCATION_TAG_PAN,
+  ALLOCATION_TAG_SOCKET,
+  ALLOCATION_TAG_MAX,
+} allocation_tag_t;
+
+typedef struct {
+  size_t live_bytes;
+  size_t live_count;
+  size_t peak_bytes;
+  size_t total_count;
+} allocation_tag_stats_t;
+
+// Returns the size to allocate for a tagged allocation of |size| bytes.
+size_t allocation_tags_resize(size_t size);
+
+// Notify the tags of a new allocation of |size| bytes at |ptr|, which must be
+// at least |allocation_tags_resize(size)| bytes. The allocation is accounted
+// to the tag of the current thread. Returns |ptr| offset to the beginning of
+// the untagged region. If |ptr| is NULL, this function does nothing.
+void* allocation_tags_notify_alloc(void* ptr, size_t size);
+
+// Notify the tags of an allocation that is being freed. |ptr| must be a
+// pointer returned by |allocation_tags_notify_alloc|. Returns |ptr| offset to
+// the real beginning of the allocation. If |ptr| is NULL, this function does
+// nothing.
+void* allocation_tags_notify_free(void* ptr);
+
+// Sets the tag new allocations of the current thread are accounted to, and
+// returns the previous one.
+allocation_tag_t allocation_tags_set_current(allocation_tag_t tag);
+
+// Returns false if tagging is disabled, else true and the statistics of
+// |tag| in |stats|.
+bool allocation_tags_get_stats(allocation_tag_t tag,
+                               allocation_tag_stats_t* stats);
+
+// Dump the statistics of each tag to the |fd| file descriptor in
+// user-readable text format.
+void allocation_tags_debug_dump(int fd);
+
+// Accounts the allocations of the current thread to |tag| for the lifetime of
+// the scope.
+class AllocationTagScope {
+ public:
+  explicit AllocationTagScope(allocation_tag_t tag)
+      : previous_(allocation_tags_set_current(tag)) {}
+  ~AllocationTagScope() { allocation_tags_set_current(previous_); }
+
+  AllocationTagScope(const AllocationTagScope&) = delete;
+  AllocationTagScope& operator=(const AllocationTagScope&) = delete;
+
+ private:
+  allocation_tag_t previous_;
+};
@@ -15,16 +15,103 @@
 //   empty sections.
 // - Duplicate keys in a section will overwrite previous values.
 // - All strings are case sensitive.
+// - Sections and keys keep their insertion order, which is the order they are
+//   saved in, and are looked up through a hash index in constant time.
 
 #include <stdbool.h>
 #include <list>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 // The default section name to use if a key/value pair is not defined within
 // a section.
 #define CONFIG_DEFAULT_SECTION "Global"
 
+// A list of |T| named by their |Name| member, with a hash index on the name.
+// It keeps the std::list iterators and insertion order, so it is iterated,
+// erased and appended to like the list it replaces, while |Find| is O(1).
+// The index refers to the names stored in the list: the name of an element
+// must not change while it is in the list, and names must be unique.
+template <typename T, std::string T::*Name>
+class indexed_list_t {
+ public:
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  indexed_list_t() = default;
+  indexed_list_t(indexed_list_t&& other) noexcept = default;
+  indexed_list_t& operator=(indexed_list_t&& other) noexcept = default;
+  indexed_list_t(const indexed_list_t& other) : list_(other.list_) {
+    Reindex();
+  }
+  indexed_list_t& operator=(const indexed_list_t& other) {
+    if (&other == this) return *this;
+    list_ = other.list_;
+    Reindex();
+    return *this;
+  }
+
+  iterator begin() { return list_.begin(); }
+  iterator end() { return list_.end(); }
+  const_iterator begin() const { return list_.begin(); }
+  const_iterator end() const { return list_.end(); }
+  size_t size() const { return list_.size(); }
+  bool empty() const { return list_.empty(); }
+
+  iterator Find(std::string_view name) {
+    auto it = index_.find(name);
+    return it == index_.end() ? list_.end() : it->second;
+  }
+  const_iterator Find(std::string_view name) const {
+    auto it = index_.find(name);
+    return it == index_.end() ? list_.end() : const_iterator(it->second);
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    T& element = list_.emplace_back(std::forward<Args>(args)...);
+    index_.emplace(element.*Name, std::prev(list_.end()));
+    return element;
+  }
+  void push_back(T element) { emplace_back(std::move(element)); }
+
+  iterator erase(const_iterator it) {
+    auto indexed = index_.find((*it).*Name);
+    if (indexed != index_.end() && indexed->second == it) {
+      index_.erase(indexed);
+    }
+    return list_.erase(it);
+  }
+  // Removes the element at |it| and returns it, unlike moving it out before
+  // erase() this drops its index entry while its name is still there
+  T extract(iterator it) {
+    auto indexed = index_.find((*it).*Name);
+    if (indexed != index_.end() && indexed->second == it) {
+      index_.erase(indexed);
+    }
+    T element = std::move(*it);
+    list_.erase(it);
+    return element;
+  }
+  void clear() {
+    index_.clear();
+    list_.clear();
+  }
+
+ private:
+  void Reindex() {
+    index_.clear();
+    for (auto it = list_.begin(); it != list_.end(); ++it) {
+      index_.emplace((*it).*Name, it);
+    }
+  }
+
+  std::list<T> list_;
+  std::unordered_map<std::string_view, iterator> index_;
+};
+
 struct entry_t {
   std::string key;
   std::string value;
@@ -32,14 +119,14 @@ struct entry_t {
 
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  indexed_list_t<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
   std::list<entry_t>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 };
 
 struct config_t {
-  std::list<section_t> sections;
+  indexed_list_t<section_t, &section_t::name> sections;
   std::list<section_t>::iterator Find(const std::string& section);
   bool Has(const std::string& section);
 };
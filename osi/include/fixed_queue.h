@@ -36,6 +36,16 @@ typedef void (*fixed_queue_cb)(fixed_queue_t* queue, void* context);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t* fixed_queue_new(size_t capacity);
 
+// Creates a new fixed queue with the given |capacity| for use by exactly one
+// producer thread and one consumer thread. Elements are kept in a bounded
+// lock-free ring and the enqueue/dequeue file descriptors are only signalled
+// when the queue goes from empty to non-empty or from full to non-full.
+// |capacity| must be greater than zero. Apart from
+// |fixed_queue_try_remove_from_queue| and |fixed_queue_get_list|, which are
+// not supported, the queue is used through the same functions as a queue
+// returned by |fixed_queue_new|. Returns NULL on failure.
+fixed_queue_t* fixed_queue_new_spsc(size_t capacity);
+
 // Frees a queue and (optionally) the enqueued elements.
 // |queue| is the queue to free. If the |free_cb| callback is not null,
 // it is called on each queue element to free it.
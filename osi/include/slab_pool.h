@@ -0,0 +1,48 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Size-class slab pool used by the osi_malloc family.
+//
+// Blocks are carved out of a single reserved region, one sub-region per size
+// class, and recycled through small per-thread caches backed by a shared
+// per-class free list. A block may be freed on any thread. Allocations larger
+// than the biggest size class, or made while a class is exhausted, are not
+// served by the pool and must fall back to the system allocator.
+//
+// The pool is disabled when building with AddressSanitizer so that heap errors
+// on pooled buffers are still reported.
+
+// Returns a block of at least |size| bytes, or NULL if the pool cannot serve
+// the request. The returned memory is not initialized.
+void* slab_pool_alloc(size_t size);
+
+// Returns true if |ptr| points into the slab pool region.
+bool slab_pool_owns(const void* ptr);
+
+// Returns |ptr| to the pool and returns true if it belongs to the pool.
+// Returns false and does nothing otherwise, including when |ptr| is NULL.
+bool slab_pool_free(void* ptr);
+
+// Dump per size class statistics (hits, misses, blocks in use and
+// high-water marks) to the |fd| file descriptor in user-readable text format.
+void slab_pool_debug_dump(int fd);
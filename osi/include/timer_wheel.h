@@ -0,0 +1,91 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Hierarchical timer wheel keyed by absolute deadlines in milliseconds.
+//
+// Entries are intrusive: the caller embeds a |timer_wheel_entry_t| in its own
+// object and the wheel links it into one of its slots, so insertion and
+// removal are O(1) and never allocate. The wheel has six levels of 64 slots
+// each; an entry lives on the level of the most significant 6-bit group in
+// which its deadline differs from the wheel time, and moves down a level at a
+// time as |timer_wheel_advance| moves the wheel time forward.
+//
+// None of the functions below are thread safe. Callers must provide their own
+// locking.
+
+typedef struct timer_wheel_t timer_wheel_t;
+
+typedef struct timer_wheel_entry_t {
+  struct timer_wheel_entry_t* prev;
+  struct timer_wheel_entry_t* next;
+  uint64_t deadline_ms;
+  void* data;  // Owner of the entry, untouched by the wheel
+  int16_t bucket;  // Index of the slot holding the entry, or -1
+} timer_wheel_entry_t;
+
+// Iterator callback prototype used for |timer_wheel_foreach|. Callback must
+// return true to continue iterating or false to stop iterating.
+typedef bool (*timer_wheel_iter_cb)(timer_wheel_entry_t* entry,
+                                    void* context);
+
+// Initializes |entry| so that it is not queued and carries |data|. Must be
+// called before the entry is used with any other function.
+void timer_wheel_entry_init(timer_wheel_entry_t* entry, void* data);
+
+// Returns a new, empty timer wheel whose time starts at |now_ms|. The returned
+// wheel must be freed with |timer_wheel_free|.
+timer_wheel_t* timer_wheel_new(uint64_t now_ms);
+
+// Frees the wheel. Entries still queued are unlinked but not otherwise
+// touched. |wheel| may be NULL.
+void timer_wheel_free(timer_wheel_t* wheel);
+
+// Queues |entry| with the given |deadline_ms|. If |entry| is already queued
+// it is moved. Entries with the same deadline are returned by
+// |timer_wheel_peek| in the order they were inserted.
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_entry_t* entry,
+                        uint64_t deadline_ms);
+
+// Removes |entry| from the wheel. Does nothing if |entry| is not queued.
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_entry_t* entry);
+
+// Returns true if |entry| is currently queued on a wheel.
+bool timer_wheel_is_queued(const timer_wheel_entry_t* entry);
+
+// Returns the entry with the earliest deadline, or NULL if the wheel is empty.
+// The result is cached until the earliest entry is removed.
+timer_wheel_entry_t* timer_wheel_peek(timer_wheel_t* wheel);
+
+// Moves the wheel time forward to |now_ms|, cascading entries down to lower
+// levels. Each entry cascades at most once per level. Moving the time
+// backwards is ignored.
+void timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ms);
+
+// Returns the number of queued entries.
+size_t timer_wheel_size(const timer_wheel_t* wheel);
+
+// Iterates over all queued entries in no particular order. Entries must not
+// be inserted or removed from |callback|.
+void timer_wheel_foreach(const timer_wheel_t* wheel,
+                         timer_wheel_iter_cb callback, void* context);
@@ -20,6 +20,7 @@
 
 #include <hardware/bluetooth.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 // Set the Bluetooth OS callouts to |callouts|.
 // This function should be called when native kernel wakelocks are not used
@@ -27,7 +28,8 @@
 // kernel wakelocks will be used.
 void wakelock_set_os_callouts(bt_os_callouts_t* callouts);
 
-// Acquire the Bluetooth wakelock.
+// Acquire the Bluetooth wakelock. Acquisitions are reference counted: the
+// wakelock is held until each successful acquire has been released.
 // The function is thread safe.
 // Return true on success, otherwise false.
 bool wakelock_acquire(void);
@@ -37,6 +39,12 @@ bool wakelock_acquire(void);
 // Return true on success, otherwise false.
 bool wakelock_release(void);
 
+// Keep the wakelock for |ms| after its last holder released it, so that
+// holders coming in the meantime reuse it instead of acquiring it again.
+// Zero, the default, releases the wakelock as soon as it has no holder.
+// The function is thread safe.
+void wakelock_set_hold_over_ms(uint64_t ms);
+
 // Cleanup the wakelock internal state.
 // This function should be called by the OSI module cleanup during
 // graceful shutdown.
@@ -42,8 +42,10 @@
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/semaphore.h"
 #include "osi/include/thread.h"
+#include "osi/include/timer_wheel.h"
 #include "osi/include/wakelock.h"
 #include "stack/include/btu.h"
 
@@ -103,6 +105,8 @@ struct alarm_t {
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
+
+  timer_wheel_entry_t wheel_entry;  // Used by the timer wheel backend
 };
 
 // If the next wakeup time is less than this threshold, we should acquire
@@ -117,6 +121,10 @@ static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 // also protects the |alarms| list.
 static std::mutex alarms_mutex;
 static list_t* alarms;
+// When set, pending alarms are kept in this hierarchical timer wheel instead
+// of the sorted |alarms| list, which makes set and cancel O(1) regardless of
+// the number of pending alarms.
+static timer_wheel_t* alarm_wheel;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -138,6 +146,10 @@ static void alarm_set_internal(alarm_t* alarm, uint64_t period_ms,
                                fixed_queue_t* queue, bool for_msg_loop);
 static void alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
+static alarm_t* pending_front(void);
+static void pending_insert(alarm_t* alarm, uint64_t just_now_ms);
+static void pending_remove(alarm_t* alarm);
+static size_t pending_count(void);
 static void schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
@@ -180,6 +192,7 @@ static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
   ret->for_msg_loop = false;
   // placement new
   new (&ret->closure) CancelableClosureInStruct();
+  timer_wheel_entry_init(&ret->wheel_entry, ret);
 
   // NOTE: The stats were reset by osi_calloc() above
 
@@ -259,8 +272,7 @@ void alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (pending_front() == alarm);
 
   remove_pending_alarm(alarm);
 
@@ -300,6 +312,8 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
+  timer_wheel_free(alarm_wheel);
+  alarm_wheel = NULL;
   list_free(alarms);
   alarms = NULL;
 }
@@ -320,6 +334,9 @@ static bool lazy_initialize(void) {
     goto error;
   }
 
+  if (osi_property_get_bool("persist.bluetooth.alarm_timer_wheel", false))
+    alarm_wheel = timer_wheel_new(now_ms());
+
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
   timer_initialized = true;
 
@@ -379,6 +396,8 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
+  timer_wheel_free(alarm_wheel);
+  alarm_wheel = NULL;
   list_free(alarms);
   alarms = NULL;
 
@@ -400,7 +419,7 @@ static uint64_t now_ms(void) {
 // Remove alarm from internal alarm list and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  pending_remove(alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -417,8 +436,7 @@ static void remove_pending_alarm(alarm_t* alarm) {
 static void schedule_next_instance(alarm_t* alarm) {
   // If the alarm is currently set and it's at the start of the list,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = (pending_front() == alarm);
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -429,6 +447,35 @@ static void schedule_next_instance(alarm_t* alarm) {
         ((just_now_ms - alarm->creation_time_ms) % alarm->period_ms);
   alarm->deadline_ms = just_now_ms + (alarm->period_ms - ms_into_period);
 
+  pending_insert(alarm, just_now_ms);
+
+  // If the new alarm has the earliest deadline, we need to re-evaluate our
+  // schedule.
+  if (needs_reschedule || pending_front() == alarm) {
+    reschedule_root_alarm();
+  }
+}
+
+// Returns the pending alarm with the earliest deadline, or NULL if there are
+// no pending alarms.
+// Must be called with |alarms_mutex| held
+static alarm_t* pending_front(void) {
+  if (alarm_wheel) {
+    timer_wheel_entry_t* entry = timer_wheel_peek(alarm_wheel);
+    return entry ? static_cast<alarm_t*>(entry->data) : NULL;
+  }
+  return list_is_empty(alarms) ? NULL
+                               : static_cast<alarm_t*>(list_front(alarms));
+}
+
+// Must be called with |alarms_mutex| held
+static void pending_insert(alarm_t* alarm, uint64_t just_now_ms) {
+  if (alarm_wheel) {
+    timer_wheel_advance(alarm_wheel, just_now_ms);
+    timer_wheel_insert(alarm_wheel, &alarm->wheel_entry, alarm->deadline_ms);
+    return;
+  }
+
   // Add it into the timer list sorted by deadline (earliest deadline first).
   if (list_is_empty(alarms) ||
       ((alarm_t*)list_front(alarms))->deadline_ms > alarm->deadline_ms) {
@@ -444,13 +491,21 @@ static void schedule_next_instance(alarm_t* alarm) {
       }
     }
   }
+}
 
-  // If the new alarm has the earliest deadline, we need to re-evaluate our
-  // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
-    reschedule_root_alarm();
+// Must be called with |alarms_mutex| held
+static void pending_remove(alarm_t* alarm) {
+  if (alarm_wheel) {
+    timer_wheel_remove(alarm_wheel, &alarm->wheel_entry);
+    return;
   }
+  list_remove(alarms, alarm);
+}
+
+// Must be called with |alarms_mutex| held
+static size_t pending_count(void) {
+  if (alarm_wheel) return timer_wheel_size(alarm_wheel);
+  return list_length(alarms);
 }
 
 // NOTE: must be called with |alarms_mutex| held
@@ -465,9 +520,9 @@ static void reschedule_root_alarm(void) {
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  next = pending_front();
+  if (next == NULL) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
   next_expiration = next->deadline_ms - now_ms();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
@@ -623,19 +678,19 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     if (!dispatcher_thread_active) break;
 
     std::lock_guard<std::mutex> lock(alarms_mutex);
-    alarm_t* alarm;
+    uint64_t just_now_ms = now_ms();
+    if (alarm_wheel) timer_wheel_advance(alarm_wheel, just_now_ms);
 
     // Take into account that the alarm may get cancelled before we get to it.
     // We're done here if there are no alarms or the alarm at the front is in
     // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline_ms >
-            now_ms()) {
+    alarm_t* alarm = pending_front();
+    if (alarm == NULL || alarm->deadline_ms > just_now_ms) {
       reschedule_root_alarm();
       continue;
     }
 
-    list_remove(alarms, alarm);
+    pending_remove(alarm);
 
     if (alarm->is_periodic) {
       alarm->prev_deadline_ms = alarm->deadline_ms;
@@ -713,6 +768,20 @@ static void update_scheduling_stats(alarm_stats_t* stats, uint64_t now_ms,
   }
 }
 
+typedef struct {
+  int fd;
+  uint64_t just_now_ms;
+} dump_context_t;
+
+static void dump_alarm(int fd, alarm_t* alarm, uint64_t just_now_ms);
+
+static bool dump_wheel_entry(timer_wheel_entry_t* entry, void* context) {
+  dump_context_t* dump_context = static_cast<dump_context_t*>(context);
+  dump_alarm(dump_context->fd, static_cast<alarm_t*>(entry->data),
+             dump_context->just_now_ms);
+  return true;
+}
+
 static void dump_stat(int fd, stat_t* stat, const char* description) {
   uint64_t average_time_ms = 0;
   if (stat->count != 0) average_time_ms = stat->total_ms / stat->count;
@@ -734,38 +803,47 @@ void alarm_debug_dump(int fd) {
 
   uint64_t just_now_ms = now_ms();
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu%s\n\n", pending_count(),
+          alarm_wheel ? " (timer wheel)" : "");
 
   // Dump info for each alarm
+  if (alarm_wheel) {
+    dump_context_t context = {fd, just_now_ms};
+    timer_wheel_foreach(alarm_wheel, dump_wheel_entry, &context);
+    return;
+  }
   for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
        node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
-    alarm_stats_t* stats = &alarm->stats;
+    dump_alarm(fd, (alarm_t*)list_node(node), just_now_ms);
+  }
+}
 
-    dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
-            (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
+static void dump_alarm(int fd, alarm_t* alarm, uint64_t just_now_ms) {
+  alarm_stats_t* stats = &alarm->stats;
 
-    dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
-            "    Action counts (sched/resched/exec/cancel)",
-            stats->scheduled_count, stats->rescheduled_count,
-            stats->total_updates, stats->canceled_count);
+  dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
+          (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
 
-    dprintf(fd, "%-51s: %zu / %zu\n",
-            "    Deviation counts (overdue/premature)",
-            stats->overdue_scheduling.count, stats->premature_scheduling.count);
+  dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
+          "    Action counts (sched/resched/exec/cancel)",
+          stats->scheduled_count, stats->rescheduled_count,
+          stats->total_updates, stats->canceled_count);
 
-    dprintf(fd, "%-51s: %llu / %llu / %lld\n",
-            "    Time in ms (since creation/interval/remaining)",
-            (unsigned long long)(just_now_ms - alarm->creation_time_ms),
-            (unsigned long long)alarm->period_ms,
-            (long long)(alarm->deadline_ms - just_now_ms));
+  dprintf(fd, "%-51s: %zu / %zu\n",
+          "    Deviation counts (overdue/premature)",
+          stats->overdue_scheduling.count, stats->premature_scheduling.count);
 
-    dump_stat(fd, &stats->overdue_scheduling,
-              "    Overdue scheduling time in ms (total/max/avg)");
+  dprintf(fd, "%-51s: %llu / %llu / %lld\n",
+          "    Time in ms (since creation/interval/remaining)",
+          (unsigned long long)(just_now_ms - alarm->creation_time_ms),
+          (unsigned long long)alarm->period_ms,
+          (long long)(alarm->deadline_ms - just_now_ms));
 
-    dump_stat(fd, &stats->premature_scheduling,
-              "    Premature scheduling time in ms (total/max/avg)");
+  dump_stat(fd, &stats->overdue_scheduling,
+            "    Overdue scheduling time in ms (total/max/avg)");
 
-    dprintf(fd, "\n");
-  }
+  dump_stat(fd, &stats->premature_scheduling,
+            "    Premature scheduling time in ms (total/max/avg)");
+
+  dprintf(fd, "\n");
 }
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_allocation_tags"
+
+#include "osi/include/allocation_tags.h"
+
+#include <base/logging.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/properties.h"
+
+namespace {
+
+constexpr char kAllocationTagsProperty[] = "persist.bluetooth.allocation_tags";
+
+// Kept in front of each allocation. The header is a multiple of the maximum
+// alignment so that the allocation stays aligned.
+struct tag_header_t {
+  size_t size;
+  allocation_tag_t tag;
+};
+constexpr size_t kHeaderSize = 16;
+static_assert(sizeof(tag_header_t) <= kHeaderSize,
+              "The tag header does not fit in front of the allocation");
+static_assert(kHeaderSize % alignof(max_align_t) == 0,
+              "The tag header would misalign the allocation");
+
+// The counters are only updated with relaxed atomics, so that tagging costs
+// no lock. A dump may see the counters of a tag from slightly different times.
+struct tag_stats_t {
+  std::atomic<size_t> live_bytes;
+  std::atomic<size_t> live_count;
+  std::atomic<size_t> peak_bytes;
+  std::atomic<size_t> total_count;
+};
+
+const char* const kTagNames[ALLOCATION_TAG_MAX] = {
+    "none", "dm", "sdp", "gatt", "a2dp", "avrcp", "hfp", "hid", "pan", "socket",
+};
+
+std::once_flag init_flag;
+bool enabled = false;
+tag_stats_t stats[ALLOCATION_TAG_MAX];
+thread_local allocation_tag_t current_tag = ALLOCATION_TAG_NONE;
+
+void init() {
+  enabled = osi_property_get_bool(kAllocationTagsProperty, false);
+}
+
+bool is_enabled() {
+  std::call_once(init_flag, init);
+  return enabled;
+}
+
+void update_peak(tag_stats_t& tag_stats, size_t live_bytes) {
+  size_t peak = tag_stats.peak_bytes.load(std::memory_order_relaxed);
+  while (live_bytes > peak &&
+         !tag_stats.peak_bytes.compare_exchange_weak(
+             peak, live_bytes, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+// Test function only. Do not call in the normal course of operations, as it
+// changes the layout of allocations.
+void allocation_tags_enable_for_testing(bool enable) {
+  std::call_once(init_flag, [] {});
+  enabled = enable;
+  for (auto& tag_stats : stats) {
+    tag_stats.live_bytes = 0;
+    tag_stats.live_count = 0;
+    tag_stats.peak_bytes = 0;
+    tag_stats.total_count = 0;
+  }
+}
+
+size_t allocation_tags_resize(size_t size) {
+  return is_enabled() ? size + kHeaderSize : size;
+}
+
+void* allocation_tags_notify_alloc(void* ptr, size_t size) {
+  if (!is_enabled() || ptr == NULL) return ptr;
+
+  tag_header_t* header = static_cast<tag_header_t*>(ptr);
+  header->size = size;
+  header->tag = current_tag;
+
+  tag_stats_t& tag_stats = stats[header->tag];
+  size_t live_bytes =
+      tag_stats.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  tag_stats.live_count.fetch_add(1, std::memory_order_relaxed);
+  tag_stats.total_count.fetch_add(1, std::memory_order_relaxed);
+  update_peak(tag_stats, live_bytes);
+
+  return static_cast<char*>(ptr) + kHeaderSize;
+}
+
+void* allocation_tags_notify_free(void* ptr) {
+  if (!is_enabled() || ptr == NULL) return ptr;
+
+  tag_header_t* header =
+      reinterpret_cast<tag_header_t*>(static_cast<char*>(ptr) - kHeaderSize);
+  CHECK(header->tag < ALLOCATION_TAG_MAX);
+
+  tag_stats_t& tag_stats = stats[header->tag];
+  tag_stats.live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+  tag_stats.live_count.fetch_sub(1, std::memory_order_relaxed);
+
+  return header;
+}
+
+allocation_tag_t allocation_tags_set_current(allocation_tag_t tag) {
+  allocation_tag_t previous = current_tag;
+  current_tag = tag;
+  return previous;
+}
+
+bool allocation_tags_get_stats(allocation_tag_t tag,
+                               allocation_tag_stats_t* tag_stats) {
+  if (!is_enabled() || tag >= ALLOCATION_TAG_MAX) return false;
+
+  const tag_stats_t& counters = stats[tag];
+  tag_stats->live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+  tag_stats->live_count = counters.live_count.load(std::memory_order_relaxed);
+  tag_stats->peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed);
+  tag_stats->total_count = counters.total_count.load(std::memory_order_relaxed);
+  return true;
+}
+
+void allocation_tags_debug_dump(int fd) {
+  if (!is_enabled()) {
+    dprintf(fd, "  Allocation tags disabled (%s)\n", kAllocationTagsProperty);
+    return;
+  }
+
+  dprintf(fd,
+          "  Allocations by tag (live octets / live / peak octets / all):\n");
+  for (int tag = 0; tag < ALLOCATION_TAG_MAX; tag++) {
+    allocation_tag_stats_t tag_stats;
+    allocation_tags_get_stats(static_cast<allocation_tag_t>(tag), &tag_stats);
+    if (tag_stats.total_count == 0) continue;
+    dprintf(fd, "    %-8s: %zu / %zu / %zu / %zu\n", kTagNames[tag],
+            tag_stats.live_bytes, tag_stats.live_count, tag_stats.peak_bytes,
+            tag_stats.total_count);
+  }
+}
@@ -19,19 +19,40 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "osi/include/allocation_tags.h"
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/slab_pool.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
-char* osi_strdup(const char* str) {
-  size_t size = strlen(str) + 1;  // + 1 for the null terminator
-  size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = malloc(real_size);
+// Serve small and BT_HDR sized requests from the slab pool and everything
+// else from the system allocator.
+static void* raw_alloc(size_t real_size) {
+  void* ptr = slab_pool_alloc(real_size);
+  if (ptr == NULL) ptr = malloc(real_size);
   CHECK(ptr);
+  return ptr;
+}
+
+static void raw_free(void* ptr) {
+  if (!slab_pool_free(ptr)) free(ptr);
+}
+
+// Returns |size| uninitialized bytes, behind the allocation tag header and
+// between the allocation tracker canaries when they are enabled.
+static void* tagged_alloc(size_t size) {
+  size_t tagged_size = allocation_tags_resize(size);
+  size_t real_size = allocation_tracker_resize_for_canary(tagged_size);
+  void* ptr = raw_alloc(real_size);
+  return allocation_tags_notify_alloc(
+      allocation_tracker_notify_alloc(alloc_allocator_id, ptr, tagged_size),
+      size);
+}
 
-  char* new_string = static_cast<char*>(
-      allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size));
+char* osi_strdup(const char* str) {
+  size_t size = strlen(str) + 1;  // + 1 for the null terminator
+  char* new_string = static_cast<char*>(tagged_alloc(size));
   if (!new_string) return NULL;
 
   memcpy(new_string, str, size);
@@ -42,12 +63,7 @@ char* osi_strndup(const char* str, size_t len) {
   size_t size = strlen(str);
   if (len < size) size = len;
 
-  size_t real_size = allocation_tracker_resize_for_canary(size + 1);
-  void* ptr = malloc(real_size);
-  CHECK(ptr);
-
-  char* new_string = static_cast<char*>(
-      allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size + 1));
+  char* new_string = static_cast<char*>(tagged_alloc(size + 1));
   if (!new_string) return NULL;
 
   memcpy(new_string, str, size);
@@ -57,22 +73,19 @@ char* osi_strndup(const char* str, size_t len) {
 
 void* osi_malloc(size_t size) {
   CHECK(static_cast<ssize_t>(size) >= 0);
-  size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = malloc(real_size);
-  CHECK(ptr);
-  return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
+  return tagged_alloc(size);
 }
 
 void* osi_calloc(size_t size) {
   CHECK(static_cast<ssize_t>(size) >= 0);
-  size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = calloc(1, real_size);
-  CHECK(ptr);
-  return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
+  void* ptr = tagged_alloc(size);
+  memset(ptr, 0, size);
+  return ptr;
 }
 
 void osi_free(void* ptr) {
-  free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
+  raw_free(allocation_tracker_notify_free(alloc_allocator_id,
+                                          allocation_tags_notify_free(ptr)));
 }
 
 void osi_free_and_reset(void** p_ptr) {
@@ -32,14 +32,12 @@
 #include <unistd.h>
 
 #include <sstream>
-#include <type_traits>
 
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.Find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
@@ -47,9 +45,7 @@ void section_t::Set(std::string key, std::string value) {
 }
 
 std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.Find(key);
 }
 
 bool section_t::Has(const std::string& key) {
@@ -57,9 +53,7 @@ bool section_t::Has(const std::string& key) {
 }
 
 std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.Find(section);
 }
 
 bool config_t::Has(const std::string& key) {
@@ -68,26 +62,16 @@ bool config_t::Has(const std::string& key) {
 
 static bool config_parse(FILE* fp, config_t* config);
 
-template <typename T,
-          class = typename std::enable_if<std::is_same<
-              config_t, typename std::remove_const<T>::type>::value>>
-static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
-}
-
 static const entry_t* entry_find(const config_t& config,
                                  const std::string& section,
                                  const std::string& key) {
-  auto sec = section_find(config, section);
+  auto sec = config.sections.Find(section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.Find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -140,7 +124,7 @@ std::unique_ptr<config_t> config_new_clone(const config_t& src) {
 }
 
 bool config_has_section(const config_t& config, const std::string& section) {
-  return (section_find(config, section) != config.sections.end());
+  return (config.sections.Find(section) != config.sections.end());
 }
 
 bool config_has_key(const config_t& config, const std::string& section,
@@ -208,7 +192,7 @@ void config_set_string(config_t* config, const std::string& section,
                        const std::string& key, const std::string& value) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.Find(section);
   if (sec == config->sections.end()) {
     config->sections.emplace_back(section_t{.name = section});
     sec = std::prev(config->sections.end());
@@ -223,20 +207,13 @@ void config_set_string(config_t* config, const std::string& section,
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
-  }
-
-  sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
+  sec->Set(key, std::move(value_no_newline));
 }
 
 bool config_remove_section(config_t* config, const std::string& section) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.Find(section);
   if (sec == config->sections.end()) return false;
 
   config->sections.erase(sec);
@@ -246,18 +223,14 @@ bool config_remove_section(config_t* config, const std::string& section) {
 bool config_remove_key(config_t* config, const std::string& section,
                        const std::string& key) {
   CHECK(config);
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.Find(section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.Find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool config_save(const config_t& config, const std::string& filename) {
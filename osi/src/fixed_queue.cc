@@ -17,8 +17,11 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#include <errno.h>
+#include <poll.h>
 #include <string.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
@@ -28,8 +31,19 @@
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
+// Bounded ring used by queues created with |fixed_queue_new_spsc|. |head| is
+// only written by the consumer and |tail| only by the producer; |count| is
+// what the two sides synchronize on.
+typedef struct {
+  void** slots;
+  std::atomic<size_t> count;
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+} spsc_ring_t;
+
 typedef struct fixed_queue_t {
   list_t* list;
+  spsc_ring_t* ring;
   semaphore_t* enqueue_sem;
   semaphore_t* dequeue_sem;
   std::mutex* mutex;
@@ -41,6 +55,9 @@ typedef struct fixed_queue_t {
 } fixed_queue_t;
 
 static void internal_dequeue_ready(void* context);
+static bool spsc_try_enqueue(fixed_queue_t* queue, void* data);
+static void* spsc_try_dequeue(fixed_queue_t* queue);
+static void wait_for_fd(int fd);
 
 fixed_queue_t* fixed_queue_new(size_t capacity) {
   fixed_queue_t* ret =
@@ -65,15 +82,56 @@ error:
   return NULL;
 }
 
+fixed_queue_t* fixed_queue_new_spsc(size_t capacity) {
+  CHECK(capacity > 0);
+  CHECK(capacity <= SIZE_MAX / sizeof(void*));
+
+  fixed_queue_t* ret =
+      static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
+
+  ret->mutex = new std::mutex;
+  ret->capacity = capacity;
+
+  ret->ring = new spsc_ring_t();
+  ret->ring->slots =
+      static_cast<void**>(osi_calloc(sizeof(void*) * capacity));
+
+  // In SPSC mode the semaphores only carry a single token each: the enqueue
+  // fd is readable while the queue is not full and the dequeue fd while it is
+  // not empty.
+  ret->enqueue_sem = semaphore_new(1);
+  if (!ret->enqueue_sem) goto error;
+
+  ret->dequeue_sem = semaphore_new(0);
+  if (!ret->dequeue_sem) goto error;
+
+  return ret;
+
+error:
+  fixed_queue_free(ret, NULL);
+  return NULL;
+}
+
 void fixed_queue_free(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
   if (!queue) return;
 
   fixed_queue_unregister_dequeue(queue);
 
-  if (free_cb)
+  if (queue->ring) {
+    if (free_cb) {
+      spsc_ring_t* ring = queue->ring;
+      size_t count = ring->count.load(std::memory_order_acquire);
+      size_t head = ring->head.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < count; i++)
+        free_cb(ring->slots[(head + i) % queue->capacity]);
+    }
+    osi_free(queue->ring->slots);
+    delete queue->ring;
+  } else if (free_cb) {
     for (const list_node_t* node = list_begin(queue->list);
          node != list_end(queue->list); node = list_next(node))
       free_cb(list_node(node));
+  }
 
   list_free(queue->list);
   semaphore_free(queue->enqueue_sem);
@@ -95,6 +153,8 @@ void fixed_queue_flush(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
 
 bool fixed_queue_is_empty(fixed_queue_t* queue) {
   if (queue == NULL) return true;
+  if (queue->ring)
+    return queue->ring->count.load(std::memory_order_acquire) == 0;
 
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list);
@@ -102,6 +162,7 @@ bool fixed_queue_is_empty(fixed_queue_t* queue) {
 
 size_t fixed_queue_length(fixed_queue_t* queue) {
   if (queue == NULL) return 0;
+  if (queue->ring) return queue->ring->count.load(std::memory_order_acquire);
 
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_length(queue->list);
@@ -117,6 +178,12 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    while (!spsc_try_enqueue(queue, data))
+      wait_for_fd(semaphore_get_fd(queue->enqueue_sem));
+    return;
+  }
+
   semaphore_wait(queue->enqueue_sem);
 
   {
@@ -130,6 +197,13 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_dequeue(fixed_queue_t* queue) {
   CHECK(queue != NULL);
 
+  if (queue->ring) {
+    void* data;
+    while ((data = spsc_try_dequeue(queue)) == NULL)
+      wait_for_fd(semaphore_get_fd(queue->dequeue_sem));
+    return data;
+  }
+
   semaphore_wait(queue->dequeue_sem);
 
   void* ret = NULL;
@@ -148,6 +222,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) return spsc_try_enqueue(queue, data);
+
   if (!semaphore_try_wait(queue->enqueue_sem)) return false;
 
   {
@@ -162,6 +238,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) return spsc_try_dequeue(queue);
+
   if (!semaphore_try_wait(queue->dequeue_sem)) return NULL;
 
   void* ret = NULL;
@@ -179,6 +257,12 @@ void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    spsc_ring_t* ring = queue->ring;
+    if (ring->count.load(std::memory_order_acquire) == 0) return NULL;
+    return ring->slots[ring->head.load(std::memory_order_relaxed)];
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_front(queue->list);
 }
@@ -186,12 +270,20 @@ void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    spsc_ring_t* ring = queue->ring;
+    if (ring->count.load(std::memory_order_acquire) == 0) return NULL;
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    return ring->slots[(tail + queue->capacity - 1) % queue->capacity];
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_back(queue->list);
 }
 
 void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
   if (queue == NULL) return NULL;
+  CHECK(queue->ring == NULL) << "not supported by SPSC queues";
 
   bool removed = false;
   {
@@ -212,6 +304,7 @@ void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
 
 list_t* fixed_queue_get_list(fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL) << "not supported by SPSC queues";
 
   // NOTE: Using the list in this way is not thread-safe.
   // Using this list in any context where threads can call other functions
@@ -260,3 +353,41 @@ static void internal_dequeue_ready(void* context) {
   fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
   queue->dequeue_ready(queue, queue->dequeue_context);
 }
+
+static bool spsc_try_enqueue(fixed_queue_t* queue, void* data) {
+  spsc_ring_t* ring = queue->ring;
+  if (ring->count.load(std::memory_order_acquire) == queue->capacity)
+    return false;
+
+  size_t tail = ring->tail.load(std::memory_order_relaxed);
+  ring->slots[tail] = data;
+  ring->tail.store((tail + 1) % queue->capacity, std::memory_order_relaxed);
+
+  size_t previous = ring->count.fetch_add(1, std::memory_order_acq_rel);
+  if (previous == 0) semaphore_post(queue->dequeue_sem);
+  if (previous + 1 == queue->capacity) semaphore_wait(queue->enqueue_sem);
+  return true;
+}
+
+static void* spsc_try_dequeue(fixed_queue_t* queue) {
+  spsc_ring_t* ring = queue->ring;
+  if (ring->count.load(std::memory_order_acquire) == 0) return NULL;
+
+  size_t head = ring->head.load(std::memory_order_relaxed);
+  void* data = ring->slots[head];
+  ring->head.store((head + 1) % queue->capacity, std::memory_order_relaxed);
+
+  size_t previous = ring->count.fetch_sub(1, std::memory_order_acq_rel);
+  if (previous == queue->capacity) semaphore_post(queue->enqueue_sem);
+  if (previous == 1) semaphore_wait(queue->dequeue_sem);
+  return data;
+}
+
+// Blocks until |fd| is readable without consuming the semaphore token.
+static void wait_for_fd(int fd) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  OSI_NO_INTR(poll(&pfd, 1, -1));
+}
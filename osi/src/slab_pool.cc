@@ -0,0 +1,250 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_slab_pool"
+
+#include "osi/include/slab_pool.h"
+
+#include <base/logging.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "internal_include/bt_target.h"
+#include "osi/include/log.h"
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SLAB_POOL_DISABLED 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define SLAB_POOL_DISABLED 1
+#endif
+
+namespace {
+
+// Extra room on top of the payload for the allocation tracker canaries and the
+// allocation tag header.
+constexpr size_t kCanaryRoom = 32;
+
+constexpr size_t kNumClasses = 4;
+
+// The largest class fits a full BT_DEFAULT_BUFFER_SIZE buffer, which is what
+// the HCI buffer allocator hands out for every ACL/SCO/ISO packet.
+constexpr size_t kClassBlockSize[kNumClasses] = {
+    64, 256, 1024, ((BT_DEFAULT_BUFFER_SIZE + kCanaryRoom + 15) / 16) * 16};
+constexpr size_t kClassBlockCount[kNumClasses] = {1024, 512, 256, 128};
+
+// Number of free blocks kept by each thread per class, and the number of
+// blocks moved between a thread cache and the shared free list at once.
+constexpr size_t kThreadCacheSize = 32;
+constexpr size_t kThreadCacheBatch = kThreadCacheSize / 2;
+
+struct free_block_t {
+  free_block_t* next;
+};
+
+struct slab_class_t {
+  uint8_t* base;
+  size_t block_size;
+  size_t block_count;
+
+  std::mutex lock;
+  free_block_t* free_list;  // Shared free list, guarded by |lock|
+  size_t next_unused;       // Index of the first never used block
+
+  std::atomic<size_t> hits;
+  std::atomic<size_t> misses;
+  std::atomic<size_t> in_use;
+  std::atomic<size_t> high_water;
+};
+
+slab_class_t classes[kNumClasses];
+std::once_flag init_flag;
+std::atomic<uintptr_t> region_begin(0);
+std::atomic<uintptr_t> region_end(0);
+
+void slab_pool_init() {
+  size_t total = 0;
+  for (size_t i = 0; i < kNumClasses; i++)
+    total += kClassBlockSize[i] * kClassBlockCount[i];
+
+  // Pages are only backed once a block living on them is handed out.
+  void* region = mmap(nullptr, total, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (region == MAP_FAILED) {
+    LOG_ERROR("%s unable to reserve %zu bytes, slab pool disabled", __func__,
+              total);
+    return;
+  }
+
+  uint8_t* base = static_cast<uint8_t*>(region);
+  for (size_t i = 0; i < kNumClasses; i++) {
+    classes[i].base = base;
+    classes[i].block_size = kClassBlockSize[i];
+    classes[i].block_count = kClassBlockCount[i];
+    classes[i].free_list = nullptr;
+    classes[i].next_unused = 0;
+    base += kClassBlockSize[i] * kClassBlockCount[i];
+  }
+
+  region_begin.store(reinterpret_cast<uintptr_t>(region),
+                     std::memory_order_release);
+  region_end.store(reinterpret_cast<uintptr_t>(base),
+                   std::memory_order_release);
+}
+
+size_t class_for_size(size_t size) {
+  for (size_t i = 0; i < kNumClasses; i++) {
+    if (size <= kClassBlockSize[i]) return i;
+  }
+  return kNumClasses;
+}
+
+size_t class_for_block(uintptr_t address) {
+  for (size_t i = kNumClasses; i > 0; i--) {
+    if (address >= reinterpret_cast<uintptr_t>(classes[i - 1].base))
+      return i - 1;
+  }
+  return 0;
+}
+
+// Moves up to |count| blocks from the shared free list (or the never used
+// tail of the class) into |out|. Returns the number of blocks moved.
+size_t refill(slab_class_t& slab, void** out, size_t count) {
+  std::lock_guard<std::mutex> lock(slab.lock);
+  size_t moved = 0;
+  while (moved < count && slab.free_list != nullptr) {
+    out[moved++] = slab.free_list;
+    slab.free_list = slab.free_list->next;
+  }
+  while (moved < count && slab.next_unused < slab.block_count) {
+    out[moved++] = slab.base + slab.next_unused * slab.block_size;
+    slab.next_unused++;
+  }
+  return moved;
+}
+
+void release(slab_class_t& slab, void** blocks, size_t count) {
+  if (count == 0) return;
+  std::lock_guard<std::mutex> lock(slab.lock);
+  for (size_t i = 0; i < count; i++) {
+    free_block_t* block = static_cast<free_block_t*>(blocks[i]);
+    block->next = slab.free_list;
+    slab.free_list = block;
+  }
+}
+
+struct thread_cache_t {
+  void* blocks[kNumClasses][kThreadCacheSize];
+  size_t count[kNumClasses] = {};
+
+  ~thread_cache_t() {
+    for (size_t i = 0; i < kNumClasses; i++) {
+      release(classes[i], blocks[i], count[i]);
+      count[i] = 0;
+    }
+  }
+};
+
+thread_local thread_cache_t thread_cache;
+
+void update_high_water(slab_class_t& slab, size_t in_use) {
+  size_t high = slab.high_water.load(std::memory_order_relaxed);
+  while (in_use > high && !slab.high_water.compare_exchange_weak(
+                              high, in_use, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+void* slab_pool_alloc(size_t size) {
+#if defined(SLAB_POOL_DISABLED)
+  return NULL;
+#else
+  size_t index = class_for_size(size);
+  if (index == kNumClasses) return NULL;
+
+  std::call_once(init_flag, slab_pool_init);
+  if (region_begin.load(std::memory_order_acquire) == 0) return NULL;
+
+  slab_class_t& slab = classes[index];
+  thread_cache_t& cache = thread_cache;
+  if (cache.count[index] == 0) {
+    cache.count[index] = refill(slab, cache.blocks[index], kThreadCacheBatch);
+    if (cache.count[index] == 0) {
+      slab.misses.fetch_add(1, std::memory_order_relaxed);
+      return NULL;
+    }
+  }
+
+  void* block = cache.blocks[index][--cache.count[index]];
+  slab.hits.fetch_add(1, std::memory_order_relaxed);
+  update_high_water(slab,
+                    slab.in_use.fetch_add(1, std::memory_order_relaxed) + 1);
+  return block;
+#endif
+}
+
+bool slab_pool_owns(const void* ptr) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  return address >= region_begin.load(std::memory_order_acquire) &&
+         address < region_end.load(std::memory_order_acquire);
+}
+
+bool slab_pool_free(void* ptr) {
+  if (ptr == NULL || !slab_pool_owns(ptr)) return false;
+
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  size_t index = class_for_block(address);
+  slab_class_t& slab = classes[index];
+  CHECK((address - reinterpret_cast<uintptr_t>(slab.base)) % slab.block_size ==
+        0);
+
+  slab.in_use.fetch_sub(1, std::memory_order_relaxed);
+
+  thread_cache_t& cache = thread_cache;
+  if (cache.count[index] == kThreadCacheSize) {
+    cache.count[index] -= kThreadCacheBatch;
+    release(slab, &cache.blocks[index][cache.count[index]], kThreadCacheBatch);
+  }
+  cache.blocks[index][cache.count[index]++] = ptr;
+  return true;
+}
+
+void slab_pool_debug_dump(int fd) {
+  dprintf(fd, "  Slab pool size classes (hits / misses / in use / peak):\n");
+  if (region_begin.load(std::memory_order_acquire) == 0) {
+    dprintf(fd, "    Not in use\n");
+    return;
+  }
+
+  for (size_t i = 0; i < kNumClasses; i++) {
+    const slab_class_t& slab = classes[i];
+    dprintf(fd, "    %5zu bytes x %4zu : %zu / %zu / %zu / %zu\n",
+            slab.block_size, slab.block_count,
+            slab.hits.load(std::memory_order_relaxed),
+            slab.misses.load(std::memory_order_relaxed),
+            slab.in_use.load(std::memory_order_relaxed),
+            slab.high_water.load(std::memory_order_relaxed));
+  }
+}
@@ -0,0 +1,286 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "osi/include/timer_wheel.h"
+
+#include <base/logging.h>
+
+#include "osi/include/allocator.h"
+
+#define WHEEL_LEVEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_LEVEL_BITS)
+#define WHEEL_LEVELS 6
+#define WHEEL_SLOT_MASK ((uint64_t)(WHEEL_SLOTS - 1))
+
+// Deadlines too far in the future for the last level, unsorted.
+#define OVERFLOW_BUCKET (WHEEL_LEVELS * WHEEL_SLOTS)
+// Deadlines which are already behind the wheel time, unsorted.
+#define EXPIRED_BUCKET (OVERFLOW_BUCKET + 1)
+#define NUM_BUCKETS (EXPIRED_BUCKET + 1)
+
+typedef struct {
+  timer_wheel_entry_t* first;
+  timer_wheel_entry_t* last;
+} bucket_t;
+
+struct timer_wheel_t {
+  uint64_t now_ms;
+  size_t size;
+  bucket_t buckets[NUM_BUCKETS];
+  uint64_t occupied[WHEEL_LEVELS];  // One bit per non-empty slot
+
+  bool front_valid;
+  timer_wheel_entry_t* front;
+};
+
+static void bucket_append(timer_wheel_t* wheel, int bucket,
+                          timer_wheel_entry_t* entry);
+static void bucket_unlink(timer_wheel_t* wheel, timer_wheel_entry_t* entry);
+static int bucket_for_deadline(const timer_wheel_t* wheel,
+                               uint64_t deadline_ms);
+static timer_wheel_entry_t* earliest_in_bucket(const bucket_t* bucket);
+static void take_bucket(timer_wheel_t* wheel, int bucket, bucket_t* out);
+
+void timer_wheel_entry_init(timer_wheel_entry_t* entry, void* data) {
+  CHECK(entry != NULL);
+
+  entry->prev = NULL;
+  entry->next = NULL;
+  entry->deadline_ms = 0;
+  entry->data = data;
+  entry->bucket = -1;
+}
+
+timer_wheel_t* timer_wheel_new(uint64_t now_ms) {
+  timer_wheel_t* wheel =
+      static_cast<timer_wheel_t*>(osi_calloc(sizeof(timer_wheel_t)));
+  wheel->now_ms = now_ms;
+  wheel->front_valid = true;
+  return wheel;
+}
+
+void timer_wheel_free(timer_wheel_t* wheel) {
+  if (!wheel) return;
+
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    timer_wheel_entry_t* entry = wheel->buckets[i].first;
+    while (entry != NULL) {
+      timer_wheel_entry_t* next = entry->next;
+      entry->prev = entry->next = NULL;
+      entry->bucket = -1;
+      entry = next;
+    }
+  }
+  osi_free(wheel);
+}
+
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_entry_t* entry,
+                        uint64_t deadline_ms) {
+  CHECK(wheel != NULL);
+  CHECK(entry != NULL);
+
+  timer_wheel_remove(wheel, entry);
+
+  entry->deadline_ms = deadline_ms;
+  bucket_append(wheel, bucket_for_deadline(wheel, deadline_ms), entry);
+  wheel->size++;
+
+  if (wheel->front_valid &&
+      (wheel->front == NULL || deadline_ms < wheel->front->deadline_ms))
+    wheel->front = entry;
+}
+
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_entry_t* entry) {
+  CHECK(wheel != NULL);
+  CHECK(entry != NULL);
+
+  if (entry->bucket < 0) return;
+
+  bucket_unlink(wheel, entry);
+  wheel->size--;
+
+  if (wheel->front == entry) {
+    wheel->front = NULL;
+    wheel->front_valid = (wheel->size == 0);
+  }
+}
+
+bool timer_wheel_is_queued(const timer_wheel_entry_t* entry) {
+  CHECK(entry != NULL);
+  return entry->bucket >= 0;
+}
+
+timer_wheel_entry_t* timer_wheel_peek(timer_wheel_t* wheel) {
+  CHECK(wheel != NULL);
+
+  if (wheel->front_valid) return wheel->front;
+
+  timer_wheel_entry_t* front =
+      earliest_in_bucket(&wheel->buckets[EXPIRED_BUCKET]);
+
+  // Every entry on a level is earlier than any entry on the levels above it,
+  // and within a level the lowest occupied slot holds the earliest entries.
+  for (int level = 0; front == NULL && level < WHEEL_LEVELS; level++) {
+    if (wheel->occupied[level] == 0) continue;
+    int slot = __builtin_ctzll(wheel->occupied[level]);
+    front = earliest_in_bucket(&wheel->buckets[level * WHEEL_SLOTS + slot]);
+  }
+
+  if (front == NULL)
+    front = earliest_in_bucket(&wheel->buckets[OVERFLOW_BUCKET]);
+
+  wheel->front = front;
+  wheel->front_valid = true;
+  return front;
+}
+
+void timer_wheel_advance(timer_wheel_t* wheel, uint64_t now_ms) {
+  CHECK(wheel != NULL);
+
+  if (now_ms <= wheel->now_ms) return;
+
+  // Collect the entries whose position depends on the part of the wheel time
+  // that is changing, then place them again relative to the new time.
+  bucket_t moved = {NULL, NULL};
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    int shift = level * WHEEL_LEVEL_BITS;
+    if (wheel->occupied[level] == 0) continue;
+
+    if ((now_ms >> (shift + WHEEL_LEVEL_BITS)) !=
+        (wheel->now_ms >> (shift + WHEEL_LEVEL_BITS))) {
+      for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+        take_bucket(wheel, level * WHEEL_SLOTS + slot, &moved);
+      continue;
+    }
+
+    int from = (wheel->now_ms >> shift) & WHEEL_SLOT_MASK;
+    int to = (now_ms >> shift) & WHEEL_SLOT_MASK;
+    for (int slot = from; slot <= to; slot++)
+      take_bucket(wheel, level * WHEEL_SLOTS + slot, &moved);
+  }
+
+  if ((now_ms >> (WHEEL_LEVELS * WHEEL_LEVEL_BITS)) !=
+      (wheel->now_ms >> (WHEEL_LEVELS * WHEEL_LEVEL_BITS)))
+    take_bucket(wheel, OVERFLOW_BUCKET, &moved);
+
+  wheel->now_ms = now_ms;
+
+  timer_wheel_entry_t* entry = moved.first;
+  while (entry != NULL) {
+    timer_wheel_entry_t* next = entry->next;
+    entry->prev = entry->next = NULL;
+    bucket_append(wheel, bucket_for_deadline(wheel, entry->deadline_ms),
+                  entry);
+    entry = next;
+  }
+}
+
+size_t timer_wheel_size(const timer_wheel_t* wheel) {
+  CHECK(wheel != NULL);
+  return wheel->size;
+}
+
+void timer_wheel_foreach(const timer_wheel_t* wheel,
+                         timer_wheel_iter_cb callback, void* context) {
+  CHECK(wheel != NULL);
+  CHECK(callback != NULL);
+
+  for (int i = 0; i < NUM_BUCKETS; i++) {
+    for (timer_wheel_entry_t* entry = wheel->buckets[i].first; entry != NULL;
+         entry = entry->next) {
+      if (!callback(entry, context)) return;
+    }
+  }
+}
+
+static int bucket_for_deadline(const timer_wheel_t* wheel,
+                               uint64_t deadline_ms) {
+  if (deadline_ms < wheel->now_ms) return EXPIRED_BUCKET;
+
+  uint64_t diff = deadline_ms ^ wheel->now_ms;
+  int level = 0;
+  if (diff != 0) level = (63 - __builtin_clzll(diff)) / WHEEL_LEVEL_BITS;
+  if (level >= WHEEL_LEVELS) return OVERFLOW_BUCKET;
+
+  int slot = (deadline_ms >> (level * WHEEL_LEVEL_BITS)) & WHEEL_SLOT_MASK;
+  return level * WHEEL_SLOTS + slot;
+}
+
+static void bucket_append(timer_wheel_t* wheel, int bucket,
+                          timer_wheel_entry_t* entry) {
+  bucket_t* b = &wheel->buckets[bucket];
+  entry->bucket = bucket;
+  entry->next = NULL;
+  entry->prev = b->last;
+  if (b->last != NULL)
+    b->last->next = entry;
+  else
+    b->first = entry;
+  b->last = entry;
+
+  if (bucket < OVERFLOW_BUCKET)
+    wheel->occupied[bucket / WHEEL_SLOTS] |= 1ULL << (bucket % WHEEL_SLOTS);
+}
+
+static void bucket_unlink(timer_wheel_t* wheel, timer_wheel_entry_t* entry) {
+  int bucket = entry->bucket;
+  bucket_t* b = &wheel->buckets[bucket];
+  if (entry->prev != NULL)
+    entry->prev->next = entry->next;
+  else
+    b->first = entry->next;
+  if (entry->next != NULL)
+    entry->next->prev = entry->prev;
+  else
+    b->last = entry->prev;
+
+  entry->prev = entry->next = NULL;
+  entry->bucket = -1;
+
+  if (b->first == NULL && bucket < OVERFLOW_BUCKET)
+    wheel->occupied[bucket / WHEEL_SLOTS] &= ~(1ULL << (bucket % WHEEL_SLOTS));
+}
+
+// Returns the first entry with the smallest deadline in |bucket|, so that
+// entries with equal deadlines keep their insertion order.
+static timer_wheel_entry_t* earliest_in_bucket(const bucket_t* bucket) {
+  timer_wheel_entry_t* earliest = bucket->first;
+  for (timer_wheel_entry_t* entry = bucket->first; entry != NULL;
+       entry = entry->next) {
+    if (entry->deadline_ms < earliest->deadline_ms) earliest = entry;
+  }
+  return earliest;
+}
+
+// Moves all entries of |bucket| to the end of |out|, keeping their order.
+static void take_bucket(timer_wheel_t* wheel, int bucket, bucket_t* out) {
+  bucket_t* b = &wheel->buckets[bucket];
+  if (b->first == NULL) return;
+
+  if (out->last != NULL) {
+    out->last->next = b->first;
+    b->first->prev = out->last;
+  } else {
+    out->first = b->first;
+  }
+  out->last = b->last;
+
+  b->first = b->last = NULL;
+  if (bucket < OVERFLOW_BUCKET)
+    wheel->occupied[bucket / WHEEL_SLOTS] &= ~(1ULL << (bucket % WHEEL_SLOTS));
+}
@@ -30,8 +30,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <condition_variable>
 #include <mutex>
 #include <string>
+#include <thread>
 
 #include "base/logging.h"
 #include "common/metrics.h"
@@ -58,10 +60,25 @@ static pthread_once_t initialized = PTHREAD_ONCE_INIT;
 static int wake_lock_fd = INVALID_FD;
 static int wake_unlock_fd = INVALID_FD;
 
+// Holders of the wakelock. The system wakelock is acquired by the first
+// holder, and released |hold_over_ms| after the last one is gone unless a new
+// holder comes first, so that bursts of nearby alarms share one
+// acquire/release pair.
+static std::mutex holders_mutex;
+static size_t holder_count = 0;
+static bool is_system_lock_held = false;
+static uint64_t hold_over_ms = 0;
+// Boot time the system wakelock is released at, 0 if no release is pending
+static uint64_t release_deadline_ms = 0;
+static std::condition_variable release_cv;
+static std::thread release_thread;
+static bool release_thread_stop = false;
+
 // Wakelock statistics for the "bluetooth_timer"
 typedef struct {
   bool is_acquired;
   size_t acquired_count;
+  size_t coalesced_count;
   size_t released_count;
   size_t acquired_errors;
   size_t released_errors;
@@ -91,6 +108,9 @@ static void wakelock_initialize_native(void);
 static void reset_wakelock_stats(void);
 static void update_wakelock_acquired_stats(bt_status_t acquired_status);
 static void update_wakelock_released_stats(bt_status_t released_status);
+static bool release_system_lock(void);
+static void release_thread_main(void);
+static uint64_t now_ms(void);
 
 void wakelock_set_os_callouts(bt_os_callouts_t* callouts) {
   wakelock_os_callouts = callouts;
@@ -101,6 +121,15 @@ void wakelock_set_os_callouts(bt_os_callouts_t* callouts) {
 bool wakelock_acquire(void) {
   pthread_once(&initialized, wakelock_initialize);
 
+  std::lock_guard<std::mutex> lock(holders_mutex);
+  if (is_system_lock_held) {
+    holder_count++;
+    release_deadline_ms = 0;
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    wakelock_stats.coalesced_count++;
+    return true;
+  }
+
   bt_status_t status = BT_STATUS_FAIL;
 
   if (is_native)
@@ -110,10 +139,14 @@ bool wakelock_acquire(void) {
 
   update_wakelock_acquired_stats(status);
 
-  if (status != BT_STATUS_SUCCESS)
+  if (status != BT_STATUS_SUCCESS) {
     LOG_ERROR("%s unable to acquire wake lock: %d", __func__, status);
+    return false;
+  }
 
-  return (status == BT_STATUS_SUCCESS);
+  holder_count++;
+  is_system_lock_held = true;
+  return true;
 }
 
 static bt_status_t wakelock_acquire_callout(void) {
@@ -147,6 +180,35 @@ static bt_status_t wakelock_acquire_native(void) {
 bool wakelock_release(void) {
   pthread_once(&initialized, wakelock_initialize);
 
+  std::lock_guard<std::mutex> lock(holders_mutex);
+  if (holder_count == 0) {
+    // Unbalanced release, the wakelock is already released or about to be
+    return true;
+  }
+  if (--holder_count > 0) return true;
+
+  if (hold_over_ms == 0) return release_system_lock();
+
+  release_deadline_ms = now_ms() + hold_over_ms;
+  if (!release_thread.joinable()) {
+    release_thread_stop = false;
+    release_thread = std::thread(release_thread_main);
+  }
+  release_cv.notify_one();
+  return true;
+}
+
+void wakelock_set_hold_over_ms(uint64_t ms) {
+  std::lock_guard<std::mutex> lock(holders_mutex);
+  hold_over_ms = ms;
+}
+
+// Releases the system wakelock, must be called with |holders_mutex| held
+static bool release_system_lock(void) {
+  release_deadline_ms = 0;
+  if (!is_system_lock_held) return true;
+  is_system_lock_held = false;
+
   bt_status_t status = BT_STATUS_FAIL;
 
   if (is_native)
@@ -159,6 +221,25 @@ bool wakelock_release(void) {
   return (status == BT_STATUS_SUCCESS);
 }
 
+// Releases the system wakelock once the hold-over after the last holder has
+// passed without a new holder
+static void release_thread_main(void) {
+  std::unique_lock<std::mutex> lock(holders_mutex);
+  while (!release_thread_stop) {
+    if (release_deadline_ms == 0) {
+      release_cv.wait(lock);
+      continue;
+    }
+    uint64_t just_now_ms = now_ms();
+    if (just_now_ms >= release_deadline_ms) {
+      release_system_lock();
+      continue;
+    }
+    release_cv.wait_for(
+        lock, std::chrono::milliseconds(release_deadline_ms - just_now_ms));
+  }
+}
+
 static bt_status_t wakelock_release_callout(void) {
   return static_cast<bt_status_t>(
       wakelock_os_callouts->release_wake_lock(WAKE_LOCK_ID));
@@ -209,9 +290,20 @@ static void wakelock_initialize_native(void) {
 }
 
 void wakelock_cleanup(void) {
-  if (wakelock_stats.is_acquired) {
-    LOG_ERROR("%s releasing wake lock as part of cleanup", __func__);
-    wakelock_release();
+  {
+    std::lock_guard<std::mutex> lock(holders_mutex);
+    release_thread_stop = true;
+  }
+  release_cv.notify_one();
+  if (release_thread.joinable()) release_thread.join();
+
+  {
+    std::lock_guard<std::mutex> lock(holders_mutex);
+    if (is_system_lock_held && release_deadline_ms == 0) {
+      LOG_ERROR("%s releasing wake lock as part of cleanup", __func__);
+    }
+    holder_count = 0;
+    release_system_lock();
   }
   wake_lock_path.clear();
   wake_unlock_path.clear();
@@ -241,6 +333,7 @@ static void reset_wakelock_stats(void) {
 
   wakelock_stats.is_acquired = false;
   wakelock_stats.acquired_count = 0;
+  wakelock_stats.coalesced_count = 0;
   wakelock_stats.released_count = 0;
   wakelock_stats.acquired_errors = 0;
   wakelock_stats.released_errors = 0;
@@ -326,6 +419,11 @@ static void update_wakelock_released_stats(bt_status_t released_status) {
 }
 
 void wakelock_debug_dump(int fd) {
+  uint64_t dump_hold_over_ms;
+  {
+    std::lock_guard<std::mutex> lock(holders_mutex);
+    dump_hold_over_ms = hold_over_ms;
+  }
   const uint64_t just_now_ms = now_ms();
 
   std::lock_guard<std::mutex> lock(stats_mutex);
@@ -349,11 +447,23 @@ void wakelock_debug_dump(int fd) {
   if (wakelock_stats.acquired_count > 0)
     avg_interval_ms = total_interval_ms / wakelock_stats.acquired_count;
 
+  const uint64_t run_time_ms =
+      just_now_ms - wakelock_stats.last_reset_timestamp_ms;
+  uint64_t acquired_per_minute = 0;
+  if (run_time_ms > 0)
+    acquired_per_minute = wakelock_stats.acquired_count * 60000 / run_time_ms;
+
   dprintf(fd, "\nBluetooth Wakelock Statistics:\n");
   dprintf(fd, "  Is acquired                    : %s\n",
           wakelock_stats.is_acquired ? "true" : "false");
   dprintf(fd, "  Acquired/released count        : %zu / %zu\n",
           wakelock_stats.acquired_count, wakelock_stats.released_count);
+  dprintf(fd, "  Release hold-over (ms)         : %llu\n",
+          (unsigned long long)dump_hold_over_ms);
+  dprintf(fd, "  Coalesced acquire count        : %zu\n",
+          wakelock_stats.coalesced_count);
+  dprintf(fd, "  Acquired count per minute      : %llu\n",
+          (unsigned long long)acquired_per_minute);
   dprintf(fd, "  Acquired/released error count  : %zu / %zu\n",
           wakelock_stats.acquired_errors, wakelock_stats.released_errors);
   dprintf(fd, "  Last acquire/release error code: %d / %d\n",
@@ -368,6 +478,5 @@ void wakelock_debug_dump(int fd) {
   dprintf(fd, "  Total acquired time (ms)       : %llu\n",
           (unsigned long long)total_interval_ms);
   dprintf(fd, "  Total run time (ms)            : %llu\n",
-          (unsigned long long)(just_now_ms -
-                               wakelock_stats.last_reset_timestamp_ms));
+          (unsigned long long)run_time_ms);
 }
@@ -46,6 +46,8 @@ alarm_t* alarm_new(const char* name) {
 
 void alarm_free(alarm_t* alarm) { AlarmMock::Get()->AlarmFreeImpl(alarm); }
 
+void alarm_cancel(alarm_t* alarm) { AlarmMock::Get()->AlarmCancel(alarm); }
+
 void alarm_set_on_mloop(alarm_t* alarm, uint64_t interval_ms,
                         alarm_callback_t cb, void* data) {
   AlarmMock::Get()->AlarmSetOnMloop(alarm, interval_ms, cb, data);
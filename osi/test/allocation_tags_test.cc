@@ -0,0 +1,110 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <thread>
+
+#include "osi/include/allocation_tags.h"
+
+void allocation_tags_enable_for_testing(bool enable);
+
+class AllocationTagsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { allocation_tags_enable_for_testing(true); }
+  void TearDown() override { allocation_tags_enable_for_testing(false); }
+
+  void* Alloc(size_t size) {
+    return allocation_tags_notify_alloc(malloc(allocation_tags_resize(size)),
+                                        size);
+  }
+
+  void Free(void* ptr) { free(allocation_tags_notify_free(ptr)); }
+
+  allocation_tag_stats_t Stats(allocation_tag_t tag) {
+    allocation_tag_stats_t stats;
+    EXPECT_TRUE(allocation_tags_get_stats(tag, &stats));
+    return stats;
+  }
+};
+
+TEST_F(AllocationTagsTest, test_disabled_no_bad_effects) {
+  allocation_tags_enable_for_testing(false);
+
+  EXPECT_EQ(4U, allocation_tags_resize(4));
+  void* ptr = malloc(4);
+  EXPECT_EQ(ptr, allocation_tags_notify_alloc(ptr, 4));
+  EXPECT_EQ(ptr, allocation_tags_notify_free(ptr));
+  free(ptr);
+
+  allocation_tag_stats_t stats;
+  EXPECT_FALSE(allocation_tags_get_stats(ALLOCATION_TAG_NONE, &stats));
+}
+
+TEST_F(AllocationTagsTest, test_accounted_to_scope_tag) {
+  void* untagged = Alloc(10);
+  void* gatt;
+  {
+    AllocationTagScope scope(ALLOCATION_TAG_GATT);
+    gatt = Alloc(100);
+    {
+      AllocationTagScope nested(ALLOCATION_TAG_SDP);
+      Free(Alloc(20));
+    }
+    Free(Alloc(50));
+  }
+
+  EXPECT_EQ(10U, Stats(ALLOCATION_TAG_NONE).live_bytes);
+  allocation_tag_stats_t stats = Stats(ALLOCATION_TAG_GATT);
+  EXPECT_EQ(100U, stats.live_bytes);
+  EXPECT_EQ(1U, stats.live_count);
+  EXPECT_EQ(150U, stats.peak_bytes);
+  EXPECT_EQ(2U, stats.total_count);
+  EXPECT_EQ(1U, Stats(ALLOCATION_TAG_SDP).total_count);
+  EXPECT_EQ(0U, Stats(ALLOCATION_TAG_SDP).live_bytes);
+
+  Free(gatt);
+  Free(untagged);
+  EXPECT_EQ(0U, Stats(ALLOCATION_TAG_GATT).live_count);
+  EXPECT_EQ(150U, Stats(ALLOCATION_TAG_GATT).peak_bytes);
+}
+
+TEST_F(AllocationTagsTest, test_freed_on_other_thread) {
+  void* ptr;
+  {
+    AllocationTagScope scope(ALLOCATION_TAG_A2DP);
+    ptr = Alloc(64);
+  }
+
+  // The allocation keeps its tag whatever the tag of the freeing thread
+  std::thread([this, ptr] {
+    AllocationTagScope scope(ALLOCATION_TAG_AVRCP);
+    Free(ptr);
+  }).join();
+
+  EXPECT_EQ(0U, Stats(ALLOCATION_TAG_A2DP).live_bytes);
+  EXPECT_EQ(0U, Stats(ALLOCATION_TAG_AVRCP).total_count);
+}
+
+TEST_F(AllocationTagsTest, test_aligned) {
+  void* ptr = Alloc(1);
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(ptr) % alignof(max_align_t));
+  Free(ptr);
+}
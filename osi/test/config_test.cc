@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <vector>
 
 #include "AllocationTestHarness.h"
 
@@ -244,6 +245,28 @@ TEST_F(ConfigTest, config_remove_key_missing) {
   EXPECT_EQ(config_get_int(*config, "DID", "productId", 999), 999);
 }
 
+TEST_F(ConfigTest, config_index_keeps_order) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  for (int i = 0; i < 100; i++) {
+    config_set_int(config.get(), "section" + std::to_string(i), "key", i);
+  }
+  EXPECT_TRUE(config_remove_section(config.get(), "section50"));
+  config_set_int(config.get(), "section50", "key", 50);
+
+  config_t copy = *config;
+  copy.sections.erase(copy.Find("section10"));
+  EXPECT_FALSE(copy.Has("section10"));
+  EXPECT_TRUE(config->Has("section10"));
+  EXPECT_EQ(config_get_int(copy, "section99", "key", -1), 99);
+
+  std::vector<std::string> names;
+  for (const section_t& section : copy.sections) names.push_back(section.name);
+  ASSERT_EQ(names.size(), 99u);
+  EXPECT_EQ(names.front(), "section0");
+  EXPECT_EQ(names[10], "section11");
+  EXPECT_EQ(names.back(), "section50");
+}
+
 TEST_F(ConfigTest, config_save_basic) {
   std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
   EXPECT_TRUE(config_save(*config, CONFIG_FILE));
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <climits>
+#include <thread>
 
 #include "AllocationTestHarness.h"
 
@@ -348,3 +349,111 @@ TEST_F(FixedQueueTest, test_fixed_queue_register_dequeue) {
   thread_free(worker_thread);
   fixed_queue_free(queue, NULL);
 }
+
+TEST_F(FixedQueueTest, test_fixed_queue_spsc_enqueue_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_spsc(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+  EXPECT_EQ(TEST_QUEUE_SIZE, fixed_queue_capacity(queue));
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+  EXPECT_EQ(nullptr, fixed_queue_try_dequeue(queue));
+  EXPECT_EQ(nullptr, fixed_queue_try_peek_first(queue));
+
+  // Fill the queue, wrapping around the ring a few times
+  for (size_t round = 0; round < 3; round++) {
+    for (size_t i = 0; i < TEST_QUEUE_SIZE; i++)
+      EXPECT_TRUE(fixed_queue_try_enqueue(queue, (void*)(i + 1)));
+    EXPECT_FALSE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+    EXPECT_EQ(TEST_QUEUE_SIZE, fixed_queue_length(queue));
+    EXPECT_EQ((void*)1, fixed_queue_try_peek_first(queue));
+    EXPECT_EQ((void*)TEST_QUEUE_SIZE, fixed_queue_try_peek_last(queue));
+
+    for (size_t i = 0; i < TEST_QUEUE_SIZE; i++)
+      EXPECT_EQ((void*)(i + 1), fixed_queue_dequeue(queue));
+    EXPECT_TRUE(fixed_queue_is_empty(queue));
+  }
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_spsc_fds_follow_transitions) {
+  fixed_queue_t* queue = fixed_queue_new_spsc(2);
+  ASSERT_TRUE(queue != NULL);
+  int enqueue_fd = fixed_queue_get_enqueue_fd(queue);
+  int dequeue_fd = fixed_queue_get_dequeue_fd(queue);
+
+  EXPECT_TRUE(is_fd_readable(enqueue_fd));
+  EXPECT_FALSE(is_fd_readable(dequeue_fd));
+
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  EXPECT_TRUE(is_fd_readable(enqueue_fd));
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_FALSE(is_fd_readable(enqueue_fd));
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_dequeue(queue));
+  EXPECT_TRUE(is_fd_readable(enqueue_fd));
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_try_dequeue(queue));
+  EXPECT_TRUE(is_fd_readable(enqueue_fd));
+  EXPECT_FALSE(is_fd_readable(dequeue_fd));
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_spsc_free_calls_free_cb) {
+  fixed_queue_t* queue = fixed_queue_new_spsc(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING3);
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_dequeue(queue));
+
+  test_queue_entry_free_counter = 0;
+  fixed_queue_free(queue, test_queue_entry_free_cb);
+  EXPECT_EQ(2, test_queue_entry_free_counter);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_spsc_producer_consumer) {
+  static const uintptr_t kNumMessages = 100000;
+  fixed_queue_t* queue = fixed_queue_new_spsc(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  std::thread producer([queue]() {
+    for (uintptr_t i = 1; i <= kNumMessages; i++)
+      fixed_queue_enqueue(queue, (void*)i);
+  });
+
+  for (uintptr_t i = 1; i <= kNumMessages; i++)
+    ASSERT_EQ((void*)i, fixed_queue_dequeue(queue));
+
+  producer.join();
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_spsc_register_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_spsc(TEST_QUEUE_SIZE);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_ready, NULL);
+
+  // Add a message to the queue, and expect to receive it
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING, msg);
+
+  fixed_queue_unregister_dequeue(queue);
+  thread_free(worker_thread);
+  fixed_queue_free(queue, NULL);
+}
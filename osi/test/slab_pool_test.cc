@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/allocator.h"
+#include "osi/include/slab_pool.h"
+
+class SlabPoolTest : public AllocationTestHarness {};
+
+TEST_F(SlabPoolTest, test_alloc_small_is_pooled) {
+  void* ptr = slab_pool_alloc(32);
+  ASSERT_NE(nullptr, ptr);
+  EXPECT_TRUE(slab_pool_owns(ptr));
+  memset(ptr, 0xAA, 32);
+  EXPECT_TRUE(slab_pool_free(ptr));
+}
+
+TEST_F(SlabPoolTest, test_block_is_recycled_on_same_thread) {
+  void* first = slab_pool_alloc(200);
+  ASSERT_NE(nullptr, first);
+  EXPECT_TRUE(slab_pool_free(first));
+  void* second = slab_pool_alloc(200);
+  EXPECT_EQ(first, second);
+  EXPECT_TRUE(slab_pool_free(second));
+}
+
+TEST_F(SlabPoolTest, test_oversized_alloc_is_not_pooled) {
+  EXPECT_EQ(nullptr, slab_pool_alloc(64 * 1024));
+}
+
+TEST_F(SlabPoolTest, test_foreign_pointer_is_not_freed) {
+  void* ptr = malloc(16);
+  EXPECT_FALSE(slab_pool_owns(ptr));
+  EXPECT_FALSE(slab_pool_free(ptr));
+  free(ptr);
+  EXPECT_FALSE(slab_pool_free(nullptr));
+}
+
+TEST_F(SlabPoolTest, test_exhausted_class_falls_back) {
+  std::vector<void*> blocks;
+  void* ptr;
+  while ((ptr = slab_pool_alloc(1024)) != nullptr) {
+    blocks.push_back(ptr);
+    ASSERT_LT(blocks.size(), 100000u);
+  }
+  EXPECT_FALSE(blocks.empty());
+
+  // osi_malloc keeps working from the system allocator.
+  void* fallback = osi_malloc(1000);
+  ASSERT_NE(nullptr, fallback);
+  EXPECT_FALSE(slab_pool_owns(fallback));
+  osi_free(fallback);
+
+  for (void* block : blocks) EXPECT_TRUE(slab_pool_free(block));
+}
+
+TEST_F(SlabPoolTest, test_free_on_other_thread) {
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; i++) blocks.push_back(osi_malloc(48));
+
+  std::thread consumer([&blocks]() {
+    for (void* block : blocks) osi_free(block);
+  });
+  consumer.join();
+}
+
+TEST_F(SlabPoolTest, test_osi_calloc_zeroes_recycled_block) {
+  uint8_t* ptr = static_cast<uint8_t*>(osi_malloc(100));
+  memset(ptr, 0xFF, 100);
+  osi_free(ptr);
+
+  ptr = static_cast<uint8_t*>(osi_calloc(100));
+  for (int i = 0; i < 100; i++) EXPECT_EQ(0, ptr[i]);
+  osi_free(ptr);
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/timer_wheel.h"
+
+class TimerWheelTest : public AllocationTestHarness {};
+
+static bool count_entry(timer_wheel_entry_t* entry, void* context) {
+  (*static_cast<size_t*>(context))++;
+  return true;
+}
+
+TEST_F(TimerWheelTest, test_new_free_empty) {
+  timer_wheel_t* wheel = timer_wheel_new(1000);
+  ASSERT_TRUE(wheel != NULL);
+  EXPECT_EQ(0u, timer_wheel_size(wheel));
+  EXPECT_EQ(nullptr, timer_wheel_peek(wheel));
+  timer_wheel_free(wheel);
+  timer_wheel_free(NULL);
+}
+
+TEST_F(TimerWheelTest, test_insert_remove) {
+  timer_wheel_t* wheel = timer_wheel_new(0);
+  timer_wheel_entry_t a, b;
+  timer_wheel_entry_init(&a, &a);
+  timer_wheel_entry_init(&b, &b);
+  EXPECT_FALSE(timer_wheel_is_queued(&a));
+
+  timer_wheel_insert(wheel, &a, 5000);
+  timer_wheel_insert(wheel, &b, 10);
+  EXPECT_TRUE(timer_wheel_is_queued(&a));
+  EXPECT_EQ(2u, timer_wheel_size(wheel));
+  EXPECT_EQ(&b, timer_wheel_peek(wheel));
+
+  timer_wheel_remove(wheel, &b);
+  EXPECT_FALSE(timer_wheel_is_queued(&b));
+  EXPECT_EQ(&a, timer_wheel_peek(wheel));
+
+  // Removing twice is a no-op
+  timer_wheel_remove(wheel, &b);
+  EXPECT_EQ(1u, timer_wheel_size(wheel));
+
+  // Re-inserting moves the entry
+  timer_wheel_insert(wheel, &a, 3);
+  EXPECT_EQ(1u, timer_wheel_size(wheel));
+  EXPECT_EQ(&a, timer_wheel_peek(wheel));
+  EXPECT_EQ(3u, timer_wheel_peek(wheel)->deadline_ms);
+
+  size_t count = 0;
+  timer_wheel_foreach(wheel, count_entry, &count);
+  EXPECT_EQ(1u, count);
+
+  timer_wheel_free(wheel);
+  EXPECT_FALSE(timer_wheel_is_queued(&a));
+}
+
+TEST_F(TimerWheelTest, test_equal_deadlines_keep_insertion_order) {
+  timer_wheel_t* wheel = timer_wheel_new(100);
+  timer_wheel_entry_t entries[4];
+  for (auto& entry : entries) {
+    timer_wheel_entry_init(&entry, NULL);
+    timer_wheel_insert(wheel, &entry, 100 + 70000);
+  }
+
+  timer_wheel_advance(wheel, 100 + 69990);
+  for (auto& entry : entries) {
+    EXPECT_EQ(&entry, timer_wheel_peek(wheel));
+    timer_wheel_remove(wheel, &entry);
+  }
+  timer_wheel_free(wheel);
+}
+
+TEST_F(TimerWheelTest, test_overflow_and_expired) {
+  timer_wheel_t* wheel = timer_wheel_new(1000);
+  timer_wheel_entry_t far, past;
+  timer_wheel_entry_init(&far, NULL);
+  timer_wheel_entry_init(&past, NULL);
+
+  timer_wheel_insert(wheel, &far, 1000 + (1ULL << 40));
+  EXPECT_EQ(&far, timer_wheel_peek(wheel));
+  timer_wheel_insert(wheel, &past, 10);
+  EXPECT_EQ(&past, timer_wheel_peek(wheel));
+  timer_wheel_remove(wheel, &past);
+
+  timer_wheel_advance(wheel, 1000 + (1ULL << 40) + 1);
+  EXPECT_EQ(&far, timer_wheel_peek(wheel));
+
+  timer_wheel_free(wheel);
+}
+
+// Compare the wheel against an ordered multimap under a random workload of
+// inserts, cancels and time advances.
+TEST_F(TimerWheelTest, test_random_against_reference) {
+  std::mt19937_64 rng(42);
+  uint64_t now = 123456;
+  timer_wheel_t* wheel = timer_wheel_new(now);
+
+  const size_t kNumEntries = 2000;
+  std::vector<timer_wheel_entry_t> entries(kNumEntries);
+  for (auto& entry : entries) timer_wheel_entry_init(&entry, NULL);
+  std::multimap<uint64_t, timer_wheel_entry_t*> reference;
+
+  auto reference_remove = [&reference](timer_wheel_entry_t* entry) {
+    auto range = reference.equal_range(entry->deadline_ms);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == entry) {
+        reference.erase(it);
+        return;
+      }
+    }
+  };
+
+  for (int step = 0; step < 200000; step++) {
+    timer_wheel_entry_t* entry = &entries[rng() % kNumEntries];
+    switch (rng() % 4) {
+      case 0:
+      case 1: {
+        // Spread deadlines over every level of the wheel
+        uint64_t delay = rng() % (1ULL << (rng() % 38));
+        if (timer_wheel_is_queued(entry)) reference_remove(entry);
+        timer_wheel_insert(wheel, entry, now + delay);
+        reference.emplace(now + delay, entry);
+        break;
+      }
+      case 2:
+        if (timer_wheel_is_queued(entry)) reference_remove(entry);
+        timer_wheel_remove(wheel, entry);
+        break;
+      case 3:
+        now += rng() % 5000;
+        timer_wheel_advance(wheel, now);
+        break;
+    }
+
+    ASSERT_EQ(reference.size(), timer_wheel_size(wheel));
+    timer_wheel_entry_t* front = timer_wheel_peek(wheel);
+    if (reference.empty()) {
+      ASSERT_EQ(nullptr, front);
+    } else {
+      ASSERT_NE(nullptr, front);
+      ASSERT_EQ(reference.begin()->first, front->deadline_ms);
+    }
+
+    // Expire everything that is due
+    while (front != NULL && front->deadline_ms <= now) {
+      reference_remove(front);
+      timer_wheel_remove(wheel, front);
+      front = timer_wheel_peek(wheel);
+      ASSERT_EQ(reference.size(), timer_wheel_size(wheel));
+      if (!reference.empty()) {
+        ASSERT_EQ(reference.begin()->first, front->deadline_ms);
+      }
+    }
+  }
+
+  timer_wheel_free(wheel);
+}
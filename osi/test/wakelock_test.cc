@@ -24,14 +24,20 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "osi/include/wakelock.h"
 
 #include "AllocationTestHarness.h"
 
-static bool is_wake_lock_acquired = false;
+static std::atomic<bool> is_wake_lock_acquired(false);
+static std::atomic<int> acquire_wake_lock_count(0);
 
 static int acquire_wake_lock_cb(const char* lock_name) {
   is_wake_lock_acquired = true;
+  acquire_wake_lock_count++;
   return BT_STATUS_SUCCESS;
 }
 
@@ -70,8 +76,10 @@ class WakelockTest : public AllocationTestHarness {
   }
 
   void TearDown() override {
-    is_wake_lock_acquired = false;
+    wakelock_set_hold_over_ms(0);
     wakelock_cleanup();
+    is_wake_lock_acquired = false;
+    acquire_wake_lock_count = 0;
     wakelock_set_os_callouts(NULL);
 
     // Clean up the temp wake lock directory
@@ -155,3 +163,45 @@ TEST_F(WakelockTest, test_set_paths) {
     ASSERT_FALSE(IsFileWakeLockAcquired());
   }
 }
+
+TEST_F(WakelockTest, test_nested_acquire) {
+  wakelock_set_os_callouts(&bt_wakelock_callouts);
+
+  ASSERT_TRUE(wakelock_acquire());
+  ASSERT_TRUE(wakelock_acquire());
+  ASSERT_EQ(1, acquire_wake_lock_count);
+
+  // Held until the last holder releases it
+  wakelock_release();
+  ASSERT_TRUE(is_wake_lock_acquired);
+  wakelock_release();
+  ASSERT_FALSE(is_wake_lock_acquired);
+
+  // Unbalanced releases are ignored
+  wakelock_release();
+  ASSERT_TRUE(wakelock_acquire());
+  ASSERT_TRUE(is_wake_lock_acquired);
+  wakelock_release();
+  ASSERT_FALSE(is_wake_lock_acquired);
+}
+
+TEST_F(WakelockTest, test_hold_over) {
+  wakelock_set_os_callouts(&bt_wakelock_callouts);
+  wakelock_set_hold_over_ms(100);
+
+  for (size_t i = 0; i < 100; i++) {
+    wakelock_acquire();
+    ASSERT_TRUE(is_wake_lock_acquired);
+    wakelock_release();
+    ASSERT_TRUE(is_wake_lock_acquired);
+  }
+  ASSERT_EQ(1, acquire_wake_lock_count);
+
+  // Released once the hold-over has passed without holder
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (is_wake_lock_acquired &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_FALSE(is_wake_lock_acquired);
+}
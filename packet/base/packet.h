@@ -39,6 +39,10 @@ class Packet : public std::enable_shared_from_this<Packet> {
       : packet_start_index_(0),
         packet_end_index_(0),
         data_(std::make_shared<std::vector<uint8_t>>(0)){};
+  explicit Packet(std::shared_ptr<std::vector<uint8_t>> data)
+      : packet_start_index_(0),
+        packet_end_index_(data->size()),
+        data_(std::move(data)){};
   Packet(std::shared_ptr<const Packet> pkt, size_t start, size_t end)
       : packet_start_index_(start), packet_end_index_(end), data_(pkt->data_){};
   Packet(std::shared_ptr<const Packet> pkt) : data_(pkt->data_) {
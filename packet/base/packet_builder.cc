@@ -17,11 +17,37 @@
 #include "packet_builder.h"
 
 #include <base/logging.h>
+#include <string>
 
 #include "packet.h"
 
 namespace bluetooth {
 
+namespace {
+
+// Packet over a buffer owned by the caller of SerializeTo()
+class BufferPacket : public Packet {
+ public:
+  explicit BufferPacket(const std::shared_ptr<std::vector<uint8_t>>& buffer)
+      : Packet(buffer) {}
+
+  bool IsValid() const override { return true; }
+  std::string ToString() const override { return "BufferPacket"; }
+
+ private:
+  std::pair<size_t, size_t> GetPayloadIndecies() const override {
+    return std::pair<size_t, size_t>(packet_start_index_, packet_end_index_);
+  }
+};
+
+}  // namespace
+
+bool PacketBuilder::SerializeTo(
+    const std::shared_ptr<std::vector<uint8_t>>& buffer) {
+  buffer->clear();
+  return Serialize(std::make_shared<BufferPacket>(buffer));
+}
+
 void PacketBuilder::ReserveSpace(const std::shared_ptr<Packet>& pkt,
                                  size_t size) {
   pkt->data_->reserve(size);
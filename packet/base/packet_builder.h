@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace bluetooth {
 
@@ -27,6 +29,11 @@ class PacketBuilder {
   virtual size_t size() const = 0;
   virtual bool Serialize(const std::shared_ptr<Packet>& pkt) = 0;
 
+  // Serialize into |buffer|, replacing its contents. A sender that keeps one
+  // buffer for all the packets it sends reuses its storage instead of
+  // allocating a new one per packet.
+  bool SerializeTo(const std::shared_ptr<std::vector<uint8_t>>& buffer);
+
   virtual ~PacketBuilder() = default;
 
  protected:
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <set>
+
+#include "avrcp_test_packets.h"
+#include "get_element_attributes_packet.h"
+#include "get_folder_items.h"
+#include "packet_test_helper.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+namespace {
+
+using TestAvrcpPacket = TestPacketType<Packet>;
+using TestBrowsePacket = TestPacketType<BrowsePacket>;
+
+// Received vendor command, specialized layer by layer as the AVRCP target
+// service does
+void BM_ParseGetElementAttributes(benchmark::State& state) {
+  auto raw = TestAvrcpPacket::Make(get_element_attributes_request_full);
+  for (auto _ : state) {
+    auto pkt = Packet::Parse(raw);
+    auto vendor_pkt = Packet::Specialize<VendorPacket>(pkt);
+    auto request =
+        Packet::Specialize<GetElementAttributesRequest>(vendor_pkt);
+    benchmark::DoNotOptimize(request->IsValid());
+    benchmark::DoNotOptimize(request->GetAttributesRequested());
+  }
+}
+BENCHMARK(BM_ParseGetElementAttributes);
+
+// Received browse command
+void BM_ParseGetFolderItems(benchmark::State& state) {
+  auto raw = TestBrowsePacket::Make(get_folder_items_request);
+  for (auto _ : state) {
+    auto pkt = BrowsePacket::Parse(raw);
+    auto request = Packet::Specialize<GetFolderItemsRequest>(pkt);
+    benchmark::DoNotOptimize(request->IsValid());
+    benchmark::DoNotOptimize(request->GetEndItem());
+    benchmark::DoNotOptimize(request->GetAttributesRequested());
+  }
+}
+BENCHMARK(BM_ParseGetFolderItems);
+
+std::unique_ptr<GetFolderItemsResponseBuilder> MakeFolderItemsResponse(
+    size_t num_songs) {
+  auto builder = GetFolderItemsResponseBuilder::MakeNowPlayingBuilder(
+      Status::NO_ERROR, 0x0000, 0xFFFF);
+  for (size_t i = 0; i < num_songs; i++) {
+    std::set<AttributeEntry> attributes = {
+        AttributeEntry(Attribute::TITLE, "Test Song"),
+        AttributeEntry(Attribute::ARTIST_NAME, "Test Artist"),
+        AttributeEntry(Attribute::ALBUM_NAME, "Test Album")};
+    builder->AddSong(MediaElementItem(i + 1, "Test Song", attributes));
+  }
+  return builder;
+}
+
+// Response serialized into a new buffer for every message
+void BM_SerializeNewBuffer(benchmark::State& state) {
+  auto builder = MakeFolderItemsResponse(state.range(0));
+  for (auto _ : state) {
+    auto buffer = std::make_shared<std::vector<uint8_t>>();
+    builder->SerializeTo(buffer);
+    benchmark::DoNotOptimize(buffer->data());
+  }
+}
+BENCHMARK(BM_SerializeNewBuffer)->Arg(1)->Arg(10);
+
+// Response serialized into a buffer reused across messages
+void BM_SerializePooledBuffer(benchmark::State& state) {
+  auto builder = MakeFolderItemsResponse(state.range(0));
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  for (auto _ : state) {
+    builder->SerializeTo(buffer);
+    benchmark::DoNotOptimize(buffer->data());
+  }
+}
+BENCHMARK(BM_SerializePooledBuffer)->Arg(1)->Arg(10);
+
+// Copy of a serialized response out to the transport buffer, through the
+// packet iterators
+void BM_CopyOutIterator(benchmark::State& state) {
+  auto builder = MakeFolderItemsResponse(state.range(0));
+  auto pkt = TestBrowsePacket::Make();
+  builder->Serialize(pkt);
+  std::vector<uint8_t> out(pkt->size());
+  for (auto _ : state) {
+    uint8_t* p_data = out.data();
+    for (auto it = pkt->begin(); it != pkt->end(); it++) {
+      *p_data++ = *it;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_CopyOutIterator)->Arg(1)->Arg(10);
+
+// Copy of a serialized response out to the transport buffer, from the
+// contiguous serialization buffer
+void BM_CopyOutBuffer(benchmark::State& state) {
+  auto builder = MakeFolderItemsResponse(state.range(0));
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  builder->SerializeTo(buffer);
+  std::vector<uint8_t> out(buffer->size());
+  for (auto _ : state) {
+    memcpy(out.data(), buffer->data(), buffer->size());
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK(BM_CopyOutBuffer)->Arg(1)->Arg(10);
+
+}  // namespace
+
+}  // namespace avrcp
+}  // namespace bluetooth
+
+BENCHMARK_MAIN();
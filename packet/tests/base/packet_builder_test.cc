@@ -52,6 +52,20 @@ TEST(PacketBuilderTest, reserveSpaceTest) {
   ASSERT_GE(packet->GetData().capacity(), test_l2cap_data.size());
 }
 
+TEST(PacketBuilderTest, serializeToTest) {
+  auto builder = TestPacketBuilder::MakeBuilder(test_l2cap_data);
+  auto buffer = std::make_shared<vector<uint8_t>>(test_avrcp_data);
+
+  ASSERT_TRUE(builder->SerializeTo(buffer));
+  ASSERT_EQ(*buffer, test_l2cap_data);
+
+  // Serializing again replaces the contents and keeps the storage
+  auto storage = buffer->data();
+  ASSERT_TRUE(builder->SerializeTo(buffer));
+  ASSERT_EQ(*buffer, test_l2cap_data);
+  ASSERT_EQ(buffer->data(), storage);
+}
+
 TEST(PacketBuilderTest, addPayloadOctetsTest) {
   auto builder = TestPacketBuilder::MakeBuilder(test_l2cap_data);
   auto packet = TestPacket::Make();
@@ -32,11 +32,13 @@ class VectorPacket : public ::bluetooth::Packet {
   };
 
   static std::shared_ptr<VectorPacket> Make(std::vector<uint8_t> payload) {
-    auto pkt = VectorPacket::Make();
-    pkt->packet_start_index_ = 0;
-    pkt->packet_end_index_ = payload.size();
-    pkt->data_ = std::make_shared<std::vector<uint8_t>>(std::move(payload));
-    return pkt;
+    return Make(std::make_shared<std::vector<uint8_t>>(std::move(payload)));
+  };
+
+  // Wraps |buffer| without copying it
+  static std::shared_ptr<VectorPacket> Make(
+      std::shared_ptr<std::vector<uint8_t>> buffer) {
+    return std::shared_ptr<VectorPacket>(new VectorPacket(std::move(buffer)));
   };
 
   const std::vector<uint8_t>& GetData() { return *data_; };
@@ -70,6 +72,7 @@ class AvrcpMessageConverter {
     switch (m->hdr.opcode) {
       case AVRC_OP_VENDOR: {
         tAVRC_MSG_VENDOR* msg = (tAVRC_MSG_VENDOR*)m;
+        data.reserve(6 + msg->vendor_len);
         data.push_back(m->hdr.ctype);
         data.push_back((m->hdr.subunit_type << 3) | m->hdr.subunit_id);
         data.push_back(m->hdr.opcode);
@@ -82,6 +85,7 @@ class AvrcpMessageConverter {
       } break;
       case AVRC_OP_PASS_THRU: {
         tAVRC_MSG_PASS* msg = (tAVRC_MSG_PASS*)m;
+        data.reserve(5);
         data.push_back(m->hdr.ctype);
         data.push_back((m->hdr.subunit_type << 3) | m->hdr.subunit_id);
         data.push_back(m->hdr.opcode);
@@ -92,15 +96,13 @@ class AvrcpMessageConverter {
         tAVRC_MSG_BROWSE* msg = (tAVRC_MSG_BROWSE*)m;
         // The first 3 bytes are header bytes that aren't actually in AVRCP
         // packets
-        for (int i = 0; i < msg->browse_len; i++) {
-          data.push_back(msg->p_browse_data[i]);
-        }
+        data.assign(msg->p_browse_data, msg->p_browse_data + msg->browse_len);
       } break;
       default:
         LOG(ERROR) << "Unknown opcode for AVRCP message";
         break;
     }
 
-    return VectorPacket::Make(data);
+    return VectorPacket::Make(std::move(data));
   }
 };
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hardware/avrcp/avrcp.h"
+
+namespace bluetooth {
+namespace avrcp {
+
+// A helper class that caches the browsing content received from the AVRCP
+// Media Interface layer for one connected device. Remote devices page
+// through large folders with one GetFolderItems request per screen, and
+// follow up with GetItemAttributes and GetTotalNumberOfItems requests on the
+// same folder, so each folder is only fetched once from the media layer.
+//
+// Folder listings are keyed by browsed player and folder ID. We only support
+// database unaware players, whose UID counter is always 0, so the cache
+// stands in for the UID counter: it must be cleared whenever the media layer
+// reports that the UIDs, or the players, have changed.
+class BrowseCache {
+ public:
+  // The number of folder listings kept, enough for the path a remote device
+  // usually navigates back and forth through
+  static constexpr size_t kMaxFolders = 8;
+
+  const std::vector<ListItem>* GetFolder(int player_id,
+                                         const std::string& folder_id) {
+    auto it = folders_.find(FolderKey(player_id, folder_id));
+    if (it == folders_.end()) return nullptr;
+    it->second.last_used = ++use_count_;
+    return &it->second.items;
+  }
+
+  void PutFolder(int player_id, const std::string& folder_id,
+                 std::vector<ListItem> items) {
+    FolderKey key(player_id, folder_id);
+    if (folders_.size() >= kMaxFolders && folders_.count(key) == 0) {
+      // Evict the least recently used folder
+      auto lru = folders_.begin();
+      for (auto it = folders_.begin(); it != folders_.end(); it++) {
+        if (it->second.last_used < lru->second.last_used) lru = it;
+      }
+      folders_.erase(lru);
+    }
+    folders_[key] = FolderEntry{std::move(items), ++use_count_};
+  }
+
+  void ClearFolders() { folders_.clear(); }
+
+  bool GetNowPlaying(std::string* curr_song_id,
+                     std::vector<SongInfo>* song_list) const {
+    if (!has_now_playing_) return false;
+    *curr_song_id = now_playing_curr_song_id_;
+    *song_list = now_playing_list_;
+    return true;
+  }
+
+  void PutNowPlaying(std::string curr_song_id,
+                     std::vector<SongInfo> song_list) {
+    now_playing_curr_song_id_ = std::move(curr_song_id);
+    now_playing_list_ = std::move(song_list);
+    has_now_playing_ = true;
+  }
+
+  void ClearNowPlaying() {
+    has_now_playing_ = false;
+    now_playing_curr_song_id_.clear();
+    now_playing_list_.clear();
+  }
+
+  void Clear() {
+    ClearFolders();
+    ClearNowPlaying();
+  }
+
+  size_t NumFolders() const { return folders_.size(); }
+
+ private:
+  using FolderKey = std::pair<int, std::string>;
+  struct FolderEntry {
+    std::vector<ListItem> items;
+    uint64_t last_used;
+  };
+
+  std::map<FolderKey, FolderEntry> folders_;
+  uint64_t use_count_ = 0;
+
+  bool has_now_playing_ = false;
+  std::string now_playing_curr_song_id_;
+  std::vector<SongInfo> now_playing_list_;
+};
+
+}  // namespace avrcp
+}  // namespace bluetooth
@@ -18,6 +18,7 @@
 
 #include <base/bind.h>
 #include <base/logging.h>
+#include <string.h>
 #include <map>
 
 #include "avrc_defs.h"
@@ -535,13 +536,15 @@ void ConnectionHandler::SdpCb(RawAddress bdaddr, SdpCallback cb,
 void ConnectionHandler::SendMessage(
     uint8_t handle, uint8_t label, bool browse,
     std::unique_ptr<::bluetooth::PacketBuilder> message) {
-  std::shared_ptr<::bluetooth::Packet> packet = VectorPacket::Make();
-  message->Serialize(packet);
+  // Responses are serialized into the same buffer one at a time and copied
+  // out to the BT_HDR below, so its storage is reused for every message
+  message->SerializeTo(tx_buffer_);
+  auto packet = ::bluetooth::Packet::Specialize<Packet>(
+      VectorPacket::Make(tx_buffer_));
 
   uint8_t ctype = AVRC_RSP_ACCEPT;
   if (!browse) {
-    ctype =
-        (uint8_t)(::bluetooth::Packet::Specialize<Packet>(packet)->GetCType());
+    ctype = (uint8_t)(packet->GetCType());
   }
 
   DLOG(INFO) << "SendMessage to handle=" << loghex(handle);
@@ -555,9 +558,8 @@ void ConnectionHandler::SendMessage(
   // the packet so none of these layer specific fields will be used.
   pkt->event = 0xFFFF;
   /* Handle for AVRCP fragment */
-  uint16_t op_code = (uint16_t)(::bluetooth::Packet::Specialize<Packet>(packet)->GetOpcode());
-  if (!browse && (op_code == (uint16_t)(Opcode::VENDOR))) {
-    pkt->event = op_code;
+  if (!browse && packet->GetOpcode() == Opcode::VENDOR) {
+    pkt->event = (uint16_t)(Opcode::VENDOR);
   }
 
   // TODO (apanicke): This layer specific stuff can go away once we move over
@@ -567,11 +569,9 @@ void ConnectionHandler::SendMessage(
     pkt->layer_specific = AVCT_DATA_BROWSE;
   }
 
-  pkt->len = packet->size();
+  pkt->len = tx_buffer_->size();
   uint8_t* p_data = (uint8_t*)(pkt + 1) + pkt->offset;
-  for (auto it = packet->begin(); it != packet->end(); it++) {
-    *p_data++ = *it;
-  }
+  memcpy(p_data, tx_buffer_->data(), tx_buffer_->size());
 
   avrc_->MsgReq(handle, label, ctype, pkt);
 }
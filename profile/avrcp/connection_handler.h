@@ -20,6 +20,7 @@
 #include <base/memory/weak_ptr.h>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "avrcp_internal.h"
 #include "packet/avrcp/avrcp_packet.h"
@@ -139,6 +140,10 @@ class ConnectionHandler {
   // fields.
   std::map<RawAddress, uint16_t> feature_map_;
 
+  // Serialization buffer reused for every message sent
+  std::shared_ptr<std::vector<uint8_t>> tx_buffer_ =
+      std::make_shared<std::vector<uint8_t>>();
+
   static ConnectionHandler* instance_;
 
   using SdpCallback = base::Callback<void(uint16_t status, uint16_t version,
@@ -15,6 +15,8 @@
  */
 #include "device.h"
 
+#include <algorithm>
+
 #include "abstract_message_loop.h"
 #include "connection_handler.h"
 #include "packet/avrcp/avrcp_reject_packet.h"
@@ -34,6 +36,10 @@ namespace avrcp {
 #define VOL_NOT_SUPPORTED -1
 #define VOL_REGISTRATION_FAILED -2
 
+// How far a reported play position may drift from the position extrapolated
+// from the last notification before it is treated as a seek
+constexpr uint64_t kPlayPosMaxDriftMs = 1000;
+
 Device::Device(
     const RawAddress& bdaddr, bool avrcp13_compatibility,
     base::Callback<void(uint8_t label, bool browse,
@@ -85,6 +91,16 @@ void filter_cover_art(SongInfo& s) {
   }
 }
 
+static bool same_song_info(const SongInfo& a, const SongInfo& b) {
+  return a.media_id == b.media_id &&
+         std::equal(a.attributes.begin(), a.attributes.end(),
+                    b.attributes.begin(), b.attributes.end(),
+                    [](const AttributeEntry& x, const AttributeEntry& y) {
+                      return x.attribute() == y.attribute() &&
+                             x.value() == y.value();
+                    });
+}
+
 bool Device::IsActive() const {
   return address_ == a2dp_interface_->active_peer();
 }
@@ -436,6 +452,7 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
                                               std::vector<SongInfo> song_list) {
   DEVICE_VLOG(1) << __func__;
   uint64_t uid = 0;
+  SongInfo curr_song;
 
   if (interim) {
     track_changed_ = Notification(true, label);
@@ -453,9 +470,21 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
       DEVICE_VLOG(3) << __func__ << ": Found media ID match for "
                      << song.media_id;
       uid = now_playing_ids_.get_uid(curr_song_id);
+      curr_song = song;
     }
   }
 
+  // Players report metadata updates that don't change anything the remote
+  // device can see, keep the registration for an actual change
+  if (!interim && same_song_info(curr_song, last_track_info_)) {
+    DEVICE_VLOG(0) << __func__
+                   << ": Not sending notification due to no track update "
+                   << address_.ToString();
+    notifications_suppressed_++;
+    return;
+  }
+  last_track_info_ = curr_song;
+
   if (curr_song_id == "") {
     DEVICE_LOG(WARNING) << "Empty media ID";
     uid = 0;
@@ -469,6 +498,7 @@ void Device::TrackChangedNotificationResponse(uint8_t label, bool interim,
       interim, uid);
   send_message_cb_.Run(label, false, std::move(response));
   if (!interim) {
+    notifications_sent_++;
     active_labels_.erase(label);
     track_changed_ = Notification(false, 0);
   }
@@ -492,6 +522,7 @@ void Device::PlaybackStatusNotificationResponse(uint8_t label, bool interim,
     DEVICE_VLOG(0) << __func__
                    << ": Not sending notification due to no state update "
                    << address_.ToString();
+    notifications_suppressed_++;
     return;
   }
 
@@ -503,6 +534,7 @@ void Device::PlaybackStatusNotificationResponse(uint8_t label, bool interim,
   send_message_cb_.Run(label, false, std::move(response));
 
   if (!interim) {
+    notifications_sent_++;
     active_labels_.erase(label);
     play_status_changed_ = Notification(false, 0);
   }
@@ -522,6 +554,19 @@ void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
   if (!interim && last_play_status_.position == status.position) {
     DEVICE_LOG(WARNING) << address_.ToString()
                         << ": No update to play position";
+    notifications_suppressed_++;
+    return;
+  }
+
+  // Only notify steady playback progress at the interval the remote device
+  // asked for, play status updates from the player can be much more frequent
+  base::TimeTicks now = base::TimeTicks::Now();
+  uint64_t interval_ms = play_pos_interval_ * 1000ULL;
+  uint64_t elapsed_ms = (now - last_play_pos_time_).InMilliseconds();
+  if (!interim && !IsPlayPosDiscontinuity(status, elapsed_ms, interval_ms)) {
+    DEVICE_VLOG(3) << __func__ << ": Deferring play position update";
+    notifications_suppressed_++;
+    if (!IsInSilenceMode()) QueuePlayPosUpdate(interval_ms - elapsed_ms);
     return;
   }
 
@@ -531,8 +576,11 @@ void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
   send_message_cb_.Run(label, false, std::move(response));
 
   last_play_status_.position = status.position;
+  last_play_pos_state_ = status.state;
+  last_play_pos_time_ = now;
 
   if (!interim) {
+    notifications_sent_++;
     active_labels_.erase(label);
     play_pos_changed_ = Notification(false, 0);
   }
@@ -541,15 +589,34 @@ void Device::PlaybackPosNotificationResponse(uint8_t label, bool interim,
   // device even though the device thinks the music is paused. This makes
   // the status bar on the remote device move.
   if (status.state == PlayState::PLAYING && !IsInSilenceMode()) {
-    DEVICE_VLOG(0) << __func__ << ": Queue next play position update";
-    play_pos_update_cb_.Reset(base::Bind(&Device::HandlePlayPosUpdate,
-                                         weak_ptr_factory_.GetWeakPtr()));
-    btbase::AbstractMessageLoop::current_task_runner()->PostDelayedTask(
-        FROM_HERE, play_pos_update_cb_.callback(),
-        base::TimeDelta::FromSeconds(play_pos_interval_));
+    QueuePlayPosUpdate(interval_ms);
   }
 }
 
+bool Device::IsPlayPosDiscontinuity(const PlayStatus& status,
+                                    uint64_t elapsed_ms,
+                                    uint64_t interval_ms) const {
+  if (status.state != PlayState::PLAYING ||
+      last_play_pos_state_ != PlayState::PLAYING || elapsed_ms >= interval_ms) {
+    return true;
+  }
+
+  // A position away from where playback should be by now is a seek
+  uint64_t expected = last_play_status_.position + elapsed_ms;
+  uint64_t drift = status.position > expected ? status.position - expected
+                                              : expected - status.position;
+  return drift > kPlayPosMaxDriftMs;
+}
+
+void Device::QueuePlayPosUpdate(uint64_t delay_ms) {
+  DEVICE_VLOG(0) << __func__ << ": Queue next play position update";
+  play_pos_update_cb_.Reset(base::Bind(&Device::HandlePlayPosUpdate,
+                                       weak_ptr_factory_.GetWeakPtr()));
+  btbase::AbstractMessageLoop::current_task_runner()->PostDelayedTask(
+      FROM_HERE, play_pos_update_cb_.callback(),
+      base::TimeDelta::FromMilliseconds(delay_ms));
+}
+
 // TODO (apanicke): Finish implementing when we add support for more than one
 // player
 void Device::AddressedPlayerNotificationResponse(
@@ -828,13 +895,13 @@ void Device::HandleGetFolderItems(uint8_t label,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
       break;
     case Scope::VFS:
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
+      GetCurrentFolderItems(
           base::Bind(&Device::GetVFSListResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label, pkt));
+                     weak_ptr_factory_.GetWeakPtr(), label, pkt),
+          false);
       break;
     case Scope::NOW_PLAYING:
-      media_interface_->GetNowPlayingList(
+      GetBrowsedNowPlayingList(
           base::Bind(&Device::GetNowPlayingListResponse,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
       break;
@@ -865,13 +932,13 @@ void Device::HandleGetTotalNumberOfItems(
       break;
     }
     case Scope::VFS:
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
+      GetCurrentFolderItems(
           base::Bind(&Device::GetTotalNumberOfItemsVFSResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label));
+                     weak_ptr_factory_.GetWeakPtr(), label),
+          false);
       break;
     case Scope::NOW_PLAYING:
-      media_interface_->GetNowPlayingList(
+      GetBrowsedNowPlayingList(
           base::Bind(&Device::GetTotalNumberOfItemsNowPlayingResponse,
                      weak_ptr_factory_.GetWeakPtr(), label));
       break;
@@ -949,10 +1016,11 @@ void Device::HandleChangePath(uint8_t label,
                    << "\"";
   }
 
-  media_interface_->GetFolderItems(
-      curr_browsed_player_id_, CurrentFolder(),
-      base::Bind(&Device::ChangePathResponse, weak_ptr_factory_.GetWeakPtr(),
-                 label, pkt));
+  // Entering a folder always refreshes its listing, the following requests
+  // to page through it are answered from the browse cache
+  GetCurrentFolderItems(base::Bind(&Device::ChangePathResponse,
+                                   weak_ptr_factory_.GetWeakPtr(), label, pkt),
+                        true);
 }
 
 void Device::ChangePathResponse(uint8_t label,
@@ -987,7 +1055,7 @@ void Device::HandleGetItemAttributes(
 
   switch (pkt->GetScope()) {
     case Scope::NOW_PLAYING: {
-      media_interface_->GetNowPlayingList(
+      GetBrowsedNowPlayingList(
           base::Bind(&Device::GetItemAttributesNowPlayingResponse,
                      weak_ptr_factory_.GetWeakPtr(), label, pkt));
     } break;
@@ -996,10 +1064,10 @@ void Device::HandleGetItemAttributes(
       // then we can auto send the error without calling up. We do this check
       // later right now though in order to prevent race conditions with updates
       // on the media layer.
-      media_interface_->GetFolderItems(
-          curr_browsed_player_id_, CurrentFolder(),
+      GetCurrentFolderItems(
           base::Bind(&Device::GetItemAttributesVFSResponse,
-                     weak_ptr_factory_.GetWeakPtr(), label, pkt));
+                     weak_ptr_factory_.GetWeakPtr(), label, pkt),
+          false);
       break;
     default:
       DEVICE_LOG(ERROR) << "UNKNOWN SCOPE FOR HANDLE GET ITEM ATTRIBUTES";
@@ -1172,16 +1240,31 @@ std::set<AttributeEntry> filter_attributes_requested(
   return result;
 }
 
-void Device::GetVFSListResponse(uint8_t label,
-                                std::shared_ptr<GetFolderItemsRequest> pkt,
-                                std::vector<ListItem> items) {
-  DEVICE_VLOG(2) << __func__ << ": start_item=" << pkt->GetStartItem()
-                 << " end_item=" << pkt->GetEndItem();
+void Device::GetCurrentFolderItems(
+    MediaInterface::FolderItemsCallback folder_cb, bool refresh) {
+  std::string folder_id = CurrentFolder();
+  if (!refresh) {
+    const auto* items =
+        browse_cache_.GetFolder(curr_browsed_player_id_, folder_id);
+    if (items != nullptr) {
+      DEVICE_VLOG(3) << __func__ << ": cache hit for folder \"" << folder_id
+                     << "\"";
+      folder_cb.Run(*items);
+      return;
+    }
+  }
 
-  // The builder will automatically correct the status if there are zero items
-  auto builder = GetFolderItemsResponseBuilder::MakeVFSBuilder(
-      Status::NO_ERROR, 0x0000, browse_mtu_);
+  media_interface_->GetFolderItems(
+      curr_browsed_player_id_, folder_id,
+      base::Bind(&Device::CurrentFolderItemsFetched,
+                 weak_ptr_factory_.GetWeakPtr(), curr_browsed_player_id_,
+                 folder_id, folder_cb));
+}
 
+void Device::CurrentFolderItemsFetched(
+    int player_id, std::string folder_id,
+    MediaInterface::FolderItemsCallback folder_cb,
+    std::vector<ListItem> items) {
   // TODO (apanicke): Add test that checks if vfs_ids_ is the correct size after
   // an operation.
   for (const auto& item : items) {
@@ -1192,11 +1275,46 @@ void Device::GetVFSListResponse(uint8_t label,
     }
   }
 
-  // Add the elements retrieved in the last get folder items request and map
-  // them to UIDs The maps will be cleared every time a directory change
-  // happens. These items do not need to correspond with the now playing list as
-  // the UID's only need to be unique in the context of the current scope and
-  // the current folder
+  browse_cache_.PutFolder(player_id, folder_id, items);
+  folder_cb.Run(std::move(items));
+}
+
+void Device::GetBrowsedNowPlayingList(MediaInterface::NowPlayingCallback cb) {
+  std::string curr_song_id;
+  std::vector<SongInfo> song_list;
+  if (browse_cache_.GetNowPlaying(&curr_song_id, &song_list)) {
+    DEVICE_VLOG(3) << __func__ << ": cache hit";
+    cb.Run(std::move(curr_song_id), std::move(song_list));
+    return;
+  }
+
+  media_interface_->GetNowPlayingList(
+      base::Bind(&Device::BrowsedNowPlayingListFetched,
+                 weak_ptr_factory_.GetWeakPtr(), cb));
+}
+
+void Device::BrowsedNowPlayingListFetched(
+    MediaInterface::NowPlayingCallback cb, std::string curr_song_id,
+    std::vector<SongInfo> song_list) {
+  browse_cache_.PutNowPlaying(curr_song_id, song_list);
+  cb.Run(std::move(curr_song_id), std::move(song_list));
+}
+
+void Device::GetVFSListResponse(uint8_t label,
+                                std::shared_ptr<GetFolderItemsRequest> pkt,
+                                std::vector<ListItem> items) {
+  DEVICE_VLOG(2) << __func__ << ": start_item=" << pkt->GetStartItem()
+                 << " end_item=" << pkt->GetEndItem();
+
+  // The builder will automatically correct the status if there are zero items
+  auto builder = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+      Status::NO_ERROR, 0x0000, browse_mtu_);
+
+  // Add the requested range of the current folder. The items were mapped to
+  // UIDs when the folder was fetched, see CurrentFolderItemsFetched(). The maps
+  // will be cleared every time a directory change happens. These items do not
+  // need to correspond with the now playing list as the UID's only need to be
+  // unique in the context of the current scope and the current folder
   for (auto i = pkt->GetStartItem(); i <= pkt->GetEndItem() && i < items.size();
        i++) {
     if (items[i].type == ListItem::FOLDER) {
@@ -1315,6 +1433,7 @@ void Device::SetBrowsedPlayerResponse(
   }
 
   curr_browsed_player_id_ = pkt->GetPlayerId();
+  browse_cache_.ClearFolders();
 
   // Clear the path and push the new root.
   current_path_ = std::stack<std::string>();
@@ -1333,18 +1452,56 @@ void Device::SendMediaUpdate(bool metadata, bool play_status, bool queue) {
                  << " : play_status= " << play_status << " : queue=" << queue
                  << " ; is_silence=" << is_silence;
 
-  if (queue) {
-    HandleNowPlayingUpdate();
+  // The current song is part of the now playing list response
+  if (metadata || queue) {
+    browse_cache_.ClearNowPlaying();
   }
 
-  if (play_status) {
-    HandlePlayStatusUpdate();
-    if (!is_silence) {
-      HandlePlayPosUpdate();
-    }
+  // Fetch the now playing list and the play status at most once for all the
+  // notifications an update affects
+  bool track = metadata && track_changed_.first;
+  bool now_playing = queue && now_playing_changed_.first;
+  if (track || now_playing) {
+    media_interface_->GetNowPlayingList(
+        base::Bind(&Device::MediaUpdateNowPlayingResponse,
+                   weak_ptr_factory_.GetWeakPtr(), track, now_playing));
+  }
+
+  bool status = play_status && play_status_changed_.first;
+  bool pos = play_status && !is_silence && play_pos_changed_.first;
+  if (status || pos) {
+    media_interface_->GetPlayStatus(
+        base::Bind(&Device::MediaUpdatePlayStatusResponse,
+                   weak_ptr_factory_.GetWeakPtr(), status, pos));
+  }
+}
+
+void Device::MediaUpdateNowPlayingResponse(bool track, bool now_playing,
+                                           std::string curr_song_id,
+                                           std::vector<SongInfo> song_list) {
+  if (now_playing && now_playing_changed_.first) {
+    HandleNowPlayingNotificationResponse(now_playing_changed_.second, false,
+                                         curr_song_id, song_list);
   }
 
-  if (metadata) HandleTrackUpdate();
+  if (track && track_changed_.first) {
+    TrackChangedNotificationResponse(track_changed_.second, false,
+                                     std::move(curr_song_id),
+                                     std::move(song_list));
+  }
+}
+
+void Device::MediaUpdatePlayStatusResponse(bool status, bool pos,
+                                           PlayStatus play_status) {
+  if (status && play_status_changed_.first) {
+    PlaybackStatusNotificationResponse(play_status_changed_.second, false,
+                                       play_status);
+  }
+
+  if (pos && play_pos_changed_.first) {
+    PlaybackPosNotificationResponse(play_pos_changed_.second, false,
+                                    play_status);
+  }
 }
 
 void Device::SendFolderUpdate(bool available_players, bool addressed_player,
@@ -1352,6 +1509,14 @@ void Device::SendFolderUpdate(bool available_players, bool addressed_player,
   CHECK(media_interface_);
   DEVICE_VLOG(4) << __func__;
 
+  if (available_players || uids) {
+    browse_cache_.ClearFolders();
+  }
+
+  if (addressed_player) {
+    browse_cache_.ClearNowPlaying();
+  }
+
   if (available_players) {
     HandleAvailablePlayerUpdate();
   }
@@ -1412,6 +1577,7 @@ void Device::HandleNowPlayingNotificationResponse(
   for (const SongInfo& song : song_list) {
     now_playing_ids_.insert(song.media_id);
   }
+  browse_cache_.PutNowPlaying(curr_song_id, song_list);
 
   auto response =
       RegisterNotificationResponseBuilder::MakeNowPlayingBuilder(interim);
@@ -1469,6 +1635,7 @@ void Device::HandleAddressedPlayerUpdate() {
 void Device::DeviceDisconnected() {
   DEVICE_LOG(INFO) << "Device was disconnected";
   play_pos_update_cb_.Cancel();
+  browse_cache_.Clear();
 
   // TODO (apanicke): Once the interfaces are set in the Device construction,
   // remove these conditionals.
@@ -1505,6 +1672,8 @@ std::ostream& operator<<(std::ostream& out, const Device& d) {
   }
   out << "Last Play State: " << d.last_play_status_.state << std::endl;
   out << "Last Song Sent ID: \"" << d.last_song_info_.media_id << "\"\n";
+  out << "Notifications: sent=" << d.notifications_sent_
+      << " suppressed=" << d.notifications_suppressed_ << std::endl;
   out << "Current Folder: \"" << d.CurrentFolder() << "\"\n";
   out << "MTU Sizes: CTRL=" << d.ctrl_mtu_ << " BROWSE=" << d.browse_mtu_
       << std::endl;
@@ -22,6 +22,7 @@
 
 #include <base/bind.h>
 #include <base/cancelable_callback.h>
+#include <base/time/time.h>
 
 #include "avrcp_internal.h"
 #include "hardware/avrcp/avrcp.h"
@@ -38,6 +39,7 @@
 #include "packet/avrcp/set_addressed_player.h"
 #include "packet/avrcp/set_browsed_player.h"
 #include "packet/avrcp/vendor_packet.h"
+#include "profile/avrcp/browse_cache.h"
 #include "profile/avrcp/media_id_map.h"
 #include "raw_address.h"
 
@@ -180,6 +182,14 @@ class Device {
   virtual void PlaybackStatusNotificationResponse(uint8_t label, bool interim,
                                                   PlayStatus status);
 
+  // MEDIA UPDATES
+  // Dispatch one media layer fetch to every notification an update affects
+  virtual void MediaUpdateNowPlayingResponse(bool track, bool now_playing,
+                                             std::string curr_song_id,
+                                             std::vector<SongInfo> song_list);
+  virtual void MediaUpdatePlayStatusResponse(bool status, bool pos,
+                                             PlayStatus play_status);
+
   // GET ELEMENT ATTRIBUTE
   // TODO (apanicke): Add a Handler function for this so if a specific device
   // needs to implement an interop fix, you only need to overload the one
@@ -292,6 +302,29 @@ class Device {
     active_labels_.erase(label);
     send_message_cb_.Run(label, browse, std::move(message));
   }
+
+  // Whether a play position has to be notified right away rather than at the
+  // next play position interval
+  bool IsPlayPosDiscontinuity(const PlayStatus& status, uint64_t elapsed_ms,
+                              uint64_t interval_ms) const;
+  void QueuePlayPosUpdate(uint64_t delay_ms);
+
+  // Get the items of the current folder for a browsing request. They come
+  // from the browse cache unless |refresh| is set or the folder is not
+  // cached.
+  void GetCurrentFolderItems(MediaInterface::FolderItemsCallback folder_cb,
+                             bool refresh);
+  void CurrentFolderItemsFetched(int player_id, std::string folder_id,
+                                 MediaInterface::FolderItemsCallback folder_cb,
+                                 std::vector<ListItem> items);
+
+  // Get the now playing list for a browsing request, from the browse cache
+  // if possible.
+  void GetBrowsedNowPlayingList(MediaInterface::NowPlayingCallback cb);
+  void BrowsedNowPlayingListFetched(MediaInterface::NowPlayingCallback cb,
+                                    std::string curr_song_id,
+                                    std::vector<SongInfo> song_list);
+
   base::WeakPtrFactory<Device> weak_ptr_factory_;
 
   // TODO (apanicke): Initialize all the variables in the constructor.
@@ -323,12 +356,21 @@ class Device {
 
   MediaIdMap vfs_ids_;
   MediaIdMap now_playing_ids_;
+  BrowseCache browse_cache_;
 
   uint32_t play_pos_interval_ = 0;
 
   SongInfo last_song_info_;
   PlayStatus last_play_status_;
 
+  // The last notified track, and the state and time of the last notified play
+  // position, used to suppress redundant changed notifications
+  SongInfo last_track_info_;
+  PlayState last_play_pos_state_ = PlayState::STOPPED;
+  base::TimeTicks last_play_pos_time_;
+  uint32_t notifications_sent_ = 0;
+  uint32_t notifications_suppressed_ = 0;
+
   base::CancelableClosure play_pos_update_cb_;
 
   MediaInterface* media_interface_ = nullptr;
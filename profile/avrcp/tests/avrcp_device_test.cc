@@ -135,11 +135,13 @@ TEST_F(AvrcpDeviceTest, trackChangedTest) {
                     AttributeEntry(Attribute::GENRE, "Test Genre"),
                     AttributeEntry(Attribute::PLAYING_TIME, "1000"),
                     AttributeEntry(Attribute::DEFAULT_COVER_ART, "0000001")}};
-  std::vector<SongInfo> list = {info};
+  SongInfo info2 = {"test_id2", {AttributeEntry(Attribute::TITLE, "Song 2")}};
+  std::vector<SongInfo> list = {info, info2};
 
   EXPECT_CALL(interface, GetNowPlayingList(_))
       .Times(2)
-      .WillRepeatedly(InvokeCb<0>("test_id", list));
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(InvokeCb<0>("test_id2", list));
 
   // Test the interim response for track changed
   auto interim_response =
@@ -156,7 +158,7 @@ TEST_F(AvrcpDeviceTest, trackChangedTest) {
 
   // Test the changed response for track changed
   auto changed_response =
-      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x01);
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x02);
   EXPECT_CALL(response_cb,
               Call(1, false, matchPacket(std::move(changed_response))))
       .Times(1);
@@ -164,6 +166,47 @@ TEST_F(AvrcpDeviceTest, trackChangedTest) {
   test_device->HandleTrackUpdate();
 }
 
+TEST_F(AvrcpDeviceTest, trackUnchangedTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  SongInfo info = {"test_id", {AttributeEntry(Attribute::TITLE, "Song")}};
+  SongInfo renamed = {"test_id", {AttributeEntry(Attribute::TITLE, "Name")}};
+  std::vector<SongInfo> list = {info};
+  std::vector<SongInfo> renamed_list = {renamed};
+
+  EXPECT_CALL(interface, GetNowPlayingList(_))
+      .Times(3)
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(InvokeCb<0>("test_id", renamed_list));
+
+  auto interim_response =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(true, 0x01);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(interim_response))))
+      .Times(1);
+
+  auto request =
+      RegisterNotificationRequestBuilder::MakeBuilder(Event::TRACK_CHANGED, 0);
+  auto pkt = TestAvrcpPacket::Make();
+  request->Serialize(pkt);
+  SendMessage(1, pkt);
+
+  // An update with the same track and metadata isn't sent
+  test_device->HandleTrackUpdate();
+
+  // Updated metadata for the same track is
+  auto changed_response =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x01);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(changed_response))))
+      .Times(1);
+  test_device->HandleTrackUpdate();
+}
+
 TEST_F(AvrcpDeviceTest, playStatusTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -270,7 +313,8 @@ TEST_F(AvrcpDeviceTest, trackChangedBeforeInterimTest) {
                     AttributeEntry(Attribute::GENRE, "Test Genre"),
                     AttributeEntry(Attribute::PLAYING_TIME, "1000"),
                     AttributeEntry(Attribute::DEFAULT_COVER_ART, "0000001")}};
-  std::vector<SongInfo> list = {info};
+  SongInfo info2 = {"test_id2", {AttributeEntry(Attribute::TITLE, "Song 2")}};
+  std::vector<SongInfo> list = {info, info2};
 
   MediaInterface::NowPlayingCallback interim_cb;
   MediaInterface::NowPlayingCallback changed_cb;
@@ -288,7 +332,7 @@ TEST_F(AvrcpDeviceTest, trackChangedBeforeInterimTest) {
               Call(1, false, matchPacket(std::move(interim_response))))
       .Times(1);
   auto changed_response =
-      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x01);
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x02);
   EXPECT_CALL(response_cb,
               Call(1, false, matchPacket(std::move(changed_response))))
       .Times(1);
@@ -308,7 +352,59 @@ TEST_F(AvrcpDeviceTest, trackChangedBeforeInterimTest) {
 
   // Try to send track changed update, should succeed
   test_device->HandleTrackUpdate();
-  changed_cb.Run("test_id", list);
+  changed_cb.Run("test_id2", list);
+}
+
+TEST_F(AvrcpDeviceTest, mediaUpdateSingleFetchTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  SongInfo info = {"test_id", {AttributeEntry(Attribute::TITLE, "Song")}};
+  SongInfo info2 = {"test_id2", {AttributeEntry(Attribute::TITLE, "Song 2")}};
+  std::vector<SongInfo> list = {info, info2};
+
+  // One fetch for each registration, then one for the update
+  EXPECT_CALL(interface, GetNowPlayingList(_))
+      .Times(3)
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(InvokeCb<0>("test_id", list))
+      .WillOnce(InvokeCb<0>("test_id2", list));
+
+  auto track_interim =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(true, 0x01);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(track_interim))))
+      .Times(1);
+  auto request =
+      RegisterNotificationRequestBuilder::MakeBuilder(Event::TRACK_CHANGED, 0);
+  auto pkt = TestAvrcpPacket::Make();
+  request->Serialize(pkt);
+  SendMessage(1, pkt);
+
+  auto now_playing_interim =
+      RegisterNotificationResponseBuilder::MakeNowPlayingBuilder(true);
+  EXPECT_CALL(response_cb,
+              Call(2, false, matchPacket(std::move(now_playing_interim))))
+      .Times(1);
+  request = RegisterNotificationRequestBuilder::MakeBuilder(
+      Event::NOW_PLAYING_CONTENT_CHANGED, 0);
+  pkt = TestAvrcpPacket::Make();
+  request->Serialize(pkt);
+  SendMessage(2, pkt);
+
+  auto now_playing_changed =
+      RegisterNotificationResponseBuilder::MakeNowPlayingBuilder(false);
+  EXPECT_CALL(response_cb,
+              Call(2, false, matchPacket(std::move(now_playing_changed))))
+      .Times(1);
+  auto track_changed =
+      RegisterNotificationResponseBuilder::MakeTrackChangedBuilder(false, 0x02);
+  EXPECT_CALL(response_cb,
+              Call(1, false, matchPacket(std::move(track_changed))))
+      .Times(1);
+  test_device->SendMediaUpdate(true, false, true);
 }
 
 TEST_F(AvrcpDeviceTest, playStatusChangedBeforeInterimTest) {
@@ -978,8 +1074,9 @@ TEST_F(AvrcpDeviceTest, changePathTest) {
   ListItem item3 = {ListItem::FOLDER, info3, SongInfo()};
   ListItem item4 = {ListItem::FOLDER, info4, SongInfo()};
   std::vector<ListItem> list1 = {item2, item3, item4};
+  // Changing into a folder refreshes it, browsing it is served from the cache
   EXPECT_CALL(interface, GetFolderItems(_, "test_id1", _))
-      .Times(3)
+      .Times(2)
       .WillRepeatedly(InvokeCb<2>(list1));
 
   std::vector<ListItem> list2 = {};
@@ -1051,6 +1148,62 @@ TEST_F(AvrcpDeviceTest, changePathTest) {
   SendBrowseMessage(5, request);
 }
 
+TEST_F(AvrcpDeviceTest, browseCacheTest) {
+  MockMediaInterface interface;
+  NiceMock<MockA2dpInterface> a2dp_interface;
+
+  test_device->RegisterInterfaces(&interface, &a2dp_interface, nullptr);
+
+  FolderInfo info0 = {"test_id0", true, "Test Folder0"};
+  FolderInfo info1 = {"test_id1", true, "Test Folder1"};
+  FolderInfo info2 = {"test_id2", true, "Test Folder2"};
+  ListItem item0 = {ListItem::FOLDER, info0, SongInfo()};
+  ListItem item1 = {ListItem::FOLDER, info1, SongInfo()};
+  ListItem item2 = {ListItem::FOLDER, info2, SongInfo()};
+  std::vector<ListItem> list = {item0, item1, item2};
+
+  // The folder is fetched once, then once more after the UIDs changed
+  EXPECT_CALL(interface, GetFolderItems(_, "", _))
+      .Times(2)
+      .WillRepeatedly(InvokeCb<2>(list));
+
+  // Page through the folder one item at a time
+  for (uint8_t i = 0; i < list.size(); i++) {
+    auto folder_items_response = GetFolderItemsResponseBuilder::MakeVFSBuilder(
+        Status::NO_ERROR, 0x0000, 0xFFFF);
+    folder_items_response->AddFolder(
+        FolderItem(i + 1, 0, true, list[i].folder.name));
+    EXPECT_CALL(response_cb,
+                Call(i + 1, true,
+                     matchPacket(std::move(folder_items_response))))
+        .Times(1);
+
+    auto folder_request_builder =
+        GetFolderItemsRequestBuilder::MakeBuilder(Scope::VFS, i, i, {});
+    auto request = TestBrowsePacket::Make();
+    folder_request_builder->Serialize(request);
+    SendBrowseMessage(i + 1, request);
+  }
+
+  auto total_items_response = GetTotalNumberOfItemsResponseBuilder::MakeBuilder(
+      Status::NO_ERROR, 0, list.size());
+  EXPECT_CALL(response_cb,
+              Call(4, true, matchPacket(std::move(total_items_response))))
+      .Times(1);
+  SendBrowseMessage(
+      4, TestBrowsePacket::Make(get_total_number_of_items_request_vfs));
+
+  test_device->SendFolderUpdate(false, false, true);
+
+  total_items_response = GetTotalNumberOfItemsResponseBuilder::MakeBuilder(
+      Status::NO_ERROR, 0, list.size());
+  EXPECT_CALL(response_cb,
+              Call(5, true, matchPacket(std::move(total_items_response))))
+      .Times(1);
+  SendBrowseMessage(
+      5, TestBrowsePacket::Make(get_total_number_of_items_request_vfs));
+}
+
 TEST_F(AvrcpDeviceTest, getItemAttributesNowPlayingTest) {
   MockMediaInterface interface;
   NiceMock<MockA2dpInterface> a2dp_interface;
@@ -448,6 +448,8 @@ const btgatt_client_callbacks_t gatt_client_callbacks = {
     nullptr, /* phy_update_cb */
     nullptr, /* conn_update_cb */
     nullptr, /* service_changed_cb*/
+    nullptr, /* notify_batch_cb */
+    nullptr, /* write_stream_progress_cb */
 };
 
 const btgatt_scanner_callbacks_t gatt_scanner_callbacks = {
@@ -19,8 +19,12 @@
 #include <mutex>
 #include <shared_mutex>
 
+#include <base/bind.h>
+#include <base/location.h>
 #include <base/logging.h>
 #include <base/observer_list.h>
+#include <base/threading/thread_task_runner_handle.h>
+#include <base/time/time.h>
 
 #include "abstract_observer_list.h"
 #include "service/hal/bluetooth_interface.h"
@@ -59,6 +63,28 @@ GetClientObservers();
 btbase::AbstractObserverList<BluetoothGattInterface::ServerObserver>*
 GetServerObservers();
 
+// Source of the generations of deferred scan reconfigurations. Guarded by the
+// |scan_clients_lock_| of the instance that schedules them.
+uint64_t g_reconfigure_generation = 0;
+
+// Scan on the LE 1M PHY.
+constexpr int kScanPhyLe1M = 1;
+
+// Returns true if |lhs| scans a larger share of the time than |rhs|, or as
+// much with a shorter interval.
+bool HasHigherDutyCycle(const BluetoothGattInterface::ScanParams& lhs,
+                        const BluetoothGattInterface::ScanParams& rhs) {
+  if (rhs.scan_window == 0) return lhs.scan_window != 0;
+  uint64_t lhs_duty = (uint64_t)lhs.scan_window * rhs.scan_interval;
+  uint64_t rhs_duty = (uint64_t)rhs.scan_window * lhs.scan_interval;
+  if (lhs_duty != rhs_duty) return lhs_duty > rhs_duty;
+  return lhs.scan_window != 0 && lhs.scan_interval < rhs.scan_interval;
+}
+
+void SetScanParametersCallback(uint8_t status) {
+  if (status != 0) LOG(ERROR) << "Failed to set scan parameters: " << +status;
+}
+
 #define FOR_EACH_SCANNER_OBSERVER(func)           \
   for (auto& observer : *GetScannerObservers()) { \
     observer.func;                                \
@@ -405,6 +431,8 @@ const btgatt_client_callbacks_t gatt_client_callbacks = {
     nullptr,
     nullptr,
     nullptr,  // service_changed_cb
+    nullptr,  // notify_batch_cb
+    nullptr,  // write_stream_progress_cb
 };
 
 const btgatt_server_callbacks_t gatt_server_callbacks = {
@@ -777,23 +805,13 @@ void BluetoothGattInterface::InitializeForTesting(
   g_interface = test_instance;
 }
 
-bt_status_t BluetoothGattInterface::StartScan(int client_id) {
+bt_status_t BluetoothGattInterface::StartScan(int client_id,
+                                              const ScanParams& params) {
   lock_guard<mutex> lock(scan_clients_lock_);
 
-  // Scan already initiated for this client.
-  if (scan_client_set_.find(client_id) != scan_client_set_.end()) {
-    // Assume starting scan multiple times is not error, but warn user.
-    LOG(WARNING) << "Scan already initiated for client";
-    return BT_STATUS_SUCCESS;
-  }
-
-  // If this is the first scan client, then make a call into the stack. We
-  // only do this when the reference count changes to or from 0.
-  if (scan_client_set_.empty()) {
-    GetScannerHALInterface()->Scan(true);
-  }
-
-  scan_client_set_.insert(client_id);
+  // Starting a scan again for a client only updates its request.
+  scan_clients_[client_id] = params;
+  UpdateScanLocked(true);
 
   return BT_STATUS_SUCCESS;
 }
@@ -802,19 +820,90 @@ bt_status_t BluetoothGattInterface::StopScan(int client_id) {
   lock_guard<mutex> lock(scan_clients_lock_);
 
   // Scan not initiated for this client.
-  auto iter = scan_client_set_.find(client_id);
-  if (iter == scan_client_set_.end()) {
+  if (scan_clients_.erase(client_id) == 0) {
     // Assume stopping scan multiple times is not error, but warn user.
     LOG(WARNING) << "Scan already stopped or not initiated for client";
     return BT_STATUS_SUCCESS;
   }
 
-  if (scan_client_set_.size() == 1) {
+  UpdateScanLocked(true);
+  return BT_STATUS_SUCCESS;
+}
+
+void BluetoothGattInterface::UpdateScanLocked(bool defer_decrease) {
+  ScanParams merged = {0, 0};
+  for (const auto& client : scan_clients_) {
+    if (HasHigherDutyCycle(client.second, merged)) merged = client.second;
+  }
+
+  // Only make a call into the stack to start or stop the scan when the first
+  // client asks for it or the last one goes away.
+  if (merged.scan_window == 0) {
+    pending_reconfigure_ = 0;
+    if (scanning_) {
+      GetScannerHALInterface()->Scan(false);
+      scanning_ = false;
+    }
+    return;
+  }
+
+  if (!scanning_) {
+    pending_reconfigure_ = 0;
+    ApplyScanParamsLocked(merged);
+    GetScannerHALInterface()->Scan(true);
+    scanning_ = true;
+    return;
+  }
+
+  if (!HasHigherDutyCycle(merged, applied_scan_params_) &&
+      !HasHigherDutyCycle(applied_scan_params_, merged)) {
+    // The current scan already satisfies every client.
+    pending_reconfigure_ = 0;
+    return;
+  }
+
+  if (defer_decrease && HasHigherDutyCycle(applied_scan_params_, merged)) {
+    if (pending_reconfigure_ != 0) return;
+    if (!base::ThreadTaskRunnerHandle::IsSet()) {
+      LOG(WARNING) << "No task runner to defer the scan reconfiguration";
+    } else {
+      pending_reconfigure_ = ++g_reconfigure_generation;
+      base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+          FROM_HERE,
+          base::Bind(&BluetoothGattInterface::ReconfigureScan,
+                     pending_reconfigure_),
+          base::TimeDelta::FromMilliseconds(kScanReconfigureDelayMs));
+      return;
+    }
+  }
+
+  pending_reconfigure_ = 0;
+  ApplyScanParamsLocked(merged);
+}
+
+void BluetoothGattInterface::ApplyScanParamsLocked(const ScanParams& params) {
+  VLOG(1) << __func__ << " - interval: " << params.scan_interval
+          << " window: " << params.scan_window;
+
+  // The parameters are only picked up when the scan starts.
+  GetScannerHALInterface()->SetScanParameters(
+      kScanPhyLe1M, {params.scan_interval}, {params.scan_window},
+      base::Bind(&SetScanParametersCallback));
+  if (scanning_) {
     GetScannerHALInterface()->Scan(false);
+    GetScannerHALInterface()->Scan(true);
   }
+  applied_scan_params_ = params;
+}
 
-  scan_client_set_.erase(iter);
-  return BT_STATUS_SUCCESS;
+// static
+void BluetoothGattInterface::ReconfigureScan(uint64_t generation) {
+  shared_lock<shared_mutex_impl> instance_lock(g_instance_lock);
+  if (!g_interface) return;
+
+  lock_guard<mutex> lock(g_interface->scan_clients_lock_);
+  if (g_interface->pending_reconfigure_ != generation) return;
+  g_interface->UpdateScanLocked(false);
 }
 
 }  // namespace hal
@@ -16,8 +16,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <mutex>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 #include <base/macros.h>
@@ -242,20 +243,54 @@ class BluetoothGattInterface {
   // structure.
   virtual const btgatt_server_interface_t* GetServerHALInterface() const = 0;
 
+  // Scan duty cycle requested by a scan client, in units of 0.625 ms. A zero
+  // |scan_window| marks an opportunistic client, which receives the results
+  // of the scans started by the other clients but never scans on its own.
+  struct ScanParams {
+    uint32_t scan_interval;
+    uint32_t scan_window;
+  };
+
   // Initiates a regular BLE device scan. This is called internally from each
-  // LowEnergyClient. This function synchronizes the scan requests and maintains
-  // an internal reference count for each scan client that is interested.
-  bt_status_t StartScan(int client_id);
+  // LowEnergyScanner. This function arbitrates between the requests of all
+  // the scan clients: the controller is programmed once with the highest duty
+  // cycle any of them asks for, and is only restarted when that changes.
+  // Calling StartScan() again for the same client updates its request.
+  //
+  // A scan is restarted right away when the duty cycle goes up. When it goes
+  // down, the restart is deferred by |kScanReconfigureDelayMs| so that clients
+  // coming and going in quick succession cost at most one restart.
+  bt_status_t StartScan(int client_id, const ScanParams& params);
   bt_status_t StopScan(int client_id);
 
+  // Delay before the scan is reconfigured with a lower duty cycle.
+  static constexpr int kScanReconfigureDelayMs = 2000;
+
  protected:
   BluetoothGattInterface() = default;
   virtual ~BluetoothGattInterface() = default;
 
  private:
-  // Used to keep a reference count for the different BLE scan clients.
+  // Brings the controller scan in line with the requests in |scan_clients_|.
+  // A duty cycle decrease is deferred if |defer_decrease| is true.
+  void UpdateScanLocked(bool defer_decrease);
+
+  // Programs |params| and restarts the scan if it is running.
+  void ApplyScanParamsLocked(const ScanParams& params);
+
+  // Runs a deferred reconfiguration unless it was superseded.
+  static void ReconfigureScan(uint64_t generation);
+
+  // The requests of the different BLE scan clients, by client id.
   std::mutex scan_clients_lock_;
-  std::unordered_set<int> scan_client_set_;
+  std::unordered_map<int, ScanParams> scan_clients_;
+
+  // The state the controller was last programmed with.
+  bool scanning_ = false;
+  ScanParams applied_scan_params_ = {0, 0};
+
+  // Generation of the deferred reconfiguration, 0 if none is pending.
+  uint64_t pending_reconfigure_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(BluetoothGattInterface);
 };
@@ -129,6 +129,7 @@ btgatt_client_interface_t fake_btgattc_iface = {
     nullptr,  // read_phy
     nullptr,  // test_command
     nullptr,  // get_gatt_db
+    nullptr,  // write_characteristic_stream
 };
 
 btgatt_server_interface_t fake_btgatts_iface = {
@@ -143,6 +144,7 @@ btgatt_server_interface_t fake_btgatts_iface = {
     FakeSendResponse,
     nullptr,  // set_phy
     nullptr,  // read_phy
+    nullptr,  // set_attribute_cache
 };
 
 }  // namespace
@@ -16,9 +16,12 @@
 
 #include "service/ipc/binder/bluetooth_le_scanner_binder_server.h"
 
+#include <base/bind.h>
+#include <base/location.h>
 #include <base/logging.h>
 
 #include "service/adapter.h"
+#include "service/daemon.h"
 
 using android::String8;
 using android::String16;
@@ -29,6 +32,10 @@ namespace binder {
 
 namespace {
 const int kInvalidInstanceId = -1;
+
+// Batches are delivered early once they hold this many results, to keep
+// transactions well below the binder buffer size.
+const size_t kMaxBatchSize = 64;
 }  // namespace
 
 BluetoothLeScannerBinderServer::BluetoothLeScannerBinderServer(
@@ -52,12 +59,20 @@ Status BluetoothLeScannerBinderServer::RegisterScanner(
 
 Status BluetoothLeScannerBinderServer::UnregisterScanner(int scanner_id) {
   VLOG(2) << __func__;
+  {
+    std::lock_guard<std::mutex> lock(*maps_lock());
+    pending_results_.erase(scanner_id);
+  }
   UnregisterInstanceBase(scanner_id);
   return Status::ok();
 }
 
 Status BluetoothLeScannerBinderServer::UnregisterAll() {
   VLOG(2) << __func__;
+  {
+    std::lock_guard<std::mutex> lock(*maps_lock());
+    pending_results_.clear();
+  }
   UnregisterAllBase();
   return Status::ok();
 }
@@ -97,6 +112,9 @@ Status BluetoothLeScannerBinderServer::StopScan(int scanner_id,
     return Status::ok();
   }
 
+  // Deliver what was found before the scan stopped
+  FlushScanResultsLocked(scanner_id);
+
   *_aidl_return = scanner->StopScan();
   return Status::ok();
 }
@@ -113,7 +131,49 @@ void BluetoothLeScannerBinderServer::OnScanResult(
     return;
   }
 
-  cb->OnScanResult(result);
+  base::TimeDelta report_delay = scanner->scan_settings().report_delay();
+  if (report_delay <= base::TimeDelta()) {
+    cb->OnScanResult(result);
+    return;
+  }
+
+  auto& batch = pending_results_[scanner_id];
+  batch.push_back(result);
+  if (batch.size() >= kMaxBatchSize) {
+    FlushScanResultsLocked(scanner_id);
+  } else if (batch.size() == 1) {
+    bluetooth::Daemon::Get()->GetMessageLoop()->task_runner()->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&BluetoothLeScannerBinderServer::FlushScanResults,
+                   android::sp<BluetoothLeScannerBinderServer>(this),
+                   scanner_id),
+        report_delay);
+  }
+}
+
+// static
+void BluetoothLeScannerBinderServer::FlushScanResults(
+    android::sp<BluetoothLeScannerBinderServer> server, int scanner_id) {
+  std::lock_guard<std::mutex> lock(*server->maps_lock());
+  server->FlushScanResultsLocked(scanner_id);
+}
+
+void BluetoothLeScannerBinderServer::FlushScanResultsLocked(int scanner_id) {
+  auto iter = pending_results_.find(scanner_id);
+  if (iter == pending_results_.end()) return;
+
+  std::vector<android::bluetooth::ScanResult> batch;
+  batch.swap(iter->second);
+  pending_results_.erase(iter);
+  if (batch.empty()) return;
+
+  auto cb = GetLECallback(scanner_id);
+  if (!cb.get()) {
+    VLOG(2) << "Scanner was unregistered - scanner_id: " << scanner_id;
+    return;
+  }
+
+  cb->OnBatchScanResults(batch);
 }
 
 android::sp<IBluetoothLeScannerCallback>
@@ -17,10 +17,13 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <base/macros.h>
 
 #include <android/bluetooth/IBluetoothLeScannerCallback.h>
+#include <android/bluetooth/scan_result.h>
 #include "android/bluetooth/BnBluetoothLeScanner.h"
 
 #include "service/common/bluetooth/low_energy_constants.h"
@@ -61,10 +64,20 @@ class BluetoothLeScannerBinderServer
                    bool* _aidl_return) override;
   Status StopScan(int scanner_id, bool* _aidl_return) override;
 
+  // Results of scans started with a non-zero report delay are delivered in
+  // batches through OnBatchScanResults, one transaction per report delay.
   void OnScanResult(bluetooth::LowEnergyScanner* scanner,
                     const bluetooth::ScanResult& result) override;
 
  private:
+  // Delivers the pending results of |scanner_id| in one transaction. Posted
+  // on the daemon main loop with a reference that keeps |server| alive.
+  static void FlushScanResults(
+      android::sp<BluetoothLeScannerBinderServer> server, int scanner_id);
+
+  // Same as above, with maps_lock() already held.
+  void FlushScanResultsLocked(int scanner_id);
+
   // Returns a pointer to the IBluetoothLowEnergyCallback instance associated
   // with |scanner_id|. Returns NULL if such a callback cannot be found.
   android::sp<IBluetoothLeScannerCallback> GetLECallback(int scanner_id);
@@ -80,6 +93,11 @@ class BluetoothLeScannerBinderServer
 
   bluetooth::Adapter* adapter_;  // weak
 
+  // Results of batched scans waiting to be delivered, per scanner ID. Guarded
+  // by maps_lock().
+  std::unordered_map<int, std::vector<android::bluetooth::ScanResult>>
+      pending_results_;
+
   DISALLOW_COPY_AND_ASSIGN(BluetoothLeScannerBinderServer);
 };
 
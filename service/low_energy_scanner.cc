@@ -18,6 +18,7 @@
 
 #include "service/adapter.h"
 #include "service/logging_helpers.h"
+#include "stack/include/advertise_data_parser.h"
 #include "stack/include/bt_types.h"
 #include "stack/include/hcidefs.h"
 
@@ -61,6 +62,100 @@ size_t GetScanRecordLength(std::vector<uint8_t> bytes) {
   return kScanRecordLength;
 }
 
+// Returns the scan duty cycle of |mode|, in units of 0.625 ms.
+hal::BluetoothGattInterface::ScanParams GetScanParams(ScanSettings::Mode mode) {
+  switch (mode) {
+    case ScanSettings::MODE_OPPORTUNISTIC:
+      return {8192, 0};
+    case ScanSettings::MODE_BALANCED:
+      return {6554, 1638};  // 4096 ms / 1024 ms
+    case ScanSettings::MODE_LOW_LATENCY:
+      return {6554, 6554};  // 4096 ms / 4096 ms
+    case ScanSettings::MODE_LOW_POWER:
+    default:
+      return {8192, 819};  // 5120 ms / 512 ms
+  }
+}
+
+// Returns true if one of the service Uuids advertised in the field of |type|
+// matches |uuid| on the bits set in |mask|.
+bool MatchesServiceUuid(const AdIndex& ad_index, uint8_t type, size_t uuid_len,
+                        const Uuid::UUID128Bit& uuid,
+                        const Uuid::UUID128Bit& mask) {
+  uint8_t len = 0;
+  const uint8_t* p = ad_index.GetFieldByType(type, &len);
+  for (; p != nullptr && len >= uuid_len; p += uuid_len, len -= uuid_len) {
+    Uuid advertised;
+    if (uuid_len == Uuid::kNumBytes16)
+      advertised = Uuid::From16Bit(p[0] | (p[1] << 8));
+    else if (uuid_len == Uuid::kNumBytes32)
+      advertised = Uuid::From32Bit(p[0] | (p[1] << 8) | (p[2] << 16) |
+                                   ((uint32_t)p[3] << 24));
+    else
+      advertised = Uuid::From128BitLE(p);
+
+    const Uuid::UUID128Bit& bytes = advertised.To128BitBE();
+    bool matched = true;
+    for (size_t i = 0; i < bytes.size(); i++) {
+      if ((bytes[i] & mask[i]) != (uuid[i] & mask[i])) {
+        matched = false;
+        break;
+      }
+    }
+    if (matched) return true;
+  }
+  return false;
+}
+
+// Returns true if the result from |bda| with the advertising data indexed by
+// |ad_index| matches all the fields set in |filter|.
+bool MatchesFilter(const ScanFilter& filter, const RawAddress& bda,
+                   const AdIndex& ad_index) {
+  if (!filter.device_address().empty()) {
+    RawAddress address;
+    if (!RawAddress::FromString(filter.device_address(), address) ||
+        address != bda)
+      return false;
+  }
+
+  if (!filter.device_name().empty()) {
+    uint8_t len = 0;
+    const uint8_t* p =
+        ad_index.GetFieldByType(HCI_EIR_COMPLETE_LOCAL_NAME_TYPE, &len);
+    if (p == nullptr)
+      p = ad_index.GetFieldByType(HCI_EIR_SHORTENED_LOCAL_NAME_TYPE, &len);
+    if (p == nullptr ||
+        filter.device_name() != std::string(reinterpret_cast<const char*>(p),
+                                            len))
+      return false;
+  }
+
+  if (filter.service_uuid()) {
+    const Uuid::UUID128Bit& uuid = filter.service_uuid()->To128BitBE();
+    Uuid::UUID128Bit mask;
+    if (filter.service_uuid_mask())
+      mask = filter.service_uuid_mask()->To128BitBE();
+    else
+      mask.fill(0xff);
+
+    if (!MatchesServiceUuid(ad_index, HCI_EIR_MORE_16BITS_UUID_TYPE,
+                            Uuid::kNumBytes16, uuid, mask) &&
+        !MatchesServiceUuid(ad_index, HCI_EIR_COMPLETE_16BITS_UUID_TYPE,
+                            Uuid::kNumBytes16, uuid, mask) &&
+        !MatchesServiceUuid(ad_index, HCI_EIR_MORE_32BITS_UUID_TYPE,
+                            Uuid::kNumBytes32, uuid, mask) &&
+        !MatchesServiceUuid(ad_index, HCI_EIR_COMPLETE_32BITS_UUID_TYPE,
+                            Uuid::kNumBytes32, uuid, mask) &&
+        !MatchesServiceUuid(ad_index, HCI_EIR_MORE_128BITS_UUID_TYPE,
+                            Uuid::kNumBytes128, uuid, mask) &&
+        !MatchesServiceUuid(ad_index, HCI_EIR_COMPLETE_128BITS_UUID_TYPE,
+                            Uuid::kNumBytes128, uuid, mask))
+      return false;
+  }
+
+  return true;
+}
+
 }  // namespace
 
 // LowEnergyScanner implementation
@@ -103,14 +198,20 @@ bool LowEnergyScanner::StartScan(const ScanSettings& settings,
     return false;
   }
 
-  // TODO(jpawlowski): Push settings and filtering logic below the HAL.
-  bt_status_t status =
-      hal::BluetoothGattInterface::Get()->StartScan(scanner_id_);
+  // The scan mode is arbitrated with the other clients below the HAL, while
+  // the filters are applied to this client's results only.
+  bt_status_t status = hal::BluetoothGattInterface::Get()->StartScan(
+      scanner_id_, GetScanParams(settings.mode()));
   if (status != BT_STATUS_SUCCESS) {
     LOG(ERROR) << "Failed to initiate scanning for client: " << scanner_id_;
     return false;
   }
 
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    scan_settings_ = settings;
+    scan_filters_ = filters;
+  }
   scan_started_ = true;
   return true;
 }
@@ -147,7 +248,22 @@ void LowEnergyScanner::ScanResultCallback(
   lock_guard<mutex> lock(delegate_mutex_);
   if (!delegate_) return;
 
-  // TODO(armansito): Apply software filters here.
+  // Drop the results this client did not ask for here, rather than waking it
+  // up for each of them.
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    if (!scan_filters_.empty()) {
+      AdIndex ad_index(adv_data);
+      bool matched = false;
+      for (const auto& filter : scan_filters_) {
+        if (MatchesFilter(filter, bda, ad_index)) {
+          matched = true;
+          break;
+        }
+      }
+      if (!matched) return;
+    }
+  }
 
   size_t record_len = GetScanRecordLength(adv_data);
   std::vector<uint8_t> scan_record(adv_data.begin(),
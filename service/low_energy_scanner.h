@@ -20,6 +20,7 @@
 #include <functional>
 #include <map>
 #include <mutex>
+#include <vector>
 
 #include <base/macros.h>
 #include <bluetooth/uuid.h>
@@ -71,13 +72,20 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   // |filters|. See the documentation for ScanSettings and ScanFilter for how
   // these parameters can be configured. Return true on success, false
   // otherwise. Please see logs for details in case of error.
+  //
+  // The filters are applied in the daemon: only the results that match at
+  // least one of them are passed to the delegate. An empty list matches all
+  // results. The scan itself is shared with the other clients and runs with
+  // the most demanding of their scan modes. Calling this while a scan is in
+  // progress updates its settings and filters.
   bool StartScan(const ScanSettings& settings,
                  const std::vector<ScanFilter>& filters);
 
   // Stops an ongoing BLE device scan for this client.
   bool StopScan();
 
-  // Returns the current scan settings.
+  // Returns the current scan settings. Must not be called concurrently with
+  // StartScan().
   const ScanSettings& scan_settings() const { return scan_settings_; }
 
   // BluetoothInstace overrides:
@@ -112,6 +120,9 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   // Current scan settings.
   ScanSettings scan_settings_;
 
+  // Filters of the current scan.
+  std::vector<ScanFilter> scan_filters_;
+
   // If true, then this client have a BLE device scan in progress.
   std::atomic_bool scan_started_;
 
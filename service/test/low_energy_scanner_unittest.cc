@@ -32,6 +32,8 @@ using ::testing::Pointee;
 using ::testing::DoAll;
 using ::testing::Invoke;
 using ::testing::SaveArg;
+using ::testing::ElementsAre;
+using ::testing::InSequence;
 
 namespace bluetooth {
 namespace {
@@ -359,5 +361,162 @@ TEST_F(LowEnergyScannerPostRegisterTest, ScanRecord) {
   le_scanner_->SetDelegate(nullptr);
 }
 
+TEST_F(LowEnergyScannerPostRegisterTest, ScanFilters) {
+  TestDelegate delegate;
+  le_scanner_->SetDelegate(&delegate);
+
+  // Flags, complete local name "Test", and the 16-bit service Uuid 0x180D.
+  std::vector<uint8_t> kNamedRecord({0x02, 0x01, 0x06, 0x05, 0x09, 'T', 'e',
+                                     's', 't', 0x03, 0x03, 0x0D, 0x18});
+  kNamedRecord.resize(62, 0x00);
+  std::vector<uint8_t> kAnonymousRecord({0x02, 0x01, 0x06});
+  kAnonymousRecord.resize(62, 0x00);
+  const RawAddress kTestAddress0 = {{0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C}};
+  const RawAddress kTestAddress1 = {{0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0D}};
+  const int kTestRssi = 64;
+
+  EXPECT_CALL(mock_adapter_, IsEnabled()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_handler_, Scan(_)).WillRepeatedly(Return());
+
+  ScanSettings settings;
+  std::vector<ScanFilter> filters(2);
+  filters[0].set_device_name("Test");
+  ASSERT_TRUE(filters[1].SetDeviceAddress("01:02:03:0a:0b:0d"));
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+
+  // Matches the name filter.
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kNamedRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+
+  // Matches neither filter.
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kAnonymousRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+
+  // Matches the address filter.
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress1, kTestRssi,
+                                                 kAnonymousRecord);
+  EXPECT_EQ(2, delegate.scan_result_count());
+  EXPECT_EQ("01:02:03:0A:0B:0D", delegate.last_scan_result().device_address());
+
+  // A filter with several fields matches when all of them do.
+  filters.resize(1);
+  ASSERT_TRUE(filters[0].SetDeviceAddress("01:02:03:0A:0B:0D"));
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kNamedRecord);
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress1, kTestRssi,
+                                                 kAnonymousRecord);
+  EXPECT_EQ(2, delegate.scan_result_count());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress1, kTestRssi,
+                                                 kNamedRecord);
+  EXPECT_EQ(3, delegate.scan_result_count());
+
+  // Service Uuid, exact and masked.
+  filters[0] = ScanFilter();
+  filters[0].SetServiceUuid(Uuid::From16Bit(0x180F));
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kNamedRecord);
+  EXPECT_EQ(3, delegate.scan_result_count());
+
+  Uuid::UUID128Bit mask;
+  mask.fill(0xFF);
+  mask[3] = 0xF0;  // ignore the low nibble of the 16-bit Uuid
+  filters[0].SetServiceUuidWithMask(Uuid::From16Bit(0x180F),
+                                    Uuid::From128BitBE(mask));
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kNamedRecord);
+  EXPECT_EQ(4, delegate.scan_result_count());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kAnonymousRecord);
+  EXPECT_EQ(4, delegate.scan_result_count());
+
+  // No filters, everything goes through.
+  filters.clear();
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress0, kTestRssi,
+                                                 kAnonymousRecord);
+  EXPECT_EQ(5, delegate.scan_result_count());
+
+  le_scanner_->SetDelegate(nullptr);
+}
+
+TEST_F(LowEnergyScannerPostRegisterTest, ScanArbitration) {
+  std::unique_ptr<LowEnergyScanner> le_scanner2;
+  RegisterTestScanner([&](std::unique_ptr<LowEnergyScanner> scanner) {
+    le_scanner2 = std::move(scanner);
+  });
+
+  EXPECT_CALL(mock_adapter_, IsEnabled()).WillRepeatedly(Return(true));
+
+  std::vector<ScanFilter> filters;
+  ScanSettings low_power;
+  ScanSettings low_latency;
+  low_latency.set_mode(ScanSettings::MODE_LOW_LATENCY);
+  ScanSettings opportunistic;
+  opportunistic.set_mode(ScanSettings::MODE_OPPORTUNISTIC);
+
+  // An opportunistic client does not scan on its own.
+  EXPECT_CALL(*mock_handler_, SetScanParameters(_, _, _, _)).Times(0);
+  EXPECT_CALL(*mock_handler_, Scan(_)).Times(0);
+  ASSERT_TRUE(le_scanner2->StartScan(opportunistic, filters));
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  // The first client that does programs the controller and starts the scan.
+  {
+    InSequence seq;
+    EXPECT_CALL(*mock_handler_,
+                SetScanParameters(_, ElementsAre(8192), ElementsAre(819), _))
+        .Times(1);
+    EXPECT_CALL(*mock_handler_, Scan(true)).Times(1);
+  }
+  ASSERT_TRUE(le_scanner_->StartScan(low_power, filters));
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  // A request the current scan already satisfies changes nothing.
+  EXPECT_CALL(*mock_handler_, SetScanParameters(_, _, _, _)).Times(0);
+  EXPECT_CALL(*mock_handler_, Scan(_)).Times(0);
+  ASSERT_TRUE(le_scanner2->StartScan(low_power, filters));
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  // A more demanding one restarts the scan with its duty cycle.
+  {
+    InSequence seq;
+    EXPECT_CALL(*mock_handler_,
+                SetScanParameters(_, ElementsAre(6554), ElementsAre(6554), _))
+        .Times(1);
+    EXPECT_CALL(*mock_handler_, Scan(false)).Times(1);
+    EXPECT_CALL(*mock_handler_, Scan(true)).Times(1);
+  }
+  ASSERT_TRUE(le_scanner2->StartScan(low_latency, filters));
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  // Without a task runner to defer it on, the scan falls back to the remaining
+  // request as soon as the demanding client stops.
+  {
+    InSequence seq;
+    EXPECT_CALL(*mock_handler_,
+                SetScanParameters(_, ElementsAre(8192), ElementsAre(819), _))
+        .Times(1);
+    EXPECT_CALL(*mock_handler_, Scan(false)).Times(1);
+    EXPECT_CALL(*mock_handler_, Scan(true)).Times(1);
+  }
+  ASSERT_TRUE(le_scanner2->StopScan());
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  // The last client stops the scan.
+  EXPECT_CALL(*mock_handler_, SetScanParameters(_, _, _, _)).Times(0);
+  EXPECT_CALL(*mock_handler_, Scan(false)).Times(1);
+  ASSERT_TRUE(le_scanner_->StopScan());
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+
+  EXPECT_CALL(*mock_handler_, Unregister(_)).Times(1).WillOnce(Return());
+  le_scanner2.reset();
+  ::testing::Mock::VerifyAndClearExpectations(mock_handler_.get());
+}
+
 }  // namespace
 }  // namespace bluetooth
@@ -21,6 +21,7 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include <aacenc_lib.h>
 #include <base/logging.h>
@@ -52,6 +53,7 @@ typedef struct {
   uint32_t frame_length;         // Samples per channel in a frame
   uint8_t input_channels_n;      // Number of channels
   int max_encoded_buffer_bytes;  // Max encoded bytes per frame
+  int bit_rate;                  // Configured CBR bit rate, or 0 for VBR
 } tA2DP_AAC_ENCODER_PARAMS;
 
 typedef struct {
@@ -351,6 +353,7 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
         __func__, aac_param_value, aac_error);
     return;  // TODO: Return an error?
   }
+  p_encoder_params->bit_rate = aac_param_value;
 
   // Set the encoder's parameters: PEAK Bit Rate
   aac_error = aacEncoder_SetParam(a2dp_aac_encoder_cb.aac_handle,
@@ -432,6 +435,8 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
     }
     aac_param_value =
         static_cast<uint8_t>(bitrate_mode) & ~A2DP_AAC_VARIABLE_BIT_RATE_MASK;
+    // The bit rate is ignored in VBR mode, so it cannot be scaled
+    p_encoder_params->bit_rate = 0;
   }
   LOG_INFO("%s: AACENC_BITRATEMODE: %d", __func__, aac_param_value);
   aac_error = aacEncoder_SetParam(a2dp_aac_encoder_cb.aac_handle,
@@ -736,6 +741,39 @@ int A2dpCodecConfigAacSource::getEffectiveMtu() const {
   return a2dp_aac_encoder_cb.TxAaMtuSize;
 }
 
+uint64_t A2dpCodecConfigAacSource::encoderPacketIntervalUs() const {
+  const tA2DP_AAC_ENCODER_PARAMS* p_encoder_params =
+      &a2dp_aac_encoder_cb.aac_encoder_params;
+
+  // Each media packet carries a single AAC frame
+  if (p_encoder_params->sample_rate == 0) return 0;
+  return static_cast<uint64_t>(p_encoder_params->frame_length) * 1000000 /
+         p_encoder_params->sample_rate;
+}
+
+bool A2dpCodecConfigAacSource::setEncoderRatePercent(uint8_t rate_percent) {
+  tA2DP_AAC_ENCODER_PARAMS* p_encoder_params =
+      &a2dp_aac_encoder_cb.aac_encoder_params;
+
+  if (!a2dp_aac_encoder_cb.has_aac_handle || p_encoder_params->bit_rate == 0)
+    return false;
+
+  // The new bit rate is applied by the encoder on the next encoded frame
+  int bit_rate =
+      p_encoder_params->bit_rate * std::min<uint8_t>(rate_percent, 100) / 100;
+  AACENC_ERROR aac_error = aacEncoder_SetParam(a2dp_aac_encoder_cb.aac_handle,
+                                               AACENC_BITRATE, bit_rate);
+  if (aac_error != AACENC_OK) {
+    LOG_ERROR(
+        "%s: Cannot set AAC parameter AACENC_BITRATE to %d: "
+        "AAC error 0x%x",
+        __func__, bit_rate, aac_error);
+    return false;
+  }
+  LOG_INFO("%s: rate %u%%, bit rate %d", __func__, rate_percent, bit_rate);
+  return true;
+}
+
 void A2dpCodecConfigAacSource::debug_codec_dump(int fd) {
   a2dp_aac_encoder_stats_t* stats = &a2dp_aac_encoder_cb.stats;
 
@@ -24,6 +24,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 #include "a2dp_sbc.h"
 #include "a2dp_sbc_up_sample.h"
@@ -103,6 +104,9 @@ typedef struct {
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_SBC_FEEDING_STATE feeding_state;
   int16_t pcmBuffer[SBC_MAX_PCM_BUFFER_SIZE];
+  int16_t configured_bitpool; /* Bitpool derived from the codec config */
+  int16_t min_bitpool;        /* Lowest bitpool accepted by the peer */
+  uint8_t rate_percent;       /* Bitpool scaling requested by the source */
 
   a2dp_sbc_encoder_stats_t stats;
 } tA2DP_SBC_ENCODER_CB;
@@ -116,10 +120,18 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
                                     bool* p_config_updated);
 static bool a2dp_sbc_read_feeding(uint32_t* bytes);
 static void a2dp_sbc_encode_frames(uint8_t nb_frame);
+static void a2dp_sbc_send_frames_batched(uint8_t nb_frame,
+                                         uint8_t nb_iterations);
+static size_t a2dp_sbc_encode_pcm(const uint8_t* p_pcm, size_t pcm_len,
+                                  uint8_t frames_per_packet,
+                                  std::vector<BT_HDR*>* p_packets);
+static uint32_t a2dp_sbc_get_sampling_rate(void);
+static uint32_t a2dp_sbc_pcm_bytes_per_frame(void);
 static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us);
 static uint8_t calculate_max_frames_per_packet(void);
+static void a2dp_sbc_apply_rate_percent(void);
 static uint16_t a2dp_sbc_source_rate();
 static uint32_t a2dp_sbc_frame_length(void);
 
@@ -147,6 +159,7 @@ void a2dp_sbc_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
   a2dp_sbc_encoder_cb.peer_supports_3mbps = p_peer_params->peer_supports_3mbps;
   a2dp_sbc_encoder_cb.peer_mtu = p_peer_params->peer_mtu;
   a2dp_sbc_encoder_cb.timestamp = 0;
+  a2dp_sbc_encoder_cb.rate_percent = 100;
 
   // NOTE: Ignore the restart_input / restart_output flags - this initization
   // happens when the connection is (re)started.
@@ -364,6 +377,21 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
 
   /* Reset the SBC encoder */
   SBC_Encoder_Init(&a2dp_sbc_encoder_cb.sbc_encoder_params);
+  a2dp_sbc_encoder_cb.configured_bitpool = p_encoder_params->s16BitPool;
+  a2dp_sbc_encoder_cb.min_bitpool = min_bitpool;
+  a2dp_sbc_apply_rate_percent();
+}
+
+// Scales the configured bitpool by the current rate percentage. The bitpool
+// is carried in every frame header, so the encoder state is kept as is and
+// only the number of frames per packet is recomputed.
+static void a2dp_sbc_apply_rate_percent(void) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  int16_t bitpool = a2dp_sbc_encoder_cb.configured_bitpool *
+                    a2dp_sbc_encoder_cb.rate_percent / 100;
+
+  p_encoder_params->s16BitPool =
+      std::max(bitpool, a2dp_sbc_encoder_cb.min_bitpool);
   a2dp_sbc_encoder_cb.tx_sbc_frames = calculate_max_frames_per_packet();
 }
 
@@ -405,12 +433,29 @@ void a2dp_sbc_send_frames(uint64_t timestamp_us) {
               nb_frame, nb_iterations);
   if (nb_frame == 0) return;
 
+  // Without resampling, the PCM for all iterations is read at once and
+  // encoded in a batch, each iteration still making its own packets.
+  if (a2dp_sbc_get_sampling_rate() ==
+      a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
+    a2dp_sbc_send_frames_batched(nb_frame, nb_iterations);
+    return;
+  }
+
   for (uint8_t counter = 0; counter < nb_iterations; counter++) {
     // Transcode frame and enqueue
     a2dp_sbc_encode_frames(nb_frame);
   }
 }
 
+size_t a2dp_sbc_encode_frames_batch(const uint8_t* p_pcm, size_t pcm_len,
+                                    std::vector<BT_HDR*>* p_packets) {
+  if (a2dp_sbc_get_sampling_rate() !=
+      a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
+    return 0;
+  }
+  return a2dp_sbc_encode_pcm(p_pcm, pcm_len, 0x0F, p_packets);
+}
+
 // Obtains the number of frames to send and number of iterations
 // to be used. |num_of_iterations| and |num_of_frames| parameters
 // are used as output param for returning the respective values.
@@ -584,6 +629,122 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
   }
 }
 
+// Reads the PCM of |nb_frame| * |nb_iterations| frames with a single call to
+// the read callback, then encodes it into packets of at most |nb_frame| frames.
+// A partial frame left by an underflow is kept in |pcmBuffer| for the next
+// tick, like a2dp_sbc_read_feeding() does.
+static void a2dp_sbc_send_frames_batched(uint8_t nb_frame,
+                                         uint8_t nb_iterations) {
+  static uint8_t pcm[MAX_PCM_FRAME_NUM_PER_TICK * SBC_MAX_NUM_OF_BLOCKS *
+                     SBC_MAX_NUM_OF_CHANNELS * SBC_MAX_NUM_OF_SUBBANDS *
+                     sizeof(int16_t)];
+  uint32_t pcm_bytes_per_frame = a2dp_sbc_pcm_bytes_per_frame();
+  size_t total_frames = std::min<size_t>(nb_frame * nb_iterations,
+                                         sizeof(pcm) / pcm_bytes_per_frame);
+  size_t residue = a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue;
+
+  memcpy(pcm, a2dp_sbc_encoder_cb.pcmBuffer, residue);
+  uint32_t read_size = total_frames * pcm_bytes_per_frame - residue;
+  a2dp_sbc_encoder_cb.stats.media_read_total_expected_reads_count++;
+  a2dp_sbc_encoder_cb.stats.media_read_total_expected_read_bytes += read_size;
+  uint32_t nb_byte_read =
+      a2dp_sbc_encoder_cb.read_callback(pcm + residue, read_size);
+  a2dp_sbc_encoder_cb.stats.media_read_total_actual_read_bytes += nb_byte_read;
+  if (nb_byte_read == read_size) {
+    a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
+  }
+
+  std::vector<BT_HDR*> packets;
+  size_t pcm_len = residue + nb_byte_read;
+  size_t consumed = a2dp_sbc_encode_pcm(pcm, pcm_len, nb_frame, &packets);
+
+  // Keep the partial frame and give back the frames not read this tick
+  a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = pcm_len - consumed;
+  memcpy(a2dp_sbc_encoder_cb.pcmBuffer, pcm + consumed, pcm_len - consumed);
+  size_t done_nb_frame = consumed / pcm_bytes_per_frame;
+  if (done_nb_frame < total_frames) {
+    LOG_WARN("%s: underflow %zu, %d", __func__, total_frames - done_nb_frame,
+             a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue);
+    a2dp_sbc_encoder_cb.feeding_state.counter +=
+        (total_frames - done_nb_frame) * pcm_bytes_per_frame;
+  }
+
+  for (size_t i = 0; i < packets.size(); i++) {
+    BT_HDR* p_buf = packets[i];
+    if (!a2dp_sbc_encoder_cb.enqueue_callback(
+            p_buf, p_buf->layer_specific,
+            p_buf->layer_specific * pcm_bytes_per_frame)) {
+      for (i++; i < packets.size(); i++) osi_free(packets[i]);
+      return;
+    }
+  }
+}
+
+// Encodes the whole SBC frames of |p_pcm| into packets of at most
+// |frames_per_packet| frames appended to |p_packets|. Returns the number of
+// PCM octets consumed.
+static size_t a2dp_sbc_encode_pcm(const uint8_t* p_pcm, size_t pcm_len,
+                                  uint8_t frames_per_packet,
+                                  std::vector<BT_HDR*>* p_packets) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  uint16_t blocm_x_subband =
+      p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks;
+  uint32_t pcm_bytes_per_frame = a2dp_sbc_pcm_bytes_per_frame();
+  size_t nb_frame = pcm_len / pcm_bytes_per_frame;
+  const uint8_t* p_input = p_pcm;
+  uint16_t last_frame_len = 0;
+
+  while (nb_frame) {
+    BT_HDR* p_buf = (BT_HDR*)osi_malloc(A2DP_SBC_BUFFER_SIZE);
+    p_buf->offset = A2DP_SBC_OFFSET;
+    p_buf->len = 0;
+    p_buf->layer_specific = 0;
+    a2dp_sbc_encoder_cb.stats.media_read_total_expected_packets++;
+
+    do {
+      // SBC_Encode() needs aligned samples
+      memcpy(a2dp_sbc_encoder_cb.pcmBuffer, p_input, pcm_bytes_per_frame);
+      p_input += pcm_bytes_per_frame;
+      uint8_t* output = (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len;
+      last_frame_len = SBC_Encode(p_encoder_params,
+                                  a2dp_sbc_encoder_cb.pcmBuffer, output);
+      p_buf->len += last_frame_len;
+      p_buf->layer_specific++;
+      nb_frame--;
+    } while (
+        ((p_buf->len + last_frame_len) < a2dp_sbc_encoder_cb.TxAaMtuSize) &&
+        (p_buf->layer_specific < 0x0F) &&
+        (p_buf->layer_specific < frames_per_packet) && nb_frame);
+
+    // The timestamp of the media packet is the one of its first SBC frame
+    *((uint32_t*)(p_buf + 1)) = a2dp_sbc_encoder_cb.timestamp;
+    a2dp_sbc_encoder_cb.timestamp += p_buf->layer_specific * blocm_x_subband;
+    p_packets->push_back(p_buf);
+  }
+  return p_input - p_pcm;
+}
+
+static uint32_t a2dp_sbc_get_sampling_rate(void) {
+  switch (a2dp_sbc_encoder_cb.sbc_encoder_params.s16SamplingFreq) {
+    case SBC_sf44100:
+      return 44100;
+    case SBC_sf32000:
+      return 32000;
+    case SBC_sf16000:
+      return 16000;
+    case SBC_sf48000:
+    default:
+      return 48000;
+  }
+}
+
+static uint32_t a2dp_sbc_pcm_bytes_per_frame(void) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  return p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks *
+         p_encoder_params->s16NumOfChannels *
+         a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+}
+
 static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
   uint16_t blocm_x_subband =
@@ -898,6 +1059,28 @@ int A2dpCodecConfigSbcSource::getEffectiveMtu() const {
   return a2dp_sbc_encoder_cb.TxAaMtuSize;
 }
 
+uint64_t A2dpCodecConfigSbcSource::encoderPacketIntervalUs() const {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  uint64_t frames = std::min<uint64_t>(a2dp_sbc_encoder_cb.tx_sbc_frames,
+                                       MAX_PCM_FRAME_NUM_PER_TICK);
+  uint64_t samples = frames * p_encoder_params->s16NumOfSubBands *
+                     p_encoder_params->s16NumOfBlocks;
+
+  return samples * 1000000 / a2dp_sbc_get_sampling_rate();
+}
+
+bool A2dpCodecConfigSbcSource::setEncoderRatePercent(uint8_t rate_percent) {
+  if (a2dp_sbc_encoder_cb.configured_bitpool == 0) return false;
+
+  a2dp_sbc_encoder_cb.rate_percent = std::min<uint8_t>(rate_percent, 100);
+  a2dp_sbc_apply_rate_percent();
+  LOG_INFO("%s: rate %u%%, bitpool %d, frames per packet %u", __func__,
+           a2dp_sbc_encoder_cb.rate_percent,
+           a2dp_sbc_encoder_cb.sbc_encoder_params.s16BitPool,
+           a2dp_sbc_encoder_cb.tx_sbc_frames);
+  return true;
+}
+
 void A2dpCodecConfigSbcSource::debug_codec_dump(int fd) {
   a2dp_sbc_encoder_stats_t* stats = &a2dp_sbc_encoder_cb.stats;
 
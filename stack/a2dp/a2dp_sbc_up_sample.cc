@@ -25,6 +25,14 @@
 
 #include "a2dp_sbc_up_sample.h"
 
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 typedef int(tA2DP_SBC_ACT)(void* p_src, void* p_dst, uint32_t src_samples,
                            uint32_t dst_samples, uint32_t* p_ret);
 
@@ -42,6 +50,107 @@ typedef struct {
 
 tA2DP_SBC_UPS_CB a2dp_sbc_ups_cb;
 
+/* Number of mono samples widened to stereo frames per repeat pass */
+#define A2DP_SBC_UPS_MONO_CHUNK 16
+
+/*******************************************************************************
+ *
+ * Function         a2dp_sbc_repeat_frames
+ *
+ * Description      Writes each of the n_frames 32-bit frames of p_src ratio
+ *                  times to p_dst. When dst_sps is a multiple of src_sps,
+ *                  this is what the sample-and-hold loops produce once
+ *                  cur_pos is back at dst_sps. Ratios of 2 and 4 use SSE2 or
+ *                  NEON when available.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+static void a2dp_sbc_repeat_frames(const uint8_t* p_src, uint8_t* p_dst,
+                                   uint32_t n_frames, uint32_t ratio) {
+  uint32_t i = 0;
+
+#if defined(__SSE2__)
+  if (ratio == 2) {
+    for (; i + 4 <= n_frames; i += 4, p_src += 16, p_dst += 32) {
+      __m128i v = _mm_loadu_si128((const __m128i*)p_src);
+      _mm_storeu_si128((__m128i*)p_dst, _mm_unpacklo_epi32(v, v));
+      _mm_storeu_si128((__m128i*)(p_dst + 16), _mm_unpackhi_epi32(v, v));
+    }
+  } else if (ratio == 4) {
+    for (; i + 4 <= n_frames; i += 4, p_src += 16, p_dst += 64) {
+      __m128i v = _mm_loadu_si128((const __m128i*)p_src);
+      _mm_storeu_si128((__m128i*)p_dst, _mm_shuffle_epi32(v, 0x00));
+      _mm_storeu_si128((__m128i*)(p_dst + 16), _mm_shuffle_epi32(v, 0x55));
+      _mm_storeu_si128((__m128i*)(p_dst + 32), _mm_shuffle_epi32(v, 0xaa));
+      _mm_storeu_si128((__m128i*)(p_dst + 48), _mm_shuffle_epi32(v, 0xff));
+    }
+  }
+#elif defined(__ARM_NEON)
+  if (ratio == 2) {
+    for (; i + 4 <= n_frames; i += 4, p_src += 16, p_dst += 32) {
+      uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(p_src));
+      uint32x4x2_t z = vzipq_u32(v, v);
+      vst1q_u8(p_dst, vreinterpretq_u8_u32(z.val[0]));
+      vst1q_u8(p_dst + 16, vreinterpretq_u8_u32(z.val[1]));
+    }
+  } else if (ratio == 4) {
+    for (; i + 4 <= n_frames; i += 4, p_src += 16, p_dst += 64) {
+      uint32x4_t v = vreinterpretq_u32_u8(vld1q_u8(p_src));
+      uint32x4x2_t z = vzipq_u32(v, v);
+      uint32x4x2_t lo = vzipq_u32(z.val[0], z.val[0]);
+      uint32x4x2_t hi = vzipq_u32(z.val[1], z.val[1]);
+      vst1q_u8(p_dst, vreinterpretq_u8_u32(lo.val[0]));
+      vst1q_u8(p_dst + 16, vreinterpretq_u8_u32(lo.val[1]));
+      vst1q_u8(p_dst + 32, vreinterpretq_u8_u32(hi.val[0]));
+      vst1q_u8(p_dst + 48, vreinterpretq_u8_u32(hi.val[1]));
+    }
+  }
+#endif
+
+  for (; i < n_frames; i++, p_src += 4) {
+    for (uint32_t r = 0; r < ratio; r++, p_dst += 4) memcpy(p_dst, p_src, 4);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         a2dp_sbc_repeat_mono_frames
+ *
+ * Description      Same as a2dp_sbc_repeat_frames for 16-bit mono samples,
+ *                  each written as a stereo frame. Samples are widened in
+ *                  chunks for the ratios with a vector path.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+static void a2dp_sbc_repeat_mono_frames(const uint8_t* p_src, uint8_t* p_dst,
+                                        uint32_t n_samples, uint32_t ratio) {
+  uint8_t frames[A2DP_SBC_UPS_MONO_CHUNK * 4];
+
+  if (ratio != 2 && ratio != 4) {
+    for (; n_samples; n_samples--, p_src += 2) {
+      uint8_t frame[4] = {p_src[0], p_src[1], p_src[0], p_src[1]};
+      for (uint32_t r = 0; r < ratio; r++, p_dst += 4) memcpy(p_dst, frame, 4);
+    }
+    return;
+  }
+
+  while (n_samples) {
+    uint32_t n = n_samples < A2DP_SBC_UPS_MONO_CHUNK ? n_samples
+                                                      : A2DP_SBC_UPS_MONO_CHUNK;
+    for (uint32_t i = 0; i < n; i++) {
+      memcpy(&frames[i * 4], &p_src[i * 2], 2);
+      memcpy(&frames[i * 4 + 2], &p_src[i * 2], 2);
+    }
+    a2dp_sbc_repeat_frames(frames, p_dst, n, ratio);
+
+    p_src += n * 2;
+    p_dst += n * 4 * ratio;
+    n_samples -= n;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         a2dp_sbc_init_up_sample
@@ -164,6 +273,25 @@ int a2dp_sbc_up_sample_16s(void* p_src, void* p_dst, uint32_t src_samples,
 
   a2dp_sbc_ups_cb.cur_pos = dst_sps;
 
+  /* At an integer ratio every source frame is held for exactly ratio frames
+   * and cur_pos is back at dst_sps after each one, so whole frames can be
+   * repeated in bulk. The loop below handles the tail. */
+  if (src_sps && dst_sps % src_sps == 0) {
+    uint32_t ratio = dst_sps / src_sps;
+    uint32_t n = dst_samples / ratio;
+    if (n > src_samples) n = src_samples;
+    if (n) {
+      a2dp_sbc_repeat_frames((const uint8_t*)p_src_tmp, (uint8_t*)p_dst_tmp,
+                             n, ratio);
+      p_src_tmp += n * 2;
+      p_dst_tmp += n * 2 * ratio;
+      *p_worker1 = p_src_tmp[-2];
+      *p_worker2 = p_src_tmp[-1];
+      src_samples -= n;
+      dst_samples -= n * ratio;
+    }
+  }
+
   while (src_samples-- && dst_samples) {
     *p_worker1 = *p_src_tmp++;
     *p_worker2 = *p_src_tmp++;
@@ -223,6 +351,22 @@ int a2dp_sbc_up_sample_16m(void* p_src, void* p_dst, uint32_t src_samples,
 
   a2dp_sbc_ups_cb.cur_pos = dst_sps;
 
+  /* Bulk path for integer ratios, see a2dp_sbc_up_sample_16s */
+  if (src_sps && dst_sps % src_sps == 0) {
+    uint32_t ratio = dst_sps / src_sps;
+    uint32_t n = dst_samples / (2 * ratio);
+    if (n > src_samples) n = src_samples;
+    if (n) {
+      a2dp_sbc_repeat_mono_frames((const uint8_t*)p_src_tmp,
+                                  (uint8_t*)p_dst_tmp, n, ratio);
+      p_src_tmp += n;
+      p_dst_tmp += n * 2 * ratio;
+      *p_worker = p_src_tmp[-1];
+      src_samples -= n;
+      dst_samples -= n * 2 * ratio;
+    }
+  }
+
   while (src_samples-- && dst_samples) {
     *p_worker = *p_src_tmp++;
 
@@ -25,6 +25,7 @@
 
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx.h"
+#include "a2dp_vendor_aptx_pcm.h"
 #include "bt_common.h"
 #include "common/time_util.h"
 #include "osi/include/log.h"
@@ -62,8 +63,6 @@ static tAPTX_ENCODER_SIZEOF_PARAMS aptx_encoder_sizeof_params_func;
 #define A2DP_APTX_OFFSET (AVDT_MEDIA_OFFSET - AVDT_MEDIA_HDR_SIZE)
 #endif
 
-#define A2DP_APTX_MAX_PCM_BYTES_PER_READ 4096
-
 typedef struct {
   uint64_t sleep_time_ns;
   uint32_t pcm_reads;
@@ -97,6 +96,7 @@ typedef struct {
   tA2DP_FEEDING_PARAMS feeding_params;
   tAPTX_FRAMING_PARAMS framing_params;
   void* aptx_encoder_state;
+  tA2DP_APTX_PCM_FEED pcm_feed;
   a2dp_aptx_encoder_stats_t stats;
 } tA2DP_APTX_ENCODER_CB;
 
@@ -109,9 +109,6 @@ static void a2dp_vendor_aptx_encoder_update(uint16_t peer_mtu,
                                             bool* p_config_updated);
 static void aptx_init_framing_params(tAPTX_FRAMING_PARAMS* framing_params);
 static void aptx_update_framing_params(tAPTX_FRAMING_PARAMS* framing_params);
-static size_t aptx_encode_16bit(tAPTX_FRAMING_PARAMS* framing_params,
-                                size_t* data_out_index, uint16_t* data16_in,
-                                uint8_t* data_out);
 
 bool A2DP_VendorLoadEncoderAptx(void) {
   if (aptx_encoder_lib_handle != NULL) return true;  // Already loaded
@@ -361,10 +358,12 @@ static void aptx_update_framing_params(tAPTX_FRAMING_PARAMS* framing_params) {
 
 void a2dp_vendor_aptx_feeding_reset(void) {
   aptx_init_framing_params(&a2dp_aptx_encoder_cb.framing_params);
+  a2dp_aptx_encoder_cb.pcm_feed.len = 0;
 }
 
 void a2dp_vendor_aptx_feeding_flush(void) {
   aptx_init_framing_params(&a2dp_aptx_encoder_cb.framing_params);
+  a2dp_aptx_encoder_cb.pcm_feed.len = 0;
 }
 
 uint64_t a2dp_vendor_aptx_get_encoder_interval_ms(void) {
@@ -388,11 +387,9 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
   //
   // Read the PCM data and encode it
   //
-  uint16_t read_buffer16[A2DP_APTX_MAX_PCM_BYTES_PER_READ / sizeof(uint16_t)];
+  tA2DP_APTX_PCM_FEED* p_feed = &a2dp_aptx_encoder_cb.pcm_feed;
   uint32_t expected_read_bytes =
       framing_params->pcm_reads * framing_params->pcm_bytes_per_read;
-  size_t encoded_ptr_index = 0;
-  size_t pcm_bytes_encoded = 0;
   uint32_t bytes_read = 0;
 
   a2dp_aptx_encoder_cb.stats.media_read_total_expected_packets++;
@@ -401,24 +398,26 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
       expected_read_bytes;
 
   LOG_VERBOSE("%s: PCM read of size %u", __func__, expected_read_bytes);
-  bytes_read = a2dp_aptx_encoder_cb.read_callback((uint8_t*)read_buffer16,
-                                                  expected_read_bytes);
+  bool filled = a2dp_aptx_pcm_feed_fill(p_feed,
+                                        a2dp_aptx_encoder_cb.read_callback,
+                                        expected_read_bytes, &bytes_read);
   a2dp_aptx_encoder_cb.stats.media_read_total_actual_read_bytes += bytes_read;
-  if (bytes_read < expected_read_bytes) {
-    LOG_WARN("%s: underflow at PCM reading: read %u bytes instead of %u",
-             __func__, bytes_read, expected_read_bytes);
+  if (!filled) {
+    // Keep what was read for the next packet
+    LOG_WARN("%s: underflow at PCM reading: have %u bytes instead of %u",
+             __func__, p_feed->len, expected_read_bytes);
     a2dp_aptx_encoder_cb.stats.media_read_total_dropped_packets++;
     osi_free(p_buf);
     return;
   }
   a2dp_aptx_encoder_cb.stats.media_read_total_actual_reads_count++;
 
-  for (uint32_t reads = 0, offset = 0; reads < framing_params->pcm_reads;
-       reads++, offset +=
-                (framing_params->pcm_bytes_per_read / sizeof(uint16_t))) {
-    pcm_bytes_encoded += aptx_encode_16bit(framing_params, &encoded_ptr_index,
-                                           read_buffer16 + offset, encoded_ptr);
-  }
+  // The whole packet is encoded in one pass, the pcm_reads split only sets
+  // how much PCM goes in it
+  size_t pcm_bytes_encoded = a2dp_aptx_encode_16bit(
+      aptx_encoder_encode_stereo_func, a2dp_aptx_encoder_cb.aptx_encoder_state,
+      p_feed->pcm, expected_read_bytes, encoded_ptr);
+  a2dp_aptx_pcm_feed_consume(p_feed, expected_read_bytes);
 
   // Compute the number of encoded bytes
   const int COMPRESSION_RATIO = 4;
@@ -436,46 +435,13 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
   a2dp_aptx_encoder_cb.timestamp += rtp_timestamp;
 
   if (p_buf->len > 0) {
-    a2dp_aptx_encoder_cb.enqueue_callback(p_buf, 1, bytes_read);
+    a2dp_aptx_encoder_cb.enqueue_callback(p_buf, 1, expected_read_bytes);
   } else {
     a2dp_aptx_encoder_cb.stats.media_read_total_dropped_packets++;
     osi_free(p_buf);
   }
 }
 
-static size_t aptx_encode_16bit(tAPTX_FRAMING_PARAMS* framing_params,
-                                size_t* data_out_index, uint16_t* data16_in,
-                                uint8_t* data_out) {
-  size_t pcm_bytes_encoded = 0;
-  size_t frame = 0;
-
-  for (size_t aptx_samples = 0;
-       aptx_samples < framing_params->pcm_bytes_per_read / 16; aptx_samples++) {
-    uint32_t pcmL[4];
-    uint32_t pcmR[4];
-    uint16_t encoded_sample[2];
-
-    for (size_t i = 0, j = frame; i < 4; i++, j++) {
-      pcmL[i] = (uint16_t) * (data16_in + (2 * j));
-      pcmR[i] = (uint16_t) * (data16_in + ((2 * j) + 1));
-    }
-
-    aptx_encoder_encode_stereo_func(a2dp_aptx_encoder_cb.aptx_encoder_state,
-                                    &pcmL, &pcmR, &encoded_sample);
-
-    data_out[*data_out_index + 0] = (uint8_t)((encoded_sample[0] >> 8) & 0xff);
-    data_out[*data_out_index + 1] = (uint8_t)((encoded_sample[0] >> 0) & 0xff);
-    data_out[*data_out_index + 2] = (uint8_t)((encoded_sample[1] >> 8) & 0xff);
-    data_out[*data_out_index + 3] = (uint8_t)((encoded_sample[1] >> 0) & 0xff);
-
-    frame += 4;
-    pcm_bytes_encoded += 16;
-    *data_out_index += 4;
-  }
-
-  return pcm_bytes_encoded;
-}
-
 uint64_t A2dpCodecConfigAptx::encoderIntervalMs() const {
   return a2dp_vendor_aptx_get_encoder_interval_ms();
 }
@@ -25,6 +25,7 @@
 
 #include "a2dp_vendor.h"
 #include "a2dp_vendor_aptx_hd.h"
+#include "a2dp_vendor_aptx_pcm.h"
 #include "bt_common.h"
 #include "common/time_util.h"
 #include "osi/include/log.h"
@@ -62,8 +63,6 @@ static tAPTX_HD_ENCODER_SIZEOF_PARAMS aptx_hd_encoder_sizeof_params_func;
 #define A2DP_APTX_HD_OFFSET AVDT_MEDIA_OFFSET
 #endif
 
-#define A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ 4096
-
 typedef struct {
   uint64_t sleep_time_ns;
   uint32_t pcm_reads;
@@ -97,6 +96,7 @@ typedef struct {
   tA2DP_FEEDING_PARAMS feeding_params;
   tAPTX_HD_FRAMING_PARAMS framing_params;
   void* aptx_hd_encoder_state;
+  tA2DP_APTX_PCM_FEED pcm_feed;
   a2dp_aptx_hd_encoder_stats_t stats;
 } tA2DP_APTX_HD_ENCODER_CB;
 
@@ -109,9 +109,6 @@ static void aptx_hd_init_framing_params(
     tAPTX_HD_FRAMING_PARAMS* framing_params);
 static void aptx_hd_update_framing_params(
     tAPTX_HD_FRAMING_PARAMS* framing_params);
-static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
-                                   size_t* data_out_index, uint32_t* data32_in,
-                                   uint8_t* data_out);
 
 bool A2DP_VendorLoadEncoderAptxHd(void) {
   if (aptx_hd_encoder_lib_handle != NULL) return true;  // Already loaded
@@ -345,10 +342,12 @@ static void aptx_hd_update_framing_params(
 
 void a2dp_vendor_aptx_hd_feeding_reset(void) {
   aptx_hd_init_framing_params(&a2dp_aptx_hd_encoder_cb.framing_params);
+  a2dp_aptx_hd_encoder_cb.pcm_feed.len = 0;
 }
 
 void a2dp_vendor_aptx_hd_feeding_flush(void) {
   aptx_hd_init_framing_params(&a2dp_aptx_hd_encoder_cb.framing_params);
+  a2dp_aptx_hd_encoder_cb.pcm_feed.len = 0;
 }
 
 uint64_t a2dp_vendor_aptx_hd_get_encoder_interval_ms(void) {
@@ -373,12 +372,9 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   //
   // Read the PCM data and encode it
   //
-  uint32_t
-      read_buffer32[A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ / sizeof(uint32_t)];
+  tA2DP_APTX_PCM_FEED* p_feed = &a2dp_aptx_hd_encoder_cb.pcm_feed;
   uint32_t expected_read_bytes =
       framing_params->pcm_reads * framing_params->pcm_bytes_per_read;
-  size_t encoded_ptr_index = 0;
-  size_t pcm_bytes_encoded = 0;
   uint32_t bytes_read = 0;
 
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_expected_packets++;
@@ -387,26 +383,28 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
       expected_read_bytes;
 
   LOG_VERBOSE("%s: PCM read of size %u", __func__, expected_read_bytes);
-  bytes_read = a2dp_aptx_hd_encoder_cb.read_callback((uint8_t*)read_buffer32,
-                                                     expected_read_bytes);
+  bool filled = a2dp_aptx_pcm_feed_fill(p_feed,
+                                        a2dp_aptx_hd_encoder_cb.read_callback,
+                                        expected_read_bytes, &bytes_read);
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_actual_read_bytes +=
       bytes_read;
-  if (bytes_read < expected_read_bytes) {
-    LOG_WARN("%s: underflow at PCM reading: read %u bytes instead of %u",
-             __func__, bytes_read, expected_read_bytes);
+  if (!filled) {
+    // Keep what was read for the next packet
+    LOG_WARN("%s: underflow at PCM reading: have %u bytes instead of %u",
+             __func__, p_feed->len, expected_read_bytes);
     a2dp_aptx_hd_encoder_cb.stats.media_read_total_dropped_packets++;
     osi_free(p_buf);
     return;
   }
   a2dp_aptx_hd_encoder_cb.stats.media_read_total_actual_reads_count++;
 
-  for (uint32_t reads = 0, offset = 0; reads < framing_params->pcm_reads;
-       reads++, offset +=
-                framing_params->pcm_bytes_per_read / sizeof(uint32_t)) {
-    pcm_bytes_encoded +=
-        aptx_hd_encode_24bit(framing_params, &encoded_ptr_index,
-                             read_buffer32 + offset, encoded_ptr);
-  }
+  // The whole packet is encoded in one pass, the pcm_reads split only sets
+  // how much PCM goes in it
+  size_t pcm_bytes_encoded = a2dp_aptx_hd_encode_24bit(
+      aptx_hd_encoder_encode_stereo_func,
+      a2dp_aptx_hd_encoder_cb.aptx_hd_encoder_state, p_feed->pcm,
+      expected_read_bytes, encoded_ptr);
+  a2dp_aptx_pcm_feed_consume(p_feed, expected_read_bytes);
 
   // Compute the number of encoded bytes
   const int COMPRESSION_RATIO = 4;
@@ -425,54 +423,13 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
   a2dp_aptx_hd_encoder_cb.timestamp += rtp_timestamp;
 
   if (p_buf->len > 0) {
-    a2dp_aptx_hd_encoder_cb.enqueue_callback(p_buf, 1, bytes_read);
+    a2dp_aptx_hd_encoder_cb.enqueue_callback(p_buf, 1, expected_read_bytes);
   } else {
     a2dp_aptx_hd_encoder_cb.stats.media_read_total_dropped_packets++;
     osi_free(p_buf);
   }
 }
 
-static size_t aptx_hd_encode_24bit(tAPTX_HD_FRAMING_PARAMS* framing_params,
-                                   size_t* data_out_index, uint32_t* data32_in,
-                                   uint8_t* data_out) {
-  size_t pcm_bytes_encoded = 0;
-  const uint8_t* p = (const uint8_t*)(data32_in);
-
-  for (size_t aptx_hd_samples = 0;
-       aptx_hd_samples < framing_params->pcm_bytes_per_read / 24;
-       aptx_hd_samples++) {
-    uint32_t pcmL[4];
-    uint32_t pcmR[4];
-    uint32_t encoded_sample[2];
-
-    // Expand from AUDIO_FORMAT_PCM_24_BIT_PACKED data (3 bytes per sample)
-    // into AUDIO_FORMAT_PCM_8_24_BIT (4 bytes per sample).
-    for (size_t i = 0; i < 4; i++) {
-      pcmL[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
-      p += 3;
-      pcmR[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
-      p += 3;
-    }
-
-    aptx_hd_encoder_encode_stereo_func(
-        a2dp_aptx_hd_encoder_cb.aptx_hd_encoder_state, &pcmL, &pcmR,
-        &encoded_sample);
-
-    uint8_t* encoded_ptr = (uint8_t*)&encoded_sample[0];
-    data_out[*data_out_index + 0] = *(encoded_ptr + 2);
-    data_out[*data_out_index + 1] = *(encoded_ptr + 1);
-    data_out[*data_out_index + 2] = *(encoded_ptr + 0);
-    data_out[*data_out_index + 3] = *(encoded_ptr + 6);
-    data_out[*data_out_index + 4] = *(encoded_ptr + 5);
-    data_out[*data_out_index + 5] = *(encoded_ptr + 4);
-
-    pcm_bytes_encoded += 24;
-    *data_out_index += 6;
-  }
-
-  return pcm_bytes_encoded;
-}
-
 uint64_t A2dpCodecConfigAptxHd::encoderIntervalMs() const {
   return a2dp_vendor_aptx_hd_get_encoder_interval_ms();
 }
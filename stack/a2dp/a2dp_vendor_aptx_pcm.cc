@@ -0,0 +1,108 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "a2dp_vendor_aptx_pcm.h"
+
+#include <base/logging.h>
+#include <string.h>
+
+// PCM octets of the four stereo samples encoded by one library call
+#define APTX_PCM_BYTES_PER_CALL 16
+#define APTX_HD_PCM_BYTES_PER_CALL 24
+
+bool a2dp_aptx_pcm_feed_fill(tA2DP_APTX_PCM_FEED* p_feed,
+                             uint32_t (*read_callback)(uint8_t*, uint32_t),
+                             uint32_t len, uint32_t* p_bytes_read) {
+  CHECK(len <= sizeof(p_feed->pcm));
+
+  *p_bytes_read = 0;
+  if (p_feed->len < len) {
+    *p_bytes_read =
+        read_callback(p_feed->pcm + p_feed->len, len - p_feed->len);
+    p_feed->len += *p_bytes_read;
+  }
+  return p_feed->len >= len;
+}
+
+void a2dp_aptx_pcm_feed_consume(tA2DP_APTX_PCM_FEED* p_feed, uint32_t len) {
+  CHECK(len <= p_feed->len);
+
+  p_feed->len -= len;
+  if (p_feed->len > 0) memmove(p_feed->pcm, p_feed->pcm + len, p_feed->len);
+}
+
+size_t a2dp_aptx_encode_16bit(tA2DP_APTX_ENCODE_STEREO encode, void* state,
+                              const uint8_t* p_pcm, size_t pcm_len,
+                              uint8_t* p_out) {
+  const uint16_t* p_in = reinterpret_cast<const uint16_t*>(p_pcm);
+  size_t calls = pcm_len / APTX_PCM_BYTES_PER_CALL;
+
+  for (size_t n = 0; n < calls; n++) {
+    uint32_t pcmL[4];
+    uint32_t pcmR[4];
+    uint16_t encoded_sample[2];
+
+    for (size_t i = 0; i < 4; i++) {
+      pcmL[i] = p_in[2 * i];
+      pcmR[i] = p_in[2 * i + 1];
+    }
+    p_in += 8;
+
+    encode(state, &pcmL, &pcmR, &encoded_sample);
+
+    p_out[0] = (uint8_t)(encoded_sample[0] >> 8);
+    p_out[1] = (uint8_t)encoded_sample[0];
+    p_out[2] = (uint8_t)(encoded_sample[1] >> 8);
+    p_out[3] = (uint8_t)encoded_sample[1];
+    p_out += 4;
+  }
+
+  return calls * APTX_PCM_BYTES_PER_CALL;
+}
+
+size_t a2dp_aptx_hd_encode_24bit(tA2DP_APTX_ENCODE_STEREO encode, void* state,
+                                 const uint8_t* p_pcm, size_t pcm_len,
+                                 uint8_t* p_out) {
+  const uint8_t* p = p_pcm;
+  size_t calls = pcm_len / APTX_HD_PCM_BYTES_PER_CALL;
+
+  for (size_t n = 0; n < calls; n++) {
+    uint32_t pcmL[4];
+    uint32_t pcmR[4];
+    uint32_t encoded_sample[2];
+
+    // Expand from AUDIO_FORMAT_PCM_24_BIT_PACKED data (3 bytes per sample)
+    // into AUDIO_FORMAT_PCM_8_24_BIT (4 bytes per sample).
+    for (size_t i = 0; i < 4; i++) {
+      pcmL[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
+      p += 3;
+      pcmR[i] = ((p[0] << 0) | (p[1] << 8) | (((int8_t)p[2]) << 16));
+      p += 3;
+    }
+
+    encode(state, &pcmL, &pcmR, &encoded_sample);
+
+    p_out[0] = (uint8_t)(encoded_sample[0] >> 16);
+    p_out[1] = (uint8_t)(encoded_sample[0] >> 8);
+    p_out[2] = (uint8_t)encoded_sample[0];
+    p_out[3] = (uint8_t)(encoded_sample[1] >> 16);
+    p_out[4] = (uint8_t)(encoded_sample[1] >> 8);
+    p_out[5] = (uint8_t)encoded_sample[1];
+    p_out += 6;
+  }
+
+  return calls * APTX_HD_PCM_BYTES_PER_CALL;
+}
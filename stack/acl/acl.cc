@@ -46,6 +46,7 @@ void tACL_CONN::Reset() {
   rs_disc_pending = BTM_SEC_RS_NOT_PENDING;
   switch_role_state_ = BTM_ACL_SWKEY_STATE_IDLE;
   sca = 0;
+  memset(&traffic, 0, sizeof(traffic));
 }
 
 // When the local device initiates an le ACL disconnect the address
@@ -306,6 +306,8 @@ struct tACL_CONN {
  public:
   uint8_t sca; /* Sleep clock accuracy */
 
+  tBTM_ACL_TRAFFIC traffic; /* BR/EDR data traffic, for power management */
+
   void Reset();
 
   struct tPolicy {
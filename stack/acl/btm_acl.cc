@@ -39,6 +39,7 @@
 #include "bta/sys/bta_sys.h"
 #include "btif/include/btif_acl.h"
 #include "common/metrics.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "device/include/interop.h"
 #include "include/l2cap_hci_link_interface.h"
@@ -52,6 +53,7 @@
 #include "stack/acl/peer_packet_types.h"
 #include "stack/btm/btm_dev.h"
 #include "stack/btm/btm_int_types.h"
+#include "stack/btm/btm_rmt_cache.h"
 #include "stack/btm/btm_sec.h"
 #include "stack/btm/security_device_record.h"
 #include "stack/gatt/connection_manager.h"
@@ -362,6 +364,50 @@ tACL_CONN* StackAclBtmAcl::acl_allocate_connection() {
   return nullptr;
 }
 
+static void btm_acl_cached_rmt_info_complete(uint16_t handle,
+                                             uint8_t max_page) {
+  tACL_CONN* p_acl = internal_.acl_get_connection_from_handle(handle);
+  if (p_acl == nullptr) {
+    LOG_WARN("Unable to find active acl");
+    return;
+  }
+  btm_process_remote_ext_features(p_acl, max_page);
+  internal_.btm_establish_continue(p_acl);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_acl_use_cached_rmt_info
+ *
+ * Description      This function sets the remote version and features of a
+ *                  new BR/EDR link from the cache, when they were read
+ *                  recently, instead of reading them from the peer. The link
+ *                  set up continues from the main thread, like after the
+ *                  reads.
+ *
+ * Returns          true if the cache had them
+ *
+ ******************************************************************************/
+static bool btm_acl_use_cached_rmt_info(tACL_CONN* p_acl) {
+  tREMOTE_VERSION_INFO version;
+  uint8_t max_page;
+  if (!btm_rmt_cache_get_info(p_acl->remote_addr, &version,
+                              p_acl->peer_lmp_feature_pages, &max_page)) {
+    return false;
+  }
+
+  LOG_DEBUG("Remote version and features of %s from cache",
+            PRIVATE_ADDRESS(p_acl->remote_addr));
+  p_acl->remote_version_info = version;
+  BTM_update_version_info(p_acl->remote_addr, version);
+  for (uint8_t page = 0; page <= max_page; page++) {
+    p_acl->peer_lmp_feature_valid[page] = true;
+  }
+  do_in_main_thread(FROM_HERE, base::Bind(&btm_acl_cached_rmt_info_complete,
+                                          p_acl->hci_handle, max_page));
+  return true;
+}
+
 void btm_acl_created(const RawAddress& bda, uint16_t hci_handle,
                      tHCI_ROLE link_role, tBT_TRANSPORT transport) {
   tACL_CONN* p_acl = internal_.btm_bda_to_acl(bda, transport);
@@ -416,7 +462,9 @@ void btm_acl_created(const RawAddress& bda, uint16_t hci_handle,
     if (!bluetooth::shim::is_gd_l2cap_enabled() &&
         !bluetooth::shim::is_gd_acl_enabled()) {
       // GD L2cap and GD Acl read this automatically
-      btsnd_hcic_rmt_ver_req(hci_handle);
+      if (!btm_acl_use_cached_rmt_info(p_acl)) {
+        btsnd_hcic_rmt_ver_req(hci_handle);
+      }
     }
   }
 
@@ -830,7 +878,7 @@ void btm_read_remote_version_complete_raw(uint8_t* p) {
   ASSERT_LOG(!bluetooth::shim::is_gd_acl_enabled(),
              "gd acl layer should be receiving this completion");
   btm_read_remote_version_complete(static_cast<tHCI_STATUS>(status), handle,
-                                   lmp_version, manufacturer, lmp_version);
+                                   lmp_version, manufacturer, lmp_subversion);
 }
 
 void btm_read_remote_version_complete(tHCI_STATUS status, uint16_t handle,
@@ -981,6 +1029,8 @@ void btm_read_remote_features_complete(uint16_t handle, uint8_t* features) {
 
   /* Remote controller has no extended features. Process remote controller
      supported features (features page 0). */
+  btm_rmt_cache_set_info(p_acl_cb->remote_addr, p_acl_cb->remote_version_info,
+                         p_acl_cb->peer_lmp_feature_pages, 0);
   btm_process_remote_ext_features(p_acl_cb, 0);
 
   /* Continue with HCI connection establishment */
@@ -1058,6 +1108,8 @@ void btm_read_remote_ext_features_complete(uint16_t handle, uint8_t page_num,
   LOG_DEBUG("BTM reached last remote extended features page (%d)", page_num);
 
   /* Process the pages */
+  btm_rmt_cache_set_info(p_acl_cb->remote_addr, p_acl_cb->remote_version_info,
+                         p_acl_cb->peer_lmp_feature_pages, page_num);
   btm_process_remote_ext_features(p_acl_cb, max_page);
 
   /* Continue with HCI connection establishment */
@@ -2721,21 +2773,64 @@ void acl_disconnect_after_role_switch(uint16_t conn_handle,
   }
 }
 
+/* Counts a BR/EDR data packet, and the idle gap before it if it starts a new
+ * burst, see tBTM_ACL_TRAFFIC */
+static void acl_record_traffic(tACL_CONN* p_acl, bool is_tx) {
+  tBTM_ACL_TRAFFIC& traffic = p_acl->traffic;
+  if (is_tx) {
+    traffic.tx_packets++;
+  } else {
+    traffic.rx_packets++;
+  }
+
+  uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+  uint64_t gap_ms = now_ms - traffic.last_packet_ms;
+  bool new_burst =
+      traffic.last_packet_ms != 0 && gap_ms >= BTM_ACL_BURST_GAP_MS;
+  traffic.last_packet_ms = now_ms;
+  if (!new_burst) return;
+
+  size_t bucket = 0;
+  for (gap_ms /= 2 * BTM_ACL_BURST_GAP_MS;
+       gap_ms != 0 && bucket < BTM_ACL_GAP_BUCKETS - 1; gap_ms /= 2) {
+    bucket++;
+  }
+  traffic.gaps[bucket]++;
+
+  uint32_t total = 0;
+  for (size_t i = 0; i < BTM_ACL_GAP_BUCKETS; i++) total += traffic.gaps[i];
+  if (total >= BTM_ACL_GAP_HISTORY) {
+    for (size_t i = 0; i < BTM_ACL_GAP_BUCKETS; i++) traffic.gaps[i] /= 2;
+  }
+}
+
+bool BTM_ReadAclTraffic(const RawAddress& remote_bda,
+                        tBTM_ACL_TRAFFIC* p_traffic) {
+  tACL_CONN* p_acl = internal_.btm_bda_to_acl(remote_bda, BT_TRANSPORT_BR_EDR);
+  if (p_acl == nullptr) {
+    return false;
+  }
+  *p_traffic = p_acl->traffic;
+  return true;
+}
+
 constexpr uint16_t kDataPacketEventBrEdr = (BT_EVT_TO_LM_HCI_ACL);
 constexpr uint16_t kDataPacketEventBle =
     (BT_EVT_TO_LM_HCI_ACL | LOCAL_BLE_CONTROLLER_ID);
 
 void acl_send_data_packet_br_edr(const RawAddress& bd_addr, BT_HDR* p_buf) {
+  tACL_CONN* p_acl = internal_.btm_bda_to_acl(bd_addr, BT_TRANSPORT_BR_EDR);
   if (bluetooth::shim::is_gd_acl_enabled()) {
-    tACL_CONN* p_acl = internal_.btm_bda_to_acl(bd_addr, BT_TRANSPORT_BR_EDR);
     if (p_acl == nullptr) {
       LOG_WARN("Acl br_edr data write for unknown device:%s",
                PRIVATE_ADDRESS(bd_addr));
       osi_free(p_buf);
       return;
     }
+    acl_record_traffic(p_acl, true);
     return bluetooth::shim::ACL_WriteData(p_acl->hci_handle, p_buf);
   }
+  if (p_acl != nullptr) acl_record_traffic(p_acl, true);
   bte_main_hci_send(p_buf, kDataPacketEventBrEdr);
 }
 
@@ -2809,6 +2904,11 @@ void acl_rcv_acl_data(BT_HDR* p_msg) {
     osi_free(p_msg);
     return;
   }
+  tACL_CONN* p_acl =
+      internal_.acl_get_connection_from_handle(acl_header.handle);
+  if (p_acl != nullptr && p_acl->is_transport_br_edr()) {
+    acl_record_traffic(p_acl, false);
+  }
   l2c_rcv_acl_data(p_msg);
 }
 
@@ -2820,6 +2920,10 @@ void acl_packets_completed(uint16_t handle, uint16_t credits) {
   l2c_packets_completed(handle, credits);
 }
 
+void acl_tx_congestion(uint16_t handle, bool congested) {
+  l2c_link_tx_congestion(handle, congested);
+}
+
 static void acl_parse_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
   if (evt_len == 0) {
     LOG_ERROR("Received num completed packets with zero length");
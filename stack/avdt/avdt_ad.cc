@@ -31,6 +31,7 @@
 #include "bt_target.h"
 #include "bt_types.h"
 #include "bt_utils.h"
+#include "hci/include/btsnoop.h"
 #include "l2c_api.h"
 #include "l2cdefs.h"
 #include "osi/include/osi.h"
@@ -371,6 +372,13 @@ void avdt_ad_tc_open_ind(AvdtpTransportChannel* p_tbl) {
     avdt_ccb_event(p_ccb, AVDT_CCB_LL_OPEN_EVT, &avdt_ccb_evt);
     return;
   }
+  /* log the media packet headers, but not the stream itself */
+  if (avdt_ad_tcid_to_type(p_tbl->tcid) == AVDT_CHAN_MEDIA) {
+    btsnoop_get_interface()->truncate_l2c_channel(
+        avdtp_cb.ad.rt_tbl[p_tbl->ccb_idx][p_tbl->tcid].lcid,
+        AVDT_MEDIA_SNOOP_LEN);
+  }
+
   /* if media or other channel, notify scb that channel open */
   /* look up scb in stream routing table by ccb, tcid */
   p_scb = avdtp_cb.ad.LookupAvdtpScb(*p_tbl);
@@ -129,6 +129,12 @@
 /* first byte of media packet header */
 #define AVDT_MEDIA_OCTET1 0x80
 
+/* offsets of the per-packet fields in the media packet header */
+#define AVDT_MEDIA_HDR_PT_OFFSET 1
+#define AVDT_MEDIA_HDR_SEQ_OFFSET 2
+#define AVDT_MEDIA_HDR_TS_OFFSET 4
+#define AVDT_MEDIA_HDR_SSRC_OFFSET 8
+
 /*****************************************************************************
  * message parsing and building macros
  ****************************************************************************/
@@ -220,4 +226,30 @@
     *(p)++ = (uint8_t)(nosp);      \
   } while (0)
 
+/* Build a media packet header template: the fields that stay the same for
+ * the whole stream are set, and the per-packet fields are left zero. */
+#define AVDT_MEDIA_HDR_BLD_TEMPLATE(p, ssrc)                       \
+  do {                                                             \
+    memset((p), 0, AVDT_MEDIA_HDR_SIZE);                           \
+    (p)[0] = AVDT_MEDIA_OCTET1;                                    \
+    (p)[AVDT_MEDIA_HDR_SSRC_OFFSET] = (uint8_t)((ssrc) >> 24);     \
+    (p)[AVDT_MEDIA_HDR_SSRC_OFFSET + 1] = (uint8_t)((ssrc) >> 16); \
+    (p)[AVDT_MEDIA_HDR_SSRC_OFFSET + 2] = (uint8_t)((ssrc) >> 8);  \
+    (p)[AVDT_MEDIA_HDR_SSRC_OFFSET + 3] = (uint8_t)(ssrc);         \
+  } while (0)
+
+/* Copy a media packet header template in front of the payload at |p| and
+ * patch the payload type, sequence number and timestamp in place. */
+#define AVDT_MEDIA_HDR_BLD_FROM_TEMPLATE(p, tmpl, m_pt, seq, ts) \
+  do {                                                           \
+    memcpy((p), (tmpl), AVDT_MEDIA_HDR_SIZE);                    \
+    (p)[AVDT_MEDIA_HDR_PT_OFFSET] = (uint8_t)(m_pt);             \
+    (p)[AVDT_MEDIA_HDR_SEQ_OFFSET] = (uint8_t)((seq) >> 8);      \
+    (p)[AVDT_MEDIA_HDR_SEQ_OFFSET + 1] = (uint8_t)(seq);         \
+    (p)[AVDT_MEDIA_HDR_TS_OFFSET] = (uint8_t)((ts) >> 24);       \
+    (p)[AVDT_MEDIA_HDR_TS_OFFSET + 1] = (uint8_t)((ts) >> 16);   \
+    (p)[AVDT_MEDIA_HDR_TS_OFFSET + 2] = (uint8_t)((ts) >> 8);    \
+    (p)[AVDT_MEDIA_HDR_TS_OFFSET + 3] = (uint8_t)(ts);           \
+  } while (0)
+
 #endif /* AVDT_DEFS_H */
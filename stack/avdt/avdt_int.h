@@ -24,6 +24,7 @@
 #ifndef AVDT_INT_H
 #define AVDT_INT_H
 
+#include <string.h>
 #include <unordered_map>
 
 #include "avdt_api.h"
@@ -86,6 +87,10 @@ enum {
 /* scb transport channel disconnect timeout value (in milliseconds) */
 #define AVDT_SCB_TC_DISC_TIMEOUT_MS (10 * 1000)
 
+/* media channel payload kept in snoop logs: the RTP header and the first
+ * byte of the codec media payload header, e.g. the SBC frame count */
+#define AVDT_MEDIA_SNOOP_LEN (AVDT_MEDIA_HDR_SIZE + 1)
+
 /* maximum number of command retransmissions */
 #ifndef AVDT_RET_MAX
 #define AVDT_RET_MAX 1
@@ -424,6 +429,8 @@ class AvdtpScb {
         curr_evt(0),
         cong(false),
         close_code(0),
+        media_hdr_rtp(false),
+        media_hdr{},
         scb_handle_(0) {}
 
   /**
@@ -473,6 +480,8 @@ class AvdtpScb {
     curr_evt = 0;
     cong = false;
     close_code = 0;
+    media_hdr_rtp = false;
+    memset(media_hdr, 0, sizeof(media_hdr));
     scb_handle_ = scb_handle;
   }
 
@@ -498,6 +507,8 @@ class AvdtpScb {
   bool cong;           // True if the media transport channel is congested
   uint8_t close_code;  // Error code received in close response
   bool curr_stream;    // True if the SCB is the current stream, False otherwise
+  bool media_hdr_rtp;  // True if media packets carry an RTP header
+  uint8_t media_hdr[AVDT_MEDIA_HDR_SIZE];  // RTP header template of the stream
 
  private:
   uint8_t scb_handle_;  // Unique handle for this AvdtpScb entry
@@ -864,6 +875,7 @@ extern uint8_t avdt_scb_verify(AvdtpCcb* p_ccb, uint8_t state, uint8_t* p_seid,
                                uint16_t num_seid, uint8_t* p_err_code);
 extern void avdt_scb_peer_seid_list(tAVDT_MULTI* p_multi);
 extern uint32_t avdt_scb_gen_ssrc(AvdtpScb* p_scb);
+extern void avdt_scb_bld_media_hdr_template(AvdtpScb* p_scb);
 
 /* SCB action functions */
 extern void avdt_scb_hdl_abort_cmd(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data);
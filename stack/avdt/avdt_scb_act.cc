@@ -71,6 +71,26 @@ uint32_t avdt_scb_gen_ssrc(AvdtpScb* p_scb) {
                      p_scb->stream_config.cfg.codec_info[2]));
 }
 
+/*******************************************************************************
+ *
+ * Function         avdt_scb_bld_media_hdr_template
+ *
+ * Description      This function precomputes the RTP media packet header of
+ *                  the stream, so that media packets only need the payload
+ *                  type, sequence number and timestamp patched in.  It is
+ *                  called whenever the stream is started, since the stream
+ *                  configuration cannot change while streaming.
+ *
+ * Returns          Nothing.
+ *
+ ******************************************************************************/
+void avdt_scb_bld_media_hdr_template(AvdtpScb* p_scb) {
+  bool is_content_protection = (p_scb->curr_cfg.num_protect > 0);
+  p_scb->media_hdr_rtp =
+      A2DP_UsesRtpHeader(is_content_protection, p_scb->curr_cfg.codec_info);
+  AVDT_MEDIA_HDR_BLD_TEMPLATE(p_scb->media_hdr, avdt_scb_gen_ssrc(p_scb));
+}
+
 /*******************************************************************************
  *
  * Function         avdt_scb_hdl_abort_cmd
@@ -715,6 +735,7 @@ void avdt_scb_hdl_setconfig_rsp(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data) {
  ******************************************************************************/
 void avdt_scb_hdl_start_cmd(AvdtpScb* p_scb,
                             UNUSED_ATTR tAVDT_SCB_EVT* p_data) {
+  avdt_scb_bld_media_hdr_template(p_scb);
   (*p_scb->stream_config.p_avdt_ctrl_cback)(
       avdt_scb_to_hdl(p_scb),
       p_scb->p_ccb ? p_scb->p_ccb->peer_addr : RawAddress::kEmpty,
@@ -732,6 +753,7 @@ void avdt_scb_hdl_start_cmd(AvdtpScb* p_scb,
  *
  ******************************************************************************/
 void avdt_scb_hdl_start_rsp(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data) {
+  avdt_scb_bld_media_hdr_template(p_scb);
   (*p_scb->stream_config.p_avdt_ctrl_cback)(
       avdt_scb_to_hdl(p_scb),
       p_scb->p_ccb ? p_scb->p_ccb->peer_addr : RawAddress::kEmpty,
@@ -997,8 +1019,7 @@ void avdt_scb_hdl_tc_open_sto(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data) {
  ******************************************************************************/
 void avdt_scb_hdl_write_req(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data) {
   uint8_t* p;
-  uint32_t ssrc;
-  bool add_rtp_header = !(p_data->apiwrite.opt & AVDT_DATA_OPT_NO_RTP);
+  BT_HDR* p_buf = p_data->apiwrite.p_buf;
 
   /* free packet we're holding, if any; to be replaced with new */
   if (p_scb->p_pkt != NULL) {
@@ -1007,36 +1028,27 @@ void avdt_scb_hdl_write_req(AvdtpScb* p_scb, tAVDT_SCB_EVT* p_data) {
   }
   osi_free_and_reset((void**)&p_scb->p_pkt);
 
-  /* Recompute only if the RTP header wasn't disabled by the API */
-  if (add_rtp_header) {
-    bool is_content_protection = (p_scb->curr_cfg.num_protect > 0);
-    add_rtp_header =
-        A2DP_UsesRtpHeader(is_content_protection, p_scb->curr_cfg.codec_info);
-  }
-
-  /* Build a media packet, and add an RTP header if required. */
-  if (add_rtp_header) {
-    if (p_data->apiwrite.p_buf->offset < AVDT_MEDIA_HDR_SIZE) {
+  /* Build a media packet, and add an RTP header if required.  The header is
+   * copied from the stream template into the headroom of the buffer, unless
+   * it was disabled by the API. */
+  if (p_scb->media_hdr_rtp && !(p_data->apiwrite.opt & AVDT_DATA_OPT_NO_RTP)) {
+    if (p_buf->offset < AVDT_MEDIA_HDR_SIZE) {
       android_errorWriteWithInfoLog(0x534e4554, "242535997", -1, NULL, 0);
       return;
     }
 
-    ssrc = avdt_scb_gen_ssrc(p_scb);
-
-    p_data->apiwrite.p_buf->len += AVDT_MEDIA_HDR_SIZE;
-    p_data->apiwrite.p_buf->offset -= AVDT_MEDIA_HDR_SIZE;
+    p_buf->len += AVDT_MEDIA_HDR_SIZE;
+    p_buf->offset -= AVDT_MEDIA_HDR_SIZE;
     p_scb->media_seq++;
-    p = (uint8_t*)(p_data->apiwrite.p_buf + 1) + p_data->apiwrite.p_buf->offset;
+    p = (uint8_t*)(p_buf + 1) + p_buf->offset;
 
-    UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
-    UINT8_TO_BE_STREAM(p, p_data->apiwrite.m_pt);
-    UINT16_TO_BE_STREAM(p, p_scb->media_seq);
-    UINT32_TO_BE_STREAM(p, p_data->apiwrite.time_stamp);
-    UINT32_TO_BE_STREAM(p, ssrc);
+    AVDT_MEDIA_HDR_BLD_FROM_TEMPLATE(p, p_scb->media_hdr,
+                                     p_data->apiwrite.m_pt, p_scb->media_seq,
+                                     p_data->apiwrite.time_stamp);
   }
 
   /* store it */
-  p_scb->p_pkt = p_data->apiwrite.p_buf;
+  p_scb->p_pkt = p_buf;
 }
 
 /*******************************************************************************
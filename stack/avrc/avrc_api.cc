@@ -28,6 +28,7 @@
 #include "avrc_int.h"
 #include "bt_common.h"
 #include "btu.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -619,6 +620,7 @@ static uint8_t avrc_proc_far_msg(uint8_t handle, uint8_t label, uint8_t cr,
  *****************************************************************************/
 static void avrc_msg_cback(uint8_t handle, uint8_t label, uint8_t cr,
                            BT_HDR* p_pkt) {
+  AllocationTagScope tag_scope(ALLOCATION_TAG_AVRCP);
   uint8_t opcode;
   tAVRC_MSG msg;
   uint8_t* p_data;
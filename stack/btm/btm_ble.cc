@@ -49,6 +49,7 @@ extern tBTM_CB btm_cb;
 
 extern bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                                      const RawAddress& new_pseudo_addr);
+extern void btm_ble_clear_resolved_rpa_cache();
 extern void gatt_notify_phy_updated(tGATT_STATUS status, uint16_t handle,
                                     uint8_t tx_phy, uint8_t rx_phy);
 
@@ -88,6 +89,7 @@ void BTM_SecAddBleDevice(const RawAddress& bd_addr, tBT_DEVICE_TYPE dev_type,
   p_dev_rec->ble.ble_addr_type = addr_type;
 
   p_dev_rec->ble.pseudo_addr = bd_addr;
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
   /* sync up with the Inq Data base*/
   tBTM_INQ_INFO* p_info = BTM_InqDbRead(bd_addr);
   if (p_info) {
@@ -1157,6 +1159,7 @@ void btm_sec_save_le_key(const RawAddress& bd_addr, tBTM_LE_KEY_TYPE key_type,
         p_rec->bd_addr = p_keys->pid_key.identity_addr;
         /* combine DUMO device security record if needed */
         btm_consolidate_dev(p_rec);
+        btm_ble_clear_resolved_rpa_cache();
         break;
 
       case BTM_LE_KEY_PCSRK:
@@ -1704,6 +1707,7 @@ void btm_ble_connected(const RawAddress& bda, uint16_t handle, uint8_t enc_mode,
   p_dev_rec->ble.ble_addr_type = addr_type;
   p_dev_rec->ble.pseudo_addr = bda;
   p_dev_rec->ble_hci_handle = handle;
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
   p_dev_rec->device_type |= BT_DEVICE_TYPE_BLE;
   p_dev_rec->role_central = (role == HCI_ROLE_CENTRAL) ? true : false;
 
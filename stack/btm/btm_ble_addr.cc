@@ -32,6 +32,7 @@
 #include "hcimsgs.h"
 
 #include "btm_ble_int.h"
+#include "common/lru.h"
 #include "main/shim/shim.h"
 #include "stack/btm/btm_dev.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
@@ -136,6 +137,7 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                               const RawAddress& new_pseudo_addr) {
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_cb.sec_dev_rec_index.Update(p_dev_rec);
     return true;
   }
 
@@ -185,38 +187,91 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
   return false;
 }
 
-/** This function match the random address to the appointed device record,
- * starting from calculating IRK. If the record index exceeds the maximum record
- * number, matching failed and send a callback. */
-static bool btm_ble_match_random_bda(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  RawAddress* random_bda = static_cast<RawAddress*>(context);
+namespace {
 
-  if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) ||
-      !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID))
-    // Match fails preconditions
-    return true;
+/* Peer RPAs recently resolved, or found not to be resolvable, mapped to the
+ * address of the matching device record, or to an empty address. Advertisers
+ * keep their RPA for up to 15 minutes and are reported many times meanwhile;
+ * the RPAs they rotated out of are not seen again and age out of the cache.
+ */
+constexpr size_t kRpaCacheSize = 64;
+bluetooth::common::LegacyLruCache<RawAddress, RawAddress> rpa_cache(
+    kRpaCacheSize, "rpa_cache");
 
-  if (rpa_matches_irk(*random_bda, p_dev_rec->ble.keys.irk)) {
-    // Matched
-    return false;
-  }
+/* Number of IRKs tried against an RPA with a single aes_128_batch() */
+constexpr size_t kIrkBatchSize = 8;
 
-  // This item not a match, continue iteration
-  return true;
+bool has_irk(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+         (p_dev_rec->ble.key_type & BTM_LE_KEY_PID);
 }
 
+/* Returns the first record whose IRK resolves |rpa|, trying the IRKs by
+ * batches of kIrkBatchSize */
+tBTM_SEC_DEV_REC* resolve_random_addr_batched(const RawAddress& rpa) {
+  /* use the 3 MSB of bd address as prand */
+  Octet16 prand{0};
+  prand[0] = rpa.address[2];
+  prand[1] = rpa.address[1];
+  prand[2] = rpa.address[0];
+
+  tBTM_SEC_DEV_REC* records[kIrkBatchSize];
+  Octet16 irks[kIrkBatchSize];
+  Octet16 hashes[kIrkBatchSize];
+
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  list_node_t* node = list_begin(btm_cb.sec_dev_rec);
+  while (node != end) {
+    size_t num_irks = 0;
+    for (; node != end && num_irks < kIrkBatchSize; node = list_next(node)) {
+      tBTM_SEC_DEV_REC* p_dev_rec =
+          static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+      if (!has_irk(p_dev_rec)) continue;
+      records[num_irks] = p_dev_rec;
+      irks[num_irks++] = p_dev_rec->ble.keys.irk;
+    }
+
+    crypto_toolbox::aes_128_batch(irks, num_irks, prand, hashes);
+    for (size_t i = 0; i < num_irks; i++) {
+      /* the hash is the 3 LSB of bd address */
+      if (hashes[i][0] == rpa.address[5] && hashes[i][1] == rpa.address[4] &&
+          hashes[i][2] == rpa.address[3]) {
+        return records[i];
+      }
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
 /** This function is called to resolve a random address.
  * Returns pointer to the security record of the device whom a random address is
  * matched to.
  */
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
-                                (void*)&random_bda);
-  return (n == nullptr) ? (nullptr)
-                        : (static_cast<tBTM_SEC_DEV_REC*>(list_node(n)));
+  RawAddress* cached = rpa_cache.Find(random_bda);
+  if (cached != nullptr) {
+    if (cached->IsEmpty()) return nullptr;
+
+    /* The record may have been removed, or re-paired with another IRK */
+    tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(*cached);
+    if (p_dev_rec != nullptr && has_irk(p_dev_rec) &&
+        rpa_matches_irk(random_bda, p_dev_rec->ble.keys.irk)) {
+      return p_dev_rec;
+    }
+  }
+
+  tBTM_SEC_DEV_REC* p_dev_rec = resolve_random_addr_batched(random_bda);
+  rpa_cache.Put(random_bda,
+                p_dev_rec != nullptr ? p_dev_rec->bd_addr : RawAddress::kEmpty);
+  return p_dev_rec;
 }
 
+/** This function is called when a new peer IRK is stored: the RPAs found not
+ * to be resolvable may now be. */
+void btm_ble_clear_resolved_rpa_cache() { rpa_cache.Clear(); }
+
 /*******************************************************************************
  *  address mapping between pseudo address and real connection address
  ******************************************************************************/
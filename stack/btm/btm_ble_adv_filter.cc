@@ -29,6 +29,7 @@
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "stack/btm/btm_ble_int.h"
+#include "stack/btm/btm_ble_sw_filter.h"
 #include "stack/btm/btm_int_types.h"
 #include "utils/include/bt_utils.h"
 
@@ -87,6 +88,56 @@ static bool is_filtering_supported() {
   return cmn_ble_vsc_cb.filter_support != 0 && cmn_ble_vsc_cb.max_filter != 0;
 }
 
+/* Every filter is also compiled for the host side engine. The filters the
+ * controller has no slot for, or all of them when it has no APCF support, are
+ * matched on the host: the controller filtering is then turned off so that it
+ * reports everything, and the engine applies all the filters. */
+static BleSoftwareFilter sw_filter;
+static bool filter_feature_enabled = false;
+static bool hw_filter_enabled = false;
+
+static bool is_sw_filter_index(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  return !is_filtering_supported() || filt_index >= cmn_ble_vsc_cb.max_filter;
+}
+
+static bool is_sw_filter_needed() {
+  if (!filter_feature_enabled) return false;
+  if (!is_filtering_supported()) return true;
+  return sw_filter.IsAnyEnabledFrom(cmn_ble_vsc_cb.max_filter);
+}
+
+static void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
+                              uint16_t evt_len);
+
+/* Turns the controller filtering on or off, as the feature state and the
+ * filters matched on the host require */
+static void btm_ble_update_hw_filter(tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
+  bool enable = filter_feature_enabled && !is_sw_filter_needed();
+  if (!is_filtering_supported() || enable == hw_filter_enabled) {
+    if (p_stat_cback) p_stat_cback.Run(BTM_BLE_PF_ENABLE, BTM_SUCCESS);
+    return;
+  }
+  hw_filter_enabled = enable;
+  if (!p_stat_cback) p_stat_cback = base::DoNothing();
+
+  uint8_t param[20];
+  memset(param, 0, 20);
+
+  uint8_t* p = param;
+  UINT8_TO_STREAM(p, BTM_BLE_META_PF_ENABLE);
+  UINT8_TO_STREAM(p, enable);
+
+  btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_ADV_FILTER, param,
+                            BTM_BLE_PCF_ENABLE_LEN,
+                            base::Bind(&enable_cmpl_cback, p_stat_cback));
+}
+
+bool btm_ble_adv_filter_match(const RawAddress& bda,
+                              const std::vector<uint8_t>& adv_data) {
+  if (!is_sw_filter_needed()) return true;
+  return sw_filter.Match(bda, adv_data);
+}
+
 static bool is_empty_128bit(const std::array<uint8_t, 16> data) {
   int i, len = 16;
   for (i = 0; i < len; i++) {
@@ -620,8 +671,9 @@ static std::unordered_map<tBTM_BLE_PF_FILT_INDEX, RawAddress>
 void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                    std::vector<ApcfCommand> commands,
                    tBTM_BLE_PF_CFG_CBACK cb) {
-  if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, BTM_MODE_UNSUPPORTED);
+  sw_filter.Set(filt_index, commands);
+  if (is_sw_filter_index(filt_index)) {
+    cb.Run(0, 0, BTM_SUCCESS);
     return;
   }
 
@@ -731,8 +783,9 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
  */
 void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
                      tBTM_BLE_PF_CFG_CBACK cb) {
-  if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, BTM_MODE_UNSUPPORTED);
+  sw_filter.Clear(filt_index);
+  if (is_sw_filter_index(filt_index)) {
+    cb.Run(0, 0, BTM_SUCCESS);
     return;
   }
 
@@ -808,8 +861,18 @@ void BTM_BleAdvFilterParamSetup(
                 BTM_BLE_ADV_FILT_FEAT_SELN_LEN + BTM_BLE_ADV_FILT_TRACK_NUM;
   uint8_t param[len], *p;
 
-  if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, btm_status_value(BTM_MODE_UNSUPPORTED));
+  if (BTM_BLE_SCAN_COND_CLEAR == action) {
+    sw_filter.ClearAll();
+  } else {
+    sw_filter.Enable(filt_index, BTM_BLE_SCAN_COND_ADD == action);
+  }
+
+  if (BTM_BLE_SCAN_COND_CLEAR == action ? !is_filtering_supported()
+                                        : is_sw_filter_index(filt_index)) {
+    /* Filters matched on the host may turn the controller filtering off, or
+     * back on */
+    btm_ble_update_hw_filter(tBTM_BLE_PF_STATUS_CBACK());
+    cb.Run(0, action, btm_status_value(BTM_SUCCESS));
     return;
   }
 
@@ -928,23 +991,8 @@ static void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
  ******************************************************************************/
 void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                                        tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
-  if (!is_filtering_supported()) {
-    if (p_stat_cback)
-      p_stat_cback.Run(BTM_BLE_PF_ENABLE,
-                       BTM_MODE_UNSUPPORTED /* BTA_FAILURE */);
-    return;
-  }
-
-  uint8_t param[20];
-  memset(param, 0, 20);
-
-  uint8_t* p = param;
-  UINT8_TO_STREAM(p, BTM_BLE_META_PF_ENABLE);
-  UINT8_TO_STREAM(p, enable);
-
-  btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_ADV_FILTER, param,
-                            BTM_BLE_PCF_ENABLE_LEN,
-                            base::Bind(&enable_cmpl_cback, p_stat_cback));
+  filter_feature_enabled = enable;
+  btm_ble_update_hw_filter(std::move(p_stat_cback));
 }
 
 /*******************************************************************************
@@ -960,6 +1008,9 @@ void BTM_BleEnableDisableFilterFeature(uint8_t enable,
  ******************************************************************************/
 void btm_ble_adv_filter_init(void) {
   memset(&btm_ble_adv_filt_cb, 0, sizeof(tBTM_BLE_ADV_FILTER_CB));
+  sw_filter.ClearAll();
+  filter_feature_enabled = false;
+  hw_filter_enabled = false;
 
   BTM_BleGetVendorCapabilities(&cmn_ble_vsc_cb);
 
@@ -25,6 +25,7 @@
 #include <base/bind.h>
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 
 #include "device/include/controller.h"
 #include "main/shim/acl_api.h"
@@ -212,6 +213,27 @@ const tBLE_BD_ADDR convert_to_address_with_type(
   }
 }
 
+/* Returns the background connection |bd_addr| is kept in, the same way
+ * btm_add_dev_to_controller() finds it, or nullptr if there is none */
+static BackgroundConnection* background_connection_find(
+    const RawAddress& bd_addr) {
+  const tBLE_BD_ADDR entry =
+      convert_to_address_with_type(bd_addr, btm_find_dev(bd_addr));
+  auto map_iter = background_connections.find(entry.bda);
+  if (map_iter == background_connections.end()) return nullptr;
+  if (map_iter->second.pending_removal) return nullptr;
+  return &map_iter->second;
+}
+
+/* Whether adding |bd_addr| leaves the controller acceptlist as it is */
+static bool background_connection_in_controller(const RawAddress& bd_addr) {
+  const tBLE_BD_ADDR entry =
+      convert_to_address_with_type(bd_addr, btm_find_dev(bd_addr));
+  const BackgroundConnection* connection = background_connection_find(bd_addr);
+  return connection != nullptr && connection->in_controller_wl &&
+         connection->addr_type == entry.type;
+}
+
 /*******************************************************************************
  *
  * Function         btm_add_dev_to_controller
@@ -545,6 +567,15 @@ bool BTM_AcceptlistAdd(const RawAddress& address) {
         /* is_direct */ false);
   }
 
+  /* The acceptlist can't be edited while the controller initiates from it,
+   * which costs a cancel and a new create connection. A device already in it
+   * needs neither. */
+  if (background_connection_in_controller(address)) {
+    btm_ble_resume_bg_conn();
+    LOG_DEBUG("Le acceptlist already has device:%s", PRIVATE_ADDRESS(address));
+    return true;
+  }
+
   if (background_connections_count() ==
       controller_get_interface()->get_ble_acceptlist_size()) {
     LOG_ERROR("Unable to add device to acceptlist since it is full");
@@ -573,6 +604,11 @@ void BTM_AcceptlistRemove(const RawAddress& address) {
     return;
   }
 
+  if (background_connection_find(address) == nullptr) {
+    LOG_DEBUG("Le acceptlist has no device:%s", PRIVATE_ADDRESS(address));
+    return;
+  }
+
   if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_ACCEPTLIST_INIT) {
     btm_ble_stop_auto_conn();
   }
@@ -581,6 +617,51 @@ void BTM_AcceptlistRemove(const RawAddress& address) {
   LOG_DEBUG("Removed from Le acceptlist device:%s", PRIVATE_ADDRESS(address));
 }
 
+/** Removes |to_remove| from the acceptlist, then adds |to_add|, stopping and
+ * restarting the background connection only once. Returns the devices that
+ * could not be added, as the acceptlist was full */
+std::vector<RawAddress> BTM_AcceptlistUpdate(
+    const std::vector<RawAddress>& to_remove,
+    const std::vector<RawAddress>& to_add) {
+  if (!controller_get_interface()->supports_ble()) {
+    LOG_WARN("Controller does not support Le");
+    return to_add;
+  }
+
+  std::vector<RawAddress> failed;
+  if (bluetooth::shim::is_gd_acl_enabled()) {
+    for (const RawAddress& address : to_remove) BTM_AcceptlistRemove(address);
+    for (const RawAddress& address : to_add) {
+      if (!BTM_AcceptlistAdd(address)) failed.push_back(address);
+    }
+    return failed;
+  }
+
+  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_ACCEPTLIST_INIT) {
+    btm_ble_stop_auto_conn();
+  }
+  for (const RawAddress& address : to_remove) {
+    btm_add_dev_to_controller(false, address);
+  }
+  for (const RawAddress& address : to_add) {
+    if (background_connections_count() ==
+        controller_get_interface()->get_ble_acceptlist_size()) {
+      failed.push_back(address);
+      continue;
+    }
+    btm_add_dev_to_controller(true, address);
+  }
+  btm_ble_resume_bg_conn();
+  LOG_DEBUG("Updated Le acceptlist removed:%zu added:%zu failed:%zu",
+            to_remove.size(), to_add.size() - failed.size(), failed.size());
+  return failed;
+}
+
+size_t BTM_GetAcceptlistSize() {
+  if (!controller_get_interface()->supports_ble()) return 0;
+  return controller_get_interface()->get_ble_acceptlist_size();
+}
+
 /** Clear the acceptlist, end any pending acceptlist connections */
 void BTM_AcceptlistClear() {
   if (!controller_get_interface()->supports_ble()) {
@@ -16,6 +16,9 @@
  *
  ******************************************************************************/
 
+#include <cstddef>
+#include <vector>
+
 #include "types/raw_address.h"
 
 /** Adds the device into acceptlist. Returns false if acceptlist is full and
@@ -25,6 +28,16 @@ extern bool BTM_AcceptlistAdd(const RawAddress& address);
 /** Removes the device from acceptlist */
 extern void BTM_AcceptlistRemove(const RawAddress& address);
 
+/** Removes |to_remove| from the acceptlist, then adds |to_add|, stopping and
+ * restarting the background connection only once. Returns the devices that
+ * could not be added, as the acceptlist was full */
+extern std::vector<RawAddress> BTM_AcceptlistUpdate(
+    const std::vector<RawAddress>& to_remove,
+    const std::vector<RawAddress>& to_add);
+
+/** Number of devices the controller acceptlist holds, 0 if it has none */
+extern size_t BTM_GetAcceptlistSize();
+
 /** Clear the acceptlist, end any pending acceptlist connections */
 extern void BTM_AcceptlistClear();
 
@@ -26,6 +26,7 @@
 
 #include <base/bind.h>
 #include <base/strings/string_number_conversions.h>
+#include <array>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -41,6 +42,7 @@
 #include "stack/btm/btm_ble_int_types.h"
 #include "stack/btm/btm_dev.h"
 #include "stack/btm/btm_int_types.h"
+#include "stack/gatt/connection_manager.h"
 #include "stack/gatt/gatt_int.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/advertise_data_parser.h"
@@ -50,6 +52,7 @@
 #include "stack/include/hci_error_code.h"
 #include "stack/include/hcimsgs.h"
 #include "stack/include/inq_hci_link_interface.h"
+#include "stack/include/l2cap_hci_link_interface.h"
 #include "types/raw_address.h"
 
 extern tBTM_CB btm_cb;
@@ -1434,25 +1437,22 @@ static void btm_ble_update_adv_flag(uint8_t flag) {
  * condition
  */
 static uint8_t btm_ble_is_discoverable(const RawAddress& bda,
-                                       std::vector<uint8_t> const& adv_data) {
+                                       const AdIndex& ad) {
   uint8_t scan_state = BTM_BLE_NOT_SCANNING;
 
   /* for observer, always "discoverable */
   if (btm_cb.ble_ctr_cb.is_ble_observe_active())
     scan_state |= BTM_BLE_OBS_RESULT;
 
-  if (!adv_data.empty()) {
-    uint8_t flag = 0;
-    uint8_t data_len;
-    const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
-        adv_data, BTM_BLE_AD_TYPE_FLAG, &data_len);
-    if (p_flag != NULL && data_len != 0) {
-      flag = *p_flag;
-
-      if ((btm_cb.btm_inq_vars.inq_active & BTM_BLE_GENERAL_INQUIRY) &&
-          (flag & (BTM_BLE_LIMIT_DISC_FLAG | BTM_BLE_GEN_DISC_FLAG)) != 0) {
-        scan_state |= BTM_BLE_INQ_RESULT;
-      }
+  uint8_t flag = 0;
+  uint8_t data_len;
+  const uint8_t* p_flag = ad.GetFieldByType(BTM_BLE_AD_TYPE_FLAG, &data_len);
+  if (p_flag != NULL && data_len != 0) {
+    flag = *p_flag;
+
+    if ((btm_cb.btm_inq_vars.inq_active & BTM_BLE_GENERAL_INQUIRY) &&
+        (flag & (BTM_BLE_LIMIT_DISC_FLAG | BTM_BLE_GEN_DISC_FLAG)) != 0) {
+      scan_state |= BTM_BLE_INQ_RESULT;
     }
   }
   return scan_state;
@@ -1591,7 +1591,7 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
                                uint8_t primary_phy, uint8_t secondary_phy,
                                uint8_t advertising_sid, int8_t tx_power,
                                int8_t rssi, uint16_t periodic_adv_int,
-                               std::vector<uint8_t> const& data) {
+                               const AdIndex& ad) {
   tBTM_INQ_RESULTS* p_cur = &p_i->inq_info.results;
   uint8_t len;
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
@@ -1622,39 +1622,33 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
 
   p_i->inq_count = p_inq->inq_counter; /* Mark entry for current inquiry */
 
-  if (!data.empty()) {
-    const uint8_t* p_flag =
-        AdvertiseDataParser::GetFieldByType(data, BTM_BLE_AD_TYPE_FLAG, &len);
-    if (p_flag != NULL && len != 0) p_cur->flag = *p_flag;
-  }
-
-  if (!data.empty()) {
-    /* Check to see the BLE device has the Appearance UUID in the advertising
-     * data.  If it does
-     * then try to convert the appearance value to a class of device value
-     * Bluedroid can use.
-     * Otherwise fall back to trying to infer if it is a HID device based on the
-     * service class.
-     */
-    const uint8_t* p_uuid16 = AdvertiseDataParser::GetFieldByType(
-        data, BTM_BLE_AD_TYPE_APPEARANCE, &len);
-    if (p_uuid16 && len == 2) {
-      btm_ble_appearance_to_cod((uint16_t)p_uuid16[0] | (p_uuid16[1] << 8),
-                                p_cur->dev_class);
-    } else {
-      p_uuid16 = AdvertiseDataParser::GetFieldByType(
-          data, BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
-      if (p_uuid16 != NULL) {
-        uint8_t i;
-        for (i = 0; i + 2 <= len; i = i + 2) {
-          /* if this BLE device support HID over LE, set HID Major in class of
-           * device */
-          if ((p_uuid16[i] | (p_uuid16[i + 1] << 8)) == UUID_SERVCLASS_LE_HID) {
-            p_cur->dev_class[0] = 0;
-            p_cur->dev_class[1] = BTM_COD_MAJOR_PERIPHERAL;
-            p_cur->dev_class[2] = 0;
-            break;
-          }
+  const uint8_t* p_flag = ad.GetFieldByType(BTM_BLE_AD_TYPE_FLAG, &len);
+  if (p_flag != NULL && len != 0) p_cur->flag = *p_flag;
+
+  /* Check to see the BLE device has the Appearance UUID in the advertising
+   * data.  If it does
+   * then try to convert the appearance value to a class of device value
+   * Bluedroid can use.
+   * Otherwise fall back to trying to infer if it is a HID device based on the
+   * service class.
+   */
+  const uint8_t* p_uuid16 =
+      ad.GetFieldByType(BTM_BLE_AD_TYPE_APPEARANCE, &len);
+  if (p_uuid16 && len == 2) {
+    btm_ble_appearance_to_cod((uint16_t)p_uuid16[0] | (p_uuid16[1] << 8),
+                              p_cur->dev_class);
+  } else {
+    p_uuid16 = ad.GetFieldByType(BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
+    if (p_uuid16 != NULL) {
+      uint8_t i;
+      for (i = 0; i + 2 <= len; i = i + 2) {
+        /* if this BLE device support HID over LE, set HID Major in class of
+         * device */
+        if ((p_uuid16[i] | (p_uuid16[i + 1] << 8)) == UUID_SERVCLASS_LE_HID) {
+          p_cur->dev_class[0] = 0;
+          p_cur->dev_class[1] = BTM_COD_MAJOR_PERIPHERAL;
+          p_cur->dev_class[2] = 0;
+          break;
         }
       }
     }
@@ -1693,7 +1687,7 @@ void btm_clear_all_pending_le_entry(void) {
     if ((p_ent->in_use) &&
         (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
         !p_ent->scan_rsp)
-      p_ent->in_use = false;
+      btm_inq_db_release(p_ent);
   }
 }
 
@@ -1720,6 +1714,50 @@ void btm_ble_process_adv_addr(RawAddress& bda, uint8_t* addr_type) {
   }
 }
 
+namespace {
+
+/* Resolved addresses of the reports of one advertising report event. The
+ * controller often reports the advertising data and scan response of a device,
+ * or several of its advertising sets, in the same event, so each address is
+ * only resolved once per event. */
+class AdvAddrResolutionCache {
+ public:
+  void Resolve(RawAddress& bda, uint8_t* addr_type) {
+    for (size_t i = 0; i < num_entries_; i++) {
+      const Entry& entry = entries_[i];
+      if (entry.addr_type == *addr_type && entry.bda == bda) {
+        bda = entry.resolved_bda;
+        *addr_type = entry.resolved_addr_type;
+        return;
+      }
+    }
+
+    Entry entry = {bda, *addr_type, bda, *addr_type};
+    btm_ble_process_adv_addr(bda, addr_type);
+    if (num_entries_ == kMaxEntries) return;
+
+    entry.resolved_bda = bda;
+    entry.resolved_addr_type = *addr_type;
+    entries_[num_entries_++] = entry;
+  }
+
+ private:
+  /* More than the reports an extended advertising report event can hold */
+  static constexpr size_t kMaxEntries = 10;
+
+  struct Entry {
+    RawAddress bda;
+    uint8_t addr_type;
+    RawAddress resolved_bda;
+    uint8_t resolved_addr_type;
+  };
+
+  std::array<Entry, kMaxEntries> entries_;
+  size_t num_entries_ = 0;
+};
+
+}  // namespace
+
 /**
  * This function is called when extended advertising report event is received .
  * It updates the inquiry database. If the inquiry database is full, the oldest
@@ -1739,6 +1777,7 @@ void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
   /* Extract the number of reports in this event. */
   STREAM_TO_UINT8(num_reports, p);
 
+  AdvAddrResolutionCache resolved_addrs;
   constexpr int extended_report_header_size = 24;
   while (num_reports--) {
     if (p + extended_report_header_size > data + data_len) {
@@ -1780,7 +1819,7 @@ void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
     RawAddress original_bda = bda;
 
     if (addr_type != BLE_ADDR_ANONYMOUS) {
-      btm_ble_process_adv_addr(bda, &addr_type);
+      resolved_addrs.Resolve(bda, &addr_type);
     }
 
     btm_ble_process_adv_pkt_cont(event_type, addr_type, bda, primary_phy,
@@ -1806,6 +1845,7 @@ void btm_ble_process_adv_pkt(uint8_t data_len, uint8_t* data) {
   /* Extract the number of reports in this event. */
   STREAM_TO_UINT8(num_reports, p);
 
+  AdvAddrResolutionCache resolved_addrs;
   constexpr int report_header_size = 10;
   while (num_reports--) {
     if (p + report_header_size > data + data_len) {
@@ -1837,7 +1877,7 @@ void btm_ble_process_adv_pkt(uint8_t data_len, uint8_t* data) {
     // Pass up the address to GattService#onScanResult to use in ScanFilter#matches
     RawAddress original_bda = bda;
 
-    btm_ble_process_adv_addr(bda, &addr_type);
+    resolved_addrs.Resolve(bda, &addr_type);
 
     uint16_t event_type;
     event_type = 1 << BLE_EVT_LEGACY_BIT;
@@ -1886,6 +1926,10 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
 
+  if (ble_evt_type_is_connectable(evt_type)) {
+    connection_manager::on_advertising_seen(bda);
+  }
+
   std::vector<uint8_t> tmp;
   if (data_len != 0) tmp.insert(tmp.begin(), data, data + data_len);
 
@@ -1969,12 +2013,15 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
     p_inq->inq_cmpl_info.num_resp++;
   }
 
+  /* Index the fields once for all the lookups below */
+  AdIndex ad(adv_data);
+
   /* update the LE device information in inquiry database */
   btm_ble_update_inq_result(p_i, addr_type, bda, evt_type, primary_phy,
                             secondary_phy, advertising_sid, tx_power, rssi,
-                            periodic_adv_int, adv_data);
+                            periodic_adv_int, ad);
 
-  uint8_t result = btm_ble_is_discoverable(bda, adv_data);
+  uint8_t result = btm_ble_is_discoverable(bda, ad);
   if (result == 0) {
     // Device no longer discoverable so discard outstanding advertising packet
     cache.Clear(addr_type, bda);
@@ -1983,6 +2030,10 @@ void btm_ble_process_adv_pkt_cont(uint16_t evt_type, uint8_t addr_type,
 
   if (!update) result &= ~BTM_BLE_INQ_RESULT;
 
+  // Scan filters matched on the host apply to the observers only
+  if ((result & BTM_BLE_OBS_RESULT) && !btm_ble_adv_filter_match(bda, adv_data))
+    result &= ~BTM_BLE_OBS_RESULT;
+
   // Pass address up to GattService#onScanResult
   p_i->inq_info.results.original_bda = original_bda;
 
@@ -2046,12 +2097,15 @@ void btm_ble_process_adv_pkt_cont_for_inquiry(
     p_inq->inq_cmpl_info.num_resp++;
   }
 
+  /* Index the fields once for all the lookups below */
+  AdIndex ad(advertising_data);
+
   /* update the LE device information in inquiry database */
   btm_ble_update_inq_result(p_i, addr_type, bda, evt_type, primary_phy,
                             secondary_phy, advertising_sid, tx_power, rssi,
-                            periodic_adv_int, advertising_data);
+                            periodic_adv_int, ad);
 
-  uint8_t result = btm_ble_is_discoverable(bda, advertising_data);
+  uint8_t result = btm_ble_is_discoverable(bda, ad);
   if (result == 0) {
     return;
   }
@@ -2078,6 +2132,7 @@ void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
   STREAM_TO_UINT8(tx_phy, p);
   STREAM_TO_UINT8(rx_phy, p);
 
+  l2cble_process_phy_update_evt(handle, status, tx_phy, rx_phy);
   gatt_notify_phy_updated(static_cast<tGATT_STATUS>(status), handle, tx_phy,
                           rx_phy);
 }
@@ -2509,12 +2564,17 @@ void btm_ble_update_mode_operation(uint8_t link_role, const RawAddress* bd_addr,
      in order to add back device to acceptlist in order to reconnect */
   if (bd_addr != nullptr) {
     const RawAddress bda(*bd_addr);
+    bool has_slot = connection_manager::on_disconnected(bda);
     if (bluetooth::shim::is_gd_acl_enabled()) {
       if (acl_check_and_clear_ignore_auto_connect_after_disconnect(bda)) {
         LOG_DEBUG(
             "Local disconnect initiated so skipping re-add to acceptlist "
             "device:%s",
             PRIVATE_ADDRESS(bda));
+      } else if (!has_slot) {
+        LOG_DEBUG(
+            "Waiting for a slot so skipping re-add to acceptlist device:%s",
+            PRIVATE_ADDRESS(bda));
       } else {
         if (!bluetooth::shim::ACL_AcceptLeConnectionFrom(
                 convert_to_address_with_type(bda, btm_find_dev(bda)),
@@ -106,6 +106,7 @@ extern void btm_gen_resolvable_private_addr(
 
 extern tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(
     const RawAddress& random_bda);
+extern void btm_ble_clear_resolved_rpa_cache();
 extern void btm_gen_resolve_paddr_low(const RawAddress& address);
 extern uint64_t btm_get_next_private_addrress_interval_ms();
 
@@ -132,6 +133,8 @@ extern void btm_ble_adv_init(void);
 extern void btm_ble_multi_adv_cleanup(void);
 extern void btm_ble_batchscan_init(void);
 extern void btm_ble_adv_filter_init(void);
+extern bool btm_ble_adv_filter_match(const RawAddress& bda,
+                                     const std::vector<uint8_t>& adv_data);
 extern bool btm_ble_topology_check(tBTM_BLE_STATE_MASK request);
 extern bool btm_ble_clear_topology_mask(tBTM_BLE_STATE_MASK request_state);
 extern bool btm_ble_set_topology_mask(tBTM_BLE_STATE_MASK request_state);
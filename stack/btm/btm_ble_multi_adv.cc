@@ -27,6 +27,7 @@
 #include "stack/btm/btm_ble_int.h"
 
 #include <string.h>
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -51,6 +52,13 @@ extern void btm_gen_resolvable_private_addr(
 
 constexpr int ADV_DATA_LEN_MAX = 251;
 
+/* Advertising sets started once all the controller instances are taken take
+ * turns on the instances of the sets that can share theirs, see RunRotation()
+ */
+constexpr uint8_t ROTATED_SETS_MAX = 32;
+constexpr uint64_t ROTATION_SLOT_MS = 500;
+constexpr uint8_t NO_HANDLE = 0xFF;
+
 namespace {
 
 bool is_connectable(uint16_t advertising_event_properties) {
@@ -72,6 +80,13 @@ struct AdvertisingInstance {
   bool address_update_required;
   bool periodic_enabled;
   uint32_t advertising_interval;  // 1 unit is 0.625 ms
+  tBTM_BLE_ADV_PARAMS params;     // last parameters set by the upper layer
+
+  /* Controller instance the set is programmed on. Sets with an id below the
+   * instance count always use the instance of the same number, the others
+   * get one for each rotation slot and NO_HANDLE in between */
+  uint8_t handle;
+  TimeTicks last_slot_time; /* last time the set got a rotation slot */
 
   /* When true, advertising set is enabled, or last scheduled call to "LE Set
    * Extended Advertising Set Enable" is to enable this advertising set. Any
@@ -85,6 +100,18 @@ struct AdvertisingInstance {
   bool enable_status;
   TimeTicks enable_time;
 
+  /* Advertising data [0] or scan response data [1] of the set */
+  struct DataState {
+    bool programmed_valid = false;
+    std::vector<uint8_t> programmed; /* last data the controller accepted */
+    uint64_t write_in_flight = 0;    /* id of the write in flight, or 0 */
+    std::vector<uint8_t> writing;
+    std::vector<uint8_t> pending; /* latest update waiting for the write */
+    std::vector<MultiAdvCb> pending_cbs;
+    std::vector<uint8_t> current; /* latest update, restored after rotation */
+  };
+  DataState data_state[2];
+
   bool IsEnabled() { return enable_status; }
 
   bool IsConnectable() { return is_connectable(advertising_event_properties); }
@@ -100,6 +127,9 @@ struct AdvertisingInstance {
         own_address(RawAddress::kEmpty),
         address_update_required(false),
         periodic_enabled(false),
+        advertising_interval(0),
+        params{},
+        handle(inst_id),
         enable_status(false) {
     adv_raddr_timer = alarm_new_periodic("btm_ble.adv_raddr_timer");
   }
@@ -115,6 +145,7 @@ struct AdvertisingInstance {
 };
 
 void btm_ble_adv_raddr_timer_timeout(void* data);
+void btm_ble_adv_rotation_timeout(void* data);
 
 struct closure_data {
   base::Closure user_task;
@@ -171,7 +202,10 @@ class BleAdvertisingManagerImpl
                    weak_factory_.GetWeakPtr()));
   }
 
-  ~BleAdvertisingManagerImpl() override { adv_inst.clear(); }
+  ~BleAdvertisingManagerImpl() override {
+    adv_inst.clear();
+    alarm_free(rotation_timer);
+  }
 
   void GetOwnAddress(uint8_t inst_id, GetAddressCallback cb) override {
     cb.Run(adv_inst[inst_id].own_address_type, adv_inst[inst_id].own_address);
@@ -179,11 +213,20 @@ class BleAdvertisingManagerImpl
 
   void ReadInstanceCountCb(uint8_t instance_count) {
     this->inst_count = instance_count;
-    adv_inst.reserve(inst_count);
+    adv_inst.reserve(inst_count + ROTATED_SETS_MAX);
     /* Initialize adv instance indices and IDs. */
     for (uint8_t i = 0; i < inst_count; i++) {
       adv_inst.emplace_back(i);
     }
+    /* Ids of the rotated sets follow those of the controller instances */
+    int rotated_sets = std::min<int>(ROTATED_SETS_MAX, NO_HANDLE - inst_count);
+    for (int i = 0; i < rotated_sets; i++) {
+      adv_inst.emplace_back(inst_count + i);
+      adv_inst.back().handle = NO_HANDLE;
+    }
+    handle_content.resize(inst_count);
+    for (uint8_t i = 0; i < inst_count; i++) handle_content[i] = i;
+    rotation_timer = alarm_new("btm_ble.adv_rotation_timer");
   }
 
   void GenerateRpa(base::Callback<void(const RawAddress&)> cb) {
@@ -212,15 +255,23 @@ class BleAdvertisingManagerImpl
           if (!instance_weakptr.get()) return;
           auto hci_interface = instance_weakptr.get()->GetHciInterface();
 
+          /* A set off air gets its address when it is programmed again */
+          if (!instance_weakptr.get()->IsResident(*p_inst)) {
+            p_inst->own_address = bda;
+            instance_weakptr.get()->ForgetProgrammed(p_inst->inst_id);
+            configuredCb.Run(0x00);
+            return;
+          }
+
           if (restart) {
             p_inst->enable_status = false;
-            hci_interface->Enable(false, p_inst->inst_id, 0x00, 0x00,
+            hci_interface->Enable(false, p_inst->handle, 0x00, 0x00,
                                   base::DoNothing());
           }
 
           /* set it to controller */
           hci_interface->SetRandomAddress(
-              p_inst->inst_id, bda,
+              p_inst->handle, bda,
               Bind(
                   [](AdvertisingInstance* p_inst, RawAddress bda,
                      MultiAdvCb configuredCb, uint8_t status) {
@@ -231,7 +282,7 @@ class BleAdvertisingManagerImpl
 
           if (restart) {
             p_inst->enable_status = true;
-            hci_interface->Enable(true, p_inst->inst_id, 0x00, 0x00,
+            hci_interface->Enable(true, p_inst->handle, 0x00, 0x00,
                                   base::DoNothing());
           }
         },
@@ -246,6 +297,9 @@ class BleAdvertisingManagerImpl
       if (p_inst->in_use) continue;
 
       p_inst->in_use = true;
+      EvictHandle(i);
+      for (auto& state : p_inst->data_state) state = {};
+      if (RotationActive()) RunRotation();
 
       // set up periodic timer to update address.
       if (BTM_BleLocalPrivacyEnabled()) {
@@ -405,6 +459,14 @@ class BleAdvertisingManagerImpl
           return;
         }
 
+        if (status == ADVERTISE_FAILED_TOO_MANY_ADVERTISERS &&
+            CanRotate(c->params, c->periodic_params, c->duration,
+                      c->maxExtAdvEvents)) {
+          auto self = c->self;
+          self->StartRotatedAdvertisingSet(std::move(c));
+          return;
+        }
+
         if (status != 0) {
           LOG(ERROR) << " failed, status: " << +status;
           c->cb.Run(0, 0, status);
@@ -612,7 +674,7 @@ class BleAdvertisingManagerImpl
   void Enable(uint8_t inst_id, bool enable, MultiAdvCb cb, uint16_t duration,
               uint8_t maxExtAdvEvents, MultiAdvCb timeout_cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
-    if (inst_id >= inst_count) {
+    if (inst_id >= adv_inst.size()) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
     }
@@ -625,6 +687,12 @@ class BleAdvertisingManagerImpl
       return;
     }
 
+    if (IsRotated(inst_id)) {
+      EnableRotated(p_inst, enable, std::move(cb), duration, maxExtAdvEvents);
+      return;
+    }
+    Reclaim(inst_id);
+
     if (enable && (duration || maxExtAdvEvents)) {
       p_inst->timeout_cb = std::move(timeout_cb);
     }
@@ -666,12 +734,15 @@ class BleAdvertisingManagerImpl
     p_inst->enable_status = enable;
     GetHciInterface()->Enable(enable, p_inst->inst_id, p_inst->duration,
                               p_inst->maxExtAdvEvents, std::move(myCb));
+
+    /* The instance may have joined or left the rotation */
+    if (RotationActive()) RunRotation();
   }
 
   void SetParameters(uint8_t inst_id, tBTM_BLE_ADV_PARAMS* p_params,
                      ParametersCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
-    if (inst_id >= inst_count) {
+    if (inst_id >= adv_inst.size()) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
     }
@@ -683,6 +754,15 @@ class BleAdvertisingManagerImpl
       return;
     }
 
+    if (IsRotated(inst_id)) {
+      SetRotatedParameters(p_inst, p_params, std::move(cb));
+      return;
+    }
+    Reclaim(inst_id);
+
+    /* The data may not survive new parameters, write it again on update */
+    for (auto& state : p_inst->data_state) state.programmed_valid = false;
+
     // TODO: disable only if was enabled, currently no use scenario needs
     // that,
     // we always set parameters before enabling
@@ -691,6 +771,7 @@ class BleAdvertisingManagerImpl
         p_params->advertising_event_properties;
     p_inst->tx_power = p_params->tx_power;
     p_inst->advertising_interval = p_params->adv_int_min;
+    p_inst->params = *p_params;
     const RawAddress& peer_address = RawAddress::kEmpty;
 
     // sid must be in range 0x00 to 0x0F. Since no controller supports more than
@@ -710,12 +791,15 @@ class BleAdvertisingManagerImpl
     // SetParamsCallback
     // currently no use scenario needs that
     // GetHciInterface()->Enable(true, inst_id, BTM_BleUpdateAdvInstParamCb);
+
+    /* The instance may have joined or left the rotation */
+    if (RotationActive()) RunRotation();
   }
 
   void SetData(uint8_t inst_id, bool is_scan_rsp, std::vector<uint8_t> data,
                MultiAdvCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
-    if (inst_id >= inst_count) {
+    if (inst_id >= adv_inst.size()) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
     }
@@ -746,12 +830,73 @@ class BleAdvertisingManagerImpl
     }
 
     VLOG(1) << "data is: " << base::HexEncode(data.data(), data.size());
+
+    AdvertisingInstance::DataState& state = p_inst->data_state[is_scan_rsp];
+    state.current = data;
+
+    /* A set off air gets its data written when it is programmed again */
+    if (!IsResident(*p_inst)) {
+      cb.Run(0);
+      return;
+    }
+
+    /* Apps updating their data faster than the controller takes it only get
+     * their latest data written, once the write in flight completes */
+    if (state.write_in_flight != 0) {
+      state.pending = std::move(data);
+      state.pending_cbs.push_back(std::move(cb));
+      return;
+    }
+    WriteData(inst_id, is_scan_rsp, std::move(data), {std::move(cb)});
+  }
+
+  void WriteData(uint8_t inst_id, bool is_scan_rsp, std::vector<uint8_t> data,
+                 std::vector<MultiAdvCb> cbs) {
+    AdvertisingInstance::DataState& state =
+        adv_inst[inst_id].data_state[is_scan_rsp];
+    if (state.programmed_valid && state.programmed == data) {
+      VLOG(1) << "data already set";
+      for (auto& cb : cbs) cb.Run(0);
+      return;
+    }
+
+    state.write_in_flight = ++last_data_write_id;
+    state.writing = data;
     DivideAndSendData(
-        inst_id, data, cb,
+        adv_inst[inst_id].handle, std::move(data),
+        base::Bind(&BleAdvertisingManagerImpl::OnDataWritten,
+                   weak_factory_.GetWeakPtr(), inst_id, is_scan_rsp,
+                   state.write_in_flight, std::move(cbs)),
         base::Bind(&BleAdvertisingManagerImpl::SetDataAdvDataSender,
                    weak_factory_.GetWeakPtr(), is_scan_rsp));
   }
 
+  void OnDataWritten(uint8_t inst_id, bool is_scan_rsp, uint64_t write_id,
+                     std::vector<MultiAdvCb> cbs, uint8_t status) {
+    for (auto& cb : cbs) cb.Run(status);
+
+    AdvertisingInstance::DataState& state =
+        adv_inst[inst_id].data_state[is_scan_rsp];
+    /* The set was registered again meanwhile */
+    if (state.write_in_flight != write_id) return;
+
+    state.write_in_flight = 0;
+    state.programmed_valid = status == 0;
+    state.programmed = std::move(state.writing);
+
+    if (!state.pending_cbs.empty()) {
+      std::vector<MultiAdvCb> pending_cbs = std::move(state.pending_cbs);
+      state.pending_cbs.clear();
+      /* The set went off air meanwhile, |current| holds the update */
+      if (!IsResident(adv_inst[inst_id])) {
+        for (auto& cb : pending_cbs) cb.Run(0);
+        return;
+      }
+      WriteData(inst_id, is_scan_rsp, std::move(state.pending),
+                std::move(pending_cbs));
+    }
+  }
+
   void SetDataAdvDataSender(uint8_t is_scan_rsp, uint8_t inst_id,
                             uint8_t operation, uint8_t length, uint8_t* data,
                             MultiAdvCb cb) {
@@ -807,6 +952,12 @@ class BleAdvertisingManagerImpl
                                         tBLE_PERIODIC_ADV_PARAMS* params,
                                         MultiAdvCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
+    if (IsRotated(inst_id)) {
+      LOG(ERROR) << "no periodic advertising on rotated set " << +inst_id;
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+      return;
+    }
+    Reclaim(inst_id);
 
     GetHciInterface()->SetPeriodicAdvertisingParameters(
         inst_id, params->min_interval, params->max_interval,
@@ -816,6 +967,12 @@ class BleAdvertisingManagerImpl
   void SetPeriodicAdvertisingData(uint8_t inst_id, std::vector<uint8_t> data,
                                   MultiAdvCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
+    if (IsRotated(inst_id)) {
+      LOG(ERROR) << "no periodic advertising on rotated set " << +inst_id;
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+      return;
+    }
+    Reclaim(inst_id);
 
     VLOG(1) << "data is: " << base::HexEncode(data.data(), data.size());
 
@@ -830,11 +987,12 @@ class BleAdvertisingManagerImpl
     VLOG(1) << __func__ << " inst_id: " << +inst_id << ", enable: " << +enable;
 
     AdvertisingInstance* p_inst = &adv_inst[inst_id];
-    if (!p_inst->in_use) {
+    if (!p_inst->in_use || IsRotated(inst_id)) {
       LOG(ERROR) << "Invalid or not active instance";
       cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
       return;
     }
+    Reclaim(inst_id);
 
     MultiAdvCb enable_cb = Bind(
         [](AdvertisingInstance* p_inst, uint8_t enable, MultiAdvCb cb,
@@ -853,14 +1011,19 @@ class BleAdvertisingManagerImpl
   }
 
   void Unregister(uint8_t inst_id) override {
-    AdvertisingInstance* p_inst = &adv_inst[inst_id];
-
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
-    if (inst_id >= inst_count) {
+    if (inst_id >= adv_inst.size()) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
     }
 
+    AdvertisingInstance* p_inst = &adv_inst[inst_id];
+    if (IsRotated(inst_id)) {
+      UnregisterRotated(p_inst);
+      return;
+    }
+    EvictHandle(inst_id);
+
     if (adv_inst[inst_id].IsEnabled()) {
       p_inst->enable_status = false;
       GetHciInterface()->Enable(false, inst_id, 0x00, 0x00, base::DoNothing());
@@ -876,6 +1039,9 @@ class BleAdvertisingManagerImpl
     p_inst->in_use = false;
     GetHciInterface()->RemoveAdvertisingSet(inst_id, base::DoNothing());
     p_inst->address_update_required = false;
+
+    /* The instance is free for the rotated sets */
+    if (RotationActive()) RunRotation();
   }
 
   void RecomputeTimeout(AdvertisingInstance* inst, TimeTicks now) {
@@ -908,13 +1074,15 @@ class BleAdvertisingManagerImpl
   void Suspend() override {
     std::vector<SetEnableData> sets;
 
+    suspended = true;
+    alarm_cancel(rotation_timer);
     for (AdvertisingInstance& inst : adv_inst) {
-      if (!inst.in_use || !inst.enable_status) continue;
+      if (!inst.in_use || !inst.enable_status || !IsResident(inst)) continue;
 
       if (inst.duration || inst.maxExtAdvEvents)
         RecomputeTimeout(&inst, TimeTicks::Now());
 
-      sets.emplace_back(SetEnableData{.handle = inst.inst_id});
+      sets.emplace_back(SetEnableData{.handle = inst.handle});
     }
 
     if (!sets.empty())
@@ -924,21 +1092,28 @@ class BleAdvertisingManagerImpl
   void Resume() override {
     std::vector<SetEnableData> sets;
 
+    suspended = false;
     for (const AdvertisingInstance& inst : adv_inst) {
-      if (inst.in_use && inst.enable_status) {
+      if (inst.in_use && inst.enable_status && IsResident(inst)) {
         sets.emplace_back(SetEnableData{
-            .handle = inst.inst_id,
+            .handle = inst.handle,
             .duration = inst.duration,
             .max_extended_advertising_events = inst.maxExtAdvEvents});
       }
     }
 
     if (!sets.empty()) GetHciInterface()->Enable(true, sets, base::DoNothing());
+    if (RotationActive()) RunRotation();
   }
 
   void OnAdvertisingSetTerminated(
       uint8_t status, uint8_t advertising_handle, uint16_t connection_handle,
       uint8_t num_completed_extended_adv_events) override {
+    /* Report the event for the set programmed on the instance */
+    if (advertising_handle < handle_content.size() &&
+        handle_content[advertising_handle] != NO_HANDLE) {
+      advertising_handle = handle_content[advertising_handle];
+    }
     AdvertisingInstance* p_inst = &adv_inst[advertising_handle];
     VLOG(1) << __func__ << "status: " << loghex(status)
             << ", advertising_handle: " << loghex(advertising_handle)
@@ -984,13 +1159,395 @@ class BleAdvertisingManagerImpl
     }
   }
 
+  /* Rotation of the advertising sets.
+   *
+   * Sets started with StartAdvertisingSet() once every controller instance is
+   * taken get an id past the instance count, as long as they are neither
+   * connectable nor periodic and do not time out. These sets take turns, in
+   * slots of ROTATION_SLOT_MS, on the instances that are free or whose own
+   * set could be parked and restored the same way. Each slot goes to the sets
+   * that waited the longest relative to their advertising interval. The sets
+   * that keep their instance are left alone, the others are disabled and
+   * enabled with one command each. An instance remembers the last set
+   * programmed on it, so that a set coming back only gets the data that
+   * changed meanwhile written again.
+   */
+  static bool CanRotate(const tBTM_BLE_ADV_PARAMS& params,
+                        const tBLE_PERIODIC_ADV_PARAMS& periodic_params,
+                        uint16_t duration, uint8_t maxExtAdvEvents) {
+    return !is_connectable(params.advertising_event_properties) &&
+           (params.advertising_event_properties & 0x0C) == 0 &&
+           !periodic_params.enable && !duration && !maxExtAdvEvents;
+  }
+
+  bool IsRotated(uint8_t inst_id) { return inst_id >= inst_count; }
+
+  bool RotationActive() {
+    for (size_t i = inst_count; i < adv_inst.size(); i++) {
+      if (adv_inst[i].in_use) return true;
+    }
+    return false;
+  }
+
+  /* Whether the set is the one programmed on its instance */
+  bool IsResident(const AdvertisingInstance& inst) {
+    return inst.handle != NO_HANDLE &&
+           handle_content[inst.handle] == inst.inst_id;
+  }
+
+  /* Whether a set with an instance of its own can be parked for a slot */
+  bool IsShareable(AdvertisingInstance& inst) {
+    return inst.in_use && inst.enable_status && !inst.IsConnectable() &&
+           (inst.advertising_event_properties & 0x0C) == 0 &&
+           !inst.periodic_enabled && !inst.duration && !inst.maxExtAdvEvents;
+  }
+
+  bool WriteInFlight(const AdvertisingInstance& inst) {
+    return inst.data_state[0].write_in_flight != 0 ||
+           inst.data_state[1].write_in_flight != 0;
+  }
+
+  /* The set advertising on instance |handle|, nullptr if none */
+  AdvertisingInstance* OnAirOccupant(uint8_t handle) {
+    uint8_t inst_id = handle_content[handle];
+    if (inst_id == NO_HANDLE) return nullptr;
+
+    AdvertisingInstance* p_inst = &adv_inst[inst_id];
+    if (!p_inst->in_use || !p_inst->enable_status || p_inst->handle != handle)
+      return nullptr;
+    return p_inst;
+  }
+
+  /* The set must be programmed from scratch wherever it goes next */
+  void ForgetProgrammed(uint8_t inst_id) {
+    for (uint8_t& content : handle_content) {
+      if (content == inst_id) content = NO_HANDLE;
+    }
+  }
+
+  void TakeOffAir(AdvertisingInstance* p_inst) {
+    if (p_inst->handle == NO_HANDLE) return;
+    if (OnAirOccupant(p_inst->handle) == p_inst) {
+      GetHciInterface()->Enable(false, p_inst->handle, 0x00, 0x00,
+                                base::DoNothing());
+    }
+    p_inst->handle = NO_HANDLE;
+  }
+
+  /* Gives instance |handle| back to the set of the same id */
+  void EvictHandle(uint8_t handle) {
+    if (handle_content[handle] == handle) return;
+
+    AdvertisingInstance* occupant = OnAirOccupant(handle);
+    if (occupant) TakeOffAir(occupant);
+    handle_content[handle] = handle;
+    for (auto& state : adv_inst[handle].data_state)
+      state.programmed_valid = false;
+  }
+
+  /* Puts a parked set back on its instance, before an operation that the
+   * rotation could not replay */
+  void Reclaim(uint8_t inst_id) {
+    if (!adv_inst[inst_id].in_use || handle_content[inst_id] == inst_id)
+      return;
+    PlaceSets({{&adv_inst[inst_id], inst_id}});
+  }
+
+  /* Writes the parameters, address and data of the set to instance |handle|,
+   * skipping what is already there */
+  void ProgramSet(AdvertisingInstance* p_inst, uint8_t handle) {
+    p_inst->handle = handle;
+    if (handle_content[handle] != p_inst->inst_id) {
+      handle_content[handle] = p_inst->inst_id;
+      for (auto& state : p_inst->data_state) state.programmed_valid = false;
+
+      const tBTM_BLE_ADV_PARAMS& params = p_inst->params;
+      GetHciInterface()->SetParameters(
+          handle, params.advertising_event_properties, params.adv_int_min,
+          params.adv_int_max, params.channel_map, p_inst->own_address_type,
+          p_inst->own_address, 0x00, RawAddress::kEmpty,
+          params.adv_filter_policy, params.tx_power,
+          params.primary_advertising_phy, 0x00,
+          params.secondary_advertising_phy, p_inst->inst_id % 0x0F,
+          params.scan_request_notification_enable,
+          Bind([](uint8_t status, int8_t tx_power) {
+            if (status != 0)
+              LOG(ERROR) << "setting parameters failed, status: " << +status;
+          }));
+      if (p_inst->own_address_type == BLE_ADDR_RANDOM) {
+        GetHciInterface()->SetRandomAddress(handle, p_inst->own_address,
+                                            base::DoNothing());
+      }
+    }
+
+    for (int is_scan_rsp = 0; is_scan_rsp < 2; is_scan_rsp++) {
+      WriteData(p_inst->inst_id, is_scan_rsp,
+                p_inst->data_state[is_scan_rsp].current, {});
+    }
+  }
+
+  /* Programs each set on the instance paired with it, after taking the sets
+   * advertising there off air. Sets are disabled, then enabled, with a single
+   * command. */
+  void PlaceSets(
+      const std::vector<std::pair<AdvertisingInstance*, uint8_t>>& placements) {
+    std::vector<SetEnableData> disable_sets;
+    for (const auto& placement : placements) {
+      AdvertisingInstance* p_inst = placement.first;
+      if (p_inst->handle != NO_HANDLE && p_inst->handle != placement.second &&
+          OnAirOccupant(p_inst->handle) == p_inst) {
+        disable_sets.emplace_back(SetEnableData{.handle = p_inst->handle});
+      }
+
+      AdvertisingInstance* occupant = OnAirOccupant(placement.second);
+      if (occupant == nullptr || occupant == placement.first) continue;
+
+      disable_sets.emplace_back(SetEnableData{.handle = placement.second});
+      if (IsRotated(occupant->inst_id)) occupant->handle = NO_HANDLE;
+    }
+    if (!disable_sets.empty())
+      GetHciInterface()->Enable(false, disable_sets, base::DoNothing());
+
+    std::vector<SetEnableData> enable_sets;
+    for (const auto& placement : placements) {
+      ProgramSet(placement.first, placement.second);
+      if (placement.first->enable_status && !suspended)
+        enable_sets.emplace_back(SetEnableData{.handle = placement.second});
+    }
+    if (!enable_sets.empty())
+      GetHciInterface()->Enable(true, enable_sets, base::DoNothing());
+  }
+
+  /* Hands out the next rotation slot, see CanRotate() */
+  void RunRotation() {
+    alarm_cancel(rotation_timer);
+    if (suspended) return;
+
+    TimeTicks now = TimeTicks::Now();
+    std::vector<bool> in_pool(inst_count, false);
+    size_t pool_size = 0;
+    std::vector<AdvertisingInstance*> candidates;
+    for (uint8_t handle = 0; handle < inst_count; handle++) {
+      AdvertisingInstance& inst = adv_inst[handle];
+      if (inst.in_use && !IsShareable(inst)) continue;
+
+      /* A set taken off air in the middle of a data write still owns the
+       * instance until the write completes */
+      uint8_t content = handle_content[handle];
+      if (content != NO_HANDLE && WriteInFlight(adv_inst[content]) &&
+          OnAirOccupant(handle) != &adv_inst[content])
+        continue;
+
+      in_pool[handle] = true;
+      pool_size++;
+      if (inst.in_use) candidates.push_back(&inst);
+    }
+
+    bool rotating = false;
+    for (size_t i = inst_count; i < adv_inst.size(); i++) {
+      if (adv_inst[i].in_use && adv_inst[i].enable_status) {
+        candidates.push_back(&adv_inst[i]);
+        rotating = true;
+      }
+    }
+
+    /* Sets in the middle of a data write keep their instance, the slot goes
+     * to the others by how many of their intervals they waited */
+    std::vector<AdvertisingInstance*> chosen;
+    std::vector<AdvertisingInstance*> waiting;
+    std::vector<bool> kept(inst_count, false);
+    for (AdvertisingInstance* p_inst : candidates) {
+      if (p_inst->handle != NO_HANDLE &&
+          OnAirOccupant(p_inst->handle) == p_inst && WriteInFlight(*p_inst)) {
+        chosen.push_back(p_inst);
+        kept[p_inst->handle] = true;
+      } else {
+        waiting.push_back(p_inst);
+      }
+    }
+
+    auto waited = [now](const AdvertisingInstance* p_inst) {
+      double interval_ms = std::max(20.0, p_inst->params.adv_int_min * 0.625);
+      return (now - p_inst->last_slot_time).InMillisecondsF() / interval_ms;
+    };
+    std::stable_sort(waiting.begin(), waiting.end(),
+                     [&waited](const AdvertisingInstance* a,
+                               const AdvertisingInstance* b) {
+                       return waited(a) > waited(b);
+                     });
+    for (AdvertisingInstance* p_inst : waiting) {
+      if (chosen.size() >= pool_size) break;
+      if (!IsRotated(p_inst->inst_id) && kept[p_inst->inst_id]) continue;
+      chosen.push_back(p_inst);
+    }
+
+    /* Sets with an instance of their own go back to it, rotated sets stay
+     * where they are when they can, or go where they were last programmed */
+    std::vector<bool> taken = kept;
+    std::vector<std::pair<AdvertisingInstance*, uint8_t>> placements;
+    std::vector<AdvertisingInstance*> unplaced;
+    for (AdvertisingInstance* p_inst : chosen) {
+      if (IsRotated(p_inst->inst_id) || kept[p_inst->inst_id]) continue;
+      taken[p_inst->inst_id] = true;
+      if (OnAirOccupant(p_inst->inst_id) != p_inst)
+        placements.emplace_back(p_inst, p_inst->inst_id);
+    }
+    for (AdvertisingInstance* p_inst : chosen) {
+      if (!IsRotated(p_inst->inst_id)) continue;
+      uint8_t handle = p_inst->handle;
+      if (handle != NO_HANDLE && in_pool[handle] && !taken[handle]) {
+        taken[handle] = true;
+      } else if (handle == NO_HANDLE || !kept[handle]) {
+        unplaced.push_back(p_inst);
+      }
+    }
+    for (AdvertisingInstance* p_inst : unplaced) {
+      int target = -1;
+      for (uint8_t handle = 0; handle < inst_count; handle++) {
+        if (!in_pool[handle] || taken[handle]) continue;
+        if (target < 0) target = handle;
+        if (handle_content[handle] == p_inst->inst_id) {
+          target = handle;
+          break;
+        }
+      }
+      if (target < 0) break;
+      taken[target] = true;
+      placements.emplace_back(p_inst, target);
+    }
+
+    PlaceSets(placements);
+    for (AdvertisingInstance* p_inst : chosen) p_inst->last_slot_time = now;
+
+    if (rotating) {
+      alarm_set_on_mloop(rotation_timer, ROTATION_SLOT_MS,
+                         btm_ble_adv_rotation_timeout, nullptr);
+    }
+  }
+
+  void StartRotatedAdvertisingSet(c_type c) {
+    AdvertisingInstance* p_inst = nullptr;
+    for (size_t i = inst_count; i < adv_inst.size(); i++) {
+      if (!adv_inst[i].in_use) {
+        p_inst = &adv_inst[i];
+        break;
+      }
+    }
+    if (p_inst == nullptr) {
+      LOG(INFO) << "no free rotated advertising set";
+      c->cb.Run(0, 0, ADVERTISE_FAILED_TOO_MANY_ADVERTISERS);
+      return;
+    }
+
+    VLOG(1) << __func__ << " inst_id: " << +p_inst->inst_id;
+    p_inst->in_use = true;
+    p_inst->handle = NO_HANDLE;
+    p_inst->enable_status = false;
+    p_inst->periodic_enabled = false;
+    p_inst->duration = 0;
+    p_inst->maxExtAdvEvents = 0;
+    p_inst->last_slot_time = TimeTicks();
+    for (auto& state : p_inst->data_state) state = {};
+    ForgetProgrammed(p_inst->inst_id);
+
+    p_inst->params = c->params;
+    p_inst->advertising_event_properties =
+        c->params.advertising_event_properties;
+    p_inst->tx_power = c->params.tx_power;
+    p_inst->advertising_interval = c->params.adv_int_min;
+    c->inst_id = p_inst->inst_id;
+
+    if (BTM_BleLocalPrivacyEnabled()) {
+      p_inst->own_address_type = BLE_ADDR_RANDOM;
+      GenerateRpa(
+          Bind(&BleAdvertisingManagerImpl::StartRotatedAdvertisingSetFinish,
+               weak_factory_.GetWeakPtr(), base::Passed(&c)));
+    } else {
+      p_inst->own_address_type = BLE_ADDR_PUBLIC;
+      StartRotatedAdvertisingSetFinish(
+          std::move(c), *controller_get_interface()->get_address());
+    }
+  }
+
+  void StartRotatedAdvertisingSetFinish(c_type c, const RawAddress& bda) {
+    AdvertisingInstance* p_inst = &adv_inst[c->inst_id];
+    p_inst->own_address = bda;
+    if (p_inst->own_address_type == BLE_ADDR_RANDOM) {
+      alarm_set_on_mloop(p_inst->adv_raddr_timer,
+                         btm_get_next_private_addrress_interval_ms(),
+                         btm_ble_adv_raddr_timer_timeout, p_inst);
+    }
+
+    SetData(c->inst_id, false, std::move(c->advertise_data),
+            base::DoNothing());
+    SetData(c->inst_id, true, std::move(c->scan_response_data),
+            base::DoNothing());
+
+    p_inst->enable_status = true;
+    p_inst->enable_time = TimeTicks::Now();
+    RunRotation();
+
+    c->cb.Run(c->inst_id, p_inst->tx_power, BTM_BLE_MULTI_ADV_SUCCESS);
+  }
+
+  void EnableRotated(AdvertisingInstance* p_inst, bool enable, MultiAdvCb cb,
+                     uint16_t duration, uint8_t maxExtAdvEvents) {
+    if (enable && (duration || maxExtAdvEvents)) {
+      LOG(ERROR) << "rotated set " << +p_inst->inst_id << " can't time out";
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+      return;
+    }
+
+    if (!enable) TakeOffAir(p_inst);
+    if (enable && !p_inst->enable_status) {
+      p_inst->enable_time = TimeTicks::Now();
+    }
+    p_inst->enable_status = enable;
+    RunRotation();
+    cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+  }
+
+  void SetRotatedParameters(AdvertisingInstance* p_inst,
+                            tBTM_BLE_ADV_PARAMS* p_params, ParametersCb cb) {
+    tBLE_PERIODIC_ADV_PARAMS no_periodic_params = {};
+    if (!CanRotate(*p_params, no_periodic_params, 0, 0)) {
+      LOG(ERROR) << "rotated set " << +p_inst->inst_id
+                 << " can't be connectable";
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE, 0);
+      return;
+    }
+
+    /* The new parameters are written with the next slot */
+    TakeOffAir(p_inst);
+    ForgetProgrammed(p_inst->inst_id);
+    p_inst->params = *p_params;
+    p_inst->advertising_event_properties =
+        p_params->advertising_event_properties;
+    p_inst->tx_power = p_params->tx_power;
+    p_inst->advertising_interval = p_params->adv_int_min;
+    RunRotation();
+    cb.Run(BTM_BLE_MULTI_ADV_SUCCESS, p_inst->tx_power);
+  }
+
+  void UnregisterRotated(AdvertisingInstance* p_inst) {
+    TakeOffAir(p_inst);
+    ForgetProgrammed(p_inst->inst_id);
+    alarm_cancel(p_inst->adv_raddr_timer);
+    p_inst->in_use = false;
+    p_inst->enable_status = false;
+
+    /* Parked sets go back to their instance once the last one is gone */
+    RunRotation();
+  }
+
   base::WeakPtr<BleAdvertisingManagerImpl> GetWeakPtr() {
     return weak_factory_.GetWeakPtr();
   }
 
   void CancelAdvAlarms() {
+    alarm_cancel(rotation_timer);
     AdvertisingInstance* p_inst = &adv_inst[0];
-    for (uint8_t i = 0; i < inst_count; i++, p_inst++) {
+    for (size_t i = 0; i < adv_inst.size(); i++, p_inst++) {
       if (p_inst->timeout_timer) {
         alarm_cancel(p_inst->timeout_timer);
       }
@@ -1006,6 +1563,13 @@ class BleAdvertisingManagerImpl
   BleAdvertiserHciInterface* hci_interface = nullptr;
   std::vector<AdvertisingInstance> adv_inst;
   uint8_t inst_count;
+  uint64_t last_data_write_id = 0;
+
+  /* Id of the set last programmed on each controller instance, NO_HANDLE if
+   * it can't be reused */
+  std::vector<uint8_t> handle_content;
+  alarm_t* rotation_timer = nullptr;
+  bool suspended = false;
 
   // Member variables should appear before the WeakPtrFactory, to ensure
   // that any WeakPtrs are invalidated before its members
@@ -1017,6 +1581,11 @@ void btm_ble_adv_raddr_timer_timeout(void* data) {
   BleAdvertisingManagerImpl* ptr = instance_weakptr.get();
   if (ptr) ptr->ConfigureRpa((AdvertisingInstance*)data, base::DoNothing());
 }
+
+void btm_ble_adv_rotation_timeout(void* data) {
+  BleAdvertisingManagerImpl* ptr = instance_weakptr.get();
+  if (ptr) ptr->RunRotation();
+}
 }  // namespace
 
 void BleAdvertisingManager::Initialize(BleAdvertiserHciInterface* interface) {
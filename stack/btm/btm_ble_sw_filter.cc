@@ -0,0 +1,319 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_ble_sw_filter.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "stack/include/bt_types.h"
+#include "stack/include/btm_ble_api_types.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+/* Service solicitation AD types */
+constexpr uint8_t kSol16BitsUuidType = 0x14;
+constexpr uint8_t kSol32BitsUuidType = 0x1F;
+constexpr uint8_t kSol128BitsUuidType = 0x15;
+
+/* Controllers match the first 29 bytes of names and data patterns */
+constexpr size_t kMaxPatternLen = BTM_BLE_PF_STR_LEN_MAX;
+
+bool masked_equal(const uint8_t* data, const uint8_t* pattern,
+                  const uint8_t* mask, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if ((data[i] & mask[i]) != (pattern[i] & mask[i])) return false;
+  }
+  return true;
+}
+
+/* The mask of |uuid| in its 128 bit little endian form: |uuid_mask| applies to
+ * the bytes of the shortest representation of |uuid|, the bytes of the base
+ * UUID always have to match */
+Uuid::UUID128Bit uuid_mask_128(const Uuid& uuid, const Uuid& uuid_mask) {
+  Uuid::UUID128Bit mask;
+  mask.fill(0xff);
+  if (uuid_mask.IsEmpty()) return mask;
+
+  size_t len = uuid.GetShortestRepresentationSize();
+  if (len == Uuid::kNumBytes16) {
+    uint16_t mask16 = uuid_mask.As16Bit();
+    mask[12] = mask16 & 0xff;
+    mask[13] = mask16 >> 8;
+  } else if (len == Uuid::kNumBytes32) {
+    uint32_t mask32 = uuid_mask.As32Bit();
+    for (int i = 0; i < 4; i++) mask[12 + i] = (mask32 >> (8 * i)) & 0xff;
+  } else {
+    mask = uuid_mask.To128BitLE();
+  }
+  return mask;
+}
+
+/* Widens the |len| bytes UUID at |p| to its 128 bit little endian form */
+Uuid::UUID128Bit uuid_to_128(const uint8_t* p, size_t len) {
+  static const Uuid::UUID128Bit base = Uuid::From16Bit(0).To128BitLE();
+  if (len == Uuid::kNumBytes128) {
+    Uuid::UUID128Bit uuid;
+    memcpy(uuid.data(), p, Uuid::kNumBytes128);
+    return uuid;
+  }
+  Uuid::UUID128Bit uuid = base;
+  memcpy(uuid.data() + 12, p, len);
+  return uuid;
+}
+
+size_t uuid_len_of_type(uint8_t ad_type, bool solicitation) {
+  if (solicitation) {
+    switch (ad_type) {
+      case kSol16BitsUuidType:
+        return Uuid::kNumBytes16;
+      case kSol32BitsUuidType:
+        return Uuid::kNumBytes32;
+      case kSol128BitsUuidType:
+        return Uuid::kNumBytes128;
+    }
+    return 0;
+  }
+  switch (ad_type) {
+    case BT_EIR_MORE_16BITS_UUID_TYPE:
+    case BT_EIR_COMPLETE_16BITS_UUID_TYPE:
+      return Uuid::kNumBytes16;
+    case BT_EIR_MORE_32BITS_UUID_TYPE:
+    case BT_EIR_COMPLETE_32BITS_UUID_TYPE:
+      return Uuid::kNumBytes32;
+    case BT_EIR_MORE_128BITS_UUID_TYPE:
+    case BT_EIR_COMPLETE_128BITS_UUID_TYPE:
+      return Uuid::kNumBytes128;
+  }
+  return 0;
+}
+
+bool is_service_data_type(uint8_t ad_type) {
+  return ad_type == BT_EIR_SERVICE_DATA_16BITS_UUID_TYPE ||
+         ad_type == BT_EIR_SERVICE_DATA_32BITS_UUID_TYPE ||
+         ad_type == BT_EIR_SERVICE_DATA_128BITS_UUID_TYPE;
+}
+
+}  // namespace
+
+void BleSoftwareFilter::Set(uint8_t filt_index,
+                            const std::vector<ApcfCommand>& commands) {
+  Program& program = programs_[filt_index];
+  program.code.clear();
+  program.pool.clear();
+
+  auto emit = [&program](uint8_t type, const uint8_t* pattern,
+                         const uint8_t* mask, size_t len) {
+    Instruction insn = {type, 0, 0, (uint16_t)program.pool.size(),
+                        (uint8_t)len};
+    program.pool.insert(program.pool.end(), pattern, pattern + len);
+    if (mask) {
+      program.pool.insert(program.pool.end(), mask, mask + len);
+    } else {
+      program.pool.insert(program.pool.end(), len, 0xff);
+    }
+    program.code.push_back(insn);
+  };
+
+  for (const ApcfCommand& cmd : commands) {
+    if (cmd.data.size() != cmd.data_mask.size() && cmd.data.size() != 0 &&
+        cmd.data_mask.size() != 0) {
+      continue;
+    }
+
+    switch (cmd.type) {
+      case BTM_BLE_PF_ADDR_FILTER:
+        emit(cmd.type, cmd.address.address, nullptr, RawAddress::kLength);
+        break;
+
+      case BTM_BLE_PF_SRVC_DATA:
+        emit(cmd.type, nullptr, nullptr, 0);
+        break;
+
+      case BTM_BLE_PF_SRVC_UUID:
+      case BTM_BLE_PF_SRVC_SOL_UUID: {
+        Uuid::UUID128Bit uuid = cmd.uuid.To128BitLE();
+        Uuid::UUID128Bit mask = uuid_mask_128(cmd.uuid, cmd.uuid_mask);
+        emit(cmd.type, uuid.data(), mask.data(), Uuid::kNumBytes128);
+        break;
+      }
+
+      case BTM_BLE_PF_LOCAL_NAME:
+        emit(cmd.type, cmd.name.data(), nullptr,
+             std::min(cmd.name.size(), kMaxPatternLen));
+        break;
+
+      case BTM_BLE_PF_MANU_DATA: {
+        /* The data is only matched when a mask comes with it */
+        size_t len = cmd.data_mask.empty()
+                         ? 0
+                         : std::min(cmd.data.size(), kMaxPatternLen - 2);
+        emit(cmd.type, cmd.data.data(), cmd.data_mask.data(), len);
+        program.code.back().company = cmd.company;
+        program.code.back().company_mask =
+            cmd.company_mask != 0 ? cmd.company_mask : 0xffff;
+        break;
+      }
+
+      case BTM_BLE_PF_SRVC_DATA_PATTERN:
+        emit(cmd.type, cmd.data.data(),
+             cmd.data_mask.empty() ? nullptr : cmd.data_mask.data(),
+             std::min(cmd.data.size(), kMaxPatternLen - 2));
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  std::stable_sort(program.code.begin(), program.code.end(),
+                   [](const Instruction& a, const Instruction& b) {
+                     return a.type < b.type;
+                   });
+}
+
+void BleSoftwareFilter::Enable(uint8_t filt_index, bool enable) {
+  if (enable) {
+    programs_[filt_index].enabled = true;
+    return;
+  }
+  auto it = programs_.find(filt_index);
+  if (it != programs_.end()) it->second.enabled = false;
+}
+
+void BleSoftwareFilter::Clear(uint8_t filt_index) {
+  auto it = programs_.find(filt_index);
+  if (it == programs_.end()) return;
+  it->second.code.clear();
+  it->second.pool.clear();
+}
+
+void BleSoftwareFilter::ClearAll() { programs_.clear(); }
+
+bool BleSoftwareFilter::IsAnyEnabledFrom(uint8_t first_index) const {
+  for (auto it = programs_.lower_bound(first_index); it != programs_.end();
+       it++) {
+    if (it->second.enabled) return true;
+  }
+  return false;
+}
+
+bool BleSoftwareFilter::Match(const RawAddress& bda,
+                              const std::vector<uint8_t>& adv_data) const {
+  /* Split the data in fields once for all the filters */
+  std::vector<Field> fields;
+  size_t position = 0;
+  while (position < adv_data.size()) {
+    uint8_t len = adv_data[position];
+    if (len == 0 || position + 1 + len > adv_data.size()) break;
+    fields.push_back({adv_data[position + 1], (uint8_t)(len - 1),
+                      adv_data.data() + position + 2});
+    position += 1 + len;
+  }
+
+  for (const auto& entry : programs_) {
+    if (entry.second.enabled && Run(entry.second, bda, fields)) return true;
+  }
+  return false;
+}
+
+bool BleSoftwareFilter::Run(const Program& program, const RawAddress& bda,
+                            const std::vector<Field>& fields) {
+  /* Conditions of one type are OR'ed, the types are AND'ed */
+  size_t pc = 0;
+  while (pc < program.code.size()) {
+    uint8_t type = program.code[pc].type;
+    bool matched = false;
+    for (; pc < program.code.size() && program.code[pc].type == type; pc++) {
+      if (!matched) matched = Execute(program, program.code[pc], bda, fields);
+    }
+    if (!matched) return false;
+  }
+  return true;
+}
+
+bool BleSoftwareFilter::Execute(const Program& program,
+                                const Instruction& insn, const RawAddress& bda,
+                                const std::vector<Field>& fields) {
+  const uint8_t* pattern = program.pool.data() + insn.offset;
+  const uint8_t* mask = pattern + insn.len;
+
+  switch (insn.type) {
+    case BTM_BLE_PF_ADDR_FILTER:
+      return memcmp(bda.address, pattern, RawAddress::kLength) == 0;
+
+    case BTM_BLE_PF_SRVC_DATA:
+      for (const Field& field : fields) {
+        if (is_service_data_type(field.type)) return true;
+      }
+      return false;
+
+    case BTM_BLE_PF_SRVC_UUID:
+    case BTM_BLE_PF_SRVC_SOL_UUID: {
+      bool solicitation = insn.type == BTM_BLE_PF_SRVC_SOL_UUID;
+      for (const Field& field : fields) {
+        size_t uuid_len = uuid_len_of_type(field.type, solicitation);
+        if (uuid_len == 0) continue;
+        for (size_t i = 0; i + uuid_len <= field.len; i += uuid_len) {
+          Uuid::UUID128Bit uuid = uuid_to_128(field.data + i, uuid_len);
+          if (masked_equal(uuid.data(), pattern, mask, Uuid::kNumBytes128))
+            return true;
+        }
+      }
+      return false;
+    }
+
+    case BTM_BLE_PF_LOCAL_NAME:
+      for (const Field& field : fields) {
+        if (field.type != BT_EIR_COMPLETE_LOCAL_NAME_TYPE &&
+            field.type != BT_EIR_SHORTENED_LOCAL_NAME_TYPE)
+          continue;
+        if (field.len >= insn.len && (field.len == insn.len ||
+                                      insn.len == kMaxPatternLen) &&
+            memcmp(field.data, pattern, insn.len) == 0)
+          return true;
+      }
+      return false;
+
+    case BTM_BLE_PF_MANU_DATA:
+      for (const Field& field : fields) {
+        if (field.type != BT_EIR_MANUFACTURER_SPECIFIC_TYPE || field.len < 2)
+          continue;
+        uint16_t company = field.data[0] | (field.data[1] << 8);
+        if ((company & insn.company_mask) !=
+            (insn.company & insn.company_mask))
+          continue;
+        if (field.len - 2 >= insn.len &&
+            masked_equal(field.data + 2, pattern, mask, insn.len))
+          return true;
+      }
+      return false;
+
+    case BTM_BLE_PF_SRVC_DATA_PATTERN:
+      for (const Field& field : fields) {
+        if (!is_service_data_type(field.type)) continue;
+        if (field.len >= insn.len &&
+            masked_equal(field.data, pattern, mask, insn.len))
+          return true;
+      }
+      return false;
+  }
+  return false;
+}
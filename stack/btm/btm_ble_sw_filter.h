@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "hardware/bt_common_types.h"
+#include "types/raw_address.h"
+
+/* Host side matching of the advertising packet content filters (APCF), for the
+ * filters the controller has no room for.
+ *
+ * The conditions of each filter index are compiled into a short program: one
+ * instruction per condition, sorted by condition type, with the patterns and
+ * masks packed in a byte pool. A report matches a filter when, for every
+ * condition type of the filter, one of its conditions matches, and it matches
+ * the engine when it matches any enabled filter.
+ */
+class BleSoftwareFilter {
+ public:
+  /* Compiles |commands| as the conditions of |filt_index| */
+  void Set(uint8_t filt_index, const std::vector<ApcfCommand>& commands);
+
+  /* Enables or disables |filt_index|, as the filter parameter setup does */
+  void Enable(uint8_t filt_index, bool enable);
+
+  void Clear(uint8_t filt_index);
+  void ClearAll();
+
+  /* Returns true if a filter of index |first_index| or above is enabled */
+  bool IsAnyEnabledFrom(uint8_t first_index) const;
+
+  /* Returns true if any enabled filter matches the report of |bda| carrying
+   * the validated advertising data |adv_data| */
+  bool Match(const RawAddress& bda, const std::vector<uint8_t>& adv_data) const;
+
+ private:
+  struct Instruction {
+    uint8_t type; /* BTM_BLE_PF_* condition type */
+    uint16_t company;
+    uint16_t company_mask;
+    uint16_t offset; /* of the pattern in the pool, the mask follows it */
+    uint8_t len;     /* of the pattern */
+  };
+
+  struct Program {
+    bool enabled = false;
+    std::vector<Instruction> code;
+    std::vector<uint8_t> pool;
+  };
+
+  struct Field {
+    uint8_t type;
+    uint8_t len;
+    const uint8_t* data;
+  };
+
+  static bool Run(const Program& program, const RawAddress& bda,
+                  const std::vector<Field>& fields);
+  static bool Execute(const Program& program, const Instruction& insn,
+                      const RawAddress& bda, const std::vector<Field>& fields);
+
+  std::map<uint8_t, Program> programs_;
+};
@@ -73,6 +73,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
 
     p_dev_rec->bd_addr = bd_addr;
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_cb.sec_dev_rec_index.Update(p_dev_rec);
 
     /* use default value for background connection params */
     /* update conn params, use default value for background connection params */
@@ -125,6 +126,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
   p_dev_rec->link_key.fill(0);
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
+  btm_cb.sec_dev_rec_index.Remove(p_dev_rec);
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
 }
 
@@ -236,6 +238,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
 
   return (p_dev_rec);
 }
@@ -287,16 +290,6 @@ bool btm_dev_support_role_switch(const RawAddress& bd_addr) {
   return false;
 }
 
-bool is_handle_equal(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  uint16_t* handle = static_cast<uint16_t*>(context);
-
-  if (p_dev_rec->hci_handle == *handle || p_dev_rec->ble_hci_handle == *handle)
-    return false;
-
-  return true;
-}
-
 /*******************************************************************************
  *
  * Function         btm_find_dev_by_handle
@@ -308,20 +301,13 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
-
-  return NULL;
+  return btm_cb.sec_dev_rec_index.FindByHandle(handle);
 }
 
-bool is_address_equal(void* data, void* context) {
+bool is_address_resolvable(void* data, void* context) {
   tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
   const RawAddress* bd_addr = ((RawAddress*)context);
 
-  if (p_dev_rec->bd_addr == *bd_addr) return false;
-  // If a LE random address is looking for device record
-  if (p_dev_rec->ble.pseudo_addr == *bd_addr) return false;
-
   if (btm_ble_addr_resolvable(*bd_addr, p_dev_rec)) return false;
   return true;
 }
@@ -337,11 +323,24 @@ bool is_address_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
+  tBTM_SEC_DEV_REC* p_dev_rec =
+      btm_cb.sec_dev_rec_index.FindByAddress(bd_addr);
+  if (p_dev_rec) return p_dev_rec;
+
+  // If a LE random address is looking for device record
+  if (!BTM_BLE_IS_RESOLVE_BDA(bd_addr)) return NULL;
+
+  p_dev_rec = btm_cb.sec_dev_rec_index.FindRpaCandidate(bd_addr);
+  if (p_dev_rec && btm_ble_addr_resolvable(bd_addr, p_dev_rec))
+    return p_dev_rec;
+
   list_node_t* n =
-      list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+      list_foreach(btm_cb.sec_dev_rec, is_address_resolvable, (void*)&bd_addr);
+  if (n == NULL) return NULL;
 
-  return NULL;
+  p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  btm_cb.sec_dev_rec_index.PutRpa(bd_addr, p_dev_rec);
+  return p_dev_rec;
 }
 
 /*******************************************************************************
@@ -399,6 +398,8 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
       }
     }
   }
+
+  btm_cb.sec_dev_rec_index.Update(p_target_rec);
 }
 
 /*******************************************************************************
@@ -490,6 +491,7 @@ tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
   p_dev_rec =
       static_cast<tBTM_SEC_DEV_REC*>(osi_calloc(sizeof(tBTM_SEC_DEV_REC)));
   list_append(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
 
   // Initialize defaults
   p_dev_rec->sec_flags = BTM_SEC_IN_USE;
@@ -116,7 +116,7 @@ bool btm_dev_support_role_switch(const RawAddress& bd_addr);
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle);
 
-bool is_address_equal(void* data, void* context);
+bool is_address_resolvable(void* data, void* context);
 
 /*******************************************************************************
  *
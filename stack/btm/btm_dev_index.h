@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "common/lru.h"
+#include "stack/btm/security_device_record.h"
+#include "types/raw_address.h"
+
+/* Hash indexes of the security device records, by BD address, pseudo address,
+ * HCI handle and recently resolved RPA.
+ *
+ * The record fields are written all over the stack; the writers call Update()
+ * after changing an indexed field. Every hit is checked against the record
+ * fields, so a stale entry is never returned. When several records carry the
+ * same key the one allocated first wins, as in the walks over the record list.
+ */
+class SecDevRecIndex {
+ public:
+  SecDevRecIndex() : rpas_(kRpaCacheSize, "sec_dev_rec_rpas") {}
+
+  /* Indexes |p_dev_rec| under its current addresses and handles */
+  void Update(tBTM_SEC_DEV_REC* p_dev_rec) {
+    auto it = records_.find(p_dev_rec);
+    if (it == records_.end()) {
+      it = records_.emplace(p_dev_rec, Keys{next_seq_++}).first;
+    } else {
+      Unlink(p_dev_rec, it->second);
+    }
+
+    Keys& keys = it->second;
+    keys.bd_addr = p_dev_rec->bd_addr;
+    keys.pseudo_addr = p_dev_rec->ble.pseudo_addr;
+    keys.hci_handle = p_dev_rec->hci_handle;
+    keys.ble_hci_handle = p_dev_rec->ble_hci_handle;
+
+    by_address_.emplace(keys.bd_addr, p_dev_rec);
+    if (keys.pseudo_addr != keys.bd_addr)
+      by_address_.emplace(keys.pseudo_addr, p_dev_rec);
+    by_handle_.emplace(keys.hci_handle, p_dev_rec);
+    if (keys.ble_hci_handle != keys.hci_handle)
+      by_handle_.emplace(keys.ble_hci_handle, p_dev_rec);
+  }
+
+  /* Drops |p_dev_rec|, before it is freed */
+  void Remove(tBTM_SEC_DEV_REC* p_dev_rec) {
+    auto it = records_.find(p_dev_rec);
+    if (it == records_.end()) return;
+    Unlink(p_dev_rec, it->second);
+    records_.erase(it);
+  }
+
+  void Clear() {
+    records_.clear();
+    by_address_.clear();
+    by_handle_.clear();
+    rpas_.Clear();
+  }
+
+  /* Returns the record whose BD address or pseudo address is |bd_addr| */
+  tBTM_SEC_DEV_REC* FindByAddress(const RawAddress& bd_addr) const {
+    return FindFirst(by_address_, bd_addr, [&bd_addr](tBTM_SEC_DEV_REC* p) {
+      return p->bd_addr == bd_addr || p->ble.pseudo_addr == bd_addr;
+    });
+  }
+
+  /* Returns the record with the BR/EDR or LE link of handle |handle| */
+  tBTM_SEC_DEV_REC* FindByHandle(uint16_t handle) const {
+    return FindFirst(by_handle_, handle, [handle](tBTM_SEC_DEV_REC* p) {
+      return p->hci_handle == handle || p->ble_hci_handle == handle;
+    });
+  }
+
+  /* Remembers that |rpa| resolved with the IRK of |p_dev_rec| */
+  void PutRpa(const RawAddress& rpa, tBTM_SEC_DEV_REC* p_dev_rec) {
+    rpas_.Put(rpa, p_dev_rec);
+  }
+
+  /* Returns the record |rpa| last resolved to, if it is still allocated. The
+   * caller has to check the IRK of the record still resolves |rpa| */
+  tBTM_SEC_DEV_REC* FindRpaCandidate(const RawAddress& rpa) {
+    tBTM_SEC_DEV_REC** p_dev_rec = rpas_.Find(rpa);
+    if (p_dev_rec == nullptr || records_.count(*p_dev_rec) == 0) return nullptr;
+    return *p_dev_rec;
+  }
+
+ private:
+  /* Seen RPAs live for up to 15 minutes; the ones rotated out age out */
+  static constexpr size_t kRpaCacheSize = 64;
+
+  struct Keys {
+    uint64_t seq; /* allocation order */
+    RawAddress bd_addr;
+    RawAddress pseudo_addr;
+    uint16_t hci_handle;
+    uint16_t ble_hci_handle;
+  };
+
+  template <typename K>
+  static void Erase(
+      std::unordered_multimap<K, tBTM_SEC_DEV_REC*>& index, const K& key,
+      tBTM_SEC_DEV_REC* p_dev_rec) {
+    auto range = index.equal_range(key);
+    for (auto it = range.first; it != range.second; it++) {
+      if (it->second == p_dev_rec) {
+        index.erase(it);
+        return;
+      }
+    }
+  }
+
+  void Unlink(tBTM_SEC_DEV_REC* p_dev_rec, const Keys& keys) {
+    Erase(by_address_, keys.bd_addr, p_dev_rec);
+    if (keys.pseudo_addr != keys.bd_addr)
+      Erase(by_address_, keys.pseudo_addr, p_dev_rec);
+    Erase(by_handle_, keys.hci_handle, p_dev_rec);
+    if (keys.ble_hci_handle != keys.hci_handle)
+      Erase(by_handle_, keys.ble_hci_handle, p_dev_rec);
+  }
+
+  template <typename K, typename Matches>
+  tBTM_SEC_DEV_REC* FindFirst(
+      const std::unordered_multimap<K, tBTM_SEC_DEV_REC*>& index, const K& key,
+      Matches matches) const {
+    tBTM_SEC_DEV_REC* p_first = nullptr;
+    uint64_t first_seq = UINT64_MAX;
+    auto range = index.equal_range(key);
+    for (auto it = range.first; it != range.second; it++) {
+      if (!matches(it->second)) continue;
+      uint64_t seq = records_.at(it->second).seq;
+      if (seq < first_seq) {
+        p_first = it->second;
+        first_seq = seq;
+      }
+    }
+    return p_first;
+  }
+
+  uint64_t next_seq_ = 0;
+  std::unordered_map<tBTM_SEC_DEV_REC*, Keys> records_;
+  std::unordered_multimap<RawAddress, tBTM_SEC_DEV_REC*> by_address_;
+  std::unordered_multimap<uint16_t, tBTM_SEC_DEV_REC*> by_handle_;
+  bluetooth::common::LegacyLruCache<RawAddress, tBTM_SEC_DEV_REC*> rpas_;
+};
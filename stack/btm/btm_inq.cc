@@ -27,10 +27,13 @@
 
 #define LOG_TAG "bluetooth"
 
+#include <base/bind.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <unordered_map>
 
 #include "common/time_util.h"
 #include "device/include/controller.h"
@@ -46,6 +49,7 @@
 #include "stack/btm/btm_ble_int.h"
 #include "stack/btm/btm_int.h"
 #include "stack/btm/btm_int_types.h"
+#include "stack/btm/btm_rmt_cache.h"
 #include "stack/include/acl_api.h"
 #include "stack/include/btm_api.h"
 #include "stack/include/btm_ble_api.h"
@@ -133,6 +137,115 @@ const uint16_t BTM_EIR_UUID_LKUP_TBL[BTM_EIR_MAX_SERVICES] = {
     UUID_SERVCLASS_MESSAGE_ACCESS, UUID_SERVCLASS_MESSAGE_NOTIFICATION,
     UUID_SERVCLASS_HDP_SOURCE, UUID_SERVCLASS_HDP_SINK};
 
+namespace {
+
+/* Address index of the inquiry database entries, which are also linked from
+ * the most to the least recently used. Entries are released in place outside
+ * of this file too, so every lookup is checked against the entry. */
+class InqDbIndex {
+ public:
+  tINQ_DB_ENT* Find(const RawAddress& bda) {
+    auto it = slots_.find(bda);
+    if (it == slots_.end()) return nullptr;
+
+    uint16_t slot = it->second;
+    tINQ_DB_ENT* p_ent = &btm_cb.btm_inq_vars.inq_db[slot];
+    if (!p_ent->in_use || p_ent->inq_info.results.remote_bd_addr != bda) {
+      slots_.erase(it);
+      return nullptr;
+    }
+
+    Unlink(slot);
+    LinkFront(slot);
+    return p_ent;
+  }
+
+  /* Returns an unused entry if any, else the least recently used one, now
+   * indexed as the entry of |bda| */
+  tINQ_DB_ENT* Reuse(const RawAddress& bda) {
+    if (!initialized_) Rebuild();
+
+    uint16_t slot = tail_;
+    Unindex(slot);
+    Unlink(slot);
+    LinkFront(slot);
+    slots_[bda] = slot;
+    return &btm_cb.btm_inq_vars.inq_db[slot];
+  }
+
+  void Release(tINQ_DB_ENT* p_ent) {
+    if (!initialized_) Rebuild();
+
+    uint16_t slot = p_ent - btm_cb.btm_inq_vars.inq_db;
+    p_ent->in_use = false;
+    Unindex(slot);
+    Unlink(slot);
+    LinkBack(slot);
+  }
+
+  /* Indexes the entries in use again, after they were moved around */
+  void Rebuild() {
+    slots_.clear();
+    head_ = tail_ = kNone;
+    for (uint16_t slot = 0; slot < BTM_INQ_DB_SIZE; slot++) {
+      const tINQ_DB_ENT& ent = btm_cb.btm_inq_vars.inq_db[slot];
+      if (ent.in_use) {
+        slots_[ent.inq_info.results.remote_bd_addr] = slot;
+        LinkFront(slot);
+      } else {
+        LinkBack(slot);
+      }
+    }
+    initialized_ = true;
+  }
+
+ private:
+  static constexpr uint16_t kNone = UINT16_MAX;
+
+  void Unindex(uint16_t slot) {
+    auto it = slots_.find(
+        btm_cb.btm_inq_vars.inq_db[slot].inq_info.results.remote_bd_addr);
+    if (it != slots_.end() && it->second == slot) slots_.erase(it);
+  }
+
+  void Unlink(uint16_t slot) {
+    if (prev_[slot] != kNone) next_[prev_[slot]] = next_[slot];
+    if (next_[slot] != kNone) prev_[next_[slot]] = prev_[slot];
+    if (head_ == slot) head_ = next_[slot];
+    if (tail_ == slot) tail_ = prev_[slot];
+  }
+
+  void LinkFront(uint16_t slot) {
+    prev_[slot] = kNone;
+    next_[slot] = head_;
+    if (head_ != kNone) prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ == kNone) tail_ = slot;
+  }
+
+  void LinkBack(uint16_t slot) {
+    next_[slot] = kNone;
+    prev_[slot] = tail_;
+    if (tail_ != kNone) next_[tail_] = slot;
+    tail_ = slot;
+    if (head_ == kNone) head_ = slot;
+  }
+
+  bool initialized_ = false;
+  std::unordered_map<RawAddress, uint16_t> slots_;
+  uint16_t prev_[BTM_INQ_DB_SIZE];
+  uint16_t next_[BTM_INQ_DB_SIZE];
+  uint16_t head_ = kNone;
+  uint16_t tail_ = kNone;
+};
+
+InqDbIndex inq_db_index;
+
+/* Address index of the devices that responded to the current inquiry */
+std::unordered_map<RawAddress, tINQ_BDADDR*> inq_bdaddr_index;
+
+}  // namespace
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
@@ -142,6 +255,8 @@ static void btm_inq_rmt_name_failed_cancelled(void);
 static tBTM_STATUS btm_initiate_rem_name(const RawAddress& remote_bda,
                                          uint8_t origin, uint64_t timeout_ms,
                                          tBTM_CMPL_CB* p_cb);
+static void btm_inq_rmt_name_from_cache(const RawAddress& bd_addr,
+                                        const std::string& name);
 
 static uint8_t btm_convert_uuid_to_eir_service(uint16_t uuid16);
 void btm_set_eir_uuid(uint8_t* p_eir, tBTM_INQ_RESULTS* p_results);
@@ -150,6 +265,9 @@ static const uint8_t* btm_eir_get_uuid_list(uint8_t* p_eir, size_t eir_len,
                                             uint8_t* p_num_uuid,
                                             uint8_t* p_uuid_list_type);
 
+/* The running remote name request is answered from the cache */
+static bool rmt_name_from_cache = false;
+
 void SendRemoteNameRequest(const RawAddress& raw_address) {
   if (bluetooth::shim::is_gd_shim_enabled()) {
     return bluetooth::shim::SendRemoteNameRequest(raw_address);
@@ -291,6 +409,12 @@ void BTM_EnableInterlacedPageScan() {
   btm_cb.btm_inq_vars.page_scan_type = BTM_SCAN_TYPE_INTERLACED;
 }
 
+void BTM_SetStreamingActive(bool active) {
+  if (bluetooth::shim::is_gd_shim_enabled()) {
+    bluetooth::shim::BTM_SetStreamingActive(active);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         BTM_SetInquiryMode
@@ -625,7 +749,9 @@ tBTM_STATUS BTM_CancelRemoteDeviceName(void) {
 
   /* Make sure there is not already one in progress */
   if (p_inq->remname_active) {
-    if (BTM_UseLeLink(p_inq->remname_bda)) {
+    if (rmt_name_from_cache) {
+      /* Nothing to cancel, it completes right away */
+    } else if (BTM_UseLeLink(p_inq->remname_bda)) {
       /* Cancel remote name request for LE device, and process remote name
        * callback. */
       btm_inq_rmt_name_failed_cancelled();
@@ -897,7 +1023,7 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
     if (p_ent->in_use) {
       /* If this is the specified BD_ADDR or clearing all devices */
       if (p_bda == NULL || (p_ent->inq_info.results.remote_bd_addr == *p_bda)) {
-        p_ent->in_use = false;
+        inq_db_index.Release(p_ent);
       }
     }
   }
@@ -923,6 +1049,7 @@ void btm_clr_inq_result_flt(void) {
   osi_free_and_reset((void**)&p_inq->p_bd_db);
   p_inq->num_bd_entries = 0;
   p_inq->max_bd_entries = 0;
+  inq_bdaddr_index.clear();
 }
 
 /*******************************************************************************
@@ -937,21 +1064,20 @@ void btm_clr_inq_result_flt(void) {
  ******************************************************************************/
 bool btm_inq_find_bdaddr(const RawAddress& p_bda) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
-  tINQ_BDADDR* p_db = &p_inq->p_bd_db[0];
-  uint16_t xx;
 
   /* Don't bother searching, database doesn't exist or periodic mode */
-  if (!p_db) return (false);
+  if (!p_inq->p_bd_db) return (false);
 
-  for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++) {
-    if (p_db->bd_addr == p_bda && p_db->inq_count == p_inq->inq_counter)
-      return (true);
-  }
+  auto it = inq_bdaddr_index.find(p_bda);
+  if (it != inq_bdaddr_index.end() &&
+      it->second->inq_count == p_inq->inq_counter)
+    return (true);
 
-  if (xx < p_inq->max_bd_entries) {
+  if (p_inq->num_bd_entries < p_inq->max_bd_entries) {
+    tINQ_BDADDR* p_db = &p_inq->p_bd_db[p_inq->num_bd_entries++];
     p_db->inq_count = p_inq->inq_counter;
     p_db->bd_addr = p_bda;
-    p_inq->num_bd_entries++;
+    inq_bdaddr_index[p_bda] = p_db;
   }
 
   /* If here, New Entry */
@@ -969,16 +1095,7 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda) {
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
-      return (p_ent);
-  }
-
-  /* If here, not found */
-  return (NULL);
+  return inq_db_index.Find(p_bda);
 }
 
 /*******************************************************************************
@@ -986,42 +1103,33 @@ tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
  * Function         btm_inq_db_new
  *
  * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ *                  unused entry. If no entry is free, it allocates the least
+ *                  recently used entry.
  *
  * Returns          pointer to entry
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_old = btm_cb.btm_inq_vars.inq_db;
-  uint64_t ot = UINT64_MAX;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (!p_ent->in_use) {
-      memset(p_ent, 0, sizeof(tINQ_DB_ENT));
-      p_ent->inq_info.results.remote_bd_addr = p_bda;
-      p_ent->in_use = true;
+  tINQ_DB_ENT* p_ent = inq_db_index.Reuse(p_bda);
 
-      return (p_ent);
-    }
-
-    if (p_ent->time_of_resp < ot) {
-      p_old = p_ent;
-      ot = p_ent->time_of_resp;
-    }
-  }
-
-  /* If here, no free entry found. Return the oldest. */
+  memset(p_ent, 0, sizeof(tINQ_DB_ENT));
+  p_ent->inq_info.results.remote_bd_addr = p_bda;
+  p_ent->in_use = true;
 
-  memset(p_old, 0, sizeof(tINQ_DB_ENT));
-  p_old->inq_info.results.remote_bd_addr = p_bda;
-  p_old->in_use = true;
-
-  return (p_old);
+  return (p_ent);
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_release
+ *
+ * Description      This function marks an entry of the inquiry database unused.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_release(tINQ_DB_ENT* p_ent) { inq_db_index.Release(p_ent); }
+
 /*******************************************************************************
  *
  * Function         btm_process_inq_results
@@ -1245,6 +1353,7 @@ void btm_sort_inq_result(void) {
   }
 
   osi_free(p_tmp);
+  inq_db_index.Rebuild();
 }
 
 /*******************************************************************************
@@ -1368,6 +1477,21 @@ tBTM_STATUS btm_initiate_rem_name(const RawAddress& remote_bda, uint8_t origin,
       alarm_set_on_mloop(p_inq->remote_name_timer, timeout_ms,
                          btm_inq_remote_name_timer_timeout, NULL);
 
+      /* A name read recently is reported without paging the device, from the
+       * main thread like a name read over the air */
+      BD_NAME name;
+      uint16_t length;
+      if (btm_rmt_cache_get_name(remote_bda, name, &length)) {
+        VLOG(1) << __func__ << ": name of " << remote_bda << " from cache";
+        rmt_name_from_cache = true;
+        p_inq->remname_active = true;
+        do_in_main_thread(
+            FROM_HERE,
+            base::Bind(&btm_inq_rmt_name_from_cache, remote_bda,
+                       std::string(reinterpret_cast<char*>(name), length)));
+        return BTM_CMD_STARTED;
+      }
+
       /* If the database entry exists for the device, use its clock offset */
       tINQ_DB_ENT* p_i = btm_inq_db_find(remote_bda);
       if (p_i && (p_i->inq_info.results.inq_result_type & BTM_INQ_RESULT_BR)) {
@@ -1390,6 +1514,24 @@ tBTM_STATUS btm_initiate_rem_name(const RawAddress& remote_bda, uint8_t origin,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_inq_rmt_name_from_cache
+ *
+ * Description      This function completes a remote name request answered
+ *                  from the cache.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_inq_rmt_name_from_cache(const RawAddress& bd_addr,
+                                        const std::string& name) {
+  BD_NAME bd_name;
+  memcpy(bd_name, name.data(), name.size());
+  btm_process_remote_name(&bd_addr, bd_name, name.size(), HCI_SUCCESS);
+  rmt_name_from_cache = false;
+}
+
 /*******************************************************************************
  *
  * Function         btm_process_remote_name
@@ -1416,6 +1558,10 @@ void btm_process_remote_name(const RawAddress* bda, BD_NAME bdn,
 
   VLOG(2) << "Inquire BDA " << p_inq->remname_bda;
 
+  if (bda && hci_status == HCI_SUCCESS && !rmt_name_from_cache) {
+    btm_rmt_cache_set_name(*bda, bdn, evt_len);
+  }
+
   /* If the inquire BDA and remote DBA are the same, then stop the timer and set
    * the active to false */
   if ((p_inq->remname_active) && (!bda || (*bda == p_inq->remname_bda))) {
@@ -28,6 +28,7 @@
 #include "osi/include/list.h"
 #include "stack/acl/acl.h"
 #include "stack/btm/btm_ble_int_types.h"
+#include "stack/btm/btm_dev_index.h"
 #include "stack/btm/btm_sco.h"
 #include "stack/btm/neighbor_inquiry.h"
 #include "stack/btm/security_device_record.h"
@@ -277,6 +278,7 @@ typedef struct tBTM_CB {
   uint8_t disc_reason{0};           /* for legacy devices */
   tBTM_SEC_SERV_REC sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
   list_t* sec_dev_rec{nullptr}; /* list of tBTM_SEC_DEV_REC */
+  SecDevRecIndex sec_dev_rec_index; /* indexes of sec_dev_rec */
   tBTM_SEC_SERV_REC* p_out_serv{nullptr};
   tBTM_MKEY_CALLBACK* mkey_cback{nullptr};
 
@@ -363,6 +365,7 @@ typedef struct tBTM_CB {
     fixed_queue_free(sec_pending_q, nullptr);
     sec_pending_q = nullptr;
 
+    sec_dev_rec_index.Clear();
     list_free(sec_dev_rec);
     sec_dev_rec = nullptr;
 
@@ -138,6 +138,10 @@ void IsoManager::Stop() {
     pimpl_->Stop();
 }
 
+void IsoManager::Dump(int fd) {
+  if (pimpl_->IsRunning()) pimpl_->iso_impl_->dump(fd);
+}
+
 IsoManager::~IsoManager() = default;
 
 }  // namespace hci
@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -43,11 +48,38 @@ static constexpr uint8_t kStateFlagIsConnected = 0x01;
 static constexpr uint8_t kStateFlagHasDataPathSet = 0x02;
 static constexpr uint8_t kStateFlagIsBroadcast = 0x04;
 
+/* SDU send to completion latency histogram, log2 buckets of 500 us */
+static constexpr uint32_t kIsoTxLatencyUnitUs = 500;
+static constexpr size_t kIsoTxLatencyBuckets = 8;
+
 struct iso_sync_info {
   uint32_t first_sync_ts;
   uint16_t seq_nb;
 };
 
+struct iso_sdu_in_flight {
+  uint64_t sent_us;
+  uint16_t seq_nb;
+  /* ISO data packets of the SDU not completed yet */
+  uint16_t num_packets;
+};
+
+/* SDUs sent to the controller, each one is given the next SDU interval */
+struct iso_tx_info {
+  bool started;
+  uint16_t seq_nb;
+  uint64_t sdus_sent;
+  /* SDUs which came after the interval they should have been sent in */
+  uint64_t sdus_late;
+  /* SDU intervals left without any SDU */
+  uint64_t intervals_missed;
+  uint64_t sdus_dropped;
+  /* Sent SDUs, oldest first, until the controller completes their packets */
+  std::deque<iso_sdu_in_flight> in_flight;
+  uint64_t latency_hist[kIsoTxLatencyBuckets];
+  uint32_t latency_max_us;
+};
+
 struct iso_base {
   union {
     uint8_t cig_id;
@@ -57,6 +89,9 @@ struct iso_base {
   struct iso_sync_info sync_info;
   uint8_t state_flags;
   uint32_t sdu_itv;
+  /* CIS or BIG sync delay reported by the controller */
+  uint32_t sync_delay;
+  struct iso_tx_info tx_info;
 };
 
 typedef iso_base iso_cis;
@@ -377,6 +412,41 @@ struct iso_impl {
     bte_main_hci_send(packet, MSG_STACK_TO_HC_HCI_ISO | 0x0001);
   }
 
+  /* Number of controller buffers taken by an SDU with a timestamp, which the
+   * packet fragmenter splits in ISO data packets of iso_buffer_size_ bytes.
+   */
+  uint16_t num_iso_packets(uint16_t data_len) {
+    uint32_t iso_data_load_len = data_len + 8;
+    return (iso_data_load_len + iso_buffer_size_ - 1) / iso_buffer_size_;
+  }
+
+  /* Gives the SDU the next SDU interval, or the current one when the previous
+   * SDUs are behind, so that each interval gets one SDU and its sequence
+   * number. Counts the late SDUs and the intervals left without any SDU.
+   */
+  uint16_t schedule_sdu(iso_base* iso, uint32_t now) {
+    uint16_t current_seq_nb =
+        (now - iso->sync_info.first_sync_ts) / iso->sdu_itv;
+    iso_tx_info& tx = iso->tx_info;
+
+    if (!tx.started) {
+      tx.started = true;
+      tx.seq_nb = current_seq_nb;
+      return tx.seq_nb;
+    }
+
+    uint16_t next_seq_nb = tx.seq_nb + 1;
+    /* Differences in modulo 2^16, as the sequence numbers wrap around */
+    int16_t behind = current_seq_nb - next_seq_nb;
+    if (behind > 0) {
+      tx.sdus_late++;
+      tx.intervals_missed += behind;
+      next_seq_nb = current_seq_nb;
+    }
+    tx.seq_nb = next_seq_nb;
+    return tx.seq_nb;
+  }
+
   void send_iso_data(uint16_t iso_handle, const uint8_t* data,
                      uint16_t data_len) {
     iso_base* iso = GetIsoIfKnown(iso_handle);
@@ -390,23 +460,31 @@ struct iso_impl {
     LOG_ASSERT(iso->state_flags & kStateFlagHasDataPathSet)
         << "Data path not set for handle: " << +iso_handle;
 
-    /* Calculate sequence number for the ISO data packet.
-     * It should be incremented by 1 every SDU Interval.
-     */
-    uint32_t ts = bluetooth::common::time_get_os_boottime_us();
-    iso->sync_info.seq_nb = (ts - iso->sync_info.first_sync_ts) / iso->sdu_itv;
-
-    if (iso_credits_ == 0 || data_len > iso_buffer_size_) {
+    uint16_t num_packets = num_iso_packets(data_len);
+    if (iso_credits_ < num_packets) {
+      iso->tx_info.sdus_dropped++;
       LOG(WARNING) << __func__ << ", dropping ISO packet, len: "
                    << static_cast<int>(data_len)
                    << ", iso credits: " << static_cast<int>(iso_credits_);
       return;
     }
 
-    iso_credits_--;
+    iso_credits_ -= num_packets;
 
-    BT_HDR* packet =
-        prepare_ts_hci_packet(iso_handle, ts, iso->sync_info.seq_nb, data_len);
+    /* The sequence number is incremented by 1 every SDU Interval, and the
+     * timestamp is the synchronization reference of that interval, rather than
+     * the time the SDU happened to be sent at.
+     */
+    uint64_t now = bluetooth::common::time_get_os_boottime_us();
+    uint16_t seq_nb = schedule_sdu(iso, now);
+    iso->sync_info.seq_nb = seq_nb;
+    uint32_t ts = iso->sync_info.first_sync_ts + iso->sync_delay +
+                  static_cast<uint32_t>(seq_nb) * iso->sdu_itv;
+    iso->tx_info.sdus_sent++;
+    iso->tx_info.in_flight.push_back(
+        {.sent_us = now, .seq_nb = seq_nb, .num_packets = num_packets});
+
+    BT_HDR* packet = prepare_ts_hci_packet(iso_handle, ts, seq_nb, data_len);
     memcpy(packet->data + kIsoDataInTsBtHdrOffset, data, data_len);
     send_iso_data_hci_packet(packet);
   }
@@ -424,9 +502,12 @@ struct iso_impl {
     LOG_ASSERT(cis != nullptr) << "No such cis";
 
     cis->sync_info.first_sync_ts = bluetooth::common::time_get_os_boottime_us();
+    cis->tx_info.started = false;
+    cis->tx_info.in_flight.clear();
 
     STREAM_TO_UINT24(evt.cig_sync_delay, data);
     STREAM_TO_UINT24(evt.cis_sync_delay, data);
+    cis->sync_delay = evt.cis_sync_delay;
     STREAM_TO_UINT24(evt.trans_lat_mtos, data);
     STREAM_TO_UINT24(evt.trans_lat_stom, data);
     STREAM_TO_UINT8(evt.phy_mtos, data);
@@ -463,6 +544,8 @@ struct iso_impl {
 
       cig_callbacks_->OnCisEvent(kIsoEventCisDisconnected, &evt);
       cis->state_flags &= ~kStateFlagIsConnected;
+      /* The controller drops the packets it has not sent yet */
+      cis->tx_info.in_flight.clear();
       /* Data path is considered still valid, but can be reconfigured only once
        * CIS is reestablished.
        */
@@ -482,11 +565,61 @@ struct iso_impl {
       STREAM_TO_UINT16(handle, p);
       STREAM_TO_UINT16(num_sent, p);
 
-      if ((conn_hdl_to_cis_map_.find(handle) == conn_hdl_to_cis_map_.end()) &&
-          (conn_hdl_to_bis_map_.find(handle) == conn_hdl_to_bis_map_.end()))
-        continue;
+      iso_base* iso = GetIsoIfKnown(handle);
+      if (iso == nullptr) continue;
 
       iso_credits_ += num_sent;
+      complete_sdus(handle, iso, num_sent);
+    }
+  }
+
+  /* Log2 histogram bucket, the first one holds latencies below one unit */
+  static size_t tx_latency_bucket(uint32_t latency_us) {
+    uint32_t units = latency_us / kIsoTxLatencyUnitUs;
+    size_t bucket = 0;
+    while (units != 0 && bucket < kIsoTxLatencyBuckets - 1) {
+      units >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  /* Completed packets are the oldest ones of the handle, so they complete the
+   * SDUs in the order they were sent. Each SDU with all its packets completed
+   * is reported, which lets the source send the next one right away instead
+   * of queueing ahead of the controller.
+   */
+  void complete_sdus(uint16_t handle, iso_base* iso, uint16_t num_sent) {
+    iso_tx_info& tx = iso->tx_info;
+    uint64_t now = bluetooth::common::time_get_os_boottime_us();
+
+    while (num_sent != 0 && !tx.in_flight.empty()) {
+      iso_sdu_in_flight& sdu = tx.in_flight.front();
+      uint16_t completed = std::min(num_sent, sdu.num_packets);
+      sdu.num_packets -= completed;
+      num_sent -= completed;
+      if (sdu.num_packets != 0) break;
+
+      uint32_t latency_us = now - sdu.sent_us;
+      tx.latency_hist[tx_latency_bucket(latency_us)]++;
+      tx.latency_max_us = std::max(tx.latency_max_us, latency_us);
+
+      iso_sdu_sent_evt evt;
+      evt.conn_hdl = handle;
+      evt.seq_nb = sdu.seq_nb;
+      evt.latency_us = latency_us;
+      tx.in_flight.pop_front();
+      evt.sdus_in_flight = tx.in_flight.size();
+
+      if (iso->state_flags & kStateFlagIsBroadcast) {
+        evt.big_id = iso->big_handle;
+        if (big_callbacks_ != nullptr)
+          big_callbacks_->OnBigEvent(kIsoEventBigSduSent, &evt);
+      } else {
+        evt.cig_id = iso->cig_id;
+        if (cig_callbacks_ != nullptr)
+          cig_callbacks_->OnCisEvent(kIsoEventCisSduSent, &evt);
+      }
     }
   }
 
@@ -527,7 +660,8 @@ struct iso_impl {
             new iso_bis({.sync_info = {.first_sync_ts = ts, .seq_nb = 0},
                          .big_handle = evt.big_id,
                          .state_flags = kStateFlagIsBroadcast,
-                         .sdu_itv = last_big_create_req_sdu_itv_}));
+                         .sdu_itv = last_big_create_req_sdu_itv_,
+                         .sync_delay = evt.big_sync_delay}));
       }
     }
 
@@ -655,6 +789,35 @@ struct iso_impl {
     cig_callbacks_->OnCisEvent(kIsoEventCisDataAvailable, &evt);
   }
 
+  void dump_iso(int fd, uint16_t handle, const iso_base* iso) {
+    const iso_tx_info& tx = iso->tx_info;
+    dprintf(fd,
+            "    handle: 0x%04x, sdu interval: %u us, sync delay: %u us, "
+            "sdus sent: %" PRIu64 ", late: %" PRIu64
+            ", intervals missed: %" PRIu64 ", dropped: %" PRIu64 "\n",
+            handle, iso->sdu_itv, iso->sync_delay, tx.sdus_sent, tx.sdus_late,
+            tx.intervals_missed, tx.sdus_dropped);
+    dprintf(fd, "      in flight: %zu, max latency: %u us, latency histogram:",
+            tx.in_flight.size(), tx.latency_max_us);
+    for (size_t i = 0; i < kIsoTxLatencyBuckets; i++) {
+      dprintf(fd, " %" PRIu64, tx.latency_hist[i]);
+    }
+    dprintf(fd, " (log2 buckets of %u us)\n", kIsoTxLatencyUnitUs);
+  }
+
+  void dump(int fd) {
+    dprintf(fd, "  ----------------\n");
+    dprintf(fd, "  ISO Manager:\n");
+    dprintf(fd, "    iso credits: %u, iso buffer size: %u\n", iso_credits_,
+            iso_buffer_size_);
+    for (auto const& cis : conn_hdl_to_cis_map_) {
+      dump_iso(fd, cis.first, cis.second.get());
+    }
+    for (auto const& bis : conn_hdl_to_bis_map_) {
+      dump_iso(fd, bis.first, bis.second.get());
+    }
+  }
+
   iso_cis* GetCisIfKnown(uint16_t cis_conn_handle) {
     auto cis_it = conn_hdl_to_cis_map_.find(cis_conn_handle);
     return (cis_it != conn_hdl_to_cis_map_.end()) ? cis_it->second.get()
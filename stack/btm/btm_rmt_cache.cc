@@ -0,0 +1,147 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  The name is kept in the same key btif stores the name of the device in,
+ *  the version in the keys of the remote version property, with the time
+ *  they were read at in seconds since the epoch. The features are kept as
+ *  the pages, BD_FEATURES_LEN bytes each, starting from page 0.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_rmt_cache.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <string>
+
+#include "bt_target.h"
+#include "btif_config.h"
+
+namespace {
+
+/* Returns true if the time saved under |key| is less than |ttl_s| ago */
+bool is_fresh(const std::string& section, const std::string& key,
+              uint64_t ttl_s) {
+  uint64_t saved_s;
+  if (!btif_config_get_uint64(section, key, &saved_s)) return false;
+
+  /* A clock set back makes it unknown how old it is */
+  uint64_t now_s = static_cast<uint64_t>(time(nullptr));
+  return saved_s <= now_s && now_s - saved_s < ttl_s;
+}
+
+void set_now(const std::string& section, const std::string& key) {
+  btif_config_set_uint64(section, key, static_cast<uint64_t>(time(nullptr)));
+}
+
+}  // namespace
+
+bool btm_rmt_cache_get_name(const RawAddress& bd_addr, BD_NAME name,
+                            uint16_t* p_length) {
+  std::string section = bd_addr.ToString();
+  if (!is_fresh(section, BT_CONFIG_KEY_RMT_NAME_TIME,
+                BTM_RMT_NAME_CACHE_TTL_S)) {
+    return false;
+  }
+
+  int size = BD_NAME_LEN + 1;
+  if (!btif_config_get_str(section, BT_CONFIG_KEY_RMT_NAME,
+                           reinterpret_cast<char*>(name), &size)) {
+    return false;
+  }
+  name[BD_NAME_LEN] = 0;
+  *p_length = strlen(reinterpret_cast<char*>(name));
+  return true;
+}
+
+void btm_rmt_cache_set_name(const RawAddress& bd_addr, const uint8_t* name,
+                            uint16_t length) {
+  if (length > BD_NAME_LEN) length = BD_NAME_LEN;
+  std::string value(reinterpret_cast<const char*>(name),
+                    strnlen(reinterpret_cast<const char*>(name), length));
+
+  std::string section = bd_addr.ToString();
+  btif_config_set_str(section, BT_CONFIG_KEY_RMT_NAME, value);
+  set_now(section, BT_CONFIG_KEY_RMT_NAME_TIME);
+}
+
+bool btm_rmt_cache_get_info(const RawAddress& bd_addr,
+                            tREMOTE_VERSION_INFO* p_version,
+                            BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1],
+                            uint8_t* p_max_page) {
+  std::string section = bd_addr.ToString();
+  if (!is_fresh(section, BT_CONFIG_KEY_RMT_INFO_TIME,
+                BTM_RMT_INFO_CACHE_TTL_S)) {
+    return false;
+  }
+
+  int lmp_version, manufacturer, lmp_subversion;
+  if (!btif_config_get_int(section, BT_CONFIG_KEY_REMOTE_VER_VER,
+                           &lmp_version) ||
+      !btif_config_get_int(section, BT_CONFIG_KEY_REMOTE_VER_MFCT,
+                           &manufacturer) ||
+      !btif_config_get_int(section, BT_CONFIG_KEY_REMOTE_VER_SUBVER,
+                           &lmp_subversion)) {
+    return false;
+  }
+
+  uint8_t features[(HCI_EXT_FEATURES_PAGE_MAX + 1) * BD_FEATURES_LEN];
+  size_t length =
+      btif_config_get_bin_length(section, BT_CONFIG_KEY_RMT_FEATURES);
+  if (length == 0 || length % BD_FEATURES_LEN != 0 ||
+      length > sizeof(features) ||
+      !btif_config_get_bin(section, BT_CONFIG_KEY_RMT_FEATURES, features,
+                           &length)) {
+    return false;
+  }
+
+  p_version->lmp_version = static_cast<uint8_t>(lmp_version);
+  p_version->manufacturer = static_cast<uint16_t>(manufacturer);
+  p_version->lmp_subversion = static_cast<uint16_t>(lmp_subversion);
+  p_version->valid = true;
+  *p_max_page = length / BD_FEATURES_LEN - 1;
+  for (uint8_t page = 0; page <= *p_max_page; page++) {
+    memcpy(pages[page], &features[page * BD_FEATURES_LEN], BD_FEATURES_LEN);
+  }
+  return true;
+}
+
+void btm_rmt_cache_set_info(
+    const RawAddress& bd_addr, const tREMOTE_VERSION_INFO& version,
+    const BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1], uint8_t max_page) {
+  if (!version.valid || max_page > HCI_EXT_FEATURES_PAGE_MAX) return;
+
+  uint8_t features[(HCI_EXT_FEATURES_PAGE_MAX + 1) * BD_FEATURES_LEN];
+  for (uint8_t page = 0; page <= max_page; page++) {
+    memcpy(&features[page * BD_FEATURES_LEN], pages[page], BD_FEATURES_LEN);
+  }
+
+  std::string section = bd_addr.ToString();
+  btif_config_set_int(section, BT_CONFIG_KEY_REMOTE_VER_VER,
+                      version.lmp_version);
+  btif_config_set_int(section, BT_CONFIG_KEY_REMOTE_VER_MFCT,
+                      version.manufacturer);
+  btif_config_set_int(section, BT_CONFIG_KEY_REMOTE_VER_SUBVER,
+                      version.lmp_subversion);
+  btif_config_set_bin(section, BT_CONFIG_KEY_RMT_FEATURES, features,
+                      (max_page + 1) * BD_FEATURES_LEN);
+  set_now(section, BT_CONFIG_KEY_RMT_INFO_TIME);
+}
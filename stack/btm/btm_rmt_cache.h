@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the cache of the remote name, LMP version and LMP
+ *  features of peer devices. They are kept in the config of the device, and
+ *  used instead of reading them over the air until they are older than
+ *  BTM_RMT_NAME_CACHE_TTL_S and BTM_RMT_INFO_CACHE_TTL_S.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include "stack/include/bt_types.h"
+#include "stack/include/btm_api_types.h"
+#include "stack/include/hcidefs.h"
+#include "types/raw_address.h"
+
+/* Returns true and the name of |bd_addr| read less than
+ * BTM_RMT_NAME_CACHE_TTL_S ago, false if there is none */
+bool btm_rmt_cache_get_name(const RawAddress& bd_addr, BD_NAME name,
+                            uint16_t* p_length);
+
+/* Saves the name of |bd_addr| read with a remote name request */
+void btm_rmt_cache_set_name(const RawAddress& bd_addr, const uint8_t* name,
+                            uint16_t length);
+
+/* Returns true, the LMP version and the LMP features pages 0 to |*p_max_page|
+ * of |bd_addr| read less than BTM_RMT_INFO_CACHE_TTL_S ago, false if there
+ * are none */
+bool btm_rmt_cache_get_info(
+    const RawAddress& bd_addr, tREMOTE_VERSION_INFO* p_version,
+    BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1], uint8_t* p_max_page);
+
+/* Saves the LMP version and the LMP features pages 0 to |max_page| of
+ * |bd_addr| read on connection */
+void btm_rmt_cache_set_info(
+    const RawAddress& bd_addr, const tREMOTE_VERSION_INFO& version,
+    const BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1], uint8_t max_page);
@@ -97,7 +97,44 @@ static uint16_t btm_sco_voice_settings_to_legacy(enh_esco_params_t* p_parms);
  * Returns          void
  *
  ******************************************************************************/
-static void btm_sco_flush_sco_data(UNUSED_ATTR uint16_t sco_inx) {}
+static void btm_sco_flush_sco_data(uint16_t sco_inx) {
+  tSCO_CONN* p = btm_cb.sco_cb.get_sco_connection_from_index(sco_inx);
+  if (p == nullptr) return;
+  bluetooth::audio::sco::close(p->hci_handle);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sco_set_data_path
+ *
+ * Description      This function sets the saved SCO routing in the enhanced
+ *                  parameters. mSBC links routed over HCI are transparent to
+ *                  the controller, the host encodes and decodes the frames.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_sco_set_data_path(enh_esco_params_t* p_setup) {
+  p_setup->input_data_path = p_setup->output_data_path =
+      btm_cb.sco_cb.sco_route;
+  if (btm_cb.sco_cb.sco_route != ESCO_DATA_PATH_HCI ||
+      p_setup->transmit_coding_format.coding_format !=
+          ESCO_CODING_FORMAT_MSBC) {
+    return;
+  }
+  p_setup->transmit_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->receive_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->output_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_bandwidth = TXRX_64KBITS_RATE;
+  p_setup->output_bandwidth = TXRX_64KBITS_RATE;
+  p_setup->input_coded_data_size = 8;
+  p_setup->output_coded_data_size = 8;
+  p_setup->input_pcm_data_format = ESCO_PCM_DATA_FORMAT_NA;
+  p_setup->output_pcm_data_format = ESCO_PCM_DATA_FORMAT_NA;
+  p_setup->input_pcm_payload_msb_position = 0;
+  p_setup->output_pcm_payload_msb_position = 0;
+}
 
 /*******************************************************************************
  *
@@ -151,8 +188,7 @@ static void btm_esco_conn_rsp(uint16_t sco_inx, uint8_t hci_status,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection()) {
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
 
       BTM_TRACE_DEBUG(
           "%s: txbw 0x%x, rxbw 0x%x, lat 0x%x, retrans 0x%02x, "
@@ -283,8 +319,7 @@ static tBTM_STATUS btm_send_connect_request(uint16_t acl_handle,
       LOG_INFO("Sending enhanced SCO connect request over handle:0x%04x",
                acl_handle);
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
       LOG(INFO) << __func__ << std::hex << ": enhanced parameter list"
                 << " txbw=0x" << unsigned(p_setup->transmit_bandwidth)
                 << ", rxbw=0x" << unsigned(p_setup->receive_bandwidth)
@@ -749,6 +784,11 @@ void btm_sco_connected(tHCI_STATUS hci_status, const RawAddress& bda,
         BTM_LogHistory(kBtmLogTag, bda, "Connection success",
                        base::StringPrintf("handle:0x%04x %s", hci_handle,
                                           (spt) ? "listener" : "initiator"));
+        if (btm_cb.sco_cb.sco_route == ESCO_DATA_PATH_HCI) {
+          bluetooth::audio::sco::open(
+              hci_handle, p->esco.setup.input_coding_format.coding_format ==
+                              ESCO_CODING_FORMAT_TRANSPNT);
+        }
       } else {
         BTM_LogHistory(
             kBtmLogTag, bda, "Connection failed",
@@ -911,6 +951,7 @@ void btm_sco_on_disconnected(uint16_t hci_handle, tHCI_REASON reason) {
 
   const RawAddress bd_addr(p_sco->esco.data.bd_addr);
 
+  btm_sco_flush_sco_data(btm_cb.sco_cb.get_index(p_sco));
   p_sco->state = SCO_ST_UNUSED;
   p_sco->hci_handle = HCI_INVALID_HANDLE;
   p_sco->rem_bd_known = false;
@@ -1126,8 +1167,7 @@ tBTM_STATUS BTM_ChangeEScoLinkParms(uint16_t sco_inx,
     if (controller_get_interface()
             ->supports_enhanced_setup_synchronous_connection()) {
       /* Use the saved SCO routing */
-      p_setup->input_data_path = p_setup->output_data_path =
-          btm_cb.sco_cb.sco_route;
+      btm_sco_set_data_path(p_setup);
 
       btsnd_hcic_enhanced_set_up_synchronous_connection(p_sco->hci_handle,
                                                         p_setup);
@@ -20,8 +20,29 @@
 #include <string>
 
 #include "device/include/esco_parameters.h"
+#include "stack/include/bt_types.h"
 #include "stack/include/btm_api_types.h"
 
+namespace bluetooth {
+namespace audio {
+namespace sco {
+
+/* Software data path of the SCO links routed over HCI, btm_sco_hci.cc */
+bool is_software_path_enabled();
+
+/* Routes the data of |handle| through the software path. Main thread. */
+void open(uint16_t handle, bool is_wbs);
+
+/* Stops routing the data of |handle|. Main thread. */
+void close(uint16_t handle);
+
+/* Takes |p_msg| if it belongs to the routed link. HCI thread. */
+bool enqueue_packet(BT_HDR* p_msg);
+
+}  // namespace sco
+}  // namespace audio
+}  // namespace bluetooth
+
 constexpr uint16_t kMaxScoLinks = static_cast<uint16_t>(BTM_MAX_SCO_LINKS);
 
 /* Define the structures needed by sco
@@ -114,7 +135,9 @@ typedef struct {
 
   void Init() {
     def_esco_parms = esco_parameters_for_codec(ESCO_CODEC_CVSD_S3);
-    sco_route = ESCO_DATA_PATH_PCM;
+    sco_route = bluetooth::audio::sco::is_software_path_enabled()
+                    ? ESCO_DATA_PATH_HCI
+                    : ESCO_DATA_PATH_PCM;
   }
 
   uint16_t get_index(const tSCO_CONN* p_sco) const {
@@ -0,0 +1,486 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Software data path of the SCO links routed over HCI: the synchronous data
+ *  packets are decoded on a real time thread, with packet loss concealment of
+ *  the mSBC frames, and exchanged with the audio client through two shared
+ *  memory rings.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btm_sco_hci"
+
+#include <base/bind.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cinttypes>
+
+#include "common/message_loop_thread.h"
+#include "common/repeating_timer.h"
+#include "embdrv/sbc/decoder/include/oi_codec_sbc.h"
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/properties.h"
+#include "osi/include/socket_utils/sockets.h"
+#include "stack/btm/btm_sco.h"
+#include "stack/btm/btm_sco_plc.h"
+#include "stack/include/hcidefs.h"
+#include "stack/include/hcimsgs.h"
+#include "udrv/include/uipc_shm.h"
+
+using bluetooth::common::MessageLoopThread;
+using bluetooth::common::RepeatingTimer;
+
+namespace {
+
+constexpr char kSoftwareDataPathProperty[] =
+    "persist.bluetooth.sco.software_datapath";
+/* Socket the audio client connects to, to get the speaker and mic rings */
+constexpr char kAudioSocketPath[] = "/data/misc/bluedroid/.sco_audio";
+constexpr uint32_t kAudioRingSize = 4096;
+
+/* Received packets waiting for the SCO thread, filled by the HCI thread */
+constexpr size_t kRxQueueCapacity = 16;
+/* Half of the 7.5 ms eSCO interval of the mSBC links */
+constexpr int64_t kTickIntervalUs = 3750;
+
+constexpr uint16_t kInvalidHandle = 0xFFFF;
+constexpr size_t kMaxScoPacketLen = 255;
+/* Packet_Status_Flag of the received synchronous data packets */
+constexpr uint8_t kPacketStatusShift = 12;
+constexpr uint16_t kPacketStatusMask = 0x3;
+
+/* mSBC frames are sent with a H2 synchronization header, the first octet of
+ * which is constant and the second one a sequence number, and one octet of
+ * padding, to fill the 60 octet packets of the T2 settings */
+constexpr uint8_t kH2Sync = 0x01;
+constexpr uint8_t kH2Sequence[] = {0x08, 0x38, 0xc8, 0xf8};
+constexpr size_t kH2HeaderLen = 2;
+constexpr size_t kMsbcPacketLen = kH2HeaderLen + SBC_MSBC_FRAME_LEN + 1;
+
+struct ScoStats {
+  uint64_t rx_packets;
+  uint64_t decoded_frames;
+  uint64_t concealed_frames;
+  uint64_t speaker_overruns;
+  uint64_t mic_underruns;
+};
+
+/* Set and cleared on the main thread, read by the HCI thread to tell which
+ * packets to route here */
+std::atomic<uint16_t> active_handle(kInvalidHandle);
+std::atomic<uint64_t> rx_queue_overruns(0);
+/* Created once, never freed as the HCI thread may still be using it */
+fixed_queue_t* rx_queue = nullptr;
+
+MessageLoopThread sco_thread("bt_sco_thread");
+RepeatingTimer tick_timer;
+
+/* Runs on the SCO thread */
+class ScoDataPath {
+ public:
+  void Start(uint16_t handle, bool is_wbs) {
+    handle_ = handle;
+    is_wbs_ = is_wbs;
+    memset(&stats_, 0, sizeof(stats_));
+    rx_len_ = 0;
+    rx_dropped_ = 0;
+    tx_len_ = 0;
+    tx_seq_ = 0;
+
+    if (is_wbs_) {
+      memset(&encoder_, 0, sizeof(encoder_));
+      encoder_.Format = SBC_FORMAT_MSBC;
+      SBC_Encoder_Init(&encoder_);
+      int16_t silence[ScoPlc::kFrameSamples] = {0};
+      SBC_Encode(&encoder_, silence, zero_frame_);
+      SBC_Encoder_Init(&encoder_);
+
+      OI_STATUS status = OI_CODEC_SBC_DecoderReset(
+          &decoder_, decoder_data_, sizeof(decoder_data_), 1, 1, false);
+      if (OI_SUCCESS(status)) {
+        status = OI_CODEC_SBC_DecoderConfigureMSbc(&decoder_);
+      }
+      if (!OI_SUCCESS(status)) {
+        LOG_ERROR("%s: unable to set up the mSBC decoder: %d", __func__,
+                  status);
+      }
+      plc_.Reset();
+    }
+
+    uipc_shm_reset(&speaker_);
+    uipc_shm_reset(&mic_);
+    client_fd_ = -1;
+    listen_fd_ = Listen();
+    LOG_INFO("%s: handle 0x%04x %s", __func__, handle_,
+             is_wbs_ ? "mSBC" : "CVSD");
+  }
+
+  void Stop() {
+    /* Late packets of the link */
+    BT_HDR* p_msg;
+    while ((p_msg = (BT_HDR*)fixed_queue_try_dequeue(rx_queue)) != nullptr) {
+      osi_free(p_msg);
+    }
+    CloseClient();
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+      listen_fd_ = -1;
+    }
+    LOG_INFO("%s: handle 0x%04x rx_packets=%" PRIu64 " decoded=%" PRIu64
+             " concealed=%" PRIu64 " speaker_overruns=%" PRIu64
+             " mic_underruns=%" PRIu64 " rx_queue_overruns=%" PRIu64,
+             __func__, handle_, stats_.rx_packets, stats_.decoded_frames,
+             stats_.concealed_frames, stats_.speaker_overruns,
+             stats_.mic_underruns, rx_queue_overruns.exchange(0));
+    handle_ = kInvalidHandle;
+  }
+
+  void Tick() {
+    ServiceClient();
+    BT_HDR* p_msg;
+    while ((p_msg = (BT_HDR*)fixed_queue_try_dequeue(rx_queue)) != nullptr) {
+      ProcessPacket(p_msg);
+      osi_free(p_msg);
+    }
+  }
+
+ private:
+  int Listen() {
+    int fd = socket(AF_LOCAL, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (osi_socket_local_server_bind(fd, kAudioSocketPath,
+#if defined(OS_GENERIC)
+                                     ANDROID_SOCKET_NAMESPACE_FILESYSTEM
+#else   // !defined(OS_GENERIC)
+                                     ANDROID_SOCKET_NAMESPACE_ABSTRACT
+#endif  // defined(OS_GENERIC)
+                                     ) < 0 ||
+        listen(fd, 1) < 0) {
+      LOG_ERROR("%s: unable to listen on %s: %s", __func__, kAudioSocketPath,
+                strerror(errno));
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  /* Accepts the audio client, or notices that it went away */
+  void ServiceClient() {
+    if (client_fd_ >= 0) {
+      struct pollfd pfd = {client_fd_, POLLRDHUP, 0};
+      int ret;
+      OSI_NO_INTR(ret = poll(&pfd, 1, 0));
+      if (ret != 0) {
+        LOG_INFO("%s: audio client disconnected", __func__);
+        CloseClient();
+      }
+      return;
+    }
+    if (listen_fd_ < 0) return;
+
+    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    /* Speaker ring first, then mic ring */
+    if (uipc_shm_create(&speaker_, kAudioRingSize) < 0 ||
+        uipc_shm_create(&mic_, kAudioRingSize) < 0 ||
+        uipc_shm_send_handshake(fd, &speaker_) < 0 ||
+        uipc_shm_send_handshake(fd, &mic_) < 0) {
+      LOG_ERROR("%s: unable to set up the audio rings", __func__);
+      uipc_shm_close(&speaker_);
+      uipc_shm_close(&mic_);
+      close(fd);
+      return;
+    }
+    client_fd_ = fd;
+    LOG_INFO("%s: audio client connected", __func__);
+  }
+
+  void CloseClient() {
+    uipc_shm_close(&speaker_);
+    uipc_shm_close(&mic_);
+    if (client_fd_ >= 0) {
+      close(client_fd_);
+      client_fd_ = -1;
+    }
+  }
+
+  /* Speaker samples are dropped when the client does not keep up, as they
+   * would be too late anyway */
+  void WriteSpeaker(const void* data, size_t len) {
+    if (client_fd_ < 0) return;
+    if (uipc_shm_writable(&speaker_) < len) {
+      stats_.speaker_overruns++;
+      return;
+    }
+    memcpy(uipc_shm_write_ptr(&speaker_), data, len);
+    uipc_shm_produce(&speaker_, len);
+  }
+
+  /* Silence is sent when the client has no mic samples ready */
+  void ReadMic(void* data, size_t len) {
+    if (client_fd_ >= 0 && uipc_shm_readable(&mic_) >= len) {
+      memcpy(data, uipc_shm_read_ptr(&mic_), len);
+      uipc_shm_consume(&mic_, len);
+      return;
+    }
+    if (client_fd_ >= 0) stats_.mic_underruns++;
+    memset(data, 0, len);
+  }
+
+  void ProcessPacket(BT_HDR* p_msg) {
+    if (p_msg->len < HCI_SCO_PREAMBLE_SIZE) return;
+    uint8_t* p = p_msg->data + p_msg->offset;
+    uint16_t handle;
+    uint8_t len;
+    STREAM_TO_UINT16(handle, p);
+    STREAM_TO_UINT8(len, p);
+    uint8_t status = (handle >> kPacketStatusShift) & kPacketStatusMask;
+    handle = HCID_GET_HANDLE(handle);
+    if (handle != handle_ || len > p_msg->len - HCI_SCO_PREAMBLE_SIZE) return;
+    stats_.rx_packets++;
+
+    if (is_wbs_) {
+      ReceiveWbs(p, len, status);
+    } else {
+      WriteSpeaker(p, len);
+    }
+
+    /* Sending a packet for each one received paces the transmission on the
+     * controller clock */
+    uint8_t tx[kMaxScoPacketLen];
+    if (is_wbs_) {
+      while (tx_len_ < len) EncodeWbsPacket();
+      memcpy(tx, tx_buf_, len);
+      tx_len_ -= len;
+      memmove(tx_buf_, &tx_buf_[len], tx_len_);
+    } else {
+      ReadMic(tx, len);
+    }
+    Send(tx, len);
+  }
+
+  void Send(const uint8_t* data, uint8_t len) {
+    BT_HDR* p_buf =
+        (BT_HDR*)osi_malloc(BT_HDR_SIZE + HCI_SCO_PREAMBLE_SIZE + len);
+    p_buf->offset = 0;
+    p_buf->len = HCI_SCO_PREAMBLE_SIZE + len;
+    p_buf->layer_specific = 0;
+    uint8_t* p = p_buf->data;
+    UINT16_TO_STREAM(p, handle_);
+    UINT8_TO_STREAM(p, len);
+    memcpy(p, data, len);
+    bte_main_hci_send(p_buf, BT_EVT_TO_LM_HCI_SCO | LOCAL_BR_EDR_CONTROLLER_ID);
+  }
+
+  void EncodeWbsPacket() {
+    int16_t pcm[ScoPlc::kFrameSamples];
+    ReadMic(pcm, sizeof(pcm));
+    uint8_t* p = &tx_buf_[tx_len_];
+    p[0] = kH2Sync;
+    p[1] = kH2Sequence[tx_seq_++ % sizeof(kH2Sequence)];
+    SBC_Encode(&encoder_, pcm, &p[kH2HeaderLen]);
+    p[kMsbcPacketLen - 1] = 0;
+    tx_len_ += kMsbcPacketLen;
+  }
+
+  /* mSBC packets do not have to line up with the synchronous data packets,
+   * the received octets are buffered until a whole one is found */
+  void ReceiveWbs(const uint8_t* data, size_t len, uint8_t status) {
+    if (rx_len_ + len > sizeof(rx_buf_)) {
+      DropWbs(rx_len_ + len - sizeof(rx_buf_));
+    }
+    memcpy(&rx_buf_[rx_len_], data, len);
+    memset(&rx_status_[rx_len_], status, len);
+    rx_len_ += len;
+
+    while (rx_len_ >= kMsbcPacketLen) {
+      size_t sync = FindH2Sync();
+      if (sync > 0) {
+        DropWbs(sync);
+        continue;
+      }
+      bool good = true;
+      for (size_t i = 0; i < kMsbcPacketLen; i++) good &= rx_status_[i] == 0;
+
+      int16_t pcm[ScoPlc::kFrameSamples];
+      if (good && DecodeWbsFrame(&rx_buf_[kH2HeaderLen], pcm)) {
+        plc_.GoodFrame(pcm, pcm);
+        WriteSpeaker(pcm, sizeof(pcm));
+        stats_.decoded_frames++;
+      } else {
+        ConcealWbsFrame();
+      }
+      rx_dropped_ = 0;
+      ConsumeWbs(kMsbcPacketLen);
+    }
+  }
+
+  /* Returns the offset of the first H2 header followed by an mSBC syncword,
+   * or of the octets that may still start one */
+  size_t FindH2Sync() const {
+    for (size_t i = 0; i + kH2HeaderLen < rx_len_; i++) {
+      if (rx_buf_[i] != kH2Sync || rx_buf_[i + 2] != SBC_MSBC_SYNC_WORD) {
+        continue;
+      }
+      for (uint8_t seq : kH2Sequence) {
+        if (rx_buf_[i + 1] == seq) return i;
+      }
+    }
+    return rx_len_ - kH2HeaderLen;
+  }
+
+  /* Octets out of sync, a frame is concealed for every packet worth */
+  void DropWbs(size_t len) {
+    ConsumeWbs(len);
+    rx_dropped_ += len;
+    while (rx_dropped_ >= kMsbcPacketLen) {
+      rx_dropped_ -= kMsbcPacketLen;
+      ConcealWbsFrame();
+    }
+  }
+
+  void ConsumeWbs(size_t len) {
+    rx_len_ -= len;
+    memmove(rx_buf_, &rx_buf_[len], rx_len_);
+    memmove(rx_status_, &rx_status_[len], rx_len_);
+  }
+
+  bool DecodeWbsFrame(const uint8_t* frame, int16_t* pcm) {
+    const OI_BYTE* data = frame;
+    uint32_t bytes = SBC_MSBC_FRAME_LEN;
+    uint32_t pcm_bytes = ScoPlc::kFrameSamples * sizeof(int16_t);
+    OI_STATUS status =
+        OI_CODEC_SBC_DecodeFrame(&decoder_, &data, &bytes, pcm, &pcm_bytes);
+    return OI_SUCCESS(status) &&
+           pcm_bytes == ScoPlc::kFrameSamples * sizeof(int16_t);
+  }
+
+  void ConcealWbsFrame() {
+    /* Decoding silence gives the zero input response of the decoder */
+    int16_t zir[ScoPlc::kFrameSamples];
+    if (!DecodeWbsFrame(zero_frame_, zir)) memset(zir, 0, sizeof(zir));
+    int16_t pcm[ScoPlc::kFrameSamples];
+    plc_.BadFrame(zir, pcm);
+    WriteSpeaker(pcm, sizeof(pcm));
+    stats_.concealed_frames++;
+  }
+
+  uint16_t handle_ = kInvalidHandle;
+  bool is_wbs_ = false;
+  ScoStats stats_;
+
+  int listen_fd_ = -1;
+  int client_fd_ = -1;
+  tUIPC_SHM speaker_;
+  tUIPC_SHM mic_;
+
+  SBC_ENC_PARAMS encoder_;
+  OI_CODEC_SBC_DECODER_CONTEXT decoder_;
+  uint32_t decoder_data_[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+  uint8_t zero_frame_[SBC_MSBC_FRAME_LEN];
+  ScoPlc plc_;
+
+  uint8_t rx_buf_[kMaxScoPacketLen + kMsbcPacketLen];
+  /* Packet_Status_Flag each octet was received with */
+  uint8_t rx_status_[kMaxScoPacketLen + kMsbcPacketLen];
+  size_t rx_len_ = 0;
+  size_t rx_dropped_ = 0;
+
+  uint8_t tx_buf_[kMaxScoPacketLen + kMsbcPacketLen];
+  size_t tx_len_ = 0;
+  uint8_t tx_seq_ = 0;
+};
+
+ScoDataPath data_path;
+
+void sco_tick() { data_path.Tick(); }
+
+}  // namespace
+
+namespace bluetooth {
+namespace audio {
+namespace sco {
+
+bool is_software_path_enabled() {
+  return osi_property_get_bool(kSoftwareDataPathProperty, false);
+}
+
+void open(uint16_t handle, bool is_wbs) {
+  if (active_handle.load() != kInvalidHandle) {
+    LOG_WARN("%s: handle 0x%04x already routed, not 0x%04x", __func__,
+             active_handle.load(), handle);
+    return;
+  }
+  if (rx_queue == nullptr) rx_queue = fixed_queue_new_spsc(kRxQueueCapacity);
+
+  sco_thread.StartUp();
+  if (!sco_thread.EnableRealTimeScheduling()) {
+    LOG_WARN("%s: unable to enable real time scheduling", __func__);
+  }
+  sco_thread.DoInThread(
+      FROM_HERE, base::BindOnce(&ScoDataPath::Start,
+                                base::Unretained(&data_path), handle, is_wbs));
+  tick_timer.SchedulePeriodic(
+      sco_thread.GetWeakPtr(), FROM_HERE, base::Bind(&sco_tick),
+      base::TimeDelta::FromMicroseconds(kTickIntervalUs));
+  active_handle.store(handle);
+}
+
+void close(uint16_t handle) {
+  if (handle == kInvalidHandle || active_handle.load() != handle) return;
+  active_handle.store(kInvalidHandle);
+  tick_timer.CancelAndWait();
+  sco_thread.DoInThread(
+      FROM_HERE,
+      base::BindOnce(&ScoDataPath::Stop, base::Unretained(&data_path)));
+  /* Runs the pending Stop() before joining */
+  sco_thread.ShutDown();
+}
+
+bool enqueue_packet(BT_HDR* p_msg) {
+  uint16_t active = active_handle.load(std::memory_order_acquire);
+  if (active == kInvalidHandle || p_msg->len < HCI_SCO_PREAMBLE_SIZE) {
+    return false;
+  }
+  uint8_t* p = p_msg->data + p_msg->offset;
+  uint16_t handle;
+  STREAM_TO_UINT16(handle, p);
+  if (HCID_GET_HANDLE(handle) != active) return false;
+
+  if (!fixed_queue_try_enqueue(rx_queue, p_msg)) {
+    rx_queue_overruns++;
+    osi_free(p_msg);
+  }
+  return true;
+}
+
+}  // namespace sco
+}  // namespace audio
+}  // namespace bluetooth
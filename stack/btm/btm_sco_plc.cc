@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/btm/btm_sco_plc.h"
+
+#include <string.h>
+#include <cmath>
+
+namespace {
+
+int16_t crop(float sample) {
+  if (sample > INT16_MAX) return INT16_MAX;
+  if (sample < INT16_MIN) return INT16_MIN;
+  return static_cast<int16_t>(sample);
+}
+
+}  // namespace
+
+ScoPlc::ScoPlc() {
+  /* Raised cosine, fading from 1 to 0 */
+  for (size_t i = 0; i < kOverlap; i++) {
+    fade_[i] = (1.0f + std::cos(M_PI * (i + 1) / (kOverlap + 1))) / 2.0f;
+  }
+  Reset();
+}
+
+void ScoPlc::Reset() {
+  memset(hist_, 0, sizeof(hist_));
+  best_lag_ = 0;
+  lost_frames_ = 0;
+}
+
+void ScoPlc::GoodFrame(const int16_t* in, int16_t* out) {
+  size_t i = 0;
+  if (lost_frames_ > 0) {
+    for (; i < kReconvergence; i++) out[i] = hist_[kHistory + i];
+    for (; i < kReconvergence + kOverlap; i++) {
+      size_t j = i - kReconvergence;
+      out[i] = crop(hist_[kHistory + i] * fade_[j] +
+                    in[i] * fade_[kOverlap - 1 - j]);
+    }
+  }
+  for (; i < kFrameSamples; i++) out[i] = in[i];
+  lost_frames_ = 0;
+
+  memcpy(&hist_[kHistory], out, kFrameSamples * sizeof(int16_t));
+  memmove(hist_, &hist_[kFrameSamples], kHistory * sizeof(int16_t));
+}
+
+void ScoPlc::BadFrame(const int16_t* zir, int16_t* out) {
+  constexpr size_t kSubstitute = kFrameSamples + kReconvergence + kOverlap;
+
+  lost_frames_++;
+  if (lost_frames_ == 1) {
+    best_lag_ = PatternMatch() + kTemplate;
+    float gain = AmplitudeMatch(best_lag_);
+    size_t i = 0;
+    for (; i < kOverlap; i++) {
+      hist_[kHistory + i] = crop(zir[i] * fade_[i] +
+                                 gain * hist_[best_lag_ + i] *
+                                     fade_[kOverlap - 1 - i]);
+    }
+    for (; i < kSubstitute; i++) {
+      hist_[kHistory + i] = crop(gain * hist_[best_lag_ + i]);
+    }
+  } else {
+    /* The history moved by a frame, the lag keeps repeating the same period */
+    float gain = 1.0f;
+    if (lost_frames_ > kMaxRepeatedFrames) {
+      gain = lost_frames_ > kMaxRepeatedFrames + 1 ? 0.0f : 0.5f;
+    }
+    for (size_t i = 0; i < kSubstitute; i++) {
+      hist_[kHistory + i] = crop(gain * hist_[best_lag_ + i]);
+    }
+  }
+
+  memcpy(out, &hist_[kHistory], kFrameSamples * sizeof(int16_t));
+  memmove(hist_, &hist_[kFrameSamples],
+          (kHistory + kReconvergence + kOverlap) * sizeof(int16_t));
+}
+
+size_t ScoPlc::PatternMatch() const {
+  const int16_t* tmpl = &hist_[kHistory - kTemplate];
+
+  /* Energy of the candidate segment, slid along the window */
+  int64_t energy = 0;
+  for (size_t m = 0; m < kTemplate; m++) {
+    energy += static_cast<int32_t>(hist_[m]) * hist_[m];
+  }
+
+  size_t best = 0;
+  double best_score = -INFINITY;
+  for (size_t n = 0; n < kWindow; n++) {
+    const int16_t* candidate = &hist_[n];
+    int64_t corr = 0;
+    for (size_t m = 0; m < kTemplate; m++) {
+      corr += static_cast<int32_t>(tmpl[m]) * candidate[m];
+    }
+    /* Normalized cross correlation, the template energy is common to all */
+    if (energy > 0) {
+      double score = corr / std::sqrt(static_cast<double>(energy));
+      if (score > best_score) {
+        best_score = score;
+        best = n;
+      }
+    }
+    int32_t entering = candidate[kTemplate];
+    int32_t leaving = candidate[0];
+    energy += entering * entering - leaving * leaving;
+  }
+  return best;
+}
+
+float ScoPlc::AmplitudeMatch(size_t lag) const {
+  float last = 0;
+  float substitute = 0.000001f;
+  for (size_t i = 0; i < kFrameSamples; i++) {
+    last += std::fabs(hist_[kHistory - kFrameSamples + i]);
+    substitute += std::fabs(hist_[lag + i]);
+  }
+  /* Bounded, not to turn noise into loud artifacts */
+  float gain = last / substitute;
+  if (gain < 0.75f) gain = 0.75f;
+  if (gain > 1.2f) gain = 1.2f;
+  return gain;
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Packet loss concealment of the mSBC frames of wide band speech, by waveform
+ * substitution as the HFP specification describes it.
+ *
+ * The last decoded samples are kept as history. When a frame is lost, the
+ * segment of the history that best matches its last samples is found, and the
+ * samples that followed that segment replace the lost frame, scaled to the
+ * amplitude of the previous frame. The substitute is faded in over the zero
+ * input response of the decoder, and the next good frame is faded in over the
+ * rest of the substitute once the decoder had time to converge again.
+ */
+class ScoPlc {
+ public:
+  /* Samples of an mSBC frame */
+  static constexpr size_t kFrameSamples = 120;
+
+  ScoPlc();
+
+  void Reset();
+
+  /* Copies the decoded frame |in| to |out|, fading out of a concealment if the
+   * previous frame was lost. |in| and |out| may be the same. */
+  void GoodFrame(const int16_t* in, int16_t* out);
+
+  /* Writes a substitute for a lost frame to |out|. |zir| is the output of the
+   * decoder for a frame of silence, which continues its previous output. */
+  void BadFrame(const int16_t* zir, int16_t* out);
+
+  /* Number of frames lost in a row */
+  size_t lost_frames() const { return lost_frames_; }
+
+ private:
+  /* Length of the history searched for a match, of the template matched, of
+   * the decoder reconvergence and of the overlap-adds, in samples */
+  static constexpr size_t kWindow = 256;
+  static constexpr size_t kTemplate = 64;
+  static constexpr size_t kReconvergence = 36;
+  static constexpr size_t kOverlap = 16;
+  static constexpr size_t kHistory = kWindow + kFrameSamples - 1;
+  /* Substitutes past this many lost frames fade out to silence */
+  static constexpr size_t kMaxRepeatedFrames = 4;
+
+  /* Returns the start of the history segment best matching its end */
+  size_t PatternMatch() const;
+  /* Returns the gain bringing the substitute starting at |lag| to the
+   * amplitude of the last frame */
+  float AmplitudeMatch(size_t lag) const;
+
+  /* History, followed by the current frame, and by the substitute samples
+   * used to fade into the next frame */
+  int16_t hist_[kHistory + kFrameSamples + kReconvergence + kOverlap];
+  float fade_[kOverlap];
+  size_t best_lag_;
+  size_t lost_frames_;
+};
@@ -1504,6 +1504,7 @@ tBTM_STATUS btm_sec_l2cap_access_req_by_requirement(
   tBTM_SEC_DEV_REC* p_dev_rec = btm_find_or_alloc_dev(bd_addr);
 
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
 
   if ((!is_originator) && (security_required & BTM_SEC_MODE4_LEVEL4)) {
     bool local_supports_sc =
@@ -3612,6 +3613,7 @@ void btm_sec_connected(const RawAddress& bda, uint16_t handle,
   }
 
   p_dev_rec->hci_handle = handle;
+  btm_cb.sec_dev_rec_index.Update(p_dev_rec);
   btm_acl_created(bda, handle, assigned_role, BT_TRANSPORT_BR_EDR);
 
   /* role may not be correct here, it will be updated by l2cap, but we need to
@@ -3743,6 +3745,7 @@ void btm_sec_disconnected(uint16_t handle, tHCI_REASON reason) {
 
   if (transport == BT_TRANSPORT_LE) {
     p_dev_rec->ble_hci_handle = HCI_INVALID_HANDLE;
+    btm_cb.sec_dev_rec_index.Update(p_dev_rec);
     p_dev_rec->sec_flags &= ~(BTM_SEC_LE_AUTHENTICATED | BTM_SEC_LE_ENCRYPTED |
                               BTM_SEC_ROLE_SWITCHED);
     p_dev_rec->enc_key_size = 0;
@@ -3759,6 +3762,7 @@ void btm_sec_disconnected(uint16_t handle, tHCI_REASON reason) {
     }
   } else {
     p_dev_rec->hci_handle = HCI_INVALID_HANDLE;
+    btm_cb.sec_dev_rec_index.Update(p_dev_rec);
     p_dev_rec->sec_flags &=
         ~(BTM_SEC_AUTHENTICATED | BTM_SEC_ENCRYPTED | BTM_SEC_ROLE_SWITCHED |
           BTM_SEC_16_DIGIT_PIN_AUTHED);
@@ -257,3 +257,4 @@ typedef union /* contains the inquiry filter condition */
 
 extern bool btm_inq_find_bdaddr(const RawAddress& p_bda);
 extern tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda);
+extern void btm_inq_db_release(tINQ_DB_ENT* p_ent);
@@ -49,6 +49,10 @@ uint8_t btu_trace_level = HCI_INITIAL_TRACE_LEVEL;
 
 static MessageLoopThread main_thread("bt_main_thread", true);
 
+/* Boot time the HCI thread received the packet being processed at, 0 when no
+ * received packet is being processed */
+static uint64_t hci_rx_time_us = 0;
+
 void btu_hci_msg_process(BT_HDR* p_msg) {
   /* Determine the input message type. */
   switch (p_msg->event & BT_EVT_MASK) {
@@ -86,6 +90,14 @@ void btu_hci_msg_process(BT_HDR* p_msg) {
   }
 }
 
+void btu_hci_msg_process_received(BT_HDR* p_msg, uint64_t rx_time_us) {
+  hci_rx_time_us = rx_time_us;
+  btu_hci_msg_process(p_msg);
+  hci_rx_time_us = 0;
+}
+
+uint64_t btu_hci_rx_time_us() { return hci_rx_time_us; }
+
 bluetooth::common::MessageLoopThread* get_main_thread() { return &main_thread; }
 
 bt_status_t do_in_main_thread(const base::Location& from_here,
@@ -97,6 +109,17 @@ bt_status_t do_in_main_thread(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 
+bt_status_t do_in_main_thread_high_priority(const base::Location& from_here,
+                                            base::OnceClosure task) {
+  if (!main_thread.DoInThread(
+          from_here, std::move(task),
+          bluetooth::common::MessageLoopThread::Priority::kHigh)) {
+    LOG(ERROR) << __func__ << ": failed from " << from_here.ToString();
+    return BT_STATUS_FAIL;
+  }
+  return BT_STATUS_SUCCESS;
+}
+
 bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay) {
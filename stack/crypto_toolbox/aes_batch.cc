@@ -0,0 +1,45 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+#include <algorithm>
+
+#include "stack/crypto_toolbox/aes_hw.h"
+
+namespace crypto_toolbox {
+
+void aes_128_batch(const Octet16* keys, size_t num_keys,
+                   const Octet16& message, Octet16* out) {
+  Octet16 message_reversed;
+  std::reverse_copy(message.begin(), message.end(), message_reversed.begin());
+
+  for (size_t i = 0; i < num_keys; i++) {
+    Octet16 key_reversed;
+    std::reverse_copy(keys[i].begin(), keys[i].end(), key_reversed.begin());
+
+    /* The key schedule is the same for both the software and the hardware
+     * rounds, only the rounds run on the AES instructions */
+    aes_context ctx;
+    aes_set_key(key_reversed.data(), key_reversed.size(), &ctx);
+    aes_encrypt_block(message_reversed.data(), out[i].data(), ctx);
+
+    std::reverse(out[i].begin(), out[i].end());
+  }
+}
+
+}  // namespace crypto_toolbox
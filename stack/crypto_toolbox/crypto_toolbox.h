@@ -22,6 +22,10 @@
 namespace crypto_toolbox {
 
 extern Octet16 aes_128(const Octet16& key, const Octet16& message);
+/* This function computes AES_128(keys[i], message) into out[i] for each of
+ * the |num_keys| keys */
+extern void aes_128_batch(const Octet16* keys, size_t num_keys,
+                          const Octet16& message, Octet16* out);
 extern Octet16 aes_cmac(const Octet16& key, const uint8_t* message,
                         uint16_t length);
 extern Octet16 f4(const uint8_t* u, const uint8_t* v, const Octet16& x,
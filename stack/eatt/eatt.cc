@@ -197,6 +197,21 @@ void EattExtension::StopAppIndicationTimer(const RawAddress& bd_addr,
   pimpl_->eatt_impl_->stop_app_indication_timer(bd_addr, cid);
 }
 
+void EattExtension::ReportGattLoad(const RawAddress& bd_addr,
+                                   uint16_t pending_requests,
+                                   uint16_t pending_indications) {
+  pimpl_->eatt_impl_->report_gatt_load(bd_addr, pending_requests,
+                                       pending_indications);
+}
+
+void EattExtension::SetBearerPolicy(const EattBearerPolicy& policy) {
+  pimpl_->eatt_impl_->policy_ = policy;
+}
+
+void EattExtension::Dump(int fd) {
+  if (pimpl_->IsRunning()) pimpl_->eatt_impl_->dump(fd);
+}
+
 void EattExtension::Start() { pimpl_->Start(); }
 
 void EattExtension::Stop() { pimpl_->Stop(); }
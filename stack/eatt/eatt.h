@@ -24,6 +24,12 @@
 #define EATT_MIN_MTU_MPS (64)
 #define EATT_DEFAULT_MTU (256)
 
+/* Defaults of the policy opening EATT bearers on GATT load */
+#define EATT_LOAD_REQUEST_DEPTH_THRESHOLD (2)
+#define EATT_LOAD_INDICATION_BACKLOG_THRESHOLD (2)
+#define EATT_LOAD_BEARERS_PER_STEP (2)
+#define EATT_IDLE_BEARER_TIMEOUT_MS (30000)
+
 namespace bluetooth {
 namespace eatt {
 
@@ -53,6 +59,8 @@ class EattChannel {
   alarm_t* ind_confirmation_timer_;
   /* GATT client command queue */
   std::queue<tGATT_CMD_Q> cl_cmd_q_;
+  /* Last time data was received on the channel, to close it once idle */
+  uint64_t last_active_ms_;
 
   EattChannel(RawAddress& bda, uint16_t cid, uint16_t tx_mtu, uint16_t rx_mtu)
       : bda_(bda),
@@ -62,7 +70,8 @@ class EattChannel {
         state_(EattChannelState::EATT_CHANNEL_PENDING),
         indicate_handle_(0),
         ind_ack_timer_(NULL),
-        ind_confirmation_timer_(NULL) {}
+        ind_confirmation_timer_(NULL),
+        last_active_ms_(0) {}
 
   ~EattChannel() {
     if (ind_ack_timer_ != NULL) {
@@ -94,6 +103,22 @@ class EattChannel {
   void EattChannelSetTxMTU(uint16_t tx_mtu) { this->tx_mtu_ = tx_mtu; }
 };
 
+/* Policy scaling the EATT bearers with the GATT load. When dynamic, a link
+ * starts with the ATT bearer only: the central opens EATT bearers when the
+ * load crosses a threshold, and closes them once they stay idle.
+ */
+struct EattBearerPolicy {
+  bool dynamic;
+  /* Client requests queued on the link that trigger opening bearers */
+  uint16_t request_depth_threshold;
+  /* Indications waiting for a free bearer that trigger opening bearers */
+  uint16_t indication_backlog_threshold;
+  /* Number of bearers opened at once */
+  uint8_t bearers_per_step;
+  /* Time without data after which a bearer is closed */
+  uint64_t idle_timeout_ms;
+};
+
 /* Interface class */
 class EattExtension {
  public:
@@ -263,6 +288,32 @@ class EattExtension {
    */
   virtual void StopAppIndicationTimer(const RawAddress& bd_addr, uint16_t cid);
 
+  /**
+   * Report the GATT load of the link to the peer device, so that EATT bearers
+   * can be opened on demand.
+   *
+   * @param bd_addr peer device address
+   * @param pending_requests client requests queued on all bearers
+   * @param pending_indications indications waiting for a free bearer
+   */
+  virtual void ReportGattLoad(const RawAddress& bd_addr,
+                              uint16_t pending_requests,
+                              uint16_t pending_indications);
+
+  /**
+   * Set the policy scaling the EATT bearers with the GATT load
+   *
+   * @param policy new policy, applies to the next load reports
+   */
+  void SetBearerPolicy(const EattBearerPolicy& policy);
+
+  /**
+   * Dump the EATT bearers of each peer device
+   *
+   * @param fd file descriptor to dump to
+   */
+  void Dump(int fd);
+
   /**
    * Starts the EattExtension module
    */
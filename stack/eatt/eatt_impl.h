@@ -15,16 +15,21 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+
+#include <algorithm>
 #include <map>
 #include <queue>
 
 #include "acl_api.h"
 #include "base/bind_helpers.h"
 #include "bt_types.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "eatt.h"
 #include "l2c_api.h"
 #include "osi/include/alarm.h"
+#include "osi/include/properties.h"
 #include "stack/btm/btm_sec.h"
 #include "stack/gatt/gatt_int.h"
 #include "stack/l2cap/l2c_int.h"
@@ -44,8 +49,16 @@ class eatt_device {
 
   std::map<uint16_t, std::shared_ptr<EattChannel>> eatt_channels;
 
+  /* Bearers opened on GATT load and closed once idle */
+  uint32_t bearers_opened_on_load_;
+  uint32_t bearers_closed_idle_;
+
   eatt_device(const RawAddress& bd_addr, uint16_t mtu, uint16_t mps)
-      : rx_mtu_(mtu), rx_mps_(mps), eatt_tcb_(nullptr) {
+      : rx_mtu_(mtu),
+        rx_mps_(mps),
+        eatt_tcb_(nullptr),
+        bearers_opened_on_load_(0),
+        bearers_closed_idle_(0) {
     bda_ = bd_addr;
   }
 };
@@ -56,14 +69,27 @@ struct eatt_impl {
   uint16_t default_mtu_;
   uint16_t max_mps_;
   tL2CAP_APPL_INFO reg_info_;
+  EattBearerPolicy policy_;
+  alarm_t* idle_timer_;
 
   eatt_impl() {
     default_mtu_ = EATT_DEFAULT_MTU;
     max_mps_ = EATT_MIN_MTU_MPS;
     psm_ = BT_PSM_EATT;
+
+    policy_.dynamic =
+        osi_property_get_bool("persist.bluetooth.eatt.dynamic_bearers", false);
+    policy_.request_depth_threshold = EATT_LOAD_REQUEST_DEPTH_THRESHOLD;
+    policy_.indication_backlog_threshold =
+        EATT_LOAD_INDICATION_BACKLOG_THRESHOLD;
+    policy_.bearers_per_step = EATT_LOAD_BEARERS_PER_STEP;
+    policy_.idle_timeout_ms =
+        osi_property_get_int32("persist.bluetooth.eatt.idle_timeout_ms",
+                               EATT_IDLE_BEARER_TIMEOUT_MS);
+    idle_timer_ = alarm_new("eatt_idle_timer");
   };
 
-  ~eatt_impl() = default;
+  ~eatt_impl() { alarm_free(idle_timer_); }
 
   eatt_device* find_device_by_cid(uint16_t lcid) {
     /* This works only because Android CIDs are unique across the ACL
@@ -146,10 +172,13 @@ struct eatt_impl {
       eatt_dev->eatt_channels.insert({cid, chan});
 
       chan->EattChannelSetState(EattChannelState::EATT_CHANNEL_OPENED);
+      chan->last_active_ms_ = bluetooth::common::time_get_os_boottime_ms();
       eatt_dev->eatt_tcb_->eatt++;
 
       LOG(INFO) << __func__ << " Channel connected CID " << loghex(cid);
     }
+
+    schedule_idle_check();
   }
 
   void eatt_l2cap_connect_cfm(const RawAddress& bda, uint16_t lcid,
@@ -178,12 +207,15 @@ struct eatt_impl {
 
     channel->EattChannelSetState(EattChannelState::EATT_CHANNEL_OPENED);
     channel->EattChannelSetTxMTU(peer_mtu);
+    channel->last_active_ms_ = bluetooth::common::time_get_os_boottime_ms();
 
     CHECK(eatt_dev->eatt_tcb_);
     CHECK(eatt_dev->bda_ == channel->bda_);
     eatt_dev->eatt_tcb_->eatt++;
 
     LOG(INFO) << __func__ << " Channel connected CID " << loghex(lcid);
+
+    schedule_idle_check();
   }
 
   void eatt_l2cap_reconfig_completed(const RawAddress& bda, uint16_t lcid,
@@ -270,6 +302,7 @@ struct eatt_impl {
       return;
     }
 
+    channel->last_active_ms_ = bluetooth::common::time_get_os_boottime_ms();
     gatt_data_process(*eatt_dev->eatt_tcb_, channel->cid_, data_p);
     osi_free(data_p);
   }
@@ -292,7 +325,8 @@ struct eatt_impl {
     return eatt_dev;
   }
 
-  void connect_eatt(eatt_device* eatt_dev) {
+  void connect_eatt(eatt_device* eatt_dev,
+                    uint8_t num_of_channels = L2CAP_CREDIT_BASED_MAX_CIDS) {
     /* Let us use maximum possible mps */
     if (eatt_dev->rx_mps_ == EATT_MIN_MTU_MPS)
       eatt_dev->rx_mps_ = controller_get_interface()->get_acl_data_size_ble();
@@ -304,8 +338,8 @@ struct eatt_impl {
     };
 
     /* Warning! CIDs in Android are unique across the ACL connections */
-    std::vector<uint16_t> connecting_cids =
-        L2CA_ConnectCreditBasedReq(psm_, eatt_dev->bda_, &local_coc_cfg);
+    std::vector<uint16_t> connecting_cids = L2CA_ConnectCreditBasedReq(
+        psm_, eatt_dev->bda_, &local_coc_cfg, num_of_channels);
 
     if (connecting_cids.size() == 0) {
       LOG(ERROR) << "Unable to get cid";
@@ -589,6 +623,11 @@ struct eatt_impl {
       return;
     }
 
+    if (policy_.dynamic) {
+      LOG(INFO) << __func__ << " EATT bearers will be opened on GATT load";
+      return;
+    }
+
     connect_eatt(eatt_dev);
   }
 
@@ -646,6 +685,11 @@ struct eatt_impl {
         return;
       }
 
+      if (policy_.dynamic) {
+        LOG(INFO) << __func__ << " EATT bearers will be opened on GATT load";
+        return;
+      }
+
       connect_eatt(eatt_dev);
       return;
     }
@@ -659,6 +703,119 @@ struct eatt_impl {
     }
   }
 
+  void report_gatt_load(const RawAddress& bd_addr, uint16_t pending_requests,
+                        uint16_t pending_indications) {
+    if (!policy_.dynamic) return;
+    if (pending_requests < policy_.request_depth_threshold &&
+        pending_indications < policy_.indication_backlog_threshold)
+      return;
+
+    /* Only peers known to support EATT are in the list */
+    eatt_device* eatt_dev = find_device_by_address(bd_addr);
+    if (!eatt_dev) return;
+
+    /* Opening more bearers than a connection opens at once wastes credits */
+    size_t num_of_bearers = eatt_dev->eatt_channels.size();
+    if (num_of_bearers >= L2CAP_CREDIT_BASED_MAX_CIDS) return;
+
+    /* Wait for the bearers being opened before asking for more */
+    auto iter = find_if(
+        eatt_dev->eatt_channels.begin(), eatt_dev->eatt_channels.end(),
+        [](const std::pair<uint16_t, std::shared_ptr<EattChannel>>& el) {
+          return el.second->state_ == EattChannelState::EATT_CHANNEL_PENDING;
+        });
+    if (iter != eatt_dev->eatt_channels.end()) return;
+
+    if (L2CA_GetBleConnRole(bd_addr) != HCI_ROLE_CENTRAL) return;
+
+    uint8_t num_of_channels = std::min<size_t>(
+        policy_.bearers_per_step, L2CAP_CREDIT_BASED_MAX_CIDS - num_of_bearers);
+
+    LOG(INFO) << __func__ << " " << bd_addr
+              << " pending requests: " << +pending_requests
+              << " pending indications: " << +pending_indications
+              << ", opening " << +num_of_channels << " bearers";
+
+    connect_eatt(eatt_dev, num_of_channels);
+    eatt_dev->bearers_opened_on_load_ +=
+        eatt_dev->eatt_channels.size() - num_of_bearers;
+  }
+
+  static void eatt_idle_timeout(void* data) {
+    eatt_impl* impl = (eatt_impl*)data;
+    impl->close_idle_bearers();
+  }
+
+  void schedule_idle_check() {
+    if (!policy_.dynamic || alarm_is_scheduled(idle_timer_)) return;
+
+    alarm_set_on_mloop(idle_timer_, policy_.idle_timeout_ms, eatt_idle_timeout,
+                       this);
+  }
+
+  bool is_channel_idle(EattChannel* channel, uint64_t now_ms) {
+    return channel->state_ == EattChannelState::EATT_CHANNEL_OPENED &&
+           channel->cl_cmd_q_.empty() &&
+           !GATT_HANDLE_IS_VALID(channel->indicate_handle_) &&
+           now_ms - channel->last_active_ms_ >= policy_.idle_timeout_ms;
+  }
+
+  void close_idle_bearers() {
+    uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+    bool has_bearers = false;
+
+    for (eatt_device& eatt_dev : devices_) {
+      auto iter = eatt_dev.eatt_channels.begin();
+      while (iter != eatt_dev.eatt_channels.end()) {
+        if (!is_channel_idle(iter->second.get(), now_ms)) {
+          has_bearers = true;
+          iter++;
+          continue;
+        }
+
+        uint16_t cid = iter->first;
+        LOG(INFO) << __func__ << " " << eatt_dev.bda_
+                  << " closing idle cid: " << loghex(cid);
+        disconnect_channel(cid);
+        /* When initiating disconnection, stack will not notify us that it is
+         * done. We need to assume success
+         */
+        iter = eatt_dev.eatt_channels.erase(iter);
+        eatt_dev.eatt_tcb_->eatt--;
+        eatt_dev.bearers_closed_idle_++;
+      }
+
+      if (eatt_dev.eatt_channels.empty()) eatt_dev.eatt_tcb_ = nullptr;
+    }
+
+    if (has_bearers) schedule_idle_check();
+  }
+
+  void dump(int fd) {
+    dprintf(fd, "\nEATT state:\n");
+    dprintf(fd,
+            "\tdynamic bearers: %s request depth threshold: %u indication "
+            "backlog threshold: %u idle timeout: %llums\n",
+            policy_.dynamic ? "true" : "false",
+            policy_.request_depth_threshold,
+            policy_.indication_backlog_threshold,
+            (unsigned long long)policy_.idle_timeout_ms);
+
+    for (const eatt_device& eatt_dev : devices_) {
+      size_t pending = std::count_if(
+          eatt_dev.eatt_channels.begin(), eatt_dev.eatt_channels.end(),
+          [](const std::pair<uint16_t, std::shared_ptr<EattChannel>>& el) {
+            return el.second->state_ == EattChannelState::EATT_CHANNEL_PENDING;
+          });
+      dprintf(fd,
+              "\t * %s: bearers: %zu pending: %zu opened on load: %u closed "
+              "idle: %u\n",
+              eatt_dev.bda_.ToString().c_str(), eatt_dev.eatt_channels.size(),
+              pending, eatt_dev.bearers_opened_on_load_,
+              eatt_dev.bearers_closed_idle_);
+    }
+  }
+
   void add_from_storage(const RawAddress& bd_addr) {
     eatt_device* eatt_dev = find_device_by_address(bd_addr);
 
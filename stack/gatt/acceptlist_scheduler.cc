@@ -0,0 +1,230 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/gatt/acceptlist_scheduler.h"
+
+#include <algorithm>
+
+namespace connection_manager {
+
+namespace {
+
+constexpr uint64_t kNever = UINT64_MAX;
+
+/* Removes |address| from |addresses|, returns true if it was there */
+bool erase(std::vector<RawAddress>* addresses, const RawAddress& address) {
+  auto it = std::find(addresses->begin(), addresses->end(), address);
+  if (it == addresses->end()) return false;
+  addresses->erase(it);
+  return true;
+}
+
+}  // namespace
+
+void AcceptlistScheduler::Reset() {
+  devices_.clear();
+  capacity_ = 0;
+  in_acceptlist_ = 0;
+}
+
+bool AcceptlistScheduler::Contains(const RawAddress& address) const {
+  return devices_.count(address) != 0;
+}
+
+bool AcceptlistScheduler::InAcceptlist(const RawAddress& address) const {
+  auto it = devices_.find(address);
+  return it != devices_.end() && it->second.in_acceptlist;
+}
+
+bool AcceptlistScheduler::Add(const RawAddress& address, bool direct,
+                              uint64_t now_ms) {
+  auto it = devices_.find(address);
+  if (it != devices_.end()) {
+    it->second.direct |= direct;
+    return false;
+  }
+
+  bool has_slot = in_acceptlist_ < capacity_;
+  devices_[address] = Device{direct, has_slot, false, now_ms, 0};
+  if (has_slot) in_acceptlist_++;
+  return has_slot;
+}
+
+bool AcceptlistScheduler::Remove(const RawAddress& address) {
+  auto it = devices_.find(address);
+  if (it == devices_.end()) return false;
+
+  bool had_slot = it->second.in_acceptlist;
+  if (had_slot) in_acceptlist_--;
+  devices_.erase(it);
+  return had_slot;
+}
+
+void AcceptlistScheduler::OnAddFailed(const RawAddress& address,
+                                      uint64_t now_ms) {
+  auto it = devices_.find(address);
+  if (it == devices_.end() || !it->second.in_acceptlist) return;
+
+  it->second.in_acceptlist = false;
+  it->second.slot_ms = now_ms;
+  in_acceptlist_--;
+  /* The controller holds less than it said, or holds devices of others */
+  capacity_ = in_acceptlist_;
+}
+
+void AcceptlistScheduler::SetDirect(const RawAddress& address, bool direct) {
+  auto it = devices_.find(address);
+  if (it != devices_.end()) it->second.direct = direct;
+}
+
+bool AcceptlistScheduler::OnSeen(const RawAddress& address, uint64_t now_ms) {
+  auto it = devices_.find(address);
+  if (it == devices_.end()) return false;
+
+  Device& device = it->second;
+  bool was_nearby = IsNearby(device, now_ms);
+  device.seen_ms = now_ms;
+  if (was_nearby || device.in_acceptlist || device.connected) return false;
+  promotions_++;
+  return true;
+}
+
+void AcceptlistScheduler::OnConnected(const RawAddress& address) {
+  auto it = devices_.find(address);
+  if (it != devices_.end()) it->second.connected = true;
+}
+
+void AcceptlistScheduler::OnDisconnected(const RawAddress& address,
+                                         uint64_t now_ms) {
+  auto it = devices_.find(address);
+  if (it == devices_.end()) return;
+
+  /* It was just around, it is likely to be back soon */
+  it->second.connected = false;
+  it->second.seen_ms = now_ms;
+}
+
+bool AcceptlistScheduler::IsNearby(const Device& device, uint64_t now_ms) {
+  return device.seen_ms != 0 && now_ms - device.seen_ms < kNearbyMs;
+}
+
+bool AcceptlistScheduler::WaitsLonger(const Device& a, const Device& b,
+                                      uint64_t now_ms) {
+  if (a.direct != b.direct) return a.direct;
+  bool a_nearby = IsNearby(a, now_ms);
+  if (a_nearby != IsNearby(b, now_ms)) return a_nearby;
+  return a.slot_ms < b.slot_ms;
+}
+
+uint64_t AcceptlistScheduler::EvictableMs(const Device& waiting,
+                                          const Device& victim,
+                                          uint64_t now_ms) {
+  if (victim.connected) return 0;
+  if (victim.direct) return kNever;
+  if (waiting.direct) return 0;
+
+  uint64_t evictable_ms = victim.slot_ms + kSlotMs;
+  if (IsNearby(waiting, now_ms) && !IsNearby(victim, now_ms)) {
+    evictable_ms = std::min(evictable_ms, victim.slot_ms + kMinSlotMs);
+  }
+  return evictable_ms;
+}
+
+AcceptlistScheduler::DeviceMap::const_iterator AcceptlistScheduler::BestWaiting(
+    uint64_t now_ms) const {
+  auto best = devices_.end();
+  for (auto it = devices_.begin(); it != devices_.end(); it++) {
+    const Device& device = it->second;
+    if (device.in_acceptlist || device.connected) continue;
+    if (best == devices_.end() || WaitsLonger(device, best->second, now_ms)) {
+      best = it;
+    }
+  }
+  return best;
+}
+
+AcceptlistScheduler::Batch AcceptlistScheduler::Rotate(uint64_t now_ms) {
+  /* Every device taking a slot ends with a fresh one, and only the devices
+   * that had theirs for a while, or are connected, lose it: this ends */
+  Batch batch;
+  for (;;) {
+    auto best = BestWaiting(now_ms);
+    if (best == devices_.end()) break;
+    const Device& waiting = best->second;
+
+    if (in_acceptlist_ >= capacity_) {
+      /* Connected devices first, then the slot held the longest */
+      auto victim = devices_.end();
+      uint64_t victim_ms = kNever;
+      for (auto it = devices_.begin(); it != devices_.end(); it++) {
+        if (!it->second.in_acceptlist) continue;
+        uint64_t evictable_ms = EvictableMs(waiting, it->second, now_ms);
+        if (evictable_ms > now_ms) continue;
+        if (victim == devices_.end() || evictable_ms < victim_ms ||
+            (evictable_ms == victim_ms &&
+             it->second.slot_ms < victim->second.slot_ms)) {
+          victim = it;
+          victim_ms = evictable_ms;
+        }
+      }
+      if (victim == devices_.end()) break;
+
+      victim->second.in_acceptlist = false;
+      victim->second.slot_ms = now_ms;
+      in_acceptlist_--;
+      if (!erase(&batch.add, victim->first)) {
+        batch.remove.push_back(victim->first);
+      }
+    }
+
+    /* It may have lost its slot earlier in this batch */
+    Device& device = devices_[best->first];
+    device.in_acceptlist = true;
+    device.slot_ms = now_ms;
+    in_acceptlist_++;
+    if (!erase(&batch.remove, best->first)) batch.add.push_back(best->first);
+  }
+  rotations_ += batch.remove.size();
+  return batch;
+}
+
+uint64_t AcceptlistScheduler::NextRotationMs(uint64_t now_ms) const {
+  auto best = BestWaiting(now_ms);
+  if (best == devices_.end()) return 0;
+  if (in_acceptlist_ < capacity_) return now_ms;
+
+  uint64_t next_ms = kNever;
+  for (const auto& entry : devices_) {
+    if (!entry.second.in_acceptlist) continue;
+    next_ms =
+        std::min(next_ms, EvictableMs(best->second, entry.second, now_ms));
+  }
+  /* All slots are held by direct connections, they end within seconds */
+  if (next_ms == kNever) return now_ms + kSlotMs;
+  return std::max(next_ms, now_ms);
+}
+
+size_t AcceptlistScheduler::waiting() const {
+  size_t count = 0;
+  for (const auto& entry : devices_) {
+    if (!entry.second.in_acceptlist && !entry.second.connected) count++;
+  }
+  return count;
+}
+
+}  // namespace connection_manager
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "types/raw_address.h"
+
+namespace connection_manager {
+
+/* Decides which of the devices connection_manager connects to are in the
+ * controller acceptlist, when there are more of them than it can hold.
+ *
+ * Devices with a free slot are added right away. The others wait, and get a
+ * slot in turns:
+ *  - a direct connection takes the slot of a background one right away;
+ *  - a device seen advertising in the last kNearbyMs takes the slot of one
+ *    that wasn't, after it had it for kMinSlotMs;
+ *  - any other takes the slot of the device that had it for kSlotMs, the
+ *    devices that waited the longest first.
+ * Connected devices don't need their slot, they give it up first.
+ *
+ * It doesn't send anything to the controller: Rotate() returns the devices to
+ * remove and to add, to apply in one batch.
+ */
+class AcceptlistScheduler {
+ public:
+  static constexpr uint64_t kSlotMs = 20000;
+  static constexpr uint64_t kMinSlotMs = 4000;
+  static constexpr uint64_t kNearbyMs = 10000;
+
+  struct Batch {
+    std::vector<RawAddress> remove;
+    std::vector<RawAddress> add;
+  };
+
+  void Reset();
+
+  /* Number of devices the controller acceptlist holds */
+  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  size_t capacity() const { return capacity_; }
+
+  bool Contains(const RawAddress& address) const;
+  bool InAcceptlist(const RawAddress& address) const;
+
+  /* A device to connect to. Returns true if it has a slot right away, the
+   * caller adds it to the acceptlist, false if it waits */
+  bool Add(const RawAddress& address, bool direct, uint64_t now_ms);
+  /* Nobody connects to the device anymore. Returns true if it had a slot, the
+   * caller removes it from the acceptlist */
+  bool Remove(const RawAddress& address);
+  /* The device was given a slot that the acceptlist had no room for */
+  void OnAddFailed(const RawAddress& address, uint64_t now_ms);
+  void SetDirect(const RawAddress& address, bool direct);
+
+  /* The device was seen advertising. Returns true if it waits for a slot, and
+   * the caller should Rotate() soon */
+  bool OnSeen(const RawAddress& address, uint64_t now_ms);
+  void OnConnected(const RawAddress& address);
+  void OnDisconnected(const RawAddress& address, uint64_t now_ms);
+
+  /* Gives the slots to the devices that should have them now */
+  Batch Rotate(uint64_t now_ms);
+
+  /* When Rotate() has something to do: 0 if no device waits, |now_ms| if
+   * right away */
+  uint64_t NextRotationMs(uint64_t now_ms) const;
+
+  size_t size() const { return devices_.size(); }
+  size_t in_acceptlist() const { return in_acceptlist_; }
+  size_t waiting() const;
+  uint32_t rotations() const { return rotations_; }
+  uint32_t promotions() const { return promotions_; }
+
+ private:
+  struct Device {
+    bool direct;
+    bool in_acceptlist;
+    bool connected;
+    /* When it got its slot, or lost it */
+    uint64_t slot_ms;
+    /* When it was last seen advertising, 0 if never */
+    uint64_t seen_ms;
+  };
+  using DeviceMap = std::map<RawAddress, Device>;
+
+  static bool IsNearby(const Device& device, uint64_t now_ms);
+  static bool WaitsLonger(const Device& a, const Device& b, uint64_t now_ms);
+  /* When |waiting| may take the slot of |victim| */
+  static uint64_t EvictableMs(const Device& waiting, const Device& victim,
+                              uint64_t now_ms);
+  DeviceMap::const_iterator BestWaiting(uint64_t now_ms) const;
+
+  DeviceMap devices_;
+  size_t capacity_ = 0;
+  size_t in_acceptlist_ = 0;
+  uint32_t rotations_ = 0;
+  uint32_t promotions_ = 0;
+};
+
+}  // namespace connection_manager
@@ -25,6 +25,7 @@
 #include "bt_target.h"
 
 #include "gatt_int.h"
+#include "gd/common/trace_ring.h"
 #include "l2c_api.h"
 #include "osi/include/log.h"
 
@@ -387,6 +388,78 @@ BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         attp_build_notif_msg
+ *
+ * Description      Build a handle value notification for an ATT bearer of
+ *                  the given payload size. The value is truncated to fit.
+ *
+ * Returns          the PDU.
+ *
+ ******************************************************************************/
+BT_HDR* attp_build_notif_msg(uint16_t payload_size, uint16_t handle,
+                             uint16_t len, uint8_t* p_data) {
+  return attp_build_value_cmd(payload_size, GATT_HANDLE_VALUE_NOTIF, handle, 0,
+                              len, p_data);
+}
+
+/*******************************************************************************
+ *
+ * Function         attp_build_multi_notif_msg
+ *
+ * Description      Build a multiple handle value notification of the values
+ *                  from *p_it that fit in payload_size, and advance *p_it
+ *                  past them. A value that does not fit with another one is
+ *                  sent in a handle value notification instead, as the PDU
+ *                  must hold at least two values.
+ *
+ * Returns          the PDU.
+ *
+ ******************************************************************************/
+BT_HDR* attp_build_multi_notif_msg(
+    uint16_t payload_size,
+    std::map<uint16_t, std::vector<uint8_t>>::const_iterator* p_it,
+    std::map<uint16_t, std::vector<uint8_t>>::const_iterator end) {
+  /* opcode, then handle, length and value of each notification */
+  size_t len = GATT_OP_CODE_SIZE;
+  size_t count = 0;
+  for (auto it = *p_it; it != end; it++) {
+    if (len + 4 + it->second.size() > payload_size) break;
+    len += 4 + it->second.size();
+    count++;
+  }
+
+  if (count < 2) {
+    const auto& first = **p_it;
+    (*p_it)++;
+    return attp_build_notif_msg(payload_size, first.first, first.second.size(),
+                                const_cast<uint8_t*>(first.second.data()));
+  }
+
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + len + L2CAP_MIN_OFFSET);
+  uint8_t* p = (uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET;
+  p_buf->offset = L2CAP_MIN_OFFSET;
+  p_buf->len = len;
+
+  UINT8_TO_STREAM(p, GATT_HANDLE_MULTI_VALUE_NOTIF);
+  for (; count > 0; count--, (*p_it)++) {
+    const std::vector<uint8_t>& value = (*p_it)->second;
+    UINT16_TO_STREAM(p, (*p_it)->first);
+    UINT16_TO_STREAM(p, value.size());
+    ARRAY_TO_STREAM(p, value.data(), (int)value.size());
+  }
+  return p_buf;
+}
+
+/** Copy of a built PDU, for sending the same PDU on another bearer */
+BT_HDR* attp_copy_msg(const BT_HDR* p_msg) {
+  size_t size = sizeof(BT_HDR) + p_msg->offset + p_msg->len;
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(size);
+  memcpy(p_buf, p_msg, size);
+  return p_buf;
+}
+
 /*******************************************************************************
  *
  * Function         attp_send_sr_msg
@@ -509,6 +582,9 @@ tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
     return GATT_ILLEGAL_PARAMETER;
   }
 
+  bluetooth::common::TraceRing::Record(
+      bluetooth::common::TraceEventId::GATT_REQUEST, p_clcb->cid, op_code);
+
   uint16_t payload_size = gatt_tcb_get_payload_size_tx(tcb, p_clcb->cid);
 
   switch (op_code) {
@@ -26,11 +26,13 @@
 #include <memory>
 #include <set>
 
+#include "common/time_util.h"
 #include "internal_include/bt_trace.h"
 #include "main/shim/shim.h"
 #include "osi/include/alarm.h"
 #include "osi/include/log.h"
 #include "stack/btm/btm_ble_bgconn.h"
+#include "stack/gatt/acceptlist_scheduler.h"
 #include "stack/include/l2c_api.h"
 
 #define DIRECT_CONNECT_TIMEOUT (30 * 1000) /* 30 seconds */
@@ -73,14 +75,91 @@ namespace {
 // Maps address to apps trying to connect to it
 std::map<RawAddress, tAPPS_CONNECTING> bgconn_dev;
 
+// Devices of bgconn_dev with a slot in the acceptlist, and those waiting for
+// one when there are more than it holds
+AcceptlistScheduler scheduler;
+alarm_t* rotation_alarm = nullptr;
+
 bool anyone_connecting(
     const std::map<RawAddress, tAPPS_CONNECTING>::iterator it) {
   return (!it->second.doing_bg_conn.empty() ||
           !it->second.doing_direct_conn.empty());
 }
 
+uint64_t now_ms() { return bluetooth::common::time_get_os_boottime_ms(); }
+
 }  // namespace
 
+static void rotate_acceptlist(void* data);
+
+/** Sets the rotation timer to when the acceptlist should next rotate */
+static void set_rotation_alarm(uint64_t now) {
+  uint64_t next = scheduler.NextRotationMs(now);
+  if (next == 0) {
+    if (rotation_alarm != nullptr) alarm_cancel(rotation_alarm);
+    return;
+  }
+
+  if (rotation_alarm == nullptr) {
+    rotation_alarm = alarm_new("conn_mgr_acceptlist_rotation");
+  }
+  uint64_t delay_ms = next > now ? next - now : AcceptlistScheduler::kMinSlotMs;
+  alarm_set_on_mloop(rotation_alarm, delay_ms, rotate_acceptlist, nullptr);
+}
+
+/** Gives the acceptlist slots to the devices that should have them now, in one
+ * batch */
+static void rotate_acceptlist(void* data) {
+  uint64_t now = now_ms();
+  AcceptlistScheduler::Batch batch = scheduler.Rotate(now);
+  if (!batch.remove.empty() || !batch.add.empty()) {
+    LOG_INFO("Rotating acceptlist removing:%zu adding:%zu waiting:%zu",
+             batch.remove.size(), batch.add.size(), scheduler.waiting());
+    for (const RawAddress& address :
+         BTM_AcceptlistUpdate(batch.remove, batch.add)) {
+      scheduler.OnAddFailed(address, now);
+    }
+  }
+  set_rotation_alarm(now);
+}
+
+/** Rotates the acceptlist now if it should, or sets the timer */
+static void schedule_rotation() {
+  uint64_t now = now_ms();
+  uint64_t next = scheduler.NextRotationMs(now);
+  if (next != 0 && next <= now) {
+    rotate_acceptlist(nullptr);
+  } else {
+    set_rotation_alarm(now);
+  }
+}
+
+/** Adds a device to the acceptlist, or to the devices waiting for a slot in it
+ * if it is full. Returns false if it can't be added */
+static bool acceptlist_add(const RawAddress& address, bool direct) {
+  if (scheduler.size() == 0) scheduler.SetCapacity(BTM_GetAcceptlistSize());
+  if (scheduler.capacity() == 0) return false;
+
+  if (!scheduler.Add(address, direct, now_ms())) {
+    LOG_INFO("Acceptlist full, device waits for a slot:%s",
+             address.ToString().c_str());
+    schedule_rotation();
+    return true;
+  }
+
+  if (!BTM_AcceptlistAdd(address)) {
+    scheduler.Remove(address);
+    return false;
+  }
+  return true;
+}
+
+/** Removes a device from the acceptlist, or from the devices waiting for a
+ * slot in it. The caller schedules a rotation to hand out the slot */
+static void acceptlist_remove(const RawAddress& address) {
+  if (scheduler.Remove(address)) BTM_AcceptlistRemove(address);
+}
+
 /** background connection device from the list. Returns pointer to the device
  * record, or nullptr if not found */
 std::set<tAPP_ID> get_apps_connecting_to(const RawAddress& address) {
@@ -97,7 +176,6 @@ bool background_connect_add(uint8_t app_id, const RawAddress& address) {
   }
 
   auto it = bgconn_dev.find(address);
-  bool in_acceptlist = false;
   if (it != bgconn_dev.end()) {
     // device already in the acceptlist, just add interested app to the list
     if (it->second.doing_bg_conn.count(app_id)) {
@@ -105,16 +183,11 @@ bool background_connect_add(uint8_t app_id, const RawAddress& address) {
                 << "already doing background connection to " << address;
       return true;
     }
-
-    // Already in acceptlist ?
-    if (anyone_connecting(it)) {
-      in_acceptlist = true;
-    }
   }
 
-  if (!in_acceptlist) {
-    // the device is not in the acceptlist
-    if (!BTM_AcceptlistAdd(address)) return false;
+  // Already in acceptlist, or waiting for a slot in it ?
+  if (!scheduler.Contains(address)) {
+    if (!acceptlist_add(address, false)) return false;
   }
 
   // create endtry for address, and insert app_id.
@@ -128,8 +201,9 @@ bool remove_unconditional(const RawAddress& address) {
   auto it = bgconn_dev.find(address);
   if (it == bgconn_dev.end()) return false;
 
-  BTM_AcceptlistRemove(address);
+  acceptlist_remove(address);
   bgconn_dev.erase(it);
+  schedule_rotation();
   return true;
 }
 
@@ -146,8 +220,9 @@ bool background_connect_remove(uint8_t app_id, const RawAddress& address) {
   if (anyone_connecting(it)) return true;
 
   // no more apps interested - remove from acceptlist and delete record
-  BTM_AcceptlistRemove(address);
+  acceptlist_remove(address);
   bgconn_dev.erase(it);
+  schedule_rotation();
   return true;
 }
 
@@ -162,13 +237,15 @@ void on_app_deregistered(uint8_t app_id) {
     it->second.doing_direct_conn.erase(app_id);
 
     if (anyone_connecting(it)) {
+      scheduler.SetDirect(it->first, !it->second.doing_direct_conn.empty());
       it++;
       continue;
     }
 
-    BTM_AcceptlistRemove(it->first);
+    acceptlist_remove(it->first);
     it = bgconn_dev.erase(it);
   }
+  schedule_rotation();
 }
 
 static void remove_all_clients_with_pending_connections(
@@ -184,13 +261,41 @@ static void remove_all_clients_with_pending_connections(
 void on_connection_complete(const RawAddress& address) {
   LOG_INFO("Le connection completed to device:%s", address.ToString().c_str());
 
+  // a connected device doesn't need its slot, it gives it up if others wait
+  scheduler.OnConnected(address);
   remove_all_clients_with_pending_connections(address);
+  schedule_rotation();
+}
+
+bool on_disconnected(const RawAddress& address) {
+  if (!scheduler.Contains(address)) return true;
+
+  scheduler.OnDisconnected(address, now_ms());
+  bool in_acceptlist = scheduler.InAcceptlist(address);
+  schedule_rotation();
+  return in_acceptlist;
+}
+
+void on_advertising_seen(const RawAddress& address) {
+  // on every advertising report, keep it cheap while the acceptlist has room
+  if (scheduler.size() <= scheduler.in_acceptlist()) return;
+
+  if (scheduler.OnSeen(address, now_ms())) {
+    LOG_DEBUG("Device waiting for an acceptlist slot is nearby:%s",
+              address.ToString().c_str());
+    schedule_rotation();
+  }
 }
 
 /** Reset bg device list. If called after controller reset, set |after_reset| to
  * true, as there is no need to wipe controller acceptlist in this case. */
 void reset(bool after_reset) {
   bgconn_dev.clear();
+  scheduler.Reset();
+  if (rotation_alarm != nullptr) {
+    alarm_free(rotation_alarm);
+    rotation_alarm = nullptr;
+  }
   if (!after_reset) BTM_AcceptlistClear();
 }
 
@@ -219,8 +324,8 @@ bool direct_connect_add(uint8_t app_id, const RawAddress& address) {
       return false;
     }
 
-    // are we already in the acceptlist ?
-    if (anyone_connecting(it)) {
+    // are we already in the acceptlist, or waiting for a slot in it ?
+    if (scheduler.Contains(address)) {
       LOG_WARN("Background connection attempt already in progress app_id=%x",
                app_id);
       in_acceptlist = true;
@@ -230,12 +335,16 @@ bool direct_connect_add(uint8_t app_id, const RawAddress& address) {
   bool params_changed = BTM_SetLeConnectionModeToFast();
 
   if (!in_acceptlist) {
-    if (!BTM_AcceptlistAdd(address)) {
+    if (!acceptlist_add(address, true)) {
       // if we can't add to acceptlist, turn parameters back to slow.
       LOG_WARN("Unable to add le device to acceptlist");
       if (params_changed) BTM_SetLeConnectionModeToSlow();
       return false;
     }
+  } else {
+    // if waiting for a slot, take one from a background connection right away
+    scheduler.SetDirect(address, true);
+    schedule_rotation();
   }
 
   // Setup a timer
@@ -279,12 +388,14 @@ bool direct_connect_remove(uint8_t app_id, const RawAddress& address) {
   }
 
   if (anyone_connecting(it)) {
+    scheduler.SetDirect(address, !it->second.doing_direct_conn.empty());
     return true;
   }
 
   // no more apps interested - remove from acceptlist
-  BTM_AcceptlistRemove(address);
+  acceptlist_remove(address);
   bgconn_dev.erase(it);
+  schedule_rotation();
   return true;
 }
 
@@ -296,8 +407,15 @@ void dump(int fd) {
   }
 
   dprintf(fd, "\tdevices attempting connection: %d", (int)bgconn_dev.size());
+  dprintf(fd,
+          "\n\tacceptlist slots: %zu in use: %zu waiting: %zu rotations: %u "
+          "promoted when seen: %u",
+          scheduler.capacity(), scheduler.in_acceptlist(), scheduler.waiting(),
+          scheduler.rotations(), scheduler.promotions());
   for (const auto& entry : bgconn_dev) {
-    dprintf(fd, "\n\t * %s: ", entry.first.ToString().c_str());
+    dprintf(fd, "\n\t * %s: %s", entry.first.ToString().c_str(),
+            scheduler.InAcceptlist(entry.first) ? "in acceptlist"
+                                                : "waiting for a slot");
 
     if (!entry.second.doing_direct_conn.empty()) {
       dprintf(fd, "\n\t\tapps doing direct connect: ");
@@ -25,7 +25,8 @@
 /* connection_manager takes care of all the low-level details of LE connection
  * initiation. It accept requests from multiple subsystems to connect to
  * devices, and multiplex them into acceptlist add/remove, and scan parameter
- * changes.
+ * changes. When there are more devices than the controller acceptlist holds,
+ * they take turns in it, see AcceptlistScheduler.
  *
  * There is no code for app_id generation. GATT clients use their GATT_IF, and
  * L2CAP layer uses CONN_MGR_ID_L2CAP as fixed app_id. In case any further
@@ -47,6 +48,14 @@ extern void reset(bool after_reset);
 extern void on_app_deregistered(tAPP_ID app_id);
 extern void on_connection_complete(const RawAddress& address);
 
+/* Called on LE disconnection. Returns false if the device waits for a slot in
+ * the acceptlist, and must not be added back to it */
+extern bool on_disconnected(const RawAddress& address);
+
+/* Called on every advertising report, devices waiting for a slot in the
+ * acceptlist get one sooner when they are nearby */
+extern void on_advertising_seen(const RawAddress& address);
+
 extern std::set<tAPP_ID> get_apps_connecting_to(const RawAddress& remote_bda);
 
 extern bool direct_connect_add(tAPP_ID app_id, const RawAddress& address);
@@ -28,16 +28,19 @@
 #include <base/strings/string_number_conversions.h>
 #include <stdio.h>
 #include "bt_common.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "gatt_api.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
 #include "main/shim/dumpsys.h"
 #include "osi/include/log.h"
+#include "stack/eatt/eatt.h"
 #include "stack/gatt/connection_manager.h"
 #include "types/bt_transport.h"
 
 using bluetooth::Uuid;
+using bluetooth::eatt::EattExtension;
 
 extern bool BTM_BackgroundConnectAddressKnown(const RawAddress& address);
 /**
@@ -143,7 +146,8 @@ static void gatt_update_last_srv_info() {
 
 /** Update database hash and client status */
 static void gatt_update_for_database_change() {
-  gatt_cb.database_hash = gatts_calculate_database_hash(gatt_cb.srv_list_info);
+  /* the hash is computed again when it is needed */
+  gatt_cb.database_hash_valid = false;
 
   uint8_t i = 0;
   for (i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
@@ -315,6 +319,7 @@ tGATT_STATUS GATTS_AddService(tGATT_IF gatt_if, btgatt_db_element_t* service,
     elem.sdp_handle = 0;
   }
 
+  gatt_sr_index_service(rit);
   gatt_update_last_srv_info();
 
   VLOG(1) << __func__ << ": allocated el s_hdl=" << loghex(elem.s_hdl)
@@ -415,6 +420,7 @@ void GATTS_StopService(uint16_t service_handle) {
     SDP_DeleteRecord(it->sdp_handle);
   }
 
+  gatt_sr_unindex_service(it);
   gatt_cb.srv_list_info->erase(it);
   gatt_update_last_srv_info();
 }
@@ -536,6 +542,178 @@ tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
   return cmd_sent;
 }
 
+/** Send the notifications held for the coalescing window of a connection */
+static void gatt_send_pending_notif(void* data) {
+  tGATT_TCB& tcb = *(tGATT_TCB*)data;
+  bool multi = gatt_sr_is_cl_multi_notif_supported(tcb);
+
+  for (const auto& bearer : tcb.pending_notif) {
+    uint16_t cid = bearer.first;
+    uint16_t payload_size = gatt_tcb_get_payload_size_tx(tcb, cid);
+    const std::map<uint16_t, std::vector<uint8_t>>& values = bearer.second;
+
+    auto it = values.cbegin();
+    while (it != values.cend()) {
+      BT_HDR* p_buf;
+      if (multi) {
+        p_buf = attp_build_multi_notif_msg(payload_size, &it, values.cend());
+      } else {
+        p_buf = attp_build_notif_msg(payload_size, it->first,
+                                     it->second.size(),
+                                     const_cast<uint8_t*>(it->second.data()));
+        it++;
+      }
+
+      tGATT_STATUS status = attp_send_sr_msg(tcb, cid, p_buf);
+      if (status != GATT_SUCCESS && status != GATT_CONGESTED) {
+        LOG(WARNING) << __func__ << ": notification to " << tcb.peer_bda
+                     << " not sent, status=" << loghex(status);
+      }
+    }
+  }
+  tcb.pending_notif.clear();
+}
+
+/** Hold a notification until the end of the coalescing window */
+static void gatt_queue_notif(tGATT_TCB& tcb, uint16_t cid,
+                             uint16_t attr_handle, uint16_t val_len,
+                             uint8_t* p_val) {
+  tcb.pending_notif[cid][attr_handle].assign(p_val, p_val + val_len);
+
+  if (tcb.notif_timer == nullptr) {
+    tcb.notif_timer = alarm_new("gatt.notif_timer");
+  }
+  if (!alarm_is_scheduled(tcb.notif_timer)) {
+    alarm_set_on_mloop(tcb.notif_timer, gatt_cb.notif_coalesce_ms,
+                       gatt_send_pending_notif, &tcb);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueNotificationFanOut
+ *
+ * Description      This function sends one handle value notification to
+ *                  several clients.
+ *
+ * Returns          GATT_SUCCESS if sent or queued to every client; otherwise
+ *                  the error code of the last client that failed.
+ *
+ ******************************************************************************/
+tGATT_STATUS GATTS_HandleValueNotificationFanOut(
+    const std::vector<uint16_t>& conn_ids, uint16_t attr_handle,
+    uint16_t val_len, uint8_t* p_val) {
+  VLOG(1) << __func__ << ": attr_handle=" << loghex(attr_handle)
+          << ", clients=" << conn_ids.size();
+
+  if (!GATT_HANDLE_IS_VALID(attr_handle)) {
+    return GATT_ILLEGAL_PARAMETER;
+  }
+
+  tGATT_STATUS status = GATT_SUCCESS;
+  /* PDU built for each payload size, copied to each connection using it */
+  std::map<uint16_t, BT_HDR*> built;
+
+  for (uint16_t conn_id : conn_ids) {
+    tGATT_REG* p_reg = gatt_get_regcb(GATT_GET_GATT_IF(conn_id));
+    tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+    if ((p_reg == NULL) || (p_tcb == NULL)) {
+      LOG(ERROR) << __func__ << ": Unknown conn_id: " << conn_id;
+      status = GATT_INVALID_CONN_ID;
+      continue;
+    }
+
+    uint16_t cid = gatt_tcb_get_att_cid(*p_tcb, p_reg->eatt_support);
+
+    if (gatt_cb.notif_coalesce_ms != 0) {
+      gatt_queue_notif(*p_tcb, cid, attr_handle, val_len, p_val);
+      continue;
+    }
+
+    uint16_t payload_size = gatt_tcb_get_payload_size_tx(*p_tcb, cid);
+    BT_HDR*& p_msg = built[payload_size];
+    if (p_msg == NULL) {
+      p_msg = attp_build_notif_msg(payload_size, attr_handle, val_len, p_val);
+    }
+
+    tGATT_STATUS ret = attp_send_sr_msg(*p_tcb, cid, attp_copy_msg(p_msg));
+    if (ret != GATT_SUCCESS && ret != GATT_CONGESTED) status = ret;
+  }
+
+  for (auto& msg : built) osi_free(msg.second);
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTS_SetNotificationCoalescing
+ *
+ * Description      Set the coalescing window of
+ *                  GATTS_HandleValueNotificationFanOut().
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void GATTS_SetNotificationCoalescing(uint64_t window_ms) {
+  LOG(INFO) << __func__ << ": window_ms=" << window_ms;
+  gatt_cb.notif_coalesce_ms = window_ms;
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTS_SetAttributeCache
+ *
+ * Description      Cache the value of a characteristic or descriptor of a
+ *                  started service in the stack, so that reads of it are
+ *                  answered without a read request to the application.
+ *
+ * Returns          GATT_SUCCESS if the value is cached; otherwise error code.
+ *
+ ******************************************************************************/
+tGATT_STATUS GATTS_SetAttributeCache(uint16_t attr_handle,
+                                     const std::vector<uint8_t>& value,
+                                     uint64_t ttl_ms) {
+  VLOG(1) << __func__ << ": attr_handle=" << loghex(attr_handle)
+          << ", len=" << value.size() << ", ttl_ms=" << ttl_ms;
+
+  const tGATT_ATTR_REF* p_ref = gatt_sr_find_attr_ref(attr_handle);
+  if (p_ref == nullptr) {
+    LOG(ERROR) << __func__ << ": no attribute at " << loghex(attr_handle);
+    return GATT_NOT_FOUND;
+  }
+
+  tGATT_ATTR& attr = *p_ref->p_attr;
+  if ((attr.gatt_type != BTGATT_DB_CHARACTERISTIC &&
+       attr.gatt_type != BTGATT_DB_DESCRIPTOR) ||
+      value.size() > GATT_MAX_ATTR_LEN) {
+    LOG(ERROR) << __func__ << ": can't cache value of " << loghex(attr_handle);
+    return GATT_ILLEGAL_PARAMETER;
+  }
+
+  attr.p_cache.reset(new tGATT_ATTR_CACHE);
+  attr.p_cache->value = value;
+  attr.p_cache->expiry_ms =
+      ttl_ms ? bluetooth::common::time_get_os_boottime_ms() + ttl_ms : 0;
+  return GATT_SUCCESS;
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTS_ClearAttributeCache
+ *
+ * Description      Drop the value cached by GATTS_SetAttributeCache(), reads
+ *                  of the attribute go to the application again.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void GATTS_ClearAttributeCache(uint16_t attr_handle) {
+  VLOG(1) << __func__ << ": attr_handle=" << loghex(attr_handle);
+
+  const tGATT_ATTR_REF* p_ref = gatt_sr_find_attr_ref(attr_handle);
+  if (p_ref != nullptr) p_ref->p_attr->p_cache.reset();
+}
+
 /*******************************************************************************
  *
  * Function         GATTS_SendRsp
@@ -635,13 +813,33 @@ tGATT_STATUS GATTC_ConfigureMTU(uint16_t conn_id, uint16_t mtu) {
 
   /* For this request only ATT CID is valid */
   p_clcb->cid = L2CAP_ATT_CID;
-  p_clcb->p_tcb->payload_size = mtu;
   p_clcb->operation = GATTC_OPTYPE_CONFIG;
+
+  /* The client sends Exchange MTU once per link, the GATT profile usually
+   * does it on connection. Later requests get the MTU it negotiated. */
+  if (p_tcb->mtu_exchanged) {
+    LOG_DEBUG("ATT mtu already exchanged conn_id:%hu mtu:%hu", conn_id,
+              p_tcb->payload_size);
+    gatt_end_operation(p_clcb, GATT_SUCCESS, NULL);
+    return GATT_SUCCESS;
+  }
+  if (p_tcb->p_mtu_clcb != NULL) {
+    LOG_DEBUG("ATT mtu exchange in progress, conn_id:%hu waits", conn_id);
+    return GATT_SUCCESS;
+  }
+
+  p_tcb->payload_size = mtu;
   tGATT_CL_MSG gatt_cl_msg;
   gatt_cl_msg.mtu = mtu;
   LOG_DEBUG("Configuring ATT mtu size conn_id:%hu mtu:%hu", conn_id, mtu);
 
-  return attp_send_cl_msg(*p_clcb->p_tcb, p_clcb, GATT_REQ_MTU, &gatt_cl_msg);
+  tGATT_STATUS status =
+      attp_send_cl_msg(*p_tcb, p_clcb, GATT_REQ_MTU, &gatt_cl_msg);
+  if (status == GATT_SUCCESS || status == GATT_CONGESTED ||
+      status == GATT_CMD_STARTED) {
+    p_tcb->p_mtu_clcb = p_clcb;
+  }
+  return status;
 }
 
 /*******************************************************************************
@@ -704,6 +902,7 @@ tGATT_STATUS GATTC_Discover(uint16_t conn_id, tGATT_DISC_TYPE disc_type,
   p_clcb->s_handle = start_handle;
   p_clcb->e_handle = end_handle;
   p_clcb->uuid = uuid;
+  p_clcb->cid = gatt_tcb_select_cid_for_request(*p_tcb, p_clcb, 0);
 
   LOG(INFO) << __func__ << " conn_id=" << loghex(conn_id)
             << ", disc_type=" << +disc_type
@@ -763,8 +962,6 @@ tGATT_STATUS GATTC_Read(uint16_t conn_id, tGATT_READ_TYPE type,
   p_clcb->op_subtype = type;
   p_clcb->auth_req = p_read->by_handle.auth_req;
   p_clcb->counter = 0;
-  p_clcb->read_req_current_mtu =
-      gatt_tcb_get_payload_size_tx(*p_tcb, p_clcb->cid);
 
   switch (type) {
     case GATT_READ_BY_TYPE:
@@ -796,6 +993,12 @@ tGATT_STATUS GATTC_Read(uint16_t conn_id, tGATT_READ_TYPE type,
       break;
   }
 
+  bool by_handle = type == GATT_READ_BY_HANDLE || type == GATT_READ_PARTIAL;
+  p_clcb->cid = gatt_tcb_select_cid_for_request(
+      *p_tcb, p_clcb, by_handle ? p_clcb->s_handle : 0);
+  p_clcb->read_req_current_mtu =
+      gatt_tcb_get_payload_size_tx(*p_tcb, p_clcb->cid);
+
   /* start security check */
   if (gatt_security_check_start(p_clcb)) p_tcb->pending_enc_clcb.push(p_clcb);
   return GATT_SUCCESS;
@@ -849,6 +1052,11 @@ tGATT_STATUS GATTC_Write(uint16_t conn_id, tGATT_WRITE_TYPE type,
   if (type == GATT_WRITE_PREPARE) {
     p_clcb->start_offset = p_write->offset;
     p->offset = 0;
+  } else {
+    /* Prepared writes stay on the bearer the execute write will use */
+    p_clcb->s_handle = p_write->handle;
+    p_clcb->cid =
+        gatt_tcb_select_cid_for_request(*p_tcb, p_clcb, p_write->handle);
   }
 
   if (gatt_security_check_start(p_clcb)) p_tcb->pending_enc_clcb.push(p_clcb);
@@ -898,6 +1106,44 @@ tGATT_STATUS GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute) {
   return GATT_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         GATTC_GetInFlightDepth
+ *
+ * Description      This function returns the number of client requests sent
+ *                  on the connection's ATT and EATT bearers that still wait
+ *                  for a response, whichever application sent them.
+ *
+ * Parameters       conn_id: connection identifier.
+ *
+ * Returns          Number of requests in flight, 0 if not connected.
+ *
+ ******************************************************************************/
+uint16_t GATTC_GetInFlightDepth(uint16_t conn_id) {
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+  if (p_tcb == NULL) return 0;
+  return gatt_tcb_get_in_flight_depth(*p_tcb);
+}
+
+/*******************************************************************************
+ *
+ * Function         GATTC_GetWriteCmdMaxLen
+ *
+ * Description      This function returns the number of value octets a Write
+ *                  Command can carry on the connection's ATT bearer, which
+ *                  every Write Command is sent on.
+ *
+ * Parameters       conn_id: connection identifier.
+ *
+ * Returns          Maximum value length, 0 if not connected.
+ *
+ ******************************************************************************/
+uint16_t GATTC_GetWriteCmdMaxLen(uint16_t conn_id) {
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+  if (p_tcb == NULL || p_tcb->payload_size <= GATT_HDR_SIZE) return 0;
+  return p_tcb->payload_size - GATT_HDR_SIZE;
+}
+
 /*******************************************************************************
  *
  * Function         GATTC_SendHandleValueConfirm
@@ -1354,3 +1600,32 @@ bool GATT_GetConnIdIfConnected(tGATT_IF gatt_if, const RawAddress& bd_addr,
   VLOG(1) << __func__ << " status= " << +status;
   return status;
 }
+
+/*******************************************************************************
+ *
+ * Function         GATT_Dump
+ *
+ * Description      Dump the bearers and the load of each GATT connection
+ *
+ * Parameters       fd: file descriptor to dump to
+ *
+ * Returns          None.
+ *
+ ******************************************************************************/
+void GATT_Dump(int fd) {
+  dprintf(fd, "\nGATT connections:\n");
+  for (uint8_t i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+    tGATT_TCB& tcb = gatt_cb.tcb[i];
+    if (!tcb.in_use) continue;
+
+    dprintf(fd,
+            "\t * %s: bearers: %d pending requests: %u in flight: %u pending "
+            "indications: %zu\n",
+            tcb.peer_bda.ToString().c_str(), 1 + tcb.eatt,
+            gatt_tcb_get_pending_request_depth(tcb),
+            gatt_tcb_get_in_flight_depth(tcb),
+            fixed_queue_length(tcb.pending_ind_q));
+  }
+
+  EattExtension::GetInstance()->Dump(fd);
+}
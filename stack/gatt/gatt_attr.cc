@@ -838,6 +838,20 @@ static bool gatt_sr_is_cl_robust_caching_supported(tGATT_TCB& tcb) {
   return (tcb.cl_supp_feat & BLE_GATT_CL_SUP_FEAT_CACHING_BITMASK);
 }
 
+/*******************************************************************************
+ *
+ * Function         gatt_sr_is_cl_multi_notif_supported
+ *
+ * Description      Check if the client of the connection accepts Multiple
+ *                  Handle Value Notifications
+ *
+ * Returns          true if enabled by client side, otherwise false
+ *
+ ******************************************************************************/
+bool gatt_sr_is_cl_multi_notif_supported(tGATT_TCB& tcb) {
+  return (tcb.cl_supp_feat & BLE_GATT_CL_SUP_FEAT_MULTI_NOTIF_BITMASK);
+}
+
 /*******************************************************************************
  *
  * Function         gatt_sr_is_cl_change_aware
@@ -871,7 +885,8 @@ void gatt_sr_init_cl_status(tGATT_TCB& tcb) {
 
   if (gatt_sr_is_cl_robust_caching_supported(tcb)) {
     Octet16 stored_hash = btif_storage_get_gatt_cl_db_hash(tcb.peer_bda);
-    tcb.is_robust_cache_change_aware = (stored_hash == gatt_cb.database_hash);
+    tcb.is_robust_cache_change_aware =
+        (stored_hash == gatts_get_database_hash());
   } else {
     // set default value for untrusted device
     tcb.is_robust_cache_change_aware = true;
@@ -898,7 +913,7 @@ void gatt_sr_update_cl_status(tGATT_TCB& tcb, bool chg_aware) {
   // only when client status is changed from change-unaware to change-aware, we
   // can then store database hash into btif_storage
   if (!tcb.is_robust_cache_change_aware && chg_aware) {
-    btif_storage_set_gatt_cl_db_hash(tcb.peer_bda, gatt_cb.database_hash);
+    btif_storage_set_gatt_cl_db_hash(tcb.peer_bda, gatts_get_database_hash());
   }
 
   // only when the status is changed, print the log
@@ -916,7 +931,7 @@ static tGATT_STATUS gatt_sr_read_db_hash(uint16_t conn_id,
   LOG(INFO) << __func__ << ": conn_id=" << loghex(conn_id);
 
   uint8_t* p = p_value->value;
-  Octet16& db_hash = gatt_cb.database_hash;
+  const Octet16& db_hash = gatts_get_database_hash();
   ARRAY_TO_STREAM(p, db_hash.data(), (uint16_t)db_hash.size());
   p_value->len = (uint16_t)db_hash.size();
 
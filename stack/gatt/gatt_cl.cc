@@ -30,6 +30,7 @@
 #include "bt_target.h"
 #include "bt_utils.h"
 #include "gatt_int.h"
+#include "gd/common/trace_ring.h"
 #include "l2c_api.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -192,8 +193,9 @@ void gatt_act_read(tGATT_CLCB* p_clcb, uint16_t offset) {
       break;
 
     case GATT_READ_MULTIPLE:
-      op_code = GATT_REQ_READ_MULTI;
       memcpy(&msg.read_multi, p_clcb->p_attr_buf, sizeof(tGATT_READ_MULTI));
+      op_code = msg.read_multi.variable_len ? GATT_REQ_READ_MULTI_VAR
+                                            : GATT_REQ_READ_MULTI;
       break;
 
     case GATT_READ_INC_SRV_UUID128:
@@ -623,7 +625,13 @@ void gatt_process_prep_write_rsp(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
  ******************************************************************************/
 void gatt_process_notification(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
                                uint16_t len, uint8_t* p_data) {
-  tGATT_VALUE value = {};
+  // The value is parsed straight into the completion data handed to the
+  // clients, and only the received octets of it are written.
+  tGATT_CL_COMPLETE gatt_cl_complete;
+  tGATT_VALUE& value = gatt_cl_complete.att_value;
+  value.conn_id = 0;
+  value.offset = 0;
+  value.auth_req = GATT_AUTH_REQ_NONE;
   tGATT_REG* p_reg;
   uint16_t conn_id;
   tGATT_STATUS encrypt_status = {};
@@ -715,8 +723,7 @@ void gatt_process_notification(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
 
   STREAM_TO_ARRAY(value.value, p, value.len);
 
-  tGATT_CL_COMPLETE gatt_cl_complete;
-  gatt_cl_complete.att_value = value;
+  // The cid shares its storage with value.conn_id, which is not used here.
   gatt_cl_complete.cid = cid;
 
   for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
@@ -752,7 +759,6 @@ void gatt_process_notification(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
     // Accounting
     rem_len -= value.len;
 
-    gatt_cl_complete.att_value = value;
     gatt_cl_complete.cid = cid;
 
     for (i = 0, p_reg = gatt_cb.cl_rcb; i < GATT_MAX_APPS; i++, p_reg++) {
@@ -1192,6 +1198,9 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint16_t cid,
     return;
   }
 
+  bluetooth::common::TraceRing::Record(
+      bluetooth::common::TraceEventId::GATT_RESPONSE, cid, op_code);
+
   uint8_t cmd_code = 0;
   tGATT_CLCB* p_clcb = gatt_cmd_dequeue(tcb, cid, &cmd_code);
   uint8_t rsp_code = gatt_cmd_to_rsp_code(cmd_code);
@@ -30,6 +30,8 @@
 #include <log/log.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include "common/time_util.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
 #include "osi/include/osi.h"
@@ -145,6 +147,31 @@ static tGATT_STATUS gatts_check_attr_readability(const tGATT_ATTR& attr,
   return GATT_SUCCESS;
 }
 
+/**
+ * Answer a read of |attr| from the value the application cached in the stack.
+ * Returns GATT_PENDING when the cached value expired, so that the read goes to
+ * the application.
+ */
+static tGATT_STATUS read_attr_cache(tGATT_ATTR& attr, uint16_t offset,
+                                    uint8_t** p_data, uint16_t mtu,
+                                    uint16_t* p_len) {
+  const tGATT_ATTR_CACHE& cache = *attr.p_cache;
+  if (cache.expiry_ms != 0 &&
+      bluetooth::common::time_get_os_boottime_ms() >= cache.expiry_ms) {
+    VLOG(1) << __func__ << ": cached value of handle " << loghex(attr.handle)
+            << " expired";
+    attr.p_cache.reset();
+    return GATT_PENDING;
+  }
+
+  if (offset > cache.value.size()) return GATT_INVALID_OFFSET;
+
+  *p_len = std::min<size_t>(cache.value.size() - offset, mtu);
+  memcpy(*p_data, cache.value.data() + offset, *p_len);
+  *p_data += *p_len;
+  return GATT_SUCCESS;
+}
+
 /*******************************************************************************
  *
  * Function         read_attr_value
@@ -177,6 +204,11 @@ static tGATT_STATUS read_attr_value(tGATT_ATTR& attr16, uint16_t offset,
                                                      sec_flag, key_size);
   if (status != GATT_SUCCESS) return status;
 
+  if (attr16.p_cache) {
+    status = read_attr_cache(attr16, offset, p_data, mtu, p_len);
+    if (status != GATT_PENDING) return status;
+  }
+
   if (!attr16.uuid.Is16Bit()) {
     /* characteristic description or characteristic value */
     return GATT_PENDING;
@@ -257,10 +289,10 @@ static tGATT_STATUS read_attr_value(tGATT_ATTR& attr16, uint16_t offset,
  *
  * Function         gatts_db_read_attr_value_by_type
  *
- * Description      Query attribute value by attribute type.
+ * Description      Query attribute value by attribute type in the started
+ *                  services, using the attribute type index.
  *
- * Parameter        p_db: pointer to the attribute database.
- *                  p_rsp: Read By type response data.
+ * Parameter        p_rsp: Read By type response data.
  *                  s_handle: starting handle of the range we are looking for.
  *                  e_handle: ending handle of the range we are looking for.
  *                  type: Attribute type.
@@ -272,49 +304,52 @@ static tGATT_STATUS read_attr_value(tGATT_ATTR& attr16, uint16_t offset,
  *
  ******************************************************************************/
 tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
-    BT_HDR* p_rsp, uint16_t s_handle, uint16_t e_handle, const Uuid& type,
-    uint16_t* p_len, tGATT_SEC_FLAG sec_flag, uint8_t key_size,
-    uint32_t trans_id, uint16_t* p_cur_handle) {
+    tGATT_TCB& tcb, uint16_t cid, uint8_t op_code, BT_HDR* p_rsp,
+    uint16_t s_handle, uint16_t e_handle, const Uuid& type, uint16_t* p_len,
+    tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id,
+    uint16_t* p_cur_handle) {
   tGATT_STATUS status = GATT_NOT_FOUND;
   uint16_t len = 0;
   uint8_t* p = (uint8_t*)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
 
-  if (p_db) {
-    for (tGATT_ATTR& attr : p_db->attr_list) {
-      if (attr.handle >= s_handle && type == attr.uuid) {
-        if (*p_len <= 2) {
-          status = GATT_NO_RESOURCES;
-          break;
-        }
+  auto by_type = gatt_cb.attr_by_type.find(type);
+  if (by_type == gatt_cb.attr_by_type.end()) return status;
 
-        UINT16_TO_STREAM(p, attr.handle);
+  const std::vector<uint16_t>& handles = by_type->second;
+  for (auto it = std::lower_bound(handles.begin(), handles.end(), s_handle);
+       it != handles.end() && *it <= e_handle; it++) {
+    tGATT_ATTR& attr = *gatt_cb.attr_by_handle[*it].p_attr;
 
-        status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2),
-                                 &len, sec_flag, key_size);
+    if (*p_len <= 2) {
+      status = GATT_NO_RESOURCES;
+      break;
+    }
 
-        if (status == GATT_PENDING) {
-          status = gatts_send_app_read_request(tcb, cid, op_code, attr.handle,
-                                               0, trans_id, attr.gatt_type);
+    UINT16_TO_STREAM(p, attr.handle);
 
-          /* one callback at a time */
-          break;
-        } else if (status == GATT_SUCCESS) {
-          if (p_rsp->offset == 0) p_rsp->offset = len + 2;
-
-          if (p_rsp->offset == len + 2) {
-            p_rsp->len += (len + 2);
-            *p_len -= (len + 2);
-          } else {
-            LOG(ERROR) << "format mismatch";
-            status = GATT_NO_RESOURCES;
-            break;
-          }
-        } else {
-          *p_cur_handle = attr.handle;
-          break;
-        }
+    status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2), &len,
+                             sec_flag, key_size);
+
+    if (status == GATT_PENDING) {
+      status = gatts_send_app_read_request(tcb, cid, op_code, attr.handle, 0,
+                                           trans_id, attr.gatt_type);
+
+      /* one callback at a time */
+      break;
+    } else if (status == GATT_SUCCESS) {
+      if (p_rsp->offset == 0) p_rsp->offset = len + 2;
+
+      if (p_rsp->offset == len + 2) {
+        p_rsp->len += (len + 2);
+        *p_len -= (len + 2);
+      } else {
+        LOG(ERROR) << "format mismatch";
+        status = GATT_NO_RESOURCES;
+        break;
       }
+    } else {
+      *p_cur_handle = attr.handle;
+      break;
     }
   }
 
@@ -444,14 +479,14 @@ uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
 /* Service Attribute Database Query Utility Functions */
 /******************************************************************************/
 tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle) {
-  if (!p_db) return nullptr;
+  if (!p_db || p_db->attr_list.empty()) return nullptr;
 
-  for (auto& attr : p_db->attr_list) {
-    if (attr.handle == handle) return &attr;
-    if (attr.handle > handle) return nullptr;
-  }
+  /* attributes of a service have consecutive handles */
+  uint16_t first = p_db->attr_list.front().handle;
+  if (handle < first || handle - first >= p_db->attr_list.size())
+    return nullptr;
 
-  return nullptr;
+  return &p_db->attr_list[handle - first];
 }
 
 /*******************************************************************************
@@ -674,6 +709,27 @@ tGATT_STATUS gatts_write_attr_perm_check(tGATT_SVC_DB* p_db, uint8_t op_code,
   return status;
 }
 
+/*******************************************************************************
+ *
+ * Function         gatts_invalidate_attr_cache
+ *
+ * Description      Drop the value cached for an attribute a client is writing,
+ *                  so that following reads go to the application again.
+ *
+ * Parameter        p_db: pointer to the attribute database.
+ *                  handle: handle of the attribute written.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatts_invalidate_attr_cache(tGATT_SVC_DB* p_db, uint16_t handle) {
+  tGATT_ATTR* p_attr = find_attr_by_handle(p_db, handle);
+  if (!p_attr || !p_attr->p_cache) return;
+
+  VLOG(1) << __func__ << ": handle=" << loghex(handle);
+  p_attr->p_cache.reset();
+}
+
 /**
  * Description      Allocate a memory space for a new attribute, and link this
  *                  attribute into the database attribute list.
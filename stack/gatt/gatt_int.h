@@ -30,6 +30,8 @@
 #include <base/strings/stringprintf.h>
 #include <string.h>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -163,10 +165,19 @@ typedef union {
 #define GATT_ATTR_UUID_TYPE_32 2
 typedef uint8_t tGATT_ATTR_UUID_TYPE;
 
+/* Value of a characteristic or descriptor that the stack answers reads
+ * with, instead of sending a read request to the application
+*/
+typedef struct {
+  std::vector<uint8_t> value;
+  uint64_t expiry_ms; /* boot time the value expires at, 0 if never */
+} tGATT_ATTR_CACHE;
+
 /* 16 bits UUID Attribute in server database
 */
 typedef struct {
   std::unique_ptr<tGATT_ATTR_VALUE> p_value;
+  std::unique_ptr<tGATT_ATTR_CACHE> p_cache;
   tGATT_PERM permission;
   uint16_t handle;
   bluetooth::Uuid uuid;
@@ -281,8 +292,17 @@ typedef struct {
   uint16_t e_hdl;      /* service ending handle */
   tGATT_IF gatt_if;    /* this service is belong to which application */
   bool is_primary;
+  std::vector<uint8_t> hash_info; /* serialized for the database hash */
 } tGATT_SRV_LIST_ELEM;
 
+/* Entry of the attribute table of the started services. srv is the end of
+ * srv_list_info for handles no started service owns, p_attr is nullptr for
+ * handles a service reserved but did not use */
+typedef struct {
+  std::list<tGATT_SRV_LIST_ELEM>::iterator srv;
+  tGATT_ATTR* p_attr;
+} tGATT_ATTR_REF;
+
 typedef struct {
   std::queue<tGATT_CLCB*> pending_enc_clcb; /* pending encryption channel q */
   tGATT_SEC_ACTION sec_act;
@@ -314,6 +334,17 @@ typedef struct {
   std::queue<tGATT_CMD_Q> cl_cmd_q;
   alarm_t* ind_ack_timer; /* local app confirm to indication timer */
 
+  /* notifications held for the coalescing window, latest value of each
+   * handle, by ATT bearer */
+  std::map<uint16_t, std::map<uint16_t, std::vector<uint8_t>>> pending_notif;
+  alarm_t* notif_timer; /* end of the notification coalescing window */
+
+  /* client Exchange MTU, sent at most once per link */
+  tGATT_CLCB* p_mtu_clcb; /* request in flight, other requests wait on it */
+  bool mtu_exchanged;     /* later requests complete with payload_size */
+  alarm_t* auto_mtu_timer; /* start of the automatic exchange */
+  uint8_t auto_mtu_retry;
+
   // TODO(hylo): support byte array data
   /* Client supported feature*/
   uint8_t cl_supp_feat;
@@ -395,6 +426,11 @@ typedef struct {
   std::list<tGATT_HDL_LIST_ELEM>* hdl_list_info;
   std::list<tGATT_SRV_LIST_ELEM>* srv_list_info;
 
+  /* Attributes of the started services indexed by handle, and the sorted
+   * handles of the attributes of each type. Follow srv_list_info */
+  std::vector<tGATT_ATTR_REF> attr_by_handle;
+  std::unordered_map<bluetooth::Uuid, std::vector<uint16_t>> attr_by_type;
+
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
   tGATT_CLCB clcb[GATT_CL_MAX_LCB]; /* connection link control block*/
@@ -420,8 +456,16 @@ typedef struct {
    */
   uint8_t gatt_cl_supported_feat_mask;
 
+  /* notifications fanned out by GATTS_HandleValueNotificationFanOut() are
+   * coalesced for that long, 0 to send them right away */
+  uint64_t notif_coalesce_ms;
+
+  /* exchange the largest ATT MTU as soon as an LE link opens */
+  bool auto_mtu_enabled;
+
   uint16_t handle_of_database_hash;
-  Octet16 database_hash;
+  Octet16 database_hash; /* use gatts_get_database_hash() */
+  bool database_hash_valid; /* false when services changed since computed */
 
   tGATT_APPL_INFO cb_info;
 
@@ -468,6 +512,7 @@ extern bool gatt_cl_read_sr_supp_feat_req(
     base::OnceCallback<void(const RawAddress&, uint8_t)> cb);
 
 extern bool gatt_sr_is_cl_change_aware(tGATT_TCB& tcb);
+extern bool gatt_sr_is_cl_multi_notif_supported(tGATT_TCB& tcb);
 extern void gatt_sr_init_cl_status(tGATT_TCB& tcb);
 extern void gatt_sr_update_cl_status(tGATT_TCB& tcb, bool chg_unaware);
 
@@ -477,6 +522,13 @@ extern tGATT_STATUS attp_send_cl_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
                                      uint8_t op_code, tGATT_CL_MSG* p_msg);
 extern BT_HDR* attp_build_sr_msg(tGATT_TCB& tcb, uint8_t op_code,
                                  tGATT_SR_MSG* p_msg);
+extern BT_HDR* attp_build_notif_msg(uint16_t payload_size, uint16_t handle,
+                                    uint16_t len, uint8_t* p_data);
+extern BT_HDR* attp_build_multi_notif_msg(
+    uint16_t payload_size,
+    std::map<uint16_t, std::vector<uint8_t>>::const_iterator* p_it,
+    std::map<uint16_t, std::vector<uint8_t>>::const_iterator end);
+extern BT_HDR* attp_copy_msg(const BT_HDR* p_msg);
 extern tGATT_STATUS attp_send_sr_msg(tGATT_TCB& tcb, uint16_t cid,
                                      BT_HDR* p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, uint16_t cid,
@@ -534,6 +586,11 @@ extern bool gatt_auto_connect_dev_remove(tGATT_IF gatt_if,
 /* server function */
 extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle);
+extern void gatt_sr_index_service(std::list<tGATT_SRV_LIST_ELEM>::iterator it);
+extern void gatt_sr_unindex_service(
+    std::list<tGATT_SRV_LIST_ELEM>::iterator it);
+extern const tGATT_ATTR_REF* gatt_sr_find_attr_ref(uint16_t handle);
+extern void gatt_sr_clear_attr_index();
 extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
@@ -563,6 +620,11 @@ extern bool gatt_tcb_get_cid_available_for_indication(
 extern bool gatt_tcb_find_indicate_handle(tGATT_TCB& tcb, uint16_t cid,
                                           uint16_t* indicated_handle_p);
 extern uint16_t gatt_tcb_get_att_cid(tGATT_TCB& tcb, bool eatt_support);
+extern uint16_t gatt_tcb_select_cid_for_request(tGATT_TCB& tcb,
+                                                tGATT_CLCB* p_clcb,
+                                                uint16_t handle);
+extern uint16_t gatt_tcb_get_in_flight_depth(tGATT_TCB& tcb);
+extern uint16_t gatt_tcb_get_pending_request_depth(tGATT_TCB& tcb);
 extern uint16_t gatt_tcb_get_payload_size_tx(tGATT_TCB& tcb, uint16_t cid);
 extern uint16_t gatt_tcb_get_payload_size_rx(tGATT_TCB& tcb, uint16_t cid);
 extern void gatt_clcb_dealloc(tGATT_CLCB* p_clcb);
@@ -603,6 +665,7 @@ extern void gatt_cleanup_upon_disc(const RawAddress& bda,
                                    tBT_TRANSPORT transport);
 extern void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status,
                                void* p_data);
+extern void gatt_mtu_exchange_done(tGATT_TCB& tcb, tGATT_STATUS status);
 
 extern void gatt_act_discovery(tGATT_CLCB* p_clcb);
 extern void gatt_act_read(tGATT_CLCB* p_clcb, uint16_t offset);
@@ -639,10 +702,10 @@ extern uint16_t gatts_add_char_ext_prop_descr(tGATT_SVC_DB& db,
 extern uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
                                      const bluetooth::Uuid& dscp_uuid);
 extern tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
-    BT_HDR* p_rsp, uint16_t s_handle, uint16_t e_handle,
-    const bluetooth::Uuid& type, uint16_t* p_len, tGATT_SEC_FLAG sec_flag,
-    uint8_t key_size, uint32_t trans_id, uint16_t* p_cur_handle);
+    tGATT_TCB& tcb, uint16_t cid, uint8_t op_code, BT_HDR* p_rsp,
+    uint16_t s_handle, uint16_t e_handle, const bluetooth::Uuid& type,
+    uint16_t* p_len, tGATT_SEC_FLAG sec_flag, uint8_t key_size,
+    uint32_t trans_id, uint16_t* p_cur_handle);
 extern tGATT_STATUS gatts_read_attr_value_by_handle(
     tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
     uint16_t handle, uint16_t offset, uint8_t* p_value, uint16_t* p_len,
@@ -650,6 +713,8 @@ extern tGATT_STATUS gatts_read_attr_value_by_handle(
 extern tGATT_STATUS gatts_write_attr_perm_check(
     tGATT_SVC_DB* p_db, uint8_t op_code, uint16_t handle, uint16_t offset,
     uint8_t* p_data, uint16_t len, tGATT_SEC_FLAG sec_flag, uint8_t key_size);
+extern void gatts_invalidate_attr_cache(tGATT_SVC_DB* p_db, uint16_t handle);
+extern tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle);
 extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                uint16_t handle,
                                                tGATT_SEC_FLAG sec_flag,
@@ -659,5 +724,6 @@ extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
 /* gatt_sr_hash.cc */
 extern Octet16 gatts_calculate_database_hash(
     std::list<tGATT_SRV_LIST_ELEM>* lst_ptr);
+extern const Octet16& gatts_get_database_hash();
 
 #endif
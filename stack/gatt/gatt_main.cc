@@ -27,10 +27,13 @@
 #include "bt_common.h"
 #include "bt_utils.h"
 #include "btif/include/btif_storage.h"
+#include "common/lru.h"
 #include "connection_manager.h"
 #include "device/include/interop.h"
 #include "l2c_api.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "stack/btm/btm_ble_int.h"
 #include "stack/btm/btm_dev.h"
 #include "stack/btm/btm_sec.h"
@@ -84,6 +87,23 @@ static const tL2CAP_APPL_INFO dyn_info = {
 
 tGATT_CB gatt_cb;
 
+namespace {
+
+/* Outcome of the last Exchange MTU with recent peers: the negotiated MTU, or
+ * 0 for peers that do not support the request */
+constexpr size_t kPeerMtuCacheSize = 32;
+bluetooth::common::LegacyLruCache<RawAddress, uint16_t> peer_mtu_cache(
+    kPeerMtuCacheSize, "gatt_peer_mtu");
+
+/* The automatic exchange with a peer not in the cache waits that long, so
+ * that the peer or a local app can go first */
+constexpr uint64_t kAutoMtuDelayMs = 200;
+/* and is retried that often while the GATT client is busy on the link */
+constexpr uint64_t kAutoMtuRetryMs = 500;
+constexpr uint8_t kAutoMtuMaxRetry = 10;
+
+}  // namespace
+
 /*******************************************************************************
  *
  * Function         gatt_init
@@ -101,6 +121,9 @@ void gatt_init(void) {
 
   gatt_cb = tGATT_CB();
   connection_manager::reset(true);
+  gatt_cb.auto_mtu_enabled =
+      osi_property_get_bool("persist.bluetooth.gatt.auto_mtu", true);
+  peer_mtu_cache.Clear();
   memset(&fixed_reg, 0, sizeof(tL2CAP_FIXED_CHNL_REG));
 
   gatt_cb.sign_op_queue = fixed_queue_new(SIZE_MAX);
@@ -159,6 +182,12 @@ void gatt_free(void) {
     alarm_free(gatt_cb.tcb[i].ind_ack_timer);
     gatt_cb.tcb[i].ind_ack_timer = NULL;
 
+    alarm_free(gatt_cb.tcb[i].notif_timer);
+    gatt_cb.tcb[i].notif_timer = NULL;
+
+    alarm_free(gatt_cb.tcb[i].auto_mtu_timer);
+    gatt_cb.tcb[i].auto_mtu_timer = NULL;
+
     fixed_queue_free(gatt_cb.tcb[i].sr_cmd.multi_rsp_q, NULL);
     gatt_cb.tcb[i].sr_cmd.multi_rsp_q = NULL;
 
@@ -166,6 +195,7 @@ void gatt_free(void) {
       EattExtension::GetInstance()->FreeGattResources(gatt_cb.tcb[i].peer_bda);
   }
 
+  gatt_sr_clear_attr_index();
   gatt_cb.hdl_list_info->clear();
   delete gatt_cb.hdl_list_info;
   gatt_cb.hdl_list_info = nullptr;
@@ -410,6 +440,70 @@ void on_connection_timed_out(uint8_t app_id, const RawAddress& address) {
 }
 }  // namespace connection_manager
 
+/** Sends the Exchange MTU request of the GATT profile, unless the link
+ * already has an MTU above the default */
+static void gatt_auto_mtu_timeout(void* data) {
+  tGATT_TCB* p_tcb = (tGATT_TCB*)data;
+
+  if (gatt_get_ch_state(p_tcb) != GATT_CH_OPEN || p_tcb->mtu_exchanged ||
+      p_tcb->p_mtu_clcb != NULL ||
+      p_tcb->payload_size > GATT_DEF_BLE_MTU_SIZE) {
+    return;
+  }
+
+  uint16_t conn_id = GATT_CREATE_CONN_ID(p_tcb->tcb_idx, gatt_cb.gatt_if);
+  tGATT_STATUS status = GATTC_ConfigureMTU(conn_id, GATT_MAX_MTU_SIZE);
+  if (status == GATT_BUSY && ++p_tcb->auto_mtu_retry < kAutoMtuMaxRetry) {
+    alarm_set_on_mloop(p_tcb->auto_mtu_timer, kAutoMtuRetryMs,
+                       gatt_auto_mtu_timeout, p_tcb);
+    return;
+  }
+  if (status != GATT_SUCCESS && status != GATT_CMD_STARTED &&
+      status != GATT_CONGESTED) {
+    LOG_WARN("Unable to exchange ATT mtu with %s status:%d",
+             PRIVATE_ADDRESS(p_tcb->peer_bda), status);
+  }
+}
+
+/** Schedules the Exchange MTU request of the GATT profile on a new LE link.
+ * Peers known to reject it are skipped, peers known to accept it get the
+ * matching data length right away and the request without delay. */
+static void gatt_auto_mtu_start(tGATT_TCB* p_tcb) {
+  if (!gatt_cb.auto_mtu_enabled) return;
+
+  uint16_t mtu = 0;
+  bool known = peer_mtu_cache.Get(p_tcb->peer_bda, &mtu);
+  if (known && mtu == 0) {
+    LOG_DEBUG("Peer %s does not support ATT mtu exchange",
+              PRIVATE_ADDRESS(p_tcb->peer_bda));
+    return;
+  }
+  if (known) BTM_SetBleDataLength(p_tcb->peer_bda, mtu + L2CAP_PKT_OVERHEAD);
+
+  if (p_tcb->auto_mtu_timer == NULL) {
+    p_tcb->auto_mtu_timer = alarm_new("gatt.auto_mtu_timer");
+  }
+  p_tcb->auto_mtu_retry = 0;
+  alarm_set_on_mloop(p_tcb->auto_mtu_timer, known ? 0 : kAutoMtuDelayMs,
+                     gatt_auto_mtu_timeout, p_tcb);
+}
+
+/** Called when the Exchange MTU request in flight on |tcb| ends, before its
+ * owner and the requests waiting on it are called back */
+void gatt_mtu_exchange_done(tGATT_TCB& tcb, tGATT_STATUS status) {
+  tcb.p_mtu_clcb = NULL;
+
+  if (status == GATT_SUCCESS) {
+    tcb.mtu_exchanged = true;
+    peer_mtu_cache.Put(tcb.peer_bda, tcb.payload_size);
+  } else if (status == GATT_REQ_NOT_SUPPORTED) {
+    /* the request is not retried on this link nor on the next ones */
+    tcb.mtu_exchanged = true;
+    tcb.payload_size = GATT_DEF_BLE_MTU_SIZE;
+    peer_mtu_cache.Put(tcb.peer_bda, 0);
+  }
+}
+
 /** This callback function is called by L2CAP to indicate that the ATT fixed
  * channel for LE is connected (conn = true)/disconnected (conn = false).
  */
@@ -451,6 +545,7 @@ static void gatt_le_connect_cback(uint16_t chan, const RawAddress& bd_addr,
       p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
 
       gatt_send_conn_cback(p_tcb);
+      gatt_auto_mtu_start(p_tcb);
     }
     if (check_srv_chg) gatt_chk_srv_chg(p_srv_chg_clt);
   }
@@ -470,6 +565,7 @@ static void gatt_le_connect_cback(uint16_t chan, const RawAddress& bd_addr,
     p_tcb->payload_size = GATT_DEF_BLE_MTU_SIZE;
 
     gatt_send_conn_cback(p_tcb);
+    gatt_auto_mtu_start(p_tcb);
     if (check_srv_chg) {
       gatt_chk_srv_chg(p_srv_chg_clt);
     }
@@ -800,6 +896,7 @@ static void gatt_send_conn_cback(tGATT_TCB* p_tcb) {
  *
  ******************************************************************************/
 void gatt_data_process(tGATT_TCB& tcb, uint16_t cid, BT_HDR* p_buf) {
+  AllocationTagScope tag_scope(ALLOCATION_TAG_GATT);
   uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
   uint8_t op_code, pseudo_op_code;
 
@@ -576,52 +576,39 @@ static tGATT_STATUS gatt_build_primary_service_rsp(
  * Returns          true: if data filled sucessfully.
  *                  false: packet full, or format mismatch.
  */
-static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SRV_LIST_ELEM& el,
-                                             BT_HDR* p_msg, uint16_t& len,
-                                             uint16_t s_hdl, uint16_t e_hdl) {
+static tGATT_STATUS gatt_build_find_info_rsp(const tGATT_ATTR& attr,
+                                             BT_HDR* p_msg, uint16_t& len) {
   uint8_t info_pair_len[2] = {4, 18};
 
-  if (!el.p_db) return GATT_NOT_FOUND;
-
-  /* check the attribute database */
-
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-  for (auto& attr : el.p_db->attr_list) {
-    if (attr.handle > e_hdl) break;
-
-    if (attr.handle < s_hdl) continue;
-
-    uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
-    if (p_msg->offset == 0)
-      p_msg->offset = (uuid_len == Uuid::kNumBytes16) ? GATT_INFO_TYPE_PAIR_16
-                                                      : GATT_INFO_TYPE_PAIR_128;
-
-    if (len < info_pair_len[p_msg->offset - 1]) return GATT_NO_RESOURCES;
-
-    if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 &&
-        uuid_len == Uuid::kNumBytes16) {
-      UINT16_TO_STREAM(p, attr.handle);
-      UINT16_TO_STREAM(p, attr.uuid.As16Bit());
-    } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
-               uuid_len == Uuid::kNumBytes128) {
-      UINT16_TO_STREAM(p, attr.handle);
-      ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
-    } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
-               uuid_len == Uuid::kNumBytes32) {
-      UINT16_TO_STREAM(p, attr.handle);
-      ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
-    } else {
-      LOG(ERROR) << "format mismatch";
-      return GATT_NO_RESOURCES;
-      /* format mismatch */
-    }
-    p_msg->len += info_pair_len[p_msg->offset - 1];
-    len -= info_pair_len[p_msg->offset - 1];
-    return GATT_SUCCESS;
+  uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
+  if (p_msg->offset == 0)
+    p_msg->offset = (uuid_len == Uuid::kNumBytes16) ? GATT_INFO_TYPE_PAIR_16
+                                                    : GATT_INFO_TYPE_PAIR_128;
+
+  if (len < info_pair_len[p_msg->offset - 1]) return GATT_NO_RESOURCES;
+
+  if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 &&
+      uuid_len == Uuid::kNumBytes16) {
+    UINT16_TO_STREAM(p, attr.handle);
+    UINT16_TO_STREAM(p, attr.uuid.As16Bit());
+  } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
+             uuid_len == Uuid::kNumBytes128) {
+    UINT16_TO_STREAM(p, attr.handle);
+    ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
+  } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
+             uuid_len == Uuid::kNumBytes32) {
+    UINT16_TO_STREAM(p, attr.handle);
+    ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
+  } else {
+    LOG(ERROR) << "format mismatch";
+    return GATT_NO_RESOURCES;
+    /* format mismatch */
   }
-
-  return GATT_NOT_FOUND;
+  p_msg->len += info_pair_len[p_msg->offset - 1];
+  len -= info_pair_len[p_msg->offset - 1];
+  return GATT_SUCCESS;
 }
 
 static tGATT_STATUS read_handles(uint16_t& len, uint8_t*& p, uint16_t& s_hdl,
@@ -759,14 +746,23 @@ static void gatts_process_find_info(tGATT_TCB& tcb, uint16_t cid,
 
   buf_len = payload_size - 2;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      reason = gatt_build_find_info_rsp(el, p_msg, buf_len, s_hdl, e_hdl);
-      if (reason == GATT_NO_RESOURCES) {
-        reason = GATT_SUCCESS;
-        break;
-      }
+  /* the first attribute in range of each service, found in the attribute
+   * table, goes in the response */
+  uint32_t handle = s_hdl;
+  while (handle <= e_hdl && handle < gatt_cb.attr_by_handle.size()) {
+    const tGATT_ATTR_REF& ref = gatt_cb.attr_by_handle[handle];
+    if (ref.srv == gatt_cb.srv_list_info->end()) {
+      handle++;
+      continue;
     }
+
+    reason = ref.p_attr ? gatt_build_find_info_rsp(*ref.p_attr, p_msg, buf_len)
+                        : GATT_NOT_FOUND;
+    if (reason == GATT_NO_RESOURCES) {
+      reason = GATT_SUCCESS;
+      break;
+    }
+    handle = ref.srv->e_hdl + 1;
   }
 
   *p = (uint8_t)p_msg->offset;
@@ -889,25 +885,16 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t cid,
   p_msg->len = 2;
   uint16_t buf_len = payload_size - 2;
 
-  reason = GATT_NOT_FOUND;
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      uint8_t sec_flag, key_size;
-      gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
-
-      tGATT_STATUS ret = gatts_db_read_attr_value_by_type(
-          tcb, cid, el.p_db, op_code, p_msg, s_hdl, e_hdl, uuid, &buf_len,
-          sec_flag, key_size, 0, &err_hdl);
-      if (ret != GATT_NOT_FOUND) {
-        reason = ret;
-        if (ret == GATT_NO_RESOURCES) reason = GATT_SUCCESS;
-      }
+  uint8_t sec_flag, key_size;
+  gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
 
-      if (ret != GATT_SUCCESS && ret != GATT_NOT_FOUND) {
-        s_hdl = err_hdl;
-        break;
-      }
-    }
+  reason = gatts_db_read_attr_value_by_type(tcb, cid, op_code, p_msg, s_hdl,
+                                            e_hdl, uuid, &buf_len, sec_flag,
+                                            key_size, 0, &err_hdl);
+  if (reason == GATT_NO_RESOURCES) {
+    reason = GATT_SUCCESS;
+  } else if (reason != GATT_SUCCESS && reason != GATT_NOT_FOUND) {
+    s_hdl = err_hdl;
   }
   *p = (uint8_t)p_msg->offset;
   p_msg->offset = L2CAP_MIN_OFFSET;
@@ -981,6 +968,9 @@ static void gatts_process_write_req(tGATT_TCB& tcb, uint16_t cid,
                                        sec_flag, key_size);
 
   if (status == GATT_SUCCESS) {
+    /* the application owns the new value, stop answering reads from cache */
+    gatts_invalidate_attr_cache(el.p_db, handle);
+
     trans_id = gatt_sr_enqueue_cmd(tcb, cid, op_code, handle);
     if (trans_id != 0) {
       conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, el.gatt_if);
@@ -1106,34 +1096,28 @@ void gatts_process_attribute_req(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
   }
 #endif
 
-  if (GATT_HANDLE_IS_VALID(handle)) {
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        for (const auto& attr : el.p_db->attr_list) {
-          if (attr.handle == handle) {
-            switch (op_code) {
-              case GATT_REQ_READ: /* read char/char descriptor value */
-              case GATT_REQ_READ_BLOB:
-                gatts_process_read_req(tcb, cid, el, op_code, handle, len, p);
-                break;
-
-              case GATT_REQ_WRITE: /* write char/char descriptor value */
-              case GATT_CMD_WRITE:
-              case GATT_SIGN_CMD_WRITE:
-              case GATT_REQ_PREPARE_WRITE:
-                gatts_process_write_req(tcb, cid, el, handle, op_code, len, p,
-                                        attr.gatt_type);
-                break;
-              default:
-                break;
-            }
-            status = GATT_SUCCESS;
-            break;
-          }
-        }
+  const tGATT_ATTR_REF* ref = nullptr;
+  if (GATT_HANDLE_IS_VALID(handle)) ref = gatt_sr_find_attr_ref(handle);
+
+  if (ref) {
+    tGATT_SRV_LIST_ELEM& el = *ref->srv;
+    switch (op_code) {
+      case GATT_REQ_READ: /* read char/char descriptor value */
+      case GATT_REQ_READ_BLOB:
+        gatts_process_read_req(tcb, cid, el, op_code, handle, len, p);
+        break;
+
+      case GATT_REQ_WRITE: /* write char/char descriptor value */
+      case GATT_CMD_WRITE:
+      case GATT_SIGN_CMD_WRITE:
+      case GATT_REQ_PREPARE_WRITE:
+        gatts_process_write_req(tcb, cid, el, handle, op_code, len, p,
+                                ref->p_attr->gatt_type);
+        break;
+      default:
         break;
-      }
     }
+    status = GATT_SUCCESS;
   }
 
   if (status != GATT_SUCCESS && op_code != GATT_CMD_WRITE &&
@@ -24,101 +24,111 @@
 
 using bluetooth::Uuid;
 
-static size_t calculate_database_info_size(std::list<tGATT_SRV_LIST_ELEM>* lst_ptr) {
+static size_t calculate_service_info_size(const tGATT_SRV_LIST_ELEM& el) {
   size_t len = 0;
-  auto srv_it = lst_ptr->begin();
-  for (; srv_it != lst_ptr->end(); srv_it++) {
-    auto attr_list = &srv_it->p_db->attr_list;
-    auto attr_it = attr_list->begin();
-    for (; attr_it != attr_list->end(); attr_it++) {
-      if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_PRI_SERVICE) ||
-          attr_it->uuid == Uuid::From16Bit(GATT_UUID_SEC_SERVICE)) {
-        // Service declaration (Handle + Type + Value)
-        len += 4 + gatt_build_uuid_to_stream_len(attr_it->p_value->uuid);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE)){
-        // Included service declaration (Handle + Type + Value)
-        len += 8 + gatt_build_uuid_to_stream_len(attr_it->p_value->incl_handle.service_type);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DECLARE)) {
-        // Characteristic declaration (Handle + Type + Value)
-        len += 7 + gatt_build_uuid_to_stream_len((++attr_it)->uuid);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DESCRIPTION) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_SRVR_CONFIG) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_PRESENT_FORMAT) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_AGG_FORMAT)) {
-        // Descriptor (Handle + Type)
-        len += 4;
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP)) {
-        // Descriptor for ext property (Handle + Type + Value)
-        len += 6;
-      }
+  auto attr_list = &el.p_db->attr_list;
+  auto attr_it = attr_list->begin();
+  for (; attr_it != attr_list->end(); attr_it++) {
+    if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_PRI_SERVICE) ||
+        attr_it->uuid == Uuid::From16Bit(GATT_UUID_SEC_SERVICE)) {
+      // Service declaration (Handle + Type + Value)
+      len += 4 + gatt_build_uuid_to_stream_len(attr_it->p_value->uuid);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE)){
+      // Included service declaration (Handle + Type + Value)
+      len += 8 + gatt_build_uuid_to_stream_len(attr_it->p_value->incl_handle.service_type);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DECLARE)) {
+      // Characteristic declaration (Handle + Type + Value)
+      len += 7 + gatt_build_uuid_to_stream_len((++attr_it)->uuid);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DESCRIPTION) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_SRVR_CONFIG) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_PRESENT_FORMAT) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_AGG_FORMAT)) {
+      // Descriptor (Handle + Type)
+      len += 4;
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP)) {
+      // Descriptor for ext property (Handle + Type + Value)
+      len += 6;
     }
   }
   return len;
 }
 
-static void fill_database_info(std::list<tGATT_SRV_LIST_ELEM>* lst_ptr, uint8_t* p_data) {
-  auto srv_it = lst_ptr->begin();
-  for (; srv_it != lst_ptr->end(); srv_it++) {
-    auto attr_list = &srv_it->p_db->attr_list;
-    auto attr_it = attr_list->begin();
-    for (; attr_it != attr_list->end(); attr_it++) {
-      if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_PRI_SERVICE) ||
-          attr_it->uuid == Uuid::From16Bit(GATT_UUID_SEC_SERVICE)) {
-        // Service declaration
-        UINT16_TO_STREAM(p_data, attr_it->handle);
+static void fill_service_info(const tGATT_SRV_LIST_ELEM& el, uint8_t* p_data) {
+  auto attr_list = &el.p_db->attr_list;
+  auto attr_it = attr_list->begin();
+  for (; attr_it != attr_list->end(); attr_it++) {
+    if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_PRI_SERVICE) ||
+        attr_it->uuid == Uuid::From16Bit(GATT_UUID_SEC_SERVICE)) {
+      // Service declaration
+      UINT16_TO_STREAM(p_data, attr_it->handle);
 
-        if (srv_it->is_primary) {
-          UINT16_TO_STREAM(p_data, GATT_UUID_PRI_SERVICE);
-        } else {
-          UINT16_TO_STREAM(p_data, GATT_UUID_SEC_SERVICE);
-        }
+      if (el.is_primary) {
+        UINT16_TO_STREAM(p_data, GATT_UUID_PRI_SERVICE);
+      } else {
+        UINT16_TO_STREAM(p_data, GATT_UUID_SEC_SERVICE);
+      }
 
-        gatt_build_uuid_to_stream(&p_data, attr_it->p_value->uuid);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE)){
-        // Included service declaration
-        UINT16_TO_STREAM(p_data, attr_it->handle);
-        UINT16_TO_STREAM(p_data, GATT_UUID_INCLUDE_SERVICE);
-        UINT16_TO_STREAM(p_data, attr_it->p_value->incl_handle.s_handle);
-        UINT16_TO_STREAM(p_data, attr_it->p_value->incl_handle.e_handle);
+      gatt_build_uuid_to_stream(&p_data, attr_it->p_value->uuid);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_INCLUDE_SERVICE)){
+      // Included service declaration
+      UINT16_TO_STREAM(p_data, attr_it->handle);
+      UINT16_TO_STREAM(p_data, GATT_UUID_INCLUDE_SERVICE);
+      UINT16_TO_STREAM(p_data, attr_it->p_value->incl_handle.s_handle);
+      UINT16_TO_STREAM(p_data, attr_it->p_value->incl_handle.e_handle);
 
-        gatt_build_uuid_to_stream(&p_data, attr_it->p_value->incl_handle.service_type);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DECLARE)) {
-        // Characteristic declaration
-        UINT16_TO_STREAM(p_data, attr_it->handle);
-        UINT16_TO_STREAM(p_data, GATT_UUID_CHAR_DECLARE);
-        UINT8_TO_STREAM(p_data, attr_it->p_value->char_decl.property);
-        UINT16_TO_STREAM(p_data, attr_it->p_value->char_decl.char_val_handle);
+      gatt_build_uuid_to_stream(&p_data, attr_it->p_value->incl_handle.service_type);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DECLARE)) {
+      // Characteristic declaration
+      UINT16_TO_STREAM(p_data, attr_it->handle);
+      UINT16_TO_STREAM(p_data, GATT_UUID_CHAR_DECLARE);
+      UINT8_TO_STREAM(p_data, attr_it->p_value->char_decl.property);
+      UINT16_TO_STREAM(p_data, attr_it->p_value->char_decl.char_val_handle);
 
-        // Increment 1 to fetch characteristic uuid from value declaration attribute
-        gatt_build_uuid_to_stream(&p_data, (++attr_it)->uuid);
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DESCRIPTION) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_SRVR_CONFIG) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_PRESENT_FORMAT) ||
-                 attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_AGG_FORMAT)) {
-        // Descriptor
-        UINT16_TO_STREAM(p_data, attr_it->handle);
-        UINT16_TO_STREAM(p_data, attr_it->uuid.As16Bit());
-      } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP)) {
-        // Descriptor
-        UINT16_TO_STREAM(p_data, attr_it->handle);
-        UINT16_TO_STREAM(p_data, attr_it->uuid.As16Bit());
-        UINT16_TO_STREAM(p_data, attr_it->p_value
-                                     ? attr_it->p_value->char_ext_prop
-                                     : 0x0000);
-      }
+      // Increment 1 to fetch characteristic uuid from value declaration attribute
+      gatt_build_uuid_to_stream(&p_data, (++attr_it)->uuid);
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_DESCRIPTION) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_SRVR_CONFIG) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_PRESENT_FORMAT) ||
+               attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_AGG_FORMAT)) {
+      // Descriptor
+      UINT16_TO_STREAM(p_data, attr_it->handle);
+      UINT16_TO_STREAM(p_data, attr_it->uuid.As16Bit());
+    } else if (attr_it->uuid == Uuid::From16Bit(GATT_UUID_CHAR_EXT_PROP)) {
+      // Descriptor
+      UINT16_TO_STREAM(p_data, attr_it->handle);
+      UINT16_TO_STREAM(p_data, attr_it->uuid.As16Bit());
+      UINT16_TO_STREAM(p_data, attr_it->p_value
+                                   ? attr_it->p_value->char_ext_prop
+                                   : 0x0000);
     }
   }
 }
 
+// A started service doesn't change, so its part of the hashed data is
+// serialized once and kept with the service
+static const std::vector<uint8_t>& get_service_info(tGATT_SRV_LIST_ELEM& el) {
+  if (el.hash_info.empty()) {
+    el.hash_info.resize(calculate_service_info_size(el));
+    fill_service_info(el, el.hash_info.data());
+  }
+  return el.hash_info;
+}
+
 Octet16 gatts_calculate_database_hash(std::list<tGATT_SRV_LIST_ELEM>* lst_ptr) {
-  int len = calculate_database_info_size(lst_ptr);
+  size_t len = 0;
+  for (tGATT_SRV_LIST_ELEM& el : *lst_ptr) len += get_service_info(el).size();
 
-  std::vector<uint8_t> serialized(len);
-  fill_database_info(lst_ptr, serialized.data());
+  // The hash is computed over the data in reverse order, build it from the
+  // last service to the first
+  std::vector<uint8_t> serialized;
+  serialized.reserve(len);
+  for (auto srv_it = lst_ptr->rbegin(); srv_it != lst_ptr->rend(); srv_it++) {
+    const std::vector<uint8_t>& info = srv_it->hash_info;
+    serialized.insert(serialized.end(), info.rbegin(), info.rend());
+  }
 
-  std::reverse(serialized.begin(), serialized.end());
   Octet16 db_hash = crypto_toolbox::aes_cmac(Octet16{0}, serialized.data(),
                                   serialized.size());
   LOG(INFO) << __func__ << ": hash="
@@ -126,3 +136,12 @@ Octet16 gatts_calculate_database_hash(std::list<tGATT_SRV_LIST_ELEM>* lst_ptr) {
 
   return db_hash;
 }
+
+const Octet16& gatts_get_database_hash() {
+  if (!gatt_cb.database_hash_valid) {
+    gatt_cb.database_hash =
+        gatts_calculate_database_hash(gatt_cb.srv_list_info);
+    gatt_cb.database_hash_valid = true;
+  }
+  return gatt_cb.database_hash;
+}
@@ -22,7 +22,11 @@
  *
  ******************************************************************************/
 #include <base/strings/stringprintf.h>
+#include <algorithm>
 #include <cstdint>
+#include <map>
+#include <queue>
+#include <set>
 
 #include "bt_target.h"  // Must be first to define build configuration
 
@@ -167,6 +171,10 @@ void gatt_add_pending_ind(tGATT_TCB* p_tcb, tGATT_VALUE* p_ind) {
   tGATT_VALUE* p_buf = (tGATT_VALUE*)osi_malloc(sizeof(tGATT_VALUE));
   memcpy(p_buf, p_ind, sizeof(tGATT_VALUE));
   fixed_queue_enqueue(p_tcb->pending_ind_q, p_buf);
+
+  EattExtension::GetInstance()->ReportGattLoad(
+      p_tcb->peer_bda, gatt_tcb_get_pending_request_depth(*p_tcb),
+      fixed_queue_length(p_tcb->pending_ind_q));
 }
 
 /*******************************************************************************
@@ -725,21 +733,104 @@ void  gatt_ind_ack_timeout(void* data) {
  *
  * Description      Search for a service that owns a specific handle.
  *
- * Returns          GATT_MAX_SR_PROFILES if not found. Otherwise the index of
- *                  the service.
+ * Returns          end of srv_list_info if not found. Otherwise the service.
  *
  ******************************************************************************/
 std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle) {
-  auto it = gatt_cb.srv_list_info->begin();
+  if (handle >= gatt_cb.attr_by_handle.size()) {
+    return gatt_cb.srv_list_info->end();
+  }
 
-  for (; it != gatt_cb.srv_list_info->end(); it++) {
-    if (it->s_hdl <= handle && it->e_hdl >= handle) {
-      return it;
+  return gatt_cb.attr_by_handle[handle].srv;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_index_service
+ *
+ * Description      Add the attributes of a started service to the attribute
+ *                  table and to the attribute type index.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_index_service(std::list<tGATT_SRV_LIST_ELEM>::iterator it) {
+  std::vector<tGATT_ATTR_REF>& table = gatt_cb.attr_by_handle;
+  if (table.size() <= it->e_hdl) {
+    table.resize(it->e_hdl + 1, {gatt_cb.srv_list_info->end(), nullptr});
+  }
+
+  for (uint32_t handle = it->s_hdl; handle <= it->e_hdl; handle++) {
+    table[handle] = {it, nullptr};
+  }
+
+  for (tGATT_ATTR& attr : it->p_db->attr_list) {
+    table[attr.handle].p_attr = &attr;
+
+    std::vector<uint16_t>& handles = gatt_cb.attr_by_type[attr.uuid];
+    handles.insert(
+        std::upper_bound(handles.begin(), handles.end(), attr.handle),
+        attr.handle);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_unindex_service
+ *
+ * Description      Remove the attributes of a service that is being stopped
+ *                  from the attribute table and the attribute type index.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_unindex_service(std::list<tGATT_SRV_LIST_ELEM>::iterator it) {
+  for (const tGATT_ATTR& attr : it->p_db->attr_list) {
+    auto type = gatt_cb.attr_by_type.find(attr.uuid);
+    if (type == gatt_cb.attr_by_type.end()) continue;
+
+    std::vector<uint16_t>& handles = type->second;
+    auto pos = std::lower_bound(handles.begin(), handles.end(), attr.handle);
+    if (pos != handles.end() && *pos == attr.handle) handles.erase(pos);
+    if (handles.empty()) gatt_cb.attr_by_type.erase(type);
+  }
+
+  std::vector<tGATT_ATTR_REF>& table = gatt_cb.attr_by_handle;
+  for (uint32_t handle = it->s_hdl;
+       handle <= it->e_hdl && handle < table.size(); handle++) {
+    if (table[handle].srv == it) {
+      table[handle] = {gatt_cb.srv_list_info->end(), nullptr};
     }
   }
 
-  return it;
+  while (!table.empty() && table.back().srv == gatt_cb.srv_list_info->end()) {
+    table.pop_back();
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_find_attr_ref
+ *
+ * Description      Look up a handle in the attribute table of the started
+ *                  services.
+ *
+ * Returns          nullptr if no started service has an attribute at handle.
+ *
+ ******************************************************************************/
+const tGATT_ATTR_REF* gatt_sr_find_attr_ref(uint16_t handle) {
+  if (handle >= gatt_cb.attr_by_handle.size()) return nullptr;
+
+  const tGATT_ATTR_REF& ref = gatt_cb.attr_by_handle[handle];
+  if (ref.p_attr == nullptr) return nullptr;
+  return &ref;
+}
+
+/** Drop the attribute table, when the service list is freed */
+void gatt_sr_clear_attr_index() {
+  gatt_cb.attr_by_handle.clear();
+  gatt_cb.attr_by_type.clear();
 }
 
 /*******************************************************************************
@@ -1106,6 +1197,151 @@ uint16_t gatt_tcb_get_att_cid(tGATT_TCB& tcb, bool eatt_support) {
   return tcb.att_lcid;
 }
 
+/*******************************************************************************
+ *
+ * Function         gatt_clcb_is_handle_request
+ *
+ * Description      The function checks if clcb reads or writes the given
+ *                  attribute by handle
+ *
+ * Returns          true if it does
+ *
+ ******************************************************************************/
+static bool gatt_clcb_is_handle_request(const tGATT_CLCB& clcb,
+                                        uint16_t handle) {
+  if (clcb.s_handle != handle) return false;
+  if (clcb.operation == GATTC_OPTYPE_WRITE) return true;
+  return clcb.operation == GATTC_OPTYPE_READ &&
+         (clcb.op_subtype == GATT_READ_BY_HANDLE ||
+          clcb.op_subtype == GATT_READ_PARTIAL);
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tcb_get_cl_cmd_q
+ *
+ * Description      This function gets the client command queue of a bearer
+ *
+ * Returns          Command queue, nullptr if the bearer is gone
+ *
+ ******************************************************************************/
+static std::queue<tGATT_CMD_Q>* gatt_tcb_get_cl_cmd_q(tGATT_TCB& tcb,
+                                                      uint16_t cid) {
+  if (cid == tcb.att_lcid) return &tcb.cl_cmd_q;
+
+  EattChannel* channel =
+      EattExtension::GetInstance()->FindEattChannelByCid(tcb.peer_bda, cid);
+  if (!channel) return nullptr;
+  return &channel->cl_cmd_q_;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tcb_select_cid_for_request
+ *
+ * Description      This function picks the bearer for a new client request.
+ *                  Responses are only ordered within a bearer, so a request
+ *                  on an attribute that already has one pending queues up
+ *                  behind it on the same bearer. Any other request goes to an
+ *                  idle EATT bearer, then to an idle ATT bearer, and otherwise
+ *                  to the bearer with the fewest requests queued. Write
+ *                  Commands wait for no response, and spreading a stream of
+ *                  them over bearers could reorder it, so they always use the
+ *                  ATT bearer.
+ *
+ * Parameter        handle: attribute read or written, 0 if the request is not
+ *                  for a single attribute
+ *
+ * Returns          CID of the bearer
+ *
+ ******************************************************************************/
+uint16_t gatt_tcb_select_cid_for_request(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
+                                         uint16_t handle) {
+  if (!tcb.eatt || !p_clcb->p_reg->eatt_support) return tcb.att_lcid;
+  if (p_clcb->operation == GATTC_OPTYPE_WRITE &&
+      p_clcb->op_subtype == GATT_WRITE_NO_RSP)
+    return tcb.att_lcid;
+
+  std::map<uint16_t, size_t> queue_len;
+  queue_len[tcb.att_lcid] = tcb.cl_cmd_q.size();
+  for (uint8_t i = 0; i < GATT_CL_MAX_LCB; i++) {
+    const tGATT_CLCB& clcb = gatt_cb.clcb[i];
+    if (!clcb.in_use || &clcb == p_clcb || clcb.p_tcb != &tcb) continue;
+
+    if (handle != 0 && gatt_clcb_is_handle_request(clcb, handle)) {
+      VLOG(1) << __func__ << ": handle " << loghex(handle)
+              << " busy, keep on cid " << loghex(clcb.cid);
+      return clcb.cid;
+    }
+
+    if (queue_len.count(clcb.cid) != 0) continue;
+    std::queue<tGATT_CMD_Q>* cl_cmd_q = gatt_tcb_get_cl_cmd_q(tcb, clcb.cid);
+    if (cl_cmd_q) queue_len[clcb.cid] = cl_cmd_q->size();
+  }
+
+  EattChannel* channel =
+      EattExtension::GetInstance()->GetChannelAvailableForClientRequest(
+          tcb.peer_bda);
+  if (channel) return channel->cid_;
+  if (tcb.cl_cmd_q.empty()) return tcb.att_lcid;
+
+  auto least_busy = std::min_element(
+      queue_len.begin(), queue_len.end(),
+      [](const auto& a, const auto& b) { return a.second < b.second; });
+  return least_busy->first;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tcb_get_in_flight_depth
+ *
+ * Description      This function counts the client requests sent on all
+ *                  bearers of the link that still wait for a response
+ *
+ * Returns          Number of requests in flight
+ *
+ ******************************************************************************/
+uint16_t gatt_tcb_get_in_flight_depth(tGATT_TCB& tcb) {
+  std::set<uint16_t> cids = {tcb.att_lcid};
+  for (uint8_t i = 0; i < GATT_CL_MAX_LCB; i++) {
+    const tGATT_CLCB& clcb = gatt_cb.clcb[i];
+    if (clcb.in_use && clcb.p_tcb == &tcb) cids.insert(clcb.cid);
+  }
+
+  /* Only the request at the head of a bearer queue can be sent */
+  uint16_t depth = 0;
+  for (uint16_t cid : cids) {
+    std::queue<tGATT_CMD_Q>* cl_cmd_q = gatt_tcb_get_cl_cmd_q(tcb, cid);
+    if (cl_cmd_q && !cl_cmd_q->empty() && !cl_cmd_q->front().to_send) depth++;
+  }
+  return depth;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_tcb_get_pending_request_depth
+ *
+ * Description      This function counts the client requests queued on all
+ *                  bearers of the link, sent or waiting to be sent
+ *
+ * Returns          Number of pending requests
+ *
+ ******************************************************************************/
+uint16_t gatt_tcb_get_pending_request_depth(tGATT_TCB& tcb) {
+  std::set<uint16_t> cids = {tcb.att_lcid};
+  for (uint8_t i = 0; i < GATT_CL_MAX_LCB; i++) {
+    const tGATT_CLCB& clcb = gatt_cb.clcb[i];
+    if (clcb.in_use && clcb.p_tcb == &tcb) cids.insert(clcb.cid);
+  }
+
+  uint16_t depth = 0;
+  for (uint16_t cid : cids) {
+    std::queue<tGATT_CMD_Q>* cl_cmd_q = gatt_tcb_get_cl_cmd_q(tcb, cid);
+    if (cl_cmd_q) depth += cl_cmd_q->size();
+  }
+  return depth;
+}
+
 /*******************************************************************************
  *
  * Function         gatt_tcb_get_payload_size_tx
@@ -1427,6 +1663,10 @@ void gatt_cmd_enq(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, bool to_send,
     CHECK(channel);
     channel->cl_cmd_q_.push(cmd);
   }
+
+  EattExtension::GetInstance()->ReportGattLoad(
+      tcb.peer_bda, gatt_tcb_get_pending_request_depth(tcb),
+      fixed_queue_length(tcb.pending_ind_q));
 }
 
 /** dequeue the command in the client CCB command queue */
@@ -1467,6 +1707,19 @@ tGATT_STATUS gatt_send_write_msg(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
   return attp_send_cl_msg(tcb, p_clcb, op_code, &msg);
 }
 
+/** Ends the Exchange MTU requests that waited on the one in flight on |tcb|
+ */
+static void gatt_end_waiting_mtu_ops(tGATT_TCB& tcb, tGATT_STATUS status) {
+  for (uint8_t i = 0; i < GATT_CL_MAX_LCB; i++) {
+    tGATT_CLCB* p_clcb = &gatt_cb.clcb[i];
+    if (p_clcb->in_use && p_clcb->p_tcb == &tcb &&
+        p_clcb->operation == GATTC_OPTYPE_CONFIG &&
+        p_clcb != tcb.p_mtu_clcb) {
+      gatt_end_operation(p_clcb, status, NULL);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         gatt_end_operation
@@ -1487,10 +1740,15 @@ void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status, void* p_data) {
       (p_clcb->p_reg) ? p_clcb->p_reg->app_cb.p_disc_cmpl_cb : NULL;
   uint16_t conn_id;
   uint8_t operation;
+  tGATT_TCB* p_tcb = p_clcb->p_tcb;
+  bool mtu_exchange_done = (p_clcb->operation == GATTC_OPTYPE_CONFIG &&
+                            p_tcb->p_mtu_clcb == p_clcb);
 
   VLOG(1) << __func__
           << StringPrintf(" status=%d op=%d subtype=%d", status,
                           p_clcb->operation, p_clcb->op_subtype);
+  if (mtu_exchange_done) gatt_mtu_exchange_done(*p_tcb, status);
+
   memset(&cb_data.att_value, 0, sizeof(tGATT_VALUE));
 
   if (p_cmpl_cb != NULL && p_clcb->operation != 0) {
@@ -1539,6 +1797,9 @@ void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status, void* p_data) {
                  << StringPrintf(
                         ": not sent out op=%d p_disc_cmpl_cb:%p p_cmpl_cb:%p",
                         operation, p_disc_cmpl_cb, p_cmpl_cb);
+
+  /* requests made while the exchange was in flight end with it */
+  if (mtu_exchange_done) gatt_end_waiting_mtu_ops(*p_tcb, status);
 }
 
 /** This function cleans up the control blocks when L2CAP channel disconnect */
@@ -1568,6 +1829,11 @@ void gatt_cleanup_upon_disc(const RawAddress& bda, tGATT_DISCONN_REASON reason,
   p_tcb->ind_ack_timer = NULL;
   alarm_free(p_tcb->conf_timer);
   p_tcb->conf_timer = NULL;
+  alarm_free(p_tcb->notif_timer);
+  p_tcb->notif_timer = NULL;
+
+  alarm_free(p_tcb->auto_mtu_timer);
+  p_tcb->auto_mtu_timer = NULL;
   gatt_free_pending_ind(p_tcb);
   fixed_queue_free(p_tcb->sr_cmd.multi_rsp_q, NULL);
   p_tcb->sr_cmd.multi_rsp_q = NULL;
@@ -50,6 +50,8 @@ class A2dpCodecConfigAacSource : public A2dpCodecConfigAacBase {
   bool init() override;
   uint64_t encoderIntervalMs() const override;
   int getEffectiveMtu() const override;
+  uint64_t encoderPacketIntervalUs() const override;
+  bool setEncoderRatePercent(uint8_t rate_percent) override;
 
  private:
   bool useRtpHeaderMarkerBit() const override;
@@ -28,6 +28,7 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include <hardware/bt_av.h>
 
@@ -129,6 +130,19 @@ class A2dpCodecConfig {
   // configured.
   virtual int getEffectiveMtu() const = 0;
 
+  // Gets the playout duration of one full media packet of the running
+  // encoder, which is the natural wakeup period of the encoder.
+  // Returns the duration in microseconds, or 0 if it is not fixed.
+  virtual uint64_t encoderPacketIntervalUs() const { return 0; }
+
+  // Scales the target rate of the running encoder to |rate_percent| percent
+  // of the rate derived from the negotiated codec configuration. Used by the
+  // A2DP Source to back off while the link is congested.
+  // Returns true if the encoder supports rate scaling, otherwise false.
+  virtual bool setEncoderRatePercent(uint8_t /* rate_percent */) {
+    return false;
+  }
+
   // Checks whether |codec_config| is empty and contains no configuration.
   // Returns true if |codec_config| is empty, otherwise false.
   static bool isCodecConfigEmpty(const btav_a2dp_codec_config_t& codec_config);
@@ -497,7 +511,10 @@ typedef uint32_t (*a2dp_source_read_callback_t)(uint8_t* p_buf, uint32_t len);
 
 // Prototype for a callback to enqueue A2DP Source packets for transmission.
 // |p_buf| is the buffer with the audio data to enqueue. The callback is
-// responsible for freeing |p_buf|.
+// responsible for freeing |p_buf|. The audio data must start at an offset of
+// at least AVDT_MEDIA_OFFSET (or AVDT_MEDIA_OFFSET - AVDT_MEDIA_HDR_SIZE if the
+// codec does not use an RTP header), so the AVDTP and L2CAP headers can be
+// written in place in front of it. Packets without this headroom are dropped.
 // |frames_n| is the number of audio frames in |p_buf| - it is used for
 // statistics purpose.
 // |num_bytes| is the number of audio bytes in |p_buf| - it is used for
@@ -538,6 +555,15 @@ typedef struct {
 
   // Set transmit queue length for the A2DP encoder.
   void (*set_transmit_queue_length)(size_t transmit_queue_length);
+
+  // Encode the PCM audio in |p_pcm|, |pcm_len| octets in the feeding format,
+  // into A2DP media packets appended to |p_packets|. Only whole codec frames
+  // are encoded, and each packet is filled up to the peer MTU. The caller
+  // owns the packets. Returns the number of PCM octets consumed, which is
+  // zero if the encoder cannot take PCM in the feeding format directly.
+  // May be nullptr if the encoder has no batched mode.
+  size_t (*encode_frames)(const uint8_t* p_pcm, size_t pcm_len,
+                          std::vector<BT_HDR*>* p_packets);
 } tA2DP_ENCODER_INTERFACE;
 
 // Prototype for a callback to receive decoded audio data from a
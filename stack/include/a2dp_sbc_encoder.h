@@ -59,6 +59,12 @@ uint64_t a2dp_sbc_get_encoder_interval_ms(void);
 // |timestamp_us| is the current timestamp (in microseconds).
 void a2dp_sbc_send_frames(uint64_t timestamp_us);
 
+// Encodes the whole SBC frames of |p_pcm| into media packets appended to
+// |p_packets| - see |tA2DP_ENCODER_INTERFACE.encode_frames|. Returns zero
+// without encoding if the feeding has to be resampled to the SBC sample rate.
+size_t a2dp_sbc_encode_frames_batch(const uint8_t* p_pcm, size_t pcm_len,
+                                    std::vector<BT_HDR*>* p_packets);
+
 // Get SBC bitrate
 // Returns |uint32_t| bitrate in bits per second
 uint32_t a2dp_sbc_get_bitrate();
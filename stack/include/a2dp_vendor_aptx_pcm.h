@@ -0,0 +1,67 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// PCM feed and encoding loops shared by the A2DP aptX and aptX-HD encoders
+//
+
+#ifndef A2DP_VENDOR_APTX_PCM_H
+#define A2DP_VENDOR_APTX_PCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the PCM feed, larger than the PCM of any aptX or aptX-HD packet
+#define A2DP_APTX_PCM_FEED_SIZE 4096
+
+// Encoding function of the aptX and aptX-HD libraries: encodes four stereo
+// samples from |pcmL| and |pcmR| into two code words in |buffer|.
+typedef int (*tA2DP_APTX_ENCODE_STEREO)(void* state, void* pcmL, void* pcmR,
+                                        void* buffer);
+
+// PCM read for the next media packet. What an underflowing read returned
+// stays in the feed for the next packet, instead of being dropped.
+typedef struct {
+  alignas(16) uint8_t pcm[A2DP_APTX_PCM_FEED_SIZE];
+  uint32_t len;  // PCM octets in |pcm|
+} tA2DP_APTX_PCM_FEED;
+
+// Reads with |read_callback| what |p_feed| misses to hold |len| PCM octets.
+// |p_bytes_read| is set to the number of octets read.
+// Returns true if |p_feed| holds at least |len| octets.
+bool a2dp_aptx_pcm_feed_fill(tA2DP_APTX_PCM_FEED* p_feed,
+                             uint32_t (*read_callback)(uint8_t*, uint32_t),
+                             uint32_t len, uint32_t* p_bytes_read);
+
+// Removes the first |len| PCM octets of |p_feed|, once they are encoded.
+void a2dp_aptx_pcm_feed_consume(tA2DP_APTX_PCM_FEED* p_feed, uint32_t len);
+
+// Encodes the 16-bit stereo PCM of |p_pcm|, which must be 16-bit aligned,
+// with |encode| and packs the code words into |p_out|, four octets for every
+// 16 PCM octets.
+// Returns the number of PCM octets encoded.
+size_t a2dp_aptx_encode_16bit(tA2DP_APTX_ENCODE_STEREO encode, void* state,
+                              const uint8_t* p_pcm, size_t pcm_len,
+                              uint8_t* p_out);
+
+// Encodes the packed 24-bit stereo PCM of |p_pcm| with |encode| and packs the
+// code words into |p_out|, six octets for every 24 PCM octets.
+// Returns the number of PCM octets encoded.
+size_t a2dp_aptx_hd_encode_24bit(tA2DP_APTX_ENCODE_STEREO encode, void* state,
+                                 const uint8_t* p_pcm, size_t pcm_len,
+                                 uint8_t* p_out);
+
+#endif  // A2DP_VENDOR_APTX_PCM_H
@@ -284,6 +284,19 @@ void btm_acl_update_conn_addr(uint16_t conn_handle, const RawAddress& address);
  ******************************************************************************/
 bool BTM_ReadPowerMode(const RawAddress& remote_bda, tBTM_PM_MODE* p_mode);
 
+/*******************************************************************************
+ *
+ * Function         BTM_ReadAclTraffic
+ *
+ * Description      This returns the ACL data traffic of the BR/EDR link to
+ *                  the remote device, see tBTM_ACL_TRAFFIC.
+ *
+ * Returns          true if the link was found, false otherwise
+ *
+ ******************************************************************************/
+bool BTM_ReadAclTraffic(const RawAddress& remote_bda,
+                        tBTM_ACL_TRAFFIC* p_traffic);
+
 void btm_acl_created(const RawAddress& bda, uint16_t hci_handle,
                      tHCI_ROLE link_role, tBT_TRANSPORT transport);
 
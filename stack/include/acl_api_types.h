@@ -86,6 +86,24 @@ typedef struct {
   uint8_t link_quality;
 } tBTM_LINK_QUALITY_RESULT;
 
+/* ACL data traffic of a BR/EDR link, returned by BTM_ReadAclTraffic. Packets
+ * less than BTM_ACL_BURST_GAP_MS apart are part of the same burst, and the
+ * idle gaps before the bursts are counted in log2 buckets: from 1 to 2 times
+ * BTM_ACL_BURST_GAP_MS, from 2 to 4 times, and so on, the last bucket holding
+ * all the longer gaps. The counts are halved once they add up to
+ * BTM_ACL_GAP_HISTORY, so that they follow the recent traffic.
+ */
+#define BTM_ACL_BURST_GAP_MS 100
+#define BTM_ACL_GAP_BUCKETS 8
+#define BTM_ACL_GAP_HISTORY 64
+
+typedef struct {
+  uint32_t tx_packets;
+  uint32_t rx_packets;
+  uint64_t last_packet_ms; /* boot time of the last packet, 0 if none */
+  uint32_t gaps[BTM_ACL_GAP_BUCKETS];
+} tBTM_ACL_TRAFFIC;
+
 #define BTM_INQUIRY_STARTED 1
 #define BTM_INQUIRY_CANCELLED 2
 #define BTM_INQUIRY_COMPLETE 3
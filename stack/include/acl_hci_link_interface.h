@@ -68,6 +68,7 @@ void acl_rcv_acl_data(BT_HDR* p_msg);
 void acl_link_segments_xmitted(BT_HDR* p_msg);
 void acl_process_num_completed_pkts(uint8_t* p, uint8_t evt_len);
 void acl_packets_completed(uint16_t handle, uint16_t num_packets);
+void acl_tx_congestion(uint16_t handle, bool congested);
 void acl_process_supported_features(uint16_t handle, uint64_t features);
 void acl_process_extended_features(uint16_t handle, uint8_t current_page_number,
                                    uint8_t max_page_number, uint64_t features);
@@ -142,3 +142,69 @@ class AdvertiseDataParser {
     return GetFieldByType(ad.data(), ad.size(), type, p_length);
   }
 };
+
+/**
+ * Index of the fields of advertising data, built in a single pass over the
+ * data, for callers that look up several field types in the same report.
+ * Lookups return the same fields as AdvertiseDataParser::GetFieldByType. The
+ * index points into the data, which must outlive it.
+ */
+class AdIndex {
+ public:
+  // Enough for the fields of legacy advertising and scan response data. The
+  // fields past this many are looked up by scanning the rest of the data.
+  static constexpr size_t kMaxFields = 32;
+
+  AdIndex(const uint8_t* ad, size_t ad_len) : ad_(ad), ad_len_(ad_len) {
+    while (rest_ != ad_len && num_fields_ < kMaxFields) {
+      uint8_t len = ad[rest_];
+
+      if (len == 0 || rest_ + len >= ad_len) {
+        rest_ = ad_len;
+        break;
+      }
+
+      fields_[num_fields_++] = {ad[rest_ + 1], (uint8_t)(len - 1),
+                                (uint32_t)(rest_ + 2)};
+      rest_ += len + 1;
+    }
+  }
+
+  explicit AdIndex(std::vector<uint8_t> const& ad)
+      : AdIndex(ad.data(), ad.size()) {}
+
+  /**
+   * This function returns a pointer inside the indexed data where the first
+   * field of |type| is located, together with its length in |p_length|
+   */
+  const uint8_t* GetFieldByType(uint8_t type, uint8_t* p_length) const {
+    for (size_t i = 0; i < num_fields_; i++) {
+      if (fields_[i].type == type) {
+        *p_length = fields_[i].len;
+        return ad_ + fields_[i].offset;
+      }
+    }
+
+    if (rest_ != ad_len_) {
+      return AdvertiseDataParser::GetFieldByType(ad_ + rest_, ad_len_ - rest_,
+                                                 type, p_length);
+    }
+
+    *p_length = 0;
+    return NULL;
+  }
+
+ private:
+  struct Field {
+    uint8_t type;
+    uint8_t len; /* not including the type */
+    uint32_t offset;
+  };
+
+  const uint8_t* ad_;
+  size_t ad_len_;
+  /* Position of the first field not indexed */
+  size_t rest_ = 0;
+  size_t num_fields_ = 0;
+  std::array<Field, kMaxFields> fields_;
+};
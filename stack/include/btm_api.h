@@ -350,6 +350,20 @@ void BTM_EnableInterlacedInquiryScan();
 
 void BTM_EnableInterlacedPageScan();
 
+/*******************************************************************************
+ *
+ * Function         BTM_SetStreamingActive
+ *
+ * Description      This function is called when audio streaming starts or
+ *                  stops, so that the radio time given to inquiry, page and
+ *                  LE scans is limited while streaming. Only the GD stack
+ *                  with the radio scheduler enabled limits the scans.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_SetStreamingActive(bool active);
+
 /*******************************************************************************
  *
  * Function         BTM_ReadRemoteDeviceName
@@ -228,6 +228,13 @@ class IsoManager {
    */
   void Stop();
 
+  /**
+   * Dumps the ISO data path statistics
+   *
+   * @param fd file descriptor to write to
+   */
+  void Dump(int fd);
+
  private:
   struct impl;
   std::unique_ptr<impl> pimpl_;
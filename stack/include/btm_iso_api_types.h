@@ -42,6 +42,7 @@ constexpr uint8_t kIsoSca0To20Ppm = 0x07;
 constexpr uint8_t kIsoEventCisDataAvailable = 0x00;
 constexpr uint8_t kIsoEventCisEstablishCmpl = 0x01;
 constexpr uint8_t kIsoEventCisDisconnected = 0x02;
+constexpr uint8_t kIsoEventCisSduSent = 0x03;
 
 constexpr uint8_t kIsoEventCigOnCreateCmpl = 0x00;
 constexpr uint8_t kIsoEventCigOnReconfigureCmpl = 0x01;
@@ -49,6 +50,7 @@ constexpr uint8_t kIsoEventCigOnRemoveCmpl = 0x02;
 
 constexpr uint8_t kIsoEventBigOnCreateCmpl = 0x00;
 constexpr uint8_t kIsoEventBigOnTerminateCmpl = 0x01;
+constexpr uint8_t kIsoEventBigSduSent = 0x02;
 
 struct cig_create_params {
   uint32_t sdu_itv_mtos;
@@ -144,6 +146,20 @@ struct big_terminate_cmpl_evt {
   uint8_t reason;
 };
 
+/* The controller completed all the ISO data packets of an SDU */
+struct iso_sdu_sent_evt {
+  union {
+    uint8_t cig_id;
+    uint8_t big_id;
+  };
+  uint16_t conn_hdl;
+  uint16_t seq_nb;
+  /* From SendIsoData until the last packet was completed */
+  uint32_t latency_us;
+  /* SDUs still waiting in the controller on this handle */
+  uint16_t sdus_in_flight;
+};
+
 struct iso_data_path_params {
   uint8_t data_path_dir;
   uint8_t data_path_id;
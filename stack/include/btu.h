@@ -55,10 +55,18 @@ void btu_hcif_send_cmd_with_cb(const base::Location& posted_from,
 bluetooth::common::MessageLoopThread* get_main_thread();
 bt_status_t do_in_main_thread(const base::Location& from_here,
                               base::OnceClosure task);
+/* Posts |task| to the high priority lane of the main thread, for the HCI
+ * receive path that must not queue behind other work */
+bt_status_t do_in_main_thread_high_priority(const base::Location& from_here,
+                                            base::OnceClosure task);
 bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay);
 
+/* Boot time the packet being processed by the main thread was received from
+ * HCI at, 0 outside of the processing of a received packet */
+uint64_t btu_hci_rx_time_us();
+
 using BtMainClosure = std::function<void()>;
 void post_on_bt_main(BtMainClosure closure);
 
@@ -20,6 +20,7 @@
 
 #include <base/strings/stringprintf.h>
 #include <string>
+#include <vector>
 
 #include "bt_target.h"
 #include "btm_ble_api.h"
@@ -871,6 +872,83 @@ extern tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
                                                   uint16_t val_len,
                                                   uint8_t* p_val);
 
+/*******************************************************************************
+ *
+ * Function         GATTS_HandleValueNotificationFanOut
+ *
+ * Description      This function sends one handle value notification to
+ *                  several clients. The PDU is built once for each ATT MTU in
+ *                  use and copied to the connections.
+ *
+ *                  When a coalescing window is set, the value is held until
+ *                  the window ends and replaced by later values of the same
+ *                  handle. The values held for a client that supports them
+ *                  are then sent in Multiple Handle Value Notifications.
+ *
+ * Parameter        conn_ids: connection identifiers of the clients.
+ *                  attr_handle: Attribute handle of this handle value
+ *                               notification.
+ *                  val_len: Length of the notified attribute value.
+ *                  p_val: Pointer to the notified attribute value data.
+ *
+ * Returns          GATT_SUCCESS if sent or queued to every client; otherwise
+ *                  the error code of the last client that failed.
+ *
+ ******************************************************************************/
+extern tGATT_STATUS GATTS_HandleValueNotificationFanOut(
+    const std::vector<uint16_t>& conn_ids, uint16_t attr_handle,
+    uint16_t val_len, uint8_t* p_val);
+
+/*******************************************************************************
+ *
+ * Function         GATTS_SetNotificationCoalescing
+ *
+ * Description      Set how long GATTS_HandleValueNotificationFanOut() holds
+ *                  values so that rapid updates of a handle are sent once.
+ *
+ * Parameter        window_ms: coalescing window, 0 to send right away.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void GATTS_SetNotificationCoalescing(uint64_t window_ms);
+
+/*******************************************************************************
+ *
+ * Function         GATTS_SetAttributeCache
+ *
+ * Description      Cache the value of a characteristic or descriptor in the
+ *                  stack. Reads of the attribute, including long reads, are
+ *                  answered from the cached value instead of being sent to
+ *                  the application, until it expires or is cleared. The
+ *                  application must set it again when the value changes.
+ *
+ * Parameter        attr_handle: handle of an attribute of a started service.
+ *                  value: value of the attribute.
+ *                  ttl_ms: how long the value stays valid, 0 for a value that
+ *                          never changes.
+ *
+ * Returns          GATT_SUCCESS if the value is cached; otherwise error code.
+ *
+ ******************************************************************************/
+extern tGATT_STATUS GATTS_SetAttributeCache(uint16_t attr_handle,
+                                            const std::vector<uint8_t>& value,
+                                            uint64_t ttl_ms);
+
+/*******************************************************************************
+ *
+ * Function         GATTS_ClearAttributeCache
+ *
+ * Description      Drop the cached value of an attribute, its reads are sent
+ *                  to the application again.
+ *
+ * Parameter        attr_handle: handle of the attribute.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void GATTS_ClearAttributeCache(uint16_t attr_handle);
+
 /*******************************************************************************
  *
  * Function         GATTS_SendRsp
@@ -995,6 +1073,36 @@ extern tGATT_STATUS GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute);
 extern tGATT_STATUS GATTC_SendHandleValueConfirm(uint16_t conn_id,
                                                  uint16_t handle);
 
+/*******************************************************************************
+ *
+ * Function         GATTC_GetInFlightDepth
+ *
+ * Description      This function returns the number of client requests sent
+ *                  on the connection's ATT and EATT bearers that still wait
+ *                  for a response.
+ *
+ * Parameters       conn_id: connection identifier.
+ *
+ * Returns          Number of requests in flight, 0 if not connected.
+ *
+ ******************************************************************************/
+extern uint16_t GATTC_GetInFlightDepth(uint16_t conn_id);
+
+/*******************************************************************************
+ *
+ * Function         GATTC_GetWriteCmdMaxLen
+ *
+ * Description      This function returns the number of value octets a Write
+ *                  Command can carry on the connection. Write Commands are
+ *                  always sent on the ATT bearer, so this follows its MTU.
+ *
+ * Parameters       conn_id: connection identifier.
+ *
+ * Returns          Maximum value length, 0 if not connected.
+ *
+ ******************************************************************************/
+extern uint16_t GATTC_GetWriteCmdMaxLen(uint16_t conn_id);
+
 /*******************************************************************************
  *
  * Function         GATT_SetIdleTimeout
@@ -1172,6 +1280,19 @@ extern bool GATT_GetConnIdIfConnected(tGATT_IF gatt_if,
 extern void GATT_ConfigServiceChangeCCC(const RawAddress& remote_bda,
                                         bool enable, tBT_TRANSPORT transport);
 
+/*******************************************************************************
+ *
+ * Function         GATT_Dump
+ *
+ * Description      Dump the bearers and the load of each GATT connection
+ *
+ * Parameters       fd: file descriptor to dump to
+ *
+ * Returns          None.
+ *
+ ******************************************************************************/
+extern void GATT_Dump(int fd);
+
 // Enables the GATT profile on the device.
 // It clears out the control blocks, and registers with L2CAP.
 extern void gatt_init(void);
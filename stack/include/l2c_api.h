@@ -497,8 +497,9 @@ extern bool L2CA_ReconfigCreditBasedConnsReq(const RawAddress& bd_addr,
  *
  *  Function         L2CA_ConnectCreditBasedReq
  *
- *  Description      With this function L2CAP will initiate setup of up to 5 credit
- *                   based connections for given psm using provided configuration.
+ *  Description      With this function L2CAP will initiate setup of up to
+ *                   |num_of_channels| credit based connections, at most 5, for
+ *                   given psm using provided configuration.
  *                   L2CAP will notify user on the connection result, by calling
  *                   pL2CA_CreditBasedConnectCfm_Cb for each cid with a result.
  *
@@ -507,7 +508,8 @@ extern bool L2CA_ReconfigCreditBasedConnsReq(const RawAddress& bd_addr,
  ******************************************************************************/
 
 extern std::vector<uint16_t> L2CA_ConnectCreditBasedReq(
-    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg);
+    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg,
+    uint8_t num_of_channels);
 
 /*******************************************************************************
  *
@@ -44,6 +44,9 @@ extern void l2cble_process_data_length_change_event(uint16_t handle,
                                                     uint16_t tx_data_len,
                                                     uint16_t rx_data_len);
 
+extern void l2cble_process_phy_update_evt(uint16_t handle, uint8_t status,
+                                          uint8_t tx_phy, uint8_t rx_phy);
+
 // Notify to L2cap layer that ACL data or remote version is received
 extern void l2cble_notify_le_connection(const RawAddress& bda);
 
@@ -153,6 +153,8 @@ typedef struct {
   uint16_t num_attr_filters; /* Number of attribute filters  */
   uint16_t attr_filters[SDP_MAX_ATTR_FILTERS]; /* Attributes to filter */
   uint8_t* p_free_mem; /* Pointer to free memory       */
+  uint32_t max_size;   /* Size the DB may grow to, 0 if it is fixed */
+  struct t_sdp_disc_block* p_blocks; /* Memory added as the DB grew */
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
   uint8_t*
       raw_data; /* Received record from server. allocated/released by client  */
@@ -208,6 +210,35 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
                          uint16_t num_uuid, const bluetooth::Uuid* p_uuid_list,
                          uint16_t num_attr, uint16_t* p_attr_list);
 
+/*******************************************************************************
+ *
+ * Function         SDP_CreateDiscoveryDb
+ *
+ * Description      This function allocates and initializes a discovery
+ *                  database of len bytes, which grows as records are added
+ *                  up to SDP_MAX_DISC_DB_SIZE bytes.
+ *
+ * Returns          the database, to be released with SDP_FreeDiscoveryDb, or
+ *                  NULL if one or more parameters are bad
+ *
+ ******************************************************************************/
+tSDP_DISCOVERY_DB* SDP_CreateDiscoveryDb(uint32_t len, uint16_t num_uuid,
+                                         const bluetooth::Uuid* p_uuid_list,
+                                         uint16_t num_attr,
+                                         uint16_t* p_attr_list);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FreeDiscoveryDb
+ *
+ * Description      This function releases a discovery database allocated by
+ *                  SDP_CreateDiscoveryDb.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_FreeDiscoveryDb(tSDP_DISCOVERY_DB* p_db);
+
 /*******************************************************************************
  *
  * Function         SDP_CancelServiceSearch
@@ -268,6 +299,34 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
                                         tSDP_DISC_CMPL_CB2* p_cb,
                                         void* user_data);
 
+/*******************************************************************************
+ *
+ * Function         SDP_InvalidateCache
+ *
+ * Description      This function drops the search attribute responses cached
+ *                  for a remote device, so that the next search goes over the
+ *                  air.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_InvalidateCache(const RawAddress& bd_addr);
+
+/*******************************************************************************
+ *
+ * Function         SDP_UpdateCacheFingerprint
+ *
+ * Description      This function is called with data that changes when the
+ *                  services of a remote device change, like the service UUIDs
+ *                  of its EIR. The cached search attribute responses of the
+ *                  device are dropped if the data differs from last time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_UpdateCacheFingerprint(const RawAddress& bd_addr,
+                                const uint8_t* p_data, size_t len);
+
 /* API of utilities to find data in the local discovery database */
 
 /*******************************************************************************
@@ -282,6 +341,21 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
  ******************************************************************************/
 tSDP_DISC_ATTR* SDP_FindAttributeInRec(tSDP_DISC_REC* p_rec, uint16_t attr_id);
 
+/*******************************************************************************
+ *
+ * Function         SDP_FindAttributesInRec
+ *
+ * Description      This function searches an SDP discovery record for several
+ *                  attributes at once. p_attrs[i] is set to the entry of
+ *                  attr_ids[i], or NULL if the record does not have it.
+ *
+ * Returns          Number of attributes found
+ *
+ ******************************************************************************/
+uint16_t SDP_FindAttributesInRec(tSDP_DISC_REC* p_rec, uint16_t num_attr,
+                                 const uint16_t* p_attr_ids,
+                                 tSDP_DISC_ATTR** p_attrs);
+
 /*******************************************************************************
  *
  * Function         SDP_FindServiceInDb
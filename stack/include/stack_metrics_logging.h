@@ -21,6 +21,12 @@
 
 #include "types/raw_address.h"
 
+// Starts the thread the events below are emitted from. Until it is running,
+// and after stack_metrics_logging_shut_down(), events are emitted by the
+// thread reporting them.
+void stack_metrics_logging_start_up();
+void stack_metrics_logging_shut_down();
+
 void log_classic_pairing_event(const RawAddress& address, uint16_t handle,
                                uint32_t hci_cmd, uint16_t hci_event,
                                uint16_t cmd_status, uint16_t reason_code,
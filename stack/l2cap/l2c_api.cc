@@ -725,6 +725,7 @@ bool L2CA_ConnectCreditBasedRsp(const RawAddress& p_bd_addr, uint8_t id,
  *  Parameters:      PSM for the L2CAP channel
  *                   BD address of the peer
  *                   Local channel configuration
+ *                   Number of channels to connect, at most 5
  *
  *  Return value:    Vector of allocated local cids.
  *
@@ -732,9 +733,11 @@ bool L2CA_ConnectCreditBasedRsp(const RawAddress& p_bd_addr, uint8_t id,
 
 std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
                                                  const RawAddress& p_bd_addr,
-                                                 tL2CAP_LE_CFG_INFO* p_cfg) {
+                                                 tL2CAP_LE_CFG_INFO* p_cfg,
+                                                 uint8_t num_of_channels) {
   if (bluetooth::shim::is_gd_l2cap_enabled()) {
-    return bluetooth::shim::L2CA_ConnectCreditBasedReq(psm, p_bd_addr, p_cfg);
+    return bluetooth::shim::L2CA_ConnectCreditBasedReq(psm, p_bd_addr, p_cfg,
+                                                       num_of_channels);
   }
 
   VLOG(1) << __func__ << " BDA: " << p_bd_addr
@@ -753,6 +756,12 @@ std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
     return allocated_cids;
   }
 
+  if (num_of_channels == 0 || num_of_channels > L2CAP_CREDIT_BASED_MAX_CIDS) {
+    L2CAP_TRACE_WARNING("%s invalid number of channels: %d", __func__,
+                        num_of_channels);
+    return allocated_cids;
+  }
+
   /* Fail if the PSM is not registered */
   tL2C_RCB* p_rcb = l2cu_find_ble_rcb_by_psm(psm);
   if (p_rcb == NULL) {
@@ -777,7 +786,7 @@ std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
 
   tL2C_CCB* p_ccb_primary;
 
-  for (int i = 0; i < 5; i++) {
+  for (int i = 0; i < num_of_channels; i++) {
     /* Allocate a channel control block */
     tL2C_CCB* p_ccb = l2cu_allocate_ccb(p_lcb, 0);
     if (p_ccb == NULL) {
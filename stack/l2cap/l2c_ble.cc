@@ -30,6 +30,7 @@
 
 #include "bt_target.h"
 #include "bta_hearing_aid_api.h"
+#include "common/time_util.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
@@ -54,6 +55,7 @@ extern tBTM_CB btm_cb;
 using base::StringPrintf;
 
 static void l2cble_start_conn_update(tL2C_LCB* p_lcb);
+static void l2cble_tuner_start(tL2C_LCB* p_lcb);
 extern void gatt_notify_conn_update(const RawAddress& remote, uint16_t interval,
                                     uint16_t latency, uint16_t timeout,
                                     tHCI_STATUS status);
@@ -106,6 +108,7 @@ bool L2CA_UpdateBleConnParams(const RawAddress& rem_bda, uint16_t min_int,
   p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
   p_lcb->min_ce_len = min_ce_len;
   p_lcb->max_ce_len = max_ce_len;
+  p_lcb->tuner.PinParams();
 
   l2cble_start_conn_update(p_lcb);
 
@@ -263,6 +266,8 @@ bool l2cble_conn_comp(uint16_t handle, uint8_t role, const RawAddress& bda,
                              L2CAP_FIXED_CHNL_BLE_SIG_BIT |
                              L2CAP_FIXED_CHNL_SMP_BIT;
 
+  l2cble_tuner_start(p_lcb);
+
   if (role == HCI_ROLE_PERIPHERAL) {
     if (!controller_get_interface()
              ->supports_ble_peripheral_initiated_feature_exchange()) {
@@ -395,6 +400,7 @@ void l2cble_process_conn_update_evt(uint16_t handle, uint8_t status,
   if (status != HCI_SUCCESS) {
     L2CAP_TRACE_WARNING("%s: Error status: %d", __func__, status);
   }
+  p_lcb->tuner.OnConnUpdateDone(status == HCI_SUCCESS);
 
   l2cble_start_conn_update(p_lcb);
 
@@ -491,6 +497,7 @@ void l2cble_process_sig_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len) {
           p_lcb->latency = latency;
           p_lcb->timeout = timeout;
           p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
+          p_lcb->tuner.PinParams();
 
           l2cble_start_conn_update(p_lcb);
         }
@@ -499,9 +506,17 @@ void l2cble_process_sig_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len) {
                                   0);
       break;
 
-    case L2CAP_CMD_BLE_UPDATE_RSP:
-      p += 2;
+    case L2CAP_CMD_BLE_UPDATE_RSP: {
+      if (p + 2 > p_pkt_end) {
+        LOG(ERROR) << "invalid L2CAP_CMD_BLE_UPDATE_RSP len";
+        return;
+      }
+      uint16_t result;
+      STREAM_TO_UINT16(result, p);
+      /* Accepted updates complete with the connection update event */
+      if (result != L2CAP_CFG_OK) p_lcb->tuner.OnConnUpdateDone(false);
       break;
+    }
 
     case L2CAP_CMD_CREDIT_BASED_CONN_REQ: {
       if (p + 10 > p_pkt_end) {
@@ -1246,6 +1261,7 @@ void l2cble_process_rc_param_request_evt(uint16_t handle, uint16_t int_min,
 
     /* if update is enabled, always accept connection parameter update */
     if ((p_lcb->conn_update_mask & L2C_BLE_CONN_UPDATE_DISABLE) == 0) {
+      p_lcb->tuner.PinParams();
       btsnd_hcic_ble_rc_param_req_reply(handle, int_min, int_max, latency,
                                         timeout, 0, 0);
     } else {
@@ -1596,6 +1612,7 @@ void l2cble_use_preferred_conn_params(const RawAddress& bda) {
     p_lcb->max_interval = p_dev_rec->conn_params.max_conn_int;
     p_lcb->timeout = p_dev_rec->conn_params.supervision_tout;
     p_lcb->latency = p_dev_rec->conn_params.peripheral_latency;
+    p_lcb->tuner.PinParams();
 
     btsnd_hcic_ble_upd_ll_conn_params(
         p_lcb->Handle(), p_dev_rec->conn_params.min_conn_int,
@@ -1604,3 +1621,205 @@ void l2cble_use_preferred_conn_params(const RawAddress& bda) {
         p_dev_rec->conn_params.supervision_tout, 0, 0);
   }
 }
+
+/* Peers that failed connection or PHY updates of the tuner, kept across
+ * connections, the oldest one is replaced when full */
+#define L2C_BLE_TUNER_PEERS 16
+
+typedef struct {
+  RawAddress bd_addr;
+  uint8_t quirks;
+} tL2C_BLE_TUNER_PEER;
+
+static tL2C_BLE_TUNER_PEER l2cble_tuner_peers[L2C_BLE_TUNER_PEERS];
+static uint8_t l2cble_tuner_next_peer;
+
+static uint8_t l2cble_tuner_peer_quirks(const RawAddress& bda) {
+  for (const tL2C_BLE_TUNER_PEER& peer : l2cble_tuner_peers) {
+    if (peer.quirks != 0 && peer.bd_addr == bda) return peer.quirks;
+  }
+  return 0;
+}
+
+/* Packets waiting to be sent on the link, or sent and not yet completed */
+static uint16_t l2cble_tuner_queued(const tL2C_LCB* p_lcb) {
+  size_t queued = list_length(p_lcb->link_xmit_data_q) + p_lcb->sent_not_acked;
+  return (uint16_t)std::min<size_t>(queued, UINT16_MAX);
+}
+
+const char* l2cble_tuner_load_text(LeLinkLoad load) {
+  switch (load) {
+    case LeLinkLoad::kDefault:
+      return "default";
+    case LeLinkLoad::kBulk:
+      return "bulk";
+    case LeLinkLoad::kIdle:
+      return "idle";
+  }
+  return "unknown";
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cble_tuner_apply
+ *
+ * Description      This function sets the connection parameters, PHY and data
+ *                  length of the load of the link, as far as the peer and the
+ *                  applications allow.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2cble_tuner_apply(tL2C_LCB* p_lcb) {
+  LeLinkTuner& tuner = p_lcb->tuner;
+  LOG_INFO("LE link handle:0x%04x load:%s rate:%uB/s", p_lcb->Handle(),
+           l2cble_tuner_load_text(tuner.load()), tuner.rate());
+
+  if (tuner.load() == LeLinkLoad::kBulk) {
+    const controller_t* controller = controller_get_interface();
+    if (tuner.Wants2mPhy() && controller->supports_ble_2m_phy() &&
+        acl_peer_supports_ble_2m_phy(p_lcb->Handle())) {
+      tuner.OnPhyRequested();
+      BTM_BleSetPhy(p_lcb->remote_bd_addr, PHY_LE_2M, PHY_LE_2M, 0);
+    }
+    if (p_lcb->tx_data_len < BTM_BLE_DATA_SIZE_MAX &&
+        controller->supports_ble_packet_extension() &&
+        acl_peer_supports_ble_packet_extension(p_lcb->Handle())) {
+      BTM_SetBleDataLength(p_lcb->remote_bd_addr, BTM_BLE_DATA_SIZE_MAX);
+    }
+  }
+
+  if (!tuner.WantsConnUpdate() ||
+      (p_lcb->conn_update_mask & L2C_BLE_CONN_UPDATE_DISABLE))
+    return;
+
+  tL2C_BLE_CONN_PARAMS params = tuner.Params();
+  L2CA_AdjustConnectionIntervals(&params.min_int, &params.max_int,
+                                 BTM_BLE_CONN_INT_MIN);
+  if (params.min_int == p_lcb->min_interval &&
+      params.max_int == p_lcb->max_interval &&
+      params.latency == p_lcb->latency && params.timeout == p_lcb->timeout)
+    return;
+
+  p_lcb->min_interval = params.min_int;
+  p_lcb->max_interval = params.max_int;
+  p_lcb->latency = params.latency;
+  p_lcb->timeout = params.timeout;
+  p_lcb->min_ce_len = 0;
+  p_lcb->max_ce_len = 0;
+  p_lcb->conn_update_mask |= L2C_BLE_NEW_CONN_PARAM;
+  tuner.OnConnUpdateRequested();
+
+  l2cble_start_conn_update(p_lcb);
+}
+
+/* Closes the load windows of the LE links without traffic, stops once they
+ * are all idle */
+static void l2cble_tuner_timeout(UNUSED_ATTR void* data) {
+  uint64_t now_ms = bluetooth::common::time_get_os_boottime_ms();
+  bool busy = false;
+
+  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!p_lcb->in_use || p_lcb->transport != BT_TRANSPORT_LE ||
+        p_lcb->link_state != LST_CONNECTED)
+      continue;
+    if (p_lcb->tuner.Count(now_ms, 0, l2cble_tuner_queued(p_lcb)))
+      l2cble_tuner_apply(p_lcb);
+    if (p_lcb->tuner.load() != LeLinkLoad::kIdle) busy = true;
+  }
+
+  if (!busy) alarm_cancel(l2cb.ble_tuner_timer);
+}
+
+static void l2cble_tuner_start_timer(void) {
+  if (!alarm_is_scheduled(l2cb.ble_tuner_timer)) {
+    alarm_set_on_mloop(l2cb.ble_tuner_timer, LeLinkTuner::kWindowMs,
+                       l2cble_tuner_timeout, NULL);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cble_tuner_start
+ *
+ * Description      This function starts following the load of a new LE link,
+ *                  from its connection parameters.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2cble_tuner_start(tL2C_LCB* p_lcb) {
+  tL2C_BLE_CONN_PARAMS params = {
+      .min_int = p_lcb->min_interval,
+      .max_int = p_lcb->max_interval,
+      .latency = p_lcb->latency,
+      .timeout = p_lcb->timeout,
+  };
+  p_lcb->tuner.Reset(bluetooth::common::time_get_os_boottime_ms(), params,
+                     l2cble_tuner_peer_quirks(p_lcb->remote_bd_addr));
+
+  if (l2cb.ble_tuner_enabled) l2cble_tuner_start_timer();
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cble_tuner_stop
+ *
+ * Description      This function is called when an LE link is released, it
+ *                  keeps what the tuner learnt about the peer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cble_tuner_stop(tL2C_LCB* p_lcb) {
+  uint8_t quirks = p_lcb->tuner.quirks();
+  if (quirks == 0) return;
+
+  for (tL2C_BLE_TUNER_PEER& peer : l2cble_tuner_peers) {
+    if (peer.quirks != 0 && peer.bd_addr == p_lcb->remote_bd_addr) {
+      peer.quirks = quirks;
+      return;
+    }
+  }
+  l2cble_tuner_peers[l2cble_tuner_next_peer].bd_addr = p_lcb->remote_bd_addr;
+  l2cble_tuner_peers[l2cble_tuner_next_peer].quirks = quirks;
+  l2cble_tuner_next_peer = (l2cble_tuner_next_peer + 1) % L2C_BLE_TUNER_PEERS;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cble_tuner_count
+ *
+ * Description      This function counts the bytes sent or received on an LE
+ *                  link, and tunes the link when its load changes.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cble_tuner_count(tL2C_LCB* p_lcb, uint32_t bytes) {
+  if (!l2cb.ble_tuner_enabled || p_lcb->link_state != LST_CONNECTED) return;
+
+  if (p_lcb->tuner.Count(bluetooth::common::time_get_os_boottime_ms(), bytes,
+                         l2cble_tuner_queued(p_lcb))) {
+    l2cble_tuner_apply(p_lcb);
+    if (p_lcb->tuner.load() != LeLinkLoad::kIdle) l2cble_tuner_start_timer();
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2cble_process_phy_update_evt
+ *
+ * Description      This function process the LE PHY update complete event
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cble_process_phy_update_evt(uint16_t handle, uint8_t status,
+                                   uint8_t tx_phy, uint8_t rx_phy) {
+  tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(handle);
+  if (p_lcb == NULL) return;
+
+  p_lcb->tuner.OnPhyUpdated(status == HCI_SUCCESS, tx_phy, rx_phy);
+}
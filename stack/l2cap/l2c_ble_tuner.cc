@@ -0,0 +1,200 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "stack/l2cap/l2c_ble_tuner.h"
+
+#include <algorithm>
+
+namespace {
+
+/* PHYs of the LE PHY Update Complete event */
+constexpr uint8_t kPhy1m = 0x01;
+constexpr uint8_t kPhy2m = 0x02;
+
+/* Largest supervision timeout, in 10 ms */
+constexpr uint32_t kMaxTimeout = 0x0C80;
+
+uint8_t saturated_add(uint8_t count, uint64_t n) {
+  return static_cast<uint8_t>(std::min<uint64_t>(count + n, UINT8_MAX));
+}
+
+}  // namespace
+
+void LeLinkTuner::Reset(uint64_t now_ms, const tL2C_BLE_CONN_PARAMS& params,
+                        uint8_t quirks) {
+  base_ = params;
+  window_start_ms_ = now_ms;
+  window_bytes_ = 0;
+  window_queue_ = 0;
+  rate_ = 0;
+  peak_rate_ = 0;
+  bulk_count_ = 0;
+  idle_count_ = 0;
+  load_ = LeLinkLoad::kDefault;
+  busy_windows_ = 0;
+  quiet_windows_ = 0;
+  idle_windows_ = 0;
+  phy_windows_ = 0;
+  quirks_ = quirks;
+  conn_update_failures_ = 0;
+  phy_failures_ = 0;
+  params_pinned_ = false;
+  conn_update_pending_ = false;
+  phy_pending_ = false;
+  phy_2m_ = false;
+  phy_pinned_ = false;
+}
+
+bool LeLinkTuner::Count(uint64_t now_ms, uint32_t bytes, uint16_t queued) {
+  LeLinkLoad load = load_;
+  if (now_ms - window_start_ms_ >= kWindowMs) CloseWindows(now_ms, queued);
+  window_bytes_ += bytes;
+  window_queue_ = std::max(window_queue_, queued);
+  return load != load_;
+}
+
+void LeLinkTuner::CloseWindows(uint64_t now_ms, uint16_t queued) {
+  /* A window only closes on traffic or on a tick, it may span many */
+  uint64_t elapsed_ms = now_ms - window_start_ms_;
+  uint64_t windows = elapsed_ms / kWindowMs;
+  uint32_t rate =
+      static_cast<uint32_t>(uint64_t{window_bytes_} * 1000 / elapsed_ms);
+  rate_ = windows > 4 ? rate : (3 * rate_ + rate) / 4;
+  peak_rate_ = std::max(peak_rate_, rate);
+
+  bool busy = rate >= kBulkRate || window_queue_ >= kBulkQueue;
+  bool quiet = rate < kQuietRate && window_queue_ < kQuietQueue;
+  bool idle = window_bytes_ < kIdleBytes * windows;
+  busy_windows_ = busy ? saturated_add(busy_windows_, 1) : 0;
+  quiet_windows_ = quiet ? saturated_add(quiet_windows_, windows) : 0;
+  idle_windows_ = idle ? saturated_add(idle_windows_, windows) : 0;
+
+  if (phy_pending_) {
+    phy_windows_ = saturated_add(phy_windows_, windows);
+    if (phy_windows_ >= kPhyUpdateWindows) {
+      phy_pending_ = false;
+      PhyFailed();
+    }
+  }
+
+  window_start_ms_ = now_ms;
+  window_bytes_ = 0;
+  window_queue_ = queued;
+
+  LeLinkLoad load = load_;
+  switch (load_) {
+    case LeLinkLoad::kDefault:
+      if (busy_windows_ >= kBulkEnterWindows) {
+        load = LeLinkLoad::kBulk;
+      } else if (idle_windows_ >= kIdleWindows) {
+        load = LeLinkLoad::kIdle;
+      }
+      break;
+    case LeLinkLoad::kBulk:
+      if (quiet_windows_ >= kBulkExitWindows) load = LeLinkLoad::kDefault;
+      break;
+    case LeLinkLoad::kIdle:
+      if (!idle) load = LeLinkLoad::kDefault;
+      break;
+  }
+  if (load == load_) return;
+
+  load_ = load;
+  busy_windows_ = 0;
+  quiet_windows_ = 0;
+  idle_windows_ = 0;
+  if (load_ == LeLinkLoad::kBulk) bulk_count_++;
+  if (load_ == LeLinkLoad::kIdle) idle_count_++;
+}
+
+tL2C_BLE_CONN_PARAMS LeLinkTuner::Params() const {
+  tL2C_BLE_CONN_PARAMS params = base_;
+  switch (load_) {
+    case LeLinkLoad::kDefault:
+      break;
+    case LeLinkLoad::kBulk:
+      params.min_int = kBulkMinInt;
+      params.max_int = kBulkMaxInt;
+      params.latency = 0;
+      break;
+    case LeLinkLoad::kIdle: {
+      if (base_.min_int >= kIdleMinInt) break;
+      params.min_int = kIdleMinInt;
+      params.max_int = std::max(kIdleMaxInt, base_.max_int);
+      /* The timeout must be over twice the longest time between two
+       * connection events, in 10 ms from 1.25 ms intervals */
+      uint32_t timeout = (1 + uint32_t{params.latency}) * params.max_int / 4;
+      params.timeout = static_cast<uint16_t>(
+          std::min(std::max(uint32_t{params.timeout}, timeout + 1),
+                   kMaxTimeout));
+      break;
+    }
+  }
+  return params;
+}
+
+bool LeLinkTuner::WantsConnUpdate() const {
+  return !params_pinned_ && !(quirks_ & kNoConnUpdate);
+}
+
+bool LeLinkTuner::Wants2mPhy() const {
+  return load_ == LeLinkLoad::kBulk && !phy_2m_ && !phy_pending_ &&
+         !phy_pinned_ && !(quirks_ & kNo2mPhy);
+}
+
+void LeLinkTuner::OnConnUpdateDone(bool success) {
+  if (!conn_update_pending_) return;
+  conn_update_pending_ = false;
+  if (success) {
+    conn_update_failures_ = 0;
+  } else {
+    ConnUpdateFailed();
+  }
+}
+
+void LeLinkTuner::OnPhyRequested() {
+  phy_pending_ = true;
+  phy_windows_ = 0;
+}
+
+void LeLinkTuner::OnPhyUpdated(bool success, uint8_t tx_phy, uint8_t rx_phy) {
+  bool is_2m = tx_phy == kPhy2m && rx_phy == kPhy2m;
+  if (phy_pending_) {
+    phy_pending_ = false;
+    /* A peer refusing 2M completes the update on the PHY it was on */
+    if (success && is_2m) {
+      phy_failures_ = 0;
+    } else {
+      PhyFailed();
+    }
+  } else if (success && !is_2m && (tx_phy != kPhy1m || rx_phy != kPhy1m)) {
+    /* LE Coded PHY, most likely for range */
+    phy_pinned_ = true;
+  }
+  if (success) phy_2m_ = is_2m;
+}
+
+void LeLinkTuner::ConnUpdateFailed() {
+  conn_update_failures_ = saturated_add(conn_update_failures_, 1);
+  if (conn_update_failures_ >= kMaxFailures) quirks_ |= kNoConnUpdate;
+}
+
+void LeLinkTuner::PhyFailed() {
+  phy_failures_ = saturated_add(phy_failures_, 1);
+  if (phy_failures_ >= kMaxFailures) quirks_ |= kNo2mPhy;
+}
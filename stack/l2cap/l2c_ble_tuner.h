@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Tuning of the connection parameters and PHY of an LE link to its load.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <cstdint>
+
+/* Connection parameters, in the units of the HCI commands */
+typedef struct {
+  uint16_t min_int;
+  uint16_t max_int;
+  uint16_t latency;
+  uint16_t timeout;
+} tL2C_BLE_CONN_PARAMS;
+
+/* Load of an LE link, each with its own connection parameters */
+enum class LeLinkLoad : uint8_t {
+  /* Parameters the link was connected with */
+  kDefault,
+  /* Short interval, 2M PHY and longest data length */
+  kBulk,
+  /* Long interval */
+  kIdle,
+};
+
+/* Follows the load of an LE link, from the bytes sent and received over all
+ * its channels (ATT, EATT and credit based channels) and from the depth of its
+ * transmit queue, measured over windows of kWindowMs:
+ *  - kBulkEnterWindows busy windows in a row enter kBulk, kBulkExitWindows
+ *    quiet windows in a row leave it.
+ *  - kIdleWindows windows with no traffic but keepalives enter kIdle, any
+ *    traffic leaves it.
+ * The thresholds to enter and to leave kBulk are apart, and every change
+ * restarts the counts, so the link doesn't flap between two loads.
+ *
+ * Connection updates and PHY updates that the peer fails are counted. Past
+ * kMaxFailures, they are not tried anymore on this peer: the quirks() are kept
+ * by the caller and given back to Reset() on the next connection.
+ *
+ * It is kept in tL2C_LCB, and cleared with it: it has no constructor, call
+ * Reset() when the link comes up.
+ */
+class LeLinkTuner {
+ public:
+  static constexpr uint64_t kWindowMs = 1000;
+  /* Bytes per second, or packets queued, of a busy window */
+  static constexpr uint32_t kBulkRate = 16 * 1024;
+  static constexpr uint16_t kBulkQueue = 8;
+  /* Bytes per second, and packets queued, below which a window is quiet */
+  static constexpr uint32_t kQuietRate = 4 * 1024;
+  static constexpr uint16_t kQuietQueue = 2;
+  static constexpr uint8_t kBulkEnterWindows = 2;
+  static constexpr uint8_t kBulkExitWindows = 3;
+  /* Bytes per window below which the link is idle */
+  static constexpr uint32_t kIdleBytes = 64;
+  static constexpr uint8_t kIdleWindows = 10;
+  /* Windows a PHY update is waited for before it is counted as failed */
+  static constexpr uint8_t kPhyUpdateWindows = 5;
+  static constexpr uint8_t kMaxFailures = 2;
+
+  /* Intervals of kBulk and kIdle, in 1.25 ms */
+  static constexpr uint16_t kBulkMinInt = 6;
+  static constexpr uint16_t kBulkMaxInt = 12;
+  static constexpr uint16_t kIdleMinInt = 80;
+  static constexpr uint16_t kIdleMaxInt = 120;
+
+  /* quirks() of the peer */
+  static constexpr uint8_t kNoConnUpdate = 1 << 0;
+  static constexpr uint8_t kNo2mPhy = 1 << 1;
+
+  /* The link came up with |params| */
+  void Reset(uint64_t now_ms, const tL2C_BLE_CONN_PARAMS& params,
+             uint8_t quirks);
+
+  /* Counts |bytes| sent or received, with |queued| packets waiting to be
+   * sent. Returns true if the load of the link changed */
+  bool Count(uint64_t now_ms, uint32_t bytes, uint16_t queued);
+
+  /* Connection parameters of the current load */
+  tL2C_BLE_CONN_PARAMS Params() const;
+
+  /* Whether to update the connection parameters, or to switch to 2M PHY, on
+   * the current load */
+  bool WantsConnUpdate() const;
+  bool Wants2mPhy() const;
+
+  /* The connection parameters were set by an application or by the peer,
+   * they are left as they are */
+  void PinParams() { params_pinned_ = true; }
+
+  void OnConnUpdateRequested() { conn_update_pending_ = true; }
+  void OnConnUpdateDone(bool success);
+  void OnPhyRequested();
+  void OnPhyUpdated(bool success, uint8_t tx_phy, uint8_t rx_phy);
+
+  LeLinkLoad load() const { return load_; }
+  uint8_t quirks() const { return quirks_; }
+  bool params_pinned() const { return params_pinned_; }
+  /* Smoothed throughput, in bytes per second */
+  uint32_t rate() const { return rate_; }
+  uint32_t peak_rate() const { return peak_rate_; }
+  uint32_t bulk_count() const { return bulk_count_; }
+  uint32_t idle_count() const { return idle_count_; }
+  uint8_t conn_update_failures() const { return conn_update_failures_; }
+  uint8_t phy_failures() const { return phy_failures_; }
+
+ private:
+  void CloseWindows(uint64_t now_ms, uint16_t queued);
+  void ConnUpdateFailed();
+  void PhyFailed();
+
+  tL2C_BLE_CONN_PARAMS base_;
+  uint64_t window_start_ms_;
+  uint32_t window_bytes_;
+  uint16_t window_queue_;
+  uint32_t rate_;
+  uint32_t peak_rate_;
+  uint32_t bulk_count_;
+  uint32_t idle_count_;
+  LeLinkLoad load_;
+  uint8_t busy_windows_;
+  uint8_t quiet_windows_;
+  uint8_t idle_windows_;
+  uint8_t phy_windows_;
+  uint8_t quirks_;
+  uint8_t conn_update_failures_;
+  uint8_t phy_failures_;
+  bool params_pinned_;
+  bool conn_update_pending_;
+  bool phy_pending_;
+  bool phy_2m_;
+  /* The PHY was set by an application or by the peer */
+  bool phy_pinned_;
+};
@@ -28,6 +28,7 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "common/time_util.h"
+#include "gd/common/trace_ring.h"
 #include "hcidefs.h"
 #include "l2c_int.h"
 #include "l2cdefs.h"
@@ -1579,6 +1580,9 @@ void l2c_enqueue_peer_data(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
         p_ccb, p_ccb->in_use, p_ccb->chnl_state, p_ccb->local_cid,
         p_ccb->remote_cid);
   }
+  bluetooth::common::TraceRing::Record(
+      bluetooth::common::TraceEventId::L2CAP_ENQUEUE, p_ccb->local_cid,
+      p_buf->len);
   fixed_queue_enqueue(p_ccb->xmit_hold_q, p_buf);
 
   l2cu_check_channel_congestion(p_ccb);
@@ -51,7 +51,7 @@ static const char* SAR_types[] = {"Unsegmented", "Start", "End",
 static const char* SUP_types[] = {"RR", "REJ", "RNR", "SREJ"};
 
 /* Look-up table for the CRC calculation */
-static const unsigned short crctab[256] = {
+static constexpr unsigned short crctab[256] = {
     0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601,
     0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440, 0xcc01, 0x0cc0,
     0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81,
@@ -83,6 +83,27 @@ static const unsigned short crctab[256] = {
     0x4100, 0x81c1, 0x8081, 0x4040,
 };
 
+/* Look-up tables for computing the CRC eight bytes at a time. slice[k][b] is
+ * the CRC of byte b followed by k zero bytes, so each of eight bytes is looked
+ * up independently of the others */
+typedef struct {
+  unsigned short slice[8][256];
+} tL2C_FCR_CRC_TABLES;
+
+static constexpr tL2C_FCR_CRC_TABLES l2c_fcr_make_crc_tables() {
+  tL2C_FCR_CRC_TABLES tables{};
+  for (int b = 0; b < 256; b++) tables.slice[0][b] = crctab[b];
+  for (int k = 1; k < 8; k++) {
+    for (int b = 0; b < 256; b++) {
+      unsigned short prev = tables.slice[k - 1][b];
+      tables.slice[k][b] = (prev >> 8) ^ crctab[prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+static constexpr tL2C_FCR_CRC_TABLES crc_tables = l2c_fcr_make_crc_tables();
+
 /*******************************************************************************
  *  Static local functions
 */
@@ -91,6 +112,9 @@ static void process_s_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf, uint16_t ctrl_word);
 static void process_i_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf, uint16_t ctrl_word,
                             bool delay_ack);
 static bool retransmit_i_frames(tL2C_CCB* p_ccb, uint8_t tx_seq);
+static void l2c_fcr_take_rtt_sample(tL2C_CCB* p_ccb, uint8_t num_bufs_acked);
+static void l2c_fcr_adapt_to_loss(tL2C_CCB* p_ccb);
+static void l2c_fcr_adapt_to_acks(tL2C_CCB* p_ccb, uint8_t num_bufs_acked);
 static void prepare_I_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf,
                             bool is_retransmission);
 static bool do_sar_reassembly(tL2C_CCB* p_ccb, BT_HDR* p_buf,
@@ -100,7 +124,8 @@ static bool do_sar_reassembly(tL2C_CCB* p_ccb, BT_HDR* p_buf,
  *
  * Function         l2c_fcr_updcrc
  *
- * Description      This function computes the CRC using the look-up table.
+ * Description      This function computes the CRC using the look-up tables,
+ *                  eight bytes at a time.
  *
  * Returns          CRC
  *
@@ -111,6 +136,15 @@ static unsigned short l2c_fcr_updcrc(unsigned short icrc, unsigned char* icp,
   unsigned char* cp = icp;
   int cnt = icnt;
 
+  /* The 16 bit CRC only overlaps the first two of every eight bytes */
+  for (; cnt >= 8; cnt -= 8, cp += 8) {
+    crc ^= cp[0] | (cp[1] << 8);
+    crc = crc_tables.slice[7][crc & 0xff] ^ crc_tables.slice[6][crc >> 8] ^
+          crc_tables.slice[5][cp[2]] ^ crc_tables.slice[4][cp[3]] ^
+          crc_tables.slice[3][cp[4]] ^ crc_tables.slice[2][cp[5]] ^
+          crc_tables.slice[1][cp[6]] ^ crc_tables.slice[0][cp[7]];
+  }
+
   while (cnt--) {
     crc = ((crc >> 8) & 0xff) ^ crctab[(crc & 0xff) ^ *cp++];
   }
@@ -168,6 +202,8 @@ void l2c_fcr_start_timer(tL2C_CCB* p_ccb) {
   /* The timers which are in milliseconds */
   if (p_ccb->fcrb.wait_ack) {
     tout = (uint32_t)p_ccb->our_cfg.fcr.mon_tout;
+  } else if (p_ccb->fcrb.rtrans_tout != 0) {
+    tout = p_ccb->fcrb.rtrans_tout;
   } else {
     tout = (uint32_t)p_ccb->our_cfg.fcr.rtrans_tout;
   }
@@ -269,13 +305,137 @@ bool l2c_fcr_is_flow_controlled(tL2C_CCB* p_ccb) {
     /* Check if remote side flowed us off or the transmit window is full */
     if ((p_ccb->fcrb.remote_busy) ||
         (fixed_queue_length(p_ccb->fcrb.waiting_for_ack_q) >=
-         p_ccb->peer_cfg.fcr.tx_win_sz)) {
+         l2c_fcr_get_tx_window(p_ccb))) {
       return (true);
     }
   }
   return (false);
 }
 
+/*******************************************************************************
+ *
+ * Function         l2c_fcr_get_tx_window
+ *
+ * Description      This function returns how many I-frames may be waiting for
+ *                  an ack: the peer's TxWindow, or less while adaptive eRTM
+ *                  backs off from losses.
+ *
+ * Returns          The transmit window
+ *
+ ******************************************************************************/
+uint8_t l2c_fcr_get_tx_window(const tL2C_CCB* p_ccb) {
+  CHECK(p_ccb != NULL);
+  uint8_t tx_win_sz = p_ccb->peer_cfg.fcr.tx_win_sz;
+
+  if (p_ccb->fcrb.tx_win_sz != 0 && p_ccb->fcrb.tx_win_sz < tx_win_sz)
+    tx_win_sz = p_ccb->fcrb.tx_win_sz;
+
+  return (tx_win_sz);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_fcr_take_rtt_sample
+ *
+ * Description      This function completes the round trip time measurement if
+ *                  the timed I-frame is among the ones just acked, and with
+ *                  adaptive eRTM derives the retransmission timeout from it
+ *                  following RFC 6298.
+ *
+ * Returns          -
+ *
+ ******************************************************************************/
+static void l2c_fcr_take_rtt_sample(tL2C_CCB* p_ccb, uint8_t num_bufs_acked) {
+  tL2C_FCRB* p_fcrb = &p_ccb->fcrb;
+
+  if (!p_fcrb->rtt_sample_pending ||
+      ((p_fcrb->rtt_sample_seq - p_fcrb->last_rx_ack) & L2CAP_FCR_SEQ_MODULO) >=
+          num_bufs_acked) {
+    return;
+  }
+  p_fcrb->rtt_sample_pending = false;
+
+  uint32_t rtt = (uint32_t)(bluetooth::common::time_get_os_boottime_ms() -
+                            p_fcrb->rtt_sample_start_ms);
+  tL2C_FCR_STATS* p_stats = &p_fcrb->stats;
+  if (p_stats->rtt_samples == 0 || rtt < p_stats->min_rtt_ms)
+    p_stats->min_rtt_ms = rtt;
+  if (rtt > p_stats->max_rtt_ms) p_stats->max_rtt_ms = rtt;
+
+  if (p_stats->rtt_samples++ == 0) {
+    p_fcrb->srtt_ms = rtt;
+    p_fcrb->rttvar_ms = rtt / 2;
+  } else {
+    uint32_t delta =
+        (rtt > p_fcrb->srtt_ms) ? rtt - p_fcrb->srtt_ms : p_fcrb->srtt_ms - rtt;
+    p_fcrb->rttvar_ms = (3 * p_fcrb->rttvar_ms + delta) / 4;
+    p_fcrb->srtt_ms = (7 * p_fcrb->srtt_ms + rtt) / 8;
+  }
+
+  if (!l2cb.fcr_adaptive) return;
+
+  uint32_t tout = p_fcrb->srtt_ms + 4 * p_fcrb->rttvar_ms;
+  if (tout < L2CAP_ADAPTIVE_MIN_RETRANS_TOUT)
+    tout = L2CAP_ADAPTIVE_MIN_RETRANS_TOUT;
+  if (tout > p_ccb->our_cfg.fcr.mon_tout && p_ccb->our_cfg.fcr.mon_tout != 0)
+    tout = p_ccb->our_cfg.fcr.mon_tout;
+  p_fcrb->rtrans_tout = tout;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_fcr_adapt_to_loss
+ *
+ * Description      This function is called when the peer rejected I-frames or
+ *                  the retransmission timer expired. With adaptive eRTM the
+ *                  transmit window is halved.
+ *
+ * Returns          -
+ *
+ ******************************************************************************/
+static void l2c_fcr_adapt_to_loss(tL2C_CCB* p_ccb) {
+  tL2C_FCRB* p_fcrb = &p_ccb->fcrb;
+
+  if (!l2cb.fcr_adaptive) return;
+
+  uint8_t tx_win_sz = l2c_fcr_get_tx_window(p_ccb) / 2;
+  if (tx_win_sz == 0) tx_win_sz = 1;
+  p_fcrb->tx_win_sz = tx_win_sz;
+  p_fcrb->win_acks = 0;
+
+  if (p_fcrb->stats.min_tx_window == 0 ||
+      tx_win_sz < p_fcrb->stats.min_tx_window) {
+    p_fcrb->stats.min_tx_window = tx_win_sz;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_fcr_adapt_to_acks
+ *
+ * Description      This function grows a reduced transmit window by one
+ *                  I-frame per window of I-frames acked, up to the peer's
+ *                  TxWindow.
+ *
+ * Returns          -
+ *
+ ******************************************************************************/
+static void l2c_fcr_adapt_to_acks(tL2C_CCB* p_ccb, uint8_t num_bufs_acked) {
+  tL2C_FCRB* p_fcrb = &p_ccb->fcrb;
+
+  if (p_fcrb->tx_win_sz == 0) return;
+
+  p_fcrb->win_acks += num_bufs_acked;
+  while (p_fcrb->tx_win_sz != 0 && p_fcrb->win_acks >= p_fcrb->tx_win_sz) {
+    p_fcrb->win_acks -= p_fcrb->tx_win_sz;
+    p_fcrb->tx_win_sz++;
+    if (p_fcrb->tx_win_sz >= p_ccb->peer_cfg.fcr.tx_win_sz) {
+      p_fcrb->tx_win_sz = 0;
+      p_fcrb->win_acks = 0;
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         prepare_I_frame
@@ -306,11 +466,21 @@ static void prepare_I_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf,
     STREAM_TO_UINT16(ctrl_word, p);
 
     ctrl_word &= ~(L2CAP_FCR_REQ_SEQ_BITS + L2CAP_FCR_F_BIT);
+
+    p_fcrb->stats.i_frames_retransmitted++;
   } else {
     ctrl_word = p_buf->layer_specific & L2CAP_FCR_SEG_BITS; /* SAR bits */
     ctrl_word |=
         (p_fcrb->next_tx_seq << L2CAP_FCR_TX_SEQ_BITS_SHIFT); /* Tx Seq */
 
+    p_fcrb->stats.i_frames_sent++;
+    if (!p_fcrb->rtt_sample_pending &&
+        p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_ERTM_MODE) {
+      p_fcrb->rtt_sample_pending = true;
+      p_fcrb->rtt_sample_seq = p_fcrb->next_tx_seq;
+      p_fcrb->rtt_sample_start_ms = bluetooth::common::time_get_os_boottime_ms();
+    }
+
     p_fcrb->next_tx_seq = (p_fcrb->next_tx_seq + 1) & L2CAP_FCR_SEQ_MODULO;
   }
 
@@ -717,6 +887,12 @@ void l2c_lcc_proc_pdu(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
       return;
     }
 
+    /* Unsegmented SDU, pass the PDU buffer up rather than a copy of it */
+    if (sdu_length == p_buf->len) {
+      l2c_csm_execute(p_ccb, L2CEVT_L2CAP_DATA, p_buf);
+      return;
+    }
+
     p_data = (BT_HDR*)osi_malloc(BT_HDR_SIZE + sdu_length);
     if (p_data == NULL) {
       osi_free(p_buf);
@@ -782,6 +958,20 @@ void l2c_fcr_proc_tout(tL2C_CCB* p_ccb) {
       p_ccb->local_cid, p_ccb->fcrb.num_tries, p_ccb->peer_cfg.fcr.max_transmit,
       p_ccb->fcrb.wait_ack, fixed_queue_length(p_ccb->fcrb.waiting_for_ack_q));
 
+  if (!p_ccb->fcrb.wait_ack) {
+    /* The retransmission timer expired: back off like RFC 6298 */
+    p_ccb->fcrb.stats.retrans_timeouts++;
+    p_ccb->fcrb.rtt_sample_pending = false;
+    if (l2cb.fcr_adaptive && p_ccb->fcrb.rtrans_tout != 0) {
+      p_ccb->fcrb.rtrans_tout *= 2;
+      if (p_ccb->our_cfg.fcr.mon_tout != 0 &&
+          p_ccb->fcrb.rtrans_tout > p_ccb->our_cfg.fcr.mon_tout) {
+        p_ccb->fcrb.rtrans_tout = p_ccb->our_cfg.fcr.mon_tout;
+      }
+    }
+    l2c_fcr_adapt_to_loss(p_ccb);
+  }
+
   if ((p_ccb->peer_cfg.fcr.max_transmit != 0) &&
       (++p_ccb->fcrb.num_tries > p_ccb->peer_cfg.fcr.max_transmit)) {
     l2cu_disconnect_chnl(p_ccb);
@@ -862,6 +1052,11 @@ static bool process_reqseq(tL2C_CCB* p_ccb, uint16_t ctrl_word) {
     return (false);
   }
 
+  if (num_bufs_acked != 0) {
+    l2c_fcr_take_rtt_sample(p_ccb, num_bufs_acked);
+    l2c_fcr_adapt_to_acks(p_ccb, num_bufs_acked);
+  }
+
   p_fcrb->last_rx_ack = req_seq;
 
   /* Now we can release all acknowledged frames, and restart the retransmission
@@ -947,6 +1142,8 @@ static void process_s_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf,
 
     case L2CAP_FCR_SUP_REJ:
       p_fcrb->remote_busy = false;
+      p_fcrb->stats.rejects_received++;
+      l2c_fcr_adapt_to_loss(p_ccb);
       all_ok = retransmit_i_frames(p_ccb, L2C_FCR_RETX_ALL_PKTS);
       break;
 
@@ -957,6 +1154,8 @@ static void process_s_frame(tL2C_CCB* p_ccb, BT_HDR* p_buf,
 
     case L2CAP_FCR_SUP_SREJ:
       p_fcrb->remote_busy = false;
+      p_fcrb->stats.rejects_received++;
+      l2c_fcr_adapt_to_loss(p_ccb);
       all_ok = retransmit_i_frames(
           p_ccb, (uint8_t)((ctrl_word & L2CAP_FCR_REQ_SEQ_BITS) >>
                            L2CAP_FCR_REQ_SEQ_BITS_SHIFT));
@@ -1283,6 +1482,9 @@ static bool retransmit_i_frames(tL2C_CCB* p_ccb, uint8_t tx_seq) {
     return (false);
   }
 
+  /* The timed I-frame may be among the ones sent again */
+  p_ccb->fcrb.rtt_sample_pending = false;
+
   /* tx_seq indicates whether to retransmit a specific sequence or all (if ==
    * L2C_FCR_RETX_ALL_PKTS) */
   list_t* list_ack = NULL;
@@ -1529,35 +1731,41 @@ BT_HDR* l2c_lcc_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
       p_buf->len,
       (uint16_t)(first_pdu ? (max_pdu - L2CAP_LCC_SDU_LENGTH) : max_pdu));
   bool last_pdu = (no_of_bytes_to_send == p_buf->len);
+  uint16_t headers_offset = first_pdu ? L2CAP_LCC_OFFSET : L2CAP_MIN_OFFSET;
+  uint16_t sdu_length = p_buf->len;
 
-  /* Get a new buffer and copy the data that can be sent in a PDU */
-  BT_HDR* p_xmit =
-      l2c_fcr_clone_buf(p_buf, first_pdu ? L2CAP_LCC_OFFSET : L2CAP_MIN_OFFSET,
-                        no_of_bytes_to_send);
+  BT_HDR* p_xmit;
+  if (last_pdu && p_buf->offset >= headers_offset) {
+    /* Send the last piece from the SDU buffer, the pieces already sent left
+     * room for the headers in front of it */
+    p_xmit = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
+  } else {
+    /* Get a new buffer and copy the data that can be sent in a PDU */
+    p_xmit = l2c_fcr_clone_buf(p_buf, headers_offset, no_of_bytes_to_send);
+    p_buf->event = p_ccb->local_cid;
+    p_buf->len -= no_of_bytes_to_send;
+    p_buf->offset += no_of_bytes_to_send;
+
+    /* copy PBF setting */
+    p_xmit->layer_specific = p_buf->layer_specific;
+
+    if (last_pdu) {
+      p_buf = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
+      osi_free(p_buf);
+    }
+  }
 
-  p_buf->event = p_ccb->local_cid;
   p_xmit->event = p_ccb->local_cid;
 
   if (first_pdu) {
     p_xmit->offset -= L2CAP_LCC_SDU_LENGTH; /* for writing the SDU length. */
     uint8_t* p = (uint8_t*)(p_xmit + 1) + p_xmit->offset;
-    UINT16_TO_STREAM(p, p_buf->len);
+    UINT16_TO_STREAM(p, sdu_length);
     p_xmit->len += L2CAP_LCC_SDU_LENGTH;
   }
 
-  p_buf->len -= no_of_bytes_to_send;
-  p_buf->offset += no_of_bytes_to_send;
-
-  /* copy PBF setting */
-  p_xmit->layer_specific = p_buf->layer_specific;
-
   if (last_piece_of_sdu) *last_piece_of_sdu = last_pdu;
 
-  if (last_pdu) {
-    p_buf = (BT_HDR*)fixed_queue_try_dequeue(p_ccb->xmit_hold_q);
-    osi_free(p_buf);
-  }
-
   /* Step back to add the L2CAP headers */
   p_xmit->offset -= L2CAP_PKT_OVERHEAD;
   p_xmit->len += L2CAP_PKT_OVERHEAD;
@@ -25,6 +25,7 @@
 #define L2C_INT_H
 
 #include <stdbool.h>
+#include <algorithm>
 #include <string>
 
 #include "bt_common.h"
@@ -40,6 +41,7 @@
 #include "osi/include/fixed_queue.h"
 #include "osi/include/list.h"
 #include "stack/include/hci_error_code.h"
+#include "stack/l2cap/l2c_ble_tuner.h"
 #include "types/hci_role.h"
 
 #define L2CAP_MIN_MTU 48 /* Minimum acceptable MTU is 48 bytes */
@@ -219,8 +221,24 @@ typedef enum : uint16_t {
 
 #define L2CAP_MAX_FCR_CFG_TRIES 2 /* Config attempts before disconnecting */
 
+/* Floor of the adapted retransmission timeout. The peer may hold its acks for
+ * up to its own ack timeout, so a timeout below that only causes polls. */
+#define L2CAP_ADAPTIVE_MIN_RETRANS_TOUT (2 * L2CAP_FCR_ACK_TIMEOUT_MS)
+
 typedef uint8_t tL2C_BLE_FIXED_CHNLS_MASK;
 
+/* Per channel eRTM transmit statistics, shown in dumpsys */
+typedef struct {
+  uint32_t i_frames_sent;          /* I-frames sent the first time */
+  uint32_t i_frames_retransmitted; /* I-frames sent again */
+  uint32_t retrans_timeouts;       /* Retransmission timer expiries */
+  uint32_t rejects_received;       /* REJ and SREJ frames from the peer */
+  uint32_t rtt_samples;            /* Round trip times measured */
+  uint32_t min_rtt_ms;
+  uint32_t max_rtt_ms;
+  uint8_t min_tx_window; /* Smallest adapted transmit window, 0 if none */
+} tL2C_FCR_STATS;
+
 typedef struct {
   uint8_t next_tx_seq;       /* Next sequence number to be Tx'ed */
   uint8_t last_rx_ack;       /* Last sequence number ack'ed by the peer */
@@ -248,6 +266,20 @@ typedef struct {
   alarm_t* ack_timer;         /* Timer delaying RR */
   alarm_t* mon_retrans_timer; /* Timer Monitor or Retransmission */
 
+  /* Round trip time of one I-frame at a time, from its first transmission to
+   * its ack. Frames which get retransmitted are not timed (Karn). */
+  bool rtt_sample_pending;      /* An I-frame is being timed */
+  uint8_t rtt_sample_seq;       /* TxSeq of the timed I-frame */
+  uint64_t rtt_sample_start_ms; /* When the timed I-frame was sent */
+  uint32_t srtt_ms;             /* Smoothed round trip time */
+  uint32_t rttvar_ms;           /* Round trip time variation */
+
+  /* With adaptive eRTM, 0 until adapted: use the configured value */
+  uint32_t rtrans_tout; /* Retransmission timeout in milliseconds */
+  uint8_t tx_win_sz;    /* Transmit window, at most the peer's */
+  uint8_t win_acks;     /* I-frames acked since the window last grew */
+
+  tL2C_FCR_STATS stats;
 } tL2C_FCRB;
 
 typedef struct {
@@ -477,6 +509,8 @@ typedef struct t_l2c_linkcb {
 
   bool partial_segment_being_sent; /* Set true when a partial segment */
                                    /* is being sent. */
+  bool acl_tx_congested;           /* Set true while the ACL layer below */
+                                   /* holds too many packets of the link */
   bool w4_info_rsp;                /* true when info request is active */
   uint32_t peer_ext_fea;           /* Peer's extended features mask */
   list_t* link_xmit_data_q;        /* Link transmit data buffer queue */
@@ -525,6 +559,8 @@ typedef struct t_l2c_linkcb {
   uint16_t min_ce_len;
   uint16_t max_ce_len;
 
+  LeLinkTuner tuner; /* Connection parameters and PHY for the LE link load */
+
   /* each priority group is limited burst transmission */
   /* round robin service for the same priority channels */
   tL2C_RR_SERV rr_serv[L2CAP_NUM_CHNL_PRIORITY];
@@ -572,6 +608,20 @@ typedef struct {
       round_robin_unacked = 0;
   }
 
+  /* Controller buffers taken beyond controller_xmit_window by PDUs that are
+   * sent whole, and repaid out of the next completed packets */
+  uint16_t controller_xmit_overdraft;
+  void take_classic_xmit_window(uint16_t num_packets) {
+    uint16_t taken = std::min(controller_xmit_window, num_packets);
+    controller_xmit_window -= taken;
+    controller_xmit_overdraft += num_packets - taken;
+  }
+  void return_classic_xmit_window(uint16_t num_packets) {
+    uint16_t repaid = std::min(controller_xmit_overdraft, num_packets);
+    controller_xmit_overdraft -= repaid;
+    controller_xmit_window += num_packets - repaid;
+  }
+
   bool check_round_robin;       /* Do a round robin check */
 
   bool is_cong_cback_context;
@@ -620,9 +670,27 @@ typedef struct {
       ble_round_robin_unacked = 0;
   }
 
+  /* As controller_xmit_overdraft, for the LE buffers */
+  uint16_t controller_le_xmit_overdraft;
+  void take_le_xmit_window(uint16_t num_packets) {
+    uint16_t taken = std::min(controller_le_xmit_window, num_packets);
+    controller_le_xmit_window -= taken;
+    controller_le_xmit_overdraft += num_packets - taken;
+  }
+  void return_le_xmit_window(uint16_t num_packets) {
+    uint16_t repaid = std::min(controller_le_xmit_overdraft, num_packets);
+    controller_le_xmit_overdraft -= repaid;
+    controller_le_xmit_window += num_packets - repaid;
+  }
+
   bool ble_check_round_robin;       /* Do a round robin check */
   tL2C_RCB ble_rcb_pool[BLE_MAX_L2CAP_CLIENTS]; /* Registration info pool */
 
+  bool fcr_adaptive; /* Adapt eRTM timers and window to the link */
+
+  bool ble_tuner_enabled;   /* Tune LE links to their load */
+  alarm_t* ble_tuner_timer; /* Closes the load windows of quiet LE links */
+
   uint16_t le_dyn_psm; /* Next LE dynamic PSM value to try to assign */
   bool le_dyn_psm_assigned[LE_DYNAMIC_PSM_RANGE]; /* Table of assigned LE PSM */
 
@@ -675,6 +743,7 @@ extern void l2cu_release_lcb(tL2C_LCB* p_lcb);
 extern tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                           tBT_TRANSPORT transport);
 extern tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle);
+extern void l2cu_clear_lcb_indexes(void);
 
 extern bool l2cu_set_acl_priority(const RawAddress& bd_addr,
                                   tL2CAP_PRIORITY priority,
@@ -812,6 +881,7 @@ extern void l2c_fcr_send_S_frame(tL2C_CCB* p_ccb, uint16_t function_code,
 extern BT_HDR* l2c_fcr_clone_buf(BT_HDR* p_buf, uint16_t new_offset,
                                  uint16_t no_of_bytes);
 extern bool l2c_fcr_is_flow_controlled(tL2C_CCB* p_ccb);
+extern uint8_t l2c_fcr_get_tx_window(const tL2C_CCB* p_ccb);
 extern BT_HDR* l2c_fcr_get_next_xmit_sdu_seg(tL2C_CCB* p_ccb,
                                              uint16_t max_packet_length);
 extern void l2c_fcr_start_timer(tL2C_CCB* p_ccb);
@@ -850,6 +920,9 @@ extern tL2CAP_LE_RESULT_CODE l2ble_sec_access_req(const RawAddress& bd_addr,
                                                   void* p_ref_data);
 
 extern void l2cble_update_data_length(tL2C_LCB* p_lcb);
+extern void l2cble_tuner_count(tL2C_LCB* p_lcb, uint32_t bytes);
+extern void l2cble_tuner_stop(tL2C_LCB* p_lcb);
+extern const char* l2cble_tuner_load_text(LeLinkLoad load);
 
 extern void l2cu_process_fixed_disc_cback(tL2C_LCB* p_lcb);
 
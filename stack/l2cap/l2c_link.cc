@@ -28,6 +28,7 @@
 #include <cstdint>
 
 #include "device/include/controller.h"
+#include "gd/common/trace_ring.h"
 #include "main/shim/l2c_api.h"
 #include "main/shim/shim.h"
 #include "osi/include/log.h"
@@ -41,6 +42,9 @@
 #include "types/bt_transport.h"
 #include "types/raw_address.h"
 
+using bluetooth::common::TraceEventId;
+using bluetooth::common::TraceRing;
+
 extern tBTM_CB btm_cb;
 
 bool BTM_ReadPowerMode(const RawAddress& remote_bda, tBTM_PM_MODE* p_mode);
@@ -926,7 +930,7 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, uint16_t local_cid,
       }
 
       if ((!p_lcb->in_use) || (p_lcb->partial_segment_being_sent) ||
-          (p_lcb->link_state != LST_CONNECTED) ||
+          (p_lcb->acl_tx_congested) || (p_lcb->link_state != LST_CONNECTED) ||
           (p_lcb->link_xmit_quota != 0) || (l2c_link_check_power_mode(p_lcb))) {
         LOG_DEBUG("Skipping lcb %d due to quota", xx);
         continue;
@@ -973,6 +977,13 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, uint16_t local_cid,
       LOG_INFO("A partial segment is being sent, cannot send anything else");
       return;
     }
+    /* Hold the data in L2CAP, where it is seen by the channel congestion
+     * callbacks, while the ACL layer below has too much of it queued */
+    if (p_lcb->acl_tx_congested) {
+      LOG_DEBUG("ACL tx congested handle:0x%04x, holding data",
+                p_lcb->Handle());
+      return;
+    }
     LOG_DEBUG(
         "Direct send, transport=%d, xmit_window=%d, le_xmit_window=%d, "
         "sent_not_acked=%d, link_xmit_quota=%d",
@@ -985,7 +996,8 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, uint16_t local_cid,
              (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
             (l2cb.controller_le_xmit_window != 0 &&
              (p_lcb->transport == BT_TRANSPORT_LE))) &&
-           (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
+           (p_lcb->sent_not_acked < p_lcb->link_xmit_quota) &&
+           !p_lcb->acl_tx_congested) {
       if (list_is_empty(p_lcb->link_xmit_data_q)) {
         LOG_DEBUG("No transmit data, skipping");
         break;
@@ -1003,7 +1015,8 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, uint16_t local_cid,
                (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
               (l2cb.controller_le_xmit_window != 0 &&
                (p_lcb->transport == BT_TRANSPORT_LE))) &&
-             (p_lcb->sent_not_acked < p_lcb->link_xmit_quota)) {
+             (p_lcb->sent_not_acked < p_lcb->link_xmit_quota) &&
+             !p_lcb->acl_tx_congested) {
         p_buf = l2cu_get_next_buffer_to_send(p_lcb);
         if (p_buf == NULL) {
           LOG_DEBUG("No next buffer, skipping");
@@ -1037,6 +1050,40 @@ void l2c_OnHciModeChangeSendPendingPackets(RawAddress remote) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         l2c_link_account_whole_pdu
+ *
+ * Description      With the GD ACL manager, PDUs are sent down whole and
+ *                  fragmented below, while the controller completes each
+ *                  fragment. Account the PDU for all of its fragments, so that
+ *                  the windows follow the controller buffers and data waits in
+ *                  the priority aware L2CAP queues rather than below. The
+ *                  fragments beyond the window are repaid out of the next
+ *                  completed packets.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_link_account_whole_pdu(tL2C_LCB* p_lcb, BT_HDR* p_buf,
+                                       uint16_t acl_data_size) {
+  uint16_t num_segs = 1;
+  if (p_buf->len > HCI_DATA_PREAMBLE_SIZE && acl_data_size != 0) {
+    num_segs = (p_buf->len - HCI_DATA_PREAMBLE_SIZE + acl_data_size - 1) /
+               acl_data_size;
+  }
+
+  p_lcb->sent_not_acked += num_segs;
+  p_buf->layer_specific = 0;
+  if (p_lcb->transport == BT_TRANSPORT_LE) {
+    l2cb.take_le_xmit_window(num_segs);
+    if (p_lcb->link_xmit_quota == 0) l2cb.ble_round_robin_unacked += num_segs;
+  } else {
+    l2cb.take_classic_xmit_window(num_segs);
+    if (p_lcb->link_xmit_quota == 0) l2cb.round_robin_unacked += num_segs;
+  }
+}
+
 /*******************************************************************************
  *
  * Function         l2c_link_send_to_lower
@@ -1051,11 +1098,11 @@ static void l2c_link_send_to_lower_br_edr(tL2C_LCB* p_lcb, BT_HDR* p_buf) {
       controller_get_interface()->get_acl_data_size_classic();
   const uint16_t link_xmit_quota = p_lcb->link_xmit_quota;
   const bool is_bdr_and_fits_in_buffer =
-      bluetooth::shim::is_gd_acl_enabled()
-          ? true
-          : (p_buf->len <= acl_packet_size_classic);
+      (p_buf->len <= acl_packet_size_classic);
 
-  if (is_bdr_and_fits_in_buffer) {
+  if (bluetooth::shim::is_gd_acl_enabled()) {
+    l2c_link_account_whole_pdu(p_lcb, p_buf, acl_data_size_classic);
+  } else if (is_bdr_and_fits_in_buffer) {
     if (link_xmit_quota == 0) {
       l2cb.round_robin_unacked++;
     }
@@ -1104,7 +1151,9 @@ static void l2c_link_send_to_lower_ble(tL2C_LCB* p_lcb, BT_HDR* p_buf) {
   const uint16_t link_xmit_quota = p_lcb->link_xmit_quota;
   const bool is_ble_and_fits_in_buffer = (p_buf->len <= acl_packet_size_ble);
 
-  if (is_ble_and_fits_in_buffer) {
+  if (bluetooth::shim::is_gd_acl_enabled()) {
+    l2c_link_account_whole_pdu(p_lcb, p_buf, acl_data_size_ble);
+  } else if (is_ble_and_fits_in_buffer) {
     if (link_xmit_quota == 0) {
       l2cb.ble_round_robin_unacked++;
     }
@@ -1138,6 +1187,7 @@ static void l2c_link_send_to_lower_ble(tL2C_LCB* p_lcb, BT_HDR* p_buf) {
     l2cb.controller_le_xmit_window -= num_segs;
     if (p_lcb->link_xmit_quota == 0) l2cb.ble_round_robin_unacked += num_segs;
   }
+  l2cble_tuner_count(p_lcb, p_buf->len);
   acl_send_data_packet_ble(p_lcb->remote_bd_addr, p_buf);
   LOG_DEBUG("TotalWin=%d,Hndl=0x%x,Quota=%d,Unack=%d,RRQuota=%d,RRUnack=%d",
             l2cb.controller_le_xmit_window, p_lcb->Handle(),
@@ -1259,6 +1309,29 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         l2c_link_tx_congestion
+ *
+ * Description      This function is called when the ACL layer below starts or
+ *                  stops holding too many packets of a link. While congested,
+ *                  the data of the link is kept in the L2CAP queues. The
+ *                  congestion is reported from within l2c_link_send_to_lower,
+ *                  so the send loops stop at the packet that caused it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_link_tx_congestion(uint16_t handle, bool congested) {
+  tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(handle);
+  if (p_lcb == nullptr) {
+    LOG_WARN("Received ACL tx congestion for unknown ACL");
+    return;
+  }
+  p_lcb->acl_tx_congested = congested;
+  if (!congested) l2c_link_check_send_pkts(p_lcb, 0, NULL);
+}
+
 void l2c_packets_completed(uint16_t handle, uint16_t num_sent) {
   tL2C_LCB* p_lcb = l2cu_find_lcb_by_handle(handle);
   if (p_lcb == nullptr) {
@@ -1269,12 +1342,12 @@ void l2c_packets_completed(uint16_t handle, uint16_t num_sent) {
 
   switch (p_lcb->transport) {
     case BT_TRANSPORT_BR_EDR:
-      l2cb.controller_xmit_window += num_sent;
+      l2cb.return_classic_xmit_window(num_sent);
       if (p_lcb->is_round_robin_scheduling())
         l2cb.update_outstanding_classic_packets(num_sent);
       break;
     case BT_TRANSPORT_LE:
-      l2cb.controller_le_xmit_window += num_sent;
+      l2cb.return_le_xmit_window(num_sent);
       if (p_lcb->is_round_robin_scheduling())
         l2cb.update_outstanding_le_packets(num_sent);
       break;
@@ -1511,6 +1584,8 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb) {
       p_buf = l2c_fcr_get_next_xmit_sdu_seg(p_ccb, 0);
       if (p_buf != NULL) {
         l2cu_check_channel_congestion(p_ccb);
+        TraceRing::Record(TraceEventId::L2CAP_DEQUEUE, p_ccb->local_cid,
+                          p_buf->len);
         l2cu_set_acl_hci_header(p_buf, p_ccb);
         return (p_buf);
       }
@@ -1523,6 +1598,8 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb) {
         }
 
         l2cu_check_channel_congestion(p_ccb);
+        TraceRing::Record(TraceEventId::L2CAP_DEQUEUE, p_ccb->local_cid,
+                          p_buf->len);
         l2cu_set_acl_hci_header(p_buf, p_ccb);
         return (p_buf);
       }
@@ -1570,6 +1647,7 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb) {
 
   l2cu_check_channel_congestion(p_ccb);
 
+  TraceRing::Record(TraceEventId::L2CAP_DEQUEUE, p_ccb->local_cid, p_buf->len);
   l2cu_set_acl_hci_header(p_buf, p_ccb);
 
   return (p_buf);
@@ -36,6 +36,7 @@
 #include "main/shim/shim.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
@@ -143,6 +144,7 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
     /* only process fixed channel data as channel open indication when link is
      * not in disconnecting mode */
     l2cble_notify_le_connection(p_lcb->remote_bd_addr);
+    l2cble_tuner_count(p_lcb, hci_len);
   }
 
   /* Find the CCB for this CID */
@@ -913,6 +915,7 @@ void l2c_init(void) {
   int16_t xx;
 
   memset(&l2cb, 0, sizeof(tL2C_CB));
+  l2cu_clear_lcb_indexes();
 
   /* the LE PSM is increased by 1 before being used */
   l2cb.le_dyn_psm = LE_DYNAMIC_PSM_START - 1;
@@ -931,6 +934,13 @@ void l2c_init(void) {
   /* Set the default idle timeout */
   l2cb.idle_timeout = L2CAP_LINK_INACTIVITY_TOUT;
 
+  l2cb.fcr_adaptive =
+      osi_property_get_bool("persist.bluetooth.l2cap.adaptive_ertm", false);
+  /* Opt-in: the tuner changes the connection parameters and PHY that the
+   * peers and applications see */
+  l2cb.ble_tuner_enabled =
+      osi_property_get_bool("persist.bluetooth.le.link_tuner", false);
+
 #if defined(L2CAP_INITIAL_TRACE_LEVEL)
   l2cb.l2cap_trace_level = L2CAP_INITIAL_TRACE_LEVEL;
 #else
@@ -952,6 +962,7 @@ void l2c_init(void) {
   CHECK(l2cb.rcv_pending_q != NULL);
 
   l2cb.receive_hold_timer = alarm_new("l2c.receive_hold_timer");
+  l2cb.ble_tuner_timer = alarm_new_periodic("l2c.ble_tuner_timer");
 }
 
 void l2c_free(void) {
@@ -962,6 +973,8 @@ void l2c_free(void) {
 
   list_free(l2cb.rcv_pending_q);
   l2cb.rcv_pending_q = NULL;
+  alarm_free(l2cb.ble_tuner_timer);
+  l2cb.ble_tuner_timer = NULL;
 }
 
 void l2c_receive_hold_timer_timeout(UNUSED_ATTR void* data) {
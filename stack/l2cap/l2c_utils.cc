@@ -26,6 +26,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <unordered_map>
+
 #include "bt_common.h"
 #include "bt_types.h"
 #include "btm_api.h"
@@ -44,6 +46,29 @@
 
 tL2C_CCB* l2cu_get_next_channel_in_rr(tL2C_LCB* p_lcb); // TODO Move
 
+namespace {
+/* Indexes over the in-use LCBs of l2cb.lcb_pool, so that per packet lookups
+ * don't scan the pool. An entry may be stale, e.g. after the handle of its
+ * LCB was invalidated, so every hit is checked against the LCB itself. */
+std::unordered_map<uint16_t, tL2C_LCB*> lcb_by_handle;
+std::unordered_multimap<RawAddress, tL2C_LCB*> lcb_by_bd_addr;
+}  // namespace
+
+/*******************************************************************************
+ *
+ * Function         l2cu_clear_lcb_indexes
+ *
+ * Description      Drop all the LCB lookup indexes, for when the LCB pool is
+ *                  reset
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_clear_lcb_indexes(void) {
+  lcb_by_handle.clear();
+  lcb_by_bd_addr.clear();
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_allocate_lcb
@@ -91,6 +116,7 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
         l2c_link_adjust_allocation();
       }
       p_lcb->link_xmit_data_q = list_new(NULL);
+      lcb_by_bd_addr.emplace(p_bd_addr, p_lcb);
       return (p_lcb);
     }
   }
@@ -104,7 +130,12 @@ void l2cu_set_lcb_handle(struct t_l2c_linkcb& p_lcb, uint16_t handle) {
     LOG_WARN("Should not replace active handle:%hu with new handle:%hu",
              p_lcb.Handle(), handle);
   }
+  auto old_entry = lcb_by_handle.find(p_lcb.Handle());
+  if (old_entry != lcb_by_handle.end() && old_entry->second == &p_lcb) {
+    lcb_by_handle.erase(old_entry);
+  }
   p_lcb.SetHandle(handle);
+  if (handle != HCI_INVALID_HANDLE) lcb_by_handle[handle] = &p_lcb;
 }
 
 /*******************************************************************************
@@ -152,6 +183,19 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   p_lcb->in_use = false;
   p_lcb->ResetBonding();
 
+  auto handle_entry = lcb_by_handle.find(p_lcb->Handle());
+  if (handle_entry != lcb_by_handle.end() && handle_entry->second == p_lcb) {
+    lcb_by_handle.erase(handle_entry);
+  }
+  auto bd_addr_entries = lcb_by_bd_addr.equal_range(p_lcb->remote_bd_addr);
+  for (auto entry = bd_addr_entries.first; entry != bd_addr_entries.second;
+       entry++) {
+    if (entry->second == p_lcb) {
+      lcb_by_bd_addr.erase(entry);
+      break;
+    }
+  }
+
   /* Stop and free timers */
   alarm_free(p_lcb->l2c_lcb_timer);
   p_lcb->l2c_lcb_timer = NULL;
@@ -161,14 +205,16 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   if (p_lcb->transport == BT_TRANSPORT_BR_EDR) /* Release all SCO links */
     BTM_RemoveSco(p_lcb->remote_bd_addr);
 
+  if (p_lcb->transport == BT_TRANSPORT_LE) l2cble_tuner_stop(p_lcb);
+
   if (p_lcb->sent_not_acked > 0) {
     if (p_lcb->transport == BT_TRANSPORT_LE) {
-      l2cb.controller_le_xmit_window += p_lcb->sent_not_acked;
+      l2cb.return_le_xmit_window(p_lcb->sent_not_acked);
       if (l2cb.controller_le_xmit_window > l2cb.num_lm_ble_bufs) {
         l2cb.controller_le_xmit_window = l2cb.num_lm_ble_bufs;
       }
     } else {
-      l2cb.controller_xmit_window += p_lcb->sent_not_acked;
+      l2cb.return_classic_xmit_window(p_lcb->sent_not_acked);
       if (l2cb.controller_xmit_window > l2cb.num_lm_acl_bufs) {
         l2cb.controller_xmit_window = l2cb.num_lm_acl_bufs;
       }
@@ -229,26 +275,26 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
  *
  * Function         l2cu_find_lcb_by_bd_addr
  *
- * Description      Look through all active LCBs for a match based on the
- *                  remote BD address.
+ * Description      Find the active LCB with the given remote BD address and
+ *                  transport.
  *
  * Returns          pointer to matched LCB, or NULL if no match
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                    tBT_TRANSPORT transport) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-    if ((p_lcb->in_use) && p_lcb->transport == transport &&
-        (p_lcb->remote_bd_addr == p_bd_addr)) {
-      return (p_lcb);
+  tL2C_LCB* p_match = NULL;
+  auto entries = lcb_by_bd_addr.equal_range(p_bd_addr);
+  for (auto entry = entries.first; entry != entries.second; entry++) {
+    tL2C_LCB* p_lcb = entry->second;
+    /* Should there be several, the first one of the pool wins */
+    if (p_lcb->in_use && p_lcb->transport == transport &&
+        (p_match == NULL || p_lcb < p_match)) {
+      p_match = p_lcb;
     }
   }
 
-  /* If here, no match found */
-  return (NULL);
+  return (p_match);
 }
 
 /*******************************************************************************
@@ -3109,22 +3155,26 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  *
  * Function         l2cu_find_lcb_by_handle
  *
- * Description      Look through all active LCBs for a match based on the
- *                  HCI handle.
+ * Description      Find the active LCB with the given HCI handle.
  *
  * Returns          pointer to matched LCB, or NULL if no match
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
-
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-    if ((p_lcb->in_use) && (p_lcb->Handle() == handle)) {
-      return (p_lcb);
+  if (handle == HCI_INVALID_HANDLE) {
+    /* Links which are not connected yet are not indexed */
+    for (tL2C_LCB& lcb : l2cb.lcb_pool) {
+      if (lcb.in_use && lcb.Handle() == handle) return (&lcb);
     }
+    return (NULL);
   }
 
+  auto entry = lcb_by_handle.find(handle);
+  if (entry == lcb_by_handle.end()) return (NULL);
+
+  tL2C_LCB* p_lcb = entry->second;
+  if (p_lcb->in_use && p_lcb->Handle() == handle) return (p_lcb);
+
   /* If here, no match found */
   return (NULL);
 }
@@ -17,16 +17,65 @@
 #include <frameworks/proto_logging/stats/enums/bluetooth/enums.pb.h>
 #include <frameworks/proto_logging/stats/enums/bluetooth/hci/enums.pb.h>
 
+#include <base/bind.h>
+#include <base/location.h>
+#include <base/logging.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/message_loop_thread.h"
 #include "common/metrics.h"
 #include "main/shim/metrics_api.h"
 #include "main/shim/shim.h"
 #include "stack/include/stack_metrics_logging.h"
 #include "types/raw_address.h"
 
-void log_classic_pairing_event(const RawAddress& address, uint16_t handle,
-                               uint32_t hci_cmd, uint16_t hci_event,
-                               uint16_t cmd_status, uint16_t reason_code,
-                               int64_t event_value) {
+using bluetooth::common::MessageLoopThread;
+
+namespace {
+
+// Obfuscating the address and writing the atom is done on this thread, away
+// from the protocol threads that report the events
+MessageLoopThread metrics_thread("bt_metrics_thread");
+
+std::mutex pending_mutex;
+std::vector<base::OnceClosure> pending_events;
+
+void emit_pending_events() {
+  std::vector<base::OnceClosure> events;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    events.swap(pending_events);
+  }
+  for (auto& event : events) std::move(event).Run();
+}
+
+// Queues |event| to be emitted on the metrics thread. Only the first event of
+// a batch posts a task, the events reported until it runs are emitted with it.
+// Events are emitted in place when the metrics thread is not running.
+void queue_event(base::OnceClosure event) {
+  if (!metrics_thread.IsRunning()) {
+    std::move(event).Run();
+    return;
+  }
+  bool post;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    post = pending_events.empty();
+    pending_events.push_back(std::move(event));
+  }
+  if (post && !metrics_thread.DoInThread(FROM_HERE,
+                                         base::BindOnce(emit_pending_events))) {
+    emit_pending_events();
+  }
+}
+
+void emit_classic_pairing_event(const RawAddress& address, uint16_t handle,
+                                uint32_t hci_cmd, uint16_t hci_event,
+                                uint16_t cmd_status, uint16_t reason_code,
+                                int64_t event_value) {
   if (bluetooth::shim::is_any_gd_enabled()) {
     bluetooth::shim::LogMetricClassicPairingEvent(address, handle, hci_cmd,
                                                   hci_event, cmd_status,
@@ -38,25 +87,26 @@ void log_classic_pairing_event(const RawAddress& address, uint16_t handle,
   }
 }
 
-void log_link_layer_connection_event(
-    const RawAddress* address, uint32_t connection_handle,
+void emit_link_layer_connection_event(
+    bool has_address, const RawAddress& address, uint32_t connection_handle,
     android::bluetooth::DirectionEnum direction, uint16_t link_type,
     uint32_t hci_cmd, uint16_t hci_event, uint16_t hci_ble_event,
     uint16_t cmd_status, uint16_t reason_code) {
+  const RawAddress* p_address = has_address ? &address : nullptr;
   if (bluetooth::shim::is_any_gd_enabled()) {
     bluetooth::shim::LogMetricLinkLayerConnectionEvent(
-        address, connection_handle, direction, link_type, hci_cmd, hci_event,
-        hci_ble_event, cmd_status, reason_code);
+        p_address, connection_handle, direction, link_type, hci_cmd,
+        hci_event, hci_ble_event, cmd_status, reason_code);
   } else {
     bluetooth::common::LogLinkLayerConnectionEvent(
-        address, connection_handle, direction, link_type, hci_cmd, hci_event,
+        p_address, connection_handle, direction, link_type, hci_cmd, hci_event,
         hci_ble_event, cmd_status, reason_code);
   }
 }
 
-void log_smp_pairing_event(const RawAddress& address, uint8_t smp_cmd,
-                           android::bluetooth::DirectionEnum direction,
-                           uint8_t smp_fail_reason) {
+void emit_smp_pairing_event(const RawAddress& address, uint8_t smp_cmd,
+                            android::bluetooth::DirectionEnum direction,
+                            uint8_t smp_fail_reason) {
   if (bluetooth::shim::is_any_gd_enabled()) {
     bluetooth::shim::LogMetricSmpPairingEvent(address, smp_cmd, direction,
                                               smp_fail_reason);
@@ -66,18 +116,74 @@ void log_smp_pairing_event(const RawAddress& address, uint8_t smp_cmd,
   }
 }
 
-void log_sdp_attribute(const RawAddress& address, uint16_t protocol_uuid,
-                       uint16_t attribute_id, size_t attribute_size,
-                       const char* attribute_value) {
+void emit_sdp_attribute(const RawAddress& address, uint16_t protocol_uuid,
+                        uint16_t attribute_id,
+                        const std::string& attribute_value) {
   if (bluetooth::shim::is_any_gd_enabled()) {
-    bluetooth::shim::LogMetricSdpAttribute(address, protocol_uuid, attribute_id,
-                                           attribute_size, attribute_value);
+    bluetooth::shim::LogMetricSdpAttribute(
+        address, protocol_uuid, attribute_id, attribute_value.size(),
+        attribute_value.data());
   } else {
     bluetooth::common::LogSdpAttribute(address, protocol_uuid, attribute_id,
-                                       attribute_size, attribute_value);
+                                       attribute_value.size(),
+                                       attribute_value.data());
+  }
+}
+
+}  // namespace
+
+void stack_metrics_logging_start_up() {
+  metrics_thread.StartUp();
+  if (!metrics_thread.IsRunning()) {
+    LOG(ERROR) << __func__ << ": unable to start metrics thread, metrics will"
+               << " be emitted from the reporting threads";
   }
 }
 
+void stack_metrics_logging_shut_down() {
+  // Stops queueing first, the events still pending are emitted by the last
+  // task before the thread exits
+  metrics_thread.ShutDown();
+  emit_pending_events();
+}
+
+void log_classic_pairing_event(const RawAddress& address, uint16_t handle,
+                               uint32_t hci_cmd, uint16_t hci_event,
+                               uint16_t cmd_status, uint16_t reason_code,
+                               int64_t event_value) {
+  queue_event(base::BindOnce(emit_classic_pairing_event, address, handle,
+                             hci_cmd, hci_event, cmd_status, reason_code,
+                             event_value));
+}
+
+void log_link_layer_connection_event(
+    const RawAddress* address, uint32_t connection_handle,
+    android::bluetooth::DirectionEnum direction, uint16_t link_type,
+    uint32_t hci_cmd, uint16_t hci_event, uint16_t hci_ble_event,
+    uint16_t cmd_status, uint16_t reason_code) {
+  queue_event(base::BindOnce(
+      emit_link_layer_connection_event, address != nullptr,
+      address != nullptr ? *address : RawAddress::kEmpty, connection_handle,
+      direction, link_type, hci_cmd, hci_event, hci_ble_event, cmd_status,
+      reason_code));
+}
+
+void log_smp_pairing_event(const RawAddress& address, uint8_t smp_cmd,
+                           android::bluetooth::DirectionEnum direction,
+                           uint8_t smp_fail_reason) {
+  queue_event(base::BindOnce(emit_smp_pairing_event, address, smp_cmd,
+                             direction, smp_fail_reason));
+}
+
+void log_sdp_attribute(const RawAddress& address, uint16_t protocol_uuid,
+                       uint16_t attribute_id, size_t attribute_size,
+                       const char* attribute_value) {
+  // The value is copied, the caller's buffer does not outlive the call
+  queue_event(base::BindOnce(emit_sdp_attribute, address, protocol_uuid,
+                             attribute_id,
+                             std::string(attribute_value, attribute_size)));
+}
+
 void log_manufacturer_info(const RawAddress& address,
                            android::bluetooth::DeviceInfoSrcEnum source_type,
                            const std::string& source_name,
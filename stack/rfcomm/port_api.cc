@@ -29,6 +29,7 @@
 
 #include "osi/include/log.h"
 #include "osi/include/mutex.h"
+#include "osi/include/properties.h"
 
 #include "bt_common.h"
 #include "l2c_api.h"
@@ -802,8 +803,11 @@ static int port_write(tPORT* p_port, BT_HDR* p_buf) {
       (p_port->rfc.state != RFC_STATE_OPENED) ||
       ((p_port->port_ctrl & (PORT_CTRL_REQ_SENT | PORT_CTRL_IND_RECEIVED)) !=
        (PORT_CTRL_REQ_SENT | PORT_CTRL_IND_RECEIVED))) {
-    if ((p_port->tx.queue_size > PORT_TX_CRITICAL_WM) ||
-        (fixed_queue_length(p_port->tx.queue) > PORT_TX_BUF_CRITICAL_WM)) {
+    if ((p_port->tx.queue_size >
+         p_port->tx_high_wm + (PORT_TX_CRITICAL_WM - PORT_TX_HIGH_WM)) ||
+        (fixed_queue_length(p_port->tx.queue) >
+         p_port->tx_buf_high +
+             (PORT_TX_BUF_CRITICAL_WM - PORT_TX_BUF_HIGH_WM))) {
       RFCOMM_TRACE_WARNING("PORT_Write: Queue size: %d", p_port->tx.queue_size);
 
       osi_free(p_buf);
@@ -930,8 +934,8 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
 
   while (available) {
     /* if we're over buffer high water mark, we're done */
-    if ((p_port->tx.queue_size > PORT_TX_HIGH_WM) ||
-        (fixed_queue_length(p_port->tx.queue) > PORT_TX_BUF_HIGH_WM)) {
+    if ((p_port->tx.queue_size > p_port->tx_high_wm) ||
+        (fixed_queue_length(p_port->tx.queue) > p_port->tx_buf_high)) {
       port_flow_control_user(p_port);
       event |= PORT_EV_FC;
       RFCOMM_TRACE_EVENT(
@@ -1057,8 +1061,8 @@ int PORT_WriteData(uint16_t handle, const char* p_data, uint16_t max_len,
 
   while (max_len) {
     /* if we're over buffer high water mark, we're done */
-    if ((p_port->tx.queue_size > PORT_TX_HIGH_WM) ||
-        (fixed_queue_length(p_port->tx.queue) > PORT_TX_BUF_HIGH_WM))
+    if ((p_port->tx.queue_size > p_port->tx_high_wm) ||
+        (fixed_queue_length(p_port->tx.queue) > p_port->tx_buf_high))
       break;
 
     /* continue with rfcomm data write */
@@ -1113,6 +1117,8 @@ void RFCOMM_Init(void) {
   rfc_lcid_mcb = {};
 
   rfc_cb.rfc.last_mux = MAX_BD_CONNECTIONS;
+  rfc_cb.rfc.adaptive_flow =
+      osi_property_get_bool("persist.bluetooth.rfcomm.adaptive_flow", true);
 
 #if defined(RFCOMM_INITIAL_TRACE_LEVEL)
   rfc_cb.trace_level = RFCOMM_INITIAL_TRACE_LEVEL;
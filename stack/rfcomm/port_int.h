@@ -51,6 +51,33 @@ typedef struct {
   tPORT_CALLBACK* p_callback; /* Address of the callback function */
 } tPORT_DATA;
 
+/*
+ * Throughput of one direction of a port, measured over
+ * PORT_FLOW_RATE_WINDOW_MS windows
+*/
+typedef struct {
+  uint64_t window_start_ms; /* Start of the current window, 0 if none */
+  uint32_t window_bytes;    /* Bytes moved in the current window */
+  uint32_t rate;            /* Smoothed rate, in bytes per second */
+  uint32_t total_bytes;     /* Bytes moved since the port was allocated */
+} tPORT_RATE;
+
+/*
+ * Link measurements a port sizes its credits and watermarks from
+*/
+typedef struct {
+  tPORT_RATE rx; /* Data from peer to app */
+  tPORT_RATE tx; /* Data from app to peer */
+  uint64_t rx_rtt_start_ms; /* Credits granted to a stalled peer, 0 if none */
+  uint64_t tx_rtt_start_ms; /* Peer ran out of credits for us, 0 if none */
+  uint64_t msc_rtt_start_ms; /* Modem status command sent, 0 if none */
+  uint32_t srtt_ms;         /* Smoothed credit round trip time */
+  uint32_t rtt_samples;     /* Round trip times measured */
+  uint32_t adjustments;     /* Times the watermarks were resized */
+  uint16_t peak_credit_rx_max; /* Largest credit_rx_max used */
+  uint16_t peak_tx_buf_high;   /* Largest tx_buf_high used */
+} tPORT_FLOW;
+
 /*
  * Port control structure used to pass modem info
 */
@@ -185,6 +212,10 @@ typedef struct {
       credit_rx_max; /* Max number of credits we will allow this guy to sent */
   uint16_t credit_rx_low;   /* Number of credits when we send credit update */
   uint16_t rx_buf_critical; /* port receive queue critical watermark level */
+  uint32_t rx_critical_wm;  /* same, in bytes */
+  uint16_t tx_buf_high;     /* port transmit queue high watermark level */
+  uint32_t tx_high_wm;      /* same, in bytes */
+  tPORT_FLOW flow;          /* Measurements the watermarks are sized from */
   bool keep_port_handle;    /* true if port is not deallocated when closing */
   /* it is set to true for server when allocating port */
   uint16_t keep_mtu; /* Max MTU that port can receive by server */
@@ -212,6 +243,9 @@ extern uint32_t port_get_signal_changes(tPORT* p_port, uint8_t old_signals,
                                         uint8_t signal);
 extern uint32_t port_flow_control_user(tPORT* p_port);
 extern void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count);
+extern void port_flow_rx_data(tPORT* p_port, uint16_t len);
+extern void port_flow_tx_data(tPORT* p_port, uint16_t len);
+extern void port_flow_take_rtt_sample(tPORT* p_port, uint64_t* p_start_ms);
 
 /*
  * Functions provided by the port_rfc.cc
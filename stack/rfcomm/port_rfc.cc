@@ -639,6 +639,8 @@ void PORT_ControlCnf(tRFC_MCB* p_mcb, uint8_t dlci,
 
   if (!p_port) return;
 
+  port_flow_take_rtt_sample(p_port, &p_port->flow.msc_rtt_start_ms);
+
   if (!(p_port->port_ctrl & PORT_CTRL_REQ_CONFIRMED)) {
     p_port->port_ctrl |= PORT_CTRL_REQ_CONFIRMED;
 
@@ -766,6 +768,8 @@ void PORT_DataInd(tRFC_MCB* p_mcb, uint8_t dlci, BT_HDR* p_buf) {
     osi_free(p_buf);
     return;
   }
+  port_flow_rx_data(p_port, p_buf->len);
+
   /* If client registered callout callback with flow control we can just deliver
    * receive data */
   if (p_port->p_data_co_callback) {
@@ -789,7 +793,7 @@ void PORT_DataInd(tRFC_MCB* p_mcb, uint8_t dlci, BT_HDR* p_buf) {
     return;
   }
   /* Check if rx queue exceeds the limit */
-  if ((p_port->rx.queue_size + p_buf->len > PORT_RX_CRITICAL_WM) ||
+  if ((p_port->rx.queue_size + p_buf->len > p_port->rx_critical_wm) ||
       (fixed_queue_length(p_port->rx.queue) + 1 > p_port->rx_buf_critical)) {
     RFCOMM_TRACE_EVENT("PORT_DataInd. Buffer over run. Dropping the buffer");
     osi_free(p_buf);
@@ -24,12 +24,16 @@
 #include <base/logging.h>
 #include <string.h>
 
+#include <algorithm>
+
+
 #include "osi/include/mutex.h"
 
 #include "bt_common.h"
 #include "bt_target.h"
 #include "btm_int.h"
 #include "btu.h"
+#include "common/time_util.h"
 #include "l2cdefs.h"
 #include "port_api.h"
 #include "port_int.h"
@@ -122,6 +126,11 @@ void port_set_defaults(tPORT* p_port) {
   memset(&p_port->peer_ctrl, 0, sizeof(p_port->peer_ctrl));
   memset(&p_port->rx, 0, sizeof(p_port->rx));
   memset(&p_port->tx, 0, sizeof(p_port->tx));
+  memset(&p_port->flow, 0, sizeof(p_port->flow));
+
+  p_port->rx_critical_wm = PORT_RX_CRITICAL_WM;
+  p_port->tx_buf_high = PORT_TX_BUF_HIGH_WM;
+  p_port->tx_high_wm = PORT_TX_HIGH_WM;
 
   p_port->tx.queue = fixed_queue_new(SIZE_MAX);
   p_port->rx.queue = fixed_queue_new(SIZE_MAX);
@@ -188,6 +197,8 @@ void port_select_mtu(tPORT* p_port) {
   p_port->rx_buf_critical = (PORT_RX_CRITICAL_WM / p_port->mtu);
   if (p_port->rx_buf_critical > PORT_RX_BUF_CRITICAL_WM)
     p_port->rx_buf_critical = PORT_RX_BUF_CRITICAL_WM;
+  p_port->rx_critical_wm = PORT_RX_CRITICAL_WM;
+  p_port->flow.peak_credit_rx_max = p_port->credit_rx_max;
   RFCOMM_TRACE_DEBUG(
       "%s: credit_rx_max %d, credit_rx_low %d, rx_buf_critical %d", __func__,
       p_port->credit_rx_max, p_port->credit_rx_low, p_port->rx_buf_critical);
@@ -389,8 +400,8 @@ uint32_t port_flow_control_user(tPORT* p_port) {
   /* tx_queue is full */
   bool fc = p_port->tx.peer_fc || !p_port->rfc.p_mcb ||
             !p_port->rfc.p_mcb->peer_ready ||
-            (p_port->tx.queue_size > PORT_TX_HIGH_WM) ||
-            (fixed_queue_length(p_port->tx.queue) > PORT_TX_BUF_HIGH_WM);
+            (p_port->tx.queue_size > p_port->tx_high_wm) ||
+            (fixed_queue_length(p_port->tx.queue) > p_port->tx_buf_high);
 
   if (p_port->tx.user_fc == fc) return (0);
 
@@ -471,6 +482,11 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
       /* There might be a special case when we just adjusted rx_max */
       if ((p_port->credit_rx <= p_port->credit_rx_low) && !p_port->rx.user_fc &&
           (p_port->credit_rx_max > p_port->credit_rx)) {
+        /* a stalled peer resumes one round trip after the update */
+        if (p_port->credit_rx == 0 && p_port->flow.rx_rtt_start_ms == 0)
+          p_port->flow.rx_rtt_start_ms =
+              bluetooth::common::time_get_os_boottime_ms();
+
         rfc_send_credit(p_port->rfc.p_mcb, p_port->dlci,
                         (uint8_t)(p_port->credit_rx_max - p_port->credit_rx));
 
@@ -526,3 +542,174 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
     }
   }
 }
+
+/*******************************************************************************
+ *
+ * Function         port_flow_adapt
+ *
+ * Description      Size the credits granted to the peer and the transmit queue
+ *                  watermarks of a port to twice the bandwidth-delay product
+ *                  of the link, so that data keeps flowing while a credit
+ *                  update is on its way. The static watermarks are the
+ *                  minimum, and the ports of a multiplexer share
+ *                  PORT_MCB_MAX_QUEUE_SIZE bytes of queued data.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void port_flow_adapt(tPORT* p_port) {
+  tRFC_MCB* p_mcb = p_port->rfc.p_mcb;
+  tPORT_FLOW* p_flow = &p_port->flow;
+
+  if (!rfc_cb.rfc.adaptive_flow || !p_mcb || p_flow->rtt_samples == 0 ||
+      p_port->mtu == 0 || p_port->peer_mtu == 0)
+    return;
+
+  /* Memory the other ports of the multiplexer may already hold */
+  uint32_t used = 0;
+  for (const tPORT& port : rfc_cb.port.port) {
+    if (!port.in_use || &port == p_port || port.rfc.p_mcb != p_mcb) continue;
+    used += port.credit_rx_max * port.mtu + port.tx_high_wm;
+  }
+  uint32_t budget =
+      (used < PORT_MCB_MAX_QUEUE_SIZE) ? (PORT_MCB_MAX_QUEUE_SIZE - used) / 2 : 0;
+
+  uint16_t credit_rx_max = p_port->credit_rx_max;
+  if (p_mcb->flow == PORT_FC_CREDIT) {
+    /* static sizing of port_select_mtu() */
+    uint16_t base_max = std::min<uint16_t>(PORT_RX_HIGH_WM / p_port->mtu,
+                                           PORT_RX_BUF_HIGH_WM);
+    uint16_t base_low =
+        std::min<uint16_t>(PORT_RX_LOW_WM / p_port->mtu, PORT_RX_BUF_LOW_WM);
+    uint16_t base_critical = std::min<uint16_t>(
+        PORT_RX_CRITICAL_WM / p_port->mtu, PORT_RX_BUF_CRITICAL_WM);
+
+    uint64_t bdp = (uint64_t)p_flow->rx.rate * p_flow->srtt_ms / 1000;
+    uint64_t wanted = 2 * bdp / p_port->mtu + 1;
+    wanted = std::min<uint64_t>(wanted, PORT_RX_BUF_ADAPTIVE_MAX_WM);
+    wanted = std::min<uint64_t>(wanted, budget / p_port->mtu);
+    credit_rx_max = std::max<uint64_t>(wanted, base_max);
+
+    p_port->credit_rx_low = std::max<uint16_t>(credit_rx_max / 2, base_low);
+    p_port->rx_buf_critical = credit_rx_max + (base_critical - base_max);
+    p_port->rx_critical_wm = std::max<uint32_t>(
+        PORT_RX_CRITICAL_WM, p_port->rx_buf_critical * p_port->mtu);
+  }
+
+  uint64_t bdp = (uint64_t)p_flow->tx.rate * p_flow->srtt_ms / 1000;
+  uint64_t wanted = 2 * bdp / p_port->peer_mtu + 1;
+  wanted = std::min<uint64_t>(wanted, PORT_TX_BUF_ADAPTIVE_MAX_WM);
+  wanted = std::min<uint64_t>(wanted, budget / p_port->peer_mtu);
+  uint16_t tx_buf_high = std::max<uint64_t>(wanted, PORT_TX_BUF_HIGH_WM);
+
+  if (credit_rx_max == p_port->credit_rx_max &&
+      tx_buf_high == p_port->tx_buf_high)
+    return;
+
+  RFCOMM_TRACE_DEBUG(
+      "%s: port:%d srtt:%ums rx:%uB/s tx:%uB/s credit_rx_max %d->%d "
+      "tx_buf_high %d->%d",
+      __func__, p_port->handle, p_flow->srtt_ms, p_flow->rx.rate,
+      p_flow->tx.rate, p_port->credit_rx_max, credit_rx_max,
+      p_port->tx_buf_high, tx_buf_high);
+
+  p_port->credit_rx_max = credit_rx_max;
+  p_port->tx_buf_high = tx_buf_high;
+  p_port->tx_high_wm =
+      std::max<uint32_t>(PORT_TX_HIGH_WM, tx_buf_high * p_port->peer_mtu);
+  p_flow->adjustments++;
+  p_flow->peak_credit_rx_max =
+      std::max(p_flow->peak_credit_rx_max, credit_rx_max);
+  p_flow->peak_tx_buf_high = std::max(p_flow->peak_tx_buf_high, tx_buf_high);
+
+  /* a larger window may be granted right away, unless the app is behind */
+  if (p_mcb->flow == PORT_FC_CREDIT && !p_port->rx.peer_fc)
+    port_flow_control_peer(p_port, true, 0);
+}
+
+/*******************************************************************************
+ *
+ * Function         port_flow_count
+ *
+ * Description      Account |len| bytes moved in one direction of a port, and
+ *                  resize the port watermarks at the end of each window.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void port_flow_count(tPORT* p_port, tPORT_RATE* p_rate, uint16_t len) {
+  uint64_t now = bluetooth::common::time_get_os_boottime_ms();
+
+  p_rate->total_bytes += len;
+
+  /* a window spanning an idle period says nothing about the link */
+  if (p_rate->window_start_ms == 0 ||
+      now - p_rate->window_start_ms > 4 * PORT_FLOW_RATE_WINDOW_MS) {
+    p_rate->window_start_ms = now;
+    p_rate->window_bytes = len;
+    return;
+  }
+
+  p_rate->window_bytes += len;
+  uint64_t elapsed = now - p_rate->window_start_ms;
+  if (elapsed < PORT_FLOW_RATE_WINDOW_MS) return;
+
+  uint32_t rate = (uint32_t)((uint64_t)p_rate->window_bytes * 1000 / elapsed);
+  p_rate->rate = (p_rate->rate == 0) ? rate : (3 * p_rate->rate + rate) / 4;
+  p_rate->window_start_ms = now;
+  p_rate->window_bytes = 0;
+
+  port_flow_adapt(p_port);
+}
+
+/*******************************************************************************
+ *
+ * Function         port_flow_rx_data
+ *
+ * Description      Account a data frame of |len| bytes received on a port.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void port_flow_rx_data(tPORT* p_port, uint16_t len) {
+  port_flow_take_rtt_sample(p_port, &p_port->flow.rx_rtt_start_ms);
+  port_flow_count(p_port, &p_port->flow.rx, len);
+}
+
+/*******************************************************************************
+ *
+ * Function         port_flow_tx_data
+ *
+ * Description      Account a data frame of |len| bytes sent on a port.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void port_flow_tx_data(tPORT* p_port, uint16_t len) {
+  port_flow_count(p_port, &p_port->flow.tx, len);
+}
+
+/*******************************************************************************
+ *
+ * Function         port_flow_take_rtt_sample
+ *
+ * Description      Complete the round trip time measurement started at
+ *                  |*p_start_ms|, if any.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void port_flow_take_rtt_sample(tPORT* p_port, uint64_t* p_start_ms) {
+  if (*p_start_ms == 0) return;
+
+  tPORT_FLOW* p_flow = &p_port->flow;
+  uint32_t rtt = (uint32_t)(bluetooth::common::time_get_os_boottime_ms() -
+                            *p_start_ms);
+  *p_start_ms = 0;
+
+  if (p_flow->rtt_samples++ == 0) {
+    p_flow->srtt_ms = rtt;
+  } else {
+    p_flow->srtt_ms = (7 * p_flow->srtt_ms + rtt) / 8;
+  }
+}
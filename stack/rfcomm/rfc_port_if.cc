@@ -27,6 +27,7 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bt_utils.h"
+#include "common/time_util.h"
 #include "l2c_api.h"
 #include "osi/include/osi.h"
 #include "port_api.h"
@@ -255,6 +256,7 @@ void RFCOMM_ControlReq(tRFC_MCB* p_mcb, uint8_t dlci, tPORT_CTRL* p_pars) {
   p_port->port_ctrl |= PORT_CTRL_REQ_SENT;
 
   p_port->rfc.expected_rsp |= RFC_RSP_MSC;
+  p_port->flow.msc_rtt_start_ms = bluetooth::common::time_get_os_boottime_ms();
 
   rfc_send_msc(p_mcb, dlci, true, p_pars);
   rfc_port_timer_start(p_port, RFC_T2_TIMEOUT);
@@ -28,6 +28,7 @@
 #include "bt_utils.h"
 #include "btm_api.h"
 #include "btu.h"
+#include "common/time_util.h"
 #include "osi/include/osi.h"
 #include "port_api.h"
 #include "port_ext.h"
@@ -376,6 +377,7 @@ void rfc_port_closed(tPORT* p_port) {
 void rfc_inc_credit(tPORT* p_port, uint8_t credit) {
   if (p_port->rfc.p_mcb->flow == PORT_FC_CREDIT) {
     p_port->credit_tx += credit;
+    port_flow_take_rtt_sample(p_port, &p_port->flow.tx_rtt_start_ms);
 
     RFCOMM_TRACE_EVENT("rfc_inc_credit:%d", p_port->credit_tx);
 
@@ -398,7 +400,12 @@ void rfc_dec_credit(tPORT* p_port) {
   if (p_port->rfc.p_mcb->flow == PORT_FC_CREDIT) {
     if (p_port->credit_tx > 0) p_port->credit_tx--;
 
-    if (p_port->credit_tx == 0) p_port->tx.peer_fc = true;
+    if (p_port->credit_tx == 0) {
+      p_port->tx.peer_fc = true;
+      if (p_port->flow.tx_rtt_start_ms == 0)
+        p_port->flow.tx_rtt_start_ms =
+            bluetooth::common::time_get_os_boottime_ms();
+    }
   }
 }
 
@@ -29,6 +29,7 @@
 #include "sdp_api.h"
 #include "sdpint.h"
 
+#include "osi/include/allocator.h"
 #include "osi/include/osi.h"
 
 using bluetooth::Uuid;
@@ -95,6 +96,53 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
   return (true);
 }
 
+/*******************************************************************************
+ *
+ * Function         SDP_CreateDiscoveryDb
+ *
+ * Description      This function allocates and initializes a discovery
+ *                  database of len bytes, which grows as records are added
+ *                  up to SDP_MAX_DISC_DB_SIZE bytes.
+ *
+ * Returns          the database, to be released with SDP_FreeDiscoveryDb, or
+ *                  NULL if one or more parameters are bad
+ *
+ ******************************************************************************/
+tSDP_DISCOVERY_DB* SDP_CreateDiscoveryDb(uint32_t len, uint16_t num_uuid,
+                                         const Uuid* p_uuid_list,
+                                         uint16_t num_attr,
+                                         uint16_t* p_attr_list) {
+  if (len > SDP_MAX_DISC_DB_SIZE) len = SDP_MAX_DISC_DB_SIZE;
+  if (len < sizeof(tSDP_DISCOVERY_DB)) len = sizeof(tSDP_DISCOVERY_DB);
+
+  tSDP_DISCOVERY_DB* p_db = (tSDP_DISCOVERY_DB*)osi_malloc(len);
+  if (!SDP_InitDiscoveryDb(p_db, len, num_uuid, p_uuid_list, num_attr,
+                           p_attr_list)) {
+    osi_free(p_db);
+    return NULL;
+  }
+
+  p_db->max_size = SDP_MAX_DISC_DB_SIZE;
+  return p_db;
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_FreeDiscoveryDb
+ *
+ * Description      This function releases a discovery database allocated by
+ *                  SDP_CreateDiscoveryDb.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_FreeDiscoveryDb(tSDP_DISCOVERY_DB* p_db) {
+  if (p_db == NULL) return;
+
+  sdp_disc_reset_db(p_db);
+  osi_free(p_db);
+}
+
 /*******************************************************************************
  *
  * Function         SDP_CancelServiceSearch
@@ -107,7 +155,7 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
  ******************************************************************************/
 bool SDP_CancelServiceSearch(tSDP_DISCOVERY_DB* p_db) {
   tCONN_CB* p_ccb = sdpu_find_ccb_by_db(p_db);
-  if (!p_ccb) return (false);
+  if (!p_ccb) return sdp_cache_cancel(p_db);
 
   sdp_disconnect(p_ccb, SDP_CANCEL);
   p_ccb->disc_state = SDP_DISC_WAIT_CANCEL;
@@ -159,6 +207,8 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
                                        tSDP_DISC_CMPL_CB* p_cb) {
   tCONN_CB* p_ccb;
 
+  if (sdp_cache_serve(p_bd_addr, p_db, p_cb, NULL, NULL)) return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -192,6 +242,8 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
                                         void* user_data) {
   tCONN_CB* p_ccb;
 
+  if (sdp_cache_serve(p_bd_addr, p_db, NULL, p_cb2, user_data)) return (true);
+
   /* Specific BD address */
   p_ccb = sdp_conn_originate(p_bd_addr);
 
@@ -231,6 +283,39 @@ tSDP_DISC_ATTR* SDP_FindAttributeInRec(tSDP_DISC_REC* p_rec, uint16_t attr_id) {
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         SDP_FindAttributesInRec
+ *
+ * Description      This function searches an SDP discovery record for several
+ *                  attributes at once. p_attrs[i] is set to the entry of
+ *                  attr_ids[i], or NULL if the record does not have it.
+ *
+ * Returns          Number of attributes found
+ *
+ ******************************************************************************/
+uint16_t SDP_FindAttributesInRec(tSDP_DISC_REC* p_rec, uint16_t num_attr,
+                                 const uint16_t* p_attr_ids,
+                                 tSDP_DISC_ATTR** p_attrs) {
+  uint16_t num_found = 0;
+  uint16_t xx;
+
+  for (xx = 0; xx < num_attr; xx++) p_attrs[xx] = NULL;
+
+  for (tSDP_DISC_ATTR* p_attr = p_rec->p_first_attr;
+       p_attr && num_found < num_attr; p_attr = p_attr->p_next_attr) {
+    for (xx = 0; xx < num_attr; xx++) {
+      if (p_attr_ids[xx] == p_attr->attr_id && !p_attrs[xx]) {
+        p_attrs[xx] = p_attr;
+        num_found++;
+        break;
+      }
+    }
+  }
+
+  return num_found;
+}
+
 /*******************************************************************************
  *
  * Function         SDP_FindServiceUUIDInRec
@@ -822,61 +907,52 @@ uint16_t SDP_GetDiRecord(uint8_t get_record_index,
 
   if (result == SDP_SUCCESS) {
     /* copy the information from the SDP record to the DI record */
-    tSDP_DISC_ATTR* p_curr_attr = NULL;
-
-    /* ClientExecutableURL is optional */
-    p_curr_attr = SDP_FindAttributeInRec(p_curr_record, ATTR_ID_CLIENT_EXE_URL);
-    SDP_AttrStringCopy(p_device_info->rec.client_executable_url, p_curr_attr,
+    const uint16_t attr_ids[] = {
+        ATTR_ID_CLIENT_EXE_URL,    ATTR_ID_SERVICE_DESCRIPTION,
+        ATTR_ID_DOCUMENTATION_URL, ATTR_ID_SPECIFICATION_ID,
+        ATTR_ID_VENDOR_ID,         ATTR_ID_VENDOR_ID_SOURCE,
+        ATTR_ID_PRODUCT_ID,        ATTR_ID_PRODUCT_VERSION,
+        ATTR_ID_PRIMARY_RECORD};
+    tSDP_DISC_ATTR* p_attrs[ARRAY_SIZE(attr_ids)];
+    SDP_FindAttributesInRec(p_curr_record, ARRAY_SIZE(attr_ids), attr_ids,
+                            p_attrs);
+
+    /* ClientExecutableURL, Service Description and DocumentationURL are
+     * optional */
+    SDP_AttrStringCopy(p_device_info->rec.client_executable_url, p_attrs[0],
                        SDP_MAX_ATTR_LEN);
-
-    /* Service Description is optional */
-    p_curr_attr =
-        SDP_FindAttributeInRec(p_curr_record, ATTR_ID_SERVICE_DESCRIPTION);
-    SDP_AttrStringCopy(p_device_info->rec.service_description, p_curr_attr,
+    SDP_AttrStringCopy(p_device_info->rec.service_description, p_attrs[1],
                        SDP_MAX_ATTR_LEN);
-
-    /* DocumentationURL is optional */
-    p_curr_attr =
-        SDP_FindAttributeInRec(p_curr_record, ATTR_ID_DOCUMENTATION_URL);
-    SDP_AttrStringCopy(p_device_info->rec.documentation_url, p_curr_attr,
+    SDP_AttrStringCopy(p_device_info->rec.documentation_url, p_attrs[2],
                        SDP_MAX_ATTR_LEN);
 
-    p_curr_attr =
-        SDP_FindAttributeInRec(p_curr_record, ATTR_ID_SPECIFICATION_ID);
-    if (p_curr_attr)
-      p_device_info->spec_id = p_curr_attr->attr_value.v.u16;
+    if (p_attrs[3])
+      p_device_info->spec_id = p_attrs[3]->attr_value.v.u16;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
 
-    p_curr_attr = SDP_FindAttributeInRec(p_curr_record, ATTR_ID_VENDOR_ID);
-    if (p_curr_attr)
-      p_device_info->rec.vendor = p_curr_attr->attr_value.v.u16;
+    if (p_attrs[4])
+      p_device_info->rec.vendor = p_attrs[4]->attr_value.v.u16;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
 
-    p_curr_attr =
-        SDP_FindAttributeInRec(p_curr_record, ATTR_ID_VENDOR_ID_SOURCE);
-    if (p_curr_attr)
-      p_device_info->rec.vendor_id_source = p_curr_attr->attr_value.v.u16;
+    if (p_attrs[5])
+      p_device_info->rec.vendor_id_source = p_attrs[5]->attr_value.v.u16;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
 
-    p_curr_attr = SDP_FindAttributeInRec(p_curr_record, ATTR_ID_PRODUCT_ID);
-    if (p_curr_attr)
-      p_device_info->rec.product = p_curr_attr->attr_value.v.u16;
+    if (p_attrs[6])
+      p_device_info->rec.product = p_attrs[6]->attr_value.v.u16;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
 
-    p_curr_attr =
-        SDP_FindAttributeInRec(p_curr_record, ATTR_ID_PRODUCT_VERSION);
-    if (p_curr_attr)
-      p_device_info->rec.version = p_curr_attr->attr_value.v.u16;
+    if (p_attrs[7])
+      p_device_info->rec.version = p_attrs[7]->attr_value.v.u16;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
 
-    p_curr_attr = SDP_FindAttributeInRec(p_curr_record, ATTR_ID_PRIMARY_RECORD);
-    if (p_curr_attr)
-      p_device_info->rec.primary_record = (bool)p_curr_attr->attr_value.v.u8;
+    if (p_attrs[8])
+      p_device_info->rec.primary_record = (bool)p_attrs[8]->attr_value.v.u8;
     else
       result = SDP_ERR_ATTR_NOT_PRESENT;
   }
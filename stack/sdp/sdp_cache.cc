@@ -0,0 +1,390 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the cache of the search attribute responses of remote
+ *  devices. A search with the same UUID and attribute filters as a cached one
+ *  is answered from the cache without paging the device.
+ *
+ *  The responses are kept in the config of the device, most recent first:
+ *    uint8_t  version
+ *    entries:
+ *      uint8_t  num_uuid, uint8_t uuid[num_uuid][16] (big endian)
+ *      uint8_t  num_attr, uint16_t attr[num_attr]
+ *      uint16_t len, uint8_t attribute_lists[len]
+ *  Multi-byte fields are little endian.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <string.h>
+
+#include <list>
+#include <vector>
+
+#include "bt_target.h"
+
+#include "bt_common.h"
+#include "btif_config.h"
+#include "osi/include/log.h"
+#include "sdp_api.h"
+#include "sdpint.h"
+#include "stack/include/btu.h"
+
+using bluetooth::Uuid;
+
+#define SDP_CACHE_VERSION 1
+
+typedef struct {
+  std::vector<Uuid> uuids;
+  std::vector<uint16_t> attrs;
+  std::vector<uint8_t> lists;
+} tSDP_CACHE_ENTRY;
+
+/* A search answered from the cache, completed from the main thread like one
+ * going over the air */
+typedef struct {
+  uint32_t id;
+  tSDP_DISCOVERY_DB* p_db;
+  tSDP_DISC_CMPL_CB* p_cb;
+  tSDP_DISC_CMPL_CB2* p_cb2;
+  void* user_data;
+} tSDP_CACHE_SEARCH;
+
+static std::list<tSDP_CACHE_SEARCH> sdp_cache_searches;
+static uint32_t sdp_cache_next_id;
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_entry_size
+ *
+ * Description      This function returns the size of an entry once stored.
+ *
+ * Returns          size in bytes
+ *
+ ******************************************************************************/
+static size_t sdp_cache_entry_size(const tSDP_CACHE_ENTRY& entry) {
+  return 1 + entry.uuids.size() * Uuid::kNumBytes128 + 1 +
+         entry.attrs.size() * 2 + 2 + entry.lists.size();
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_load
+ *
+ * Description      This function reads the cached responses of a device.
+ *
+ * Returns          the entries, most recent first. Empty if there is no
+ *                  cache, or if it is malformed or of another version.
+ *
+ ******************************************************************************/
+static std::vector<tSDP_CACHE_ENTRY> sdp_cache_load(const std::string& bdstr) {
+  std::vector<tSDP_CACHE_ENTRY> entries;
+
+  size_t size = btif_config_get_bin_length(bdstr, BT_CONFIG_KEY_SDP_CACHE);
+  if (size == 0) return entries;
+
+  std::vector<uint8_t> blob(size);
+  if (!btif_config_get_bin(bdstr, BT_CONFIG_KEY_SDP_CACHE, blob.data(),
+                           &size) ||
+      size == 0 || blob[0] != SDP_CACHE_VERSION)
+    return entries;
+
+  const uint8_t* p = blob.data() + 1;
+  const uint8_t* p_end = blob.data() + size;
+  while (p < p_end) {
+    tSDP_CACHE_ENTRY entry;
+    uint8_t num;
+
+    STREAM_TO_UINT8(num, p);
+    if (num > SDP_MAX_UUID_FILTERS ||
+        p + num * Uuid::kNumBytes128 + 1 > p_end)
+      break;
+    for (uint8_t xx = 0; xx < num; xx++, p += Uuid::kNumBytes128)
+      entry.uuids.push_back(Uuid::From128BitBE(p));
+
+    STREAM_TO_UINT8(num, p);
+    if (num > SDP_MAX_ATTR_FILTERS || p + num * 2 + 2 > p_end) break;
+    for (uint8_t xx = 0; xx < num; xx++) {
+      uint16_t attr;
+      STREAM_TO_UINT16(attr, p);
+      entry.attrs.push_back(attr);
+    }
+
+    uint16_t len;
+    STREAM_TO_UINT16(len, p);
+    if (len == 0 || p + len > p_end) break;
+    entry.lists.assign(p, p + len);
+    p += len;
+
+    entries.push_back(std::move(entry));
+  }
+
+  if (p != p_end) {
+    LOG_WARN("Dropping malformed SDP cache of %s", bdstr.c_str());
+    btif_config_remove(bdstr, BT_CONFIG_KEY_SDP_CACHE);
+    entries.clear();
+  }
+  return entries;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_save
+ *
+ * Description      This function writes the cached responses of a device.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_save(const std::string& bdstr,
+                           const std::vector<tSDP_CACHE_ENTRY>& entries) {
+  std::vector<uint8_t> blob(1, SDP_CACHE_VERSION);
+
+  for (const tSDP_CACHE_ENTRY& entry : entries) {
+    size_t offset = blob.size();
+    blob.resize(offset + sdp_cache_entry_size(entry));
+    uint8_t* p = blob.data() + offset;
+
+    UINT8_TO_STREAM(p, entry.uuids.size());
+    for (const Uuid& uuid : entry.uuids) {
+      memcpy(p, uuid.To128BitBE().data(), Uuid::kNumBytes128);
+      p += Uuid::kNumBytes128;
+    }
+    UINT8_TO_STREAM(p, entry.attrs.size());
+    for (uint16_t attr : entry.attrs) UINT16_TO_STREAM(p, attr);
+    UINT16_TO_STREAM(p, entry.lists.size());
+    memcpy(p, entry.lists.data(), entry.lists.size());
+  }
+
+  btif_config_set_bin(bdstr, BT_CONFIG_KEY_SDP_CACHE, blob.data(),
+                      blob.size());
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_matches
+ *
+ * Description      This function checks if an entry was cached for a search
+ *                  with the filters of a discovery database. The attribute
+ *                  filters of a database are always sorted.
+ *
+ * Returns          true if it was
+ *
+ ******************************************************************************/
+static bool sdp_cache_matches(const tSDP_CACHE_ENTRY& entry,
+                              const tSDP_DISCOVERY_DB* p_db) {
+  if (entry.uuids.size() != p_db->num_uuid_filters ||
+      entry.attrs.size() != p_db->num_attr_filters)
+    return false;
+  for (size_t xx = 0; xx < entry.uuids.size(); xx++) {
+    if (entry.uuids[xx] != p_db->uuid_filters[xx]) return false;
+  }
+  for (size_t xx = 0; xx < entry.attrs.size(); xx++) {
+    if (entry.attrs[xx] != p_db->attr_filters[xx]) return false;
+  }
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_complete
+ *
+ * Description      This function reports the result of a search answered from
+ *                  the cache, unless it was cancelled.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_cache_complete(uint32_t id) {
+  for (auto it = sdp_cache_searches.begin(); it != sdp_cache_searches.end();
+       it++) {
+    if (it->id != id) continue;
+
+    tSDP_CACHE_SEARCH search = *it;
+    sdp_cache_searches.erase(it);
+    if (search.p_cb)
+      (*search.p_cb)(SDP_SUCCESS);
+    else if (search.p_cb2)
+      (*search.p_cb2)(SDP_SUCCESS, search.user_data);
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_serve
+ *
+ * Description      This function answers a search attribute request from the
+ *                  cached responses of the device, if one matches. The
+ *                  records are in the discovery database on return, the
+ *                  callback is called from the main thread later.
+ *
+ * Returns          true if the search was answered, false if it must go over
+ *                  the air.
+ *
+ ******************************************************************************/
+bool sdp_cache_serve(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                     tSDP_DISC_CMPL_CB* p_cb, tSDP_DISC_CMPL_CB2* p_cb2,
+                     void* user_data) {
+#if (SDP_RAW_DATA_INCLUDED == TRUE)
+  /* The raw response is not cached */
+  if (p_db->raw_data) return false;
+#endif
+
+  std::string bdstr = bd_addr.ToString();
+  std::vector<tSDP_CACHE_ENTRY> entries = sdp_cache_load(bdstr);
+  for (tSDP_CACHE_ENTRY& entry : entries) {
+    if (!sdp_cache_matches(entry, p_db)) continue;
+
+    uint8_t* p = entry.lists.data();
+    if (sdp_disc_save_attr_lists(p_db, bd_addr, p, p + entry.lists.size()) !=
+        SDP_SUCCESS) {
+      /* Start over empty, the search goes over the air */
+      sdp_disc_reset_db(p_db);
+      return false;
+    }
+
+    SDP_TRACE_EVENT("%s: SDP search for %s answered from the cache", __func__,
+                    bdstr.c_str());
+    uint32_t id = sdp_cache_next_id++;
+    sdp_cache_searches.push_back({id, p_db, p_cb, p_cb2, user_data});
+    do_in_main_thread(FROM_HERE, base::Bind(sdp_cache_complete, id));
+    return true;
+  }
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_cancel
+ *
+ * Description      This function cancels a search answered from the cache
+ *                  that was not reported yet.
+ *
+ * Returns          true if one was cancelled
+ *
+ ******************************************************************************/
+bool sdp_cache_cancel(tSDP_DISCOVERY_DB* p_db) {
+  for (auto it = sdp_cache_searches.begin(); it != sdp_cache_searches.end();
+       it++) {
+    if (it->p_db != p_db) continue;
+
+    tSDP_CACHE_SEARCH search = *it;
+    sdp_cache_searches.erase(it);
+    if (search.p_cb)
+      (*search.p_cb)(SDP_CANCEL);
+    else if (search.p_cb2)
+      (*search.p_cb2)(SDP_CANCEL, search.user_data);
+    return true;
+  }
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_cache_store
+ *
+ * Description      This function caches the attribute lists of a complete
+ *                  search attribute response, replacing the response cached
+ *                  for the same filters.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_cache_store(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                     const uint8_t* p_lists, uint16_t len) {
+  tSDP_CACHE_ENTRY entry;
+  entry.uuids.assign(p_db->uuid_filters,
+                     p_db->uuid_filters + p_db->num_uuid_filters);
+  entry.attrs.assign(p_db->attr_filters,
+                     p_db->attr_filters + p_db->num_attr_filters);
+  entry.lists.assign(p_lists, p_lists + len);
+
+  size_t size = 1 + sdp_cache_entry_size(entry);
+  if (len == 0 || size > SDP_MAX_CACHE_SIZE) return;
+
+  std::string bdstr = bd_addr.ToString();
+  std::vector<tSDP_CACHE_ENTRY> entries = sdp_cache_load(bdstr);
+  std::vector<tSDP_CACHE_ENTRY> kept;
+  kept.push_back(std::move(entry));
+  for (tSDP_CACHE_ENTRY& old : entries) {
+    if (sdp_cache_matches(old, p_db)) continue;
+    size += sdp_cache_entry_size(old);
+    if (size > SDP_MAX_CACHE_SIZE) break;
+    kept.push_back(std::move(old));
+  }
+
+  sdp_cache_save(bdstr, kept);
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_InvalidateCache
+ *
+ * Description      This function drops the search attribute responses cached
+ *                  for a remote device, so that the next search goes over the
+ *                  air.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_InvalidateCache(const RawAddress& bd_addr) {
+  std::string bdstr = bd_addr.ToString();
+  if (btif_config_exist(bdstr, BT_CONFIG_KEY_SDP_CACHE)) {
+    SDP_TRACE_EVENT("%s: %s", __func__, bdstr.c_str());
+    btif_config_remove(bdstr, BT_CONFIG_KEY_SDP_CACHE);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_UpdateCacheFingerprint
+ *
+ * Description      This function is called with data that changes when the
+ *                  services of a remote device change, like the service UUIDs
+ *                  of its EIR. The cached search attribute responses of the
+ *                  device are dropped if the data differs from last time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_UpdateCacheFingerprint(const RawAddress& bd_addr,
+                                const uint8_t* p_data, size_t len) {
+  std::string bdstr = bd_addr.ToString();
+
+  /* Nothing to keep fresh, and the config of devices seen in inquiries is not
+   * made to grow */
+  if (!btif_config_exist(bdstr, BT_CONFIG_KEY_SDP_CACHE)) return;
+
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (size_t xx = 0; xx < len; xx++) {
+    hash ^= p_data[xx];
+    hash *= 16777619u;
+  }
+
+  int stored;
+  if (btif_config_get_int(bdstr, BT_CONFIG_KEY_SDP_CACHE_FINGERPRINT,
+                          &stored)) {
+    if ((uint32_t)stored == hash) return;
+    SDP_InvalidateCache(bd_addr);
+  }
+  btif_config_set_int(bdstr, BT_CONFIG_KEY_SDP_CACHE_FINGERPRINT, (int)hash);
+}
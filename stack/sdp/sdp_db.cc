@@ -25,18 +25,153 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
 #include "bt_target.h"
 
 #include "bt_common.h"
 
+#include "avrc_defs.h"
 #include "sdp_api.h"
 #include "sdpint.h"
 
+using bluetooth::Uuid;
+
+/* Number of serialized attribute lists kept for the SDP server */
+#define SDP_MAX_CACHED_ATTR_LISTS 16
+
+/* Serialized attributes of a record matching an attribute ID list */
+typedef struct {
+  uint32_t record_handle;
+  tSDP_ATTR_SEQ attr_seq;
+  bool avrcp_1_4_only;
+  std::vector<uint8_t> value;
+} tSDP_ATTR_LIST;
+
+/* Records holding each UUID, and the UUIDs held by each record. Kept outside
+ * of sdp_cb as sdp_init() clears the control block with memset */
+static std::unordered_map<Uuid, std::set<uint32_t>> sdp_records_by_uuid;
+static std::unordered_map<uint32_t, std::vector<Uuid>> sdp_uuids_by_record;
+
+/* Most recently used first */
+static std::list<tSDP_ATTR_LIST> sdp_attr_lists;
+
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
 /******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
-                             uint16_t his_len, int nest_level);
+static void find_uuids_in_seq(uint8_t* p, uint32_t seq_len, int nest_level,
+                              std::vector<Uuid>* p_uuids);
+
+/*******************************************************************************
+ *
+ * Function         sdp_uuid_from_array
+ *
+ * Description      This function converts a big endian UUID of 2, 4 or 16
+ *                  bytes, as found in records and requests, into a Uuid.
+ *
+ * Returns          true if converted, false if the length is invalid
+ *
+ ******************************************************************************/
+static bool sdp_uuid_from_array(uint8_t* p, uint32_t len, Uuid* p_uuid) {
+  uint16_t uuid16;
+  uint32_t uuid32;
+
+  switch (len) {
+    case Uuid::kNumBytes16:
+      BE_STREAM_TO_UINT16(uuid16, p);
+      *p_uuid = Uuid::From16Bit(uuid16);
+      return true;
+    case Uuid::kNumBytes32:
+      BE_STREAM_TO_UINT32(uuid32, p);
+      *p_uuid = Uuid::From32Bit(uuid32);
+      return true;
+    case Uuid::kNumBytes128:
+      *p_uuid = Uuid::From128BitBE(p);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_unindex_record
+ *
+ * Description      This function removes a record from the UUID index, and
+ *                  drops the serialized attribute lists of the record.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_unindex_record(uint32_t handle) {
+  auto uuids = sdp_uuids_by_record.find(handle);
+  if (uuids != sdp_uuids_by_record.end()) {
+    for (const Uuid& uuid : uuids->second) {
+      auto records = sdp_records_by_uuid.find(uuid);
+      if (records == sdp_records_by_uuid.end()) continue;
+      records->second.erase(handle);
+      if (records->second.empty()) sdp_records_by_uuid.erase(records);
+    }
+    sdp_uuids_by_record.erase(uuids);
+  }
+
+  sdp_attr_lists.remove_if([handle](const tSDP_ATTR_LIST& list) {
+    return list.record_handle == handle;
+  });
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_record
+ *
+ * Description      This function (re)builds the UUID index entries of a record
+ *                  after its attributes changed. A record holds the UUIDs of
+ *                  its UUID attributes and those nested in its sequences, like
+ *                  ServiceSearch requests match them.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_index_record(tSDP_RECORD* p_rec) {
+  sdp_db_unindex_record(p_rec->record_handle);
+
+  std::vector<Uuid>& uuids = sdp_uuids_by_record[p_rec->record_handle];
+  for (uint16_t xx = 0; xx < p_rec->num_attributes; xx++) {
+    tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[xx];
+    Uuid uuid = Uuid::kEmpty;
+
+    if (p_attr->type == UUID_DESC_TYPE) {
+      if (sdp_uuid_from_array(p_attr->value_ptr, p_attr->len, &uuid))
+        uuids.push_back(uuid);
+    } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
+      find_uuids_in_seq(p_attr->value_ptr, p_attr->len, 0, &uuids);
+    }
+  }
+
+  for (const Uuid& uuid : uuids) {
+    sdp_records_by_uuid[uuid].insert(p_rec->record_handle);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_reset_index
+ *
+ * Description      This function empties the UUID index and the serialized
+ *                  attribute lists, when the whole database is dropped.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_db_reset_index(void) {
+  sdp_records_by_uuid.clear();
+  sdp_uuids_by_record.clear();
+  sdp_attr_lists.clear();
+}
 
 /*******************************************************************************
  *
@@ -46,45 +181,50 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
  *                  specified UIDs. It is passed either NULL to start at the
  *                  beginning, or the previous record found.
  *
+ *                  Candidates are taken from the UUID of the sequence held by
+ *                  the fewest records, in ascending handle order.
+ *
  * Returns          Pointer to the record, or NULL if not found.
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
-  uint16_t xx, yy;
-  tSDP_ATTRIBUTE* p_attr;
-  tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
+  std::vector<const std::set<uint32_t>*> sets;
+  const std::set<uint32_t>* p_smallest = NULL;
+
+  /* The spec says that a match occurs if the record contains all the passed
+   * UUIDs in it. */
+  for (uint16_t yy = 0; yy < p_seq->num_uids; yy++) {
+    Uuid uuid = Uuid::kEmpty;
+    if (!sdp_uuid_from_array(&p_seq->uuid_entry[yy].value[0],
+                             p_seq->uuid_entry[yy].len, &uuid))
+      return (NULL);
+
+    auto records = sdp_records_by_uuid.find(uuid);
+    if (records == sdp_records_by_uuid.end()) return (NULL);
+
+    sets.push_back(&records->second);
+    if (!p_smallest || records->second.size() < p_smallest->size())
+      p_smallest = &records->second;
+  }
 
-  /* If NULL, start at the beginning, else start at the first specified record
-   */
-  if (!p_rec)
-    p_rec = &sdp_cb.server_db.record[0];
-  else
-    p_rec++;
-
-  /* Look through the records. The spec says that a match occurs if */
-  /* the record contains all the passed UUIDs in it.                */
-  for (; p_rec < p_end; p_rec++) {
-    for (yy = 0; yy < p_seq->num_uids; yy++) {
-      p_attr = &p_rec->attribute[0];
-      for (xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
-        if (p_attr->type == UUID_DESC_TYPE) {
-          if (sdpu_compare_uuid_arrays(p_attr->value_ptr, p_attr->len,
-                                       &p_seq->uuid_entry[yy].value[0],
-                                       p_seq->uuid_entry[yy].len))
-            break;
-        } else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE) {
-          if (find_uuid_in_seq(p_attr->value_ptr, p_attr->len,
-                               &p_seq->uuid_entry[yy].value[0],
-                               p_seq->uuid_entry[yy].len, 0))
-            break;
-        }
-      }
-      /* If any UUID was not found,  on to the next record */
-      if (xx == p_rec->num_attributes) break;
-    }
+  if (!p_smallest) {
+    /* Empty sequence, every record matches */
+    tSDP_RECORD* p_end =
+        &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
+    p_rec = p_rec ? p_rec + 1 : &sdp_cb.server_db.record[0];
+    return (p_rec < p_end) ? p_rec : NULL;
+  }
 
-    /* If every UUID was found in the record, return the record */
-    if (yy == p_seq->num_uids) return (p_rec);
+  /* If NULL, start at the beginning, else after the specified record */
+  auto it = p_rec ? p_smallest->upper_bound(p_rec->record_handle)
+                  : p_smallest->begin();
+  for (; it != p_smallest->end(); it++) {
+    uint32_t handle = *it;
+    if (std::all_of(sets.begin(), sets.end(),
+                    [handle](const std::set<uint32_t>* p_set) {
+                      return p_set->count(handle) != 0;
+                    }))
+      return sdp_db_find_record(handle);
   }
 
   /* If here, no more records found */
@@ -93,21 +233,22 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
 
 /*******************************************************************************
  *
- * Function         find_uuid_in_seq
+ * Function         find_uuids_in_seq
  *
- * Description      This function searches a data element sequenct for a UUID.
+ * Description      This function collects the UUIDs of a data element
+ *                  sequence, and of the sequences nested in it.
  *
- * Returns          true if found, else false
+ * Returns          void
  *
  ******************************************************************************/
-static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
-                             uint16_t uuid_len, int nest_level) {
+static void find_uuids_in_seq(uint8_t* p, uint32_t seq_len, int nest_level,
+                              std::vector<Uuid>* p_uuids) {
   uint8_t* p_end = p + seq_len;
   uint8_t type;
   uint32_t len;
 
   /* A little safety check to avoid excessive recursion */
-  if (nest_level > 3) return (false);
+  if (nest_level > 3) return;
 
   while (p < p_end) {
     type = *p++;
@@ -118,16 +259,13 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
     }
     type = type >> 3;
     if (type == UUID_DESC_TYPE) {
-      if (sdpu_compare_uuid_arrays(p, len, p_uuid, uuid_len)) return (true);
+      Uuid uuid = Uuid::kEmpty;
+      if (sdp_uuid_from_array(p, len, &uuid)) p_uuids->push_back(uuid);
     } else if (type == DATA_ELE_SEQ_DESC_TYPE) {
-      if (find_uuid_in_seq(p, len, p_uuid, uuid_len, nest_level + 1))
-        return (true);
+      find_uuids_in_seq(p, len, nest_level + 1, p_uuids);
     }
     p = p + len;
   }
-
-  /* If here, failed to match */
-  return (false);
 }
 
 /*******************************************************************************
@@ -141,13 +279,15 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
-  tSDP_RECORD* p_rec;
+  tSDP_RECORD* p_begin = &sdp_cb.server_db.record[0];
   tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
 
-  /* Look through the records for the caller's handle */
-  for (p_rec = &sdp_cb.server_db.record[0]; p_rec < p_end; p_rec++) {
-    if (p_rec->record_handle == handle) return (p_rec);
-  }
+  /* Records are kept in ascending handle order, see SDP_CreateRecord */
+  tSDP_RECORD* p_rec = std::lower_bound(
+      p_begin, p_end, handle, [](const tSDP_RECORD& rec, uint32_t h) {
+        return rec.record_handle < h;
+      });
+  if (p_rec != p_end && p_rec->record_handle == handle) return (p_rec);
 
   /* Record with that handle not found. */
   return (NULL);
@@ -167,19 +307,80 @@ tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
  ******************************************************************************/
 tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec, uint16_t start_attr,
                                         uint16_t end_attr) {
-  tSDP_ATTRIBUTE* p_at;
-  uint16_t xx;
+  tSDP_ATTRIBUTE* p_end = &p_rec->attribute[p_rec->num_attributes];
 
-  /* Note that the attributes in a record are assumed to be in sorted order */
-  for (xx = 0, p_at = &p_rec->attribute[0]; xx < p_rec->num_attributes;
-       xx++, p_at++) {
-    if ((p_at->id >= start_attr) && (p_at->id <= end_attr)) return (p_at);
-  }
+  /* Note that the attributes in a record are kept in sorted order */
+  tSDP_ATTRIBUTE* p_at = std::lower_bound(
+      &p_rec->attribute[0], p_end, start_attr,
+      [](const tSDP_ATTRIBUTE& attr, uint16_t id) { return attr.id < id; });
+  if (p_at != p_end && p_at->id <= end_attr) return (p_at);
 
   /* No matching attribute found */
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_db_get_attr_list
+ *
+ * Description      This function returns the serialized attributes of a record
+ *                  matching an attribute ID list, as sent in an AttributeList
+ *                  without the sequence header. The last lists built are kept
+ *                  until their record changes, so repeated requests are not
+ *                  serialized again.
+ *
+ *                  If avrcp_1_4_only is set, an AVRCP profile descriptor of a
+ *                  later version is reported as AVRCP 1.4.
+ *
+ * Returns          The serialized attributes, empty if none matched. Only
+ *                  valid until the next call.
+ *
+ ******************************************************************************/
+const std::vector<uint8_t>& sdp_db_get_attr_list(tSDP_RECORD* p_rec,
+                                                 tSDP_ATTR_SEQ* p_seq,
+                                                 bool avrcp_1_4_only) {
+  for (auto it = sdp_attr_lists.begin(); it != sdp_attr_lists.end(); it++) {
+    if (it->record_handle == p_rec->record_handle &&
+        it->avrcp_1_4_only == avrcp_1_4_only &&
+        it->attr_seq.num_attr == p_seq->num_attr &&
+        std::equal(&p_seq->attr_entry[0], &p_seq->attr_entry[p_seq->num_attr],
+                   &it->attr_seq.attr_entry[0],
+                   [](const tATT_ENT& a, const tATT_ENT& b) {
+                     return a.start == b.start && a.end == b.end;
+                   })) {
+      sdp_attr_lists.splice(sdp_attr_lists.begin(), sdp_attr_lists, it);
+      return sdp_attr_lists.front().value;
+    }
+  }
+
+  sdp_attr_lists.push_front({.record_handle = p_rec->record_handle,
+                             .attr_seq = *p_seq,
+                             .avrcp_1_4_only = avrcp_1_4_only});
+  std::vector<uint8_t>& value = sdp_attr_lists.front().value;
+
+  tSDP_ATTRIBUTE* p_end = &p_rec->attribute[p_rec->num_attributes];
+  for (uint16_t xx = 0; xx < p_seq->num_attr; xx++) {
+    uint16_t end_id = p_seq->attr_entry[xx].end;
+
+    for (tSDP_ATTRIBUTE* p_attr = sdp_db_find_attr_in_rec(
+             p_rec, p_seq->attr_entry[xx].start, end_id);
+         p_attr && p_attr < p_end && p_attr->id <= end_id; p_attr++) {
+      size_t offset = value.size();
+      value.resize(offset + sdpu_get_attrib_entry_len(p_attr));
+      sdpu_build_attrib_entry(&value[offset], p_attr);
+
+      if (avrcp_1_4_only &&
+          sdpu_is_avrcp_profile_description_list(p_attr) > AVRC_REV_1_4) {
+        value.back() = 0x04;
+      }
+    }
+  }
+
+  if (sdp_attr_lists.size() > SDP_MAX_CACHED_ATTR_LISTS)
+    sdp_attr_lists.pop_back();
+  return value;
+}
+
 /*******************************************************************************
  *
  * Function         sdp_compose_proto_list
@@ -299,6 +500,8 @@ bool SDP_DeleteRecord(uint32_t handle) {
     /* require new DI record to be created in SDP_SetLocalDiRecord */
     sdp_cb.server_db.di_primary_handle = 0;
 
+    sdp_db_reset_index();
+
     return (true);
   } else {
     /* Find the record in the database */
@@ -314,6 +517,7 @@ bool SDP_DeleteRecord(uint32_t handle) {
         }
 
         sdp_cb.server_db.num_records--;
+        sdp_db_unindex_record(handle);
 
         SDP_TRACE_DEBUG("SDP_DeleteRecord ok, num_records:%d",
                         sdp_cb.server_db.num_records);
@@ -451,6 +655,7 @@ bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
         return (false);
       }
       p_rec->num_attributes++;
+      sdp_db_index_record(p_rec);
       return (true);
     }
   }
@@ -801,6 +1006,7 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
             }
             p_rec->free_pad_ptr -= len;
           }
+          sdp_db_index_record(p_rec);
           return (true);
         }
       }
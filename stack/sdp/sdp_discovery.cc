@@ -50,7 +50,9 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                      uint8_t* p_reply_end);
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end);
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end);
+static uint8_t* save_attr_seq(tSDP_DISCOVERY_DB* p_db, const RawAddress& bda,
+                              uint8_t* p, uint8_t* p_msg_end);
+static bool reserve_mem(tSDP_DISCOVERY_DB* p_db, uint32_t len);
 static tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db,
                                  const RawAddress& p_bda);
 static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
@@ -439,7 +441,8 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 #endif
 
       /* Save the response in the database. Stop on any error */
-      if (!save_attr_seq(p_ccb, &p_ccb->rsp_list[0],
+      if (!save_attr_seq(p_ccb->p_db, p_ccb->device_address,
+                         &p_ccb->rsp_list[0],
                          &p_ccb->rsp_list[p_ccb->list_len])) {
         sdp_disconnect(p_ccb, SDP_DB_FULL);
         return;
@@ -520,11 +523,10 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  ******************************************************************************/
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end) {
-  uint8_t *p, *p_start, *p_end, *p_param_len;
-  uint8_t type;
-  uint32_t seq_len;
+  uint8_t *p_start, *p_param_len;
   uint16_t param_len, lists_byte_count = 0;
   bool cont_request_needed = false;
+  tSDP_STATUS status;
 
   /* If p_reply is NULL, we were called for the initial read */
   if (p_reply) {
@@ -638,39 +640,63 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
   }
 #endif
 
-  p = &p_ccb->rsp_list[0];
+  status = sdp_disc_save_attr_lists(p_ccb->p_db, p_ccb->device_address,
+                                    p_ccb->rsp_list,
+                                    p_ccb->rsp_list + p_ccb->list_len);
+  if (status != SDP_SUCCESS) {
+    sdp_disconnect(p_ccb, status);
+    return;
+  }
+
+  /* Since we got everything we need, disconnect the call */
+  sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
+  sdp_cache_store(p_ccb->device_address, p_ccb->p_db, p_ccb->rsp_list,
+                  p_ccb->list_len);
+  sdp_disconnect(p_ccb, SDP_SUCCESS);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_save_attr_lists
+ *
+ * Description      This function saves the attribute lists of a complete
+ *                  search attribute response, a sequence of attribute
+ *                  sequences, in the discovery database.
+ *
+ * Returns          SDP_SUCCESS, or the reason to fail the discovery
+ *
+ ******************************************************************************/
+tSDP_STATUS sdp_disc_save_attr_lists(tSDP_DISCOVERY_DB* p_db,
+                                     const RawAddress& bda, uint8_t* p,
+                                     uint8_t* p_end) {
+  uint8_t type;
+  uint32_t seq_len;
+
+  if (p == NULL || p >= p_end) {
+    LOG_WARN("Empty search attribute response");
+    return SDP_ILLEGAL_PARAMETER;
+  }
 
   /* The contents is a sequence of attribute sequences */
   type = *p++;
 
   if ((type >> 3) != DATA_ELE_SEQ_DESC_TYPE) {
     LOG_WARN("Wrong element in attr_rsp type:0x%02x", type);
-    return;
+    return SDP_ILLEGAL_PARAMETER;
   }
-  p = sdpu_get_len_from_type(p, p + p_ccb->list_len, type, &seq_len);
-  if (p == NULL || (p + seq_len) > (p + p_ccb->list_len)) {
+  p = sdpu_get_len_from_type(p, p_end, type, &seq_len);
+  if (p == NULL || (p + seq_len) > p_end) {
     LOG_WARN("Illegal search attribute length");
-    sdp_disconnect(p_ccb, SDP_ILLEGAL_PARAMETER);
-    return;
+    return SDP_ILLEGAL_PARAMETER;
   }
-  p_end = &p_ccb->rsp_list[p_ccb->list_len];
 
-  if ((p + seq_len) != p_end) {
-    sdp_disconnect(p_ccb, SDP_INVALID_CONT_STATE);
-    return;
-  }
+  if ((p + seq_len) != p_end) return SDP_INVALID_CONT_STATE;
 
   while (p < p_end) {
-    p = save_attr_seq(p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
-    if (!p) {
-      sdp_disconnect(p_ccb, SDP_DB_FULL);
-      return;
-    }
+    p = save_attr_seq(p_db, bda, p, p_end);
+    if (!p) return SDP_DB_FULL;
   }
-
-  /* Since we got everything we need, disconnect the call */
-  sdpu_log_attribute_metrics(p_ccb->device_address, p_ccb->p_db);
-  sdp_disconnect(p_ccb, SDP_SUCCESS);
+  return SDP_SUCCESS;
 }
 
 /*******************************************************************************
@@ -683,7 +709,8 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  * Returns          pointer to next byte or NULL if error
  *
  ******************************************************************************/
-static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
+static uint8_t* save_attr_seq(tSDP_DISCOVERY_DB* p_db, const RawAddress& bda,
+                              uint8_t* p, uint8_t* p_msg_end) {
   uint32_t seq_len, attr_len;
   uint16_t attr_id;
   uint8_t type, *p_seq_end;
@@ -702,7 +729,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
   }
 
   /* Create a record */
-  p_rec = add_record(p_ccb->p_db, p_ccb->device_address);
+  p_rec = add_record(p_db, bda);
   if (!p_rec) {
     SDP_TRACE_WARNING("SDP - DB full add_record");
     return (NULL);
@@ -726,7 +753,7 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
     BE_STREAM_TO_UINT16(attr_id, p);
 
     /* Now, add the attribute value */
-    p = add_attr(p, p_seq_end, p_ccb->p_db, p_rec, attr_id, NULL, 0);
+    p = add_attr(p, p_seq_end, p_db, p_rec, attr_id, NULL, 0);
 
     if (!p) {
       SDP_TRACE_WARNING("SDP - DB full add_attr");
@@ -737,6 +764,66 @@ static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end) {
   return (p);
 }
 
+/*******************************************************************************
+ *
+ * Function         reserve_mem
+ *
+ * Description      This function makes sure that len bytes are free at
+ *                  p_free_mem, adding a block to a growing DB if needed.
+ *                  The memory of a new block is zeroed like the memory of a
+ *                  DB that was just initialized.
+ *
+ * Returns          true if there is room, false if the DB is full
+ *
+ ******************************************************************************/
+static bool reserve_mem(tSDP_DISCOVERY_DB* p_db, uint32_t len) {
+  if (p_db->mem_free >= len) return true;
+  if (p_db->max_size == 0) return false;
+
+  uint32_t size = std::max<uint32_t>(len, SDP_DISC_DB_BLOCK_SIZE);
+  if (sizeof(tSDP_DISCOVERY_DB) + p_db->mem_size + size > p_db->max_size) {
+    SDP_TRACE_WARNING("SDP - DB reached its maximum size %u", p_db->max_size);
+    return false;
+  }
+
+  tSDP_DISC_BLOCK* p_block =
+      (tSDP_DISC_BLOCK*)osi_calloc(sizeof(tSDP_DISC_BLOCK) + size);
+  p_block->p_next = p_db->p_blocks;
+  p_block->size = size;
+  p_db->p_blocks = p_block;
+
+  /* The rest of the current block is left unused */
+  p_db->mem_size += size;
+  p_db->mem_free = size;
+  p_db->p_free_mem = (uint8_t*)(p_block + 1);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_reset_db
+ *
+ * Description      This function drops the records of a discovery database,
+ *                  releasing the blocks it grew by.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_disc_reset_db(tSDP_DISCOVERY_DB* p_db) {
+  while (p_db->p_blocks) {
+    tSDP_DISC_BLOCK* p_block = p_db->p_blocks;
+    p_db->p_blocks = p_block->p_next;
+    p_db->mem_size -= p_block->size;
+    osi_free(p_block);
+  }
+
+  /* Attributes rely on the memory being zeroed */
+  memset(p_db + 1, 0, p_db->mem_size);
+  p_db->p_first_rec = NULL;
+  p_db->mem_free = p_db->mem_size;
+  p_db->p_free_mem = (uint8_t*)(p_db + 1);
+}
+
 /*******************************************************************************
  *
  * Function         add_record
@@ -750,7 +837,7 @@ tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db, const RawAddress& p_bda) {
   tSDP_DISC_REC* p_rec;
 
   /* See if there is enough space in the database */
-  if (p_db->mem_free < sizeof(tSDP_DISC_REC)) return (NULL);
+  if (!reserve_mem(p_db, sizeof(tSDP_DISC_REC))) return (NULL);
 
   p_rec = (tSDP_DISC_REC*)p_db->p_free_mem;
   p_db->p_free_mem += sizeof(tSDP_DISC_REC);
@@ -826,7 +913,7 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
   total_len = (total_len + 3) & ~3;
 
   /* See if there is enough space in the database */
-  if (p_db->mem_free < total_len) return (NULL);
+  if (!reserve_mem(p_db, total_len)) return (NULL);
 
   p_attr = (tSDP_DISC_ATTR*)p_db->p_free_mem;
   p_attr->attr_id = attr_id;
@@ -25,6 +25,8 @@
 #ifndef SDP_INT_H
 #define SDP_INT_H
 
+#include <vector>
+
 #include "bluetooth/uuid.h"
 #include "bt_target.h"
 #include "l2c_api.h"
@@ -106,18 +108,12 @@ typedef struct {
   tSDP_RECORD record[SDP_MAX_RECORDS];
 } tSDP_DB;
 
-/* Continuation information for the SDP server response */
-typedef struct {
-  uint16_t next_attr_index;    /* attr index for next continuation response */
-  uint16_t next_attr_start_id; /* attr id to start with for the attr index in
-                                  next cont. response */
-  tSDP_RECORD* prev_sdp_rec; /* last sdp record that was completely sent in the
-                                response */
-  bool last_attr_seq_desc_sent; /* whether attr seq length has been sent
-                                   previously */
-  uint16_t attr_offset; /* offset within the attr to keep trak of partial
-                           attributes in the responses */
-} tSDP_CONT_INFO;
+/* A block of memory added to a growing discovery database. Records and
+ * attributes are carved out of the memory following it */
+typedef struct t_sdp_disc_block {
+  struct t_sdp_disc_block* p_next;
+  uint32_t size; /* Size of the memory after the header */
+} tSDP_DISC_BLOCK;
 
 /* Define the SDP Connection Control Block */
 typedef struct {
@@ -160,9 +156,7 @@ typedef struct {
   uint8_t disc_state;
   uint8_t is_attr_search;
 
-  uint16_t cont_offset;     /* Continuation state data in the server response */
-  tSDP_CONT_INFO cont_info; /* structure to hold continuation information for
-                               the server response */
+  uint16_t cont_offset; /* Continuation state data in the server response */
 
 } tCONN_CB;
 
@@ -218,14 +212,7 @@ extern bool sdpu_compare_uuid_with_attr(const bluetooth::Uuid& uuid,
                                         tSDP_DISC_ATTR* p_attr);
 
 extern void sdpu_sort_attr_list(uint16_t num_attr, tSDP_DISCOVERY_DB* p_db);
-extern uint16_t sdpu_get_list_len(tSDP_UUID_SEQ* uid_seq,
-                                  tSDP_ATTR_SEQ* attr_seq);
-extern uint16_t sdpu_get_attrib_seq_len(tSDP_RECORD* p_rec,
-                                        tSDP_ATTR_SEQ* attr_seq);
 extern uint16_t sdpu_get_attrib_entry_len(tSDP_ATTRIBUTE* p_attr);
-extern uint8_t* sdpu_build_partial_attrib_entry(uint8_t* p_out,
-                                                tSDP_ATTRIBUTE* p_attr,
-                                                uint16_t len, uint16_t* offset);
 extern uint16_t sdpu_is_avrcp_profile_description_list(tSDP_ATTRIBUTE* p_attr);
 
 /* Functions provided by sdp_db.cc
@@ -236,6 +223,10 @@ extern tSDP_RECORD* sdp_db_find_record(uint32_t handle);
 extern tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec,
                                                uint16_t start_attr,
                                                uint16_t end_attr);
+extern const std::vector<uint8_t>& sdp_db_get_attr_list(tSDP_RECORD* p_rec,
+                                                        tSDP_ATTR_SEQ* p_seq,
+                                                        bool avrcp_1_4_only);
+extern void sdp_db_reset_index(void);
 
 /* Functions provided by sdp_server.cc
  */
@@ -245,5 +236,18 @@ extern void sdp_server_handle_client_req(tCONN_CB* p_ccb, BT_HDR* p_msg);
  */
 extern void sdp_disc_connected(tCONN_CB* p_ccb);
 extern void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern void sdp_disc_reset_db(tSDP_DISCOVERY_DB* p_db);
+extern tSDP_STATUS sdp_disc_save_attr_lists(tSDP_DISCOVERY_DB* p_db,
+                                            const RawAddress& bda, uint8_t* p,
+                                            uint8_t* p_end);
+
+/* Functions provided by sdp_cache.cc
+ */
+extern bool sdp_cache_serve(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                            tSDP_DISC_CMPL_CB* p_cb, tSDP_DISC_CMPL_CB2* p_cb2,
+                            void* user_data);
+extern bool sdp_cache_cancel(tSDP_DISCOVERY_DB* p_db);
+extern void sdp_cache_store(const RawAddress& bd_addr, tSDP_DISCOVERY_DB* p_db,
+                            const uint8_t* p_lists, uint16_t len);
 
 #endif
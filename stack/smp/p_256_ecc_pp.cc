@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "gd/security/ecc/p_256_engine.h"
 #include "p_256_multprecision.h"
 
 elliptic_curve_t curve;
@@ -240,6 +241,17 @@ void ECC_PointMult_Bin_NAF(Point* q, Point* p, uint32_t* n) {
   multiprecision_mersenns_mult_mod(q->y, q->y, q->z);
 }
 
+void ECC_PointMult(Point* q, Point* p, uint32_t* n) {
+  if (memcmp(p->x, curve_p256.G.x, sizeof(p->x)) == 0 &&
+      memcmp(p->y, curve_p256.G.y, sizeof(p->y)) == 0) {
+    bluetooth::security::ecc::P256ScalarMultBase(n, q->x, q->y);
+  } else {
+    bluetooth::security::ecc::P256ScalarMult(n, p->x, p->y, q->x, q->y);
+  }
+  multiprecision_init(q->z);
+  q->z[0] = 1;
+}
+
 bool ECC_ValidatePoint(const Point& pt) {
   p_256_init_curve();
 
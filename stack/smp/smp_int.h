@@ -445,6 +445,7 @@ extern void smp_generate_passkey(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_generate_rand_cont(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
+extern void smp_key_pool_pairing_cmpl(tSMP_CB* p_cb);
 extern void smp_compute_dhkey(tSMP_CB* p_cb);
 extern void smp_calculate_local_commitment(tSMP_CB* p_cb);
 extern Octet16 smp_calculate_peer_commitment(tSMP_CB* p_cb);
@@ -29,8 +29,10 @@
 #include "btm_ble_api.h"
 #include "btm_ble_int.h"
 #include "device/include/controller.h"
+#include "gd/security/key_pair_pool.h"
 #include "hcimsgs.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "p_256_ecc_pp.h"
 #include "smp_int.h"
 #include "stack/btm/btm_dev.h"
@@ -39,6 +41,7 @@
 #include "stack/include/acl_api.h"
 
 #include <algorithm>
+#include <array>
 
 extern tBTM_CB btm_cb;  // TODO Remove
 
@@ -52,6 +55,7 @@ using crypto_toolbox::aes_128;
 static void smp_process_stk(tSMP_CB* p_cb, Octet16* p);
 static Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb);
 static void smp_process_private_key(tSMP_CB* p_cb);
+static void smp_local_key_pair_created(tSMP_CB* p_cb);
 
 #define SMP_PASSKEY_MASK 0xfff00000
 
@@ -72,6 +76,79 @@ static bool is_empty(tSMP_LOC_OOB_DATA* data) {
 
 bool smp_has_local_oob_data() { return !is_empty(&saved_local_oob_data); }
 
+/* Number of local key pairs kept ready for the next pairings, 0 disables the
+ * pool, and number of pairings each of them may serve */
+#define SMP_KEY_POOL_SIZE_PROPERTY "persist.bluetooth.smp.key_pool_size"
+#define SMP_KEY_MAX_USES_PROPERTY "persist.bluetooth.smp.key_max_uses"
+
+using SmpPrivateKey = std::array<uint8_t, BT_OCTET32_LEN>;
+using SmpKeyPool =
+    bluetooth::security::KeyPairPool<SmpPrivateKey, tSMP_PUBLIC_KEY>;
+
+static SmpKeyPool& smp_key_pool() {
+  static SmpKeyPool* pool = new SmpKeyPool(
+      std::max(0, osi_property_get_int32(SMP_KEY_POOL_SIZE_PROPERTY, 1)),
+      osi_property_get_int32(SMP_KEY_MAX_USES_PROPERTY, 1));
+  return *pool;
+}
+
+/* Private key of the pool refill in progress, if any */
+static BT_OCTET32 key_pool_private_key;
+static bool key_pool_refilling = false;
+
+static void smp_refill_key_pool();
+
+static void smp_key_pool_rand(size_t offset, BT_OCTET8 rand) {
+  memcpy(&key_pool_private_key[offset], rand, BT_OCTET8_LEN);
+  offset += BT_OCTET8_LEN;
+  if (offset < BT_OCTET32_LEN) {
+    btsnd_hcic_ble_rand(Bind(&smp_key_pool_rand, offset));
+    return;
+  }
+
+  Point public_key;
+  SmpPrivateKey private_key;
+  memcpy(private_key.data(), key_pool_private_key, BT_OCTET32_LEN);
+  ECC_PointMult(&public_key, &(curve_p256.G), (uint32_t*)private_key.data());
+  tSMP_PUBLIC_KEY loc_publ_key;
+  memcpy(loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
+  memcpy(loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
+  smp_key_pool().Put(private_key, loc_publ_key);
+
+  memset(key_pool_private_key, 0, BT_OCTET32_LEN);
+  memset(private_key.data(), 0, BT_OCTET32_LEN);
+  key_pool_refilling = false;
+  smp_refill_key_pool();
+}
+
+/* Generates the key pairs missing from the pool, one after the other */
+static void smp_refill_key_pool() {
+  if (key_pool_refilling || smp_key_pool().Missing() == 0) return;
+  key_pool_refilling = true;
+  btsnd_hcic_ble_rand(Bind(&smp_key_pool_rand, static_cast<size_t>(0)));
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_key_pool_pairing_cmpl
+ *
+ * Description      This function is called when a pairing completes, while
+ *                  SMP goes back to idle. It drops the key pair of a failed
+ *                  pairing from the pool, and generates the key pairs for the
+ *                  next pairings.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_key_pool_pairing_cmpl(tSMP_CB* p_cb) {
+  if (p_cb->status != SMP_SUCCESS) {
+    SmpPrivateKey private_key;
+    memcpy(private_key.data(), p_cb->private_key, BT_OCTET32_LEN);
+    smp_key_pool().Drop(private_key);
+  }
+  smp_refill_key_pool();
+}
+
 void smp_debug_print_nbyte_little_endian(uint8_t* p, const char* key_name,
                                          uint8_t len) {}
 
@@ -579,8 +656,9 @@ Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb) {
  *
  * Description      This function is called to create private key used to
  *                  calculate public key and DHKey.
- *                  The function starts private key creation requesting
- *                  for the controller to generate [0-7] octets of private key.
+ *                  The function takes a ready key pair from the pool, or
+ *                  starts private key creation requesting for the controller
+ *                  to generate [0-7] octets of private key.
  *
  * Returns          void
  *
@@ -610,6 +688,16 @@ void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
     LOG_WARN("OOB Association Model with no saved data present");
   }
 
+  auto key_pair = smp_key_pool().Take();
+  if (key_pair) {
+    SMP_TRACE_DEBUG("%s: use a key pair from the pool", __func__);
+    memcpy(p_cb->private_key, key_pair->first.data(), BT_OCTET32_LEN);
+    p_cb->loc_publ_key = key_pair->second;
+    memset(key_pair->first.data(), 0, BT_OCTET32_LEN);
+    smp_local_key_pair_created(p_cb);
+    return;
+  }
+
   btsnd_hcic_ble_rand(Bind(
       [](tSMP_CB* p_cb, BT_OCTET8 rand) {
         memcpy((void*)p_cb->private_key, rand, BT_OCTET8_LEN);
@@ -714,6 +802,20 @@ void smp_process_private_key(tSMP_CB* p_cb) {
   memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
   memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
 
+  smp_local_key_pair_created(p_cb);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_local_key_pair_created
+ *
+ * Description      This function notifies SM that private key / public key
+ *                  pair is created.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_local_key_pair_created(tSMP_CB* p_cb) {
   smp_debug_print_nbyte_little_endian(p_cb->private_key, "private",
                                       BT_OCTET32_LEN);
   smp_debug_print_nbyte_little_endian(p_cb->loc_publ_key.x, "local public(x)",
@@ -959,6 +959,7 @@ void smp_proc_pairing_cmpl(tSMP_CB* p_cb) {
 
   RawAddress pairing_bda = p_cb->pairing_bda;
 
+  smp_key_pool_pairing_cmpl(p_cb);
   smp_reset_control_value(p_cb);
 
   if (p_callback) (*p_callback)(SMP_COMPLT_EVT, pairing_bda, &evt_data);
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "stack/include/a2dp_vendor_aptx_pcm.h"
+
+namespace {
+
+struct FakeState {
+  uint32_t calls = 0;
+  bool hd = false;
+};
+
+/* Fake library encoder, the code words are a checksum of the samples */
+int FakeEncodeStereo(void* state, void* pcmL, void* pcmR, void* buffer) {
+  FakeState* fake = static_cast<FakeState*>(state);
+  const uint32_t* left = static_cast<const uint32_t*>(pcmL);
+  const uint32_t* right = static_cast<const uint32_t*>(pcmR);
+  uint32_t words[2] = {fake->calls++, 0};
+  for (int i = 0; i < 4; i++) {
+    words[0] = words[0] * 31 + left[i];
+    words[1] = words[1] * 37 + right[i];
+  }
+  if (fake->hd) {
+    uint32_t* out = static_cast<uint32_t*>(buffer);
+    out[0] = words[0] & 0xffffff;
+    out[1] = words[1] & 0xffffff;
+  } else {
+    uint16_t* out = static_cast<uint16_t*>(buffer);
+    out[0] = words[0];
+    out[1] = words[1];
+  }
+  return 0;
+}
+
+std::vector<uint8_t> RandomPcm(size_t len) {
+  std::mt19937 rng(len);
+  std::vector<uint8_t> pcm(len);
+  for (auto& b : pcm) b = rng();
+  return pcm;
+}
+
+std::vector<uint8_t> g_source;
+size_t g_source_pos = 0;
+uint32_t g_read_limit = 0;
+
+uint32_t ReadSource(uint8_t* p_buf, uint32_t len) {
+  len = std::min<uint32_t>(len, g_read_limit);
+  len = std::min<size_t>(len, g_source.size() - g_source_pos);
+  memcpy(p_buf, g_source.data() + g_source_pos, len);
+  g_source_pos += len;
+  return len;
+}
+
+}  // namespace
+
+TEST(A2dpVendorAptxPcmTest, encode_16bit_packs_big_endian_code_words) {
+  alignas(16) uint8_t pcm[224];
+  std::vector<uint8_t> random = RandomPcm(sizeof(pcm));
+  memcpy(pcm, random.data(), sizeof(pcm));
+  FakeState state;
+  std::vector<uint8_t> out(sizeof(pcm) / 4 + 1, 0xa5);
+
+  EXPECT_EQ(sizeof(pcm),
+            a2dp_aptx_encode_16bit(FakeEncodeStereo, &state, pcm, sizeof(pcm),
+                                   out.data()));
+  EXPECT_EQ(sizeof(pcm) / 16, state.calls);
+  EXPECT_EQ(0xa5, out.back());
+
+  /* Same code words as one library call per group of four samples */
+  FakeState ref_state;
+  for (size_t n = 0; n < sizeof(pcm) / 16; n++) {
+    uint32_t pcmL[4];
+    uint32_t pcmR[4];
+    uint16_t words[2];
+    for (int i = 0; i < 4; i++) {
+      uint16_t l, r;
+      memcpy(&l, pcm + n * 16 + i * 4, 2);
+      memcpy(&r, pcm + n * 16 + i * 4 + 2, 2);
+      pcmL[i] = l;
+      pcmR[i] = r;
+    }
+    FakeEncodeStereo(&ref_state, pcmL, pcmR, words);
+    EXPECT_EQ(words[0] >> 8, out[n * 4 + 0]);
+    EXPECT_EQ(words[0] & 0xff, out[n * 4 + 1]);
+    EXPECT_EQ(words[1] >> 8, out[n * 4 + 2]);
+    EXPECT_EQ(words[1] & 0xff, out[n * 4 + 3]);
+  }
+}
+
+TEST(A2dpVendorAptxPcmTest, encode_24bit_expands_packed_samples) {
+  std::vector<uint8_t> pcm = RandomPcm(24 * 3);
+  FakeState state;
+  state.hd = true;
+  std::vector<uint8_t> out(pcm.size() / 4);
+
+  EXPECT_EQ(pcm.size(), a2dp_aptx_hd_encode_24bit(FakeEncodeStereo, &state,
+                                                  pcm.data(), pcm.size(),
+                                                  out.data()));
+  EXPECT_EQ(3u, state.calls);
+
+  FakeState ref_state;
+  ref_state.hd = true;
+  for (size_t n = 0; n < 3; n++) {
+    uint32_t pcmL[4];
+    uint32_t pcmR[4];
+    uint32_t words[2];
+    const uint8_t* p = pcm.data() + n * 24;
+    for (int i = 0; i < 4; i++, p += 6) {
+      pcmL[i] = p[0] | (p[1] << 8) | (((int8_t)p[2]) << 16);
+      pcmR[i] = p[3] | (p[4] << 8) | (((int8_t)p[5]) << 16);
+    }
+    FakeEncodeStereo(&ref_state, pcmL, pcmR, words);
+    for (int w = 0; w < 2; w++) {
+      EXPECT_EQ((words[w] >> 16) & 0xff, out[n * 6 + w * 3 + 0]);
+      EXPECT_EQ((words[w] >> 8) & 0xff, out[n * 6 + w * 3 + 1]);
+      EXPECT_EQ(words[w] & 0xff, out[n * 6 + w * 3 + 2]);
+    }
+  }
+}
+
+TEST(A2dpVendorAptxPcmTest, feed_keeps_underflow_for_next_packet) {
+  g_source = RandomPcm(1000);
+  g_source_pos = 0;
+  tA2DP_APTX_PCM_FEED feed;
+  feed.len = 0;
+  uint32_t bytes_read = 0;
+
+  g_read_limit = 150;
+  EXPECT_FALSE(a2dp_aptx_pcm_feed_fill(&feed, ReadSource, 224, &bytes_read));
+  EXPECT_EQ(150u, bytes_read);
+  EXPECT_EQ(150u, feed.len);
+
+  /* Only the missing octets are read, and the packet starts with the PCM
+   * read on underflow */
+  g_read_limit = 1000;
+  EXPECT_TRUE(a2dp_aptx_pcm_feed_fill(&feed, ReadSource, 224, &bytes_read));
+  EXPECT_EQ(74u, bytes_read);
+  EXPECT_EQ(0, memcmp(feed.pcm, g_source.data(), 224));
+  a2dp_aptx_pcm_feed_consume(&feed, 224);
+  EXPECT_EQ(0u, feed.len);
+
+  EXPECT_TRUE(a2dp_aptx_pcm_feed_fill(&feed, ReadSource, 208, &bytes_read));
+  EXPECT_EQ(208u, bytes_read);
+  EXPECT_EQ(0, memcmp(feed.pcm, g_source.data() + 224, 208));
+}
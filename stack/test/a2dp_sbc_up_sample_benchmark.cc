@@ -0,0 +1,58 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "stack/include/a2dp_sbc_up_sample.h"
+
+namespace {
+
+/* Audio feed period, matching the A2DP media timer tick */
+constexpr uint32_t kFeedPeriodMs = 20;
+
+/* Converts one feed period from the source rate to the SBC rate, as the
+ * encoder does on every media timer tick */
+void BM_UpSample(benchmark::State& state, uint32_t src_sps, uint32_t dst_sps,
+                 uint8_t bits, uint8_t n_channels) {
+  uint32_t src_bytes = src_sps * kFeedPeriodMs / 1000 * n_channels * bits / 8;
+  uint32_t dst_bytes = (dst_sps * kFeedPeriodMs / 1000 + 1) * 4;
+  std::vector<uint8_t> src(src_bytes, 0x5a);
+  std::vector<int16_t> dst(dst_bytes / sizeof(int16_t));
+  uint32_t src_used = 0;
+
+  a2dp_sbc_init_up_sample(src_sps, dst_sps, bits, n_channels);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a2dp_sbc_up_sample(
+        src.data(), dst.data(), src_bytes, dst_bytes, &src_used));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * src_bytes);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_UpSample, 16s_8k_to_48k, 8000, 48000, 16, 2);
+BENCHMARK_CAPTURE(BM_UpSample, 16s_22k_to_44k, 22050, 44100, 16, 2);
+BENCHMARK_CAPTURE(BM_UpSample, 16s_44k_to_48k, 44100, 48000, 16, 2);
+BENCHMARK_CAPTURE(BM_UpSample, 16m_16k_to_48k, 16000, 48000, 16, 1);
+BENCHMARK_CAPTURE(BM_UpSample, 8s_11k_to_44k, 11025, 44100, 8, 2);
+BENCHMARK_CAPTURE(BM_UpSample, 8m_8k_to_48k, 8000, 48000, 8, 1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#include "stack/include/a2dp_vendor_aptx_pcm.h"
+
+namespace {
+
+/* Stands for the vendor library, which is not available on the host: the
+ * benchmarks measure the PCM feed, sample expansion and packing around it */
+int FakeEncodeStereo(void* state, void* pcmL, void* pcmR, void* buffer) {
+  const uint32_t* left = static_cast<const uint32_t*>(pcmL);
+  const uint32_t* right = static_cast<const uint32_t*>(pcmR);
+  uint32_t* out = static_cast<uint32_t*>(buffer);
+  out[0] = left[0] ^ left[1] ^ left[2] ^ left[3];
+  out[1] = right[0] ^ right[1] ^ right[2] ^ right[3];
+  return 0;
+}
+
+uint32_t ReadPcm(uint8_t* p_buf, uint32_t len) {
+  memset(p_buf, 0x5a, len);
+  return len;
+}
+
+/* One aptX media packet, 12 reads of 224 PCM octets at 48 kHz */
+void BM_AptxPacket(benchmark::State& state) {
+  constexpr uint32_t kPcmBytes = 12 * 224;
+  tA2DP_APTX_PCM_FEED feed;
+  feed.len = 0;
+  std::vector<uint8_t> out(kPcmBytes / 4);
+  uint32_t bytes_read;
+
+  for (auto _ : state) {
+    a2dp_aptx_pcm_feed_fill(&feed, ReadPcm, kPcmBytes, &bytes_read);
+    benchmark::DoNotOptimize(a2dp_aptx_encode_16bit(
+        FakeEncodeStereo, nullptr, feed.pcm, kPcmBytes, out.data()));
+    a2dp_aptx_pcm_feed_consume(&feed, kPcmBytes);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kPcmBytes);
+}
+
+/* One aptX-HD media packet, 108 reads of 24 PCM octets at 48 kHz */
+void BM_AptxHdPacket(benchmark::State& state) {
+  constexpr uint32_t kPcmBytes = 108 * 24;
+  tA2DP_APTX_PCM_FEED feed;
+  feed.len = 0;
+  std::vector<uint8_t> out(kPcmBytes / 4);
+  uint32_t bytes_read;
+
+  for (auto _ : state) {
+    a2dp_aptx_pcm_feed_fill(&feed, ReadPcm, kPcmBytes, &bytes_read);
+    benchmark::DoNotOptimize(a2dp_aptx_hd_encode_24bit(
+        FakeEncodeStereo, nullptr, feed.pcm, kPcmBytes, out.data()));
+    a2dp_aptx_pcm_feed_consume(&feed, kPcmBytes);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * kPcmBytes);
+}
+
+}  // namespace
+
+BENCHMARK(BM_AptxPacket);
+BENCHMARK(BM_AptxHdPacket);
+
+BENCHMARK_MAIN();
@@ -129,6 +129,46 @@ TEST(AdvertiseDataParserTest, GetFieldByType) {
   EXPECT_EQ(0, p_length);
 }
 
+TEST(AdvertiseDataParserTest, AdIndexGetFieldByType) {
+  // Flags, two complete name fields, then a field with a bad length.
+  const std::vector<uint8_t> data0{0x02, 0x01, 0x06, 0x03, 0x09, 0x41,
+                                   0x42, 0x02, 0x09, 0x43, 0x05, 0x16};
+  AdIndex index0(data0);
+
+  uint8_t p_length;
+  const uint8_t* data = index0.GetFieldByType(0x01, &p_length);
+  EXPECT_EQ(data0.data() + 2, data);
+  EXPECT_EQ(1, p_length);
+
+  // First field of the type is returned.
+  data = index0.GetFieldByType(0x09, &p_length);
+  EXPECT_EQ(data0.data() + 5, data);
+  EXPECT_EQ(2, p_length);
+
+  data = index0.GetFieldByType(0x16, &p_length);
+  EXPECT_EQ(nullptr, data);
+  EXPECT_EQ(0, p_length);
+
+  // More fields than the index holds, the last ones come from the data.
+  std::vector<uint8_t> data1;
+  for (size_t i = 0; i < AdIndex::kMaxFields + 4; i++) {
+    data1.insert(data1.end(), {0x02, (uint8_t)(0x20 + i), (uint8_t)i});
+  }
+  AdIndex index1(data1);
+  for (size_t i = 0; i < AdIndex::kMaxFields + 5; i++) {
+    uint8_t expected_length;
+    const uint8_t* expected = AdvertiseDataParser::GetFieldByType(
+        data1, 0x20 + i, &expected_length);
+    data = index1.GetFieldByType(0x20 + i, &p_length);
+    EXPECT_EQ(expected, data);
+    EXPECT_EQ(expected_length, p_length);
+  }
+
+  AdIndex index2(nullptr, 0);
+  EXPECT_EQ(nullptr, index2.GetFieldByType(0x01, &p_length));
+  EXPECT_EQ(0, p_length);
+}
+
 // This test makes sure that RemoveTrailingZeros is working correctly. It does
 // run the RemoveTrailingZeros for ad data, then glue scan response at end of
 // it, and checks that the resulting data is good.
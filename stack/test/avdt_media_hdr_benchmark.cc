@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+#include "avdt_api.h"
+#include "stack/avdt/avdt_defs.h"
+
+namespace {
+
+/* SBC media codec information element, as stored in the stream config */
+constexpr uint8_t kCodecInfo[] = {6, AVDT_MEDIA_TYPE_AUDIO << 4, 0, 0x21,
+                                  0x15, 2, 53};
+constexpr uint8_t kPayloadType = 0x60;
+
+/* A media packet buffer as produced by the encoder: the payload starts at
+ * AVDT_MEDIA_OFFSET, leaving room for the protocol headers */
+struct MediaPacket {
+  explicit MediaPacket(size_t payload_len)
+      : data(AVDT_MEDIA_OFFSET + payload_len) {}
+  void Rewind() { offset = AVDT_MEDIA_OFFSET; }
+  uint8_t* Prepend(uint16_t len) {
+    offset -= len;
+    return data.data() + offset;
+  }
+  std::vector<uint8_t> data;
+  uint16_t offset = AVDT_MEDIA_OFFSET;
+};
+
+/* Per-packet header build: SSRC derived from the codec info and every field
+ * serialized through the byte stream macros */
+void BM_MediaHdrStream(benchmark::State& state) {
+  MediaPacket pkt(state.range(0));
+  uint16_t seq = 0;
+  uint32_t time_stamp = 0;
+  for (auto _ : state) {
+    pkt.Rewind();
+    uint32_t ssrc = (uint32_t)(kCodecInfo[1] | kCodecInfo[2]);
+    uint8_t* p = pkt.Prepend(AVDT_MEDIA_HDR_SIZE);
+    UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
+    UINT8_TO_BE_STREAM(p, kPayloadType);
+    UINT16_TO_BE_STREAM(p, ++seq);
+    UINT32_TO_BE_STREAM(p, time_stamp);
+    UINT32_TO_BE_STREAM(p, ssrc);
+    time_stamp += 128;
+    benchmark::DoNotOptimize(pkt.data.data());
+  }
+}
+BENCHMARK(BM_MediaHdrStream)->Arg(256)->Arg(1024);
+
+/* Per-packet header build from the stream template */
+void BM_MediaHdrTemplate(benchmark::State& state) {
+  MediaPacket pkt(state.range(0));
+  uint8_t media_hdr[AVDT_MEDIA_HDR_SIZE];
+  AVDT_MEDIA_HDR_BLD_TEMPLATE(media_hdr,
+                              (uint32_t)(kCodecInfo[1] | kCodecInfo[2]));
+  uint16_t seq = 0;
+  uint32_t time_stamp = 0;
+  for (auto _ : state) {
+    pkt.Rewind();
+    uint8_t* p = pkt.Prepend(AVDT_MEDIA_HDR_SIZE);
+    ++seq;
+    AVDT_MEDIA_HDR_BLD_FROM_TEMPLATE(p, media_hdr, kPayloadType, seq,
+                                     time_stamp);
+    time_stamp += 128;
+    benchmark::DoNotOptimize(pkt.data.data());
+  }
+}
+BENCHMARK(BM_MediaHdrTemplate)->Arg(256)->Arg(1024);
+
+/* Reference cost of a packet without headroom: the payload is copied into a
+ * new buffer before the header can be prepended */
+void BM_MediaHdrCopyPayload(benchmark::State& state) {
+  std::vector<uint8_t> payload(state.range(0));
+  uint8_t media_hdr[AVDT_MEDIA_HDR_SIZE];
+  AVDT_MEDIA_HDR_BLD_TEMPLATE(media_hdr,
+                              (uint32_t)(kCodecInfo[1] | kCodecInfo[2]));
+  uint16_t seq = 0;
+  uint32_t time_stamp = 0;
+  for (auto _ : state) {
+    MediaPacket pkt(payload.size());
+    memcpy(pkt.data.data() + pkt.offset, payload.data(), payload.size());
+    uint8_t* p = pkt.Prepend(AVDT_MEDIA_HDR_SIZE);
+    ++seq;
+    AVDT_MEDIA_HDR_BLD_FROM_TEMPLATE(p, media_hdr, kPayloadType, seq,
+                                     time_stamp);
+    time_stamp += 128;
+    benchmark::DoNotOptimize(pkt.data.data());
+  }
+}
+BENCHMARK(BM_MediaHdrCopyPayload)->Arg(256)->Arg(1024);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -145,6 +145,7 @@ class BleAdvertisingManagerTest : public testing::Test {
   int reg_status = -1;
   int set_params_status = -1;
   int set_data_status = -1;
+  int set_data_count = 0;
   int enable_status = -1;
   int start_advertising_status = -1;
   int start_advertising_set_advertiser_id = -1;
@@ -182,7 +183,10 @@ class BleAdvertisingManagerTest : public testing::Test {
   void SetParametersCb(uint8_t status, int8_t tx_power) {
     set_params_status = status;
   }
-  void SetDataCb(uint8_t status) { set_data_status = status; }
+  void SetDataCb(uint8_t status) {
+    set_data_status = status;
+    set_data_count++;
+  }
   void EnableCb(uint8_t status) { enable_status = status; }
   void StartAdvertisingCb(uint8_t status) { start_advertising_status = status; }
   void StartAdvertisingSetCb(uint8_t advertiser_id, int8_t tx_power,
@@ -672,6 +676,56 @@ TEST_F(BleAdvertisingManagerTest, test_data_sender) {
   EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
 }
 
+/* Updates made while a data write is in flight are coalesced into one write of
+ * the latest data, and unchanged data is not written again */
+TEST_F(BleAdvertisingManagerTest, test_data_coalescing) {
+  BleAdvertisingManager::Get()->RegisterAdvertiser(
+      Bind(&BleAdvertisingManagerTest::RegistrationCb, base::Unretained(this)));
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, reg_status);
+  int advertiser_id = reg_inst_id;
+
+  std::vector<uint8_t> data = {0x03 /* len */, 0xFF, 0x01, 0x00};
+  status_cb set_data_cb;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(advertiser_id, COMPLETE, _, 4, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cb));
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data,
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  data[3] = 0x01;
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data,
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  data[3] = 0x02;
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data,
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  /* Only the latest data is written once the first write completes */
+  status_cb set_latest_data_cb;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(advertiser_id, COMPLETE, _, _, _, _))
+      .With(Args<4, 3>(ElementsAreArray(data)))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_latest_data_cb));
+  set_data_cb.Run(0);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  EXPECT_EQ(1, set_data_count);
+
+  set_latest_data_cb.Run(0);
+  EXPECT_EQ(3, set_data_count);
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+
+  /* The data is already in the controller */
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(_, _, _, _, _, _)).Times(0);
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data,
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  EXPECT_EQ(4, set_data_count);
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+}
+
 /* This test makes sure that conectable advertisment with timeout will get it's
  * address updated once the timeout passes and one tries to enable it again.*/
 TEST_F(BleAdvertisingManagerTest,
@@ -1112,3 +1166,102 @@ TEST_F(BleAdvertisingManagerTest, test_recompute_timeout) {
   testRecomputeTimeout2();
   testRecomputeTimeout3();
 }
+
+/* This test verifies that non-connectable sets started once all the controller
+ * instances are in use take turns on the instances that can be shared */
+TEST_F(BleAdvertisingManagerTest, test_rotated_advertising_sets) {
+  for (int i = 0; i < num_adv_instances; i++) {
+    BleAdvertisingManager::Get()->RegisterAdvertiser(Bind(
+        &BleAdvertisingManagerTest::RegistrationCb, base::Unretained(this)));
+    EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, reg_status);
+  }
+
+  tBTM_BLE_ADV_PARAMS params = {};
+  params.advertising_event_properties = 0x0000; /* non-connectable */
+  params.adv_int_min = 0x00A0;
+  params.adv_int_max = 0x00A0;
+  tBLE_PERIODIC_ADV_PARAMS periodic_params = {};
+  std::vector<int> rotated_ids;
+
+  // No instance is free, both sets are accepted and wait for a slot
+  EXPECT_CALL(*hci_mock, Enable(_, _, _)).Times(0);
+  for (int i = 0; i < 2; i++) {
+    BleAdvertisingManager::Get()->StartAdvertisingSet(
+        Bind(&BleAdvertisingManagerTest::StartAdvertisingSetCb,
+             base::Unretained(this)),
+        &params, std::vector<uint8_t>(), std::vector<uint8_t>(),
+        &periodic_params, std::vector<uint8_t>(), 0 /* duration */,
+        0 /* maxExtAdvEvents */, Bind(DoNothing2));
+    EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, start_advertising_set_status);
+    EXPECT_GE(start_advertising_set_advertiser_id, num_adv_instances);
+    rotated_ids.push_back(start_advertising_set_advertiser_id);
+  }
+  EXPECT_NE(rotated_ids[0], rotated_ids[1]);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  // Let the data writes succeed once the test is done checking the commands
+  std::vector<status_cb> data_cbs;
+  auto save_data_cb = [&data_cbs](uint8_t, uint8_t, uint8_t, uint8_t,
+                                  uint8_t*, status_cb cb) {
+    data_cbs.push_back(cb);
+  };
+  auto run_data_cbs = [&data_cbs]() {
+    std::vector<status_cb> cbs;
+    cbs.swap(data_cbs);
+    for (auto& cb : cbs) cb.Run(0);
+  };
+  ON_CALL(*hci_mock, SetAdvertisingData(_, _, _, _, _, _))
+      .WillByDefault(::testing::Invoke(save_data_cb));
+  ON_CALL(*hci_mock, SetScanResponseData(_, _, _, _, _, _))
+      .WillByDefault(::testing::Invoke(save_data_cb));
+
+  // Freeing an instance gives it to the first rotated set
+  const uint8_t shared_handle = 3;
+  std::vector<SetEnableData> enabled_sets;
+  EXPECT_CALL(*hci_mock, RemoveAdvertisingSet(shared_handle, _)).Times(1);
+  EXPECT_CALL(*hci_mock,
+              SetParameters1(shared_handle, _, _, _, _, _, _, _, _))
+      .Times(1);
+  EXPECT_CALL(*hci_mock, SetParameters2(_, _, _, _, _, _, _, _)).Times(1);
+  EXPECT_CALL(*hci_mock, Enable(0x01 /* enable */, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<1>(&enabled_sets));
+  BleAdvertisingManager::Get()->Unregister(shared_handle);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  ASSERT_EQ(1UL, enabled_sets.size());
+  EXPECT_EQ(shared_handle, enabled_sets[0].handle);
+  run_data_cbs();
+
+  // Next slot goes to the second set, switching with a single command each way
+  std::vector<SetEnableData> disabled_sets;
+  EXPECT_CALL(*hci_mock, Enable(0x00 /* disable */, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<1>(&disabled_sets));
+  EXPECT_CALL(*hci_mock,
+              SetParameters1(shared_handle, _, _, _, _, _, _, _, _))
+      .Times(1);
+  EXPECT_CALL(*hci_mock, SetParameters2(_, _, _, _, _, _, _, _)).Times(1);
+  EXPECT_CALL(*hci_mock, Enable(0x01 /* enable */, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<1>(&enabled_sets));
+  last_alarm_cb(last_alarm_data);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  ASSERT_EQ(1UL, disabled_sets.size());
+  EXPECT_EQ(shared_handle, disabled_sets[0].handle);
+  ASSERT_EQ(1UL, enabled_sets.size());
+  EXPECT_EQ(shared_handle, enabled_sets[0].handle);
+  run_data_cbs();
+
+  // Once the other rotated set is gone, the remaining one keeps the instance
+  EXPECT_CALL(*hci_mock, Enable(0x00 /* disable */, _, _)).Times(1);
+  EXPECT_CALL(*hci_mock, SetParameters1(_, _, _, _, _, _, _, _, _)).Times(1);
+  EXPECT_CALL(*hci_mock, SetParameters2(_, _, _, _, _, _, _, _)).Times(1);
+  EXPECT_CALL(*hci_mock, Enable(0x01 /* enable */, _, _)).Times(1);
+  BleAdvertisingManager::Get()->Unregister(rotated_ids[1]);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  run_data_cbs();
+
+  EXPECT_CALL(*hci_mock, Enable(_, _, _)).Times(0);
+  last_alarm_cb(last_alarm_data);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+}
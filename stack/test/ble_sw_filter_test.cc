@@ -0,0 +1,222 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "stack/btm/btm_ble_sw_filter.h"
+#include "stack/include/btm_ble_api_types.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+const RawAddress kAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kOtherAddress({0x66, 0x55, 0x44, 0x33, 0x22, 0x11});
+
+ApcfCommand MakeCommand(uint8_t type) {
+  ApcfCommand cmd = {};
+  cmd.type = type;
+  return cmd;
+}
+
+/* Flags, complete 16 bit UUIDs 0x180D and 0x180F, name "abcd", manufacturer
+ * data of company 0x00E0 and 16 bit service data of UUID 0xFEAA */
+const std::vector<uint8_t> kAdvData = {
+    0x02, 0x01, 0x06, 0x05, 0x03, 0x0D, 0x18, 0x0F, 0x18, 0x05, 0x09,
+    'a',  'b',  'c',  'd',  0x05, 0xFF, 0xE0, 0x00, 0x01, 0x02, 0x05,
+    0x16, 0xAA, 0xFE, 0x10, 0x20};
+
+}  // namespace
+
+TEST(BleSoftwareFilterTest, NoFilterEnabled) {
+  BleSoftwareFilter filter;
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  filter.Set(0, {MakeCommand(BTM_BLE_PF_SRVC_DATA)});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  filter.Enable(0, false);
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, Address) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_ADDR_FILTER);
+  cmd.address = kAddress;
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+  EXPECT_FALSE(filter.Match(kOtherAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, ServiceUuid) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_SRVC_UUID);
+  cmd.uuid = Uuid::From16Bit(0x180F);
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  cmd.uuid = Uuid::From16Bit(0x1810);
+  filter.Set(0, {cmd});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  /* Only the upper byte of the 16 bit UUID is compared */
+  cmd.uuid_mask = Uuid::From16Bit(0xFF00);
+  filter.Set(0, {cmd});
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  /* A 128 bit UUID on the Bluetooth base matches its 16 bit form */
+  cmd.uuid = Uuid::FromString("0000180d-0000-1000-8000-00805f9b34fb");
+  cmd.uuid_mask = Uuid::kEmpty;
+  filter.Set(0, {cmd});
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, SolicitationUuidNotServiceUuid) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_SRVC_SOL_UUID);
+  cmd.uuid = Uuid::From16Bit(0x180F);
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  const std::vector<uint8_t> sol_data = {0x03, 0x14, 0x0F, 0x18};
+  EXPECT_TRUE(filter.Match(kAddress, sol_data));
+}
+
+TEST(BleSoftwareFilterTest, LocalName) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_LOCAL_NAME);
+  cmd.name = {'a', 'b', 'c', 'd'};
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  /* Names have to match as a whole */
+  cmd.name = {'a', 'b', 'c'};
+  filter.Set(0, {cmd});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, ManufacturerData) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_MANU_DATA);
+  cmd.company = 0x00E0;
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  cmd.data = {0x01, 0x03};
+  cmd.data_mask = {0xFF, 0xFF};
+  filter.Set(0, {cmd});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  cmd.data_mask = {0xFF, 0x00};
+  filter.Set(0, {cmd});
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  cmd.company = 0x004C;
+  filter.Set(0, {cmd});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, ServiceDataPattern) {
+  BleSoftwareFilter filter;
+  ApcfCommand cmd = MakeCommand(BTM_BLE_PF_SRVC_DATA_PATTERN);
+  cmd.data = {0xAA, 0xFE, 0x10};
+  filter.Set(0, {cmd});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  cmd.data = {0xAA, 0xFE, 0x11};
+  filter.Set(0, {cmd});
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, ConditionsOfOneTypeAreOred) {
+  BleSoftwareFilter filter;
+  ApcfCommand uuid_a = MakeCommand(BTM_BLE_PF_SRVC_UUID);
+  uuid_a.uuid = Uuid::From16Bit(0x1810);
+  ApcfCommand uuid_b = MakeCommand(BTM_BLE_PF_SRVC_UUID);
+  uuid_b.uuid = Uuid::From16Bit(0x180D);
+  filter.Set(0, {uuid_a, uuid_b});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, ConditionTypesAreAnded) {
+  BleSoftwareFilter filter;
+  ApcfCommand addr = MakeCommand(BTM_BLE_PF_ADDR_FILTER);
+  addr.address = kAddress;
+  ApcfCommand uuid = MakeCommand(BTM_BLE_PF_SRVC_UUID);
+  uuid.uuid = Uuid::From16Bit(0x180D);
+  filter.Set(0, {uuid, addr});
+  filter.Enable(0, true);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+  EXPECT_FALSE(filter.Match(kOtherAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, AnyEnabledFilterMatches) {
+  BleSoftwareFilter filter;
+  ApcfCommand addr = MakeCommand(BTM_BLE_PF_ADDR_FILTER);
+  addr.address = kOtherAddress;
+  ApcfCommand name = MakeCommand(BTM_BLE_PF_LOCAL_NAME);
+  name.name = {'a', 'b', 'c', 'd'};
+  filter.Set(1, {addr});
+  filter.Set(20, {name});
+  filter.Enable(1, true);
+  filter.Enable(20, true);
+
+  EXPECT_TRUE(filter.IsAnyEnabledFrom(16));
+  EXPECT_FALSE(filter.IsAnyEnabledFrom(21));
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+
+  filter.Enable(20, false);
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+  EXPECT_TRUE(filter.Match(kOtherAddress, kAdvData));
+
+  filter.ClearAll();
+  EXPECT_FALSE(filter.IsAnyEnabledFrom(0));
+  EXPECT_FALSE(filter.Match(kOtherAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, FilterWithoutConditionsMatchesAll) {
+  BleSoftwareFilter filter;
+  ApcfCommand addr = MakeCommand(BTM_BLE_PF_ADDR_FILTER);
+  addr.address = kOtherAddress;
+  filter.Set(0, {addr});
+  filter.Enable(0, true);
+  EXPECT_FALSE(filter.Match(kAddress, kAdvData));
+
+  filter.Clear(0);
+  EXPECT_TRUE(filter.Match(kAddress, kAdvData));
+}
+
+TEST(BleSoftwareFilterTest, MalformedData) {
+  BleSoftwareFilter filter;
+  filter.Set(0, {MakeCommand(BTM_BLE_PF_SRVC_DATA)});
+  filter.Enable(0, true);
+
+  const std::vector<uint8_t> truncated = {0x05, 0x16, 0xAA};
+  EXPECT_FALSE(filter.Match(kAddress, truncated));
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/btm/btm_dev_index.h"
+
+namespace {
+
+const RawAddress kAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+const RawAddress kPseudoAddress({0x66, 0x55, 0x44, 0x33, 0x22, 0x11});
+const RawAddress kRpa({0x4a, 0x22, 0x33, 0x44, 0x55, 0x66});
+
+tBTM_SEC_DEV_REC MakeRecord(const RawAddress& bd_addr, uint16_t hci_handle,
+                            uint16_t ble_hci_handle) {
+  tBTM_SEC_DEV_REC dev_rec = {};
+  dev_rec.bd_addr = bd_addr;
+  dev_rec.hci_handle = hci_handle;
+  dev_rec.ble_hci_handle = ble_hci_handle;
+  return dev_rec;
+}
+
+}  // namespace
+
+TEST(SecDevRecIndexTest, FindByAddressAndHandle) {
+  SecDevRecIndex index;
+  tBTM_SEC_DEV_REC dev_rec = MakeRecord(kAddress, 0x0001, 0x0002);
+  dev_rec.ble.pseudo_addr = kPseudoAddress;
+  index.Update(&dev_rec);
+
+  EXPECT_EQ(&dev_rec, index.FindByAddress(kAddress));
+  EXPECT_EQ(&dev_rec, index.FindByAddress(kPseudoAddress));
+  EXPECT_EQ(nullptr, index.FindByAddress(kRpa));
+  EXPECT_EQ(&dev_rec, index.FindByHandle(0x0001));
+  EXPECT_EQ(&dev_rec, index.FindByHandle(0x0002));
+  EXPECT_EQ(nullptr, index.FindByHandle(0x0003));
+
+  index.Remove(&dev_rec);
+  EXPECT_EQ(nullptr, index.FindByAddress(kAddress));
+  EXPECT_EQ(nullptr, index.FindByHandle(0x0001));
+}
+
+TEST(SecDevRecIndexTest, UpdateMovesKeys) {
+  SecDevRecIndex index;
+  tBTM_SEC_DEV_REC dev_rec =
+      MakeRecord(kAddress, HCI_INVALID_HANDLE, HCI_INVALID_HANDLE);
+  index.Update(&dev_rec);
+
+  dev_rec.hci_handle = 0x0010;
+  dev_rec.bd_addr = kPseudoAddress;
+  index.Update(&dev_rec);
+  EXPECT_EQ(&dev_rec, index.FindByHandle(0x0010));
+  /* The LE link is still down */
+  EXPECT_EQ(&dev_rec, index.FindByHandle(HCI_INVALID_HANDLE));
+  EXPECT_EQ(&dev_rec, index.FindByAddress(kPseudoAddress));
+  EXPECT_EQ(nullptr, index.FindByAddress(kAddress));
+}
+
+TEST(SecDevRecIndexTest, StaleKeysAreNotReturned) {
+  SecDevRecIndex index;
+  tBTM_SEC_DEV_REC dev_rec = MakeRecord(kAddress, 0x0001, 0x0002);
+  index.Update(&dev_rec);
+
+  /* Changed without an update */
+  dev_rec.hci_handle = HCI_INVALID_HANDLE;
+  EXPECT_EQ(nullptr, index.FindByHandle(0x0001));
+  EXPECT_EQ(&dev_rec, index.FindByHandle(0x0002));
+}
+
+TEST(SecDevRecIndexTest, FirstAllocatedRecordWins) {
+  SecDevRecIndex index;
+  tBTM_SEC_DEV_REC first = MakeRecord(kPseudoAddress, 0x0001, 0x0002);
+  tBTM_SEC_DEV_REC second = MakeRecord(kAddress, 0x0003, 0x0004);
+  index.Update(&first);
+  index.Update(&second);
+
+  /* The first record now shares the address of the second one */
+  first.ble.pseudo_addr = kAddress;
+  index.Update(&first);
+  EXPECT_EQ(&first, index.FindByAddress(kAddress));
+
+  index.Remove(&first);
+  EXPECT_EQ(&second, index.FindByAddress(kAddress));
+}
+
+TEST(SecDevRecIndexTest, RpaCandidates) {
+  SecDevRecIndex index;
+  tBTM_SEC_DEV_REC dev_rec = MakeRecord(kAddress, 0x0001, 0x0002);
+  index.Update(&dev_rec);
+
+  EXPECT_EQ(nullptr, index.FindRpaCandidate(kRpa));
+  index.PutRpa(kRpa, &dev_rec);
+  EXPECT_EQ(&dev_rec, index.FindRpaCandidate(kRpa));
+
+  index.Remove(&dev_rec);
+  EXPECT_EQ(nullptr, index.FindRpaCandidate(kRpa));
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+
+#include "btif/include/btif_config.h"
+#include "stack/btm/btm_rmt_cache.h"
+#include "test/mock/mock_btif_config.h"
+
+namespace mock = test::mock::btif_config;
+
+namespace {
+
+const RawAddress kAddress({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
+
+/* The config, by "section/key" */
+std::map<std::string, std::string> config;
+
+std::string config_key(const std::string& section, const std::string& key) {
+  return section + "/" + key;
+}
+
+bool get(const std::string& section, const std::string& key,
+         std::string* value) {
+  auto it = config.find(config_key(section, key));
+  if (it == config.end()) return false;
+  *value = it->second;
+  return true;
+}
+
+bool set(const std::string& section, const std::string& key,
+         const std::string& value) {
+  config[config_key(section, key)] = value;
+  return true;
+}
+
+class BtmRmtCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    config.clear();
+    mock::btif_config_get_int.body = [](const std::string& section,
+                                        const std::string& key, int* value) {
+      std::string s;
+      if (!get(section, key, &s)) return false;
+      *value = std::stoi(s);
+      return true;
+    };
+    mock::btif_config_set_int.body = [](const std::string& section,
+                                        const std::string& key, int value) {
+      return set(section, key, std::to_string(value));
+    };
+    mock::btif_config_get_uint64.body =
+        [](const std::string& section, const std::string& key,
+           uint64_t* value) {
+          std::string s;
+          if (!get(section, key, &s)) return false;
+          *value = std::stoull(s);
+          return true;
+        };
+    mock::btif_config_set_uint64.body = [](const std::string& section,
+                                           const std::string& key,
+                                           uint64_t value) {
+      return set(section, key, std::to_string(value));
+    };
+    mock::btif_config_get_str.body = [](const std::string& section,
+                                        const std::string& key, char* value,
+                                        int* size_bytes) {
+      std::string s;
+      if (!get(section, key, &s)) return false;
+      if (static_cast<int>(s.size()) >= *size_bytes) return false;
+      strcpy(value, s.c_str());
+      *size_bytes = s.size() + 1;
+      return true;
+    };
+    mock::btif_config_set_str.body = set;
+    mock::btif_config_get_bin_length.body = [](const std::string& section,
+                                               const std::string& key) {
+      std::string s;
+      return get(section, key, &s) ? s.size() : 0;
+    };
+    mock::btif_config_get_bin.body = [](const std::string& section,
+                                        const std::string& key, uint8_t* value,
+                                        size_t* length) {
+      std::string s;
+      if (!get(section, key, &s) || s.size() > *length) return false;
+      memcpy(value, s.data(), s.size());
+      *length = s.size();
+      return true;
+    };
+    mock::btif_config_set_bin.body = [](const std::string& section,
+                                        const std::string& key,
+                                        const uint8_t* value, size_t length) {
+      return set(section, key,
+                 std::string(reinterpret_cast<const char*>(value), length));
+    };
+  }
+
+  void TearDown() override {
+    mock::btif_config_get_int = {};
+    mock::btif_config_set_int = {};
+    mock::btif_config_get_uint64 = {};
+    mock::btif_config_set_uint64 = {};
+    mock::btif_config_get_str = {};
+    mock::btif_config_set_str = {};
+    mock::btif_config_get_bin_length = {};
+    mock::btif_config_get_bin = {};
+    mock::btif_config_set_bin = {};
+  }
+
+  /* Makes what was saved under |key| |age_s| old */
+  void Age(const std::string& key, uint64_t age_s) {
+    set(kAddress.ToString(), key,
+        std::to_string(static_cast<uint64_t>(time(nullptr)) - age_s));
+  }
+};
+
+TEST_F(BtmRmtCacheTest, name) {
+  BD_NAME name;
+  uint16_t length;
+  EXPECT_FALSE(btm_rmt_cache_get_name(kAddress, name, &length));
+
+  const char kName[] = "Headset";
+  btm_rmt_cache_set_name(kAddress, reinterpret_cast<const uint8_t*>(kName),
+                         sizeof(kName) - 1);
+  ASSERT_TRUE(btm_rmt_cache_get_name(kAddress, name, &length));
+  EXPECT_EQ(length, sizeof(kName) - 1);
+  EXPECT_STREQ(reinterpret_cast<char*>(name), kName);
+
+  Age(BT_CONFIG_KEY_RMT_NAME_TIME, BTM_RMT_NAME_CACHE_TTL_S);
+  EXPECT_FALSE(btm_rmt_cache_get_name(kAddress, name, &length));
+}
+
+TEST_F(BtmRmtCacheTest, name_in_the_future_is_stale) {
+  const char kName[] = "Headset";
+  btm_rmt_cache_set_name(kAddress, reinterpret_cast<const uint8_t*>(kName),
+                         sizeof(kName) - 1);
+  set(kAddress.ToString(), BT_CONFIG_KEY_RMT_NAME_TIME,
+      std::to_string(static_cast<uint64_t>(time(nullptr)) + 3600));
+
+  BD_NAME name;
+  uint16_t length;
+  EXPECT_FALSE(btm_rmt_cache_get_name(kAddress, name, &length));
+}
+
+TEST_F(BtmRmtCacheTest, version_and_features) {
+  tREMOTE_VERSION_INFO version = {.lmp_version = 10,
+                                  .lmp_subversion = 0x1234,
+                                  .manufacturer = 0x000f,
+                                  .valid = true};
+  BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1] = {
+      {0xff, 0xfe, 0x8f, 0xfe, 0xd8, 0x3f, 0x5b, 0x87}, {0x0f}, {0x45}};
+  btm_rmt_cache_set_info(kAddress, version, pages, 2);
+
+  tREMOTE_VERSION_INFO cached;
+  BD_FEATURES cached_pages[HCI_EXT_FEATURES_PAGE_MAX + 1] = {};
+  uint8_t max_page;
+  ASSERT_TRUE(
+      btm_rmt_cache_get_info(kAddress, &cached, cached_pages, &max_page));
+  EXPECT_TRUE(cached.valid);
+  EXPECT_EQ(cached.lmp_version, version.lmp_version);
+  EXPECT_EQ(cached.lmp_subversion, version.lmp_subversion);
+  EXPECT_EQ(cached.manufacturer, version.manufacturer);
+  ASSERT_EQ(max_page, 2);
+  EXPECT_EQ(memcmp(cached_pages, pages, 3 * BD_FEATURES_LEN), 0);
+
+  Age(BT_CONFIG_KEY_RMT_INFO_TIME, BTM_RMT_INFO_CACHE_TTL_S);
+  EXPECT_FALSE(
+      btm_rmt_cache_get_info(kAddress, &cached, cached_pages, &max_page));
+}
+
+TEST_F(BtmRmtCacheTest, invalid_version_is_not_saved) {
+  tREMOTE_VERSION_INFO version;
+  BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1] = {};
+  btm_rmt_cache_set_info(kAddress, version, pages, 0);
+
+  uint8_t max_page;
+  EXPECT_FALSE(btm_rmt_cache_get_info(kAddress, &version, pages, &max_page));
+}
+
+TEST_F(BtmRmtCacheTest, malformed_features_are_ignored) {
+  tREMOTE_VERSION_INFO version = {.lmp_version = 10, .valid = true};
+  BD_FEATURES pages[HCI_EXT_FEATURES_PAGE_MAX + 1] = {};
+  btm_rmt_cache_set_info(kAddress, version, pages, 0);
+  set(kAddress.ToString(), BT_CONFIG_KEY_RMT_FEATURES, "short");
+
+  uint8_t max_page;
+  EXPECT_FALSE(btm_rmt_cache_get_info(kAddress, &version, pages, &max_page));
+}
+
+}  // namespace
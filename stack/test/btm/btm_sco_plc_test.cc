@@ -0,0 +1,184 @@
+/*
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <cmath>
+
+#include "embdrv/sbc/decoder/include/oi_codec_sbc.h"
+#include "embdrv/sbc/encoder/include/sbc_encoder.h"
+#include "stack/btm/btm_sco_plc.h"
+
+namespace {
+
+constexpr size_t kFrameSamples = ScoPlc::kFrameSamples;
+
+class ScoPlcTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    memset(&encoder_, 0, sizeof(encoder_));
+    encoder_.Format = SBC_FORMAT_MSBC;
+    SBC_Encoder_Init(&encoder_);
+    ASSERT_TRUE(OI_SUCCESS(OI_CODEC_SBC_DecoderReset(
+        &decoder_, decoder_data_, sizeof(decoder_data_), 1, 1, false)));
+    ASSERT_TRUE(OI_SUCCESS(OI_CODEC_SBC_DecoderConfigureMSbc(&decoder_)));
+    t_ = 0;
+  }
+
+  /* 250 Hz tone, a period of 64 samples at 16 kHz */
+  void NextInput(int16_t* pcm) {
+    for (size_t i = 0; i < kFrameSamples; i++, t_++) {
+      pcm[i] = static_cast<int16_t>(8000 * std::sin(2 * M_PI * t_ / 64.0));
+    }
+  }
+
+  void Encode(int16_t* pcm, uint8_t* frame) {
+    ASSERT_EQ(SBC_Encode(&encoder_, pcm, frame),
+              static_cast<uint32_t>(SBC_MSBC_FRAME_LEN));
+  }
+
+  bool Decode(OI_CODEC_SBC_DECODER_CONTEXT* decoder, const uint8_t* frame,
+              int16_t* pcm) {
+    const OI_BYTE* data = frame;
+    uint32_t bytes = SBC_MSBC_FRAME_LEN;
+    uint32_t pcm_bytes = kFrameSamples * sizeof(int16_t);
+    return OI_SUCCESS(OI_CODEC_SBC_DecodeFrame(decoder, &data, &bytes, pcm,
+                                               &pcm_bytes)) &&
+           pcm_bytes == kFrameSamples * sizeof(int16_t);
+  }
+
+  SBC_ENC_PARAMS encoder_;
+  OI_CODEC_SBC_DECODER_CONTEXT decoder_;
+  uint32_t decoder_data_[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+  size_t t_;
+};
+
+double Energy(const int16_t* pcm) {
+  double energy = 0;
+  for (size_t i = 0; i < kFrameSamples; i++) energy += pcm[i] * pcm[i];
+  return energy;
+}
+
+double Error(const int16_t* a, const int16_t* b) {
+  double error = 0;
+  for (size_t i = 0; i < kFrameSamples; i++) {
+    error += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return error;
+}
+
+TEST_F(ScoPlcTest, msbc_round_trip) {
+  int16_t in[kFrameSamples];
+  int16_t out[kFrameSamples];
+  uint8_t frame[SBC_MSBC_FRAME_LEN];
+
+  for (int i = 0; i < 20; i++) {
+    NextInput(in);
+    Encode(in, frame);
+    EXPECT_EQ(frame[0], SBC_MSBC_SYNC_WORD);
+    EXPECT_EQ(frame[1], 0);
+    EXPECT_EQ(frame[2], 0);
+    ASSERT_TRUE(Decode(&decoder_, frame, out));
+  }
+  /* The decoded tone keeps its level past the codec delay */
+  EXPECT_NEAR(Energy(out) / Energy(in), 1.0, 0.1);
+}
+
+TEST_F(ScoPlcTest, good_frames_pass_through) {
+  ScoPlc plc;
+  int16_t in[kFrameSamples];
+  int16_t out[kFrameSamples];
+
+  for (int i = 0; i < 10; i++) {
+    NextInput(in);
+    plc.GoodFrame(in, out);
+    EXPECT_EQ(memcmp(in, out, sizeof(in)), 0);
+  }
+  EXPECT_EQ(plc.lost_frames(), 0u);
+}
+
+TEST_F(ScoPlcTest, conceals_lost_frame) {
+  ScoPlc plc;
+  int16_t in[kFrameSamples];
+  int16_t reference[kFrameSamples];
+  int16_t out[kFrameSamples];
+  uint8_t frame[SBC_MSBC_FRAME_LEN];
+  uint8_t zero_frame[SBC_MSBC_FRAME_LEN];
+
+  int16_t silence[kFrameSamples] = {0};
+  Encode(silence, zero_frame);
+  SBC_Encoder_Init(&encoder_);
+
+  /* Second decoder, receiving every frame */
+  OI_CODEC_SBC_DECODER_CONTEXT lossless;
+  uint32_t lossless_data[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+  ASSERT_TRUE(OI_SUCCESS(OI_CODEC_SBC_DecoderReset(
+      &lossless, lossless_data, sizeof(lossless_data), 1, 1, false)));
+  ASSERT_TRUE(OI_SUCCESS(OI_CODEC_SBC_DecoderConfigureMSbc(&lossless)));
+
+  for (int i = 0; i < 10; i++) {
+    NextInput(in);
+    Encode(in, frame);
+    ASSERT_TRUE(Decode(&lossless, frame, reference));
+    ASSERT_TRUE(Decode(&decoder_, frame, out));
+    plc.GoodFrame(out, out);
+  }
+
+  NextInput(in);
+  Encode(in, frame);
+  ASSERT_TRUE(Decode(&lossless, frame, reference));
+  int16_t zir[kFrameSamples];
+  ASSERT_TRUE(Decode(&decoder_, zero_frame, zir));
+  plc.BadFrame(zir, out);
+  EXPECT_EQ(plc.lost_frames(), 1u);
+
+  /* Far closer to the lost frame than muting it */
+  EXPECT_LT(Error(out, reference), 0.1 * Energy(reference));
+
+  NextInput(in);
+  Encode(in, frame);
+  ASSERT_TRUE(Decode(&lossless, frame, reference));
+  ASSERT_TRUE(Decode(&decoder_, frame, out));
+  plc.GoodFrame(out, out);
+  EXPECT_EQ(plc.lost_frames(), 0u);
+  EXPECT_LT(Error(out, reference), 0.1 * Energy(reference));
+}
+
+TEST_F(ScoPlcTest, fades_out_long_losses) {
+  ScoPlc plc;
+  int16_t in[kFrameSamples];
+  int16_t out[kFrameSamples];
+  int16_t zir[kFrameSamples] = {0};
+
+  for (int i = 0; i < 10; i++) {
+    NextInput(in);
+    plc.GoodFrame(in, out);
+  }
+
+  double first = 0;
+  for (int i = 0; i < 10; i++) {
+    plc.BadFrame(zir, out);
+    if (i == 0) first = Energy(out);
+  }
+  EXPECT_GT(first, 0.5 * Energy(in));
+  EXPECT_EQ(Energy(out), 0.0);
+  EXPECT_EQ(plc.lost_frames(), 10u);
+}
+
+}  // namespace
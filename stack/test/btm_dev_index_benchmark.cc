@@ -0,0 +1,142 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "osi/include/list.h"
+#include "stack/btm/btm_dev_index.h"
+
+namespace {
+
+constexpr size_t kNumBondedDevices = 500;
+
+RawAddress MakeAddress(size_t i) {
+  RawAddress bd_addr;
+  bd_addr.address[0] = 0x00;
+  bd_addr.address[1] = 0x1b;
+  bd_addr.address[2] = 0xdc;
+  bd_addr.address[3] = (i >> 16) & 0xff;
+  bd_addr.address[4] = (i >> 8) & 0xff;
+  bd_addr.address[5] = i & 0xff;
+  return bd_addr;
+}
+
+/* A bond table of kNumBondedDevices records, in both the record list the
+ * lookups used to walk and the index */
+class BondTable {
+ public:
+  BondTable() : list_(list_new(nullptr)) {
+    for (size_t i = 0; i < kNumBondedDevices; i++) {
+      auto p_dev_rec = std::make_unique<tBTM_SEC_DEV_REC>();
+      p_dev_rec->bd_addr = MakeAddress(i);
+      p_dev_rec->ble.pseudo_addr = p_dev_rec->bd_addr;
+      p_dev_rec->hci_handle = i;
+      p_dev_rec->ble_hci_handle = kNumBondedDevices + i;
+      list_append(list_, p_dev_rec.get());
+      index_.Update(p_dev_rec.get());
+      records_.push_back(std::move(p_dev_rec));
+    }
+  }
+  ~BondTable() { list_free(list_); }
+
+  list_t* list() const { return list_; }
+  SecDevRecIndex& index() { return index_; }
+
+ private:
+  list_t* list_;
+  SecDevRecIndex index_;
+  std::vector<std::unique_ptr<tBTM_SEC_DEV_REC>> records_;
+};
+
+bool is_address_equal(void* data, void* context) {
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
+  const RawAddress* bd_addr = static_cast<RawAddress*>(context);
+  return p_dev_rec->bd_addr != *bd_addr &&
+         p_dev_rec->ble.pseudo_addr != *bd_addr;
+}
+
+bool is_handle_equal(void* data, void* context) {
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
+  uint16_t* handle = static_cast<uint16_t*>(context);
+  return p_dev_rec->hci_handle != *handle &&
+         p_dev_rec->ble_hci_handle != *handle;
+}
+
+// Address lookups walking the record list, as btm_find_dev used to
+void BM_FindByAddressList(benchmark::State& state) {
+  BondTable table;
+  size_t i = 0;
+  for (auto _ : state) {
+    RawAddress bd_addr = MakeAddress(i++ % (2 * kNumBondedDevices));
+    benchmark::DoNotOptimize(
+        list_foreach(table.list(), is_address_equal, &bd_addr));
+  }
+}
+BENCHMARK(BM_FindByAddressList);
+
+// Address lookups in the index, half of them for unknown devices
+void BM_FindByAddressIndex(benchmark::State& state) {
+  BondTable table;
+  size_t i = 0;
+  for (auto _ : state) {
+    RawAddress bd_addr = MakeAddress(i++ % (2 * kNumBondedDevices));
+    benchmark::DoNotOptimize(table.index().FindByAddress(bd_addr));
+  }
+}
+BENCHMARK(BM_FindByAddressIndex);
+
+// Handle lookups walking the record list, as btm_find_dev_by_handle used to
+void BM_FindByHandleList(benchmark::State& state) {
+  BondTable table;
+  uint16_t handle = 0;
+  for (auto _ : state) {
+    uint16_t h = handle++ % (2 * kNumBondedDevices);
+    benchmark::DoNotOptimize(list_foreach(table.list(), is_handle_equal, &h));
+  }
+}
+BENCHMARK(BM_FindByHandleList);
+
+void BM_FindByHandleIndex(benchmark::State& state) {
+  BondTable table;
+  uint16_t handle = 0;
+  for (auto _ : state) {
+    uint16_t h = handle++ % (2 * kNumBondedDevices);
+    benchmark::DoNotOptimize(table.index().FindByHandle(h));
+  }
+}
+BENCHMARK(BM_FindByHandleIndex);
+
+// Connection and disconnection of a link, reindexing the record each time
+void BM_UpdateHandle(benchmark::State& state) {
+  BondTable table;
+  tBTM_SEC_DEV_REC* p_dev_rec = table.index().FindByHandle(0);
+  for (auto _ : state) {
+    p_dev_rec->hci_handle = HCI_INVALID_HANDLE;
+    table.index().Update(p_dev_rec);
+    p_dev_rec->hci_handle = 0;
+    table.index().Update(p_dev_rec);
+  }
+}
+BENCHMARK(BM_UpdateHandle);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -1915,6 +1915,119 @@ TEST_F(IsoManagerTest, SendIsoDataBigValid) {
   }
 }
 
+TEST_F(IsoManagerTest, SendIsoDataSequenceNumbers) {
+  IsoManager::GetInstance()->CreateBig(volatile_test_big_params_evt_.big_id,
+                                       kDefaultBigParams);
+
+  uint16_t handle = volatile_test_big_params_evt_.conn_handles[0];
+  IsoManager::GetInstance()->SetupIsoDataPath(handle,
+                                              kDefaultIsoDataPathParams);
+
+  /* SDUs sent back to back are given consecutive SDU intervals, with their
+   * sequence numbers and timestamps.
+   */
+  std::vector<uint16_t> seq_nbs;
+  std::vector<uint32_t> timestamps;
+  EXPECT_CALL(bte_interface_, HciSend)
+      .Times(3)
+      .WillRepeatedly([&seq_nbs, &timestamps](BT_HDR* p_msg, uint16_t event) {
+        uint8_t* p = p_msg->data;
+        uint32_t ts;
+        uint16_t seq_nb;
+
+        ASSERT_TRUE(p_msg->layer_specific & BT_ISO_HDR_CONTAINS_TS);
+        STREAM_SKIP_UINT16(p);  // skip handle
+        STREAM_SKIP_UINT16(p);  // skip length
+        STREAM_TO_UINT32(ts, p);
+        STREAM_TO_UINT16(seq_nb, p);
+        timestamps.push_back(ts);
+        seq_nbs.push_back(seq_nb);
+      });
+
+  std::vector<uint8_t> data_vec(108, 0);
+  for (int i = 0; i < 3; i++) {
+    IsoManager::GetInstance()->SendIsoData(handle, data_vec.data(),
+                                           data_vec.size());
+  }
+
+  ASSERT_EQ(seq_nbs.size(), 3u);
+  for (size_t i = 1; i < seq_nbs.size(); i++) {
+    ASSERT_EQ(seq_nbs[i], static_cast<uint16_t>(seq_nbs[i - 1] + 1));
+    ASSERT_EQ(timestamps[i] - timestamps[i - 1], kDefaultBigParams.sdu_itv);
+  }
+}
+
+TEST_F(IsoManagerTest, SendIsoDataFragmentCredits) {
+  uint8_t num_buffers = controller_interface_.GetIsoBufferCount();
+  uint16_t iso_data_size = controller_interface_.GetIsoDataSize();
+
+  IsoManager::GetInstance()->CreateBig(volatile_test_big_params_evt_.big_id,
+                                       kDefaultBigParams);
+  IsoManager::GetInstance()->SetupIsoDataPath(
+      volatile_test_big_params_evt_.conn_handles[0], kDefaultIsoDataPathParams);
+
+  /* The SDUs with their headers take two ISO data packets each, so only half
+   * as many fit in the controller buffers.
+   */
+  std::vector<uint8_t> data_vec(iso_data_size + 1, 0);
+  EXPECT_CALL(bte_interface_, HciSend).Times(num_buffers / 2);
+  for (uint8_t i = 0; i < num_buffers; i++) {
+    IsoManager::GetInstance()->SendIsoData(
+        volatile_test_big_params_evt_.conn_handles[0], data_vec.data(),
+        data_vec.size());
+  }
+}
+
+TEST_F(IsoManagerTest, SendIsoDataSduSentEvents) {
+  uint16_t iso_data_size = controller_interface_.GetIsoDataSize();
+
+  IsoManager::GetInstance()->CreateBig(volatile_test_big_params_evt_.big_id,
+                                       kDefaultBigParams);
+  uint16_t handle = volatile_test_big_params_evt_.conn_handles[0];
+  IsoManager::GetInstance()->SetupIsoDataPath(handle,
+                                              kDefaultIsoDataPathParams);
+
+  // Two SDUs taking two ISO data packets each
+  std::vector<uint8_t> data_vec(iso_data_size + 1, 0);
+  EXPECT_CALL(bte_interface_, HciSend).Times(2);
+  for (int i = 0; i < 2; i++) {
+    IsoManager::GetInstance()->SendIsoData(handle, data_vec.data(),
+                                           data_vec.size());
+  }
+
+  std::vector<bluetooth::hci::iso_manager::iso_sdu_sent_evt> events;
+  EXPECT_CALL(*big_callbacks_,
+              OnBigEvent(bluetooth::hci::iso_manager::kIsoEventBigSduSent, _))
+      .WillRepeatedly([&events](uint8_t event_code, void* data) {
+        events.push_back(
+            *static_cast<bluetooth::hci::iso_manager::iso_sdu_sent_evt*>(
+                data));
+      });
+
+  // Half of the first SDU completed is not reported
+  uint8_t mock_rsp[5];
+  uint8_t* p = mock_rsp;
+  UINT8_TO_STREAM(p, 1);
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, 1);
+  IsoManager::GetInstance()->HandleNumComplDataPkts(mock_rsp, sizeof(mock_rsp));
+  ASSERT_TRUE(events.empty());
+
+  // The rest of the packets complete both SDUs, oldest first
+  p = mock_rsp;
+  UINT8_TO_STREAM(p, 1);
+  UINT16_TO_STREAM(p, handle);
+  UINT16_TO_STREAM(p, 3);
+  IsoManager::GetInstance()->HandleNumComplDataPkts(mock_rsp, sizeof(mock_rsp));
+
+  ASSERT_EQ(events.size(), 2u);
+  ASSERT_EQ(events[0].big_id, volatile_test_big_params_evt_.big_id);
+  ASSERT_EQ(events[0].conn_hdl, handle);
+  ASSERT_EQ(events[0].sdus_in_flight, 1);
+  ASSERT_EQ(events[1].seq_nb, static_cast<uint16_t>(events[0].seq_nb + 1));
+  ASSERT_EQ(events[1].sdus_in_flight, 0);
+}
+
 TEST_F(IsoManagerTest, SendIsoDataNoCredits) {
   uint8_t num_buffers = controller_interface_.GetIsoBufferCount();
   std::vector<uint8_t> data_vec(108, 0);
@@ -35,8 +35,14 @@ static void clear_l2cap_allowlist(uint16_t, uint16_t,
                                   uint16_t) { /* do nothing */
 }
 
-static const btsnoop_t fake_snoop = {capture, allowlist_l2c_channel,
-                                     allowlist_rfc_dlci, add_rfc_l2c_channel,
-                                     clear_l2cap_allowlist};
+static void truncate_l2c_channel(uint16_t, uint16_t) { /* do nothing */
+}
+
+static const btsnoop_t fake_snoop = {capture,
+                                     allowlist_l2c_channel,
+                                     allowlist_rfc_dlci,
+                                     add_rfc_l2c_channel,
+                                     clear_l2cap_allowlist,
+                                     truncate_l2c_channel};
 
 const btsnoop_t* btsnoop_get_interface() { return &fake_snoop; }
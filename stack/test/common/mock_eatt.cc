@@ -116,6 +116,16 @@ void EattExtension::StopAppIndicationTimer(const RawAddress& bd_addr,
   pimpl_->StopAppIndicationTimer(bd_addr, cid);
 }
 
+void EattExtension::ReportGattLoad(const RawAddress& bd_addr,
+                                   uint16_t pending_requests,
+                                   uint16_t pending_indications) {
+  pimpl_->ReportGattLoad(bd_addr, pending_requests, pending_indications);
+}
+
+void EattExtension::SetBearerPolicy(const EattBearerPolicy& policy) {}
+
+void EattExtension::Dump(int fd) {}
+
 void EattExtension::Start() {
   // It is needed here as IsoManager which is a singleton creates it, but in
   // this mock we want to destroy and recreate the mock on each test case.
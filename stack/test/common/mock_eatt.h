@@ -61,6 +61,9 @@ class MockEattExtension : public EattExtension {
               (const RawAddress& bd_addr, uint16_t cid));
   MOCK_METHOD((void), StopAppIndicationTimer,
               (const RawAddress& bd_addr, uint16_t cid));
+  MOCK_METHOD((void), ReportGattLoad,
+              (const RawAddress& bd_addr, uint16_t pending_requests,
+               uint16_t pending_indications));
 
   MOCK_METHOD((void), Start, ());
   MOCK_METHOD((void), Stop, ());
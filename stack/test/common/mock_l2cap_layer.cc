@@ -76,8 +76,10 @@ tHCI_ROLE L2CA_GetBleConnRole(const RawAddress& bd_addr) {
 
 std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
                                 const RawAddress& bd_addr,
-                                tL2CAP_LE_CFG_INFO* p_cfg) {
-  return l2cap_interface->ConnectCreditBasedReq(psm, bd_addr, p_cfg);
+                                tL2CAP_LE_CFG_INFO* p_cfg,
+                                uint8_t num_of_channels) {
+  return l2cap_interface->ConnectCreditBasedReq(psm, bd_addr, p_cfg,
+                                                num_of_channels);
 }
 
 bool L2CA_ConnectCreditBasedRsp(const RawAddress& bd_addr, uint8_t id,
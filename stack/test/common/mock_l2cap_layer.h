@@ -46,7 +46,8 @@ class L2capInterface {
                                        tL2CAP_LE_CFG_INFO* p_cfg) = 0;
   virtual std::vector<uint16_t>  ConnectCreditBasedReq(uint16_t psm,
                                 const RawAddress& bd_addr,
-                                tL2CAP_LE_CFG_INFO* p_cfg) = 0;
+                                tL2CAP_LE_CFG_INFO* p_cfg,
+                                uint8_t num_of_channels) = 0;
   virtual bool ReconfigCreditBasedConnsReq(const RawAddress& bd_addr, std::vector<uint16_t> &lcids,
                                 tL2CAP_LE_CFG_INFO* peer_cfg) = 0;
   virtual ~L2capInterface() = default;
@@ -76,10 +77,11 @@ class MockL2capInterface : public L2capInterface {
                     std::vector<uint16_t> &lcids,
                     uint16_t result,
                     tL2CAP_LE_CFG_INFO* p_cfg));
-  MOCK_METHOD3(ConnectCreditBasedReq,
+  MOCK_METHOD4(ConnectCreditBasedReq,
                std::vector<uint16_t> (uint16_t psm,
                     const RawAddress& bd_addr,
-                    tL2CAP_LE_CFG_INFO* p_cfg));
+                    tL2CAP_LE_CFG_INFO* p_cfg,
+                    uint8_t num_of_channels));
   MOCK_METHOD3(ReconfigCreditBasedConnsReq,
                bool(const RawAddress& p_bd_addr, std::vector<uint16_t> &lcids, tL2CAP_LE_CFG_INFO* peer_cfg));
 };
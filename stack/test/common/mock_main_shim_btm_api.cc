@@ -330,6 +330,9 @@ void bluetooth::shim::BTM_EnableInterlacedInquiryScan() {
 void bluetooth::shim::BTM_EnableInterlacedPageScan() {
   mock_function_count_map[__func__]++;
 }
+void bluetooth::shim::BTM_SetStreamingActive(bool active) {
+  mock_function_count_map[__func__]++;
+}
 void bluetooth::shim::BTM_LE_PF_addr_filter(tBTM_BLE_SCAN_COND_OP action,
                                             tBTM_BLE_PF_FILT_INDEX filt_index,
                                             tBLE_BD_ADDR addr,
@@ -88,6 +88,9 @@ void l2c_link_timeout(tL2C_LCB* p_lcb) { mock_function_count_map[__func__]++; }
 void l2c_packets_completed(uint16_t handle, uint16_t num_sent) {
   mock_function_count_map[__func__]++;
 }
+void l2c_link_tx_congestion(uint16_t handle, bool congested) {
+  mock_function_count_map[__func__]++;
+}
 void l2c_pin_code_request(const RawAddress& bd_addr) {
   mock_function_count_map[__func__]++;
 }
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "stack/crypto_toolbox/aes_hw.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using crypto_toolbox::AesBackend;
+
+namespace {
+
+const Octet16 kKey{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                   0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+/* Runs the benchmark on the backend of its first argument, skipping it when
+ * the CPU lacks that backend */
+bool SetBackend(benchmark::State& state) {
+  AesBackend backend = static_cast<AesBackend>(state.range(0));
+  if (!crypto_toolbox::aes_set_backend(backend)) {
+    state.SkipWithError("backend not supported by the CPU");
+    return false;
+  }
+  return true;
+}
+
+void BackendArgs(benchmark::internal::Benchmark* b) {
+  for (AesBackend backend :
+       {AesBackend::kSoftware, AesBackend::kAesNi, AesBackend::kArmv8}) {
+    b->Arg(static_cast<int>(backend));
+  }
+}
+
+/* Single block, as in the RPA hash and the SMP legacy functions */
+void BM_Aes128(benchmark::State& state) {
+  if (!SetBackend(state)) return;
+  Octet16 message{};
+  for (auto _ : state) {
+    message = crypto_toolbox::aes_128(kKey, message);
+    benchmark::DoNotOptimize(message);
+  }
+  crypto_toolbox::aes_set_backend(crypto_toolbox::aes_detect_backend());
+}
+BENCHMARK(BM_Aes128)->Apply(BackendArgs);
+
+void BackendAndLengthArgs(benchmark::internal::Benchmark* b) {
+  for (AesBackend backend :
+       {AesBackend::kSoftware, AesBackend::kAesNi, AesBackend::kArmv8}) {
+    for (int length : {65, 1024, 8192}) {
+      b->Args({static_cast<int>(backend), length});
+    }
+  }
+}
+
+/* CMAC over messages from the SMP functions (f4 is 65 octets) up to the size
+ * of a large GATT database hash input */
+void BM_AesCmac(benchmark::State& state) {
+  if (!SetBackend(state)) return;
+  std::vector<uint8_t> message(state.range(1), 0x5a);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        crypto_toolbox::aes_cmac(kKey, message.data(), message.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+  crypto_toolbox::aes_set_backend(crypto_toolbox::aes_detect_backend());
+}
+BENCHMARK(BM_AesCmac)->Apply(BackendAndLengthArgs);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/aes_hw.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
 #include <base/logging.h>
@@ -317,6 +318,35 @@ TEST(CryptoToolboxTest, bt_spec_example_d_7_test) {
   EXPECT_EQ(result[2], expected_ah[2]);
 }
 
+// BT Spec 5.0 | Vol 3, Part H D.7, with the IRK among other keys
+TEST(CryptoToolboxTest, aes_128_batch_test) {
+  Octet16 IRK{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
+              0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b};
+  Octet16 prand{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x81, 0x94};
+  Octet16 expected_aes_128{0x15, 0x9d, 0x5f, 0xb7, 0x2e, 0xbe, 0x23, 0x11,
+                           0xa4, 0x8c, 0x1b, 0xdc, 0xc4, 0x0d, 0xfb, 0xaa};
+
+  // algorithm expect all input to be in little endian format, so reverse
+  std::reverse(std::begin(IRK), std::end(IRK));
+  std::reverse(std::begin(prand), std::end(prand));
+  std::reverse(std::begin(expected_aes_128), std::end(expected_aes_128));
+
+  std::vector<Octet16> keys(5);
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < OCTET16_LEN; j++) keys[i][j] = i * 31 + j * 7;
+  }
+  keys[3] = IRK;
+
+  std::vector<Octet16> result(keys.size());
+  aes_128_batch(keys.data(), keys.size(), prand, result.data());
+
+  EXPECT_EQ(expected_aes_128, result[3]);
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(aes_128(keys[i], prand), result[i]);
+  }
+}
+
 // BT Spec 5.0 | Vol 3, Part H D.8
 TEST(CryptoToolboxTest, bt_spec_example_d_8_test) {
   Octet16 Key{0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
@@ -397,4 +427,32 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+// Every backend the CPU supports computes the same AES and CMAC as the
+// software one, over messages of all the lengths around the block boundaries
+// and longer than a chunk
+TEST(CryptoToolboxTest, aes_backends_test) {
+  Octet16 key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+              0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+  std::vector<uint8_t> message(600);
+  for (size_t i = 0; i < message.size(); i++) message[i] = i * 7 + 3;
+
+  AesBackend detected = aes_get_backend();
+  ASSERT_TRUE(aes_set_backend(AesBackend::kSoftware));
+  std::vector<Octet16> expected;
+  for (size_t length = 0; length <= message.size(); length++) {
+    expected.push_back(aes_cmac(key, message.data(), length));
+  }
+  Octet16 expected_aes = aes_128(key, message.data(), OCTET16_LEN);
+
+  for (AesBackend backend : {AesBackend::kAesNi, AesBackend::kArmv8}) {
+    if (!aes_set_backend(backend)) continue;
+    EXPECT_EQ(expected_aes, aes_128(key, message.data(), OCTET16_LEN));
+    for (size_t length = 0; length <= message.size(); length++) {
+      ASSERT_EQ(expected[length], aes_cmac(key, message.data(), length))
+          << "length " << length;
+    }
+  }
+  ASSERT_TRUE(aes_set_backend(detected));
+}
+
 }  // namespace crypto_toolbox
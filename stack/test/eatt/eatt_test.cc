@@ -73,7 +73,7 @@ class EattTest : public testing::Test {
 
     std::vector<uint16_t> test_local_cids{61, 62, 63, 64, 65};
     EXPECT_CALL(l2cap_interface_,
-                ConnectCreditBasedReq(BT_PSM_EATT, test_address, _))
+                ConnectCreditBasedReq(BT_PSM_EATT, test_address, _, _))
         .WillOnce(Return(test_local_cids));
 
     eatt_instance_->Connect(test_address);
@@ -104,6 +104,47 @@ class EattTest : public testing::Test {
     ASSERT_TRUE(test_tcb.eatt == num_of_accepted_connections);
   }
 
+  void ConnectDeviceDynamicBearers(void) {
+    ON_CALL(gatt_interface_, ClientReadSupportedFeatures)
+        .WillByDefault(
+            [](const RawAddress& addr,
+               base::OnceCallback<void(const RawAddress&, uint8_t)> cb) {
+              std::move(cb).Run(addr, BLE_GATT_SVR_SUP_FEAT_EATT_BITMASK);
+              return true;
+            });
+    ON_CALL(gatt_interface_, GetEattSupport)
+        .WillByDefault([](const RawAddress& addr) { return true; });
+
+    eatt_instance_->SetBearerPolicy({.dynamic = true,
+                                     .request_depth_threshold = 2,
+                                     .indication_backlog_threshold = 2,
+                                     .bearers_per_step = 2,
+                                     .idle_timeout_ms = 1000});
+
+    /* The link starts with the ATT bearer only */
+    EXPECT_CALL(l2cap_interface_, ConnectCreditBasedReq(_, _, _, _)).Times(0);
+    eatt_instance_->Connect(test_address);
+    testing::Mock::VerifyAndClearExpectations(&l2cap_interface_);
+  }
+
+  void OpenBearersOnLoad(std::vector<uint16_t> cids) {
+    EXPECT_CALL(l2cap_interface_, ConnectCreditBasedReq(BT_PSM_EATT,
+                                                        test_address, _,
+                                                        cids.size()))
+        .WillOnce(Return(cids));
+    eatt_instance_->ReportGattLoad(test_address, 2, 0);
+
+    /* No more bearers are asked for while these are pending */
+    eatt_instance_->ReportGattLoad(test_address, 3, 0);
+
+    for (uint16_t cid : cids) {
+      l2cap_app_info_.pL2CA_CreditBasedConnectCfm_Cb(
+          test_address, cid, EATT_MIN_MTU_MPS, L2CAP_CONN_OK);
+      connected_cids_.push_back(cid);
+    }
+    testing::Mock::VerifyAndClearExpectations(&l2cap_interface_);
+  }
+
   void DisconnectEattByPeer(void) {
     for (uint16_t cid : connected_cids_)
       l2cap_app_info_.pL2CA_DisconnectInd_Cb(cid, true);
@@ -252,7 +293,7 @@ TEST_F(EattTest, ConnectFailedEattNotSupported) {
       .WillByDefault([](const RawAddress& addr) { return false; });
 
   EXPECT_CALL(l2cap_interface_,
-              ConnectCreditBasedReq(BT_PSM_EATT, test_address, _))
+              ConnectCreditBasedReq(BT_PSM_EATT, test_address, _, _))
       .Times(0);
   eatt_instance_->Connect(test_address);
   ASSERT_TRUE(eatt_instance_->IsEattSupportedByPeer(test_address) == false);
@@ -260,7 +301,7 @@ TEST_F(EattTest, ConnectFailedEattNotSupported) {
 
 TEST_F(EattTest, ConnectFailedSlaveOnTheLink) {
   EXPECT_CALL(l2cap_interface_,
-              ConnectCreditBasedReq(BT_PSM_EATT, test_address, _))
+              ConnectCreditBasedReq(BT_PSM_EATT, test_address, _, _))
       .Times(0);
 
   hci_role_ = HCI_ROLE_PERIPHERAL;
@@ -440,4 +481,46 @@ TEST_F(EattTest, DoubleDisconnect) {
   /* Force second disconnect */
   eatt_instance_->Disconnect(test_address);
 }
+
+TEST_F(EattTest, DynamicBearersOpenedOnLoad) {
+  ConnectDeviceDynamicBearers();
+
+  /* Below the thresholds */
+  EXPECT_CALL(l2cap_interface_, ConnectCreditBasedReq(_, _, _, _)).Times(0);
+  eatt_instance_->ReportGattLoad(test_address, 1, 1);
+  testing::Mock::VerifyAndClearExpectations(&l2cap_interface_);
+
+  OpenBearersOnLoad({61, 62});
+  ASSERT_TRUE(test_tcb.eatt == 2);
+
+  OpenBearersOnLoad({63, 64});
+  OpenBearersOnLoad({65});
+  ASSERT_TRUE(test_tcb.eatt == 5);
+
+  /* At most as many bearers as a static connection opens */
+  EXPECT_CALL(l2cap_interface_, ConnectCreditBasedReq(_, _, _, _)).Times(0);
+  eatt_instance_->ReportGattLoad(test_address, 10, 10);
+  testing::Mock::VerifyAndClearExpectations(&l2cap_interface_);
+
+  DisconnectEattDevice(connected_cids_);
+}
+
+TEST_F(EattTest, DynamicBearersOpenedOnIndicationBacklog) {
+  ConnectDeviceDynamicBearers();
+
+  std::vector<uint16_t> cids{61, 62};
+  EXPECT_CALL(l2cap_interface_,
+              ConnectCreditBasedReq(BT_PSM_EATT, test_address, _, 2))
+      .WillOnce(Return(cids));
+  eatt_instance_->ReportGattLoad(test_address, 0, 2);
+}
+
+TEST_F(EattTest, DynamicBearersNotOpenedByPeripheral) {
+  ConnectDeviceDynamicBearers();
+
+  ON_CALL(l2cap_interface_, GetBleConnRole(_))
+      .WillByDefault(Return(HCI_ROLE_PERIPHERAL));
+  EXPECT_CALL(l2cap_interface_, ConnectCreditBasedReq(_, _, _, _)).Times(0);
+  eatt_instance_->ReportGattLoad(test_address, 10, 10);
+}
 }  // namespace
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/gatt/acceptlist_scheduler.h"
+
+namespace connection_manager {
+namespace {
+
+constexpr uint64_t kNowMs = 100000;
+
+RawAddress device(uint8_t i) { return RawAddress({0x00, 0x11, 0x22, 0, 0, i}); }
+
+class AcceptlistSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    scheduler_.Reset();
+    scheduler_.SetCapacity(2);
+    now_ms_ = kNowMs;
+  }
+
+  /* Fills the acceptlist with devices 1 and 2, device 3 waits */
+  void Oversubscribe() {
+    EXPECT_TRUE(scheduler_.Add(device(1), false, now_ms_));
+    EXPECT_TRUE(scheduler_.Add(device(2), false, now_ms_));
+    EXPECT_FALSE(scheduler_.Add(device(3), false, now_ms_));
+    EXPECT_EQ(scheduler_.waiting(), 1u);
+  }
+
+  AcceptlistScheduler scheduler_;
+  uint64_t now_ms_;
+};
+
+TEST_F(AcceptlistSchedulerTest, adds_while_there_is_room) {
+  EXPECT_TRUE(scheduler_.Add(device(1), false, now_ms_));
+  EXPECT_TRUE(scheduler_.InAcceptlist(device(1)));
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_), 0u);
+  EXPECT_TRUE(scheduler_.Rotate(now_ms_).add.empty());
+
+  EXPECT_TRUE(scheduler_.Remove(device(1)));
+  EXPECT_FALSE(scheduler_.Remove(device(1)));
+  EXPECT_EQ(scheduler_.size(), 0u);
+}
+
+TEST_F(AcceptlistSchedulerTest, rotates_after_slot_time) {
+  Oversubscribe();
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_),
+            now_ms_ + AcceptlistScheduler::kSlotMs);
+  EXPECT_TRUE(scheduler_.Rotate(now_ms_ + 1000).add.empty());
+
+  now_ms_ += AcceptlistScheduler::kSlotMs;
+  AcceptlistScheduler::Batch batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.remove.size(), 1u);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], device(3));
+  EXPECT_FALSE(scheduler_.InAcceptlist(batch.remove[0]));
+  EXPECT_EQ(scheduler_.rotations(), 1u);
+  EXPECT_EQ(scheduler_.in_acceptlist(), 2u);
+
+  /* The device that lost its slot gets one back in turn */
+  RawAddress evicted = batch.remove[0];
+  now_ms_ = scheduler_.NextRotationMs(now_ms_);
+  batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], evicted);
+}
+
+TEST_F(AcceptlistSchedulerTest, direct_connection_takes_slot_right_away) {
+  Oversubscribe();
+  EXPECT_FALSE(scheduler_.Add(device(4), true, now_ms_));
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_), now_ms_);
+
+  AcceptlistScheduler::Batch batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], device(4));
+  EXPECT_EQ(batch.remove.size(), 1u);
+
+  /* Direct connections are never rotated out */
+  now_ms_ += 10 * AcceptlistScheduler::kSlotMs;
+  for (int i = 0; i < 5; i++) {
+    scheduler_.Rotate(now_ms_);
+    EXPECT_TRUE(scheduler_.InAcceptlist(device(4)));
+    now_ms_ += AcceptlistScheduler::kSlotMs;
+  }
+}
+
+TEST_F(AcceptlistSchedulerTest, nearby_device_is_promoted) {
+  Oversubscribe();
+  EXPECT_TRUE(scheduler_.OnSeen(device(3), now_ms_));
+  /* Seen again: nothing new */
+  now_ms_ += 100;
+  EXPECT_FALSE(scheduler_.OnSeen(device(3), now_ms_));
+  EXPECT_EQ(scheduler_.promotions(), 1u);
+
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_),
+            kNowMs + AcceptlistScheduler::kMinSlotMs);
+  now_ms_ = kNowMs + AcceptlistScheduler::kMinSlotMs;
+  AcceptlistScheduler::Batch batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], device(3));
+}
+
+TEST_F(AcceptlistSchedulerTest, nearby_device_keeps_its_slot) {
+  Oversubscribe();
+  scheduler_.OnSeen(device(1), now_ms_);
+  scheduler_.OnSeen(device(2), now_ms_);
+  EXPECT_FALSE(scheduler_.OnSeen(device(1), now_ms_));
+
+  scheduler_.OnSeen(device(3), now_ms_);
+  now_ms_ += AcceptlistScheduler::kMinSlotMs;
+  EXPECT_TRUE(scheduler_.Rotate(now_ms_).add.empty());
+}
+
+TEST_F(AcceptlistSchedulerTest, connected_device_gives_up_slot) {
+  Oversubscribe();
+  scheduler_.OnConnected(device(2));
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_), now_ms_);
+
+  AcceptlistScheduler::Batch batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.remove.size(), 1u);
+  EXPECT_EQ(batch.remove[0], device(2));
+  EXPECT_EQ(scheduler_.waiting(), 0u);
+
+  /* Back on disconnection, ahead of devices that were not seen */
+  scheduler_.OnDisconnected(device(2), now_ms_);
+  EXPECT_EQ(scheduler_.waiting(), 1u);
+  now_ms_ += AcceptlistScheduler::kMinSlotMs;
+  batch = scheduler_.Rotate(now_ms_);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], device(2));
+}
+
+TEST_F(AcceptlistSchedulerTest, removal_frees_slot) {
+  Oversubscribe();
+  EXPECT_TRUE(scheduler_.Remove(device(1)));
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_), now_ms_);
+
+  AcceptlistScheduler::Batch batch = scheduler_.Rotate(now_ms_);
+  EXPECT_TRUE(batch.remove.empty());
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.add[0], device(3));
+}
+
+TEST_F(AcceptlistSchedulerTest, learns_capacity_from_failed_add) {
+  scheduler_.SetCapacity(3);
+  EXPECT_TRUE(scheduler_.Add(device(1), false, now_ms_));
+  EXPECT_TRUE(scheduler_.Add(device(2), false, now_ms_));
+  EXPECT_TRUE(scheduler_.Add(device(3), false, now_ms_));
+  scheduler_.OnAddFailed(device(3), now_ms_);
+  EXPECT_EQ(scheduler_.capacity(), 2u);
+  EXPECT_EQ(scheduler_.waiting(), 1u);
+  EXPECT_GT(scheduler_.NextRotationMs(now_ms_), now_ms_);
+}
+
+TEST_F(AcceptlistSchedulerTest, waits_on_direct_connections) {
+  EXPECT_TRUE(scheduler_.Add(device(1), true, now_ms_));
+  EXPECT_TRUE(scheduler_.Add(device(2), true, now_ms_));
+  EXPECT_FALSE(scheduler_.Add(device(3), false, now_ms_));
+  EXPECT_EQ(scheduler_.NextRotationMs(now_ms_),
+            now_ms_ + AcceptlistScheduler::kSlotMs);
+  EXPECT_TRUE(scheduler_.Rotate(now_ms_ + AcceptlistScheduler::kSlotMs)
+                  .add.empty());
+
+  scheduler_.SetDirect(device(1), false);
+  AcceptlistScheduler::Batch batch =
+      scheduler_.Rotate(now_ms_ + AcceptlistScheduler::kSlotMs);
+  ASSERT_EQ(batch.add.size(), 1u);
+  EXPECT_EQ(batch.remove[0], device(1));
+}
+
+}  // namespace
+}  // namespace connection_manager
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "stack/gatt/gatt_int.h"
+#include "stack/include/l2cdefs.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+const Uuid kCccd = Uuid::From16Bit(0x2902);
+const Uuid kCharDeclaration = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+/* reads not answered by the stack go to the application under this id */
+const uint32_t kTransId = 1;
+
+class GattAttrIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    gatt_cb.srv_list_info = new std::list<tGATT_SRV_LIST_ELEM>();
+  }
+
+  void TearDown() override {
+    gatt_sr_clear_attr_index();
+    delete gatt_cb.srv_list_info;
+    gatt_cb.srv_list_info = nullptr;
+  }
+
+  /* Start a service of one notifying characteristic, with |num_handles|
+   * handles reserved */
+  std::list<tGATT_SRV_LIST_ELEM>::iterator StartService(tGATT_SVC_DB& db,
+                                                        uint16_t s_hdl,
+                                                        uint16_t num_handles) {
+    gatts_init_service_db(db, Uuid::From16Bit(0x180D), true, s_hdl,
+                          num_handles);
+    gatts_add_characteristic(db, GATT_PERM_READ, GATT_CHAR_PROP_BIT_NOTIFY,
+                             Uuid::From16Bit(0x2A37));
+    gatts_add_char_descr(db, GATT_PERM_READ | GATT_PERM_WRITE, kCccd);
+
+    auto it = gatt_cb.srv_list_info->emplace(gatt_cb.srv_list_info->end());
+    it->p_db = &db;
+    it->s_hdl = s_hdl;
+    it->e_hdl = s_hdl + num_handles - 1;
+    gatt_sr_index_service(it);
+    return it;
+  }
+};
+
+}  // namespace
+
+TEST_F(GattAttrIndexTest, find_by_handle) {
+  tGATT_SVC_DB db_1, db_2;
+  auto srv_1 = StartService(db_1, 0x0001, 5);
+  auto srv_2 = StartService(db_2, 0x0028, 4);
+
+  const tGATT_ATTR_REF* ref = gatt_sr_find_attr_ref(0x002a);
+  ASSERT_NE(nullptr, ref);
+  EXPECT_EQ(srv_2, ref->srv);
+  EXPECT_EQ(&db_2.attr_list[2], ref->p_attr);
+  EXPECT_EQ(&db_2.attr_list[2], find_attr_by_handle(&db_2, 0x002a));
+
+  /* reserved but unused handles belong to the service, without attribute */
+  EXPECT_EQ(nullptr, gatt_sr_find_attr_ref(0x0005));
+  EXPECT_EQ(nullptr, find_attr_by_handle(&db_1, 0x0005));
+  EXPECT_EQ(srv_1, gatt_sr_find_i_rcb_by_handle(0x0005));
+
+  EXPECT_EQ(nullptr, gatt_sr_find_attr_ref(0x0010));
+  EXPECT_EQ(gatt_cb.srv_list_info->end(), gatt_sr_find_i_rcb_by_handle(0x0010));
+  EXPECT_EQ(gatt_cb.srv_list_info->end(), gatt_sr_find_i_rcb_by_handle(0xffff));
+}
+
+TEST_F(GattAttrIndexTest, index_by_type) {
+  tGATT_SVC_DB db_1, db_2;
+  StartService(db_2, 0x0028, 4);
+  StartService(db_1, 0x0001, 5);
+
+  std::vector<uint16_t> expected = {0x0004, 0x002b};
+  EXPECT_EQ(expected, gatt_cb.attr_by_type[kCccd]);
+  expected = {0x0002, 0x0029};
+  EXPECT_EQ(expected, gatt_cb.attr_by_type[kCharDeclaration]);
+}
+
+TEST_F(GattAttrIndexTest, unindex_service) {
+  tGATT_SVC_DB db_1, db_2;
+  auto srv_1 = StartService(db_1, 0x0001, 5);
+  auto srv_2 = StartService(db_2, 0x0028, 4);
+
+  gatt_sr_unindex_service(srv_2);
+  gatt_cb.srv_list_info->erase(srv_2);
+  EXPECT_EQ(nullptr, gatt_sr_find_attr_ref(0x002b));
+  EXPECT_EQ(6u, gatt_cb.attr_by_handle.size());
+  std::vector<uint16_t> expected = {0x0004};
+  EXPECT_EQ(expected, gatt_cb.attr_by_type[kCccd]);
+
+  gatt_sr_unindex_service(srv_1);
+  gatt_cb.srv_list_info->erase(srv_1);
+  EXPECT_TRUE(gatt_cb.attr_by_handle.empty());
+  EXPECT_EQ(0u, gatt_cb.attr_by_type.count(kCharDeclaration));
+}
+
+TEST_F(GattAttrIndexTest, read_cached_value) {
+  tGATT_SVC_DB db;
+  StartService(db, 0x0001, 5);
+  tGATT_ATTR& value_attr = db.attr_list[2];
+  value_attr.p_cache.reset(new tGATT_ATTR_CACHE{{1, 2, 3, 4, 5, 6}, 0});
+
+  tGATT_TCB tcb;
+  uint8_t buf[GATT_MAX_ATTR_LEN];
+  uint16_t len = 0;
+  EXPECT_EQ(GATT_SUCCESS,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ, 0x0003, 0, buf,
+                                            &len, 4, 0, 16, 0));
+  EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}),
+            std::vector<uint8_t>(buf, buf + len));
+
+  /* long reads continue from the cached value */
+  EXPECT_EQ(GATT_SUCCESS,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ_BLOB, 0x0003, 4, buf,
+                                            &len, 4, 0, 16, 0));
+  EXPECT_EQ(std::vector<uint8_t>({5, 6}), std::vector<uint8_t>(buf, buf + len));
+
+  EXPECT_EQ(GATT_INVALID_OFFSET,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ_BLOB, 0x0003, 7, buf,
+                                            &len, 4, 0, 16, 0));
+}
+
+TEST_F(GattAttrIndexTest, read_uncached_value) {
+  tGATT_SVC_DB db;
+  StartService(db, 0x0001, 5);
+
+  tGATT_TCB tcb;
+  uint8_t buf[GATT_MAX_ATTR_LEN];
+  uint16_t len = 0;
+  EXPECT_EQ(GATT_PENDING,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ, 0x0003, 0, buf,
+                                            &len, 16, 0, 16, kTransId));
+
+  /* an expired value is dropped and the read goes to the application */
+  tGATT_ATTR& value_attr = db.attr_list[2];
+  value_attr.p_cache.reset(new tGATT_ATTR_CACHE{{1, 2, 3}, 1});
+  EXPECT_EQ(GATT_PENDING,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ, 0x0003, 0, buf,
+                                            &len, 16, 0, 16, kTransId));
+  EXPECT_EQ(nullptr, value_attr.p_cache);
+}
+
+TEST_F(GattAttrIndexTest, write_invalidates_cached_value) {
+  tGATT_SVC_DB db;
+  StartService(db, 0x0001, 5);
+  tGATT_ATTR& value_attr = db.attr_list[2];
+  value_attr.p_cache.reset(new tGATT_ATTR_CACHE{{1, 2, 3}, 0});
+
+  /* other attributes keep their cached value */
+  gatts_invalidate_attr_cache(&db, 0x0004);
+  ASSERT_NE(nullptr, value_attr.p_cache);
+
+  gatts_invalidate_attr_cache(&db, 0x0003);
+  EXPECT_EQ(nullptr, value_attr.p_cache);
+
+  tGATT_TCB tcb;
+  uint8_t buf[GATT_MAX_ATTR_LEN];
+  uint16_t len = 0;
+  EXPECT_EQ(GATT_PENDING,
+            gatts_read_attr_value_by_handle(tcb, L2CAP_ATT_CID, &db,
+                                            GATT_REQ_READ, 0x0003, 0, buf,
+                                            &len, 16, 0, 16, kTransId));
+}
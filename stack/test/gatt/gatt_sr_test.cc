@@ -49,6 +49,10 @@ struct TestMutables {
     int access_count_{0};
     tGATT_STATUS return_status_{GATT_SUCCESS};
   } gatts_write_attr_perm_check;
+  struct {
+    int access_count_{0};
+    uint16_t handle_{0};
+  } gatts_invalidate_attr_cache;
 };
 
 TestMutables test_state_;
@@ -93,13 +97,14 @@ void gatt_act_discovery(tGATT_CLCB* p_clcb) {}
 bool gatt_disconnect(tGATT_TCB* p_tcb) { return false; }
 tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB* p_tcb) { return GATT_CH_CLOSE; }
 tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, uint16_t cid, tGATT_SVC_DB* p_db, uint8_t op_code,
-    BT_HDR* p_rsp, uint16_t s_handle, uint16_t e_handle, const Uuid& type,
-    uint16_t* p_len, tGATT_SEC_FLAG sec_flag, uint8_t key_size,
-    uint32_t trans_id, uint16_t* p_cur_handle) {
+    tGATT_TCB& tcb, uint16_t cid, uint8_t op_code, BT_HDR* p_rsp,
+    uint16_t s_handle, uint16_t e_handle, const Uuid& type, uint16_t* p_len,
+    tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id,
+    uint16_t* p_cur_handle) {
   return GATT_SUCCESS;
 }
 void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {}
+void gatt_mtu_exchange_done(tGATT_TCB& tcb, tGATT_STATUS status) {}
 Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db) { return nullptr; }
 tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
                                          uint16_t val_len, uint8_t* p_val) {
@@ -126,6 +131,10 @@ tGATT_STATUS gatts_write_attr_perm_check(tGATT_SVC_DB* p_db, uint8_t op_code,
   test_state_.gatts_write_attr_perm_check.access_count_++;
   return test_state_.gatts_write_attr_perm_check.return_status_;
 }
+void gatts_invalidate_attr_cache(tGATT_SVC_DB* p_db, uint16_t handle) {
+  test_state_.gatts_invalidate_attr_cache.access_count_++;
+  test_state_.gatts_invalidate_attr_cache.handle_ = handle;
+}
 void gatt_update_app_use_link_flag(tGATT_IF gatt_if, tGATT_TCB* p_tcb,
                                    bool is_add, bool check_acl_link) {}
 bluetooth::common::MessageLoopThread* get_main_thread() { return nullptr; }
@@ -362,6 +371,8 @@ TEST_F(GattSrTest, gatts_process_write_req_request_write_typical) {
                           length, p_data, kGattCharacteristicType);
 
   CHECK(test_state_.gatts_write_attr_perm_check.access_count_ == 1);
+  CHECK(test_state_.gatts_invalidate_attr_cache.access_count_ == 1);
+  CHECK(test_state_.gatts_invalidate_attr_cache.handle_ == kHandle);
   CHECK(test_state_.application_request_callback.conn_id_ == el_.gatt_if);
   CHECK(test_state_.application_request_callback.trans_id_ == 0x12345678);
   CHECK(test_state_.application_request_callback.type_ ==
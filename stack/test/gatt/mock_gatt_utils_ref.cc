@@ -67,6 +67,7 @@ void gatts_proc_srv_chg_ind_ack(tGATT_TCB) {}
 bool gatt_disconnect(tGATT_TCB* p_tcb) { return false; }
 tGATT_CH_STATE gatt_get_ch_state(tGATT_TCB* p_tcb) { return GATT_CH_CLOSE; }
 void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {}
+void gatt_mtu_exchange_done(tGATT_TCB& tcb, tGATT_STATUS status) {}
 
 /** stack/gatt/gatt_sr.cc */
 uint32_t gatt_sr_enqueue_cmd(tGATT_TCB& tcb, uint16_t cid, uint8_t op_code,
@@ -21,6 +21,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/strings.h"
@@ -139,3 +140,37 @@ TEST_F(StackGattTest, GATT_Register_Deregister) {
 
   gatt_free();
 }
+
+TEST_F(StackGattTest, attp_build_multi_notif_msg) {
+  std::map<uint16_t, std::vector<uint8_t>> values = {
+      {0x0010, {0x01, 0x02, 0x03}},
+      {0x0012, {0x04, 0x05}},
+      {0x0014, std::vector<uint8_t>(30, 0xaa)},
+  };
+  auto it = values.cbegin();
+
+  // The first two values fit in a 23 octets payload, with their handles and
+  // lengths
+  BT_HDR* p_buf = attp_build_multi_notif_msg(23, &it, values.cend());
+  const std::vector<uint8_t> expected = {0x23, 0x10, 0x00, 0x03, 0x00, 0x01,
+                                         0x02, 0x03, 0x12, 0x00, 0x02, 0x00,
+                                         0x04, 0x05};
+  ASSERT_EQ(expected.size(), p_buf->len);
+  uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  ASSERT_EQ(expected, std::vector<uint8_t>(p, p + p_buf->len));
+  ASSERT_EQ(0x0014, it->first);
+  osi_free(p_buf);
+
+  // The last value goes alone in a truncated handle value notification
+  p_buf = attp_build_multi_notif_msg(23, &it, values.cend());
+  ASSERT_EQ(23, p_buf->len);
+  p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  ASSERT_EQ(GATT_HANDLE_VALUE_NOTIF, p[0]);
+  ASSERT_EQ(values.cend(), it);
+
+  BT_HDR* p_copy = attp_copy_msg(p_buf);
+  ASSERT_EQ(p_buf->len, p_copy->len);
+  ASSERT_EQ(0, memcmp(p_buf + 1, p_copy + 1, p_buf->offset + p_buf->len));
+  osi_free(p_copy);
+  osi_free(p_buf);
+}
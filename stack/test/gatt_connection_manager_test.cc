@@ -6,8 +6,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
+#include "common/time_util.h"
 #include "osi/include/alarm.h"
 #include "osi/test/alarm_mock.h"
+#include "stack/gatt/acceptlist_scheduler.h"
 
 using testing::_;
 using testing::DoAll;
@@ -24,6 +27,9 @@ class AcceptlistMock {
  public:
   MOCK_METHOD1(AcceptlistAdd, bool(const RawAddress&));
   MOCK_METHOD1(AcceptlistRemove, void(const RawAddress&));
+  MOCK_METHOD2(AcceptlistUpdate,
+               std::vector<RawAddress>(const std::vector<RawAddress>&,
+                                       const std::vector<RawAddress>&));
   MOCK_METHOD0(AcceptlistClear, void());
   MOCK_METHOD0(SetLeConnectionModeToFast, bool());
   MOCK_METHOD0(SetLeConnectionModeToSlow, void());
@@ -31,6 +37,8 @@ class AcceptlistMock {
 };
 
 std::unique_ptr<AcceptlistMock> localAcceptlistMock;
+size_t acceptlist_size = 128;
+uint64_t fake_now_ms = 100000;
 }  // namespace
 
 RawAddress address1{{0x01, 0x01, 0x01, 0x01, 0x01, 0x01}};
@@ -50,6 +58,14 @@ void BTM_AcceptlistRemove(const RawAddress& address) {
   return localAcceptlistMock->AcceptlistRemove(address);
 }
 
+std::vector<RawAddress> BTM_AcceptlistUpdate(
+    const std::vector<RawAddress>& to_remove,
+    const std::vector<RawAddress>& to_add) {
+  return localAcceptlistMock->AcceptlistUpdate(to_remove, to_add);
+}
+
+size_t BTM_GetAcceptlistSize() { return acceptlist_size; }
+
 void BTM_AcceptlistClear() { return localAcceptlistMock->AcceptlistClear(); }
 
 bool BTM_SetLeConnectionModeToFast() {
@@ -70,6 +86,12 @@ bool L2CA_ConnectFixedChnl(uint16_t fixed_cid, const RawAddress& bd_addr) {
   return false;
 }
 
+namespace bluetooth {
+namespace common {
+uint64_t time_get_os_boottime_ms() { return fake_now_ms; }
+}  // namespace common
+}  // namespace bluetooth
+
 namespace connection_manager {
 class BleConnectionManager : public testing::Test {
   void SetUp() override {
@@ -80,6 +102,7 @@ class BleConnectionManager : public testing::Test {
     connection_manager::reset(true);
     AlarmMock::Reset();
     localAcceptlistMock.reset();
+    acceptlist_size = 128;
   }
 };
 
@@ -283,4 +306,100 @@ TEST_F(BleConnectionManager, test_direct_and_background_connect) {
   Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
 }
 
+/** Verify that devices that don't fit in the acceptlist wait for a slot, and
+ * take turns in it */
+TEST_F(BleConnectionManager, test_background_connection_oversubscribed) {
+  RawAddress address3{{0x33, 0x33, 0x33, 0x33, 0x33, 0x33}};
+  acceptlist_size = 2;
+
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(address1))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(address2))
+      .WillOnce(Return(true));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmNew(_)).Times(1);
+  alarm_callback_t alarm_callback = nullptr;
+  uint64_t alarm_ms = 0;
+  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, _, _, _))
+      .WillOnce(DoAll(SaveArg<1>(&alarm_ms), SaveArg<2>(&alarm_callback)));
+  EXPECT_TRUE(background_connect_add(CLIENT1, address1));
+  EXPECT_TRUE(background_connect_add(CLIENT1, address2));
+  // acceptlist is full, the device waits for a slot
+  EXPECT_TRUE(background_connect_add(CLIENT1, address3));
+  EXPECT_EQ(alarm_ms, AcceptlistScheduler::kSlotMs);
+
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  Mock::VerifyAndClearExpectations(AlarmMock::Get());
+
+  // the device that had its slot the longest makes room, in one batch
+  fake_now_ms += alarm_ms;
+  std::vector<RawAddress> removed, added;
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistUpdate(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&removed), SaveArg<1>(&added),
+                      Return(std::vector<RawAddress>())));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, _, _, _)).Times(1);
+  alarm_callback(nullptr);
+  ASSERT_EQ(removed.size(), 1UL);
+  ASSERT_EQ(added.size(), 1UL);
+  EXPECT_EQ(added[0], address3);
+
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  Mock::VerifyAndClearExpectations(AlarmMock::Get());
+
+  // removing a device hands its slot to the waiting one right away
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(address3)).Times(1);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistUpdate(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&removed), SaveArg<1>(&added),
+                      Return(std::vector<RawAddress>())));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmCancel(_)).Times(1);
+  EXPECT_TRUE(background_connect_remove(CLIENT1, address3));
+  EXPECT_TRUE(removed.empty());
+  ASSERT_EQ(added.size(), 1UL);
+
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+}
+
+/** Verify that a direct connection takes the slot of a background one */
+TEST_F(BleConnectionManager, test_direct_connect_oversubscribed) {
+  acceptlist_size = 1;
+
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(address1))
+      .WillOnce(Return(true));
+  EXPECT_TRUE(background_connect_add(CLIENT1, address1));
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+
+  std::vector<RawAddress> removed, added;
+  EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToFast()).Times(1);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistAdd(_)).Times(0);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistUpdate(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&removed), SaveArg<1>(&added),
+                      Return(std::vector<RawAddress>())));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmNew(_)).Times(2);
+  EXPECT_CALL(*AlarmMock::Get(), AlarmSetOnMloop(_, _, _, _)).Times(2);
+  EXPECT_TRUE(direct_connect_add(CLIENT1, address2));
+  ASSERT_EQ(removed.size(), 1UL);
+  EXPECT_EQ(removed[0], address1);
+  ASSERT_EQ(added.size(), 1UL);
+  EXPECT_EQ(added[0], address2);
+
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  Mock::VerifyAndClearExpectations(AlarmMock::Get());
+
+  // once connected, the background connection gets its slot back
+  EXPECT_CALL(*localAcceptlistMock, SetLeConnectionModeToSlow()).Times(1);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistRemove(address2)).Times(1);
+  EXPECT_CALL(*localAcceptlistMock, AcceptlistUpdate(_, _))
+      .WillOnce(DoAll(SaveArg<0>(&removed), SaveArg<1>(&added),
+                      Return(std::vector<RawAddress>())));
+  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+  on_connection_complete(address2);
+  EXPECT_TRUE(removed.empty());
+  ASSERT_EQ(added.size(), 1UL);
+  EXPECT_EQ(added[0], address1);
+
+  Mock::VerifyAndClearExpectations(localAcceptlistMock.get());
+  Mock::VerifyAndClearExpectations(AlarmMock::Get());
+  EXPECT_CALL(*AlarmMock::Get(), AlarmFree(_)).Times(1);
+}
+
 }  // namespace connection_manager
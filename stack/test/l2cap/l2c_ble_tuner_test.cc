@@ -0,0 +1,209 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "stack/l2cap/l2c_ble_tuner.h"
+
+namespace {
+
+constexpr uint64_t kWindowMs = LeLinkTuner::kWindowMs;
+constexpr tL2C_BLE_CONN_PARAMS kBaseParams = {
+    .min_int = 24, .max_int = 40, .latency = 0, .timeout = 500};
+
+class L2cBleTunerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    now_ms_ = 100000;
+    tuner_.Reset(now_ms_, kBaseParams, 0);
+  }
+
+  /* Runs |windows| windows of |rate| bytes per second, in 10 packets each.
+   * Returns true if the load changed */
+  bool Run(uint32_t windows, uint32_t rate, uint16_t queued = 0) {
+    bool changed = false;
+    for (uint32_t i = 0; i < windows * 10; i++) {
+      now_ms_ += kWindowMs / 10;
+      changed |= tuner_.Count(now_ms_, rate / 10, queued);
+    }
+    return changed;
+  }
+
+  /* One tick without traffic after |ms| */
+  bool Tick(uint64_t ms) {
+    now_ms_ += ms;
+    return tuner_.Count(now_ms_, 0, 0);
+  }
+
+  uint64_t now_ms_;
+  LeLinkTuner tuner_;
+};
+
+TEST_F(L2cBleTunerTest, starts_on_link_parameters) {
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kDefault);
+  tL2C_BLE_CONN_PARAMS params = tuner_.Params();
+  EXPECT_EQ(params.min_int, kBaseParams.min_int);
+  EXPECT_EQ(params.max_int, kBaseParams.max_int);
+  EXPECT_TRUE(tuner_.WantsConnUpdate());
+  EXPECT_FALSE(tuner_.Wants2mPhy());
+}
+
+TEST_F(L2cBleTunerTest, enters_bulk_after_busy_windows) {
+  EXPECT_FALSE(Run(LeLinkTuner::kBulkEnterWindows - 1, 32 * 1024));
+  EXPECT_TRUE(Run(1, 32 * 1024));
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+  EXPECT_EQ(tuner_.bulk_count(), 1u);
+  EXPECT_GE(tuner_.peak_rate(), LeLinkTuner::kBulkRate);
+
+  tL2C_BLE_CONN_PARAMS params = tuner_.Params();
+  EXPECT_EQ(params.min_int, LeLinkTuner::kBulkMinInt);
+  EXPECT_EQ(params.max_int, LeLinkTuner::kBulkMaxInt);
+  EXPECT_EQ(params.latency, 0);
+  EXPECT_EQ(params.timeout, kBaseParams.timeout);
+  EXPECT_TRUE(tuner_.Wants2mPhy());
+}
+
+TEST_F(L2cBleTunerTest, enters_bulk_on_deep_queue) {
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 1024, LeLinkTuner::kBulkQueue);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+}
+
+TEST_F(L2cBleTunerTest, ignores_short_bursts) {
+  for (int i = 0; i < 10; i++) {
+    Run(1, 32 * 1024);
+    Run(1, 1024);
+  }
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kDefault);
+}
+
+TEST_F(L2cBleTunerTest, leaves_bulk_after_quiet_windows) {
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 32 * 1024);
+  ASSERT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+
+  /* Between the two thresholds: neither busy nor quiet */
+  Run(10, 8 * 1024);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+
+  Run(LeLinkTuner::kBulkExitWindows, 1024);
+  Run(1, 1024);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kDefault);
+}
+
+TEST_F(L2cBleTunerTest, relaxes_idle_link) {
+  for (int i = 0; i <= LeLinkTuner::kIdleWindows; i++) Tick(kWindowMs);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kIdle);
+  EXPECT_EQ(tuner_.idle_count(), 1u);
+
+  tL2C_BLE_CONN_PARAMS params = tuner_.Params();
+  EXPECT_EQ(params.min_int, LeLinkTuner::kIdleMinInt);
+  EXPECT_EQ(params.max_int, LeLinkTuner::kIdleMaxInt);
+  EXPECT_EQ(params.timeout, kBaseParams.timeout);
+
+  /* Keepalives don't wake it up */
+  Run(5, LeLinkTuner::kIdleBytes / 2);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kIdle);
+
+  EXPECT_TRUE(Run(2, 1024));
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kDefault);
+}
+
+TEST_F(L2cBleTunerTest, closes_windows_spanning_a_long_gap) {
+  /* No tick for a minute, then traffic */
+  EXPECT_TRUE(tuner_.Count(now_ms_ + 60000, 1000, 0));
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kIdle);
+}
+
+TEST_F(L2cBleTunerTest, idle_keeps_longer_base_interval) {
+  tL2C_BLE_CONN_PARAMS slow = {
+      .min_int = 400, .max_int = 400, .latency = 4, .timeout = 3200};
+  tuner_.Reset(now_ms_, slow, 0);
+  Tick(60000);
+  ASSERT_EQ(tuner_.load(), LeLinkLoad::kIdle);
+  tL2C_BLE_CONN_PARAMS params = tuner_.Params();
+  EXPECT_EQ(params.min_int, slow.min_int);
+  EXPECT_EQ(params.timeout, slow.timeout);
+}
+
+TEST_F(L2cBleTunerTest, idle_timeout_covers_interval) {
+  tL2C_BLE_CONN_PARAMS params = {
+      .min_int = 24, .max_int = 40, .latency = 20, .timeout = 100};
+  tuner_.Reset(now_ms_, params, 0);
+  Tick(60000);
+  params = tuner_.Params();
+  /* 21 events of 150 ms, twice, is over 6 s */
+  EXPECT_GT(params.timeout * 10, 2 * 21 * params.max_int * 5 / 4);
+}
+
+TEST_F(L2cBleTunerTest, pinned_parameters_are_left) {
+  tuner_.PinParams();
+  EXPECT_FALSE(tuner_.WantsConnUpdate());
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 32 * 1024);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+  EXPECT_TRUE(tuner_.Wants2mPhy());
+}
+
+TEST_F(L2cBleTunerTest, stops_conn_updates_failed_by_peer) {
+  tuner_.OnConnUpdateDone(false);
+  EXPECT_EQ(tuner_.conn_update_failures(), 0);
+
+  for (int i = 0; i < LeLinkTuner::kMaxFailures; i++) {
+    EXPECT_TRUE(tuner_.WantsConnUpdate());
+    tuner_.OnConnUpdateRequested();
+    tuner_.OnConnUpdateDone(false);
+  }
+  EXPECT_FALSE(tuner_.WantsConnUpdate());
+  EXPECT_EQ(tuner_.quirks(), LeLinkTuner::kNoConnUpdate);
+
+  /* Remembered on the next connection */
+  tuner_.Reset(now_ms_, kBaseParams, tuner_.quirks());
+  EXPECT_FALSE(tuner_.WantsConnUpdate());
+}
+
+TEST_F(L2cBleTunerTest, tracks_2m_phy) {
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 32 * 1024);
+  ASSERT_TRUE(tuner_.Wants2mPhy());
+  tuner_.OnPhyRequested();
+  EXPECT_FALSE(tuner_.Wants2mPhy());
+  tuner_.OnPhyUpdated(true, 2, 2);
+  EXPECT_FALSE(tuner_.Wants2mPhy());
+  EXPECT_EQ(tuner_.phy_failures(), 0);
+}
+
+TEST_F(L2cBleTunerTest, stops_2m_phy_refused_by_peer) {
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 32 * 1024);
+
+  /* Completed on 1M */
+  tuner_.OnPhyRequested();
+  tuner_.OnPhyUpdated(true, 1, 1);
+  EXPECT_EQ(tuner_.phy_failures(), 1);
+  EXPECT_TRUE(tuner_.Wants2mPhy());
+
+  /* Never completed */
+  tuner_.OnPhyRequested();
+  Run(LeLinkTuner::kPhyUpdateWindows + 1, 32 * 1024);
+  EXPECT_EQ(tuner_.phy_failures(), 2);
+  EXPECT_FALSE(tuner_.Wants2mPhy());
+  EXPECT_EQ(tuner_.quirks(), LeLinkTuner::kNo2mPhy);
+}
+
+TEST_F(L2cBleTunerTest, leaves_coded_phy) {
+  tuner_.OnPhyUpdated(true, 3, 3);
+  Run(LeLinkTuner::kBulkEnterWindows + 1, 32 * 1024);
+  EXPECT_EQ(tuner_.load(), LeLinkLoad::kBulk);
+  EXPECT_FALSE(tuner_.Wants2mPhy());
+}
+
+}  // namespace
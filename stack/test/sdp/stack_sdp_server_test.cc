@@ -0,0 +1,640 @@
+/*
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/message_loop_thread.h"
+#include "device/include/interop.h"
+#include "osi/include/alarm.h"
+#include "osi/include/allocator.h"
+#include "stack/include/avrc_defs.h"
+#include "stack/include/bt_types.h"
+#include "stack/include/sdp_api.h"
+#include "stack/include/sdpdefs.h"
+#include "stack/sdp/sdpint.h"
+#include "test/mock/mock_stack_l2cap_api.h"
+#include "types/bluetooth/uuid.h"
+#include "types/raw_address.h"
+
+std::map<std::string, int> mock_function_count_map;
+
+bluetooth::common::MessageLoopThread* get_main_thread() { return nullptr; }
+
+tSDP_CB sdp_cb;
+
+void sdp_conn_timer_timeout(void* data) {}
+
+namespace {
+bool avrcp_1_4_only_peer = false;
+}  // namespace
+
+bool interop_match_addr(const interop_feature_t feature,
+                        const RawAddress* addr) {
+  return feature == INTEROP_AVRCP_1_4_ONLY && avrcp_1_4_only_peer;
+}
+
+namespace {
+
+using bluetooth::Uuid;
+
+constexpr uint16_t kConnectionId = 0x0040;
+constexpr uint16_t kTransNum = 0x1234;
+constexpr uint16_t kSmallMtu = 48;
+
+/* Response header: PDU ID, transaction ID and parameter length */
+constexpr size_t kRspHdrLen = 5;
+
+const std::vector<uint8_t> kAllAttributes = {0x35, 0x05, 0x0a, 0x00,
+                                             0x00, 0xff, 0xff};
+const std::vector<uint8_t> kNoContinuation = {0x00};
+
+std::vector<uint8_t> Continuation(uint16_t offset) {
+  return {SDP_CONTINUATION_LEN, (uint8_t)(offset >> 8), (uint8_t)offset};
+}
+
+std::vector<uint8_t> Uuid16(uint16_t uuid) {
+  return {(UUID_DESC_TYPE << 3) | SIZE_TWO_BYTES, (uint8_t)(uuid >> 8),
+          (uint8_t)uuid};
+}
+
+std::vector<uint8_t> Uuid32(uint32_t uuid) {
+  return {(UUID_DESC_TYPE << 3) | SIZE_FOUR_BYTES, (uint8_t)(uuid >> 24),
+          (uint8_t)(uuid >> 16), (uint8_t)(uuid >> 8), (uint8_t)uuid};
+}
+
+std::vector<uint8_t> Uuid128(const Uuid& uuid) {
+  std::vector<uint8_t> elem = {(UUID_DESC_TYPE << 3) | SIZE_SIXTEEN_BYTES};
+  const Uuid::UUID128Bit& bytes = uuid.To128BitBE();
+  elem.insert(elem.end(), bytes.begin(), bytes.end());
+  return elem;
+}
+
+std::vector<uint8_t> UuidSeq(const std::vector<uint8_t>& uuids) {
+  std::vector<uint8_t> seq = {(DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE,
+                              (uint8_t)uuids.size()};
+  seq.insert(seq.end(), uuids.begin(), uuids.end());
+  return seq;
+}
+
+std::vector<uint8_t> Concat(std::vector<std::vector<uint8_t>> parts) {
+  std::vector<uint8_t> out;
+  for (const auto& part : parts) out.insert(out.end(), part.begin(), part.end());
+  return out;
+}
+
+/* Attribute list bytes of a ServiceAttribute or ServiceSearchAttribute
+ * response, with the continuation state that follows them */
+struct AttrListsRsp {
+  std::vector<uint8_t> lists;
+  std::vector<uint8_t> cont;
+};
+
+class StackSdpServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mock_function_count_map.clear();
+    avrcp_1_4_only_peer = false;
+    SDP_DeleteRecord(0);
+
+    p_ccb_ = &sdp_cb.ccb[0];
+    memset(p_ccb_, 0, sizeof(*p_ccb_));
+    p_ccb_->con_state = SDP_STATE_CONNECTED;
+    p_ccb_->connection_id = kConnectionId;
+    p_ccb_->rem_mtu_size = SDP_MTU_SIZE;
+    p_ccb_->sdp_conn_timer = alarm_new("sdp.test_conn_timer");
+
+    test::mock::stack_l2cap_api::L2CA_DataWrite.body =
+        [this](uint16_t cid, BT_HDR* p_buf) {
+          EXPECT_EQ(kConnectionId, cid);
+          uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+          responses_.emplace_back(p, p + p_buf->len);
+          osi_free(p_buf);
+          return (uint8_t)0;
+        };
+  }
+
+  void TearDown() override {
+    test::mock::stack_l2cap_api::L2CA_DataWrite = {};
+    osi_free_and_reset((void**)&p_ccb_->rsp_list);
+    alarm_free(p_ccb_->sdp_conn_timer);
+    SDP_DeleteRecord(0);
+  }
+
+  /* Record of |service_class|, with a service name of |name_len| bytes */
+  uint32_t AddRecord(uint16_t service_class, size_t name_len = 0) {
+    uint32_t handle = SDP_CreateRecord();
+    EXPECT_NE(0u, handle);
+    EXPECT_TRUE(SDP_AddServiceClassIdList(handle, 1, &service_class));
+    if (name_len) {
+      std::vector<uint8_t> name(name_len, 'n');
+      EXPECT_TRUE(SDP_AddAttribute(handle, ATTR_ID_SERVICE_NAME,
+                                   TEXT_STR_DESC_TYPE, name.size(),
+                                   name.data()));
+    }
+    return handle;
+  }
+
+  /* Sends a request to the server and returns its single response */
+  std::vector<uint8_t> Request(uint8_t pdu_id,
+                               const std::vector<uint8_t>& params) {
+    BT_HDR* p_msg =
+        (BT_HDR*)osi_malloc(sizeof(BT_HDR) + kRspHdrLen + params.size());
+    p_msg->offset = 0;
+    p_msg->len = kRspHdrLen + params.size();
+    uint8_t* p = (uint8_t*)(p_msg + 1);
+    UINT8_TO_BE_STREAM(p, pdu_id);
+    UINT16_TO_BE_STREAM(p, kTransNum);
+    UINT16_TO_BE_STREAM(p, params.size());
+    if (!params.empty()) memcpy(p, params.data(), params.size());
+
+    responses_.clear();
+    sdp_server_handle_client_req(p_ccb_, p_msg);
+    osi_free(p_msg);
+
+    EXPECT_EQ(1u, responses_.size());
+    if (responses_.empty()) return {};
+    EXPECT_LE(responses_.back().size(), p_ccb_->rem_mtu_size);
+    return responses_.back();
+  }
+
+  std::vector<uint8_t> ServiceAttrReq(uint32_t handle,
+                                      const std::vector<uint8_t>& cont) {
+    std::vector<uint8_t> params = {
+        (uint8_t)(handle >> 24), (uint8_t)(handle >> 16),
+        (uint8_t)(handle >> 8),  (uint8_t)handle,
+        0xff,                    0xff};
+    return Request(SDP_PDU_SERVICE_ATTR_REQ,
+                   Concat({params, kAllAttributes, cont}));
+  }
+
+  std::vector<uint8_t> SearchAttrReq(const std::vector<uint8_t>& uuid_seq,
+                                     const std::vector<uint8_t>& cont) {
+    return Request(SDP_PDU_SERVICE_SEARCH_ATTR_REQ,
+                   Concat({uuid_seq, {0xff, 0xff}, kAllAttributes, cont}));
+  }
+
+  /* Splits an attribute response into its lists and continuation state */
+  static AttrListsRsp ParseAttrListsRsp(const std::vector<uint8_t>& rsp,
+                                        uint8_t pdu_id) {
+    AttrListsRsp parsed;
+    EXPECT_GE(rsp.size(), kRspHdrLen + 3);
+    if (rsp.size() < kRspHdrLen + 3) return parsed;
+    EXPECT_EQ(pdu_id, rsp[0]);
+    EXPECT_EQ(rsp.size() - kRspHdrLen, (size_t)((rsp[3] << 8) | rsp[4]));
+
+    size_t count = (rsp[5] << 8) | rsp[6];
+    auto lists = rsp.begin() + kRspHdrLen + 2;
+    EXPECT_LE(count + 1, (size_t)(rsp.end() - lists));
+    if (count + 1 > (size_t)(rsp.end() - lists)) return parsed;
+    parsed.lists.assign(lists, lists + count);
+    parsed.cont.assign(lists + count, rsp.end());
+    EXPECT_EQ(parsed.cont.size(), parsed.cont[0] + 1u);
+    return parsed;
+  }
+
+  static uint16_t ErrorCode(const std::vector<uint8_t>& rsp) {
+    if (rsp.size() < kRspHdrLen + 2 || rsp[0] != SDP_PDU_ERROR_RESPONSE)
+      return 0;
+    return (rsp[5] << 8) | rsp[6];
+  }
+
+  /* Reads the whole attribute list(s) of a request, following continuation
+   * states, and returns how many responses it took */
+  size_t ReadAll(const std::function<std::vector<uint8_t>(
+                     const std::vector<uint8_t>&)>& request,
+                 uint8_t pdu_id, std::vector<uint8_t>* p_lists) {
+    std::vector<uint8_t> cont = kNoContinuation;
+    size_t num_rsp = 0;
+    p_lists->clear();
+    do {
+      AttrListsRsp rsp = ParseAttrListsRsp(request(cont), pdu_id);
+      num_rsp++;
+      if (rsp.cont.empty()) break;
+      EXPECT_LE(rsp.lists.size(), p_ccb_->rem_mtu_size - 10u);
+      p_lists->insert(p_lists->end(), rsp.lists.begin(), rsp.lists.end());
+      cont = rsp.cont;
+    } while (cont[0] != 0 && num_rsp < 100);
+    return num_rsp;
+  }
+
+  /* Handles of the records in ServiceSearchAttribute lists */
+  static std::vector<uint32_t> RecordHandles(const std::vector<uint8_t>& lists) {
+    std::vector<uint32_t> handles;
+    size_t hdr_len = (lists[0] & 7) == SIZE_IN_NEXT_WORD ? 3 : 2;
+    for (size_t i = hdr_len; i + 3 <= lists.size();) {
+      EXPECT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD, lists[i]);
+      size_t len = (lists[i + 1] << 8) | lists[i + 2];
+      /* The record handle attribute comes first: 09 00 00 0a <handle> */
+      const uint8_t* p = &lists[i + 3 + 4];
+      handles.push_back((p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+      i += 3 + len;
+    }
+    return handles;
+  }
+
+  tCONN_CB* p_ccb_;
+  std::vector<std::vector<uint8_t>> responses_;
+};
+
+TEST_F(StackSdpServerTest, service_attr_two_byte_sequence_header) {
+  uint32_t handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      ServiceAttrReq(handle, kNoContinuation), SDP_PDU_SERVICE_ATTR_RSP);
+  const std::vector<uint8_t> expected = {
+      0x35, 0x10,
+      /* ServiceRecordHandle */
+      0x09, 0x00, 0x00, 0x0a, 0x00, 0x01, 0x00, 0x00,
+      /* ServiceClassIDList */
+      0x09, 0x00, 0x01, 0x35, 0x03, 0x19, 0x11, 0x0a};
+  EXPECT_EQ(expected, rsp.lists);
+  EXPECT_EQ(kNoContinuation, rsp.cont);
+}
+
+TEST_F(StackSdpServerTest, service_attr_sequence_header_size) {
+  /* Lists of up to 252 bytes take a 2 byte header, longer ones 3 bytes. The
+   * record handle and class list take 16 bytes, the name 5 bytes more than
+   * its length */
+  uint32_t short_handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 231);
+  uint32_t long_handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 232);
+
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      ServiceAttrReq(short_handle, kNoContinuation), SDP_PDU_SERVICE_ATTR_RSP);
+  ASSERT_EQ(254u, rsp.lists.size());
+  EXPECT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE, rsp.lists[0]);
+  EXPECT_EQ(252, rsp.lists[1]);
+
+  rsp = ParseAttrListsRsp(ServiceAttrReq(long_handle, kNoContinuation),
+                          SDP_PDU_SERVICE_ATTR_RSP);
+  ASSERT_EQ(256u, rsp.lists.size());
+  EXPECT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD, rsp.lists[0]);
+  EXPECT_EQ(0, rsp.lists[1]);
+  EXPECT_EQ(253, rsp.lists[2]);
+}
+
+TEST_F(StackSdpServerTest, service_attr_continuation_across_mtus) {
+  uint32_t handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 300);
+
+  std::vector<uint8_t> whole;
+  ASSERT_EQ(1u, ReadAll(
+                    [&](const std::vector<uint8_t>& cont) {
+                      return ServiceAttrReq(handle, cont);
+                    },
+                    SDP_PDU_SERVICE_ATTR_RSP, &whole));
+
+  p_ccb_->rem_mtu_size = kSmallMtu;
+  std::vector<uint8_t> sliced;
+  size_t num_rsp = ReadAll(
+      [&](const std::vector<uint8_t>& cont) {
+        return ServiceAttrReq(handle, cont);
+      },
+      SDP_PDU_SERVICE_ATTR_RSP, &sliced);
+
+  /* 3 byte header, 16 bytes of handle and class list, 306 of name */
+  ASSERT_EQ(325u, whole.size());
+  EXPECT_EQ((DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD, whole[0]);
+  EXPECT_EQ((325u + kSmallMtu - 11) / (kSmallMtu - 10), num_rsp);
+  EXPECT_EQ(whole, sliced);
+}
+
+TEST_F(StackSdpServerTest, forged_continuation_state) {
+  uint32_t handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 300);
+  p_ccb_->rem_mtu_size = kSmallMtu;
+
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      ServiceAttrReq(handle, kNoContinuation), SDP_PDU_SERVICE_ATTR_RSP);
+  ASSERT_EQ(Continuation(kSmallMtu - 10), rsp.cont);
+
+  /* Offsets other than the one sent are rejected */
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, Continuation(kSmallMtu - 9))));
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, Continuation(0))));
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, Continuation(0xffff))));
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, {0x01, kSmallMtu - 10})));
+
+  /* The exchange still continues from the offset sent */
+  rsp = ParseAttrListsRsp(ServiceAttrReq(handle, rsp.cont),
+                          SDP_PDU_SERVICE_ATTR_RSP);
+  EXPECT_EQ(Continuation(2 * (kSmallMtu - 10)), rsp.cont);
+}
+
+TEST_F(StackSdpServerTest, continuation_past_the_response) {
+  uint32_t handle = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+
+  /* No response to continue */
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, Continuation(0))));
+
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      ServiceAttrReq(handle, kNoContinuation), SDP_PDU_SERVICE_ATTR_RSP);
+  ASSERT_EQ(kNoContinuation, rsp.cont);
+
+  /* The response was fully sent, even at the offset the server is at */
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(ServiceAttrReq(handle, Continuation(rsp.lists.size()))));
+  EXPECT_EQ(SDP_INVALID_CONT_STATE,
+            ErrorCode(SearchAttrReq(UuidSeq(Uuid16(UUID_SERVCLASS_AUDIO_SOURCE)),
+                                    Continuation(rsp.lists.size()))));
+}
+
+TEST_F(StackSdpServerTest, search_attr_continuation_across_mtus) {
+  uint32_t handle_1 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  AddRecord(UUID_SERVCLASS_AV_REMOTE_CONTROL, 100);
+  uint32_t handle_2 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 200);
+  auto request = [this](const std::vector<uint8_t>& cont) {
+    return SearchAttrReq(UuidSeq(Uuid16(UUID_SERVCLASS_AUDIO_SOURCE)), cont);
+  };
+
+  std::vector<uint8_t> whole;
+  ASSERT_EQ(1u, ReadAll(request, SDP_PDU_SERVICE_SEARCH_ATTR_RSP, &whole));
+  EXPECT_EQ(std::vector<uint32_t>({handle_1, handle_2}), RecordHandles(whole));
+
+  p_ccb_->rem_mtu_size = kSmallMtu;
+  std::vector<uint8_t> sliced;
+  EXPECT_LT(5u, ReadAll(request, SDP_PDU_SERVICE_SEARCH_ATTR_RSP, &sliced));
+  EXPECT_EQ(whole, sliced);
+}
+
+TEST_F(StackSdpServerTest, search_attr_no_match) {
+  AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      SearchAttrReq(UuidSeq(Uuid16(UUID_SERVCLASS_AV_REMOTE_CONTROL)),
+                    kNoContinuation),
+      SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  EXPECT_EQ(std::vector<uint8_t>({0x35, 0x00}), rsp.lists);
+  EXPECT_EQ(kNoContinuation, rsp.cont);
+}
+
+TEST_F(StackSdpServerTest, uuid_index_matches_all_uuid_sizes) {
+  const Uuid custom = Uuid::FromString("9f2d4c9e-64c1-4b36-9cbb-5d2bd7d3c5e1");
+  uint32_t audio_source = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+  uint32_t custom_handle = SDP_CreateRecord();
+  std::vector<uint8_t> custom_class = Uuid128(custom);
+  ASSERT_TRUE(SDP_AddAttribute(custom_handle, ATTR_ID_SERVICE_CLASS_ID_LIST,
+                               DATA_ELE_SEQ_DESC_TYPE, custom_class.size(),
+                               custom_class.data()));
+  tSDP_PROTOCOL_ELEM l2cap = {.protocol_uuid = UUID_PROTOCOL_L2CAP,
+                              .num_params = 1,
+                              .params = {0x1001}};
+  ASSERT_TRUE(SDP_AddProtocolList(custom_handle, 1, &l2cap));
+
+  const Uuid audio_source_128 = Uuid::From16Bit(UUID_SERVCLASS_AUDIO_SOURCE);
+  for (const auto& uuid : {Uuid16(UUID_SERVCLASS_AUDIO_SOURCE),
+                           Uuid32(UUID_SERVCLASS_AUDIO_SOURCE),
+                           Uuid128(audio_source_128)}) {
+    AttrListsRsp rsp = ParseAttrListsRsp(
+        SearchAttrReq(UuidSeq(uuid), kNoContinuation),
+        SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+    EXPECT_EQ(std::vector<uint32_t>({audio_source}),
+              RecordHandles(rsp.lists));
+  }
+
+  /* UUIDs nested in sequences match too, all of the pattern must match */
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      SearchAttrReq(UuidSeq(Concat({Uuid128(custom),
+                                    Uuid16(UUID_PROTOCOL_L2CAP)})),
+                    kNoContinuation),
+      SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  EXPECT_EQ(std::vector<uint32_t>({custom_handle}), RecordHandles(rsp.lists));
+
+  rsp = ParseAttrListsRsp(
+      SearchAttrReq(UuidSeq(Concat({Uuid128(custom),
+                                    Uuid16(UUID_SERVCLASS_AUDIO_SOURCE)})),
+                    kNoContinuation),
+      SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  EXPECT_TRUE(RecordHandles(rsp.lists).empty());
+}
+
+TEST_F(StackSdpServerTest, service_search_uses_uuid_index) {
+  uint32_t handle_1 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+  AddRecord(UUID_SERVCLASS_AV_REMOTE_CONTROL);
+  uint32_t handle_2 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE);
+
+  std::vector<uint8_t> rsp = Request(
+      SDP_PDU_SERVICE_SEARCH_REQ,
+      Concat({UuidSeq(Uuid32(UUID_SERVCLASS_AUDIO_SOURCE)), {0x00, 0x10},
+              kNoContinuation}));
+  const std::vector<uint8_t> expected = {
+      SDP_PDU_SERVICE_SEARCH_RSP,
+      (uint8_t)(kTransNum >> 8),
+      (uint8_t)kTransNum,
+      0x00,
+      0x0d,
+      /* total and current record count */
+      0x00,
+      0x02,
+      0x00,
+      0x02,
+      (uint8_t)(handle_1 >> 24),
+      (uint8_t)(handle_1 >> 16),
+      (uint8_t)(handle_1 >> 8),
+      (uint8_t)handle_1,
+      (uint8_t)(handle_2 >> 24),
+      (uint8_t)(handle_2 >> 16),
+      (uint8_t)(handle_2 >> 8),
+      (uint8_t)handle_2,
+      0x00};
+  EXPECT_EQ(expected, rsp);
+}
+
+TEST_F(StackSdpServerTest, avrcp_1_4_only_peer) {
+  uint32_t handle = AddRecord(UUID_SERVCLASS_AV_REMOTE_CONTROL);
+  ASSERT_TRUE(SDP_AddProfileDescriptorList(
+      handle, UUID_SERVCLASS_AV_REMOTE_CONTROL, AVRC_REV_1_6));
+  auto request = [this]() {
+    return ParseAttrListsRsp(
+        SearchAttrReq(UuidSeq(Uuid16(UUID_SERVCLASS_AV_REMOTE_CONTROL)),
+                      kNoContinuation),
+        SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  };
+  /* BluetoothProfileDescriptorList, ending the list */
+  const std::vector<uint8_t> avrcp_1_6 = {0x09, 0x00, 0x09, 0x35, 0x08, 0x35,
+                                          0x06, 0x19, 0x11, 0x0e, 0x09, 0x01,
+                                          0x06};
+  std::vector<uint8_t> avrcp_1_4 = avrcp_1_6;
+  avrcp_1_4.back() = 0x04;
+
+  std::vector<uint8_t> lists = request().lists;
+  ASSERT_LE(avrcp_1_6.size(), lists.size());
+  EXPECT_TRUE(std::equal(avrcp_1_6.rbegin(), avrcp_1_6.rend(), lists.rbegin()));
+
+  avrcp_1_4_only_peer = true;
+  lists = request().lists;
+  ASSERT_LE(avrcp_1_4.size(), lists.size());
+  EXPECT_TRUE(std::equal(avrcp_1_4.rbegin(), avrcp_1_4.rend(), lists.rbegin()));
+
+  /* The database keeps the real version for other peers */
+  avrcp_1_4_only_peer = false;
+  lists = request().lists;
+  EXPECT_TRUE(std::equal(avrcp_1_6.rbegin(), avrcp_1_6.rend(), lists.rbegin()));
+}
+
+TEST_F(StackSdpServerTest, record_deleted_between_continuations) {
+  uint32_t handle_1 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  uint32_t handle_2 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  p_ccb_->rem_mtu_size = kSmallMtu;
+  const std::vector<uint8_t> pattern =
+      UuidSeq(Uuid16(UUID_SERVCLASS_AUDIO_SOURCE));
+
+  /* A ServiceAttribute exchange on the deleted record ends */
+  AttrListsRsp rsp = ParseAttrListsRsp(
+      ServiceAttrReq(handle_2, kNoContinuation), SDP_PDU_SERVICE_ATTR_RSP);
+  ASSERT_NE(kNoContinuation, rsp.cont);
+  ASSERT_TRUE(SDP_DeleteRecord(handle_2));
+  EXPECT_EQ(SDP_INVALID_SERV_REC_HDL,
+            ErrorCode(ServiceAttrReq(handle_2, rsp.cont)));
+
+  /* A ServiceSearchAttribute exchange completes with the records it started
+   * with, the next one no longer finds the deleted record */
+  handle_2 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  std::vector<uint8_t> lists;
+  rsp = ParseAttrListsRsp(SearchAttrReq(pattern, kNoContinuation),
+                          SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  lists = rsp.lists;
+  ASSERT_TRUE(SDP_DeleteRecord(handle_2));
+  while (rsp.cont != kNoContinuation) {
+    rsp = ParseAttrListsRsp(SearchAttrReq(pattern, rsp.cont),
+                            SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+    lists.insert(lists.end(), rsp.lists.begin(), rsp.lists.end());
+  }
+  EXPECT_EQ(std::vector<uint32_t>({handle_1, handle_2}), RecordHandles(lists));
+
+  p_ccb_->rem_mtu_size = SDP_MTU_SIZE;
+  rsp = ParseAttrListsRsp(SearchAttrReq(pattern, kNoContinuation),
+                          SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  EXPECT_EQ(std::vector<uint32_t>({handle_1}), RecordHandles(rsp.lists));
+}
+
+TEST_F(StackSdpServerTest, record_added_between_continuations) {
+  uint32_t handle_1 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  p_ccb_->rem_mtu_size = kSmallMtu;
+  const std::vector<uint8_t> pattern =
+      UuidSeq(Uuid16(UUID_SERVCLASS_AUDIO_SOURCE));
+
+  AttrListsRsp rsp = ParseAttrListsRsp(SearchAttrReq(pattern, kNoContinuation),
+                                       SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  std::vector<uint8_t> lists = rsp.lists;
+  uint32_t handle_2 = AddRecord(UUID_SERVCLASS_AUDIO_SOURCE, 100);
+  while (rsp.cont != kNoContinuation) {
+    rsp = ParseAttrListsRsp(SearchAttrReq(pattern, rsp.cont),
+                            SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+    lists.insert(lists.end(), rsp.lists.begin(), rsp.lists.end());
+  }
+  EXPECT_EQ(std::vector<uint32_t>({handle_1}), RecordHandles(lists));
+
+  p_ccb_->rem_mtu_size = SDP_MTU_SIZE;
+  rsp = ParseAttrListsRsp(SearchAttrReq(pattern, kNoContinuation),
+                          SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  EXPECT_EQ(std::vector<uint32_t>({handle_1, handle_2}),
+            RecordHandles(rsp.lists));
+}
+
+class StackSdpDbTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SDP_DeleteRecord(0); }
+  void TearDown() override { SDP_DeleteRecord(0); }
+
+  static tSDP_ATTR_SEQ AttrSeq(uint16_t start, uint16_t end) {
+    tSDP_ATTR_SEQ seq = {.num_attr = 1};
+    seq.attr_entry[0] = {.start = start, .end = end};
+    return seq;
+  }
+};
+
+TEST_F(StackSdpDbTest, attr_list_cached_until_record_changes) {
+  uint32_t handle = SDP_CreateRecord();
+  uint16_t service_class = UUID_SERVCLASS_AUDIO_SOURCE;
+  ASSERT_TRUE(SDP_AddServiceClassIdList(handle, 1, &service_class));
+  tSDP_ATTR_SEQ seq = AttrSeq(ATTR_ID_SERVICE_CLASS_ID_LIST, 0xffff);
+
+  const std::vector<uint8_t>* p_list =
+      &sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false);
+  const std::vector<uint8_t> class_list = {0x09, 0x00, 0x01, 0x35,
+                                           0x03, 0x19, 0x11, 0x0a};
+  EXPECT_EQ(class_list, *p_list);
+  EXPECT_EQ(p_list,
+            &sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false));
+
+  /* Adding an attribute drops the cached list */
+  uint8_t psm[] = {0x00, 0x19};
+  ASSERT_TRUE(SDP_AddAttribute(handle, 0x0200, UINT_DESC_TYPE, 2, psm));
+  std::vector<uint8_t> expected = class_list;
+  expected.insert(expected.end(), {0x09, 0x02, 0x00, 0x09, 0x00, 0x19});
+  EXPECT_EQ(expected,
+            sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false));
+
+  /* So does deleting one */
+  ASSERT_TRUE(SDP_DeleteAttribute(handle, ATTR_ID_SERVICE_CLASS_ID_LIST));
+  EXPECT_EQ(std::vector<uint8_t>({0x09, 0x02, 0x00, 0x09, 0x00, 0x19}),
+            sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false));
+}
+
+TEST_F(StackSdpDbTest, attr_list_of_reused_record_handle) {
+  uint32_t handle = SDP_CreateRecord();
+  uint16_t service_class = UUID_SERVCLASS_AUDIO_SOURCE;
+  ASSERT_TRUE(SDP_AddServiceClassIdList(handle, 1, &service_class));
+  tSDP_ATTR_SEQ seq = AttrSeq(ATTR_ID_SERVICE_CLASS_ID_LIST,
+                              ATTR_ID_SERVICE_CLASS_ID_LIST);
+  ASSERT_FALSE(
+      sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false).empty());
+
+  /* The next record takes the handle of the deleted one */
+  ASSERT_TRUE(SDP_DeleteRecord(handle));
+  ASSERT_EQ(handle, SDP_CreateRecord());
+  EXPECT_TRUE(
+      sdp_db_get_attr_list(sdp_db_find_record(handle), &seq, false).empty());
+
+  tSDP_UUID_SEQ uuid_seq = {.num_uids = 1};
+  uuid_seq.uuid_entry[0] = {.len = 2, .value = {0x11, 0x0a}};
+  EXPECT_EQ(nullptr, sdp_db_service_search(nullptr, &uuid_seq));
+}
+
+TEST_F(StackSdpDbTest, attr_lists_evicted_least_recently_used_first) {
+  uint32_t handle = SDP_CreateRecord();
+  uint16_t service_class = UUID_SERVCLASS_AUDIO_SOURCE;
+  ASSERT_TRUE(SDP_AddServiceClassIdList(handle, 1, &service_class));
+  tSDP_RECORD* p_rec = sdp_db_find_record(handle);
+
+  /* Lists of different attribute ranges are cached separately */
+  std::vector<const std::vector<uint8_t>*> lists;
+  for (uint16_t end = 0; end < 32; end++) {
+    tSDP_ATTR_SEQ seq = AttrSeq(0, end);
+    lists.push_back(&sdp_db_get_attr_list(p_rec, &seq, false));
+  }
+
+  /* The 16 most recent are still cached, hits do not evict */
+  for (uint16_t end = 31; end >= 16; end--) {
+    tSDP_ATTR_SEQ seq = AttrSeq(0, end);
+    EXPECT_EQ(lists[end], &sdp_db_get_attr_list(p_rec, &seq, false));
+    EXPECT_EQ(16u, lists[end]->size());
+  }
+
+  /* The older ones are built again */
+  tSDP_ATTR_SEQ seq = AttrSeq(0, 0);
+  EXPECT_EQ(8u, sdp_db_get_attr_list(p_rec, &seq, false).size());
+}
+
+}  // namespace
@@ -38,11 +38,8 @@ static void add_item_to_list(std::list<tGATT_SRV_LIST_ELEM>& srv_list_info,
 }
 
 // BT Spec 5.2, Vol 3, Part G, Appendix B
-TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
-  tGATT_SVC_DB local_db[4];
-  for (int i=0; i<4; i++) local_db[i] = tGATT_SVC_DB();
-  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
-
+static void build_example_db(tGATT_SVC_DB* local_db,
+                             std::list<tGATT_SRV_LIST_ELEM>& srv_list_info) {
   // 0x1800
   add_item_to_list(srv_list_info, &local_db[0], true);
   gatts_init_service_db(local_db[0], Uuid::From16Bit(0x1800), true, 0x0001, 5);
@@ -78,6 +75,13 @@ TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
   gatts_init_service_db(local_db[3], Uuid::From16Bit(0x180F), false, 0x0014, 3);
   gatts_add_characteristic(local_db[3], GATT_PERM_READ,  GATT_CHAR_PROP_BIT_READ,
     Uuid::From16Bit(0x2A19));
+}
+
+TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
+  tGATT_SVC_DB local_db[4];
+  for (int i=0; i<4; i++) local_db[i] = tGATT_SVC_DB();
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_db(local_db, srv_list_info);
 
   Octet16 expected_hash{0xF1, 0xCA, 0x2D, 0x48, 0xEC, 0xF5, 0x8B, 0xAC,
                         0x8A, 0x88, 0x30, 0xBB, 0xB9, 0xFB, 0xA9, 0x90};
@@ -87,3 +91,39 @@ TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
 
   ASSERT_EQ(result_hash, expected_hash);
 }
+
+TEST(GattDatabaseTest, cachedServiceInfoAfterServiceRemoval) {
+  tGATT_SVC_DB local_db[4];
+  for (int i=0; i<4; i++) local_db[i] = tGATT_SVC_DB();
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_db(local_db, srv_list_info);
+
+  Octet16 full_hash = gatts_calculate_database_hash(&srv_list_info);
+  ASSERT_EQ(full_hash, gatts_calculate_database_hash(&srv_list_info));
+
+  // Services keep their serialized info, the hash must not depend on it
+  srv_list_info.erase(std::next(srv_list_info.begin()));
+  Octet16 cached_hash = gatts_calculate_database_hash(&srv_list_info);
+  for (auto& el : srv_list_info) el.hash_info.clear();
+  ASSERT_EQ(cached_hash, gatts_calculate_database_hash(&srv_list_info));
+  ASSERT_NE(full_hash, cached_hash);
+}
+
+TEST(GattDatabaseTest, databaseHashComputedWhenRead) {
+  tGATT_SVC_DB local_db[4];
+  for (int i=0; i<4; i++) local_db[i] = tGATT_SVC_DB();
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_db(local_db, srv_list_info);
+
+  gatt_cb.srv_list_info = &srv_list_info;
+  gatt_cb.database_hash_valid = false;
+  Octet16 hash = gatts_calculate_database_hash(&srv_list_info);
+  ASSERT_EQ(hash, gatts_get_database_hash());
+  ASSERT_TRUE(gatt_cb.database_hash_valid);
+
+  srv_list_info.pop_back();
+  ASSERT_EQ(hash, gatts_get_database_hash());
+  gatt_cb.database_hash_valid = false;
+  ASSERT_NE(hash, gatts_get_database_hash());
+  gatt_cb.srv_list_info = nullptr;
+}
@@ -41,6 +41,15 @@ bt_status_t do_in_main_thread(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 
+bt_status_t do_in_main_thread_high_priority(const base::Location& from_here,
+                                            base::OnceClosure task) {
+  ASSERT_LOG(main_thread.DoInThread(
+                 from_here, std::move(task),
+                 bluetooth::common::MessageLoopThread::Priority::kHigh),
+             "Unable to run on main thread high priority");
+  return BT_STATUS_SUCCESS;
+}
+
 bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay) {
@@ -28,6 +28,8 @@ using BtMainClosure = std::function<void()>;
 
 bt_status_t do_in_main_thread(const base::Location& from_here,
                               base::OnceClosure task);
+bt_status_t do_in_main_thread_high_priority(const base::Location& from_here,
+                                            base::OnceClosure task);
 bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay);
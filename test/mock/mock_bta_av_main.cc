@@ -82,7 +82,21 @@ void bta_av_conn_cback(UNUSED_ATTR uint8_t handle, const RawAddress& bd_addr,
                        uint8_t event, tAVDT_CTRL* p_data, uint8_t scb_index) {
   mock_function_count_map[__func__]++;
 }
-void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
+void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, tBTA_AV_MEDIA_PKT* p_pkt) {
+  mock_function_count_map[__func__]++;
+}
+void bta_av_flush_audio_list(tBTA_AV_SCB* p_scb) {
+  mock_function_count_map[__func__]++;
+}
+tBTA_AV_MEDIA_PKT* bta_av_media_pkt_new(BT_HDR* p_buf, uint32_t timestamp) {
+  mock_function_count_map[__func__]++;
+  return nullptr;
+}
+BT_HDR* bta_av_media_pkt_take(tBTA_AV_MEDIA_PKT* p_pkt) {
+  mock_function_count_map[__func__]++;
+  return nullptr;
+}
+void bta_av_media_pkt_release(tBTA_AV_MEDIA_PKT* p_pkt) {
   mock_function_count_map[__func__]++;
 }
 void bta_av_free_scb(tBTA_AV_SCB* p_scb) {
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:33
+ *   Functions generated:34
  */
 
 #include <map>
@@ -76,6 +76,7 @@ void BTA_DmBleConfirmReply(const RawAddress& bd_addr, bool accept) {
 void BTA_DmBleGetEnergyInfo(tBTA_BLE_ENERGY_INFO_CBACK* p_cmpl_cback) {
   mock_function_count_map[__func__]++;
 }
+void BTA_DmPmDumpStatistics(int fd) { mock_function_count_map[__func__]++; }
 void BTA_DmBlePasskeyReply(const RawAddress& bd_addr, bool accept,
                            uint32_t passkey) {
   mock_function_count_map[__func__]++;
@@ -26,7 +26,6 @@ extern std::map<std::string, int> mock_function_count_map;
 
 #include <base/bind.h>
 #include <ios>
-#include <list>
 #include <memory>
 #include <vector>
 #include "bt_target.h"
@@ -61,7 +60,7 @@ const gatt::Service* BTA_GATTC_GetOwningService(uint16_t conn_id,
   mock_function_count_map[__func__]++;
   return nullptr;
 }
-const std::list<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
+const std::vector<gatt::Service>* BTA_GATTC_GetServices(uint16_t conn_id) {
   mock_function_count_map[__func__]++;
   return nullptr;
 }
@@ -103,6 +102,10 @@ void BTA_GATTC_DiscoverServiceByUuid(uint16_t conn_id,
 void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute) {
   mock_function_count_map[__func__]++;
 }
+void BTA_GATTC_ExecuteWrite(uint16_t conn_id, bool is_execute,
+                            GATT_EXECUTE_WRITE_OP_CB callback, void* cb_data) {
+  mock_function_count_map[__func__]++;
+}
 void BTA_GATTC_GetGattDb(uint16_t conn_id, uint16_t start_handle,
                          uint16_t end_handle, btgatt_db_element_t** db,
                          int* count) {
@@ -136,6 +139,11 @@ void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
                             tGATT_AUTH_REQ auth_req) {
   mock_function_count_map[__func__]++;
 }
+void BTA_GATTC_ReadMultiple(uint16_t conn_id, tBTA_GATTC_MULTI* p_read_multi,
+                            bool variable_len, tGATT_AUTH_REQ auth_req,
+                            GATT_READ_MULTI_OP_CB callback, void* cb_data) {
+  mock_function_count_map[__func__]++;
+}
 void BTA_GATTC_ReadUsingCharUuid(uint16_t conn_id, const bluetooth::Uuid& uuid,
                                  uint16_t s_handle, uint16_t e_handle,
                                  tGATT_AUTH_REQ auth_req,
@@ -165,3 +173,10 @@ void BTA_GATTC_WriteCharValue(uint16_t conn_id, uint16_t handle,
                               GATT_WRITE_OP_CB callback, void* cb_data) {
   mock_function_count_map[__func__]++;
 }
+void BTA_GATTC_WriteCharStream(uint16_t conn_id, uint16_t handle,
+                               std::vector<uint8_t> value,
+                               tGATT_AUTH_REQ auth_req,
+                               GATT_WRITE_STREAM_OP_CB callback,
+                               void* cb_data) {
+  mock_function_count_map[__func__]++;
+}
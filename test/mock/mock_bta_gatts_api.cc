@@ -67,6 +67,10 @@ void BTA_GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_id,
                                      bool need_confirm) {
   mock_function_count_map[__func__]++;
 }
+void BTA_GATTS_SetAttributeCache(uint16_t attr_id, std::vector<uint8_t> value,
+                                 uint64_t ttl_ms) {
+  mock_function_count_map[__func__]++;
+}
 void BTA_GATTS_Open(tGATT_IF server_if, const RawAddress& remote_bda,
                     bool is_direct, tBT_TRANSPORT transport) {
   mock_function_count_map[__func__]++;
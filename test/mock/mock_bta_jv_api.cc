@@ -79,6 +79,12 @@ tBTA_JV_STATUS BTA_JvL2capWrite(uint32_t handle, uint32_t req_id, BT_HDR* msg,
   mock_function_count_map[__func__]++;
   return 0;
 }
+tBTA_JV_STATUS BTA_JvL2capWriteBatch(uint32_t handle, uint32_t req_id,
+                                     std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id) {
+  mock_function_count_map[__func__]++;
+  return 0;
+}
 tBTA_JV_STATUS BTA_JvRfcommClose(uint32_t handle, uint32_t rfcomm_slot_id) {
   mock_function_count_map[__func__]++;
   return 0;
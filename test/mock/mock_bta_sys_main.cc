@@ -55,6 +55,10 @@ void bta_sys_register(uint8_t id, const tBTA_SYS_REG* p_reg) {
   mock_function_count_map[__func__]++;
 }
 void bta_sys_sendmsg(void* p_msg) { mock_function_count_map[__func__]++; }
+void bta_sys_send_inline_event(tBTA_SYS_EVT_HDLR* p_handler,
+                               const void* p_event, size_t len) {
+  mock_function_count_map[__func__]++;
+}
 void bta_sys_sendmsg_delayed(void* p_msg, const base::TimeDelta& delay) {
   mock_function_count_map[__func__]++;
 }
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:12
+ *   Functions generated:13
  */
 
 #include <cstdint>
@@ -53,6 +53,10 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
   mock_function_count_map[__func__]++;
 }
 void bta_hh_co_destroy(int fd) { mock_function_count_map[__func__]++; }
+void bta_hh_co_input(uint8_t dev_handle, uint8_t rpt_id, const uint8_t* p_rpt,
+                     uint16_t len) {
+  mock_function_count_map[__func__]++;
+}
 void bta_hh_co_get_rpt_rsp(uint8_t dev_handle, uint8_t status, uint8_t* p_rpt,
                            uint16_t len) {
   mock_function_count_map[__func__]++;
@@ -18,8 +18,12 @@
  * Generated mock file from original source file
  */
 
-#include "osi/include/future.h"
+#include <map>
+#include <string>
 
-static future_t* hack_future;
+extern std::map<std::string, int> mock_function_count_map;
 
-future_t* stack_manager_get_hack_future() { return hack_future; }
+void stack_manager_signal_stage_done() {
+  mock_function_count_map[__func__]++;
+}
+void stack_manager_dump(int fd) { mock_function_count_map[__func__]++; }
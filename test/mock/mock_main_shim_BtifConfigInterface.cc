@@ -85,6 +85,10 @@ std::vector<std::string>
 bluetooth::shim::BtifConfigInterface::GetPersistentDevices() {
   return std::vector<std::string>();
 }
+void bluetooth::shim::BtifConfigInterface::ForEachPersistentProperty(
+    const std::function<void(const std::string& section,
+                             const std::string& property,
+                             const std::string& value)>& visitor) {}
 void bluetooth::shim::BtifConfigInterface::Save(){};
 void bluetooth::shim::BtifConfigInterface::Flush(){};
 void bluetooth::shim::BtifConfigInterface::Clear(){};
@@ -144,10 +144,11 @@ bool bluetooth::shim::L2CA_ReconfigCreditBasedConnsReq(
       bd_addr, lcids, p_cfg);
 }
 std::vector<uint16_t> bluetooth::shim::L2CA_ConnectCreditBasedReq(
-    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg) {
+    uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg,
+    uint8_t num_of_channels) {
   mock_function_count_map[__func__]++;
   return test::mock::main_shim_l2cap_api::L2CA_ConnectCreditBasedReq(
-      psm, p_bd_addr, p_cfg);
+      psm, p_bd_addr, p_cfg, num_of_channels);
 }
 bool bluetooth::shim::L2CA_ConnectCreditBasedRsp(
     const RawAddress& bd_addr, uint8_t id,
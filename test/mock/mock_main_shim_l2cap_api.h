@@ -176,17 +176,20 @@ struct L2CA_ReconfigCreditBasedConnsReq {
 };
 extern struct L2CA_ReconfigCreditBasedConnsReq L2CA_ReconfigCreditBasedConnsReq;
 // Name: L2CA_ConnectCreditBasedReq
-// Params: uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg
-// Returns: std::vector<uint16_t>
+// Params: uint16_t psm, const RawAddress& p_bd_addr, tL2CAP_LE_CFG_INFO* p_cfg,
+// uint8_t num_of_channels Returns: std::vector<uint16_t>
 struct L2CA_ConnectCreditBasedReq {
   std::vector<uint16_t> cids;
   std::function<std::vector<uint16_t>(uint16_t psm, const RawAddress& p_bd_addr,
-                                      tL2CAP_LE_CFG_INFO* p_cfg)>
+                                      tL2CAP_LE_CFG_INFO* p_cfg,
+                                      uint8_t num_of_channels)>
       body{[this](uint16_t psm, const RawAddress& p_bd_addr,
-                  tL2CAP_LE_CFG_INFO* p_cfg) { return cids; }};
+                  tL2CAP_LE_CFG_INFO* p_cfg,
+                  uint8_t num_of_channels) { return cids; }};
   std::vector<uint16_t> operator()(uint16_t psm, const RawAddress& p_bd_addr,
-                                   tL2CAP_LE_CFG_INFO* p_cfg) {
-    return body(psm, p_bd_addr, p_cfg);
+                                   tL2CAP_LE_CFG_INFO* p_cfg,
+                                   uint8_t num_of_channels) {
+    return body(psm, p_bd_addr, p_cfg, num_of_channels);
   };
 };
 extern struct L2CA_ConnectCreditBasedReq L2CA_ConnectCreditBasedReq;
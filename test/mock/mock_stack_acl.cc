@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:127
+ *   Functions generated:128
  */
 
 #include <cstdint>
@@ -48,6 +48,11 @@ bool BTM_BLE_IS_RESOLVE_BDA(const RawAddress& x) {
   mock_function_count_map[__func__]++;
   return false;
 }
+bool BTM_ReadAclTraffic(const RawAddress& remote_bda,
+                        tBTM_ACL_TRAFFIC* p_traffic) {
+  mock_function_count_map[__func__]++;
+  return false;
+}
 bool BTM_IsAclConnectionUp(const RawAddress& remote_bda,
                            tBT_TRANSPORT transport) {
   mock_function_count_map[__func__]++;
@@ -287,6 +292,9 @@ void acl_link_segments_xmitted(BT_HDR* p_msg) {
 void acl_packets_completed(uint16_t handle, uint16_t credits) {
   mock_function_count_map[__func__]++;
 }
+void acl_tx_congestion(uint16_t handle, bool congested) {
+  mock_function_count_map[__func__]++;
+}
 void acl_process_supported_features(uint16_t handle, uint64_t features) {
   mock_function_count_map[__func__]++;
 }
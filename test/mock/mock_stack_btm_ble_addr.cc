@@ -98,6 +98,9 @@ tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   return test::mock::stack_btm_ble_addr::btm_ble_resolve_random_addr(
       random_bda);
 }
+void btm_ble_clear_resolved_rpa_cache() {
+  mock_function_count_map[__func__]++;
+}
 bool btm_identity_addr_to_random_pseudo(RawAddress* bd_addr,
                                         uint8_t* p_addr_type, bool refresh) {
   mock_function_count_map[__func__]++;
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:11
+ *   Functions generated:13
  *
  *  mockcify.pl ver 0.2
  */
@@ -56,6 +56,8 @@ struct BTM_SetLeConnectionModeToFast BTM_SetLeConnectionModeToFast;
 struct BTM_SetLeConnectionModeToSlow BTM_SetLeConnectionModeToSlow;
 struct BTM_AcceptlistAdd BTM_AcceptlistAdd;
 struct BTM_AcceptlistRemove BTM_AcceptlistRemove;
+struct BTM_AcceptlistUpdate BTM_AcceptlistUpdate;
+struct BTM_GetAcceptlistSize BTM_GetAcceptlistSize;
 struct BTM_AcceptlistClear BTM_AcceptlistClear;
 
 }  // namespace stack_btm_ble_bgconn
@@ -108,6 +110,17 @@ void BTM_AcceptlistRemove(const RawAddress& address) {
   mock_function_count_map[__func__]++;
   test::mock::stack_btm_ble_bgconn::BTM_AcceptlistRemove(address);
 }
+std::vector<RawAddress> BTM_AcceptlistUpdate(
+    const std::vector<RawAddress>& to_remove,
+    const std::vector<RawAddress>& to_add) {
+  mock_function_count_map[__func__]++;
+  return test::mock::stack_btm_ble_bgconn::BTM_AcceptlistUpdate(to_remove,
+                                                                 to_add);
+}
+size_t BTM_GetAcceptlistSize() {
+  mock_function_count_map[__func__]++;
+  return test::mock::stack_btm_ble_bgconn::BTM_GetAcceptlistSize();
+}
 void BTM_AcceptlistClear() {
   mock_function_count_map[__func__]++;
   test::mock::stack_btm_ble_bgconn::BTM_AcceptlistClear();
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:11
+ *   Functions generated:13
  *
  *  mockcify.pl ver 0.2
  */
@@ -37,6 +37,7 @@ extern std::map<std::string, int> mock_function_count_map;
 #include <base/bind.h>
 #include <cstdint>
 #include <unordered_map>
+#include <vector>
 #include "device/include/controller.h"
 #include "main/shim/acl_api.h"
 #include "main/shim/shim.h"
@@ -151,6 +152,30 @@ struct BTM_AcceptlistRemove {
   void operator()(const RawAddress& address) { body(address); };
 };
 extern struct BTM_AcceptlistRemove BTM_AcceptlistRemove;
+// Name: BTM_AcceptlistUpdate
+// Params: const std::vector<RawAddress>& to_remove,
+// const std::vector<RawAddress>& to_add
+// Returns: std::vector<RawAddress>
+struct BTM_AcceptlistUpdate {
+  std::function<std::vector<RawAddress>(
+      const std::vector<RawAddress>& to_remove,
+      const std::vector<RawAddress>& to_add)>
+      body{[](const std::vector<RawAddress>& to_remove,
+              const std::vector<RawAddress>& to_add) { return to_add; }};
+  std::vector<RawAddress> operator()(const std::vector<RawAddress>& to_remove,
+                                     const std::vector<RawAddress>& to_add) {
+    return body(to_remove, to_add);
+  };
+};
+extern struct BTM_AcceptlistUpdate BTM_AcceptlistUpdate;
+// Name: BTM_GetAcceptlistSize
+// Params:
+// Returns: size_t
+struct BTM_GetAcceptlistSize {
+  std::function<size_t()> body{[]() { return 0; }};
+  size_t operator()() { return body(); };
+};
+extern struct BTM_GetAcceptlistSize BTM_GetAcceptlistSize;
 // Name: BTM_AcceptlistClear
 // Params:
 // Returns: void
@@ -64,11 +64,7 @@ bool btm_set_bond_type_dev(const RawAddress& bd_addr,
   mock_function_count_map[__func__]++;
   return false;
 }
-bool is_address_equal(void* data, void* context) {
-  mock_function_count_map[__func__]++;
-  return false;
-}
-bool is_handle_equal(void* data, void* context) {
+bool is_address_resolvable(void* data, void* context) {
   mock_function_count_map[__func__]++;
   return false;
 }
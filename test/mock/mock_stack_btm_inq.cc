@@ -128,6 +128,9 @@ tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda) {
   mock_function_count_map[__func__]++;
   return nullptr;
 }
+void btm_inq_db_release(tINQ_DB_ENT* p_ent) {
+  mock_function_count_map[__func__]++;
+}
 uint16_t BTM_IsInquiryActive(void) {
   mock_function_count_map[__func__]++;
   return 0;
@@ -150,6 +153,9 @@ void BTM_AddEirService(uint32_t* p_eir_uuid, uint16_t uuid16) {
 void BTM_CancelInquiry(void) { mock_function_count_map[__func__]++; }
 void BTM_EnableInterlacedInquiryScan() { mock_function_count_map[__func__]++; }
 void BTM_EnableInterlacedPageScan() { mock_function_count_map[__func__]++; }
+void BTM_SetStreamingActive(bool active) {
+  mock_function_count_map[__func__]++;
+}
 void BTM_RemoveEirService(uint32_t* p_eir_uuid, uint16_t uuid16) {
   mock_function_count_map[__func__]++;
 }
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:7
+ *   Functions generated:9
  */
 
 #include <map>
@@ -56,6 +56,11 @@ bt_status_t do_in_main_thread(const base::Location& from_here,
   mock_function_count_map[__func__]++;
   return BT_STATUS_SUCCESS;
 }
+bt_status_t do_in_main_thread_high_priority(const base::Location& from_here,
+                                            base::OnceClosure task) {
+  mock_function_count_map[__func__]++;
+  return BT_STATUS_SUCCESS;
+}
 bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
                                       base::OnceClosure task,
                                       const base::TimeDelta& delay) {
@@ -63,6 +68,13 @@ bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
   return BT_STATUS_SUCCESS;
 }
 void btu_hci_msg_process(BT_HDR* p_msg) { mock_function_count_map[__func__]++; }
+void btu_hci_msg_process_received(BT_HDR* p_msg, uint64_t rx_time_us) {
+  mock_function_count_map[__func__]++;
+}
+uint64_t btu_hci_rx_time_us() {
+  mock_function_count_map[__func__]++;
+  return 0;
+}
 void main_thread_shut_down() { mock_function_count_map[__func__]++; }
 void main_thread_start_up() { mock_function_count_map[__func__]++; }
 void post_on_bt_main(BtMainClosure closure) {
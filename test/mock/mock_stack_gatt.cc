@@ -115,6 +115,14 @@ tGATT_STATUS GATTC_SendHandleValueConfirm(uint16_t conn_id, uint16_t cid) {
   mock_function_count_map[__func__]++;
   return GATT_SUCCESS;
 }
+uint16_t GATTC_GetInFlightDepth(uint16_t conn_id) {
+  mock_function_count_map[__func__]++;
+  return 0;
+}
+uint16_t GATTC_GetWriteCmdMaxLen(uint16_t conn_id) {
+  mock_function_count_map[__func__]++;
+  return 0;
+}
 tGATT_STATUS GATTC_Write(uint16_t conn_id, tGATT_WRITE_TYPE type,
                          tGATT_VALUE* p_write) {
   mock_function_count_map[__func__]++;
@@ -136,6 +144,24 @@ tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
   mock_function_count_map[__func__]++;
   return GATT_SUCCESS;
 }
+tGATT_STATUS GATTS_HandleValueNotificationFanOut(
+    const std::vector<uint16_t>& conn_ids, uint16_t attr_handle,
+    uint16_t val_len, uint8_t* p_val) {
+  mock_function_count_map[__func__]++;
+  return GATT_SUCCESS;
+}
+void GATTS_SetNotificationCoalescing(uint64_t window_ms) {
+  mock_function_count_map[__func__]++;
+}
+tGATT_STATUS GATTS_SetAttributeCache(uint16_t attr_handle,
+                                     const std::vector<uint8_t>& value,
+                                     uint64_t ttl_ms) {
+  mock_function_count_map[__func__]++;
+  return GATT_SUCCESS;
+}
+void GATTS_ClearAttributeCache(uint16_t attr_handle) {
+  mock_function_count_map[__func__]++;
+}
 tGATT_STATUS GATTS_SendRsp(uint16_t conn_id, uint32_t trans_id,
                            tGATT_STATUS status, tGATTS_RSP* p_msg) {
   mock_function_count_map[__func__]++;
@@ -157,3 +183,4 @@ void GATT_SetIdleTimeout(const RawAddress& bd_addr, uint16_t idle_tout,
   mock_function_count_map[__func__]++;
 }
 void GATT_StartIf(tGATT_IF gatt_if) { mock_function_count_map[__func__]++; }
+void GATT_Dump(int fd) { mock_function_count_map[__func__]++; }
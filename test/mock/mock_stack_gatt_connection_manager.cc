@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:16
+ *   Functions generated:18
  */
 
 #include <map>
@@ -81,6 +81,13 @@ void connection_manager::on_app_deregistered(uint8_t app_id) {
 void connection_manager::on_connection_complete(const RawAddress& address) {
   mock_function_count_map[__func__]++;
 }
+bool connection_manager::on_disconnected(const RawAddress& address) {
+  mock_function_count_map[__func__]++;
+  return true;
+}
+void connection_manager::on_advertising_seen(const RawAddress& address) {
+  mock_function_count_map[__func__]++;
+}
 void connection_manager::reset(bool after_reset) {
   mock_function_count_map[__func__]++;
 }
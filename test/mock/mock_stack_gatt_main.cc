@@ -102,6 +102,9 @@ void gatt_proc_srv_chg(void) { mock_function_count_map[__func__]++; }
 void gatt_send_srv_chg_ind(const RawAddress& peer_bda) {
   mock_function_count_map[__func__]++;
 }
+void gatt_mtu_exchange_done(tGATT_TCB& tcb, tGATT_STATUS status) {
+  mock_function_count_map[__func__]++;
+}
 void gatt_set_ch_state(tGATT_TCB* p_tcb, tGATT_CH_STATE ch_state) {
   mock_function_count_map[__func__]++;
 }
@@ -172,10 +172,11 @@ bool L2CA_ConnectCreditBasedRsp(const RawAddress& p_bd_addr, uint8_t id,
 }
 std::vector<uint16_t> L2CA_ConnectCreditBasedReq(uint16_t psm,
                                                  const RawAddress& p_bd_addr,
-                                                 tL2CAP_LE_CFG_INFO* p_cfg) {
+                                                 tL2CAP_LE_CFG_INFO* p_cfg,
+                                                 uint8_t num_of_channels) {
   mock_function_count_map[__func__]++;
-  return test::mock::stack_l2cap_api::L2CA_ConnectCreditBasedReq(psm, p_bd_addr,
-                                                                 p_cfg);
+  return test::mock::stack_l2cap_api::L2CA_ConnectCreditBasedReq(
+      psm, p_bd_addr, p_cfg, num_of_channels);
 }
 bool L2CA_ReconfigCreditBasedConnsReq(const RawAddress& bda,
                                       std::vector<uint16_t>& lcids,
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:22
+ *   Functions generated:26
  *
  *  mockcify.pl ver 0.2
  */
@@ -72,6 +72,10 @@ struct l2cble_sec_comp l2cble_sec_comp;
 struct l2ble_sec_access_req l2ble_sec_access_req;
 struct L2CA_AdjustConnectionIntervals L2CA_AdjustConnectionIntervals;
 struct l2cble_use_preferred_conn_params l2cble_use_preferred_conn_params;
+struct l2cble_tuner_count l2cble_tuner_count;
+struct l2cble_tuner_stop l2cble_tuner_stop;
+struct l2cble_tuner_load_text l2cble_tuner_load_text;
+struct l2cble_process_phy_update_evt l2cble_process_phy_update_evt;
 
 }  // namespace stack_l2cap_ble
 }  // namespace mock
@@ -197,5 +201,23 @@ void l2cble_use_preferred_conn_params(const RawAddress& bda) {
   mock_function_count_map[__func__]++;
   test::mock::stack_l2cap_ble::l2cble_use_preferred_conn_params(bda);
 }
+void l2cble_tuner_count(tL2C_LCB* p_lcb, uint32_t bytes) {
+  mock_function_count_map[__func__]++;
+  test::mock::stack_l2cap_ble::l2cble_tuner_count(p_lcb, bytes);
+}
+void l2cble_tuner_stop(tL2C_LCB* p_lcb) {
+  mock_function_count_map[__func__]++;
+  test::mock::stack_l2cap_ble::l2cble_tuner_stop(p_lcb);
+}
+const char* l2cble_tuner_load_text(LeLinkLoad load) {
+  mock_function_count_map[__func__]++;
+  return test::mock::stack_l2cap_ble::l2cble_tuner_load_text(load);
+}
+void l2cble_process_phy_update_evt(uint16_t handle, uint8_t status,
+                                   uint8_t tx_phy, uint8_t rx_phy) {
+  mock_function_count_map[__func__]++;
+  test::mock::stack_l2cap_ble::l2cble_process_phy_update_evt(handle, status,
+                                                             tx_phy, rx_phy);
+}
 
 // END mockcify generation
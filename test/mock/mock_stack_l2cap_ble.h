@@ -313,6 +313,46 @@ struct l2cble_use_preferred_conn_params {
   void operator()(const RawAddress& bda) { body(bda); };
 };
 extern struct l2cble_use_preferred_conn_params l2cble_use_preferred_conn_params;
+// Name: l2cble_tuner_count
+// Params: tL2C_LCB* p_lcb, uint32_t bytes
+// Returns: void
+struct l2cble_tuner_count {
+  std::function<void(tL2C_LCB* p_lcb, uint32_t bytes)> body{
+      [](tL2C_LCB* p_lcb, uint32_t bytes) {}};
+  void operator()(tL2C_LCB* p_lcb, uint32_t bytes) { body(p_lcb, bytes); };
+};
+extern struct l2cble_tuner_count l2cble_tuner_count;
+// Name: l2cble_tuner_stop
+// Params: tL2C_LCB* p_lcb
+// Returns: void
+struct l2cble_tuner_stop {
+  std::function<void(tL2C_LCB* p_lcb)> body{[](tL2C_LCB* p_lcb) {}};
+  void operator()(tL2C_LCB* p_lcb) { body(p_lcb); };
+};
+extern struct l2cble_tuner_stop l2cble_tuner_stop;
+// Name: l2cble_tuner_load_text
+// Params: LeLinkLoad load
+// Returns: const char*
+struct l2cble_tuner_load_text {
+  std::function<const char*(LeLinkLoad load)> body{
+      [](LeLinkLoad load) { return ""; }};
+  const char* operator()(LeLinkLoad load) { return body(load); };
+};
+extern struct l2cble_tuner_load_text l2cble_tuner_load_text;
+// Name: l2cble_process_phy_update_evt
+// Params: uint16_t handle, uint8_t status, uint8_t tx_phy, uint8_t rx_phy
+// Returns: void
+struct l2cble_process_phy_update_evt {
+  std::function<void(uint16_t handle, uint8_t status, uint8_t tx_phy,
+                     uint8_t rx_phy)>
+      body{[](uint16_t handle, uint8_t status, uint8_t tx_phy,
+              uint8_t rx_phy) {}};
+  void operator()(uint16_t handle, uint8_t status, uint8_t tx_phy,
+                  uint8_t rx_phy) {
+    body(handle, status, tx_phy, rx_phy);
+  };
+};
+extern struct l2cble_process_phy_update_evt l2cble_process_phy_update_evt;
 
 }  // namespace stack_l2cap_ble
 }  // namespace mock
@@ -97,6 +97,7 @@ tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
   mock_function_count_map[__func__]++;
   return nullptr;
 }
+void l2cu_clear_lcb_indexes(void) { mock_function_count_map[__func__]++; }
 tL2C_LCB* l2cu_find_lcb_by_state(tL2C_LINK_STATE state) {
   mock_function_count_map[__func__]++;
   return nullptr;
@@ -66,6 +66,8 @@ struct log_manufacturer_info log_manufacturer_info;
 }  // namespace test
 
 // Mocked functions, if any
+void stack_metrics_logging_start_up() { mock_function_count_map[__func__]++; }
+void stack_metrics_logging_shut_down() { mock_function_count_map[__func__]++; }
 void log_classic_pairing_event(const RawAddress& address, uint16_t handle,
                                uint32_t hci_cmd, uint16_t hci_event,
                                uint16_t cmd_status, uint16_t reason_code,
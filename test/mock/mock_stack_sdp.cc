@@ -34,6 +34,15 @@ bool SDP_InitDiscoveryDb(tSDP_DISCOVERY_DB* p_db, uint32_t len,
   return false;
 }
 
+tSDP_DISCOVERY_DB* SDP_CreateDiscoveryDb(uint32_t len, uint16_t num_uuid,
+                                         const Uuid* p_uuid_list,
+                                         uint16_t num_attr,
+                                         uint16_t* p_attr_list) {
+  return (NULL);
+}
+
+void SDP_FreeDiscoveryDb(tSDP_DISCOVERY_DB* p_db) {}
+
 bool SDP_CancelServiceSearch(tSDP_DISCOVERY_DB* p_db) { return false; }
 
 bool SDP_ServiceSearchRequest(const RawAddress& p_bd_addr,
@@ -54,10 +63,20 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
   return false;
 }
 
+void SDP_InvalidateCache(const RawAddress& bd_addr) {}
+void SDP_UpdateCacheFingerprint(const RawAddress& bd_addr,
+                                const uint8_t* p_data, size_t len) {}
+
 tSDP_DISC_ATTR* SDP_FindAttributeInRec(tSDP_DISC_REC* p_rec, uint16_t attr_id) {
   return (NULL);
 }
 
+uint16_t SDP_FindAttributesInRec(tSDP_DISC_REC* p_rec, uint16_t num_attr,
+                                 const uint16_t* p_attr_ids,
+                                 tSDP_DISC_ATTR** p_attrs) {
+  return 0;
+}
+
 bool SDP_FindServiceUUIDInRec(tSDP_DISC_REC* p_rec, Uuid* p_uuid) {
   return false;
 }
@@ -16,7 +16,7 @@
 
 /*
  * Generated mock file from original source file
- *   Functions generated:14
+ *   Functions generated:16
  */
 
 #include <map>
@@ -96,6 +96,14 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
   mock_function_count_map[__func__]++;
   return nullptr;
 }
+const std::vector<uint8_t>& sdp_db_get_attr_list(tSDP_RECORD* p_rec,
+                                                 tSDP_ATTR_SEQ* p_seq,
+                                                 bool avrcp_1_4_only) {
+  static std::vector<uint8_t> attr_list;
+  mock_function_count_map[__func__]++;
+  return attr_list;
+}
+void sdp_db_reset_index(void) { mock_function_count_map[__func__]++; }
 uint32_t SDP_CreateRecord(void) {
   mock_function_count_map[__func__]++;
   return 0;
@@ -53,7 +53,7 @@ extern std::map<std::string, int> mock_function_count_map;
 #endif
 
 bool UIPC_Open(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK* p_cback,
-               const char* socket_path) {
+               const char* socket_path, tUIPC_CH_TYPE ch_type) {
   mock_function_count_map[__func__]++;
   return false;
 }
@@ -10,6 +10,13 @@
 known_benchmarks=(
   bluetooth_benchmark_thread_performance
   bluetooth_benchmark_timer_performance
+  bluetooth_benchmark_sbc_encoder
+  bluetooth_benchmark_sbc_decoder
+  bluetooth_benchmark_avdt_media_header
+  bluetooth_benchmark_avrcp_packets
+  bluetooth_benchmark_btm_dev_index
+  bluetooth_benchmark_crypto_toolbox
+  bluetooth_benchmark_shim_acl_rx
 )
 
 usage() {
@@ -27,6 +27,7 @@ extern std::map<std::string, int> mock_function_count_map;
 #include "osi/src/compat.cc"  // For strlcpy
 
 #include "osi/include/alarm.h"
+#include "osi/include/allocation_tags.h"
 #include "osi/include/allocator.h"
 #include "osi/include/array.h"
 #include "osi/include/buffer.h"
@@ -51,15 +52,11 @@ extern std::map<std::string, int> mock_function_count_map;
 
 std::list<entry_t>::iterator section_t::Find(const std::string& key) {
   mock_function_count_map[__func__]++;
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.Find(key);
 }
 std::list<section_t>::iterator config_t::Find(const std::string& section) {
   mock_function_count_map[__func__]++;
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.Find(section);
 }
 
 bool checksum_save(const std::string& checksum, const std::string& filename) {
@@ -176,6 +173,29 @@ void* array_ptr(const array_t* array) {
   return nullptr;
 }
 
+size_t allocation_tags_resize(size_t size) {
+  mock_function_count_map[__func__]++;
+  return size;
+}
+void* allocation_tags_notify_alloc(void* ptr, size_t size) {
+  mock_function_count_map[__func__]++;
+  return ptr;
+}
+void* allocation_tags_notify_free(void* ptr) {
+  mock_function_count_map[__func__]++;
+  return ptr;
+}
+allocation_tag_t allocation_tags_set_current(allocation_tag_t tag) {
+  mock_function_count_map[__func__]++;
+  return ALLOCATION_TAG_NONE;
+}
+bool allocation_tags_get_stats(allocation_tag_t tag,
+                               allocation_tag_stats_t* stats) {
+  mock_function_count_map[__func__]++;
+  return false;
+}
+void allocation_tags_debug_dump(int fd) { mock_function_count_map[__func__]++; }
+
 size_t allocation_tracker_expect_no_allocations(void) {
   mock_function_count_map[__func__]++;
   return 0;
@@ -313,6 +333,10 @@ fixed_queue_t* fixed_queue_new(size_t capacity) {
   mock_function_count_map[__func__]++;
   return nullptr;
 }
+fixed_queue_t* fixed_queue_new_spsc(size_t capacity) {
+  mock_function_count_map[__func__]++;
+  return nullptr;
+}
 int fixed_queue_get_dequeue_fd(const fixed_queue_t* queue) {
   mock_function_count_map[__func__]++;
   return 0;
@@ -643,3 +667,6 @@ void wakelock_set_os_callouts(bt_os_callouts_t* callouts) {
 void wakelock_set_paths(const char* lock_path, const char* unlock_path) {
   mock_function_count_map[__func__]++;
 }
+void wakelock_set_hold_over_ms(uint64_t ms) {
+  mock_function_count_map[__func__]++;
+}
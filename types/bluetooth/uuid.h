@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <array>
 #include <string>
 
@@ -54,11 +55,14 @@ class Uuid final {
   size_t GetShortestRepresentationSize() const;
 
   // Returns true if this UUID can be represented as 16 bit.
-  bool Is16Bit() const;
+  bool Is16Bit() const {
+    return uu[0] == 0 && uu[1] == 0 &&
+           memcmp(uu.data() + kNumBytes32, kBaseTail, sizeof(kBaseTail)) == 0;
+  }
 
   // Returns 16 bit Little Endian representation of this UUID. Use
   // GetShortestRepresentationSize() or Is16Bit() before using this method.
-  uint16_t As16Bit() const;
+  uint16_t As16Bit() const { return (((uint16_t)uu[2]) << 8) + uu[3]; }
 
   // Returns 32 bit Little Endian representation of this UUID. Use
   // GetShortestRepresentationSize() before using this method.
@@ -71,10 +75,20 @@ class Uuid final {
   static Uuid FromString(const std::string& uuid, bool* is_valid = nullptr);
 
   // Converts 16bit Little Endian representation of UUID to UUID
-  static Uuid From16Bit(uint16_t uuid16bit);
+  static constexpr Uuid From16Bit(uint16_t uuid16bit) {
+    return From32Bit(uuid16bit);
+  }
 
   // Converts 32bit Little Endian representation of UUID to UUID
-  static Uuid From32Bit(uint32_t uuid32bit);
+  static constexpr Uuid From32Bit(uint32_t uuid32bit) {
+    return Uuid(UUID128Bit{{(uint8_t)(uuid32bit >> 24),
+                            (uint8_t)(uuid32bit >> 16),
+                            (uint8_t)(uuid32bit >> 8), (uint8_t)uuid32bit,
+                            kBaseTail[0], kBaseTail[1], kBaseTail[2],
+                            kBaseTail[3], kBaseTail[4], kBaseTail[5],
+                            kBaseTail[6], kBaseTail[7], kBaseTail[8],
+                            kBaseTail[9], kBaseTail[10], kBaseTail[11]}});
+  }
 
   // Converts 128 bit Big Endian array representing UUID to UUID.
   static constexpr Uuid From128BitBE(const UUID128Bit& uuid) {
@@ -109,11 +123,37 @@ class Uuid final {
   // Update UUID with new value
   void UpdateUuid(const Uuid& uuid);
 
-  bool operator<(const Uuid& rhs) const;
-  bool operator==(const Uuid& rhs) const;
-  bool operator!=(const Uuid& rhs) const;
+  // Compared as two 64 bit words, UUIDs are looked up for every attribute of
+  // GATT and SDP requests.
+  bool operator<(const Uuid& rhs) const {
+    return memcmp(uu.data(), rhs.uu.data(), kNumBytes128) < 0;
+  }
+  bool operator==(const Uuid& rhs) const {
+    uint64_t lhs_words[2], rhs_words[2];
+    memcpy(lhs_words, uu.data(), kNumBytes128);
+    memcpy(rhs_words, rhs.uu.data(), kNumBytes128);
+    return ((lhs_words[0] ^ rhs_words[0]) | (lhs_words[1] ^ rhs_words[1])) ==
+           0;
+  }
+  bool operator!=(const Uuid& rhs) const { return !(*this == rhs); }
+
+  // Returns a hash of the two 64 bit words of this UUID
+  size_t Hash() const {
+    uint64_t words[2];
+    memcpy(words, uu.data(), kNumBytes128);
+    uint64_t h = words[0] ^ (words[1] * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ULL;
+    h ^= h >> 32;
+    return static_cast<size_t>(h);
+  }
 
  private:
+  // Last 12 bytes of the Bluetooth Base UUID
+  // 00000000-0000-1000-8000-00805F9B34FB, shared by all 16 and 32 bit UUIDs.
+  static constexpr uint8_t kBaseTail[kNumBytes128 - kNumBytes32] = {
+      0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb};
+
   constexpr Uuid(const UUID128Bit& val) : uu{val} {};
 
   // Network-byte-ordered ID (Big Endian).
@@ -133,10 +173,7 @@ namespace std {
 template <>
 struct hash<bluetooth::Uuid> {
   std::size_t operator()(const bluetooth::Uuid& key) const {
-    const auto& uuid_bytes = key.To128BitBE();
-    std::hash<std::string> hash_fn;
-    return hash_fn(std::string(reinterpret_cast<const char*>(uuid_bytes.data()),
-                               uuid_bytes.size()));
+    return key.Hash();
   }
 };
 
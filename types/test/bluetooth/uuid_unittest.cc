@@ -19,6 +19,8 @@
 #include <bluetooth/uuid.h>
 #include <gtest/gtest.h>
 
+#include <unordered_set>
+
 using bluetooth::Uuid;
 
 static const Uuid ONES = Uuid::From128BitBE(
@@ -106,6 +108,45 @@ TEST(UuidTest, From32Bit) {
   EXPECT_TRUE(memcmp(&uuid, u4, sizeof(u4)) == 0);
 }
 
+TEST(UuidTest, FromBitConstexpr) {
+  constexpr Uuid kGattService = Uuid::From16Bit(0x1801);
+  EXPECT_EQ(kGattService, Uuid::FromString("1801"));
+  constexpr Uuid kLong = Uuid::From32Bit(0x3344553e);
+  EXPECT_EQ(kLong, Uuid::FromString("3344553e"));
+}
+
+TEST(UuidTest, Compare) {
+  EXPECT_TRUE(ONES == ONES);
+  EXPECT_FALSE(ONES != ONES);
+  EXPECT_TRUE(ONES != SEQUENTIAL);
+  EXPECT_FALSE(Uuid::From16Bit(0x1800) == Uuid::From16Bit(0x1801));
+  EXPECT_TRUE(Uuid::kEmpty.IsEmpty());
+  EXPECT_FALSE(kBase.IsEmpty());
+
+  // Ordering is lexicographic on the Big Endian bytes
+  EXPECT_TRUE(SEQUENTIAL < ONES);
+  EXPECT_FALSE(ONES < SEQUENTIAL);
+  EXPECT_FALSE(ONES < ONES);
+  EXPECT_TRUE(Uuid::From16Bit(0x00ff) < Uuid::From16Bit(0x0100));
+  EXPECT_TRUE(Uuid::From16Bit(0xffff) < Uuid::From32Bit(0x00010000));
+}
+
+TEST(UuidTest, Hash) {
+  std::hash<Uuid> hash_fn;
+  EXPECT_EQ(hash_fn(Uuid::From16Bit(0x2a00)),
+            hash_fn(Uuid::FromString("2a00")));
+
+  std::unordered_set<size_t> hashes;
+  for (uint32_t i = 0; i < 0x10000; i++) {
+    hashes.insert(hash_fn(Uuid::From16Bit(i)));
+  }
+  EXPECT_EQ(hashes.size(), 0x10000u);
+
+  std::unordered_set<Uuid> uuids = {ONES, SEQUENTIAL, kBase};
+  EXPECT_EQ(uuids.count(Uuid::From16Bit(0x0000)), 1u);
+  EXPECT_EQ(uuids.count(Uuid::From16Bit(0x0001)), 0u);
+}
+
 TEST(UuidTest, ToString) {
   const std::string UUID_BASE_STR = "00000000-0000-1000-8000-00805f9b34fb";
   const std::string UUID_EMP_STR = "00000000-0000-0000-0000-000000000000";
@@ -20,6 +20,8 @@
 
 #include <mutex>
 
+#include "uipc_shm.h"
+
 #define UIPC_CH_ID_AV_CTRL 0
 #define UIPC_CH_ID_AV_AUDIO 1
 #define UIPC_CH_NUM 2
@@ -30,6 +32,12 @@
 
 typedef uint8_t tUIPC_CH_ID;
 
+/* Data transport of a channel */
+typedef enum {
+  UIPC_CH_TYPE_SOCKET = 0, /* data is streamed over the socket */
+  UIPC_CH_TYPE_SHM,        /* data is passed through a shared memory ring */
+} tUIPC_CH_TYPE;
+
 /* Events generated */
 typedef enum {
   UIPC_OPEN_EVT = 0x0001,
@@ -47,6 +55,7 @@ typedef enum {
 #define UIPC_REG_CBACK 2
 #define UIPC_REG_REMOVE_ACTIVE_READSET 3
 #define UIPC_SET_READ_POLL_TMO 4
+#define UIPC_REQ_RX_READABLE 5 /* param: uint32_t*, bytes ready to read */
 
 typedef void(tUIPC_RCV_CBACK)(
     tUIPC_CH_ID ch_id,
@@ -63,6 +72,8 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  tUIPC_CH_TYPE type;
+  tUIPC_SHM shm; /* mapped while a UIPC_CH_TYPE_SHM client is connected */
 } tUIPC_CHAN;
 
 struct tUIPC_STATE {
@@ -91,10 +102,13 @@ std::unique_ptr<tUIPC_STATE> UIPC_Init();
  * @param ch_id Channel ID
  * @param p_cback Callback handler
  * @param socket_path Path to the socket
+ * @param ch_type Data transport; with UIPC_CH_TYPE_SHM the socket is only
+ *                used to hand a shared memory ring to the client
  * @return true on success, otherwise false
  */
 bool UIPC_Open(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK* p_cback,
-               const char* socket_path);
+               const char* socket_path,
+               tUIPC_CH_TYPE ch_type = UIPC_CH_TYPE_SOCKET);
 
 /**
  * Closes a channel in UIPC or the entire UIPC module
@@ -0,0 +1,358 @@
+/******************************************************************************
+ *
+ *  Copyright 2021 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*
+ * Shared-memory transport for UIPC audio channels.
+ *
+ * The stack side of a UIPC_CH_TYPE_SHM channel creates a single producer /
+ * single consumer byte ring in a memfd together with two eventfd doorbells,
+ * and hands the three descriptors to the audio HAL over the freshly accepted
+ * data socket. PCM then flows through the ring; the socket only remains to
+ * detect hang-up. The data area is mapped twice back to back so that any
+ * span of up to |size| bytes starting in the ring is contiguous in memory.
+ *
+ * This header is shared with the audio HALs and therefore has no dependency
+ * on the stack.
+ */
+
+#ifndef UIPC_SHM_H
+#define UIPC_SHM_H
+
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#define UIPC_SHM_MAGIC 0x55534852 /* "USHR" */
+
+/* Default ring capacity, rounded up to a power of two of at least a page */
+#define UIPC_SHM_RING_SZ (32 * 1024)
+
+/* How long a client waits for the handshake after connecting */
+#define UIPC_SHM_HANDSHAKE_TMO_MS 500
+
+/* Ring control block, located in the first page of the memfd. |head| and
+ * |producer_waiting| are written by the producer, |tail| and
+ * |consumer_waiting| by the consumer. A waiting flag asks the other side to
+ * ring the doorbell once it has made progress. */
+typedef struct {
+  uint32_t magic;
+  uint32_t size;
+  alignas(64) std::atomic<uint32_t> head;
+  std::atomic<uint32_t> producer_waiting;
+  alignas(64) std::atomic<uint32_t> tail;
+  std::atomic<uint32_t> consumer_waiting;
+} tUIPC_SHM_RING;
+
+/* Sent by the server on the data socket right after accept. A zero |size|
+ * (and no descriptors) tells the client to keep using the socket. */
+typedef struct {
+  uint32_t magic;
+  uint32_t size;
+} tUIPC_SHM_HANDSHAKE;
+
+typedef struct {
+  int mem_fd;
+  int data_evt;  /* producer -> consumer doorbell */
+  int space_evt; /* consumer -> producer doorbell */
+  uint32_t size;
+  size_t map_len;
+  uint8_t* base;
+  tUIPC_SHM_RING* ring;
+  uint8_t* data;
+} tUIPC_SHM;
+
+static inline void uipc_shm_reset(tUIPC_SHM* shm) {
+  shm->mem_fd = -1;
+  shm->data_evt = -1;
+  shm->space_evt = -1;
+  shm->size = 0;
+  shm->map_len = 0;
+  shm->base = nullptr;
+  shm->ring = nullptr;
+  shm->data = nullptr;
+}
+
+static inline bool uipc_shm_is_mapped(const tUIPC_SHM* shm) {
+  return shm->ring != nullptr;
+}
+
+/* Unmaps the ring and closes all descriptors */
+static inline void uipc_shm_close(tUIPC_SHM* shm) {
+  if (shm->base != nullptr) munmap(shm->base, shm->map_len);
+  if (shm->mem_fd >= 0) close(shm->mem_fd);
+  if (shm->data_evt >= 0) close(shm->data_evt);
+  if (shm->space_evt >= 0) close(shm->space_evt);
+  uipc_shm_reset(shm);
+}
+
+/* Maps |shm->mem_fd| with the data area mirrored after itself */
+static inline int uipc_shm_map(tUIPC_SHM* shm) {
+  const size_t page = sysconf(_SC_PAGESIZE);
+  const size_t size = shm->size;
+
+  if (size == 0 || (size & (size - 1)) != 0 || (size % page) != 0) return -1;
+
+  const size_t map_len = page + 2 * size;
+  void* base = mmap(nullptr, map_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+  if (base == MAP_FAILED) return -1;
+
+  uint8_t* p = static_cast<uint8_t*>(base);
+  if (mmap(p, page + size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           shm->mem_fd, 0) == MAP_FAILED ||
+      mmap(p + page + size, size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, shm->mem_fd, page) == MAP_FAILED) {
+    munmap(base, map_len);
+    return -1;
+  }
+
+  shm->base = p;
+  shm->map_len = map_len;
+  shm->ring = reinterpret_cast<tUIPC_SHM_RING*>(p);
+  shm->data = p + page;
+  return 0;
+}
+
+/* Creates a ring of at least |size| bytes. Server side. */
+static inline int uipc_shm_create(tUIPC_SHM* shm, uint32_t size) {
+  const uint32_t page = sysconf(_SC_PAGESIZE);
+  uint32_t ring_sz = page;
+  while (ring_sz < size) ring_sz <<= 1;
+
+  uipc_shm_reset(shm);
+  shm->size = ring_sz;
+  shm->mem_fd = memfd_create("uipc_shm", MFD_CLOEXEC);
+  shm->data_evt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  shm->space_evt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (shm->mem_fd < 0 || shm->data_evt < 0 || shm->space_evt < 0 ||
+      ftruncate(shm->mem_fd, page + ring_sz) < 0 || uipc_shm_map(shm) < 0) {
+    uipc_shm_close(shm);
+    return -1;
+  }
+
+  shm->ring->magic = UIPC_SHM_MAGIC;
+  shm->ring->size = ring_sz;
+  shm->ring->head.store(0);
+  shm->ring->producer_waiting.store(0);
+  shm->ring->tail.store(0);
+  shm->ring->consumer_waiting.store(0);
+  return 0;
+}
+
+/* Sends the handshake, with the ring descriptors if |shm| is mapped */
+static inline int uipc_shm_send_handshake(int sock, const tUIPC_SHM* shm) {
+  tUIPC_SHM_HANDSHAKE hs = {UIPC_SHM_MAGIC,
+                            uipc_shm_is_mapped(shm) ? shm->size : 0};
+  struct iovec iov = {&hs, sizeof(hs)};
+  char cbuf[CMSG_SPACE(3 * sizeof(int))];
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if (uipc_shm_is_mapped(shm)) {
+    const int fds[3] = {shm->mem_fd, shm->data_evt, shm->space_evt};
+    memset(cbuf, 0, sizeof(cbuf));
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+  }
+
+  ssize_t ret;
+  do {
+    ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+  } while (ret == -1 && errno == EINTR);
+  return (ret == (ssize_t)sizeof(hs)) ? 0 : -1;
+}
+
+/* Waits up to |tmo_ms| for the handshake and maps the ring. Client side.
+ * Returns -1 if the server did not offer a ring; the socket stays usable. */
+static inline int uipc_shm_recv_handshake(int sock, tUIPC_SHM* shm,
+                                          int tmo_ms) {
+  struct pollfd pfd = {sock, POLLIN, 0};
+  int ret;
+
+  uipc_shm_reset(shm);
+
+  do {
+    ret = poll(&pfd, 1, tmo_ms);
+  } while (ret == -1 && errno == EINTR);
+  if (ret <= 0 || !(pfd.revents & POLLIN)) return -1;
+
+  tUIPC_SHM_HANDSHAKE hs = {0, 0};
+  struct iovec iov = {&hs, sizeof(hs)};
+  char cbuf[CMSG_SPACE(3 * sizeof(int))];
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+
+  ssize_t n;
+  do {
+    n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+  } while (n == -1 && errno == EINTR);
+
+  int fds[3] = {-1, -1, -1};
+  struct cmsghdr* cmsg = (n > 0) ? CMSG_FIRSTHDR(&msg) : nullptr;
+  if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN(sizeof(fds))) {
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+  }
+
+  shm->mem_fd = fds[0];
+  shm->data_evt = fds[1];
+  shm->space_evt = fds[2];
+  shm->size = hs.size;
+
+  if (n != (ssize_t)sizeof(hs) || hs.magic != UIPC_SHM_MAGIC ||
+      (msg.msg_flags & MSG_CTRUNC) || fds[2] < 0 || uipc_shm_map(shm) < 0 ||
+      shm->ring->magic != UIPC_SHM_MAGIC || shm->ring->size != shm->size) {
+    uipc_shm_close(shm);
+    return -1;
+  }
+  return 0;
+}
+
+/* Bytes available to the consumer, contiguous at uipc_shm_read_ptr() */
+static inline uint32_t uipc_shm_readable(const tUIPC_SHM* shm) {
+  uint32_t avail = shm->ring->head.load(std::memory_order_acquire) -
+                   shm->ring->tail.load(std::memory_order_relaxed);
+  /* never trust the peer beyond the mapped window */
+  return (avail > shm->size) ? shm->size : avail;
+}
+
+/* Bytes available to the producer, contiguous at uipc_shm_write_ptr() */
+static inline uint32_t uipc_shm_writable(const tUIPC_SHM* shm) {
+  uint32_t used = shm->ring->head.load(std::memory_order_relaxed) -
+                  shm->ring->tail.load(std::memory_order_acquire);
+  return (used > shm->size) ? 0 : shm->size - used;
+}
+
+static inline const uint8_t* uipc_shm_read_ptr(const tUIPC_SHM* shm) {
+  return shm->data +
+         (shm->ring->tail.load(std::memory_order_relaxed) & (shm->size - 1));
+}
+
+static inline uint8_t* uipc_shm_write_ptr(const tUIPC_SHM* shm) {
+  return shm->data +
+         (shm->ring->head.load(std::memory_order_relaxed) & (shm->size - 1));
+}
+
+/* Releases |len| bytes back to the producer */
+static inline void uipc_shm_consume(tUIPC_SHM* shm, uint32_t len) {
+  shm->ring->tail.store(shm->ring->tail.load(std::memory_order_relaxed) + len);
+  if (shm->ring->producer_waiting.exchange(0)) eventfd_write(shm->space_evt, 1);
+}
+
+/* Publishes |len| bytes to the consumer */
+static inline void uipc_shm_produce(tUIPC_SHM* shm, uint32_t len) {
+  shm->ring->head.store(shm->ring->head.load(std::memory_order_relaxed) + len);
+  if (shm->ring->consumer_waiting.exchange(0)) eventfd_write(shm->data_evt, 1);
+}
+
+/* Announces that the caller is about to sleep on its doorbell. Returns false
+ * if the ring became ready meanwhile, in which case there is nothing to wait
+ * for. */
+static inline bool uipc_shm_arm_wait(tUIPC_SHM* shm, bool producer) {
+  std::atomic<uint32_t>& waiting = producer ? shm->ring->producer_waiting
+                                            : shm->ring->consumer_waiting;
+  waiting.store(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if ((producer ? uipc_shm_writable(shm) : uipc_shm_readable(shm)) != 0) {
+    waiting.store(0, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+/* Sleeps on doorbell |evt| for up to |tmo_ms| while watching |sock| for
+ * hang-up. Touches no shared memory, so it may run without the lock that
+ * protects the mapping. Returns 1 when woken, 0 on timeout and -1 when the
+ * peer is gone. */
+static inline int uipc_shm_poll(int evt, int sock, int tmo_ms) {
+  struct pollfd pfd[2] = {{evt, POLLIN, 0}, {sock, POLLIN, 0}};
+  int ret;
+
+  do {
+    ret = poll(pfd, 2, tmo_ms);
+  } while (ret == -1 && errno == EINTR);
+  if (ret < 0) return -1;
+
+  if (pfd[0].revents & POLLIN) {
+    eventfd_t value;
+    eventfd_read(evt, &value);
+  }
+  /* nothing but hang-up is expected on the socket once the ring is up */
+  if (pfd[1].revents != 0 || (pfd[0].revents & (POLLERR | POLLNVAL)))
+    return -1;
+  return (ret == 0) ? 0 : 1;
+}
+
+/* Copies |len| bytes into the ring, waiting up to |tmo_ms| in total for the
+ * consumer to make room. Client side. Returns the number of bytes written,
+ * or -1 on timeout or hang-up. */
+static inline int uipc_shm_write(tUIPC_SHM* shm, int sock, const void* p,
+                                 size_t len, int tmo_ms) {
+  const uint8_t* src = static_cast<const uint8_t*>(p);
+  struct timespec start;
+  size_t count = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (count < len) {
+    uint32_t room = uipc_shm_writable(shm);
+    if (room == 0) {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      int elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+                       (now.tv_nsec - start.tv_nsec) / 1000000;
+      if (elapsed_ms >= tmo_ms) return -1;
+      if (uipc_shm_arm_wait(shm, true) &&
+          uipc_shm_poll(shm->space_evt, sock, tmo_ms - elapsed_ms) < 0) {
+        shm->ring->producer_waiting.store(0, std::memory_order_relaxed);
+        return -1;
+      }
+      shm->ring->producer_waiting.store(0, std::memory_order_relaxed);
+      continue;
+    }
+
+    uint32_t n = (len - count < room) ? (uint32_t)(len - count) : room;
+    memcpy(uipc_shm_write_ptr(shm), src + count, n);
+    uipc_shm_produce(shm, n);
+    count += n;
+  }
+  return (int)count;
+}
+
+#endif /* UIPC_SHM_H */
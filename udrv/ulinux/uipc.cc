@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/prctl.h>
@@ -38,6 +39,7 @@
 #include <sys/stat.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <algorithm>
 #include <mutex>
 #include <set>
 
@@ -79,6 +81,7 @@ typedef enum {
  *  Static functions
  *****************************************************************************/
 static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id);
+static void uipc_setup_shm_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id);
 
 /*****************************************************************************
  *  Externs
@@ -205,6 +208,8 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
     p->fd = UIPC_DISCONNECTED;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->type = UIPC_CH_TYPE_SOCKET;
+    uipc_shm_reset(&p->shm);
   }
 
   return 0;
@@ -251,12 +256,18 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
       close(uipc.ch[ch_id].fd);
       FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
       uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+      uipc_shm_close(&uipc.ch[ch_id].shm);
     }
 
     uipc.ch[ch_id].fd = accept_server_socket(uipc.ch[ch_id].srvfd);
 
     BTIF_TRACE_EVENT("NEW FD %d", uipc.ch[ch_id].fd);
 
+    if ((uipc.ch[ch_id].fd >= 0) &&
+        (uipc.ch[ch_id].type == UIPC_CH_TYPE_SHM)) {
+      uipc_setup_shm_locked(uipc, ch_id);
+    }
+
     if ((uipc.ch[ch_id].fd >= 0) && uipc.ch[ch_id].cback) {
       /*  if we have a callback we should add this fd to the active set
           and notify user with callback event */
@@ -292,6 +303,28 @@ static void uipc_check_interrupt_locked(tUIPC_STATE& uipc) {
   }
 }
 
+/* hand a fresh shared memory ring to the client that just connected */
+static void uipc_setup_shm_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
+  tUIPC_CHAN* p = &uipc.ch[ch_id];
+
+  if (uipc_shm_create(&p->shm, UIPC_SHM_RING_SZ) < 0) {
+    BTIF_TRACE_ERROR("CH %d : shm ring setup failed (%s), using socket", ch_id,
+                     strerror(errno));
+  }
+
+  /* the handshake is sent even without a ring so the client stops waiting */
+  if (uipc_shm_send_handshake(p->fd, &p->shm) < 0) {
+    BTIF_TRACE_ERROR("CH %d : shm handshake failed (%s)", ch_id,
+                     strerror(errno));
+    uipc_shm_close(&p->shm);
+    return;
+  }
+
+  BTIF_TRACE_EVENT("CH %d : %s transport (ring %u bytes)", ch_id,
+                   uipc_shm_is_mapped(&p->shm) ? "shm" : "socket",
+                   p->shm.size);
+}
+
 static inline void uipc_wakeup_locked(tUIPC_STATE& uipc) {
   char sig_on = 1;
   BTIF_TRACE_EVENT("UIPC SEND WAKE UP");
@@ -300,7 +333,8 @@ static inline void uipc_wakeup_locked(tUIPC_STATE& uipc) {
 }
 
 static int uipc_setup_server_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
-                                    const char* name, tUIPC_RCV_CBACK* cback) {
+                                    const char* name, tUIPC_RCV_CBACK* cback,
+                                    tUIPC_CH_TYPE ch_type) {
   int fd;
 
   BTIF_TRACE_EVENT("SETUP CHANNEL SERVER %d", ch_id);
@@ -323,6 +357,7 @@ static int uipc_setup_server_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
   uipc.ch[ch_id].srvfd = fd;
   uipc.ch[ch_id].cback = cback;
   uipc.ch[ch_id].read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
+  uipc.ch[ch_id].type = ch_type;
 
   /* trigger main thread to update read set */
   uipc_wakeup_locked(uipc);
@@ -342,6 +377,12 @@ static void uipc_flush_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     return;
   }
 
+  if (uipc_shm_is_mapped(&uipc.ch[ch_id].shm)) {
+    tUIPC_SHM* shm = &uipc.ch[ch_id].shm;
+    uipc_shm_consume(shm, uipc_shm_readable(shm));
+    return;
+  }
+
   while (1) {
     int ret;
     OSI_NO_INTR(ret = poll(&pfd, 1, 1));
@@ -403,6 +444,7 @@ static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     close(uipc.ch[ch_id].fd);
     FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
     uipc.ch[ch_id].fd = UIPC_DISCONNECTED;
+    uipc_shm_close(&uipc.ch[ch_id].shm);
     wakeup = 1;
   }
 
@@ -540,8 +582,9 @@ std::unique_ptr<tUIPC_STATE> UIPC_Init() {
  **
  ******************************************************************************/
 bool UIPC_Open(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK* p_cback,
-               const char* socket_path) {
-  BTIF_TRACE_DEBUG("UIPC_Open : ch_id %d, p_cback %x", ch_id, p_cback);
+               const char* socket_path, tUIPC_CH_TYPE ch_type) {
+  BTIF_TRACE_DEBUG("UIPC_Open : ch_id %d, p_cback %x, type %d", ch_id, p_cback,
+                   ch_type);
 
   std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
 
@@ -554,7 +597,7 @@ bool UIPC_Open(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, tUIPC_RCV_CBACK* p_cback,
     return 0;
   }
 
-  uipc_setup_server_locked(uipc, ch_id, socket_path, p_cback);
+  uipc_setup_server_locked(uipc, ch_id, socket_path, p_cback, ch_type);
 
   return true;
 }
@@ -608,6 +651,53 @@ bool UIPC_Send(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
   return false;
 }
 
+/* Read from a shared memory channel. The ring is only touched with the lock
+ * held, since the UIPC thread unmaps it when the channel closes; the lock is
+ * dropped while sleeping on the doorbell. */
+static uint32_t uipc_read_shm(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
+                              uint8_t* p_buf, uint32_t len) {
+  std::unique_lock<std::recursive_mutex> lock(uipc.mutex);
+  tUIPC_SHM* shm = &uipc.ch[ch_id].shm;
+  uint32_t n_read = 0;
+
+  while (n_read < len && uipc_shm_is_mapped(shm)) {
+    uint32_t avail = uipc_shm_readable(shm);
+    if (avail == 0) {
+      if (!uipc_shm_arm_wait(shm, false)) continue;
+
+      int data_evt = shm->data_evt;
+      int fd = uipc.ch[ch_id].fd;
+      int tmo_ms = uipc.ch[ch_id].read_poll_tmo_ms;
+
+      lock.unlock();
+      int ret = uipc_shm_poll(data_evt, fd, tmo_ms);
+      lock.lock();
+
+      if (!uipc_shm_is_mapped(shm) || shm->data_evt != data_evt) break;
+      shm->ring->consumer_waiting.store(0, std::memory_order_relaxed);
+
+      if (ret == 0) {
+        BTIF_TRACE_WARNING("poll timeout (%d ms)", tmo_ms);
+        break;
+      }
+      if (ret < 0) {
+        BTIF_TRACE_WARNING("UIPC_Read : channel detached remotely");
+        uipc_close_locked(uipc, ch_id);
+        return 0;
+      }
+      continue;
+    }
+
+    /* the mirrored mapping keeps the readable span contiguous */
+    uint32_t n = std::min(avail, len - n_read);
+    memcpy(p_buf + n_read, uipc_shm_read_ptr(shm), n);
+    uipc_shm_consume(shm, n);
+    n_read += n;
+  }
+
+  return n_read;
+}
+
 /*******************************************************************************
  **
  ** Function         UIPC_Read
@@ -635,6 +725,10 @@ uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
     return 0;
   }
 
+  if (uipc_shm_is_mapped(&uipc.ch[ch_id].shm)) {
+    return uipc_read_shm(uipc, ch_id, p_buf, len);
+  }
+
   while (n_read < (int)len) {
     pfd.fd = fd;
     pfd.events = POLLIN | POLLHUP;
@@ -731,6 +825,19 @@ extern bool UIPC_Ioctl(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t request,
                        uipc.ch[ch_id].read_poll_tmo_ms);
       break;
 
+    case UIPC_REQ_RX_READABLE: {
+      uint32_t* p_readable = static_cast<uint32_t*>(param);
+      int n = 0;
+      *p_readable = 0;
+      if (uipc.ch[ch_id].fd == UIPC_DISCONNECTED) return false;
+      if (uipc_shm_is_mapped(&uipc.ch[ch_id].shm)) {
+        *p_readable = uipc_shm_readable(&uipc.ch[ch_id].shm);
+      } else if (ioctl(uipc.ch[ch_id].fd, FIONREAD, &n) == 0 && n > 0) {
+        *p_readable = n;
+      }
+      return true;
+    }
+
     default:
       BTIF_TRACE_EVENT("UIPC_Ioctl : request not handled (%d)", request);
       break;
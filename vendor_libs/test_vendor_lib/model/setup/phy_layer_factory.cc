@@ -34,28 +34,30 @@ std::shared_ptr<PhyLayer> PhyLayerFactory::GetPhyLayer(
     const std::function<void(model::packets::LinkLayerPacketView)>&
         device_receive,
     uint32_t device_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
   std::shared_ptr<PhyLayer> new_phy = std::make_shared<PhyLayerImpl>(
       phy_type_, next_id_++, device_receive, device_id, this);
-  phy_layers_.push_back(new_phy);
+  auto phy_layers = std::make_shared<PhyLayers>(*phy_layers_);
+  phy_layers->push_back(new_phy);
+  phy_layers_ = std::move(phy_layers);
   return new_phy;
 }
 
 void PhyLayerFactory::UnregisterPhyLayer(uint32_t id) {
-  for (auto phy : phy_layers_) {
-    if (phy->GetId() == id) {
-      phy_layers_.remove(phy);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto phy_layers = std::make_shared<PhyLayers>(*phy_layers_);
+  for (auto it = phy_layers->begin(); it != phy_layers->end(); it++) {
+    if ((*it)->GetId() == id) {
+      phy_layers->erase(it);
+      phy_layers_ = std::move(phy_layers);
       return;
     }
   }
 }
 
 void PhyLayerFactory::UnregisterAllPhyLayers() {
-  while (!phy_layers_.empty()) {
-    if (phy_layers_.begin() != phy_layers_.end()) {
-      auto id = (*phy_layers_.begin())->GetId();
-      UnregisterPhyLayer(id);
-    }
-  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  phy_layers_ = std::make_shared<PhyLayers>();
 }
 
 void PhyLayerFactory::Send(
@@ -77,20 +79,48 @@ void PhyLayerFactory::Send(
 
 void PhyLayerFactory::Send(model::packets::LinkLayerPacketView packet,
                            uint32_t id) {
-  for (const auto& phy : phy_layers_) {
-    if (id != phy->GetId()) {
-      phy->Receive(packet);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_.emplace_back(std::move(packet), id);
+    if (delivering_) {
+      return;
+    }
+    delivering_ = true;
+  }
+  DeliverQueued();
+}
+
+void PhyLayerFactory::DeliverQueued() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!queued_.empty()) {
+    auto queued = std::move(queued_.front());
+    queued_.pop_front();
+    std::shared_ptr<const PhyLayers> phy_layers = phy_layers_;
+    lock.unlock();
+
+    for (const auto& phy : *phy_layers) {
+      if (queued.second != phy->GetId()) {
+        phy->Receive(queued.first);
+      }
     }
+    lock.lock();
   }
+  delivering_ = false;
 }
 
 void PhyLayerFactory::TimerTick() {
-  for (auto& phy : phy_layers_) {
+  std::shared_ptr<const PhyLayers> phy_layers;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phy_layers = phy_layers_;
+  }
+  for (auto& phy : *phy_layers) {
     phy->TimerTick();
   }
 }
 
 std::string PhyLayerFactory::ToString() const {
+  std::lock_guard<std::mutex> lock(mutex_);
   std::stringstream factory;
   switch (phy_type_) {
     case Phy::Type::LOW_ENERGY:
@@ -102,7 +132,7 @@ std::string PhyLayerFactory::ToString() const {
     default:
       factory << "Unknown: ";
   }
-  for (auto& phy : phy_layers_) {
+  for (auto& phy : *phy_layers_) {
     factory << phy->GetDeviceId();
     factory << ",";
   }
@@ -16,8 +16,10 @@
 
 #pragma once
 
-#include <list>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include "include/phy.h"
@@ -58,8 +60,21 @@ class PhyLayerFactory {
   virtual void Send(model::packets::LinkLayerPacketView packet, uint32_t id);
 
  private:
+  using PhyLayers = std::vector<std::shared_ptr<PhyLayer>>;
+
+  // Delivers the queued packets one at a time to every phy layer but the
+  // sender's. Packets sent while delivering, by the receivers or by other
+  // threads, are queued behind instead of being delivered in the middle of
+  // another packet.
+  void DeliverQueued();
+
   Phy::Type phy_type_;
-  std::list<std::shared_ptr<PhyLayer>> phy_layers_;
+  mutable std::mutex mutex_;
+  // Replaced on registration, so that a delivery keeps the phy layers it
+  // started with without holding the lock
+  std::shared_ptr<const PhyLayers> phy_layers_{std::make_shared<PhyLayers>()};
+  std::deque<std::pair<model::packets::LinkLayerPacketView, uint32_t>> queued_;
+  bool delivering_{false};
   uint32_t next_id_{1};
   const uint32_t factory_id_;
 };
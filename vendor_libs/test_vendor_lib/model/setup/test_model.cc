@@ -116,7 +116,7 @@ void TestModel::Del(size_t dev_index) {
 
 size_t TestModel::AddPhy(Phy::Type phy_type) {
   size_t factory_id = phys_.size();
-  phys_.emplace_back(phy_type, factory_id);
+  phys_.push_back(std::make_unique<PhyLayerFactory>(phy_type, factory_id));
   return factory_id;
 }
 
@@ -127,7 +127,7 @@ void TestModel::DelPhy(size_t phy_index) {
   }
   schedule_task_(
       model_user_id_, std::chrono::milliseconds(0),
-      [this, phy_index]() { phys_[phy_index].UnregisterAllPhyLayers(); });
+      [this, phy_index]() { phys_[phy_index]->UnregisterAllPhyLayers(); });
 }
 
 void TestModel::AddDeviceToPhy(size_t dev_index, size_t phy_index) {
@@ -140,7 +140,7 @@ void TestModel::AddDeviceToPhy(size_t dev_index, size_t phy_index) {
     return;
   }
   auto dev = devices_[dev_index];
-  dev->RegisterPhyLayer(phys_[phy_index].GetPhyLayer(
+  dev->RegisterPhyLayer(phys_[phy_index]->GetPhyLayer(
       [dev](model::packets::LinkLayerPacketView packet) {
         dev->IncomingPacket(std::move(packet));
       },
@@ -159,8 +159,8 @@ void TestModel::DelDeviceFromPhy(size_t dev_index, size_t phy_index) {
   schedule_task_(model_user_id_, std::chrono::milliseconds(0),
                  [this, dev_index, phy_index]() {
                    devices_[dev_index]->UnregisterPhyLayer(
-                       phys_[phy_index].GetType(),
-                       phys_[phy_index].GetFactoryId());
+                       phys_[phy_index]->GetType(),
+                       phys_[phy_index]->GetFactoryId());
                  });
 }
 
@@ -168,7 +168,7 @@ void TestModel::AddLinkLayerConnection(int socket_fd, Phy::Type phy_type) {
   std::shared_ptr<Device> dev = LinkLayerSocketDevice::Create(socket_fd, phy_type);
   int index = Add(dev);
   for (size_t i = 0; i < phys_.size(); i++) {
-    if (phy_type == phys_[i].GetType()) {
+    if (phy_type == phys_[i]->GetType()) {
       AddDeviceToPhy(index, i);
     }
   }
@@ -250,7 +250,7 @@ const std::string& TestModel::List() {
   list_string_ += " Phys: \r\n";
   for (size_t i = 0; i < phys_.size(); i++) {
     list_string_ += "  " + std::to_string(i) + ":";
-    list_string_ += phys_[i].ToString() + " \r\n";
+    list_string_ += phys_[i]->ToString() + " \r\n";
   }
   return list_string_;
 }